@@ -84,6 +84,10 @@ size: $(BUILD)/$(PROJECT).elf
 linkermap: $(BUILD)/$(PROJECT).elf
 	@linkermap -v $<.map
 
+# code and static RAM of each TinyUSB module
+memory-report: $(BUILD)/$(PROJECT).elf
+	@$(PYTHON) $(TOP)/tools/memory_report.py $<.map
+
 # ---------------------------------------
 # Flash Targets
 # ---------------------------------------
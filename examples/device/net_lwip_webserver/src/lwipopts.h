@@ -60,6 +60,8 @@
 #define LWIP_SINGLE_NETIF               1
 
 #define PBUF_POOL_SIZE                  4
+#define LWIP_SUPPORT_CUSTOM_PBUF        1
+#define LWIP_CHECKSUM_CTRL_PER_NETIF    1
 
 #define HTTPD_USE_CUSTOM_FSDATA         0
 
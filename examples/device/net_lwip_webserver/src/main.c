@@ -66,6 +66,49 @@ static struct netif netif_data;
 /* shared between tud_network_recv_cb() and service_traffic() */
 static struct pbuf *received_frame;
 
+#if CFG_TUD_NCM && CFG_TUD_NCM_CSUM_OFFLOAD
+/* checksums are generated by the NCM driver and verified unless it could not tell */
+#define NETIF_CHECKSUM_GEN_OFFLOAD (NETIF_CHECKSUM_GEN_IP | NETIF_CHECKSUM_GEN_UDP | NETIF_CHECKSUM_GEN_TCP | \
+                                    NETIF_CHECKSUM_GEN_ICMP | NETIF_CHECKSUM_GEN_ICMP6)
+#define NETIF_CHECKSUM_CHECK_OFFLOAD (NETIF_CHECKSUM_CHECK_IP | NETIF_CHECKSUM_CHECK_UDP | NETIF_CHECKSUM_CHECK_TCP | \
+                                      NETIF_CHECKSUM_CHECK_ICMP | NETIF_CHECKSUM_CHECK_ICMP6)
+static uint8_t received_csum;
+#endif
+
+#if CFG_TUD_NCM && LWIP_SUPPORT_CUSTOM_PBUF
+/* zero-copy reception: pbufs referencing datagrams within the NCM receive buffers (needs CFG_TUD_NCM_OUT_NTB_N >= 2) */
+typedef struct {
+  struct pbuf_custom pc; /* must be first */
+  void *ntb;             /* handle from tud_network_recv_hold(), NULL if free */
+} ref_pbuf_t;
+
+static ref_pbuf_t ref_pbufs[PBUF_POOL_SIZE];
+
+static void ref_pbuf_free(struct pbuf *p) {
+  ref_pbuf_t *rp = (ref_pbuf_t *) p;
+  void *ntb = rp->ntb;
+
+  rp->ntb = NULL;
+  tud_network_recv_release(ntb);
+}
+
+static struct pbuf *ref_pbuf_alloc(const uint8_t *src, uint16_t size) {
+  for (size_t i = 0; i < TU_ARRAY_SIZE(ref_pbufs); i++) {
+    ref_pbuf_t *rp = &ref_pbufs[i];
+    if (rp->ntb == NULL) {
+      /* fails if the driver needs the buffer back for reception, the frame is copied then */
+      rp->ntb = tud_network_recv_hold();
+      if (rp->ntb == NULL) {
+        return NULL;
+      }
+      rp->pc.custom_free_function = ref_pbuf_free;
+      return pbuf_alloced_custom(PBUF_RAW, size, PBUF_REF, &rp->pc, (void *) (uintptr_t) src, size);
+    }
+  }
+  return NULL;
+}
+#endif
+
 /* this is used by this code, ./class/net/net_driver.c, and usb_descriptors.c */
 /* ideally speaking, this should be generated from the hardware's unique ID (if available) */
 /* it is suggested that the first byte is 0x02 to indicate a link-local address */
@@ -129,6 +172,9 @@ static err_t netif_init_cb(struct netif *netif) {
   netif->state = NULL;
   netif->name[0] = 'E';
   netif->name[1] = 'X';
+#if CFG_TUD_NCM && CFG_TUD_NCM_CSUM_OFFLOAD
+  NETIF_SET_CHECKSUM_CTRL(netif, NETIF_CHECKSUM_ENABLE_ALL & ~NETIF_CHECKSUM_GEN_OFFLOAD);
+#endif
   netif->linkoutput = linkoutput_fn;
   netif->output = ip4_output_fn;
 #if LWIP_IPV6
@@ -168,9 +214,23 @@ bool tud_network_recv_cb(const uint8_t *src, uint16_t size) {
   parsing the previous, we must signal our inability to accept it */
   if (received_frame) return false;
 
+#if CFG_TUD_NCM && CFG_TUD_NCM_CSUM_OFFLOAD
+  received_csum = tud_network_recv_csum();
+  if (received_csum == TUD_NETWORK_CSUM_INVALID) return true; /* drop */
+#endif
+
   if (size) {
-    struct pbuf *p = pbuf_alloc(PBUF_RAW, size, PBUF_POOL);
+    struct pbuf *p;
+
+#if CFG_TUD_NCM && LWIP_SUPPORT_CUSTOM_PBUF
+    p = ref_pbuf_alloc(src, size);
+    if (p) {
+      received_frame = p;
+      return true;
+    }
+#endif
 
+    p = pbuf_alloc(PBUF_RAW, size, PBUF_POOL);
     if (p) {
       /* pbuf_alloc() has already initialized struct; all we need to do is copy the data */
       memcpy(p->payload, src, size);
@@ -194,6 +254,12 @@ uint16_t tud_network_xmit_cb(uint8_t *dst, void *ref, uint16_t arg) {
 static void service_traffic(void) {
   /* handle any packet received by tud_network_recv_cb() */
   if (received_frame) {
+#if CFG_TUD_NCM && CFG_TUD_NCM_CSUM_OFFLOAD
+    /* skip verification already done by the driver */
+    u16_t ctrl = NETIF_CHECKSUM_ENABLE_ALL & ~NETIF_CHECKSUM_GEN_OFFLOAD;
+    if (received_csum == TUD_NETWORK_CSUM_VALID) ctrl &= ~NETIF_CHECKSUM_CHECK_OFFLOAD;
+    NETIF_SET_CHECKSUM_CTRL(&netif_data, ctrl);
+#endif
     // Surrender ownership of our pbuf unless there was an error
     // Only call pbuf_free if not Ok else it will panic with "pbuf_free: p->ref > 0"
     // or steal it from whatever took ownership of it with undefined consequences.
@@ -51,7 +51,6 @@ static CLI_UINT cli_buffer[BYTES_TO_CLI_UINTS(CLI_BUFFER_SIZE)];
 
 //------------- Elm Chan FatFS -------------//
 static FATFS fatfs[CFG_TUH_DEVICE_MAX]; // for simplicity only support 1 LUN per device
-static volatile bool _disk_busy[CFG_TUH_DEVICE_MAX];
 
 // define the buffer to be place in USB/DMA memory with correct alignment/cache line size
 CFG_TUH_MEM_SECTION static struct {
@@ -67,10 +66,6 @@ bool cli_init(void);
 
 bool msc_app_init(void)
 {
-  for(size_t i=0; i<CFG_TUH_DEVICE_MAX; i++) {
-    _disk_busy[i] = false;
-  }
-
   // disable stdout buffered for echoing typing command
   #ifndef __ICCARM__ // TODO IAR doesn't support stream control ?
   setbuf(stdout, NULL);
@@ -182,21 +177,8 @@ void tuh_msc_umount_cb(uint8_t dev_addr)
 // DiskIO
 //--------------------------------------------------------------------+
 
-static void wait_for_disk_io(BYTE pdrv)
-{
-  while(_disk_busy[pdrv])
-  {
-    tuh_task();
-  }
-}
-
-static bool disk_io_complete(uint8_t dev_addr, tuh_msc_complete_data_t const * cb_data)
-{
-  (void) dev_addr; (void) cb_data;
-  _disk_busy[dev_addr-1] = false;
-  return true;
-}
-
+// Blocking read/write of MSC host driver splits large requests into commands and runs tuh_task() (or sleeps with
+// RTOS) while waiting. Note: FatFs sector buffer must be accessible by USB/DMA controller
 DSTATUS disk_status (
 	BYTE pdrv		/* Physical drive nmuber to identify the drive */
 )
@@ -223,11 +205,7 @@ DRESULT disk_read (
 	uint8_t const dev_addr = pdrv + 1;
 	uint8_t const lun = 0;
 
-	_disk_busy[pdrv] = true;
-	tuh_msc_read10(dev_addr, lun, buff, sector, (uint16_t) count, disk_io_complete, 0);
-	wait_for_disk_io(pdrv);
-
-	return RES_OK;
+	return tuh_msc_read_sync(dev_addr, lun, buff, sector, count) ? RES_OK : RES_ERROR;
 }
 
 #if FF_FS_READONLY == 0
@@ -242,11 +220,7 @@ DRESULT disk_write (
 	uint8_t const dev_addr = pdrv + 1;
 	uint8_t const lun = 0;
 
-	_disk_busy[pdrv] = true;
-	tuh_msc_write10(dev_addr, lun, buff, sector, (uint16_t) count, disk_io_complete, 0);
-	wait_for_disk_io(pdrv);
-
-	return RES_OK;
+	return tuh_msc_write_sync(dev_addr, lun, buff, sector, count) ? RES_OK : RES_ERROR;
 }
 
 #endif
@@ -262,8 +236,12 @@ DRESULT disk_ioctl (
   switch ( cmd )
   {
     case CTRL_SYNC:
-      // nothing to do since we do blocking
+#if CFG_TUH_MSC_CACHE_BLOCKS
+      // write back cached blocks
+      return tuh_msc_cache_sync_blocking(dev_addr, lun) ? RES_OK : RES_ERROR;
+#else
       return RES_OK;
+#endif
 
     case GET_SECTOR_COUNT:
       *((DWORD*) buff) = (WORD) tuh_msc_get_block_count(dev_addr, lun);
@@ -113,6 +113,14 @@
 //------------- MSC -------------//
 #define CFG_TUH_MSC_MAXLUN    4 // typical for most card reader
 
+// Block cache (per device): keep FAT/directory sectors and merge small writes e.g 16 blocks. Disabled since it
+// takes (CACHE_BLOCKS + CACHE_XFER_BLOCKS) * 512 bytes for each of CFG_TUH_DEVICE_MAX
+#define CFG_TUH_MSC_CACHE_BLOCKS       0
+#define CFG_TUH_MSC_CACHE_XFER_BLOCKS  4
+
+// Queue SCSI commands so that large reads/writes are issued back-to-back
+#define CFG_TUH_MSC_CMD_QUEUE          4
+
 #ifdef __cplusplus
  }
 #endif
@@ -246,6 +246,7 @@ function(family_configure_common TARGET RTOS)
       -Wmissing-prototypes
       )
     target_link_options(${TARGET} PUBLIC "LINKER:-Map=$<TARGET_FILE:${TARGET}>.map")
+    family_add_memory_report(${TARGET})
     if (CMAKE_C_COMPILER_ID STREQUAL "GNU" AND CMAKE_C_COMPILER_VERSION VERSION_GREATER_EQUAL 12.0
       AND NO_WARN_RWX_SEGMENTS_SUPPORTED AND (NOT RTOS STREQUAL zephyr))
       target_link_options(${TARGET} PUBLIC "LINKER:--no-warn-rwx-segments")
@@ -306,6 +307,14 @@ function(family_add_bin_hex TARGET)
   endif()
 endfunction()
 
+# Add <TARGET>-memory_report target: code and static RAM of each TinyUSB module from linker map
+function(family_add_memory_report TARGET)
+  add_custom_target(${TARGET}-memory_report
+    COMMAND python ${TOP}/tools/memory_report.py $<TARGET_FILE:${TARGET}>.map
+    DEPENDS ${TARGET}
+    VERBATIM)
+endfunction()
+
 # Add uf2 output
 function(family_add_uf2 TARGET FAMILY_ID)
   set(BIN_FILE $<TARGET_FILE_DIR:${TARGET}>/${TARGET}.hex)
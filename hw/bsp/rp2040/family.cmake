@@ -49,6 +49,8 @@ add_library(tinyusb_common_base INTERFACE)
 target_sources(tinyusb_common_base INTERFACE
 	${TOP}/src/tusb.c
 	${TOP}/src/common/tusb_fifo.c
+	${TOP}/src/common/tusb_capture.c
+	${TOP}/src/common/tusb_bridge.c
 	)
 
 target_include_directories(tinyusb_common_base INTERFACE
@@ -93,6 +95,8 @@ target_sources(tinyusb_device_base INTERFACE
 		${TOP}/src/class/hid/hid_device.c
 		${TOP}/src/class/midi/midi_device.c
 		${TOP}/src/class/msc/msc_device.c
+		${TOP}/src/class/msc/msc_cache.c
+		${TOP}/src/class/msc/uas_device.c
 		${TOP}/src/class/net/ecm_rndis_device.c
 		${TOP}/src/class/net/ncm_device.c
 		${TOP}/src/class/usbtmc/usbtmc_device.c
@@ -112,6 +116,8 @@ target_sources(tinyusb_host_base INTERFACE
 		${TOP}/src/class/cdc/cdc_host.c
 		${TOP}/src/class/hid/hid_host.c
 		${TOP}/src/class/msc/msc_host.c
+		${TOP}/src/class/msc/msc_passthrough.c
+		${TOP}/src/class/net/ncm_host.c
 		${TOP}/src/class/vendor/vendor_host.c
 		)
 
@@ -339,6 +345,8 @@ function(suppress_tinyusb_warnings)
 			set(CONVERSION_WARNING_FILES
 				${PICO_TINYUSB_PATH}/src/tusb.c
 				${PICO_TINYUSB_PATH}/src/common/tusb_fifo.c
+				${PICO_TINYUSB_PATH}/src/common/tusb_capture.c
+				${PICO_TINYUSB_PATH}/src/common/tusb_bridge.c
 				${PICO_TINYUSB_PATH}/src/device/usbd.c
 				${PICO_TINYUSB_PATH}/src/device/usbd_control.c
 				${PICO_TINYUSB_PATH}/src/host/usbh.c
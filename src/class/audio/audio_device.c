@@ -79,18 +79,9 @@
 // Linear buffer in case target MCU is not capable of handling a ring buffer FIFO e.g. no hardware buffer
 // is available or driver is would need to be changed dramatically
 
-// Only STM32 and dcd_transdimension use non-linear buffer for now
-// dwc2 except esp32sx (since it may use dcd_esp32sx)
-// Ring buffer is incompatible with dcache, since neither address nor size is aligned to cache line
-#if (defined(TUP_USBIP_DWC2) && !TU_CHECK_MCU(OPT_MCU_ESP32S2, OPT_MCU_ESP32S3)) || \
-    defined(TUP_USBIP_FSDEV) ||                                                     \
-    CFG_TUSB_MCU == OPT_MCU_RX63X ||                                                \
-    CFG_TUSB_MCU == OPT_MCU_RX65X ||                                                \
-    CFG_TUSB_MCU == OPT_MCU_RX72N ||                                                \
-    CFG_TUSB_MCU == OPT_MCU_LPC18XX ||                                              \
-    CFG_TUSB_MCU == OPT_MCU_LPC43XX ||                                              \
-    CFG_TUSB_MCU == OPT_MCU_MIMXRT1XXX ||                                           \
-    CFG_TUSB_MCU == OPT_MCU_MSP432E4
+// Only DCDs implementing dcd_edpt_xfer_fifo() can use non-linear buffer, see TUP_DCD_EDPT_XFER_FIFO and
+// dcd_caps_t.xfer_fifo. Ring buffer is incompatible with dcache, since neither address nor size is aligned to cache line
+#if defined(TUP_DCD_EDPT_XFER_FIFO)
   #if TUD_AUDIO_PREFER_RING_BUFFER && !CFG_TUD_MEM_DCACHE_ENABLE
     #define USE_LINEAR_BUFFER 0
   #else
@@ -100,6 +91,14 @@
   #define USE_LINEAR_BUFFER 1
 #endif
 
+// Sample format conversion per direction, see tud_audio_conv_params_cb()
+#define AUDIOD_CONV_RX (CFG_TUD_AUDIO_ENABLE_CONVERSION && CFG_TUD_AUDIO_ENABLE_EP_OUT && CFG_TUD_AUDIO_ENABLE_DECODING && CFG_TUD_AUDIO_ENABLE_TYPE_I_DECODING)
+#define AUDIOD_CONV_TX (CFG_TUD_AUDIO_ENABLE_CONVERSION && CFG_TUD_AUDIO_ENABLE_EP_IN && CFG_TUD_AUDIO_ENABLE_ENCODING && CFG_TUD_AUDIO_ENABLE_TYPE_I_ENCODING)
+
+// Resampling of support FIFO data per direction, see tud_audio_n_resampler_enable()
+#define AUDIOD_RS_RX (CFG_TUD_AUDIO_ENABLE_RESAMPLER && CFG_TUD_AUDIO_ENABLE_EP_OUT && CFG_TUD_AUDIO_ENABLE_DECODING && CFG_TUD_AUDIO_ENABLE_TYPE_I_DECODING)
+#define AUDIOD_RS_TX (CFG_TUD_AUDIO_ENABLE_RESAMPLER && CFG_TUD_AUDIO_ENABLE_EP_IN && CFG_TUD_AUDIO_ENABLE_ENCODING && CFG_TUD_AUDIO_ENABLE_TYPE_I_ENCODING)
+
 // Declaration of buffers
 
 // Check for maximum supported numbers
@@ -107,8 +106,11 @@
   #error Maximum number of audio functions restricted to three!
 #endif
 
+// Double buffering of IN EP queues linear buffers
+#define USE_LINEAR_BUFFER_IN (USE_LINEAR_BUFFER || CFG_TUD_AUDIO_ENABLE_ENCODING || CFG_TUD_AUDIO_EP_IN_DOUBLE_BUFFER)
+
 // Put swap buffer in USB section only if necessary
-#if USE_LINEAR_BUFFER || CFG_TUD_AUDIO_ENABLE_ENCODING
+#if USE_LINEAR_BUFFER_IN
   #define IN_SW_BUF_MEM_ATTR TU_ATTR_ALIGNED(4)
 #else
   #define IN_SW_BUF_MEM_ATTR CFG_TUD_MEM_SECTION CFG_TUD_MEM_ALIGN
@@ -149,19 +151,29 @@ tu_static IN_SW_BUF_MEM_ATTR struct {
 // Linear buffer TX in case:
 // - target MCU is not capable of handling a ring buffer FIFO e.g. no hardware buffer is available or driver is would need to be changed dramatically OR
 // - the software encoding is used - in this case the linear buffers serve as a target memory where logical channels are encoded into
-#if CFG_TUD_AUDIO_ENABLE_EP_IN && (USE_LINEAR_BUFFER || CFG_TUD_AUDIO_ENABLE_ENCODING)
+// - double buffering is enabled, packets are prepared into the second buffer while the first is on the wire
+#if CFG_TUD_AUDIO_ENABLE_EP_IN && USE_LINEAR_BUFFER_IN
 tu_static CFG_TUD_MEM_SECTION struct {
   #if CFG_TUD_AUDIO_FUNC_1_EP_IN_SZ_MAX > 0
   TUD_EPBUF_DEF(buf_1, CFG_TUD_AUDIO_FUNC_1_EP_IN_SZ_MAX);
+    #if CFG_TUD_AUDIO_EP_IN_DOUBLE_BUFFER
+  TUD_EPBUF_DEF(buf_1_alt, CFG_TUD_AUDIO_FUNC_1_EP_IN_SZ_MAX);
+    #endif
   #endif
   #if CFG_TUD_AUDIO > 1 && CFG_TUD_AUDIO_FUNC_2_EP_IN_SZ_MAX > 0
   TUD_EPBUF_DEF(buf_2, CFG_TUD_AUDIO_FUNC_2_EP_IN_SZ_MAX);
+    #if CFG_TUD_AUDIO_EP_IN_DOUBLE_BUFFER
+  TUD_EPBUF_DEF(buf_2_alt, CFG_TUD_AUDIO_FUNC_2_EP_IN_SZ_MAX);
+    #endif
   #endif
   #if CFG_TUD_AUDIO > 2 && CFG_TUD_AUDIO_FUNC_3_EP_IN_SZ_MAX > 0
   TUD_EPBUF_DEF(buf_3, CFG_TUD_AUDIO_FUNC_3_EP_IN_SZ_MAX);
+    #if CFG_TUD_AUDIO_EP_IN_DOUBLE_BUFFER
+  TUD_EPBUF_DEF(buf_3_alt, CFG_TUD_AUDIO_FUNC_3_EP_IN_SZ_MAX);
+    #endif
   #endif
 } lin_buf_in;
-#endif// CFG_TUD_AUDIO_ENABLE_EP_IN && (USE_LINEAR_BUFFER || CFG_TUD_AUDIO_ENABLE_DECODING)
+#endif// CFG_TUD_AUDIO_ENABLE_EP_IN && USE_LINEAR_BUFFER_IN
 
 // EP OUT software buffers and mutexes
 #if CFG_TUD_AUDIO_ENABLE_EP_OUT && !CFG_TUD_AUDIO_ENABLE_DECODING
@@ -304,6 +316,43 @@ tu_static CFG_TUD_MEM_SECTION struct {
 } int_ep_buf[CFG_TUD_AUDIO];
 #endif
 
+#if CFG_TUD_AUDIO_ENABLE_RESAMPLER
+  #define AUDIOD_RS_TAPS   16
+  #define AUDIOD_RS_PHASES 64
+  #define AUDIOD_RS_ONE    ((uint32_t) 1 << 30)// Q2.30
+
+// Resampler state of one support FIFO
+typedef struct {
+  // History of each channel, every sample is written twice s.t. the last AUDIOD_RS_TAPS samples are contiguous
+  union {
+    int16_t s16[CFG_TUD_AUDIO_RESAMPLER_N_CHANNELS_MAX][2 * AUDIOD_RS_TAPS];
+    int32_t s32[CFG_TUD_AUDIO_RESAMPLER_N_CHANNELS_MAX][2 * AUDIOD_RS_TAPS];
+  } hist;
+  uint32_t frac;// Position of next output after history tap 7 in Q2.30, new input is needed once it is 1.0
+  uint8_t idx;  // Oldest history sample
+} audiod_rs_ff_t;
+
+typedef struct {
+  audiod_rs_ff_t ff[CFG_TUD_AUDIO_RESAMPLER_N_FF_MAX];
+  uint32_t step;  // Input samples per output sample in Q2.30
+  int32_t integ;  // Integral correction of step in Q2.30
+  int32_t lvl_avg;// Filtered level of support FIFO 0 in 1/256 frame
+  uint8_t n_bytes;// Sample size in support FIFOs, 0 if format is not supported
+  uint8_t n_ch;   // Channels per support FIFO
+} audiod_rs_t;
+#endif
+
+// Parsed AS alternate setting
+typedef struct {
+  uint16_t desc_offset;      // Offset of Standard AS Interface Descriptor from p_desc
+  uint8_t itf;
+  uint8_t alt;
+  uint8_t format_type;       // bFormatType of Class-Specific AS Interface Descriptor, AUDIO_FORMAT_TYPE_UNDEFINED if not found
+  uint8_t n_channels;
+  uint8_t n_bytes_per_sample;// bSubslotSize of Type I Format Type Descriptor, 0 if not found
+  uint32_t format_type_I;    // bmFormats
+} audiod_alt_cfg_t;
+
 typedef struct
 {
   uint8_t rhport;
@@ -358,6 +407,23 @@ typedef struct
         uint16_t fifo_lvl_thr; // fifo level threshold
         uint16_t rate_const[2];// pre-computed feedback/fifo_depth rate
       } fifo_count;
+
+      struct {
+        int64_t err_sum;      // Accumulated level error in 1/256 byte
+        int64_t err_sum_max;  // Anti-windup limit of err_sum
+        uint32_t base_value;  // Rate estimate in 16.16 format
+        uint32_t sample_freq;
+        uint32_t mclk_freq;   // 0 if rate is not measured
+        uint32_t kp;          // Proportional gain in 2^-32 sample per frame for each 1/256 byte of error
+        uint32_t clamp_count;
+        int32_t lvl_avg;      // Filtered level in 1/256 byte
+        int32_t p_term;       // Last corrections in 16.16 format for telemetry
+        int32_t i_term;
+        uint16_t fifo_lvl_thr;
+        uint16_t lvl_min;
+        uint16_t lvl_max;
+        uint8_t kp_shift;     // Kp = 2^-kp_shift sample per frame for each slot of error, Ki = Kp^2/4
+      } fifo_pi;
     } compute;
 
   } feedback;
@@ -374,6 +440,12 @@ typedef struct
   uint8_t n_bytes_per_sample_rx;
   uint8_t n_ff_used_rx;
   #endif
+  #if AUDIOD_CONV_RX
+  audio_conv_params_t conv_rx;// Format of samples in support FIFOs, conversion is disabled if n_bytes_per_sample is 0
+  #endif
+  #if AUDIOD_RS_RX
+  audiod_rs_t rs_rx;
+  #endif
 #endif
 
 #if CFG_TUD_AUDIO_ENABLE_EP_IN && CFG_TUD_AUDIO_EP_IN_FLOW_CONTROL
@@ -393,6 +465,12 @@ typedef struct
   audio_data_format_type_I_t format_type_I_tx;
   uint8_t n_ff_used_tx;
   #endif
+  #if AUDIOD_CONV_TX
+  audio_conv_params_t conv_tx;// Format of samples in support FIFOs, conversion is disabled if n_bytes_per_sample is 0
+  #endif
+  #if AUDIOD_RS_TX
+  audiod_rs_t rs_tx;
+  #endif
 #endif
 
   /*------------- From this point, data is not cleared by bus reset -------------*/
@@ -404,6 +482,33 @@ typedef struct
   // Current active alternate settings
   uint8_t *alt_setting;// We need to save the current alternate setting this way, because it is possible that there are AS interfaces which do not have an EP!
 
+#if CFG_TUD_AUDIO_ENABLE_CONVERSION
+  // Conversion gains indexed by EP direction: set by application per logical channel (index 0 is master) and
+  // resulting gain of each channel
+  uint16_t gain[2][1 + CFG_TUD_AUDIO_CONV_N_CHANNELS_MAX];
+  uint16_t gain_ch[2][CFG_TUD_AUDIO_CONV_N_CHANNELS_MAX];
+#endif
+
+#if CFG_TUD_AUDIO_ENABLE_RESAMPLER
+  bool rs_enabled[2];// Resampler enabled by application, indexed by EP direction
+#endif
+
+#if CFG_TUD_AUDIO_ENABLE_STATS
+  // Kept over bus reset to catch glitches caused by it
+  audio_stats_t stats;
+  uint32_t stats_pkt_avg[2];// Average data packet size in 1/256 byte indexed by EP direction, 0 until first non-empty packet
+  uint16_t stats_slot_sz[2];// Audio slot size of active alternate setting indexed by EP direction, 0 if unknown
+  uint32_t stats_sof_ts;    // Timestamp and frame number of last SOF
+  uint32_t stats_sof_frame;
+  bool stats_sof_valid;
+#endif
+
+#if CFG_TUD_AUDIO_ALT_CFG_MAX
+  // Alternate settings with EPs, parsed when mounted
+  audiod_alt_cfg_t alt_cfg[CFG_TUD_AUDIO_ALT_CFG_MAX];
+  uint8_t n_alt_cfg;
+#endif
+
 // EP Transfer buffers and FIFOs
 #if CFG_TUD_AUDIO_ENABLE_EP_OUT && !CFG_TUD_AUDIO_ENABLE_DECODING
   tu_fifo_t ep_out_ff;
@@ -438,8 +543,11 @@ typedef struct
   #define USE_LINEAR_BUFFER_RX 1
 #endif
 
-#if CFG_TUD_AUDIO_ENABLE_EP_IN && (USE_LINEAR_BUFFER || CFG_TUD_AUDIO_ENABLE_ENCODING)
+#if CFG_TUD_AUDIO_ENABLE_EP_IN && USE_LINEAR_BUFFER_IN
   uint8_t *lin_buf_in;
+  #if CFG_TUD_AUDIO_EP_IN_DOUBLE_BUFFER
+  uint8_t *lin_buf_in_alt;// Buffer on the wire or queued, swapped with lin_buf_in once lin_buf_in is queued
+  #endif
   #define USE_LINEAR_BUFFER_TX 1
 #endif
 
@@ -524,12 +632,27 @@ TU_ATTR_WEAK TU_ATTR_FAST_FUNC void tud_audio_feedback_interval_isr(uint8_t func
 }
 #endif
 
+#if CFG_TUD_AUDIO_ENABLE_STATS
+TU_ATTR_WEAK TU_ATTR_FAST_FUNC uint32_t tud_audio_stats_timestamp_cb(void) {
+  return 0;
+}
+#endif
+
 #if CFG_TUD_AUDIO_ENABLE_INTERRUPT_EP
 TU_ATTR_WEAK void tud_audio_int_done_cb(uint8_t rhport) {
   (void) rhport;
 }
 #endif
 
+#if CFG_TUD_AUDIO_ENABLE_CONVERSION
+TU_ATTR_WEAK void tud_audio_conv_params_cb(uint8_t func_id, uint8_t alt_itf, uint8_t ep_addr, audio_conv_params_t *conv_param) {
+  (void) func_id;
+  (void) alt_itf;
+  (void) ep_addr;
+  (void) conv_param;
+}
+#endif
+
 // Invoked when audio set interface request received
 TU_ATTR_WEAK bool tud_audio_set_itf_cb(uint8_t rhport, tusb_control_request_t const *p_request) {
   (void) rhport;
@@ -626,12 +749,27 @@ static bool audiod_verify_itf_exists(uint8_t itf, uint8_t *func_id);
 static bool audiod_verify_ep_exists(uint8_t ep, uint8_t *func_id);
 static uint8_t audiod_get_audio_fct_idx(audiod_function_t *audio);
 
-#if (CFG_TUD_AUDIO_ENABLE_EP_IN && (CFG_TUD_AUDIO_EP_IN_FLOW_CONTROL || CFG_TUD_AUDIO_ENABLE_ENCODING)) || (CFG_TUD_AUDIO_ENABLE_EP_OUT && CFG_TUD_AUDIO_ENABLE_DECODING)
-static void audiod_parse_for_AS_params(audiod_function_t *audio, uint8_t const *p_desc, uint8_t const *p_desc_end, uint8_t const as_itf);
+static void audiod_parse_alt_cfg(uint8_t const *p_desc, uint8_t const *p_desc_end, audiod_alt_cfg_t *cfg);
+#if CFG_TUD_AUDIO_ALT_CFG_MAX
+static void audiod_build_alt_cfg(audiod_function_t *audio);
+#endif
 
 static inline uint8_t tu_desc_subtype(void const *desc) {
   return ((uint8_t const *) desc)[2];
 }
+
+#if AUDIOD_CONV_RX || AUDIOD_CONV_TX
+static bool audiod_conv_setup(uint8_t func_id, uint8_t alt, uint8_t ep_addr, audio_conv_params_t *conv, uint8_t ep_bytes, uint8_t n_channels);
+#endif
+
+#if AUDIOD_RS_RX || AUDIOD_RS_TX
+static void audiod_rs_setup(audiod_rs_t *rs, uint8_t n_bytes, uint8_t n_ch, uint8_t n_ff_used, tu_fifo_t *ff);
+#endif
+#if AUDIOD_RS_RX
+static uint16_t audiod_rs_read(audiod_function_t *audio, uint8_t ff_idx, uint8_t *buffer, uint16_t bufsize);
+#endif
+#if AUDIOD_RS_TX
+static uint16_t audiod_rs_write(audiod_function_t *audio, uint8_t ff_idx, uint8_t const *data, uint16_t len);
 #endif
 
 #if CFG_TUD_AUDIO_ENABLE_EP_IN && CFG_TUD_AUDIO_EP_IN_FLOW_CONTROL
@@ -639,9 +777,15 @@ static bool audiod_calc_tx_packet_sz(audiod_function_t *audio);
 static uint16_t audiod_tx_packet_size(const uint16_t *norminal_size, uint16_t data_count, uint16_t fifo_depth, uint16_t max_size);
 #endif
 
+#if CFG_TUD_AUDIO_ENABLE_STATS
+static void audiod_stats_packet(audiod_function_t *audio, uint8_t ep_dir, uint16_t n_bytes);
+#endif
+
 #if CFG_TUD_AUDIO_ENABLE_EP_OUT && CFG_TUD_AUDIO_ENABLE_FEEDBACK_EP
 static bool audiod_set_fb_params_freq(audiod_function_t *audio, uint32_t sample_freq, uint32_t mclk_freq);
 static void audiod_fb_fifo_count_update(audiod_function_t *audio, uint16_t lvl_new);
+static bool audiod_set_fb_params_pi(audiod_function_t *audio, audio_feedback_params_t const *fb_param, uint8_t slot_size, uint16_t fifo_depth);
+static void audiod_fb_fifo_pi_update(audiod_function_t *audio, uint16_t lvl_new);
 #endif
 
 bool tud_audio_n_mounted(uint8_t func_id) {
@@ -693,6 +837,11 @@ uint16_t tud_audio_n_available_support_ff(uint8_t func_id, uint8_t ff_idx) {
 
 uint16_t tud_audio_n_read_support_ff(uint8_t func_id, uint8_t ff_idx, void *buffer, uint16_t bufsize) {
   TU_VERIFY(func_id < CFG_TUD_AUDIO && _audiod_fct[func_id].p_desc != NULL && ff_idx < _audiod_fct[func_id].n_rx_supp_ff);
+  #if AUDIOD_RS_RX
+  if (_audiod_fct[func_id].rs_enabled[TUSB_DIR_OUT] && _audiod_fct[func_id].rs_rx.n_bytes != 0) {
+    return audiod_rs_read(&_audiod_fct[func_id], ff_idx, (uint8_t *) buffer, bufsize);
+  }
+  #endif
   return tu_fifo_read_n(&_audiod_fct[func_id].rx_supp_ff[ff_idx], buffer, bufsize);
 }
 
@@ -715,6 +864,10 @@ static bool audiod_rx_done_cb(uint8_t rhport, audiod_function_t *audio, uint16_t
   idx_audio_fct = audiod_get_audio_fct_idx(audio);
   TU_VERIFY(audiod_get_AS_interface_index(audio->ep_out_as_intf_num, audio, &idxItf, &dummy2));
 
+  #if CFG_TUD_AUDIO_ENABLE_STATS
+  audiod_stats_packet(audio, TUSB_DIR_OUT, n_bytes_received);
+  #endif
+
   // Call a weak callback here - a possibility for user to get informed an audio packet was received and data gets now loaded into EP FIFO (or decoded into support RX software FIFO)
   TU_VERIFY(tud_audio_rx_done_pre_read_cb(rhport, n_bytes_received, idx_audio_fct, audio->ep_out, audio->alt_setting[idxItf]));
 
@@ -755,12 +908,22 @@ static bool audiod_rx_done_cb(uint8_t rhport, audiod_function_t *audio, uint16_t
   #else
 
     #if USE_LINEAR_BUFFER_RX
+      #if CFG_TUD_AUDIO_ENABLE_STATS
+  // EP OUT FIFO is overwritable, oldest data is lost
+  if (tu_fifo_remaining(&audio->ep_out_ff) < n_bytes_received) audio->stats.rx_overrun++;
+      #endif
+
   // Data currently is in linear buffer, copy into EP OUT FIFO
   TU_VERIFY(tu_fifo_write_n(&audio->ep_out_ff, audio->lin_buf_out, n_bytes_received));
 
   // Schedule for next receive
   TU_VERIFY(usbd_edpt_xfer(rhport, audio->ep_out, audio->lin_buf_out, audio->ep_out_sz), false);
     #else
+      #if CFG_TUD_AUDIO_ENABLE_STATS
+  // Data was written by DCD, a full FIFO has likely been overwritten
+  if (n_bytes_received && tu_fifo_full(&audio->ep_out_ff)) audio->stats.rx_overrun++;
+      #endif
+
   // Data is already placed in EP FIFO, schedule for next receive
   TU_VERIFY(usbd_edpt_xfer_fifo(rhport, audio->ep_out, &audio->ep_out_ff, audio->ep_out_sz), false);
     #endif
@@ -768,6 +931,8 @@ static bool audiod_rx_done_cb(uint8_t rhport, audiod_function_t *audio, uint16_t
     #if CFG_TUD_AUDIO_ENABLE_FEEDBACK_EP
   if (audio->feedback.compute_method == AUDIO_FEEDBACK_METHOD_FIFO_COUNT) {
     audiod_fb_fifo_count_update(audio, tu_fifo_count(&audio->ep_out_ff));
+  } else if (audio->feedback.compute_method == AUDIO_FEEDBACK_METHOD_FIFO_PI) {
+    audiod_fb_fifo_pi_update(audio, tu_fifo_count(&audio->ep_out_ff));
   }
     #endif
 
@@ -781,6 +946,142 @@ static bool audiod_rx_done_cb(uint8_t rhport, audiod_function_t *audio, uint16_t
 
 #endif//CFG_TUD_AUDIO_ENABLE_EP_OUT
 
+#if (CFG_TUD_AUDIO_ENABLE_DECODING && CFG_TUD_AUDIO_ENABLE_EP_OUT) || (CFG_TUD_AUDIO_ENABLE_ENCODING && CFG_TUD_AUDIO_ENABLE_EP_IN)
+
+// Copy n_frames frames of one support FIFO (2 channels each) between FIFO and interleaved linear buffer, pointers
+// advance by dst_step/src_step frames. Always inlined so that the callers below specialize it for the common FIFO
+// counts: with constant sample size and step the compiler unrolls the loops and uses wide / vector load-store
+// (LDRD/LDM on Cortex-M, MVE on Helium, Xtensa SIMD) instead of a generic strided loop. Returns src and dst end.
+TU_ATTR_ALWAYS_INLINE static inline void audiod_copy_frames(uint8_t const nBytesPerSample, uint8_t **p_dst, uint8_t **p_src,
+                                                            uint16_t n_frames, uint16_t const dst_step, uint16_t const src_step) {
+  if (nBytesPerSample == 2 || nBytesPerSample == 4) {
+    // 1 or 2 words per frame
+    uint8_t const n_words = nBytesPerSample / 2;
+    uint32_t *dst32 = (uint32_t *) (void *) *p_dst;
+    uint32_t const *src32 = (uint32_t const *) (void const *) *p_src;
+    while (n_frames--) {
+      for (uint8_t w = 0; w < n_words; w++) {
+        dst32[w] = src32[w];
+      }
+      dst32 += n_words * dst_step;
+      src32 += n_words * src_step;
+    }
+    *p_dst = (uint8_t *) dst32;
+    *p_src = (uint8_t *) (uintptr_t) src32;
+  } else {
+    // 1 or 3 halfwords per frame
+    uint8_t const n_words = nBytesPerSample;
+    uint16_t *dst16 = (uint16_t *) (void *) *p_dst;
+    uint16_t const *src16 = (uint16_t const *) (void const *) *p_src;
+    while (n_frames--) {
+      for (uint8_t w = 0; w < n_words; w++) {
+        dst16[w] = src16[w];
+      }
+      dst16 += n_words * dst_step;
+      src16 += n_words * src_step;
+    }
+    *p_dst = (uint8_t *) dst16;
+    *p_src = (uint8_t *) (uintptr_t) src16;
+  }
+}
+
+TU_ATTR_ALWAYS_INLINE static inline void audiod_copy_frames_n(uint8_t const nBytesPerSample, uint8_t **p_dst, uint8_t **p_src,
+                                                              uint16_t n_frames, uint16_t const dst_step, uint16_t const src_step) {
+  switch (nBytesPerSample) {
+    case 1: audiod_copy_frames(1, p_dst, p_src, n_frames, dst_step, src_step); break;
+    case 2: audiod_copy_frames(2, p_dst, p_src, n_frames, dst_step, src_step); break;
+    case 3: audiod_copy_frames(3, p_dst, p_src, n_frames, dst_step, src_step); break;
+    default: audiod_copy_frames(4, p_dst, p_src, n_frames, dst_step, src_step); break;
+  }
+}
+
+#endif
+
+#if AUDIOD_CONV_RX || AUDIOD_CONV_TX
+
+// Read little endian sample of n_bytes as MSB aligned 32-bit value. n_bits_right != 0: sample is right justified
+TU_ATTR_ALWAYS_INLINE static inline int32_t audiod_conv_read(uint8_t const *p, uint8_t n_bytes, uint8_t n_bits_right) {
+  uint32_t v = p[0];
+  for (uint8_t i = 1; i < n_bytes; i++) {
+    v |= (uint32_t) p[i] << (8 * i);
+  }
+  return (int32_t) (v << (n_bits_right ? (32 - n_bits_right) : (32 - 8 * n_bytes)));
+}
+
+// Write MSB aligned 32-bit value as little endian sample of n_bytes. n_bits_right != 0: sample is right justified
+TU_ATTR_ALWAYS_INLINE static inline void audiod_conv_write(uint8_t *p, int32_t sample, uint8_t n_bytes, uint8_t n_bits_right) {
+  // arithmetic shift: right justified samples are sign extended
+  uint32_t const v = n_bits_right ? (uint32_t) (sample >> (32 - n_bits_right)) : ((uint32_t) sample >> (32 - 8 * n_bytes));
+  for (uint8_t i = 0; i < n_bytes; i++) {
+    p[i] = (uint8_t) (v >> (8 * i));
+  }
+}
+
+// Multiply by Q1.15 gain with saturation
+TU_ATTR_ALWAYS_INLINE static inline int32_t audiod_conv_gain(int32_t sample, uint16_t gain) {
+  int64_t const v = ((int64_t) sample * gain) >> 15;
+  return (v > INT32_MAX) ? INT32_MAX : (v < INT32_MIN) ? INT32_MIN : (int32_t) v;
+}
+
+// Convert n_samples between one support FIFO and the EP linear buffer holding all support FIFOs' channels interleaved.
+// ff is the support FIFO buffer, ep the position in the linear buffer; *p_ch is the channel within the FIFO of the
+// first sample, kept across calls for the wrapped part of the FIFO. Returns EP position after the last sample
+static uint8_t *audiod_conv_copy(audiod_function_t const *audio, bool decode, uint8_t ff_idx, uint8_t *ff, uint8_t *ep,
+                                 uint16_t n_samples, uint8_t *p_ch) {
+  audio_conv_params_t const *conv;
+  uint8_t ep_bytes, n_ch, n_ff_used;
+  uint16_t const *gain;
+
+  #if AUDIOD_CONV_RX
+  if (decode) {
+    conv = &audio->conv_rx;
+    ep_bytes = audio->n_bytes_per_sample_rx;
+    n_ch = audio->n_channels_per_ff_rx;
+    n_ff_used = audio->n_ff_used_rx;
+    gain = audio->gain_ch[TUSB_DIR_OUT];
+  }
+  #endif
+  #if AUDIOD_CONV_TX
+  if (!decode) {
+    conv = &audio->conv_tx;
+    ep_bytes = audio->n_bytes_per_sample_tx;
+    n_ch = audio->n_channels_per_ff_tx;
+    n_ff_used = audio->n_ff_used_tx;
+    gain = audio->gain_ch[TUSB_DIR_IN];
+  }
+  #endif
+
+  uint8_t const ff_bytes = conv->n_bytes_per_sample;
+  uint8_t const n_bits_right = conv->n_bits_right;
+  bool const apply_gain = conv->apply_gain;
+  uint16_t const ep_skip = (uint16_t) ((n_ff_used - 1) * n_ch * ep_bytes);// channels of other FIFOs in EP frame
+  gain += ff_idx * n_ch;
+  uint8_t ch = *p_ch;
+
+  while (n_samples--) {
+    int32_t sample = decode ? audiod_conv_read(ep, ep_bytes, 0) : audiod_conv_read(ff, ff_bytes, n_bits_right);
+    if (apply_gain) {
+      sample = audiod_conv_gain(sample, gain[ch]);
+    }
+    if (decode) {
+      audiod_conv_write(ff, sample, ff_bytes, n_bits_right);
+    } else {
+      audiod_conv_write(ep, sample, ep_bytes, 0);
+    }
+    ff += ff_bytes;
+    ep += ep_bytes;
+    if (++ch == n_ch) {
+      ch = 0;
+      ep += ep_skip;
+    }
+  }
+
+  *p_ch = ch;
+  return ep;
+}
+
+#endif
+
 // The following functions are used in case CFG_TUD_AUDIO_ENABLE_DECODING != 0
 #if CFG_TUD_AUDIO_ENABLE_DECODING && CFG_TUD_AUDIO_ENABLE_EP_OUT
 
@@ -789,42 +1090,24 @@ static bool audiod_rx_done_cb(uint8_t rhport, audiod_function_t *audio, uint16_t
 // Helper function
 static inline void *audiod_interleaved_copy_bytes_fast_decode(uint16_t const nBytesPerSample, void *dst, const void *dst_end, void *src, uint8_t const n_ff_used) {
   // Due to one FIFO contains 2 channels, data always aligned to (nBytesPerSample * 2)
-  uint16_t *dst16 = dst;
-  uint16_t *src16 = src;
-  const uint16_t *dst_end16 = dst_end;
-  uint32_t *dst32 = dst;
-  uint32_t *src32 = src;
-  const uint32_t *dst_end32 = dst_end;
-
-  if (nBytesPerSample == 1) {
-    while (dst16 < dst_end16) {
-      *dst16++ = *src16++;
-      src16 += n_ff_used - 1;
-    }
-    return src16;
-  } else if (nBytesPerSample == 2) {
-    while (dst32 < dst_end32) {
-      *dst32++ = *src32++;
-      src32 += n_ff_used - 1;
-    }
-    return src32;
-  } else if (nBytesPerSample == 3) {
-    while (dst16 < dst_end16) {
-      *dst16++ = *src16++;
-      *dst16++ = *src16++;
-      *dst16++ = *src16++;
-      src16 += 3 * (n_ff_used - 1);
-    }
-    return src16;
-  } else// nBytesPerSample == 4
-  {
-    while (dst32 < dst_end32) {
-      *dst32++ = *src32++;
-      *dst32++ = *src32++;
-      src32 += 2 * (n_ff_used - 1);
-    }
-    return src32;
+  uint16_t const n_bytes = (uint16_t) ((uint8_t const *) dst_end - (uint8_t const *) dst);
+  uint8_t *dst8 = dst;
+  uint8_t *src8 = src;
+
+  if (n_ff_used == 1) {
+    // all channels in one FIFO: nothing to de-interleave
+    memcpy(dst8, src8, n_bytes);
+    return src8 + n_bytes;
   }
+
+  uint16_t const n_frames = (uint16_t) (n_bytes / (2 * nBytesPerSample));
+  uint8_t const n_bytes_per_sample = (uint8_t) nBytesPerSample;
+  switch (n_ff_used) {
+    case 2: audiod_copy_frames_n(n_bytes_per_sample, &dst8, &src8, n_frames, 1, 2); break;
+    case 4: audiod_copy_frames_n(n_bytes_per_sample, &dst8, &src8, n_frames, 1, 4); break;
+    default: audiod_copy_frames_n(n_bytes_per_sample, &dst8, &src8, n_frames, 1, n_ff_used); break;
+  }
+  return src8;
 }
 
 static bool audiod_decode_type_I_pcm(uint8_t rhport, audiod_function_t *audio, uint16_t n_bytes_received) {
@@ -840,10 +1123,39 @@ static bool audiod_decode_type_I_pcm(uint8_t rhport, audiod_function_t *audio, u
   uint8_t *dst_end;
 
   tu_fifo_buffer_info_t info;
+  #if CFG_TUD_AUDIO_ENABLE_STATS
+  bool overrun = false;
+  #endif
 
   for (cnt_ff = 0; cnt_ff < n_ff_used; cnt_ff++) {
     tu_fifo_get_write_info(&audio->rx_supp_ff[cnt_ff], &info);
 
+  #if AUDIOD_CONV_RX
+    if (audio->conv_rx.n_bytes_per_sample != 0) {
+      // Convert while copying, FIFO depth is a multiple of its sample size
+      uint8_t const ff_bytes = audio->conv_rx.n_bytes_per_sample;
+      uint16_t const n_samples = nBytesPerFFToRead / audio->n_bytes_per_sample_rx;
+      uint16_t const n_lin = tu_min16(n_samples, info.len_lin / ff_bytes);
+      uint16_t const n_wrap = tu_min16(n_samples - n_lin, info.len_wrap / ff_bytes);
+      uint8_t ch = 0;
+    #if CFG_TUD_AUDIO_ENABLE_STATS
+      overrun |= (n_lin + n_wrap < n_samples);
+    #endif
+
+      src = &audio->lin_buf_out[cnt_ff * audio->n_channels_per_ff_rx * audio->n_bytes_per_sample_rx];
+      src = audiod_conv_copy(audio, true, cnt_ff, info.ptr_lin, src, n_lin, &ch);
+      if (n_wrap != 0) {
+        audiod_conv_copy(audio, true, cnt_ff, info.ptr_wrap, src, n_wrap, &ch);
+      }
+      tu_fifo_advance_write_pointer(&audio->rx_supp_ff[cnt_ff], (uint16_t) ((n_lin + n_wrap) * ff_bytes));
+      continue;
+    }
+  #endif
+
+  #if CFG_TUD_AUDIO_ENABLE_STATS
+    overrun |= (info.len_lin + info.len_wrap < nBytesPerFFToRead);
+  #endif
+
     if (info.len_lin != 0) {
       info.len_lin = tu_min16(nBytesPerFFToRead, info.len_lin);
       src = &audio->lin_buf_out[cnt_ff * audio->n_channels_per_ff_rx * audio->n_bytes_per_sample_rx];
@@ -863,9 +1175,15 @@ static bool audiod_decode_type_I_pcm(uint8_t rhport, audiod_function_t *audio, u
   // Number of bytes should be a multiple of CFG_TUD_AUDIO_N_BYTES_PER_SAMPLE_RX * CFG_TUD_AUDIO_N_CHANNELS_RX but checking makes no sense - no way to correct it
   // TU_VERIFY(cnt != n_bytes);
 
+  #if CFG_TUD_AUDIO_ENABLE_STATS
+  if (overrun) audio->stats.rx_overrun++;
+  #endif
+
   #if CFG_TUD_AUDIO_ENABLE_FEEDBACK_EP
   if (audio->feedback.compute_method == AUDIO_FEEDBACK_METHOD_FIFO_COUNT) {
     audiod_fb_fifo_count_update(audio, tu_fifo_count(&audio->rx_supp_ff[0]));
+  } else if (audio->feedback.compute_method == AUDIO_FEEDBACK_METHOD_FIFO_PI) {
+    audiod_fb_fifo_pi_update(audio, tu_fifo_count(&audio->rx_supp_ff[0]));
   }
   #endif
 
@@ -895,6 +1213,27 @@ uint16_t tud_audio_n_write(uint8_t func_id, const void *data, uint16_t len) {
   return tu_fifo_write_n(&_audiod_fct[func_id].ep_in_ff, data, len);
 }
 
+/**
+ * \brief           Reserve linear space in EP in buffer for zero-copy write
+ *
+ *  Data is written directly into EP in buffer e.g by DMA, then committed with tud_audio_n_write_commit() which must
+ *  always be called after a successful reserve. Reserved space can be less than len at buffer wrap-around.
+ *
+ * \param[in]       func_id: Index of audio function interface
+ * \param[out]      buffer: Start of reserved space
+ * \param[in]       len: # of bytes wanted
+ * \return          Number of bytes reserved
+ */
+uint16_t tud_audio_n_write_reserve(uint8_t func_id, void **buffer, uint16_t len) {
+  TU_VERIFY(func_id < CFG_TUD_AUDIO && _audiod_fct[func_id].p_desc != NULL);
+  return tu_fifo_reserve(&_audiod_fct[func_id].ep_in_ff, buffer, len);
+}
+
+void tud_audio_n_write_commit(uint8_t func_id, uint16_t len) {
+  TU_VERIFY(func_id < CFG_TUD_AUDIO, );
+  tu_fifo_commit(&_audiod_fct[func_id].ep_in_ff, len);
+}
+
 bool tud_audio_n_clear_ep_in_ff(uint8_t func_id)// Delete all content in the EP IN FIFO
 {
   TU_VERIFY(func_id < CFG_TUD_AUDIO && _audiod_fct[func_id].p_desc != NULL);
@@ -932,6 +1271,11 @@ bool tud_audio_n_clear_tx_support_ff(uint8_t func_id, uint8_t ff_idx) {
 
 uint16_t tud_audio_n_write_support_ff(uint8_t func_id, uint8_t ff_idx, const void *data, uint16_t len) {
   TU_VERIFY(func_id < CFG_TUD_AUDIO && _audiod_fct[func_id].p_desc != NULL && ff_idx < _audiod_fct[func_id].n_tx_supp_ff);
+  #if AUDIOD_RS_TX
+  if (_audiod_fct[func_id].rs_enabled[TUSB_DIR_IN] && _audiod_fct[func_id].rs_tx.n_bytes != 0) {
+    return audiod_rs_write(&_audiod_fct[func_id], ff_idx, (uint8_t const *) data, len);
+  }
+  #endif
   return tu_fifo_write_n(&_audiod_fct[func_id].tx_supp_ff[ff_idx], data, len);
 }
 
@@ -966,11 +1310,362 @@ bool tud_audio_int_n_write(uint8_t func_id, const audio_interrupt_data_t *data)
 }
 #endif
 
+#if CFG_TUD_AUDIO_ENABLE_CONVERSION
+// Gain of a logical channel, channel 0 is master applied to all channels. Resulting gains are computed here s.t. encoding
+// and decoding do a single multiply per sample
+bool tud_audio_n_set_gain(uint8_t func_id, uint8_t ep_dir, uint8_t channel, uint16_t gain) {
+  TU_VERIFY(func_id < CFG_TUD_AUDIO && ep_dir <= TUSB_DIR_IN && channel <= CFG_TUD_AUDIO_CONV_N_CHANNELS_MAX);
+  audiod_function_t *audio = &_audiod_fct[func_id];
+
+  audio->gain[ep_dir][channel] = gain;
+  for (uint8_t ch = 0; ch < CFG_TUD_AUDIO_CONV_N_CHANNELS_MAX; ch++) {
+    uint32_t const g = ((uint32_t) audio->gain[ep_dir][0] * audio->gain[ep_dir][ch + 1]) >> 15;
+    audio->gain_ch[ep_dir][ch] = (uint16_t) tu_min32(g, UINT16_MAX);
+  }
+  return true;
+}
+
+// Gain = 10^(volume / (20 * 256)) = 2^(volume * 42.52 / 65536), integer part by shift and fractional part interpolated
+// from a table of 2^(i/16) in Q1.15
+uint16_t tud_audio_volume_to_gain(int16_t volume) {
+  static const uint32_t pow2_frac[17] = {32768, 34219, 35734, 37316, 38968, 40693, 42495, 44376, 46341,
+                                         48393, 50535, 52773, 55109, 57549, 60097, 62757, 65536};
+  if (volume == INT16_MIN) {
+    return 0;// -inf dB
+  }
+
+  int32_t const exp_q16 = ((int32_t) volume * 10885) / 256;
+  int32_t const exp_int = exp_q16 >> 16;// floor, arithmetic shift
+  uint32_t const frac = (uint32_t) exp_q16 & 0xFFFFu;
+  uint32_t const idx = frac >> 12;
+  uint32_t const g = pow2_frac[idx] + (((pow2_frac[idx + 1] - pow2_frac[idx]) * (frac & 0xFFFu)) >> 12);
+
+  if (exp_int >= 1) {
+    return UINT16_MAX;
+  }
+  if (exp_int <= -32) {
+    return 0;
+  }
+  return (uint16_t) tu_min32(g >> (uint32_t) (-exp_int), UINT16_MAX);
+}
+#endif
+
+#if AUDIOD_RS_RX || AUDIOD_RS_TX
+// Resampler: 16 tap windowed sinc (Kaiser, beta 8) interpolation, error is below -80 dB up to 10 kHz at 48 kHz. Row k of
+// the table in Q14 is the filter for an output k/64 sample after history tap 7, rows sum to 1.0. Output is interpolated
+// between two adjacent rows.
+static const int16_t audiod_rs_coef[AUDIOD_RS_PHASES + 1][AUDIOD_RS_TAPS] = {
+  {0, 0, 0, 0, 0, 0, 0, 16384, 0, 0, 0, 0, 0, 0, 0, 0},
+  {-1, 3, -10, 23, -49, 100, -237, 16378, 246, -102, 50, -24, 10, -4, 1, 0},
+  {-2, 7, -20, 46, -97, 197, -466, 16357, 499, -206, 101, -48, 21, -7, 2, 0},
+  {-2, 10, -29, 68, -143, 292, -685, 16321, 761, -312, 153, -73, 31, -11, 3, 0},
+  {-3, 13, -38, 89, -188, 383, -896, 16275, 1031, -420, 206, -99, 42, -15, 4, 0},
+  {-4, 16, -46, 110, -232, 472, -1098, 16213, 1308, -530, 259, -124, 54, -19, 5, 0},
+  {-4, 19, -55, 130, -274, 557, -1290, 16139, 1592, -640, 313, -150, 65, -23, 6, -1},
+  {-5, 21, -62, 149, -314, 639, -1473, 16053, 1883, -752, 367, -176, 76, -28, 7, -1},
+  {-5, 24, -70, 167, -353, 718, -1647, 15951, 2181, -864, 422, -203, 88, -32, 8, -1},
+  {-6, 26, -77, 184, -390, 793, -1811, 15837, 2485, -977, 476, -229, 100, -36, 10, -1},
+  {-6, 28, -83, 200, -425, 865, -1966, 15710, 2795, -1090, 531, -256, 112, -41, 11, -1},
+  {-7, 30, -90, 216, -459, 932, -2111, 15573, 3110, -1203, 586, -283, 124, -45, 12, -1},
+  {-7, 32, -95, 230, -490, 996, -2246, 15422, 3431, -1316, 640, -309, 135, -50, 13, -2},
+  {-7, 33, -101, 244, -520, 1056, -2372, 15258, 3756, -1428, 694, -335, 147, -54, 15, -2},
+  {-8, 35, -106, 256, -547, 1112, -2488, 15084, 4086, -1540, 747, -361, 159, -59, 16, -2},
+  {-8, 36, -110, 268, -573, 1164, -2594, 14896, 4420, -1650, 799, -387, 171, -63, 17, -2},
+  {-8, 37, -114, 279, -596, 1212, -2691, 14696, 4758, -1758, 851, -412, 182, -68, 19, -3},
+  {-8, 38, -118, 288, -618, 1256, -2779, 14489, 5098, -1865, 901, -437, 194, -72, 20, -3},
+  {-8, 39, -121, 297, -638, 1296, -2857, 14269, 5442, -1970, 951, -462, 205, -77, 21, -3},
+  {-8, 40, -124, 305, -655, 1332, -2926, 14035, 5788, -2072, 999, -485, 216, -81, 23, -3},
+  {-8, 41, -126, 311, -670, 1363, -2985, 13796, 6135, -2172, 1046, -508, 226, -85, 24, -4},
+  {-8, 41, -128, 317, -684, 1391, -3036, 13547, 6484, -2268, 1091, -531, 237, -90, 25, -4},
+  {-8, 41, -130, 322, -695, 1414, -3078, 13288, 6834, -2362, 1134, -552, 247, -94, 27, -4},
+  {-8, 41, -131, 326, -705, 1433, -3111, 13021, 7185, -2451, 1175, -573, 256, -98, 28, -4},
+  {-8, 41, -132, 328, -712, 1449, -3135, 12744, 7535, -2537, 1214, -592, 266, -101, 29, -5},
+  {-8, 41, -132, 330, -717, 1460, -3151, 12459, 7885, -2619, 1251, -610, 274, -105, 31, -5},
+  {-8, 41, -132, 331, -721, 1468, -3159, 12168, 8234, -2696, 1285, -628, 283, -109, 32, -5},
+  {-8, 41, -132, 332, -722, 1471, -3159, 11869, 8581, -2768, 1317, -644, 290, -112, 33, -5},
+  {-8, 41, -131, 331, -722, 1471, -3151, 11561, 8927, -2835, 1347, -658, 298, -115, 34, -6},
+  {-7, 40, -130, 329, -720, 1467, -3135, 11250, 9270, -2896, 1373, -672, 304, -118, 35, -6},
+  {-7, 39, -129, 327, -716, 1460, -3112, 10932, 9610, -2952, 1397, -684, 310, -121, 36, -6},
+  {-7, 39, -127, 324, -710, 1449, -3082, 10607, 9946, -3002, 1418, -694, 315, -123, 37, -6},
+  {-7, 38, -125, 320, -703, 1435, -3045, 10279, 10279, -3045, 1435, -703, 320, -125, 38, -7},
+  {-6, 37, -123, 315, -694, 1418, -3002, 9946, 10607, -3082, 1449, -710, 324, -127, 39, -7},
+  {-6, 36, -121, 310, -684, 1397, -2952, 9610, 10932, -3112, 1460, -716, 327, -129, 39, -7},
+  {-6, 35, -118, 304, -672, 1373, -2896, 9270, 11250, -3135, 1467, -720, 329, -130, 40, -7},
+  {-6, 34, -115, 298, -658, 1347, -2835, 8927, 11561, -3151, 1471, -722, 331, -131, 41, -8},
+  {-5, 33, -112, 290, -644, 1317, -2768, 8581, 11869, -3159, 1471, -722, 332, -132, 41, -8},
+  {-5, 32, -109, 283, -628, 1285, -2696, 8234, 12168, -3159, 1468, -721, 331, -132, 41, -8},
+  {-5, 31, -105, 274, -610, 1251, -2619, 7885, 12459, -3151, 1460, -717, 330, -132, 41, -8},
+  {-5, 29, -101, 266, -592, 1214, -2537, 7535, 12744, -3135, 1449, -712, 328, -132, 41, -8},
+  {-4, 28, -98, 256, -573, 1175, -2451, 7185, 13021, -3111, 1433, -705, 326, -131, 41, -8},
+  {-4, 27, -94, 247, -552, 1134, -2362, 6834, 13288, -3078, 1414, -695, 322, -130, 41, -8},
+  {-4, 25, -90, 237, -531, 1091, -2268, 6484, 13547, -3036, 1391, -684, 317, -128, 41, -8},
+  {-4, 24, -85, 226, -508, 1046, -2172, 6135, 13796, -2985, 1363, -670, 311, -126, 41, -8},
+  {-3, 23, -81, 216, -485, 999, -2072, 5788, 14035, -2926, 1332, -655, 305, -124, 40, -8},
+  {-3, 21, -77, 205, -462, 951, -1970, 5442, 14269, -2857, 1296, -638, 297, -121, 39, -8},
+  {-3, 20, -72, 194, -437, 901, -1865, 5098, 14489, -2779, 1256, -618, 288, -118, 38, -8},
+  {-3, 19, -68, 182, -412, 851, -1758, 4758, 14696, -2691, 1212, -596, 279, -114, 37, -8},
+  {-2, 17, -63, 171, -387, 799, -1650, 4420, 14896, -2594, 1164, -573, 268, -110, 36, -8},
+  {-2, 16, -59, 159, -361, 747, -1540, 4086, 15084, -2488, 1112, -547, 256, -106, 35, -8},
+  {-2, 15, -54, 147, -335, 694, -1428, 3756, 15258, -2372, 1056, -520, 244, -101, 33, -7},
+  {-2, 13, -50, 135, -309, 640, -1316, 3431, 15422, -2246, 996, -490, 230, -95, 32, -7},
+  {-1, 12, -45, 124, -283, 586, -1203, 3110, 15573, -2111, 932, -459, 216, -90, 30, -7},
+  {-1, 11, -41, 112, -256, 531, -1090, 2795, 15710, -1966, 865, -425, 200, -83, 28, -6},
+  {-1, 10, -36, 100, -229, 476, -977, 2485, 15837, -1811, 793, -390, 184, -77, 26, -6},
+  {-1, 8, -32, 88, -203, 422, -864, 2181, 15951, -1647, 718, -353, 167, -70, 24, -5},
+  {-1, 7, -28, 76, -176, 367, -752, 1883, 16053, -1473, 639, -314, 149, -62, 21, -5},
+  {-1, 6, -23, 65, -150, 313, -640, 1592, 16139, -1290, 557, -274, 130, -55, 19, -4},
+  {0, 5, -19, 54, -124, 259, -530, 1308, 16213, -1098, 472, -232, 110, -46, 16, -4},
+  {0, 4, -15, 42, -99, 206, -420, 1031, 16275, -896, 383, -188, 89, -38, 13, -3},
+  {0, 3, -11, 31, -73, 153, -312, 761, 16321, -685, 292, -143, 68, -29, 10, -2},
+  {0, 2, -7, 21, -48, 101, -206, 499, 16357, -466, 197, -97, 46, -20, 7, -2},
+  {0, 1, -4, 10, -24, 50, -102, 246, 16378, -237, 100, -49, 23, -10, 3, -1},
+  {0, 0, 0, 0, 0, 0, 0, 0, 16384, 0, 0, 0, 0, 0, 0, 0},
+};
+
+  #define AUDIOD_RS_STEP_MAX ((int32_t) (((uint64_t) CFG_TUD_AUDIO_RESAMPLER_PPM_MAX << 30) / 1000000u))
+
+  #if defined(__ARM_FEATURE_SIMD32) && __ARM_FEATURE_SIMD32
+    #include <arm_acle.h>
+  #endif
+
+TU_ATTR_ALWAYS_INLINE static inline int32_t audiod_rs_clamp(int32_t v, int32_t lo, int32_t hi) {
+  return (v < lo) ? lo : (v > hi) ? hi : v;
+}
+
+// 16-bit samples: a dual 16x16 multiply-accumulate per pair of taps where available
+TU_ATTR_ALWAYS_INLINE static inline int32_t audiod_rs_dot16(int16_t const *x, int16_t const *c) {
+  int32_t acc = 0;
+  #if defined(__ARM_FEATURE_SIMD32) && __ARM_FEATURE_SIMD32
+  for (uint8_t i = 0; i < AUDIOD_RS_TAPS; i += 2) {
+    int16x2_t x2, c2;
+    memcpy(&x2, &x[i], sizeof(x2));
+    memcpy(&c2, &c[i], sizeof(c2));
+    acc = __smlad(x2, c2, acc);
+  }
+  #else
+  for (uint8_t i = 0; i < AUDIOD_RS_TAPS; i++) {
+    acc += (int32_t) x[i] * c[i];
+  }
+  #endif
+  return acc;
+}
+
+TU_ATTR_ALWAYS_INLINE static inline int64_t audiod_rs_dot32(int32_t const *x, int16_t const *c) {
+  int64_t acc = 0;
+  for (uint8_t i = 0; i < AUDIOD_RS_TAPS; i++) {
+    acc += (int64_t) x[i] * c[i];
+  }
+  return acc;
+}
+
+// Append one frame of interleaved samples to history
+static void audiod_rs_push(audiod_rs_t const *rs, audiod_rs_ff_t *st, uint8_t const *src) {
+  uint8_t const idx = st->idx;
+  for (uint8_t ch = 0; ch < rs->n_ch; ch++) {
+    if (rs->n_bytes == 2) {
+      int16_t v;
+      memcpy(&v, src, 2);
+      st->hist.s16[ch][idx] = st->hist.s16[ch][idx + AUDIOD_RS_TAPS] = v;
+    } else {
+      int32_t v;
+      memcpy(&v, src, 4);
+      st->hist.s32[ch][idx] = st->hist.s32[ch][idx + AUDIOD_RS_TAPS] = v;
+    }
+    src += rs->n_bytes;
+  }
+  st->idx = (uint8_t) ((idx + 1) & (AUDIOD_RS_TAPS - 1));
+}
+
+// Interpolate one frame at current position
+static void audiod_rs_output(audiod_rs_t const *rs, audiod_rs_ff_t const *st, uint8_t *dst) {
+  uint32_t const phase = st->frac >> 24;
+  int32_t const sub = (int32_t) ((st->frac >> 8) & 0xFFFFu);
+  int16_t const *c0 = audiod_rs_coef[phase];
+  int16_t const *c1 = audiod_rs_coef[phase + 1];
+
+  for (uint8_t ch = 0; ch < rs->n_ch; ch++) {
+    if (rs->n_bytes == 2) {
+      int16_t const *x = &st->hist.s16[ch][st->idx];
+      int32_t const a0 = audiod_rs_dot16(x, c0);
+      int32_t const a1 = audiod_rs_dot16(x, c1);
+      int32_t v = a0 + (int32_t) (((int64_t) (a1 - a0) * sub) >> 16);
+      v = (v + (1 << 13)) >> 14;
+      int16_t const out = (int16_t) audiod_rs_clamp(v, INT16_MIN, INT16_MAX);
+      memcpy(dst, &out, 2);
+    } else {
+      int32_t const *x = &st->hist.s32[ch][st->idx];
+      int64_t const a0 = audiod_rs_dot32(x, c0);
+      int64_t const a1 = audiod_rs_dot32(x, c1);
+      int64_t v = a0 + (((a1 - a0) * sub) >> 16);
+      v = (v + (1 << 13)) >> 14;
+      int32_t const out = (v > INT32_MAX) ? INT32_MAX : (v < INT32_MIN) ? INT32_MIN : (int32_t) v;
+      memcpy(dst, &out, 4);
+    }
+    dst += rs->n_bytes;
+  }
+}
+
+// Steer ratio by level of support FIFO 0 with a PI controller: FIFO above half asks for a higher step, which means
+// fewer output samples per input when writing (IN) and consuming more input per output when reading (OUT)
+static void audiod_rs_steer(audiod_rs_t *rs, tu_fifo_t *ff) {
+  uint16_t const frame_bytes = (uint16_t) (rs->n_bytes * rs->n_ch);
+  int32_t const lvl = (int32_t) (tu_fifo_count(ff) / frame_bytes) << 8;
+  int32_t const target = (int32_t) (tu_fifo_depth(ff) / frame_bytes) << 7;
+
+  // Level jumps by a packet each time USB side moves data, average it out
+  rs->lvl_avg += (lvl - rs->lvl_avg) / 16;
+  int32_t const err = rs->lvl_avg - target;
+
+  // Kp = 2^-14, Ki = 2^-22 per frame of error and update
+  int32_t integ = rs->integ + err / 4;
+  integ = audiod_rs_clamp(integ, -AUDIOD_RS_STEP_MAX, AUDIOD_RS_STEP_MAX);
+  rs->integ = integ;
+
+  int32_t corr = integ + err * 256;
+  corr = audiod_rs_clamp(corr, -AUDIOD_RS_STEP_MAX, AUDIOD_RS_STEP_MAX);
+  rs->step = (uint32_t) ((int32_t) AUDIOD_RS_ONE + corr);
+}
+
+static void audiod_rs_setup(audiod_rs_t *rs, uint8_t n_bytes, uint8_t n_ch, uint8_t n_ff_used, tu_fifo_t *ff) {
+  tu_memclr(rs, sizeof(audiod_rs_t));
+  rs->step = AUDIOD_RS_ONE;
+
+  // Unsupported format is passed through
+  if ((n_bytes == 2 || n_bytes == 4) && n_ch <= CFG_TUD_AUDIO_RESAMPLER_N_CHANNELS_MAX && n_ff_used <= CFG_TUD_AUDIO_RESAMPLER_N_FF_MAX) {
+    rs->n_bytes = n_bytes;
+    rs->n_ch = n_ch;
+    rs->lvl_avg = (int32_t) (tu_fifo_depth(ff) / (n_bytes * n_ch)) << 7;
+  } else {
+    TU_LOG2("  Resampler bypassed for this format\r\n");
+  }
+}
+#endif
+
+#if AUDIOD_RS_TX
+// Resample frames of application into support FIFO
+static uint16_t audiod_rs_write(audiod_function_t *audio, uint8_t ff_idx, uint8_t const *data, uint16_t len) {
+  audiod_rs_t *rs = &audio->rs_tx;
+  audiod_rs_ff_t *st = &rs->ff[ff_idx];
+  tu_fifo_t *ff = &audio->tx_supp_ff[ff_idx];
+  uint16_t const frame_bytes = (uint16_t) (rs->n_bytes * rs->n_ch);
+  uint16_t const n_frames = len / frame_bytes;
+
+  if (ff_idx == 0) {
+    audiod_rs_steer(rs, ff);
+  }
+
+  uint8_t out[16 * 4 * CFG_TUD_AUDIO_RESAMPLER_N_CHANNELS_MAX];
+  uint16_t n_out = 0;
+
+  for (uint16_t i = 0; i < n_frames; i++) {
+    audiod_rs_push(rs, st, data);
+    data += frame_bytes;
+
+    while (st->frac < AUDIOD_RS_ONE) {
+      if (n_out + frame_bytes > sizeof(out)) {
+        tu_fifo_write_n(ff, out, n_out);
+        n_out = 0;
+      }
+      audiod_rs_output(rs, st, &out[n_out]);
+      n_out = (uint16_t) (n_out + frame_bytes);
+      st->frac += rs->step;
+    }
+    st->frac -= AUDIOD_RS_ONE;
+  }
+  tu_fifo_write_n(ff, out, n_out);
+
+  return (uint16_t) (n_frames * frame_bytes);
+}
+#endif
+
+#if AUDIOD_RS_RX
+// Resample frames of support FIFO into application buffer, stop when FIFO runs empty
+static uint16_t audiod_rs_read(audiod_function_t *audio, uint8_t ff_idx, uint8_t *buffer, uint16_t bufsize) {
+  audiod_rs_t *rs = &audio->rs_rx;
+  audiod_rs_ff_t *st = &rs->ff[ff_idx];
+  tu_fifo_t *ff = &audio->rx_supp_ff[ff_idx];
+  uint16_t const frame_bytes = (uint16_t) (rs->n_bytes * rs->n_ch);
+  uint16_t const n_frames = bufsize / frame_bytes;
+  uint16_t n_out = 0;
+
+  if (ff_idx == 0) {
+    audiod_rs_steer(rs, ff);
+  }
+
+  while (n_out < n_frames) {
+    if (st->frac >= AUDIOD_RS_ONE) {
+      uint8_t frame[4 * CFG_TUD_AUDIO_RESAMPLER_N_CHANNELS_MAX];
+      if (tu_fifo_count(ff) < frame_bytes) break;
+      tu_fifo_read_n(ff, frame, frame_bytes);
+      audiod_rs_push(rs, st, frame);
+      st->frac -= AUDIOD_RS_ONE;
+    } else {
+      audiod_rs_output(rs, st, buffer);
+      buffer += frame_bytes;
+      n_out++;
+      st->frac += rs->step;
+    }
+  }
+
+  return (uint16_t) (n_out * frame_bytes);
+}
+#endif
+
+#if CFG_TUD_AUDIO_ENABLE_RESAMPLER
+bool tud_audio_n_resampler_enable(uint8_t func_id, uint8_t ep_dir, bool enable) {
+  TU_VERIFY(func_id < CFG_TUD_AUDIO && ep_dir <= TUSB_DIR_IN);
+  audiod_function_t *audio = &_audiod_fct[func_id];
+
+  // Restart from unity ratio and empty history
+  #if AUDIOD_RS_RX
+  if (ep_dir == TUSB_DIR_OUT && audio->rs_rx.n_bytes != 0) {
+    audiod_rs_setup(&audio->rs_rx, audio->rs_rx.n_bytes, audio->rs_rx.n_ch, 1, &audio->rx_supp_ff[0]);
+  }
+  #endif
+  #if AUDIOD_RS_TX
+  if (ep_dir == TUSB_DIR_IN && audio->rs_tx.n_bytes != 0) {
+    audiod_rs_setup(&audio->rs_tx, audio->rs_tx.n_bytes, audio->rs_tx.n_ch, 1, &audio->tx_supp_ff[0]);
+  }
+  #endif
+  audio->rs_enabled[ep_dir] = enable;
+
+  return true;
+}
+
+int32_t tud_audio_n_resampler_ppm(uint8_t func_id, uint8_t ep_dir) {
+  TU_VERIFY(func_id < CFG_TUD_AUDIO && ep_dir <= TUSB_DIR_IN, 0);
+  uint32_t step = AUDIOD_RS_ONE;
+  #if AUDIOD_RS_RX
+  if (ep_dir == TUSB_DIR_OUT) step = _audiod_fct[func_id].rs_rx.step;
+  #endif
+  #if AUDIOD_RS_TX
+  if (ep_dir == TUSB_DIR_IN) step = _audiod_fct[func_id].rs_tx.step;
+  #endif
+  return (int32_t) (((int64_t) step - (int64_t) AUDIOD_RS_ONE) * 1000000 / (int64_t) AUDIOD_RS_ONE);
+}
+#endif
+
 // This function is called once a transmit of an audio packet was successfully completed. Here, we encode samples and place it in IN EP's buffer for next transmission.
 // If you prefer your own (more efficient) implementation suiting your purpose set CFG_TUD_AUDIO_ENABLE_ENCODING = 0 and use tud_audio_n_write.
 
 // n_bytes_copied - Informs caller how many bytes were loaded. In case n_bytes_copied = 0, a ZLP is scheduled to inform host no data is available for current frame.
 #if CFG_TUD_AUDIO_ENABLE_EP_IN
+  #if USE_LINEAR_BUFFER_TX
+// Submit packet loaded into lin_buf_in. With double buffering it is queued behind the packet on the wire and
+// started from ISR once that completes, lin_buf_in then points to the free buffer for the next packet.
+static bool audiod_tx_xfer(uint8_t rhport, audiod_function_t *audio, uint16_t n_bytes) {
+    #if CFG_TUD_AUDIO_EP_IN_DOUBLE_BUFFER
+  TU_VERIFY(usbd_edpt_xfer_queue(rhport, audio->ep_in, audio->lin_buf_in, n_bytes));
+  uint8_t *const buf = audio->lin_buf_in;
+  audio->lin_buf_in = audio->lin_buf_in_alt;
+  audio->lin_buf_in_alt = buf;
+  return true;
+    #else
+  return usbd_edpt_xfer(rhport, audio->ep_in, audio->lin_buf_in, n_bytes);
+    #endif
+}
+  #endif
+
 static bool audiod_tx_done_cb(uint8_t rhport, audiod_function_t *audio) {
   uint8_t idxItf;
   uint8_t const *dummy2;
@@ -981,6 +1676,11 @@ static bool audiod_tx_done_cb(uint8_t rhport, audiod_function_t *audio) {
   // Only send something if current alternate interface is not 0 as in this case nothing is to be sent due to UAC2 specifications
   if (audio->alt_setting[idxItf] == 0) return false;
 
+  #if CFG_TUD_AUDIO_EP_IN_DOUBLE_BUFFER
+  // Both buffers are on the wire or queued, next packet is prepared on completion
+  TU_VERIFY(usbd_edpt_xfer_queue_available(rhport, audio->ep_in));
+  #endif
+
   // Call a weak callback here - a possibility for user to get informed former TX was completed and data gets now loaded into EP in buffer (in case FIFOs are used) or
   // if no FIFOs are used the user may use this call back to load its data into the EP IN buffer by use of tud_audio_n_write_ep_in_buffer().
   TU_VERIFY(tud_audio_tx_done_pre_load_cb(rhport, idx_audio_fct, audio->ep_in, audio->alt_setting[idxItf]));
@@ -1023,7 +1723,7 @@ static bool audiod_tx_done_cb(uint8_t rhport, audiod_function_t *audio) {
       break;
   }
 
-  TU_VERIFY(usbd_edpt_xfer(rhport, audio->ep_in, audio->lin_buf_in, n_bytes_tx));
+  TU_VERIFY(audiod_tx_xfer(rhport, audio, n_bytes_tx));
 
   #else
     // No support FIFOs, if no linear buffer required schedule transmit, else put data into linear buffer and schedule
@@ -1035,7 +1735,7 @@ static bool audiod_tx_done_cb(uint8_t rhport, audiod_function_t *audio) {
     #endif
     #if USE_LINEAR_BUFFER_TX
   tu_fifo_read_n(&audio->ep_in_ff, audio->lin_buf_in, n_bytes_tx);
-  TU_VERIFY(usbd_edpt_xfer(rhport, audio->ep_in, audio->lin_buf_in, n_bytes_tx));
+  TU_VERIFY(audiod_tx_xfer(rhport, audio, n_bytes_tx));
     #else
   // Send everything in ISO EP FIFO
   TU_VERIFY(usbd_edpt_xfer_fifo(rhport, audio->ep_in, &audio->ep_in_ff, n_bytes_tx));
@@ -1043,6 +1743,10 @@ static bool audiod_tx_done_cb(uint8_t rhport, audiod_function_t *audio) {
 
   #endif
 
+  #if CFG_TUD_AUDIO_ENABLE_STATS
+  audiod_stats_packet(audio, TUSB_DIR_IN, n_bytes_tx);
+  #endif
+
   // Call a weak callback here - a possibility for user to get informed former TX was completed and how many bytes were loaded for the next frame
   TU_VERIFY(tud_audio_tx_done_post_load_cb(rhport, n_bytes_tx, idx_audio_fct, audio->ep_in, audio->alt_setting[idxItf]));
 
@@ -1072,42 +1776,24 @@ range [-1, +1)
 // Helper function
 static inline void *audiod_interleaved_copy_bytes_fast_encode(uint16_t const nBytesPerSample, void *src, const void *src_end, void *dst, uint8_t const n_ff_used) {
   // Due to one FIFO contains 2 channels, data always aligned to (nBytesPerSample * 2)
-  uint16_t *dst16 = dst;
-  uint16_t *src16 = src;
-  const uint16_t *src_end16 = src_end;
-  uint32_t *dst32 = dst;
-  uint32_t *src32 = src;
-  const uint32_t *src_end32 = src_end;
-
-  if (nBytesPerSample == 1) {
-    while (src16 < src_end16) {
-      *dst16++ = *src16++;
-      dst16 += n_ff_used - 1;
-    }
-    return dst16;
-  } else if (nBytesPerSample == 2) {
-    while (src32 < src_end32) {
-      *dst32++ = *src32++;
-      dst32 += n_ff_used - 1;
-    }
-    return dst32;
-  } else if (nBytesPerSample == 3) {
-    while (src16 < src_end16) {
-      *dst16++ = *src16++;
-      *dst16++ = *src16++;
-      *dst16++ = *src16++;
-      dst16 += 3 * (n_ff_used - 1);
-    }
-    return dst16;
-  } else// nBytesPerSample == 4
-  {
-    while (src32 < src_end32) {
-      *dst32++ = *src32++;
-      *dst32++ = *src32++;
-      dst32 += 2 * (n_ff_used - 1);
-    }
-    return dst32;
+  uint16_t const n_bytes = (uint16_t) ((uint8_t const *) src_end - (uint8_t const *) src);
+  uint8_t *dst8 = dst;
+  uint8_t *src8 = src;
+
+  if (n_ff_used == 1) {
+    // all channels in one FIFO: nothing to interleave
+    memcpy(dst8, src8, n_bytes);
+    return dst8 + n_bytes;
   }
+
+  uint16_t const n_frames = (uint16_t) (n_bytes / (2 * nBytesPerSample));
+  uint8_t const n_bytes_per_sample = (uint8_t) nBytesPerSample;
+  switch (n_ff_used) {
+    case 2: audiod_copy_frames_n(n_bytes_per_sample, &dst8, &src8, n_frames, 2, 1); break;
+    case 4: audiod_copy_frames_n(n_bytes_per_sample, &dst8, &src8, n_frames, 4, 1); break;
+    default: audiod_copy_frames_n(n_bytes_per_sample, &dst8, &src8, n_frames, n_ff_used, 1); break;
+  }
+  return dst8;
 }
 
 static uint16_t audiod_encode_type_I_pcm(uint8_t rhport, audiod_function_t *audio) {
@@ -1115,7 +1801,11 @@ static uint16_t audiod_encode_type_I_pcm(uint8_t rhport, audiod_function_t *audi
   // This is ensured within set_interface, where the FIFOs are reconfigured according to this size
 
   // We encode directly into IN EP's linear buffer - abort if previous transfer not complete
+  #if CFG_TUD_AUDIO_EP_IN_DOUBLE_BUFFER
+  TU_VERIFY(usbd_edpt_xfer_queue_available(rhport, audio->ep_in));
+  #else
   TU_VERIFY(!usbd_edpt_busy(rhport, audio->ep_in));
+  #endif
 
   // Determine amount of samples
   uint8_t const n_ff_used = audio->n_ff_used_tx;
@@ -1129,12 +1819,26 @@ static uint16_t audiod_encode_type_I_pcm(uint8_t rhport, audiod_function_t *audi
     }
   }
 
+  #if AUDIOD_CONV_TX
+  // Sizes below are in EP format, scale FIFO level
+  uint8_t const ff_bytes = audio->conv_tx.n_bytes_per_sample;
+  if (ff_bytes != 0) {
+    nBytesPerFFToSend = (uint16_t) (nBytesPerFFToSend / ff_bytes * audio->n_bytes_per_sample_tx);
+  }
+  #endif
+
   #if CFG_TUD_AUDIO_EP_IN_FLOW_CONTROL
+  uint16_t ff_depth = audio->tx_supp_ff[0].depth;
+    #if AUDIOD_CONV_TX
+  if (ff_bytes != 0) {
+    ff_depth = (uint16_t) (ff_depth / ff_bytes * audio->n_bytes_per_sample_tx);
+  }
+    #endif
   const uint16_t norm_packet_sz_tx[3] = {audio->packet_sz_tx[0] / n_ff_used,
                                          audio->packet_sz_tx[1] / n_ff_used,
                                          audio->packet_sz_tx[2] / n_ff_used};
   // packet_sz_tx is based on total packet size, here we want size for each support buffer.
-  nBytesPerFFToSend = audiod_tx_packet_size(norm_packet_sz_tx, nBytesPerFFToSend, audio->tx_supp_ff[0].depth, audio->ep_in_sz / n_ff_used);
+  nBytesPerFFToSend = audiod_tx_packet_size(norm_packet_sz_tx, nBytesPerFFToSend, ff_depth, audio->ep_in_sz / n_ff_used);
   // Check if there is enough data
   if (nBytesPerFFToSend == 0) return 0;
   #else
@@ -1158,6 +1862,23 @@ static uint16_t audiod_encode_type_I_pcm(uint8_t rhport, audiod_function_t *audi
 
     tu_fifo_get_read_info(&audio->tx_supp_ff[cnt_ff], &info);
 
+  #if AUDIOD_CONV_TX
+    if (ff_bytes != 0) {
+      // Convert while copying, FIFO depth is a multiple of its sample size
+      uint16_t const n_samples = nBytesPerFFToSend / audio->n_bytes_per_sample_tx;
+      uint16_t const n_lin = tu_min16(n_samples, info.len_lin / ff_bytes);
+      uint16_t const n_wrap = tu_min16(n_samples - n_lin, info.len_wrap / ff_bytes);
+      uint8_t ch = 0;
+
+      dst = audiod_conv_copy(audio, false, cnt_ff, info.ptr_lin, dst, n_lin, &ch);
+      if (n_wrap != 0) {
+        audiod_conv_copy(audio, false, cnt_ff, info.ptr_wrap, dst, n_wrap, &ch);
+      }
+      tu_fifo_advance_read_pointer(&audio->tx_supp_ff[cnt_ff], (uint16_t) ((n_lin + n_wrap) * ff_bytes));
+      continue;
+    }
+  #endif
+
     if (info.len_lin != 0) {
       info.len_lin = tu_min16(nBytesPerFFToSend, info.len_lin);// Limit up to desired length
       src_end = (uint8_t *) info.ptr_lin + info.len_lin;
@@ -1184,6 +1905,16 @@ static uint16_t audiod_encode_type_I_pcm(uint8_t rhport, audiod_function_t *audi
 
 #if CFG_TUD_AUDIO_ENABLE_EP_OUT && CFG_TUD_AUDIO_ENABLE_FEEDBACK_EP
 static inline bool audiod_fb_send(audiod_function_t *audio) {
+  #if CFG_TUD_AUDIO_ENABLE_STATS
+  audio->stats.fb_count++;
+  if (audio->stats.fb_history[0] != audio->feedback.value) {
+    for (uint8_t i = CFG_TUD_AUDIO_STATS_FB_HISTORY - 1; i > 0; i--) {
+      audio->stats.fb_history[i] = audio->stats.fb_history[i - 1];
+    }
+    audio->stats.fb_history[0] = audio->feedback.value;
+  }
+  #endif
+
   bool apply_correction = (TUSB_SPEED_FULL == tud_speed_get()) && audio->feedback.format_correction;
   // Format the feedback value
   if (apply_correction) {
@@ -1215,6 +1946,69 @@ static inline bool audiod_fb_send(audiod_function_t *audio) {
 }
 #endif
 
+#if CFG_TUD_AUDIO_ENABLE_STATS
+// Classify a data packet against the average size of its EP direction, ZLPs are not averaged
+static void audiod_stats_packet(audiod_function_t *audio, uint8_t ep_dir, uint16_t n_bytes) {
+  bool const is_in = (ep_dir == TUSB_DIR_IN);
+  uint32_t *n_short = is_in ? &audio->stats.tx_short : &audio->stats.rx_short;
+  uint32_t *avg = &audio->stats_pkt_avg[ep_dir];
+  uint32_t const slot = ((uint32_t) audio->stats_slot_sz[ep_dir]) << 8;
+  uint32_t const n = ((uint32_t) n_bytes) << 8;
+
+  if (is_in) {
+    audio->stats.tx_packets++;
+  } else {
+    audio->stats.rx_packets++;
+  }
+
+  if (n_bytes == 0) {
+    if (is_in) {
+      audio->stats.tx_underrun++;
+    } else {
+      audio->stats.rx_short++;
+    }
+    return;
+  }
+
+  if (*avg == 0) {
+    *avg = n;
+    return;
+  }
+
+  if (slot != 0) {
+    if (n % slot != 0 || n + slot < *avg) {
+      (*n_short)++;
+    } else if (n > *avg + slot && !is_in) {
+      audio->stats.rx_oversize++;
+    }
+  }
+  *avg = *avg - (*avg >> 4) + (n >> 4);
+}
+
+bool tud_audio_n_get_stats(uint8_t func_id, audio_stats_t *stats, bool clear) {
+  TU_VERIFY(func_id < CFG_TUD_AUDIO && _audiod_fct[func_id].p_desc != NULL && stats != NULL);
+  audiod_function_t *audio = &_audiod_fct[func_id];
+
+  // Counters are updated in ISR (SOF) and USBD task, copy as consistent as possible
+  usbd_int_set(false);
+  *stats = audio->stats;
+  if (clear) {
+    // Feedback history is not a counter, keep it
+    tu_memclr(&audio->stats, offsetof(audio_stats_t, fb_history));
+    audio->stats.sof_count = 0;
+    audio->stats.sof_missed = 0;
+    audio->stats.sof_period_min = 0;
+    audio->stats.sof_period_max = 0;
+  }
+  usbd_int_set(true);
+
+  stats->tx_pkt_avg = (uint16_t) (audio->stats_pkt_avg[TUSB_DIR_IN] >> 8);
+  stats->rx_pkt_avg = (uint16_t) (audio->stats_pkt_avg[TUSB_DIR_OUT] >> 8);
+
+  return true;
+}
+#endif
+
 //--------------------------------------------------------------------+
 // USBD Driver API
 //--------------------------------------------------------------------+
@@ -1224,6 +2018,16 @@ void audiod_init(void) {
   for (uint8_t i = 0; i < CFG_TUD_AUDIO; i++) {
     audiod_function_t *audio = &_audiod_fct[i];
 
+#if CFG_TUD_AUDIO_ENABLE_CONVERSION
+    // Unity gain until feature unit volume is set
+    for (uint8_t ch = 0; ch <= CFG_TUD_AUDIO_CONV_N_CHANNELS_MAX; ch++) {
+      audio->gain[TUSB_DIR_OUT][ch] = audio->gain[TUSB_DIR_IN][ch] = AUDIO_CONV_GAIN_UNITY;
+    }
+    for (uint8_t ch = 0; ch < CFG_TUD_AUDIO_CONV_N_CHANNELS_MAX; ch++) {
+      audio->gain_ch[TUSB_DIR_OUT][ch] = audio->gain_ch[TUSB_DIR_IN][ch] = AUDIO_CONV_GAIN_UNITY;
+    }
+#endif
+
     // Initialize control buffers
     switch (i) {
       case 0:
@@ -1300,16 +2104,25 @@ void audiod_init(void) {
   #if CFG_TUD_AUDIO_FUNC_1_EP_IN_SZ_MAX > 0
       case 0:
         audio->lin_buf_in = lin_buf_in.buf_1;
+  #if CFG_TUD_AUDIO_EP_IN_DOUBLE_BUFFER
+        audio->lin_buf_in_alt = lin_buf_in.buf_1_alt;
+  #endif
         break;
   #endif
   #if CFG_TUD_AUDIO > 1 && CFG_TUD_AUDIO_FUNC_2_EP_IN_SZ_MAX > 0
       case 1:
         audio->lin_buf_in = lin_buf_in.buf_2;
+  #if CFG_TUD_AUDIO_EP_IN_DOUBLE_BUFFER
+        audio->lin_buf_in_alt = lin_buf_in.buf_2_alt;
+  #endif
         break;
   #endif
   #if CFG_TUD_AUDIO > 2 && CFG_TUD_AUDIO_FUNC_3_EP_IN_SZ_MAX > 0
       case 2:
         audio->lin_buf_in = lin_buf_in.buf_3;
+  #if CFG_TUD_AUDIO_EP_IN_DOUBLE_BUFFER
+        audio->lin_buf_in_alt = lin_buf_in.buf_3_alt;
+  #endif
         break;
   #endif
     }
@@ -1538,10 +2351,9 @@ bool audiod_deinit(void) {
 }
 
 void audiod_reset(uint8_t rhport) {
-  (void) rhport;
-
   for (uint8_t i = 0; i < CFG_TUD_AUDIO; i++) {
     audiod_function_t *audio = &_audiod_fct[i];
+    if (audio->p_desc && audio->rhport != rhport) continue; // opened on other port
     tu_memclr(audio, ITF_MEM_RESET_SIZE);
 
 #if CFG_TUD_AUDIO_ENABLE_EP_IN && !CFG_TUD_AUDIO_ENABLE_ENCODING
@@ -1723,6 +2535,10 @@ uint16_t audiod_open(uint8_t rhport, tusb_desc_interface_t const *itf_desc, uint
       }
 #endif
 
+#if CFG_TUD_AUDIO_ALT_CFG_MAX
+      audiod_build_alt_cfg(&_audiod_fct[i]);
+#endif
+
       _audiod_fct[i].mounted = true;
       break;
     }
@@ -1778,6 +2594,20 @@ static bool audiod_set_interface(uint8_t rhport, tusb_control_request_t const *p
 
   audiod_function_t *audio = &_audiod_fct[func_id];
 
+  // Host selects the active alternate setting again e.g. on every stream start: EPs, FIFOs and feedback are still valid
+  bool itf_active = false;
+#if CFG_TUD_AUDIO_ENABLE_EP_IN
+  itf_active |= (audio->ep_in_as_intf_num == itf);
+#endif
+#if CFG_TUD_AUDIO_ENABLE_EP_OUT
+  itf_active |= (audio->ep_out_as_intf_num == itf);
+#endif
+  if (itf_active && alt != 0 && audio->alt_setting[idxItf] == alt) {
+    TU_VERIFY(tud_audio_set_itf_cb(rhport, p_request));
+    tud_control_status(rhport, p_request);
+    return true;
+  }
+
 // Look if there is an EP to be closed - for this driver, there are only 3 possible EPs which may be closed (only AS related EPs can be closed, AC EP (if present) is always open)
 #if CFG_TUD_AUDIO_ENABLE_EP_IN
   if (audio->ep_in_as_intf_num == itf) {
@@ -1787,10 +2617,11 @@ static bool audiod_set_interface(uint8_t rhport, tusb_control_request_t const *p
   #endif
 
     // Clear FIFOs, since data is no longer valid
+    // Support FIFOs are kept if streaming continues in another alternate setting with the same sample layout, see below
   #if !CFG_TUD_AUDIO_ENABLE_ENCODING
     tu_fifo_clear(&audio->ep_in_ff);
   #else
-    for (uint8_t cnt = 0; cnt < audio->n_tx_supp_ff; cnt++) {
+    for (uint8_t cnt = 0; cnt < audio->n_tx_supp_ff && alt == 0; cnt++) {
       tu_fifo_clear(&audio->tx_supp_ff[cnt]);
     }
   #endif
@@ -1816,10 +2647,11 @@ static bool audiod_set_interface(uint8_t rhport, tusb_control_request_t const *p
   #endif
 
     // Clear FIFOs, since data is no longer valid
+    // Support FIFOs are kept if streaming continues in another alternate setting with the same sample layout, see below
   #if !CFG_TUD_AUDIO_ENABLE_DECODING
     tu_fifo_clear(&audio->ep_out_ff);
   #else
-    for (uint8_t cnt = 0; cnt < audio->n_rx_supp_ff; cnt++) {
+    for (uint8_t cnt = 0; cnt < audio->n_rx_supp_ff && alt == 0; cnt++) {
       tu_fifo_clear(&audio->rx_supp_ff[cnt]);
     }
   #endif
@@ -1847,14 +2679,35 @@ static bool audiod_set_interface(uint8_t rhport, tusb_control_request_t const *p
   // Get pointer at end
   uint8_t const *p_desc_end = audio->p_desc + audio->desc_length - TUD_AUDIO_DESC_IAD_LEN;
 
+  // Jump straight to the alternate setting if it was parsed when mounted or if configuration descriptor is indexed
+  audiod_alt_cfg_t alt_cfg;
+  audiod_alt_cfg_t const *p_alt_cfg = NULL;
+#if CFG_TUD_AUDIO_ALT_CFG_MAX
+  for (uint8_t i = 0; i < audio->n_alt_cfg; i++) {
+    if (audio->alt_cfg[i].itf == itf && audio->alt_cfg[i].alt == alt) {
+      p_alt_cfg = &audio->alt_cfg[i];
+      p_desc = audio->p_desc + p_alt_cfg->desc_offset;
+      break;
+    }
+  }
+  if (p_alt_cfg == NULL)
+#endif
+  {
+    uint8_t const *p_desc_alt = (uint8_t const *) usbd_find_interface_desc(rhport, itf, alt);
+    if (p_desc_alt && p_desc_alt >= p_desc && p_desc_alt < p_desc_end) {
+      p_desc = p_desc_alt;
+    }
+  }
+
   // p_desc starts at required interface with alternate setting zero
   // Condition modified from p_desc < p_desc_end to prevent gcc>=12 strict-overflow warning
   while (p_desc_end - p_desc > 0) {
     // Find correct interface
     if (tu_desc_type(p_desc) == TUSB_DESC_INTERFACE && ((tusb_desc_interface_t const *) p_desc)->bInterfaceNumber == itf && ((tusb_desc_interface_t const *) p_desc)->bAlternateSetting == alt) {
-#if (CFG_TUD_AUDIO_ENABLE_EP_IN && (CFG_TUD_AUDIO_EP_IN_FLOW_CONTROL || CFG_TUD_AUDIO_ENABLE_ENCODING)) || (CFG_TUD_AUDIO_ENABLE_EP_OUT && CFG_TUD_AUDIO_ENABLE_DECODING)
-      uint8_t const *p_desc_parse_for_params = p_desc;
-#endif
+      if (p_alt_cfg == NULL) {
+        audiod_parse_alt_cfg(p_desc, p_desc_end, &alt_cfg);
+        p_alt_cfg = &alt_cfg;
+      }
       // From this point forward follow the EP descriptors associated to the current alternate setting interface - Open EPs if necessary
       uint8_t foundEPs = 0, nEps = ((tusb_desc_interface_t const *) p_desc)->bNumEndpoints;
       // Condition modified from p_desc < p_desc_end to prevent gcc>=12 strict-overflow warning
@@ -1878,25 +2731,63 @@ static bool audiod_set_interface(uint8_t rhport, tusb_control_request_t const *p
             audio->ep_in = ep_addr;
             audio->ep_in_as_intf_num = itf;
             audio->ep_in_sz = tu_edpt_packet_size(desc_ep);
+  #if CFG_TUD_AUDIO_ENABLE_STATS
+            audio->stats_slot_sz[TUSB_DIR_IN] = (uint16_t) (p_alt_cfg->n_channels * p_alt_cfg->n_bytes_per_sample);
+            audio->stats_pkt_avg[TUSB_DIR_IN] = 0;
+  #endif
 
             // If software encoding is enabled, parse for the corresponding parameters - doing this here means only AS interfaces with EPs get scanned for parameters
   #if CFG_TUD_AUDIO_ENABLE_ENCODING || CFG_TUD_AUDIO_EP_IN_FLOW_CONTROL
-            audiod_parse_for_AS_params(audio, p_desc_parse_for_params, p_desc_end, itf);
+    #if CFG_TUD_AUDIO_ENABLE_ENCODING && CFG_TUD_AUDIO_ENABLE_TYPE_I_ENCODING
+      #if AUDIOD_CONV_TX
+            uint8_t const ff_bytes_tx_prev = audio->conv_tx.n_bytes_per_sample ? audio->conv_tx.n_bytes_per_sample : audio->n_bytes_per_sample_tx;
+      #else
+            uint8_t const ff_bytes_tx_prev = audio->n_bytes_per_sample_tx;
+      #endif
+            uint8_t const n_ff_used_tx_prev = audio->n_ff_used_tx;
+    #endif
+
+            if (p_alt_cfg->format_type != AUDIO_FORMAT_TYPE_UNDEFINED) {
+              audio->n_channels_tx = p_alt_cfg->n_channels;
+              audio->format_type_tx = (audio_format_type_t) p_alt_cfg->format_type;
+    #if CFG_TUD_AUDIO_ENABLE_TYPE_I_ENCODING
+              audio->format_type_I_tx = (audio_data_format_type_I_t) p_alt_cfg->format_type_I;
+    #endif
+            }
+            if (p_alt_cfg->n_bytes_per_sample != 0) {
+              audio->n_bytes_per_sample_tx = p_alt_cfg->n_bytes_per_sample;
+            }
 
               // Reconfigure size of support FIFOs - this is necessary to avoid samples to get split in case of a wrap
     #if CFG_TUD_AUDIO_ENABLE_ENCODING && CFG_TUD_AUDIO_ENABLE_TYPE_I_ENCODING
-            const uint16_t active_fifo_depth = (uint16_t) ((audio->tx_supp_ff_sz_max / (audio->n_channels_per_ff_tx * audio->n_bytes_per_sample_tx)) * (audio->n_channels_per_ff_tx * audio->n_bytes_per_sample_tx));
-            for (uint8_t cnt = 0; cnt < audio->n_tx_supp_ff; cnt++) {
-              tu_fifo_config(&audio->tx_supp_ff[cnt], audio->tx_supp_ff[cnt].buffer, active_fifo_depth, 1, true);
-            }
+      #if AUDIOD_CONV_TX
+            TU_VERIFY(audiod_conv_setup(func_id, alt, ep_addr, &audio->conv_tx, audio->n_bytes_per_sample_tx, audio->n_channels_tx));
+            uint8_t const ff_bytes_tx = audio->conv_tx.n_bytes_per_sample ? audio->conv_tx.n_bytes_per_sample : audio->n_bytes_per_sample_tx;
+      #else
+            uint8_t const ff_bytes_tx = audio->n_bytes_per_sample_tx;
+      #endif
+            const uint16_t active_fifo_depth = (uint16_t) ((audio->tx_supp_ff_sz_max / (audio->n_channels_per_ff_tx * ff_bytes_tx)) * (audio->n_channels_per_ff_tx * ff_bytes_tx));
             audio->n_ff_used_tx = audio->n_channels_tx / audio->n_channels_per_ff_tx;
             TU_ASSERT(audio->n_ff_used_tx <= audio->n_tx_supp_ff);
+            // Reconfiguring empties the FIFOs, keep them if samples are laid out as before
+            if (ff_bytes_tx != ff_bytes_tx_prev || audio->n_ff_used_tx != n_ff_used_tx_prev || active_fifo_depth != tu_fifo_depth(&audio->tx_supp_ff[0])) {
+              for (uint8_t cnt = 0; cnt < audio->n_tx_supp_ff; cnt++) {
+                tu_fifo_config(&audio->tx_supp_ff[cnt], audio->tx_supp_ff[cnt].buffer, active_fifo_depth, 1, true);
+              }
+            }
+      #if AUDIOD_RS_TX
+            audiod_rs_setup(&audio->rs_tx, ff_bytes_tx, audio->n_channels_per_ff_tx, audio->n_ff_used_tx, &audio->tx_supp_ff[0]);
+      #endif
     #endif
   #endif
 
             // Schedule first transmit if alternate interface is not zero i.e. streaming is disabled - in case no sample data is available a ZLP is loaded
             // It is necessary to trigger this here since the refill is done with an RX FIFO empty interrupt which can only trigger if something was in there
             TU_VERIFY(audiod_tx_done_cb(rhport, &_audiod_fct[func_id]));
+  #if CFG_TUD_AUDIO_EP_IN_DOUBLE_BUFFER
+            // Queue the second packet right away so that one is always prepared ahead
+            TU_VERIFY(audiod_tx_done_cb(rhport, &_audiod_fct[func_id]));
+  #endif
           }
 #endif// CFG_TUD_AUDIO_ENABLE_EP_IN
 
@@ -1908,18 +2799,54 @@ static bool audiod_set_interface(uint8_t rhport, tusb_control_request_t const *p
             audio->ep_out = ep_addr;
             audio->ep_out_as_intf_num = itf;
             audio->ep_out_sz = tu_edpt_packet_size(desc_ep);
+  #if CFG_TUD_AUDIO_ENABLE_STATS
+            audio->stats_slot_sz[TUSB_DIR_OUT] = (uint16_t) (p_alt_cfg->n_channels * p_alt_cfg->n_bytes_per_sample);
+            audio->stats_pkt_avg[TUSB_DIR_OUT] = 0;
+  #endif
 
   #if CFG_TUD_AUDIO_ENABLE_DECODING
-            audiod_parse_for_AS_params(audio, p_desc_parse_for_params, p_desc_end, itf);
+    #if CFG_TUD_AUDIO_ENABLE_TYPE_I_DECODING
+      #if AUDIOD_CONV_RX
+            uint8_t const ff_bytes_rx_prev = audio->conv_rx.n_bytes_per_sample ? audio->conv_rx.n_bytes_per_sample : audio->n_bytes_per_sample_rx;
+      #else
+            uint8_t const ff_bytes_rx_prev = audio->n_bytes_per_sample_rx;
+      #endif
+            uint8_t const n_ff_used_rx_prev = audio->n_ff_used_rx;
+    #endif
 
-              // Reconfigure size of support FIFOs - this is necessary to avoid samples to get split in case of a wrap
+            if (p_alt_cfg->format_type != AUDIO_FORMAT_TYPE_UNDEFINED) {
+              audio->n_channels_rx = p_alt_cfg->n_channels;
+              audio->format_type_rx = (audio_format_type_t) p_alt_cfg->format_type;
+    #if CFG_TUD_AUDIO_ENABLE_TYPE_I_DECODING
+              audio->format_type_I_rx = (audio_data_format_type_I_t) p_alt_cfg->format_type_I;
+    #endif
+            }
     #if CFG_TUD_AUDIO_ENABLE_TYPE_I_DECODING
-            const uint16_t active_fifo_depth = (audio->rx_supp_ff_sz_max / audio->n_bytes_per_sample_rx) * audio->n_bytes_per_sample_rx;
-            for (uint8_t cnt = 0; cnt < audio->n_rx_supp_ff; cnt++) {
-              tu_fifo_config(&audio->rx_supp_ff[cnt], audio->rx_supp_ff[cnt].buffer, active_fifo_depth, 1, true);
+            if (p_alt_cfg->n_bytes_per_sample != 0) {
+              audio->n_bytes_per_sample_rx = p_alt_cfg->n_bytes_per_sample;
             }
+    #endif
+
+              // Reconfigure size of support FIFOs - this is necessary to avoid samples to get split in case of a wrap
+    #if CFG_TUD_AUDIO_ENABLE_TYPE_I_DECODING
+      #if AUDIOD_CONV_RX
+            TU_VERIFY(audiod_conv_setup(func_id, alt, ep_addr, &audio->conv_rx, audio->n_bytes_per_sample_rx, audio->n_channels_rx));
+            uint8_t const ff_bytes_rx = audio->conv_rx.n_bytes_per_sample ? audio->conv_rx.n_bytes_per_sample : audio->n_bytes_per_sample_rx;
+      #else
+            uint8_t const ff_bytes_rx = audio->n_bytes_per_sample_rx;
+      #endif
+            const uint16_t active_fifo_depth = (uint16_t) ((audio->rx_supp_ff_sz_max / ff_bytes_rx) * ff_bytes_rx);
             audio->n_ff_used_rx = audio->n_channels_rx / audio->n_channels_per_ff_rx;
             TU_ASSERT(audio->n_ff_used_rx <= audio->n_rx_supp_ff);
+            // Reconfiguring empties the FIFOs, keep them if samples are laid out as before
+            if (ff_bytes_rx != ff_bytes_rx_prev || audio->n_ff_used_rx != n_ff_used_rx_prev || active_fifo_depth != tu_fifo_depth(&audio->rx_supp_ff[0])) {
+              for (uint8_t cnt = 0; cnt < audio->n_rx_supp_ff; cnt++) {
+                tu_fifo_config(&audio->rx_supp_ff[cnt], audio->rx_supp_ff[cnt].buffer, active_fifo_depth, 1, true);
+              }
+            }
+      #if AUDIOD_RS_RX
+            audiod_rs_setup(&audio->rs_rx, ff_bytes_rx, audio->n_channels_per_ff_rx, audio->n_ff_used_rx, &audio->rx_supp_ff[0]);
+      #endif
     #endif
   #endif
 
@@ -1995,6 +2922,26 @@ static bool audiod_set_interface(uint8_t rhport, tusb_control_request_t const *p
             }
           } break;
 
+          case AUDIO_FEEDBACK_METHOD_FIFO_PI: {
+            uint8_t slot_size = fb_param.fifo_pi.slot_size;
+  #if CFG_TUD_AUDIO_ENABLE_DECODING
+            uint16_t const fifo_depth = tu_fifo_depth(&audio->rx_supp_ff[0]);
+    #if CFG_TUD_AUDIO_ENABLE_TYPE_I_DECODING
+            if (slot_size == 0) {
+      #if AUDIOD_CONV_RX
+              uint8_t const ff_bytes_rx = audio->conv_rx.n_bytes_per_sample ? audio->conv_rx.n_bytes_per_sample : audio->n_bytes_per_sample_rx;
+      #else
+              uint8_t const ff_bytes_rx = audio->n_bytes_per_sample_rx;
+      #endif
+              slot_size = (uint8_t) (ff_bytes_rx * audio->n_channels_per_ff_rx);
+            }
+    #endif
+  #else
+            uint16_t const fifo_depth = tu_fifo_depth(&audio->ep_out_ff);
+  #endif
+            TU_ASSERT(audiod_set_fb_params_pi(audio, &fb_param, slot_size, fifo_depth));
+          } break;
+
           // nothing to do
           default:
             break;
@@ -2010,17 +2957,28 @@ static bool audiod_set_interface(uint8_t rhport, tusb_control_request_t const *p
     p_desc = tu_desc_next(p_desc);
   }
 
-#if CFG_TUD_AUDIO_ENABLE_FEEDBACK_EP
-  // Disable SOF interrupt if no driver has any enabled feedback EP
+#if CFG_TUD_AUDIO_ENABLE_FEEDBACK_EP || CFG_TUD_AUDIO_ENABLE_STATS
+  // Disable SOF interrupt if no driver has any enabled feedback EP (or any EP to be monitored)
   bool enable_sof = false;
   for (uint8_t i = 0; i < CFG_TUD_AUDIO; i++) {
+  #if CFG_TUD_AUDIO_ENABLE_STATS
+    _audiod_fct[i].stats_sof_valid = false;
+    #if CFG_TUD_AUDIO_ENABLE_EP_IN
+    enable_sof |= (_audiod_fct[i].ep_in_as_intf_num != 0);
+    #endif
+    #if CFG_TUD_AUDIO_ENABLE_EP_OUT
+    enable_sof |= (_audiod_fct[i].ep_out_as_intf_num != 0);
+    #endif
+  #endif
+  #if CFG_TUD_AUDIO_ENABLE_FEEDBACK_EP
     if (_audiod_fct[i].ep_fb != 0 &&
         (_audiod_fct[i].feedback.compute_method == AUDIO_FEEDBACK_METHOD_FREQUENCY_FIXED ||
          _audiod_fct[i].feedback.compute_method == AUDIO_FEEDBACK_METHOD_FREQUENCY_FLOAT ||
-         _audiod_fct[i].feedback.compute_method == AUDIO_FEEDBACK_METHOD_FREQUENCY_POWER_OF_2)) {
+         _audiod_fct[i].feedback.compute_method == AUDIO_FEEDBACK_METHOD_FREQUENCY_POWER_OF_2 ||
+         (_audiod_fct[i].feedback.compute_method == AUDIO_FEEDBACK_METHOD_FIFO_PI && _audiod_fct[i].feedback.compute.fifo_pi.mclk_freq != 0))) {
       enable_sof = true;
-      break;
     }
+  #endif
   }
   usbd_sof_enable(rhport, SOF_CONSUMER_AUDIO, enable_sof);
 #endif
@@ -2251,6 +3209,28 @@ bool audiod_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint3
   return false;
 }
 
+#if CFG_TUD_AUDIO_XFER_ISR
+// Only received audio packets are handled in ISR, other endpoints are deferred to audiod_xfer_cb() in usbd task
+TU_ATTR_FAST_FUNC bool audiod_xfer_isr(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes) {
+  #if CFG_TUD_AUDIO_ENABLE_EP_OUT
+  TU_VERIFY(XFER_RESULT_SUCCESS == result);
+
+  for (uint8_t func_id = 0; func_id < CFG_TUD_AUDIO; func_id++) {
+    audiod_function_t *audio = &_audiod_fct[func_id];
+    if (audio->rhport == rhport && audio->ep_out == ep_addr) {
+      // event is consumed even if decoding fails, deferring would process the same packet twice
+      (void) audiod_rx_done_cb(rhport, audio, (uint16_t) xferred_bytes);
+      return true;
+    }
+  }
+  #else
+  (void) rhport; (void) ep_addr; (void) result; (void) xferred_bytes;
+  #endif
+
+  return false;
+}
+#endif
+
 #if CFG_TUD_AUDIO_ENABLE_EP_OUT && CFG_TUD_AUDIO_ENABLE_FEEDBACK_EP
 
 static bool audiod_set_fb_params_freq(audiod_function_t *audio, uint32_t sample_freq, uint32_t mclk_freq) {
@@ -2310,11 +3290,130 @@ static void audiod_fb_fifo_count_update(audiod_function_t *audio, uint16_t lvl_n
   }
 }
 
+static bool audiod_set_fb_params_pi(audiod_function_t *audio, audio_feedback_params_t const *fb_param, uint8_t slot_size, uint16_t fifo_depth) {
+  TU_ASSERT(slot_size > 0 && fifo_depth >= 2 * slot_size);
+
+  // Level is updated once per received packet, assume one packet per (micro)frame
+  uint32_t const frame_div = (TUSB_SPEED_FULL == tud_speed_get()) ? 1000 : 8000;
+  uint32_t const bandwidth_mhz = fb_param->fifo_pi.bandwidth_mhz ? fb_param->fifo_pi.bandwidth_mhz : 1000;
+
+  // Kp = 2*pi*bandwidth/update_rate, rounded down to a power of 2. Ki = Kp^2/4 for a critically damped loop
+  uint32_t const ratio = (uint32_t) (((uint64_t) frame_div * 159155u) / (1000u * bandwidth_mhz));// update_rate / (2*pi*bandwidth)
+  uint8_t kp_shift = ratio ? tu_log2(ratio) : 0;
+  kp_shift = tu_max8(kp_shift, 1);
+  kp_shift = tu_min8(kp_shift, 20);
+
+  audio->feedback.compute.fifo_pi.kp_shift = kp_shift;
+  audio->feedback.compute.fifo_pi.kp = (uint32_t) ((1UL << 24) / slot_size) >> kp_shift;
+  TU_ASSERT(audio->feedback.compute.fifo_pi.kp > 0);
+
+  // Integral correction is limited to the allowed feedback range
+  uint32_t const i_max = audio->feedback.max_value - audio->feedback.min_value;
+  audio->feedback.compute.fifo_pi.err_sum_max = (int64_t) ((((uint64_t) i_max << 16) << (kp_shift + 2)) / audio->feedback.compute.fifo_pi.kp);
+
+  // Avoid 64bit division
+  uint32_t const nominal = ((fb_param->sample_freq / 100) << 16) / (frame_div / 100);
+  uint16_t const fifo_lvl_thr = fifo_depth / 2;
+
+  audio->feedback.compute.fifo_pi.base_value = nominal;
+  audio->feedback.compute.fifo_pi.sample_freq = fb_param->sample_freq;
+  audio->feedback.compute.fifo_pi.mclk_freq = fb_param->fifo_pi.mclk_freq;
+  audio->feedback.compute.fifo_pi.fifo_lvl_thr = fifo_lvl_thr;
+  audio->feedback.compute.fifo_pi.lvl_avg = (int32_t) fifo_lvl_thr << 8;
+  audio->feedback.compute.fifo_pi.err_sum = 0;
+  audio->feedback.compute.fifo_pi.p_term = 0;
+  audio->feedback.compute.fifo_pi.i_term = 0;
+  audio->feedback.compute.fifo_pi.clamp_count = 0;
+  audio->feedback.compute.fifo_pi.lvl_min = UINT16_MAX;
+  audio->feedback.compute.fifo_pi.lvl_max = 0;
+  audio->feedback.value = nominal;
+
+  return true;
+}
+
+static void audiod_fb_fifo_pi_update(audiod_function_t *audio, uint16_t lvl_new) {
+  // Level drops every time data is consumed, a short low-pass filter removes this packet jitter
+  int32_t lvl = audio->feedback.compute.fifo_pi.lvl_avg;
+  lvl += (((int32_t) lvl_new << 8) - lvl) / 8;
+  audio->feedback.compute.fifo_pi.lvl_avg = lvl;
+
+  if (lvl_new < audio->feedback.compute.fifo_pi.lvl_min) audio->feedback.compute.fifo_pi.lvl_min = lvl_new;
+  if (lvl_new > audio->feedback.compute.fifo_pi.lvl_max) audio->feedback.compute.fifo_pi.lvl_max = lvl_new;
+
+  // Positive error i.e. FIFO below target asks host for more samples
+  int32_t const err = ((int32_t) audio->feedback.compute.fifo_pi.fifo_lvl_thr << 8) - lvl;
+  int64_t err_sum = audio->feedback.compute.fifo_pi.err_sum + err;
+  int64_t const err_sum_max = audio->feedback.compute.fifo_pi.err_sum_max;
+  if (err_sum > err_sum_max) err_sum = err_sum_max;
+  if (err_sum < -err_sum_max) err_sum = -err_sum_max;
+
+  uint32_t const kp = audio->feedback.compute.fifo_pi.kp;
+  int32_t const p_term = (int32_t) (((int64_t) err * kp) >> 16);
+  int32_t const i_term = (int32_t) ((err_sum * kp) >> (16 + audio->feedback.compute.fifo_pi.kp_shift + 2));
+
+  int64_t feedback = (int64_t) audio->feedback.compute.fifo_pi.base_value + p_term + i_term;
+
+  if (feedback > audio->feedback.max_value || feedback < audio->feedback.min_value) {
+    // Anti-windup: stop integrating while output is saturated
+    feedback = (feedback > audio->feedback.max_value) ? audio->feedback.max_value : audio->feedback.min_value;
+    audio->feedback.compute.fifo_pi.clamp_count++;
+  } else {
+    audio->feedback.compute.fifo_pi.err_sum = err_sum;
+  }
+
+  audio->feedback.compute.fifo_pi.p_term = p_term;
+  audio->feedback.compute.fifo_pi.i_term = i_term;
+  audio->feedback.value = (uint32_t) feedback;
+
+  // Schedule a transmit with the new value if EP is not busy - this triggers repetitive scheduling of the feedback value
+  if (usbd_edpt_claim(audio->rhport, audio->ep_fb)) {
+    audiod_fb_send(audio);
+  }
+}
+
+bool tud_audio_n_fb_pi_stats(uint8_t func_id, audio_feedback_pi_stats_t *stats, bool clear) {
+  TU_VERIFY(func_id < CFG_TUD_AUDIO && _audiod_fct[func_id].p_desc != NULL);
+  audiod_function_t *audio = &_audiod_fct[func_id];
+  TU_VERIFY(audio->feedback.compute_method == AUDIO_FEEDBACK_METHOD_FIFO_PI);
+
+  stats->value = audio->feedback.value;
+  stats->base_value = audio->feedback.compute.fifo_pi.base_value;
+  stats->p_term = audio->feedback.compute.fifo_pi.p_term;
+  stats->i_term = audio->feedback.compute.fifo_pi.i_term;
+  stats->fifo_lvl = (uint16_t) (audio->feedback.compute.fifo_pi.lvl_avg >> 8);
+  stats->fifo_lvl_thr = audio->feedback.compute.fifo_pi.fifo_lvl_thr;
+  stats->fifo_lvl_min = audio->feedback.compute.fifo_pi.lvl_min;
+  stats->fifo_lvl_max = audio->feedback.compute.fifo_pi.lvl_max;
+  stats->clamp_count = audio->feedback.compute.fifo_pi.clamp_count;
+
+  if (clear) {
+    audio->feedback.compute.fifo_pi.lvl_min = UINT16_MAX;
+    audio->feedback.compute.fifo_pi.lvl_max = 0;
+    audio->feedback.compute.fifo_pi.clamp_count = 0;
+  }
+
+  return true;
+}
+
 uint32_t tud_audio_feedback_update(uint8_t func_id, uint32_t cycles) {
   audiod_function_t *audio = &_audiod_fct[func_id];
   uint32_t feedback;
 
   switch (audio->feedback.compute_method) {
+    case AUDIO_FEEDBACK_METHOD_FIFO_PI: {
+      // Measured rate only moves the estimate, feedback is sent by the controller on FIFO update
+      TU_VERIFY(audio->feedback.compute.fifo_pi.mclk_freq != 0, 0);
+      uint64_t fb64 = ((((uint64_t) cycles) * audio->feedback.compute.fifo_pi.sample_freq) << 16) >> audio->feedback.frame_shift;
+      uint32_t measured = (uint32_t) (fb64 / audio->feedback.compute.fifo_pi.mclk_freq);
+      if (measured > audio->feedback.max_value) measured = audio->feedback.max_value;
+      if (measured < audio->feedback.min_value) measured = audio->feedback.min_value;
+
+      uint32_t base = audio->feedback.compute.fifo_pi.base_value;
+      base = (uint32_t) ((int32_t) base + ((int32_t) measured - (int32_t) base) / 8);
+      audio->feedback.compute.fifo_pi.base_value = base;
+      return audio->feedback.value;
+    }
+
     case AUDIO_FEEDBACK_METHOD_FREQUENCY_POWER_OF_2:
       feedback = (cycles << audio->feedback.compute.power_of_2);
       break;
@@ -2362,6 +3461,36 @@ TU_ATTR_FAST_FUNC void audiod_sof_isr(uint8_t rhport, uint32_t frame_count) {
   (void) rhport;
   (void) frame_count;
 
+#if CFG_TUD_AUDIO_ENABLE_STATS
+  uint32_t const ts = tud_audio_stats_timestamp_cb();
+
+  for (uint8_t i = 0; i < CFG_TUD_AUDIO; i++) {
+    audiod_function_t *audio = &_audiod_fct[i];
+    if (audio->p_desc == NULL) continue;
+
+    audio->stats.sof_count++;
+    if (audio->stats_sof_valid) {
+      // Frame number is 11 bit
+      uint32_t const n_frames = (frame_count - audio->stats_sof_frame) & 0x7FFu;
+      if (n_frames > 1) {
+        audio->stats.sof_missed += n_frames - 1;
+      } else if (n_frames == 1 && ts != 0) {
+        uint32_t const period = ts - audio->stats_sof_ts;
+        if (audio->stats.sof_period_avg == 0) {
+          audio->stats.sof_period_avg = period;
+        } else {
+          audio->stats.sof_period_avg = (uint32_t) ((int32_t) audio->stats.sof_period_avg + ((int32_t) period - (int32_t) audio->stats.sof_period_avg) / 16);
+        }
+        if (audio->stats.sof_period_min == 0 || period < audio->stats.sof_period_min) audio->stats.sof_period_min = period;
+        if (period > audio->stats.sof_period_max) audio->stats.sof_period_max = period;
+      }
+    }
+    audio->stats_sof_ts = ts;
+    audio->stats_sof_frame = frame_count;
+    audio->stats_sof_valid = true;
+  }
+#endif
+
 #if CFG_TUD_AUDIO_ENABLE_EP_OUT && CFG_TUD_AUDIO_ENABLE_FEEDBACK_EP
   // Determine feedback value - The feedback method is described in 5.12.4.2 of the USB 2.0 spec
   // Boiled down, the feedback value Ff = n_samples / (micro)frame.
@@ -2559,20 +3688,28 @@ static bool audiod_verify_ep_exists(uint8_t ep, uint8_t *func_id) {
   return false;
 }
 
-#if (CFG_TUD_AUDIO_ENABLE_EP_IN && (CFG_TUD_AUDIO_EP_IN_FLOW_CONTROL || CFG_TUD_AUDIO_ENABLE_ENCODING)) || (CFG_TUD_AUDIO_ENABLE_EP_OUT && CFG_TUD_AUDIO_ENABLE_DECODING)
-// p_desc points to the AS interface of alternate setting zero
-// itf is the interface number of the corresponding interface - we check if the interface belongs to EP in or EP out to see if it is a TX or RX parameter
-// Currently, only AS interfaces with an EP (in or out) are supposed to be parsed for!
-static void audiod_parse_for_AS_params(audiod_function_t *audio, uint8_t const *p_desc, uint8_t const *p_desc_end, uint8_t const as_itf) {
-  #if CFG_TUD_AUDIO_ENABLE_EP_IN && CFG_TUD_AUDIO_ENABLE_EP_OUT
-  if (as_itf != audio->ep_in_as_intf_num && as_itf != audio->ep_out_as_intf_num) return;// Abort, this interface has no EP, this driver does not support this currently
-  #endif
-  #if CFG_TUD_AUDIO_ENABLE_EP_IN && !CFG_TUD_AUDIO_ENABLE_EP_OUT
-  if (as_itf != audio->ep_in_as_intf_num) return;
-  #endif
-  #if !CFG_TUD_AUDIO_ENABLE_EP_IN && CFG_TUD_AUDIO_ENABLE_EP_OUT
-  if (as_itf != audio->ep_out_as_intf_num) return;
-  #endif
+#if AUDIOD_CONV_RX || AUDIOD_CONV_TX
+// Get sample format of support FIFOs for the alternate setting just set
+static bool audiod_conv_setup(uint8_t func_id, uint8_t alt, uint8_t ep_addr, audio_conv_params_t *conv, uint8_t ep_bytes, uint8_t n_channels) {
+  tu_memclr(conv, sizeof(audio_conv_params_t));
+  tud_audio_conv_params_cb(func_id, alt, ep_addr, conv);
+
+  if (conv->n_bytes_per_sample != 0) {
+    // 8-bit PCM is unsigned and not supported
+    TU_ASSERT(ep_bytes >= 2 && ep_bytes <= 4);
+    TU_ASSERT(conv->n_bytes_per_sample >= 2 && conv->n_bytes_per_sample <= 4);
+    TU_ASSERT(conv->n_bits_right <= 8 * conv->n_bytes_per_sample);
+    TU_ASSERT(!conv->apply_gain || n_channels <= CFG_TUD_AUDIO_CONV_N_CHANNELS_MAX);
+  }
+  return true;
+}
+#endif
+
+// Parse format of the alternate setting whose Standard AS Interface Descriptor p_desc points to
+static void audiod_parse_alt_cfg(uint8_t const *p_desc, uint8_t const *p_desc_end, audiod_alt_cfg_t *cfg) {
+  tu_memclr(cfg, sizeof(audiod_alt_cfg_t));
+  cfg->itf = ((tusb_desc_interface_t const *) p_desc)->bInterfaceNumber;
+  cfg->alt = ((tusb_desc_interface_t const *) p_desc)->bAlternateSetting;
 
   p_desc = tu_desc_next(p_desc);// Exclude standard AS interface descriptor of current alternate interface descriptor
   // Condition modified from p_desc < p_desc_end to prevent gcc>=12 strict-overflow warning
@@ -2580,59 +3717,44 @@ static void audiod_parse_for_AS_params(audiod_function_t *audio, uint8_t const *
     // Abort if follow up descriptor is a new standard interface descriptor - indicates the last AS descriptor was already finished
     if (tu_desc_type(p_desc) == TUSB_DESC_INTERFACE) break;
 
-    // Look for a Class-Specific AS Interface Descriptor(4.9.2) to verify format type and format and also to get number of physical channels
-    if (tu_desc_type(p_desc) == TUSB_DESC_CS_INTERFACE && tu_desc_subtype(p_desc) == AUDIO_CS_AS_INTERFACE_AS_GENERAL) {
-  #if CFG_TUD_AUDIO_ENABLE_EP_IN
-      if (as_itf == audio->ep_in_as_intf_num) {
-        audio->n_channels_tx = ((audio_desc_cs_as_interface_t const *) p_desc)->bNrChannels;
-        audio->format_type_tx = (audio_format_type_t) (((audio_desc_cs_as_interface_t const *) p_desc)->bFormatType);
-
-    #if CFG_TUD_AUDIO_ENABLE_TYPE_I_ENCODING
-        audio->format_type_I_tx = (audio_data_format_type_I_t) (((audio_desc_cs_as_interface_t const *) p_desc)->bmFormats);
-    #endif
+    if (tu_desc_type(p_desc) == TUSB_DESC_CS_INTERFACE) {
+      // Look for a Class-Specific AS Interface Descriptor(4.9.2) to verify format type and format and also to get number of physical channels
+      if (tu_desc_subtype(p_desc) == AUDIO_CS_AS_INTERFACE_AS_GENERAL) {
+        audio_desc_cs_as_interface_t const *desc_cs = (audio_desc_cs_as_interface_t const *) p_desc;
+        cfg->format_type = desc_cs->bFormatType;
+        cfg->n_channels = desc_cs->bNrChannels;
+        cfg->format_type_I = desc_cs->bmFormats;
       }
-  #endif
 
-  #if CFG_TUD_AUDIO_ENABLE_EP_OUT && CFG_TUD_AUDIO_ENABLE_DECODING
-      if (as_itf == audio->ep_out_as_intf_num) {
-        audio->n_channels_rx = ((audio_desc_cs_as_interface_t const *) p_desc)->bNrChannels;
-        audio->format_type_rx = ((audio_desc_cs_as_interface_t const *) p_desc)->bFormatType;
-    #if CFG_TUD_AUDIO_ENABLE_TYPE_I_DECODING
-        audio->format_type_I_rx = ((audio_desc_cs_as_interface_t const *) p_desc)->bmFormats;
-    #endif
+      // Look for a Type I Format Type Descriptor(2.3.1.6 - Audio Formats)
+      if (tu_desc_subtype(p_desc) == AUDIO_CS_AS_INTERFACE_FORMAT_TYPE && ((audio_desc_type_I_format_t const *) p_desc)->bFormatType == AUDIO_FORMAT_TYPE_I) {
+        cfg->n_bytes_per_sample = ((audio_desc_type_I_format_t const *) p_desc)->bSubslotSize;
       }
-  #endif
+
+      // Other format types are not supported yet
     }
 
-    // Look for a Type I Format Type Descriptor(2.3.1.6 - Audio Formats)
-  #if CFG_TUD_AUDIO_ENABLE_TYPE_I_ENCODING || CFG_TUD_AUDIO_EP_IN_FLOW_CONTROL || CFG_TUD_AUDIO_ENABLE_TYPE_I_DECODING
-    if (tu_desc_type(p_desc) == TUSB_DESC_CS_INTERFACE && tu_desc_subtype(p_desc) == AUDIO_CS_AS_INTERFACE_FORMAT_TYPE && ((audio_desc_type_I_format_t const *) p_desc)->bFormatType == AUDIO_FORMAT_TYPE_I) {
-    #if CFG_TUD_AUDIO_ENABLE_EP_IN && CFG_TUD_AUDIO_ENABLE_EP_OUT
-      if (as_itf != audio->ep_in_as_intf_num && as_itf != audio->ep_out_as_intf_num) break;// Abort loop, this interface has no EP, this driver does not support this currently
-    #endif
-    #if CFG_TUD_AUDIO_ENABLE_EP_IN && !CFG_TUD_AUDIO_ENABLE_EP_OUT
-      if (as_itf != audio->ep_in_as_intf_num) break;
-    #endif
-    #if !CFG_TUD_AUDIO_ENABLE_EP_IN && CFG_TUD_AUDIO_ENABLE_EP_OUT
-      if (as_itf != audio->ep_out_as_intf_num) break;
-    #endif
+    p_desc = tu_desc_next(p_desc);
+  }
+}
 
-    #if CFG_TUD_AUDIO_ENABLE_EP_IN
-      if (as_itf == audio->ep_in_as_intf_num) {
-        audio->n_bytes_per_sample_tx = ((audio_desc_type_I_format_t const *) p_desc)->bSubslotSize;
-      }
-    #endif
+#if CFG_TUD_AUDIO_ALT_CFG_MAX
+// Parse all AS alternate settings having EPs once, s.t. set interface does not need to walk the descriptor
+static void audiod_build_alt_cfg(audiod_function_t *audio) {
+  uint8_t const *p_desc = audio->p_desc;
+  uint8_t const *p_desc_end = p_desc + audio->desc_length - TUD_AUDIO_DESC_IAD_LEN;
 
-    #if CFG_TUD_AUDIO_ENABLE_EP_OUT && CFG_TUD_AUDIO_ENABLE_DECODING
-      if (as_itf == audio->ep_out_as_intf_num) {
-        audio->n_bytes_per_sample_rx = ((audio_desc_type_I_format_t const *) p_desc)->bSubslotSize;
+  audio->n_alt_cfg = 0;
+  // Condition modified from p_desc < p_desc_end to prevent gcc>=12 strict-overflow warning
+  while (p_desc_end - p_desc > 0 && audio->n_alt_cfg < CFG_TUD_AUDIO_ALT_CFG_MAX) {
+    if (tu_desc_type(p_desc) == TUSB_DESC_INTERFACE) {
+      tusb_desc_interface_t const *desc_itf = (tusb_desc_interface_t const *) p_desc;
+      if (desc_itf->bInterfaceSubClass == AUDIO_SUBCLASS_STREAMING && desc_itf->bNumEndpoints > 0) {
+        audiod_alt_cfg_t *cfg = &audio->alt_cfg[audio->n_alt_cfg++];
+        audiod_parse_alt_cfg(p_desc, p_desc_end, cfg);
+        cfg->desc_offset = (uint16_t) (p_desc - audio->p_desc);
       }
-    #endif
     }
-  #endif
-
-    // Other format types are not supported yet
-
     p_desc = tu_desc_next(p_desc);
   }
 }
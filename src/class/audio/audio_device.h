@@ -187,6 +187,24 @@
 #define CFG_TUD_AUDIO_EP_IN_FLOW_CONTROL  1
 #endif
 
+// Prepare ISO IN packets one interval ahead into a second linear buffer. The prepared packet is queued behind the one on
+// the wire and armed from ISR when it completes (requires CFG_TUD_EDPT_XFER_QUEUE), usbd task then has a whole interval
+// to encode the next one instead of racing the next IN token. Adds one packet of latency and EP IN size of RAM.
+#ifndef CFG_TUD_AUDIO_EP_IN_DOUBLE_BUFFER
+#define CFG_TUD_AUDIO_EP_IN_DOUBLE_BUFFER 0
+#endif
+
+#if CFG_TUD_AUDIO_EP_IN_DOUBLE_BUFFER && !CFG_TUD_EDPT_XFER_QUEUE
+#error CFG_TUD_AUDIO_EP_IN_DOUBLE_BUFFER requires CFG_TUD_EDPT_XFER_QUEUE
+#endif
+
+// Number of AS alternate settings with endpoints per audio function whose descriptor location and format are parsed
+// once at mount, set interface then switches to them without walking the configuration descriptor.
+// Alternate settings beyond this number still work but are parsed on every set interface. 0 to disable.
+#ifndef CFG_TUD_AUDIO_ALT_CFG_MAX
+#define CFG_TUD_AUDIO_ALT_CFG_MAX 4
+#endif
+
 // Enable/disable feedback EP (required for asynchronous RX applications)
 #ifndef CFG_TUD_AUDIO_ENABLE_FEEDBACK_EP
 #define CFG_TUD_AUDIO_ENABLE_FEEDBACK_EP                    0                             // Feedback - 0 or 1
@@ -270,6 +288,72 @@
 #define CFG_TUD_AUDIO_ENABLE_TYPE_I_DECODING                0
 #endif
 
+// Sample format conversion fused into Type I encoding/decoding: samples in support FIFOs may have a different format than
+// on the EP (e.g. 16-bit EP and left justified 32-bit I2S), optionally multiplied by a gain e.g. of a feature unit's
+// volume control. Format is set per alternate setting by tud_audio_conv_params_cb()
+#ifndef CFG_TUD_AUDIO_ENABLE_CONVERSION
+#define CFG_TUD_AUDIO_ENABLE_CONVERSION                     0
+#endif
+
+// Maximum number of logical channels with individual gain
+#ifndef CFG_TUD_AUDIO_CONV_N_CHANNELS_MAX
+#define CFG_TUD_AUDIO_CONV_N_CHANNELS_MAX                   8
+#endif
+
+// Handle ISO OUT transfer complete directly in ISR (require CFG_TUD_XFER_ISR): received packet is decoded into support
+// FIFOs (or copied into EP OUT FIFO) and endpoint is re-armed without waiting for usbd task.
+// Note: tud_audio_rx_done_pre_read_cb() and tud_audio_rx_done_post_read_cb() are then invoked in ISR context
+#ifndef CFG_TUD_AUDIO_XFER_ISR
+#define CFG_TUD_AUDIO_XFER_ISR                              0
+#endif
+
+#if CFG_TUD_AUDIO_XFER_ISR && !CFG_TUD_XFER_ISR
+  #error "CFG_TUD_AUDIO_XFER_ISR requires CFG_TUD_XFER_ISR"
+#endif
+
+#if CFG_TUD_AUDIO_ENABLE_CONVERSION && !CFG_TUD_AUDIO_ENABLE_TYPE_I_ENCODING && !CFG_TUD_AUDIO_ENABLE_TYPE_I_DECODING
+#error CFG_TUD_AUDIO_ENABLE_CONVERSION requires Type I encoding or decoding
+#endif
+
+// Asynchronous sample rate converter between application and support FIFOs: samples written by tud_audio_n_write_support_ff()
+// or read by tud_audio_n_read_support_ff() are resampled by a ratio close to 1, steered to keep support FIFO 0 half filled.
+// Compensates clock mismatch of device and host where there is no feedback e.g. microphones, or where the device can not
+// follow it. Supports 16 and 32-bit samples in support FIFOs, enabled per EP direction by tud_audio_n_resampler_enable()
+#ifndef CFG_TUD_AUDIO_ENABLE_RESAMPLER
+#define CFG_TUD_AUDIO_ENABLE_RESAMPLER                      0
+#endif
+
+// Maximum number of channels per support FIFO for resampling
+#ifndef CFG_TUD_AUDIO_RESAMPLER_N_CHANNELS_MAX
+#define CFG_TUD_AUDIO_RESAMPLER_N_CHANNELS_MAX              2
+#endif
+
+// Maximum number of support FIFOs used by an alternate setting for resampling
+#ifndef CFG_TUD_AUDIO_RESAMPLER_N_FF_MAX
+#define CFG_TUD_AUDIO_RESAMPLER_N_FF_MAX                    1
+#endif
+
+// Maximum deviation of resampling ratio from 1 in ppm
+#ifndef CFG_TUD_AUDIO_RESAMPLER_PPM_MAX
+#define CFG_TUD_AUDIO_RESAMPLER_PPM_MAX                     1000
+#endif
+
+#if CFG_TUD_AUDIO_ENABLE_RESAMPLER && !CFG_TUD_AUDIO_ENABLE_TYPE_I_ENCODING && !CFG_TUD_AUDIO_ENABLE_TYPE_I_DECODING
+#error CFG_TUD_AUDIO_ENABLE_RESAMPLER requires Type I encoding or decoding
+#endif
+
+// Runtime statistics of streaming per audio function e.g. to diagnose glitches without an USB analyzer: packet counts,
+// short/oversize packets, FIFO underruns/overruns, feedback history and host SOF jitter, see tud_audio_n_get_stats().
+// SOF interrupt is enabled while an AS interface with EP is active
+#ifndef CFG_TUD_AUDIO_ENABLE_STATS
+#define CFG_TUD_AUDIO_ENABLE_STATS                          0
+#endif
+
+// Number of latest feedback values kept in statistics
+#ifndef CFG_TUD_AUDIO_STATS_FB_HISTORY
+#define CFG_TUD_AUDIO_STATS_FB_HISTORY                      8
+#endif
+
 // Type I Coding parameters not given within UAC2 descriptors
 // It would be possible to allow for a more flexible setting and not fix this parameter as done below. However, this is most often not needed and kept for later if really necessary. The more flexible setting could be implemented within set_interface(), however, how the values are saved per alternate setting is to be determined!
 #if CFG_TUD_AUDIO_ENABLE_EP_IN && CFG_TUD_AUDIO_ENABLE_ENCODING && CFG_TUD_AUDIO_ENABLE_TYPE_I_ENCODING
@@ -384,6 +468,8 @@ tu_fifo_t* tud_audio_n_get_rx_support_ff          (uint8_t func_id, uint8_t ff_i
 
 #if CFG_TUD_AUDIO_ENABLE_EP_IN && !CFG_TUD_AUDIO_ENABLE_ENCODING
 uint16_t tud_audio_n_write                        (uint8_t func_id, const void * data, uint16_t len);
+uint16_t tud_audio_n_write_reserve                (uint8_t func_id, void ** buffer, uint16_t len); // Zero-copy write, must be followed by commit
+void     tud_audio_n_write_commit                 (uint8_t func_id, uint16_t len);
 bool     tud_audio_n_clear_ep_in_ff               (uint8_t func_id);                          // Delete all content in the EP IN FIFO
 tu_fifo_t*   tud_audio_n_get_ep_in_ff             (uint8_t func_id);
 #endif
@@ -399,6 +485,41 @@ tu_fifo_t* tud_audio_n_get_tx_support_ff          (uint8_t func_id, uint8_t ff_i
 bool    tud_audio_int_n_write                     (uint8_t func_id, const audio_interrupt_data_t * data);
 #endif
 
+#if CFG_TUD_AUDIO_ENABLE_CONVERSION
+bool     tud_audio_n_set_gain                     (uint8_t func_id, uint8_t ep_dir, uint8_t channel, uint16_t gain); // Conversion gain of EP direction TUSB_DIR_IN/OUT, see AUDIO_CONV_GAIN_UNITY
+#endif
+
+#if CFG_TUD_AUDIO_ENABLE_RESAMPLER
+bool     tud_audio_n_resampler_enable             (uint8_t func_id, uint8_t ep_dir, bool enable); // Resample support FIFO data of EP direction TUSB_DIR_IN/OUT
+int32_t  tud_audio_n_resampler_ppm                (uint8_t func_id, uint8_t ep_dir); // Current ratio deviation, positive if input side (application for IN, USB for OUT) is faster
+#endif
+
+#if CFG_TUD_AUDIO_ENABLE_STATS
+// Packets are counted short/oversize if they deviate by more than one audio slot from the average packet size
+// (UAC2 FMT-2.0 section 2.3.1.1), or if they are empty or hold a partial audio slot
+typedef struct {
+  uint32_t tx_packets;     // IN data packets scheduled
+  uint32_t tx_short;       // IN packets shorter than average, without empty ones
+  uint32_t tx_underrun;    // IN packets sent empty since FIFO had no data
+  uint32_t rx_packets;     // OUT data packets received
+  uint32_t rx_short;       // OUT packets shorter than average, empty or holding a partial audio slot
+  uint32_t rx_oversize;    // OUT packets longer than average
+  uint32_t rx_overrun;     // OUT packets not fully stored since FIFO was full
+  uint16_t tx_pkt_avg;     // Average IN packet size in bytes
+  uint16_t rx_pkt_avg;     // Average OUT packet size in bytes
+  uint32_t fb_count;       // Feedback packets sent
+  uint32_t fb_history[CFG_TUD_AUDIO_STATS_FB_HISTORY]; // Latest distinct feedback values sent in 16.16 format, index 0 is newest
+  uint32_t sof_count;      // SOFs received
+  uint32_t sof_missed;     // SOFs missed according to frame number
+  uint32_t sof_period_min; // SOF period in ticks of tud_audio_stats_timestamp_cb(), all 0 if not implemented. Max - min
+  uint32_t sof_period_max; // is the host SOF jitter (plus interrupt latency)
+  uint32_t sof_period_avg;
+} audio_stats_t;
+
+// Get statistics of audio function, counters and min/max are reset if clear is true
+bool     tud_audio_n_get_stats                    (uint8_t func_id, audio_stats_t* stats, bool clear);
+#endif
+
 
 //--------------------------------------------------------------------+
 // Application API (Interface0)
@@ -426,6 +547,8 @@ static inline tu_fifo_t* tud_audio_get_rx_support_ff        (uint8_t ff_idx);
 
 #if CFG_TUD_AUDIO_ENABLE_EP_IN && !CFG_TUD_AUDIO_ENABLE_ENCODING
 static inline uint16_t tud_audio_write                      (const void * data, uint16_t len);
+static inline uint16_t tud_audio_write_reserve              (void ** buffer, uint16_t len);
+static inline void     tud_audio_write_commit               (uint16_t len);
 static inline bool 	   tud_audio_clear_ep_in_ff             (void);
 static inline tu_fifo_t* tud_audio_get_ep_in_ff             (void);
 #endif
@@ -443,6 +566,18 @@ static inline tu_fifo_t* tud_audio_get_tx_support_ff        (uint8_t ff_idx);
 static inline bool tud_audio_int_write                      (const audio_interrupt_data_t * data);
 #endif
 
+#if CFG_TUD_AUDIO_ENABLE_CONVERSION
+static inline bool tud_audio_set_gain                       (uint8_t ep_dir, uint8_t channel, uint16_t gain);
+#endif
+
+#if CFG_TUD_AUDIO_ENABLE_RESAMPLER
+static inline bool tud_audio_resampler_enable               (uint8_t ep_dir, bool enable);
+#endif
+
+#if CFG_TUD_AUDIO_ENABLE_STATS
+static inline bool tud_audio_get_stats                      (audio_stats_t* stats, bool clear);
+#endif
+
 // Buffer control EP data and schedule a transmit
 // This function is intended to be used if you do not have a persistent buffer or memory location available (e.g. non-local variables) and need to answer onto a
 // get request. This function buffers your answer request frame into the control buffer of the corresponding audio driver and schedules a transmit for sending it.
@@ -486,7 +621,16 @@ void tud_audio_fb_done_cb(uint8_t func_id);
 // It is read from within the SOF ISR - see: audiod_sof() -, hence, the ISR must has a high priority such that no software dependent "random" delay i.e. jitter is introduced).
 // Long-term drift could occur since error is accumulated.
 //
-// Option 3 - manual
+// Option 3 - AUDIO_FEEDBACK_METHOD_FIFO_PI
+// Feedback value is calculated within the audio driver by a proportional-integral controller regulating the FIFO level to half fill
+// around a rate estimate. The estimate is the nominal rate, or if mclk_freq is given the rate measured from master clock cycles passed to
+// tud_audio_feedback_update() (SOF interrupt is enabled as for option 2). The integral term removes the remaining error i.e. FIFO does not drift
+// even if the estimate is off, the clock measurement lets the controller follow the sample clock without waiting for the FIFO to move.
+// Loop bandwidth is configurable, lower bandwidth filters more host jitter but reacts slower. See tud_audio_n_fb_pi_stats() for telemetry.
+// Advantage: No long-term drift, FIFO level settles on half fill regardless of clock offset, same FIFO size as option 1.
+// Disadvantage: Bandwidth must be chosen well below the feedback update rate of host, otherwise control loop could oscillate.
+//
+// Option 4 - manual
 // Determined by the user itself and set by use of tud_audio_n_fb_set(). The feedback value may be determined e.g. from some fill status of some FIFO buffer.
 // Advantage: No ISR interrupt is enabled, hence the CPU need not to handle an ISR every 1ms or 125us and thus less CPU load.
 // Disadvantage: typically a larger FIFO is needed to compensate for jitter (e.g. 6 frames), i.e. a larger delay is introduced.
@@ -513,7 +657,7 @@ bool tud_audio_n_fb_set(uint8_t func_id, uint32_t feedback);
 
 // Update feedback value with passed MCLK cycles since last time this update function is called.
 // Typically called within tud_audio_sof_isr(). Required tud_audio_feedback_params_cb() is implemented
-// This function will also call tud_audio_feedback_set()
+// This function will also call tud_audio_feedback_set(), except for AUDIO_FEEDBACK_METHOD_FIFO_PI where cycles only update the rate estimate
 // return feedback value in 16.16 for reference (0 for error)
 // Example :
 //   binterval=3 (4ms); FS = 48kHz; MCLK = 12.288MHz
@@ -525,7 +669,8 @@ enum {
   AUDIO_FEEDBACK_METHOD_FREQUENCY_FIXED,
   AUDIO_FEEDBACK_METHOD_FREQUENCY_FLOAT,
   AUDIO_FEEDBACK_METHOD_FREQUENCY_POWER_OF_2, // For driver internal use only
-  AUDIO_FEEDBACK_METHOD_FIFO_COUNT
+  AUDIO_FEEDBACK_METHOD_FIFO_COUNT,
+  AUDIO_FEEDBACK_METHOD_FIFO_PI
 };
 
 typedef struct {
@@ -537,9 +682,30 @@ typedef struct {
       uint32_t mclk_freq; // Main clock frequency in Hz i.e. master clock to which sample clock is based on
     }frequency;
 
+    struct {
+      uint32_t mclk_freq;     // Main clock frequency in Hz counted by tud_audio_feedback_update(), 0 to use nominal rate as estimate
+      uint16_t bandwidth_mhz; // Control loop bandwidth in mHz, rounded to a power of 2 of the update rate. 0 for default of 1 Hz
+      uint8_t slot_size;      // Bytes per audio slot in FIFO i.e. channels x subslot size. 0 to use the decoding format (support FIFO 0)
+    }fifo_pi;
   };
 }audio_feedback_params_t;
 
+// Controller state of AUDIO_FEEDBACK_METHOD_FIFO_PI
+typedef struct {
+  uint32_t value;        // Feedback value in 16.16 format
+  uint32_t base_value;   // Rate estimate in 16.16 format, nominal or measured from main clock
+  int32_t  p_term;       // Proportional correction in 16.16 format
+  int32_t  i_term;       // Integral correction in 16.16 format
+  uint16_t fifo_lvl;     // Filtered FIFO level in bytes
+  uint16_t fifo_lvl_thr; // FIFO level target in bytes
+  uint16_t fifo_lvl_min; // Lowest FIFO level since last clear
+  uint16_t fifo_lvl_max; // Highest FIFO level since last clear
+  uint32_t clamp_count;  // Number of updates limited to min/max value since last clear
+}audio_feedback_pi_stats_t;
+
+// Get state of AUDIO_FEEDBACK_METHOD_FIFO_PI controller, min/max level and clamp count are reset if clear is true
+bool tud_audio_n_fb_pi_stats(uint8_t func_id, audio_feedback_pi_stats_t* stats, bool clear);
+
 // Invoked when needed to set feedback parameters
 void tud_audio_feedback_params_cb(uint8_t func_id, uint8_t alt_itf, audio_feedback_params_t* feedback_param);
 
@@ -558,6 +724,32 @@ bool tud_audio_feedback_format_correction_cb(uint8_t func_id);
 void tud_audio_int_done_cb(uint8_t rhport);
 #endif
 
+#if CFG_TUD_AUDIO_ENABLE_STATS
+// Invoked in SOF ISR to timestamp SOFs for jitter statistics, returns a free running counter e.g. CPU cycle counter.
+// Not measured if not implemented
+TU_ATTR_FAST_FUNC uint32_t tud_audio_stats_timestamp_cb(void);
+#endif
+
+#if CFG_TUD_AUDIO_ENABLE_CONVERSION
+// Unity gain of conversion, gain is unsigned Q1.15 i.e. up to +6 dB
+#define AUDIO_CONV_GAIN_UNITY  0x8000u
+
+typedef struct {
+  uint8_t n_bytes_per_sample; // sample size in support FIFOs: 2, 3 (packed) or 4. 0 keeps EP format, no conversion
+  uint8_t n_bits_right;       // 0: samples are left justified i.e. MSB aligned (e.g. I2S 24-bit in 32-bit slot),
+                              // otherwise right justified and sign extended with this many valid bits (e.g. 24 in 32)
+  bool    apply_gain;         // multiply samples by gain set with tud_audio_n_set_gain()
+} audio_conv_params_t;
+
+// Invoked when an alternate setting with data EP is set, to get the format of samples in support FIFOs.
+// EP samples are left justified in bSubslotSize bytes. Without implementation the EP format is kept
+void tud_audio_conv_params_cb(uint8_t func_id, uint8_t alt_itf, uint8_t ep_addr, audio_conv_params_t* conv_param);
+
+// Convert volume of a feature unit's volume control (1/256 dB, 0x8000 is -inf) to gain for tud_audio_n_set_gain(),
+// saturated to the maximum gain
+uint16_t tud_audio_volume_to_gain(int16_t volume);
+#endif
+
 // Invoked when audio set interface request received
 bool tud_audio_set_itf_cb(uint8_t rhport, tusb_control_request_t const * p_request);
 
@@ -650,6 +842,16 @@ static inline uint16_t tud_audio_write(const void * data, uint16_t len)
   return tud_audio_n_write(0, data, len);
 }
 
+static inline uint16_t tud_audio_write_reserve(void ** buffer, uint16_t len)
+{
+  return tud_audio_n_write_reserve(0, buffer, len);
+}
+
+static inline void tud_audio_write_commit(uint16_t len)
+{
+  tud_audio_n_write_commit(0, len);
+}
+
 static inline bool tud_audio_clear_ep_in_ff(void)
 {
   return tud_audio_n_clear_ep_in_ff(0);
@@ -693,6 +895,27 @@ static inline bool tud_audio_int_write(const audio_interrupt_data_t * data)
 }
 #endif
 
+#if CFG_TUD_AUDIO_ENABLE_CONVERSION
+static inline bool tud_audio_set_gain(uint8_t ep_dir, uint8_t channel, uint16_t gain)
+{
+  return tud_audio_n_set_gain(0, ep_dir, channel, gain);
+}
+#endif
+
+#if CFG_TUD_AUDIO_ENABLE_RESAMPLER
+static inline bool tud_audio_resampler_enable(uint8_t ep_dir, bool enable)
+{
+  return tud_audio_n_resampler_enable(0, ep_dir, enable);
+}
+#endif
+
+#if CFG_TUD_AUDIO_ENABLE_STATS
+static inline bool tud_audio_get_stats(audio_stats_t* stats, bool clear)
+{
+  return tud_audio_n_get_stats(0, stats, clear);
+}
+#endif
+
 #if CFG_TUD_AUDIO_ENABLE_EP_OUT && CFG_TUD_AUDIO_ENABLE_FEEDBACK_EP
 
 static inline bool tud_audio_fb_set(uint32_t feedback)
@@ -700,6 +923,11 @@ static inline bool tud_audio_fb_set(uint32_t feedback)
   return tud_audio_n_fb_set(0, feedback);
 }
 
+static inline bool tud_audio_fb_pi_stats(audio_feedback_pi_stats_t* stats, bool clear)
+{
+  return tud_audio_n_fb_pi_stats(0, stats, clear);
+}
+
 #endif
 
 //--------------------------------------------------------------------+
@@ -711,6 +939,7 @@ void     audiod_reset          (uint8_t rhport);
 uint16_t audiod_open           (uint8_t rhport, tusb_desc_interface_t const * itf_desc, uint16_t max_len);
 bool     audiod_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t const * request);
 bool     audiod_xfer_cb        (uint8_t rhport, uint8_t edpt_addr, xfer_result_t result, uint32_t xferred_bytes);
+bool     audiod_xfer_isr       (uint8_t rhport, uint8_t edpt_addr, xfer_result_t result, uint32_t xferred_bytes);
 void     audiod_sof_isr        (uint8_t rhport, uint32_t frame_count);
 
 #ifdef __cplusplus
@@ -0,0 +1,639 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#include "tusb_option.h"
+
+#if (CFG_TUH_ENABLED && CFG_TUH_AUDIO)
+
+#include "host/usbh.h"
+#include "host/usbh_pvt.h"
+
+#include "audio_host.h"
+
+// Level where CFG_TUSB_DEBUG must be at least for this driver is logged
+#ifndef CFG_TUH_AUDIO_LOG_LEVEL
+  #define CFG_TUH_AUDIO_LOG_LEVEL   CFG_TUH_LOG_LEVEL
+#endif
+
+#define TU_LOG_DRV(...)   TU_LOG(CFG_TUH_AUDIO_LOG_LEVEL, __VA_ARGS__)
+
+//--------------------------------------------------------------------+
+// MACRO CONSTANT TYPEDEF
+//--------------------------------------------------------------------+
+
+// Max clock entities and terminals tracked while parsing AudioControl interface
+#define AUDIOH_ENTITY_MAX   8
+
+typedef struct {
+  uint8_t itf_num;
+  uint8_t ep_data;        // isochronous data endpoint
+  uint8_t ep_fb;          // explicit feedback endpoint of asynchronous OUT, 0 if not available
+  uint8_t terminal_id;    // terminal linked to this interface
+  uint8_t clock_id;       // clock source of linked terminal, 0 if unknown
+  uint8_t interval;       // data packet interval in (micro)frames
+
+  uint8_t alt_count;
+  uint8_t alt_cur;        // index into alt[] of started stream
+  bool    streaming;
+  uint8_t xfer_pending;   // isochronous transfers in flight
+  uint8_t xfer_next;      // slot of next transfer to complete, transfers are completed in order
+
+  uint32_t sample_rate;
+  uint32_t spp_q16;       // samples per packet in 16.16, nominal or from feedback
+  uint32_t acc_q16;       // fractional samples accumulator
+
+  tuh_audio_format_t alt[CFG_TUH_AUDIO_ALT_MAX];
+  hcd_iso_packet_t packets[2][CFG_TUH_AUDIO_ISO_PACKETS];
+  hcd_iso_packet_t fb_packet;
+
+  tu_fifo_t ff;
+  uint8_t ff_buf[CFG_TUH_AUDIO_FIFO_SIZE];
+} audioh_stream_t;
+
+typedef struct {
+  uint8_t daddr;
+  uint8_t ac_itf;
+  bool mounted;
+  uint8_t stream_count;
+  audioh_stream_t stream[CFG_TUH_AUDIO_AS_MAX];
+} audioh_interface_t;
+
+typedef struct {
+  TUH_EPBUF_DEF(data, 2 * CFG_TUH_AUDIO_ISO_PACKETS * CFG_TUH_AUDIO_EP_SZ_MAX);
+  TUH_EPBUF_DEF(fb, 4);
+} audioh_stream_epbuf_t;
+
+typedef struct {
+  TUH_EPBUF_DEF(ctrl, 4);
+  audioh_stream_epbuf_t stream[CFG_TUH_AUDIO_AS_MAX];
+} audioh_epbuf_t;
+
+static audioh_interface_t _audioh_itf[CFG_TUH_AUDIO];
+CFG_TUH_MEM_SECTION static audioh_epbuf_t _audioh_epbuf[CFG_TUH_AUDIO];
+
+//--------------------------------------------------------------------+
+// Helper
+//--------------------------------------------------------------------+
+TU_ATTR_ALWAYS_INLINE static inline audioh_interface_t* get_audio_itf(uint8_t daddr, uint8_t idx) {
+  TU_ASSERT(daddr > 0 && idx < CFG_TUH_AUDIO, NULL);
+  audioh_interface_t* p_audio = &_audioh_itf[idx];
+  return (p_audio->daddr == daddr) ? p_audio : NULL;
+}
+
+TU_ATTR_ALWAYS_INLINE static inline audioh_stream_t* get_stream(uint8_t daddr, uint8_t idx, uint8_t stream) {
+  audioh_interface_t* p_audio = get_audio_itf(daddr, idx);
+  return (p_audio && stream < p_audio->stream_count) ? &p_audio->stream[stream] : NULL;
+}
+
+static uint8_t get_idx_by_itf(uint8_t daddr, uint8_t itf_num) {
+  for (uint8_t idx = 0; idx < CFG_TUH_AUDIO; idx++) {
+    audioh_interface_t const* p_audio = &_audioh_itf[idx];
+    if (p_audio->daddr == daddr && p_audio->ac_itf == itf_num) return idx;
+  }
+  return TUSB_INDEX_INVALID_8;
+}
+
+static audioh_interface_t* find_new_itf(void) {
+  for (uint8_t i = 0; i < CFG_TUH_AUDIO; i++) {
+    if (_audioh_itf[i].daddr == 0) return &_audioh_itf[i];
+  }
+  return NULL;
+}
+
+TU_ATTR_ALWAYS_INLINE static inline uint16_t frame_bytes(tuh_audio_format_t const* fmt) {
+  return (uint16_t) (fmt->channels * fmt->subslot_size);
+}
+
+//--------------------------------------------------------------------+
+// Application API
+//--------------------------------------------------------------------+
+bool tuh_audio_mounted(uint8_t daddr, uint8_t idx) {
+  audioh_interface_t* p_audio = get_audio_itf(daddr, idx);
+  TU_VERIFY(p_audio);
+  return p_audio->mounted;
+}
+
+uint8_t tuh_audio_stream_count(uint8_t daddr, uint8_t idx) {
+  audioh_interface_t* p_audio = get_audio_itf(daddr, idx);
+  return p_audio ? p_audio->stream_count : 0;
+}
+
+bool tuh_audio_stream_get_info(uint8_t daddr, uint8_t idx, uint8_t stream, tuh_audio_stream_info_t* info) {
+  audioh_stream_t* s = get_stream(daddr, idx, stream);
+  TU_VERIFY(s && info);
+
+  info->itf_num   = s->itf_num;
+  info->ep_addr   = s->ep_data;
+  info->alt_count = s->alt_count;
+  info->streaming = s->streaming;
+  return true;
+}
+
+bool tuh_audio_stream_get_format(uint8_t daddr, uint8_t idx, uint8_t stream, uint8_t alt_idx, tuh_audio_format_t* format) {
+  audioh_stream_t* s = get_stream(daddr, idx, stream);
+  TU_VERIFY(s && format && alt_idx < s->alt_count);
+  *format = s->alt[alt_idx];
+  return true;
+}
+
+uint16_t tuh_audio_write(uint8_t daddr, uint8_t idx, uint8_t stream, void const* buffer, uint16_t bufsize) {
+  audioh_stream_t* s = get_stream(daddr, idx, stream);
+  TU_VERIFY(s && tu_edpt_dir(s->ep_data) == TUSB_DIR_OUT, 0);
+  return (uint16_t) tu_fifo_write_n(&s->ff, buffer, bufsize);
+}
+
+uint16_t tuh_audio_read(uint8_t daddr, uint8_t idx, uint8_t stream, void* buffer, uint16_t bufsize) {
+  audioh_stream_t* s = get_stream(daddr, idx, stream);
+  TU_VERIFY(s && tu_edpt_dir(s->ep_data) == TUSB_DIR_IN, 0);
+  return (uint16_t) tu_fifo_read_n(&s->ff, buffer, bufsize);
+}
+
+uint16_t tuh_audio_available(uint8_t daddr, uint8_t idx, uint8_t stream) {
+  audioh_stream_t* s = get_stream(daddr, idx, stream);
+  TU_VERIFY(s, 0);
+  return (uint16_t) ((tu_edpt_dir(s->ep_data) == TUSB_DIR_IN) ? tu_fifo_count(&s->ff) : tu_fifo_remaining(&s->ff));
+}
+
+//--------------------------------------------------------------------+
+// Streaming
+//--------------------------------------------------------------------+
+
+// Prepare packets of a transfer slot and submit it
+static bool stream_xfer_submit(uint8_t daddr, uint8_t idx, uint8_t stream, uint8_t slot) {
+  audioh_stream_t* s = &_audioh_itf[idx].stream[stream];
+  tuh_audio_format_t const* fmt = &s->alt[s->alt_cur];
+  uint8_t* buf = _audioh_epbuf[idx].stream[stream].data + slot * CFG_TUH_AUDIO_ISO_PACKETS * CFG_TUH_AUDIO_EP_SZ_MAX;
+  hcd_iso_packet_t* packets = s->packets[slot];
+
+  if (tu_edpt_dir(s->ep_data) == TUSB_DIR_IN) {
+    for (uint8_t i = 0; i < CFG_TUH_AUDIO_ISO_PACKETS; i++) {
+      packets[i].len = fmt->ep_size;
+    }
+  } else {
+    // packet size follows sample rate (or device's feedback), fractional samples are carried over to next packet
+    uint16_t const fbytes = frame_bytes(fmt);
+    uint16_t const max_len = (uint16_t) (fmt->ep_size - fmt->ep_size % fbytes);
+    uint32_t offset = 0;
+    for (uint8_t i = 0; i < CFG_TUH_AUDIO_ISO_PACKETS; i++) {
+      s->acc_q16 += s->spp_q16;
+      uint16_t const len = (uint16_t) tu_min32((s->acc_q16 >> 16) * fbytes, max_len);
+      s->acc_q16 &= 0xFFFFu;
+
+      // FIFO underrun is sent as silence
+      uint16_t const count = (uint16_t) tu_fifo_read_n(&s->ff, buf + offset, len);
+      if (count < len) {
+        tu_memclr(buf + offset + count, (size_t) (len - count));
+      }
+
+      packets[i].len = len;
+      offset += len;
+    }
+  }
+
+  TU_VERIFY(usbh_edpt_iso_xfer(daddr, s->ep_data, buf, packets, CFG_TUH_AUDIO_ISO_PACKETS));
+  s->xfer_pending++;
+  return true;
+}
+
+static bool stream_fb_submit(uint8_t daddr, uint8_t idx, uint8_t stream) {
+  audioh_stream_t* s = &_audioh_itf[idx].stream[stream];
+  s->fb_packet.len = (tuh_speed_get(daddr) == TUSB_SPEED_HIGH) ? 4 : 3;
+  return usbh_edpt_iso_xfer(daddr, s->ep_fb, _audioh_epbuf[idx].stream[stream].fb, &s->fb_packet, 1);
+}
+
+static void stream_kickoff(uint8_t daddr, uint8_t idx, uint8_t stream) {
+  audioh_stream_t* s = &_audioh_itf[idx].stream[stream];
+  bool const is_hs = (tuh_speed_get(daddr) == TUSB_SPEED_HIGH);
+
+  // nominal samples per packet
+  uint32_t const pkt_rate = (is_hs ? 8000u : 1000u) / s->interval;
+  s->spp_q16 = (uint32_t) ((((uint64_t) s->sample_rate) << 16) / pkt_rate);
+  s->acc_q16 = 0;
+  s->xfer_next = 0;
+  tu_fifo_clear(&s->ff);
+
+  s->streaming = true;
+  bool ok = stream_xfer_submit(daddr, idx, stream, 0) && stream_xfer_submit(daddr, idx, stream, 1);
+  if (ok && s->ep_fb) {
+    ok = stream_fb_submit(daddr, idx, stream);
+  }
+  s->streaming = ok;
+
+  TU_LOG_DRV("[%u] Audio stream %u %s at %lu Hz\r\n", daddr, stream, ok ? "started" : "failed", s->sample_rate);
+  if (tuh_audio_stream_started_cb) tuh_audio_stream_started_cb(daddr, idx, stream, ok);
+}
+
+//--------------------------------------------------------------------+
+// Start / Stop
+//--------------------------------------------------------------------+
+enum {
+  STREAM_SET_SAMPLE_RATE,
+  STREAM_SET_INTERFACE,
+  STREAM_KICKOFF
+};
+
+// user_data: idx << 16 | stream << 8 | state
+static void process_stream_start(tuh_xfer_t* xfer) {
+  uint8_t const daddr  = xfer->daddr;
+  uint8_t const idx    = (uint8_t) (xfer->user_data >> 16);
+  uint8_t const stream = (uint8_t) (xfer->user_data >> 8);
+  uint8_t const state  = (uint8_t) xfer->user_data;
+
+  audioh_interface_t* p_audio = get_audio_itf(daddr, idx);
+  TU_VERIFY(p_audio && stream < p_audio->stream_count,);
+  audioh_stream_t* s = &p_audio->stream[stream];
+  uintptr_t const user_data = ((uintptr_t) idx << 16) | ((uintptr_t) stream << 8);
+
+  switch (state) {
+    case STREAM_SET_SAMPLE_RATE:
+      if (s->clock_id) {
+        tusb_control_request_t const request = {
+          .bmRequestType_bit = {
+            .recipient = TUSB_REQ_RCPT_INTERFACE,
+            .type      = TUSB_REQ_TYPE_CLASS,
+            .direction = TUSB_DIR_OUT
+          },
+          .bRequest = AUDIO_CS_REQ_CUR,
+          .wValue   = tu_htole16((uint16_t) (AUDIO_CS_CTRL_SAM_FREQ << 8)),
+          .wIndex   = tu_htole16(tu_u16(s->clock_id, p_audio->ac_itf)),
+          .wLength  = 4
+        };
+
+        uint8_t* ctrl = _audioh_epbuf[idx].ctrl;
+        tu_unaligned_write32(ctrl, tu_htole32(s->sample_rate));
+
+        tuh_xfer_t ctrl_xfer = {
+          .daddr       = daddr,
+          .ep_addr     = 0,
+          .setup       = &request,
+          .buffer      = ctrl,
+          .complete_cb = process_stream_start,
+          .user_data   = user_data | STREAM_SET_INTERFACE
+        };
+
+        if (!tuh_control_xfer(&ctrl_xfer)) {
+          if (tuh_audio_stream_started_cb) tuh_audio_stream_started_cb(daddr, idx, stream, false);
+        }
+        break;
+      }
+      TU_ATTR_FALLTHROUGH;
+
+    case STREAM_SET_INTERFACE:
+      // clock with fixed frequency can stall sample rate request
+      if (xfer->result != XFER_RESULT_SUCCESS && state == STREAM_SET_INTERFACE) {
+        TU_LOG_DRV("[%u] Audio clock %u does not accept %lu Hz\r\n", daddr, s->clock_id, s->sample_rate);
+      }
+
+      if (!tuh_interface_set(daddr, s->itf_num, s->alt[s->alt_cur].alt, process_stream_start, user_data | STREAM_KICKOFF)) {
+        if (tuh_audio_stream_started_cb) tuh_audio_stream_started_cb(daddr, idx, stream, false);
+      }
+      break;
+
+    case STREAM_KICKOFF:
+      if (xfer->result == XFER_RESULT_SUCCESS) {
+        stream_kickoff(daddr, idx, stream);
+      } else if (tuh_audio_stream_started_cb) {
+        tuh_audio_stream_started_cb(daddr, idx, stream, false);
+      }
+      break;
+
+    default: break;
+  }
+}
+
+bool tuh_audio_stream_start(uint8_t daddr, uint8_t idx, uint8_t stream, uint8_t alt_idx, uint32_t sample_rate) {
+  audioh_stream_t* s = get_stream(daddr, idx, stream);
+  TU_VERIFY(s && alt_idx < s->alt_count && sample_rate);
+
+  // previous transfers must be drained first
+  TU_VERIFY(!s->streaming && s->xfer_pending == 0);
+  TU_ASSERT(s->alt[alt_idx].ep_size <= CFG_TUH_AUDIO_EP_SZ_MAX);
+
+  s->alt_cur = alt_idx;
+  s->sample_rate = sample_rate;
+
+  // fake request to kick-off the start process
+  tuh_xfer_t xfer;
+  xfer.daddr = daddr;
+  xfer.result = XFER_RESULT_SUCCESS;
+  xfer.user_data = ((uintptr_t) idx << 16) | ((uintptr_t) stream << 8) | STREAM_SET_SAMPLE_RATE;
+  process_stream_start(&xfer);
+
+  return true;
+}
+
+bool tuh_audio_stream_stop(uint8_t daddr, uint8_t idx, uint8_t stream) {
+  audioh_stream_t* s = get_stream(daddr, idx, stream);
+  TU_VERIFY(s && s->streaming);
+
+  // transfers are not re-submitted, device stops streaming in zero-bandwidth alternate setting
+  s->streaming = false;
+  return tuh_interface_set(daddr, s->itf_num, 0, NULL, 0);
+}
+
+//--------------------------------------------------------------------+
+// USBH API
+//--------------------------------------------------------------------+
+bool audioh_init(void) {
+  TU_LOG_DRV("sizeof(audioh_interface_t) = %u\r\n", sizeof(audioh_interface_t));
+  tu_memclr(_audioh_itf, sizeof(_audioh_itf));
+  return true;
+}
+
+bool audioh_deinit(void) {
+  return true;
+}
+
+bool audioh_xfer_cb(uint8_t daddr, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes) {
+  for (uint8_t idx = 0; idx < CFG_TUH_AUDIO; idx++) {
+    audioh_interface_t* p_audio = &_audioh_itf[idx];
+    if (p_audio->daddr != daddr) continue;
+
+    for (uint8_t stream = 0; stream < p_audio->stream_count; stream++) {
+      audioh_stream_t* s = &p_audio->stream[stream];
+
+      if (ep_addr == s->ep_fb && s->ep_fb) {
+        // feedback is samples per (micro)frame: 10.14 in full speed, 16.16 in high speed
+        if (result == XFER_RESULT_SUCCESS && xferred_bytes >= 3) {
+          uint8_t const* fb = _audioh_epbuf[idx].stream[stream].fb;
+          uint32_t value = (xferred_bytes >= 4) ? tu_unaligned_read32(fb) : (tu_unaligned_read32(fb) & 0xFFFFFFu) << 2;
+          value = tu_le32toh(value);
+          if (value) {
+            s->spp_q16 = value * s->interval;
+          }
+        }
+        if (s->streaming) {
+          (void) stream_fb_submit(daddr, idx, stream);
+        }
+        return true;
+      }
+
+      if (ep_addr == s->ep_data) {
+        uint8_t const slot = s->xfer_next;
+        s->xfer_next ^= 1u;
+        if (s->xfer_pending) s->xfer_pending--;
+
+        if (tu_edpt_dir(ep_addr) == TUSB_DIR_IN) {
+          uint8_t const* buf = _audioh_epbuf[idx].stream[stream].data +
+                               slot * CFG_TUH_AUDIO_ISO_PACKETS * CFG_TUH_AUDIO_EP_SZ_MAX;
+          hcd_iso_packet_t const* packets = s->packets[slot];
+          for (uint8_t i = 0; i < CFG_TUH_AUDIO_ISO_PACKETS; i++) {
+            if (packets[i].result == XFER_RESULT_SUCCESS && packets[i].actual_len) {
+              (void) tu_fifo_write_n(&s->ff, buf, packets[i].actual_len);
+            }
+            buf += packets[i].len;
+          }
+          if (tuh_audio_rx_cb) tuh_audio_rx_cb(daddr, idx, stream, (uint16_t) xferred_bytes);
+        } else {
+          if (tuh_audio_tx_cb) tuh_audio_tx_cb(daddr, idx, stream);
+        }
+
+        // keep 2 transfers in flight for continuous streaming
+        if (s->streaming) {
+          (void) stream_xfer_submit(daddr, idx, stream, slot);
+        }
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+void audioh_close(uint8_t daddr) {
+  for (uint8_t i = 0; i < CFG_TUH_AUDIO; i++) {
+    audioh_interface_t* p_audio = &_audioh_itf[i];
+    if (p_audio->daddr == daddr) {
+      TU_LOG_DRV("  AUDIOh close addr = %u index = %u\r\n", daddr, i);
+      if (p_audio->mounted && tuh_audio_umount_cb) tuh_audio_umount_cb(daddr, i);
+      tu_memclr(p_audio, sizeof(audioh_interface_t));
+    }
+  }
+}
+
+//--------------------------------------------------------------------+
+// Enumeration
+//--------------------------------------------------------------------+
+
+// Follow clock selector/multiplier to its clock source
+static uint8_t clock_source_resolve(uint8_t const (*clock_map)[2], uint8_t count, uint8_t clock_id) {
+  for (uint8_t depth = 0; depth < AUDIOH_ENTITY_MAX; depth++) {
+    uint8_t i = 0;
+    while (i < count && clock_map[i][0] != clock_id) i++;
+    if (i == count || clock_map[i][1] == 0) return clock_id; // clock source (or unknown)
+    clock_id = clock_map[i][1];
+  }
+  return clock_id;
+}
+
+bool audioh_open(uint8_t rhport, uint8_t daddr, tusb_desc_interface_t const* desc_itf, uint16_t max_len) {
+  (void) rhport;
+
+  // UAC2 only
+  TU_VERIFY(TUSB_CLASS_AUDIO == desc_itf->bInterfaceClass &&
+            AUDIO_SUBCLASS_CONTROL == desc_itf->bInterfaceSubClass &&
+            AUDIO_FUNC_PROTOCOL_CODE_V2 == desc_itf->bInterfaceProtocol);
+  TU_LOG_DRV("[%u] AUDIO opening Interface %u\r\n", daddr, desc_itf->bInterfaceNumber);
+
+  audioh_interface_t* p_audio = find_new_itf();
+  TU_ASSERT(p_audio); // not enough interface, try to increase CFG_TUH_AUDIO
+  tu_memclr(p_audio, sizeof(audioh_interface_t));
+
+  // entity maps: terminal id -> clock id, clock selector/multiplier id -> its input clock id (0 if clock source)
+  uint8_t term_map[AUDIOH_ENTITY_MAX][2];
+  uint8_t clock_map[AUDIOH_ENTITY_MAX][2];
+  uint8_t term_count = 0;
+  uint8_t clock_count = 0;
+
+  // data/feedback endpoint of each stream is opened once with largest packet size among alternate settings
+  tusb_desc_endpoint_t ep_data_desc[CFG_TUH_AUDIO_AS_MAX];
+  tusb_desc_endpoint_t ep_fb_desc[CFG_TUH_AUDIO_AS_MAX];
+  tu_memclr(ep_data_desc, sizeof(ep_data_desc));
+  tu_memclr(ep_fb_desc, sizeof(ep_fb_desc));
+
+  uint8_t const* p_desc = (uint8_t const*) desc_itf;
+  uint8_t const* desc_end = p_desc + max_len;
+  tusb_desc_interface_t const* cur_itf = desc_itf;
+  audioh_stream_t* s = NULL;
+  tuh_audio_format_t* fmt = NULL;
+
+  while (p_desc < desc_end && tu_desc_len(p_desc)) {
+    switch (tu_desc_type(p_desc)) {
+      case TUSB_DESC_INTERFACE:
+        cur_itf = (tusb_desc_interface_t const*) p_desc;
+        s = NULL;
+        fmt = NULL;
+        if (TUSB_CLASS_AUDIO == cur_itf->bInterfaceClass && AUDIO_SUBCLASS_STREAMING == cur_itf->bInterfaceSubClass) {
+          // find or add stream
+          for (uint8_t i = 0; i < p_audio->stream_count; i++) {
+            if (p_audio->stream[i].itf_num == cur_itf->bInterfaceNumber) s = &p_audio->stream[i];
+          }
+          if (s == NULL && p_audio->stream_count < CFG_TUH_AUDIO_AS_MAX) {
+            s = &p_audio->stream[p_audio->stream_count++];
+            s->itf_num = cur_itf->bInterfaceNumber;
+          }
+          if (s && cur_itf->bAlternateSetting != 0 && cur_itf->bNumEndpoints && s->alt_count < CFG_TUH_AUDIO_ALT_MAX) {
+            fmt = &s->alt[s->alt_count++];
+            fmt->alt = cur_itf->bAlternateSetting;
+          }
+        }
+        break;
+
+      case TUSB_DESC_CS_INTERFACE:
+        if (cur_itf->bInterfaceSubClass == AUDIO_SUBCLASS_CONTROL) {
+          uint8_t const subtype = p_desc[2];
+          if (subtype == AUDIO_CS_AC_INTERFACE_INPUT_TERMINAL && term_count < AUDIOH_ENTITY_MAX) {
+            audio_desc_input_terminal_t const* it = (audio_desc_input_terminal_t const*) p_desc;
+            term_map[term_count][0] = it->bTerminalID;
+            term_map[term_count][1] = it->bCSourceID;
+            term_count++;
+          } else if (subtype == AUDIO_CS_AC_INTERFACE_OUTPUT_TERMINAL && term_count < AUDIOH_ENTITY_MAX) {
+            audio_desc_output_terminal_t const* ot = (audio_desc_output_terminal_t const*) p_desc;
+            term_map[term_count][0] = ot->bTerminalID;
+            term_map[term_count][1] = ot->bCSourceID;
+            term_count++;
+          } else if (subtype == AUDIO_CS_AC_INTERFACE_CLOCK_SOURCE && clock_count < AUDIOH_ENTITY_MAX) {
+            clock_map[clock_count][0] = ((audio_desc_clock_source_t const*) p_desc)->bClockID;
+            clock_map[clock_count][1] = 0;
+            clock_count++;
+          } else if (subtype == AUDIO_CS_AC_INTERFACE_CLOCK_SELECTOR && clock_count < AUDIOH_ENTITY_MAX) {
+            // follow first input pin, selector is left at its default
+            audio_desc_clock_selector_t const* cs = (audio_desc_clock_selector_t const*) p_desc;
+            clock_map[clock_count][0] = cs->bClockID;
+            clock_map[clock_count][1] = cs->baCSourceID;
+            clock_count++;
+          } else if (subtype == AUDIO_CS_AC_INTERFACE_CLOCK_MULTIPLIER && clock_count < AUDIOH_ENTITY_MAX) {
+            audio_desc_clock_multiplier_t const* cm = (audio_desc_clock_multiplier_t const*) p_desc;
+            clock_map[clock_count][0] = cm->bClockID;
+            clock_map[clock_count][1] = cm->bCSourceID;
+            clock_count++;
+          }
+        } else if (fmt) {
+          uint8_t const subtype = p_desc[2];
+          if (subtype == AUDIO_CS_AS_INTERFACE_AS_GENERAL) {
+            audio_desc_cs_as_interface_t const* as = (audio_desc_cs_as_interface_t const*) p_desc;
+            s->terminal_id = as->bTerminalLink;
+            fmt->channels = as->bNrChannels;
+          } else if (subtype == AUDIO_CS_AS_INTERFACE_FORMAT_TYPE) {
+            audio_desc_type_I_format_t const* format = (audio_desc_type_I_format_t const*) p_desc;
+            if (format->bFormatType == AUDIO_FORMAT_TYPE_I) {
+              fmt->subslot_size = format->bSubslotSize;
+              fmt->bit_resolution = format->bBitResolution;
+            }
+          }
+        }
+        break;
+
+      case TUSB_DESC_ENDPOINT:
+        if (fmt) {
+          tusb_desc_endpoint_t const* desc_ep = (tusb_desc_endpoint_t const*) p_desc;
+          uint8_t const stream = (uint8_t) (s - p_audio->stream);
+          if (desc_ep->bmAttributes.xfer == TUSB_XFER_ISOCHRONOUS) {
+            tusb_desc_endpoint_t* ep_desc = (desc_ep->bmAttributes.usage == 1) ? &ep_fb_desc[stream] : &ep_data_desc[stream];
+            if (ep_desc->bLength == 0 || tu_edpt_packet_size(desc_ep) > tu_edpt_packet_size(ep_desc)) {
+              *ep_desc = *desc_ep;
+            }
+            if (desc_ep->bmAttributes.usage != 1) {
+              fmt->ep_size = tu_edpt_packet_size(desc_ep);
+            }
+          }
+        }
+        break;
+
+      default: break;
+    }
+
+    p_desc = tu_desc_next(p_desc);
+  }
+
+  // drop streams without operational alternate setting e.g non-audio or unsupported format
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < p_audio->stream_count; i++) {
+    audioh_stream_t* st = &p_audio->stream[i];
+    if (st->alt_count == 0 || ep_data_desc[i].bLength == 0) continue;
+
+    tusb_desc_endpoint_t const* desc_data = &ep_data_desc[i];
+    tusb_desc_endpoint_t const* desc_fb = &ep_fb_desc[i];
+    TU_ASSERT(tuh_edpt_open(daddr, desc_data));
+    st->ep_data = desc_data->bEndpointAddress;
+    st->interval = (uint8_t) (1u << (tu_min8(tu_max8(desc_data->bInterval, 1), 4) - 1));
+
+    // feedback is optional, stream runs at nominal rate if it cannot be opened
+    if (desc_fb->bLength && tu_edpt_dir(st->ep_data) == TUSB_DIR_OUT && tuh_edpt_open(daddr, desc_fb)) {
+      st->ep_fb = desc_fb->bEndpointAddress;
+    }
+
+    // clock of linked terminal
+    for (uint8_t t = 0; t < term_count; t++) {
+      if (term_map[t][0] == st->terminal_id) {
+        st->clock_id = clock_source_resolve((uint8_t const (*)[2]) clock_map, clock_count, term_map[t][1]);
+      }
+    }
+
+    tu_fifo_config(&st->ff, st->ff_buf, CFG_TUH_AUDIO_FIFO_SIZE, 1, false);
+
+    if (count != i) {
+      p_audio->stream[count] = *st;
+      tu_fifo_config(&p_audio->stream[count].ff, p_audio->stream[count].ff_buf, CFG_TUH_AUDIO_FIFO_SIZE, 1, false);
+    }
+    count++;
+  }
+  p_audio->stream_count = count;
+
+  if (count == 0) {
+    tu_memclr(p_audio, sizeof(audioh_interface_t));
+    return false;
+  }
+
+  p_audio->daddr = daddr;
+  p_audio->ac_itf = desc_itf->bInterfaceNumber;
+
+  return true;
+}
+
+//--------------------------------------------------------------------+
+// Set Configure
+//--------------------------------------------------------------------+
+bool audioh_set_config(uint8_t daddr, uint8_t itf_num) {
+  uint8_t const idx = get_idx_by_itf(daddr, itf_num);
+  audioh_interface_t* p_audio = get_audio_itf(daddr, idx);
+  TU_VERIFY(p_audio);
+  p_audio->mounted = true;
+
+  // enumeration is complete
+  if (tuh_audio_mount_cb) tuh_audio_mount_cb(daddr, idx);
+
+  // notify usbh that driver enumeration is complete, skip all associated streaming interfaces
+  uint8_t last_itf = itf_num;
+  for (uint8_t i = 0; i < p_audio->stream_count; i++) {
+    last_itf = tu_max8(last_itf, p_audio->stream[i].itf_num);
+  }
+  usbh_driver_set_config_complete(daddr, last_itf);
+
+  return true;
+}
+
+#endif
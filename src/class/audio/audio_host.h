@@ -0,0 +1,146 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#ifndef _TUSB_AUDIO_HOST_H_
+#define _TUSB_AUDIO_HOST_H_
+
+#include "audio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//--------------------------------------------------------------------+
+// Class Driver Configuration
+//--------------------------------------------------------------------+
+
+// Max AudioStreaming interfaces per audio function
+#ifndef CFG_TUH_AUDIO_AS_MAX
+#define CFG_TUH_AUDIO_AS_MAX 2
+#endif
+
+// Max operational alternate settings (excluding zero-bandwidth alt 0) per AudioStreaming interface
+#ifndef CFG_TUH_AUDIO_ALT_MAX
+#define CFG_TUH_AUDIO_ALT_MAX 4
+#endif
+
+// Number of isochronous packets per transfer, 2 transfers are queued per stream
+#ifndef CFG_TUH_AUDIO_ISO_PACKETS
+#define CFG_TUH_AUDIO_ISO_PACKETS 4
+#endif
+
+// Largest isochronous data packet size supported
+#ifndef CFG_TUH_AUDIO_EP_SZ_MAX
+#define CFG_TUH_AUDIO_EP_SZ_MAX 256
+#endif
+
+// Software FIFO size in bytes per stream, between application and isochronous transfers
+#ifndef CFG_TUH_AUDIO_FIFO_SIZE
+#define CFG_TUH_AUDIO_FIFO_SIZE (4 * CFG_TUH_AUDIO_ISO_PACKETS * CFG_TUH_AUDIO_EP_SZ_MAX)
+#endif
+
+// Stream format of an operational alternate setting
+typedef struct {
+  uint8_t  alt;            // bAlternateSetting
+  uint8_t  channels;       // bNrChannels
+  uint8_t  subslot_size;   // bytes per sample
+  uint8_t  bit_resolution; // used bits per sample
+  uint16_t ep_size;        // wMaxPacketSize of data endpoint
+} tuh_audio_format_t;
+
+typedef struct {
+  uint8_t itf_num;    // AudioStreaming interface number
+  uint8_t ep_addr;    // data endpoint: OUT is speaker, IN is microphone
+  uint8_t alt_count;  // number of operational alternate settings
+  bool    streaming;
+} tuh_audio_stream_info_t;
+
+//--------------------------------------------------------------------+
+// Application API
+//--------------------------------------------------------------------+
+
+// Check if audio function is mounted
+bool tuh_audio_mounted(uint8_t daddr, uint8_t idx);
+
+// Get number of AudioStreaming interfaces of an audio function
+uint8_t tuh_audio_stream_count(uint8_t daddr, uint8_t idx);
+
+// Get AudioStreaming interface information
+bool tuh_audio_stream_get_info(uint8_t daddr, uint8_t idx, uint8_t stream, tuh_audio_stream_info_t* info);
+
+// Get format of an operational alternate setting, alt_idx is from 0 to alt_count-1
+bool tuh_audio_stream_get_format(uint8_t daddr, uint8_t idx, uint8_t stream, uint8_t alt_idx, tuh_audio_format_t* format);
+
+// Start streaming: set sample rate of the stream's clock source (if any), select alternate setting and continuously
+// schedule isochronous transfers. tuh_audio_stream_started_cb() is invoked when done.
+bool tuh_audio_stream_start(uint8_t daddr, uint8_t idx, uint8_t stream, uint8_t alt_idx, uint32_t sample_rate);
+
+// Stop streaming: in-flight transfers are let to complete then zero-bandwidth alternate setting is selected
+bool tuh_audio_stream_stop(uint8_t daddr, uint8_t idx, uint8_t stream);
+
+// Write samples to OUT (speaker) stream, return number of bytes written
+uint16_t tuh_audio_write(uint8_t daddr, uint8_t idx, uint8_t stream, void const* buffer, uint16_t bufsize);
+
+// Read samples from IN (microphone) stream, return number of bytes read
+uint16_t tuh_audio_read(uint8_t daddr, uint8_t idx, uint8_t stream, void* buffer, uint16_t bufsize);
+
+// Bytes available in stream FIFO: to read for IN stream, free space to write for OUT stream
+uint16_t tuh_audio_available(uint8_t daddr, uint8_t idx, uint8_t stream);
+
+//--------------------------------------------------------------------+
+// Callbacks (Weak is optional)
+//--------------------------------------------------------------------+
+
+// Invoked when audio function is mounted
+TU_ATTR_WEAK void tuh_audio_mount_cb(uint8_t daddr, uint8_t idx);
+
+// Invoked when audio function is unmounted
+TU_ATTR_WEAK void tuh_audio_umount_cb(uint8_t daddr, uint8_t idx);
+
+// Invoked when tuh_audio_stream_start() is complete
+TU_ATTR_WEAK void tuh_audio_stream_started_cb(uint8_t daddr, uint8_t idx, uint8_t stream, bool success);
+
+// Invoked when an isochronous transfer of IN stream is received and its data is written to stream FIFO
+TU_ATTR_WEAK void tuh_audio_rx_cb(uint8_t daddr, uint8_t idx, uint8_t stream, uint16_t xferred_bytes);
+
+// Invoked when an isochronous transfer of OUT stream is sent, application can write more data
+TU_ATTR_WEAK void tuh_audio_tx_cb(uint8_t daddr, uint8_t idx, uint8_t stream);
+
+//--------------------------------------------------------------------+
+// Internal Class Driver API
+//--------------------------------------------------------------------+
+bool audioh_init(void);
+bool audioh_deinit(void);
+bool audioh_open(uint8_t rhport, uint8_t daddr, tusb_desc_interface_t const* desc_itf, uint16_t max_len);
+bool audioh_set_config(uint8_t daddr, uint8_t itf_num);
+bool audioh_xfer_cb(uint8_t daddr, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes);
+void audioh_close(uint8_t daddr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _TUSB_AUDIO_HOST_H_ */
@@ -38,21 +38,54 @@
 // MACRO CONSTANT TYPEDEF
 //--------------------------------------------------------------------+
 typedef struct {
+  uint8_t *data;
+  uint16_t len;
+} btd_tx_pkt_t;
+
+// TX queue of application packets (not copied), packet in flight is kept for sent callback
+typedef struct {
+  tu_fifo_t ff;
+  btd_tx_pkt_t inflight;
+  bool zlp_needed;   // ACL packet ended on packet boundary, ZLP goes before next packet
+  bool zlp_inflight;
+} btd_txq_t;
+
+typedef struct {
+  uint8_t rhport;
   uint8_t itf_num;
   uint8_t ep_ev;
   uint8_t ep_acl_in;
   uint16_t ep_acl_in_pkt_sz;
   uint8_t ep_acl_out;
-  uint8_t ep_voice[2];  // Not used yet
+  uint8_t ep_voice[2];
   uint8_t ep_voice_size[2][CFG_TUD_BTH_ISO_ALT_COUNT];
-
-  // Previous amount of bytes sent when issuing ZLP
-  uint32_t prev_xferred_bytes;
+  uint8_t iso_alt;
+
+  btd_txq_t ev_q;
+  btd_txq_t acl_q;
+
+  #if CFG_TUD_BTH_ACL_RX_DEPTH
+  // received ACL ring: free-running counters, written by xfer_cb and read by application
+  volatile uint8_t acl_rx_wr;
+  volatile uint8_t acl_rx_rd;
+  bool acl_rx_full; // last packet filled its buffer: a following ZLP terminates it
+  uint16_t acl_rx_len[CFG_TUD_BTH_ACL_RX_DEPTH];
+  #endif
 } btd_interface_t;
 
 typedef struct {
-  TUD_EPBUF_DEF(epout_buf, CFG_TUD_BTH_DATA_EPSIZE);
   TUD_EPBUF_TYPE_DEF(bt_hci_cmd_t, hci_cmd);
+  #if CFG_TUD_BTH_ACL_RX_DEPTH
+  struct {
+    TUD_EPBUF_DEF(buf, CFG_TUD_BTH_ACL_RX_BUFSIZE);
+  } acl_rx[CFG_TUD_BTH_ACL_RX_DEPTH];
+  #else
+  TUD_EPBUF_DEF(epout_buf, CFG_TUD_BTH_DATA_EPSIZE);
+  #endif
+  #if CFG_TUD_BTH_ISO_EPSIZE
+  TUD_EPBUF_DEF(voice_in, CFG_TUD_BTH_ISO_EPSIZE);
+  TUD_EPBUF_DEF(voice_out, CFG_TUD_BTH_ISO_EPSIZE);
+  #endif
 } btd_epbuf_t;
 
 //--------------------------------------------------------------------+
@@ -61,22 +94,92 @@ typedef struct {
 static btd_interface_t _btd_itf;
 CFG_TUD_MEM_SECTION static btd_epbuf_t _btd_epbuf;
 
-static bool bt_tx_data(uint8_t ep, void *data, uint16_t len)
+static btd_tx_pkt_t _btd_ev_q_buf[CFG_TUD_BTH_EVENT_QUEUE_DEPTH];
+static btd_tx_pkt_t _btd_acl_q_buf[CFG_TUD_BTH_ACL_QUEUE_DEPTH];
+
+// Start next queued packet (or pending ZLP) if endpoint is idle
+static void bt_tx_kick(uint8_t rhport, btd_txq_t *q, uint8_t ep)
 {
-  uint8_t const rhport = 0;
+  while (usbd_edpt_claim(rhport, ep)) {
+    if (q->zlp_needed) {
+      q->zlp_needed = false;
+      q->zlp_inflight = true;
+      TU_ASSERT(usbd_edpt_xfer(rhport, ep, NULL, 0), );
+      return;
+    }
 
-  // skip if previous transfer not complete
-  TU_VERIFY(!usbd_edpt_busy(rhport, ep));
+    btd_tx_pkt_t pkt;
+    if (tu_fifo_read(&q->ff, &pkt)) {
+      q->inflight = pkt;
+      if (!usbd_edpt_xfer(rhport, ep, pkt.data, pkt.len)) {
+        usbd_edpt_release(rhport, ep);
+      }
+      return;
+    }
+
+    usbd_edpt_release(rhport, ep);
 
-  TU_ASSERT(usbd_edpt_xfer(rhport, ep, data, len));
+    // packet may be queued while endpoint was claimed here
+    if (tu_fifo_empty(&q->ff)) {
+      return;
+    }
+  }
+}
 
+static bool bt_tx_data(btd_txq_t *q, uint8_t ep, void *data, uint16_t len)
+{
+  uint8_t const rhport = _btd_itf.rhport;
+  TU_VERIFY(ep);
+
+  btd_tx_pkt_t const pkt = { .data = (uint8_t *) data, .len = len };
+  TU_VERIFY(tu_fifo_write(&q->ff, &pkt));
+
+  bt_tx_kick(rhport, q, ep);
   return true;
 }
 
+#if CFG_TUD_BTH_ACL_RX_DEPTH
+TU_ATTR_ALWAYS_INLINE static inline uint8_t acl_rx_count(void) {
+  return (uint8_t) (_btd_itf.acl_rx_wr - _btd_itf.acl_rx_rd);
+}
+
+// receive next ACL packet directly into free slot of the ring, if any
+static void acl_rx_arm(uint8_t rhport)
+{
+  uint8_t const ep = _btd_itf.ep_acl_out;
+  TU_VERIFY(ep && acl_rx_count() < CFG_TUD_BTH_ACL_RX_DEPTH, );
+  TU_VERIFY(usbd_edpt_claim(rhport, ep), );
+
+  // ring can be changed before endpoint is claimed
+  if (acl_rx_count() < CFG_TUD_BTH_ACL_RX_DEPTH) {
+    uint8_t *buf = _btd_epbuf.acl_rx[_btd_itf.acl_rx_wr % CFG_TUD_BTH_ACL_RX_DEPTH].buf;
+    if (usbd_edpt_xfer(rhport, ep, buf, CFG_TUD_BTH_ACL_RX_BUFSIZE)) {
+      return;
+    }
+  }
+  usbd_edpt_release(rhport, ep);
+}
+#endif
+
 //--------------------------------------------------------------------+
 // READ API
 //--------------------------------------------------------------------+
+#if CFG_TUD_BTH_ACL_RX_DEPTH
+uint16_t tud_bt_acl_data_peek(void const **acl_data)
+{
+  TU_VERIFY(acl_rx_count(), 0);
+  uint8_t const slot = _btd_itf.acl_rx_rd % CFG_TUD_BTH_ACL_RX_DEPTH;
+  *acl_data = _btd_epbuf.acl_rx[slot].buf;
+  return _btd_itf.acl_rx_len[slot];
+}
 
+void tud_bt_acl_data_release(void)
+{
+  TU_VERIFY(acl_rx_count(), );
+  _btd_itf.acl_rx_rd++;
+  acl_rx_arm(_btd_itf.rhport);
+}
+#endif
 
 //--------------------------------------------------------------------+
 // WRITE API
@@ -84,19 +187,90 @@ static bool bt_tx_data(uint8_t ep, void *data, uint16_t len)
 
 bool tud_bt_event_send(void *event, uint16_t event_len)
 {
-  return bt_tx_data(_btd_itf.ep_ev, event, event_len);
+  return bt_tx_data(&_btd_itf.ev_q, _btd_itf.ep_ev, event, event_len);
 }
 
 bool tud_bt_acl_data_send(void *event, uint16_t event_len)
 {
-  return bt_tx_data(_btd_itf.ep_acl_in, event, event_len);
+  return bt_tx_data(&_btd_itf.acl_q, _btd_itf.ep_acl_in, event, event_len);
+}
+
+//--------------------------------------------------------------------+
+// SCO API
+//--------------------------------------------------------------------+
+#if CFG_TUD_BTH_ISO_EPSIZE
+uint8_t tud_bt_sco_alt(void)
+{
+  return _btd_itf.iso_alt;
+}
+
+bool tud_bt_sco_data_send(void const *sco_data, uint16_t data_len)
+{
+  uint8_t const rhport = _btd_itf.rhport;
+  uint8_t const ep = _btd_itf.ep_voice[TUSB_DIR_IN];
+  TU_VERIFY(_btd_itf.iso_alt && data_len <= _btd_itf.ep_voice_size[TUSB_DIR_IN][_btd_itf.iso_alt]);
+  TU_VERIFY(usbd_edpt_claim(rhport, ep));
+
+  memcpy(_btd_epbuf.voice_in, sco_data, data_len);
+  if (!usbd_edpt_xfer(rhport, ep, _btd_epbuf.voice_in, data_len)) {
+    usbd_edpt_release(rhport, ep);
+    return false;
+  }
+  return true;
 }
 
+// Open ISO endpoints with packet size of alternate setting, alt 0 closes them
+static bool sco_set_alt(uint8_t rhport, uint8_t alt)
+{
+  TU_VERIFY(alt < CFG_TUD_BTH_ISO_ALT_COUNT);
+
+#ifndef TUP_DCD_EDPT_ISO_ALLOC
+  if (_btd_itf.iso_alt) {
+    usbd_edpt_close(rhport, _btd_itf.ep_voice[TUSB_DIR_IN]);
+    usbd_edpt_close(rhport, _btd_itf.ep_voice[TUSB_DIR_OUT]);
+  }
+#endif
+  _btd_itf.iso_alt = 0;
+
+  if (alt) {
+    for (uint8_t dir = 0; dir < 2; dir++) {
+      uint8_t const size = _btd_itf.ep_voice_size[dir][alt];
+      TU_ASSERT(size <= CFG_TUD_BTH_ISO_EPSIZE);
+      tusb_desc_endpoint_t const desc_ep = {
+        .bLength          = sizeof(tusb_desc_endpoint_t),
+        .bDescriptorType  = TUSB_DESC_ENDPOINT,
+        .bEndpointAddress = _btd_itf.ep_voice[dir],
+        .bmAttributes     = { .xfer = TUSB_XFER_ISOCHRONOUS },
+        .wMaxPacketSize   = size,
+        .bInterval        = 1
+      };
+#ifdef TUP_DCD_EDPT_ISO_ALLOC
+      TU_ASSERT(usbd_edpt_iso_activate(rhport, &desc_ep));
+#else
+      TU_ASSERT(usbd_edpt_open(rhport, &desc_ep));
+#endif
+    }
+    _btd_itf.iso_alt = alt;
+
+    // Prepare for incoming voice data
+    TU_ASSERT(usbd_edpt_xfer(rhport, _btd_itf.ep_voice[TUSB_DIR_OUT], _btd_epbuf.voice_out,
+                             _btd_itf.ep_voice_size[TUSB_DIR_OUT][alt]));
+  }
+
+  if (tud_bt_sco_alt_cb) {
+    tud_bt_sco_alt_cb(alt);
+  }
+  return true;
+}
+#endif
+
 //--------------------------------------------------------------------+
 // USBD Driver API
 //--------------------------------------------------------------------+
 void btd_init(void) {
   tu_memclr(&_btd_itf, sizeof(_btd_itf));
+  tu_fifo_config(&_btd_itf.ev_q.ff, _btd_ev_q_buf, CFG_TUD_BTH_EVENT_QUEUE_DEPTH, sizeof(btd_tx_pkt_t), false);
+  tu_fifo_config(&_btd_itf.acl_q.ff, _btd_acl_q_buf, CFG_TUD_BTH_ACL_QUEUE_DEPTH, sizeof(btd_tx_pkt_t), false);
 }
 
 bool btd_deinit(void) {
@@ -105,7 +279,16 @@ bool btd_deinit(void) {
 
 void btd_reset(uint8_t rhport)
 {
-  (void)rhport;
+  // keep interface opened on other root port
+  TU_VERIFY(_btd_itf.ep_ev == 0 || _btd_itf.rhport == rhport, );
+  tu_fifo_t const ev_ff = _btd_itf.ev_q.ff;
+  tu_fifo_t const acl_ff = _btd_itf.acl_q.ff;
+
+  tu_memclr(&_btd_itf, sizeof(_btd_itf));
+  _btd_itf.ev_q.ff = ev_ff;
+  _btd_itf.acl_q.ff = acl_ff;
+  tu_fifo_clear(&_btd_itf.ev_q.ff);
+  tu_fifo_clear(&_btd_itf.acl_q.ff);
 }
 
 uint16_t btd_open(uint8_t rhport, tusb_desc_interface_t const *itf_desc, uint16_t max_len)
@@ -123,6 +306,7 @@ uint16_t btd_open(uint8_t rhport, tusb_desc_interface_t const *itf_desc, uint16_
 
   TU_ASSERT(itf_desc->bNumEndpoints == 3 && max_len >= hci_itf_size);
 
+  _btd_itf.rhport = rhport;
   _btd_itf.itf_num = itf_desc->bInterfaceNumber;
 
   desc_ep = (tusb_desc_endpoint_t const *) tu_desc_next(itf_desc);
@@ -152,7 +336,11 @@ uint16_t btd_open(uint8_t rhport, tusb_desc_interface_t const *itf_desc, uint16_
   itf_desc = (tusb_desc_interface_t const *)tu_desc_next(tu_desc_next(desc_ep));
 
   // Prepare for incoming data from host
+#if CFG_TUD_BTH_ACL_RX_DEPTH
+  acl_rx_arm(rhport);
+#else
   TU_ASSERT(usbd_edpt_xfer(rhport, _btd_itf.ep_acl_out, _btd_epbuf.epout_buf, CFG_TUD_BTH_DATA_EPSIZE), 0);
+#endif
 
   drv_len = hci_itf_size;
 
@@ -209,6 +397,12 @@ uint16_t btd_open(uint8_t rhport, tusb_desc_interface_t const *itf_desc, uint16_
     drv_len += iso_alt_itf_size;
   }
 
+#if CFG_TUD_BTH_ISO_EPSIZE && defined(TUP_DCD_EDPT_ISO_ALLOC)
+  // ISO endpoints are activated when host selects an alternate setting
+  TU_ASSERT(usbd_edpt_iso_alloc(rhport, _btd_itf.ep_voice[TUSB_DIR_IN], CFG_TUD_BTH_ISO_EPSIZE), 0);
+  TU_ASSERT(usbd_edpt_iso_alloc(rhport, _btd_itf.ep_voice[TUSB_DIR_OUT], CFG_TUD_BTH_ISO_EPSIZE), 0);
+#endif
+
   return drv_len;
 }
 
@@ -231,9 +425,22 @@ bool btd_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t c
     }
     else if (request->bmRequestType_bit.recipient == TUSB_REQ_RCPT_INTERFACE)
     {
-      if (request->bRequest == TUSB_REQ_SET_INTERFACE && _btd_itf.itf_num + 1 == request->wIndex)
+      if (request->bmRequestType_bit.type == TUSB_REQ_TYPE_STANDARD)
       {
-        // TODO: Set interface it would involve changing size of endpoint size
+#if CFG_TUD_BTH_ISO_EPSIZE
+        TU_VERIFY(_btd_itf.itf_num + 1 == tu_u16_low(request->wIndex));
+        if (request->bRequest == TUSB_REQ_SET_INTERFACE)
+        {
+          TU_VERIFY(sco_set_alt(rhport, (uint8_t) request->wValue));
+          return tud_control_status(rhport, request);
+        }
+        else if (request->bRequest == TUSB_REQ_GET_INTERFACE)
+        {
+          return tud_control_xfer(rhport, request, &_btd_itf.iso_alt, 1);
+        }
+#endif
+        // let usbd handle GET/SET_INTERFACE when SCO streaming is not enabled
+        return false;
       }
       else
       {
@@ -263,32 +470,70 @@ bool btd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result,
   // received new data from host
   if (ep_addr == _btd_itf.ep_acl_out)
   {
-    if (tud_bt_acl_data_received_cb) tud_bt_acl_data_received_cb(_btd_epbuf.epout_buf, xferred_bytes);
+#if CFG_TUD_BTH_ACL_RX_DEPTH
+    if (xferred_bytes == 0 && _btd_itf.acl_rx_full) {
+      // ZLP terminating previous packet of buffer size
+      _btd_itf.acl_rx_full = false;
+    } else {
+      uint8_t const slot = _btd_itf.acl_rx_wr % CFG_TUD_BTH_ACL_RX_DEPTH;
+      _btd_itf.acl_rx_full = (xferred_bytes == CFG_TUD_BTH_ACL_RX_BUFSIZE);
+      _btd_itf.acl_rx_len[slot] = (uint16_t) xferred_bytes;
+      _btd_itf.acl_rx_wr++;
+
+      // re-arm into next free slot first so that host can keep sending
+      acl_rx_arm(rhport);
+
+      if (tud_bt_acl_data_received_cb) tud_bt_acl_data_received_cb(_btd_epbuf.acl_rx[slot].buf, (uint16_t) xferred_bytes);
+      return true;
+    }
+    acl_rx_arm(rhport);
+#else
+    if (tud_bt_acl_data_received_cb) tud_bt_acl_data_received_cb(_btd_epbuf.epout_buf, (uint16_t) xferred_bytes);
 
     // prepare for next data
     TU_ASSERT(usbd_edpt_xfer(rhport, _btd_itf.ep_acl_out, _btd_epbuf.epout_buf, CFG_TUD_BTH_DATA_EPSIZE));
+#endif
   }
   else if (ep_addr == _btd_itf.ep_ev)
   {
     if (tud_bt_event_sent_cb) tud_bt_event_sent_cb((uint16_t)xferred_bytes);
+    bt_tx_kick(rhport, &_btd_itf.ev_q, ep_addr);
   }
   else if (ep_addr == _btd_itf.ep_acl_in)
   {
-    if ((result == XFER_RESULT_SUCCESS) && (xferred_bytes > 0) &&
-        ((xferred_bytes & (_btd_itf.ep_acl_in_pkt_sz - 1)) == 0)) {
-      // Save number of transferred bytes
-      _btd_itf.prev_xferred_bytes = xferred_bytes;
-
-      // Send zero-length packet
-      tud_bt_acl_data_send(NULL, 0);
-    } else if (tud_bt_acl_data_sent_cb) {
-      if (xferred_bytes == 0) {
-        xferred_bytes = _btd_itf.prev_xferred_bytes;
-        _btd_itf.prev_xferred_bytes = 0;
-      }
-      tud_bt_acl_data_sent_cb((uint16_t)xferred_bytes);
+    btd_txq_t *q = &_btd_itf.acl_q;
+    if (q->zlp_inflight) {
+      // ZLP of previous packet is sent
+      q->zlp_inflight = false;
+      xferred_bytes = q->inflight.len;
+    } else if ((result == XFER_RESULT_SUCCESS) && (xferred_bytes > 0) &&
+               ((xferred_bytes & (_btd_itf.ep_acl_in_pkt_sz - 1)) == 0)) {
+      // Send zero-length packet before reporting and sending next packet
+      q->zlp_needed = true;
+      bt_tx_kick(rhport, q, ep_addr);
+      return true;
     }
+
+    if (tud_bt_acl_data_sent_cb) tud_bt_acl_data_sent_cb((uint16_t)xferred_bytes);
+    bt_tx_kick(rhport, q, ep_addr);
   }
+#if CFG_TUD_BTH_ISO_EPSIZE
+  else if (ep_addr == _btd_itf.ep_voice[TUSB_DIR_OUT])
+  {
+    if (result == XFER_RESULT_SUCCESS && tud_bt_sco_data_received_cb) {
+      tud_bt_sco_data_received_cb(_btd_epbuf.voice_out, (uint16_t) xferred_bytes);
+    }
+
+    if (_btd_itf.iso_alt) {
+      TU_ASSERT(usbd_edpt_xfer(rhport, ep_addr, _btd_epbuf.voice_out,
+                               _btd_itf.ep_voice_size[TUSB_DIR_OUT][_btd_itf.iso_alt]));
+    }
+  }
+  else if (ep_addr == _btd_itf.ep_voice[TUSB_DIR_IN])
+  {
+    if (tud_bt_sco_data_sent_cb) tud_bt_sco_data_sent_cb((uint16_t) xferred_bytes);
+  }
+#endif
 
   return true;
 }
@@ -47,6 +47,40 @@
 #define CFG_TUD_BTH_HISTORICAL_COMPATIBLE 0
 #endif
 
+// Number of HCI event packets queued while event endpoint is busy
+#ifndef CFG_TUD_BTH_EVENT_QUEUE_DEPTH
+#define CFG_TUD_BTH_EVENT_QUEUE_DEPTH 4
+#endif
+
+// Number of ACL data packets queued while ACL IN endpoint is busy
+#ifndef CFG_TUD_BTH_ACL_QUEUE_DEPTH
+#define CFG_TUD_BTH_ACL_QUEUE_DEPTH  4
+#endif
+
+// Number of received ACL data packets buffered (power of 2), 0 to deliver each packet with
+// tud_bt_acl_data_received_cb() only. Each slot holds CFG_TUD_BTH_ACL_RX_BUFSIZE bytes, which should fit the
+// largest ACL packet of controller (4-byte header + ACL_Data_Packet_Length) rounded up to CFG_TUD_BTH_DATA_EPSIZE
+#ifndef CFG_TUD_BTH_ACL_RX_DEPTH
+#define CFG_TUD_BTH_ACL_RX_DEPTH     0
+#endif
+
+#ifndef CFG_TUD_BTH_ACL_RX_BUFSIZE
+#define CFG_TUD_BTH_ACL_RX_BUFSIZE   CFG_TUD_BTH_DATA_EPSIZE
+#endif
+
+// Largest packet size of ISO (SCO voice) endpoints among alternate settings, 0 to disable SCO streaming
+#ifndef CFG_TUD_BTH_ISO_EPSIZE
+#define CFG_TUD_BTH_ISO_EPSIZE       0
+#endif
+
+#if CFG_TUD_BTH_EVENT_QUEUE_DEPTH == 0 || CFG_TUD_BTH_ACL_QUEUE_DEPTH == 0
+  #error "CFG_TUD_BTH_EVENT_QUEUE_DEPTH and CFG_TUD_BTH_ACL_QUEUE_DEPTH must be at least 1"
+#endif
+
+#if (CFG_TUD_BTH_ACL_RX_DEPTH & (CFG_TUD_BTH_ACL_RX_DEPTH - 1)) || (CFG_TUD_BTH_ACL_RX_BUFSIZE % CFG_TUD_BTH_DATA_EPSIZE)
+  #error "CFG_TUD_BTH_ACL_RX_DEPTH must be power of 2, CFG_TUD_BTH_ACL_RX_BUFSIZE multiple of CFG_TUD_BTH_DATA_EPSIZE"
+#endif
+
 typedef struct TU_ATTR_PACKED
 {
   uint16_t op_code;
@@ -73,7 +107,9 @@ TU_ATTR_WEAK void tud_bt_hci_cmd_cb(void *hci_cmd, size_t cmd_len);
 // Detailed format is described in Bluetooth core specification Vol 2,
 // Part E, 5.4.2.
 // Length is from 4 bytes, (12 bits for Handle, 4 bits for flags
-// and 16 bits for data total length) to endpoint size.
+// and 16 bits for data total length) to endpoint size, or to
+// CFG_TUD_BTH_ACL_RX_BUFSIZE with CFG_TUD_BTH_ACL_RX_DEPTH. In the latter case
+// data stays valid until released with tud_bt_acl_data_release().
 TU_ATTR_WEAK void tud_bt_acl_data_received_cb(void *acl_data, uint16_t data_len);
 
 // Called when event sent with tud_bt_event_send() was delivered to BT stack.
@@ -85,11 +121,21 @@ TU_ATTR_WEAK void tud_bt_event_sent_cb(uint16_t sent_bytes);
 // Controller can release/reuse buffer with ACL packet at this point.
 TU_ATTR_WEAK void tud_bt_acl_data_sent_cb(uint16_t sent_bytes);
 
+// Invoked when host selects alternate setting of ISO interface, 0 stops SCO streaming
+TU_ATTR_WEAK void tud_bt_sco_alt_cb(uint8_t alt);
+
+// Invoked when SCO data was received from host, data is valid only during callback
+TU_ATTR_WEAK void tud_bt_sco_data_received_cb(void *sco_data, uint16_t data_len);
+
+// Invoked when SCO data sent with tud_bt_sco_data_send() was delivered
+TU_ATTR_WEAK void tud_bt_sco_data_sent_cb(uint16_t sent_bytes);
+
 // Bluetooth controller calls this function when it wants to send even packet
 // as described in Bluetooth core specification Vol 2, Part E, 5.4.4.
 // Event has at least 2 bytes, first is Event code second contains parameter
 // total length. Controller can release/reuse event memory after
-// tud_bt_event_sent_cb() is called.
+// tud_bt_event_sent_cb() is called. Packets are queued while endpoint is busy,
+// return false if queue (CFG_TUD_BTH_EVENT_QUEUE_DEPTH) is full.
 bool tud_bt_event_send(void *event, uint16_t event_len);
 
 // Bluetooth controller calls this to send ACL data packet
@@ -98,8 +144,27 @@ bool tud_bt_event_send(void *event, uint16_t event_len);
 // and 16 bits for data total length). Upper limit is not limited
 // to endpoint size since buffer is allocate by controller
 // and must not be reused till tud_bt_acl_data_sent_cb() is called.
+// Packets are queued while endpoint is busy, return false if queue
+// (CFG_TUD_BTH_ACL_QUEUE_DEPTH) is full.
 bool tud_bt_acl_data_send(void *acl_data, uint16_t data_len);
 
+#if CFG_TUD_BTH_ACL_RX_DEPTH
+// Get oldest received ACL packet, return its length (0 if none)
+uint16_t tud_bt_acl_data_peek(void const **acl_data);
+
+// Release oldest received ACL packet, its buffer is used to receive new data
+void tud_bt_acl_data_release(void);
+#endif
+
+#if CFG_TUD_BTH_ISO_EPSIZE
+// Current alternate setting of ISO interface, 0 if SCO is not streaming
+uint8_t tud_bt_sco_alt(void);
+
+// Send one SCO packet (up to ISO endpoint size of current alternate setting).
+// Data is copied, return false if previous packet is not sent yet
+bool tud_bt_sco_data_send(void const *sco_data, uint16_t data_len);
+#endif
+
 //--------------------------------------------------------------------+
 // Internal Class Driver API
 //--------------------------------------------------------------------+
@@ -0,0 +1,632 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#include "tusb_option.h"
+
+#if (CFG_TUH_ENABLED && CFG_TUH_BTH)
+
+#include "host/usbh.h"
+#include "host/usbh_pvt.h"
+
+#include "bth_host.h"
+
+// Level where CFG_TUSB_DEBUG must be at least for this driver is logged
+#ifndef CFG_TUH_BTH_LOG_LEVEL
+  #define CFG_TUH_BTH_LOG_LEVEL   CFG_TUH_LOG_LEVEL
+#endif
+
+#define TU_LOG_DRV(...)   TU_LOG(CFG_TUH_BTH_LOG_LEVEL, __VA_ARGS__)
+
+//--------------------------------------------------------------------+
+// MACRO CONSTANT TYPEDEF
+//--------------------------------------------------------------------+
+enum {
+  BTH_SUBCLASS_RF_CONTROLLER = 0x01,
+  BTH_PROTOCOL_BLUETOOTH     = 0x01,
+};
+
+// Event is received one packet at a time, allow the last packet to be a full one
+#define BTH_EVENT_EPBUF_SIZE   (TU_DIV_CEIL(CFG_TUH_BTH_EVENT_BUFSIZE, 64) * 64)
+
+typedef struct {
+  uint8_t daddr;
+  uint8_t itf_num;
+  uint8_t itf_count;              // 2 if SCO interface is bound to this driver
+  tusb_desc_interface_t desc_itf; // for get_info()
+  bool mounted;                   // Enumeration is complete
+
+  uint8_t  ep_evt;
+  uint8_t  ep_evt_mps;
+  uint16_t evt_len;               // bytes of current event received so far
+
+  uint8_t  ep_acl_in;
+  uint8_t  ep_acl_out;
+  uint16_t acl_out_mps;
+
+  volatile bool cmd_busy;
+  volatile bool acl_tx_busy;
+  bool     acl_tx_zlp;            // ZLP pending after ACL packet of multiple of packet size
+  uint16_t acl_tx_len;
+
+#if CFG_TUH_BTH_SCO
+  uint8_t sco_itf;
+  uint8_t sco_alt_count;
+  uint8_t sco_alt;                // alternate setting being streamed, 0 if stopped
+  uint8_t sco_alt_req;            // alternate setting requested by tuh_bth_sco_set_alt()
+  uint8_t ep_sco_in;
+  uint8_t ep_sco_out;
+  uint8_t sco_mps[2][CFG_TUH_BTH_SCO_ALT_MAX]; // packet size per direction and alternate setting
+
+  uint8_t sco_rx_pending;         // IN transfers in flight
+  uint8_t sco_rx_next;            // slot of next IN transfer to complete, transfers are completed in order
+  volatile bool sco_tx_busy;
+
+  hcd_iso_packet_t sco_rx_packets[2][CFG_TUH_BTH_SCO_ISO_PACKETS];
+  hcd_iso_packet_t sco_tx_packets[CFG_TUH_BTH_SCO_ISO_PACKETS];
+#endif
+} bthh_interface_t;
+
+typedef struct {
+  TUH_EPBUF_DEF(cmd, CFG_TUH_BTH_CMD_BUFSIZE);
+  TUH_EPBUF_DEF(evt, BTH_EVENT_EPBUF_SIZE);
+  struct {
+    TUH_EPBUF_DEF(buf, CFG_TUH_BTH_ACL_BUFSIZE);
+  } acl_rx[CFG_TUH_BTH_ACL_RX_COUNT];
+#if CFG_TUH_BTH_SCO
+  TUH_EPBUF_DEF(sco_rx, 2 * CFG_TUH_BTH_SCO_ISO_PACKETS * CFG_TUH_BTH_SCO_EP_BUFSIZE);
+  TUH_EPBUF_DEF(sco_tx, CFG_TUH_BTH_SCO_ISO_PACKETS * CFG_TUH_BTH_SCO_EP_BUFSIZE);
+#endif
+} bthh_epbuf_t;
+
+static bthh_interface_t _bthh_itf[CFG_TUH_BTH];
+CFG_TUH_MEM_SECTION static bthh_epbuf_t _bthh_epbuf[CFG_TUH_BTH];
+
+//--------------------------------------------------------------------+
+// Helper
+//--------------------------------------------------------------------+
+static inline bthh_interface_t* get_itf(uint8_t idx) {
+  TU_ASSERT(idx < CFG_TUH_BTH, NULL);
+  bthh_interface_t* p_bth = &_bthh_itf[idx];
+  return (p_bth->daddr != 0) ? p_bth : NULL;
+}
+
+static uint8_t get_idx_by_ep_addr(uint8_t daddr, uint8_t ep_addr) {
+  for (uint8_t i = 0; i < CFG_TUH_BTH; i++) {
+    bthh_interface_t const* p_bth = &_bthh_itf[i];
+    if (p_bth->daddr == daddr &&
+        (ep_addr == p_bth->ep_evt || ep_addr == p_bth->ep_acl_in || ep_addr == p_bth->ep_acl_out
+#if CFG_TUH_BTH_SCO
+         || ep_addr == p_bth->ep_sco_in || ep_addr == p_bth->ep_sco_out
+#endif
+        )) {
+      return i;
+    }
+  }
+  return TUSB_INDEX_INVALID_8;
+}
+
+//--------------------------------------------------------------------+
+// Event: received one packet at a time directly into event buffer until the length in event header is reached
+//--------------------------------------------------------------------+
+static bool evt_submit(uint8_t idx) {
+  bthh_interface_t* p_bth = &_bthh_itf[idx];
+  uint8_t const daddr = p_bth->daddr;
+
+  TU_VERIFY(usbh_edpt_claim(daddr, p_bth->ep_evt));
+  if (!usbh_edpt_xfer(daddr, p_bth->ep_evt, _bthh_epbuf[idx].evt + p_bth->evt_len, p_bth->ep_evt_mps)) {
+    usbh_edpt_release(daddr, p_bth->ep_evt);
+    return false;
+  }
+  return true;
+}
+
+static void evt_complete(uint8_t idx, xfer_result_t result, uint32_t xferred_bytes) {
+  bthh_interface_t* p_bth = &_bthh_itf[idx];
+  if (result != XFER_RESULT_SUCCESS) {
+    TU_LOG_DRV("  BTH event transfer failed (%u, %u)\r\n", p_bth->daddr, idx);
+    p_bth->evt_len = 0;
+    return;
+  }
+
+  uint8_t const* evt = _bthh_epbuf[idx].evt;
+  p_bth->evt_len = (uint16_t) (p_bth->evt_len + xferred_bytes);
+
+  if (p_bth->evt_len >= 2 && p_bth->evt_len >= 2u + evt[1]) {
+    if (tuh_bth_event_received_cb) {
+      tuh_bth_event_received_cb(idx, evt, (uint16_t) (2u + evt[1]));
+    }
+    p_bth->evt_len = 0;
+  } else if (xferred_bytes < p_bth->ep_evt_mps || p_bth->evt_len + p_bth->ep_evt_mps > BTH_EVENT_EPBUF_SIZE) {
+    // short packet before end of event or event too large: drop and re-sync with next event
+    if (p_bth->evt_len) {
+      TU_LOG_DRV("  BTH drop incomplete event (%u bytes)\r\n", p_bth->evt_len);
+    }
+    p_bth->evt_len = 0;
+  }
+
+  (void) evt_submit(idx);
+}
+
+//--------------------------------------------------------------------+
+// ACL IN: each transfer carries one whole ACL packet, delivered from endpoint buffer which is re-armed afterwards
+//--------------------------------------------------------------------+
+static void acl_rx_complete(uint8_t idx, uint8_t b, xfer_result_t result, uint32_t xferred_bytes);
+
+#if CFG_TUH_BTH_ACL_RX_COUNT > 1
+static void acl_rx_xfer_cb(tuh_xfer_t* xfer) {
+  uint8_t const idx = (uint8_t) (xfer->user_data >> 2);
+  bthh_interface_t* p_bth = get_itf(idx);
+  TU_VERIFY(p_bth && p_bth->daddr == xfer->daddr, );
+  acl_rx_complete(idx, (uint8_t) (xfer->user_data & 3), xfer->result, xfer->actual_len);
+}
+#endif
+
+static bool acl_rx_submit(uint8_t idx, uint8_t b) {
+  bthh_interface_t* p_bth = &_bthh_itf[idx];
+  uint8_t const daddr = p_bth->daddr;
+  uint8_t* buf = _bthh_epbuf[idx].acl_rx[b].buf;
+
+#if CFG_TUH_BTH_ACL_RX_COUNT > 1
+  // queued behind outstanding transfers when endpoint is busy
+  tuh_xfer_t xfer = {
+      .daddr       = daddr,
+      .ep_addr     = p_bth->ep_acl_in,
+      .buflen      = CFG_TUH_BTH_ACL_BUFSIZE,
+      .buffer      = buf,
+      .complete_cb = acl_rx_xfer_cb,
+      .user_data   = (uintptr_t) ((idx << 2) | b)
+  };
+  return tuh_edpt_xfer(&xfer);
+#else
+  (void) b;
+  TU_VERIFY(usbh_edpt_claim(daddr, p_bth->ep_acl_in));
+  if (!usbh_edpt_xfer(daddr, p_bth->ep_acl_in, buf, CFG_TUH_BTH_ACL_BUFSIZE)) {
+    usbh_edpt_release(daddr, p_bth->ep_acl_in);
+    return false;
+  }
+  return true;
+#endif
+}
+
+static void acl_rx_complete(uint8_t idx, uint8_t b, xfer_result_t result, uint32_t xferred_bytes) {
+  bthh_interface_t* p_bth = &_bthh_itf[idx];
+  if (result != XFER_RESULT_SUCCESS) {
+    TU_LOG_DRV("  BTH ACL IN transfer failed (%u, %u)\r\n", p_bth->daddr, idx);
+    return;
+  }
+
+  // 4-byte header: handle + flags (2), data total length (2)
+  uint8_t const* pkt = _bthh_epbuf[idx].acl_rx[b].buf;
+  if (xferred_bytes >= 4 && xferred_bytes == 4u + tu_le16toh(tu_unaligned_read16(pkt + 2))) {
+    if (tuh_bth_acl_received_cb) {
+      tuh_bth_acl_received_cb(idx, pkt, (uint16_t) xferred_bytes);
+    }
+  } else if (xferred_bytes) {
+    TU_LOG_DRV("  BTH drop malformed ACL packet (%lu bytes)\r\n", xferred_bytes);
+  }
+
+  if (p_bth->mounted) {
+    (void) acl_rx_submit(idx, b);
+  }
+}
+
+//--------------------------------------------------------------------+
+// SCO
+//--------------------------------------------------------------------+
+#if CFG_TUH_BTH_SCO
+static bool sco_rx_submit(uint8_t idx, uint8_t slot) {
+  bthh_interface_t* p_bth = &_bthh_itf[idx];
+  hcd_iso_packet_t* packets = p_bth->sco_rx_packets[slot];
+  uint8_t* buf = _bthh_epbuf[idx].sco_rx + slot * CFG_TUH_BTH_SCO_ISO_PACKETS * CFG_TUH_BTH_SCO_EP_BUFSIZE;
+
+  for (uint8_t i = 0; i < CFG_TUH_BTH_SCO_ISO_PACKETS; i++) {
+    packets[i].len = p_bth->sco_mps[TUSB_DIR_IN][p_bth->sco_alt];
+  }
+
+  TU_VERIFY(usbh_edpt_iso_xfer(p_bth->daddr, p_bth->ep_sco_in, buf, packets, CFG_TUH_BTH_SCO_ISO_PACKETS));
+  p_bth->sco_rx_pending++;
+  return true;
+}
+
+static void sco_rx_complete(uint8_t idx) {
+  bthh_interface_t* p_bth = &_bthh_itf[idx];
+  uint8_t const slot = p_bth->sco_rx_next;
+  p_bth->sco_rx_next ^= 1u;
+  if (p_bth->sco_rx_pending) p_bth->sco_rx_pending--;
+
+  uint8_t const* buf = _bthh_epbuf[idx].sco_rx + slot * CFG_TUH_BTH_SCO_ISO_PACKETS * CFG_TUH_BTH_SCO_EP_BUFSIZE;
+  hcd_iso_packet_t const* packets = p_bth->sco_rx_packets[slot];
+  for (uint8_t i = 0; i < CFG_TUH_BTH_SCO_ISO_PACKETS; i++) {
+    if (packets[i].result == XFER_RESULT_SUCCESS && packets[i].actual_len && tuh_bth_sco_received_cb) {
+      tuh_bth_sco_received_cb(idx, buf, packets[i].actual_len);
+    }
+    buf += packets[i].len;
+  }
+
+  // keep 2 transfers in flight while streaming
+  if (p_bth->sco_alt && p_bth->sco_mps[TUSB_DIR_IN][p_bth->sco_alt]) {
+    (void) sco_rx_submit(idx, (uint8_t) ((p_bth->sco_rx_next + p_bth->sco_rx_pending) & 1u));
+  }
+}
+
+static void sco_set_alt_complete(tuh_xfer_t* xfer) {
+  uint8_t const idx = (uint8_t) xfer->user_data;
+  bthh_interface_t* p_bth = get_itf(idx);
+  TU_VERIFY(p_bth && p_bth->daddr == xfer->daddr, );
+
+  bool const success = (xfer->result == XFER_RESULT_SUCCESS);
+  uint8_t const alt = success ? p_bth->sco_alt_req : 0;
+  p_bth->sco_alt = alt;
+
+  if (alt && p_bth->ep_sco_in && p_bth->sco_mps[TUSB_DIR_IN][alt]) {
+    while (p_bth->sco_rx_pending < 2) {
+      if (!sco_rx_submit(idx, (uint8_t) ((p_bth->sco_rx_next + p_bth->sco_rx_pending) & 1u))) {
+        break;
+      }
+    }
+  }
+
+  if (tuh_bth_sco_alt_cb) {
+    tuh_bth_sco_alt_cb(idx, p_bth->sco_alt_req, success);
+  }
+}
+
+uint8_t tuh_bth_sco_alt_count(uint8_t idx) {
+  bthh_interface_t* p_bth = get_itf(idx);
+  TU_VERIFY(p_bth, 0);
+  return p_bth->sco_alt_count;
+}
+
+bool tuh_bth_sco_set_alt(uint8_t idx, uint8_t alt) {
+  bthh_interface_t* p_bth = get_itf(idx);
+  TU_VERIFY(p_bth && p_bth->mounted && alt < p_bth->sco_alt_count);
+
+  // in-flight transfers are let to complete without re-submitting
+  p_bth->sco_alt = 0;
+  p_bth->sco_alt_req = alt;
+  return tuh_interface_set(p_bth->daddr, p_bth->sco_itf, alt, sco_set_alt_complete, idx);
+}
+
+bool tuh_bth_sco_send(uint8_t idx, void const* data, uint16_t len) {
+  bthh_interface_t* p_bth = get_itf(idx);
+  TU_VERIFY(p_bth && p_bth->sco_alt && p_bth->ep_sco_out && !p_bth->sco_tx_busy && len);
+
+  uint16_t const mps = p_bth->sco_mps[TUSB_DIR_OUT][p_bth->sco_alt];
+  TU_VERIFY(mps);
+  uint16_t const count = (uint16_t) tu_div_ceil(len, mps);
+  TU_VERIFY(count <= CFG_TUH_BTH_SCO_ISO_PACKETS);
+
+  memcpy(_bthh_epbuf[idx].sco_tx, data, len);
+  for (uint16_t i = 0; i < count; i++) {
+    p_bth->sco_tx_packets[i].len = (uint16_t) tu_min16(mps, (uint16_t) (len - i * mps));
+  }
+
+  p_bth->sco_tx_busy = true;
+  if (!usbh_edpt_iso_xfer(p_bth->daddr, p_bth->ep_sco_out, _bthh_epbuf[idx].sco_tx, p_bth->sco_tx_packets, count)) {
+    p_bth->sco_tx_busy = false;
+    return false;
+  }
+  return true;
+}
+#endif
+
+//--------------------------------------------------------------------+
+// Application API
+//--------------------------------------------------------------------+
+uint8_t tuh_bth_itf_get_index(uint8_t daddr, uint8_t itf_num) {
+  for (uint8_t i = 0; i < CFG_TUH_BTH; i++) {
+    bthh_interface_t const* p_bth = &_bthh_itf[i];
+    if (p_bth->daddr == daddr && p_bth->itf_num == itf_num) return i;
+  }
+  return TUSB_INDEX_INVALID_8;
+}
+
+bool tuh_bth_itf_get_info(uint8_t idx, tuh_itf_info_t* info) {
+  bthh_interface_t* p_bth = get_itf(idx);
+  TU_VERIFY(p_bth && info);
+
+  info->daddr = p_bth->daddr;
+  info->desc = p_bth->desc_itf;
+  return true;
+}
+
+bool tuh_bth_mounted(uint8_t idx) {
+  bthh_interface_t* p_bth = get_itf(idx);
+  TU_VERIFY(p_bth);
+  return p_bth->mounted;
+}
+
+static void cmd_xfer_cb(tuh_xfer_t* xfer) {
+  uint8_t const idx = (uint8_t) xfer->user_data;
+  bthh_interface_t* p_bth = get_itf(idx);
+  TU_VERIFY(p_bth && p_bth->daddr == xfer->daddr, );
+
+  p_bth->cmd_busy = false;
+  if (tuh_bth_command_sent_cb) {
+    tuh_bth_command_sent_cb(idx, xfer->result);
+  }
+}
+
+bool tuh_bth_command_send(uint8_t idx, void const* cmd, uint16_t len) {
+  bthh_interface_t* p_bth = get_itf(idx);
+  TU_VERIFY(p_bth && p_bth->mounted && len <= CFG_TUH_BTH_CMD_BUFSIZE && !p_bth->cmd_busy);
+
+  // Primary controller of a composite device is addressed by interface
+  tusb_control_request_t const request = {
+    .bmRequestType_bit = {
+      .recipient = p_bth->itf_num ? TUSB_REQ_RCPT_INTERFACE : TUSB_REQ_RCPT_DEVICE,
+      .type      = TUSB_REQ_TYPE_CLASS,
+      .direction = TUSB_DIR_OUT
+    },
+    .bRequest = 0,
+    .wValue   = 0,
+    .wIndex   = tu_htole16((uint16_t) p_bth->itf_num),
+    .wLength  = tu_htole16(len)
+  };
+
+  memcpy(_bthh_epbuf[idx].cmd, cmd, len);
+  p_bth->cmd_busy = true;
+
+  tuh_xfer_t xfer = {
+    .daddr       = p_bth->daddr,
+    .ep_addr     = 0,
+    .setup       = &request,
+    .buffer      = _bthh_epbuf[idx].cmd,
+    .complete_cb = cmd_xfer_cb,
+    .user_data   = idx
+  };
+
+  if (!tuh_control_xfer(&xfer)) {
+    p_bth->cmd_busy = false;
+    return false;
+  }
+  return true;
+}
+
+bool tuh_bth_acl_send_ready(uint8_t idx) {
+  bthh_interface_t* p_bth = get_itf(idx);
+  TU_VERIFY(p_bth);
+  return p_bth->mounted && !p_bth->acl_tx_busy;
+}
+
+bool tuh_bth_acl_send(uint8_t idx, void const* packet, uint16_t len) {
+  bthh_interface_t* p_bth = get_itf(idx);
+  TU_VERIFY(p_bth && p_bth->mounted && !p_bth->acl_tx_busy);
+
+  uint8_t const daddr = p_bth->daddr;
+  TU_VERIFY(usbh_edpt_claim(daddr, p_bth->ep_acl_out));
+
+  p_bth->acl_tx_busy = true;
+  p_bth->acl_tx_len = len;
+  p_bth->acl_tx_zlp = (len > 0) && (len % p_bth->acl_out_mps == 0);
+
+  if (!usbh_edpt_xfer(daddr, p_bth->ep_acl_out, (uint8_t*) (uintptr_t) packet, len)) {
+    p_bth->acl_tx_busy = false;
+    usbh_edpt_release(daddr, p_bth->ep_acl_out);
+    return false;
+  }
+  return true;
+}
+
+//--------------------------------------------------------------------+
+// USBH API
+//--------------------------------------------------------------------+
+bool bthh_init(void) {
+  TU_LOG_DRV("sizeof(bthh_interface_t) = %u\r\n", sizeof(bthh_interface_t));
+  tu_memclr(_bthh_itf, sizeof(_bthh_itf));
+  return true;
+}
+
+bool bthh_deinit(void) {
+  return true;
+}
+
+void bthh_close(uint8_t daddr) {
+  for (uint8_t idx = 0; idx < CFG_TUH_BTH; idx++) {
+    bthh_interface_t* p_bth = &_bthh_itf[idx];
+    if (p_bth->daddr == daddr) {
+      TU_LOG_DRV("  BTH close addr = %u index = %u\r\n", daddr, idx);
+
+      if (p_bth->mounted && tuh_bth_umount_cb) {
+        tuh_bth_umount_cb(idx);
+      }
+
+      tu_memclr(p_bth, sizeof(bthh_interface_t));
+    }
+  }
+}
+
+bool bthh_xfer_cb(uint8_t daddr, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes) {
+  uint8_t const idx = get_idx_by_ep_addr(daddr, ep_addr);
+  bthh_interface_t* p_bth = get_itf(idx);
+  TU_VERIFY(p_bth);
+
+  if (ep_addr == p_bth->ep_evt) {
+    evt_complete(idx, result, xferred_bytes);
+  } else if (ep_addr == p_bth->ep_acl_in) {
+    // only used with single ACL IN transfer, queued transfers complete with acl_rx_xfer_cb()
+    acl_rx_complete(idx, 0, result, xferred_bytes);
+  } else if (ep_addr == p_bth->ep_acl_out) {
+    if (result == XFER_RESULT_SUCCESS && p_bth->acl_tx_zlp) {
+      // terminate packet of multiple of packet size with ZLP before reporting it
+      p_bth->acl_tx_zlp = false;
+      if (usbh_edpt_claim(daddr, ep_addr)) {
+        if (usbh_edpt_xfer(daddr, ep_addr, NULL, 0)) {
+          return true;
+        }
+        usbh_edpt_release(daddr, ep_addr);
+      }
+    }
+
+    p_bth->acl_tx_busy = false;
+    if (tuh_bth_acl_sent_cb) {
+      tuh_bth_acl_sent_cb(idx, result, p_bth->acl_tx_len);
+    }
+  }
+#if CFG_TUH_BTH_SCO
+  else if (ep_addr == p_bth->ep_sco_in) {
+    sco_rx_complete(idx);
+  } else if (ep_addr == p_bth->ep_sco_out) {
+    p_bth->sco_tx_busy = false;
+    if (tuh_bth_sco_sent_cb) {
+      tuh_bth_sco_sent_cb(idx);
+    }
+  }
+#endif
+
+  return true;
+}
+
+//--------------------------------------------------------------------+
+// Enumeration
+//--------------------------------------------------------------------+
+bool bthh_open(uint8_t rhport, uint8_t daddr, tusb_desc_interface_t const* desc_itf, uint16_t max_len) {
+  (void) rhport;
+  TU_VERIFY(TUSB_CLASS_WIRELESS_CONTROLLER == desc_itf->bInterfaceClass &&
+            BTH_SUBCLASS_RF_CONTROLLER == desc_itf->bInterfaceSubClass &&
+            BTH_PROTOCOL_BLUETOOTH == desc_itf->bInterfaceProtocol);
+
+  bthh_interface_t* p_bth = NULL;
+  for (uint8_t i = 0; i < CFG_TUH_BTH; i++) {
+    if (_bthh_itf[i].daddr == 0) {
+      p_bth = &_bthh_itf[i];
+      break;
+    }
+  }
+  TU_VERIFY(p_bth);
+
+  TU_LOG_DRV("[%u] BTH opening Interface %u\r\n", daddr, desc_itf->bInterfaceNumber);
+  p_bth->daddr = daddr;
+  p_bth->itf_num = desc_itf->bInterfaceNumber;
+  p_bth->itf_count = 1;
+  p_bth->desc_itf = *desc_itf;
+
+#if CFG_TUH_BTH_SCO
+  tusb_desc_endpoint_t const* sco_desc[2] = { NULL, NULL }; // largest one of each direction
+#endif
+
+  // HCI interface: interrupt IN (event), bulk IN/OUT (ACL). Following interface (if bound) carries SCO
+  uint8_t const* p_desc = tu_desc_next(desc_itf);
+  uint8_t const* desc_end = ((uint8_t const*) desc_itf) + max_len;
+  uint8_t cur_itf = desc_itf->bInterfaceNumber;
+  uint8_t cur_alt = 0;
+
+  while (p_desc < desc_end) {
+    uint8_t const desc_type = tu_desc_type(p_desc);
+
+    if (TUSB_DESC_INTERFACE == desc_type) {
+      tusb_desc_interface_t const* itf = (tusb_desc_interface_t const*) p_desc;
+      cur_itf = itf->bInterfaceNumber;
+      cur_alt = itf->bAlternateSetting;
+      if (cur_itf == p_bth->itf_num + 1) {
+        p_bth->itf_count = 2;
+#if CFG_TUH_BTH_SCO
+        p_bth->sco_itf = cur_itf;
+        if (cur_alt < CFG_TUH_BTH_SCO_ALT_MAX) {
+          p_bth->sco_alt_count = tu_max8(p_bth->sco_alt_count, (uint8_t) (cur_alt + 1));
+        }
+#endif
+      }
+    } else if (TUSB_DESC_ENDPOINT == desc_type) {
+      tusb_desc_endpoint_t const* desc_ep = (tusb_desc_endpoint_t const*) p_desc;
+      uint8_t const dir = tu_edpt_dir(desc_ep->bEndpointAddress);
+
+      if (cur_itf == p_bth->itf_num) {
+        if (TUSB_XFER_INTERRUPT == desc_ep->bmAttributes.xfer && TUSB_DIR_IN == dir && 0 == p_bth->ep_evt) {
+          TU_ASSERT(tuh_edpt_open(daddr, desc_ep));
+          p_bth->ep_evt = desc_ep->bEndpointAddress;
+          p_bth->ep_evt_mps = (uint8_t) tu_edpt_packet_size(desc_ep);
+        } else if (TUSB_XFER_BULK == desc_ep->bmAttributes.xfer) {
+          if (TUSB_DIR_IN == dir && 0 == p_bth->ep_acl_in) {
+            TU_ASSERT(tuh_edpt_open(daddr, desc_ep));
+            p_bth->ep_acl_in = desc_ep->bEndpointAddress;
+          } else if (TUSB_DIR_OUT == dir && 0 == p_bth->ep_acl_out) {
+            TU_ASSERT(tuh_edpt_open(daddr, desc_ep));
+            p_bth->ep_acl_out = desc_ep->bEndpointAddress;
+            p_bth->acl_out_mps = tu_edpt_packet_size(desc_ep);
+          }
+        }
+      }
+#if CFG_TUH_BTH_SCO
+      else if (cur_itf == p_bth->sco_itf && TUSB_XFER_ISOCHRONOUS == desc_ep->bmAttributes.xfer &&
+               cur_alt < CFG_TUH_BTH_SCO_ALT_MAX) {
+        uint16_t const mps = tu_edpt_packet_size(desc_ep);
+        if (mps <= CFG_TUH_BTH_SCO_EP_BUFSIZE) {
+          p_bth->sco_mps[dir][cur_alt] = (uint8_t) mps;
+          if (sco_desc[dir] == NULL || mps > tu_edpt_packet_size(sco_desc[dir])) {
+            sco_desc[dir] = desc_ep;
+          }
+        }
+      }
+#endif
+    }
+
+    p_desc = tu_desc_next(p_desc);
+  }
+  (void) cur_alt;
+
+  TU_ASSERT(p_bth->ep_evt && p_bth->ep_acl_in && p_bth->ep_acl_out && p_bth->acl_out_mps);
+
+#if CFG_TUH_BTH_SCO
+  // isochronous endpoints are opened with largest packet size, alternate setting only selects the bandwidth used
+  if (sco_desc[TUSB_DIR_IN] && tuh_edpt_open(daddr, sco_desc[TUSB_DIR_IN])) {
+    p_bth->ep_sco_in = sco_desc[TUSB_DIR_IN]->bEndpointAddress;
+  }
+  if (sco_desc[TUSB_DIR_OUT] && tuh_edpt_open(daddr, sco_desc[TUSB_DIR_OUT])) {
+    p_bth->ep_sco_out = sco_desc[TUSB_DIR_OUT]->bEndpointAddress;
+  }
+  if (!p_bth->ep_sco_in && !p_bth->ep_sco_out) {
+    p_bth->sco_alt_count = 0;
+  }
+#endif
+
+  return true;
+}
+
+bool bthh_set_config(uint8_t daddr, uint8_t itf_num) {
+  uint8_t const idx = tuh_bth_itf_get_index(daddr, itf_num);
+  bthh_interface_t* p_bth = get_itf(idx);
+  TU_ASSERT(p_bth);
+
+  TU_LOG_DRV("BTH Set Configure complete\r\n");
+  p_bth->mounted = true;
+  if (tuh_bth_mount_cb) {
+    tuh_bth_mount_cb(idx);
+  }
+
+  // Prepare for incoming events and ACL data
+  (void) evt_submit(idx);
+  for (uint8_t b = 0; b < CFG_TUH_BTH_ACL_RX_COUNT; b++) {
+    (void) acl_rx_submit(idx, b);
+  }
+
+  // notify usbh that driver enumeration is complete, including SCO interface if bound
+  usbh_driver_set_config_complete(daddr, (uint8_t) (itf_num + p_bth->itf_count - 1));
+
+  return true;
+}
+
+#endif
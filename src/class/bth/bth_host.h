@@ -0,0 +1,174 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#ifndef _TUSB_BTH_HOST_H_
+#define _TUSB_BTH_HOST_H_
+
+#include "common/tusb_common.h"
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+//--------------------------------------------------------------------+
+// Class Driver Configuration
+//--------------------------------------------------------------------+
+
+// HCI command buffer: 3-byte header + up to 255 bytes of parameters
+#ifndef CFG_TUH_BTH_CMD_BUFSIZE
+#define CFG_TUH_BTH_CMD_BUFSIZE      258
+#endif
+
+// HCI event buffer: 2-byte header + up to 255 bytes of parameters
+#ifndef CFG_TUH_BTH_EVENT_BUFSIZE
+#define CFG_TUH_BTH_EVENT_BUFSIZE    257
+#endif
+
+// ACL IN transfer buffer, should fit the largest ACL packet of controller (4-byte header + ACL_Data_Packet_Length)
+// and be multiple of max packet size
+#ifndef CFG_TUH_BTH_ACL_BUFSIZE
+#define CFG_TUH_BTH_ACL_BUFSIZE      1088
+#endif
+
+// Number of ACL IN transfers kept outstanding (1 to 4). With more than 1, next transfers are queued behind the active
+// one so that controller keeps sending while a received packet is processed. Require CFG_TUH_EDPT_XFER_QUEUE
+#ifndef CFG_TUH_BTH_ACL_RX_COUNT
+#define CFG_TUH_BTH_ACL_RX_COUNT     1
+#endif
+
+// Enable SCO (voice) streaming over isochronous endpoints of the second interface
+#ifndef CFG_TUH_BTH_SCO
+#define CFG_TUH_BTH_SCO              0
+#endif
+
+// Largest isochronous packet size of SCO endpoints among alternate settings
+#ifndef CFG_TUH_BTH_SCO_EP_BUFSIZE
+#define CFG_TUH_BTH_SCO_EP_BUFSIZE   64
+#endif
+
+// Number of isochronous packets per SCO transfer, 2 IN transfers are queued
+#ifndef CFG_TUH_BTH_SCO_ISO_PACKETS
+#define CFG_TUH_BTH_SCO_ISO_PACKETS  3
+#endif
+
+// Max alternate settings of SCO interface, including zero-bandwidth alt 0
+#ifndef CFG_TUH_BTH_SCO_ALT_MAX
+#define CFG_TUH_BTH_SCO_ALT_MAX      6
+#endif
+
+#if CFG_TUH_BTH_ACL_RX_COUNT < 1 || CFG_TUH_BTH_ACL_RX_COUNT > 4 || \
+    (CFG_TUH_BTH_ACL_RX_COUNT > 1 && !CFG_TUH_EDPT_XFER_QUEUE)
+  #error "CFG_TUH_BTH_ACL_RX_COUNT must be 1 to 4, more than 1 requires CFG_TUH_EDPT_XFER_QUEUE"
+#endif
+
+//--------------------------------------------------------------------+
+// Application API
+//--------------------------------------------------------------------+
+
+// Get controller index from device address + interface number of HCI interface
+// return TUSB_INDEX_INVALID_8 (0xFF) if not found
+uint8_t tuh_bth_itf_get_index(uint8_t daddr, uint8_t itf_num);
+
+// Get HCI interface information
+// return true if index is correct and interface is currently mounted
+bool tuh_bth_itf_get_info(uint8_t idx, tuh_itf_info_t* info);
+
+// Check if controller is mounted
+bool tuh_bth_mounted(uint8_t idx);
+
+// Send HCI command packet (without packet indicator). Command is copied, tuh_bth_command_sent_cb() is invoked when
+// complete. Return false if previous command is not complete yet
+bool tuh_bth_command_send(uint8_t idx, void const* cmd, uint16_t len);
+
+// Send HCI ACL data packet (without packet indicator). Packet is sent without copy: buffer must stay valid until
+// tuh_bth_acl_sent_cb() and be accessible by host controller (e.g in CFG_TUH_MEM_SECTION with CFG_TUH_MEM_ALIGN).
+// Return false if previous packet is not sent yet
+bool tuh_bth_acl_send(uint8_t idx, void const* packet, uint16_t len);
+
+// Check if an ACL data packet can be sent
+bool tuh_bth_acl_send_ready(uint8_t idx);
+
+#if CFG_TUH_BTH_SCO
+// Number of alternate settings of SCO interface, 0 if controller has no SCO interface
+uint8_t tuh_bth_sco_alt_count(uint8_t idx);
+
+// Select SCO alternate setting, 0 stops streaming. tuh_bth_sco_alt_cb() is invoked when done
+bool tuh_bth_sco_set_alt(uint8_t idx, uint8_t alt);
+
+// Send HCI SCO data, split into isochronous packets of current alternate setting. Data is copied,
+// tuh_bth_sco_sent_cb() is invoked when sent. Return false if streaming is off or previous data is not sent yet
+bool tuh_bth_sco_send(uint8_t idx, void const* data, uint16_t len);
+#endif
+
+//--------------------------------------------------------------------+
+// Callbacks (Weak is optional)
+//--------------------------------------------------------------------+
+
+// Invoked when controller is mounted
+TU_ATTR_WEAK void tuh_bth_mount_cb(uint8_t idx);
+
+// Invoked when controller is unmounted
+TU_ATTR_WEAK void tuh_bth_umount_cb(uint8_t idx);
+
+// Invoked when a complete HCI event packet is received. Buffer is only valid within callback
+TU_ATTR_WEAK void tuh_bth_event_received_cb(uint8_t idx, uint8_t const* event, uint16_t len);
+
+// Invoked when a complete HCI ACL data packet is received. Buffer is only valid within callback, other ACL IN
+// transfers (if any) are kept in progress meanwhile
+TU_ATTR_WEAK void tuh_bth_acl_received_cb(uint8_t idx, uint8_t const* packet, uint16_t len);
+
+// Invoked when HCI command transfer is complete
+TU_ATTR_WEAK void tuh_bth_command_sent_cb(uint8_t idx, xfer_result_t result);
+
+// Invoked when ACL data packet is sent, its buffer can be reused
+TU_ATTR_WEAK void tuh_bth_acl_sent_cb(uint8_t idx, xfer_result_t result, uint16_t len);
+
+#if CFG_TUH_BTH_SCO
+// Invoked when tuh_bth_sco_set_alt() is complete
+TU_ATTR_WEAK void tuh_bth_sco_alt_cb(uint8_t idx, uint8_t alt, bool success);
+
+// Invoked for each received isochronous packet of SCO data. Buffer is only valid within callback
+TU_ATTR_WEAK void tuh_bth_sco_received_cb(uint8_t idx, uint8_t const* data, uint16_t len);
+
+// Invoked when SCO data is sent
+TU_ATTR_WEAK void tuh_bth_sco_sent_cb(uint8_t idx);
+#endif
+
+//--------------------------------------------------------------------+
+// Internal Class Driver API
+//--------------------------------------------------------------------+
+bool bthh_init       (void);
+bool bthh_deinit     (void);
+bool bthh_open       (uint8_t rhport, uint8_t daddr, tusb_desc_interface_t const *desc_itf, uint16_t max_len);
+bool bthh_set_config (uint8_t daddr, uint8_t itf_num);
+bool bthh_xfer_cb    (uint8_t daddr, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes);
+void bthh_close      (uint8_t daddr);
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif /* _TUSB_BTH_HOST_H_ */
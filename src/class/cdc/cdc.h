@@ -412,6 +412,30 @@ typedef struct TU_ATTR_PACKED
 
 TU_VERIFY_STATIC(sizeof(cdc_line_control_state_t) == 2, "size is not correct");
 
+/// UART State Bitmap of Serial State notification (PSTN 6.5.4). Bits 2-6 are irregular events, only signaled once
+typedef union TU_ATTR_PACKED {
+  struct TU_ATTR_PACKED {
+    uint16_t rx_carrier : 1; ///< bRxCarrier, state of DCD
+    uint16_t tx_carrier : 1; ///< bTxCarrier, state of DSR
+    uint16_t brk        : 1; ///< bBreak, break detected
+    uint16_t ring       : 1; ///< bRingSignal, ring signal detected
+    uint16_t framing    : 1; ///< bFraming, framing error
+    uint16_t parity     : 1; ///< bParity, parity error
+    uint16_t overrun    : 1; ///< bOverRun, received data has been discarded due to overrun
+    uint16_t            : 9;
+  };
+  uint16_t value;
+} cdc_serial_state_t;
+
+TU_VERIFY_STATIC(sizeof(cdc_serial_state_t) == 2, "size is not correct");
+
+typedef struct TU_ATTR_PACKED {
+  tusb_control_request_t header;
+  cdc_serial_state_t serial_state;
+} cdc_notify_serial_state_t;
+
+TU_VERIFY_STATIC(sizeof(cdc_notify_serial_state_t) == 10, "size is not correct");
+
 TU_ATTR_PACKED_END  // End of all packed definitions
 TU_ATTR_BIT_FIELD_ORDER_END
 
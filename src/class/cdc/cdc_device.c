@@ -46,6 +46,7 @@
 #define BULK_PACKET_SIZE (TUD_OPT_HIGH_SPEED ? 512 : 64)
 
 typedef struct {
+  uint8_t rhport;
   uint8_t itf_num;
   uint8_t ep_notif;
   uint8_t ep_in;
@@ -54,19 +55,60 @@ typedef struct {
   // Bit 0:  DTR (Data Terminal Ready), Bit 1: RTS (Request to Send)
   uint8_t line_state;
 
+  cdc_serial_state_t serial_state;
+  bool serial_state_pending; // changed while notification endpoint is busy
+  bool rx_throttled;         // out endpoint paused until rx fifo drains to rx_resume_level
+
+  #if CFG_TUSB_CORE_AFFINITY >= 0
+  volatile uint8_t xfer_deferred; // transfer requested by other core is pending in usbd task
+  #endif
+
+  #if CFG_TUD_CDC_XFER_ISR
+  volatile bool isr_rx_pending;     // receive callbacks deferred by cdcd_xfer_isr() to usbd task
+  volatile bool isr_wanted_pending; // wanted char received in ISR
+  #endif
+
+  // zero-copy write: application buffer is sent after fifo bytes queued before it
+  struct {
+    uint8_t const* buf;
+    uint32_t len;
+    uint32_t sent;
+    tu_fifo_size_t fifo_before; // fifo bytes that precede buffer
+    uint16_t inflight;          // bytes of current transfer taken from buffer
+    tud_cdc_write_zc_cb_t done_cb;
+  } zc;
+
   /*------------- From this point, data is not cleared by bus reset -------------*/
   char wanted_char;
+  bool line_framing;
+  tu_fifo_size_t rx_resume_level;
+
+  // line framing scan state of rx fifo, consumer side. Bytes from fifo head up to rx_scanned have no line end,
+  // or rx_line_len is the length of first complete line
+  tu_fifo_size_t rx_scanned;
+  tu_fifo_size_t rx_line_len;
   TU_ATTR_ALIGNED(4) cdc_line_coding_t line_coding;
 
   // FIFO
   tu_fifo_t rx_ff;
   tu_fifo_t tx_ff;
+  tu_edpt_coalesce_t tx_coalesce;
 
+  // internal storage, can be replaced by tud_cdc_n_configure_fifo_buffer()
+  #if CFG_TUD_CDC_RX_BUFSIZE > 0
   uint8_t rx_ff_buf[CFG_TUD_CDC_RX_BUFSIZE];
+  #endif
+  #if CFG_TUD_CDC_TX_BUFSIZE > 0
   uint8_t tx_ff_buf[CFG_TUD_CDC_TX_BUFSIZE];
+  #endif
 
   OSAL_MUTEX_DEF(rx_ff_mutex);
   OSAL_MUTEX_DEF(tx_ff_mutex);
+
+  #if OSAL_MUTEX_REQUIRED
+  osal_mutex_t rx_mutex; // created mutex, may not be attached to fifo if lock-free
+  osal_mutex_t tx_mutex;
+  #endif
 } cdcd_interface_t;
 
 #define ITF_MEM_RESET_SIZE   offsetof(cdcd_interface_t, wanted_char)
@@ -74,6 +116,7 @@ typedef struct {
 typedef struct {
   TUD_EPBUF_DEF(epout, CFG_TUD_CDC_EP_BUFSIZE);
   TUD_EPBUF_DEF(epin, CFG_TUD_CDC_EP_BUFSIZE);
+  TUD_EPBUF_TYPE_DEF(cdc_notify_serial_state_t, epnotif);
 } cdcd_epbuf_t;
 
 //--------------------------------------------------------------------+
@@ -84,29 +127,68 @@ CFG_TUD_MEM_SECTION static cdcd_epbuf_t _cdcd_epbuf[CFG_TUD_CDC];
 
 static tud_cdc_configure_fifo_t _cdcd_fifo_cfg;
 
-static bool _prep_out_transaction(uint8_t itf) {
-  const uint8_t rhport = 0;
+TU_VERIFY_STATIC(CFG_TUD_CDC <= 32, "ready mask is 32-bit");
+
+#if CFG_TUSB_OS != OPT_OS_NONE
+// posted when any port receives data, for tud_cdc_wait_ready_mask()
+static osal_semaphore_def_t _cdcd_rx_semdef;
+static osal_semaphore_t _cdcd_rx_sem;
+#endif
+
+#if CFG_TUSB_CORE_AFFINITY >= 0
+static void cdcd_deferred_xfer(void* param);
+
+// Endpoints are only accessed on the USB core: other cores defer transfers to usbd task, at most one pending
+static bool _defer_if_other_core(uint8_t itf) {
+  if (osal_core_id() == CFG_TUSB_CORE_AFFINITY) {
+    return false;
+  }
+  cdcd_interface_t* p_cdc = &_cdcd_itf[itf];
+  if (!p_cdc->xfer_deferred) {
+    p_cdc->xfer_deferred = 1;
+    usbd_defer_func(cdcd_deferred_xfer, (void*) (uintptr_t) itf, false);
+  }
+  return true;
+}
+#else
+  #define _defer_if_other_core(_itf)   false
+#endif
+
+// in_isr is true when called from cdcd_xfer_isr()
+static bool _prep_out_transaction(uint8_t itf, bool in_isr) {
   cdcd_interface_t* p_cdc = &_cdcd_itf[itf];
   cdcd_epbuf_t* p_epbuf = &_cdcd_epbuf[itf];
+  const uint8_t rhport = p_cdc->rhport;
 
   // Skip if usb is not ready yet
-  TU_VERIFY(tud_ready() && p_cdc->ep_out);
+  TU_VERIFY(tud_rhport_ready(rhport) && p_cdc->ep_out);
 
-  uint16_t available = tu_fifo_remaining(&p_cdc->rx_ff);
+  // Once throttled, endpoint stays NAKed until fifo drains below resume level (hysteresis) instead of re-arming
+  // for every packet read by a slightly slower consumer
+  if (p_cdc->rx_throttled && tu_fifo_count(&p_cdc->rx_ff) > p_cdc->rx_resume_level) {
+    return false;
+  }
 
   // Prepare for incoming data but only allow what we can store in the ring buffer.
   // TODO Actually we can still carry out the transfer, keeping count of received bytes
   // and slowly move it to the FIFO when read().
   // This pre-check reduces endpoint claiming
-  TU_VERIFY(available >= CFG_TUD_CDC_EP_BUFSIZE);
+  uint32_t available = tu_fifo_remaining(&p_cdc->rx_ff);
+  if (available < CFG_TUD_CDC_EP_BUFSIZE) {
+    p_cdc->rx_throttled = true;
+    return false;
+  }
+
+  TU_VERIFY(!_defer_if_other_core(itf));
 
   // claim endpoint
-  TU_VERIFY(usbd_edpt_claim(rhport, p_cdc->ep_out));
+  TU_VERIFY(usbd_edpt_claim_ex(rhport, p_cdc->ep_out, in_isr));
 
   // fifo can be changed before endpoint is claimed
   available = tu_fifo_remaining(&p_cdc->rx_ff);
 
   if (available >= CFG_TUD_CDC_EP_BUFSIZE) {
+    p_cdc->rx_throttled = false;
     return usbd_edpt_xfer(rhport, p_cdc->ep_out, p_epbuf->epout, CFG_TUD_CDC_EP_BUFSIZE);
   } else {
     // Release endpoint since we don't make any transfer
@@ -122,16 +204,93 @@ static bool _prep_out_transaction(uint8_t itf) {
 bool tud_cdc_configure_fifo(const tud_cdc_configure_fifo_t* cfg) {
   TU_VERIFY(cfg);
   _cdcd_fifo_cfg = (*cfg);
+
+  #if OSAL_MUTEX_REQUIRED
+  // single producer/consumer can skip mutex: fifo is lock-free in that case
+  for (uint8_t i = 0; i < CFG_TUD_CDC; i++) {
+    cdcd_interface_t* p_cdc = &_cdcd_itf[i];
+    tu_fifo_config_mutex(&p_cdc->rx_ff, NULL, cfg->rx_lockfree ? NULL : p_cdc->rx_mutex);
+    tu_fifo_config_mutex(&p_cdc->tx_ff, cfg->tx_lockfree ? NULL : p_cdc->tx_mutex, NULL);
+  }
+  #endif
+
+  #if CFG_TUSB_FIFO_ISR_SAFE
+  for (uint8_t i = 0; i < CFG_TUD_CDC; i++) {
+    tu_fifo_set_isr_safe(&_cdcd_itf[i].tx_ff, cfg->tx_isr_safe);
+  }
+  #else
+  TU_VERIFY(!cfg->tx_isr_safe);
+  #endif
+
+  return true;
+}
+
+static bool _send_serial_state(uint8_t itf) {
+  cdcd_interface_t* p_cdc = &_cdcd_itf[itf];
+  cdcd_epbuf_t* p_epbuf = &_cdcd_epbuf[itf];
+  const uint8_t rhport = p_cdc->rhport;
+
+  TU_VERIFY(tud_rhport_ready(rhport) && p_cdc->ep_notif);
+  if (!usbd_edpt_claim(rhport, p_cdc->ep_notif)) {
+    p_cdc->serial_state_pending = true; // sent when current notification completes
+    return true;
+  }
+
+  cdc_notify_serial_state_t* notify = &p_epbuf->epnotif;
+  notify->header.bmRequestType = 0xA1; // class, interface, device to host
+  notify->header.bRequest = CDC_NOTIF_SERIAL_STATE;
+  notify->header.wValue = 0;
+  notify->header.wIndex = p_cdc->itf_num;
+  notify->header.wLength = sizeof(cdc_serial_state_t);
+  notify->serial_state = p_cdc->serial_state;
+
+  // irregular signals are one-shot events
+  p_cdc->serial_state.value &= 0x03u;
+  p_cdc->serial_state_pending = false;
+
+  return usbd_edpt_xfer(rhport, p_cdc->ep_notif, (uint8_t*) notify, sizeof(cdc_notify_serial_state_t));
+}
+
+bool tud_cdc_n_send_serial_state(uint8_t itf, cdc_serial_state_t state) {
+  TU_VERIFY(itf < CFG_TUD_CDC);
+  cdcd_interface_t* p_cdc = &_cdcd_itf[itf];
+  // keep not yet sent irregular events
+  p_cdc->serial_state.value = (uint16_t) ((p_cdc->serial_state.value & 0x7Cu) | state.value);
+  return _send_serial_state(itf);
+}
+
+void tud_cdc_n_set_rx_throttle(uint8_t itf, uint32_t resume_level) {
+  _cdcd_itf[itf].rx_resume_level = (tu_fifo_size_t) tu_min32(resume_level, TU_FIFO_SIZE_MAX);
+  _prep_out_transaction(itf, false);
+}
+
+bool tud_cdc_n_configure_fifo_buffer(uint8_t itf, void* rx_buf, uint32_t rx_size, void* tx_buf, uint32_t tx_size) {
+  TU_VERIFY(itf < CFG_TUD_CDC);
+  cdcd_interface_t* p_cdc = &_cdcd_itf[itf];
+  TU_VERIFY(p_cdc->ep_in == 0 && p_cdc->ep_out == 0); // not while mounted
+
+  // rx fifo must hold a whole transfer, otherwise out endpoint is never armed
+  TU_VERIFY(rx_buf == NULL || (rx_size >= CFG_TUD_CDC_EP_BUFSIZE && rx_size <= TU_FIFO_DEPTH_MAX));
+  TU_VERIFY(tx_buf == NULL || (tx_size > 0 && tx_size <= TU_FIFO_DEPTH_MAX));
+
+  if (rx_buf) {
+    TU_VERIFY(tu_fifo_config(&p_cdc->rx_ff, rx_buf, (tu_fifo_size_t) rx_size, 1, false));
+    p_cdc->rx_scanned = p_cdc->rx_line_len = 0;
+  }
+  if (tx_buf) {
+    TU_VERIFY(tu_fifo_config(&p_cdc->tx_ff, tx_buf, (tu_fifo_size_t) tx_size, 1, true));
+  }
+
   return true;
 }
 
 bool tud_cdc_n_ready(uint8_t itf) {
-  return tud_ready() && _cdcd_itf[itf].ep_in != 0 && _cdcd_itf[itf].ep_out != 0;
+  return tud_rhport_ready(_cdcd_itf[itf].rhport) && _cdcd_itf[itf].ep_in != 0 && _cdcd_itf[itf].ep_out != 0;
 }
 
 bool tud_cdc_n_connected(uint8_t itf) {
   // DTR (bit 0) active  is considered as connected
-  return tud_ready() && tu_bit_test(_cdcd_itf[itf].line_state, 0);
+  return tud_rhport_ready(_cdcd_itf[itf].rhport) && tu_bit_test(_cdcd_itf[itf].line_state, 0);
 }
 
 uint8_t tud_cdc_n_get_line_state(uint8_t itf) {
@@ -144,6 +303,11 @@ void tud_cdc_n_get_line_coding(uint8_t itf, cdc_line_coding_t* coding) {
 
 void tud_cdc_n_set_wanted_char(uint8_t itf, char wanted) {
   _cdcd_itf[itf].wanted_char = wanted;
+  _cdcd_itf[itf].rx_scanned = _cdcd_itf[itf].rx_line_len = 0;
+}
+
+void tud_cdc_n_set_line_framing(uint8_t itf, bool enabled) {
+  _cdcd_itf[itf].line_framing = enabled;
 }
 
 //--------------------------------------------------------------------+
@@ -153,61 +317,209 @@ uint32_t tud_cdc_n_available(uint8_t itf) {
   return tu_fifo_count(&_cdcd_itf[itf].rx_ff);
 }
 
+// update line scan state after count bytes are read from rx fifo
+static void _rx_consumed(cdcd_interface_t* p_cdc, tu_fifo_size_t count) {
+  if (p_cdc->rx_line_len) {
+    if (count < p_cdc->rx_line_len) {
+      p_cdc->rx_line_len = (tu_fifo_size_t) (p_cdc->rx_line_len - count);
+      return;
+    }
+    p_cdc->rx_line_len = 0;
+    p_cdc->rx_scanned = 0; // nothing is scanned beyond line end
+  } else {
+    p_cdc->rx_scanned = (tu_fifo_size_t) (p_cdc->rx_scanned - TU_MIN(count, p_cdc->rx_scanned));
+  }
+}
+
 uint32_t tud_cdc_n_read(uint8_t itf, void* buffer, uint32_t bufsize) {
   cdcd_interface_t* p_cdc = &_cdcd_itf[itf];
-  uint32_t num_read = tu_fifo_read_n(&p_cdc->rx_ff, buffer, (uint16_t) TU_MIN(bufsize, UINT16_MAX));
-  _prep_out_transaction(itf);
+  uint32_t num_read = tu_fifo_read_n(&p_cdc->rx_ff, buffer, (tu_fifo_size_t) TU_MIN(bufsize, TU_FIFO_SIZE_MAX));
+  _rx_consumed(p_cdc, (tu_fifo_size_t) num_read);
+  _prep_out_transaction(itf, false);
   return num_read;
 }
 
+uint32_t tud_cdc_n_line_available(uint8_t itf) {
+  cdcd_interface_t* p_cdc = &_cdcd_itf[itf];
+  TU_VERIFY(((signed char) p_cdc->wanted_char) != -1, 0);
+
+  if (p_cdc->rx_line_len == 0) {
+    // only scan data received since last call, linear and wrapped part of fifo
+    tu_fifo_buffer_info_t info;
+    tu_fifo_get_read_info(&p_cdc->rx_ff, &info);
+
+    uint8_t const* part[2] = { (uint8_t const*) info.ptr_lin, (uint8_t const*) info.ptr_wrap };
+    tu_fifo_size_t const part_len[2] = { info.len_lin, info.len_wrap };
+    tu_fifo_size_t offset = 0;
+
+    for (uint8_t i = 0; i < 2 && p_cdc->rx_line_len == 0; i++) {
+      if (p_cdc->rx_scanned < offset + part_len[i]) {
+        tu_fifo_size_t const start = (tu_fifo_size_t) (p_cdc->rx_scanned - offset);
+        uint8_t const* found = (uint8_t const*) memchr(part[i] + start, p_cdc->wanted_char, part_len[i] - start);
+        if (found) {
+          p_cdc->rx_line_len = (tu_fifo_size_t) (offset + (found - part[i]) + 1);
+        } else {
+          p_cdc->rx_scanned = (tu_fifo_size_t) (offset + part_len[i]);
+        }
+      }
+      offset = (tu_fifo_size_t) (offset + part_len[i]);
+    }
+
+    // line longer than fifo: return what is there, otherwise it can never complete
+    if (p_cdc->rx_line_len == 0 && tu_fifo_full(&p_cdc->rx_ff)) {
+      return tu_fifo_count(&p_cdc->rx_ff);
+    }
+  }
+
+  return p_cdc->rx_line_len;
+}
+
 bool tud_cdc_n_peek(uint8_t itf, uint8_t* chr) {
   return tu_fifo_peek(&_cdcd_itf[itf].rx_ff, chr);
 }
 
+uint32_t tud_cdc_ready_mask(void) {
+  // fifo count is lock-free, no need to track readiness separately
+  uint32_t mask = 0;
+  for (uint8_t i = 0; i < CFG_TUD_CDC; i++) {
+    if (!tu_fifo_empty(&_cdcd_itf[i].rx_ff)) {
+      mask |= TU_BIT(i);
+    }
+  }
+  return mask;
+}
+
+#if CFG_TUSB_OS != OPT_OS_NONE
+uint32_t tud_cdc_wait_ready_mask(uint32_t timeout_ms) {
+  uint32_t mask = tud_cdc_ready_mask();
+  if (mask == 0 && _cdcd_rx_sem && osal_semaphore_wait(_cdcd_rx_sem, timeout_ms)) {
+    mask = tud_cdc_ready_mask();
+  }
+  return mask;
+}
+#endif
+
 void tud_cdc_n_read_flush(uint8_t itf) {
   cdcd_interface_t* p_cdc = &_cdcd_itf[itf];
   tu_fifo_clear(&p_cdc->rx_ff);
-  _prep_out_transaction(itf);
+  p_cdc->rx_scanned = p_cdc->rx_line_len = 0;
+  _prep_out_transaction(itf, false);
 }
 
 //--------------------------------------------------------------------+
 // WRITE API
 //--------------------------------------------------------------------+
-uint32_t tud_cdc_n_write(uint8_t itf, const void* buffer, uint32_t bufsize) {
+// flush if queue more than coalescing threshold (packet size by default), otherwise arm coalescing timeout
+static void _write_flush_if_needed(uint8_t itf) {
   cdcd_interface_t* p_cdc = &_cdcd_itf[itf];
-  uint16_t ret = tu_fifo_write_n(&p_cdc->tx_ff, buffer, (uint16_t) TU_MIN(bufsize, UINT16_MAX));
-
-  // flush if queue more than packet size
-  if (tu_fifo_count(&p_cdc->tx_ff) >= BULK_PACKET_SIZE
-      #if CFG_TUD_CDC_TX_BUFSIZE < BULK_PACKET_SIZE
-      || tu_fifo_full(&p_cdc->tx_ff) // check full if fifo size is less than packet size
-      #endif
+  const uint16_t threshold = tu_edpt_coalesce_threshold(&p_cdc->tx_coalesce, BULK_PACKET_SIZE);
+  if (tu_fifo_count(&p_cdc->tx_ff) >= threshold ||
+      (tu_fifo_depth(&p_cdc->tx_ff) < threshold && tu_fifo_full(&p_cdc->tx_ff)) // fifo size is less than threshold
       ) {
     tud_cdc_n_write_flush(itf);
+  } else if (tu_fifo_count(&p_cdc->tx_ff)) {
+    tu_edpt_coalesce_arm(&p_cdc->tx_coalesce);
   }
+}
 
+uint32_t tud_cdc_n_write(uint8_t itf, const void* buffer, uint32_t bufsize) {
+  cdcd_interface_t* p_cdc = &_cdcd_itf[itf];
+  TU_VERIFY(tu_fifo_depth(&p_cdc->tx_ff), 0); // no storage configured
+  uint32_t ret = tu_fifo_write_n(&p_cdc->tx_ff, buffer, (tu_fifo_size_t) TU_MIN(bufsize, TU_FIFO_SIZE_MAX));
+  _write_flush_if_needed(itf);
   return ret;
 }
 
-uint32_t tud_cdc_n_write_flush(uint8_t itf) {
+uint32_t tud_cdc_n_write_reserve(uint8_t itf, void** buffer, uint32_t bufsize) {
+  cdcd_interface_t* p_cdc = &_cdcd_itf[itf];
+  return tu_fifo_reserve(&p_cdc->tx_ff, buffer, (tu_fifo_size_t) TU_MIN(bufsize, TU_FIFO_SIZE_MAX));
+}
+
+uint32_t tud_cdc_n_write_commit(uint8_t itf, uint32_t count) {
+  cdcd_interface_t* p_cdc = &_cdcd_itf[itf];
+  tu_fifo_commit(&p_cdc->tx_ff, (tu_fifo_size_t) count);
+  _write_flush_if_needed(itf);
+  return count;
+}
+
+bool tud_cdc_n_write_zc(uint8_t itf, void const* buffer, uint32_t bufsize, tud_cdc_write_zc_cb_t done_cb) {
+  cdcd_interface_t* p_cdc = &_cdcd_itf[itf];
+  TU_VERIFY(buffer && bufsize && p_cdc->zc.buf == NULL);
+
+  p_cdc->zc.fifo_before = tu_fifo_count(&p_cdc->tx_ff);
+  p_cdc->zc.sent = 0;
+  p_cdc->zc.inflight = 0;
+  p_cdc->zc.len = bufsize;
+  p_cdc->zc.done_cb = done_cb;
+  p_cdc->zc.buf = (uint8_t const*) buffer;
+
+  tud_cdc_n_write_flush(itf);
+  return true;
+}
+
+bool tud_cdc_n_write_zc_busy(uint8_t itf) {
+  return _cdcd_itf[itf].zc.buf != NULL;
+}
+
+// complete zero-copy write, callback gets number of bytes actually sent (less than requested if aborted)
+static void _write_zc_done(uint8_t itf) {
+  cdcd_interface_t* p_cdc = &_cdcd_itf[itf];
+  uint8_t const* buf = p_cdc->zc.buf;
+  tud_cdc_write_zc_cb_t const done_cb = p_cdc->zc.done_cb;
+  uint32_t const sent = p_cdc->zc.sent;
+
+  p_cdc->zc.buf = NULL;
+  if (buf && done_cb) {
+    done_cb(itf, buf, sent);
+  }
+}
+
+// in_isr is true when called from cdcd_xfer_isr()
+static uint32_t _write_flush(uint8_t itf, bool in_isr) {
   cdcd_interface_t* p_cdc = &_cdcd_itf[itf];
   cdcd_epbuf_t* p_epbuf = &_cdcd_epbuf[itf];
 
   // Skip if usb is not ready yet
-  TU_VERIFY(tud_ready(), 0);
+  TU_VERIFY(tud_rhport_ready(p_cdc->rhport), 0);
+
+  // zero-copy buffer is next: send it directly once fifo bytes queued before it are sent
+  bool const zc_next = (p_cdc->zc.buf != NULL) && (p_cdc->zc.inflight == 0) &&
+                       (p_cdc->zc.fifo_before == 0 || tu_fifo_empty(&p_cdc->tx_ff));
 
   // No data to send
-  if (!tu_fifo_count(&p_cdc->tx_ff)) {
+  if (!zc_next && !tu_fifo_count(&p_cdc->tx_ff)) {
     return 0;
   }
 
-  const uint8_t rhport = 0;
+  TU_VERIFY(!_defer_if_other_core(itf), 0);
+
+  // pending data is being flushed, later completion will continue with what is left
+  tu_edpt_coalesce_disarm(&p_cdc->tx_coalesce);
+
+  const uint8_t rhport = p_cdc->rhport;
 
   // Claim the endpoint
-  TU_VERIFY(usbd_edpt_claim(rhport, p_cdc->ep_in), 0);
+  TU_VERIFY(usbd_edpt_claim_ex(rhport, p_cdc->ep_in, in_isr), 0);
+
+  if (zc_next) {
+    // largest chunk of whole packets that fits transfer length, remaining bytes are sent as last chunk
+    uint32_t const remain = p_cdc->zc.len - p_cdc->zc.sent;
+    uint16_t const chunk = (uint16_t) tu_min32(remain, UINT16_MAX & ~(BULK_PACKET_SIZE - 1u));
+    p_cdc->zc.fifo_before = 0;
+    p_cdc->zc.inflight = chunk;
+    TU_ASSERT(usbd_edpt_xfer(rhport, p_cdc->ep_in, (uint8_t*) (uintptr_t) (p_cdc->zc.buf + p_cdc->zc.sent), chunk), 0);
+    return chunk;
+  }
 
-  // Pull data from FIFO
-  const uint16_t count = tu_fifo_read_n(&p_cdc->tx_ff, p_epbuf->epin, CFG_TUD_CDC_EP_BUFSIZE);
+  // Pull data from FIFO, only what precedes zero-copy buffer if there is one
+  uint16_t bufsize = CFG_TUD_CDC_EP_BUFSIZE;
+  if (p_cdc->zc.buf && p_cdc->zc.fifo_before) {
+    bufsize = (uint16_t) tu_min32(bufsize, p_cdc->zc.fifo_before);
+  }
+  const uint16_t count = (uint16_t) tu_fifo_read_n(&p_cdc->tx_ff, p_epbuf->epin, bufsize);
+  if (p_cdc->zc.buf) {
+    p_cdc->zc.fifo_before = (tu_fifo_size_t) (p_cdc->zc.fifo_before - tu_min32(count, p_cdc->zc.fifo_before));
+  }
 
   if (count) {
     TU_ASSERT(usbd_edpt_xfer(rhport, p_cdc->ep_in, p_epbuf->epin, count), 0);
@@ -220,11 +532,16 @@ uint32_t tud_cdc_n_write_flush(uint8_t itf) {
   }
 }
 
+uint32_t tud_cdc_n_write_flush(uint8_t itf) {
+  return _write_flush(itf, false);
+}
+
 uint32_t tud_cdc_n_write_available(uint8_t itf) {
   return tu_fifo_remaining(&_cdcd_itf[itf].tx_ff);
 }
 
 bool tud_cdc_n_write_clear(uint8_t itf) {
+  _cdcd_itf[itf].zc.fifo_before = 0;
   return tu_fifo_clear(&_cdcd_itf[itf].tx_ff);
 }
 
@@ -233,12 +550,16 @@ bool tud_cdc_n_write_clear(uint8_t itf) {
 //--------------------------------------------------------------------+
 void cdcd_init(void) {
   tu_memclr(_cdcd_itf, sizeof(_cdcd_itf));
-  tu_memclr(&_cdcd_fifo_cfg, sizeof(_cdcd_fifo_cfg));
+
+  #if CFG_TUSB_OS != OPT_OS_NONE
+  _cdcd_rx_sem = osal_semaphore_create(&_cdcd_rx_semdef);
+  #endif
 
   for (uint8_t i = 0; i < CFG_TUD_CDC; i++) {
     cdcd_interface_t* p_cdc = &_cdcd_itf[i];
 
     p_cdc->wanted_char = (char) -1;
+    p_cdc->rx_resume_level = TU_FIFO_SIZE_MAX; // no hysteresis: re-arm once a packet fits
 
     // default line coding is : stop bit = 1, parity = none, data bits = 8
     p_cdc->line_coding.bit_rate = 115200;
@@ -247,38 +568,57 @@ void cdcd_init(void) {
     p_cdc->line_coding.data_bits = 8;
 
     // Config RX fifo
+    #if CFG_TUD_CDC_RX_BUFSIZE > 0
     tu_fifo_config(&p_cdc->rx_ff, p_cdc->rx_ff_buf, TU_ARRAY_SIZE(p_cdc->rx_ff_buf), 1, false);
+    #endif
 
     // Config TX fifo as overwritable at initialization and will be changed to non-overwritable
     // if terminal supports DTR bit. Without DTR we do not know if data is actually polled by terminal.
     // In this way, the most current data is prioritized.
+    #if CFG_TUD_CDC_TX_BUFSIZE > 0
     tu_fifo_config(&p_cdc->tx_ff, p_cdc->tx_ff_buf, TU_ARRAY_SIZE(p_cdc->tx_ff_buf), 1, true);
+    #endif
+
+    #if CFG_TUSB_FIFO_ISR_SAFE
+    tu_fifo_set_isr_safe(&p_cdc->tx_ff, _cdcd_fifo_cfg.tx_isr_safe);
+    #endif
+
+    p_cdc->tx_coalesce.threshold = CFG_TUD_CDC_TX_COALESCE_BYTES;
+    p_cdc->tx_coalesce.timeout = CFG_TUD_CDC_TX_COALESCE_MS;
 
     #if OSAL_MUTEX_REQUIRED
-    osal_mutex_t mutex_rd = osal_mutex_create(&p_cdc->rx_ff_mutex);
-    osal_mutex_t mutex_wr = osal_mutex_create(&p_cdc->tx_ff_mutex);
-    TU_ASSERT(mutex_rd != NULL && mutex_wr != NULL, );
+    p_cdc->rx_mutex = osal_mutex_create(&p_cdc->rx_ff_mutex);
+    p_cdc->tx_mutex = osal_mutex_create(&p_cdc->tx_ff_mutex);
+    TU_ASSERT(p_cdc->rx_mutex != NULL && p_cdc->tx_mutex != NULL, );
 
-    tu_fifo_config_mutex(&p_cdc->rx_ff, NULL, mutex_rd);
-    tu_fifo_config_mutex(&p_cdc->tx_ff, mutex_wr, NULL);
+    // fifo may be configured before tusb_init()
+    tu_fifo_config_mutex(&p_cdc->rx_ff, NULL, _cdcd_fifo_cfg.rx_lockfree ? NULL : p_cdc->rx_mutex);
+    tu_fifo_config_mutex(&p_cdc->tx_ff, _cdcd_fifo_cfg.tx_lockfree ? NULL : p_cdc->tx_mutex, NULL);
     #endif
   }
 }
 
 bool cdcd_deinit(void) {
+  #if CFG_TUSB_OS != OPT_OS_NONE
+  if (_cdcd_rx_sem) {
+    osal_semaphore_delete(_cdcd_rx_sem);
+    _cdcd_rx_sem = NULL;
+  }
+  #endif
+
   #if OSAL_MUTEX_REQUIRED
   for(uint8_t i=0; i<CFG_TUD_CDC; i++) {
     cdcd_interface_t* p_cdc = &_cdcd_itf[i];
-    osal_mutex_t mutex_rd = p_cdc->rx_ff.mutex_rd;
-    osal_mutex_t mutex_wr = p_cdc->tx_ff.mutex_wr;
 
-    if (mutex_rd) {
-      osal_mutex_delete(mutex_rd);
+    if (p_cdc->rx_mutex) {
+      osal_mutex_delete(p_cdc->rx_mutex);
+      p_cdc->rx_mutex = NULL;
       tu_fifo_config_mutex(&p_cdc->rx_ff, NULL, NULL);
     }
 
-    if (mutex_wr) {
-      osal_mutex_delete(mutex_wr);
+    if (p_cdc->tx_mutex) {
+      osal_mutex_delete(p_cdc->tx_mutex);
+      p_cdc->tx_mutex = NULL;
       tu_fifo_config_mutex(&p_cdc->tx_ff, NULL, NULL);
     }
   }
@@ -288,19 +628,21 @@ bool cdcd_deinit(void) {
 }
 
 void cdcd_reset(uint8_t rhport) {
-  (void) rhport;
-
   for (uint8_t i = 0; i < CFG_TUD_CDC; i++) {
     cdcd_interface_t* p_cdc = &_cdcd_itf[i];
+    if (p_cdc->ep_in && p_cdc->rhport != rhport) continue; // opened on other port
 
+    _write_zc_done(i); // return aborted zero-copy buffer to application
     tu_memclr(p_cdc, ITF_MEM_RESET_SIZE);
     if (!_cdcd_fifo_cfg.rx_persistent) {
       tu_fifo_clear(&p_cdc->rx_ff);
+      p_cdc->rx_scanned = p_cdc->rx_line_len = 0;
     }
     if (!_cdcd_fifo_cfg.tx_persistent) {
       tu_fifo_clear(&p_cdc->tx_ff);
     }
     tu_fifo_set_overwritable(&p_cdc->tx_ff, true);
+    tu_edpt_coalesce_disarm(&p_cdc->tx_coalesce);
   }
 }
 
@@ -320,8 +662,13 @@ uint16_t cdcd_open(uint8_t rhport, const tusb_desc_interface_t* itf_desc, uint16
   }
   TU_ASSERT(cdc_id < CFG_TUD_CDC, 0);
 
+  // storage must be configured with tud_cdc_n_configure_fifo_buffer() when there is no internal buffer
+  TU_ASSERT(tu_fifo_depth(&p_cdc->rx_ff) && tu_fifo_depth(&p_cdc->tx_ff), 0);
+
   //------------- Control Interface -------------//
+  p_cdc->rhport = rhport;
   p_cdc->itf_num = itf_desc->bInterfaceNumber;
+  usbd_itf_set_context(rhport, p_cdc->itf_num, p_cdc);
 
   uint16_t drv_len = sizeof(tusb_desc_interface_t);
   const uint8_t* p_desc = tu_desc_next(itf_desc);
@@ -338,6 +685,7 @@ uint16_t cdcd_open(uint8_t rhport, const tusb_desc_interface_t* itf_desc, uint16
 
     TU_ASSERT(usbd_edpt_open(rhport, desc_ep), 0);
     p_cdc->ep_notif = desc_ep->bEndpointAddress;
+    usbd_edpt_set_context(rhport, p_cdc->ep_notif, p_cdc);
 
     drv_len += tu_desc_len(p_desc);
     p_desc = tu_desc_next(p_desc);
@@ -352,12 +700,18 @@ uint16_t cdcd_open(uint8_t rhport, const tusb_desc_interface_t* itf_desc, uint16
 
     // Open endpoint pair
     TU_ASSERT(usbd_open_edpt_pair(rhport, p_desc, 2, TUSB_XFER_BULK, &p_cdc->ep_out, &p_cdc->ep_in), 0);
+    usbd_edpt_set_context(rhport, p_cdc->ep_out, p_cdc);
+    usbd_edpt_set_context(rhport, p_cdc->ep_in, p_cdc);
 
     drv_len += 2 * sizeof(tusb_desc_endpoint_t);
+
+    #if CFG_TUD_CDC_TX_COALESCE_MS
+    usbd_sof_enable(rhport, SOF_CONSUMER_CDC, true); // tick coalescing timeout
+    #endif
   }
 
   // Prepare for incoming data
-  _prep_out_transaction(cdc_id);
+  _prep_out_transaction(cdc_id, false);
 
   return drv_len;
 }
@@ -373,13 +727,19 @@ bool cdcd_control_xfer_cb(uint8_t rhport, uint8_t stage, const tusb_control_requ
   cdcd_interface_t* p_cdc;
 
   // Identify which interface to use
+#if CFG_TUD_ITF_CONTEXT
+  p_cdc = (cdcd_interface_t*) usbd_itf_get_context(rhport, tu_u16_low(request->wIndex));
+  TU_VERIFY(p_cdc != NULL && p_cdc->itf_num == request->wIndex);
+  itf = (uint8_t) (p_cdc - _cdcd_itf);
+#else
   for (itf = 0; itf < CFG_TUD_CDC; itf++) {
     p_cdc = &_cdcd_itf[itf];
-    if (p_cdc->itf_num == request->wIndex) {
+    if (p_cdc->rhport == rhport && p_cdc->itf_num == request->wIndex) {
       break;
     }
   }
   TU_VERIFY(itf < CFG_TUD_CDC);
+#endif
 
   switch (request->bRequest) {
     case CDC_REQUEST_SET_LINE_CODING:
@@ -444,32 +804,37 @@ bool cdcd_control_xfer_cb(uint8_t rhport, uint8_t stage, const tusb_control_requ
   return true;
 }
 
+TU_ATTR_FAST_FUNC static bool cdcd_edpt_match(uint8_t itf, uint8_t rhport, uint8_t ep_addr) {
+  cdcd_interface_t const* p_cdc = &_cdcd_itf[itf];
+  return p_cdc->rhport == rhport &&
+         ((ep_addr == p_cdc->ep_out) || (ep_addr == p_cdc->ep_in) || (ep_addr == p_cdc->ep_notif));
+}
+
 bool cdcd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes) {
   (void) result;
 
-  uint8_t itf;
-  cdcd_interface_t* p_cdc;
-
-  // Identify which interface to use
-  for (itf = 0; itf < CFG_TUD_CDC; itf++) {
-    p_cdc = &_cdcd_itf[itf];
-    if ((ep_addr == p_cdc->ep_out) || (ep_addr == p_cdc->ep_in)) {
-      break;
-    }
-  }
+  uint8_t const itf = usbd_edpt_find_instance(rhport, ep_addr, _cdcd_itf, cdcd_edpt_match);
   TU_ASSERT(itf < CFG_TUD_CDC);
+  cdcd_interface_t* p_cdc = &_cdcd_itf[itf];
   cdcd_epbuf_t* p_epbuf = &_cdcd_epbuf[itf];
 
   // Received new data
   if (ep_addr == p_cdc->ep_out) {
-    tu_fifo_write_n(&p_cdc->rx_ff, p_epbuf->epout, (uint16_t) xferred_bytes);
+    tu_fifo_write_n(&p_cdc->rx_ff, p_epbuf->epout, (tu_fifo_size_t) xferred_bytes);
 
-    // Check for wanted char and invoke callback if needed
+    // Check for wanted char and invoke callback if needed: once per occurrence, or once per packet with line framing
+    // since application pulls all complete lines with tud_cdc_n_line_available()
     if (tud_cdc_rx_wanted_cb && (((signed char) p_cdc->wanted_char) != -1)) {
-      for (uint32_t i = 0; i < xferred_bytes; i++) {
-        if ((p_cdc->wanted_char == p_epbuf->epout[i]) && !tu_fifo_empty(&p_cdc->rx_ff)) {
+      uint8_t const* p = p_epbuf->epout;
+      uint8_t const* const end = p + xferred_bytes;
+      while (p < end && (p = (uint8_t const*) memchr(p, p_cdc->wanted_char, (size_t) (end - p))) != NULL) {
+        if (!tu_fifo_empty(&p_cdc->rx_ff)) {
           tud_cdc_rx_wanted_cb(itf, p_cdc->wanted_char);
         }
+        if (p_cdc->line_framing) {
+          break;
+        }
+        p++;
       }
     }
 
@@ -478,14 +843,28 @@ bool cdcd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_
       tud_cdc_rx_cb(itf);
     }
 
+    #if CFG_TUSB_OS != OPT_OS_NONE
+    if (_cdcd_rx_sem && xferred_bytes) {
+      (void) osal_semaphore_post(_cdcd_rx_sem, false);
+    }
+    #endif
+
     // prepare for OUT transaction
-    _prep_out_transaction(itf);
+    _prep_out_transaction(itf, false);
   }
 
   // Data sent to host, we continue to fetch from tx fifo to send.
   // Note: This will cause incorrect baudrate set in line coding.
   //       Though maybe the baudrate is not really important !!!
   if (ep_addr == p_cdc->ep_in) {
+    if (p_cdc->zc.inflight) {
+      p_cdc->zc.sent += xferred_bytes;
+      p_cdc->zc.inflight = 0;
+      if (p_cdc->zc.sent >= p_cdc->zc.len) {
+        _write_zc_done(itf);
+      }
+    }
+
     // invoke transmit callback to possibly refill tx fifo
     if (tud_cdc_tx_complete_cb) {
       tud_cdc_tx_complete_cb(itf);
@@ -494,7 +873,8 @@ bool cdcd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_
     if (0 == tud_cdc_n_write_flush(itf)) {
       // If there is no data left, a ZLP should be sent if
       // xferred_bytes is multiple of EP Packet size and not zero
-      if (!tu_fifo_count(&p_cdc->tx_ff) && xferred_bytes && (0 == (xferred_bytes & (BULK_PACKET_SIZE - 1)))) {
+      if (!tu_fifo_count(&p_cdc->tx_ff) && !p_cdc->zc.buf && xferred_bytes &&
+          (0 == (xferred_bytes & (BULK_PACKET_SIZE - 1)))) {
         if (usbd_edpt_claim(rhport, p_cdc->ep_in)) {
           usbd_edpt_xfer(rhport, p_cdc->ep_in, NULL, 0);
         }
@@ -502,9 +882,104 @@ bool cdcd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_
     }
   }
 
-  // nothing to do with notif endpoint for now
+  if (ep_addr == p_cdc->ep_notif && p_cdc->serial_state_pending) {
+    _send_serial_state(itf);
+  }
 
   return true;
 }
 
+#if CFG_TUD_CDC_XFER_ISR
+// Invoke receive callbacks for data moved to fifo by cdcd_xfer_isr(). Flags are cleared first so that data received
+// meanwhile schedules another call
+static void cdcd_rx_deferred_cb(void* param) {
+  uint8_t const itf = (uint8_t) (uintptr_t) param;
+  cdcd_interface_t* p_cdc = &_cdcd_itf[itf];
+  TU_VERIFY(p_cdc->isr_rx_pending, ); // cleared by bus reset meanwhile
+
+  p_cdc->isr_rx_pending = false;
+  if (p_cdc->isr_wanted_pending) {
+    p_cdc->isr_wanted_pending = false;
+    if (tud_cdc_rx_wanted_cb && !tu_fifo_empty(&p_cdc->rx_ff)) {
+      tud_cdc_rx_wanted_cb(itf, p_cdc->wanted_char);
+    }
+  }
+
+  if (tud_cdc_rx_cb && !tu_fifo_empty(&p_cdc->rx_ff)) {
+    tud_cdc_rx_cb(itf);
+  }
+}
+
+// Move received data to fifo and re-arm OUT endpoint in ISR, receive callbacks are deferred to usbd task (wanted char
+// callback once per deferred call). IN endpoint is only handled here if no callback is involved, everything else
+// is passed to cdcd_xfer_cb() in usbd task
+TU_ATTR_FAST_FUNC bool cdcd_xfer_isr(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes) {
+  TU_VERIFY(XFER_RESULT_SUCCESS == result);
+
+  uint8_t const itf = usbd_edpt_find_instance(rhport, ep_addr, _cdcd_itf, cdcd_edpt_match);
+  TU_VERIFY(itf < CFG_TUD_CDC);
+  cdcd_interface_t* p_cdc = &_cdcd_itf[itf];
+  cdcd_epbuf_t* p_epbuf = &_cdcd_epbuf[itf];
+
+  if (ep_addr == p_cdc->ep_out) {
+    tu_fifo_write_n(&p_cdc->rx_ff, p_epbuf->epout, (tu_fifo_size_t) xferred_bytes);
+
+    if (tud_cdc_rx_wanted_cb && (((signed char) p_cdc->wanted_char) != -1) &&
+        memchr(p_epbuf->epout, p_cdc->wanted_char, xferred_bytes) != NULL) {
+      p_cdc->isr_wanted_pending = true;
+    }
+
+    _prep_out_transaction(itf, true);
+
+    if ((tud_cdc_rx_cb || p_cdc->isr_wanted_pending) && xferred_bytes && !p_cdc->isr_rx_pending) {
+      p_cdc->isr_rx_pending = true;
+      usbd_defer_func(cdcd_rx_deferred_cb, (void*) (uintptr_t) itf, true);
+    }
+    return true;
+  }
+
+  if (ep_addr == p_cdc->ep_in) {
+    // transmit complete and zero-copy done callbacks run in usbd task
+    TU_VERIFY(!tud_cdc_tx_complete_cb && !p_cdc->zc.buf);
+
+    if (0 == _write_flush(itf, true) && !tu_fifo_count(&p_cdc->tx_ff) && xferred_bytes &&
+        (0 == (xferred_bytes & (BULK_PACKET_SIZE - 1)))) {
+      // ZLP for transfer of multiple of packet size
+      if (usbd_edpt_claim_ex(rhport, p_cdc->ep_in, true)) {
+        usbd_edpt_xfer(rhport, p_cdc->ep_in, NULL, 0);
+      }
+    }
+    return true;
+  }
+
+  return false;
+}
+#endif
+
+#if CFG_TUSB_CORE_AFFINITY >= 0
+static void cdcd_deferred_xfer(void* param) {
+  const uint8_t itf = (uint8_t) (uintptr_t) param;
+  // clear first so that data queued from now on defers another transfer
+  _cdcd_itf[itf].xfer_deferred = 0;
+  _prep_out_transaction(itf, false);
+  tud_cdc_n_write_flush(itf);
+}
+#endif
+
+#if CFG_TUD_CDC_TX_COALESCE_MS
+// flush pending data whose coalescing timeout has expired, deferred from SOF ISR
+static void cdcd_coalesce_flush(void* param) {
+  tud_cdc_n_write_flush((uint8_t) (uintptr_t) param);
+}
+
+void cdcd_sof(uint8_t rhport, uint32_t frame_count) {
+  for (uint8_t itf = 0; itf < CFG_TUD_CDC; itf++) {
+    cdcd_interface_t* p_cdc = &_cdcd_itf[itf];
+    if (p_cdc->ep_in && p_cdc->rhport == rhport && tu_edpt_coalesce_tick(&p_cdc->tx_coalesce, frame_count)) {
+      usbd_defer_func(cdcd_coalesce_flush, (void*) (uintptr_t) itf, true);
+    }
+  }
+}
+#endif
+
 #endif
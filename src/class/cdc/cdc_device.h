@@ -41,6 +41,27 @@
   #define CFG_TUD_CDC_EP_BUFSIZE    (TUD_OPT_HIGH_SPEED ? 512 : 64)
 #endif
 
+// Handle bulk transfer complete directly in ISR (require CFG_TUD_XFER_ISR) for lower latency: received data is moved
+// to fifo and endpoint re-armed in ISR. Application callbacks are still invoked in usbd task
+#ifndef CFG_TUD_CDC_XFER_ISR
+  #define CFG_TUD_CDC_XFER_ISR      0
+#endif
+
+// Write coalescing: data is written to endpoint once this many bytes are queued (0: bulk packet size) ...
+#ifndef CFG_TUD_CDC_TX_COALESCE_BYTES
+  #define CFG_TUD_CDC_TX_COALESCE_BYTES 0
+#endif
+
+// ... or this many ms after the first unflushed byte, without calling tud_cdc_write_flush(). Useful for printf
+// style logging. 0 to disable. SOF interrupt is enabled while mounted
+#ifndef CFG_TUD_CDC_TX_COALESCE_MS
+  #define CFG_TUD_CDC_TX_COALESCE_MS    0
+#endif
+
+#if CFG_TUD_CDC_XFER_ISR && !CFG_TUD_XFER_ISR
+  #error "CFG_TUD_CDC_XFER_ISR requires CFG_TUD_XFER_ISR"
+#endif
+
 #ifdef __cplusplus
  extern "C" {
 #endif
@@ -52,11 +73,20 @@
 typedef struct TU_ATTR_PACKED {
   uint8_t rx_persistent : 1; // keep rx fifo on bus reset or disconnect
   uint8_t tx_persistent : 1; // keep tx fifo on bus reset or disconnect
+  uint8_t rx_lockfree   : 1; // skip rx fifo mutex, only one task reads from this fifo (single consumer)
+  uint8_t tx_lockfree   : 1; // skip tx fifo mutex, only one task writes to this fifo (single producer)
+  uint8_t tx_isr_safe   : 1; // tx fifo can be written from multiple ISRs and tasks, require CFG_TUSB_FIFO_ISR_SAFE
 } tud_cdc_configure_fifo_t;
 
-// Configure CDC FIFOs behavior
+// Configure CDC FIFOs behavior, can be called before or after tusb_init()
 bool tud_cdc_configure_fifo(tud_cdc_configure_fifo_t const* cfg);
 
+// Use application storage for an interface's RX and/or TX FIFO (NULL keeps current one) so that each port can have
+// its own depth. Must be called after tusb_init() while interface is not mounted, RX size must be at least
+// CFG_TUD_CDC_EP_BUFSIZE. With CFG_TUD_CDC_RX_BUFSIZE/CFG_TUD_CDC_TX_BUFSIZE = 0 there is no internal storage and
+// every interface must be configured before it can be mounted.
+bool tud_cdc_n_configure_fifo_buffer(uint8_t itf, void* rx_buf, uint32_t rx_size, void* tx_buf, uint32_t tx_size);
+
 //--------------------------------------------------------------------+
 // Application API (Multiple Ports) i.e. CFG_TUD_CDC > 1
 //--------------------------------------------------------------------+
@@ -76,6 +106,22 @@ void tud_cdc_n_get_line_coding(uint8_t itf, cdc_line_coding_t* coding);
 // Set special character that will trigger tud_cdc_rx_wanted_cb() callback on receiving
 void tud_cdc_n_set_wanted_char(uint8_t itf, char wanted);
 
+// Line framing mode: wanted char is the record delimiter, tud_cdc_rx_wanted_cb() is invoked once per packet that
+// completes at least one line. Lines are then pulled with tud_cdc_n_line_available() and tud_cdc_n_read().
+void tud_cdc_n_set_line_framing(uint8_t itf, bool enabled);
+
+// Get length of first complete line in RX FIFO including wanted char, 0 if there is none. Each received byte is
+// scanned only once across calls. If FIFO is full without a line end, its whole content is returned as a record.
+uint32_t tud_cdc_n_line_available(uint8_t itf);
+
+// Send Serial State notification (DCD, DSR and irregular events such as overrun) on notification endpoint. If a
+// notification is in progress, latest state is sent once it completes. Irregular events are signaled only once.
+bool tud_cdc_n_send_serial_state(uint8_t itf, cdc_serial_state_t state);
+
+// RX flow control: once RX FIFO has no room for another packet, OUT endpoint is NAKed (host pauses without error)
+// until FIFO count drops to resume_level or less. Default is to resume as soon as a packet fits.
+void tud_cdc_n_set_rx_throttle(uint8_t itf, uint32_t resume_level);
+
 // Get the number of bytes available for reading
 uint32_t tud_cdc_n_available(uint8_t itf);
 
@@ -107,15 +153,44 @@ TU_ATTR_ALWAYS_INLINE static inline uint32_t tud_cdc_n_write_str(uint8_t itf, ch
   return tud_cdc_n_write(itf, str, strlen(str));
 }
 
+// Zero-copy write: get pointer to linear free space in TX fifo, return its size (can be less than bufsize at
+// fifo wrap-around). Must be followed by tud_cdc_n_write_commit() with number of bytes actually written.
+uint32_t tud_cdc_n_write_reserve(uint8_t itf, void** buffer, uint32_t bufsize);
+
+// Commit bytes written to reserved space, data is sent if packet size is queued
+uint32_t tud_cdc_n_write_commit(uint8_t itf, uint32_t count);
+
 // Force sending data if possible, return number of forced bytes
 uint32_t tud_cdc_n_write_flush(uint8_t itf);
 
+// Invoked when a zero-copy write buffer is no longer used by the stack, xferred is less than its size if transfer
+// is aborted by bus reset
+typedef void (*tud_cdc_write_zc_cb_t)(uint8_t itf, void const* buffer, uint32_t xferred);
+
+// Zero-copy write: send application buffer directly without copying into TX FIFO, after FIFO data written before
+// it. Buffer must stay valid and untouched until done_cb, and be accessible by USB DMA (CFG_TUD_MEM_SECTION and
+// CFG_TUD_MEM_ALIGN, cache maintained by application if any). Only one buffer per interface can be pending.
+bool tud_cdc_n_write_zc(uint8_t itf, void const* buffer, uint32_t bufsize, tud_cdc_write_zc_cb_t done_cb);
+
+// Check if zero-copy write buffer is still pending
+bool tud_cdc_n_write_zc_busy(uint8_t itf);
+
 // Return the number of bytes (characters) available for writing to TX FIFO buffer in a single n_write operation.
 uint32_t tud_cdc_n_write_available(uint8_t itf);
 
 // Clear the transmit FIFO
 bool tud_cdc_n_write_clear(uint8_t itf);
 
+// Bitmap of interfaces with received data in RX FIFO, bit n for interface n. Multi-port applications can skip idle
+// ports without calling tud_cdc_n_available() on each of them
+uint32_t tud_cdc_ready_mask(void);
+
+#if CFG_TUSB_OS != OPT_OS_NONE
+// Block until any interface has received data or timeout, return tud_cdc_ready_mask() (0 on timeout).
+// Must not be called from the task running tud_task()
+uint32_t tud_cdc_wait_ready_mask(uint32_t timeout_ms);
+#endif
+
 //--------------------------------------------------------------------+
 // Application API (Single Port)
 //--------------------------------------------------------------------+
@@ -140,6 +215,22 @@ TU_ATTR_ALWAYS_INLINE static inline void tud_cdc_set_wanted_char(char wanted) {
   tud_cdc_n_set_wanted_char(0, wanted);
 }
 
+TU_ATTR_ALWAYS_INLINE static inline void tud_cdc_set_line_framing(bool enabled) {
+  tud_cdc_n_set_line_framing(0, enabled);
+}
+
+TU_ATTR_ALWAYS_INLINE static inline uint32_t tud_cdc_line_available(void) {
+  return tud_cdc_n_line_available(0);
+}
+
+TU_ATTR_ALWAYS_INLINE static inline bool tud_cdc_send_serial_state(cdc_serial_state_t state) {
+  return tud_cdc_n_send_serial_state(0, state);
+}
+
+TU_ATTR_ALWAYS_INLINE static inline void tud_cdc_set_rx_throttle(uint32_t resume_level) {
+  tud_cdc_n_set_rx_throttle(0, resume_level);
+}
+
 TU_ATTR_ALWAYS_INLINE static inline uint32_t tud_cdc_available(void) {
   return tud_cdc_n_available(0);
 }
@@ -172,10 +263,22 @@ TU_ATTR_ALWAYS_INLINE static inline uint32_t tud_cdc_write_str(char const* str)
   return tud_cdc_n_write_str(0, str);
 }
 
+TU_ATTR_ALWAYS_INLINE static inline uint32_t tud_cdc_write_reserve(void** buffer, uint32_t bufsize) {
+  return tud_cdc_n_write_reserve(0, buffer, bufsize);
+}
+
+TU_ATTR_ALWAYS_INLINE static inline uint32_t tud_cdc_write_commit(uint32_t count) {
+  return tud_cdc_n_write_commit(0, count);
+}
+
 TU_ATTR_ALWAYS_INLINE static inline uint32_t tud_cdc_write_flush(void) {
   return tud_cdc_n_write_flush(0);
 }
 
+TU_ATTR_ALWAYS_INLINE static inline bool tud_cdc_write_zc(void const* buffer, uint32_t bufsize, tud_cdc_write_zc_cb_t done_cb) {
+  return tud_cdc_n_write_zc(0, buffer, bufsize, done_cb);
+}
+
 TU_ATTR_ALWAYS_INLINE static inline uint32_t tud_cdc_write_available(void) {
   return tud_cdc_n_write_available(0);
 }
@@ -218,6 +321,8 @@ void     cdcd_reset           (uint8_t rhport);
 uint16_t cdcd_open            (uint8_t rhport, tusb_desc_interface_t const * itf_desc, uint16_t max_len);
 bool     cdcd_control_xfer_cb (uint8_t rhport, uint8_t stage, tusb_control_request_t const * request);
 bool     cdcd_xfer_cb         (uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes);
+bool     cdcd_xfer_isr        (uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes);
+void     cdcd_sof             (uint8_t rhport, uint32_t frame_count);
 
 #ifdef __cplusplus
  }
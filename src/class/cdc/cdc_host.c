@@ -43,6 +43,8 @@
 
 #define TU_LOG_DRV(...)   TU_LOG(CFG_TUH_CDC_LOG_LEVEL, __VA_ARGS__)
 
+#define CDCH_RX_MULTI_URB   (CFG_TUH_CDC_RX_XFER_COUNT > 1)
+
 //--------------------------------------------------------------------+
 // Host CDC Interface
 //--------------------------------------------------------------------+
@@ -58,9 +60,23 @@ typedef struct {
   bool mounted;        // Enumeration is complete
   cdc_acm_capability_t acm_capability;
 
+  cdc_serial_state_t serial_state;
+  uint8_t recover_pending; // endpoints (CDCH_EP_ bit) to re-submit after failure
+  uint8_t halt_pending;    // endpoints (CDCH_EP_ bit) to clear halt before re-submit
+  uint8_t err_count;       // consecutive failed transfers
+
+  #if CDCH_RX_MULTI_URB
+  uint8_t rx_head;         // buffer of oldest outstanding RX transfer
+  uint8_t rx_armed;        // number of outstanding RX transfers
+  #endif
+
   TU_ATTR_ALIGNED(4) cdc_line_coding_t line_coding; // Baudrate, stop bits, parity, data width
   uint8_t line_state;                               // DTR (bit0), RTS (bit1)
 
+  #if CFG_TUH_CDC_FTDI
+  uint8_t ftdi_modem_status; // last modem status byte: CTS, DSR, RI, RLSD (bit 4-7)
+  #endif
+
   #if CFG_TUH_CDC_FTDI || CFG_TUH_CDC_CP210X || CFG_TUH_CDC_CH34X
   cdc_line_coding_t requested_line_coding;
   // 1 byte padding
@@ -72,19 +88,121 @@ typedef struct {
     tu_edpt_stream_t tx;
     tu_edpt_stream_t rx;
 
+    #if !CFG_TUH_CDC_FIFO_POOL_SIZE
     uint8_t tx_ff_buf[CFG_TUH_CDC_TX_BUFSIZE];
-    uint8_t rx_ff_buf[CFG_TUH_CDC_TX_BUFSIZE];
+    uint8_t rx_ff_buf[CFG_TUH_CDC_RX_BUFSIZE];
+    #endif
   } stream;
 } cdch_interface_t;
 
 typedef struct {
   TUH_EPBUF_DEF(tx, CFG_TUH_CDC_TX_EPSIZE);
-  TUH_EPBUF_DEF(rx, CFG_TUH_CDC_TX_EPSIZE);
+  TUH_EPBUF_DEF(rx, CFG_TUH_CDC_RX_EPSIZE);
+  TUH_EPBUF_TYPE_DEF(cdc_notify_serial_state_t, notif);
+  #if CDCH_RX_MULTI_URB
+  struct {
+    TUH_EPBUF_DEF(buf, CFG_TUH_CDC_RX_EPSIZE);
+  } rx_multi[CFG_TUH_CDC_RX_XFER_COUNT];
+  #endif
 } cdch_epbuf_t;
 
+enum {
+  CDCH_EP_RX = 0,
+  CDCH_EP_TX,
+  CDCH_EP_NOTIF,
+  CDCH_EP_COUNT
+};
+
+enum {
+  RECOVER_DELAY_MS = 10
+};
+
 static cdch_interface_t cdch_data[CFG_TUH_CDC];
 CFG_TUH_MEM_SECTION static cdch_epbuf_t cdch_epbuf[CFG_TUH_CDC];
 
+//--------------------------------------------------------------------+
+// FIFO Pool
+//--------------------------------------------------------------------+
+#if CFG_TUH_CDC_FIFO_POOL_SIZE
+enum {
+  FIFO_POOL_UNITS = CFG_TUH_CDC_FIFO_POOL_SIZE / CFG_TUH_CDC_FIFO_POOL_UNIT
+};
+
+TU_VERIFY_STATIC(FIFO_POOL_UNITS > 0, "FIFO pool is smaller than its unit");
+
+TU_ATTR_ALIGNED(4) static uint8_t _cdch_fifo_pool[FIFO_POOL_UNITS * CFG_TUH_CDC_FIFO_POOL_UNIT];
+static uint32_t _cdch_fifo_pool_map[(FIFO_POOL_UNITS + 31) / 32]; // bit set if unit is in use
+
+static void fifo_pool_mark(uint32_t first, uint32_t count, bool used) {
+  for (uint32_t u = first; u < first + count; u++) {
+    if (used) {
+      _cdch_fifo_pool_map[u / 32] |= TU_BIT(u % 32);
+    } else {
+      _cdch_fifo_pool_map[u / 32] &= ~TU_BIT(u % 32);
+    }
+  }
+}
+
+// First fit allocation of contiguous units, size is rounded up to multiple of unit
+static uint8_t* fifo_pool_alloc(uint32_t* p_size) {
+  uint32_t const count = tu_div_ceil(*p_size, CFG_TUH_CDC_FIFO_POOL_UNIT);
+  uint32_t run = 0;
+
+  for (uint32_t u = 0; u < FIFO_POOL_UNITS && count; u++) {
+    if (tu_bit_test(_cdch_fifo_pool_map[u / 32], (uint8_t) (u % 32))) {
+      run = 0;
+    } else if (++run == count) {
+      uint32_t const first = u + 1 - count;
+      fifo_pool_mark(first, count, true);
+      *p_size = count * CFG_TUH_CDC_FIFO_POOL_UNIT;
+      return &_cdch_fifo_pool[first * CFG_TUH_CDC_FIFO_POOL_UNIT];
+    }
+  }
+
+  return NULL;
+}
+
+static void fifo_pool_free(tu_edpt_stream_t* s) {
+  uint8_t* buf = s->ff.buffer;
+  if (buf) {
+    uint32_t const first = (uint32_t) (buf - _cdch_fifo_pool) / CFG_TUH_CDC_FIFO_POOL_UNIT;
+    fifo_pool_mark(first, tu_fifo_depth(&s->ff) / CFG_TUH_CDC_FIFO_POOL_UNIT, false);
+    tu_edpt_stream_set_fifo(s, NULL, 0);
+  }
+}
+
+static bool fifo_pool_alloc_stream(tu_edpt_stream_t* s, uint32_t size) {
+  uint8_t* buf = fifo_pool_alloc(&size);
+  if (buf == NULL) {
+    // not enough space left: fall back to a single packet
+    size = s->mps;
+    buf = fifo_pool_alloc(&size);
+    TU_VERIFY(buf);
+  }
+  tu_edpt_stream_set_fifo(s, buf, size);
+  return true;
+}
+
+// Take RX/TX FIFOs from pool once endpoints are opened
+static bool fifo_pool_open(cdch_interface_t* p_cdc) {
+  uint8_t const idx = (uint8_t) (p_cdc - cdch_data);
+  uint32_t rx_bufsize = tu_max32(CFG_TUH_CDC_RX_BUFSIZE, 2u * p_cdc->stream.rx.mps);
+  uint32_t tx_bufsize = tu_max32(CFG_TUH_CDC_TX_BUFSIZE, 2u * p_cdc->stream.tx.mps);
+
+  if (tuh_cdc_fifo_size_cb) {
+    uint16_t vid = 0, pid = 0;
+    (void) tuh_vid_pid_get(p_cdc->daddr, &vid, &pid);
+    tuh_cdc_fifo_size_cb(idx, vid, pid, tuh_speed_get(p_cdc->daddr), &rx_bufsize, &tx_bufsize);
+  }
+
+  TU_ASSERT(fifo_pool_alloc_stream(&p_cdc->stream.rx, tu_min32(rx_bufsize, TU_FIFO_DEPTH_MAX)));
+  TU_ASSERT(fifo_pool_alloc_stream(&p_cdc->stream.tx, tu_min32(tx_bufsize, TU_FIFO_DEPTH_MAX)));
+  TU_LOG_DRV("  CDCh FIFO rx = %" PRIu32 ", tx = %" PRIu32 " from pool\r\n",
+             (uint32_t) tu_fifo_depth(&p_cdc->stream.rx.ff), (uint32_t) tu_fifo_depth(&p_cdc->stream.tx.ff));
+  return true;
+}
+#endif
+
 //--------------------------------------------------------------------+
 // Serial Driver
 //--------------------------------------------------------------------+
@@ -102,7 +220,9 @@ static bool acm_set_control_line_state(cdch_interface_t* p_cdc, uint16_t line_st
 #if CFG_TUH_CDC_FTDI
 #include "serial/ftdi_sio.h"
 
+#ifdef CFG_TUH_CDC_FTDI_VID_PID_LIST
 static uint16_t const ftdi_vid_pid_list[][2] = {CFG_TUH_CDC_FTDI_VID_PID_LIST};
+#endif
 
 static bool ftdi_open(uint8_t daddr, const tusb_desc_interface_t *itf_desc, uint16_t max_len);
 static void ftdi_process_config(tuh_xfer_t* xfer);
@@ -111,13 +231,16 @@ static bool ftdi_sio_set_baudrate(cdch_interface_t* p_cdc, uint32_t baudrate, tu
 static bool ftdi_set_data_format(cdch_interface_t* p_cdc, uint8_t stop_bits, uint8_t parity, uint8_t data_bits, tuh_xfer_cb_t complete_cb, uintptr_t user_data);
 static bool ftdi_set_line_coding(cdch_interface_t* p_cdc, cdc_line_coding_t const* line_coding, tuh_xfer_cb_t complete_cb, uintptr_t user_data);
 static bool ftdi_sio_set_modem_ctrl(cdch_interface_t* p_cdc, uint16_t line_state, tuh_xfer_cb_t complete_cb, uintptr_t user_data);
+static void ftdi_rx_xfer_complete(uint8_t idx, cdch_interface_t* p_cdc, uint32_t xferred_bytes);
 #endif
 
 //------------- CP210X prototypes -------------//
 #if CFG_TUH_CDC_CP210X
 #include "serial/cp210x.h"
 
+#ifdef CFG_TUH_CDC_CP210X_VID_PID_LIST
 static uint16_t const cp210x_vid_pid_list[][2] = {CFG_TUH_CDC_CP210X_VID_PID_LIST};
+#endif
 
 static bool cp210x_open(uint8_t daddr, tusb_desc_interface_t const *itf_desc, uint16_t max_len);
 static void cp210x_process_config(tuh_xfer_t* xfer);
@@ -132,7 +255,9 @@ static bool cp210x_set_modem_ctrl(cdch_interface_t* p_cdc, uint16_t line_state,
 #if CFG_TUH_CDC_CH34X
 #include "serial/ch34x.h"
 
+#ifdef CFG_TUH_CDC_CH34X_VID_PID_LIST
 static uint16_t const ch34x_vid_pid_list[][2] = {CFG_TUH_CDC_CH34X_VID_PID_LIST};
+#endif
 
 static bool ch34x_open(uint8_t daddr, tusb_desc_interface_t const* itf_desc, uint16_t max_len);
 static void ch34x_process_config(tuh_xfer_t* xfer);
@@ -163,7 +288,8 @@ enum {
 };
 
 typedef struct {
-  uint16_t const (*vid_pid_list)[2];
+  uint16_t const quirk; // TUH_QUIRK_SERIAL_ flag of devices in usbh device ID table
+  uint16_t const (*vid_pid_list)[2]; // additional devices, if any
   uint16_t const vid_pid_count;
   bool (*const open)(uint8_t daddr, const tusb_desc_interface_t *itf_desc, uint16_t max_len);
   void (*const process_set_config)(tuh_xfer_t* xfer);
@@ -176,6 +302,7 @@ typedef struct {
 // Note driver list must be in the same order as SERIAL_DRIVER enum
 static const cdch_serial_driver_t serial_drivers[] = {
   {
+      .quirk                  = 0,
       .vid_pid_list           = NULL,
       .vid_pid_count          = 0,
       .open                   = acm_open,
@@ -188,8 +315,11 @@ static const cdch_serial_driver_t serial_drivers[] = {
 
   #if CFG_TUH_CDC_FTDI
   {
+      .quirk                  = TUH_QUIRK_SERIAL_FTDI,
+    #ifdef CFG_TUH_CDC_FTDI_VID_PID_LIST
       .vid_pid_list           = ftdi_vid_pid_list,
       .vid_pid_count          = TU_ARRAY_SIZE(ftdi_vid_pid_list),
+    #endif
       .open                   = ftdi_open,
       .process_set_config     = ftdi_process_config,
       .set_control_line_state = ftdi_sio_set_modem_ctrl,
@@ -201,8 +331,11 @@ static const cdch_serial_driver_t serial_drivers[] = {
 
   #if CFG_TUH_CDC_CP210X
   {
+      .quirk                  = TUH_QUIRK_SERIAL_CP210X,
+    #ifdef CFG_TUH_CDC_CP210X_VID_PID_LIST
       .vid_pid_list           = cp210x_vid_pid_list,
       .vid_pid_count          = TU_ARRAY_SIZE(cp210x_vid_pid_list),
+    #endif
       .open                   = cp210x_open,
       .process_set_config     = cp210x_process_config,
       .set_control_line_state = cp210x_set_modem_ctrl,
@@ -214,8 +347,11 @@ static const cdch_serial_driver_t serial_drivers[] = {
 
   #if CFG_TUH_CDC_CH34X
   {
+      .quirk                  = TUH_QUIRK_SERIAL_CH34X,
+    #ifdef CFG_TUH_CDC_CH34X_VID_PID_LIST
       .vid_pid_list           = ch34x_vid_pid_list,
       .vid_pid_count          = TU_ARRAY_SIZE(ch34x_vid_pid_list),
+    #endif
       .open                   = ch34x_open,
       .process_set_config     = ch34x_process_config,
       .set_control_line_state = ch34x_set_modem_ctrl,
@@ -260,6 +396,11 @@ static cdch_interface_t* make_new_itf(uint8_t daddr, tusb_desc_interface_t const
       p_cdc->bInterfaceSubClass = itf_desc->bInterfaceSubClass;
       p_cdc->bInterfaceProtocol = itf_desc->bInterfaceProtocol;
       p_cdc->line_state         = 0;
+      p_cdc->ep_notif           = 0;
+      p_cdc->serial_state.value = 0;
+      p_cdc->recover_pending    = 0;
+      p_cdc->halt_pending       = 0;
+      p_cdc->err_count          = 0;
       return p_cdc;
     }
   }
@@ -270,6 +411,88 @@ static cdch_interface_t* make_new_itf(uint8_t daddr, tusb_desc_interface_t const
 static bool open_ep_stream_pair(cdch_interface_t* p_cdc , tusb_desc_endpoint_t const *desc_ep);
 static void set_config_complete(cdch_interface_t * p_cdc, uint8_t idx, uint8_t itf_num);
 static void cdch_internal_control_complete(tuh_xfer_t* xfer);
+static void rx_xfer(cdch_interface_t* p_cdc, uint8_t idx);
+static void xfer_failed(cdch_interface_t* p_cdc, uint8_t idx, uint8_t ep_addr, xfer_result_t result);
+
+//--------------------------------------------------------------------+
+// RX transfer
+//--------------------------------------------------------------------+
+
+#if CDCH_RX_MULTI_URB
+TU_ATTR_ALWAYS_INLINE static inline bool rx_is_multi(cdch_interface_t const* p_cdc) {
+  #if CFG_TUH_CDC_FTDI
+  return p_cdc->serial_drid != SERIAL_DRIVER_FTDI;
+  #else
+  (void) p_cdc;
+  return true;
+  #endif
+}
+
+static void rx_multi_complete_cb(tuh_xfer_t* xfer);
+
+// Submit free RX buffers as long as FIFO has room for all outstanding transfers
+static void rx_multi_submit(cdch_interface_t* p_cdc, uint8_t idx) {
+  tu_fifo_t* ff = &p_cdc->stream.rx.ff;
+
+  while (p_cdc->rx_armed < CFG_TUH_CDC_RX_XFER_COUNT &&
+         !tu_bit_test(p_cdc->recover_pending, CDCH_EP_RX) &&
+         tu_fifo_remaining(ff) >= (uint32_t) (p_cdc->rx_armed + 1) * CFG_TUH_CDC_RX_EPSIZE) {
+    uint8_t const b = (uint8_t) ((p_cdc->rx_head + p_cdc->rx_armed) % CFG_TUH_CDC_RX_XFER_COUNT);
+    tuh_xfer_t xfer = {
+        .daddr       = p_cdc->daddr,
+        .ep_addr     = p_cdc->stream.rx.ep_addr,
+        .buflen      = CFG_TUH_CDC_RX_EPSIZE,
+        .buffer      = cdch_epbuf[idx].rx_multi[b].buf,
+        .complete_cb = rx_multi_complete_cb,
+        .user_data   = idx
+    };
+
+    // stop if usbh queue is full, next completion submits the rest
+    if (!tuh_edpt_xfer(&xfer)) {
+      break;
+    }
+    p_cdc->rx_armed++;
+  }
+}
+
+static void rx_multi_complete_cb(tuh_xfer_t* xfer) {
+  uint8_t const idx = (uint8_t) xfer->user_data;
+  cdch_interface_t* p_cdc = get_itf(idx);
+  TU_VERIFY(p_cdc && p_cdc->daddr == xfer->daddr && p_cdc->rx_armed,);
+
+  // completions are in submission order
+  uint8_t const b = p_cdc->rx_head;
+  p_cdc->rx_head = (uint8_t) ((b + 1) % CFG_TUH_CDC_RX_XFER_COUNT);
+  p_cdc->rx_armed--;
+
+  if (xfer->result != XFER_RESULT_SUCCESS) {
+    xfer_failed(p_cdc, idx, xfer->ep_addr, xfer->result);
+    return;
+  }
+  p_cdc->err_count = 0;
+
+  // FIFO room is reserved on submit
+  tu_fifo_write_n(&p_cdc->stream.rx.ff, cdch_epbuf[idx].rx_multi[b].buf, (tu_fifo_size_t) xfer->actual_len);
+
+  if (tuh_cdc_rx_cb) {
+    tuh_cdc_rx_cb(idx);
+  }
+
+  rx_multi_submit(p_cdc, idx);
+}
+#endif
+
+static void rx_xfer(cdch_interface_t* p_cdc, uint8_t idx) {
+  #if CDCH_RX_MULTI_URB
+  if (rx_is_multi(p_cdc)) {
+    rx_multi_submit(p_cdc, idx);
+    return;
+  }
+  #endif
+
+  (void) idx;
+  tu_edpt_stream_read_xfer(p_cdc->daddr, &p_cdc->stream.rx);
+}
 
 //--------------------------------------------------------------------+
 // APPLICATION API
@@ -335,6 +558,14 @@ bool tuh_cdc_get_local_line_coding(uint8_t idx, cdc_line_coding_t* line_coding)
   return true;
 }
 
+bool tuh_cdc_get_serial_state(uint8_t idx, cdc_serial_state_t* serial_state) {
+  cdch_interface_t* p_cdc = get_itf(idx);
+  TU_VERIFY(p_cdc);
+
+  *serial_state = p_cdc->serial_state;
+  return true;
+}
+
 //--------------------------------------------------------------------+
 // Write
 //--------------------------------------------------------------------+
@@ -375,6 +606,15 @@ uint32_t tuh_cdc_read (uint8_t idx, void* buffer, uint32_t bufsize) {
   cdch_interface_t* p_cdc = get_itf(idx);
   TU_VERIFY(p_cdc);
 
+  #if CDCH_RX_MULTI_URB
+  if (rx_is_multi(p_cdc)) {
+    uint32_t const count = tu_fifo_read_n(&p_cdc->stream.rx.ff, buffer,
+                                          (tu_fifo_size_t) tu_min32(bufsize, TU_FIFO_SIZE_MAX));
+    rx_multi_submit(p_cdc, idx);
+    return count;
+  }
+  #endif
+
   return tu_edpt_stream_read(p_cdc->daddr, &p_cdc->stream.rx, buffer, bufsize);
 }
 
@@ -397,7 +637,7 @@ bool tuh_cdc_read_clear (uint8_t idx) {
   TU_VERIFY(p_cdc);
 
   bool ret = tu_edpt_stream_clear(&p_cdc->stream.rx);
-  tu_edpt_stream_read_xfer(p_cdc->daddr, &p_cdc->stream.rx);
+  rx_xfer(p_cdc, idx);
   return ret;
 }
 
@@ -629,6 +869,17 @@ bool cdch_init(void) {
   for (size_t i = 0; i < CFG_TUH_CDC; i++) {
     cdch_interface_t* p_cdc = &cdch_data[i];
     cdch_epbuf_t* epbuf = &cdch_epbuf[i];
+    #if CFG_TUH_CDC_FIFO_POOL_SIZE
+    // FIFOs are taken from pool when opened: init with pool so that mutex is created, then detach
+    tu_edpt_stream_init(&p_cdc->stream.tx, true, true, false,
+                        _cdch_fifo_pool, CFG_TUH_CDC_FIFO_POOL_UNIT,
+                        epbuf->tx, CFG_TUH_CDC_TX_EPSIZE);
+    tu_edpt_stream_init(&p_cdc->stream.rx, true, false, false,
+                        _cdch_fifo_pool, CFG_TUH_CDC_FIFO_POOL_UNIT,
+                        epbuf->rx, CFG_TUH_CDC_RX_EPSIZE);
+    tu_edpt_stream_set_fifo(&p_cdc->stream.tx, NULL, 0);
+    tu_edpt_stream_set_fifo(&p_cdc->stream.rx, NULL, 0);
+    #else
     tu_edpt_stream_init(&p_cdc->stream.tx, true, true, false,
                         p_cdc->stream.tx_ff_buf, CFG_TUH_CDC_TX_BUFSIZE,
                         epbuf->tx, CFG_TUH_CDC_TX_EPSIZE);
@@ -636,6 +887,7 @@ bool cdch_init(void) {
     tu_edpt_stream_init(&p_cdc->stream.rx, true, false, false,
                         p_cdc->stream.rx_ff_buf, CFG_TUH_CDC_RX_BUFSIZE,
                         epbuf->rx, CFG_TUH_CDC_RX_EPSIZE);
+    #endif
   }
 
   return true;
@@ -666,18 +918,167 @@ void cdch_close(uint8_t daddr) {
       p_cdc->mounted = false;
       tu_edpt_stream_close(&p_cdc->stream.tx);
       tu_edpt_stream_close(&p_cdc->stream.rx);
+
+      #if CFG_TUH_CDC_FIFO_POOL_SIZE
+      fifo_pool_free(&p_cdc->stream.tx);
+      fifo_pool_free(&p_cdc->stream.rx);
+      #endif
     }
   }
 }
 
-bool cdch_xfer_cb(uint8_t daddr, uint8_t ep_addr, xfer_result_t event, uint32_t xferred_bytes) {
-  // TODO handle stall response, retry failed transfer ...
-  TU_ASSERT(event == XFER_RESULT_SUCCESS);
+//--------------------------------------------------------------------+
+// Notification & Error Recovery
+//--------------------------------------------------------------------+
+
+static void notif_xfer(cdch_interface_t* p_cdc, uint8_t idx) {
+  // only ACM notification format is known, vendor interrupt endpoints are left idle
+  if (p_cdc->ep_notif && p_cdc->serial_drid == SERIAL_DRIVER_ACM && usbh_edpt_claim(p_cdc->daddr, p_cdc->ep_notif)) {
+    if (!usbh_edpt_xfer(p_cdc->daddr, p_cdc->ep_notif, (uint8_t*) &cdch_epbuf[idx].notif, sizeof(cdc_notify_serial_state_t))) {
+      usbh_edpt_release(p_cdc->daddr, p_cdc->ep_notif);
+    }
+  }
+}
+
+// DCD and DSR are states, the other bits are irregular events which are reported each time they are set
+static void serial_state_update(cdch_interface_t* p_cdc, uint8_t idx, uint16_t value) {
+  uint16_t const state_mask = 0x0003;
+  bool const changed = ((value ^ p_cdc->serial_state.value) & state_mask) || (value & ~state_mask);
+
+  p_cdc->serial_state.value = value;
+  if (changed && tuh_cdc_serial_state_cb) {
+    tuh_cdc_serial_state_cb(idx, p_cdc->serial_state);
+  }
+}
+
+static void notif_process(cdch_interface_t* p_cdc, uint8_t idx, uint32_t xferred_bytes) {
+  cdc_notify_serial_state_t const* notif = &cdch_epbuf[idx].notif;
+  TU_VERIFY(xferred_bytes >= sizeof(tusb_control_request_t),);
+
+  if (notif->header.bRequest == CDC_NOTIF_SERIAL_STATE && xferred_bytes >= sizeof(cdc_notify_serial_state_t)) {
+    TU_LOG_DRV("  CDCh Serial State = 0x%04X\r\n", tu_le16toh(notif->serial_state.value));
+    serial_state_update(p_cdc, idx, tu_le16toh(notif->serial_state.value));
+  } else {
+    TU_LOG_DRV("  CDCh Notification %02X ignored\r\n", notif->header.bRequest);
+  }
+}
+
+static uint8_t edpt_id(cdch_interface_t const* p_cdc, uint8_t ep_addr) {
+  if (ep_addr == p_cdc->stream.rx.ep_addr) {
+    return CDCH_EP_RX;
+  } else if (ep_addr == p_cdc->stream.tx.ep_addr) {
+    return CDCH_EP_TX;
+  } else {
+    return CDCH_EP_NOTIF;
+  }
+}
+
+static uint8_t edpt_addr(cdch_interface_t const* p_cdc, uint8_t id) {
+  switch (id) {
+    case CDCH_EP_RX: return p_cdc->stream.rx.ep_addr;
+    case CDCH_EP_TX: return p_cdc->stream.tx.ep_addr;
+    default:         return p_cdc->ep_notif;
+  }
+}
+
+static void edpt_resubmit(cdch_interface_t* p_cdc, uint8_t idx, uint8_t id) {
+  switch (id) {
+    case CDCH_EP_RX:
+      rx_xfer(p_cdc, idx);
+      break;
+
+    case CDCH_EP_TX:
+      tu_edpt_stream_write_xfer(p_cdc->daddr, &p_cdc->stream.tx);
+      break;
+
+    default:
+      notif_xfer(p_cdc, idx);
+      break;
+  }
+}
 
+static void recover_process(void* param);
+
+static void clear_halt_complete(tuh_xfer_t* xfer) {
+  uint8_t const idx = (uint8_t) xfer->user_data;
+  cdch_interface_t* p_cdc = get_itf(idx);
+  TU_VERIFY(p_cdc && p_cdc->daddr == xfer->daddr,);
+
+  // halt is cleared one endpoint at a time: the first one pending
+  for (uint8_t id = 0; id < CDCH_EP_COUNT; id++) {
+    if (tu_bit_test(p_cdc->halt_pending, id)) {
+      p_cdc->halt_pending = (uint8_t) tu_bit_clear(p_cdc->halt_pending, id);
+      if (xfer->result != XFER_RESULT_SUCCESS) {
+        TU_LOG_DRV("  CDCh failed to clear halt EP %02X\r\n", edpt_addr(p_cdc, id));
+        p_cdc->recover_pending = (uint8_t) tu_bit_clear(p_cdc->recover_pending, id);
+      }
+      break;
+    }
+  }
+
+  recover_process((void*) (uintptr_t) idx);
+}
+
+// Clear halt of stalled endpoints then re-submit failed ones, run in usbh task
+static void recover_process(void* param) {
+  uint8_t const idx = (uint8_t) (uintptr_t) param;
+  cdch_interface_t* p_cdc = get_itf(idx);
+  TU_VERIFY(p_cdc,);
+
+  for (uint8_t id = 0; id < CDCH_EP_COUNT; id++) {
+    if (tu_bit_test(p_cdc->halt_pending, id)) {
+      if (!tuh_edpt_clear_halt(p_cdc->daddr, edpt_addr(p_cdc, id), clear_halt_complete, idx)) {
+        // control endpoint is busy, try again later
+        usbh_defer_func_ms(recover_process, param, RECOVER_DELAY_MS);
+      }
+      return; // continued in clear_halt_complete()
+    }
+  }
+
+  for (uint8_t id = 0; id < CDCH_EP_COUNT; id++) {
+    if (tu_bit_test(p_cdc->recover_pending, id)) {
+      p_cdc->recover_pending = (uint8_t) tu_bit_clear(p_cdc->recover_pending, id);
+      edpt_resubmit(p_cdc, idx, id);
+    }
+  }
+}
+
+static void xfer_failed(cdch_interface_t* p_cdc, uint8_t idx, uint8_t ep_addr, xfer_result_t result) {
+  TU_LOG_DRV("  CDCh EP %02X %s\r\n", ep_addr, result == XFER_RESULT_STALLED ? "stalled" : "failed");
+  uint8_t const id = edpt_id(p_cdc, ep_addr);
+  if (tu_bit_test(p_cdc->recover_pending, id)) {
+    return; // other queued transfers of an endpoint already being recovered
+  }
+
+  if (p_cdc->err_count >= CFG_TUH_CDC_XFER_RETRY) {
+    TU_LOG_DRV("  CDCh too many errors, EP %02X is stopped\r\n", ep_addr);
+    return;
+  }
+  p_cdc->err_count++;
+
+  bool const idle = (p_cdc->recover_pending == 0);
+  p_cdc->recover_pending = (uint8_t) tu_bit_set(p_cdc->recover_pending, id);
+  if (result == XFER_RESULT_STALLED) {
+    p_cdc->halt_pending = (uint8_t) tu_bit_set(p_cdc->halt_pending, id);
+  }
+
+  // back off a bit, also let a transient error (e.g. device busy) settle
+  if (idle) {
+    usbh_defer_func_ms(recover_process, (void*) (uintptr_t) idx, RECOVER_DELAY_MS);
+  }
+}
+
+bool cdch_xfer_cb(uint8_t daddr, uint8_t ep_addr, xfer_result_t event, uint32_t xferred_bytes) {
   uint8_t const idx = get_idx_by_ep_addr(daddr, ep_addr);
   cdch_interface_t * p_cdc = get_itf(idx);
   TU_ASSERT(p_cdc);
 
+  if (event != XFER_RESULT_SUCCESS) {
+    xfer_failed(p_cdc, idx, ep_addr, event);
+    return true;
+  }
+  p_cdc->err_count = 0;
+
   if ( ep_addr == p_cdc->stream.tx.ep_addr ) {
     // invoke tx complete callback to possibly refill tx fifo
     if (tuh_cdc_tx_complete_cb) {
@@ -692,9 +1093,7 @@ bool cdch_xfer_cb(uint8_t daddr, uint8_t ep_addr, xfer_result_t event, uint32_t
   } else if ( ep_addr == p_cdc->stream.rx.ep_addr ) {
     #if CFG_TUH_CDC_FTDI
     if (p_cdc->serial_drid == SERIAL_DRIVER_FTDI) {
-      // FTDI reserve 2 bytes for status
-      // uint8_t status[2] = {p_cdc->stream.rx.ep_buf[0], p_cdc->stream.rx.ep_buf[1]};
-      tu_edpt_stream_read_xfer_complete_offset(&p_cdc->stream.rx, xferred_bytes, 2);
+      ftdi_rx_xfer_complete(idx, p_cdc, xferred_bytes);
     }else
     #endif
     {
@@ -709,7 +1108,8 @@ bool cdch_xfer_cb(uint8_t daddr, uint8_t ep_addr, xfer_result_t event, uint32_t
     // prepare for next transfer if needed
     tu_edpt_stream_read_xfer(daddr, &p_cdc->stream.rx);
   }else if ( ep_addr == p_cdc->ep_notif ) {
-    // TODO handle notification endpoint
+    notif_process(p_cdc, idx, xferred_bytes);
+    notif_xfer(p_cdc, idx);
   }else {
     TU_ASSERT(false);
   }
@@ -736,6 +1136,10 @@ static bool open_ep_stream_pair(cdch_interface_t* p_cdc, tusb_desc_endpoint_t co
     desc_ep = (tusb_desc_endpoint_t const*) tu_desc_next(desc_ep);
   }
 
+  #if CFG_TUH_CDC_FIFO_POOL_SIZE
+  TU_ASSERT(fifo_pool_open(p_cdc));
+  #endif
+
   return true;
 }
 
@@ -751,9 +1155,13 @@ bool cdch_open(uint8_t rhport, uint8_t daddr, tusb_desc_interface_t const *itf_d
              TUSB_CLASS_VENDOR_SPECIFIC == itf_desc->bInterfaceClass) {
     uint16_t vid, pid;
     TU_VERIFY(tuh_vid_pid_get(daddr, &vid, &pid));
+    uint16_t const quirks = tuh_quirks_get(daddr);
 
     for (size_t dr = 1; dr < SERIAL_DRIVER_COUNT; dr++) {
       cdch_serial_driver_t const* driver = &serial_drivers[dr];
+      if (quirks & driver->quirk) {
+        return driver->open(daddr, itf_desc, max_len);
+      }
       for (size_t i = 0; i < driver->vid_pid_count; i++) {
         if (driver->vid_pid_list[i][0] == vid && driver->vid_pid_list[i][1] == pid) {
           return driver->open(daddr, itf_desc, max_len);
@@ -772,8 +1180,9 @@ static void set_config_complete(cdch_interface_t * p_cdc, uint8_t idx, uint8_t i
     tuh_cdc_mount_cb(idx);
   }
 
-  // Prepare for incoming data
-  tu_edpt_stream_read_xfer(p_cdc->daddr, &p_cdc->stream.rx);
+  // Prepare for incoming data and notification
+  rx_xfer(p_cdc, idx);
+  notif_xfer(p_cdc, idx);
 
   // notify usbh that driver enumeration is complete
   usbh_driver_set_config_complete(p_cdc->daddr, itf_num);
@@ -996,6 +1405,7 @@ static bool ftdi_open(uint8_t daddr, const tusb_desc_interface_t *itf_desc, uint
 
   TU_LOG_DRV("FTDI opened\r\n");
   p_cdc->serial_drid = SERIAL_DRIVER_FTDI;
+  p_cdc->ftdi_modem_status = 0;
 
   // endpoint pair
   tusb_desc_endpoint_t const * desc_ep = (tusb_desc_endpoint_t const *) tu_desc_next(itf_desc);
@@ -1004,6 +1414,40 @@ static bool ftdi_open(uint8_t daddr, const tusb_desc_interface_t *itf_desc, uint
   return open_ep_stream_pair(p_cdc, desc_ep);
 }
 
+// Every packet (not transfer) starts with 2 status bytes: modem status then line status
+static void ftdi_rx_xfer_complete(uint8_t idx, cdch_interface_t* p_cdc, uint32_t xferred_bytes) {
+  uint8_t const* buf = p_cdc->stream.rx.ep_buf;
+  uint16_t const mps = p_cdc->stream.rx.mps;
+  uint8_t const line_err_mask = FTDI_RS_OE | FTDI_RS_PE | FTDI_RS_FE | FTDI_RS_BI;
+  uint8_t modem_status = p_cdc->ftdi_modem_status;
+  uint8_t line_status = 0;
+
+  for (uint32_t ofs = 0; ofs + 2 <= xferred_bytes; ofs += mps) {
+    modem_status = buf[ofs] & 0xf0;
+    line_status |= buf[ofs + 1] & line_err_mask;
+  }
+
+  // status must be captured before de-framing, which may compact parked payload over it
+  tu_edpt_stream_read_xfer_complete_framed(&p_cdc->stream.rx, xferred_bytes, 2);
+
+  if (modem_status != p_cdc->ftdi_modem_status || line_status) {
+    p_cdc->ftdi_modem_status = modem_status;
+    if (tuh_cdc_ftdi_status_cb) {
+      tuh_cdc_ftdi_status_cb(idx, modem_status, line_status);
+    }
+
+    cdc_serial_state_t serial_state = {.value = 0};
+    serial_state.rx_carrier = (modem_status & FTDI_RS0_RLSD) ? 1u : 0u;
+    serial_state.tx_carrier = (modem_status & FTDI_RS0_DSR) ? 1u : 0u;
+    serial_state.ring       = (modem_status & FTDI_RS0_RI) ? 1u : 0u;
+    serial_state.brk        = (line_status & FTDI_RS_BI) ? 1u : 0u;
+    serial_state.framing    = (line_status & FTDI_RS_FE) ? 1u : 0u;
+    serial_state.parity     = (line_status & FTDI_RS_PE) ? 1u : 0u;
+    serial_state.overrun    = (line_status & FTDI_RS_OE) ? 1u : 0u;
+    serial_state_update(p_cdc, idx, serial_state.value);
+  }
+}
+
 // set request without data
 static bool ftdi_sio_set_request(cdch_interface_t* p_cdc, uint8_t command, uint16_t value, tuh_xfer_cb_t complete_cb, uintptr_t user_data) {
   tusb_control_request_t const request = {
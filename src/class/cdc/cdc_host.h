@@ -52,7 +52,8 @@
 #define CFG_TUH_CDC_RX_BUFSIZE USBH_EPSIZE_BULK_MAX
 #endif
 
-// RX Endpoint size
+// RX Endpoint buffer size, multiple of max packet size. Larger buffer allows multi-packet transfer (e.g. 4KB for
+// highspeed device), transfer is sized to multiple of packet size fitting RX FIFO remaining
 #ifndef CFG_TUH_CDC_RX_EPSIZE
 #define CFG_TUH_CDC_RX_EPSIZE  USBH_EPSIZE_BULK_MAX
 #endif
@@ -67,6 +68,37 @@
 #define CFG_TUH_CDC_TX_EPSIZE  USBH_EPSIZE_BULK_MAX
 #endif
 
+// Size of buffer pool shared by RX/TX FIFOs of all interfaces. 0 means each interface has its own FIFOs of
+// CFG_TUH_CDC_RX_BUFSIZE/TX_BUFSIZE. Otherwise FIFOs are carved from pool when interface is opened (size is decided by
+// tuh_cdc_fifo_size_cb()) and returned when closed, so that unmounted interfaces take no FIFO memory.
+#ifndef CFG_TUH_CDC_FIFO_POOL_SIZE
+#define CFG_TUH_CDC_FIFO_POOL_SIZE 0
+#endif
+
+// Allocation unit of FIFO pool, FIFO sizes are rounded up to multiple of it
+#ifndef CFG_TUH_CDC_FIFO_POOL_UNIT
+#define CFG_TUH_CDC_FIFO_POOL_UNIT 64
+#endif
+
+// Number of RX transfers of CFG_TUH_CDC_RX_EPSIZE kept outstanding (1 to 4). With more than 1, next transfers are
+// queued behind the active one so that device keeps sending while received data is processed. A transfer is only
+// submitted when RX FIFO has room for it: CFG_TUH_CDC_RX_BUFSIZE should be at least count * CFG_TUH_CDC_RX_EPSIZE.
+// Require CFG_TUH_EDPT_XFER_QUEUE. FTDI always uses single transfer since its status bytes are stripped in place
+#ifndef CFG_TUH_CDC_RX_XFER_COUNT
+#define CFG_TUH_CDC_RX_XFER_COUNT 1
+#endif
+
+#if CFG_TUH_CDC_RX_XFER_COUNT < 1 || CFG_TUH_CDC_RX_XFER_COUNT > 4 || \
+    (CFG_TUH_CDC_RX_XFER_COUNT > 1 && !CFG_TUH_EDPT_XFER_QUEUE)
+  #error "CFG_TUH_CDC_RX_XFER_COUNT must be 1 to 4, more than 1 requires CFG_TUH_EDPT_XFER_QUEUE"
+#endif
+
+// Number of consecutive failed/stalled transfers recovered (clear halt if stalled, then re-submit) before
+// an endpoint is given up. Counter is reset by any successful transfer of the interface
+#ifndef CFG_TUH_CDC_XFER_RETRY
+#define CFG_TUH_CDC_XFER_RETRY 3
+#endif
+
 //--------------------------------------------------------------------+
 // Application API
 //--------------------------------------------------------------------+
@@ -99,6 +131,10 @@ TU_ATTR_ALWAYS_INLINE static inline bool tuh_cdc_connected(uint8_t idx) {
 // NOTE: This function does not make any USB transfer request to device.
 bool tuh_cdc_get_local_line_coding(uint8_t idx, cdc_line_coding_t* line_coding);
 
+// Get latest serial state: DCD, DSR and events of last notification (ring, break, errors).
+// Reported by ACM SERIAL_STATE notification or FTDI status bytes, no USB transfer is made
+bool tuh_cdc_get_serial_state(uint8_t idx, cdc_serial_state_t* serial_state);
+
 //--------------------------------------------------------------------+
 // Write API
 //--------------------------------------------------------------------+
@@ -188,6 +224,21 @@ TU_ATTR_WEAK extern void tuh_cdc_rx_cb(uint8_t idx);
 // Invoked when a TX is complete and therefore space becomes available in TX buffer
 TU_ATTR_WEAK extern void tuh_cdc_tx_complete_cb(uint8_t idx);
 
+// Invoked when DCD/DSR changes or an event (ring, break, framing/parity/overrun error) is reported
+TU_ATTR_WEAK extern void tuh_cdc_serial_state_cb(uint8_t idx, cdc_serial_state_t serial_state);
+
+#if CFG_TUH_CDC_FIFO_POOL_SIZE
+// Invoked when opening an interface to decide its FIFO sizes taken from pool (CFG_TUH_CDC_FIFO_POOL_SIZE).
+// rx_bufsize/tx_bufsize are pre-filled with defaults: CFG_TUH_CDC_RX_BUFSIZE/TX_BUFSIZE but at least 2 packets of
+// endpoint. If pool has not enough space left, FIFOs are reduced to 1 packet
+TU_ATTR_WEAK extern void tuh_cdc_fifo_size_cb(uint8_t idx, uint16_t vid, uint16_t pid, tusb_speed_t speed,
+                                              uint32_t* rx_bufsize, uint32_t* tx_bufsize);
+#endif
+
+// Invoked when FTDI modem status changes or line errors are reported in received packets.
+// modem_status: CTS, DSR, RI, RLSD (bit 4-7), line_status: accumulated OE, PE, FE, BI (bit 1-4)
+TU_ATTR_WEAK extern void tuh_cdc_ftdi_status_cb(uint8_t idx, uint8_t modem_status, uint8_t line_status);
+
 //--------------------------------------------------------------------+
 // Internal Class Driver API
 //--------------------------------------------------------------------+
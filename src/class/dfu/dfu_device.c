@@ -33,6 +33,10 @@
 
 #include "dfu_device.h"
 
+#if CFG_TUD_DFU_DOUBLE_BUFFER
+#include "tusb.h" // for tusb_time_millis_api()
+#endif
+
 //--------------------------------------------------------------------+
 // MACRO CONSTANT TYPEDEF
 //--------------------------------------------------------------------+
@@ -57,6 +61,15 @@ typedef struct {
   bool flashing_in_progress;
   uint16_t block;
   uint16_t length;
+  uint8_t buf_idx;          // transfer buffer of next received block
+  uint16_t xfer_size[CFG_TUD_DFU_ALT_MAX]; // wTransferSize of each alternate setting
+
+#if CFG_TUD_DFU_DOUBLE_BUFFER
+  // flashing_in_progress only tracks application, received block/manifest is pending until it is handed over
+  bool manifest_pending;
+  uint32_t flash_start_ms;
+  uint32_t flash_timeout_ms;
+#endif
 } dfu_state_ctx_t;
 
 // Only a single dfu state is allowed
@@ -64,14 +77,55 @@ static dfu_state_ctx_t _dfu_ctx;
 
 CFG_TUD_MEM_SECTION static struct {
   TUD_EPBUF_DEF(transfer_buf, CFG_TUD_DFU_XFER_BUFSIZE);
+#if CFG_TUD_DFU_DOUBLE_BUFFER
+  TUD_EPBUF_DEF(transfer_buf2, CFG_TUD_DFU_XFER_BUFSIZE);
+#endif
 } _dfu_epbuf;
 
 static void reset_state(void) {
   _dfu_ctx.state = DFU_IDLE;
   _dfu_ctx.status = DFU_STATUS_OK;
   _dfu_ctx.flashing_in_progress = false;
+  _dfu_ctx.buf_idx = 0;
+#if CFG_TUD_DFU_DOUBLE_BUFFER
+  _dfu_ctx.manifest_pending = false;
+#endif
+}
+
+// application transfer buffer, NULL for internal one
+static uint8_t* _dfu_app_buf;
+static uint32_t _dfu_app_bufsize;
+
+// size of a single transfer buffer
+static uint32_t transfer_bufsize(void) {
+  uint32_t const n_buf = CFG_TUD_DFU_DOUBLE_BUFFER ? 2 : 1;
+  return _dfu_app_buf ? (_dfu_app_bufsize / n_buf) : CFG_TUD_DFU_XFER_BUFSIZE;
+}
+
+TU_ATTR_ALWAYS_INLINE static inline uint16_t alt_xfer_size(uint8_t alt) {
+  return _dfu_ctx.xfer_size[tu_min8(alt, CFG_TUD_DFU_ALT_MAX - 1)];
 }
 
+#if CFG_TUD_DFU_DOUBLE_BUFFER
+static uint8_t* download_buf(uint8_t idx) {
+  if (_dfu_app_buf) {
+    return _dfu_app_buf + (idx ? transfer_bufsize() : 0);
+  }
+  return idx ? _dfu_epbuf.transfer_buf2 : _dfu_epbuf.transfer_buf;
+}
+
+// remaining time of block being flashed, part of it is already spent while next block was received
+static uint32_t flash_remaining_ms(void) {
+  uint32_t const elapsed = tusb_time_millis_api() - _dfu_ctx.flash_start_ms;
+  return (elapsed < _dfu_ctx.flash_timeout_ms) ? (_dfu_ctx.flash_timeout_ms - elapsed) : 0;
+}
+#else
+TU_ATTR_ALWAYS_INLINE static inline uint8_t* download_buf(uint8_t idx) {
+  (void) idx;
+  return _dfu_app_buf ? _dfu_app_buf : _dfu_epbuf.transfer_buf;
+}
+#endif
+
 static bool reply_getstatus(uint8_t rhport, const tusb_control_request_t* request, dfu_state_t state, dfu_status_t status, uint32_t timeout);
 static bool process_download_get_status(uint8_t rhport, uint8_t stage, const tusb_control_request_t* request);
 static bool process_manifest_get_status(uint8_t rhport, uint8_t stage, const tusb_control_request_t* request);
@@ -169,30 +223,56 @@ uint16_t dfu_moded_open(uint8_t rhport, const tusb_desc_interface_t* itf_desc, u
   uint16_t drv_len = 0;
   TU_VERIFY(itf_desc->bInterfaceSubClass == TUD_DFU_APP_SUBCLASS && itf_desc->bInterfaceProtocol == DFU_PROTOCOL_DFU, 0);
 
-  while(itf_desc->bInterfaceSubClass == TUD_DFU_APP_SUBCLASS && itf_desc->bInterfaceProtocol == DFU_PROTOCOL_DFU) {
-    TU_ASSERT(max_len > drv_len, 0);
+  // Functional descriptor either follows all alternate settings, or each alternate setting has its own one
+  uint8_t sized_count = 0; // alternate settings with known transfer size
+  bool has_func = false;
+  bool size_ok = true;
 
-    // Alternate must have the same interface number
-    TU_ASSERT(itf_desc->bInterfaceNumber == itf_num, 0);
+  while (drv_len < max_len) {
+    const uint8_t* p_desc = (const uint8_t*) itf_desc;
 
-    // Alt should increase by one every time
-    TU_ASSERT(itf_desc->bAlternateSetting == alt_count, 0);
-    alt_count++;
+    if (tu_desc_type(p_desc) == TUSB_DESC_INTERFACE) {
+      if (itf_desc->bInterfaceSubClass != TUD_DFU_APP_SUBCLASS || itf_desc->bInterfaceProtocol != DFU_PROTOCOL_DFU) {
+        break;
+      }
+
+      // Alternate must have the same interface number
+      TU_ASSERT(itf_desc->bInterfaceNumber == itf_num, 0);
+
+      // Alt should increase by one every time
+      TU_ASSERT(itf_desc->bAlternateSetting == alt_count, 0);
+      alt_count++;
+    } else if (tu_desc_type(p_desc) == TUSB_DESC_FUNCTIONAL) {
+      //------------- DFU Functional descriptor -------------//
+      const tusb_desc_dfu_functional_t* func_desc = (const tusb_desc_dfu_functional_t*) p_desc;
+      TU_ASSERT(alt_count > sized_count, 0);
+      if (!has_func) {
+        _dfu_ctx.attrs = func_desc->bAttributes;
+        has_func = true;
+      }
+
+      // transfer size must fit transfer buffer: CFG_TUD_DFU_XFER_BUFSIZE or the one of tud_dfu_set_transfer_buffer()
+      const uint16_t transfer_size = tu_le16toh(tu_unaligned_read16(p_desc + offsetof(tusb_desc_dfu_functional_t, wTransferSize)));
+      size_ok = size_ok && (transfer_size <= transfer_bufsize());
+
+      for (; sized_count < alt_count; sized_count++) {
+        if (sized_count < CFG_TUD_DFU_ALT_MAX - 1) {
+          _dfu_ctx.xfer_size[sized_count] = transfer_size;
+        } else {
+          uint16_t* last = &_dfu_ctx.xfer_size[CFG_TUD_DFU_ALT_MAX - 1];
+          *last = (sized_count == CFG_TUD_DFU_ALT_MAX - 1) ? transfer_size : tu_min16(*last, transfer_size);
+        }
+      }
+    } else {
+      break;
+    }
 
-    drv_len += tu_desc_len(itf_desc);
-    itf_desc = (const tusb_desc_interface_t*) tu_desc_next(itf_desc);
+    drv_len += tu_desc_len(p_desc);
+    itf_desc = (const tusb_desc_interface_t*) tu_desc_next(p_desc);
   }
 
-  //------------- DFU Functional descriptor -------------//
-  const tusb_desc_dfu_functional_t*func_desc = (const tusb_desc_dfu_functional_t*) itf_desc;
-  TU_ASSERT(tu_desc_type(func_desc) == TUSB_DESC_FUNCTIONAL, 0);
-  drv_len += sizeof(tusb_desc_dfu_functional_t);
-
-  _dfu_ctx.attrs = func_desc->bAttributes;
-
-  // CFG_TUD_DFU_XFER_BUFSIZE has to be set to the buffer size used in TUD_DFU_DESCRIPTOR
-  const uint16_t transfer_size = tu_le16toh( tu_unaligned_read16((const uint8_t*) func_desc + offsetof(tusb_desc_dfu_functional_t, wTransferSize)) );
-  TU_ASSERT(transfer_size <= CFG_TUD_DFU_XFER_BUFSIZE, drv_len);
+  TU_ASSERT(has_func && sized_count == alt_count, 0);
+  TU_ASSERT(size_ok, drv_len);
 
   return drv_len;
 }
@@ -267,13 +347,22 @@ bool dfu_moded_control_xfer_cb(uint8_t rhport, uint8_t stage, const tusb_control
       case DFU_REQUEST_UPLOAD:
         if (stage == CONTROL_STAGE_SETUP) {
           TU_VERIFY(_dfu_ctx.attrs & DFU_ATTR_CAN_UPLOAD);
+
+          if (tud_dfu_upload_direct_cb) {
+            uint8_t const* data = NULL;
+            const uint16_t xfer_len = tud_dfu_upload_direct_cb(_dfu_ctx.alt, request->wValue, &data, request->wLength);
+            if (data) {
+              return tud_control_xfer_direct(rhport, request, (void*) (uintptr_t) data, xfer_len);
+            }
+          }
+
           TU_VERIFY(tud_dfu_upload_cb);
-          TU_VERIFY(request->wLength <= CFG_TUD_DFU_XFER_BUFSIZE);
+          TU_VERIFY(request->wLength <= alt_xfer_size(_dfu_ctx.alt));
 
-          const uint16_t xfer_len = tud_dfu_upload_cb(_dfu_ctx.alt, request->wValue, _dfu_epbuf.transfer_buf,
-                                                      request->wLength);
+          uint8_t* buf = download_buf(0);
+          const uint16_t xfer_len = tud_dfu_upload_cb(_dfu_ctx.alt, request->wValue, buf, request->wLength);
 
-          return tud_control_xfer(rhport, request, _dfu_epbuf.transfer_buf, xfer_len);
+          return tud_control_xfer_direct(rhport, request, buf, xfer_len);
         }
         break;
 
@@ -281,10 +370,15 @@ bool dfu_moded_control_xfer_cb(uint8_t rhport, uint8_t stage, const tusb_control
         if (stage == CONTROL_STAGE_SETUP) {
           TU_VERIFY(_dfu_ctx.attrs & DFU_ATTR_CAN_DOWNLOAD);
           TU_VERIFY(_dfu_ctx.state == DFU_IDLE || _dfu_ctx.state == DFU_DNLOAD_IDLE);
-          TU_VERIFY(request->wLength <= CFG_TUD_DFU_XFER_BUFSIZE);
+          TU_VERIFY(request->wLength <= alt_xfer_size(_dfu_ctx.alt));
 
+#if CFG_TUD_DFU_DOUBLE_BUFFER
+          // previous block may still be flashing, mark manifest as pending instead
+          _dfu_ctx.manifest_pending = (request->wLength == 0);
+#else
           // set to true for both download and manifest
           _dfu_ctx.flashing_in_progress = true;
+#endif
 
           // save block and length for flashing
           _dfu_ctx.block = request->wValue;
@@ -293,7 +387,7 @@ bool dfu_moded_control_xfer_cb(uint8_t rhport, uint8_t stage, const tusb_control
           if (request->wLength) {
             // Download with payload -> transition to DOWNLOAD SYNC
             _dfu_ctx.state = DFU_DNLOAD_SYNC;
-            return tud_control_xfer(rhport, request, _dfu_epbuf.transfer_buf, request->wLength);
+            return tud_control_xfer_direct(rhport, request, download_buf(_dfu_ctx.buf_idx), request->wLength);
           } else {
             // Download is complete -> transition to MANIFEST SYNC
             _dfu_ctx.state = DFU_MANIFEST_SYNC;
@@ -329,10 +423,16 @@ bool dfu_moded_control_xfer_cb(uint8_t rhport, uint8_t stage, const tusb_control
   return true;
 }
 
+void tud_dfu_set_transfer_buffer(uint8_t* buffer, uint32_t bufsize) {
+  _dfu_app_buf = bufsize ? buffer : NULL;
+  _dfu_app_bufsize = buffer ? bufsize : 0;
+}
+
 void tud_dfu_finish_flashing(uint8_t status) {
   _dfu_ctx.flashing_in_progress = false;
 
   if (status == DFU_STATUS_OK) {
+    // With double buffer, state is DNBUSY only if the next block is waiting, otherwise host is already sending it
     if (_dfu_ctx.state == DFU_DNBUSY) {
       _dfu_ctx.state = DFU_DNLOAD_SYNC;
     } else if (_dfu_ctx.state == DFU_MANIFEST) {
@@ -347,6 +447,68 @@ void tud_dfu_finish_flashing(uint8_t status) {
   }
 }
 
+#if CFG_TUD_DFU_DOUBLE_BUFFER
+static bool process_download_get_status(uint8_t rhport, uint8_t stage, const tusb_control_request_t* request) {
+  if (stage == CONTROL_STAGE_SETUP) {
+    // previous block is still flashing: host polls again after its remaining time. Otherwise received block is flashed
+    // while host sends the next one
+    if (_dfu_ctx.flashing_in_progress) {
+      return reply_getstatus(rhport, request, DFU_DNBUSY, _dfu_ctx.status, flash_remaining_ms());
+    }
+    return reply_getstatus(rhport, request, DFU_DNLOAD_IDLE, _dfu_ctx.status, 0);
+  } else if (stage == CONTROL_STAGE_ACK) {
+    if (_dfu_ctx.flashing_in_progress) {
+      _dfu_ctx.state = DFU_DNBUSY;
+    } else {
+      uint8_t const* buf = download_buf(_dfu_ctx.buf_idx);
+      _dfu_ctx.buf_idx ^= 1;
+      _dfu_ctx.flashing_in_progress = true;
+      _dfu_ctx.flash_timeout_ms = tud_dfu_get_timeout_cb(_dfu_ctx.alt, DFU_DNBUSY);
+      _dfu_ctx.flash_start_ms = tusb_time_millis_api();
+      _dfu_ctx.state = DFU_DNLOAD_IDLE;
+      tud_dfu_download_cb(_dfu_ctx.alt, _dfu_ctx.block, buf, _dfu_ctx.length);
+    }
+  }
+
+  return true;
+}
+
+static bool process_manifest_get_status(uint8_t rhport, uint8_t stage, const tusb_control_request_t* request) {
+  if (stage == CONTROL_STAGE_SETUP) {
+    dfu_state_t next_state;
+    uint32_t timeout;
+
+    if (_dfu_ctx.flashing_in_progress) {
+      // last block or manifestation is still in progress
+      next_state = DFU_MANIFEST;
+      timeout = flash_remaining_ms();
+    } else if (_dfu_ctx.manifest_pending) {
+      next_state = DFU_MANIFEST;
+      timeout = tud_dfu_get_timeout_cb(_dfu_ctx.alt, next_state);
+    } else {
+      next_state = DFU_IDLE;
+      timeout = 0;
+    }
+
+    return reply_getstatus(rhport, request, next_state, _dfu_ctx.status, timeout);
+  } else if (stage == CONTROL_STAGE_ACK) {
+    if (_dfu_ctx.flashing_in_progress) {
+      // wait for last block, host polls again
+    } else if (_dfu_ctx.manifest_pending) {
+      _dfu_ctx.manifest_pending = false;
+      _dfu_ctx.flashing_in_progress = true;
+      _dfu_ctx.state = DFU_MANIFEST;
+      tud_dfu_manifest_cb(_dfu_ctx.alt);
+    } else {
+      _dfu_ctx.state = DFU_IDLE;
+    }
+  }
+
+  return true;
+}
+
+#else
+
 static bool process_download_get_status(uint8_t rhport, uint8_t stage, const tusb_control_request_t* request) {
   if (stage == CONTROL_STAGE_SETUP) {
     // only transition to next state on CONTROL_STAGE_ACK
@@ -365,7 +527,7 @@ static bool process_download_get_status(uint8_t rhport, uint8_t stage, const tus
   } else if (stage == CONTROL_STAGE_ACK) {
     if (_dfu_ctx.flashing_in_progress) {
       _dfu_ctx.state = DFU_DNBUSY;
-      tud_dfu_download_cb(_dfu_ctx.alt, _dfu_ctx.block, _dfu_epbuf.transfer_buf, _dfu_ctx.length);
+      tud_dfu_download_cb(_dfu_ctx.alt, _dfu_ctx.block, download_buf(0), _dfu_ctx.length);
     } else {
       _dfu_ctx.state = DFU_DNLOAD_IDLE;
     }
@@ -400,6 +562,7 @@ static bool process_manifest_get_status(uint8_t rhport, uint8_t stage, const tus
 
   return true;
 }
+#endif
 
 static bool reply_getstatus(uint8_t rhport, const tusb_control_request_t* request, dfu_state_t state,
                             dfu_status_t status, uint32_t timeout) {
@@ -41,6 +41,19 @@
   #error "CFG_TUD_DFU_XFER_BUFSIZE must be defined, it has to be set to the buffer size used in TUD_DFU_DESCRIPTOR"
 #endif
 
+// Max number of alternate settings whose transfer size is tracked individually, when each alternate setting has its
+// own functional descriptor (TUD_DFU_ALT_FUNC_DESCRIPTOR). Later ones share the smallest size of the remaining ones
+#ifndef CFG_TUD_DFU_ALT_MAX
+  #define CFG_TUD_DFU_ALT_MAX 8
+#endif
+
+// Double-buffered download: use 2 transfer buffers so that the next DFU_DNLOAD block is received while the previous
+// one is being flashed. tud_dfu_download_cb() is then invoked with alternating buffers, the buffer must not be used
+// after tud_dfu_finish_flashing()
+#ifndef CFG_TUD_DFU_DOUBLE_BUFFER
+  #define CFG_TUD_DFU_DOUBLE_BUFFER 0
+#endif
+
 //--------------------------------------------------------------------+
 // Application API
 //--------------------------------------------------------------------+
@@ -50,6 +63,12 @@
 // status is DFU_STATUS_OK if successful, any other error status will cause state to enter dfuError
 void tud_dfu_finish_flashing(uint8_t status);
 
+// Use application buffer for DFU_DNLOAD/DFU_UPLOAD data instead of the CFG_TUD_DFU_XFER_BUFSIZE internal one, allowing
+// larger wTransferSize when RAM is available. Must be called before enumeration; with CFG_TUD_DFU_DOUBLE_BUFFER the
+// buffer is split in 2 halves. Buffer is used directly by DCD: it must meet CFG_TUD_MEM_SECTION/CFG_TUD_MEM_ALIGN.
+// Pass NULL to use the internal buffer
+void tud_dfu_set_transfer_buffer(uint8_t* buffer, uint32_t bufsize);
+
 //--------------------------------------------------------------------+
 // Application Callback API (weak is optional)
 //--------------------------------------------------------------------+
@@ -59,6 +78,8 @@ void tud_dfu_finish_flashing(uint8_t status);
 // Invoked right before tud_dfu_download_cb() (state=DFU_DNBUSY) or tud_dfu_manifest_cb() (state=DFU_MANIFEST)
 // Application return timeout in milliseconds (bwPollTimeout) for the next download/manifest operation.
 // During this period, USB host won't try to communicate with us.
+// With CFG_TUD_DFU_DOUBLE_BUFFER, the download timeout is counted from when flashing starts and only the remaining
+// time is reported to host, which sends the next block meanwhile.
 uint32_t tud_dfu_get_timeout_cb(uint8_t alt, uint8_t state);
 
 // Invoked when received DFU_DNLOAD (wLength>0) following by DFU_GETSTATUS (state=DFU_DNBUSY) requests
@@ -76,6 +97,11 @@ void tud_dfu_manifest_cb(uint8_t alt);
 // Return the number of written bytes
 TU_ATTR_WEAK uint16_t tud_dfu_upload_cb(uint8_t alt, uint16_t block_num, uint8_t* data, uint16_t length);
 
+// Invoked when received DFU_UPLOAD request, before tud_dfu_upload_cb(). Application can point data to the block in
+// memory e.g XIP/memory-mapped flash, which is sent without copy: it must be readable by DCD (DMA) and stay valid until
+// the transfer completes. Return the number of bytes, or leave data as NULL to use tud_dfu_upload_cb() instead
+TU_ATTR_WEAK uint16_t tud_dfu_upload_direct_cb(uint8_t alt, uint16_t block_num, uint8_t const** data, uint16_t length);
+
 // Invoked when a DFU_DETACH request is received
 TU_ATTR_WEAK void tud_dfu_detach_cb(void);
 
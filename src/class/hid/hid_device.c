@@ -40,6 +40,7 @@
 // MACRO CONSTANT TYPEDEF
 //--------------------------------------------------------------------+
 typedef struct {
+  uint8_t rhport;
   uint8_t itf_num;
   uint8_t ep_in;
   uint8_t ep_out;       // optional Out endpoint
@@ -48,6 +49,9 @@ typedef struct {
   uint16_t report_desc_len;
   uint8_t protocol_mode; // Boot (0) or Report protocol (1)
   uint8_t idle_rate;     // up to application to handle idle rate
+#if CFG_TUD_HID_REPORT_FILL
+  volatile bool fill_active;
+#endif
 
   // TODO save hid descriptor since host can specifically request this after enumeration
   // Note: HID descriptor may be not available from application after enumeration
@@ -63,14 +67,51 @@ typedef struct {
 static hidd_interface_t _hidd_itf[CFG_TUD_HID];
 CFG_TUD_MEM_SECTION static hidd_epbuf_t _hidd_epbuf[CFG_TUD_HID];
 
+#if CFG_TUD_HID_REPORT_QUEUE
+typedef struct {
+  uint8_t mode; // hid_report_queue_mode_t
+  uint8_t rd_idx;
+  uint8_t count;
+
+  struct {
+    uint8_t report_id;
+    uint16_t len; // including report ID
+    uint8_t buf[CFG_TUD_HID_REPORT_QUEUE_ITEMSIZE];
+  } item[CFG_TUD_HID_REPORT_QUEUE];
+
+  OSAL_MUTEX_DEF(mutex_def);
+  #if OSAL_MUTEX_REQUIRED
+  osal_mutex_t mutex; // report API and transfer complete may run in different tasks
+  #endif
+} hidd_report_queue_t;
+
+static hidd_report_queue_t _hidd_queue[CFG_TUD_HID];
+
+TU_VERIFY_STATIC(CFG_TUD_HID_REPORT_QUEUE <= 255, "CFG_TUD_HID_REPORT_QUEUE too large");
+
+#if OSAL_MUTEX_REQUIRED
+  #define queue_lock(_q)    osal_mutex_lock((_q)->mutex, OSAL_TIMEOUT_WAIT_FOREVER)
+  #define queue_unlock(_q)  osal_mutex_unlock((_q)->mutex)
+#else
+  #define queue_lock(_q)
+  #define queue_unlock(_q)
+#endif
+#endif
+
 /*------------- Helpers -------------*/
-TU_ATTR_ALWAYS_INLINE static inline uint8_t get_index_by_itfnum(uint8_t itf_num) {
+TU_ATTR_ALWAYS_INLINE static inline uint8_t get_index_by_itfnum(uint8_t rhport, uint8_t itf_num) {
+#if CFG_TUD_ITF_CONTEXT
+  // attached by hidd_open(), control request only reaches HID driver for its own interfaces
+  hidd_interface_t const* p_hid = (hidd_interface_t const*) usbd_itf_get_context(rhport, itf_num);
+  return p_hid ? (uint8_t) (p_hid - _hidd_itf) : 0xFF;
+#else
   for (uint8_t i = 0; i < CFG_TUD_HID; i++) {
-    if (itf_num == _hidd_itf[i].itf_num) {
+    if (rhport == _hidd_itf[i].rhport && itf_num == _hidd_itf[i].itf_num) {
       return i;
     }
   }
   return 0xFF;
+#endif
 }
 
 //--------------------------------------------------------------------+
@@ -105,30 +146,149 @@ TU_ATTR_WEAK void tud_hid_report_failed_cb(uint8_t instance, hid_report_type_t r
 // APPLICATION API
 //--------------------------------------------------------------------+
 bool tud_hid_n_ready(uint8_t instance) {
-  uint8_t const rhport = 0;
+  uint8_t const rhport = _hidd_itf[instance].rhport;
   uint8_t const ep_in = _hidd_itf[instance].ep_in;
-  return tud_ready() && (ep_in != 0) && !usbd_edpt_busy(rhport, ep_in);
+  bool const ep_free = !usbd_edpt_busy(rhport, ep_in);
+#if CFG_TUD_HID_REPORT_QUEUE
+  return tud_rhport_ready(rhport) && (ep_in != 0) && (ep_free || _hidd_queue[instance].count < CFG_TUD_HID_REPORT_QUEUE);
+#else
+  return tud_rhport_ready(rhport) && (ep_in != 0) && ep_free;
+#endif
+}
+
+// Copy report with its ID prefix into buffer, return total length or 0 if not fit
+static uint16_t prepare_report(uint8_t *buf, uint16_t bufsize, uint8_t report_id, void const *report, uint16_t len) {
+  if (report_id) {
+    buf[0] = report_id;
+    TU_VERIFY(0 == tu_memcpy_s(buf + 1, bufsize - 1u, report, len), 0);
+    len++;
+  } else {
+    TU_VERIFY(0 == tu_memcpy_s(buf, bufsize, report, len), 0);
+  }
+  return len;
+}
+
+#if CFG_TUD_HID_REPORT_FILL
+// Arm IN endpoint with report filled by application
+TU_ATTR_FAST_FUNC static bool report_fill(uint8_t rhport, uint8_t instance) {
+  hidd_interface_t *p_hid = &_hidd_itf[instance];
+  hidd_epbuf_t *p_epbuf = &_hidd_epbuf[instance];
+
+  TU_VERIFY(usbd_edpt_claim(rhport, p_hid->ep_in));
+  uint16_t const len = tud_hid_report_fill_cb(instance, p_epbuf->epin, CFG_TUD_HID_EP_BUFSIZE);
+  if (len == 0 || len > CFG_TUD_HID_EP_BUFSIZE) {
+    p_hid->fill_active = false;
+    usbd_edpt_release(rhport, p_hid->ep_in);
+    return false;
+  }
+
+  return usbd_edpt_xfer(rhport, p_hid->ep_in, p_epbuf->epin, len);
+}
+
+bool tud_hid_n_report_fill_start(uint8_t instance) {
+  TU_VERIFY(instance < CFG_TUD_HID);
+  hidd_interface_t *p_hid = &_hidd_itf[instance];
+  TU_VERIFY(tud_rhport_ready(p_hid->rhport) && p_hid->ep_in);
+
+  p_hid->fill_active = true;
+  // if endpoint is busy, filling starts when the current transfer completes
+  (void) report_fill(p_hid->rhport, instance);
+  return p_hid->fill_active;
+}
+
+void tud_hid_n_report_fill_stop(uint8_t instance) {
+  TU_VERIFY(instance < CFG_TUD_HID, );
+  _hidd_itf[instance].fill_active = false;
+}
+#endif
+
+#if CFG_TUD_HID_REPORT_QUEUE
+void tud_hid_n_set_report_queue_mode(uint8_t instance, hid_report_queue_mode_t mode) {
+  TU_VERIFY(instance < CFG_TUD_HID, );
+  _hidd_queue[instance].mode = (uint8_t) mode;
+}
+
+// Add report to queue, or replace the queued one with the same ID in HID_REPORT_QUEUE_LATEST mode
+static bool queue_push(hidd_report_queue_t *q, uint8_t report_id, void const *report, uint16_t len) {
+  TU_VERIFY((report_id ? len + 1u : len) <= CFG_TUD_HID_REPORT_QUEUE_ITEMSIZE);
+
+  uint8_t idx = CFG_TUD_HID_REPORT_QUEUE;
+  if (q->mode == HID_REPORT_QUEUE_LATEST) {
+    for (uint8_t i = 0; i < q->count; i++) {
+      uint8_t const n = (uint8_t) ((q->rd_idx + i) % CFG_TUD_HID_REPORT_QUEUE);
+      if (q->item[n].report_id == report_id) {
+        idx = n;
+        break;
+      }
+    }
+  }
+
+  if (idx == CFG_TUD_HID_REPORT_QUEUE) {
+    TU_VERIFY(q->count < CFG_TUD_HID_REPORT_QUEUE);
+    idx = (uint8_t) ((q->rd_idx + q->count) % CFG_TUD_HID_REPORT_QUEUE);
+    q->count++;
+  }
+
+  q->item[idx].report_id = report_id;
+  q->item[idx].len = prepare_report(q->item[idx].buf, CFG_TUD_HID_REPORT_QUEUE_ITEMSIZE, report_id, report, len);
+  return true;
+}
+
+// Send oldest queued report if endpoint is free
+static void queue_drain(uint8_t rhport, uint8_t instance) {
+  hidd_interface_t *p_hid = &_hidd_itf[instance];
+  hidd_epbuf_t *p_epbuf = &_hidd_epbuf[instance];
+  hidd_report_queue_t *q = &_hidd_queue[instance];
+
+  queue_lock(q);
+  if (q->count && usbd_edpt_claim(rhport, p_hid->ep_in)) {
+    uint16_t const len = q->item[q->rd_idx].len;
+    memcpy(p_epbuf->epin, q->item[q->rd_idx].buf, len);
+    q->rd_idx = (uint8_t) ((q->rd_idx + 1) % CFG_TUD_HID_REPORT_QUEUE);
+    q->count--;
+    (void) usbd_edpt_xfer(rhport, p_hid->ep_in, p_epbuf->epin, len);
+  }
+  queue_unlock(q);
 }
+#endif
 
 bool tud_hid_n_report(uint8_t instance, uint8_t report_id, void const *report, uint16_t len) {
   TU_VERIFY(instance < CFG_TUD_HID);
-  const uint8_t rhport = 0;
   hidd_interface_t *p_hid = &_hidd_itf[instance];
   hidd_epbuf_t *p_epbuf = &_hidd_epbuf[instance];
+  const uint8_t rhport = p_hid->rhport;
+
+#if CFG_TUD_HID_REPORT_QUEUE
+  TU_VERIFY(tud_rhport_ready(rhport) && p_hid->ep_in);
+  hidd_report_queue_t *q = &_hidd_queue[instance];
+  bool ret;
+
+  queue_lock(q);
+  // send directly only if nothing is queued to keep the order
+  if (q->count == 0 && usbd_edpt_claim(rhport, p_hid->ep_in)) {
+    len = prepare_report(p_epbuf->epin, CFG_TUD_HID_EP_BUFSIZE, report_id, report, len);
+    if (len) {
+      ret = usbd_edpt_xfer(rhport, p_hid->ep_in, p_epbuf->epin, len);
+    } else {
+      usbd_edpt_release(rhport, p_hid->ep_in);
+      ret = false;
+    }
+  } else {
+    ret = queue_push(q, report_id, report, len);
+  }
+  queue_unlock(q);
 
+  return ret;
+#else
   // claim endpoint
   TU_VERIFY(usbd_edpt_claim(rhport, p_hid->ep_in));
 
   // prepare data
-  if (report_id) {
-    p_epbuf->epin[0] = report_id;
-    TU_VERIFY(0 == tu_memcpy_s(p_epbuf->epin + 1, CFG_TUD_HID_EP_BUFSIZE - 1, report, len));
-    len++;
-  } else {
-    TU_VERIFY(0 == tu_memcpy_s(p_epbuf->epin, CFG_TUD_HID_EP_BUFSIZE, report, len));
-  }
+  len = prepare_report(p_epbuf->epin, CFG_TUD_HID_EP_BUFSIZE, report_id, report, len);
+  TU_VERIFY(len);
 
   return usbd_edpt_xfer(rhport, p_hid->ep_in, p_epbuf->epin, len);
+#endif
 }
 
 uint8_t tud_hid_n_interface_protocol(uint8_t instance) {
@@ -199,15 +359,40 @@ bool tud_hid_n_gamepad_report(uint8_t instance, uint8_t report_id,
 //--------------------------------------------------------------------+
 void hidd_init(void) {
   hidd_reset(0);
+
+#if CFG_TUD_HID_REPORT_QUEUE && OSAL_MUTEX_REQUIRED
+  for (uint8_t i = 0; i < CFG_TUD_HID; i++) {
+    hidd_report_queue_t *q = &_hidd_queue[i];
+    q->mutex = osal_mutex_create(&q->mutex_def);
+    TU_ASSERT(q->mutex != NULL, );
+  }
+#endif
 }
 
 bool hidd_deinit(void) {
+#if CFG_TUD_HID_REPORT_QUEUE && OSAL_MUTEX_REQUIRED
+  for (uint8_t i = 0; i < CFG_TUD_HID; i++) {
+    hidd_report_queue_t *q = &_hidd_queue[i];
+    if (q->mutex) {
+      osal_mutex_delete(q->mutex);
+      q->mutex = NULL;
+    }
+  }
+#endif
   return true;
 }
 
 void hidd_reset(uint8_t rhport) {
-  (void)rhport;
-  tu_memclr(_hidd_itf, sizeof(_hidd_itf));
+  for (uint8_t i = 0; i < CFG_TUD_HID; i++) {
+    if (_hidd_itf[i].ep_in && _hidd_itf[i].rhport != rhport) continue; // opened on other port
+    tu_memclr(&_hidd_itf[i], sizeof(hidd_interface_t));
+
+#if CFG_TUD_HID_REPORT_QUEUE
+    // drop queued reports, queue mode is kept
+    _hidd_queue[i].rd_idx = 0;
+    _hidd_queue[i].count = 0;
+#endif
+  }
 }
 
 uint16_t hidd_open(uint8_t rhport, tusb_desc_interface_t const *desc_itf, uint16_t max_len) {
@@ -246,7 +431,9 @@ uint16_t hidd_open(uint8_t rhport, tusb_desc_interface_t const *desc_itf, uint16
   }
 
   p_hid->protocol_mode = HID_PROTOCOL_REPORT; // Per Specs: default is report mode
+  p_hid->rhport = rhport;
   p_hid->itf_num = desc_itf->bInterfaceNumber;
+  usbd_itf_set_context(rhport, p_hid->itf_num, p_hid);
 
   // Use offsetof to avoid pointer to the odd/misaligned address
   p_hid->report_desc_len = tu_unaligned_read16((uint8_t const *)p_hid->hid_descriptor + offsetof(tusb_hid_descriptor_hid_t, wReportLength));
@@ -265,7 +452,7 @@ uint16_t hidd_open(uint8_t rhport, tusb_desc_interface_t const *desc_itf, uint16
 bool hidd_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t const *request) {
   TU_VERIFY(request->bmRequestType_bit.recipient == TUSB_REQ_RCPT_INTERFACE);
 
-  uint8_t const hid_itf = get_index_by_itfnum((uint8_t)request->wIndex);
+  uint8_t const hid_itf = get_index_by_itfnum(rhport, (uint8_t)request->wIndex);
   TU_VERIFY(hid_itf < CFG_TUD_HID);
   hidd_interface_t *p_hid = &_hidd_itf[hid_itf];
   hidd_epbuf_t *p_epbuf = &_hidd_epbuf[hid_itf];
@@ -373,18 +560,15 @@ bool hidd_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t
   return true;
 }
 
-bool hidd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes) {
-  uint8_t instance;
-  hidd_interface_t *p_hid;
+static bool hidd_edpt_match(uint8_t instance, uint8_t rhport, uint8_t ep_addr) {
+  hidd_interface_t const *p_hid = &_hidd_itf[instance];
+  return p_hid->rhport == rhport && ((ep_addr == p_hid->ep_out) || (ep_addr == p_hid->ep_in));
+}
 
-  // Identify which interface to use
-  for (instance = 0; instance < CFG_TUD_HID; instance++) {
-    p_hid = &_hidd_itf[instance];
-    if ((ep_addr == p_hid->ep_out) || (ep_addr == p_hid->ep_in)) {
-      break;
-    }
-  }
+bool hidd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes) {
+  uint8_t const instance = usbd_edpt_find_instance(rhport, ep_addr, _hidd_itf, hidd_edpt_match);
   TU_ASSERT(instance < CFG_TUD_HID);
+  hidd_interface_t *p_hid = &_hidd_itf[instance];
   hidd_epbuf_t *p_epbuf = &_hidd_epbuf[instance];
 
   if (ep_addr == p_hid->ep_in) {
@@ -394,6 +578,15 @@ bool hidd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_
     } else {
       tud_hid_report_failed_cb(instance, HID_REPORT_TYPE_INPUT, p_epbuf->epin, (uint16_t) xferred_bytes);
     }
+#if CFG_TUD_HID_REPORT_FILL
+    if (p_hid->fill_active && report_fill(rhport, instance)) {
+      return true;
+    }
+#endif
+#if CFG_TUD_HID_REPORT_QUEUE
+    // endpoint may be claimed again by report sent from callback
+    queue_drain(rhport, instance);
+#endif
   } else {
     // Output report
     if (XFER_RESULT_SUCCESS == result) {
@@ -409,4 +602,20 @@ bool hidd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_
   return true;
 }
 
+#if CFG_TUD_HID_REPORT_FILL && CFG_TUD_XFER_ISR
+// Re-arm IN endpoint in fill mode directly in ISR, everything else is deferred to hidd_xfer_cb()
+TU_ATTR_FAST_FUNC bool hidd_xfer_isr(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes) {
+  (void) xferred_bytes;
+  TU_VERIFY(XFER_RESULT_SUCCESS == result);
+
+  for (uint8_t instance = 0; instance < CFG_TUD_HID; instance++) {
+    hidd_interface_t *p_hid = &_hidd_itf[instance];
+    if (p_hid->rhport == rhport && ep_addr == p_hid->ep_in) {
+      return p_hid->fill_active && report_fill(rhport, instance);
+    }
+  }
+  return false;
+}
+#endif
+
 #endif
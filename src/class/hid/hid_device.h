@@ -47,6 +47,28 @@
   #define CFG_TUD_HID_EP_BUFSIZE     64
 #endif
 
+// Number of input reports queued per instance while IN endpoint is busy, drained on transfer complete.
+// 0 means no queue: tud_hid_n_report() fails if endpoint is busy
+#ifndef CFG_TUD_HID_REPORT_QUEUE
+  #define CFG_TUD_HID_REPORT_QUEUE   0
+#endif
+
+// Max size of a queued report including report ID
+#ifndef CFG_TUD_HID_REPORT_QUEUE_ITEMSIZE
+  #define CFG_TUD_HID_REPORT_QUEUE_ITEMSIZE  CFG_TUD_HID_EP_BUFSIZE
+#endif
+
+// Report fill mode: once started by tud_hid_n_report_fill_start(), IN endpoint is re-armed right after each transfer
+// completes with the freshest report from tud_hid_report_fill_cb(). With CFG_TUD_XFER_ISR this is done in ISR
+#ifndef CFG_TUD_HID_REPORT_FILL
+  #define CFG_TUD_HID_REPORT_FILL    0
+#endif
+
+typedef enum {
+  HID_REPORT_QUEUE_FIFO = 0, // keep every report e.g keyboard, macro pad
+  HID_REPORT_QUEUE_LATEST,   // keep only the latest report of each report ID e.g gamepad, sensor
+} hid_report_queue_mode_t;
+
 //--------------------------------------------------------------------+
 // Application API (Multiple Instances) i.e. CFG_TUD_HID > 1
 //--------------------------------------------------------------------+
@@ -60,9 +82,24 @@ uint8_t tud_hid_n_interface_protocol(uint8_t instance);
 // Get current active protocol: HID_PROTOCOL_BOOT (0) or HID_PROTOCOL_REPORT (1)
 uint8_t tud_hid_n_get_protocol(uint8_t instance);
 
-// Send report to host
+// Send report to host. With CFG_TUD_HID_REPORT_QUEUE, report is queued if endpoint is busy
 bool tud_hid_n_report(uint8_t instance, uint8_t report_id, void const* report, uint16_t len);
 
+#if CFG_TUD_HID_REPORT_FILL
+// Start report fill mode, first report is filled now or when the current transfer completes.
+// tud_hid_n_report() should not be used while fill mode is active
+bool tud_hid_n_report_fill_start(uint8_t instance);
+
+// Stop report fill mode, the report already armed is still sent
+void tud_hid_n_report_fill_stop(uint8_t instance);
+#endif
+
+#if CFG_TUD_HID_REPORT_QUEUE
+// Set input report queue mode, default is HID_REPORT_QUEUE_FIFO. In HID_REPORT_QUEUE_LATEST mode a queued report is
+// replaced by a newer one with the same report ID, relative values (e.g mouse motion) should be accumulated by application
+void tud_hid_n_set_report_queue_mode(uint8_t instance, hid_report_queue_mode_t mode);
+#endif
+
 // KEYBOARD: convenient helper to send keyboard report if application
 // use template layout report as defined by hid_keyboard_report_t
 bool tud_hid_n_keyboard_report(uint8_t instance, uint8_t report_id, uint8_t modifier, const uint8_t keycode[6]);
@@ -131,6 +168,13 @@ uint16_t tud_hid_get_report_cb(uint8_t instance, uint8_t report_id, hid_report_t
 // received data on OUT endpoint (Report ID = 0, Type = OUTPUT)
 void tud_hid_set_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_t report_type, uint8_t const* buffer, uint16_t bufsize);
 
+#if CFG_TUD_HID_REPORT_FILL
+// Invoked in fill mode to write the next input report (including report ID if used) into buffer, right after the
+// previous one is sent. Called in ISR with CFG_TUD_XFER_ISR, tud_hid_report_complete_cb() is then skipped.
+// Return report length, 0 to stop fill mode
+uint16_t tud_hid_report_fill_cb(uint8_t instance, uint8_t* buffer, uint16_t bufsize);
+#endif
+
 // Invoked when received SET_PROTOCOL request
 // protocol is either HID_PROTOCOL_BOOT (0) or HID_PROTOCOL_REPORT (1)
 void tud_hid_set_protocol_cb(uint8_t instance, uint8_t protocol);
@@ -623,6 +667,7 @@ void     hidd_reset           (uint8_t rhport);
 uint16_t hidd_open            (uint8_t rhport, tusb_desc_interface_t const * itf_desc, uint16_t max_len);
 bool     hidd_control_xfer_cb (uint8_t rhport, uint8_t stage, tusb_control_request_t const * request);
 bool     hidd_xfer_cb         (uint8_t rhport, uint8_t ep_addr, xfer_result_t event, uint32_t xferred_bytes);
+bool     hidd_xfer_isr        (uint8_t rhport, uint8_t ep_addr, xfer_result_t event, uint32_t xferred_bytes);
 
 #ifdef __cplusplus
  }
@@ -40,6 +40,9 @@
 
 #define TU_LOG_DRV(...)   TU_LOG(CFG_TUH_HID_LOG_LEVEL, __VA_ARGS__)
 
+// Keep 2 IN transfers in flight in auto receive mode when transfer can be queued on busy endpoint
+#define HIDH_RX_DOUBLE_BUF  (CFG_TUH_HID_RX_RING && CFG_TUH_EDPT_XFER_QUEUE)
+
 //--------------------------------------------------------------------+
 // MACRO CONSTANT TYPEDEF
 //--------------------------------------------------------------------+
@@ -58,16 +61,44 @@ typedef struct {
 
   uint16_t epin_size;
   uint16_t epout_size;
+
+#if CFG_TUH_HID_RX_RING
+  bool rx_auto;     // re-submit IN transfer on completion, reports are buffered in ring
+  uint8_t rx_busy;  // bitmask of IN buffers with transfer in flight in auto mode
+#endif
+
+#if CFG_TUH_HID_POLL_ADAPTIVE
+  bool poll_adaptive;
+  bool poll_paused;          // IN transfer is aborted for poll_backoff_ms
+  uint16_t poll_backoff_ms;  // 0 while device is active
+#endif
 } hidh_interface_t;
 
 typedef struct {
   TUH_EPBUF_DEF(epin, CFG_TUH_HID_EPIN_BUFSIZE);
   TUH_EPBUF_DEF(epout, CFG_TUH_HID_EPOUT_BUFSIZE);
+#if HIDH_RX_DOUBLE_BUF
+  TUH_EPBUF_DEF(epin_alt, CFG_TUH_HID_EPIN_BUFSIZE);
+#endif
 } hidh_epbuf_t;
 
 static hidh_interface_t _hidh_itf[CFG_TUH_HID];
 CFG_TUH_MEM_SECTION static hidh_epbuf_t _hidh_epbuf[CFG_TUH_HID];
 
+#if CFG_TUH_HID_RX_RING
+typedef struct {
+  uint16_t len;
+  uint8_t data[CFG_TUH_HID_EPIN_BUFSIZE];
+} hidh_rx_report_t;
+
+typedef struct {
+  tu_fifo_t ff;
+  uint8_t ff_buf[CFG_TUH_HID_RX_RING * sizeof(hidh_rx_report_t)];
+} hidh_rx_ring_t;
+
+static hidh_rx_ring_t _hidh_rx[CFG_TUH_HID];
+#endif
+
 static uint8_t _hidh_default_protocol = HID_PROTOCOL_BOOT;
 
 //--------------------------------------------------------------------+
@@ -360,6 +391,10 @@ bool tuh_hid_receive_report(uint8_t daddr, uint8_t idx) {
   TU_VERIFY(p_hid);
   hidh_epbuf_t* epbuf = get_hid_epbuf(idx);
 
+#if CFG_TUH_HID_RX_RING
+  TU_VERIFY(!p_hid->rx_auto && !p_hid->rx_busy);
+#endif
+
   // claim endpoint
   TU_VERIFY(usbh_edpt_claim(daddr, p_hid->ep_in));
 
@@ -376,6 +411,185 @@ bool tuh_hid_receive_abort(uint8_t dev_addr, uint8_t idx) {
   return tuh_edpt_abort_xfer(dev_addr, p_hid->ep_in);
 }
 
+#if CFG_TUH_HID_RX_RING
+#if HIDH_RX_DOUBLE_BUF
+static void rx_auto_xfer_cb(tuh_xfer_t* xfer);
+#endif
+
+#if CFG_TUH_HID_POLL_ADAPTIVE
+static void poll_timer(void* param);
+
+// (re)start idle or backoff timer, param is address and index since interface can be re-used once timer fires
+static void poll_timer_start(hidh_interface_t const* p_hid, uint8_t idx, uint32_t delay_ms) {
+  (void) usbh_defer_func_ms(poll_timer, (void*) (uintptr_t) ((p_hid->daddr << 8) | idx), delay_ms);
+}
+#endif
+
+// submit IN transfer on idle buffer(s)
+static void rx_auto_submit(hidh_interface_t* p_hid, uint8_t idx) {
+  uint8_t const daddr = p_hid->daddr;
+  hidh_epbuf_t* epbuf = get_hid_epbuf(idx);
+
+#if CFG_TUH_HID_POLL_ADAPTIVE
+  if (p_hid->poll_paused) {
+    return; // re-submitted by poll_timer()
+  }
+#endif
+
+#if HIDH_RX_DOUBLE_BUF
+  // 2nd transfer is queued by usbh and submitted right on completion of the 1st one, before its callback
+  for (uint8_t b = 0; b < 2; b++) {
+    if (p_hid->rx_auto && !tu_bit_test(p_hid->rx_busy, b)) {
+      tuh_xfer_t xfer = {
+          .daddr       = daddr,
+          .ep_addr     = p_hid->ep_in,
+          .buflen      = p_hid->epin_size,
+          .buffer      = b ? epbuf->epin_alt : epbuf->epin,
+          .complete_cb = rx_auto_xfer_cb,
+          .user_data   = (uintptr_t) ((idx << 1) | b)
+      };
+      if (tuh_edpt_xfer(&xfer)) {
+        p_hid->rx_busy |= (uint8_t) TU_BIT(b);
+      }
+    }
+  }
+#else
+  if (p_hid->rx_auto && !p_hid->rx_busy && usbh_edpt_claim(daddr, p_hid->ep_in)) {
+    if (usbh_edpt_xfer(daddr, p_hid->ep_in, epbuf->epin, p_hid->epin_size)) {
+      p_hid->rx_busy = 1;
+    } else {
+      usbh_edpt_release(daddr, p_hid->ep_in);
+    }
+  }
+#endif
+
+  if (!p_hid->rx_busy) {
+    p_hid->rx_auto = false;
+  }
+#if CFG_TUH_HID_POLL_ADAPTIVE
+  else if (p_hid->poll_adaptive) {
+    poll_timer_start(p_hid, idx, CFG_TUH_HID_POLL_IDLE_MS);
+  }
+#endif
+}
+
+#if CFG_TUH_HID_POLL_ADAPTIVE
+static void poll_timer(void* param) {
+  uint8_t const daddr = (uint8_t) ((uintptr_t) param >> 8);
+  uint8_t const idx = (uint8_t) ((uintptr_t) param & 0xff);
+  hidh_interface_t* p_hid = get_hid_itf(daddr, idx);
+  TU_VERIFY(p_hid && p_hid->rx_auto && p_hid->poll_adaptive,);
+
+  if (p_hid->poll_paused) {
+    // pause is over, poll again
+    p_hid->poll_paused = false;
+    rx_auto_submit(p_hid, idx);
+  } else if (p_hid->rx_busy) {
+    // no report within idle period: stop polling and back off
+    uint32_t const backoff = p_hid->poll_backoff_ms ? 2u * p_hid->poll_backoff_ms : CFG_TUH_HID_POLL_IDLE_MS;
+    p_hid->poll_backoff_ms = (uint16_t) tu_min32(backoff, CFG_TUH_HID_POLL_BACKOFF_MAX_MS);
+    p_hid->poll_paused = true;
+    p_hid->rx_busy = 0;
+    (void) tuh_edpt_abort_xfer(daddr, p_hid->ep_in);
+    TU_LOG_DRV("  HID idle (%u, %u), pause polling %u ms\r\n", daddr, idx, p_hid->poll_backoff_ms);
+    poll_timer_start(p_hid, idx, p_hid->poll_backoff_ms);
+  }
+}
+
+bool tuh_hid_poll_adaptive(uint8_t dev_addr, uint8_t idx, bool enable) {
+  hidh_interface_t* p_hid = get_hid_itf(dev_addr, idx);
+  TU_VERIFY(p_hid && p_hid->mounted);
+
+  p_hid->poll_adaptive = enable;
+  p_hid->poll_backoff_ms = 0;
+  if (p_hid->poll_paused) {
+    // resume now, timer is ignored or restarted
+    p_hid->poll_paused = false;
+    rx_auto_submit(p_hid, idx);
+  } else if (enable && p_hid->rx_busy) {
+    poll_timer_start(p_hid, idx, CFG_TUH_HID_POLL_IDLE_MS);
+  }
+  return true;
+}
+#endif
+
+// IN transfer of auto mode complete: buffer report then re-arm with the same buffer
+static void rx_auto_received(hidh_interface_t* p_hid, uint8_t idx, uint8_t b, uint8_t const* buf,
+                             xfer_result_t result, uint32_t xferred_bytes) {
+  p_hid->rx_busy &= (uint8_t) ~TU_BIT(b);
+
+  if (result == XFER_RESULT_SUCCESS) {
+    #if CFG_TUH_HID_POLL_ADAPTIVE
+    // device is active (report may also complete right before being aborted)
+    p_hid->poll_backoff_ms = 0;
+    p_hid->poll_paused = false;
+    #endif
+
+    hidh_rx_report_t report;
+    report.len = (uint16_t) tu_min32(xferred_bytes, CFG_TUH_HID_EPIN_BUFSIZE);
+    memcpy(report.data, buf, report.len);
+    if (!tu_fifo_write(&_hidh_rx[idx].ff, &report)) {
+      TU_LOG_DRV("  HID report ring full, dropped (%u, %u)\r\n", p_hid->daddr, idx);
+    }
+  } else {
+    p_hid->rx_auto = false;
+  }
+
+  rx_auto_submit(p_hid, idx);
+}
+
+#if HIDH_RX_DOUBLE_BUF
+static void rx_auto_xfer_cb(tuh_xfer_t* xfer) {
+  uint8_t const idx = (uint8_t) (xfer->user_data >> 1);
+  uint8_t const b = (uint8_t) (xfer->user_data & 1);
+  hidh_interface_t* p_hid = get_hid_itf(xfer->daddr, idx);
+  TU_VERIFY(p_hid,);
+  rx_auto_received(p_hid, idx, b, xfer->buffer, xfer->result, xfer->actual_len);
+}
+#endif
+
+bool tuh_hid_receive_auto(uint8_t dev_addr, uint8_t idx, bool enable) {
+  hidh_interface_t* p_hid = get_hid_itf(dev_addr, idx);
+  TU_VERIFY(p_hid && p_hid->mounted);
+
+  if (!enable) {
+    // in-flight transfers are let to complete into the ring
+    p_hid->rx_auto = false;
+    return true;
+  }
+
+  if (!p_hid->rx_auto) {
+    if (!p_hid->rx_busy) {
+      tu_fifo_clear(&_hidh_rx[idx].ff);
+    }
+    #if CFG_TUH_HID_POLL_ADAPTIVE
+    p_hid->poll_paused = false;
+    p_hid->poll_backoff_ms = 0;
+    #endif
+    p_hid->rx_auto = true;
+    rx_auto_submit(p_hid, idx);
+  }
+
+  return p_hid->rx_auto;
+}
+
+uint16_t tuh_hid_report_available(uint8_t dev_addr, uint8_t idx) {
+  TU_VERIFY(get_hid_itf(dev_addr, idx), 0);
+  return (uint16_t) tu_fifo_count(&_hidh_rx[idx].ff);
+}
+
+uint16_t tuh_hid_report_read(uint8_t dev_addr, uint8_t idx, void* buffer, uint16_t bufsize) {
+  TU_VERIFY(get_hid_itf(dev_addr, idx), 0);
+
+  hidh_rx_report_t report;
+  TU_VERIFY(tu_fifo_read(&_hidh_rx[idx].ff, &report), 0);
+
+  uint16_t const len = tu_min16(report.len, bufsize);
+  memcpy(buffer, report.data, len);
+  return len;
+}
+#endif
+
 bool tuh_hid_send_ready(uint8_t dev_addr, uint8_t idx) {
   hidh_interface_t* p_hid = get_hid_itf(dev_addr, idx);
   TU_VERIFY(p_hid);
@@ -426,6 +640,14 @@ bool tuh_hid_send_report(uint8_t daddr, uint8_t idx, uint8_t report_id, const vo
 bool hidh_init(void) {
   TU_LOG_DRV("sizeof(hidh_interface_t) = %u\r\n", sizeof(hidh_interface_t));
   tu_memclr(_hidh_itf, sizeof(_hidh_itf));
+
+#if CFG_TUH_HID_RX_RING
+  for (uint8_t i = 0; i < CFG_TUH_HID; i++) {
+    hidh_rx_ring_t* ring = &_hidh_rx[i];
+    tu_fifo_config(&ring->ff, ring->ff_buf, CFG_TUH_HID_RX_RING, sizeof(hidh_rx_report_t), false);
+  }
+#endif
+
   return true;
 }
 
@@ -444,6 +666,13 @@ bool hidh_xfer_cb(uint8_t daddr, uint8_t ep_addr, xfer_result_t result, uint32_t
   hidh_epbuf_t* epbuf = get_hid_epbuf(idx);
 
   if (dir == TUSB_DIR_IN) {
+    #if CFG_TUH_HID_RX_RING && !HIDH_RX_DOUBLE_BUF
+    if (p_hid->rx_busy) {
+      rx_auto_received(p_hid, idx, 0, epbuf->epin, result, xferred_bytes);
+      return true;
+    }
+    #endif
+
     TU_LOG_DRV("  Get Report callback (%u, %u)\r\n", daddr, idx);
     TU_LOG3_MEM(epbuf->epin, xferred_bytes, 2);
     tuh_hid_report_received_cb(daddr, idx, epbuf->epin, (uint16_t) xferred_bytes);
@@ -463,6 +692,9 @@ void hidh_close(uint8_t daddr) {
       TU_LOG_DRV("  HIDh close addr = %u index = %u\r\n", daddr, i);
       if (tuh_hid_umount_cb) tuh_hid_umount_cb(daddr, i);
       tu_memclr(p_hid, sizeof(hidh_interface_t));
+      #if CFG_TUH_HID_RX_RING
+      tu_fifo_clear(&_hidh_rx[i].ff);
+      #endif
     }
   }
 }
@@ -761,4 +993,248 @@ uint8_t tuh_hid_parse_report_descriptor(tuh_hid_report_info_t* report_info_arr,
   return report_num;
 }
 
+//--------------------------------------------------------------------+
+// Report Field Parser
+//--------------------------------------------------------------------+
+
+#define HID_PARSER_USAGE_MAX  16 // usages of a main item
+#define HID_PARSER_STACK_MAX  4  // push/pop depth
+
+typedef struct {
+  uint16_t usage_page;
+  uint8_t  report_id;
+  uint8_t  report_size;
+  uint16_t report_count;
+  int32_t  logical_min;
+  int32_t  logical_max;
+} hid_parser_global_t;
+
+// Item data of 0, 1, 2 or 4 bytes
+static uint32_t parser_data_u32(uint8_t const* p, uint8_t size) {
+  switch (size) {
+    case 1: return p[0];
+    case 2: return tu_le16toh(tu_unaligned_read16(p));
+    case 4: return tu_le32toh(tu_unaligned_read32(p));
+    default: return 0;
+  }
+}
+
+static int32_t parser_data_i32(uint8_t const* p, uint8_t size) {
+  switch (size) {
+    case 1: return (int8_t) p[0];
+    case 2: return (int16_t) tu_le16toh(tu_unaligned_read16(p));
+    case 4: return (int32_t) tu_le32toh(tu_unaligned_read32(p));
+    default: return 0;
+  }
+}
+
+// Bit offset following the last field of the same report
+static uint16_t parser_next_offset(tuh_hid_field_t const* fields, uint16_t count, uint8_t report_id, uint8_t report_type) {
+  while (count--) {
+    tuh_hid_field_t const* f = &fields[count];
+    if (f->report_id == report_id && f->report_type == report_type) {
+      return (uint16_t) (f->bit_offset + f->bit_size * f->count);
+    }
+  }
+  return 0;
+}
+
+uint16_t tuh_hid_parse_report_fields(tuh_hid_field_t* fields, uint16_t max_fields, uint8_t const* desc_report, uint16_t desc_len) {
+  hid_parser_global_t global = { 0 };
+  hid_parser_global_t stack[HID_PARSER_STACK_MAX];
+  uint8_t sp = 0;
+
+  // local items, usage page in upper 16 bit if given as extended usage
+  uint32_t usages[HID_PARSER_USAGE_MAX];
+  uint8_t usage_count = 0;
+  uint32_t usage_min = 0, usage_max = 0;
+  bool usage_range = false;
+
+  uint16_t nfield = 0;
+
+  while (desc_len && nfield < max_fields) {
+    uint8_t const header = *desc_report++;
+    desc_len--;
+
+    // Long item: bDataSize, bLongItemTag then data, none is defined by spec
+    if (header == 0xFE) {
+      TU_VERIFY(desc_len >= 2, nfield);
+      uint16_t const skip = (uint16_t) (2 + desc_report[0]);
+      TU_VERIFY(desc_len >= skip, nfield);
+      desc_report += skip;
+      desc_len -= skip;
+      continue;
+    }
+
+    uint8_t const size = (header & 0x03) == 3 ? 4 : (header & 0x03);
+    uint8_t const type = (header >> 2) & 0x03;
+    uint8_t const tag = header >> 4;
+    TU_VERIFY(desc_len >= size, nfield);
+
+    uint32_t const udata = parser_data_u32(desc_report, size);
+
+    switch (type) {
+      case RI_TYPE_MAIN:
+        if (tag == RI_MAIN_INPUT || tag == RI_MAIN_OUTPUT || tag == RI_MAIN_FEATURE) {
+          uint8_t const rtype = (tag == RI_MAIN_INPUT) ? HID_REPORT_TYPE_INPUT :
+                                (tag == RI_MAIN_OUTPUT) ? HID_REPORT_TYPE_OUTPUT : HID_REPORT_TYPE_FEATURE;
+          uint16_t offset = parser_next_offset(fields, nfield, global.report_id, rtype);
+
+          // logical maximum is often given as unsigned with non-negative minimum
+          int32_t logical_max = global.logical_max;
+          if (global.logical_min >= 0 && logical_max < 0) {
+            logical_max = INT32_MAX;
+          }
+
+          // variable item with a usage list: one field per element, last usage applies to remaining elements
+          bool const per_element = (udata & HID_VARIABLE) && !usage_range && usage_count > 1;
+          uint16_t const nsplit = per_element ? global.report_count : 1;
+
+          for (uint16_t i = 0; i < nsplit && nfield < max_fields; i++) {
+            tuh_hid_field_t* f = &fields[nfield++];
+            uint32_t umin, umax;
+            if (per_element) {
+              umin = umax = usages[tu_min16(i, (uint16_t) (usage_count - 1))];
+            } else if (usage_range) {
+              umin = usage_min;
+              umax = usage_max;
+            } else {
+              umin = usage_count ? usages[0] : 0;
+              umax = usage_count ? usages[usage_count - 1] : 0;
+            }
+
+            f->report_id = global.report_id;
+            f->report_type = rtype;
+            f->flags = (uint8_t) udata;
+            f->bit_size = global.report_size;
+            f->bit_offset = offset;
+            f->count = per_element ? 1 : global.report_count;
+            f->usage_page = (umin >> 16) ? (uint16_t) (umin >> 16) : global.usage_page;
+            f->usage_min = (uint16_t) umin;
+            f->usage_max = (uint16_t) umax;
+            f->logical_min = global.logical_min;
+            f->logical_max = logical_max;
+
+            offset = (uint16_t) (offset + f->bit_size * f->count);
+          }
+        }
+
+        // local items only apply to the next main item
+        usage_count = 0;
+        usage_range = false;
+        break;
+
+      case RI_TYPE_GLOBAL:
+        switch (tag) {
+          case RI_GLOBAL_USAGE_PAGE:   global.usage_page = (uint16_t) udata; break;
+          case RI_GLOBAL_LOGICAL_MIN:  global.logical_min = parser_data_i32(desc_report, size); break;
+          case RI_GLOBAL_LOGICAL_MAX:  global.logical_max = parser_data_i32(desc_report, size); break;
+          case RI_GLOBAL_REPORT_ID:    global.report_id = (uint8_t) udata; break;
+          case RI_GLOBAL_REPORT_SIZE:  global.report_size = (uint8_t) udata; break;
+          case RI_GLOBAL_REPORT_COUNT: global.report_count = (uint16_t) udata; break;
+
+          case RI_GLOBAL_PUSH:
+            TU_VERIFY(sp < HID_PARSER_STACK_MAX, nfield);
+            stack[sp++] = global;
+            break;
+
+          case RI_GLOBAL_POP:
+            TU_VERIFY(sp > 0, nfield);
+            global = stack[--sp];
+            break;
+
+          default: break;
+        }
+        break;
+
+      case RI_TYPE_LOCAL:
+        switch (tag) {
+          case RI_LOCAL_USAGE:
+            if (usage_count < HID_PARSER_USAGE_MAX) {
+              usages[usage_count++] = udata;
+            }
+            break;
+
+          case RI_LOCAL_USAGE_MIN:
+            usage_min = udata;
+            usage_range = true;
+            break;
+
+          case RI_LOCAL_USAGE_MAX:
+            usage_max = udata;
+            usage_range = true;
+            break;
+
+          default: break;
+        }
+        break;
+
+      default: break;
+    }
+
+    desc_report += size;
+    desc_len = (uint16_t) (desc_len - size);
+  }
+
+  return nfield;
+}
+
+tuh_hid_field_t const* tuh_hid_field_find(tuh_hid_field_t const* fields, uint16_t count, uint8_t report_type,
+                                          uint16_t usage_page, uint16_t usage, uint16_t* index) {
+  for (uint16_t i = 0; i < count; i++) {
+    tuh_hid_field_t const* f = &fields[i];
+    if (f->report_type == report_type && (f->flags & HID_VARIABLE) && !(f->flags & HID_CONSTANT) &&
+        f->usage_page == usage_page && f->usage_min <= usage && usage <= f->usage_max) {
+      uint16_t const idx = (uint16_t) (usage - f->usage_min);
+      if (idx < f->count) {
+        if (index) *index = idx;
+        return f;
+      }
+    }
+  }
+  return NULL;
+}
+
+bool tuh_hid_field_read(tuh_hid_field_t const* field, uint16_t index, uint8_t const* report, uint16_t len, int32_t* value) {
+  uint8_t const bit_size = field->bit_size;
+  TU_VERIFY(index < field->count && bit_size > 0 && bit_size <= 32);
+
+  if (field->report_id) {
+    TU_VERIFY(len && report[0] == field->report_id);
+    report++;
+    len--;
+  }
+
+  uint32_t const bit_pos = field->bit_offset + (uint32_t) index * bit_size;
+  uint32_t const byte_pos = bit_pos >> 3;
+  uint8_t const shift = (uint8_t) (bit_pos & 7);
+  uint32_t raw;
+
+  if (shift == 0 && (bit_size == 8 || bit_size == 16 || bit_size == 32)) {
+    // byte-aligned
+    TU_VERIFY(byte_pos + bit_size / 8 <= len);
+    uint8_t const* p = report + byte_pos;
+    raw = (bit_size == 8) ? p[0] : (bit_size == 16) ? tu_le16toh(tu_unaligned_read16(p)) : tu_le32toh(tu_unaligned_read32(p));
+  } else {
+    uint8_t const nbytes = (uint8_t) ((shift + bit_size + 7) / 8); // up to 5 bytes
+    TU_VERIFY(byte_pos + nbytes <= len);
+    uint64_t acc = 0;
+    for (uint8_t i = 0; i < nbytes; i++) {
+      acc |= (uint64_t) report[byte_pos + i] << (8 * i);
+    }
+    raw = (uint32_t) (acc >> shift);
+    if (bit_size < 32) {
+      raw &= (1ul << bit_size) - 1;
+    }
+  }
+
+  // sign extend
+  if (field->logical_min < 0 && bit_size < 32 && (raw & (1ul << (bit_size - 1)))) {
+    raw |= ~((1ul << bit_size) - 1);
+  }
+
+  *value = (int32_t) raw;
+  return true;
+}
+
 #endif
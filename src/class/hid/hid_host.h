@@ -46,6 +46,32 @@ extern "C" {
 #define CFG_TUH_HID_EPOUT_BUFSIZE 64
 #endif
 
+// Number of reports buffered per interface in auto receive mode (tuh_hid_receive_auto()), 0 to disable.
+// With CFG_TUH_EDPT_XFER_QUEUE, two IN transfers are kept in flight so that endpoint is always armed.
+#ifndef CFG_TUH_HID_RX_RING
+#define CFG_TUH_HID_RX_RING 0
+#endif
+
+// Adaptive polling in auto receive mode (tuh_hid_poll_adaptive()): once a device has not sent a report for
+// CFG_TUH_HID_POLL_IDLE_MS (keeps NAKing), its IN transfer is aborted and polling is paused. Pause doubles on each idle
+// period up to CFG_TUH_HID_POLL_BACKOFF_MAX_MS, and is reset by the next report. Reports are held by the device while
+// paused, saving bus and CPU time of hosts with many idle devices at the cost of latency of the first report.
+#ifndef CFG_TUH_HID_POLL_ADAPTIVE
+#define CFG_TUH_HID_POLL_ADAPTIVE 0
+#endif
+
+#ifndef CFG_TUH_HID_POLL_IDLE_MS
+#define CFG_TUH_HID_POLL_IDLE_MS 100
+#endif
+
+#ifndef CFG_TUH_HID_POLL_BACKOFF_MAX_MS
+#define CFG_TUH_HID_POLL_BACKOFF_MAX_MS 800
+#endif
+
+#if CFG_TUH_HID_POLL_ADAPTIVE && !CFG_TUH_HID_RX_RING
+  #error "CFG_TUH_HID_POLL_ADAPTIVE requires CFG_TUH_HID_RX_RING"
+#endif
+
 
 typedef struct {
   uint8_t report_id;
@@ -57,6 +83,22 @@ typedef struct {
 //  uint8_t out_len;     // length of OUT report
 } tuh_hid_report_info_t;
 
+// Report field parsed by tuh_hid_parse_report_fields(): one per main item, or one per element for variable items
+// with a list of usages
+typedef struct {
+  uint8_t  report_id;
+  uint8_t  report_type;  // hid_report_type_t
+  uint8_t  flags;        // main item data e.g HID_CONSTANT, HID_VARIABLE, HID_RELATIVE
+  uint8_t  bit_size;     // report size of an element
+  uint16_t bit_offset;   // offset of the first element in report, excluding report ID
+  uint16_t count;        // report count i.e number of elements
+  uint16_t usage_page;
+  uint16_t usage_min;    // usage of the first element, or usage minimum for array
+  uint16_t usage_max;    // usage of the last element, or usage maximum for array
+  int32_t  logical_min;
+  int32_t  logical_max;
+} tuh_hid_field_t;
+
 //--------------------------------------------------------------------+
 // Interface API
 //--------------------------------------------------------------------+
@@ -88,6 +130,19 @@ bool tuh_hid_mounted(uint8_t dev_addr, uint8_t idx);
 TU_ATTR_UNUSED uint8_t tuh_hid_parse_report_descriptor(tuh_hid_report_info_t* reports_info_arr, uint8_t arr_count,
                                                        uint8_t const* desc_report, uint16_t desc_len);
 
+// Parse report descriptor into array of fields and return number of fields. Should be done once e.g in tuh_hid_mount_cb()
+// then tuh_hid_field_find() and tuh_hid_field_read() decode received reports without re-parsing.
+uint16_t tuh_hid_parse_report_fields(tuh_hid_field_t* fields, uint16_t max_fields, uint8_t const* desc_report, uint16_t desc_len);
+
+// Find the variable field of report type containing usage, index is set to the element of that usage.
+// Return NULL if not found
+tuh_hid_field_t const* tuh_hid_field_find(tuh_hid_field_t const* fields, uint16_t count, uint8_t report_type,
+                                          uint16_t usage_page, uint16_t usage, uint16_t* index);
+
+// Read an element of field from report as received (with report ID as 1st byte if field has one).
+// Value is sign extended if logical minimum is negative. Return false if report ID mismatches or report is too short
+bool tuh_hid_field_read(tuh_hid_field_t const* field, uint16_t index, uint8_t const* report, uint16_t len, int32_t* value);
+
 //--------------------------------------------------------------------+
 // Control Endpoint API
 //--------------------------------------------------------------------+
@@ -129,6 +184,26 @@ bool tuh_hid_receive_report(uint8_t dev_addr, uint8_t idx);
 // Abort receiving report on Interrupt Endpoint
 bool tuh_hid_receive_abort(uint8_t dev_addr, uint8_t idx);
 
+#if CFG_TUH_HID_RX_RING
+// Enable/disable auto receive mode: IN transfer is re-submitted as soon as previous one completes, and reports are
+// buffered in a ring of CFG_TUH_HID_RX_RING entries instead of invoking tuh_hid_report_received_cb(). Report is
+// dropped if ring is full. Auto mode stops on transfer error. Should be called in the same context as tuh_task().
+bool tuh_hid_receive_auto(uint8_t dev_addr, uint8_t idx, bool enable);
+
+// Number of reports buffered in auto receive mode
+uint16_t tuh_hid_report_available(uint8_t dev_addr, uint8_t idx);
+
+// Read oldest buffered report (with report ID as 1st byte if any), truncated to bufsize.
+// Return its length, 0 if there is none. Lock-free: can be called from a different context than tuh_task()
+uint16_t tuh_hid_report_read(uint8_t dev_addr, uint8_t idx, void* buffer, uint16_t bufsize);
+#endif
+
+#if CFG_TUH_HID_POLL_ADAPTIVE
+// Enable/disable adaptive polling of an interface in auto receive mode, disabled when mounted.
+// Polling interval itself can be overridden with tuh_edpt_interval_cb()
+bool tuh_hid_poll_adaptive(uint8_t dev_addr, uint8_t idx, bool enable);
+#endif
+
 // Check if HID interface is ready to send report
 bool tuh_hid_send_ready(uint8_t dev_addr, uint8_t idx);
 
@@ -52,9 +52,41 @@ typedef enum
 
 typedef enum
 {
-  MIDI_CS_ENDPOINT_GENERAL = 0x01
+  MIDI_CS_ENDPOINT_GENERAL     = 0x01,
+  MIDI_CS_ENDPOINT_GENERAL_2_0 = 0x02, // MIDI 2.0 alternate setting
 } midi_cs_endpoint_subtype_t;
 
+//------------- MIDI 2.0 Group Terminal Block -------------//
+
+// Descriptor type of Group Terminal Block, requested by GET_DESCRIPTOR to MIDI Streaming interface
+enum {
+  MIDI_CS_GR_TRM_BLOCK = 0x26
+};
+
+typedef enum
+{
+  MIDI_GR_TRM_BLOCK_HEADER = 0x01,
+  MIDI_GR_TRM_BLOCK        = 0x02,
+} midi_gr_trm_block_subtype_t;
+
+typedef enum
+{
+  MIDI_GR_TRM_BLOCK_TYPE_BIDIRECTIONAL = 0x00,
+  MIDI_GR_TRM_BLOCK_TYPE_IN_ONLY       = 0x01,
+  MIDI_GR_TRM_BLOCK_TYPE_OUT_ONLY      = 0x02,
+} midi_gr_trm_block_type_t;
+
+typedef enum
+{
+  MIDI_GR_TRM_BLOCK_PROTOCOL_UNKNOWN           = 0x00,
+  MIDI_GR_TRM_BLOCK_PROTOCOL_MIDI_1_64         = 0x01, // MIDI 1.0 UMP up to 64 bits
+  MIDI_GR_TRM_BLOCK_PROTOCOL_MIDI_1_64_JRTS    = 0x02, // MIDI 1.0 UMP up to 64 bits with Jitter Reduction Timestamps
+  MIDI_GR_TRM_BLOCK_PROTOCOL_MIDI_1_128        = 0x03, // MIDI 1.0 UMP up to 128 bits
+  MIDI_GR_TRM_BLOCK_PROTOCOL_MIDI_1_128_JRTS   = 0x04, // MIDI 1.0 UMP up to 128 bits with Jitter Reduction Timestamps
+  MIDI_GR_TRM_BLOCK_PROTOCOL_MIDI_2            = 0x11, // MIDI 2.0 UMP
+  MIDI_GR_TRM_BLOCK_PROTOCOL_MIDI_2_JRTS       = 0x12, // MIDI 2.0 UMP with Jitter Reduction Timestamps
+} midi_gr_trm_block_protocol_t;
+
 typedef enum
 {
   MIDI_JACK_EMBEDDED = 0x01,
@@ -201,6 +233,45 @@ typedef struct TU_ATTR_PACKED
     uint8_t  iElement;          \
  }
 
+/// MIDI 2.0 Group Terminal Block Header Descriptor
+typedef struct TU_ATTR_PACKED
+{
+  uint8_t  bLength            ; ///< Size of this descriptor in bytes: 5
+  uint8_t  bDescriptorType    ; ///< MIDI_CS_GR_TRM_BLOCK
+  uint8_t  bDescriptorSubType ; ///< MIDI_GR_TRM_BLOCK_HEADER
+  uint16_t wTotalLength       ; ///< Total length of header and all block descriptors
+} midi_desc_gr_trm_block_header_t;
+
+/// MIDI 2.0 Group Terminal Block Descriptor
+typedef struct TU_ATTR_PACKED
+{
+  uint8_t  bLength            ; ///< Size of this descriptor in bytes: 13
+  uint8_t  bDescriptorType    ; ///< MIDI_CS_GR_TRM_BLOCK
+  uint8_t  bDescriptorSubType ; ///< MIDI_GR_TRM_BLOCK
+  uint8_t  bGrpTrmBlkID       ; ///< ID of this block, referenced by MS endpoint descriptor
+  uint8_t  bGrpTrmBlkType     ; ///< midi_gr_trm_block_type_t
+  uint8_t  nGroupTrm          ; ///< First group (0-15)
+  uint8_t  nNumGroupTrm       ; ///< Number of groups spanned
+  uint8_t  iBlockItem         ; ///< string descriptor
+  uint8_t  bMIDIProtocol      ; ///< midi_gr_trm_block_protocol_t
+  uint16_t wMaxInputBandwidth ; ///< in 4KB/s unit, 0 if unknown
+  uint16_t wMaxOutputBandwidth; ///< in 4KB/s unit, 0 if unknown
+} midi_desc_gr_trm_block_t;
+
+TU_VERIFY_STATIC(sizeof(midi_desc_gr_trm_block_header_t) == 5, "size is not correct");
+TU_VERIFY_STATIC(sizeof(midi_desc_gr_trm_block_t) == 13, "size is not correct");
+
+//--------------------------------------------------------------------+
+// Universal MIDI Packet (UMP)
+//--------------------------------------------------------------------+
+
+// Number of 32-bit words of an UMP, determined by Message Type (upper 4 bits of the 1st word)
+TU_ATTR_ALWAYS_INLINE static inline uint8_t midi_ump_word_count(uint32_t word0) {
+  // MT:                          0  1  2  3  4  5  6  7  8  9  A  B  C  D  E  F
+  static const uint8_t count[] = {1, 1, 1, 2, 2, 4, 1, 1, 2, 2, 2, 3, 3, 4, 4, 4};
+  return count[word0 >> 28];
+}
+
 /** @} */
 
 #ifdef __cplusplus
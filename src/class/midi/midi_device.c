@@ -47,10 +47,17 @@ typedef struct {
 } midid_stream_t;
 
 typedef struct {
+  uint8_t rhport;
   uint8_t itf_num;
   uint8_t ep_in;
   uint8_t ep_out;
 
+  #if CFG_TUD_MIDI_UMP
+  uint8_t alt; // alternate setting of MIDI Streaming interface, 1 is MIDI 2.0 (UMP)
+  uint16_t ms_desc_len; // MIDI Streaming interface descriptors of all alternate settings
+  const uint8_t* ms_desc;
+  #endif
+
   // For Stream read()/write() API
   // Messages are always 4 bytes long, queue them for reading and writing so the
   // callers can use the Stream interface with single-byte read/write calls.
@@ -88,10 +95,20 @@ bool tud_midi_n_mounted (uint8_t itf) {
   return midi->ep_in && midi->ep_out;
 }
 
+// MIDI 1.0 stream/packet API is not used when host selected MIDI 2.0 alternate setting
+TU_ATTR_ALWAYS_INLINE static inline bool _is_ump(const midid_interface_t* midi) {
+  #if CFG_TUD_MIDI_UMP
+  return midi->alt != 0;
+  #else
+  (void) midi;
+  return false;
+  #endif
+}
+
 static void _prep_out_transaction(uint8_t idx) {
-  const uint8_t rhport = 0;
   midid_interface_t* p_midi = &_midid_itf[idx];
-  uint16_t available = tu_fifo_remaining(&p_midi->rx_ff);
+  const uint8_t rhport = p_midi->rhport;
+  uint32_t available = tu_fifo_remaining(&p_midi->rx_ff);
 
   // Prepare for incoming data but only allow what we can store in the ring buffer.
   // TODO Actually we can still carry out the transfer, keeping count of received bytes
@@ -201,13 +218,24 @@ uint32_t tud_midi_n_stream_read(uint8_t itf, uint8_t cable_num, void* buffer, ui
 bool tud_midi_n_packet_read (uint8_t itf, uint8_t packet[4])
 {
   midid_interface_t* midi = &_midid_itf[itf];
-  TU_VERIFY(midi->ep_out);
+  TU_VERIFY(midi->ep_out && !_is_ump(midi));
 
   const uint32_t num_read = tu_fifo_read_n(&midi->rx_ff, packet, 4);
   _prep_out_transaction(itf);
   return (num_read == 4);
 }
 
+uint32_t tud_midi_n_packets_read(uint8_t itf, uint8_t* packets, uint32_t count) {
+  midid_interface_t* midi = &_midid_itf[itf];
+  TU_VERIFY(midi->ep_out && !_is_ump(midi), 0);
+
+  count = tu_min32(count, tu_fifo_count(&midi->rx_ff) / 4);
+  const uint32_t num_read = tu_fifo_read_n(&midi->rx_ff, packets, (tu_fifo_size_t) (4 * count));
+  _prep_out_transaction(itf);
+
+  return num_read / 4;
+}
+
 //--------------------------------------------------------------------+
 // WRITE API
 //--------------------------------------------------------------------+
@@ -219,12 +247,12 @@ static uint32_t write_flush(uint8_t idx) {
     return 0; // No data to send
   }
 
-  const uint8_t rhport = 0;
+  const uint8_t rhport = midi->rhport;
 
   // skip if previous transfer not complete
   TU_VERIFY( usbd_edpt_claim(rhport, midi->ep_in), 0 );
 
-  uint16_t count = tu_fifo_read_n(&midi->tx_ff, _midid_epbuf[idx].epin, CFG_TUD_MIDI_EP_BUFSIZE);
+  uint16_t count = (uint16_t) tu_fifo_read_n(&midi->tx_ff, _midid_epbuf[idx].epin, CFG_TUD_MIDI_EP_BUFSIZE);
 
   if (count) {
     TU_ASSERT( usbd_edpt_xfer(rhport, midi->ep_in, _midid_epbuf[idx].epin, count), 0 );
@@ -239,7 +267,7 @@ static uint32_t write_flush(uint8_t idx) {
 uint32_t tud_midi_n_stream_write(uint8_t itf, uint8_t cable_num, const uint8_t* buffer, uint32_t bufsize)
 {
   midid_interface_t* midi = &_midid_itf[itf];
-  TU_VERIFY(midi->ep_in, 0);
+  TU_VERIFY(midi->ep_in && !_is_ump(midi), 0);
 
   midid_stream_t* stream = &midi->stream_write;
 
@@ -341,7 +369,7 @@ uint32_t tud_midi_n_stream_write(uint8_t itf, uint8_t cable_num, const uint8_t*
         stream->buffer[idx] = 0;
       }
 
-      const uint16_t count = tu_fifo_write_n(&midi->tx_ff, stream->buffer, 4);
+      const uint16_t count = (uint16_t) tu_fifo_write_n(&midi->tx_ff, stream->buffer, 4);
 
       // complete current event packet, reset stream
       stream->index = stream->total = 0;
@@ -358,7 +386,7 @@ uint32_t tud_midi_n_stream_write(uint8_t itf, uint8_t cable_num, const uint8_t*
 
 bool tud_midi_n_packet_write (uint8_t itf, const uint8_t packet[4]) {
   midid_interface_t* midi = &_midid_itf[itf];
-  TU_VERIFY(midi->ep_in);
+  TU_VERIFY(midi->ep_in && !_is_ump(midi));
 
   if (tu_fifo_remaining(&midi->tx_ff) < 4) {
     return false;
@@ -370,6 +398,162 @@ bool tud_midi_n_packet_write (uint8_t itf, const uint8_t packet[4]) {
   return true;
 }
 
+uint32_t tud_midi_n_packets_write(uint8_t itf, const uint8_t* packets, uint32_t count) {
+  midid_interface_t* midi = &_midid_itf[itf];
+  TU_VERIFY(midi->ep_in && !_is_ump(midi), 0);
+
+  count = tu_min32(count, tu_fifo_remaining(&midi->tx_ff) / 4);
+  const uint32_t num_written = tu_fifo_write_n(&midi->tx_ff, packets, (tu_fifo_size_t) (4 * count));
+  write_flush(itf);
+
+  return num_written / 4;
+}
+
+uint32_t tud_midi_n_sysex_write(uint8_t itf, uint8_t cable_num, const uint8_t* sysex, uint32_t len) {
+  midid_interface_t* midi = &_midid_itf[itf];
+  TU_VERIFY(midi->ep_in && !_is_ump(midi) && len, 0);
+
+  bool const has_end = (sysex[len - 1] == MIDI_STATUS_SYSEX_END);
+  uint8_t const cable = (uint8_t) (cable_num << 4);
+
+  // convert a chunk of packets on stack, then write it to fifo at once
+  uint8_t packets[4 * 16];
+  uint32_t i = 0;
+
+  while (i < len) {
+    uint32_t const room = tu_min32(TU_ARRAY_SIZE(packets) / 4, tu_fifo_remaining(&midi->tx_ff) / 4);
+    uint32_t n = 0;
+
+    while (n < room && i < len) {
+      uint32_t const remain = len - i;
+      uint8_t* p = &packets[4 * n];
+
+      if (remain > 3 || (remain == 3 && !has_end)) {
+        // start or continue
+        p[0] = cable | MIDI_CIN_SYSEX_START;
+        memcpy(&p[1], &sysex[i], 3);
+        i += 3;
+      } else if (has_end) {
+        // end with 1, 2 or 3 bytes
+        p[0] = (uint8_t) (cable | (MIDI_CIN_SYSEX_START + remain));
+        p[1] = p[2] = p[3] = 0;
+        memcpy(&p[1], &sysex[i], remain);
+        i += remain;
+      } else {
+        // incomplete remainder without end, left for next call
+        break;
+      }
+      n++;
+    }
+
+    if (n == 0) {
+      break;
+    }
+
+    const uint32_t count = tu_fifo_write_n(&midi->tx_ff, packets, (tu_fifo_size_t) (4 * n));
+    TU_ASSERT(count == 4 * n, i); // FIFO overflown, probably race condition
+  }
+
+  write_flush(itf);
+
+  return i;
+}
+
+//--------------------------------------------------------------------+
+// UMP API
+//--------------------------------------------------------------------+
+#if CFG_TUD_MIDI_UMP
+// UMP words are transferred in little endian, FIFOs hold them as-is
+bool tud_midi_n_ump_active(uint8_t itf) {
+  return tud_midi_n_mounted(itf) && _midid_itf[itf].alt != 0;
+}
+
+uint32_t tud_midi_n_ump_available(uint8_t itf) {
+  return tu_fifo_count(&_midid_itf[itf].rx_ff) / 4;
+}
+
+uint32_t tud_midi_n_ump_read(uint8_t itf, uint32_t* words, uint32_t count) {
+  midid_interface_t* midi = &_midid_itf[itf];
+  TU_VERIFY(midi->ep_out && midi->alt, 0);
+
+  count = tu_min32(count, tu_fifo_count(&midi->rx_ff) / 4);
+  const uint32_t num_read = tu_fifo_read_n(&midi->rx_ff, words, (tu_fifo_size_t) (4 * count));
+  _prep_out_transaction(itf);
+
+  return num_read / 4;
+}
+
+uint32_t tud_midi_n_ump_write(uint8_t itf, const uint32_t* words, uint32_t count) {
+  midid_interface_t* midi = &_midid_itf[itf];
+  TU_VERIFY(midi->ep_in && midi->alt, 0);
+
+  // only whole messages that fit in fifo
+  const uint32_t room = tu_min32(count, tu_fifo_remaining(&midi->tx_ff) / 4);
+  uint32_t n = 0;
+  while (n < room) {
+    const uint8_t len = midi_ump_word_count(words[n]);
+    if (n + len > room) {
+      break;
+    }
+    n += len;
+  }
+
+  const uint32_t num_written = tu_fifo_write_n(&midi->tx_ff, words, (tu_fifo_size_t) (4 * n));
+  write_flush(itf);
+
+  return num_written / 4;
+}
+
+// Switch alternate setting: re-open endpoints from descriptors of the selected one
+static bool _set_alt(uint8_t rhport, uint8_t idx, uint8_t alt) {
+  midid_interface_t* p_midi = &_midid_itf[idx];
+  TU_VERIFY(p_midi->ms_desc && alt < 2); // MIDI 1.0 (0) or MIDI 2.0 (1)
+
+  if (p_midi->ep_in) {
+    usbd_edpt_close(rhport, p_midi->ep_in);
+  }
+  if (p_midi->ep_out) {
+    usbd_edpt_close(rhport, p_midi->ep_out);
+  }
+
+  p_midi->ep_in = p_midi->ep_out = 0;
+  tu_memclr(&p_midi->stream_write, sizeof(midid_stream_t));
+  tu_memclr(&p_midi->stream_read, sizeof(midid_stream_t));
+  tu_fifo_clear(&p_midi->rx_ff);
+  tu_fifo_clear(&p_midi->tx_ff);
+
+  const uint8_t* p_desc = p_midi->ms_desc;
+  const uint8_t* desc_end = p_midi->ms_desc + p_midi->ms_desc_len;
+  bool found = false;
+
+  while (p_desc < desc_end) {
+    if (TUSB_DESC_INTERFACE == tu_desc_type(p_desc)) {
+      found = (((const tusb_desc_interface_t*) p_desc)->bAlternateSetting == alt);
+    } else if (found && TUSB_DESC_ENDPOINT == tu_desc_type(p_desc)) {
+      const tusb_desc_endpoint_t* desc_ep = (const tusb_desc_endpoint_t*) p_desc;
+      TU_ASSERT(usbd_edpt_open(rhport, desc_ep));
+
+      if (tu_edpt_dir(desc_ep->bEndpointAddress) == TUSB_DIR_IN) {
+        p_midi->ep_in = desc_ep->bEndpointAddress;
+      } else {
+        p_midi->ep_out = desc_ep->bEndpointAddress;
+      }
+    }
+    p_desc = tu_desc_next(p_desc);
+  }
+
+  TU_VERIFY(p_midi->ep_in && p_midi->ep_out);
+  p_midi->alt = alt;
+
+  if (tud_midi_ump_mode_cb) {
+    tud_midi_ump_mode_cb(idx, alt != 0);
+  }
+
+  _prep_out_transaction(idx);
+  return true;
+}
+#endif
+
 //--------------------------------------------------------------------+
 // USBD Driver API
 //--------------------------------------------------------------------+
@@ -418,11 +602,11 @@ bool midid_deinit(void) {
 
 void midid_reset(uint8_t rhport)
 {
-  (void) rhport;
-
   for(uint8_t i=0; i<CFG_TUD_MIDI; i++)
   {
     midid_interface_t* midi = &_midid_itf[i];
+    // keep interface opened on other root port
+    if ((midi->ep_in || midi->ep_out) && midi->rhport != rhport) continue;
     tu_memclr(midi, ITF_MEM_RESET_SIZE);
     tu_fifo_clear(&midi->rx_ff);
     tu_fifo_clear(&midi->tx_ff);
@@ -465,9 +649,15 @@ uint16_t midid_open(uint8_t rhport, const tusb_desc_interface_t* desc_itf, uint1
   }
   TU_ASSERT(p_midi);
 
+  p_midi->rhport = rhport;
   p_midi->itf_num = desc_midi->bInterfaceNumber;
   (void) p_midi->itf_num;
 
+  #if CFG_TUD_MIDI_UMP
+  p_midi->ms_desc = p_desc;
+  const uint16_t ms_desc_start = drv_len;
+  #endif
+
   // next descriptor
   drv_len += tu_desc_len(p_desc);
   p_desc   = tu_desc_next(p_desc);
@@ -499,6 +689,22 @@ uint16_t midid_open(uint8_t rhport, const tusb_desc_interface_t* desc_itf, uint1
     p_desc   = tu_desc_next(p_desc);
   }
 
+  // Other alternate settings of MIDI Streaming interface e.g MIDI 2.0
+  while (drv_len < max_len) {
+    const uint8_t desc_type = tu_desc_type(p_desc);
+    if (TUSB_DESC_INTERFACE_ASSOCIATION == desc_type ||
+        (TUSB_DESC_INTERFACE == desc_type &&
+         ((const tusb_desc_interface_t*) p_desc)->bInterfaceNumber != desc_midi->bInterfaceNumber)) {
+      break;
+    }
+    drv_len += tu_desc_len(p_desc);
+    p_desc   = tu_desc_next(p_desc);
+  }
+
+  #if CFG_TUD_MIDI_UMP
+  p_midi->ms_desc_len = (uint16_t) (drv_len - ms_desc_start);
+  #endif
+
   // Prepare for incoming data
   _prep_out_transaction(idx);
 
@@ -509,30 +715,67 @@ uint16_t midid_open(uint8_t rhport, const tusb_desc_interface_t* desc_itf, uint1
 // Driver response accordingly to the request and the transfer stage (setup/data/ack)
 // return false to stall control endpoint (e.g unsupported request)
 bool midid_control_xfer_cb(uint8_t rhport, uint8_t stage, const tusb_control_request_t* request) {
+  #if CFG_TUD_MIDI_UMP
+  TU_VERIFY(TUSB_REQ_TYPE_STANDARD == request->bmRequestType_bit.type);
+
+  // only MIDI Streaming interface has alternate settings and Group Terminal Blocks
+  uint8_t idx;
+  for (idx = 0; idx < CFG_TUD_MIDI; idx++) {
+    if (_midid_itf[idx].ms_desc && _midid_itf[idx].rhport == rhport &&
+        _midid_itf[idx].itf_num == tu_u16_low(request->wIndex)) {
+      break;
+    }
+  }
+  TU_VERIFY(idx < CFG_TUD_MIDI);
+  midid_interface_t* p_midi = &_midid_itf[idx];
+
+  if (stage != CONTROL_STAGE_SETUP) {
+    return true;
+  }
+
+  switch (request->bRequest) {
+    case TUSB_REQ_GET_INTERFACE:
+      return tud_control_xfer(rhport, request, &p_midi->alt, 1);
+
+    case TUSB_REQ_SET_INTERFACE:
+      TU_VERIFY(_set_alt(rhport, idx, tu_u16_low(request->wValue)));
+      return tud_control_status(rhport, request);
+
+    case TUSB_REQ_GET_DESCRIPTOR:
+      if (tu_u16_high(request->wValue) == MIDI_CS_GR_TRM_BLOCK && tud_midi_descriptor_gtb_cb) {
+        const uint8_t* desc_gtb = tud_midi_descriptor_gtb_cb(idx);
+        TU_VERIFY(desc_gtb);
+        const uint16_t total_len = tu_le16toh(((const midi_desc_gr_trm_block_header_t*) desc_gtb)->wTotalLength);
+        return tud_control_xfer(rhport, request, (void*) (uintptr_t) desc_gtb, total_len);
+      }
+      return false;
+
+    default:
+      return false;
+  }
+  #else
   (void) rhport; (void) stage; (void) request;
   return false; // driver doesn't support any request yet
+  #endif
+}
+
+static bool midid_edpt_match(uint8_t idx, uint8_t rhport, uint8_t ep_addr)
+{
+  midid_interface_t const* p_midi = &_midid_itf[idx];
+  return p_midi->rhport == rhport && ((ep_addr == p_midi->ep_out) || (ep_addr == p_midi->ep_in));
 }
 
 bool midid_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes)
 {
   (void) result;
-  (void) rhport;
 
-  uint8_t idx;
-  midid_interface_t* p_midi;
-
-  // Identify which interface to use
-  for (idx = 0; idx < CFG_TUD_MIDI; idx++) {
-    p_midi = &_midid_itf[idx];
-    if ((ep_addr == p_midi->ep_out) || (ep_addr == p_midi->ep_in)) {
-      break;
-    }
-  }
+  uint8_t const idx = usbd_edpt_find_instance(rhport, ep_addr, _midid_itf, midid_edpt_match);
   TU_ASSERT(idx < CFG_TUD_MIDI);
+  midid_interface_t* p_midi = &_midid_itf[idx];
 
   // receive new data
   if (ep_addr == p_midi->ep_out) {
-    tu_fifo_write_n(&p_midi->rx_ff, _midid_epbuf[idx].epout, (uint16_t)xferred_bytes);
+    tu_fifo_write_n(&p_midi->rx_ff, _midid_epbuf[idx].epout, (tu_fifo_size_t) xferred_bytes);
 
     // invoke receive callback if available
     if (tud_midi_rx_cb) {
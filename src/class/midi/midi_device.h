@@ -43,6 +43,11 @@
   #define CFG_TUD_MIDI_EP_BUFSIZE     (TUD_OPT_HIGH_SPEED ? 512 : 64)
 #endif
 
+// Support MIDI 2.0 alternate setting (1) with Universal MIDI Packets, see TUD_MIDI2_DESCRIPTOR()
+#ifndef CFG_TUD_MIDI_UMP
+  #define CFG_TUD_MIDI_UMP            0
+#endif
+
 #ifdef __cplusplus
  extern "C" {
 #endif
@@ -75,6 +80,31 @@ bool     tud_midi_n_packet_read  (uint8_t itf, uint8_t packet[4]);
 // Write event packet            (4 bytes)
 bool     tud_midi_n_packet_write (uint8_t itf, uint8_t const packet[4]);
 
+// Read up to count event packets (4 bytes each) with a single FIFO operation, return number of packets read
+uint32_t tud_midi_n_packets_read (uint8_t itf, uint8_t* packets, uint32_t count);
+
+// Write up to count event packets (4 bytes each) with a single FIFO operation, return number of packets written
+uint32_t tud_midi_n_packets_write(uint8_t itf, uint8_t const* packets, uint32_t count);
+
+#if CFG_TUD_MIDI_UMP
+// Check if host selected MIDI 2.0 alternate setting: UMP API must be used instead of MIDI 1.0 stream/packet API
+bool     tud_midi_n_ump_active   (uint8_t itf);
+
+// Get the number of 32-bit UMP words available for reading
+uint32_t tud_midi_n_ump_available(uint8_t itf);
+
+// Read up to count UMP words, return number of words read. Message length can be determined with midi_ump_word_count()
+uint32_t tud_midi_n_ump_read     (uint8_t itf, uint32_t* words, uint32_t count);
+
+// Write whole UMP messages up to count words with a single FIFO operation, return number of words written
+uint32_t tud_midi_n_ump_write    (uint8_t itf, uint32_t const* words, uint32_t count);
+#endif
+
+// Write SysEx data (starting with 0xF0 and/or ending with 0xF7) converted to event packets in one pass, return number
+// of bytes written. If buffer does not end with 0xF7, only multiple of 3 bytes are written, the remainder should be
+// prepended to the next call. Must not be interleaved with stream_write() on the same interface.
+uint32_t tud_midi_n_sysex_write  (uint8_t itf, uint8_t cable_num, uint8_t const* sysex, uint32_t len);
+
 //--------------------------------------------------------------------+
 // Application API (Single Interface)
 //--------------------------------------------------------------------+
@@ -87,6 +117,17 @@ static inline uint32_t tud_midi_stream_write (uint8_t cable_num, uint8_t const*
 static inline bool     tud_midi_packet_read  (uint8_t packet[4]);
 static inline bool     tud_midi_packet_write (uint8_t const packet[4]);
 
+static inline uint32_t tud_midi_packets_read  (uint8_t* packets, uint32_t count);
+static inline uint32_t tud_midi_packets_write (uint8_t const* packets, uint32_t count);
+static inline uint32_t tud_midi_sysex_write   (uint8_t cable_num, uint8_t const* sysex, uint32_t len);
+
+#if CFG_TUD_MIDI_UMP
+static inline bool     tud_midi_ump_active    (void);
+static inline uint32_t tud_midi_ump_available (void);
+static inline uint32_t tud_midi_ump_read      (uint32_t* words, uint32_t count);
+static inline uint32_t tud_midi_ump_write     (uint32_t const* words, uint32_t count);
+#endif
+
 //------------- Deprecated API name  -------------//
 // TODO remove after 0.10.0 release
 
@@ -120,6 +161,15 @@ static inline bool tud_midi_receive(uint8_t packet[4])
 //--------------------------------------------------------------------+
 TU_ATTR_WEAK void tud_midi_rx_cb(uint8_t itf);
 
+#if CFG_TUD_MIDI_UMP
+// Invoked when received GET_DESCRIPTOR request for Group Terminal Blocks (MIDI 2.0)
+// Application return pointer to descriptors, starting with header, see TUD_MIDI2_GTB_HEADER() and TUD_MIDI2_GTB()
+TU_ATTR_WEAK uint8_t const* tud_midi_descriptor_gtb_cb(uint8_t itf);
+
+// Invoked when host selects alternate setting: MIDI 1.0 (ump = false) or MIDI 2.0 (ump = true)
+TU_ATTR_WEAK void tud_midi_ump_mode_cb(uint8_t itf, bool ump);
+#endif
+
 //--------------------------------------------------------------------+
 // Inline Functions
 //--------------------------------------------------------------------+
@@ -154,6 +204,43 @@ static inline bool tud_midi_packet_write (uint8_t const packet[4])
   return tud_midi_n_packet_write(0, packet);
 }
 
+static inline uint32_t tud_midi_packets_read (uint8_t* packets, uint32_t count)
+{
+  return tud_midi_n_packets_read(0, packets, count);
+}
+
+static inline uint32_t tud_midi_packets_write (uint8_t const* packets, uint32_t count)
+{
+  return tud_midi_n_packets_write(0, packets, count);
+}
+
+static inline uint32_t tud_midi_sysex_write (uint8_t cable_num, uint8_t const* sysex, uint32_t len)
+{
+  return tud_midi_n_sysex_write(0, cable_num, sysex, len);
+}
+
+#if CFG_TUD_MIDI_UMP
+static inline bool tud_midi_ump_active (void)
+{
+  return tud_midi_n_ump_active(0);
+}
+
+static inline uint32_t tud_midi_ump_available (void)
+{
+  return tud_midi_n_ump_available(0);
+}
+
+static inline uint32_t tud_midi_ump_read (uint32_t* words, uint32_t count)
+{
+  return tud_midi_n_ump_read(0, words, count);
+}
+
+static inline uint32_t tud_midi_ump_write (uint32_t const* words, uint32_t count)
+{
+  return tud_midi_n_ump_write(0, words, count);
+}
+#endif
+
 //--------------------------------------------------------------------+
 // Internal Class Driver API
 //--------------------------------------------------------------------+
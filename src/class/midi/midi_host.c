@@ -0,0 +1,550 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#include "tusb_option.h"
+
+#if (CFG_TUH_ENABLED && CFG_TUH_MIDI)
+
+#include "host/usbh.h"
+#include "host/usbh_pvt.h"
+
+#include "midi_host.h"
+
+// Level where CFG_TUSB_DEBUG must be at least for this driver is logged
+#ifndef CFG_TUH_MIDI_LOG_LEVEL
+  #define CFG_TUH_MIDI_LOG_LEVEL   CFG_TUH_LOG_LEVEL
+#endif
+
+#define TU_LOG_DRV(...)   TU_LOG(CFG_TUH_MIDI_LOG_LEVEL, __VA_ARGS__)
+
+//--------------------------------------------------------------------+
+// MACRO CONSTANT TYPEDEF
+//--------------------------------------------------------------------+
+typedef struct {
+  uint8_t buffer[4];
+  uint8_t index;
+  uint8_t total;
+} midih_stream_t;
+
+typedef struct {
+  uint8_t daddr;
+  uint8_t itf_num;        // MIDI Streaming interface
+  bool mounted;           // Enumeration is complete
+
+  uint8_t rx_cable_count; // embedded jacks of IN endpoint
+  uint8_t tx_cable_count; // embedded jacks of OUT endpoint
+
+  // partial event packet of stream read()/write() API
+  midih_stream_t stream_write;
+  midih_stream_t stream_read;
+
+  struct {
+    tu_edpt_stream_t tx;
+    tu_edpt_stream_t rx;
+
+    uint8_t tx_ff_buf[CFG_TUH_MIDI_TX_BUFSIZE];
+    uint8_t rx_ff_buf[CFG_TUH_MIDI_RX_BUFSIZE];
+  } stream;
+} midih_interface_t;
+
+typedef struct {
+  TUH_EPBUF_DEF(tx, CFG_TUH_MIDI_EP_BUFSIZE);
+  TUH_EPBUF_DEF(rx, CFG_TUH_MIDI_EP_BUFSIZE);
+} midih_epbuf_t;
+
+static midih_interface_t _midih_itf[CFG_TUH_MIDI];
+CFG_TUH_MEM_SECTION static midih_epbuf_t _midih_epbuf[CFG_TUH_MIDI];
+
+//--------------------------------------------------------------------+
+// Helper
+//--------------------------------------------------------------------+
+static inline midih_interface_t* get_itf(uint8_t idx) {
+  TU_ASSERT(idx < CFG_TUH_MIDI, NULL);
+  midih_interface_t* p_midi = &_midih_itf[idx];
+  return (p_midi->daddr != 0) ? p_midi : NULL;
+}
+
+static uint8_t get_idx_by_ep_addr(uint8_t daddr, uint8_t ep_addr) {
+  for (uint8_t i = 0; i < CFG_TUH_MIDI; i++) {
+    midih_interface_t const* p_midi = &_midih_itf[i];
+    if (p_midi->daddr == daddr &&
+        (ep_addr == p_midi->stream.rx.ep_addr || ep_addr == p_midi->stream.tx.ep_addr)) {
+      return i;
+    }
+  }
+  return TUSB_INDEX_INVALID_8;
+}
+
+// Number of MIDI bytes in event packet, MIDI 1.0 Table 4-1: Code Index Number Classifications
+static uint8_t cin_data_len(uint8_t code_index) {
+  switch (code_index) {
+    case MIDI_CIN_MISC:
+    case MIDI_CIN_CABLE_EVENT:
+      return 0; // reserved
+
+    case MIDI_CIN_SYSEX_END_1BYTE:
+    case MIDI_CIN_1BYTE_DATA:
+      return 1;
+
+    case MIDI_CIN_SYSCOM_2BYTE:
+    case MIDI_CIN_SYSEX_END_2BYTE:
+    case MIDI_CIN_PROGRAM_CHANGE:
+    case MIDI_CIN_CHANNEL_PRESSURE:
+      return 2;
+
+    default:
+      return 3;
+  }
+}
+
+//--------------------------------------------------------------------+
+// Application API
+//--------------------------------------------------------------------+
+uint8_t tuh_midi_itf_get_index(uint8_t daddr, uint8_t itf_num) {
+  for (uint8_t i = 0; i < CFG_TUH_MIDI; i++) {
+    midih_interface_t const* p_midi = &_midih_itf[i];
+    if (p_midi->daddr == daddr && p_midi->itf_num == itf_num) return i;
+  }
+  return TUSB_INDEX_INVALID_8;
+}
+
+bool tuh_midi_itf_get_info(uint8_t idx, tuh_itf_info_t* info) {
+  midih_interface_t* p_midi = get_itf(idx);
+  TU_VERIFY(p_midi && info);
+
+  info->daddr = p_midi->daddr;
+
+  // re-construct descriptor
+  tusb_desc_interface_t* desc = &info->desc;
+  desc->bLength            = sizeof(tusb_desc_interface_t);
+  desc->bDescriptorType    = TUSB_DESC_INTERFACE;
+  desc->bInterfaceNumber   = p_midi->itf_num;
+  desc->bAlternateSetting  = 0;
+  desc->bNumEndpoints      = (uint8_t) ((p_midi->stream.rx.ep_addr ? 1u : 0u) + (p_midi->stream.tx.ep_addr ? 1u : 0u));
+  desc->bInterfaceClass    = TUSB_CLASS_AUDIO;
+  desc->bInterfaceSubClass = AUDIO_SUBCLASS_MIDI_STREAMING;
+  desc->bInterfaceProtocol = AUDIO_FUNC_PROTOCOL_CODE_UNDEF;
+  desc->iInterface         = 0; // not used yet
+
+  return true;
+}
+
+bool tuh_midi_mounted(uint8_t idx) {
+  midih_interface_t* p_midi = get_itf(idx);
+  TU_VERIFY(p_midi);
+  return p_midi->mounted;
+}
+
+uint8_t tuh_midi_get_rx_cable_count(uint8_t idx) {
+  midih_interface_t* p_midi = get_itf(idx);
+  TU_VERIFY(p_midi, 0);
+  return p_midi->rx_cable_count;
+}
+
+uint8_t tuh_midi_get_tx_cable_count(uint8_t idx) {
+  midih_interface_t* p_midi = get_itf(idx);
+  TU_VERIFY(p_midi, 0);
+  return p_midi->tx_cable_count;
+}
+
+//--------------------------------------------------------------------+
+// Read
+//--------------------------------------------------------------------+
+uint32_t tuh_midi_read_available(uint8_t idx) {
+  midih_interface_t* p_midi = get_itf(idx);
+  TU_VERIFY(p_midi, 0);
+  return tu_edpt_stream_read_available(&p_midi->stream.rx);
+}
+
+bool tuh_midi_packet_read(uint8_t idx, uint8_t packet[4]) {
+  return 1 == tuh_midi_packets_read(idx, packet, 1);
+}
+
+uint32_t tuh_midi_packets_read(uint8_t idx, uint8_t* packets, uint32_t count) {
+  midih_interface_t* p_midi = get_itf(idx);
+  TU_VERIFY(p_midi && p_midi->stream.rx.ep_addr, 0);
+
+  // whole packets only
+  count = tu_min32(count, tu_edpt_stream_read_available(&p_midi->stream.rx) / 4);
+  TU_VERIFY(count, 0);
+
+  return tu_edpt_stream_read(p_midi->daddr, &p_midi->stream.rx, packets, 4 * count) / 4;
+}
+
+uint32_t tuh_midi_stream_read(uint8_t idx, uint8_t* p_cable_num, void* buffer, uint32_t bufsize) {
+  midih_interface_t* p_midi = get_itf(idx);
+  TU_VERIFY(p_midi && p_cable_num, 0);
+
+  midih_stream_t* stream = &p_midi->stream_read;
+  uint8_t* buf8 = (uint8_t*) buffer;
+  uint32_t total_read = 0;
+
+  while (bufsize) {
+    // Get new packet from fifo, then set packet expected bytes
+    if (stream->total == 0) {
+      if (!tuh_midi_packet_read(idx, stream->buffer)) {
+        break;
+      }
+      stream->index = 0;
+      stream->total = cin_data_len(stream->buffer[0] & 0x0f);
+      if (stream->total == 0) {
+        continue; // skip reserved packet
+      }
+    }
+
+    // demux: return data of one cable per call, packet of other cable is kept for next call
+    uint8_t const cable_num = stream->buffer[0] >> 4;
+    if (total_read == 0) {
+      *p_cable_num = cable_num;
+    } else if (cable_num != *p_cable_num) {
+      break;
+    }
+
+    uint8_t const count = (uint8_t) tu_min32(stream->total - stream->index, bufsize);
+    memcpy(buf8, stream->buffer + 1 + stream->index, count);
+
+    total_read += count;
+    stream->index += count;
+    buf8 += count;
+    bufsize -= count;
+
+    // complete current event packet
+    if (stream->total == stream->index) {
+      stream->index = 0;
+      stream->total = 0;
+    }
+  }
+
+  return total_read;
+}
+
+//--------------------------------------------------------------------+
+// Write
+//--------------------------------------------------------------------+
+uint32_t tuh_midi_write_available(uint8_t idx) {
+  midih_interface_t* p_midi = get_itf(idx);
+  TU_VERIFY(p_midi, 0);
+  return tu_edpt_stream_write_available(p_midi->daddr, &p_midi->stream.tx);
+}
+
+uint32_t tuh_midi_write_flush(uint8_t idx) {
+  midih_interface_t* p_midi = get_itf(idx);
+  TU_VERIFY(p_midi, 0);
+  return tu_edpt_stream_write_xfer(p_midi->daddr, &p_midi->stream.tx);
+}
+
+bool tuh_midi_packet_write(uint8_t idx, uint8_t const packet[4]) {
+  return 1 == tuh_midi_packets_write(idx, packet, 1);
+}
+
+uint32_t tuh_midi_packets_write(uint8_t idx, uint8_t const* packets, uint32_t count) {
+  midih_interface_t* p_midi = get_itf(idx);
+  TU_VERIFY(p_midi && p_midi->stream.tx.ep_addr, 0);
+
+  // whole packets only
+  count = tu_min32(count, tu_edpt_stream_write_available(p_midi->daddr, &p_midi->stream.tx) / 4);
+  TU_VERIFY(count, 0);
+
+  uint32_t const num_written = tu_edpt_stream_write(p_midi->daddr, &p_midi->stream.tx, packets, 4 * count);
+  (void) tu_edpt_stream_write_xfer(p_midi->daddr, &p_midi->stream.tx);
+
+  return num_written / 4;
+}
+
+uint32_t tuh_midi_stream_write(uint8_t idx, uint8_t cable_num, uint8_t const* buffer, uint32_t bufsize) {
+  midih_interface_t* p_midi = get_itf(idx);
+  TU_VERIFY(p_midi && p_midi->stream.tx.ep_addr, 0);
+
+  midih_stream_t* stream = &p_midi->stream_write;
+  uint8_t const cable = (uint8_t) (cable_num << 4);
+
+  uint32_t i = 0;
+  while ((i < bufsize) && (tu_edpt_stream_write_available(p_midi->daddr, &p_midi->stream.tx) >= 4)) {
+    uint8_t const data = buffer[i];
+    i++;
+
+    if (stream->index == 0) {
+      //------------- New event packet -------------//
+      uint8_t const msg = data >> 4;
+
+      stream->index = 2;
+      stream->buffer[1] = data;
+
+      if ((stream->buffer[0] & 0x0f) == MIDI_CIN_SYSEX_START) {
+        // still in SysEx
+        if (data == MIDI_STATUS_SYSEX_END) {
+          stream->buffer[0] = cable | MIDI_CIN_SYSEX_END_1BYTE;
+          stream->total = 2;
+        } else {
+          stream->total = 4;
+        }
+      } else if ((msg >= 0x8 && msg <= 0xB) || msg == 0xE) {
+        // Channel Voice Messages
+        stream->buffer[0] = cable | msg;
+        stream->total = 4;
+      } else if (msg == 0xC || msg == 0xD) {
+        // Channel Voice Messages, two-byte variants (Program Change and Channel Pressure)
+        stream->buffer[0] = cable | msg;
+        stream->total = 3;
+      } else if (msg == 0xf) {
+        // System message
+        if (data == MIDI_STATUS_SYSEX_START) {
+          stream->buffer[0] = MIDI_CIN_SYSEX_START;
+          stream->total = 4;
+        } else if (data == MIDI_STATUS_SYSCOM_TIME_CODE_QUARTER_FRAME || data == MIDI_STATUS_SYSCOM_SONG_SELECT) {
+          stream->buffer[0] = MIDI_CIN_SYSCOM_2BYTE;
+          stream->total = 3;
+        } else if (data == MIDI_STATUS_SYSCOM_SONG_POSITION_POINTER) {
+          stream->buffer[0] = MIDI_CIN_SYSCOM_3BYTE;
+          stream->total = 4;
+        } else {
+          stream->buffer[0] = MIDI_CIN_SYSEX_END_1BYTE;
+          stream->total = 2;
+        }
+        stream->buffer[0] |= cable;
+      } else {
+        // Pack individual bytes if we don't support packing them into words.
+        stream->buffer[0] = cable | MIDI_CIN_1BYTE_DATA;
+        stream->total = 2;
+      }
+    } else {
+      //------------- On-going (buffering) packet -------------//
+      TU_ASSERT(stream->index < 4, i);
+      stream->buffer[stream->index] = data;
+      stream->index++;
+
+      // See if this byte ends a SysEx.
+      if ((stream->buffer[0] & 0x0f) == MIDI_CIN_SYSEX_START && data == MIDI_STATUS_SYSEX_END) {
+        stream->buffer[0] = (uint8_t) (cable | (MIDI_CIN_SYSEX_START + (stream->index - 1)));
+        stream->total = stream->index;
+      }
+    }
+
+    // Send out packet
+    if (stream->index == stream->total) {
+      // zeroes unused bytes
+      for (uint8_t b = stream->total; b < 4; b++) {
+        stream->buffer[b] = 0;
+      }
+
+      uint32_t const count = tu_edpt_stream_write(p_midi->daddr, &p_midi->stream.tx, stream->buffer, 4);
+
+      // complete current event packet, reset stream
+      stream->index = stream->total = 0;
+
+      // FIFO overflown, since we already check fifo remaining. It is probably race condition
+      TU_ASSERT(count == 4, i);
+    }
+  }
+
+  (void) tu_edpt_stream_write_xfer(p_midi->daddr, &p_midi->stream.tx);
+
+  return i;
+}
+
+//--------------------------------------------------------------------+
+// USBH API
+//--------------------------------------------------------------------+
+bool midih_init(void) {
+  TU_LOG_DRV("sizeof(midih_interface_t) = %u\r\n", sizeof(midih_interface_t));
+  tu_memclr(_midih_itf, sizeof(_midih_itf));
+
+  for (uint8_t i = 0; i < CFG_TUH_MIDI; i++) {
+    midih_interface_t* p_midi = &_midih_itf[i];
+    midih_epbuf_t* epbuf = &_midih_epbuf[i];
+    tu_edpt_stream_init(&p_midi->stream.tx, true, true, false,
+                        p_midi->stream.tx_ff_buf, CFG_TUH_MIDI_TX_BUFSIZE,
+                        epbuf->tx, CFG_TUH_MIDI_EP_BUFSIZE);
+
+    tu_edpt_stream_init(&p_midi->stream.rx, true, false, false,
+                        p_midi->stream.rx_ff_buf, CFG_TUH_MIDI_RX_BUFSIZE,
+                        epbuf->rx, CFG_TUH_MIDI_EP_BUFSIZE);
+  }
+
+  return true;
+}
+
+bool midih_deinit(void) {
+  for (uint8_t i = 0; i < CFG_TUH_MIDI; i++) {
+    midih_interface_t* p_midi = &_midih_itf[i];
+    tu_edpt_stream_deinit(&p_midi->stream.tx);
+    tu_edpt_stream_deinit(&p_midi->stream.rx);
+  }
+  return true;
+}
+
+void midih_close(uint8_t daddr) {
+  for (uint8_t idx = 0; idx < CFG_TUH_MIDI; idx++) {
+    midih_interface_t* p_midi = &_midih_itf[idx];
+    if (p_midi->daddr == daddr) {
+      TU_LOG_DRV("  MIDIh close addr = %u index = %u\r\n", daddr, idx);
+
+      if (p_midi->mounted && tuh_midi_umount_cb) {
+        tuh_midi_umount_cb(idx);
+      }
+
+      p_midi->daddr = 0;
+      p_midi->itf_num = 0;
+      p_midi->mounted = false;
+      p_midi->rx_cable_count = p_midi->tx_cable_count = 0;
+      tu_memclr(&p_midi->stream_write, sizeof(midih_stream_t));
+      tu_memclr(&p_midi->stream_read, sizeof(midih_stream_t));
+      tu_edpt_stream_close(&p_midi->stream.tx);
+      tu_edpt_stream_close(&p_midi->stream.rx);
+    }
+  }
+}
+
+bool midih_xfer_cb(uint8_t daddr, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes) {
+  uint8_t const idx = get_idx_by_ep_addr(daddr, ep_addr);
+  midih_interface_t* p_midi = get_itf(idx);
+  TU_VERIFY(p_midi);
+
+  if (ep_addr == p_midi->stream.rx.ep_addr) {
+    if (result == XFER_RESULT_SUCCESS) {
+      tu_edpt_stream_read_xfer_complete(&p_midi->stream.rx, xferred_bytes);
+    }
+
+    // re-arm first so that device can send more while application processes received packets
+    tu_edpt_stream_read_xfer(daddr, &p_midi->stream.rx);
+
+    if (result == XFER_RESULT_SUCCESS && tuh_midi_rx_cb) {
+      tuh_midi_rx_cb(idx, xferred_bytes);
+    }
+  } else {
+    if (tuh_midi_tx_cb) {
+      tuh_midi_tx_cb(idx, xferred_bytes);
+    }
+
+    if (0 == tu_edpt_stream_write_xfer(daddr, &p_midi->stream.tx)) {
+      // If there is no data left, a ZLP should be sent if xferred_bytes is multiple of EP Packet size and not zero
+      tu_edpt_stream_write_zlp_if_needed(daddr, &p_midi->stream.tx, xferred_bytes);
+    }
+  }
+
+  return true;
+}
+
+//--------------------------------------------------------------------+
+// Enumeration
+//--------------------------------------------------------------------+
+bool midih_open(uint8_t rhport, uint8_t daddr, tusb_desc_interface_t const* desc_itf, uint16_t max_len) {
+  (void) rhport;
+
+  // 1st Interface is Audio Control v1
+  TU_VERIFY(TUSB_CLASS_AUDIO               == desc_itf->bInterfaceClass    &&
+            AUDIO_SUBCLASS_CONTROL         == desc_itf->bInterfaceSubClass &&
+            AUDIO_FUNC_PROTOCOL_CODE_UNDEF == desc_itf->bInterfaceProtocol);
+
+  uint8_t const* p_desc = (uint8_t const*) desc_itf;
+  uint8_t const* desc_end = p_desc + max_len;
+
+  // Skip Audio Control interface and its class specific descriptors
+  p_desc = tu_desc_next(p_desc);
+  while (p_desc < desc_end && TUSB_DESC_CS_INTERFACE == tu_desc_type(p_desc)) {
+    p_desc = tu_desc_next(p_desc);
+  }
+
+  // 2nd Interface is MIDI Streaming
+  TU_VERIFY(p_desc < desc_end && TUSB_DESC_INTERFACE == tu_desc_type(p_desc));
+  tusb_desc_interface_t const* desc_ms = (tusb_desc_interface_t const*) p_desc;
+  TU_VERIFY(TUSB_CLASS_AUDIO              == desc_ms->bInterfaceClass &&
+            AUDIO_SUBCLASS_MIDI_STREAMING == desc_ms->bInterfaceSubClass);
+
+  midih_interface_t* p_midi = NULL;
+  for (uint8_t i = 0; i < CFG_TUH_MIDI; i++) {
+    if (_midih_itf[i].daddr == 0) {
+      p_midi = &_midih_itf[i];
+      break;
+    }
+  }
+  TU_VERIFY(p_midi);
+
+  TU_LOG_DRV("[%u] MIDI opening Interface %u\r\n", daddr, desc_ms->bInterfaceNumber);
+  p_midi->daddr = daddr;
+  p_midi->itf_num = desc_ms->bInterfaceNumber;
+
+  // Endpoints of alternate setting 0 (MIDI 1.0), each followed by MS endpoint descriptor with number of embedded jacks
+  uint8_t const* p_ep = NULL;
+  p_desc = tu_desc_next(p_desc);
+  while (p_desc < desc_end) {
+    uint8_t const desc_type = tu_desc_type(p_desc);
+    if (TUSB_DESC_INTERFACE == desc_type || TUSB_DESC_INTERFACE_ASSOCIATION == desc_type) {
+      break; // other alternate setting (e.g MIDI 2.0) or interface
+    }
+
+    if (TUSB_DESC_ENDPOINT == desc_type) {
+      tusb_desc_endpoint_t const* desc_ep = (tusb_desc_endpoint_t const*) p_desc;
+      TU_ASSERT(TUSB_XFER_BULK == desc_ep->bmAttributes.xfer || TUSB_XFER_INTERRUPT == desc_ep->bmAttributes.xfer);
+      TU_ASSERT(tuh_edpt_open(daddr, desc_ep));
+
+      if (tu_edpt_dir(desc_ep->bEndpointAddress) == TUSB_DIR_IN) {
+        tu_edpt_stream_open(&p_midi->stream.rx, desc_ep);
+      } else {
+        tu_edpt_stream_open(&p_midi->stream.tx, desc_ep);
+      }
+      p_ep = p_desc;
+    } else if (TUSB_DESC_CS_ENDPOINT == desc_type && p_ep && p_desc[2] == MIDI_CS_ENDPOINT_GENERAL) {
+      // bNumEmbMIDIJack
+      uint8_t const num_jack = p_desc[3];
+      if (tu_edpt_dir(((tusb_desc_endpoint_t const*) p_ep)->bEndpointAddress) == TUSB_DIR_IN) {
+        p_midi->rx_cable_count = num_jack;
+      } else {
+        p_midi->tx_cable_count = num_jack;
+      }
+    }
+
+    p_desc = tu_desc_next(p_desc);
+  }
+
+  TU_ASSERT(p_midi->stream.rx.ep_addr || p_midi->stream.tx.ep_addr);
+  return true;
+}
+
+bool midih_set_config(uint8_t daddr, uint8_t itf_num) {
+  // itf_num is Audio Control interface, followed by MIDI Streaming interface
+  uint8_t const idx = tuh_midi_itf_get_index(daddr, (uint8_t) (itf_num + 1));
+  midih_interface_t* p_midi = get_itf(idx);
+  TU_ASSERT(p_midi);
+
+  TU_LOG_DRV("MIDIh Set Configure complete\r\n");
+  p_midi->mounted = true;
+  if (tuh_midi_mount_cb) {
+    tuh_midi_mount_cb(idx, p_midi->rx_cable_count, p_midi->tx_cable_count);
+  }
+
+  // Prepare for incoming data
+  if (p_midi->stream.rx.ep_addr) {
+    tu_edpt_stream_read_xfer(daddr, &p_midi->stream.rx);
+  }
+
+  // notify usbh that driver enumeration is complete, skip MIDI Streaming interface
+  usbh_driver_set_config_complete(daddr, p_midi->itf_num);
+
+  return true;
+}
+
+#endif
@@ -0,0 +1,137 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#ifndef _TUSB_MIDI_HOST_H_
+#define _TUSB_MIDI_HOST_H_
+
+#include "class/audio/audio.h"
+#include "midi.h"
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+//--------------------------------------------------------------------+
+// Class Driver Configuration
+//--------------------------------------------------------------------+
+
+// RX FIFO size, should be multiple of 4 (event packet size)
+#ifndef CFG_TUH_MIDI_RX_BUFSIZE
+#define CFG_TUH_MIDI_RX_BUFSIZE USBH_EPSIZE_BULK_MAX
+#endif
+
+// TX FIFO size, should be multiple of 4 (event packet size)
+#ifndef CFG_TUH_MIDI_TX_BUFSIZE
+#define CFG_TUH_MIDI_TX_BUFSIZE USBH_EPSIZE_BULK_MAX
+#endif
+
+// Endpoint buffer size
+#ifndef CFG_TUH_MIDI_EP_BUFSIZE
+#define CFG_TUH_MIDI_EP_BUFSIZE USBH_EPSIZE_BULK_MAX
+#endif
+
+//--------------------------------------------------------------------+
+// Application API
+//--------------------------------------------------------------------+
+
+// Get Interface index from device address + MIDI Streaming interface number
+// return TUSB_INDEX_INVALID_8 (0xFF) if not found
+uint8_t tuh_midi_itf_get_index(uint8_t daddr, uint8_t itf_num);
+
+// Get MIDI Streaming interface information
+// return true if index is correct and interface is currently mounted
+bool tuh_midi_itf_get_info(uint8_t idx, tuh_itf_info_t* info);
+
+// Check if MIDI interface is mounted
+bool tuh_midi_mounted(uint8_t idx);
+
+// Number of embedded jacks (cables) of IN (device to host) and OUT (host to device) endpoint
+uint8_t tuh_midi_get_rx_cable_count(uint8_t idx);
+uint8_t tuh_midi_get_tx_cable_count(uint8_t idx);
+
+//------------- Read -------------//
+
+// Get the number of bytes of event packets available for reading
+uint32_t tuh_midi_read_available(uint8_t idx);
+
+// Read event packet (4 bytes), cable number is upper nibble of 1st byte
+bool tuh_midi_packet_read(uint8_t idx, uint8_t packet[4]);
+
+// Read up to count event packets (4 bytes each), return number of packets read
+uint32_t tuh_midi_packets_read(uint8_t idx, uint8_t* packets, uint32_t count);
+
+// Read MIDI byte stream of a single cable: stop at the first packet of another cable, which is returned by the next
+// call. p_cable_num is set to the cable of returned data. Return number of bytes read
+uint32_t tuh_midi_stream_read(uint8_t idx, uint8_t* p_cable_num, void* buffer, uint32_t bufsize);
+
+//------------- Write -------------//
+
+// Get the number of bytes available for writing
+uint32_t tuh_midi_write_available(uint8_t idx);
+
+// Write event packet (4 bytes) and start transfer if possible
+bool tuh_midi_packet_write(uint8_t idx, uint8_t const packet[4]);
+
+// Write up to count event packets (4 bytes each) and start transfer if possible, return number of packets written
+uint32_t tuh_midi_packets_write(uint8_t idx, uint8_t const* packets, uint32_t count);
+
+// Write MIDI byte stream to cable, converted to event packets. Return number of bytes written
+uint32_t tuh_midi_stream_write(uint8_t idx, uint8_t cable_num, uint8_t const* buffer, uint32_t bufsize);
+
+// Start transfer of pending data if endpoint is not busy, return number of bytes queued
+uint32_t tuh_midi_write_flush(uint8_t idx);
+
+//--------------------------------------------------------------------+
+// Callbacks (Weak is optional)
+//--------------------------------------------------------------------+
+
+// Invoked when MIDI interface is mounted
+TU_ATTR_WEAK void tuh_midi_mount_cb(uint8_t idx, uint8_t rx_cable_count, uint8_t tx_cable_count);
+
+// Invoked when MIDI interface is unmounted
+TU_ATTR_WEAK void tuh_midi_umount_cb(uint8_t idx);
+
+// Invoked when received new data. IN endpoint is already re-armed so that device can send more meanwhile
+TU_ATTR_WEAK void tuh_midi_rx_cb(uint8_t idx, uint32_t xferred_bytes);
+
+// Invoked when a TX transfer is complete, application can write more data
+TU_ATTR_WEAK void tuh_midi_tx_cb(uint8_t idx, uint32_t xferred_bytes);
+
+//--------------------------------------------------------------------+
+// Internal Class Driver API
+//--------------------------------------------------------------------+
+bool midih_init       (void);
+bool midih_deinit     (void);
+bool midih_open       (uint8_t rhport, uint8_t daddr, tusb_desc_interface_t const *desc_itf, uint16_t max_len);
+bool midih_set_config (uint8_t daddr, uint8_t itf_num);
+bool midih_xfer_cb    (uint8_t daddr, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes);
+void midih_close      (uint8_t daddr);
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif /* _TUSB_MIDI_HOST_H_ */
@@ -58,7 +58,8 @@ typedef enum
 {
   MSC_PROTOCOL_CBI              = 0 ,  ///< Control/Bulk/Interrupt protocol (with command completion interrupt)
   MSC_PROTOCOL_CBI_NO_INTERRUPT = 1 ,  ///< Control/Bulk/Interrupt protocol (without command completion interrupt)
-  MSC_PROTOCOL_BOT              = 0x50 ///< Bulk-Only Transport
+  MSC_PROTOCOL_BOT              = 0x50,///< Bulk-Only Transport
+  MSC_PROTOCOL_UAS              = 0x62 ///< USB Attached SCSI
 }msc_protocol_type_t;
 
 /// MassStorage Class-Specific Control Request
@@ -103,6 +104,116 @@ typedef struct TU_ATTR_PACKED
 
 TU_VERIFY_STATIC(sizeof(msc_csw_t) == 13, "size is not correct");
 
+//--------------------------------------------------------------------+
+// USB Attached SCSI (UAS) Constant
+//--------------------------------------------------------------------+
+enum {
+  UAS_DESC_PIPE_USAGE = 0x24 ///< Pipe Usage descriptor following each endpoint descriptor
+};
+
+/// UAS Pipe ID
+typedef enum {
+  UAS_PIPE_COMMAND  = 1,
+  UAS_PIPE_STATUS   = 2,
+  UAS_PIPE_DATA_IN  = 3,
+  UAS_PIPE_DATA_OUT = 4
+} uas_pipe_id_t;
+
+/// UAS Information Unit ID
+typedef enum {
+  UAS_IU_COMMAND     = 0x01,
+  UAS_IU_SENSE       = 0x03,
+  UAS_IU_RESPONSE    = 0x04,
+  UAS_IU_TASK_MGMT   = 0x05,
+  UAS_IU_READ_READY  = 0x06,
+  UAS_IU_WRITE_READY = 0x07
+} uas_iu_id_t;
+
+/// Task Management Function
+typedef enum {
+  UAS_TMF_ABORT_TASK         = 0x01,
+  UAS_TMF_ABORT_TASK_SET     = 0x02,
+  UAS_TMF_CLEAR_TASK_SET     = 0x04,
+  UAS_TMF_LOGICAL_UNIT_RESET = 0x08,
+  UAS_TMF_IT_NEXUS_RESET     = 0x10,
+  UAS_TMF_CLEAR_ACA          = 0x40,
+  UAS_TMF_QUERY_TASK         = 0x80,
+  UAS_TMF_QUERY_TASK_SET     = 0x81,
+  UAS_TMF_QUERY_ASYNC_EVENT  = 0x82
+} uas_tmf_t;
+
+/// Response IU code
+typedef enum {
+  UAS_RC_TMF_COMPLETE        = 0x00,
+  UAS_RC_INVALID_IU          = 0x02,
+  UAS_RC_TMF_NOT_SUPPORTED   = 0x04,
+  UAS_RC_TMF_FAILED          = 0x05,
+  UAS_RC_TMF_SUCCEEDED       = 0x08,
+  UAS_RC_INCORRECT_LUN       = 0x09,
+  UAS_RC_OVERLAPPED_TAG      = 0x0A
+} uas_response_code_t;
+
+/// Command IU, without additional CDB bytes. Fields are Big Endian
+typedef struct TU_ATTR_PACKED {
+  uint8_t  iu_id;
+  uint8_t  reserved1;
+  uint16_t tag;
+  uint8_t  prio_attr;    ///< bit 6..3 task priority, bit 2..0 task attribute
+  uint8_t  reserved5;
+  uint8_t  add_cdb_len;  ///< bit 7..2 additional CDB length in dwords
+  uint8_t  reserved7;
+  uint8_t  lun[8];
+  uint8_t  cdb[16];
+} uas_cmd_iu_t;
+
+TU_VERIFY_STATIC(sizeof(uas_cmd_iu_t) == 32, "size is not correct");
+
+/// Task Management IU
+typedef struct TU_ATTR_PACKED {
+  uint8_t  iu_id;
+  uint8_t  reserved1;
+  uint16_t tag;
+  uint8_t  function;     ///< \ref uas_tmf_t
+  uint8_t  reserved5;
+  uint16_t task_tag;     ///< tag of managed task
+  uint8_t  lun[8];
+} uas_task_mgmt_iu_t;
+
+TU_VERIFY_STATIC(sizeof(uas_task_mgmt_iu_t) == 16, "size is not correct");
+
+/// Sense IU, followed by len bytes of sense data
+typedef struct TU_ATTR_PACKED {
+  uint8_t  iu_id;
+  uint8_t  reserved1;
+  uint16_t tag;
+  uint16_t status_qualifier;
+  uint8_t  status;       ///< SCSI status
+  uint8_t  reserved7[7];
+  uint16_t len;
+} uas_sense_iu_t;
+
+TU_VERIFY_STATIC(sizeof(uas_sense_iu_t) == 16, "size is not correct");
+
+/// Response IU
+typedef struct TU_ATTR_PACKED {
+  uint8_t  iu_id;
+  uint8_t  reserved1;
+  uint16_t tag;
+  uint8_t  add_info[3];
+  uint8_t  code;         ///< \ref uas_response_code_t
+} uas_response_iu_t;
+
+TU_VERIFY_STATIC(sizeof(uas_response_iu_t) == 8, "size is not correct");
+
+/// Read Ready and Write Ready IU
+typedef struct TU_ATTR_PACKED {
+  uint8_t  iu_id;
+  uint8_t  reserved1;
+  uint16_t tag;
+} uas_ready_iu_t;
+
+TU_VERIFY_STATIC(sizeof(uas_ready_iu_t) == 4, "size is not correct");
+
 //--------------------------------------------------------------------+
 // SCSI Constant
 //--------------------------------------------------------------------+
@@ -121,8 +232,27 @@ typedef enum
   SCSI_CMD_READ_FORMAT_CAPACITY         = 0x23, ///< The command allows the Host to request a list of the possible format capacities for an installed writable media. This command also has the capability to report the writable capacity for a media when it is installed
   SCSI_CMD_READ_10                      = 0x28, ///< The READ (10) command requests that the device server read the specified logical block(s) and transfer them to the data-in buffer.
   SCSI_CMD_WRITE_10                     = 0x2A, ///< The WRITE (10) command requests that the device server transfer the specified logical block(s) from the data-out buffer and write them.
+  SCSI_CMD_SYNCHRONIZE_CACHE_10         = 0x35, ///< Write cached data of the specified logical blocks (all if zero) to the medium
+  SCSI_CMD_WRITE_SAME_10                = 0x41, ///< Write one block of Data-Out to a range of logical blocks, optionally unmapping them
+  SCSI_CMD_UNMAP                        = 0x42, ///< Tell the device server that data of the listed logical blocks is no longer needed
+  SCSI_CMD_READ_16                      = 0x88, ///< READ (16) with 64-bit LBA and 32-bit transfer length
+  SCSI_CMD_WRITE_16                     = 0x8A, ///< WRITE (16) with 64-bit LBA and 32-bit transfer length
+  SCSI_CMD_WRITE_SAME_16                = 0x93, ///< WRITE SAME (16) with 64-bit LBA and 32-bit block count
+  SCSI_CMD_SERVICE_ACTION_IN_16         = 0x9E, ///< SERVICE ACTION IN (16), carries READ CAPACITY (16)
 }scsi_cmd_type_t;
 
+/// Service action of \ref SCSI_CMD_SERVICE_ACTION_IN_16
+enum {
+  SCSI_SERVICE_ACTION_READ_CAPACITY_16 = 0x10,
+};
+
+/// Vital Product Data page returned by \ref SCSI_CMD_INQUIRY with EVPD bit set
+enum {
+  SCSI_VPD_SUPPORTED_PAGES            = 0x00,
+  SCSI_VPD_BLOCK_LIMITS               = 0xB0,
+  SCSI_VPD_LOGICAL_BLOCK_PROVISIONING = 0xB2,
+};
+
 /// SCSI Sense Key
 typedef enum
 {
@@ -141,6 +271,14 @@ typedef enum
   SCSI_SENSE_MISCOMPARE      = 0x0e  ///< Indicates that the source data did not match the data read from the medium.
 }scsi_sense_key_type_t;
 
+/// SCSI Status, reported in UAS Sense IU
+typedef enum
+{
+  SCSI_STATUS_GOOD            = 0x00,
+  SCSI_STATUS_CHECK_CONDITION = 0x02,
+  SCSI_STATUS_TASK_SET_FULL   = 0x28
+}scsi_status_type_t;
+
 //--------------------------------------------------------------------+
 // SCSI Primary Command (SPC-4)
 //--------------------------------------------------------------------+
@@ -375,6 +513,152 @@ typedef struct TU_ATTR_PACKED
 TU_VERIFY_STATIC(sizeof(scsi_read10_t) == 10, "size is not correct");
 TU_VERIFY_STATIC(sizeof(scsi_write10_t) == 10, "size is not correct");
 
+/// SCSI Read Capacity 16 Command (Service Action In)
+typedef struct TU_ATTR_PACKED
+{
+  uint8_t  cmd_code       ; ///< SCSI OpCode for \ref SCSI_CMD_SERVICE_ACTION_IN_16
+  uint8_t  service_action ; ///< \ref SCSI_SERVICE_ACTION_READ_CAPACITY_16 in bits 4:0
+  uint64_t lba            ; ///< obsolete
+  uint32_t alloc_length   ; ///< Maximum bytes of response
+  uint8_t  partial_medium_indicator ;
+  uint8_t  control        ;
+} scsi_read_capacity16_t;
+
+TU_VERIFY_STATIC(sizeof(scsi_read_capacity16_t) == 16, "size is not correct");
+
+/// SCSI Read Capacity 16 Response Data
+typedef struct TU_ATTR_PACKED
+{
+  uint64_t last_lba       ; ///< The last Logical Block Address of the device
+  uint32_t block_size     ; ///< Block size in bytes
+  uint8_t  protection     ;
+  uint8_t  lbppb_exponent ; ///< logical blocks per physical block exponent
+  uint16_t lowest_aligned_lba ;
+  uint8_t  reserved[16]   ;
+} scsi_read_capacity16_resp_t;
+
+TU_VERIFY_STATIC(sizeof(scsi_read_capacity16_resp_t) == 32, "size is not correct");
+
+/// SCSI Read 16 Command
+typedef struct TU_ATTR_PACKED
+{
+  uint8_t  cmd_code    ; ///< SCSI OpCode
+  uint8_t  flags       ;
+  uint64_t lba         ; ///< The first Logical Block Address (LBA) accessed by this command
+  uint32_t block_count ; ///< Number of Blocks used by this command
+  uint8_t  group_num   ;
+  uint8_t  control     ;
+} scsi_read16_t, scsi_write16_t;
+
+TU_VERIFY_STATIC(sizeof(scsi_read16_t) == 16, "size is not correct");
+TU_VERIFY_STATIC(sizeof(scsi_write16_t) == 16, "size is not correct");
+
+/// SCSI Write Same 10 Command, Data-Out is one block
+typedef struct TU_ATTR_PACKED
+{
+  uint8_t  cmd_code    ; ///< SCSI OpCode for \ref SCSI_CMD_WRITE_SAME_10
+  uint8_t  flags       ; ///< bit 3: UNMAP, blocks may be unmapped instead of written
+  uint32_t lba         ; ///< The first Logical Block Address (LBA) accessed by this command
+  uint8_t  group_num   ;
+  uint16_t block_count ; ///< Number of Blocks, zero means up to the last block
+  uint8_t  control     ;
+} scsi_write_same10_t;
+
+TU_VERIFY_STATIC(sizeof(scsi_write_same10_t) == 10, "size is not correct");
+
+/// SCSI Write Same 16 Command, same layout as \ref scsi_write16_t
+typedef struct TU_ATTR_PACKED
+{
+  uint8_t  cmd_code    ; ///< SCSI OpCode for \ref SCSI_CMD_WRITE_SAME_16
+  uint8_t  flags       ; ///< bit 3: UNMAP, bit 0: NDOB no Data-Out (zeros)
+  uint64_t lba         ; ///< The first Logical Block Address (LBA) accessed by this command
+  uint32_t block_count ; ///< Number of Blocks, zero means up to the last block
+  uint8_t  group_num   ;
+  uint8_t  control     ;
+} scsi_write_same16_t;
+
+TU_VERIFY_STATIC(sizeof(scsi_write_same16_t) == 16, "size is not correct");
+
+enum {
+  SCSI_WRITE_SAME_FLAG_UNMAP = 0x08,
+};
+
+/// SCSI Unmap Command
+typedef struct TU_ATTR_PACKED
+{
+  uint8_t  cmd_code          ; ///< SCSI OpCode for \ref SCSI_CMD_UNMAP
+  uint8_t  anchor            ;
+  uint32_t reserved          ;
+  uint8_t  group_num         ;
+  uint16_t param_list_length ; ///< Bytes of parameter list in Data-Out
+  uint8_t  control           ;
+} scsi_unmap_t;
+
+TU_VERIFY_STATIC(sizeof(scsi_unmap_t) == 10, "size is not correct");
+
+/// SCSI Unmap parameter list header, followed by block descriptors
+typedef struct TU_ATTR_PACKED
+{
+  uint16_t data_length            ; ///< Bytes following this field
+  uint16_t block_desc_data_length ; ///< Bytes of block descriptors
+  uint32_t reserved               ;
+} scsi_unmap_param_header_t;
+
+TU_VERIFY_STATIC(sizeof(scsi_unmap_param_header_t) == 8, "size is not correct");
+
+/// SCSI Unmap block descriptor
+typedef struct TU_ATTR_PACKED
+{
+  uint64_t lba         ; ///< The first Logical Block Address (LBA) to unmap
+  uint32_t block_count ; ///< Number of Blocks to unmap
+  uint32_t reserved    ;
+} scsi_unmap_block_desc_t;
+
+TU_VERIFY_STATIC(sizeof(scsi_unmap_block_desc_t) == 16, "size is not correct");
+
+/// SCSI Block Limits VPD page
+typedef struct TU_ATTR_PACKED
+{
+  uint8_t  peripheral_device_type ;
+  uint8_t  page_code              ; ///< \ref SCSI_VPD_BLOCK_LIMITS
+  uint16_t page_length            ;
+  uint8_t  wsnz                   ; ///< bit 0: WRITE SAME with zero block count is not supported
+  uint8_t  max_compare_write_length ;
+  uint16_t opt_transfer_length_granularity ;
+  uint32_t max_transfer_length    ;
+  uint32_t opt_transfer_length    ;
+  uint32_t max_prefetch_length    ;
+  uint32_t max_unmap_lba_count    ; ///< Maximum blocks of one UNMAP command
+  uint32_t max_unmap_block_desc_count ; ///< Maximum block descriptors of one UNMAP command
+  uint32_t opt_unmap_granularity  ;
+  uint32_t unmap_granularity_alignment ; ///< bit 31: UGAVALID
+  uint64_t max_write_same_length  ;
+  uint8_t  reserved[20]           ;
+} scsi_vpd_block_limits_t;
+
+TU_VERIFY_STATIC(sizeof(scsi_vpd_block_limits_t) == 64, "size is not correct");
+
+/// SCSI Logical Block Provisioning VPD page
+typedef struct TU_ATTR_PACKED
+{
+  uint8_t  peripheral_device_type ;
+  uint8_t  page_code              ; ///< \ref SCSI_VPD_LOGICAL_BLOCK_PROVISIONING
+  uint16_t page_length            ;
+  uint8_t  threshold_exponent     ;
+
+  uint8_t  dp      : 1; ///< provisioning group descriptor is present
+  uint8_t  anc_sup : 1; ///< anchored state is supported
+  uint8_t  lbprz   : 3; ///< unmapped blocks read as zeros
+  uint8_t  lbpws10 : 1; ///< WRITE SAME (10) with UNMAP bit is supported
+  uint8_t  lbpws   : 1; ///< WRITE SAME (16) with UNMAP bit is supported
+  uint8_t  lbpu    : 1; ///< UNMAP is supported
+
+  uint8_t  provisioning_type      ; ///< bit 2:0, 1 resource provisioned, 2 thin provisioned
+  uint8_t  reserved               ;
+} scsi_vpd_logical_block_provisioning_t;
+
+TU_VERIFY_STATIC(sizeof(scsi_vpd_logical_block_provisioning_t) == 8, "size is not correct");
+
 #ifdef __cplusplus
  }
 #endif
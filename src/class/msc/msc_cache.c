@@ -0,0 +1,296 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#include "tusb_option.h"
+#include "msc_device.h" // for CFG_TUD_MSC_CACHE_LINES default
+
+#if (CFG_TUD_ENABLED && CFG_TUD_MSC && CFG_TUD_MSC_CACHE_LINES)
+
+//--------------------------------------------------------------------+
+// MACRO CONSTANT TYPEDEF
+//--------------------------------------------------------------------+
+#define BLOCK_SIZE    CFG_TUD_MSC_CACHE_BLOCK_SIZE
+#define LINE_BLOCKS   CFG_TUD_MSC_CACHE_LINE_BLOCKS
+#define LINE_FULL     ((uint32_t) (((uint64_t) 1 << LINE_BLOCKS) - 1))
+
+typedef struct {
+  uint64_t lba;   // first block, aligned to LINE_BLOCKS
+  uint32_t valid; // blocks holding media data, line is free if zero
+  uint32_t dirty; // blocks not yet written to media
+  uint32_t stamp; // last use for LRU, 0 if only accessed sequentially: reused first to not evict hot blocks
+  uint8_t  lun;
+} cache_line_t;
+
+static cache_line_t _cache_line[CFG_TUD_MSC_CACHE_LINES];
+TU_ATTR_ALIGNED(4) static uint8_t _cache_data[CFG_TUD_MSC_CACHE_LINES][LINE_BLOCKS * BLOCK_SIZE];
+static uint32_t _cache_clock;
+
+// sequential read detection
+static uint8_t  _seq_lun;
+static uint64_t _seq_lba = UINT64_MAX;
+
+//--------------------------------------------------------------------+
+// Line
+//--------------------------------------------------------------------+
+static cache_line_t* line_find(uint8_t lun, uint64_t lba) {
+  for (uint8_t i = 0; i < CFG_TUD_MSC_CACHE_LINES; i++) {
+    cache_line_t* line = &_cache_line[i];
+    if (line->valid && line->lun == lun && line->lba == lba) {
+      return line;
+    }
+  }
+  return NULL;
+}
+
+TU_ATTR_ALWAYS_INLINE static inline uint8_t* line_data(cache_line_t const* line, uint32_t idx) {
+  return _cache_data[line - _cache_line] + idx * BLOCK_SIZE;
+}
+
+// write back runs of dirty blocks, one callback per run. Return 1 when done, 0 if busy or negative for error
+static int32_t line_flush(cache_line_t* line) {
+  while (line->dirty) {
+    uint32_t first = 0;
+    while (!tu_bit_test(line->dirty, (uint8_t) first)) {
+      first++;
+    }
+    uint32_t count = 1;
+    while (first + count < LINE_BLOCKS && tu_bit_test(line->dirty, (uint8_t) (first + count))) {
+      count++;
+    }
+
+    uint32_t done = 0;
+    while (done < count * BLOCK_SIZE) {
+      int32_t const result = mscd_media_write_cb(line->lun, line->lba + first + done / BLOCK_SIZE, done % BLOCK_SIZE,
+                                                 line_data(line, first) + done, count * BLOCK_SIZE - done);
+      if (result <= 0) {
+        if (result < 0) {
+          line->dirty = 0; // data is lost, do not retry forever
+          line->valid = 0;
+        }
+        return result == TUD_MSC_RET_ASYNC ? TUD_MSC_RET_ERROR : result;
+      }
+      done += tu_min32((uint32_t) result, count * BLOCK_SIZE - done);
+
+      // clear written blocks so that busy media resumes with the rest
+      for (uint32_t i = first; i < first + done / BLOCK_SIZE; i++) {
+        line->dirty &= (uint32_t) ~TU_BIT(i);
+      }
+    }
+  }
+  return 1;
+}
+
+// least recently used line, written back if dirty. NULL with result if it could not be written back
+static cache_line_t* line_alloc(uint8_t lun, uint64_t lba, bool sequential, int32_t* result) {
+  cache_line_t* line = &_cache_line[0];
+  for (uint8_t i = 0; i < CFG_TUD_MSC_CACHE_LINES && line->valid; i++) {
+    if (!_cache_line[i].valid || _cache_line[i].stamp < line->stamp) {
+      line = &_cache_line[i];
+    }
+  }
+
+  *result = line_flush(line);
+  if (*result <= 0) {
+    return NULL;
+  }
+
+  line->lun   = lun;
+  line->lba   = lba;
+  line->valid = 0;
+  line->dirty = 0;
+  line->stamp = sequential ? 0 : ++_cache_clock;
+  return line;
+}
+
+// read count blocks from idx into line. Return 1, 0 if busy or negative for error
+static int32_t line_fill(cache_line_t* line, uint32_t idx, uint32_t count) {
+  uint32_t done = 0;
+  while (done < count * BLOCK_SIZE) {
+    int32_t const result = mscd_media_read_cb(line->lun, line->lba + idx + done / BLOCK_SIZE, done % BLOCK_SIZE,
+                                              line_data(line, idx) + done, count * BLOCK_SIZE - done);
+    if (result <= 0) {
+      return result == TUD_MSC_RET_ASYNC ? TUD_MSC_RET_ERROR : result;
+    }
+    done += tu_min32((uint32_t) result, count * BLOCK_SIZE - done);
+
+    for (uint32_t i = idx; i < idx + done / BLOCK_SIZE; i++) {
+      line->valid |= (uint32_t) TU_BIT(i);
+    }
+  }
+  return 1;
+}
+
+// line holding lba, allocated if not cached yet
+static cache_line_t* line_get(uint8_t lun, uint64_t lba, bool sequential, int32_t* result) {
+  uint64_t const base = lba - (lba % LINE_BLOCKS);
+  cache_line_t* line = line_find(lun, base);
+  if (line) {
+    if (!sequential) {
+      line->stamp = ++_cache_clock;
+    }
+    return line;
+  }
+  return line_alloc(lun, base, sequential, result);
+}
+
+//--------------------------------------------------------------------+
+// Internal API
+//--------------------------------------------------------------------+
+int32_t mscd_cache_read(uint8_t lun, uint64_t lba, uint32_t offset, uint8_t* buffer, uint32_t bufsize) {
+  bool const sequential = (lun == _seq_lun && lba == _seq_lba);
+  int32_t total = 0;
+
+  while (bufsize) {
+    int32_t result = 1;
+    cache_line_t* line = line_get(lun, lba, sequential, &result);
+    uint32_t const idx = (uint32_t) (lba % LINE_BLOCKS);
+
+    if (line && !tu_bit_test(line->valid, (uint8_t) idx)) {
+      // fill requested blocks, read ahead rest of line on sequential access. Stop at cached (maybe dirty) block
+      uint32_t const want = sequential ? LINE_BLOCKS : idx + (offset + bufsize + BLOCK_SIZE - 1) / BLOCK_SIZE;
+      uint32_t count = 1;
+      while (idx + count < tu_min32(want, LINE_BLOCKS) && !tu_bit_test(line->valid, (uint8_t) (idx + count))) {
+        count++;
+      }
+      result = line_fill(line, idx, count);
+      if (!tu_bit_test(line->valid, (uint8_t) idx)) {
+        line = NULL;
+      }
+    }
+
+    if (!line) {
+      return total ? total : result;
+    }
+
+    uint32_t const n = tu_min32(BLOCK_SIZE - offset, bufsize);
+    memcpy(buffer, line_data(line, idx) + offset, n);
+    buffer  += n;
+    bufsize -= n;
+    total   += (int32_t) n;
+    offset  += n;
+    if (offset == BLOCK_SIZE) {
+      offset = 0;
+      lba++;
+    }
+  }
+
+  _seq_lun = lun;
+  _seq_lba = lba;
+  return total;
+}
+
+int32_t mscd_cache_write(uint8_t lun, uint64_t lba, uint32_t offset, uint8_t const* buffer, uint32_t bufsize) {
+  int32_t total = 0;
+
+  while (bufsize) {
+    int32_t result = 1;
+    cache_line_t* line = line_get(lun, lba, false, &result);
+    uint32_t const idx = (uint32_t) (lba % LINE_BLOCKS);
+    uint32_t const n = tu_min32(BLOCK_SIZE - offset, bufsize);
+
+    // partial block must be read first
+    if (line && n < BLOCK_SIZE && !tu_bit_test(line->valid, (uint8_t) idx)) {
+      result = line_fill(line, idx, 1);
+      if (result <= 0) {
+        line = NULL;
+      }
+    }
+
+    if (!line) {
+      return total ? total : result;
+    }
+
+    memcpy(line_data(line, idx) + offset, buffer, n);
+    line->valid |= (uint32_t) TU_BIT(idx);
+    line->dirty |= (uint32_t) TU_BIT(idx);
+    buffer  += n;
+    bufsize -= n;
+    total   += (int32_t) n;
+    offset  += n;
+    if (offset == BLOCK_SIZE) {
+      offset = 0;
+      lba++;
+    }
+
+    // whole erase block is written: write back at once, if busy it is done later on
+    if (line->dirty == LINE_FULL) {
+      result = line_flush(line);
+      if (result < 0) {
+        return result;
+      }
+    }
+  }
+
+  return total;
+}
+
+int32_t mscd_cache_flush(uint8_t lun) {
+  for (uint8_t i = 0; i < CFG_TUD_MSC_CACHE_LINES; i++) {
+    cache_line_t* line = &_cache_line[i];
+    if (line->valid && line->lun == lun) {
+      int32_t const result = line_flush(line);
+      if (result <= 0) {
+        return result;
+      }
+    }
+  }
+  return 1;
+}
+
+// drop cached blocks in range without writing them back, e.g media is unmapped or written directly
+void mscd_cache_discard(uint8_t lun, uint64_t lba, uint64_t block_count) {
+  for (uint8_t i = 0; i < CFG_TUD_MSC_CACHE_LINES; i++) {
+    cache_line_t* line = &_cache_line[i];
+    if (line->valid && line->lun == lun && line->lba + LINE_BLOCKS > lba && line->lba < lba + block_count) {
+      for (uint32_t idx = 0; idx < LINE_BLOCKS; idx++) {
+        if (line->lba + idx >= lba && line->lba + idx < lba + block_count) {
+          line->valid &= (uint32_t) ~TU_BIT(idx);
+          line->dirty &= (uint32_t) ~TU_BIT(idx);
+        }
+      }
+    }
+  }
+}
+
+//--------------------------------------------------------------------+
+// Application API
+//--------------------------------------------------------------------+
+bool tud_msc_cache_flush(uint8_t lun) {
+  return mscd_cache_flush(lun) > 0;
+}
+
+void tud_msc_cache_invalidate(uint8_t lun) {
+  for (uint8_t i = 0; i < CFG_TUD_MSC_CACHE_LINES; i++) {
+    if (_cache_line[i].lun == lun) {
+      tu_memclr(&_cache_line[i], sizeof(cache_line_t));
+    }
+  }
+  if (_seq_lun == lun) {
+    _seq_lba = UINT64_MAX;
+  }
+}
+
+#endif
@@ -28,12 +28,15 @@
 
 #if (CFG_TUD_ENABLED && CFG_TUD_MSC)
 
-#include "device/dcd.h"         // for faking dcd_event_xfer_complete
 #include "device/usbd.h"
 #include "device/usbd_pvt.h"
 
 #include "msc_device.h"
 
+#if CFG_TUD_UAS
+#include "uas_device.h"
+#endif
+
 // Level where CFG_TUSB_DEBUG must be at least for this driver is logged
 #ifndef CFG_TUD_MSC_LOG_LEVEL
   #define CFG_TUD_MSC_LOG_LEVEL   CFG_TUD_LOG_LEVEL
@@ -52,10 +55,18 @@ enum {
   MSC_STAGE_NEED_RESET,
 };
 
+// UNMAP parameter list must fit in endpoint buffer of every transport
+#if CFG_TUD_UAS
+  #define UNMAP_LIST_MAX  TU_MIN(CFG_TUD_MSC_EP_BUFSIZE, CFG_TUD_UAS_EP_BUFSIZE)
+#else
+  #define UNMAP_LIST_MAX  CFG_TUD_MSC_EP_BUFSIZE
+#endif
+
 typedef struct {
   TU_ATTR_ALIGNED(4) msc_cbw_t cbw;
   TU_ATTR_ALIGNED(4) msc_csw_t csw;
 
+  uint8_t  rhport;
   uint8_t  itf_num;
   uint8_t  ep_in;
   uint8_t  ep_out;
@@ -66,6 +77,17 @@ typedef struct {
   uint32_t total_len;   // byte to be transferred, can be smaller than total_bytes in cbw
   uint32_t xferred_len; // numbered of bytes transferred so far in the Data Stage
 
+  // READ10/WRITE10 buffer ring: media access of one buffer overlaps USB transfer of another
+  uint32_t io_len;      // READ10: bytes read from media, WRITE10: bytes received from host
+  uint16_t ring_len[CFG_TUD_MSC_EP_BUF_COUNT];
+  uint16_t ring_ofs;    // WRITE10: bytes of head buffer already written to media
+  uint8_t  ring_head;   // oldest buffer: next to send to host (READ10) or write to media (WRITE10)
+  uint8_t  ring_count;  // buffers holding data
+  bool     usb_busy;    // data transfer is in progress
+  bool     io_busy;     // media read/write callback is in progress (asynchronous)
+  bool     io_wait;     // media is not ready, retried on next SOF or tud_msc_media_ready()
+  bool     mapped;      // READ10: data is sent straight from memory-mapped media, ring is unused
+
   // Sense Response Data
   uint8_t sense_key;
   uint8_t add_sense_code;
@@ -74,18 +96,32 @@ typedef struct {
 
 static mscd_interface_t _mscd_itf;
 
+// buffer 0 is also used for command and status
 CFG_TUD_MEM_SECTION static struct {
   TUD_EPBUF_DEF(buf, CFG_TUD_MSC_EP_BUFSIZE);
-} _mscd_epbuf;
+} _mscd_epbuf[CFG_TUD_MSC_EP_BUF_COUNT];
 
 //--------------------------------------------------------------------+
 // INTERNAL OBJECT & FUNCTION DECLARATION
 //--------------------------------------------------------------------+
 static int32_t proc_builtin_scsi(uint8_t lun, uint8_t const scsi_cmd[16], uint8_t* buffer, uint32_t bufsize);
+static int32_t proc_inquiry_vpd(uint8_t const scsi_cmd[16], uint8_t* buffer, uint32_t bufsize);
 static void proc_read10_cmd(uint8_t rhport, mscd_interface_t* p_msc);
+static bool proc_read10_mapped(uint8_t rhport, mscd_interface_t* p_msc);
+static void proc_read10_xfer_done(uint8_t rhport, mscd_interface_t* p_msc, uint32_t xferred_bytes);
+static void proc_read10_io_start(uint8_t rhport, mscd_interface_t* p_msc);
+static bool proc_read10_io_done(uint8_t rhport, mscd_interface_t* p_msc, int32_t nbytes);
 
 static void proc_write10_cmd(uint8_t rhport, mscd_interface_t* p_msc);
 static void proc_write10_new_data(uint8_t rhport, mscd_interface_t* p_msc, uint32_t xferred_bytes);
+static void proc_write10_io_start(uint8_t rhport, mscd_interface_t* p_msc);
+static bool proc_write10_io_done(uint8_t rhport, mscd_interface_t* p_msc, int32_t nbytes);
+
+static void proc_status_stage(uint8_t rhport, mscd_interface_t* p_msc);
+
+#if CFG_TUD_MSC_CACHE_LINES
+static bool cache_sync(uint8_t lun);
+#endif
 
 TU_ATTR_ALWAYS_INLINE static inline bool is_data_in(uint8_t dir) {
   return tu_bit_test(dir, 7);
@@ -95,13 +131,13 @@ static inline bool send_csw(uint8_t rhport, mscd_interface_t* p_msc) {
   // Data residue is always = host expect - actual transferred
   p_msc->csw.data_residue = p_msc->cbw.total_bytes - p_msc->xferred_len;
   p_msc->stage = MSC_STAGE_STATUS_SENT;
-  memcpy(_mscd_epbuf.buf, &p_msc->csw, sizeof(msc_csw_t));
-  return usbd_edpt_xfer(rhport, p_msc->ep_in , _mscd_epbuf.buf, sizeof(msc_csw_t));
+  memcpy(_mscd_epbuf[0].buf, &p_msc->csw, sizeof(msc_csw_t));
+  return usbd_edpt_xfer(rhport, p_msc->ep_in , _mscd_epbuf[0].buf, sizeof(msc_csw_t));
 }
 
 static inline bool prepare_cbw(uint8_t rhport, mscd_interface_t* p_msc) {
   p_msc->stage = MSC_STAGE_CMD;
-  return usbd_edpt_xfer(rhport, p_msc->ep_out,  _mscd_epbuf.buf, sizeof(msc_cbw_t));
+  return usbd_edpt_xfer(rhport, p_msc->ep_out,  _mscd_epbuf[0].buf, sizeof(msc_cbw_t));
 }
 
 static void fail_scsi_op(uint8_t rhport, mscd_interface_t* p_msc, uint8_t status) {
@@ -127,29 +163,48 @@ static void fail_scsi_op(uint8_t rhport, mscd_interface_t* p_msc, uint8_t status
   }
 }
 
-static inline uint32_t rdwr10_get_lba(uint8_t const command[]) {
+TU_ATTR_ALWAYS_INLINE static inline bool is_read_cmd(uint8_t cmd) {
+  return cmd == SCSI_CMD_READ_10 || cmd == SCSI_CMD_READ_16;
+}
+
+TU_ATTR_ALWAYS_INLINE static inline bool is_write_cmd(uint8_t cmd) {
+  return cmd == SCSI_CMD_WRITE_10 || cmd == SCSI_CMD_WRITE_16;
+}
+
+// READ/WRITE 10 or 16
+static inline uint64_t rdwr_get_lba(uint8_t const command[]) {
   // use offsetof to avoid pointer to the odd/unaligned address
+  if (command[0] == SCSI_CMD_READ_16 || command[0] == SCSI_CMD_WRITE_16) {
+    uint8_t const* p_lba = command + offsetof(scsi_write16_t, lba);
+    uint32_t const lba_hi = tu_unaligned_read32(p_lba);
+    uint32_t const lba_lo = tu_unaligned_read32(p_lba + 4);
+    return (((uint64_t) tu_ntohl(lba_hi)) << 32) | tu_ntohl(lba_lo); // lba is in Big Endian
+  }
   const uint32_t lba = tu_unaligned_read32(command + offsetof(scsi_write10_t, lba));
   return tu_ntohl(lba); // lba is in Big Endian
 }
 
-static inline uint16_t rdwr10_get_blockcount(msc_cbw_t const* cbw) {
+static inline uint32_t rdwr_get_blockcount(msc_cbw_t const* cbw) {
+  if (cbw->command[0] == SCSI_CMD_READ_16 || cbw->command[0] == SCSI_CMD_WRITE_16) {
+    uint32_t const block_count = tu_unaligned_read32(cbw->command + offsetof(scsi_write16_t, block_count));
+    return tu_ntohl(block_count);
+  }
   uint16_t const block_count = tu_unaligned_read16(cbw->command + offsetof(scsi_write10_t, block_count));
   return tu_ntohs(block_count);
 }
 
-static inline uint16_t rdwr10_get_blocksize(msc_cbw_t const* cbw) {
+static inline uint32_t rdwr_get_blocksize(msc_cbw_t const* cbw) {
   // first extract block count in the command
-  uint16_t const block_count = rdwr10_get_blockcount(cbw);
+  uint32_t const block_count = rdwr_get_blockcount(cbw);
   if (block_count == 0) {
     return 0; // invalid block count
   }
-  return (uint16_t) (cbw->total_bytes / block_count);
+  return cbw->total_bytes / block_count;
 }
 
-static uint8_t rdwr10_validate_cmd(msc_cbw_t const* cbw) {
+static uint8_t rdwr_validate_cmd(msc_cbw_t const* cbw) {
   uint8_t status = MSC_CSW_STATUS_PASSED;
-  uint16_t const block_count = rdwr10_get_blockcount(cbw);
+  uint32_t const block_count = rdwr_get_blockcount(cbw);
 
   if (cbw->total_bytes == 0) {
     if (block_count) {
@@ -159,10 +214,10 @@ static uint8_t rdwr10_validate_cmd(msc_cbw_t const* cbw) {
       // no data transfer, only exist in complaint test suite
     }
   } else {
-    if (SCSI_CMD_READ_10 == cbw->command[0] && !is_data_in(cbw->dir)) {
+    if (is_read_cmd(cbw->command[0]) && !is_data_in(cbw->dir)) {
       TU_LOG_DRV("  SCSI case 10 (Ho <> Di)\r\n");
       status = MSC_CSW_STATUS_PHASE_ERROR;
-    } else if (SCSI_CMD_WRITE_10 == cbw->command[0] && is_data_in(cbw->dir)) {
+    } else if (is_write_cmd(cbw->command[0]) && is_data_in(cbw->dir)) {
       TU_LOG_DRV("  SCSI case 8 (Hi <> Do)\r\n");
       status = MSC_CSW_STATUS_PHASE_ERROR;
     } else if (0 == block_count) {
@@ -193,7 +248,13 @@ TU_ATTR_UNUSED tu_static tu_lookup_entry_t const _msc_scsi_cmd_lookup[] = {
   { .key = SCSI_CMD_REQUEST_SENSE                , .data = "Request Sense" },
   { .key = SCSI_CMD_READ_FORMAT_CAPACITY         , .data = "Read Format Capacity" },
   { .key = SCSI_CMD_READ_10                      , .data = "Read10" },
-  { .key = SCSI_CMD_WRITE_10                     , .data = "Write10" }
+  { .key = SCSI_CMD_WRITE_10                     , .data = "Write10" },
+  { .key = SCSI_CMD_READ_16                      , .data = "Read16" },
+  { .key = SCSI_CMD_WRITE_16                     , .data = "Write16" },
+  { .key = SCSI_CMD_WRITE_SAME_10                , .data = "Write Same10" },
+  { .key = SCSI_CMD_WRITE_SAME_16                , .data = "Write Same16" },
+  { .key = SCSI_CMD_UNMAP                        , .data = "Unmap" },
+  { .key = SCSI_CMD_SERVICE_ACTION_IN_16         , .data = "Service Action In16" }
 };
 
 TU_ATTR_UNUSED tu_static tu_lookup_table_t const _msc_scsi_cmd_table = {
@@ -244,6 +305,7 @@ uint16_t mscd_open(uint8_t rhport, tusb_desc_interface_t const * itf_desc, uint1
   TU_ASSERT(max_len >= drv_len, 0); // Max length must be at least 1 interface + 2 endpoints
 
   mscd_interface_t * p_msc = &_mscd_itf;
+  p_msc->rhport = rhport;
   p_msc->itf_num = itf_desc->bInterfaceNumber;
 
   // Open endpoint pair
@@ -255,10 +317,25 @@ uint16_t mscd_open(uint8_t rhport, tusb_desc_interface_t const * itf_desc, uint1
   return drv_len;
 }
 
+static void ring_reset(mscd_interface_t* p_msc) {
+  p_msc->io_len     = 0;
+  p_msc->ring_ofs   = 0;
+  p_msc->ring_head  = 0;
+  p_msc->ring_count = 0;
+  p_msc->usb_busy   = false;
+  p_msc->mapped     = false;
+  p_msc->io_busy    = false; // late asynchronous completion is ignored
+  if (p_msc->io_wait) {
+    p_msc->io_wait = false;
+    usbd_sof_enable(p_msc->rhport, SOF_CONSUMER_MSC, false);
+  }
+}
+
 static void proc_bot_reset(mscd_interface_t* p_msc) {
   p_msc->stage       = MSC_STAGE_CMD;
   p_msc->total_len   = 0;
   p_msc->xferred_len = 0;
+  ring_reset(p_msc);
   p_msc->sense_key           = 0;
   p_msc->add_sense_code      = 0;
   p_msc->add_sense_qualifier = 0;
@@ -351,7 +428,7 @@ bool mscd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t event, uint32_t
         return true;
       }
 
-      const uint32_t signature = tu_le32toh(tu_unaligned_read32(_mscd_epbuf.buf));
+      const uint32_t signature = tu_le32toh(tu_unaligned_read32(_mscd_epbuf[0].buf));
 
       if (!(xferred_bytes == sizeof(msc_cbw_t) && signature == MSC_CBW_SIGNATURE)) {
         // BOT 6.6.1 If CBW is not valid stall both endpoints until reset recovery
@@ -362,7 +439,7 @@ bool mscd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t event, uint32_t
         return false;
       }
 
-      memcpy(p_cbw, _mscd_epbuf.buf, sizeof(msc_cbw_t));
+      memcpy(p_cbw, _mscd_epbuf[0].buf, sizeof(msc_cbw_t));
 
       TU_LOG_DRV("  SCSI Command [Lun%u]: %s\r\n", p_cbw->lun, tu_lookup_find(&_msc_scsi_cmd_table, p_cbw->command[0]));
       //TU_LOG_MEM(MSC_DEBUG, p_cbw, xferred_bytes, 2);
@@ -377,14 +454,14 @@ bool mscd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t event, uint32_t
       p_msc->total_len = p_cbw->total_bytes;
       p_msc->xferred_len = 0;
 
-      // Read10 or Write10
-      if ((SCSI_CMD_READ_10 == p_cbw->command[0]) || (SCSI_CMD_WRITE_10 == p_cbw->command[0])) {
-        uint8_t const status = rdwr10_validate_cmd(p_cbw);
+      // Read10/16 or Write10/16
+      if (is_read_cmd(p_cbw->command[0]) || is_write_cmd(p_cbw->command[0])) {
+        uint8_t const status = rdwr_validate_cmd(p_cbw);
 
         if (status != MSC_CSW_STATUS_PASSED) {
           fail_scsi_op(rhport, p_msc, status);
         } else if (p_cbw->total_bytes) {
-          if (SCSI_CMD_READ_10 == p_cbw->command[0]) {
+          if (is_read_cmd(p_cbw->command[0])) {
             proc_read10_cmd(rhport, p_msc);
           } else {
             proc_write10_cmd(rhport, p_msc);
@@ -404,16 +481,11 @@ bool mscd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t event, uint32_t
           } else {
             // Didn't check for case 9 (Ho > Dn), which requires examining scsi command first
             // but it is OK to just receive data then responded with failed status
-            TU_ASSERT(usbd_edpt_xfer(rhport, p_msc->ep_out, _mscd_epbuf.buf, (uint16_t) p_msc->total_len));
+            TU_ASSERT(usbd_edpt_xfer(rhport, p_msc->ep_out, _mscd_epbuf[0].buf, (uint16_t) p_msc->total_len));
           }
         } else {
-          // First process if it is a built-in commands
-          int32_t resplen = proc_builtin_scsi(p_cbw->lun, p_cbw->command, _mscd_epbuf.buf, CFG_TUD_MSC_EP_BUFSIZE);
-
-          // Invoke user callback if not built-in
-          if ((resplen < 0) && (p_msc->sense_key == 0)) {
-            resplen = tud_msc_scsi_cb(p_cbw->lun, p_cbw->command, _mscd_epbuf.buf, (uint16_t)p_msc->total_len);
-          }
+          int32_t resplen = mscd_scsi_cmd(p_cbw->lun, p_cbw->command, _mscd_epbuf[0].buf, CFG_TUD_MSC_EP_BUFSIZE,
+                                          (uint16_t) p_msc->total_len);
 
           if (resplen < 0) {
             // unsupported command
@@ -436,7 +508,7 @@ bool mscd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t event, uint32_t
             } else {
               // cannot return more than host expect
               p_msc->total_len = tu_min32((uint32_t)resplen, p_cbw->total_bytes);
-              TU_ASSERT(usbd_edpt_xfer(rhport, p_msc->ep_in, _mscd_epbuf.buf, (uint16_t) p_msc->total_len));
+              TU_ASSERT(usbd_edpt_xfer(rhport, p_msc->ep_in, _mscd_epbuf[0].buf, (uint16_t) p_msc->total_len));
             }
           }
         }
@@ -445,25 +517,18 @@ bool mscd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t event, uint32_t
 
     case MSC_STAGE_DATA:
       TU_LOG_DRV("  SCSI Data [Lun%u]\r\n", p_cbw->lun);
-      //TU_LOG_MEM(MSC_DEBUG, _mscd_epbuf.buf, xferred_bytes, 2);
-
-      if (SCSI_CMD_READ_10 == p_cbw->command[0]) {
-        p_msc->xferred_len += xferred_bytes;
+      //TU_LOG_MEM(MSC_DEBUG, _mscd_epbuf[0].buf, xferred_bytes, 2);
 
-        if ( p_msc->xferred_len >= p_msc->total_len ) {
-          // Data Stage is complete
-          p_msc->stage = MSC_STAGE_STATUS;
-        }else {
-          proc_read10_cmd(rhport, p_msc);
-        }
-      } else if (SCSI_CMD_WRITE_10 == p_cbw->command[0]) {
+      if (is_read_cmd(p_cbw->command[0])) {
+        proc_read10_xfer_done(rhport, p_msc, xferred_bytes);
+      } else if (is_write_cmd(p_cbw->command[0])) {
         proc_write10_new_data(rhport, p_msc, xferred_bytes);
       } else {
         p_msc->xferred_len += xferred_bytes;
 
         // OUT transfer, invoke callback if needed
         if ( !is_data_in(p_cbw->dir) ) {
-          int32_t cb_result = tud_msc_scsi_cb(p_cbw->lun, p_cbw->command, _mscd_epbuf.buf, (uint16_t) p_msc->total_len);
+          int32_t cb_result = mscd_scsi_out(p_cbw->lun, p_cbw->command, _mscd_epbuf[0].buf, p_msc->total_len);
 
           if ( cb_result < 0 ) {
             // unsupported command
@@ -499,12 +564,14 @@ bool mscd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t event, uint32_t
         // if complete_cb() is invoked after queuing the status.
         switch (p_cbw->command[0]) {
           case SCSI_CMD_READ_10:
+          case SCSI_CMD_READ_16:
             if (tud_msc_read10_complete_cb) {
               tud_msc_read10_complete_cb(p_cbw->lun);
             }
             break;
 
           case SCSI_CMD_WRITE_10:
+          case SCSI_CMD_WRITE_16:
             if (tud_msc_write10_complete_cb) {
               tud_msc_write10_complete_cb(p_cbw->lun);
             }
@@ -527,6 +594,15 @@ bool mscd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t event, uint32_t
     default: break;
   }
 
+  proc_status_stage(rhport, p_msc);
+
+  return true;
+}
+
+// send status once data stage is complete
+static void proc_status_stage(uint8_t rhport, mscd_interface_t* p_msc) {
+  msc_cbw_t const * p_cbw = &p_msc->cbw;
+
   if (p_msc->stage == MSC_STAGE_STATUS) {
     // skip status if epin is currently stalled, will do it when received Clear Stall request
     if (!usbd_edpt_stalled(rhport, p_msc->ep_in)) {
@@ -535,7 +611,7 @@ bool mscd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t event, uint32_t
         // TU_LOG(MSC_DEBUG, "  SCSI case 5 (Hi > Di): %lu > %lu\r\n", p_cbw->total_bytes, p_msc->xferred_len);
         usbd_edpt_stall(rhport, p_msc->ep_in);
       } else {
-        TU_ASSERT(send_csw(rhport, p_msc));
+        TU_ASSERT(send_csw(rhport, p_msc),);
       }
     }
 
@@ -549,14 +625,25 @@ bool mscd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t event, uint32_t
     }
     #endif
   }
-
-  return true;
 }
 
 /*------------------------------------------------------------------*/
 /* SCSI Command Process
  *------------------------------------------------------------------*/
 
+// 64-bit capacity callback if defined, 32-bit otherwise
+void mscd_get_capacity(uint8_t lun, uint64_t* block_count, uint32_t* block_size) {
+  if (tud_msc_capacity16_cb) {
+    tud_msc_capacity16_cb(lun, block_count, block_size);
+  } else {
+    uint32_t count32 = 0;
+    uint16_t size16 = 0;
+    tud_msc_capacity_cb(lun, &count32, &size16);
+    *block_count = count32;
+    *block_size = size16;
+  }
+}
+
 // return response's length (copied to buffer). Negative if it is not an built-in command or indicate Failed status (CSW)
 // In case of a failed status, sense key must be set for reason of failure
 static int32_t proc_builtin_scsi(uint8_t lun, uint8_t const scsi_cmd[16], uint8_t* buffer, uint32_t bufsize) {
@@ -582,6 +669,13 @@ static int32_t proc_builtin_scsi(uint8_t lun, uint8_t const scsi_cmd[16], uint8_
     case SCSI_CMD_START_STOP_UNIT:
       resplen = 0;
 
+      #if CFG_TUD_MSC_CACHE_LINES
+      if (!cache_sync(lun)) {
+        resplen = -1;
+        break;
+      }
+      #endif
+
       if (tud_msc_start_stop_cb) {
         scsi_start_stop_unit_t const* start_stop = (scsi_start_stop_unit_t const*)scsi_cmd;
         if (!tud_msc_start_stop_cb(lun, start_stop->power_condition, start_stop->start, start_stop->load_eject)) {
@@ -596,6 +690,14 @@ static int32_t proc_builtin_scsi(uint8_t lun, uint8_t const scsi_cmd[16], uint8_
       }
       break;
 
+    #if CFG_TUD_MSC_CACHE_LINES
+    case SCSI_CMD_SYNCHRONIZE_CACHE_10:
+      // application callback is still invoked after cache is written back
+      (void) cache_sync(lun);
+      resplen = -1;
+      break;
+    #endif
+
     case SCSI_CMD_PREVENT_ALLOW_MEDIUM_REMOVAL:
       resplen = 0;
 
@@ -615,12 +717,10 @@ static int32_t proc_builtin_scsi(uint8_t lun, uint8_t const scsi_cmd[16], uint8_
 
 
     case SCSI_CMD_READ_CAPACITY_10: {
-      uint32_t block_count;
+      uint64_t block_count;
       uint32_t block_size;
-      uint16_t block_size_u16;
 
-      tud_msc_capacity_cb(lun, &block_count, &block_size_u16);
-      block_size = (uint32_t)block_size_u16;
+      mscd_get_capacity(lun, &block_count, &block_size);
 
       // Invalid block size/count from callback, possibly unit is not ready
       // stall this request, set sense key to NOT READY
@@ -634,7 +734,8 @@ static int32_t proc_builtin_scsi(uint8_t lun, uint8_t const scsi_cmd[16], uint8_
       } else {
         scsi_read_capacity10_resp_t read_capa10;
 
-        read_capa10.last_lba = tu_htonl(block_count-1);
+        // all ones tells host to use READ CAPACITY (16)
+        read_capa10.last_lba = tu_htonl((uint32_t) TU_MIN(block_count - 1, UINT32_MAX));
         read_capa10.block_size = tu_htonl(block_size);
 
         resplen = sizeof(read_capa10);
@@ -643,6 +744,40 @@ static int32_t proc_builtin_scsi(uint8_t lun, uint8_t const scsi_cmd[16], uint8_
     }
     break;
 
+    case SCSI_CMD_SERVICE_ACTION_IN_16: {
+      if ((scsi_cmd[1] & 0x1Fu) != SCSI_SERVICE_ACTION_READ_CAPACITY_16) {
+        resplen = -1;
+        break; // other service actions are handled by application
+      }
+
+      uint64_t block_count;
+      uint32_t block_size;
+      mscd_get_capacity(lun, &block_count, &block_size);
+
+      if (block_count == 0 || block_size == 0) {
+        resplen = -1;
+
+        // set default sense if not set by callback
+        if (p_msc->sense_key == 0) {
+          set_sense_medium_not_present(lun);
+        }
+      } else {
+        scsi_read_capacity16_resp_t read_capa16;
+        tu_memclr(&read_capa16, sizeof(read_capa16));
+
+        read_capa16.last_lba = tu_htonll(block_count - 1);
+        read_capa16.block_size = tu_htonl(block_size);
+        if (tud_msc_unmap_cb) {
+          read_capa16.lowest_aligned_lba = tu_htons(0x8000); // LBPME: logical block provisioning is enabled
+        }
+
+        uint32_t const alloc_length = tu_ntohl(tu_unaligned_read32(scsi_cmd + offsetof(scsi_read_capacity16_t, alloc_length)));
+        resplen = (int32_t) tu_min32(sizeof(read_capa16), alloc_length);
+        TU_VERIFY(0 == tu_memcpy_s(buffer, bufsize, &read_capa16, (size_t) resplen));
+      }
+    }
+    break;
+
     case SCSI_CMD_READ_FORMAT_CAPACITY: {
       scsi_read_format_capacity_data_t read_fmt_capa =
       {
@@ -652,10 +787,10 @@ static int32_t proc_builtin_scsi(uint8_t lun, uint8_t const scsi_cmd[16], uint8_
         .block_size_u16 = 0
       };
 
-      uint32_t block_count;
-      uint16_t block_size;
+      uint64_t block_count;
+      uint32_t block_size;
 
-      tud_msc_capacity_cb(lun, &block_count, &block_size);
+      mscd_get_capacity(lun, &block_count, &block_size);
 
       // Invalid block size/count from callback, possibly unit is not ready
       // stall this request, set sense key to NOT READY
@@ -667,8 +802,8 @@ static int32_t proc_builtin_scsi(uint8_t lun, uint8_t const scsi_cmd[16], uint8_
           set_sense_medium_not_present(lun);
         }
       } else {
-        read_fmt_capa.block_num = tu_htonl(block_count);
-        read_fmt_capa.block_size_u16 = tu_htons(block_size);
+        read_fmt_capa.block_num = tu_htonl((uint32_t) TU_MIN(block_count, UINT32_MAX));
+        read_fmt_capa.block_size_u16 = tu_htons((uint16_t) block_size);
 
         resplen = sizeof(read_fmt_capa);
         TU_VERIFY(0 == tu_memcpy_s(buffer, bufsize, &read_fmt_capa, (size_t) resplen));
@@ -677,6 +812,12 @@ static int32_t proc_builtin_scsi(uint8_t lun, uint8_t const scsi_cmd[16], uint8_
     break;
 
     case SCSI_CMD_INQUIRY: {
+      // EVPD: provisioning pages are built-in, others are handled by application
+      if ((scsi_cmd[1] & 0x01u) && (tud_msc_unmap_cb || tud_msc_write_same_cb)) {
+        resplen = proc_inquiry_vpd(scsi_cmd, buffer, bufsize);
+        break;
+      }
+
       scsi_inquiry_resp_t inquiry_rsp =
       {
         .is_removable = 1,
@@ -744,6 +885,11 @@ static int32_t proc_builtin_scsi(uint8_t lun, uint8_t const scsi_cmd[16], uint8_
     }
     break;
 
+    case SCSI_CMD_UNMAP:
+      // empty parameter list is no-data command
+      resplen = (tud_msc_unmap_cb && scsi_cmd[7] == 0 && scsi_cmd[8] == 0) ? 0 : -1;
+      break;
+
     default: resplen = -1;
       break;
   }
@@ -751,21 +897,440 @@ static int32_t proc_builtin_scsi(uint8_t lun, uint8_t const scsi_cmd[16], uint8_
   return resplen;
 }
 
+// Logical block provisioning VPD pages, negative if page is not built-in
+static int32_t proc_inquiry_vpd(uint8_t const scsi_cmd[16], uint8_t* buffer, uint32_t bufsize) {
+  uint16_t const alloc_length = tu_ntohs(tu_unaligned_read16(scsi_cmd + 3));
+  int32_t resplen;
+
+  switch (scsi_cmd[2]) {
+    case SCSI_VPD_SUPPORTED_PAGES: {
+      uint8_t const pages[] = {0, SCSI_VPD_SUPPORTED_PAGES, 0, 3,
+                               SCSI_VPD_SUPPORTED_PAGES, SCSI_VPD_BLOCK_LIMITS, SCSI_VPD_LOGICAL_BLOCK_PROVISIONING};
+      resplen = sizeof(pages);
+      TU_VERIFY(0 == tu_memcpy_s(buffer, bufsize, pages, (size_t) resplen));
+    }
+    break;
+
+    case SCSI_VPD_BLOCK_LIMITS: {
+      scsi_vpd_block_limits_t limits;
+      tu_memclr(&limits, sizeof(limits));
+      limits.page_code   = SCSI_VPD_BLOCK_LIMITS;
+      limits.page_length = tu_htons(sizeof(limits) - 4);
+      if (tud_msc_unmap_cb) {
+        limits.max_unmap_lba_count        = tu_htonl(UINT32_MAX);
+        limits.max_unmap_block_desc_count = tu_htonl((UNMAP_LIST_MAX - sizeof(scsi_unmap_param_header_t)) /
+                                                     sizeof(scsi_unmap_block_desc_t));
+      }
+      resplen = sizeof(limits);
+      TU_VERIFY(0 == tu_memcpy_s(buffer, bufsize, &limits, (size_t) resplen));
+    }
+    break;
+
+    case SCSI_VPD_LOGICAL_BLOCK_PROVISIONING: {
+      scsi_vpd_logical_block_provisioning_t lbp;
+      tu_memclr(&lbp, sizeof(lbp));
+      lbp.page_code   = SCSI_VPD_LOGICAL_BLOCK_PROVISIONING;
+      lbp.page_length = tu_htons(sizeof(lbp) - 4);
+      lbp.lbpu        = tud_msc_unmap_cb ? 1 : 0;
+      lbp.lbpws       = tud_msc_write_same_cb ? 1 : 0;
+      lbp.lbpws10     = tud_msc_write_same_cb ? 1 : 0;
+      lbp.provisioning_type = tud_msc_unmap_cb ? 2 : 0; // thin provisioned
+      resplen = sizeof(lbp);
+      TU_VERIFY(0 == tu_memcpy_s(buffer, bufsize, &lbp, (size_t) resplen));
+    }
+    break;
+
+    default: return -1;
+  }
+
+  return (int32_t) tu_min32((uint32_t) resplen, alloc_length);
+}
+
+// blocks are within medium and medium is writable, sense is set otherwise
+static bool lba_range_writable(uint8_t lun, uint64_t lba, uint64_t block_count, uint64_t capacity) {
+  if (capacity == 0) {
+    set_sense_medium_not_present(lun);
+    return false;
+  }
+  if (lba > capacity || block_count > capacity - lba) {
+    tud_msc_set_sense(lun, SCSI_SENSE_ILLEGAL_REQUEST, 0x21, 0x00); // LBA out of range
+    return false;
+  }
+  if (tud_msc_is_writable_cb && !tud_msc_is_writable_cb(lun)) {
+    tud_msc_set_sense(lun, SCSI_SENSE_DATA_PROTECT, 0x27, 0x00); // write protected
+    return false;
+  }
+  return true;
+}
+
+static int32_t proc_unmap(uint8_t lun, uint8_t const* buffer, uint32_t bufsize) {
+  uint64_t capacity;
+  uint32_t block_size;
+  mscd_get_capacity(lun, &capacity, &block_size);
+
+  if (bufsize < sizeof(scsi_unmap_param_header_t)) {
+    return 0; // no descriptor
+  }
+
+  uint32_t desc_len = tu_ntohs(tu_unaligned_read16(buffer + offsetof(scsi_unmap_param_header_t, block_desc_data_length)));
+  desc_len = tu_min32(desc_len, bufsize - (uint32_t) sizeof(scsi_unmap_param_header_t));
+  uint8_t const* p_desc = buffer + sizeof(scsi_unmap_param_header_t);
+
+  for (; desc_len >= sizeof(scsi_unmap_block_desc_t); desc_len -= (uint32_t) sizeof(scsi_unmap_block_desc_t)) {
+    uint32_t const lba_hi = tu_ntohl(tu_unaligned_read32(p_desc + offsetof(scsi_unmap_block_desc_t, lba)));
+    uint32_t const lba_lo = tu_ntohl(tu_unaligned_read32(p_desc + offsetof(scsi_unmap_block_desc_t, lba) + 4));
+    uint64_t const lba = (((uint64_t) lba_hi) << 32) | lba_lo;
+    uint32_t const block_count = tu_ntohl(tu_unaligned_read32(p_desc + offsetof(scsi_unmap_block_desc_t, block_count)));
+    p_desc += sizeof(scsi_unmap_block_desc_t);
+
+    if (block_count == 0) {
+      continue;
+    }
+    TU_VERIFY(lba_range_writable(lun, lba, block_count, capacity), -1);
+
+    #if CFG_TUD_MSC_CACHE_LINES
+    mscd_cache_discard(lun, lba, block_count);
+    #endif
+
+    if (!tud_msc_unmap_cb(lun, lba, block_count)) {
+      if (_mscd_itf.sense_key == 0) {
+        set_sense_medium_not_present(lun);
+      }
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+static int32_t proc_write_same(uint8_t lun, uint8_t const scsi_cmd[16], uint8_t const* buffer, uint32_t bufsize) {
+  uint64_t capacity;
+  uint32_t block_size;
+  mscd_get_capacity(lun, &capacity, &block_size);
+
+  uint64_t lba;
+  uint64_t block_count;
+  if (scsi_cmd[0] == SCSI_CMD_WRITE_SAME_16) {
+    uint8_t const* p_lba = scsi_cmd + offsetof(scsi_write_same16_t, lba);
+    lba = (((uint64_t) tu_ntohl(tu_unaligned_read32(p_lba))) << 32) | tu_ntohl(tu_unaligned_read32(p_lba + 4));
+    block_count = tu_ntohl(tu_unaligned_read32(scsi_cmd + offsetof(scsi_write_same16_t, block_count)));
+  } else {
+    lba = tu_ntohl(tu_unaligned_read32(scsi_cmd + offsetof(scsi_write_same10_t, lba)));
+    block_count = tu_ntohs(tu_unaligned_read16(scsi_cmd + offsetof(scsi_write_same10_t, block_count)));
+  }
+
+  // zero means up to last block
+  if (block_count == 0 && lba < capacity) {
+    block_count = capacity - lba;
+  }
+
+  TU_VERIFY(lba_range_writable(lun, lba, block_count, capacity), -1);
+  if (block_count > UINT32_MAX) {
+    tud_msc_set_sense(lun, SCSI_SENSE_ILLEGAL_REQUEST, 0x24, 0x00); // invalid field in CDB
+    return -1;
+  }
+  if (bufsize < block_size) {
+    tud_msc_set_sense(lun, SCSI_SENSE_ILLEGAL_REQUEST, 0x1A, 0x00); // parameter list length error
+    return -1;
+  }
+
+  #if CFG_TUD_MSC_CACHE_LINES
+  mscd_cache_discard(lun, lba, block_count);
+  #endif
+
+  bool const unmap = (scsi_cmd[1] & SCSI_WRITE_SAME_FLAG_UNMAP) != 0;
+  if (!tud_msc_write_same_cb(lun, lba, (uint32_t) block_count, buffer, block_size, unmap)) {
+    if (_mscd_itf.sense_key == 0) {
+      set_sense_medium_not_present(lun);
+    }
+    return -1;
+  }
+
+  return 0;
+}
+
+// Data-Out length of built-in commands, zero if command is not built-in. Used by UAS which has no transfer length
+uint32_t mscd_scsi_out_len(uint8_t lun, uint8_t const scsi_cmd[16]) {
+  switch (scsi_cmd[0]) {
+    case SCSI_CMD_UNMAP:
+      return tud_msc_unmap_cb ? tu_ntohs(tu_unaligned_read16(scsi_cmd + offsetof(scsi_unmap_t, param_list_length))) : 0;
+
+    case SCSI_CMD_WRITE_SAME_10:
+    case SCSI_CMD_WRITE_SAME_16: {
+      if (!tud_msc_write_same_cb || (scsi_cmd[0] == SCSI_CMD_WRITE_SAME_16 && (scsi_cmd[1] & 0x01u))) {
+        return 0; // NDOB has no Data-Out
+      }
+      uint64_t capacity;
+      uint32_t block_size;
+      mscd_get_capacity(lun, &capacity, &block_size);
+      return block_size;
+    }
+
+    default: return 0;
+  }
+}
+
+// Data-Out command after data is received: built-in first, invoke application callback if not built-in
+int32_t mscd_scsi_out(uint8_t lun, uint8_t const scsi_cmd[16], uint8_t* buffer, uint32_t bufsize) {
+  int32_t result = -1;
+
+  if (scsi_cmd[0] == SCSI_CMD_UNMAP && tud_msc_unmap_cb) {
+    result = proc_unmap(lun, buffer, bufsize);
+  } else if ((scsi_cmd[0] == SCSI_CMD_WRITE_SAME_10 || scsi_cmd[0] == SCSI_CMD_WRITE_SAME_16) && tud_msc_write_same_cb) {
+    result = proc_write_same(lun, scsi_cmd, buffer, bufsize);
+  }
+
+  if ((result < 0) && (_mscd_itf.sense_key == 0)) {
+    result = tud_msc_scsi_cb(lun, scsi_cmd, buffer, (uint16_t) bufsize);
+  }
+  return result;
+}
+
+// Built-in command first, invoke application callback if not built-in. Also used by UAS transport
+int32_t mscd_scsi_cmd(uint8_t lun, uint8_t const scsi_cmd[16], uint8_t* buffer, uint32_t bufsize, uint16_t app_bufsize) {
+  int32_t resplen = proc_builtin_scsi(lun, scsi_cmd, buffer, bufsize);
+  if ((resplen < 0) && (_mscd_itf.sense_key == 0)) {
+    resplen = tud_msc_scsi_cb(lun, scsi_cmd, buffer, app_bufsize);
+  }
+  return resplen;
+}
+
+// Fixed format sense data of a failed command (default Illegal Request) then clear it, for UAS Sense IU
+int32_t mscd_scsi_sense(uint8_t lun, uint8_t* buffer, uint32_t bufsize) {
+  if (_mscd_itf.sense_key == 0) {
+    tud_msc_set_sense(lun, SCSI_SENSE_ILLEGAL_REQUEST, 0x20, 0x00);
+  }
+  uint8_t const request_sense[16] = { SCSI_CMD_REQUEST_SENSE, 0, 0, 0, (uint8_t) sizeof(scsi_sense_fixed_resp_t) };
+  return proc_builtin_scsi(lun, request_sense, buffer, bufsize);
+}
+
+// Memory-mapped media: pointer to data of lba + offset, return its available bytes or 0 if it must be copied
+int32_t mscd_media_read_ptr(uint8_t lun, uint64_t lba, uint32_t offset, void const** buffer, uint32_t bufsize) {
+  TU_VERIFY(tud_msc_read10_ptr_cb, 0);
+
+  #if CFG_TUD_MSC_CACHE_LINES
+  // media must hold cached writes first
+  TU_VERIFY(mscd_cache_flush(lun) > 0, 0);
+  #endif
+
+  *buffer = NULL;
+  int32_t const nbytes = tud_msc_read10_ptr_cb(lun, lba, offset, buffer, bufsize);
+  TU_VERIFY(nbytes > 0 && *buffer != NULL, 0);
+  return (int32_t) tu_min32((uint32_t) nbytes, bufsize);
+}
+
+// Send application memory to host without copy, return submitted bytes (0 if failed)
+uint32_t mscd_xfer_mapped(uint8_t rhport, uint8_t ep_in, void const* buffer, uint32_t len) {
+  #if CFG_TUD_EDPT_XFER_EX
+  TU_VERIFY(usbd_edpt_xfer_ex(rhport, ep_in, (uint8_t*) (uintptr_t) buffer, len), 0);
+  #else
+  len = tu_min32(len, CFG_TUD_EDPT_XFER_EX_CHUNK);
+  TU_VERIFY(usbd_edpt_xfer(rhport, ep_in, (uint8_t*) (uintptr_t) buffer, (uint16_t) len), 0);
+  #endif
+  return len;
+}
+
+// READ10/16 use 64-bit callback if defined, 32-bit LBA callback otherwise
+int32_t mscd_media_read_cb(uint8_t lun, uint64_t lba, uint32_t offset, void* buffer, uint32_t bufsize) {
+  if (tud_msc_read16_cb) {
+    return tud_msc_read16_cb(lun, lba, offset, buffer, bufsize);
+  }
+  TU_VERIFY(lba <= UINT32_MAX, TUD_MSC_RET_ERROR);
+  return tud_msc_read10_cb(lun, (uint32_t) lba, offset, buffer, bufsize);
+}
+
+int32_t mscd_media_write_cb(uint8_t lun, uint64_t lba, uint32_t offset, uint8_t* buffer, uint32_t bufsize) {
+  if (tud_msc_write16_cb) {
+    return tud_msc_write16_cb(lun, lba, offset, buffer, bufsize);
+  }
+  TU_VERIFY(lba <= UINT32_MAX, TUD_MSC_RET_ERROR);
+  return tud_msc_write10_cb(lun, (uint32_t) lba, offset, buffer, bufsize);
+}
+
+// media access of READ/WRITE commands, through block cache if enabled
+int32_t mscd_media_read(uint8_t lun, uint64_t lba, uint32_t offset, void* buffer, uint32_t bufsize) {
+  #if CFG_TUD_MSC_CACHE_LINES
+  return mscd_cache_read(lun, lba, offset, (uint8_t*) buffer, bufsize);
+  #else
+  return mscd_media_read_cb(lun, lba, offset, buffer, bufsize);
+  #endif
+}
+
+int32_t mscd_media_write(uint8_t lun, uint64_t lba, uint32_t offset, uint8_t* buffer, uint32_t bufsize) {
+  #if CFG_TUD_MSC_CACHE_LINES
+  return mscd_cache_write(lun, lba, offset, buffer, bufsize);
+  #else
+  return mscd_media_write_cb(lun, lba, offset, buffer, bufsize);
+  #endif
+}
+
+#if CFG_TUD_MSC_CACHE_LINES
+// write back cached data, fail with sense if media is busy or failed
+static bool cache_sync(uint8_t lun) {
+  int32_t const result = mscd_cache_flush(lun);
+  if (result == 0) {
+    tud_msc_set_sense(lun, SCSI_SENSE_NOT_READY, 0x04, 0x07); // operation in progress, host retries
+  } else if (result < 0) {
+    tud_msc_set_sense(lun, SCSI_SENSE_MEDIUM_ERROR, 0x0C, 0x00); // write error
+  }
+  return result > 0;
+}
+#endif
+
+// Media returned busy: instead of spinning, wait for next SOF or tud_msc_media_ready() to retry
+static void io_wait_start(mscd_interface_t* p_msc) {
+  p_msc->io_wait = true;
+  usbd_sof_enable(p_msc->rhport, SOF_CONSUMER_MSC, true);
+}
+
+// retry media access which returned busy
+static void proc_io_retry(void* param) {
+  (void) param;
+  mscd_interface_t* p_msc = &_mscd_itf;
+  TU_VERIFY(p_msc->io_wait,);
+  p_msc->io_wait = false;
+  usbd_sof_enable(p_msc->rhport, SOF_CONSUMER_MSC, false);
+  TU_VERIFY(p_msc->stage == MSC_STAGE_DATA && !p_msc->io_busy,);
+
+  if (is_read_cmd(p_msc->cbw.command[0])) {
+    proc_read10_io_start(p_msc->rhport, p_msc);
+  } else if (is_write_cmd(p_msc->cbw.command[0])) {
+    proc_write10_io_start(p_msc->rhport, p_msc);
+  }
+  proc_status_stage(p_msc->rhport, p_msc);
+}
+
+// asynchronous media access is complete, param is callback result
+static void proc_io_async_done(void* param) {
+  mscd_interface_t* p_msc = &_mscd_itf;
+  int32_t const nbytes = (int32_t) (intptr_t) param;
+  TU_VERIFY(p_msc->stage == MSC_STAGE_DATA && p_msc->io_busy,);
+
+  if (is_read_cmd(p_msc->cbw.command[0])) {
+    if (proc_read10_io_done(p_msc->rhport, p_msc, nbytes)) {
+      proc_read10_io_start(p_msc->rhport, p_msc);
+    }
+  } else if (is_write_cmd(p_msc->cbw.command[0])) {
+    if (proc_write10_io_done(p_msc->rhport, p_msc, nbytes)) {
+      proc_write10_io_start(p_msc->rhport, p_msc);
+    }
+  }
+  proc_status_stage(p_msc->rhport, p_msc);
+}
+
+bool tud_msc_media_ready(uint8_t lun, bool in_isr) {
+  bool ret = false;
+  #if CFG_TUD_UAS
+  ret = uasd_media_ready(lun, in_isr);
+  #endif
+  if (_mscd_itf.io_wait && _mscd_itf.cbw.lun == lun) {
+    usbd_defer_func(proc_io_retry, NULL, in_isr);
+    ret = true;
+  }
+  return ret;
+}
+
+void mscd_sof(uint8_t rhport, uint32_t frame_count) {
+  (void) rhport;
+  (void) frame_count;
+  if (_mscd_itf.io_wait) {
+    usbd_defer_func(proc_io_retry, NULL, true);
+  }
+}
+
+bool tud_msc_async_read_done(int32_t nbytes, bool in_isr) {
+  TU_VERIFY(is_read_cmd(_mscd_itf.cbw.command[0]) && _mscd_itf.io_busy);
+  usbd_defer_func(proc_io_async_done, (void*) (intptr_t) nbytes, in_isr);
+  return true;
+}
+
+bool tud_msc_async_write_done(int32_t nbytes, bool in_isr) {
+  TU_VERIFY(is_write_cmd(_mscd_itf.cbw.command[0]) && _mscd_itf.io_busy);
+  usbd_defer_func(proc_io_async_done, (void*) (intptr_t) nbytes, in_isr);
+  return true;
+}
+
 static void proc_read10_cmd(uint8_t rhport, mscd_interface_t* p_msc) {
+  ring_reset(p_msc);
+  if (!proc_read10_mapped(rhport, p_msc)) {
+    proc_read10_io_start(rhport, p_msc);
+  }
+}
+
+// memory-mapped media: send rest of data straight from application memory, false to read into buffers instead
+static bool proc_read10_mapped(uint8_t rhport, mscd_interface_t* p_msc) {
+  msc_cbw_t const* p_cbw = &p_msc->cbw;
+  uint32_t const block_sz = rdwr_get_blocksize(p_cbw);
+  uint64_t const lba = rdwr_get_lba(p_cbw->command) + (p_msc->xferred_len / block_sz);
+  uint32_t const offset = p_msc->xferred_len % block_sz;
+
+  void const* buffer = NULL;
+  int32_t const nbytes = mscd_media_read_ptr(p_cbw->lun, lba, offset, &buffer, p_cbw->total_bytes - p_msc->xferred_len);
+
+  p_msc->mapped = (nbytes > 0) && (mscd_xfer_mapped(rhport, p_msc->ep_in, buffer, (uint32_t) nbytes) > 0);
+  p_msc->usb_busy = p_msc->mapped;
+  return p_msc->mapped;
+}
+
+// send oldest filled buffer to host
+static void proc_read10_xfer_start(uint8_t rhport, mscd_interface_t* p_msc) {
+  if (p_msc->usb_busy || p_msc->ring_count == 0) {
+    return;
+  }
+  uint8_t const idx = p_msc->ring_head;
+  p_msc->usb_busy = true;
+  TU_ASSERT(usbd_edpt_xfer(rhport, p_msc->ep_in, _mscd_epbuf[idx].buf, p_msc->ring_len[idx]),);
+}
+
+static void proc_read10_xfer_done(uint8_t rhport, mscd_interface_t* p_msc, uint32_t xferred_bytes) {
+  p_msc->usb_busy = false;
+  p_msc->xferred_len += xferred_bytes;
+  if (p_msc->mapped) {
+    p_msc->io_len = p_msc->xferred_len;
+  } else {
+    p_msc->ring_head = (uint8_t) ((p_msc->ring_head + 1) % CFG_TUD_MSC_EP_BUF_COUNT);
+    p_msc->ring_count--;
+  }
+
+  if (p_msc->xferred_len >= p_msc->total_len) {
+    // Data Stage is complete
+    p_msc->stage = MSC_STAGE_STATUS;
+  } else if (!p_msc->mapped || !proc_read10_mapped(rhport, p_msc)) {
+    proc_read10_xfer_start(rhport, p_msc);
+    proc_read10_io_start(rhport, p_msc);
+  }
+}
+
+// read next chunks from media into free buffers
+static void proc_read10_io_start(uint8_t rhport, mscd_interface_t* p_msc) {
   msc_cbw_t const* p_cbw = &p_msc->cbw;
 
   // block size already verified not zero
-  uint16_t const block_sz = rdwr10_get_blocksize(p_cbw);
+  uint32_t const block_sz = rdwr_get_blocksize(p_cbw);
 
-  // Adjust lba with transferred bytes
-  uint32_t const lba = rdwr10_get_lba(p_cbw->command) + (p_msc->xferred_len / block_sz);
+  while (!p_msc->io_busy && p_msc->ring_count < CFG_TUD_MSC_EP_BUF_COUNT && p_msc->io_len < p_cbw->total_bytes) {
+    // Adjust lba with bytes read so far
+    uint64_t const lba = rdwr_get_lba(p_cbw->command) + (p_msc->io_len / block_sz);
 
-  // remaining bytes capped at class buffer
-  int32_t nbytes = (int32_t)tu_min32(CFG_TUD_MSC_EP_BUFSIZE, p_cbw->total_bytes - p_msc->xferred_len);
+    // remaining bytes capped at class buffer
+    uint32_t const nbytes = tu_min32(CFG_TUD_MSC_EP_BUFSIZE, p_cbw->total_bytes - p_msc->io_len);
 
-  // Application can consume smaller bytes
-  uint32_t const offset = p_msc->xferred_len % block_sz;
-  nbytes = tud_msc_read10_cb(p_cbw->lun, lba, offset, _mscd_epbuf.buf, (uint32_t)nbytes);
+    // Application can consume smaller bytes
+    uint32_t const offset = p_msc->io_len % block_sz;
+    uint8_t const idx = (uint8_t) ((p_msc->ring_head + p_msc->ring_count) % CFG_TUD_MSC_EP_BUF_COUNT);
+
+    p_msc->io_busy = true;
+    int32_t const result = mscd_media_read(p_cbw->lun, lba, offset, _mscd_epbuf[idx].buf, nbytes);
+    if (result == TUD_MSC_RET_ASYNC || !proc_read10_io_done(rhport, p_msc, result)) {
+      return;
+    }
+  }
+}
+
+// return true if next chunk can be read
+static bool proc_read10_io_done(uint8_t rhport, mscd_interface_t* p_msc, int32_t nbytes) {
+  msc_cbw_t const* p_cbw = &p_msc->cbw;
+  p_msc->io_busy = false;
 
   if (nbytes < 0) {
     // negative means error -> endpoint is stalled & status in CSW set to failed
@@ -775,14 +1340,38 @@ static void proc_read10_cmd(uint8_t rhport, mscd_interface_t* p_msc) {
     set_sense_medium_not_present(p_cbw->lun);
 
     fail_scsi_op(rhport, p_msc, MSC_CSW_STATUS_FAILED);
+    return false;
   } else if (nbytes == 0) {
-    // zero means not ready -> simulate an transfer complete so that this driver callback will fired again
-    dcd_event_xfer_complete(rhport, p_msc->ep_in, 0, XFER_RESULT_SUCCESS, false);
+    // zero means not ready -> callback is invoked again later on with the same parameters
+    io_wait_start(p_msc);
+    return false;
   } else {
-    TU_ASSERT(usbd_edpt_xfer(rhport, p_msc->ep_in, _mscd_epbuf.buf, (uint16_t) nbytes),);
+    uint8_t const idx = (uint8_t) ((p_msc->ring_head + p_msc->ring_count) % CFG_TUD_MSC_EP_BUF_COUNT);
+    p_msc->ring_len[idx] = (uint16_t) tu_min32((uint32_t) nbytes, CFG_TUD_MSC_EP_BUFSIZE);
+    p_msc->ring_count++;
+    p_msc->io_len += p_msc->ring_len[idx];
+
+    proc_read10_xfer_start(rhport, p_msc);
+    return true;
   }
 }
 
+// receive next chunk from host into a free buffer
+static void proc_write10_xfer_start(uint8_t rhport, mscd_interface_t* p_msc) {
+  msc_cbw_t const* p_cbw = &p_msc->cbw;
+  if (p_msc->usb_busy || p_msc->ring_count >= CFG_TUD_MSC_EP_BUF_COUNT || p_msc->io_len >= p_cbw->total_bytes) {
+    return;
+  }
+
+  // remaining bytes capped at class buffer
+  uint16_t const nbytes = (uint16_t) tu_min32(CFG_TUD_MSC_EP_BUFSIZE, p_cbw->total_bytes - p_msc->io_len);
+  uint8_t const idx = (uint8_t) ((p_msc->ring_head + p_msc->ring_count) % CFG_TUD_MSC_EP_BUF_COUNT);
+
+  // Write10 callback will be called later when usb transfer complete
+  p_msc->usb_busy = true;
+  TU_ASSERT(usbd_edpt_xfer(rhport, p_msc->ep_out, _mscd_epbuf[idx].buf, nbytes),);
+}
+
 static void proc_write10_cmd(uint8_t rhport, mscd_interface_t* p_msc) {
   msc_cbw_t const* p_cbw = &p_msc->cbw;
   bool writable = true;
@@ -799,61 +1388,91 @@ static void proc_write10_cmd(uint8_t rhport, mscd_interface_t* p_msc) {
     return;
   }
 
-  // remaining bytes capped at class buffer
-  uint16_t nbytes = (uint16_t)tu_min32(CFG_TUD_MSC_EP_BUFSIZE, p_cbw->total_bytes - p_msc->xferred_len);
-
-  // Write10 callback will be called later when usb transfer complete
-  TU_ASSERT(usbd_edpt_xfer(rhport, p_msc->ep_out, _mscd_epbuf.buf, nbytes),);
+  ring_reset(p_msc);
+  proc_write10_xfer_start(rhport, p_msc);
 }
 
 // process new data arrived from WRITE10
 static void proc_write10_new_data(uint8_t rhport, mscd_interface_t* p_msc, uint32_t xferred_bytes) {
+  uint8_t const idx = (uint8_t) ((p_msc->ring_head + p_msc->ring_count) % CFG_TUD_MSC_EP_BUF_COUNT);
+  p_msc->usb_busy = false;
+  p_msc->ring_len[idx] = (uint16_t) xferred_bytes;
+  p_msc->ring_count++;
+  p_msc->io_len += xferred_bytes;
+
+  // keep host busy while media is written
+  proc_write10_xfer_start(rhport, p_msc);
+  proc_write10_io_start(rhport, p_msc);
+}
+
+// write received buffers to media, oldest first
+static void proc_write10_io_start(uint8_t rhport, mscd_interface_t* p_msc) {
   msc_cbw_t const* p_cbw = &p_msc->cbw;
 
   // block size already verified not zero
-  uint16_t const block_sz = rdwr10_get_blocksize(p_cbw);
+  uint32_t const block_sz = rdwr_get_blocksize(p_cbw);
 
-  // Adjust lba with transferred bytes
-  uint32_t const lba = rdwr10_get_lba(p_cbw->command) + (p_msc->xferred_len / block_sz);
+  while (!p_msc->io_busy && p_msc->ring_count > 0) {
+    // Adjust lba with transferred bytes
+    uint64_t const lba = rdwr_get_lba(p_cbw->command) + (p_msc->xferred_len / block_sz);
 
-  // Invoke callback to consume new data
-  uint32_t const offset = p_msc->xferred_len % block_sz;
-  int32_t nbytes = tud_msc_write10_cb(p_cbw->lun, lba, offset, _mscd_epbuf.buf, xferred_bytes);
+    // Invoke callback to consume new data
+    uint32_t const offset = p_msc->xferred_len % block_sz;
+    uint8_t const idx = p_msc->ring_head;
+
+    p_msc->io_busy = true;
+    int32_t const result = mscd_media_write(p_cbw->lun, lba, offset, _mscd_epbuf[idx].buf + p_msc->ring_ofs,
+                                       (uint32_t) (p_msc->ring_len[idx] - p_msc->ring_ofs));
+    if (result == TUD_MSC_RET_ASYNC || !proc_write10_io_done(rhport, p_msc, result)) {
+      return;
+    }
+  }
+}
+
+// return true if more data can be written
+static bool proc_write10_io_done(uint8_t rhport, mscd_interface_t* p_msc, int32_t nbytes) {
+  msc_cbw_t const* p_cbw = &p_msc->cbw;
+  uint8_t const idx = p_msc->ring_head;
+  uint16_t const remain = (uint16_t) (p_msc->ring_len[idx] - p_msc->ring_ofs);
+  p_msc->io_busy = false;
 
   if (nbytes < 0) {
     // negative means error -> failed this scsi op
     TU_LOG_DRV("  tud_msc_write10_cb() return -1\r\n");
 
     // update actual byte before failed
-    p_msc->xferred_len += xferred_bytes;
+    p_msc->xferred_len += remain;
 
     // Set sense
     set_sense_medium_not_present(p_cbw->lun);
 
     fail_scsi_op(rhport, p_msc, MSC_CSW_STATUS_FAILED);
+    return false;
+  } else if (nbytes == 0) {
+    // zero means not ready -> callback is invoked again later on with the same parameters
+    io_wait_start(p_msc);
+    return false;
   } else {
-    // Application consume less than what we got (including zero)
-    if ((uint32_t)nbytes < xferred_bytes) {
-      uint32_t const left_over = xferred_bytes - (uint32_t)nbytes;
-      if (nbytes > 0) {
-        p_msc->xferred_len += (uint16_t)nbytes;
-        memmove(_mscd_epbuf.buf, _mscd_epbuf.buf + nbytes, left_over);
-      }
-
-      // simulate an transfer complete with adjusted parameters --> callback will be invoked with adjusted parameter
-      dcd_event_xfer_complete(rhport, p_msc->ep_out, left_over, XFER_RESULT_SUCCESS, false);
-    } else {
-      // Application consume all bytes in our buffer
-      p_msc->xferred_len += xferred_bytes;
+    // Application can consume less than what we got: remaining is passed to the next callback
+    uint16_t const consumed = (uint16_t) tu_min32((uint32_t) nbytes, remain);
+    p_msc->xferred_len += consumed;
+    p_msc->ring_ofs = (uint16_t) (p_msc->ring_ofs + consumed);
+
+    if (p_msc->ring_ofs >= p_msc->ring_len[idx]) {
+      p_msc->ring_ofs = 0;
+      p_msc->ring_head = (uint8_t) ((p_msc->ring_head + 1) % CFG_TUD_MSC_EP_BUF_COUNT);
+      p_msc->ring_count--;
+    }
 
-      if (p_msc->xferred_len >= p_msc->total_len) {
-        // Data Stage is complete
-        p_msc->stage = MSC_STAGE_STATUS;
-      } else {
-        // prepare to receive more data from host
-        proc_write10_cmd(rhport, p_msc);
-      }
+    if (p_msc->xferred_len >= p_msc->total_len) {
+      // Data Stage is complete
+      p_msc->stage = MSC_STAGE_STATUS;
+      return false;
     }
+
+    // prepare to receive more data from host
+    proc_write10_xfer_start(rhport, p_msc);
+    return true;
   }
 }
 
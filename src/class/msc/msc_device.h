@@ -50,6 +50,39 @@
 
 TU_VERIFY_STATIC(CFG_TUD_MSC_EP_BUFSIZE < UINT16_MAX, "Size is not correct");
 
+// Number of CFG_TUD_MSC_EP_BUFSIZE buffers for READ10/WRITE10. With 2 or more, media access of the next chunk
+// overlaps USB transfer of the current one, best used with asynchronous callbacks (TUD_MSC_RET_ASYNC)
+#ifndef CFG_TUD_MSC_EP_BUF_COUNT
+  #define CFG_TUD_MSC_EP_BUF_COUNT  1
+#endif
+
+TU_VERIFY_STATIC(CFG_TUD_MSC_EP_BUF_COUNT > 0 && CFG_TUD_MSC_EP_BUF_COUNT < UINT8_MAX, "Count is not correct");
+
+// Optional block cache between READ/WRITE commands and media callbacks: number of lines, 0 to disable. A line holds
+// CFG_TUD_MSC_CACHE_LINE_BLOCKS consecutive blocks, set it to flash erase size so that write-back of a line is one
+// write per erase block. Sequential read fills the rest of line ahead. Dirty lines are written back on eviction,
+// once fully written, on SYNCHRONIZE CACHE, START STOP UNIT or tud_msc_cache_flush().
+// Media callbacks must complete synchronously and all LUNs must use CFG_TUD_MSC_CACHE_BLOCK_SIZE blocks.
+#ifndef CFG_TUD_MSC_CACHE_LINES
+  #define CFG_TUD_MSC_CACHE_LINES        0
+#endif
+
+#ifndef CFG_TUD_MSC_CACHE_LINE_BLOCKS
+  #define CFG_TUD_MSC_CACHE_LINE_BLOCKS  8
+#endif
+
+#ifndef CFG_TUD_MSC_CACHE_BLOCK_SIZE
+  #define CFG_TUD_MSC_CACHE_BLOCK_SIZE   512
+#endif
+
+TU_VERIFY_STATIC(CFG_TUD_MSC_CACHE_LINE_BLOCKS > 0 && CFG_TUD_MSC_CACHE_LINE_BLOCKS <= 32, "Line blocks is not correct");
+
+// Return value of tud_msc_read10_cb() and tud_msc_write10_cb() other than byte count
+enum {
+  TUD_MSC_RET_ERROR = -1,
+  TUD_MSC_RET_ASYNC = -2, // operation is started, application calls tud_msc_async_read/write_done() when complete
+};
+
 //--------------------------------------------------------------------+
 // Application API
 //--------------------------------------------------------------------+
@@ -57,6 +90,23 @@ TU_VERIFY_STATIC(CFG_TUD_MSC_EP_BUFSIZE < UINT16_MAX, "Size is not correct");
 // Set SCSI sense response
 bool tud_msc_set_sense(uint8_t lun, uint8_t sense_key, uint8_t add_sense_code, uint8_t add_sense_qualifier);
 
+// Complete a READ10/WRITE10 callback that returned TUD_MSC_RET_ASYNC, nbytes has the same meaning as callback return
+// value (byte count, 0 for busy or negative for error). Can be called from ISR e.g DMA complete.
+bool tud_msc_async_read_done(int32_t nbytes, bool in_isr);
+bool tud_msc_async_write_done(int32_t nbytes, bool in_isr);
+
+// Notify media of lun which returned busy (0) from READ10/WRITE10 callback is ready again. Callback is then retried
+// right away instead of on the next (micro)frame. Can be called from ISR.
+bool tud_msc_media_ready(uint8_t lun, bool in_isr);
+
+#if CFG_TUD_MSC_CACHE_LINES
+// Write back dirty cached blocks of lun, return false if media is busy or failed
+bool tud_msc_cache_flush(uint8_t lun);
+
+// Drop all cached blocks of lun without writing them back e.g medium is changed
+void tud_msc_cache_invalidate(uint8_t lun);
+#endif
+
 //--------------------------------------------------------------------+
 // Application Callbacks (WEAK is optional)
 //--------------------------------------------------------------------+
@@ -69,10 +119,13 @@ bool tud_msc_set_sense(uint8_t lun, uint8_t sense_key, uint8_t add_sense_code, u
 //   - read < bufsize : These bytes are transferred first and callback invoked again for remaining data.
 //
 //   - read == 0      : Indicate application is not ready yet e.g disk I/O busy.
-//                      Callback invoked again with the same parameters later on.
+//                      Callback invoked again with the same parameters on next SOF or tud_msc_media_ready().
 //
 //   - read < 0       : Indicate application error e.g invalid address. This request will be STALLed
 //                      and return failed status in command status wrapper phase.
+//
+//   - TUD_MSC_RET_ASYNC : Read is started e.g by DMA, buffer is filled until tud_msc_async_read_done().
+//                      With CFG_TUD_MSC_EP_BUF_COUNT > 1, previous chunk is transferred to host meanwhile.
 int32_t tud_msc_read10_cb (uint8_t lun, uint32_t lba, uint32_t offset, void* buffer, uint32_t bufsize);
 
 // Invoked when received SCSI WRITE10 command
@@ -80,14 +133,18 @@ int32_t tud_msc_read10_cb (uint8_t lun, uint32_t lba, uint32_t offset, void* buf
 //   - offset is only needed if CFG_TUD_MSC_EP_BUFSIZE is smaller than BLOCK_SIZE.
 //
 // - Application write data from buffer to address contents (up to bufsize) and return number of written byte. If
-//   - write < bufsize : callback invoked again with remaining data later on.
+//   - write < bufsize : callback invoked again right away with buffer advancing past written bytes (no copy),
+//                       e.g flash backend can accept one page per call.
 //
 //   - write == 0      : Indicate application is not ready yet e.g disk I/O busy.
-//                       Callback invoked again with the same parameters later on.
+//                       Callback invoked again with the same parameters on next SOF or tud_msc_media_ready().
 //
 //   - write < 0       : Indicate application error e.g invalid address. This request will be STALLed
 //                       and return failed status in command status wrapper phase.
 //
+//   - TUD_MSC_RET_ASYNC : Write is started, buffer must stay untouched until tud_msc_async_write_done().
+//                       With CFG_TUD_MSC_EP_BUF_COUNT > 1, next chunk is received from host meanwhile.
+//
 // TODO change buffer to const uint8_t*
 int32_t tud_msc_write10_cb (uint8_t lun, uint32_t lba, uint32_t offset, uint8_t* buffer, uint32_t bufsize);
 
@@ -123,6 +180,25 @@ int32_t tud_msc_scsi_cb (uint8_t lun, uint8_t const scsi_cmd[16], void* buffer,
 
 /*------------- Optional callbacks -------------*/
 
+// Invoked instead of tud_msc_read10_cb() for both READ10 and READ16 if defined, required for LBA beyond 32-bit.
+// Same parameters and return values except 64-bit lba
+TU_ATTR_WEAK int32_t tud_msc_read16_cb(uint8_t lun, uint64_t lba, uint32_t offset, void* buffer, uint32_t bufsize);
+
+// Invoked before tud_msc_read10_cb() for both READ10 and READ16 if defined, for memory-mapped media e.g RAM disk or
+// XIP flash. Set *buffer to memory holding data of lba * BLOCK_SIZE + offset and return number of bytes available
+// there (up to bufsize which is the rest of the command). Data is sent straight from that memory without copy and
+// CFG_TUD_MSC_EP_BUFSIZE limit: it must be reachable by the USB controller (DMA) and stay valid until the transfer is
+// complete. Beyond 64KB per transfer requires CFG_TUD_EDPT_XFER_EX, otherwise callback is invoked again for the rest.
+// Return 0 to read this chunk with tud_msc_read10_cb() instead.
+TU_ATTR_WEAK int32_t tud_msc_read10_ptr_cb(uint8_t lun, uint64_t lba, uint32_t offset, void const** buffer, uint32_t bufsize);
+
+// Invoked instead of tud_msc_write10_cb() for both WRITE10 and WRITE16 if defined
+TU_ATTR_WEAK int32_t tud_msc_write16_cb(uint8_t lun, uint64_t lba, uint32_t offset, uint8_t* buffer, uint32_t bufsize);
+
+// Invoked instead of tud_msc_capacity_cb() if defined, for media with more than 2^32 blocks. READ CAPACITY (10)
+// then reports all ones as last LBA so that host switches to READ CAPACITY (16) and READ16/WRITE16
+TU_ATTR_WEAK void tud_msc_capacity16_cb(uint8_t lun, uint64_t* block_count, uint32_t* block_size);
+
 // Invoked when received GET_MAX_LUN request, required for multiple LUNs implementation
 TU_ATTR_WEAK uint8_t tud_msc_get_maxlun_cb(void);
 
@@ -149,6 +225,18 @@ TU_ATTR_WEAK void tud_msc_scsi_complete_cb(uint8_t lun, uint8_t const scsi_cmd[1
 // Invoked to check if device is writable as part of SCSI WRITE10
 TU_ATTR_WEAK bool tud_msc_is_writable_cb(uint8_t lun);
 
+// Invoked when received UNMAP if defined, once per block range: host does not need the data anymore (e.g deleted
+// files) so that flash translation layer can erase it ahead of time. Logical block provisioning is then reported in
+// READ CAPACITY (16) and Block Limits/Logical Block Provisioning VPD pages.
+// Return false to fail the command, sense is set to medium not present if not set by callback
+TU_ATTR_WEAK bool tud_msc_unmap_cb(uint8_t lun, uint64_t lba, uint32_t block_count);
+
+// Invoked when received WRITE SAME (10/16) if defined: write buffer (one block) to all block_count blocks from lba.
+// If unmap is true, blocks can be unmapped instead as long as they read back the same data e.g buffer is all zeros.
+// Return false to fail the command, sense is set to medium not present if not set by callback
+TU_ATTR_WEAK bool tud_msc_write_same_cb(uint8_t lun, uint64_t lba, uint32_t block_count, uint8_t const* buffer,
+                                        uint32_t block_size, bool unmap);
+
 //--------------------------------------------------------------------+
 // Internal Class Driver API
 //--------------------------------------------------------------------+
@@ -158,6 +246,26 @@ void     mscd_reset           (uint8_t rhport);
 uint16_t mscd_open            (uint8_t rhport, tusb_desc_interface_t const * itf_desc, uint16_t max_len);
 bool     mscd_control_xfer_cb (uint8_t rhport, uint8_t stage, tusb_control_request_t const * p_request);
 bool     mscd_xfer_cb         (uint8_t rhport, uint8_t ep_addr, xfer_result_t event, uint32_t xferred_bytes);
+void     mscd_sof             (uint8_t rhport, uint32_t frame_count);
+
+// SCSI layer shared with UAS transport (uas_device.c)
+void     mscd_get_capacity    (uint8_t lun, uint64_t* block_count, uint32_t* block_size);
+int32_t  mscd_scsi_cmd        (uint8_t lun, uint8_t const scsi_cmd[16], uint8_t* buffer, uint32_t bufsize, uint16_t app_bufsize);
+int32_t  mscd_scsi_sense      (uint8_t lun, uint8_t* buffer, uint32_t bufsize);
+uint32_t mscd_scsi_out_len    (uint8_t lun, uint8_t const scsi_cmd[16]);
+int32_t  mscd_scsi_out        (uint8_t lun, uint8_t const scsi_cmd[16], uint8_t* buffer, uint32_t bufsize);
+int32_t  mscd_media_read      (uint8_t lun, uint64_t lba, uint32_t offset, void* buffer, uint32_t bufsize);
+int32_t  mscd_media_write     (uint8_t lun, uint64_t lba, uint32_t offset, uint8_t* buffer, uint32_t bufsize);
+int32_t  mscd_media_read_ptr  (uint8_t lun, uint64_t lba, uint32_t offset, void const** buffer, uint32_t bufsize);
+uint32_t mscd_xfer_mapped     (uint8_t rhport, uint8_t ep_in, void const* buffer, uint32_t len);
+int32_t  mscd_media_read_cb   (uint8_t lun, uint64_t lba, uint32_t offset, void* buffer, uint32_t bufsize);
+int32_t  mscd_media_write_cb  (uint8_t lun, uint64_t lba, uint32_t offset, uint8_t* buffer, uint32_t bufsize);
+
+// Block cache (msc_cache.c): return value as media callback, flush returns 1 when done
+int32_t  mscd_cache_read      (uint8_t lun, uint64_t lba, uint32_t offset, uint8_t* buffer, uint32_t bufsize);
+int32_t  mscd_cache_write     (uint8_t lun, uint64_t lba, uint32_t offset, uint8_t const* buffer, uint32_t bufsize);
+int32_t  mscd_cache_flush     (uint8_t lun);
+void     mscd_cache_discard   (uint8_t lun, uint64_t lba, uint64_t block_count);
 
 #ifdef __cplusplus
  }
@@ -32,6 +32,7 @@
 #include "host/usbh_pvt.h"
 
 #include "msc_host.h"
+#include "msc_passthrough.h"
 
 // Level where CFG_TUSB_DEBUG must be at least for this driver is logged
 #ifndef CFG_TUH_MSC_LOG_LEVEL
@@ -50,6 +51,13 @@ enum {
   MSC_STAGE_STATUS,
 };
 
+typedef struct {
+  msc_cbw_t cbw;
+  void* buffer;
+  tuh_msc_complete_cb_t complete_cb;
+  uintptr_t complete_arg;
+} msch_cmd_t;
+
 typedef struct {
   uint8_t itf_num;
   uint8_t ep_in;
@@ -65,9 +73,17 @@ typedef struct {
   tuh_msc_complete_cb_t complete_cb;
   uintptr_t complete_arg;
 
+#if CFG_TUH_MSC_CMD_QUEUE
+  // pending commands, started by usbh task back-to-back as soon as previous one is complete
+  tu_fifo_t cmd_ff;
+  msch_cmd_t cmd_ff_buf[CFG_TUH_MSC_CMD_QUEUE];
+  volatile bool kick_pending;
+#endif
+
   struct {
     uint32_t block_size;
-    uint32_t block_count;
+    uint64_t block_count;
+    uint32_t xfer_blocks; // preferred blocks per READ/WRITE from Block Limits VPD, 0 if not reported
   } capacity[CFG_TUH_MSC_MAXLUN];
 } msch_interface_t;
 
@@ -96,6 +112,11 @@ uint8_t tuh_msc_get_maxlun(uint8_t dev_addr) {
 }
 
 uint32_t tuh_msc_get_block_count(uint8_t dev_addr, uint8_t lun) {
+  msch_interface_t* p_msc = get_itf(dev_addr);
+  return (uint32_t) TU_MIN(p_msc->capacity[lun].block_count, UINT32_MAX);
+}
+
+uint64_t tuh_msc_get_block_count64(uint8_t dev_addr, uint8_t lun) {
   msch_interface_t* p_msc = get_itf(dev_addr);
   return p_msc->capacity[lun].block_count;
 }
@@ -105,6 +126,17 @@ uint32_t tuh_msc_get_block_size(uint8_t dev_addr, uint8_t lun) {
   return p_msc->capacity[lun].block_size;
 }
 
+uint32_t tuh_msc_get_max_xfer_blocks(uint8_t dev_addr, uint8_t lun) {
+  msch_interface_t* p_msc = get_itf(dev_addr);
+  uint32_t const block_size = p_msc->capacity[lun].block_size;
+  TU_VERIFY(block_size, 0);
+
+  // data stage of a command is a single bulk transfer with 16-bit length
+  uint32_t const count = UINT16_MAX / block_size;
+  uint32_t const xfer_blocks = p_msc->capacity[lun].xfer_blocks;
+  return (xfer_blocks && xfer_blocks < count) ? xfer_blocks : count;
+}
+
 bool tuh_msc_mounted(uint8_t dev_addr) {
   msch_interface_t* p_msc = get_itf(dev_addr);
   return p_msc->mounted;
@@ -112,9 +144,20 @@ bool tuh_msc_mounted(uint8_t dev_addr) {
 
 bool tuh_msc_ready(uint8_t dev_addr) {
   msch_interface_t* p_msc = get_itf(dev_addr);
+#if CFG_TUH_MSC_CMD_QUEUE
+  return p_msc->mounted && !tu_fifo_full(&p_msc->cmd_ff);
+#else
   return p_msc->mounted && !usbh_edpt_busy(dev_addr, p_msc->ep_in) && !usbh_edpt_busy(dev_addr, p_msc->ep_out);
+#endif
 }
 
+#if CFG_TUH_MSC_CMD_QUEUE
+uint8_t tuh_msc_queued_count(uint8_t dev_addr) {
+  msch_interface_t* p_msc = get_itf(dev_addr);
+  return (uint8_t) tu_fifo_count(&p_msc->cmd_ff);
+}
+#endif
+
 //--------------------------------------------------------------------+
 // PUBLIC API: SCSI COMMAND
 //--------------------------------------------------------------------+
@@ -125,22 +168,22 @@ static inline void cbw_init(msc_cbw_t* cbw, uint8_t lun) {
   cbw->lun       = lun;
 }
 
-bool tuh_msc_scsi_command(uint8_t daddr, msc_cbw_t const* cbw, void* data,
-                          tuh_msc_complete_cb_t complete_cb, uintptr_t arg) {
+// Send CBW of command, data and status stages are carried out by msch_xfer_cb()
+static bool cmd_start(uint8_t daddr, msch_cmd_t const* cmd) {
   msch_interface_t* p_msc = get_itf(daddr);
-  TU_VERIFY(p_msc->configured);
 
   // claim endpoint
   TU_VERIFY(usbh_edpt_claim(daddr, p_msc->ep_out));
   msch_epbuf_t* epbuf = get_epbuf(daddr);
 
-  epbuf->cbw = *cbw;
-  p_msc->buffer = data;
-  p_msc->complete_cb = complete_cb;
-  p_msc->complete_arg = arg;
+  epbuf->cbw = cmd->cbw;
+  p_msc->buffer = cmd->buffer;
+  p_msc->complete_cb = cmd->complete_cb;
+  p_msc->complete_arg = cmd->complete_arg;
   p_msc->stage = MSC_STAGE_CMD;
 
   if (!usbh_edpt_xfer(daddr, p_msc->ep_out, (uint8_t*) &epbuf->cbw, sizeof(msc_cbw_t))) {
+    p_msc->stage = MSC_STAGE_IDLE;
     usbh_edpt_release(daddr, p_msc->ep_out);
     return false;
   }
@@ -148,6 +191,73 @@ bool tuh_msc_scsi_command(uint8_t daddr, msc_cbw_t const* cbw, void* data,
   return true;
 }
 
+#if CFG_TUH_MSC_CMD_QUEUE
+// Start next queued command, commands that cannot be started are completed with failed status
+static void cmd_queue_next(uint8_t daddr) {
+  msch_interface_t* p_msc = get_itf(daddr);
+  msch_cmd_t cmd;
+
+  while (tu_fifo_read(&p_msc->cmd_ff, &cmd)) {
+    if (cmd_start(daddr, &cmd)) {
+      return;
+    }
+
+    TU_LOG_DRV("  MSCh failed to start queued command\r\n");
+    if (cmd.complete_cb) {
+      msc_csw_t const csw = {
+          .signature    = MSC_CSW_SIGNATURE,
+          .tag          = cmd.cbw.tag,
+          .data_residue = cmd.cbw.total_bytes,
+          .status       = MSC_CSW_STATUS_FAILED
+      };
+      tuh_msc_complete_data_t const cb_data = {
+          .cbw = &cmd.cbw,
+          .csw = &csw,
+          .scsi_data = cmd.buffer,
+          .user_arg = cmd.complete_arg
+      };
+      cmd.complete_cb(daddr, &cb_data);
+    }
+  }
+}
+
+// Deferred to usbh task: start queued command if device is idle
+static void cmd_queue_kick(void* param) {
+  uint8_t const daddr = (uint8_t) (uintptr_t) param;
+  msch_interface_t* p_msc = get_itf(daddr);
+
+  p_msc->kick_pending = false;
+  if (p_msc->configured && p_msc->stage == MSC_STAGE_IDLE) {
+    cmd_queue_next(daddr);
+  }
+}
+#endif
+
+bool tuh_msc_scsi_command(uint8_t daddr, msc_cbw_t const* cbw, void* data,
+                          tuh_msc_complete_cb_t complete_cb, uintptr_t arg) {
+  msch_interface_t* p_msc = get_itf(daddr);
+  TU_VERIFY(p_msc->configured);
+
+  msch_cmd_t const cmd = {
+      .cbw = *cbw,
+      .buffer = data,
+      .complete_cb = complete_cb,
+      .complete_arg = arg
+  };
+
+#if CFG_TUH_MSC_CMD_QUEUE
+  // Command is always queued and started by usbh task, which is the only one changing stage
+  TU_VERIFY(tu_fifo_write(&p_msc->cmd_ff, &cmd));
+  if (!p_msc->kick_pending) {
+    p_msc->kick_pending = true;
+    usbh_defer_func(cmd_queue_kick, (void*) (uintptr_t) daddr, false);
+  }
+  return true;
+#else
+  return cmd_start(daddr, &cmd);
+#endif
+}
+
 bool tuh_msc_read_capacity(uint8_t dev_addr, uint8_t lun, scsi_read_capacity10_resp_t* response,
                            tuh_msc_complete_cb_t complete_cb, uintptr_t arg) {
   msch_interface_t* p_msc = get_itf(dev_addr);
@@ -164,6 +274,28 @@ bool tuh_msc_read_capacity(uint8_t dev_addr, uint8_t lun, scsi_read_capacity10_r
   return tuh_msc_scsi_command(dev_addr, &cbw, response, complete_cb, arg);
 }
 
+bool tuh_msc_read_capacity16(uint8_t dev_addr, uint8_t lun, scsi_read_capacity16_resp_t* response,
+                             tuh_msc_complete_cb_t complete_cb, uintptr_t arg) {
+  msch_interface_t* p_msc = get_itf(dev_addr);
+  TU_VERIFY(p_msc->configured);
+
+  msc_cbw_t cbw;
+  cbw_init(&cbw, lun);
+
+  cbw.total_bytes = sizeof(scsi_read_capacity16_resp_t);
+  cbw.dir         = TUSB_DIR_IN_MASK;
+  cbw.cmd_len     = sizeof(scsi_read_capacity16_t);
+
+  scsi_read_capacity16_t const cmd_read_capa16 = {
+      .cmd_code       = SCSI_CMD_SERVICE_ACTION_IN_16,
+      .service_action = SCSI_SERVICE_ACTION_READ_CAPACITY_16,
+      .alloc_length   = tu_htonl(sizeof(scsi_read_capacity16_resp_t))
+  };
+  memcpy(cbw.command, &cmd_read_capa16, cbw.cmd_len);
+
+  return tuh_msc_scsi_command(dev_addr, &cbw, response, complete_cb, arg);
+}
+
 bool tuh_msc_inquiry(uint8_t dev_addr, uint8_t lun, scsi_inquiry_resp_t* response,
                      tuh_msc_complete_cb_t complete_cb, uintptr_t arg) {
   msch_interface_t* p_msc = get_itf(dev_addr);
@@ -185,6 +317,29 @@ bool tuh_msc_inquiry(uint8_t dev_addr, uint8_t lun, scsi_inquiry_resp_t* respons
   return tuh_msc_scsi_command(dev_addr, &cbw, response, complete_cb, arg);
 }
 
+bool tuh_msc_inquiry_vpd(uint8_t dev_addr, uint8_t lun, uint8_t page_code, void* response, uint8_t len,
+                         tuh_msc_complete_cb_t complete_cb, uintptr_t arg) {
+  msch_interface_t* p_msc = get_itf(dev_addr);
+  TU_VERIFY(p_msc->configured);
+
+  msc_cbw_t cbw;
+  cbw_init(&cbw, lun);
+
+  cbw.total_bytes = len;
+  cbw.dir         = TUSB_DIR_IN_MASK;
+  cbw.cmd_len     = sizeof(scsi_inquiry_t);
+
+  scsi_inquiry_t const cmd_inquiry = {
+      .cmd_code     = SCSI_CMD_INQUIRY,
+      .reserved1    = 1, // EVPD
+      .page_code    = page_code,
+      .alloc_length = len
+  };
+  memcpy(cbw.command, &cmd_inquiry, cbw.cmd_len);
+
+  return tuh_msc_scsi_command(dev_addr, &cbw, response, complete_cb, arg);
+}
+
 bool tuh_msc_test_unit_ready(uint8_t dev_addr, uint8_t lun, tuh_msc_complete_cb_t complete_cb, uintptr_t arg) {
   msch_interface_t* p_msc = get_itf(dev_addr);
   TU_VERIFY(p_msc->configured);
@@ -263,6 +418,661 @@ bool tuh_msc_write10(uint8_t dev_addr, uint8_t lun, void const* buffer, uint32_t
   return tuh_msc_scsi_command(dev_addr, &cbw, (void*) (uintptr_t) buffer, complete_cb, arg);
 }
 
+// READ16/WRITE16: 64-bit LBA and 32-bit block count, total bytes is still limited by 32-bit CBW length
+static bool rdwr16_command(uint8_t dev_addr, uint8_t lun, uint8_t cmd_code, void* buffer, uint64_t lba,
+                           uint32_t block_count, tuh_msc_complete_cb_t complete_cb, uintptr_t arg) {
+  msch_interface_t* p_msc = get_itf(dev_addr);
+  TU_VERIFY(p_msc->mounted);
+
+  uint64_t const total_bytes = (uint64_t) block_count * p_msc->capacity[lun].block_size;
+  TU_VERIFY(total_bytes <= UINT32_MAX);
+
+  msc_cbw_t cbw;
+  cbw_init(&cbw, lun);
+
+  cbw.total_bytes = (uint32_t) total_bytes;
+  cbw.dir         = (cmd_code == SCSI_CMD_READ_16) ? TUSB_DIR_IN_MASK : TUSB_DIR_OUT;
+  cbw.cmd_len     = sizeof(scsi_read16_t);
+
+  scsi_read16_t const cmd_rdwr16 = {
+      .cmd_code    = cmd_code,
+      .lba         = tu_htonll(lba),
+      .block_count = tu_htonl(block_count)
+  };
+  memcpy(cbw.command, &cmd_rdwr16, cbw.cmd_len);
+
+  return tuh_msc_scsi_command(dev_addr, &cbw, buffer, complete_cb, arg);
+}
+
+bool tuh_msc_read16(uint8_t dev_addr, uint8_t lun, void* buffer, uint64_t lba, uint32_t block_count,
+                    tuh_msc_complete_cb_t complete_cb, uintptr_t arg) {
+  return rdwr16_command(dev_addr, lun, SCSI_CMD_READ_16, buffer, lba, block_count, complete_cb, arg);
+}
+
+bool tuh_msc_write16(uint8_t dev_addr, uint8_t lun, void const* buffer, uint64_t lba, uint32_t block_count,
+                     tuh_msc_complete_cb_t complete_cb, uintptr_t arg) {
+  return rdwr16_command(dev_addr, lun, SCSI_CMD_WRITE_16, (void*) (uintptr_t) buffer, lba, block_count,
+                        complete_cb, arg);
+}
+
+//--------------------------------------------------------------------+
+// Block Cache
+//--------------------------------------------------------------------+
+#if CFG_TUH_MSC_CACHE_BLOCKS
+
+enum {
+  CACHE_STATE_IDLE = 0,
+  CACHE_STATE_FILL,  // reading blocks into xfer buffer
+  CACHE_STATE_FLUSH, // writing merged dirty blocks from xfer buffer
+  CACHE_STATE_DIRECT // large transfer with application buffer
+};
+
+enum {
+  CACHE_OP_READ = 0,
+  CACHE_OP_WRITE,
+  CACHE_OP_SYNC,
+};
+
+typedef struct {
+  uint32_t lba;
+  uint32_t stamp; // last access, for LRU replacement
+  uint8_t lun;
+  bool valid;
+  bool dirty;
+} msch_cache_slot_t;
+
+typedef struct {
+  msch_cache_slot_t slot[CFG_TUH_MSC_CACHE_BLOCKS];
+  uint32_t clock;
+
+  volatile uint8_t state;
+
+  // pending application operation
+  uint8_t op;
+  uint8_t lun;
+  uint16_t count;
+  uint32_t lba;
+  void* buffer;
+  tuh_msc_complete_cb_t complete_cb;
+  uintptr_t complete_arg;
+
+  // sequential read detection
+  bool sequential;
+  uint8_t next_lun;
+  uint32_t next_lba;
+
+  // blocks in xfer buffer being read or written
+  uint8_t xfer_lun;
+  uint16_t xfer_count;
+  uint32_t xfer_lba;
+  uint8_t xfer_slot[CFG_TUH_MSC_CACHE_XFER_BLOCKS]; // slots being flushed
+} msch_cache_t;
+
+typedef struct {
+  TUH_EPBUF_DEF(xfer, CFG_TUH_MSC_CACHE_XFER_BLOCKS * CFG_TUH_MSC_CACHE_BLOCK_SIZE);
+} msch_cache_epbuf_t;
+
+static msch_cache_t _msch_cache[CFG_TUH_DEVICE_MAX];
+static uint8_t _msch_cache_data[CFG_TUH_DEVICE_MAX][CFG_TUH_MSC_CACHE_BLOCKS][CFG_TUH_MSC_CACHE_BLOCK_SIZE];
+CFG_TUH_MEM_SECTION static msch_cache_epbuf_t _msch_cache_epbuf[CFG_TUH_DEVICE_MAX];
+
+static bool cache_fill_complete(uint8_t dev_addr, tuh_msc_complete_data_t const* cb_data);
+static bool cache_flush_complete(uint8_t dev_addr, tuh_msc_complete_data_t const* cb_data);
+static bool cache_direct_complete(uint8_t dev_addr, tuh_msc_complete_data_t const* cb_data);
+static void cache_run(uint8_t daddr);
+
+TU_ATTR_ALWAYS_INLINE static inline bool cache_usable(uint8_t daddr, uint8_t lun) {
+  msch_interface_t* p_msc = get_itf(daddr);
+  return p_msc->mounted && lun < CFG_TUH_MSC_MAXLUN &&
+         p_msc->capacity[lun].block_size == CFG_TUH_MSC_CACHE_BLOCK_SIZE;
+}
+
+static int cache_find(msch_cache_t const* cache, uint8_t lun, uint32_t lba) {
+  for (uint8_t i = 0; i < CFG_TUH_MSC_CACHE_BLOCKS; i++) {
+    msch_cache_slot_t const* slot = &cache->slot[i];
+    if (slot->valid && slot->lun == lun && slot->lba == lba) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// Least recently used slot that can be replaced without flushing (free or clean)
+static int cache_find_victim(msch_cache_t const* cache) {
+  int victim = -1;
+  for (uint8_t i = 0; i < CFG_TUH_MSC_CACHE_BLOCKS; i++) {
+    msch_cache_slot_t const* slot = &cache->slot[i];
+    if (!slot->valid) {
+      return i;
+    }
+    if (!slot->dirty && (victim < 0 || (int32_t) (slot->stamp - cache->slot[victim].stamp) < 0)) {
+      victim = i;
+    }
+  }
+  return victim;
+}
+
+TU_ATTR_ALWAYS_INLINE static inline void cache_touch(msch_cache_t* cache, uint8_t idx) {
+  cache->slot[idx].stamp = ++cache->clock;
+}
+
+static void cache_complete(uint8_t daddr, bool success) {
+  msch_cache_t* cache = &_msch_cache[daddr - 1];
+  cache->state = CACHE_STATE_IDLE;
+
+  if (cache->complete_cb) {
+    msc_cbw_t cbw;
+    cbw_init(&cbw, cache->lun);
+    cbw.cmd_len = 10;
+
+    if (cache->op == CACHE_OP_SYNC) {
+      cbw.command[0] = SCSI_CMD_SYNCHRONIZE_CACHE_10;
+    } else {
+      cbw.total_bytes = (uint32_t) cache->count * CFG_TUH_MSC_CACHE_BLOCK_SIZE;
+      cbw.dir = (cache->op == CACHE_OP_READ) ? TUSB_DIR_IN_MASK : TUSB_DIR_OUT;
+      scsi_read10_t const cmd_rw10 = {
+          .cmd_code    = (cache->op == CACHE_OP_READ) ? SCSI_CMD_READ_10 : SCSI_CMD_WRITE_10,
+          .lba         = tu_htonl(cache->lba),
+          .block_count = tu_htons(cache->count)
+      };
+      memcpy(cbw.command, &cmd_rw10, sizeof(cmd_rw10));
+    }
+
+    msc_csw_t const csw = {
+        .signature    = MSC_CSW_SIGNATURE,
+        .tag          = cbw.tag,
+        .data_residue = success ? 0 : cbw.total_bytes,
+        .status       = success ? MSC_CSW_STATUS_PASSED : MSC_CSW_STATUS_FAILED
+    };
+
+    tuh_msc_complete_data_t const cb_data = {
+        .cbw = &cbw,
+        .csw = &csw,
+        .scsi_data = cache->buffer,
+        .user_arg = cache->complete_arg
+    };
+    cache->complete_cb(daddr, &cb_data);
+  }
+}
+
+// Write back a run of adjacent dirty blocks with a single WRITE10, run contains the least recently used dirty slot of
+// lun (any lun if 0xff). Return false if there is no dirty block
+static bool cache_flush_start(uint8_t daddr, uint8_t lun) {
+  msch_cache_t* cache = &_msch_cache[daddr - 1];
+  uint8_t* xfer_buf = _msch_cache_epbuf[daddr - 1].xfer;
+
+  int first = -1;
+  for (uint8_t i = 0; i < CFG_TUH_MSC_CACHE_BLOCKS; i++) {
+    msch_cache_slot_t const* slot = &cache->slot[i];
+    if (!slot->valid || !slot->dirty || (lun != 0xff && slot->lun != lun)) {
+      continue;
+    }
+    if (first < 0 || (int32_t) (slot->stamp - cache->slot[first].stamp) < 0) {
+      first = i;
+    }
+  }
+
+  if (first < 0) {
+    return false; // nothing to flush
+  }
+
+  // extend run to lower adjacent dirty blocks
+  uint8_t const run_lun = cache->slot[first].lun;
+  uint32_t run_lba = cache->slot[first].lba;
+  while (run_lba > 0) {
+    int const idx = cache_find(cache, run_lun, run_lba - 1);
+    if (idx < 0 || !cache->slot[idx].dirty) {
+      break;
+    }
+    run_lba--;
+  }
+
+  // gather run into xfer buffer
+  uint16_t run_count = 0;
+  while (run_count < CFG_TUH_MSC_CACHE_XFER_BLOCKS) {
+    int const idx = cache_find(cache, run_lun, run_lba + run_count);
+    if (idx < 0 || !cache->slot[idx].dirty) {
+      break;
+    }
+    memcpy(xfer_buf + run_count * CFG_TUH_MSC_CACHE_BLOCK_SIZE, _msch_cache_data[daddr - 1][idx],
+           CFG_TUH_MSC_CACHE_BLOCK_SIZE);
+    cache->xfer_slot[run_count] = (uint8_t) idx;
+    run_count++;
+  }
+
+  TU_LOG_DRV("  MSCh cache flush lba = %lu, count = %u\r\n", run_lba, run_count);
+
+  cache->state = CACHE_STATE_FLUSH;
+  cache->xfer_lun = run_lun;
+  cache->xfer_lba = run_lba;
+  cache->xfer_count = run_count;
+  if (!tuh_msc_write10(daddr, run_lun, xfer_buf, run_lba, run_count, cache_flush_complete, 0)) {
+    cache_complete(daddr, false);
+  }
+
+  return true;
+}
+
+static bool cache_flush_complete(uint8_t dev_addr, tuh_msc_complete_data_t const* cb_data) {
+  msch_cache_t* cache = &_msch_cache[dev_addr - 1];
+  TU_VERIFY(cache->state == CACHE_STATE_FLUSH);
+
+  if (cb_data->csw->status != MSC_CSW_STATUS_PASSED) {
+    // keep blocks dirty, they are written again by next flush
+    cache_complete(dev_addr, false);
+    return true;
+  }
+
+  for (uint16_t i = 0; i < cache->xfer_count; i++) {
+    cache->slot[cache->xfer_slot[i]].dirty = false;
+  }
+
+  // resume pending operation
+  cache->state = CACHE_STATE_IDLE;
+  cache_run(dev_addr);
+  return true;
+}
+
+// Read count blocks (with read-ahead if sequential) into xfer buffer
+static void cache_fill_start(uint8_t daddr) {
+  msch_cache_t* cache = &_msch_cache[daddr - 1];
+  msch_interface_t* p_msc = get_itf(daddr);
+
+  uint16_t fill_count = cache->count;
+  if (cache->sequential) {
+    // sequential access: read ahead up to xfer buffer size, but not beyond end of media
+    uint64_t const remaining = p_msc->capacity[cache->lun].block_count - cache->lba;
+    fill_count = (uint16_t) TU_MIN(remaining, CFG_TUH_MSC_CACHE_XFER_BLOCKS);
+  }
+
+  cache->state = CACHE_STATE_FILL;
+  cache->xfer_lun = cache->lun;
+  cache->xfer_lba = cache->lba;
+  cache->xfer_count = fill_count;
+  if (!tuh_msc_read10(daddr, cache->lun, _msch_cache_epbuf[daddr - 1].xfer, cache->lba, fill_count,
+                      cache_fill_complete, 0)) {
+    cache_complete(daddr, false);
+  }
+}
+
+static bool cache_fill_complete(uint8_t dev_addr, tuh_msc_complete_data_t const* cb_data) {
+  msch_cache_t* cache = &_msch_cache[dev_addr - 1];
+  TU_VERIFY(cache->state == CACHE_STATE_FILL);
+
+  if (cb_data->csw->status != MSC_CSW_STATUS_PASSED) {
+    cache_complete(dev_addr, false);
+    return true;
+  }
+
+  uint8_t const* xfer_buf = _msch_cache_epbuf[dev_addr - 1].xfer;
+  uint8_t* buffer = (uint8_t*) cache->buffer;
+
+  for (uint16_t i = 0; i < cache->xfer_count; i++) {
+    uint8_t const* src = xfer_buf + i * CFG_TUH_MSC_CACHE_BLOCK_SIZE;
+    int idx = cache_find(cache, cache->xfer_lun, cache->xfer_lba + i);
+
+    if (idx >= 0 && cache->slot[idx].dirty) {
+      // cached block is newer than media
+      src = _msch_cache_data[dev_addr - 1][idx];
+    } else {
+      // install block, read-ahead blocks only replace free or clean slots
+      if (idx < 0) {
+        idx = cache_find_victim(cache);
+      }
+      if (idx >= 0) {
+        msch_cache_slot_t* slot = &cache->slot[idx];
+        slot->valid = true;
+        slot->dirty = false;
+        slot->lun = cache->xfer_lun;
+        slot->lba = cache->xfer_lba + i;
+        memcpy(_msch_cache_data[dev_addr - 1][idx], src, CFG_TUH_MSC_CACHE_BLOCK_SIZE);
+      }
+    }
+
+    if (idx >= 0) {
+      cache_touch(cache, (uint8_t) idx);
+    }
+
+    if (i < cache->count) {
+      memcpy(buffer + i * CFG_TUH_MSC_CACHE_BLOCK_SIZE, src, CFG_TUH_MSC_CACHE_BLOCK_SIZE);
+    }
+  }
+
+  cache_complete(dev_addr, true);
+  return true;
+}
+
+// Transfer larger than xfer buffer goes directly to/from application buffer
+static void cache_direct_start(uint8_t daddr) {
+  msch_cache_t* cache = &_msch_cache[daddr - 1];
+  bool ret;
+
+  cache->state = CACHE_STATE_DIRECT;
+  if (cache->op == CACHE_OP_READ) {
+    ret = tuh_msc_read10(daddr, cache->lun, cache->buffer, cache->lba, cache->count, cache_direct_complete, 0);
+  } else {
+    // cached copies are superseded by written data
+    uint8_t const* buffer = (uint8_t const*) cache->buffer;
+    for (uint16_t i = 0; i < cache->count; i++) {
+      int const idx = cache_find(cache, cache->lun, cache->lba + i);
+      if (idx >= 0) {
+        memcpy(_msch_cache_data[daddr - 1][idx], buffer + i * CFG_TUH_MSC_CACHE_BLOCK_SIZE,
+               CFG_TUH_MSC_CACHE_BLOCK_SIZE);
+        cache->slot[idx].dirty = false;
+      }
+    }
+    ret = tuh_msc_write10(daddr, cache->lun, cache->buffer, cache->lba, cache->count, cache_direct_complete, 0);
+  }
+
+  if (!ret) {
+    cache_complete(daddr, false);
+  }
+}
+
+static bool cache_direct_complete(uint8_t dev_addr, tuh_msc_complete_data_t const* cb_data) {
+  msch_cache_t* cache = &_msch_cache[dev_addr - 1];
+  TU_VERIFY(cache->state == CACHE_STATE_DIRECT);
+
+  bool const success = (cb_data->csw->status == MSC_CSW_STATUS_PASSED);
+  if (success && cache->op == CACHE_OP_READ) {
+    // dirty cached blocks are newer than media
+    uint8_t* buffer = (uint8_t*) cache->buffer;
+    for (uint8_t i = 0; i < CFG_TUH_MSC_CACHE_BLOCKS; i++) {
+      msch_cache_slot_t const* slot = &cache->slot[i];
+      uint32_t const offset = slot->lba - cache->lba;
+      if (slot->valid && slot->dirty && slot->lun == cache->lun && offset < cache->count) {
+        memcpy(buffer + offset * CFG_TUH_MSC_CACHE_BLOCK_SIZE, _msch_cache_data[dev_addr - 1][i],
+               CFG_TUH_MSC_CACHE_BLOCK_SIZE);
+      }
+    }
+  }
+
+  cache_complete(dev_addr, success);
+  return true;
+}
+
+// Carry out pending operation as far as possible, start a fill or flush when device access is needed
+static void cache_run(uint8_t daddr) {
+  msch_cache_t* cache = &_msch_cache[daddr - 1];
+  uint8_t (*data)[CFG_TUH_MSC_CACHE_BLOCK_SIZE] = _msch_cache_data[daddr - 1];
+  uint8_t* buffer = (uint8_t*) cache->buffer;
+
+  switch (cache->op) {
+    case CACHE_OP_READ:
+      if (cache->count > CFG_TUH_MSC_CACHE_XFER_BLOCKS) {
+        cache_direct_start(daddr);
+        return;
+      }
+
+      for (uint16_t i = 0; i < cache->count; i++) {
+        if (cache_find(cache, cache->lun, cache->lba + i) < 0) {
+          cache_fill_start(daddr);
+          return;
+        }
+      }
+
+      // all blocks are cached
+      for (uint16_t i = 0; i < cache->count; i++) {
+        uint8_t const idx = (uint8_t) cache_find(cache, cache->lun, cache->lba + i);
+        memcpy(buffer + i * CFG_TUH_MSC_CACHE_BLOCK_SIZE, data[idx], CFG_TUH_MSC_CACHE_BLOCK_SIZE);
+        cache_touch(cache, idx);
+      }
+      break;
+
+    case CACHE_OP_WRITE:
+      if (cache->count > CFG_TUH_MSC_CACHE_XFER_BLOCKS) {
+        cache_direct_start(daddr);
+        return;
+      }
+
+      for (uint16_t i = 0; i < cache->count; i++) {
+        int idx = cache_find(cache, cache->lun, cache->lba + i);
+        if (idx < 0) {
+          idx = cache_find_victim(cache);
+          if (idx < 0) {
+            // all slots are dirty: write back least recently used run then resume
+            cache_flush_start(daddr, 0xff);
+            return;
+          }
+        }
+
+        msch_cache_slot_t* slot = &cache->slot[idx];
+        slot->valid = true;
+        slot->dirty = true;
+        slot->lun = cache->lun;
+        slot->lba = cache->lba + i;
+        memcpy(data[idx], buffer + i * CFG_TUH_MSC_CACHE_BLOCK_SIZE, CFG_TUH_MSC_CACHE_BLOCK_SIZE);
+        cache_touch(cache, (uint8_t) idx);
+      }
+      break;
+
+    case CACHE_OP_SYNC:
+      if (cache_flush_start(daddr, cache->lun)) {
+        return;
+      }
+      break;
+
+    default: break;
+  }
+
+  cache_complete(daddr, true);
+}
+
+static bool cache_submit(uint8_t daddr, uint8_t op, uint8_t lun, void* buffer, uint32_t lba, uint16_t count,
+                         tuh_msc_complete_cb_t complete_cb, uintptr_t arg) {
+  msch_cache_t* cache = &_msch_cache[daddr - 1];
+  TU_VERIFY(cache->state == CACHE_STATE_IDLE);
+
+  cache->op = op;
+  cache->lun = lun;
+  cache->lba = lba;
+  cache->count = count;
+  cache->buffer = buffer;
+  cache->complete_cb = complete_cb;
+  cache->complete_arg = arg;
+
+  if (op == CACHE_OP_READ) {
+    cache->sequential = (lun == cache->next_lun && lba == cache->next_lba);
+    cache->next_lun = lun;
+    cache->next_lba = lba + count;
+  }
+
+  cache_run(daddr);
+  return true;
+}
+
+bool tuh_msc_cache_read(uint8_t dev_addr, uint8_t lun, void* buffer, uint32_t lba, uint16_t block_count,
+                        tuh_msc_complete_cb_t complete_cb, uintptr_t arg) {
+  if (!cache_usable(dev_addr, lun)) {
+    return tuh_msc_read10(dev_addr, lun, buffer, lba, block_count, complete_cb, arg);
+  }
+  return cache_submit(dev_addr, CACHE_OP_READ, lun, buffer, lba, block_count, complete_cb, arg);
+}
+
+bool tuh_msc_cache_write(uint8_t dev_addr, uint8_t lun, void const* buffer, uint32_t lba, uint16_t block_count,
+                         tuh_msc_complete_cb_t complete_cb, uintptr_t arg) {
+  if (!cache_usable(dev_addr, lun)) {
+    return tuh_msc_write10(dev_addr, lun, buffer, lba, block_count, complete_cb, arg);
+  }
+  return cache_submit(dev_addr, CACHE_OP_WRITE, lun, (void*) (uintptr_t) buffer, lba, block_count, complete_cb, arg);
+}
+
+bool tuh_msc_cache_sync(uint8_t dev_addr, uint8_t lun, tuh_msc_complete_cb_t complete_cb, uintptr_t arg) {
+  TU_VERIFY(tuh_msc_mounted(dev_addr));
+  return cache_submit(dev_addr, CACHE_OP_SYNC, lun, NULL, 0, 0, complete_cb, arg);
+}
+
+bool tuh_msc_cache_ready(uint8_t dev_addr) {
+  return tuh_msc_mounted(dev_addr) && _msch_cache[dev_addr - 1].state == CACHE_STATE_IDLE;
+}
+
+uint16_t tuh_msc_cache_dirty_count(uint8_t dev_addr) {
+  msch_cache_t const* cache = &_msch_cache[dev_addr - 1];
+  uint16_t count = 0;
+  for (uint8_t i = 0; i < CFG_TUH_MSC_CACHE_BLOCKS; i++) {
+    if (cache->slot[i].valid && cache->slot[i].dirty) {
+      count++;
+    }
+  }
+  return count;
+}
+
+#endif
+
+//--------------------------------------------------------------------+
+// Blocking Read/Write
+//--------------------------------------------------------------------+
+typedef struct {
+  uint32_t submitted;           // written by caller only
+  volatile uint32_t completed;  // written by complete callback only
+  volatile bool failed;
+  osal_semaphore_t sem; // NULL if waiting by running tuh_task()
+} msch_blocking_t;
+
+static bool blocking_complete(uint8_t dev_addr, tuh_msc_complete_data_t const* cb_data) {
+  (void) dev_addr;
+  msch_blocking_t* ctx = (msch_blocking_t*) cb_data->user_arg;
+  if (cb_data->csw->status != MSC_CSW_STATUS_PASSED) {
+    ctx->failed = true;
+  }
+  ctx->completed++;
+  if (ctx->sem) {
+    (void) osal_semaphore_post(ctx->sem, false);
+  }
+  return true;
+}
+
+static void blocking_init(msch_blocking_t* ctx, osal_semaphore_def_t* semdef) {
+  ctx->submitted = 0;
+  ctx->completed = 0;
+  ctx->failed = false;
+  ctx->sem = NULL;
+#if CFG_TUSB_OS != OPT_OS_NONE
+  // usbh task must keep running tuh_task() to complete commands, other threads can sleep
+  if (!usbh_in_task()) {
+    ctx->sem = osal_semaphore_create(semdef);
+  }
+#else
+  (void) semdef;
+#endif
+}
+
+static void blocking_deinit(msch_blocking_t* ctx) {
+#if CFG_TUSB_OS != OPT_OS_NONE
+  if (ctx->sem) {
+    (void) osal_semaphore_delete(ctx->sem);
+  }
+#else
+  (void) ctx;
+#endif
+}
+
+// wait until at most max_pending commands are in progress, commands are dropped if device is unplugged
+static void blocking_wait(uint8_t daddr, msch_blocking_t* ctx, uint32_t max_pending) {
+  while (ctx->submitted - ctx->completed > max_pending && tuh_msc_mounted(daddr)) {
+    if (ctx->sem) {
+      (void) osal_semaphore_wait(ctx->sem, 10);
+    } else if (tuh_task_event_ready()) {
+      tuh_task();
+    }
+  }
+}
+
+static bool rw_submit(uint8_t daddr, uint8_t lun, bool is_write, uint8_t* buffer, uint64_t lba, uint32_t count,
+                      msch_blocking_t* ctx) {
+  uintptr_t const arg = (uintptr_t) ctx;
+
+#if CFG_TUH_MSC_CACHE_BLOCKS
+  if (get_itf(daddr)->capacity[lun].block_size == CFG_TUH_MSC_CACHE_BLOCK_SIZE && lba + count <= UINT32_MAX) {
+    // keep cache coherent
+    return is_write ? tuh_msc_cache_write(daddr, lun, buffer, (uint32_t) lba, (uint16_t) count, blocking_complete, arg)
+                    : tuh_msc_cache_read(daddr, lun, buffer, (uint32_t) lba, (uint16_t) count, blocking_complete, arg);
+  }
+#endif
+
+  if (lba + count <= UINT32_MAX) {
+    return is_write ? tuh_msc_write10(daddr, lun, buffer, (uint32_t) lba, (uint16_t) count, blocking_complete, arg)
+                    : tuh_msc_read10(daddr, lun, buffer, (uint32_t) lba, (uint16_t) count, blocking_complete, arg);
+  } else {
+    return is_write ? tuh_msc_write16(daddr, lun, buffer, lba, count, blocking_complete, arg)
+                    : tuh_msc_read16(daddr, lun, buffer, lba, count, blocking_complete, arg);
+  }
+}
+
+// Split transfer into commands of preferred size, which are queued back-to-back with CFG_TUH_MSC_CMD_QUEUE
+static bool rw_sync(uint8_t daddr, uint8_t lun, bool is_write, uint8_t* buffer, uint64_t lba, uint32_t block_count) {
+  msch_interface_t* p_msc = get_itf(daddr);
+  TU_VERIFY(p_msc->mounted && lun < p_msc->max_lun);
+
+  uint32_t const block_size = p_msc->capacity[lun].block_size;
+  uint32_t const chunk_max = tuh_msc_get_max_xfer_blocks(daddr, lun);
+  TU_VERIFY(chunk_max);
+
+  msch_blocking_t ctx;
+  osal_semaphore_def_t semdef;
+  blocking_init(&ctx, &semdef);
+
+  while (block_count && !ctx.failed && p_msc->mounted) {
+    uint32_t const count = tu_min32(block_count, chunk_max);
+
+    ctx.submitted++;
+    if (rw_submit(daddr, lun, is_write, buffer, lba, count, &ctx)) {
+      buffer += count * block_size;
+      lba += count;
+      block_count -= count;
+    } else {
+      ctx.submitted--;
+      if (ctx.submitted == ctx.completed) {
+        ctx.failed = true; // interface is busy with other commands
+        break;
+      }
+      // queue is full: wait for a command to complete then retry
+      blocking_wait(daddr, &ctx, ctx.submitted - ctx.completed - 1);
+    }
+  }
+
+  blocking_wait(daddr, &ctx, 0);
+  blocking_deinit(&ctx);
+
+  return !ctx.failed && block_count == 0 && ctx.submitted == ctx.completed;
+}
+
+bool tuh_msc_read_sync(uint8_t dev_addr, uint8_t lun, void* buffer, uint64_t lba, uint32_t block_count) {
+  return rw_sync(dev_addr, lun, false, (uint8_t*) buffer, lba, block_count);
+}
+
+bool tuh_msc_write_sync(uint8_t dev_addr, uint8_t lun, void const* buffer, uint64_t lba, uint32_t block_count) {
+  return rw_sync(dev_addr, lun, true, (uint8_t*) (uintptr_t) buffer, lba, block_count);
+}
+
+#if CFG_TUH_MSC_CACHE_BLOCKS
+bool tuh_msc_cache_sync_blocking(uint8_t dev_addr, uint8_t lun) {
+  msch_blocking_t ctx;
+  osal_semaphore_def_t semdef;
+  blocking_init(&ctx, &semdef);
+
+  ctx.submitted = 1;
+  bool ret = tuh_msc_cache_sync(dev_addr, lun, blocking_complete, (uintptr_t) &ctx);
+  if (ret) {
+    blocking_wait(dev_addr, &ctx, 0);
+    ret = !ctx.failed && ctx.completed == 1;
+  }
+
+  blocking_deinit(&ctx);
+  return ret;
+}
+#endif
+
+// Complete callback for completion token, actual length excludes data residue
+bool tuh_msc_token_cb(uint8_t dev_addr, tuh_msc_complete_data_t const* cb_data) {
+  (void) dev_addr;
+  uint32_t const total = cb_data->cbw->total_bytes;
+  uint32_t const residue = tu_min32(cb_data->csw->data_residue, total);
+  xfer_result_t const result = (cb_data->csw->status == MSC_CSW_STATUS_PASSED) ? XFER_RESULT_SUCCESS : XFER_RESULT_FAILED;
+  tuh_xfer_token_complete((tuh_xfer_token_t*) cb_data->user_arg, result, total - residue);
+  return true;
+}
+
 #if 0
 // MSC interface Reset (not used now)
 bool tuh_msc_reset(uint8_t dev_addr) {
@@ -309,7 +1119,13 @@ void msch_close(uint8_t dev_addr) {
     }
   }
 
+  tu_msc_passthrough_host_close(dev_addr);
   tu_memclr(p_msc, sizeof(msch_interface_t));
+
+#if CFG_TUH_MSC_CACHE_BLOCKS
+  // device is gone, dirty blocks are lost: application should call tuh_msc_cache_sync() before ejecting
+  tu_memclr(&_msch_cache[dev_addr - 1], sizeof(msch_cache_t));
+#endif
 }
 
 bool msch_xfer_cb(uint8_t dev_addr, uint8_t ep_addr, xfer_result_t event, uint32_t xferred_bytes) {
@@ -342,6 +1158,31 @@ bool msch_xfer_cb(uint8_t dev_addr, uint8_t ep_addr, xfer_result_t event, uint32
       // SCSI op is complete
       p_msc->stage = MSC_STAGE_IDLE;
 
+#if CFG_TUH_MSC_CMD_QUEUE
+    {
+      // Start next queued CBW before invoking callback so that device works on it while application processes
+      // this one. CBW/CSW endpoint buffers are reused by next command, pass copies to callback instead.
+      msc_cbw_t const cbw_done = *cbw;
+      msc_csw_t const csw_done = *csw;
+      msch_cmd_t const done = {
+          .buffer = p_msc->buffer,
+          .complete_cb = p_msc->complete_cb,
+          .complete_arg = p_msc->complete_arg
+      };
+
+      cmd_queue_next(dev_addr);
+
+      if (done.complete_cb) {
+        tuh_msc_complete_data_t const cb_data = {
+            .cbw = &cbw_done,
+            .csw = &csw_done,
+            .scsi_data = done.buffer,
+            .user_arg = done.complete_arg
+        };
+        done.complete_cb(dev_addr, &cb_data);
+      }
+    }
+#else
       if (p_msc->complete_cb) {
         tuh_msc_complete_data_t const cb_data = {
             .cbw = cbw,
@@ -351,6 +1192,7 @@ bool msch_xfer_cb(uint8_t dev_addr, uint8_t ep_addr, xfer_result_t event, uint32
         };
         p_msc->complete_cb(dev_addr, &cb_data);
       }
+#endif
       break;
 
       // unknown state
@@ -368,6 +1210,11 @@ static void config_get_maxlun_complete(tuh_xfer_t* xfer);
 static bool config_test_unit_ready_complete(uint8_t dev_addr, tuh_msc_complete_data_t const* cb_data);
 static bool config_request_sense_complete(uint8_t dev_addr, tuh_msc_complete_data_t const* cb_data);
 static bool config_read_capacity_complete(uint8_t dev_addr, tuh_msc_complete_data_t const* cb_data);
+static bool config_read_capacity16_complete(uint8_t dev_addr, tuh_msc_complete_data_t const* cb_data);
+static void config_complete(uint8_t dev_addr);
+#if CFG_TUH_MSC_BLOCK_LIMITS
+static bool config_block_limits_complete(uint8_t dev_addr, tuh_msc_complete_data_t const* cb_data);
+#endif
 
 bool msch_open(uint8_t rhport, uint8_t dev_addr, tusb_desc_interface_t const* desc_itf, uint16_t max_len) {
   (void) rhport;
@@ -397,6 +1244,10 @@ bool msch_open(uint8_t rhport, uint8_t dev_addr, tusb_desc_interface_t const* de
 
   p_msc->itf_num = desc_itf->bInterfaceNumber;
 
+#if CFG_TUH_MSC_CMD_QUEUE
+  tu_fifo_config(&p_msc->cmd_ff, p_msc->cmd_ff_buf, CFG_TUH_MSC_CMD_QUEUE, sizeof(msch_cmd_t), false);
+#endif
+
   return true;
 }
 
@@ -492,9 +1343,70 @@ static bool config_read_capacity_complete(uint8_t dev_addr, tuh_msc_complete_dat
 
   // Capacity response field: Block size and Last LBA are both Big-Endian
   scsi_read_capacity10_resp_t* resp = (scsi_read_capacity10_resp_t*) (uintptr_t) enum_buf;
-  p_msc->capacity[cbw->lun].block_count = tu_ntohl(resp->last_lba) + 1;
+  p_msc->capacity[cbw->lun].block_count = (uint64_t) tu_ntohl(resp->last_lba) + 1;
   p_msc->capacity[cbw->lun].block_size  = tu_ntohl(resp->block_size);
 
+  // Last LBA of all ones: media is too large for READ CAPACITY (10)
+  if (resp->last_lba == UINT32_MAX) {
+    TU_LOG_DRV("SCSI Read Capacity16\r\n");
+    TU_ASSERT(tuh_msc_read_capacity16(dev_addr, cbw->lun, (scsi_read_capacity16_resp_t*) (uintptr_t) enum_buf,
+                                      config_read_capacity16_complete, 0));
+    return true;
+  }
+
+  return config_read_capacity16_complete(dev_addr, NULL);
+}
+
+// cb_data is NULL if READ CAPACITY (16) is not needed
+static bool config_read_capacity16_complete(uint8_t dev_addr, tuh_msc_complete_data_t const* cb_data) {
+  msch_interface_t* p_msc = get_itf(dev_addr);
+
+  if (cb_data) {
+    msc_cbw_t const* cbw = cb_data->cbw;
+    TU_ASSERT(cb_data->csw->status == 0);
+
+    scsi_read_capacity16_resp_t const* resp = (scsi_read_capacity16_resp_t const*) (uintptr_t) usbh_get_enum_buf();
+    p_msc->capacity[cbw->lun].block_count = tu_ntohll(resp->last_lba) + 1;
+    p_msc->capacity[cbw->lun].block_size  = tu_ntohl(resp->block_size);
+  }
+
+#if CFG_TUH_MSC_BLOCK_LIMITS
+  TU_LOG_DRV("SCSI Inquiry Block Limits VPD\r\n");
+  uint8_t const lun = 0;
+  if (tuh_msc_inquiry_vpd(dev_addr, lun, SCSI_VPD_BLOCK_LIMITS, usbh_get_enum_buf(),
+                          sizeof(scsi_vpd_block_limits_t), config_block_limits_complete, 0)) {
+    return true;
+  }
+#endif
+
+  config_complete(dev_addr);
+  return true;
+}
+
+#if CFG_TUH_MSC_BLOCK_LIMITS
+static bool config_block_limits_complete(uint8_t dev_addr, tuh_msc_complete_data_t const* cb_data) {
+  msch_interface_t* p_msc = get_itf(dev_addr);
+
+  // page is optional, device without it fails the command
+  if (cb_data->csw->status == MSC_CSW_STATUS_PASSED && cb_data->csw->data_residue <= sizeof(scsi_vpd_block_limits_t) - 16) {
+    scsi_vpd_block_limits_t const* limits = (scsi_vpd_block_limits_t const*) (uintptr_t) usbh_get_enum_buf();
+    uint32_t const opt_len = tu_ntohl(limits->opt_transfer_length);
+    uint32_t const max_len = tu_ntohl(limits->max_transfer_length);
+    if (limits->page_code == SCSI_VPD_BLOCK_LIMITS) {
+      p_msc->capacity[cb_data->cbw->lun].xfer_blocks = opt_len ? opt_len : max_len;
+    }
+    TU_LOG_DRV("  Transfer length: optimal = %lu, max = %lu\r\n", opt_len, max_len);
+  }
+
+  config_complete(dev_addr);
+  return true;
+}
+#endif
+
+// final step of enumeration
+static void config_complete(uint8_t dev_addr) {
+  msch_interface_t* p_msc = get_itf(dev_addr);
+
   // Mark enumeration is complete
   p_msc->mounted = true;
   if (tuh_msc_mount_cb) {
@@ -503,8 +1415,6 @@ static bool config_read_capacity_complete(uint8_t dev_addr, tuh_msc_complete_dat
 
   // notify usbh that driver enumeration is complete
   usbh_driver_set_config_complete(dev_addr, p_msc->itf_num);
-
-  return true;
 }
 
 #endif
@@ -41,6 +41,40 @@
 #define CFG_TUH_MSC_MAXLUN  4
 #endif
 
+// Number of SCSI commands that can be queued per device (0 to disable). Queued commands are issued back-to-back by
+// usbh task: next CBW is sent as soon as CSW of previous command is received, before its complete callback is invoked
+#ifndef CFG_TUH_MSC_CMD_QUEUE
+#define CFG_TUH_MSC_CMD_QUEUE  0
+#endif
+
+// Query Block Limits VPD page during enumeration to size READ/WRITE commands of blocking API. Off by default since
+// some USB sticks misbehave on VPD inquiry
+#ifndef CFG_TUH_MSC_BLOCK_LIMITS
+#define CFG_TUH_MSC_BLOCK_LIMITS  0
+#endif
+
+// Number of blocks of per-device block cache used by tuh_msc_cache_*() API (0 to disable). Cached blocks are
+// replaced in least recently used order, written blocks are kept (write-behind) until evicted or synced.
+#ifndef CFG_TUH_MSC_CACHE_BLOCKS
+#define CFG_TUH_MSC_CACHE_BLOCKS  0
+#endif
+
+// Block size of cache, LUN with other block size is not cached
+#ifndef CFG_TUH_MSC_CACHE_BLOCK_SIZE
+#define CFG_TUH_MSC_CACHE_BLOCK_SIZE  512
+#endif
+
+// Max blocks per cache transfer: read-ahead size of sequential reads and max adjacent dirty blocks merged into a
+// single WRITE10. Larger application transfers bypass the cache. Transfer buffer is allocated per device
+#ifndef CFG_TUH_MSC_CACHE_XFER_BLOCKS
+#define CFG_TUH_MSC_CACHE_XFER_BLOCKS  4
+#endif
+
+#if CFG_TUH_MSC_CACHE_BLOCKS && (CFG_TUH_MSC_CACHE_XFER_BLOCKS < 1 || \
+    CFG_TUH_MSC_CACHE_XFER_BLOCKS > CFG_TUH_MSC_CACHE_BLOCKS || CFG_TUH_MSC_CACHE_BLOCKS > 255)
+  #error "CFG_TUH_MSC_CACHE_XFER_BLOCKS must be 1 to CFG_TUH_MSC_CACHE_BLOCKS, CFG_TUH_MSC_CACHE_BLOCKS at most 255"
+#endif
+
 typedef struct {
   msc_cbw_t const* cbw; // SCSI command
   msc_csw_t const* csw; // SCSI status
@@ -59,20 +93,35 @@ typedef bool (*tuh_msc_complete_cb_t)(uint8_t dev_addr, tuh_msc_complete_data_t
 bool tuh_msc_mounted(uint8_t dev_addr);
 
 // Check if the interface is currently ready or busy transferring data
+// With CFG_TUH_MSC_CMD_QUEUE: check if another command can be queued
 bool tuh_msc_ready(uint8_t dev_addr);
 
+#if CFG_TUH_MSC_CMD_QUEUE
+// Number of commands queued but not started yet
+uint8_t tuh_msc_queued_count(uint8_t dev_addr);
+#endif
+
 // Get Max Lun
 uint8_t tuh_msc_get_maxlun(uint8_t dev_addr);
 
-// Get number of block
+// Get number of block, saturated at UINT32_MAX for media larger than 2^32 blocks
 uint32_t tuh_msc_get_block_count(uint8_t dev_addr, uint8_t lun);
 
+// Get number of block, with media larger than 2^32 blocks (READ CAPACITY 16)
+uint64_t tuh_msc_get_block_count64(uint8_t dev_addr, uint8_t lun);
+
 // Get block size in bytes
 uint32_t tuh_msc_get_block_size(uint8_t dev_addr, uint8_t lun);
 
+// Get number of blocks per READ/WRITE command: optimal (or max) transfer length of Block Limits VPD if reported,
+// limited by 64KB per command
+uint32_t tuh_msc_get_max_xfer_blocks(uint8_t dev_addr, uint8_t lun);
+
 // Perform a full SCSI command (cbw, data, csw) in non-blocking manner.
 // Complete callback is invoked when SCSI op is complete.
 // return true if success, false if there is already pending operation.
+// With CFG_TUH_MSC_CMD_QUEUE, command (of any LUN) is queued and executed in order, false is returned only if queue
+// is full. Queue must be filled from a single task, pending commands are dropped without callback if device is removed
 // NOTE: buffer must be accessible by USB/DMA controller, aligned correctly and multiple of cache line if enabled
 bool tuh_msc_scsi_command(uint8_t daddr, msc_cbw_t const* cbw, void* data, tuh_msc_complete_cb_t complete_cb, uintptr_t arg);
 
@@ -81,6 +130,11 @@ bool tuh_msc_scsi_command(uint8_t daddr, msc_cbw_t const* cbw, void* data, tuh_m
 // NOTE: response must be accessible by USB/DMA controller, aligned correctly and multiple of cache line if enabled
 bool tuh_msc_inquiry(uint8_t dev_addr, uint8_t lun, scsi_inquiry_resp_t* response, tuh_msc_complete_cb_t complete_cb, uintptr_t arg);
 
+// Perform SCSI Inquiry command for Vital Product Data page e.g SCSI_VPD_BLOCK_LIMITS
+// Complete callback is invoked when SCSI op is complete, command fails if page is not supported.
+// NOTE: response must be accessible by USB/DMA controller, aligned correctly and multiple of cache line if enabled
+bool tuh_msc_inquiry_vpd(uint8_t dev_addr, uint8_t lun, uint8_t page_code, void* response, uint8_t len, tuh_msc_complete_cb_t complete_cb, uintptr_t arg);
+
 // Perform SCSI Test Unit Ready command
 // Complete callback is invoked when SCSI op is complete.
 bool tuh_msc_test_unit_ready(uint8_t dev_addr, uint8_t lun, tuh_msc_complete_cb_t complete_cb, uintptr_t arg);
@@ -100,12 +154,58 @@ bool tuh_msc_read10(uint8_t dev_addr, uint8_t lun, void * buffer, uint32_t lba,
 // NOTE: buffer must be accessible by USB/DMA controller, aligned correctly and multiple of cache line if enabled
 bool tuh_msc_write10(uint8_t dev_addr, uint8_t lun, void const * buffer, uint32_t lba, uint16_t block_count, tuh_msc_complete_cb_t complete_cb, uintptr_t arg);
 
+// Perform SCSI Read 16 command: 64-bit LBA and 32-bit block count, required beyond 2^32 blocks and allows large
+// transfer in one command (total bytes is limited to 4GB by CBW).
+// Complete callback is invoked when SCSI op is complete.
+// NOTE: buffer must be accessible by USB/DMA controller, aligned correctly and multiple of cache line if enabled
+bool tuh_msc_read16(uint8_t dev_addr, uint8_t lun, void * buffer, uint64_t lba, uint32_t block_count, tuh_msc_complete_cb_t complete_cb, uintptr_t arg);
+
+// Perform SCSI Write 16 command, see tuh_msc_read16()
+bool tuh_msc_write16(uint8_t dev_addr, uint8_t lun, void const * buffer, uint64_t lba, uint32_t block_count, tuh_msc_complete_cb_t complete_cb, uintptr_t arg);
+
 // Perform SCSI Read Capacity 10 command
 // Complete callback is invoked when SCSI op is complete.
 // Note: during enumeration, host stack already carried out this request. Application can retrieve capacity by
 // simply call tuh_msc_get_block_count() and tuh_msc_get_block_size()
 bool tuh_msc_read_capacity(uint8_t dev_addr, uint8_t lun, scsi_read_capacity10_resp_t* response, tuh_msc_complete_cb_t complete_cb, uintptr_t arg);
 
+// Perform SCSI Read Capacity 16 command, issued during enumeration if media is too large for Read Capacity 10
+bool tuh_msc_read_capacity16(uint8_t dev_addr, uint8_t lun, scsi_read_capacity16_resp_t* response, tuh_msc_complete_cb_t complete_cb, uintptr_t arg);
+
+//------------- Blocking Read/Write -------------//
+// Sync (blocking) read/write of any number of blocks: split into commands of tuh_msc_get_max_xfer_blocks(), queued
+// back-to-back with CFG_TUH_MSC_CMD_QUEUE and going through block cache if enabled. Called from other thread than
+// tuh_task(), it sleeps on a semaphore, otherwise it runs tuh_task() while waiting.
+// Return false if any command fails or device is unplugged
+bool tuh_msc_read_sync(uint8_t dev_addr, uint8_t lun, void* buffer, uint64_t lba, uint32_t block_count);
+bool tuh_msc_write_sync(uint8_t dev_addr, uint8_t lun, void const* buffer, uint64_t lba, uint32_t block_count);
+
+// Complete callback for any command with a completion token (tuh_xfer_token_t) as arg: command is successful if
+// status is passed, actual length excludes data residue
+bool tuh_msc_token_cb(uint8_t dev_addr, tuh_msc_complete_data_t const* cb_data);
+
+//------------- Block Cache -------------//
+#if CFG_TUH_MSC_CACHE_BLOCKS
+// Cached READ10/WRITE10 with same semantic as tuh_msc_read10()/tuh_msc_write10(). If request can be served from
+// cache, complete callback is invoked before function returns. Only one cache operation per device is in progress,
+// return false if cache is busy. Written data is only stored on device when evicted or by tuh_msc_cache_sync()
+bool tuh_msc_cache_read(uint8_t dev_addr, uint8_t lun, void* buffer, uint32_t lba, uint16_t block_count, tuh_msc_complete_cb_t complete_cb, uintptr_t arg);
+bool tuh_msc_cache_write(uint8_t dev_addr, uint8_t lun, void const* buffer, uint32_t lba, uint16_t block_count, tuh_msc_complete_cb_t complete_cb, uintptr_t arg);
+
+// Write back all dirty blocks of lun, merging adjacent blocks. Should be called on file system sync and before
+// ejecting device: dirty blocks are lost when device is unmounted
+bool tuh_msc_cache_sync(uint8_t dev_addr, uint8_t lun, tuh_msc_complete_cb_t complete_cb, uintptr_t arg);
+
+// Sync (blocking) version of tuh_msc_cache_sync()
+bool tuh_msc_cache_sync_blocking(uint8_t dev_addr, uint8_t lun);
+
+// Check if cache can accept a new operation
+bool tuh_msc_cache_ready(uint8_t dev_addr);
+
+// Number of cached blocks not yet written to device
+uint16_t tuh_msc_cache_dirty_count(uint8_t dev_addr);
+#endif
+
 //------------- Application Callback -------------//
 
 // Invoked when a device with MassStorage interface is mounted
@@ -0,0 +1,201 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#include "tusb_option.h"
+
+#if CFG_TUSB_MSC_PASSTHROUGH && CFG_TUD_ENABLED && CFG_TUD_MSC && CFG_TUH_ENABLED && CFG_TUH_MSC
+
+#include "tusb.h"
+
+//--------------------------------------------------------------------+
+// MACRO CONSTANT TYPEDEF
+//--------------------------------------------------------------------+
+typedef struct {
+  uint8_t daddr; // 0 if not mapped
+  uint8_t lun;
+} passthrough_lun_t;
+
+// Device MSC has at most one READ10/WRITE10 chunk in progress
+typedef struct {
+  volatile bool busy;
+  bool is_write;
+  uint8_t lun;
+  uint8_t seq;         // tag of forwarded command, late completion of a dropped one is ignored
+  uint32_t lba;
+  uint8_t* buffer;     // device endpoint buffer, shared with host transfer
+
+  // write chunk already transformed, not again if host was busy and the same chunk is retried
+  uint8_t* xform_buf;
+  uint32_t xform_lba;
+} passthrough_io_t;
+
+static passthrough_lun_t _pt_lun[CFG_TUSB_MSC_PASSTHROUGH];
+static passthrough_io_t _pt_io;
+
+//--------------------------------------------------------------------+
+// Weak stubs: invoked if no strong implementation is available
+//--------------------------------------------------------------------+
+TU_ATTR_WEAK bool tusb_msc_passthrough_transform_cb(uint8_t lun, uint32_t lba, uint8_t* buffer, uint32_t bufsize,
+                                                    bool is_write) {
+  (void) lun; (void) lba; (void) buffer; (void) bufsize; (void) is_write;
+  return true;
+}
+
+//--------------------------------------------------------------------+
+// Helper
+//--------------------------------------------------------------------+
+static void io_done(int32_t nbytes) {
+  _pt_io.busy = false;
+  _pt_io.xform_buf = NULL;
+  if (_pt_io.is_write) {
+    (void) tud_msc_async_write_done(nbytes, false);
+  } else {
+    (void) tud_msc_async_read_done(nbytes, false);
+  }
+}
+
+static bool io_complete(uint8_t daddr, tuh_msc_complete_data_t const* cb_data) {
+  (void) daddr;
+  TU_VERIFY(_pt_io.busy && (uint8_t) cb_data->user_arg == _pt_io.seq);
+
+  msc_cbw_t const* cbw = cb_data->cbw;
+  uint8_t const lun = _pt_io.lun;
+  int32_t nbytes = TUD_MSC_RET_ERROR;
+
+  if (cb_data->csw->status == MSC_CSW_STATUS_PASSED) {
+    uint32_t const len = cbw->total_bytes - tu_min32(cb_data->csw->data_residue, cbw->total_bytes);
+    if (_pt_io.is_write || tusb_msc_passthrough_transform_cb(lun, _pt_io.lba, _pt_io.buffer, len, false)) {
+      nbytes = (int32_t) len;
+    } else {
+      tud_msc_set_sense(lun, SCSI_SENSE_MEDIUM_ERROR, 0x11, 0x00); // unrecovered read error
+    }
+  } else if (_pt_io.is_write) {
+    tud_msc_set_sense(lun, SCSI_SENSE_MEDIUM_ERROR, 0x0C, 0x00); // write error
+  } else {
+    tud_msc_set_sense(lun, SCSI_SENSE_MEDIUM_ERROR, 0x11, 0x00); // unrecovered read error
+  }
+
+  io_done(nbytes);
+  return true;
+}
+
+static int32_t io_forward(uint8_t lun, uint32_t lba, uint32_t offset, uint8_t* buffer, uint32_t bufsize,
+                          bool is_write) {
+  TU_VERIFY(lun < CFG_TUSB_MSC_PASSTHROUGH && !_pt_io.busy, TUD_MSC_RET_ERROR);
+  passthrough_lun_t const* pt = &_pt_lun[lun];
+  if (pt->daddr == 0 || !tuh_msc_mounted(pt->daddr)) {
+    tud_msc_set_sense(lun, SCSI_SENSE_NOT_READY, 0x3A, 0x00); // medium not present
+    return TUD_MSC_RET_ERROR;
+  }
+
+  // blocks are forwarded as a whole: chunk must start on and contain whole host blocks
+  uint32_t const block_size = tuh_msc_get_block_size(pt->daddr, pt->lun);
+  TU_VERIFY(block_size && offset == 0 && bufsize >= block_size, TUD_MSC_RET_ERROR);
+  uint16_t const block_count = (uint16_t) tu_min32(bufsize / block_size, UINT16_MAX);
+
+  if (is_write && !(_pt_io.xform_buf == buffer && _pt_io.xform_lba == lba)) {
+    if (!tusb_msc_passthrough_transform_cb(lun, lba, buffer, block_count * block_size, true)) {
+      tud_msc_set_sense(lun, SCSI_SENSE_DATA_PROTECT, 0x27, 0x00); // write protected
+      return TUD_MSC_RET_ERROR;
+    }
+    _pt_io.xform_buf = buffer;
+    _pt_io.xform_lba = lba;
+  }
+
+  _pt_io.is_write = is_write;
+  _pt_io.lun = lun;
+  _pt_io.lba = lba;
+  _pt_io.buffer = buffer;
+  _pt_io.seq++;
+  _pt_io.busy = true;
+
+  bool const ok = is_write ?
+      tuh_msc_write10(pt->daddr, pt->lun, buffer, lba, block_count, io_complete, _pt_io.seq) :
+      tuh_msc_read10(pt->daddr, pt->lun, buffer, lba, block_count, io_complete, _pt_io.seq);
+  if (!ok) {
+    _pt_io.busy = false; // host is busy, device stack retries the same chunk later
+    return 0;
+  }
+
+  return TUD_MSC_RET_ASYNC;
+}
+
+//--------------------------------------------------------------------+
+// Application API
+//--------------------------------------------------------------------+
+bool tusb_msc_passthrough_attach(uint8_t lun, uint8_t daddr, uint8_t host_lun) {
+  TU_VERIFY(lun < CFG_TUSB_MSC_PASSTHROUGH && tuh_msc_mounted(daddr) && host_lun < tuh_msc_get_maxlun(daddr));
+  _pt_lun[lun].daddr = daddr;
+  _pt_lun[lun].lun = host_lun;
+  return true;
+}
+
+void tusb_msc_passthrough_detach(uint8_t lun) {
+  TU_VERIFY(lun < CFG_TUSB_MSC_PASSTHROUGH,);
+  _pt_lun[lun].daddr = 0;
+  if (_pt_io.busy && _pt_io.lun == lun) {
+    tud_msc_set_sense(lun, SCSI_SENSE_NOT_READY, 0x3A, 0x00); // medium not present
+    io_done(TUD_MSC_RET_ERROR);
+  }
+}
+
+bool tusb_msc_passthrough_ready(uint8_t lun) {
+  bool const ready = lun < CFG_TUSB_MSC_PASSTHROUGH && _pt_lun[lun].daddr && tuh_msc_mounted(_pt_lun[lun].daddr);
+  if (!ready) {
+    tud_msc_set_sense(lun, SCSI_SENSE_NOT_READY, 0x3A, 0x00); // medium not present
+  }
+  return ready;
+}
+
+void tusb_msc_passthrough_capacity(uint8_t lun, uint32_t* block_count, uint16_t* block_size) {
+  *block_count = 0;
+  *block_size = 0;
+  TU_VERIFY(lun < CFG_TUSB_MSC_PASSTHROUGH && _pt_lun[lun].daddr,);
+  passthrough_lun_t const* pt = &_pt_lun[lun];
+  *block_count = tuh_msc_get_block_count(pt->daddr, pt->lun);
+  *block_size = (uint16_t) tuh_msc_get_block_size(pt->daddr, pt->lun);
+}
+
+int32_t tusb_msc_passthrough_read10(uint8_t lun, uint32_t lba, uint32_t offset, void* buffer, uint32_t bufsize) {
+  return io_forward(lun, lba, offset, (uint8_t*) buffer, bufsize, false);
+}
+
+int32_t tusb_msc_passthrough_write10(uint8_t lun, uint32_t lba, uint32_t offset, uint8_t* buffer, uint32_t bufsize) {
+  return io_forward(lun, lba, offset, buffer, bufsize, true);
+}
+
+//--------------------------------------------------------------------+
+// Internal API
+//--------------------------------------------------------------------+
+void tu_msc_passthrough_host_close(uint8_t daddr) {
+  for (uint8_t lun = 0; lun < CFG_TUSB_MSC_PASSTHROUGH; lun++) {
+    if (_pt_lun[lun].daddr == daddr) {
+      tusb_msc_passthrough_detach(lun);
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,99 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#ifndef TUSB_MSC_PASSTHROUGH_H_
+#define TUSB_MSC_PASSTHROUGH_H_
+
+#include "common/tusb_common.h"
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+// MSC passthrough: a LUN of a host mounted MSC device is exposed as a LUN of the device MSC interface. READ10/WRITE10
+// data is not copied: the device endpoint buffer is passed as is to tuh_msc_read10()/tuh_msc_write10(), which then
+// completes the device callback asynchronously. Overlap comes from CFG_TUD_MSC_EP_BUF_COUNT > 1 (next chunk is
+// forwarded while previous one is on device bus) and CFG_TUH_MSC_CMD_QUEUE.
+//
+// Application calls passthrough API from its tud_msc_*_cb() for mapped LUNs, e.g
+//   int32_t tud_msc_read10_cb(uint8_t lun, uint32_t lba, uint32_t offset, void* buffer, uint32_t bufsize) {
+//     return tusb_msc_passthrough_read10(lun, lba, offset, buffer, bufsize);
+//   }
+//
+// Requirements:
+// - device endpoint buffer (CFG_TUD_MEM_SECTION) must be accessible by host controller DMA
+// - CFG_TUD_MSC_EP_BUFSIZE must be a multiple of the host LUN block size
+
+#if CFG_TUSB_MSC_PASSTHROUGH && CFG_TUD_ENABLED && CFG_TUD_MSC && CFG_TUH_ENABLED && CFG_TUH_MSC
+
+//--------------------------------------------------------------------+
+// Application API
+//--------------------------------------------------------------------+
+
+// Map device lun (< CFG_TUSB_MSC_PASSTHROUGH) to host_lun of MSC device daddr, which must be mounted
+bool tusb_msc_passthrough_attach(uint8_t lun, uint8_t daddr, uint8_t host_lun);
+
+// Remove mapping of device lun, command in progress is failed. Done automatically when host device is unplugged.
+void tusb_msc_passthrough_detach(uint8_t lun);
+
+// Check if lun is mapped and host device is ready, set sense to medium not present if not.
+// Can be used as tud_msc_test_unit_ready_cb()
+bool tusb_msc_passthrough_ready(uint8_t lun);
+
+// Capacity of mapped host LUN, can be used as tud_msc_capacity_cb()
+void tusb_msc_passthrough_capacity(uint8_t lun, uint32_t* block_count, uint16_t* block_size);
+
+// Forward READ10/WRITE10 chunk to host LUN, return TUD_MSC_RET_ASYNC if started, 0 if host is busy (retried by
+// device stack) or TUD_MSC_RET_ERROR. Can be returned as is from tud_msc_read10_cb()/tud_msc_write10_cb().
+int32_t tusb_msc_passthrough_read10(uint8_t lun, uint32_t lba, uint32_t offset, void* buffer, uint32_t bufsize);
+int32_t tusb_msc_passthrough_write10(uint8_t lun, uint32_t lba, uint32_t offset, uint8_t* buffer, uint32_t bufsize);
+
+//--------------------------------------------------------------------+
+// Application Callbacks (WEAK is optional)
+//--------------------------------------------------------------------+
+
+// Invoked to transform block data in place e.g encryption: for read once received from host LUN (in usbh task), for
+// write before it is sent to host LUN (in usbd task). Return false to fail the command e.g write blocker.
+bool tusb_msc_passthrough_transform_cb(uint8_t lun, uint32_t lba, uint8_t* buffer, uint32_t bufsize, bool is_write);
+
+//--------------------------------------------------------------------+
+// Internal API used by msc host
+//--------------------------------------------------------------------+
+
+// Host MSC device is removed, its pending commands are dropped
+void tu_msc_passthrough_host_close(uint8_t daddr);
+
+#else
+
+#define tu_msc_passthrough_host_close(_daddr)
+
+#endif
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif
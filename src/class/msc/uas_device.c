@@ -0,0 +1,656 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#include "tusb_option.h"
+
+#if (CFG_TUD_ENABLED && CFG_TUD_UAS)
+
+#include "device/usbd.h"
+#include "device/usbd_pvt.h"
+
+#include "uas_device.h"
+
+// Level where CFG_TUSB_DEBUG must be at least for this driver is logged
+#ifndef CFG_TUD_UAS_LOG_LEVEL
+  #define CFG_TUD_UAS_LOG_LEVEL   CFG_TUD_LOG_LEVEL
+#endif
+
+#define TU_LOG_DRV(...)   TU_LOG(CFG_TUD_UAS_LOG_LEVEL, __VA_ARGS__)
+
+//--------------------------------------------------------------------+
+// MACRO CONSTANT TYPEDEF
+//--------------------------------------------------------------------+
+enum {
+  UAS_STAGE_IDLE = 0,   // no command in progress
+  UAS_STAGE_DATA,
+  UAS_STAGE_SENSE,      // data phase complete, Sense IU is yet to be sent
+  UAS_STAGE_SENSE_SENT,
+};
+
+typedef struct {
+  uint16_t tag;
+  uint8_t  lun;
+  uint8_t  cdb[16];
+} uasd_cmd_t;
+
+typedef struct {
+  uint8_t  rhport;
+  uint8_t  itf_num;
+  uint8_t  ep_cmd;
+  uint8_t  ep_status;
+  uint8_t  ep_din;
+  uint8_t  ep_dout;
+
+  // commands in order of arrival, queue[0] is in progress unless stage is idle
+  uasd_cmd_t queue[CFG_TUD_UAS_QUEUE_DEPTH];
+  uint8_t  count;
+
+  uint8_t  stage;
+  uint8_t  status;        // SCSI status of command in progress
+  bool     ready_pending; // Read/Write Ready IU is yet to be sent
+  bool     data_out;      // command has Data-Out: WRITE or built-in e.g UNMAP
+  bool     cmd_armed;     // command pipe is waiting for next IU
+  bool     status_busy;
+  bool     data_busy;
+  bool     io_wait;       // media is not ready, retried on next SOF or tud_msc_media_ready()
+  uint16_t busy_luns;     // LUNs which returned busy since last retry
+
+  // Response IU to task management or rejected IU, command pipe is paused until it is sent
+  bool     resp_pending;
+  uint8_t  resp_code;
+  uint16_t resp_tag;
+
+  // Data phase
+  uint64_t lba;
+  uint32_t block_size;
+  uint32_t total_len;
+  uint32_t xferred_len;   // bytes transferred on data pipe
+  uint32_t io_len;        // WRITE: bytes written to media
+  uint16_t buf_len;       // WRITE: bytes received in data buffer
+  uint16_t buf_ofs;       // WRITE: bytes of data buffer already written to media
+} uasd_interface_t;
+
+static uasd_interface_t _uasd_itf;
+
+CFG_TUD_MEM_SECTION static struct {
+  TUD_EPBUF_TYPE_DEF(uas_cmd_iu_t, cmd);
+  TUD_EPBUF_DEF(status, sizeof(uas_sense_iu_t) + sizeof(scsi_sense_fixed_resp_t));
+  TUD_EPBUF_DEF(data, CFG_TUD_UAS_EP_BUFSIZE);
+} _uasd_epbuf;
+
+//--------------------------------------------------------------------+
+// Helper
+//--------------------------------------------------------------------+
+static void proc_cmd_start(uint8_t rhport, uasd_interface_t* p_uas);
+static void proc_data_next(uint8_t rhport, uasd_interface_t* p_uas);
+static void proc_status_next(uint8_t rhport, uasd_interface_t* p_uas);
+static void io_wait_start(uint8_t rhport, uasd_interface_t* p_uas);
+
+TU_ATTR_ALWAYS_INLINE static inline bool is_read_cmd(uint8_t cmd) {
+  return cmd == SCSI_CMD_READ_10 || cmd == SCSI_CMD_READ_16;
+}
+
+TU_ATTR_ALWAYS_INLINE static inline bool is_write_cmd(uint8_t cmd) {
+  return cmd == SCSI_CMD_WRITE_10 || cmd == SCSI_CMD_WRITE_16;
+}
+
+// READ/WRITE 10 or 16, fields are Big Endian
+static uint64_t rdwr_get_lba(uint8_t const cdb[]) {
+  if (cdb[0] == SCSI_CMD_READ_16 || cdb[0] == SCSI_CMD_WRITE_16) {
+    uint8_t const* p_lba = cdb + offsetof(scsi_write16_t, lba);
+    uint32_t const lba_hi = tu_unaligned_read32(p_lba);
+    uint32_t const lba_lo = tu_unaligned_read32(p_lba + 4);
+    return (((uint64_t) tu_ntohl(lba_hi)) << 32) | tu_ntohl(lba_lo);
+  }
+  return tu_ntohl(tu_unaligned_read32(cdb + offsetof(scsi_write10_t, lba)));
+}
+
+static uint32_t rdwr_get_blockcount(uint8_t const cdb[]) {
+  if (cdb[0] == SCSI_CMD_READ_16 || cdb[0] == SCSI_CMD_WRITE_16) {
+    return tu_ntohl(tu_unaligned_read32(cdb + offsetof(scsi_write16_t, block_count)));
+  }
+  return tu_ntohs(tu_unaligned_read16(cdb + offsetof(scsi_write10_t, block_count)));
+}
+
+static void queue_remove(uasd_interface_t* p_uas, uint8_t idx) {
+  memmove(&p_uas->queue[idx], &p_uas->queue[idx + 1], (size_t) (p_uas->count - idx - 1) * sizeof(uasd_cmd_t));
+  p_uas->count--;
+}
+
+static bool queue_has_tag(uasd_interface_t const* p_uas, uint16_t tag) {
+  for (uint8_t i = 0; i < p_uas->count; i++) {
+    if (p_uas->queue[i].tag == tag) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// arm command pipe while there is room for another command
+static void cmd_pipe_arm(uint8_t rhport, uasd_interface_t* p_uas) {
+  if (!p_uas->cmd_armed && !p_uas->resp_pending && p_uas->count < CFG_TUD_UAS_QUEUE_DEPTH) {
+    p_uas->cmd_armed = usbd_edpt_xfer(rhport, p_uas->ep_cmd, (uint8_t*) &_uasd_epbuf.cmd, sizeof(uas_cmd_iu_t));
+  }
+}
+
+static void set_response(uasd_interface_t* p_uas, uint16_t tag, uint8_t code) {
+  p_uas->resp_pending = true;
+  p_uas->resp_tag     = tag;
+  p_uas->resp_code    = code;
+}
+
+// command in progress failed, sense data is reported in Sense IU
+static void fail_cmd(uasd_interface_t* p_uas) {
+  p_uas->status = SCSI_STATUS_CHECK_CONDITION;
+  if (!is_write_cmd(p_uas->queue[0].cdb[0]) || p_uas->buf_len == 0) {
+    // WRITE continues to drain data host already started to send, otherwise data phase ends here
+    p_uas->stage = UAS_STAGE_SENSE;
+    if (p_uas->xferred_len == 0) {
+      p_uas->ready_pending = false; // host has not been told to transfer data
+    }
+  }
+}
+
+//--------------------------------------------------------------------+
+// APPLICATION API
+//--------------------------------------------------------------------+
+uint8_t tud_uas_queued_count(void) {
+  return _uasd_itf.count;
+}
+
+//--------------------------------------------------------------------+
+// USBD Driver API
+//--------------------------------------------------------------------+
+void uasd_init(void) {
+  tu_memclr(&_uasd_itf, sizeof(uasd_interface_t));
+}
+
+void uasd_reset(uint8_t rhport) {
+  (void) rhport;
+  tu_memclr(&_uasd_itf, sizeof(uasd_interface_t));
+}
+
+uint16_t uasd_open(uint8_t rhport, tusb_desc_interface_t const * itf_desc, uint16_t max_len) {
+  TU_VERIFY(TUSB_CLASS_MSC    == itf_desc->bInterfaceClass &&
+            MSC_SUBCLASS_SCSI == itf_desc->bInterfaceSubClass &&
+            MSC_PROTOCOL_UAS  == itf_desc->bInterfaceProtocol, 0);
+  uint16_t const drv_len = TUD_UAS_DESC_LEN;
+  TU_ASSERT(itf_desc->bNumEndpoints == 4 && max_len >= drv_len, 0); // 1 interface + 4 (endpoint + pipe usage)
+
+  uasd_interface_t* p_uas = &_uasd_itf;
+  p_uas->rhport  = rhport;
+  p_uas->itf_num = itf_desc->bInterfaceNumber;
+
+  // each endpoint is followed by pipe usage descriptor telling its role
+  uint8_t const* p_desc = tu_desc_next(itf_desc);
+  for (uint8_t i = 0; i < 4; i++) {
+    tusb_desc_endpoint_t const* desc_ep = (tusb_desc_endpoint_t const*) p_desc;
+    TU_ASSERT(TUSB_DESC_ENDPOINT == tu_desc_type(desc_ep) && TUSB_XFER_BULK == desc_ep->bmAttributes.xfer, 0);
+    p_desc = tu_desc_next(p_desc);
+    TU_ASSERT(UAS_DESC_PIPE_USAGE == tu_desc_type(p_desc), 0);
+    TU_ASSERT(usbd_edpt_open(rhport, desc_ep), 0);
+
+    uint8_t const ep_addr = desc_ep->bEndpointAddress;
+    switch (p_desc[2]) {
+      case UAS_PIPE_COMMAND:  p_uas->ep_cmd    = ep_addr; break;
+      case UAS_PIPE_STATUS:   p_uas->ep_status = ep_addr; break;
+      case UAS_PIPE_DATA_IN:  p_uas->ep_din    = ep_addr; break;
+      case UAS_PIPE_DATA_OUT: p_uas->ep_dout   = ep_addr; break;
+      default: break;
+    }
+    p_desc = tu_desc_next(p_desc);
+  }
+  TU_ASSERT(p_uas->ep_cmd && p_uas->ep_status && p_uas->ep_din && p_uas->ep_dout, 0);
+
+  cmd_pipe_arm(rhport, p_uas);
+
+  return drv_len;
+}
+
+// UAS has no class-specific request, endpoint halt is handled by usbd
+bool uasd_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t const * request) {
+  (void) rhport;
+  (void) stage;
+  (void) request;
+  return false;
+}
+
+//--------------------------------------------------------------------+
+// Information Unit
+//--------------------------------------------------------------------+
+static uint8_t proc_task_mgmt(uasd_interface_t* p_uas, uas_task_mgmt_iu_t const* tm) {
+  uint16_t const task_tag = tu_ntohs(tm->task_tag);
+  uint8_t const lun = tm->lun[1];
+  uint8_t const first = (p_uas->stage == UAS_STAGE_IDLE) ? 0 : 1; // first command not yet started
+
+  TU_LOG_DRV("  UAS Task Management [Lun%u]: %02X\r\n", lun, tm->function);
+
+  switch (tm->function) {
+    case UAS_TMF_ABORT_TASK:
+      for (uint8_t i = 0; i < p_uas->count; i++) {
+        if (p_uas->queue[i].tag == task_tag) {
+          if (i < first) {
+            return UAS_RC_TMF_FAILED; // data transfer in progress cannot be cancelled
+          }
+          queue_remove(p_uas, i);
+          break;
+        }
+      }
+      return UAS_RC_TMF_COMPLETE;
+
+    case UAS_TMF_ABORT_TASK_SET:
+    case UAS_TMF_CLEAR_TASK_SET:
+    case UAS_TMF_LOGICAL_UNIT_RESET:
+    case UAS_TMF_IT_NEXUS_RESET:
+      // command in progress runs to completion
+      for (uint8_t i = p_uas->count; i > first; i--) {
+        if (tm->function == UAS_TMF_IT_NEXUS_RESET || p_uas->queue[i - 1].lun == lun) {
+          queue_remove(p_uas, (uint8_t) (i - 1));
+        }
+      }
+      return UAS_RC_TMF_COMPLETE;
+
+    case UAS_TMF_QUERY_TASK:
+      return queue_has_tag(p_uas, task_tag) ? UAS_RC_TMF_SUCCEEDED : UAS_RC_TMF_COMPLETE;
+
+    default:
+      return UAS_RC_TMF_NOT_SUPPORTED;
+  }
+}
+
+// new IU on command pipe: queue command or respond to task management
+static void proc_cmd_pipe(uasd_interface_t* p_uas, uint32_t xferred_bytes) {
+  uint8_t const* iu = (uint8_t const*) &_uasd_epbuf.cmd;
+  if (xferred_bytes < sizeof(uas_ready_iu_t)) {
+    return; // too short to even have a tag, ignore it
+  }
+
+  uint16_t const tag = tu_ntohs(tu_unaligned_read16(iu + 2));
+  uint8_t const lun = iu[8 + 1]; // single level LUN
+  uint8_t maxlun = 1;
+  if (tud_msc_get_maxlun_cb) {
+    maxlun = tud_msc_get_maxlun_cb();
+  }
+
+  if (iu[0] == UAS_IU_COMMAND && xferred_bytes == sizeof(uas_cmd_iu_t)) {
+    uas_cmd_iu_t const* cmd_iu = &_uasd_epbuf.cmd;
+    if (queue_has_tag(p_uas, tag)) {
+      set_response(p_uas, tag, UAS_RC_OVERLAPPED_TAG);
+    } else if (lun >= maxlun) {
+      set_response(p_uas, tag, UAS_RC_INCORRECT_LUN);
+    } else if (cmd_iu->add_cdb_len >> 2) {
+      set_response(p_uas, tag, UAS_RC_INVALID_IU); // CDB longer than 16 bytes is not supported
+    } else {
+      uasd_cmd_t* cmd = &p_uas->queue[p_uas->count++];
+      cmd->tag = tag;
+      cmd->lun = lun;
+      memcpy(cmd->cdb, cmd_iu->cdb, sizeof(cmd->cdb));
+    }
+  } else if (iu[0] == UAS_IU_TASK_MGMT && xferred_bytes >= sizeof(uas_task_mgmt_iu_t)) {
+    if (queue_has_tag(p_uas, tag)) {
+      set_response(p_uas, tag, UAS_RC_OVERLAPPED_TAG);
+    } else if (lun >= maxlun) {
+      set_response(p_uas, tag, UAS_RC_INCORRECT_LUN);
+    } else {
+      set_response(p_uas, tag, proc_task_mgmt(p_uas, (uas_task_mgmt_iu_t const*) iu));
+    }
+  } else {
+    set_response(p_uas, tag, UAS_RC_INVALID_IU);
+  }
+}
+
+// status pipe carries one IU at a time: Response IU first, then Ready or Sense IU of command in progress
+static void proc_status_next(uint8_t rhport, uasd_interface_t* p_uas) {
+  if (p_uas->status_busy) {
+    return;
+  }
+
+  uint8_t* buf = _uasd_epbuf.status;
+  uint16_t len = 0;
+
+  if (p_uas->resp_pending) {
+    uas_response_iu_t* resp = (uas_response_iu_t*) buf;
+    tu_memclr(resp, sizeof(uas_response_iu_t));
+    resp->iu_id = UAS_IU_RESPONSE;
+    resp->tag   = tu_htons(p_uas->resp_tag);
+    resp->code  = p_uas->resp_code;
+    len = sizeof(uas_response_iu_t);
+    p_uas->resp_pending = false;
+  } else if (p_uas->stage == UAS_STAGE_DATA && p_uas->ready_pending) {
+    uas_ready_iu_t* ready = (uas_ready_iu_t*) buf;
+    ready->iu_id     = p_uas->data_out ? UAS_IU_WRITE_READY : UAS_IU_READ_READY;
+    ready->reserved1 = 0;
+    ready->tag       = tu_htons(p_uas->queue[0].tag);
+    len = sizeof(uas_ready_iu_t);
+    p_uas->ready_pending = false;
+  } else if (p_uas->stage == UAS_STAGE_SENSE) {
+    uasd_cmd_t const* cmd = &p_uas->queue[0];
+    uas_sense_iu_t* sense = (uas_sense_iu_t*) buf;
+    tu_memclr(sense, sizeof(uas_sense_iu_t));
+    sense->iu_id  = UAS_IU_SENSE;
+    sense->tag    = tu_htons(cmd->tag);
+    sense->status = p_uas->status;
+    len = sizeof(uas_sense_iu_t);
+
+    if (p_uas->status != SCSI_STATUS_GOOD) {
+      int32_t const sense_len = mscd_scsi_sense(cmd->lun, buf + sizeof(uas_sense_iu_t), sizeof(scsi_sense_fixed_resp_t));
+      if (sense_len > 0) {
+        sense->len = tu_htons((uint16_t) sense_len);
+        len = (uint16_t) (len + sense_len);
+      }
+    }
+
+    TU_LOG_DRV("  UAS Sense [Lun%u] tag %u = %u\r\n", cmd->lun, cmd->tag, p_uas->status);
+    p_uas->stage = UAS_STAGE_SENSE_SENT;
+  } else {
+    return; // nothing to send
+  }
+
+  p_uas->status_busy = true;
+  TU_ASSERT(usbd_edpt_xfer(rhport, p_uas->ep_status, buf, len),);
+}
+
+//--------------------------------------------------------------------+
+// SCSI Command Process
+//--------------------------------------------------------------------+
+
+// start oldest queued command once previous one is complete
+static void proc_cmd_start(uint8_t rhport, uasd_interface_t* p_uas) {
+  if (p_uas->stage != UAS_STAGE_IDLE || p_uas->count == 0) {
+    return;
+  }
+
+  uasd_cmd_t const* cmd = &p_uas->queue[0];
+  uint8_t const opcode = cmd->cdb[0];
+
+  TU_LOG_DRV("  UAS Command [Lun%u] tag %u: %02X\r\n", cmd->lun, cmd->tag, opcode);
+
+  p_uas->stage         = UAS_STAGE_DATA;
+  p_uas->status        = SCSI_STATUS_GOOD;
+  p_uas->ready_pending = false;
+  p_uas->data_out      = is_write_cmd(opcode);
+  p_uas->total_len     = 0;
+  p_uas->xferred_len   = 0;
+  p_uas->io_len        = 0;
+  p_uas->buf_len       = 0;
+  p_uas->buf_ofs       = 0;
+
+  uint32_t const out_len = (is_read_cmd(opcode) || is_write_cmd(opcode)) ? 0 : mscd_scsi_out_len(cmd->lun, cmd->cdb);
+
+  if (is_read_cmd(opcode) || is_write_cmd(opcode)) {
+    uint32_t const block_count = rdwr_get_blockcount(cmd->cdb);
+    uint64_t capacity;
+    mscd_get_capacity(cmd->lun, &capacity, &p_uas->block_size);
+    p_uas->lba = rdwr_get_lba(cmd->cdb);
+
+    if (capacity == 0 || p_uas->block_size == 0) {
+      tud_msc_set_sense(cmd->lun, SCSI_SENSE_NOT_READY, 0x3A, 0x00); // medium not present
+      fail_cmd(p_uas);
+    } else if ((uint64_t) block_count * p_uas->block_size > UINT32_MAX) {
+      fail_cmd(p_uas); // transfer is too large
+    } else if (is_write_cmd(opcode) && tud_msc_is_writable_cb && !tud_msc_is_writable_cb(cmd->lun)) {
+      tud_msc_set_sense(cmd->lun, SCSI_SENSE_DATA_PROTECT, 0x27, 0x00); // write protected
+      fail_cmd(p_uas);
+    } else {
+      p_uas->total_len = block_count * p_uas->block_size;
+      proc_data_next(rhport, p_uas);
+    }
+  } else if (out_len) {
+    // built-in Data-Out command e.g UNMAP, executed once data is received
+    if (out_len > CFG_TUD_UAS_EP_BUFSIZE) {
+      tud_msc_set_sense(cmd->lun, SCSI_SENSE_ILLEGAL_REQUEST, 0x1A, 0x00); // parameter list length error
+      fail_cmd(p_uas);
+    } else {
+      p_uas->total_len     = out_len;
+      p_uas->data_out      = true;
+      p_uas->ready_pending = true;
+      p_uas->data_busy     = true;
+      TU_ASSERT(usbd_edpt_xfer(rhport, p_uas->ep_dout, _uasd_epbuf.data, (uint16_t) out_len),);
+    }
+  } else {
+    // other commands are Data-In or no-data: built-in or application callback
+    int32_t const resplen = mscd_scsi_cmd(cmd->lun, cmd->cdb, _uasd_epbuf.data, CFG_TUD_UAS_EP_BUFSIZE,
+                                          CFG_TUD_UAS_EP_BUFSIZE);
+    if (resplen < 0) {
+      TU_LOG_DRV("  UAS unsupported or failed command\r\n");
+      fail_cmd(p_uas);
+    } else if (resplen == 0) {
+      p_uas->stage = UAS_STAGE_SENSE;
+    } else {
+      p_uas->total_len     = tu_min32((uint32_t) resplen, CFG_TUD_UAS_EP_BUFSIZE);
+      p_uas->ready_pending = true;
+      p_uas->data_busy     = true;
+      TU_ASSERT(usbd_edpt_xfer(rhport, p_uas->ep_din, _uasd_epbuf.data, (uint16_t) p_uas->total_len),);
+    }
+  }
+}
+
+// retry media access which returned busy
+static void proc_io_retry(void* param) {
+  (void) param;
+  uasd_interface_t* p_uas = &_uasd_itf;
+  TU_VERIFY(p_uas->io_wait,);
+  p_uas->io_wait   = false;
+  p_uas->busy_luns = 0;
+  usbd_sof_enable(p_uas->rhport, SOF_CONSUMER_UAS, false);
+  TU_VERIFY(p_uas->stage == UAS_STAGE_DATA,);
+  proc_data_next(p_uas->rhport, p_uas);
+  proc_status_next(p_uas->rhport, p_uas);
+}
+
+// Media returned busy. A READ which host has not been told about yet gives way to a queued command of another LUN,
+// so that a slow media does not hold up the others. Otherwise wait for next SOF or tud_msc_media_ready() to retry.
+static void io_wait_start(uint8_t rhport, uasd_interface_t* p_uas) {
+  p_uas->busy_luns |= (uint16_t) TU_BIT(p_uas->queue[0].lun & 0x0F);
+
+  if (is_read_cmd(p_uas->queue[0].cdb[0]) && p_uas->xferred_len == 0) {
+    for (uint8_t i = 1; i < p_uas->count; i++) {
+      if (!(p_uas->busy_luns & TU_BIT(p_uas->queue[i].lun & 0x0F))) {
+        TU_LOG_DRV("  UAS Lun%u busy, start tag %u first\r\n", p_uas->queue[0].lun, p_uas->queue[i].tag);
+        uasd_cmd_t const cmd = p_uas->queue[i];
+        memmove(&p_uas->queue[1], &p_uas->queue[0], i * sizeof(uasd_cmd_t));
+        p_uas->queue[0] = cmd;
+        p_uas->stage = UAS_STAGE_IDLE;
+        proc_cmd_start(rhport, p_uas);
+        return;
+      }
+    }
+  }
+
+  p_uas->io_wait = true;
+  usbd_sof_enable(rhport, SOF_CONSUMER_UAS, true);
+}
+
+bool uasd_media_ready(uint8_t lun, bool in_isr) {
+  (void) lun; // any ready LUN may be the one to switch to
+  TU_VERIFY(_uasd_itf.io_wait);
+  usbd_defer_func(proc_io_retry, NULL, in_isr);
+  return true;
+}
+
+void uasd_sof(uint8_t rhport, uint32_t frame_count) {
+  (void) rhport;
+  (void) frame_count;
+  if (_uasd_itf.io_wait) {
+    usbd_defer_func(proc_io_retry, NULL, true);
+  }
+}
+
+// READ/WRITE data phase: media access of one chunk at a time over data buffer
+static void proc_data_next(uint8_t rhport, uasd_interface_t* p_uas) {
+  uasd_cmd_t const* cmd = &p_uas->queue[0];
+  if (p_uas->stage != UAS_STAGE_DATA || p_uas->data_busy) {
+    return;
+  }
+
+  if (is_read_cmd(cmd->cdb[0])) {
+    if (p_uas->xferred_len >= p_uas->total_len) {
+      p_uas->stage = UAS_STAGE_SENSE;
+      return;
+    }
+
+    uint32_t const nbytes = tu_min32(CFG_TUD_UAS_EP_BUFSIZE, p_uas->total_len - p_uas->xferred_len);
+    uint64_t const lba = p_uas->lba + p_uas->xferred_len / p_uas->block_size;
+    uint32_t const offset = p_uas->xferred_len % p_uas->block_size;
+
+    // memory-mapped media is sent without copy
+    void const* mapped = NULL;
+    int32_t const nmapped = mscd_media_read_ptr(cmd->lun, lba, offset, &mapped, p_uas->total_len - p_uas->xferred_len);
+    if (nmapped > 0 && mscd_xfer_mapped(rhport, p_uas->ep_din, mapped, (uint32_t) nmapped) > 0) {
+      p_uas->ready_pending = p_uas->ready_pending || (p_uas->xferred_len == 0);
+      p_uas->data_busy = true;
+      return;
+    }
+
+    int32_t const result = mscd_media_read(cmd->lun, lba, offset, _uasd_epbuf.data, nbytes);
+
+    if (result == 0) {
+      io_wait_start(rhport, p_uas);
+    } else if (result < 0) {
+      if (result == TUD_MSC_RET_ASYNC) {
+        TU_LOG_DRV("  UAS does not support asynchronous media access\r\n");
+      }
+      fail_cmd(p_uas);
+    } else {
+      p_uas->busy_luns &= (uint16_t) ~TU_BIT(cmd->lun & 0x0F);
+      p_uas->ready_pending = p_uas->ready_pending || (p_uas->xferred_len == 0);
+      p_uas->data_busy = true;
+      TU_ASSERT(usbd_edpt_xfer(rhport, p_uas->ep_din, _uasd_epbuf.data, (uint16_t) tu_min32((uint32_t) result, nbytes)),);
+    }
+  } else {
+    // write received data to media, discard it if command already failed
+    while (p_uas->buf_ofs < p_uas->buf_len && p_uas->status == SCSI_STATUS_GOOD) {
+      uint64_t const lba = p_uas->lba + p_uas->io_len / p_uas->block_size;
+      uint32_t const offset = p_uas->io_len % p_uas->block_size;
+      int32_t const result = mscd_media_write(cmd->lun, lba, offset, _uasd_epbuf.data + p_uas->buf_ofs,
+                                              (uint32_t) (p_uas->buf_len - p_uas->buf_ofs));
+      if (result == 0) {
+        io_wait_start(rhport, p_uas);
+        return;
+      } else if (result < 0) {
+        if (result == TUD_MSC_RET_ASYNC) {
+          TU_LOG_DRV("  UAS does not support asynchronous media access\r\n");
+        }
+        fail_cmd(p_uas);
+      } else {
+        uint16_t const written = (uint16_t) tu_min32((uint32_t) result, (uint32_t) (p_uas->buf_len - p_uas->buf_ofs));
+        p_uas->buf_ofs = (uint16_t) (p_uas->buf_ofs + written);
+        p_uas->io_len += written;
+      }
+    }
+    p_uas->buf_len = 0;
+    p_uas->buf_ofs = 0;
+
+    if (p_uas->xferred_len >= p_uas->total_len) {
+      p_uas->stage = UAS_STAGE_SENSE;
+    } else {
+      uint16_t const nbytes = (uint16_t) tu_min32(CFG_TUD_UAS_EP_BUFSIZE, p_uas->total_len - p_uas->xferred_len);
+      p_uas->ready_pending = p_uas->ready_pending || (p_uas->xferred_len == 0);
+      p_uas->data_busy = true;
+      TU_ASSERT(usbd_edpt_xfer(rhport, p_uas->ep_dout, _uasd_epbuf.data, nbytes),);
+    }
+  }
+}
+
+static void proc_cmd_complete(uasd_interface_t* p_uas) {
+  uasd_cmd_t const* cmd = &p_uas->queue[0];
+
+  switch (cmd->cdb[0]) {
+    case SCSI_CMD_READ_10:
+    case SCSI_CMD_READ_16:
+      if (tud_msc_read10_complete_cb) {
+        tud_msc_read10_complete_cb(cmd->lun);
+      }
+      break;
+
+    case SCSI_CMD_WRITE_10:
+    case SCSI_CMD_WRITE_16:
+      if (tud_msc_write10_complete_cb) {
+        tud_msc_write10_complete_cb(cmd->lun);
+      }
+      break;
+
+    default:
+      if (tud_msc_scsi_complete_cb) {
+        tud_msc_scsi_complete_cb(cmd->lun, cmd->cdb);
+      }
+      break;
+  }
+
+  queue_remove(p_uas, 0);
+  p_uas->stage = UAS_STAGE_IDLE;
+}
+
+bool uasd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t event, uint32_t xferred_bytes) {
+  (void) event;
+  uasd_interface_t* p_uas = &_uasd_itf;
+
+  if (ep_addr == p_uas->ep_cmd) {
+    p_uas->cmd_armed = false;
+    proc_cmd_pipe(p_uas, xferred_bytes);
+  } else if (ep_addr == p_uas->ep_status) {
+    p_uas->status_busy = false;
+    if (p_uas->stage == UAS_STAGE_SENSE_SENT) {
+      proc_cmd_complete(p_uas);
+    }
+  } else if (ep_addr == p_uas->ep_din) {
+    p_uas->data_busy = false;
+    p_uas->xferred_len += xferred_bytes;
+    if (is_read_cmd(p_uas->queue[0].cdb[0])) {
+      proc_data_next(rhport, p_uas);
+    } else {
+      p_uas->stage = UAS_STAGE_SENSE;
+    }
+  } else if (ep_addr == p_uas->ep_dout && !is_write_cmd(p_uas->queue[0].cdb[0])) {
+    p_uas->data_busy = false;
+    p_uas->xferred_len += xferred_bytes;
+    uasd_cmd_t const* cmd = &p_uas->queue[0];
+    if (mscd_scsi_out(cmd->lun, cmd->cdb, _uasd_epbuf.data, p_uas->xferred_len) < 0) {
+      fail_cmd(p_uas);
+    } else {
+      p_uas->stage = UAS_STAGE_SENSE;
+    }
+  } else if (ep_addr == p_uas->ep_dout) {
+    p_uas->data_busy = false;
+    p_uas->xferred_len += xferred_bytes;
+    p_uas->buf_len = (uint16_t) xferred_bytes;
+    p_uas->buf_ofs = 0;
+    if (xferred_bytes == 0) {
+      p_uas->total_len = p_uas->xferred_len; // host ended data early
+    }
+    proc_data_next(rhport, p_uas);
+  } else {
+    return false;
+  }
+
+  cmd_pipe_arm(rhport, p_uas);
+  proc_cmd_start(rhport, p_uas);
+  proc_status_next(rhport, p_uas);
+
+  return true;
+}
+
+#endif
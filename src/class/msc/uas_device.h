@@ -0,0 +1,92 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#ifndef _TUSB_UAS_DEVICE_H_
+#define _TUSB_UAS_DEVICE_H_
+
+#include "common/tusb_common.h"
+#include "msc_device.h"
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+// USB Attached SCSI (UAS) transport. It shares the SCSI layer and all tud_msc_*_cb() callbacks with the MSC driver
+// (CFG_TUD_MSC must be enabled), only the transport differs: host can queue several commands identified by their
+// tag, each command has its own status (Sense IU) instead of one CBW/CSW exchange at a time.
+//
+// Only USB 2.0 multi-pipe mode without bulk streams is supported: device services queued commands one at a time in
+// arrival order, announcing the one owning the data pipes with Read Ready/Write Ready IU on the status pipe.
+// Limitations:
+// - Commands other than READ/WRITE (10/16) are Data-In or no-data, data is from built-in or tud_msc_scsi_cb().
+//   Only built-in UNMAP and WRITE SAME have Data-Out
+// - Media callbacks must complete synchronously, TUD_MSC_RET_ASYNC is treated as error
+// - ABORT TASK of the command currently transferring data fails, queued commands can be aborted
+
+//--------------------------------------------------------------------+
+// Class Driver Configuration
+//--------------------------------------------------------------------+
+
+#if !CFG_TUD_MSC
+  #error CFG_TUD_UAS requires CFG_TUD_MSC for SCSI callbacks
+#endif
+
+// Number of commands host can queue
+#ifndef CFG_TUD_UAS_QUEUE_DEPTH
+  #define CFG_TUD_UAS_QUEUE_DEPTH   4
+#endif
+
+// Data pipe buffer size, should be multiple of bulk packet size
+#ifndef CFG_TUD_UAS_EP_BUFSIZE
+  #define CFG_TUD_UAS_EP_BUFSIZE    CFG_TUD_MSC_EP_BUFSIZE
+#endif
+
+TU_VERIFY_STATIC(CFG_TUD_UAS_QUEUE_DEPTH > 0 && CFG_TUD_UAS_QUEUE_DEPTH < UINT8_MAX, "Depth is not correct");
+TU_VERIFY_STATIC(CFG_TUD_UAS_EP_BUFSIZE >= 64 && CFG_TUD_UAS_EP_BUFSIZE < UINT16_MAX, "Size is not correct");
+
+//--------------------------------------------------------------------+
+// Application API
+//--------------------------------------------------------------------+
+
+// Number of commands currently queued including the one in progress
+uint8_t tud_uas_queued_count(void);
+
+//--------------------------------------------------------------------+
+// Internal Class Driver API
+//--------------------------------------------------------------------+
+void     uasd_init            (void);
+void     uasd_reset           (uint8_t rhport);
+uint16_t uasd_open            (uint8_t rhport, tusb_desc_interface_t const * itf_desc, uint16_t max_len);
+bool     uasd_control_xfer_cb (uint8_t rhport, uint8_t stage, tusb_control_request_t const * p_request);
+bool     uasd_xfer_cb         (uint8_t rhport, uint8_t ep_addr, xfer_result_t event, uint32_t xferred_bytes);
+void     uasd_sof             (uint8_t rhport, uint32_t frame_count);
+bool     uasd_media_ready     (uint8_t lun, bool in_isr);
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif /* _TUSB_UAS_DEVICE_H_ */
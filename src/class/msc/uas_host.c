@@ -0,0 +1,672 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#include "tusb_option.h"
+
+#if CFG_TUH_ENABLED && CFG_TUH_UAS
+
+#include "host/usbh.h"
+#include "host/usbh_pvt.h"
+
+#include "uas_host.h"
+
+// Level where CFG_TUSB_DEBUG must be at least for this driver is logged
+#ifndef CFG_TUH_UAS_LOG_LEVEL
+  #define CFG_TUH_UAS_LOG_LEVEL   CFG_TUH_LOG_LEVEL
+#endif
+
+#define TU_LOG_DRV(...)   TU_LOG(CFG_TUH_UAS_LOG_LEVEL, __VA_ARGS__)
+
+//--------------------------------------------------------------------+
+// MACRO CONSTANT TYPEDEF
+//--------------------------------------------------------------------+
+enum {
+  UAS_SLOT_FREE = 0,
+  UAS_SLOT_QUEUED,  // Command IU is yet to be sent
+  UAS_SLOT_SENT,    // waiting for Read/Write Ready or Sense IU
+  UAS_SLOT_DATA,    // owning data pipes
+};
+
+enum {
+  STATUS_BUFSIZE   = 64, // Sense IU with fixed format sense data and then some
+  SENSE_DATA_MAX   = sizeof(scsi_sense_fixed_resp_t),
+  ENUM_TUR_RETRY   = 10,
+  ENUM_TUR_DELAY   = 100,
+  NO_SLOT          = 0xff
+};
+
+typedef struct {
+  volatile uint8_t state;
+  uint8_t seq;             // submission order
+  uint8_t lun;
+  uint8_t dir;
+  uint8_t cdb_len;
+  uint8_t cdb[16];
+
+  bool status_received;    // Sense/Response IU is received, waiting for data transfer to complete
+  uint8_t status;
+  uint8_t sense_len;
+  uint8_t sense[SENSE_DATA_MAX];
+
+  void* buffer;
+  uint32_t total_bytes;
+  uint32_t xferred_bytes;
+  tuh_uas_complete_cb_t complete_cb;
+  uintptr_t complete_arg;
+} uash_cmd_t;
+
+typedef struct {
+  uint8_t itf_num;
+  uint8_t alt;
+  uint8_t ep_cmd;
+  uint8_t ep_status;
+  uint8_t ep_din;
+  uint8_t ep_dout;
+
+  volatile bool configured; // UAS alternate setting is selected
+  volatile bool mounted;    // Enumeration is complete
+  volatile bool kick_pending;
+
+  uint8_t seq_submit;       // written by submitter only
+  uint8_t seq_send;         // next command to send, written by usbh task only
+  uint8_t cmd_slot;         // slot whose Command IU is on command pipe, NO_SLOT if idle
+  uint8_t data_slot;        // slot owning data pipes, NO_SLOT if idle
+  uint8_t enum_retry;
+
+  uint32_t block_size;
+  uint64_t block_count;
+
+  uash_cmd_t cmd[CFG_TUH_UAS_QUEUE_DEPTH];
+} uash_interface_t;
+
+typedef struct {
+  TUH_EPBUF_TYPE_DEF(uas_cmd_iu_t, cmd);
+  TUH_EPBUF_DEF(status, STATUS_BUFSIZE);
+} uash_epbuf_t;
+
+static uash_interface_t _uash_itf[CFG_TUH_DEVICE_MAX];
+CFG_TUH_MEM_SECTION static uash_epbuf_t _uash_epbuf[CFG_TUH_DEVICE_MAX];
+
+TU_ATTR_ALWAYS_INLINE static inline uash_interface_t* get_itf(uint8_t daddr) {
+  return &_uash_itf[daddr - 1];
+}
+
+TU_ATTR_ALWAYS_INLINE static inline uash_epbuf_t* get_epbuf(uint8_t daddr) {
+  return &_uash_epbuf[daddr - 1];
+}
+
+static void cmd_send_next(uint8_t daddr);
+static void cmd_complete(uint8_t daddr, uint8_t idx);
+
+//--------------------------------------------------------------------+
+// PUBLIC API
+//--------------------------------------------------------------------+
+bool tuh_uas_mounted(uint8_t dev_addr) {
+  return get_itf(dev_addr)->mounted;
+}
+
+uint8_t tuh_uas_queued_count(uint8_t dev_addr) {
+  uash_interface_t const* p_uas = get_itf(dev_addr);
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < CFG_TUH_UAS_QUEUE_DEPTH; i++) {
+    if (p_uas->cmd[i].state != UAS_SLOT_FREE) {
+      count++;
+    }
+  }
+  return count;
+}
+
+bool tuh_uas_ready(uint8_t dev_addr) {
+  return tuh_uas_mounted(dev_addr) && tuh_uas_queued_count(dev_addr) < CFG_TUH_UAS_QUEUE_DEPTH;
+}
+
+uint64_t tuh_uas_get_block_count(uint8_t dev_addr) {
+  return get_itf(dev_addr)->block_count;
+}
+
+uint32_t tuh_uas_get_block_size(uint8_t dev_addr) {
+  return get_itf(dev_addr)->block_size;
+}
+
+// Deferred to usbh task: send queued Command IU if command pipe is idle
+static void cmd_kick(void* param) {
+  uint8_t const daddr = (uint8_t) (uintptr_t) param;
+  uash_interface_t* p_uas = get_itf(daddr);
+
+  p_uas->kick_pending = false;
+  if (p_uas->configured) {
+    cmd_send_next(daddr);
+  }
+}
+
+bool tuh_uas_scsi_command(uint8_t dev_addr, uint8_t lun, uint8_t const* cdb, uint8_t cdb_len, uint8_t dir,
+                          void* data, uint32_t total_bytes, tuh_uas_complete_cb_t complete_cb, uintptr_t arg) {
+  uash_interface_t* p_uas = get_itf(dev_addr);
+  TU_VERIFY(p_uas->configured && cdb_len <= 16);
+  TU_VERIFY(total_bytes <= UINT16_MAX && (data || total_bytes == 0)); // data is a single bulk transfer
+
+  uash_cmd_t* cmd = NULL;
+  for (uint8_t i = 0; i < CFG_TUH_UAS_QUEUE_DEPTH; i++) {
+    if (p_uas->cmd[i].state == UAS_SLOT_FREE) {
+      cmd = &p_uas->cmd[i];
+      break;
+    }
+  }
+  TU_VERIFY(cmd);
+
+  cmd->seq = p_uas->seq_submit++;
+  cmd->lun = lun;
+  cmd->dir = dir;
+  cmd->cdb_len = cdb_len;
+  memcpy(cmd->cdb, cdb, cdb_len);
+  cmd->status_received = false;
+  cmd->status = SCSI_STATUS_GOOD;
+  cmd->sense_len = 0;
+  cmd->buffer = data;
+  cmd->total_bytes = total_bytes;
+  cmd->xferred_bytes = 0;
+  cmd->complete_cb = complete_cb;
+  cmd->complete_arg = arg;
+  cmd->state = UAS_SLOT_QUEUED; // last: slot is now visible to usbh task
+
+  // Command IU is sent by usbh task, which is the only one changing pipe states
+  if (!p_uas->kick_pending) {
+    p_uas->kick_pending = true;
+    usbh_defer_func(cmd_kick, (void*) (uintptr_t) dev_addr, false);
+  }
+
+  return true;
+}
+
+static bool rw10_command(uint8_t dev_addr, uint8_t lun, uint8_t cmd_code, void* buffer, uint32_t lba,
+                         uint16_t block_count, tuh_uas_complete_cb_t complete_cb, uintptr_t arg) {
+  uash_interface_t* p_uas = get_itf(dev_addr);
+  TU_VERIFY(p_uas->mounted);
+
+  scsi_read10_t const cmd_rw10 = {
+      .cmd_code    = cmd_code,
+      .lba         = tu_htonl(lba),
+      .block_count = tu_htons(block_count)
+  };
+  uint8_t const dir = (cmd_code == SCSI_CMD_READ_10) ? TUSB_DIR_IN : TUSB_DIR_OUT;
+
+  return tuh_uas_scsi_command(dev_addr, lun, (uint8_t const*) &cmd_rw10, sizeof(cmd_rw10), dir, buffer,
+                              (uint32_t) block_count * p_uas->block_size, complete_cb, arg);
+}
+
+bool tuh_uas_read10(uint8_t dev_addr, uint8_t lun, void* buffer, uint32_t lba, uint16_t block_count,
+                    tuh_uas_complete_cb_t complete_cb, uintptr_t arg) {
+  return rw10_command(dev_addr, lun, SCSI_CMD_READ_10, buffer, lba, block_count, complete_cb, arg);
+}
+
+bool tuh_uas_write10(uint8_t dev_addr, uint8_t lun, void const* buffer, uint32_t lba, uint16_t block_count,
+                     tuh_uas_complete_cb_t complete_cb, uintptr_t arg) {
+  return rw10_command(dev_addr, lun, SCSI_CMD_WRITE_10, (void*) (uintptr_t) buffer, lba, block_count,
+                      complete_cb, arg);
+}
+
+//--------------------------------------------------------------------+
+// Pipes
+//--------------------------------------------------------------------+
+static bool status_pipe_arm(uint8_t daddr) {
+  uash_interface_t* p_uas = get_itf(daddr);
+  TU_VERIFY(usbh_edpt_claim(daddr, p_uas->ep_status));
+  if (!usbh_edpt_xfer(daddr, p_uas->ep_status, get_epbuf(daddr)->status, STATUS_BUFSIZE)) {
+    usbh_edpt_release(daddr, p_uas->ep_status);
+    return false;
+  }
+  return true;
+}
+
+// Send Command IU of oldest queued command, one at a time
+static void cmd_send_next(uint8_t daddr) {
+  uash_interface_t* p_uas = get_itf(daddr);
+  if (p_uas->cmd_slot != NO_SLOT) {
+    return;
+  }
+
+  for (uint8_t i = 0; i < CFG_TUH_UAS_QUEUE_DEPTH; i++) {
+    uash_cmd_t* cmd = &p_uas->cmd[i];
+    if (cmd->state != UAS_SLOT_QUEUED || cmd->seq != p_uas->seq_send) {
+      continue;
+    }
+
+    uas_cmd_iu_t* iu = &get_epbuf(daddr)->cmd;
+    tu_memclr(iu, sizeof(uas_cmd_iu_t));
+    iu->iu_id  = UAS_IU_COMMAND;
+    iu->tag    = tu_htons((uint16_t) (i + 1));
+    iu->lun[1] = cmd->lun; // single level LUN, task attribute is SIMPLE
+    memcpy(iu->cdb, cmd->cdb, cmd->cdb_len);
+
+    p_uas->seq_send++;
+    cmd->state = UAS_SLOT_SENT;
+
+    if (usbh_edpt_claim(daddr, p_uas->ep_cmd)) {
+      if (usbh_edpt_xfer(daddr, p_uas->ep_cmd, (uint8_t*) iu, sizeof(uas_cmd_iu_t))) {
+        p_uas->cmd_slot = i;
+        return;
+      }
+      usbh_edpt_release(daddr, p_uas->ep_cmd);
+    }
+
+    // failed to send, complete with error and try next one
+    TU_LOG_DRV("  UAS failed to send command tag %u\r\n", i + 1);
+    cmd->status = SCSI_STATUS_CHECK_CONDITION;
+    cmd_complete(daddr, i);
+    i = (uint8_t) -1; // restart search
+  }
+}
+
+// Read/Write Ready: tagged command owns data pipes
+static void data_start(uint8_t daddr, uint8_t idx, uint8_t dir) {
+  uash_interface_t* p_uas = get_itf(daddr);
+  uash_cmd_t* cmd = &p_uas->cmd[idx];
+
+  if (cmd->state != UAS_SLOT_SENT || cmd->dir != dir || p_uas->data_slot != NO_SLOT) {
+    TU_LOG_DRV("  UAS unexpected Ready IU for tag %u\r\n", idx + 1);
+    return;
+  }
+
+  uint8_t const ep_data = (dir == TUSB_DIR_IN) ? p_uas->ep_din : p_uas->ep_dout;
+  cmd->state = UAS_SLOT_DATA;
+  p_uas->data_slot = idx;
+
+  if (usbh_edpt_claim(daddr, ep_data)) {
+    if (usbh_edpt_xfer(daddr, ep_data, (uint8_t*) cmd->buffer, (uint16_t) cmd->total_bytes)) {
+      return;
+    }
+    usbh_edpt_release(daddr, ep_data);
+  }
+
+  // device still sends Sense IU of this command which completes it
+  TU_LOG_DRV("  UAS failed to start data transfer of tag %u\r\n", idx + 1);
+  cmd->state = UAS_SLOT_SENT;
+  p_uas->data_slot = NO_SLOT;
+}
+
+static void cmd_complete(uint8_t daddr, uint8_t idx) {
+  uash_cmd_t* cmd = &get_itf(daddr)->cmd[idx];
+
+  // slot can be reused within callback: keep a copy of sense data
+  uint8_t sense[SENSE_DATA_MAX];
+  memcpy(sense, cmd->sense, cmd->sense_len);
+
+  tuh_uas_complete_data_t const cb_data = {
+      .tag = (uint16_t) (idx + 1),
+      .lun = cmd->lun,
+      .status = cmd->status,
+      .sense_len = cmd->sense_len,
+      .sense = sense,
+      .scsi_data = cmd->buffer,
+      .xferred_bytes = cmd->xferred_bytes,
+      .user_arg = cmd->complete_arg
+  };
+  tuh_uas_complete_cb_t const complete_cb = cmd->complete_cb;
+  cmd->state = UAS_SLOT_FREE;
+
+  if (complete_cb) {
+    complete_cb(daddr, &cb_data);
+  }
+}
+
+static void status_process(uint8_t daddr, uint8_t const* buf, uint32_t len) {
+  uash_interface_t* p_uas = get_itf(daddr);
+  TU_VERIFY(len >= sizeof(uas_ready_iu_t),);
+
+  uas_ready_iu_t const* hdr = (uas_ready_iu_t const*) buf;
+  uint16_t const tag = tu_ntohs(hdr->tag);
+  if (tag == 0 || tag > CFG_TUH_UAS_QUEUE_DEPTH || p_uas->cmd[tag - 1].state < UAS_SLOT_SENT) {
+    TU_LOG_DRV("  UAS IU %02X with unknown tag %u\r\n", hdr->iu_id, tag);
+    return;
+  }
+
+  uint8_t const idx = (uint8_t) (tag - 1);
+  uash_cmd_t* cmd = &p_uas->cmd[idx];
+
+  switch (hdr->iu_id) {
+    case UAS_IU_READ_READY:
+      data_start(daddr, idx, TUSB_DIR_IN);
+      return;
+
+    case UAS_IU_WRITE_READY:
+      data_start(daddr, idx, TUSB_DIR_OUT);
+      return;
+
+    case UAS_IU_SENSE: {
+      TU_VERIFY(len >= sizeof(uas_sense_iu_t),);
+      uas_sense_iu_t const* sense_iu = (uas_sense_iu_t const*) buf;
+      uint32_t const sense_len = tu_min32(tu_ntohs(sense_iu->len), len - sizeof(uas_sense_iu_t));
+      cmd->status = sense_iu->status;
+      cmd->sense_len = (uint8_t) tu_min32(sense_len, SENSE_DATA_MAX);
+      memcpy(cmd->sense, buf + sizeof(uas_sense_iu_t), cmd->sense_len);
+      break;
+    }
+
+    case UAS_IU_RESPONSE: {
+      // command is rejected e.g invalid IU, overlapped tag or incorrect LUN
+      TU_LOG_DRV("  UAS Response IU tag %u: code %u\r\n", tag,
+                 len >= sizeof(uas_response_iu_t) ? ((uas_response_iu_t const*) buf)->code : 0xff);
+      cmd->status = SCSI_STATUS_CHECK_CONDITION;
+      cmd->sense_len = 0;
+      break;
+    }
+
+    default:
+      TU_LOG_DRV("  UAS unknown IU %02X\r\n", hdr->iu_id);
+      return;
+  }
+
+  if (cmd->state == UAS_SLOT_DATA) {
+    cmd->status_received = true; // complete when data transfer completes
+  } else {
+    cmd_complete(daddr, idx);
+  }
+}
+
+//--------------------------------------------------------------------+
+// CLASS-USBH API
+//--------------------------------------------------------------------+
+bool uash_init(void) {
+  TU_LOG_DRV("sizeof(uash_interface_t) = %u\r\n", sizeof(uash_interface_t));
+  TU_LOG_DRV("sizeof(uash_epbuf_t) = %u\r\n", sizeof(uash_epbuf_t));
+  tu_memclr(_uash_itf, sizeof(_uash_itf));
+  return true;
+}
+
+bool uash_deinit(void) {
+  return true;
+}
+
+void uash_close(uint8_t dev_addr) {
+  TU_VERIFY(dev_addr <= CFG_TUH_DEVICE_MAX,);
+  uash_interface_t* p_uas = get_itf(dev_addr);
+  TU_VERIFY(p_uas->ep_cmd,);
+
+  TU_LOG_DRV("  UASh close addr = %d\r\n", dev_addr);
+
+  if (p_uas->mounted && tuh_uas_umount_cb) {
+    tuh_uas_umount_cb(dev_addr);
+  }
+
+  tu_memclr(p_uas, sizeof(uash_interface_t));
+}
+
+bool uash_xfer_cb(uint8_t dev_addr, uint8_t ep_addr, xfer_result_t event, uint32_t xferred_bytes) {
+  uash_interface_t* p_uas = get_itf(dev_addr);
+
+  if (ep_addr == p_uas->ep_status) {
+    if (event == XFER_RESULT_SUCCESS) {
+      // copy IU out then re-arm, so that next IU is received while this one is processed
+      uint8_t iu[STATUS_BUFSIZE];
+      memcpy(iu, get_epbuf(dev_addr)->status, xferred_bytes);
+      (void) status_pipe_arm(dev_addr);
+      status_process(dev_addr, iu, xferred_bytes);
+    } else {
+      TU_LOG_DRV("  UAS status pipe failed (%u)\r\n", event);
+      (void) status_pipe_arm(dev_addr);
+    }
+  } else if (ep_addr == p_uas->ep_cmd) {
+    uint8_t const idx = p_uas->cmd_slot;
+    p_uas->cmd_slot = NO_SLOT;
+
+    if (event != XFER_RESULT_SUCCESS && idx < CFG_TUH_UAS_QUEUE_DEPTH) {
+      TU_LOG_DRV("  UAS failed to send command tag %u\r\n", idx + 1);
+      p_uas->cmd[idx].status = SCSI_STATUS_CHECK_CONDITION;
+      cmd_complete(dev_addr, idx);
+    }
+
+    cmd_send_next(dev_addr);
+  } else if (ep_addr == p_uas->ep_din || ep_addr == p_uas->ep_dout) {
+    uint8_t const idx = p_uas->data_slot;
+    p_uas->data_slot = NO_SLOT;
+    TU_VERIFY(idx < CFG_TUH_UAS_QUEUE_DEPTH);
+
+    uash_cmd_t* cmd = &p_uas->cmd[idx];
+    cmd->xferred_bytes = xferred_bytes;
+    cmd->state = UAS_SLOT_SENT;
+    if (event != XFER_RESULT_SUCCESS) {
+      TU_LOG_DRV("  UAS data transfer of tag %u failed (%u)\r\n", idx + 1, event);
+    }
+
+    if (cmd->status_received) {
+      cmd_complete(dev_addr, idx);
+    }
+  }
+
+  return true;
+}
+
+//--------------------------------------------------------------------+
+// Enumeration
+//--------------------------------------------------------------------+
+static void config_set_interface_complete(tuh_xfer_t* xfer);
+static void config_test_unit_ready(uint8_t daddr);
+static bool config_test_unit_ready_complete(uint8_t dev_addr, tuh_uas_complete_data_t const* cb_data);
+static bool config_read_capacity_complete(uint8_t dev_addr, tuh_uas_complete_data_t const* cb_data);
+static bool config_read_capacity16_complete(uint8_t dev_addr, tuh_uas_complete_data_t const* cb_data);
+static void config_complete(uint8_t dev_addr, bool success);
+
+bool uash_open(uint8_t rhport, uint8_t dev_addr, tusb_desc_interface_t const* desc_itf, uint16_t max_len) {
+  (void) rhport;
+  TU_VERIFY(TUSB_CLASS_MSC == desc_itf->bInterfaceClass && MSC_SUBCLASS_SCSI == desc_itf->bInterfaceSubClass);
+
+  // UAS is usually an alternate setting of Bulk-Only interface
+  uint8_t const* p_desc = (uint8_t const*) desc_itf;
+  uint8_t const* desc_end = p_desc + max_len;
+  tusb_desc_interface_t const* desc_uas = NULL;
+  while (p_desc < desc_end && tu_desc_len(p_desc)) {
+    tusb_desc_interface_t const* itf = (tusb_desc_interface_t const*) p_desc;
+    if (TUSB_DESC_INTERFACE == tu_desc_type(p_desc)) {
+      if (itf->bInterfaceNumber != desc_itf->bInterfaceNumber) {
+        break;
+      }
+      if (MSC_PROTOCOL_UAS == itf->bInterfaceProtocol && 4 == itf->bNumEndpoints) {
+        desc_uas = itf;
+        break;
+      }
+    }
+    p_desc = tu_desc_next(p_desc);
+  }
+  TU_VERIFY(desc_uas);
+
+  if (tuh_uas_use_cb && !tuh_uas_use_cb(dev_addr)) {
+    TU_LOG_DRV("  UAS rejected by application, use Bulk-Only\r\n");
+    return false;
+  }
+
+  uash_interface_t* p_uas = get_itf(dev_addr);
+  uint8_t ep[4] = {0};
+
+  // each endpoint is followed by pipe usage descriptor telling its role
+  p_desc = tu_desc_next(desc_uas);
+  for (uint8_t i = 0; i < 4; i++) {
+    tusb_desc_endpoint_t const* desc_ep = (tusb_desc_endpoint_t const*) p_desc;
+    TU_VERIFY(p_desc + sizeof(tusb_desc_endpoint_t) + 4 <= desc_end);
+    TU_VERIFY(TUSB_DESC_ENDPOINT == tu_desc_type(desc_ep) && TUSB_XFER_BULK == desc_ep->bmAttributes.xfer);
+    p_desc = tu_desc_next(p_desc);
+    TU_VERIFY(UAS_DESC_PIPE_USAGE == tu_desc_type(p_desc));
+
+    uint8_t const pipe_id = p_desc[2];
+    TU_VERIFY(pipe_id >= UAS_PIPE_COMMAND && pipe_id <= UAS_PIPE_DATA_OUT);
+    ep[pipe_id - 1] = desc_ep->bEndpointAddress;
+    TU_ASSERT(tuh_edpt_open(dev_addr, desc_ep));
+
+    p_desc = tu_desc_next(p_desc);
+  }
+  TU_VERIFY(ep[0] && ep[1] && ep[2] && ep[3]);
+
+  p_uas->itf_num   = desc_uas->bInterfaceNumber;
+  p_uas->alt       = desc_uas->bAlternateSetting;
+  p_uas->ep_cmd    = ep[UAS_PIPE_COMMAND - 1];
+  p_uas->ep_status = ep[UAS_PIPE_STATUS - 1];
+  p_uas->ep_din    = ep[UAS_PIPE_DATA_IN - 1];
+  p_uas->ep_dout   = ep[UAS_PIPE_DATA_OUT - 1];
+  p_uas->cmd_slot  = NO_SLOT;
+  p_uas->data_slot = NO_SLOT;
+
+  return true;
+}
+
+bool uash_set_config(uint8_t daddr, uint8_t itf_num) {
+  uash_interface_t* p_uas = get_itf(daddr);
+  TU_ASSERT(p_uas->itf_num == itf_num);
+
+  if (p_uas->alt == 0) {
+    // UAS-only interface
+    tuh_xfer_t xfer = {
+        .daddr  = daddr,
+        .result = XFER_RESULT_SUCCESS
+    };
+    config_set_interface_complete(&xfer);
+    return true;
+  }
+
+  TU_LOG_DRV("UAS Set Interface %u alt %u\r\n", itf_num, p_uas->alt);
+  TU_ASSERT(tuh_interface_set(daddr, itf_num, p_uas->alt, config_set_interface_complete, 0));
+  return true;
+}
+
+static void config_set_interface_complete(tuh_xfer_t* xfer) {
+  uint8_t const daddr = xfer->daddr;
+  uash_interface_t* p_uas = get_itf(daddr);
+
+  if (xfer->result != XFER_RESULT_SUCCESS) {
+    TU_LOG_DRV("  UAS alternate setting failed\r\n");
+    config_complete(daddr, false);
+    return;
+  }
+
+  p_uas->configured = true;
+  if (!status_pipe_arm(daddr)) {
+    config_complete(daddr, false);
+    return;
+  }
+
+  config_test_unit_ready(daddr);
+}
+
+static void config_tur_retry(void* param) {
+  uint8_t const daddr = (uint8_t) (uintptr_t) param;
+  if (get_itf(daddr)->configured) {
+    config_test_unit_ready(daddr);
+  }
+}
+
+static void config_test_unit_ready(uint8_t daddr) {
+  TU_LOG_DRV("SCSI Test Unit Ready\r\n");
+  uint8_t const cdb[6] = {SCSI_CMD_TEST_UNIT_READY, 0, 0, 0, 0, 0};
+  if (!tuh_uas_scsi_command(daddr, 0, cdb, sizeof(cdb), TUSB_DIR_OUT, NULL, 0, config_test_unit_ready_complete, 0)) {
+    config_complete(daddr, false);
+  }
+}
+
+static bool config_test_unit_ready_complete(uint8_t dev_addr, tuh_uas_complete_data_t const* cb_data) {
+  uash_interface_t* p_uas = get_itf(dev_addr);
+
+  if (cb_data->status != SCSI_STATUS_GOOD) {
+    // Sense IU already carries sense data: unit attention after reset or not ready while spinning up
+    if (++p_uas->enum_retry > ENUM_TUR_RETRY) {
+      config_complete(dev_addr, false);
+    } else {
+      (void) usbh_defer_func_ms(config_tur_retry, (void*) (uintptr_t) dev_addr, ENUM_TUR_DELAY);
+    }
+    return true;
+  }
+
+  TU_LOG_DRV("SCSI Read Capacity\r\n");
+  scsi_read_capacity10_t const cmd_capa = {
+      .cmd_code = SCSI_CMD_READ_CAPACITY_10
+  };
+  if (!tuh_uas_scsi_command(dev_addr, 0, (uint8_t const*) &cmd_capa, sizeof(cmd_capa), TUSB_DIR_IN,
+                            usbh_get_enum_buf(), sizeof(scsi_read_capacity10_resp_t),
+                            config_read_capacity_complete, 0)) {
+    config_complete(dev_addr, false);
+  }
+  return true;
+}
+
+static bool config_read_capacity_complete(uint8_t dev_addr, tuh_uas_complete_data_t const* cb_data) {
+  uash_interface_t* p_uas = get_itf(dev_addr);
+  if (cb_data->status != SCSI_STATUS_GOOD) {
+    config_complete(dev_addr, false);
+    return true;
+  }
+
+  // Capacity response field: Block size and Last LBA are both Big-Endian
+  scsi_read_capacity10_resp_t const* resp = (scsi_read_capacity10_resp_t const*) (uintptr_t) usbh_get_enum_buf();
+  p_uas->block_count = (uint64_t) tu_ntohl(resp->last_lba) + 1;
+  p_uas->block_size  = tu_ntohl(resp->block_size);
+
+  // Last LBA of all ones: media is too large for READ CAPACITY (10)
+  if (resp->last_lba == UINT32_MAX) {
+    TU_LOG_DRV("SCSI Read Capacity16\r\n");
+    scsi_read_capacity16_t const cmd_capa16 = {
+        .cmd_code       = SCSI_CMD_SERVICE_ACTION_IN_16,
+        .service_action = SCSI_SERVICE_ACTION_READ_CAPACITY_16,
+        .alloc_length   = tu_htonl(sizeof(scsi_read_capacity16_resp_t))
+    };
+    if (!tuh_uas_scsi_command(dev_addr, 0, (uint8_t const*) &cmd_capa16, sizeof(cmd_capa16), TUSB_DIR_IN,
+                              usbh_get_enum_buf(), sizeof(scsi_read_capacity16_resp_t),
+                              config_read_capacity16_complete, 0)) {
+      config_complete(dev_addr, false);
+    }
+    return true;
+  }
+
+  config_complete(dev_addr, true);
+  return true;
+}
+
+static bool config_read_capacity16_complete(uint8_t dev_addr, tuh_uas_complete_data_t const* cb_data) {
+  uash_interface_t* p_uas = get_itf(dev_addr);
+  if (cb_data->status == SCSI_STATUS_GOOD) {
+    scsi_read_capacity16_resp_t const* resp = (scsi_read_capacity16_resp_t const*) (uintptr_t) usbh_get_enum_buf();
+    p_uas->block_count = tu_ntohll(resp->last_lba) + 1;
+    p_uas->block_size  = tu_ntohl(resp->block_size);
+  }
+
+  config_complete(dev_addr, cb_data->status == SCSI_STATUS_GOOD);
+  return true;
+}
+
+// final step of enumeration
+static void config_complete(uint8_t dev_addr, bool success) {
+  uash_interface_t* p_uas = get_itf(dev_addr);
+
+  TU_LOG_DRV("  UAS %s, block size = %lu\r\n", success ? "mounted" : "enumeration failed", p_uas->block_size);
+
+  if (success) {
+    p_uas->mounted = true;
+    if (tuh_uas_mount_cb) {
+      tuh_uas_mount_cb(dev_addr);
+    }
+  }
+
+  // notify usbh that driver enumeration is complete
+  usbh_driver_set_config_complete(dev_addr, p_uas->itf_num);
+}
+
+#endif
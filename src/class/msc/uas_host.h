@@ -0,0 +1,131 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#ifndef _TUSB_UAS_HOST_H_
+#define _TUSB_UAS_HOST_H_
+
+#include "msc.h"
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+// USB Attached SCSI (UAS) host transport. Several commands identified by their tag are sent to the device without
+// waiting for previous ones, each command completes with its own Sense IU on the status pipe.
+//
+// Only USB 2.0 multi-pipe mode without bulk streams is supported: device announces the command owning the data pipes
+// with Read Ready/Write Ready IU, so each pipe has only one transfer at a time.
+// Mass storage interface whose UAS alternate setting is not usable (no UAS alternate, rejected by
+// tuh_uas_use_cb()) is left to the Bulk-Only MSC driver (CFG_TUH_MSC).
+
+//--------------------------------------------------------------------+
+// Class Driver Configuration
+//--------------------------------------------------------------------+
+
+// Number of commands that can be queued per device
+#ifndef CFG_TUH_UAS_QUEUE_DEPTH
+#define CFG_TUH_UAS_QUEUE_DEPTH  4
+#endif
+
+TU_VERIFY_STATIC(CFG_TUH_UAS_QUEUE_DEPTH > 0 && CFG_TUH_UAS_QUEUE_DEPTH <= 16, "Depth is not correct");
+
+typedef struct {
+  uint16_t tag;
+  uint8_t lun;
+  uint8_t status;           // SCSI status, 0 (GOOD) if success. UAS transport error is reported as CHECK CONDITION
+                            // without sense data
+  uint8_t sense_len;
+  uint8_t const* sense;     // sense data (e.g scsi_sense_fixed_resp_t) if any, only valid within callback
+  void* scsi_data;          // data buffer
+  uint32_t xferred_bytes;   // number of transferred data bytes
+  uintptr_t user_arg;       // user argument
+} tuh_uas_complete_data_t;
+
+typedef bool (*tuh_uas_complete_cb_t)(uint8_t dev_addr, tuh_uas_complete_data_t const* cb_data);
+
+//--------------------------------------------------------------------+
+// Application API
+//--------------------------------------------------------------------+
+
+// Check if device is mounted with UAS transport
+bool tuh_uas_mounted(uint8_t dev_addr);
+
+// Check if another command can be queued
+bool tuh_uas_ready(uint8_t dev_addr);
+
+// Number of commands in progress (queued, sent or transferring data)
+uint8_t tuh_uas_queued_count(uint8_t dev_addr);
+
+// Get number of block of LUN 0
+uint64_t tuh_uas_get_block_count(uint8_t dev_addr);
+
+// Get block size in bytes of LUN 0
+uint32_t tuh_uas_get_block_size(uint8_t dev_addr);
+
+// Queue a SCSI command (cdb up to 16 bytes) with data of total_bytes (at most 64KB) in direction of dir
+// (TUSB_DIR_IN/TUSB_DIR_OUT), data can be NULL if total_bytes is 0. Commands are sent in order and complete callback
+// is invoked when its status is received, possibly out of order. Return false if queue is full.
+// NOTE: data must be accessible by USB/DMA controller, aligned correctly and multiple of cache line if enabled
+bool tuh_uas_scsi_command(uint8_t dev_addr, uint8_t lun, uint8_t const* cdb, uint8_t cdb_len, uint8_t dir,
+                          void* data, uint32_t total_bytes, tuh_uas_complete_cb_t complete_cb, uintptr_t arg);
+
+// Queue READ (10) command. Read n blocks starting from LBA to buffer
+bool tuh_uas_read10(uint8_t dev_addr, uint8_t lun, void* buffer, uint32_t lba, uint16_t block_count,
+                    tuh_uas_complete_cb_t complete_cb, uintptr_t arg);
+
+// Queue WRITE (10) command. Write n blocks starting from LBA to device
+bool tuh_uas_write10(uint8_t dev_addr, uint8_t lun, void const* buffer, uint32_t lba, uint16_t block_count,
+                     tuh_uas_complete_cb_t complete_cb, uintptr_t arg);
+
+//--------------------------------------------------------------------+
+// Callbacks (Weak is optional)
+//--------------------------------------------------------------------+
+
+// Invoked when opening a mass storage interface with UAS alternate setting. Return false to use Bulk-Only Transport
+// instead e.g for bridge known to be broken with UAS
+TU_ATTR_WEAK bool tuh_uas_use_cb(uint8_t dev_addr);
+
+// Invoked when device is mounted with UAS transport and its capacity is known
+TU_ATTR_WEAK void tuh_uas_mount_cb(uint8_t dev_addr);
+
+// Invoked when device is unmounted, queued commands are dropped without callback
+TU_ATTR_WEAK void tuh_uas_umount_cb(uint8_t dev_addr);
+
+//--------------------------------------------------------------------+
+// Internal Class Driver API
+//--------------------------------------------------------------------+
+bool uash_init       (void);
+bool uash_deinit     (void);
+bool uash_open       (uint8_t rhport, uint8_t dev_addr, tusb_desc_interface_t const *desc_itf, uint16_t max_len);
+bool uash_set_config (uint8_t dev_addr, uint8_t itf_num);
+bool uash_xfer_cb    (uint8_t dev_addr, uint8_t ep_addr, xfer_result_t event, uint32_t xferred_bytes);
+void uash_close      (uint8_t dev_addr);
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif /* _TUSB_UAS_HOST_H_ */
@@ -43,10 +43,17 @@ extern void rndis_class_set_handler(uint8_t *data, int size); /* found in ./misc
 #define NETD_PACKET_SIZE  (CFG_TUD_NET_PACKET_PREFIX_LEN + CFG_TUD_NET_MTU + CFG_TUD_NET_PACKET_PREFIX_LEN)
 #define NETD_CONTROL_SIZE 120
 
+#define NETD_RX_N  CFG_TUD_ECM_RNDIS_OUT_FRAME_N
+#define NETD_TX_N  CFG_TUD_ECM_RNDIS_IN_FRAME_N
+
+TU_VERIFY_STATIC(NETD_RX_N > 0 && NETD_RX_N < UINT8_MAX && NETD_TX_N > 0 && NETD_TX_N < UINT8_MAX,
+                 "Frame buffer count is not correct");
+
 //--------------------------------------------------------------------+
 // MACRO CONSTANT TYPEDEF
 //--------------------------------------------------------------------+
 typedef struct {
+  uint8_t rhport;
   uint8_t itf_num;      // Index number of Management Interface, +1 for Data Interface
   uint8_t itf_data_alt; // Alternate setting of Data Interface. 0 : inactive, 1 : active
 
@@ -60,6 +67,21 @@ typedef struct {
   // TODO since configuration descriptor may not be long-lived memory, we should
   // keep a copy of endpoint attribute instead
   uint8_t const * ecm_desc_epdata;
+
+  // frame rings: buffers are filled and consumed in order, head is the oldest one
+  uint16_t rx_len[NETD_RX_N];
+  uint8_t  rx_head;
+  uint8_t  rx_count;      // received frames, head one is held by glue logic if rx_glue is set
+  bool     rx_armed;      // OUT transfer is in progress into buffer after the received ones
+  bool     rx_glue;       // glue logic holds head frame until tud_network_recv_renew()
+  bool     rx_delivering; // tud_network_recv_cb() is running, avoid recursion
+
+  uint16_t tx_len[NETD_TX_N];
+  uint8_t  tx_head;
+  uint8_t  tx_count;      // frames waiting for or in transmission
+  bool     tx_busy;       // IN transfer of head frame (or its ZLP) is in progress
+
+  struct netd_epbuf_struct* epbuf; // endpoint buffers, set when interface is opened
 } netd_interface_t;
 
 typedef struct ecm_notify_struct {
@@ -67,9 +89,14 @@ typedef struct ecm_notify_struct {
   uint32_t downlink, uplink;
 } ecm_notify_t;
 
-typedef struct {
-  TUD_EPBUF_DEF(rx, NETD_PACKET_SIZE);
-  TUD_EPBUF_DEF(tx, NETD_PACKET_SIZE);
+typedef struct netd_epbuf_struct {
+  struct {
+    TUD_EPBUF_DEF(buf, NETD_PACKET_SIZE);
+  } rx[NETD_RX_N];
+
+  struct {
+    TUD_EPBUF_DEF(buf, NETD_PACKET_SIZE);
+  } tx[NETD_TX_N];
 
   TUD_EPBUF_DEF(notify, sizeof(ecm_notify_t));
   TUD_EPBUF_DEF(ctrl, NETD_CONTROL_SIZE);
@@ -79,25 +106,76 @@ typedef struct {
 // INTERNAL OBJECT & FUNCTION DECLARATION
 //--------------------------------------------------------------------+
 static netd_interface_t _netd_itf;
+
+#if !CFG_TUD_EPBUF_POOL_SIZE
 CFG_TUD_MEM_SECTION static netd_epbuf_t _netd_epbuf;
-static bool can_xmit;
+#endif
+
+static void handle_incoming_packet(uint8_t idx);
+
+// receive into next free buffer
+static void rx_start(void) {
+  if (!_netd_itf.rx_armed && _netd_itf.rx_count < NETD_RX_N) {
+    uint8_t const idx = (uint8_t) ((_netd_itf.rx_head + _netd_itf.rx_count) % NETD_RX_N);
+    _netd_itf.rx_armed = usbd_edpt_xfer(_netd_itf.rhport, _netd_itf.ep_out, _netd_itf.epbuf->rx[idx].buf, NETD_PACKET_SIZE);
+  }
+}
 
-void tud_network_recv_renew(void) {
-  usbd_edpt_xfer(0, _netd_itf.ep_out, _netd_epbuf.rx, NETD_PACKET_SIZE);
+// release oldest received frame
+static void rx_pop(void) {
+  _netd_itf.rx_glue = false;
+  _netd_itf.rx_head = (uint8_t) ((_netd_itf.rx_head + 1) % NETD_RX_N);
+  _netd_itf.rx_count--;
 }
 
-static void do_in_xfer(uint8_t *buf, uint16_t len) {
-  can_xmit = false;
-  usbd_edpt_xfer(0, _netd_itf.ep_in, buf, len);
+// hand received frames to glue logic one at a time
+static void rx_deliver(void) {
+  _netd_itf.rx_delivering = true;
+  while (!_netd_itf.rx_glue && _netd_itf.rx_count > 0) {
+    _netd_itf.rx_glue = true;
+    handle_incoming_packet(_netd_itf.rx_head);
+  }
+  _netd_itf.rx_delivering = false;
+}
+
+void tud_network_n_recv_renew(uint8_t itf) {
+  TU_VERIFY(itf == 0,);
+  if (_netd_itf.rx_glue) {
+    rx_pop();
+  }
+  // frames are picked up by the running loop if invoked from tud_network_recv_cb()
+  if (!_netd_itf.rx_delivering) {
+    rx_deliver();
+  }
+  rx_start();
+}
+
+// send oldest queued frame
+static void tx_start(void) {
+  if (!_netd_itf.tx_busy && _netd_itf.tx_count > 0) {
+    uint8_t const idx = _netd_itf.tx_head;
+    _netd_itf.tx_busy = usbd_edpt_xfer(_netd_itf.rhport, _netd_itf.ep_in, _netd_itf.epbuf->tx[idx].buf, _netd_itf.tx_len[idx]);
+  }
+}
+
+// prepare frame rings once data endpoints are opened
+static void netd_data_start(void) {
+  _netd_itf.rx_head  = _netd_itf.rx_count = 0;
+  _netd_itf.rx_armed = _netd_itf.rx_glue = false;
+  _netd_itf.tx_head  = _netd_itf.tx_count = 0;
+  _netd_itf.tx_busy  = false;
+
+  tud_network_init_cb();
+  rx_start(); // prepare for incoming packets
 }
 
 void netd_report(uint8_t *buf, uint16_t len) {
-  const uint8_t rhport = 0;
+  const uint8_t rhport = _netd_itf.rhport;
   len = tu_min16(len, sizeof(ecm_notify_t));
 
-  TU_VERIFY(usbd_edpt_claim(rhport, _netd_itf.ep_notif), );
-  memcpy(_netd_epbuf.notify, buf, len);
-  usbd_edpt_xfer(rhport, _netd_itf.ep_notif, _netd_epbuf.notify, len);
+  TU_VERIFY(_netd_itf.epbuf != NULL && usbd_edpt_claim(rhport, _netd_itf.ep_notif), );
+  memcpy(_netd_itf.epbuf->notify, buf, len);
+  usbd_edpt_xfer(rhport, _netd_itf.ep_notif, _netd_itf.epbuf->notify, len);
 }
 
 //--------------------------------------------------------------------+
@@ -112,7 +190,8 @@ bool netd_deinit(void) {
 }
 
 void netd_reset(uint8_t rhport) {
-  (void) rhport;
+  // keep interface opened on other root port
+  TU_VERIFY(_netd_itf.ep_notif == 0 || _netd_itf.rhport == rhport, );
   netd_init();
 }
 
@@ -130,7 +209,15 @@ uint16_t netd_open(uint8_t rhport, tusb_desc_interface_t const * itf_desc, uint1
   // confirm interface hasn't already been allocated
   TU_ASSERT(0 == _netd_itf.ep_notif, 0);
 
+#if CFG_TUD_EPBUF_POOL_SIZE
+  _netd_itf.epbuf = (netd_epbuf_t*) usbd_epbuf_alloc(rhport, sizeof(netd_epbuf_t));
+  TU_ASSERT(_netd_itf.epbuf != NULL, 0);
+#else
+  _netd_itf.epbuf = &_netd_epbuf;
+#endif
+
   // sanity check the descriptor
+  _netd_itf.rhport = rhport;
   _netd_itf.ecm_mode = is_ecm;
 
   //------------- Management Interface -------------//
@@ -181,13 +268,7 @@ uint16_t netd_open(uint8_t rhport, tusb_desc_interface_t const * itf_desc, uint1
     // Open endpoint pair for RNDIS
     TU_ASSERT(usbd_open_edpt_pair(rhport, p_desc, 2, TUSB_XFER_BULK, &_netd_itf.ep_out, &_netd_itf.ep_in), 0);
 
-    tud_network_init_cb();
-
-    // we are ready to transmit a packet
-    can_xmit = true;
-
-    // prepare for incoming packets
-    tud_network_recv_renew();
+    netd_data_start();
   }
 
   drv_len += 2*sizeof(tusb_desc_endpoint_t);
@@ -257,11 +338,8 @@ bool netd_control_xfer_cb (uint8_t rhport, uint8_t stage, tusb_control_request_t
                   usbd_open_edpt_pair(rhport, _netd_itf.ecm_desc_epdata, 2, TUSB_XFER_BULK, &_netd_itf.ep_out, &
                     _netd_itf.ep_in));
 
-                // TODO should be merge with RNDIS's after endpoint opened
-                // Also should have opposite callback for application to disable network !!
-                tud_network_init_cb();
-                can_xmit = true; // we are ready to transmit a packet
-                tud_network_recv_renew(); // prepare for incoming packets
+                // TODO should have opposite callback for application to disable network !!
+                netd_data_start();
               }
             } else {
               // TODO close the endpoint pair
@@ -290,12 +368,12 @@ bool netd_control_xfer_cb (uint8_t rhport, uint8_t stage, tusb_control_request_t
           }
         } else {
           if (request->bmRequestType_bit.direction == TUSB_DIR_IN) {
-            rndis_generic_msg_t* rndis_msg = (rndis_generic_msg_t*)((void*)_netd_epbuf.ctrl);
+            rndis_generic_msg_t* rndis_msg = (rndis_generic_msg_t*)((void*)_netd_itf.epbuf->ctrl);
             uint32_t msglen = tu_le32toh(rndis_msg->MessageLength);
             TU_ASSERT(msglen <= NETD_CONTROL_SIZE);
-            tud_control_xfer(rhport, request, _netd_epbuf.ctrl, (uint16_t)msglen);
+            tud_control_xfer(rhport, request, _netd_itf.epbuf->ctrl, (uint16_t)msglen);
           } else {
-            tud_control_xfer(rhport, request, _netd_epbuf.ctrl, NETD_CONTROL_SIZE);
+            tud_control_xfer(rhport, request, _netd_itf.epbuf->ctrl, NETD_CONTROL_SIZE);
           }
         }
         break;
@@ -309,7 +387,7 @@ bool netd_control_xfer_cb (uint8_t rhport, uint8_t stage, tusb_control_request_t
         request->bmRequestType_bit.direction == TUSB_DIR_OUT &&
         _netd_itf.itf_num == request->wIndex) {
       if (!_netd_itf.ecm_mode) {
-        rndis_class_set_handler(_netd_epbuf.ctrl, request->wLength);
+        rndis_class_set_handler(_netd_itf.epbuf->ctrl, request->wLength);
       }
     }
   }
@@ -317,8 +395,10 @@ bool netd_control_xfer_cb (uint8_t rhport, uint8_t stage, tusb_control_request_t
   return true;
 }
 
-static void handle_incoming_packet(uint32_t len) {
-  uint8_t* pnt = _netd_epbuf.rx;
+static void handle_incoming_packet(uint8_t idx) {
+  uint8_t* const rx = _netd_itf.epbuf->rx[idx].buf;
+  uint32_t const len = _netd_itf.rx_len[idx];
+  uint8_t* pnt = rx;
   uint32_t size = 0;
 
   if (_netd_itf.ecm_mode) {
@@ -328,16 +408,18 @@ static void handle_incoming_packet(uint32_t len) {
     if (len >= sizeof(rndis_data_packet_t)) {
       if ((r->MessageType == REMOTE_NDIS_PACKET_MSG) && (r->MessageLength <= len)) {
         if ((r->DataOffset + offsetof(rndis_data_packet_t, DataOffset) + r->DataLength) <= len) {
-          pnt = &_netd_epbuf.rx[r->DataOffset + offsetof(rndis_data_packet_t, DataOffset)];
+          pnt = &rx[r->DataOffset + offsetof(rndis_data_packet_t, DataOffset)];
           size = r->DataLength;
         }
       }
     }
   }
 
-  if (!tud_network_recv_cb(pnt, (uint16_t)size)) {
+  bool const accepted = tud_network_n_recv_cb ? tud_network_n_recv_cb(0, pnt, (uint16_t) size)
+                                              : tud_network_recv_cb(pnt, (uint16_t) size);
+  if (!accepted && _netd_itf.rx_glue) {
     /* if a buffer was never handled by user code, we must renew on the user's behalf */
-    tud_network_recv_renew();
+    rx_pop();
   }
 }
 
@@ -345,9 +427,17 @@ bool netd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_
   (void)rhport;
   (void)result;
 
-  /* new packet received */
+  /* new packet received: receive next one meanwhile if there is a free buffer */
   if (ep_addr == _netd_itf.ep_out) {
-    handle_incoming_packet(xferred_bytes);
+    uint8_t const idx = (uint8_t) ((_netd_itf.rx_head + _netd_itf.rx_count) % NETD_RX_N);
+    _netd_itf.rx_armed = false;
+    _netd_itf.rx_len[idx] = (uint16_t) xferred_bytes;
+    _netd_itf.rx_count++;
+    rx_start();
+    if (!_netd_itf.rx_delivering) {
+      rx_deliver();
+    }
+    rx_start();
   }
 
   /* data transmission finished */
@@ -355,10 +445,13 @@ bool netd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_
     /* TinyUSB requires the class driver to implement ZLP (since ZLP usage is class-specific) */
 
     if (xferred_bytes && (0 == (xferred_bytes % CFG_TUD_NET_ENDPOINT_SIZE))) {
-      do_in_xfer(NULL, 0); /* a ZLP is needed */
+      usbd_edpt_xfer(rhport, _netd_itf.ep_in, NULL, 0); /* a ZLP is needed */
     } else {
-      /* we're finally finished */
-      can_xmit = true;
+      /* we're finally finished with this frame, send next one */
+      _netd_itf.tx_busy = false;
+      _netd_itf.tx_head = (uint8_t) ((_netd_itf.tx_head + 1) % NETD_TX_N);
+      _netd_itf.tx_count--;
+      tx_start();
     }
   }
 
@@ -371,23 +464,30 @@ bool netd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_
   return true;
 }
 
-bool tud_network_can_xmit(uint16_t size) {
+bool tud_network_n_can_xmit(uint8_t itf, uint16_t size) {
   (void)size;
-  return can_xmit;
+  TU_VERIFY(itf == 0 && _netd_itf.epbuf != NULL, false);
+  return _netd_itf.tx_count < NETD_TX_N;
 }
 
-void tud_network_xmit(void *ref, uint16_t arg) {
-  if (!can_xmit) {
+void tud_network_n_xmit(uint8_t itf, void *ref, uint16_t arg) {
+  if (itf != 0 || _netd_itf.epbuf == NULL || _netd_itf.tx_count >= NETD_TX_N) {
     return;
   }
 
+  uint8_t const idx = (uint8_t) ((_netd_itf.tx_head + _netd_itf.tx_count) % NETD_TX_N);
+  uint8_t* const tx = _netd_itf.epbuf->tx[idx].buf;
   uint16_t len = (_netd_itf.ecm_mode) ? 0 : CFG_TUD_NET_PACKET_PREFIX_LEN;
-  uint8_t* data = _netd_epbuf.tx + len;
+  uint8_t* data = tx + len;
 
-  len += tud_network_xmit_cb(data, ref, arg);
+  if (tud_network_n_xmit_cb) {
+    len += tud_network_n_xmit_cb(0, data, ref, arg);
+  } else {
+    len += tud_network_xmit_cb(data, ref, arg);
+  }
 
   if (!_netd_itf.ecm_mode) {
-    rndis_data_packet_t *hdr = (rndis_data_packet_t *) ((void*) _netd_epbuf.tx);
+    rndis_data_packet_t *hdr = (rndis_data_packet_t *) ((void*) tx);
     memset(hdr, 0, sizeof(rndis_data_packet_t));
     hdr->MessageType = REMOTE_NDIS_PACKET_MSG;
     hdr->MessageLength = len;
@@ -395,7 +495,9 @@ void tud_network_xmit(void *ref, uint16_t arg) {
     hdr->DataLength = len - sizeof(rndis_data_packet_t);
   }
 
-  do_in_xfer(_netd_epbuf.tx, len);
+  _netd_itf.tx_len[idx] = len;
+  _netd_itf.tx_count++;
+  tx_start();
 }
 
 #endif
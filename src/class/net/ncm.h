@@ -30,6 +30,12 @@
 
 #include "common/tusb_common.h"
 
+// Support 32-bit NTB format (NTH32/NDP32) in addition to 16-bit, host selects it with SET_NTB_FORMAT. Required for
+// NTB sizes above 64KB, which also require CFG_TUD_EDPT_XFER_EX. In 16-bit format NTBs are capped at 64KB-1.
+#ifndef CFG_TUD_NCM_NTB32
+  #define CFG_TUD_NCM_NTB32 0
+#endif
+
 // NTB buffers size for reception side, must be >> MTU to avoid TCP retransmission (driver issue ?)
 // Linux use 2048 as minimal size
 #ifndef CFG_TUD_NCM_OUT_NTB_MAX_SIZE
@@ -78,6 +84,11 @@
   #define CFG_TUD_NCM_OUT_MAX_DATAGRAMS_PER_NTB 6
 #endif
 
+#if (CFG_TUD_NCM_IN_NTB_MAX_SIZE > 0xFFFF || CFG_TUD_NCM_OUT_NTB_MAX_SIZE > 0xFFFF) && \
+    !(CFG_TUD_NCM_NTB32 && CFG_TUD_EDPT_XFER_EX)
+  #error "NTB larger than 64KB requires CFG_TUD_NCM_NTB32 and CFG_TUD_EDPT_XFER_EX"
+#endif
+
 // Table 6.2 Class-Specific Request Codes for Network Control Model subclass
 typedef enum
 {
@@ -99,10 +110,20 @@ typedef enum
   NCM_SET_CRC_MODE                                 = 0x8A,
 } ncm_request_code_t;
 
+// NTB format selected by SET_NTB_FORMAT
+typedef enum {
+  NCM_NTB_FORMAT_16 = 0,
+  NCM_NTB_FORMAT_32 = 1,
+} ncm_ntb_format_t;
+
 #define NTH16_SIGNATURE 0x484D434E
 #define NDP16_SIGNATURE_NCM0 0x304D434E
 #define NDP16_SIGNATURE_NCM1 0x314D434E
 
+#define NTH32_SIGNATURE 0x686D636E
+#define NDP32_SIGNATURE_NCM0 0x306D636E
+#define NDP32_SIGNATURE_NCM1 0x316D636E
+
 typedef struct TU_ATTR_PACKED {
   uint16_t wLength;
   uint16_t bmNtbFormatsSupported;
@@ -138,12 +159,39 @@ typedef struct TU_ATTR_PACKED {
   //ndp16_datagram_t datagram[];
 } ndp16_t;
 
+typedef struct TU_ATTR_PACKED {
+  uint32_t dwSignature;
+  uint16_t wHeaderLength;
+  uint16_t wSequence;
+  uint32_t dwBlockLength;
+  uint32_t dwNdpIndex;
+} nth32_t;
+
+typedef struct TU_ATTR_PACKED {
+  uint32_t dwDatagramIndex;
+  uint32_t dwDatagramLength;
+} ndp32_datagram_t;
+
+typedef struct TU_ATTR_PACKED {
+  uint32_t dwSignature;
+  uint16_t wLength;
+  uint16_t wReserved6;
+  uint32_t dwNextNdpIndex;
+  uint32_t dwReserved12;
+  //ndp32_datagram_t datagram[];
+} ndp32_t;
+
 typedef union TU_ATTR_PACKED {
   struct {
     nth16_t nth;
     ndp16_t ndp;
     ndp16_datagram_t ndp_datagram[CFG_TUD_NCM_IN_MAX_DATAGRAMS_PER_NTB + 1];
   };
+  struct {
+    nth32_t nth32;
+    ndp32_t ndp32;
+    ndp32_datagram_t ndp32_datagram[CFG_TUD_NCM_IN_MAX_DATAGRAMS_PER_NTB + 1];
+  };
   uint8_t data[CFG_TUD_NCM_IN_NTB_MAX_SIZE];
 } xmit_ntb_t;
 
@@ -152,6 +200,9 @@ typedef union TU_ATTR_PACKED {
     nth16_t nth;
     // only the header is at a guaranteed position
   };
+  struct {
+    nth32_t nth32;
+  };
   uint8_t data[CFG_TUD_NCM_OUT_NTB_MAX_SIZE];
 } recv_ntb_t;
 
@@ -79,6 +79,15 @@
 #define XMIT_NTB_N CFG_TUD_NCM_IN_NTB_N
 #define RECV_NTB_N CFG_TUD_NCM_OUT_NTB_N
 
+// checksum offload: frame layout
+#define ETH_HDR_LEN     14
+#define ETH_TYPE_IPV4   0x0800
+#define ETH_TYPE_IPV6   0x86DD
+#define IP_PROTO_ICMP   1
+#define IP_PROTO_TCP    6
+#define IP_PROTO_UDP    17
+#define IP_PROTO_ICMP6  58
+
 typedef struct {
   // general
   uint8_t ep_in;        // endpoint for outgoing datagrams (naming is a little bit confusing)
@@ -87,6 +96,7 @@ typedef struct {
   uint8_t itf_num;      // interface number
   uint8_t itf_data_alt; // ==0 -> no endpoints, i.e. no network traffic, ==1 -> normal operation with two endpoints (spec, chapter 5.3)
   uint8_t rhport;       // storage of \a rhport because some callbacks are done without it
+  uint16_t ntb_format;  // ncm_ntb_format_t selected by SET_NTB_FORMAT, used for both directions
 
   // recv handling
   recv_ntb_t *recv_free_ntb[RECV_NTB_N];                // free list of recv NTBs
@@ -94,6 +104,7 @@ typedef struct {
   recv_ntb_t *recv_tinyusb_ntb;                         // buffer for the running transfer TinyUSB -> driver
   recv_ntb_t *recv_glue_ntb;                            // buffer for the running transfer driver -> glue logic
   uint16_t recv_glue_ntb_datagram_ndx;                  // index into \a recv_glue_ntb_datagram
+  uint8_t recv_glue_csum;                               // checksum result of datagram passed to glue logic
 
   // xmit handling
   xmit_ntb_t *xmit_free_ntb[XMIT_NTB_N];                // free list of xmit NTBs
@@ -102,6 +113,9 @@ typedef struct {
   xmit_ntb_t *xmit_glue_ntb;                            // buffer for the running transfer glue logic -> driver
   uint16_t xmit_sequence;                               // NTB sequence counter
   uint16_t xmit_glue_ntb_datagram_ndx;                  // index into \a xmit_glue_ntb_datagram
+  bool xmit_coalescing;                                 // heavy traffic: glue NTB is held back until filled or timeout
+  tu_edpt_coalesce_t xmit_coalesce;                     // aggregation timeout
+  tud_network_xmit_stats_t xmit_stats;
 
   // notification handling
   enum {
@@ -128,8 +142,131 @@ typedef struct {
   TUD_EPBUF_TYPE_DEF(ncm_notify_t, epnotif);
 } ncm_epbuf_t;
 
-static ncm_interface_t ncm_interface;
-CFG_TUD_MEM_SECTION static ncm_epbuf_t ncm_epbuf;
+static ncm_interface_t ncm_interface[CFG_TUD_NCM];
+CFG_TUD_MEM_SECTION static ncm_epbuf_t ncm_epbuf[CFG_TUD_NCM];
+
+// recv NTBs referenced by the glue logic via tud_network_recv_hold(), kept across netd_init() because the
+// glue logic may still reference their datagrams after a bus reset
+static uint8_t recv_ntb_hold[CFG_TUD_NCM][RECV_NTB_N];
+
+TU_ATTR_ALWAYS_INLINE static inline uint8_t ncm_index(const ncm_interface_t *ncm) {
+  return (uint8_t) (ncm - ncm_interface);
+}
+
+TU_ATTR_ALWAYS_INLINE static inline ncm_epbuf_t *get_epbuf(const ncm_interface_t *ncm) {
+  return &ncm_epbuf[ncm_index(ncm)];
+}
+
+TU_ATTR_ALWAYS_INLINE static inline uint8_t *recv_hold(const ncm_interface_t *ncm) {
+  return recv_ntb_hold[ncm_index(ncm)];
+}
+
+/**
+ * Instance by index, NULL if not opened
+ */
+static ncm_interface_t *get_itf(uint8_t itf) {
+  TU_VERIFY(itf < CFG_TUD_NCM, NULL);
+  return (ncm_interface[itf].ep_notif != 0) ? &ncm_interface[itf] : NULL;
+}
+
+//-----------------------------------------------------------------------------
+//
+// NTB format: 16-bit (default) or 32-bit
+//
+#define NTB_IS_32(_ncm)  (CFG_TUD_NCM_NTB32 && (_ncm)->ntb_format == NCM_NTB_FORMAT_32)
+
+/**
+ * Max size of an xmit NTB, limited by 16-bit length fields in NTB16 format
+ */
+static uint32_t xmit_ntb_max_size(const ncm_interface_t *ncm) {
+  return NTB_IS_32(ncm) ? CFG_TUD_NCM_IN_NTB_MAX_SIZE : tu_min32(CFG_TUD_NCM_IN_NTB_MAX_SIZE, UINT16_MAX);
+}
+
+/**
+ * Size of NTH, NDP and datagram pointer table at the front of an xmit NTB
+ */
+static uint32_t xmit_ntb_header_size(const ncm_interface_t *ncm) {
+  if (NTB_IS_32(ncm)) {
+    return sizeof(nth32_t) + sizeof(ndp32_t) + (CFG_TUD_NCM_IN_MAX_DATAGRAMS_PER_NTB + 1) * sizeof(ndp32_datagram_t);
+  }
+  return sizeof(nth16_t) + sizeof(ndp16_t) + (CFG_TUD_NCM_IN_MAX_DATAGRAMS_PER_NTB + 1) * sizeof(ndp16_datagram_t);
+}
+
+static uint32_t xmit_ntb_len(const ncm_interface_t *ncm, const xmit_ntb_t *ntb) {
+  return NTB_IS_32(ncm) ? ntb->nth32.dwBlockLength : ntb->nth.wBlockLength;
+}
+
+static void xmit_ntb_len_set(const ncm_interface_t *ncm, xmit_ntb_t *ntb, uint32_t len) {
+  if (NTB_IS_32(ncm)) {
+    ntb->nth32.dwBlockLength = len;
+  } else {
+    ntb->nth.wBlockLength = (uint16_t) len;
+  }
+}
+
+static uint16_t xmit_ntb_datagram_len(const ncm_interface_t *ncm, const xmit_ntb_t *ntb, uint16_t ndx) {
+  return NTB_IS_32(ncm) ? (uint16_t) ntb->ndp32_datagram[ndx].dwDatagramLength : ntb->ndp_datagram[ndx].wDatagramLength;
+}
+
+static void xmit_ntb_datagram_set(const ncm_interface_t *ncm, xmit_ntb_t *ntb, uint16_t ndx, uint32_t index,
+                                  uint16_t len) {
+  if (NTB_IS_32(ncm)) {
+    ntb->ndp32_datagram[ndx].dwDatagramIndex = index;
+    ntb->ndp32_datagram[ndx].dwDatagramLength = len;
+  } else {
+    ntb->ndp_datagram[ndx].wDatagramIndex = (uint16_t) index;
+    ntb->ndp_datagram[ndx].wDatagramLength = len;
+  }
+}
+
+/**
+ * Get datagram \a ndx of a validated receive NTB, index and length are 0 past the last one
+ */
+static void recv_ntb_datagram(const ncm_interface_t *ncm, const recv_ntb_t *ntb, uint16_t ndx, uint32_t *index,
+                              uint16_t *len) {
+  if (NTB_IS_32(ncm)) {
+    const ndp32_datagram_t *dg = (const ndp32_datagram_t *) (ntb->data + ntb->nth32.dwNdpIndex + sizeof(ndp32_t));
+    *index = dg[ndx].dwDatagramIndex;
+    *len = (uint16_t) dg[ndx].dwDatagramLength; // validated to fit
+  } else {
+    const ndp16_datagram_t *dg = (const ndp16_datagram_t *) (ntb->data + ntb->nth.wNdpIndex + sizeof(ndp16_t));
+    *index = dg[ndx].wDatagramIndex;
+    *len = dg[ndx].wDatagramLength;
+  }
+}
+
+/**
+ * Submit an NTB transfer, NTBs above 64KB require CFG_TUD_EDPT_XFER_EX
+ */
+static bool ntb_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t *buffer, uint32_t len) {
+#if CFG_TUD_EDPT_XFER_EX
+  return usbd_edpt_xfer_ex(rhport, ep_addr, buffer, len);
+#else
+  return usbd_edpt_xfer(rhport, ep_addr, buffer, (uint16_t) len);
+#endif
+}
+
+/**
+ * Pass a received datagram to the glue logic, the per instance callback is preferred
+ */
+static bool glue_recv_cb(const ncm_interface_t *ncm, const uint8_t *src, uint16_t size) {
+  if (tud_network_n_recv_cb) {
+    return tud_network_n_recv_cb(ncm_index(ncm), src, size);
+  }
+  TU_ASSERT(tud_network_recv_cb, false);
+  return tud_network_recv_cb(src, size);
+}
+
+/**
+ * Let the glue logic copy a datagram for transmission, the per instance callback is preferred
+ */
+static uint16_t glue_xmit_cb(const ncm_interface_t *ncm, uint8_t *dst, void *ref, uint16_t arg) {
+  if (tud_network_n_xmit_cb) {
+    return tud_network_n_xmit_cb(ncm_index(ncm), dst, ref, arg);
+  }
+  TU_ASSERT(tud_network_xmit_cb, 0);
+  return tud_network_xmit_cb(dst, ref, arg);
+}
 
 /**
  * This is the NTB parameter structure
@@ -139,7 +276,7 @@ CFG_TUD_MEM_SECTION static ncm_epbuf_t ncm_epbuf;
  */
 TU_ATTR_ALIGNED(4) static const ntb_parameters_t ntb_parameters = {
   .wLength                  = sizeof(ntb_parameters_t),
-  .bmNtbFormatsSupported    = 0x01,// 16-bit NTB supported
+  .bmNtbFormatsSupported    = CFG_TUD_NCM_NTB32 ? 0x03 : 0x01,// 16-bit NTB supported, 32-bit optionally
   .dwNtbInMaxSize           = CFG_TUD_NCM_IN_NTB_MAX_SIZE,
   .wNdbInDivisor            = 1,
   .wNdbInPayloadRemainder   = 0,
@@ -163,6 +300,154 @@ TU_ATTR_ALIGNED(4) static const ntb_parameters_t ntb_parameters = {
 //      sysview:  SYSTICKS_PER_SEC=35000, IDLE_US=1000, PRINT_MOD=1000
 //
 
+//-----------------------------------------------------------------------------
+//
+// checksum offload (RFC 1071)
+//
+#if CFG_TUD_NCM_CSUM_OFFLOAD
+
+typedef struct {
+  uint16_t ip_len;    // IPv4 header length, 0 for IPv6
+  uint16_t l4_ofs;    // start of TCP/UDP/ICMP within frame
+  uint16_t l4_len;
+  uint16_t csum_ofs;  // checksum field within frame, 0 if protocol is not supported
+  uint8_t proto;
+  uint32_t pseudo;    // pseudo header sum
+} csum_frame_t;
+
+static uint32_t csum_add(uint32_t sum, const uint8_t *data, uint16_t len) {
+  if (tud_network_csum_cb) {
+    return tud_network_csum_cb(sum, data, len);
+  }
+  while (len > 1) {
+    sum += tu_u16(data[0], data[1]);
+    data += 2;
+    len -= 2;
+  }
+  if (len) {
+    sum += tu_u16(data[0], 0);
+  }
+  return sum;
+} // csum_add
+
+static uint16_t csum_fold(uint32_t sum) {
+  while (sum >> 16) {
+    sum = (sum & 0xffff) + (sum >> 16);
+  }
+  return (uint16_t) sum;
+} // csum_fold
+
+/**
+ * Locate IPv4 header and L4 checksum of an Ethernet frame.
+ * \return false if the frame is not IP
+ */
+static bool csum_parse(const uint8_t *frame, uint16_t len, csum_frame_t *f) {
+  TU_VERIFY(len >= ETH_HDR_LEN + 20, false);
+
+  uint16_t const type = tu_u16(frame[12], frame[13]);
+  const uint8_t *ip = frame + ETH_HDR_LEN;
+  uint16_t const ip_avail = (uint16_t) (len - ETH_HDR_LEN);
+  uint8_t min_len = 0;
+  uint8_t field = 0;
+
+  if (type == ETH_TYPE_IPV4) {
+    uint16_t const total = tu_u16(ip[2], ip[3]);
+    f->ip_len = (uint16_t) ((ip[0] & 0x0f) * 4);
+    TU_VERIFY((ip[0] >> 4) == 4 && f->ip_len >= 20 && total >= f->ip_len && total <= ip_avail, false);
+    f->proto = ip[9];
+    f->l4_ofs = (uint16_t) (ETH_HDR_LEN + f->ip_len);
+    f->l4_len = (uint16_t) (total - f->ip_len);
+    f->pseudo = csum_add(f->proto + (uint32_t) f->l4_len, ip + 12, 8);
+
+    if (tu_u16(ip[6], ip[7]) & 0x3fff) {
+      f->proto = 0; // fragment: L4 checksum covers the whole datagram
+    } else if (f->proto == IP_PROTO_ICMP) {
+      f->pseudo = 0;
+      min_len = 4;
+      field = 2;
+    }
+  } else if (type == ETH_TYPE_IPV6) {
+    TU_VERIFY(ip_avail >= 40 && (ip[0] >> 4) == 6, false);
+    f->ip_len = 0;
+    f->proto = ip[6]; // extension headers are not supported
+    f->l4_ofs = ETH_HDR_LEN + 40;
+    f->l4_len = tu_u16(ip[4], ip[5]);
+    TU_VERIFY(40 + (uint32_t) f->l4_len <= ip_avail, false);
+    f->pseudo = csum_add(f->proto + (uint32_t) f->l4_len, ip + 8, 32);
+
+    if (f->proto == IP_PROTO_ICMP6) {
+      min_len = 4;
+      field = 2;
+    }
+  } else {
+    return false;
+  }
+
+  if (f->proto == IP_PROTO_TCP) {
+    min_len = 20;
+    field = 16;
+  } else if (f->proto == IP_PROTO_UDP) {
+    min_len = 8;
+    field = 6;
+  }
+  f->csum_ofs = (min_len && f->l4_len >= min_len) ? (uint16_t) (f->l4_ofs + field) : 0;
+  return true;
+} // csum_parse
+
+/**
+ * Fill in IPv4 header and L4 checksums of a datagram copied into an NTB.
+ */
+static void xmit_csum_fill(uint8_t *frame, uint16_t len) {
+  csum_frame_t f;
+  if (!csum_parse(frame, len, &f)) {
+    return;
+  }
+
+  if (f.ip_len) {
+    uint8_t *ip = frame + ETH_HDR_LEN;
+    ip[10] = ip[11] = 0;
+    uint16_t const csum = (uint16_t) ~csum_fold(csum_add(0, ip, f.ip_len));
+    ip[10] = TU_U16_HIGH(csum);
+    ip[11] = TU_U16_LOW(csum);
+  }
+  if (f.csum_ofs) {
+    frame[f.csum_ofs] = frame[f.csum_ofs + 1] = 0;
+    uint16_t csum = (uint16_t) ~csum_fold(csum_add(f.pseudo, frame + f.l4_ofs, f.l4_len));
+    if (csum == 0 && f.proto == IP_PROTO_UDP) {
+      csum = 0xffff; // zero means no checksum
+    }
+    frame[f.csum_ofs] = TU_U16_HIGH(csum);
+    frame[f.csum_ofs + 1] = TU_U16_LOW(csum);
+  }
+} // xmit_csum_fill
+
+/**
+ * Verify checksums of a received datagram.
+ * \return TUD_NETWORK_CSUM_*
+ */
+static uint8_t recv_csum_verify(const uint8_t *frame, uint16_t len) {
+  csum_frame_t f;
+  if (!csum_parse(frame, len, &f)) {
+    return TUD_NETWORK_CSUM_UNVERIFIED;
+  }
+
+  if (f.ip_len && csum_fold(csum_add(0, frame + ETH_HDR_LEN, f.ip_len)) != 0xffff) {
+    return TUD_NETWORK_CSUM_INVALID;
+  }
+  if (!f.csum_ofs) {
+    return TUD_NETWORK_CSUM_UNVERIFIED;
+  }
+  if (f.ip_len && f.proto == IP_PROTO_UDP && tu_u16(frame[f.csum_ofs], frame[f.csum_ofs + 1]) == 0) {
+    return TUD_NETWORK_CSUM_VALID; // IPv4 UDP without checksum
+  }
+  if (csum_fold(csum_add(f.pseudo, frame + f.l4_ofs, f.l4_len)) != 0xffff) {
+    return TUD_NETWORK_CSUM_INVALID;
+  }
+  return TUD_NETWORK_CSUM_VALID;
+} // recv_csum_verify
+
+#endif
+
 //-----------------------------------------------------------------------------
 //
 // everything about notifications
@@ -172,14 +457,14 @@ TU_ATTR_ALIGNED(4) static const ntb_parameters_t ntb_parameters = {
  * Transmit next notification to the host (if appropriate).
  * Notifications are transferred to the host once during connection setup.
  */
-static void notification_xmit(uint8_t rhport, bool force_next) {
-  TU_LOG_DRV("notification_xmit(%d, %d) - %d %d\n", force_next, rhport, ncm_interface.notification_xmit_state, ncm_interface.notification_xmit_is_running);
+static void notification_xmit(ncm_interface_t *ncm, uint8_t rhport, bool force_next) {
+  TU_LOG_DRV("notification_xmit(%d, %d) - %d %d\n", force_next, rhport, ncm->notification_xmit_state, ncm->notification_xmit_is_running);
 
-  if (!force_next && ncm_interface.notification_xmit_is_running) {
+  if (!force_next && ncm->notification_xmit_is_running) {
     return;
   }
 
-  if (ncm_interface.notification_xmit_state == NOTIFICATION_SPEED) {
+  if (ncm->notification_xmit_state == NOTIFICATION_SPEED) {
     TU_LOG_DRV("  NOTIFICATION_SPEED\n");
     ncm_notify_t notify_speed_change = {
       .header = {
@@ -190,7 +475,7 @@ static void notification_xmit(uint8_t rhport, bool force_next) {
         },
         .bRequest = CDC_NOTIF_CONNECTION_SPEED_CHANGE,
         .wValue = 0,
-        .wIndex = ncm_interface.itf_num,
+        .wIndex = ncm->itf_num,
         .wLength = 8
       }
     };
@@ -203,12 +488,12 @@ static void notification_xmit(uint8_t rhport, bool force_next) {
     }
 
     uint16_t notif_len = sizeof(notify_speed_change.header) + notify_speed_change.header.wLength;
-    ncm_epbuf.epnotif = notify_speed_change;
-    usbd_edpt_xfer(rhport, ncm_interface.ep_notif, (uint8_t*) &ncm_epbuf.epnotif, notif_len);
+    get_epbuf(ncm)->epnotif = notify_speed_change;
+    usbd_edpt_xfer(rhport, ncm->ep_notif, (uint8_t*) &get_epbuf(ncm)->epnotif, notif_len);
 
-    ncm_interface.notification_xmit_state = NOTIFICATION_CONNECTED;
-    ncm_interface.notification_xmit_is_running = true;
-  } else if (ncm_interface.notification_xmit_state == NOTIFICATION_CONNECTED) {
+    ncm->notification_xmit_state = NOTIFICATION_CONNECTED;
+    ncm->notification_xmit_is_running = true;
+  } else if (ncm->notification_xmit_state == NOTIFICATION_CONNECTED) {
     TU_LOG_DRV("  NOTIFICATION_CONNECTED\n");
     ncm_notify_t notify_connected = {
       .header = {
@@ -219,17 +504,17 @@ static void notification_xmit(uint8_t rhport, bool force_next) {
         },
         .bRequest = CDC_NOTIF_NETWORK_CONNECTION,
         .wValue = 1 /* Connected */,
-        .wIndex = ncm_interface.itf_num,
+        .wIndex = ncm->itf_num,
         .wLength = 0,
       },
     };
 
     uint16_t notif_len = sizeof(notify_connected.header) + notify_connected.header.wLength;
-    ncm_epbuf.epnotif = notify_connected;
-    usbd_edpt_xfer(rhport, ncm_interface.ep_notif, (uint8_t *) &ncm_epbuf.epnotif, notif_len);
+    get_epbuf(ncm)->epnotif = notify_connected;
+    usbd_edpt_xfer(rhport, ncm->ep_notif, (uint8_t *) &get_epbuf(ncm)->epnotif, notif_len);
 
-    ncm_interface.notification_xmit_state = NOTIFICATION_DONE;
-    ncm_interface.notification_xmit_is_running = true;
+    ncm->notification_xmit_state = NOTIFICATION_DONE;
+    ncm->notification_xmit_is_running = true;
   } else {
     TU_LOG_DRV("  NOTIFICATION_FINISHED\n");
   }
@@ -243,16 +528,16 @@ static void notification_xmit(uint8_t rhport, bool force_next) {
 /**
  * Put NTB into the transmitter free list.
  */
-static void xmit_put_ntb_into_free_list(xmit_ntb_t *free_ntb) {
-  TU_LOG_DRV("xmit_put_ntb_into_free_list() - %p\n", ncm_interface.xmit_tinyusb_ntb);
+static void xmit_put_ntb_into_free_list(ncm_interface_t *ncm, xmit_ntb_t *free_ntb) {
+  TU_LOG_DRV("xmit_put_ntb_into_free_list() - %p\n", ncm->xmit_tinyusb_ntb);
 
   if (free_ntb == NULL) { // can happen due to ZLPs
     return;
   }
 
   for (int i = 0; i < XMIT_NTB_N; ++i) {
-    if (ncm_interface.xmit_free_ntb[i] == NULL) {
-      ncm_interface.xmit_free_ntb[i] = free_ntb;
+    if (ncm->xmit_free_ntb[i] == NULL) {
+      ncm->xmit_free_ntb[i] = free_ntb;
       return;
     }
   }
@@ -262,13 +547,13 @@ static void xmit_put_ntb_into_free_list(xmit_ntb_t *free_ntb) {
 /**
  * Get an NTB from the free list
  */
-static xmit_ntb_t *xmit_get_free_ntb(void) {
+static xmit_ntb_t *xmit_get_free_ntb(ncm_interface_t *ncm) {
   TU_LOG_DRV("xmit_get_free_ntb()\n");
 
   for (int i = 0; i < XMIT_NTB_N; ++i) {
-    if (ncm_interface.xmit_free_ntb[i] != NULL) {
-      xmit_ntb_t *free = ncm_interface.xmit_free_ntb[i];
-      ncm_interface.xmit_free_ntb[i] = NULL;
+    if (ncm->xmit_free_ntb[i] != NULL) {
+      xmit_ntb_t *free = ncm->xmit_free_ntb[i];
+      ncm->xmit_free_ntb[i] = NULL;
       return free;
     }
   }
@@ -278,12 +563,12 @@ static xmit_ntb_t *xmit_get_free_ntb(void) {
 /**
  * Put a filled NTB into the ready list
  */
-static void xmit_put_ntb_into_ready_list(xmit_ntb_t *ready_ntb) {
-  TU_LOG_DRV("xmit_put_ntb_into_ready_list(%p) %d\n", ready_ntb, ready_ntb->nth.wBlockLength);
+static void xmit_put_ntb_into_ready_list(ncm_interface_t *ncm, xmit_ntb_t *ready_ntb) {
+  TU_LOG_DRV("xmit_put_ntb_into_ready_list(%p) %lu\n", ready_ntb, (unsigned long) xmit_ntb_len(ncm, ready_ntb));
 
   for (int i = 0; i < XMIT_NTB_N; ++i) {
-    if (ncm_interface.xmit_ready_ntb[i] == NULL) {
-      ncm_interface.xmit_ready_ntb[i] = ready_ntb;
+    if (ncm->xmit_ready_ntb[i] == NULL) {
+      ncm->xmit_ready_ntb[i] = ready_ntb;
       return;
     }
   }
@@ -294,12 +579,12 @@ static void xmit_put_ntb_into_ready_list(xmit_ntb_t *ready_ntb) {
  * Get the next NTB from the ready list (and remove it from the list).
  * If the ready list is empty, return NULL.
  */
-static xmit_ntb_t *xmit_get_next_ready_ntb(void) {
+static xmit_ntb_t *xmit_get_next_ready_ntb(ncm_interface_t *ncm) {
   xmit_ntb_t *r = NULL;
 
-  r = ncm_interface.xmit_ready_ntb[0];
-  memmove(ncm_interface.xmit_ready_ntb + 0, ncm_interface.xmit_ready_ntb + 1, sizeof(ncm_interface.xmit_ready_ntb) - sizeof(ncm_interface.xmit_ready_ntb[0]));
-  ncm_interface.xmit_ready_ntb[XMIT_NTB_N - 1] = NULL;
+  r = ncm->xmit_ready_ntb[0];
+  memmove(ncm->xmit_ready_ntb + 0, ncm->xmit_ready_ntb + 1, sizeof(ncm->xmit_ready_ntb) - sizeof(ncm->xmit_ready_ntb[0]));
+  ncm->xmit_ready_ntb[XMIT_NTB_N - 1] = NULL;
 
   TU_LOG_DRV("recv_get_next_ready_ntb: %p\n", r);
   return r;
@@ -316,81 +601,117 @@ static xmit_ntb_t *xmit_get_next_ready_ntb(void) {
  * \pre
  *    This must be called from netd_xfer_cb() so that ep_in is ready
  */
-static bool xmit_insert_required_zlp(uint8_t rhport, uint32_t xferred_bytes) {
+static bool xmit_insert_required_zlp(ncm_interface_t *ncm, uint8_t rhport, uint32_t xferred_bytes) {
   TU_LOG_DRV("xmit_insert_required_zlp(%d,%ld)\n", rhport, xferred_bytes);
 
   if (xferred_bytes == 0 || xferred_bytes % CFG_TUD_NET_ENDPOINT_SIZE != 0) {
     return false;
   }
 
-  TU_ASSERT(ncm_interface.itf_data_alt == 1, false);
-  TU_ASSERT(!usbd_edpt_busy(rhport, ncm_interface.ep_in), false);
+  TU_ASSERT(ncm->itf_data_alt == 1, false);
+  TU_ASSERT(!usbd_edpt_busy(rhport, ncm->ep_in), false);
 
   TU_LOG_DRV("xmit_insert_required_zlp! (%u)\n", (unsigned) xferred_bytes);
 
   // start transmission of the ZLP
-  usbd_edpt_xfer(rhport, ncm_interface.ep_in, NULL, 0);
+  usbd_edpt_xfer(rhport, ncm->ep_in, NULL, 0);
 
   return true;
 } // xmit_insert_required_zlp
 
+/**
+ * Check if the glue NTB is filled enough to be sent while aggregating.
+ */
+static bool xmit_glue_ntb_reached_threshold(ncm_interface_t *ncm) {
+  return ncm->xmit_glue_ntb_datagram_ndx >= CFG_TUD_NCM_IN_MAX_DATAGRAMS_PER_NTB ||
+         xmit_ntb_len(ncm, ncm->xmit_glue_ntb) * 100ULL >= xmit_ntb_max_size(ncm) * (uint64_t) CFG_TUD_NCM_IN_COALESCE_PERCENT;
+} // xmit_glue_ntb_reached_threshold
+
+/**
+ * Account an NTB which is going to be sent.
+ */
+static void xmit_stats_update(ncm_interface_t *ncm, const xmit_ntb_t *ntb) {
+  tud_network_xmit_stats_t *stats = &ncm->xmit_stats;
+  uint16_t count = 0;
+  while (count < CFG_TUD_NCM_IN_MAX_DATAGRAMS_PER_NTB && xmit_ntb_datagram_len(ncm, ntb, count) != 0) {
+    ++count;
+  }
+
+  uint8_t bin = 0;
+  while (bin < TU_ARRAY_SIZE(stats->datagrams_hist) - 1 && count > (1U << bin)) {
+    ++bin;
+  }
+
+  stats->ntb_count++;
+  stats->datagram_count += count;
+  stats->byte_count += xmit_ntb_len(ncm, ntb);
+  stats->datagrams_hist[bin]++;
+} // xmit_stats_update
+
 /**
  * Start transmission if it there is a waiting packet and if can be done from interface side.
  */
-static void xmit_start_if_possible(uint8_t rhport) {
+static void xmit_start_if_possible(ncm_interface_t *ncm, uint8_t rhport) {
   TU_LOG_DRV("xmit_start_if_possible()\n");
 
-  if (ncm_interface.xmit_tinyusb_ntb != NULL) {
+  if (ncm->xmit_tinyusb_ntb != NULL) {
     TU_LOG_DRV("  !xmit_start_if_possible 1\n");
     return;
   }
-  if (ncm_interface.itf_data_alt != 1) {
+  if (ncm->itf_data_alt != 1) {
     TU_LOG_DRV("(EE) !xmit_start_if_possible 2\n");
     return;
   }
-  if (usbd_edpt_busy(rhport, ncm_interface.ep_in)) {
+  if (usbd_edpt_busy(rhport, ncm->ep_in)) {
     TU_LOG_DRV("  !xmit_start_if_possible 3\n");
     return;
   }
 
-  ncm_interface.xmit_tinyusb_ntb = xmit_get_next_ready_ntb();
-  if (ncm_interface.xmit_tinyusb_ntb == NULL) {
-    if (ncm_interface.xmit_glue_ntb == NULL || ncm_interface.xmit_glue_ntb_datagram_ndx == 0) {
+  ncm->xmit_tinyusb_ntb = xmit_get_next_ready_ntb(ncm);
+  if (ncm->xmit_tinyusb_ntb == NULL) {
+    if (ncm->xmit_glue_ntb == NULL || ncm->xmit_glue_ntb_datagram_ndx == 0) {
       // -> really nothing is waiting
       return;
     }
-    ncm_interface.xmit_tinyusb_ntb = ncm_interface.xmit_glue_ntb;
-    ncm_interface.xmit_glue_ntb = NULL;
+    if (ncm->xmit_coalescing && !xmit_glue_ntb_reached_threshold(ncm)) {
+      TU_LOG_DRV("  !xmit_start_if_possible 4\n");// aggregate until threshold or timeout
+      return;
+    }
+    ncm->xmit_tinyusb_ntb = ncm->xmit_glue_ntb;
+    ncm->xmit_glue_ntb = NULL;
+    ncm->xmit_coalescing = false;
+    tu_edpt_coalesce_disarm(&ncm->xmit_coalesce);
   }
 
+  xmit_stats_update(ncm, ncm->xmit_tinyusb_ntb);
+
+  uint32_t const len = xmit_ntb_len(ncm, ncm->xmit_tinyusb_ntb);
+
   #if CFG_TUD_NCM_LOG_LEVEL >= 3
-  {
-    uint16_t len = ncm_interface.xmit_tinyusb_ntb->nth.wBlockLength;
-    TU_LOG_BUF(3, ncm_interface.xmit_tinyusb_ntb->data[i], len);
-  }
+  TU_LOG_BUF(3, ncm->xmit_tinyusb_ntb->data, len);
   #endif
 
-  if (ncm_interface.xmit_glue_ntb_datagram_ndx != 1) {
-    TU_LOG_DRV(">> %d %d\n", ncm_interface.xmit_tinyusb_ntb->nth.wBlockLength, ncm_interface.xmit_glue_ntb_datagram_ndx);
+  if (ncm->xmit_glue_ntb_datagram_ndx != 1) {
+    TU_LOG_DRV(">> %lu %d\n", (unsigned long) len, ncm->xmit_glue_ntb_datagram_ndx);
   }
 
   // Kick off an endpoint transfer
-  usbd_edpt_xfer(0, ncm_interface.ep_in, ncm_interface.xmit_tinyusb_ntb->data, ncm_interface.xmit_tinyusb_ntb->nth.wBlockLength);
+  ntb_xfer(rhport, ncm->ep_in, ncm->xmit_tinyusb_ntb->data, len);
 } // xmit_start_if_possible
 
 /**
  * check if a new datagram fits into the current NTB
  */
-static bool xmit_requested_datagram_fits_into_current_ntb(uint16_t datagram_size) {
-  TU_LOG_DRV("xmit_requested_datagram_fits_into_current_ntb(%d) - %p %p\n", datagram_size, ncm_interface.xmit_tinyusb_ntb, ncm_interface.xmit_glue_ntb);
+static bool xmit_requested_datagram_fits_into_current_ntb(ncm_interface_t *ncm, uint16_t datagram_size) {
+  TU_LOG_DRV("xmit_requested_datagram_fits_into_current_ntb(%d) - %p %p\n", datagram_size, ncm->xmit_tinyusb_ntb, ncm->xmit_glue_ntb);
 
-  if (ncm_interface.xmit_glue_ntb == NULL) {
+  if (ncm->xmit_glue_ntb == NULL) {
     return false;
   }
-  if (ncm_interface.xmit_glue_ntb_datagram_ndx >= CFG_TUD_NCM_IN_MAX_DATAGRAMS_PER_NTB) {
+  if (ncm->xmit_glue_ntb_datagram_ndx >= CFG_TUD_NCM_IN_MAX_DATAGRAMS_PER_NTB) {
     return false;
   }
-  if (ncm_interface.xmit_glue_ntb->nth.wBlockLength + datagram_size + XMIT_ALIGN_OFFSET(datagram_size) > CFG_TUD_NCM_IN_NTB_MAX_SIZE) {
+  if (xmit_ntb_len(ncm, ncm->xmit_glue_ntb) + datagram_size + XMIT_ALIGN_OFFSET(datagram_size) > xmit_ntb_max_size(ncm)) {
     return false;
   }
   return true;
@@ -399,40 +720,73 @@ static bool xmit_requested_datagram_fits_into_current_ntb(uint16_t datagram_size
 /**
  * Setup an NTB for the glue logic
  */
-static bool xmit_setup_next_glue_ntb(void) {
-  TU_LOG_DRV("xmit_setup_next_glue_ntb - %p\n", ncm_interface.xmit_glue_ntb);
+static bool xmit_setup_next_glue_ntb(ncm_interface_t *ncm) {
+  TU_LOG_DRV("xmit_setup_next_glue_ntb - %p\n", ncm->xmit_glue_ntb);
 
-  if (ncm_interface.xmit_glue_ntb != NULL) {
+  if (ncm->xmit_glue_ntb != NULL) {
     // put NTB into waiting list (the new datagram did not fit in)
-    xmit_put_ntb_into_ready_list(ncm_interface.xmit_glue_ntb);
+    xmit_put_ntb_into_ready_list(ncm, ncm->xmit_glue_ntb);
   }
 
-  ncm_interface.xmit_glue_ntb = xmit_get_free_ntb();// get next buffer (if any)
-  if (ncm_interface.xmit_glue_ntb == NULL) {
+  ncm->xmit_glue_ntb = xmit_get_free_ntb(ncm);// get next buffer (if any)
+  if (ncm->xmit_glue_ntb == NULL) {
     TU_LOG_DRV("  xmit_setup_next_glue_ntb - nothing free\n");// should happen rarely
     return false;
   }
 
-  ncm_interface.xmit_glue_ntb_datagram_ndx = 0;
+  ncm->xmit_glue_ntb_datagram_ndx = 0;
 
-  xmit_ntb_t *ntb = ncm_interface.xmit_glue_ntb;
+  xmit_ntb_t *ntb = ncm->xmit_glue_ntb;
 
-  // Fill in NTB header
-  ntb->nth.dwSignature = NTH16_SIGNATURE;
-  ntb->nth.wHeaderLength = sizeof(ntb->nth);
-  ntb->nth.wSequence = ncm_interface.xmit_sequence++;
-  ntb->nth.wBlockLength = sizeof(ntb->nth) + sizeof(ntb->ndp) + sizeof(ntb->ndp_datagram);
-  ntb->nth.wNdpIndex = sizeof(ntb->nth);
+  if (NTB_IS_32(ncm)) {
+    // Fill in NTB header
+    ntb->nth32.dwSignature = NTH32_SIGNATURE;
+    ntb->nth32.wHeaderLength = sizeof(ntb->nth32);
+    ntb->nth32.wSequence = ncm->xmit_sequence++;
+    ntb->nth32.dwBlockLength = sizeof(ntb->nth32) + sizeof(ntb->ndp32) + sizeof(ntb->ndp32_datagram);
+    ntb->nth32.dwNdpIndex = sizeof(ntb->nth32);
 
-  // Fill in NDP16 header and terminator
-  ntb->ndp.dwSignature = NDP16_SIGNATURE_NCM0;
-  ntb->ndp.wLength = sizeof(ntb->ndp) + sizeof(ntb->ndp_datagram);
-  ntb->ndp.wNextNdpIndex = 0;
+    // Fill in NDP32 header and terminator
+    ntb->ndp32.dwSignature = NDP32_SIGNATURE_NCM0;
+    ntb->ndp32.wLength = sizeof(ntb->ndp32) + sizeof(ntb->ndp32_datagram);
+    ntb->ndp32.wReserved6 = 0;
+    ntb->ndp32.dwNextNdpIndex = 0;
+    ntb->ndp32.dwReserved12 = 0;
 
-  memset(ntb->ndp_datagram, 0, sizeof(ntb->ndp_datagram));
+    memset(ntb->ndp32_datagram, 0, sizeof(ntb->ndp32_datagram));
+  } else {
+    // Fill in NTB header
+    ntb->nth.dwSignature = NTH16_SIGNATURE;
+    ntb->nth.wHeaderLength = sizeof(ntb->nth);
+    ntb->nth.wSequence = ncm->xmit_sequence++;
+    ntb->nth.wBlockLength = sizeof(ntb->nth) + sizeof(ntb->ndp) + sizeof(ntb->ndp_datagram);
+    ntb->nth.wNdpIndex = sizeof(ntb->nth);
+
+    // Fill in NDP16 header and terminator
+    ntb->ndp.dwSignature = NDP16_SIGNATURE_NCM0;
+    ntb->ndp.wLength = sizeof(ntb->ndp) + sizeof(ntb->ndp_datagram);
+    ntb->ndp.wNextNdpIndex = 0;
+
+    memset(ntb->ndp_datagram, 0, sizeof(ntb->ndp_datagram));
+  }
   return true;
 } // xmit_setup_next_glue_ntb
 
+/**
+ * Drop NTBs waiting for transmission, e.g. they are built in the previous NTB format
+ */
+static void xmit_drop_pending_ntb(ncm_interface_t *ncm) {
+  xmit_ntb_t *ntb;
+  while ((ntb = xmit_get_next_ready_ntb(ncm)) != NULL) {
+    xmit_put_ntb_into_free_list(ncm, ntb);
+  }
+  xmit_put_ntb_into_free_list(ncm, ncm->xmit_glue_ntb);
+  ncm->xmit_glue_ntb = NULL;
+  ncm->xmit_glue_ntb_datagram_ndx = 0;
+  ncm->xmit_coalescing = false;
+  tu_edpt_coalesce_disarm(&ncm->xmit_coalesce);
+} // xmit_drop_pending_ntb
+
 //-----------------------------------------------------------------------------
 //
 // all the recv_*() stuff (TinyUSB -> driver -> glue logic)
@@ -442,13 +796,13 @@ static bool xmit_setup_next_glue_ntb(void) {
  * Return pointer to an available receive buffer or NULL.
  * Returned buffer (if any) has the size \a CFG_TUD_NCM_OUT_NTB_MAX_SIZE.
  */
-static recv_ntb_t *recv_get_free_ntb(void) {
+static recv_ntb_t *recv_get_free_ntb(ncm_interface_t *ncm) {
   TU_LOG_DRV("recv_get_free_ntb()\n");
 
   for (int i = 0; i < RECV_NTB_N; ++i) {
-    if (ncm_interface.recv_free_ntb[i] != NULL) {
-      recv_ntb_t *free = ncm_interface.recv_free_ntb[i];
-      ncm_interface.recv_free_ntb[i] = NULL;
+    if (ncm->recv_free_ntb[i] != NULL) {
+      recv_ntb_t *free = ncm->recv_free_ntb[i];
+      ncm->recv_free_ntb[i] = NULL;
       return free;
     }
   }
@@ -459,26 +813,38 @@ static recv_ntb_t *recv_get_free_ntb(void) {
  * Get the next NTB from the ready list (and remove it from the list).
  * If the ready list is empty, return NULL.
  */
-static recv_ntb_t *recv_get_next_ready_ntb(void) {
+static recv_ntb_t *recv_get_next_ready_ntb(ncm_interface_t *ncm) {
   recv_ntb_t *r = NULL;
 
-  r = ncm_interface.recv_ready_ntb[0];
-  memmove(ncm_interface.recv_ready_ntb + 0, ncm_interface.recv_ready_ntb + 1, sizeof(ncm_interface.recv_ready_ntb) - sizeof(ncm_interface.recv_ready_ntb[0]));
-  ncm_interface.recv_ready_ntb[RECV_NTB_N - 1] = NULL;
+  r = ncm->recv_ready_ntb[0];
+  memmove(ncm->recv_ready_ntb + 0, ncm->recv_ready_ntb + 1, sizeof(ncm->recv_ready_ntb) - sizeof(ncm->recv_ready_ntb[0]));
+  ncm->recv_ready_ntb[RECV_NTB_N - 1] = NULL;
 
   TU_LOG_DRV("recv_get_next_ready_ntb: %p\n", r);
   return r;
 } // recv_get_next_ready_ntb
 
+/**
+ * Index of \a ntb within the receive buffers.
+ */
+static uint8_t recv_ntb_index(ncm_interface_t *ncm, const recv_ntb_t *ntb) {
+  for (uint8_t i = 0; i < RECV_NTB_N; ++i) {
+    if (&get_epbuf(ncm)->recv[i].ntb == ntb) {
+      return i;
+    }
+  }
+  return 0;
+} // recv_ntb_index
+
 /**
  * Put NTB into the receiver free list.
  */
-static void recv_put_ntb_into_free_list(recv_ntb_t *free_ntb) {
+static void recv_put_ntb_into_free_list(ncm_interface_t *ncm, recv_ntb_t *free_ntb) {
   TU_LOG_DRV("recv_put_ntb_into_free_list(%p)\n", free_ntb);
 
   for (int i = 0; i < RECV_NTB_N; ++i) {
-    if (ncm_interface.recv_free_ntb[i] == NULL) {
-      ncm_interface.recv_free_ntb[i] = free_ntb;
+    if (ncm->recv_free_ntb[i] == NULL) {
+      ncm->recv_free_ntb[i] = free_ntb;
       return;
     }
   }
@@ -489,12 +855,13 @@ static void recv_put_ntb_into_free_list(recv_ntb_t *free_ntb) {
  * \a ready_ntb holds a validated NTB,
  * put this buffer into the waiting list.
  */
-static void recv_put_ntb_into_ready_list(recv_ntb_t *ready_ntb) {
-  TU_LOG_DRV("recv_put_ntb_into_ready_list(%p) %d\n", ready_ntb, ready_ntb->nth.wBlockLength);
+static void recv_put_ntb_into_ready_list(ncm_interface_t *ncm, recv_ntb_t *ready_ntb) {
+  TU_LOG_DRV("recv_put_ntb_into_ready_list(%p) %lu\n", ready_ntb,
+             (unsigned long) (NTB_IS_32(ncm) ? ready_ntb->nth32.dwBlockLength : ready_ntb->nth.wBlockLength));
 
   for (int i = 0; i < RECV_NTB_N; ++i) {
-    if (ncm_interface.recv_ready_ntb[i] == NULL) {
-      ncm_interface.recv_ready_ntb[i] = ready_ntb;
+    if (ncm->recv_ready_ntb[i] == NULL) {
+      ncm->recv_ready_ntb[i] = ready_ntb;
       return;
     }
   }
@@ -504,30 +871,30 @@ static void recv_put_ntb_into_ready_list(recv_ntb_t *ready_ntb) {
 /**
  * If possible, start a new reception TinyUSB -> driver.
  */
-static void recv_try_to_start_new_reception(uint8_t rhport) {
+static void recv_try_to_start_new_reception(ncm_interface_t *ncm, uint8_t rhport) {
   TU_LOG_DRV("recv_try_to_start_new_reception(%d)\n", rhport);
 
-  if (ncm_interface.itf_data_alt != 1) {
+  if (ncm->itf_data_alt != 1) {
     return;
   }
-  if (ncm_interface.recv_tinyusb_ntb != NULL) {
+  if (ncm->recv_tinyusb_ntb != NULL) {
     return;
   }
-  if (usbd_edpt_busy(rhport, ncm_interface.ep_out)) {
+  if (usbd_edpt_busy(rhport, ncm->ep_out)) {
     return;
   }
 
-  ncm_interface.recv_tinyusb_ntb = recv_get_free_ntb();
-  if (ncm_interface.recv_tinyusb_ntb == NULL) {
+  ncm->recv_tinyusb_ntb = recv_get_free_ntb(ncm);
+  if (ncm->recv_tinyusb_ntb == NULL) {
     return;
   }
 
   // initiate transfer
   TU_LOG_DRV("  start reception\n");
-  bool r = usbd_edpt_xfer(rhport, ncm_interface.ep_out, ncm_interface.recv_tinyusb_ntb->data, CFG_TUD_NCM_OUT_NTB_MAX_SIZE);
+  bool r = ntb_xfer(rhport, ncm->ep_out, ncm->recv_tinyusb_ntb->data, CFG_TUD_NCM_OUT_NTB_MAX_SIZE);
   if (!r) {
-    recv_put_ntb_into_free_list(ncm_interface.recv_tinyusb_ntb);
-    ncm_interface.recv_tinyusb_ntb = NULL;
+    recv_put_ntb_into_free_list(ncm, ncm->recv_tinyusb_ntb);
+    ncm->recv_tinyusb_ntb = NULL;
   }
 } // recv_try_to_start_new_reception
 
@@ -618,43 +985,81 @@ static bool recv_validate_datagram(const recv_ntb_t *ntb, uint32_t len) {
   return true;
 } // recv_validate_datagram
 
+/**
+ * Validate incoming NTB in 32-bit format, same rules as recv_validate_datagram()
+ * \return true if valid
+ */
+static bool recv_validate_datagram32(const recv_ntb_t *ntb, uint32_t len) {
+  const nth32_t *nth32 = &(ntb->nth32);
+  uint32_t const min_ndp_len = sizeof(ndp32_t) + 2 * sizeof(ndp32_datagram_t);
+
+  TU_LOG_DRV("recv_validate_datagram32(%p, %lu)\n", ntb, (unsigned long) len);
+
+  // check header
+  TU_VERIFY(len >= sizeof(nth32_t) + min_ndp_len, false);
+  TU_VERIFY(nth32->wHeaderLength == sizeof(nth32_t) && nth32->dwSignature == NTH32_SIGNATURE, false);
+  TU_VERIFY(nth32->dwBlockLength <= len, false);
+  TU_VERIFY(nth32->dwNdpIndex >= sizeof(nth32_t) && nth32->dwNdpIndex <= len - min_ndp_len, false);
+
+  // check (first) NDP(32), wNextNdpIndex != 0 is not supported
+  const ndp32_t *ndp32 = (const ndp32_t *) (ntb->data + nth32->dwNdpIndex);
+  TU_VERIFY(ndp32->wLength >= min_ndp_len && ndp32->wLength <= len - nth32->dwNdpIndex, false);
+  TU_VERIFY(ndp32->dwSignature == NDP32_SIGNATURE_NCM0 || ndp32->dwSignature == NDP32_SIGNATURE_NCM1, false);
+  TU_VERIFY(ndp32->dwNextNdpIndex == 0, false);
+
+  const ndp32_datagram_t *ndp32_datagram = (const ndp32_datagram_t *) (ntb->data + nth32->dwNdpIndex + sizeof(ndp32_t));
+  uint16_t const max_ndx = (uint16_t) ((ndp32->wLength - sizeof(ndp32_t)) / sizeof(ndp32_datagram_t));
+  TU_VERIFY(ndp32_datagram[max_ndx - 1].dwDatagramIndex == 0 && ndp32_datagram[max_ndx - 1].dwDatagramLength == 0, false);
+
+  for (uint16_t ndx = 0; ndp32_datagram[ndx].dwDatagramIndex != 0 && ndp32_datagram[ndx].dwDatagramLength != 0; ++ndx) {
+    uint32_t const index = ndp32_datagram[ndx].dwDatagramIndex;
+    uint32_t const length = ndp32_datagram[ndx].dwDatagramLength;
+    TU_VERIFY(index <= len && length <= len - index && length <= UINT16_MAX, false);
+  }
+
+  return true;
+} // recv_validate_datagram32
+
 /**
  * Transfer the next (pending) datagram to the glue logic and return receive buffer if empty.
  */
-static void recv_transfer_datagram_to_glue_logic(void) {
+static void recv_transfer_datagram_to_glue_logic(ncm_interface_t *ncm) {
   TU_LOG_DRV("recv_transfer_datagram_to_glue_logic()\n");
 
-  if (ncm_interface.recv_glue_ntb == NULL) {
-    ncm_interface.recv_glue_ntb = recv_get_next_ready_ntb();
-    TU_LOG_DRV("  new buffer for glue logic: %p\n", ncm_interface.recv_glue_ntb);
-    ncm_interface.recv_glue_ntb_datagram_ndx = 0;
+  if (ncm->recv_glue_ntb == NULL) {
+    ncm->recv_glue_ntb = recv_get_next_ready_ntb(ncm);
+    TU_LOG_DRV("  new buffer for glue logic: %p\n", ncm->recv_glue_ntb);
+    ncm->recv_glue_ntb_datagram_ndx = 0;
   }
 
-  if (ncm_interface.recv_glue_ntb != NULL) {
-    const ndp16_datagram_t *ndp16_datagram = (ndp16_datagram_t *) (ncm_interface.recv_glue_ntb->data + ncm_interface.recv_glue_ntb->nth.wNdpIndex + sizeof(ndp16_t));
+  if (ncm->recv_glue_ntb != NULL) {
+    uint32_t datagramIndex;
+    uint16_t datagramLength;
+    recv_ntb_datagram(ncm, ncm->recv_glue_ntb, ncm->recv_glue_ntb_datagram_ndx, &datagramIndex, &datagramLength);
 
-    if (ndp16_datagram[ncm_interface.recv_glue_ntb_datagram_ndx].wDatagramIndex == 0) {
+    if (datagramIndex == 0) {
       TU_LOG_DRV("(EE) SOMETHING WENT WRONG 1\n");
-    } else if (ndp16_datagram[ncm_interface.recv_glue_ntb_datagram_ndx].wDatagramLength == 0) {
+    } else if (datagramLength == 0) {
       TU_LOG_DRV("(EE) SOMETHING WENT WRONG 2\n");
     } else {
-      uint16_t datagramIndex = ndp16_datagram[ncm_interface.recv_glue_ntb_datagram_ndx].wDatagramIndex;
-      uint16_t datagramLength = ndp16_datagram[ncm_interface.recv_glue_ntb_datagram_ndx].wDatagramLength;
-
-      TU_LOG_DRV("  recv[%d] - %d %d\n", ncm_interface.recv_glue_ntb_datagram_ndx, datagramIndex, datagramLength);
-      if (tud_network_recv_cb(ncm_interface.recv_glue_ntb->data + datagramIndex, datagramLength)) {
+      TU_LOG_DRV("  recv[%d] - %lu %d\n", ncm->recv_glue_ntb_datagram_ndx, (unsigned long) datagramIndex, datagramLength);
+      #if CFG_TUD_NCM_CSUM_OFFLOAD
+      ncm->recv_glue_csum = recv_csum_verify(ncm->recv_glue_ntb->data + datagramIndex, datagramLength);
+      #endif
+      if (glue_recv_cb(ncm, ncm->recv_glue_ntb->data + datagramIndex, datagramLength)) {
         // send datagram successfully to glue logic
         TU_LOG_DRV("    OK\n");
-        datagramIndex = ndp16_datagram[ncm_interface.recv_glue_ntb_datagram_ndx + 1].wDatagramIndex;
-        datagramLength = ndp16_datagram[ncm_interface.recv_glue_ntb_datagram_ndx + 1].wDatagramLength;
+        recv_ntb_datagram(ncm, ncm->recv_glue_ntb, ncm->recv_glue_ntb_datagram_ndx + 1, &datagramIndex, &datagramLength);
 
         if (datagramIndex != 0 && datagramLength != 0) {
           // -> next datagram
-          ++ncm_interface.recv_glue_ntb_datagram_ndx;
+          ++ncm->recv_glue_ntb_datagram_ndx;
         } else {
-          // end of datagrams reached
-          recv_put_ntb_into_free_list(ncm_interface.recv_glue_ntb);
-          ncm_interface.recv_glue_ntb = NULL;
+          // end of datagrams reached, a held NTB is returned by tud_network_recv_release()
+          if (recv_hold(ncm)[recv_ntb_index(ncm, ncm->recv_glue_ntb)] == 0) {
+            recv_put_ntb_into_free_list(ncm, ncm->recv_glue_ntb);
+          }
+          ncm->recv_glue_ntb = NULL;
         }
       }
     }
@@ -667,93 +1072,188 @@ static void recv_transfer_datagram_to_glue_logic(void) {
 //
 
 /**
- * Check if the glue logic is allowed to call tud_network_xmit().
- * This function also fetches a next buffer if required, so that tud_network_xmit() is ready for copy
+ * Check if the glue logic is allowed to call tud_network_n_xmit().
+ * This function also fetches a next buffer if required, so that tud_network_n_xmit() is ready for copy
  * and transmission operation.
  */
-bool tud_network_can_xmit(uint16_t size) {
-  TU_LOG_DRV("tud_network_can_xmit(%d)\n", size);
+bool tud_network_n_can_xmit(uint8_t itf, uint16_t size) {
+  TU_LOG_DRV("tud_network_can_xmit(%d,%d)\n", itf, size);
 
-  TU_ASSERT(size <= CFG_TUD_NCM_IN_NTB_MAX_SIZE - (sizeof(nth16_t) + sizeof(ndp16_t) + 2 * sizeof(ndp16_datagram_t)), false);
+  ncm_interface_t *ncm = get_itf(itf);
+  TU_VERIFY(ncm != NULL, false);
+  TU_ASSERT(size <= xmit_ntb_max_size(ncm) - xmit_ntb_header_size(ncm), false);
 
-  if (xmit_requested_datagram_fits_into_current_ntb(size) || xmit_setup_next_glue_ntb()) {
+  if (xmit_requested_datagram_fits_into_current_ntb(ncm, size) || xmit_setup_next_glue_ntb(ncm)) {
     // -> everything is fine
     return true;
   }
-  xmit_start_if_possible(ncm_interface.rhport);
+  xmit_start_if_possible(ncm, ncm->rhport);
   TU_LOG_DRV("(II) tud_network_can_xmit: request blocked\n");// could happen if all xmit buffers are full (but should happen rarely)
   return false;
-} // tud_network_can_xmit
+} // tud_network_n_can_xmit
 
 /**
  * Put a datagram into a waiting NTB.
  * If currently no transmission is started, then initiate transmission.
  */
-void tud_network_xmit(void *ref, uint16_t arg) {
-  TU_LOG_DRV("tud_network_xmit(%p, %d)\n", ref, arg);
+void tud_network_n_xmit(uint8_t itf, void *ref, uint16_t arg) {
+  TU_LOG_DRV("tud_network_xmit(%d,%p,%d)\n", itf, ref, arg);
+
+  ncm_interface_t *ncm = get_itf(itf);
+  TU_VERIFY(ncm != NULL,);
 
-  if (ncm_interface.xmit_glue_ntb == NULL) {
+  if (ncm->xmit_glue_ntb == NULL) {
     TU_LOG_DRV("(EE) tud_network_xmit: no buffer\n");// must not happen (really)
     return;
   }
 
-  xmit_ntb_t *ntb = ncm_interface.xmit_glue_ntb;
+  xmit_ntb_t *ntb = ncm->xmit_glue_ntb;
 
   // copy new datagram to the end of the current NTB
-  uint16_t size = tud_network_xmit_cb(ntb->data + ntb->nth.wBlockLength, ref, arg);
+  uint32_t const len = xmit_ntb_len(ncm, ntb);
+  uint16_t size = glue_xmit_cb(ncm, ntb->data + len, ref, arg);
+
+  #if CFG_TUD_NCM_CSUM_OFFLOAD
+  xmit_csum_fill(ntb->data + len, size);
+  #endif
 
   // correct NTB internals
-  ntb->ndp_datagram[ncm_interface.xmit_glue_ntb_datagram_ndx].wDatagramIndex = ntb->nth.wBlockLength;
-  ntb->ndp_datagram[ncm_interface.xmit_glue_ntb_datagram_ndx].wDatagramLength = size;
-  ncm_interface.xmit_glue_ntb_datagram_ndx += 1;
+  xmit_ntb_datagram_set(ncm, ntb, ncm->xmit_glue_ntb_datagram_ndx, len, size);
+  ncm->xmit_glue_ntb_datagram_ndx += 1;
 
-  ntb->nth.wBlockLength += (uint16_t) (size + XMIT_ALIGN_OFFSET(size));
+  xmit_ntb_len_set(ncm, ntb, len + size + XMIT_ALIGN_OFFSET(size));
 
-  if (ntb->nth.wBlockLength > CFG_TUD_NCM_IN_NTB_MAX_SIZE) {
+  if (xmit_ntb_len(ncm, ntb) > xmit_ntb_max_size(ncm)) {
     TU_LOG_DRV("(EE) tud_network_xmit: buffer overflow\n"); // must not happen (really)
     return;
   }
 
-  xmit_start_if_possible(ncm_interface.rhport);
-} // tud_network_xmit
+  xmit_start_if_possible(ncm, ncm->rhport);
+} // tud_network_n_xmit
 
 /**
  * Keep the receive logic busy and transfer pending packets to the glue logic.
  * Avoid recursive calls due to wrong expectations of the net glue logic,
  * see https://github.com/hathach/tinyusb/issues/2711
  */
-void tud_network_recv_renew(void) {
-  TU_LOG_DRV("tud_network_recv_renew()\n");
-
-  ncm_interface.tud_network_recv_renew_process_again = true;
+static void recv_renew(ncm_interface_t *ncm) {
+  ncm->tud_network_recv_renew_process_again = true;
 
-  if (ncm_interface.tud_network_recv_renew_active) {
+  if (ncm->tud_network_recv_renew_active) {
     TU_LOG_DRV("Re-entrant into tud_network_recv_renew, will process later\n");
     return;
   }
 
-  while (ncm_interface.tud_network_recv_renew_process_again) {
-    ncm_interface.tud_network_recv_renew_process_again = false;
+  while (ncm->tud_network_recv_renew_process_again) {
+    ncm->tud_network_recv_renew_process_again = false;
 
     // If the current function is called within recv_transfer_datagram_to_glue_logic,
     // tud_network_recv_renew_process_again will become true, and the loop will run again
     // Otherwise the loop will not run again
-    ncm_interface.tud_network_recv_renew_active = true;
-    recv_transfer_datagram_to_glue_logic();
-    ncm_interface.tud_network_recv_renew_active = false;
+    ncm->tud_network_recv_renew_active = true;
+    recv_transfer_datagram_to_glue_logic(ncm);
+    ncm->tud_network_recv_renew_active = false;
+  }
+  recv_try_to_start_new_reception(ncm, ncm->rhport);
+} // recv_renew
+
+void tud_network_n_recv_renew(uint8_t itf) {
+  TU_LOG_DRV("tud_network_recv_renew(%d)\n", itf);
+
+  ncm_interface_t *ncm = get_itf(itf);
+  TU_VERIFY(ncm != NULL,);
+  recv_renew(ncm);
+} // tud_network_n_recv_renew
+
+/**
+ * Keep the NTB of the datagram currently passed to the receive callback, so that the glue logic can reference
+ * the datagram in place instead of copying it.
+ * Refused if no other NTB would be left for reception, the glue logic must then copy the datagram.
+ */
+void *tud_network_n_recv_hold(uint8_t itf) {
+  ncm_interface_t *ncm = get_itf(itf);
+  TU_VERIFY(ncm != NULL, NULL);
+
+  recv_ntb_t *ntb = ncm->recv_glue_ntb;
+  TU_VERIFY(ntb != NULL, NULL);
+
+  uint8_t const ndx = recv_ntb_index(ncm, ntb);
+  if (recv_hold(ncm)[ndx] == 0) {
+    uint8_t held = 1;
+    for (int i = 0; i < RECV_NTB_N; ++i) {
+      if (recv_hold(ncm)[i] != 0) {
+        ++held;
+      }
+    }
+    TU_VERIFY(held < RECV_NTB_N, NULL);
+  }
+  TU_VERIFY(recv_hold(ncm)[ndx] < UINT8_MAX, NULL);
+
+  ++recv_hold(ncm)[ndx];
+  TU_LOG_DRV("tud_network_recv_hold: %p %d\n", ntb, recv_hold(ncm)[ndx]);
+  return ntb;
+} // tud_network_n_recv_hold
+
+/**
+ * Drop a reference taken by tud_network_n_recv_hold().
+ * NTB is reused for reception if all its datagrams are passed to the glue logic and released.
+ * The handle identifies the instance, so no interface index is required.
+ */
+void tud_network_recv_release(void *handle) {
+  recv_ntb_t *ntb = (recv_ntb_t *) handle;
+  ncm_interface_t *ncm = NULL;
+  uint8_t ndx = 0;
+
+  TU_LOG_DRV("tud_network_recv_release(%p)\n", ntb);
+  for (uint8_t i = 0; i < CFG_TUD_NCM && ncm == NULL; ++i) {
+    for (uint8_t n = 0; n < RECV_NTB_N; ++n) {
+      if (ntb == &ncm_epbuf[i].recv[n].ntb) {
+        ncm = &ncm_interface[i];
+        ndx = n;
+        break;
+      }
+    }
+  }
+  TU_VERIFY(ncm != NULL && recv_hold(ncm)[ndx] != 0,);
+
+  if (--recv_hold(ncm)[ndx] == 0 && ntb != ncm->recv_glue_ntb) {
+    recv_put_ntb_into_free_list(ncm, ntb);
+    recv_try_to_start_new_reception(ncm, ncm->rhport);
   }
-  recv_try_to_start_new_reception(ncm_interface.rhport);
-} // tud_network_recv_renew
+} // tud_network_recv_release
 
 /**
- * Same as tud_network_recv_renew() but knows \a rhport
+ * Copy the statistics of transmitted NTBs, optionally clear them.
  */
-static void tud_network_recv_renew_r(uint8_t rhport) {
+void tud_network_n_xmit_stats(uint8_t itf, tud_network_xmit_stats_t *stats, bool clear) {
+  TU_VERIFY(itf < CFG_TUD_NCM,);
+  ncm_interface_t *ncm = &ncm_interface[itf];
+
+  if (stats != NULL) {
+    *stats = ncm->xmit_stats;
+  }
+  if (clear) {
+    memset(&ncm->xmit_stats, 0, sizeof(ncm->xmit_stats));
+  }
+} // tud_network_n_xmit_stats
+
+/**
+ * Checksum verification result of the datagram currently passed to the receive callback.
+ */
+uint8_t tud_network_n_recv_csum(uint8_t itf) {
+  TU_VERIFY(itf < CFG_TUD_NCM, 0);
+  return ncm_interface[itf].recv_glue_csum;
+} // tud_network_n_recv_csum
+
+/**
+ * Same as recv_renew() but knows \a rhport
+ */
+static void tud_network_recv_renew_r(ncm_interface_t *ncm, uint8_t rhport) {
   TU_LOG_DRV("tud_network_recv_renew_r(%d)\n", rhport);
 
-  ncm_interface.rhport = rhport;
-  tud_network_recv_renew();
-} // tud_network_recv_renew
+  ncm->rhport = rhport;
+  recv_renew(ncm);
+} // tud_network_recv_renew_r
 
 //-----------------------------------------------------------------------------
 //
@@ -766,13 +1266,20 @@ static void tud_network_recv_renew_r(uint8_t rhport) {
 void netd_init(void) {
   TU_LOG_DRV("netd_init()\n");
 
-  memset(&ncm_interface, 0, sizeof(ncm_interface));
+  memset(ncm_interface, 0, sizeof(ncm_interface));
 
-  for (int i = 0; i < XMIT_NTB_N; ++i) {
-    ncm_interface.xmit_free_ntb[i] = &ncm_epbuf.xmit[i].ntb;
-  }
-  for (int i = 0; i < RECV_NTB_N; ++i) {
-    ncm_interface.recv_free_ntb[i] = &ncm_epbuf.recv[i].ntb;
+  for (uint8_t itf = 0; itf < CFG_TUD_NCM; ++itf) {
+    ncm_interface_t *ncm = &ncm_interface[itf];
+
+    for (int i = 0; i < XMIT_NTB_N; ++i) {
+      ncm->xmit_free_ntb[i] = &get_epbuf(ncm)->xmit[i].ntb;
+    }
+    ncm->xmit_coalesce.timeout = CFG_TUD_NCM_IN_COALESCE_MS;
+    for (int i = 0, n = 0; i < RECV_NTB_N; ++i) {
+      if (recv_hold(ncm)[i] == 0) {
+        ncm->recv_free_ntb[n++] = &get_epbuf(ncm)->recv[i].ntb;
+      }
+    }
   }
 } // netd_init
 
@@ -803,14 +1310,24 @@ void netd_reset(uint8_t rhport) {
  *   structure and the values are well known.  But we do it this way.
  *
  * \post
+ * - first free instance is taken
  * - \a itf_num set
  * - \a ep_notif, \a ep_in and \a ep_out are set
  * - USB interface is open
  */
 uint16_t netd_open(uint8_t rhport, tusb_desc_interface_t const *itf_desc, uint16_t max_len) {
-  TU_ASSERT(ncm_interface.ep_notif == 0, 0);// assure that the interface is only opened once
+  // find a free instance, each interface is only opened once
+  ncm_interface_t *ncm = NULL;
+  for (uint8_t itf = 0; itf < CFG_TUD_NCM; ++itf) {
+    if (ncm_interface[itf].ep_notif == 0) {
+      ncm = &ncm_interface[itf];
+      break;
+    }
+  }
+  TU_ASSERT(ncm != NULL, 0);
 
-  ncm_interface.itf_num = itf_desc->bInterfaceNumber;// management interface
+  ncm->rhport = rhport;
+  ncm->itf_num = itf_desc->bInterfaceNumber;// management interface
 
   // skip the two first entries and the following TUSB_DESC_CS_INTERFACE entries
   uint16_t drv_len = sizeof(tusb_desc_interface_t);
@@ -823,7 +1340,7 @@ uint16_t netd_open(uint8_t rhport, tusb_desc_interface_t const *itf_desc, uint16
   // get notification endpoint
   TU_ASSERT(tu_desc_type(p_desc) == TUSB_DESC_ENDPOINT, 0);
   TU_ASSERT(usbd_edpt_open(rhport, (tusb_desc_endpoint_t const *) p_desc), 0);
-  ncm_interface.ep_notif = ((tusb_desc_endpoint_t const *) p_desc)->bEndpointAddress;
+  ncm->ep_notif = ((tusb_desc_endpoint_t const *) p_desc)->bEndpointAddress;
   drv_len += tu_desc_len(p_desc);
   p_desc = tu_desc_next(p_desc);
 
@@ -838,9 +1355,13 @@ uint16_t netd_open(uint8_t rhport, tusb_desc_interface_t const *itf_desc, uint16
 
   // a TUSB_DESC_ENDPOINT (actually two) must follow, open these endpoints
   TU_ASSERT(tu_desc_type(p_desc) == TUSB_DESC_ENDPOINT, 0);
-  TU_ASSERT(usbd_open_edpt_pair(rhport, p_desc, 2, TUSB_XFER_BULK, &ncm_interface.ep_out, &ncm_interface.ep_in));
+  TU_ASSERT(usbd_open_edpt_pair(rhport, p_desc, 2, TUSB_XFER_BULK, &ncm->ep_out, &ncm->ep_in));
   drv_len += 2 * sizeof(tusb_desc_endpoint_t);
 
+  #if CFG_TUD_NCM_IN_COALESCE_MS
+  usbd_sof_enable(rhport, SOF_CONSUMER_NCM, true); // tick aggregation timeout
+  #endif
+
   return drv_len;
 } // netd_open
 
@@ -850,39 +1371,91 @@ uint16_t netd_open(uint8_t rhport, tusb_desc_interface_t const *itf_desc, uint16
 bool netd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes) {
   (void) result;
 
-  if (ep_addr == ncm_interface.ep_out) {
+  ncm_interface_t *ncm = NULL;
+  for (uint8_t itf = 0; itf < CFG_TUD_NCM; ++itf) {
+    ncm_interface_t *p = &ncm_interface[itf];
+    if (ep_addr == p->ep_out || ep_addr == p->ep_in || ep_addr == p->ep_notif) {
+      ncm = p;
+      break;
+    }
+  }
+  TU_VERIFY(ncm != NULL);
+
+  if (ep_addr == ncm->ep_out) {
     // new NTB received
     // - make the NTB valid
     // - if ready transfer datagrams to the glue logic for further processing
     // - if there is a free receive buffer, initiate reception
-    if (!recv_validate_datagram(ncm_interface.recv_tinyusb_ntb, xferred_bytes)) {
+    bool const valid = NTB_IS_32(ncm) ? recv_validate_datagram32(ncm->recv_tinyusb_ntb, xferred_bytes) :
+                                        recv_validate_datagram(ncm->recv_tinyusb_ntb, xferred_bytes);
+    if (!valid) {
       // verification failed: ignore NTB and return it to free
       TU_LOG_DRV("Invalid datatagram. Ignoring NTB\n");
-      recv_put_ntb_into_free_list(ncm_interface.recv_tinyusb_ntb);
+      recv_put_ntb_into_free_list(ncm, ncm->recv_tinyusb_ntb);
     } else {
       // packet ok -> put it into ready list
-      recv_put_ntb_into_ready_list(ncm_interface.recv_tinyusb_ntb);
+      recv_put_ntb_into_ready_list(ncm, ncm->recv_tinyusb_ntb);
     }
-    ncm_interface.recv_tinyusb_ntb = NULL;
-    tud_network_recv_renew_r(rhport);
-  } else if (ep_addr == ncm_interface.ep_in) {
+    ncm->recv_tinyusb_ntb = NULL;
+    tud_network_recv_renew_r(ncm, rhport);
+  } else if (ep_addr == ncm->ep_in) {
     // transmission of an NTB finished
     // - free the transmitted NTB buffer
     // - insert ZLPs when necessary
     // - if there is another transmit NTB waiting, try to start transmission
-    xmit_put_ntb_into_free_list(ncm_interface.xmit_tinyusb_ntb);
-    ncm_interface.xmit_tinyusb_ntb = NULL;
-    if (!xmit_insert_required_zlp(rhport, xferred_bytes)) {
-      xmit_start_if_possible(rhport);
+    xmit_put_ntb_into_free_list(ncm, ncm->xmit_tinyusb_ntb);
+    ncm->xmit_tinyusb_ntb = NULL;
+    if (!xmit_insert_required_zlp(ncm, rhport, xferred_bytes)) {
+      #if CFG_TUD_NCM_IN_COALESCE_MS
+      if (!ncm->xmit_coalescing && ncm->xmit_ready_ntb[0] == NULL &&
+          ncm->xmit_glue_ntb != NULL && ncm->xmit_glue_ntb_datagram_ndx != 0) {
+        // datagrams queued up during transmission -> heavy traffic, aggregate more of them
+        ncm->xmit_coalescing = true;
+        tu_edpt_coalesce_arm(&ncm->xmit_coalesce);
+      }
+      #endif
+      xmit_start_if_possible(ncm, rhport);
     }
-  } else if (ep_addr == ncm_interface.ep_notif) {
+  } else if (ep_addr == ncm->ep_notif) {
     // next transfer on notification channel
-    notification_xmit(rhport, true);
+    notification_xmit(ncm, rhport, true);
   }
 
   return true;
 } // netd_xfer_cb
 
+#if CFG_TUD_NCM_IN_COALESCE_MS
+/**
+ * Aggregation timeout expired, deferred from SOF ISR: send what has been collected.
+ */
+static void netd_coalesce_flush(void *param) {
+  ncm_interface_t *ncm = (ncm_interface_t *) param;
+
+  if (ncm->xmit_coalescing) {
+    ncm->xmit_coalescing = false;
+    if (ncm->xmit_tinyusb_ntb == NULL && ncm->xmit_ready_ntb[0] == NULL &&
+        ncm->xmit_glue_ntb != NULL && ncm->xmit_glue_ntb_datagram_ndx != 0) {
+      ncm->xmit_stats.timeout_count++;
+    }
+    xmit_start_if_possible(ncm, ncm->rhport);
+  }
+} // netd_coalesce_flush
+
+/**
+ * Tick aggregation timeout.
+ */
+void netd_sof(uint8_t rhport, uint32_t frame_count) {
+  (void) rhport;
+
+  for (uint8_t itf = 0; itf < CFG_TUD_NCM; ++itf) {
+    ncm_interface_t *ncm = &ncm_interface[itf];
+    if (tu_edpt_coalesce_tick(&ncm->xmit_coalesce, frame_count)) {
+      usbd_defer_func(netd_coalesce_flush, ncm, true);
+    }
+  }
+} // netd_sof
+#endif
+
 /**
  * Respond to TinyUSB control requests.
  * At startup transmission of notification packets are done here.
@@ -892,24 +1465,36 @@ bool netd_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t
     return true;
   }
 
+  // management interface is addressed by class requests, data interface by GET/SET_INTERFACE
+  uint8_t const itf_num = (uint8_t) request->wIndex;
+  ncm_interface_t *ncm = NULL;
+  for (uint8_t itf = 0; itf < CFG_TUD_NCM; ++itf) {
+    ncm_interface_t *p = &ncm_interface[itf];
+    if (p->ep_notif != 0 && (itf_num == p->itf_num || itf_num == p->itf_num + 1)) {
+      ncm = p;
+      break;
+    }
+  }
+  TU_VERIFY(ncm != NULL);
+
   switch (request->bmRequestType_bit.type) {
     case TUSB_REQ_TYPE_STANDARD:
 
       switch (request->bRequest) {
         case TUSB_REQ_GET_INTERFACE: {
-          TU_VERIFY(ncm_interface.itf_num + 1 == request->wIndex, false);
+          TU_VERIFY(ncm->itf_num + 1 == request->wIndex, false);
 
-          tud_control_xfer(rhport, request, &ncm_interface.itf_data_alt, 1);
+          tud_control_xfer(rhport, request, &ncm->itf_data_alt, 1);
         } break;
 
         case TUSB_REQ_SET_INTERFACE: {
-          TU_VERIFY(ncm_interface.itf_num + 1 == request->wIndex && request->wValue < 2, false);
+          TU_VERIFY(ncm->itf_num + 1 == request->wIndex && request->wValue < 2, false);
 
-          ncm_interface.itf_data_alt = (uint8_t) request->wValue;
+          ncm->itf_data_alt = (uint8_t) request->wValue;
 
-          if (ncm_interface.itf_data_alt == 1) {
-            tud_network_recv_renew_r(rhport);
-            notification_xmit(rhport, false);
+          if (ncm->itf_data_alt == 1) {
+            tud_network_recv_renew_r(ncm, rhport);
+            notification_xmit(ncm, rhport, false);
           }
           tud_control_status(rhport, request);
         } break;
@@ -921,13 +1506,28 @@ bool netd_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t
       break;
 
     case TUSB_REQ_TYPE_CLASS:
-      TU_VERIFY(ncm_interface.itf_num == request->wIndex, false);
+      TU_VERIFY(ncm->itf_num == request->wIndex, false);
       switch (request->bRequest) {
         case NCM_GET_NTB_PARAMETERS: {
           // transfer NTB parameters to host.
           tud_control_xfer(rhport, request, (void *) (uintptr_t) &ntb_parameters, sizeof(ntb_parameters));
         } break;
 
+        case NCM_GET_NTB_FORMAT: {
+          tud_control_xfer(rhport, request, &ncm->ntb_format, sizeof(ncm->ntb_format));
+        } break;
+
+        case NCM_SET_NTB_FORMAT: {
+          // format can only be changed while data interface is in alternate setting 0
+          uint16_t const max_format = CFG_TUD_NCM_NTB32 ? NCM_NTB_FORMAT_32 : NCM_NTB_FORMAT_16;
+          TU_VERIFY(ncm->itf_data_alt == 0 && request->wValue <= max_format, false);
+          if (ncm->ntb_format != request->wValue) {
+            xmit_drop_pending_ntb(ncm);
+            ncm->ntb_format = request->wValue;
+          }
+          tud_control_status(rhport, request);
+        } break;
+
           // unsupported request
         default:
           return false;
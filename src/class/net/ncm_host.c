@@ -0,0 +1,815 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#include "tusb_option.h"
+
+#if (CFG_TUH_ENABLED && CFG_TUH_NCM)
+
+#include "host/usbh.h"
+#include "host/usbh_pvt.h"
+
+#include "ncm_host.h"
+
+// Level where CFG_TUSB_DEBUG must be at least for this driver is logged
+#ifndef CFG_TUH_NCM_LOG_LEVEL
+  #define CFG_TUH_NCM_LOG_LEVEL   CFG_TUH_LOG_LEVEL
+#endif
+
+#define TU_LOG_DRV(...)   TU_LOG(CFG_TUH_NCM_LOG_LEVEL, __VA_ARGS__)
+
+// Submit all free reception NTBs at once: usbh queue completes them in order
+#define NCMH_RX_MULTI_URB   (CFG_TUH_EDPT_XFER_QUEUE && CFG_TUH_API_EDPT_XFER)
+
+#define RX_NTB_N            CFG_TUH_NCM_RX_NTB_N
+#define TX_NTB_N            CFG_TUH_NCM_TX_NTB_N
+
+//--------------------------------------------------------------------+
+// Host NCM Interface
+//--------------------------------------------------------------------+
+
+typedef struct {
+  uint8_t daddr;
+  uint8_t itf_num;     // communication interface
+  uint8_t itf_data;    // data interface
+  uint8_t ep_notif;
+  uint8_t ep_in;
+  uint8_t ep_out;
+  uint16_t ep_out_size;
+
+  uint8_t mac_index;   // iMACAddress string
+  bool mac_valid;
+  uint8_t mac[6];
+
+  volatile bool mounted;
+  bool connected;
+
+  // reception: NTB ring in order of submission, from head: ready (completed) then armed (submitted) ones
+  uint8_t rx_head;
+  uint8_t rx_ready;
+  uint8_t rx_armed;
+  bool rx_paused;      // application could not consume datagram
+  bool rx_stalled;
+  uint16_t rx_ndp;     // delivery cursor in head NTB: NDP offset (0 if not started) and datagram index
+  uint16_t rx_dg;
+  uint16_t rx_len[RX_NTB_N]; // 0 if NTB is dropped
+
+  // transmission: NTB ring from head: queued (closed) ones, first one in flight, then the one being filled
+  uint8_t tx_head;
+  uint8_t tx_queued;
+  bool tx_busy;
+  uint8_t tx_dg_count; // datagrams in filling NTB
+  uint16_t tx_seq;
+  uint16_t tx_len[TX_NTB_N]; // NTB length if closed, end of last datagram if filling
+  ndp16_datagram_t tx_dg[CFG_TUH_NCM_TX_MAX_DATAGRAMS];
+
+  // device NTB parameters for transmission
+  uint16_t tx_max_size;
+  uint16_t tx_divisor;
+  uint16_t tx_remainder;
+  uint16_t tx_ndp_align;
+  uint8_t tx_max_datagrams;
+} ncmh_interface_t;
+
+typedef struct {
+  TUH_EPBUF_DEF(data, CFG_TUH_NCM_RX_NTB_SIZE);
+} ncmh_rx_ntb_t;
+
+typedef struct {
+  TUH_EPBUF_DEF(data, CFG_TUH_NCM_TX_NTB_SIZE);
+} ncmh_tx_ntb_t;
+
+typedef struct {
+  ncmh_rx_ntb_t rx[RX_NTB_N];
+  ncmh_tx_ntb_t tx[TX_NTB_N];
+  TUH_EPBUF_TYPE_DEF(ncm_notify_t, notif);
+} ncmh_epbuf_t;
+
+static ncmh_interface_t _ncmh_itf[CFG_TUH_NCM];
+CFG_TUH_MEM_SECTION static ncmh_epbuf_t _ncmh_epbuf[CFG_TUH_NCM];
+
+static void rx_submit(ncmh_interface_t* p_ncm, uint8_t idx);
+static void tx_try_send(ncmh_interface_t* p_ncm, uint8_t idx);
+
+//--------------------------------------------------------------------+
+// Helper
+//--------------------------------------------------------------------+
+
+static inline ncmh_interface_t* get_itf(uint8_t idx) {
+  TU_ASSERT(idx < CFG_TUH_NCM, NULL);
+  ncmh_interface_t* p_ncm = &_ncmh_itf[idx];
+
+  return (p_ncm->daddr != 0) ? p_ncm : NULL;
+}
+
+static inline uint8_t get_idx_by_ep_addr(uint8_t daddr, uint8_t ep_addr) {
+  for (uint8_t i = 0; i < CFG_TUH_NCM; i++) {
+    ncmh_interface_t* p_ncm = &_ncmh_itf[i];
+    if ((p_ncm->daddr == daddr) &&
+        (ep_addr == p_ncm->ep_notif || ep_addr == p_ncm->ep_in || ep_addr == p_ncm->ep_out)) {
+      return i;
+    }
+  }
+
+  return TUSB_INDEX_INVALID_8;
+}
+
+static ncmh_interface_t* make_new_itf(uint8_t daddr, tusb_desc_interface_t const* itf_desc) {
+  for (uint8_t i = 0; i < CFG_TUH_NCM; i++) {
+    ncmh_interface_t* p_ncm = &_ncmh_itf[i];
+    if (p_ncm->daddr == 0) {
+      tu_memclr(p_ncm, sizeof(ncmh_interface_t));
+      p_ncm->daddr   = daddr;
+      p_ncm->itf_num = itf_desc->bInterfaceNumber;
+      return p_ncm;
+    }
+  }
+
+  return NULL;
+}
+
+//--------------------------------------------------------------------+
+// Application API
+//--------------------------------------------------------------------+
+
+uint8_t tuh_ncm_itf_get_index(uint8_t daddr, uint8_t itf_num) {
+  for (uint8_t i = 0; i < CFG_TUH_NCM; i++) {
+    ncmh_interface_t const* p_ncm = &_ncmh_itf[i];
+    if (p_ncm->daddr == daddr && p_ncm->itf_num == itf_num) return i;
+  }
+
+  return TUSB_INDEX_INVALID_8;
+}
+
+bool tuh_ncm_itf_get_info(uint8_t idx, tuh_itf_info_t* info) {
+  ncmh_interface_t* p_ncm = get_itf(idx);
+  TU_VERIFY(p_ncm && info);
+
+  info->daddr = p_ncm->daddr;
+
+  // re-construct descriptor
+  tusb_desc_interface_t* desc = &info->desc;
+  desc->bLength            = sizeof(tusb_desc_interface_t);
+  desc->bDescriptorType    = TUSB_DESC_INTERFACE;
+
+  desc->bInterfaceNumber   = p_ncm->itf_num;
+  desc->bAlternateSetting  = 0;
+  desc->bNumEndpoints      = p_ncm->ep_notif ? 1u : 0u;
+  desc->bInterfaceClass    = TUSB_CLASS_CDC;
+  desc->bInterfaceSubClass = CDC_COMM_SUBCLASS_NETWORK_CONTROL_MODEL;
+  desc->bInterfaceProtocol = 0;
+  desc->iInterface         = 0; // not used yet
+
+  return true;
+}
+
+bool tuh_ncm_mounted(uint8_t idx) {
+  ncmh_interface_t* p_ncm = get_itf(idx);
+  TU_VERIFY(p_ncm);
+  return p_ncm->mounted;
+}
+
+bool tuh_ncm_connected(uint8_t idx) {
+  ncmh_interface_t* p_ncm = get_itf(idx);
+  TU_VERIFY(p_ncm && p_ncm->mounted);
+  return p_ncm->connected;
+}
+
+bool tuh_ncm_get_mac(uint8_t idx, uint8_t mac[6]) {
+  ncmh_interface_t* p_ncm = get_itf(idx);
+  TU_VERIFY(p_ncm && p_ncm->mac_valid);
+  memcpy(mac, p_ncm->mac, 6);
+  return true;
+}
+
+void tuh_ncm_rx_resume(uint8_t idx) {
+  ncmh_interface_t* p_ncm = get_itf(idx);
+  TU_VERIFY(p_ncm && p_ncm->mounted,);
+  p_ncm->rx_paused = false;
+  rx_submit(p_ncm, idx);
+}
+
+//--------------------------------------------------------------------+
+// Reception
+//--------------------------------------------------------------------+
+
+// Check NTH16 and the NDP16 chain so that datagrams can be delivered without further checks
+static bool rx_ntb_validate(uint8_t const* ntb, uint32_t len) {
+  nth16_t const* nth = (nth16_t const*) ntb;
+  TU_VERIFY(len >= sizeof(nth16_t));
+  TU_VERIFY(nth->dwSignature == NTH16_SIGNATURE && nth->wHeaderLength == sizeof(nth16_t));
+  TU_VERIFY(nth->wBlockLength >= sizeof(nth16_t) && nth->wBlockLength <= len && nth->wNdpIndex != 0);
+
+  uint32_t const block_len = nth->wBlockLength;
+  uint32_t ndp_index = nth->wNdpIndex;
+  uint32_t ndp_count = 0;
+
+  while (ndp_index) {
+    // guard against NDP chain looping on itself
+    TU_VERIFY(++ndp_count <= block_len / sizeof(ndp16_t));
+    TU_VERIFY(ndp_index >= sizeof(nth16_t) && (ndp_index & 3) == 0 && ndp_index + sizeof(ndp16_t) <= block_len);
+
+    ndp16_t const* ndp = (ndp16_t const*) (ntb + ndp_index);
+    TU_VERIFY(ndp->dwSignature == NDP16_SIGNATURE_NCM0);
+    TU_VERIFY(ndp->wLength >= sizeof(ndp16_t) + 2 * sizeof(ndp16_datagram_t) && ndp_index + ndp->wLength <= block_len);
+
+    ndp16_datagram_t const* datagram = (ndp16_datagram_t const*) (ndp + 1);
+    uint32_t const max_count = (uint32_t) ((ndp->wLength - sizeof(ndp16_t)) / sizeof(ndp16_datagram_t));
+    for (uint32_t i = 0; i < max_count && datagram[i].wDatagramIndex && datagram[i].wDatagramLength; i++) {
+      TU_VERIFY(datagram[i].wDatagramIndex >= sizeof(nth16_t) &&
+                (uint32_t) datagram[i].wDatagramIndex + datagram[i].wDatagramLength <= block_len);
+    }
+
+    ndp_index = ndp->wNextNdpIndex;
+  }
+
+  return true;
+}
+
+// Deliver datagrams of ready NTBs in order, free them and submit them again
+static void rx_process(ncmh_interface_t* p_ncm, uint8_t idx) {
+  while (p_ncm->rx_ready && !p_ncm->rx_paused) {
+    uint8_t const* ntb = _ncmh_epbuf[idx].rx[p_ncm->rx_head].data;
+
+    if (p_ncm->rx_len[p_ncm->rx_head]) {
+      if (p_ncm->rx_ndp == 0) {
+        p_ncm->rx_ndp = ((nth16_t const*) ntb)->wNdpIndex;
+        p_ncm->rx_dg  = 0;
+      }
+
+      while (p_ncm->rx_ndp) {
+        ndp16_t const* ndp = (ndp16_t const*) (ntb + p_ncm->rx_ndp);
+        ndp16_datagram_t const* datagram = (ndp16_datagram_t const*) (ndp + 1);
+        uint16_t const max_count = (uint16_t) ((ndp->wLength - sizeof(ndp16_t)) / sizeof(ndp16_datagram_t));
+
+        for (; p_ncm->rx_dg < max_count; p_ncm->rx_dg++) {
+          ndp16_datagram_t const* dg = &datagram[p_ncm->rx_dg];
+          if (dg->wDatagramIndex == 0 || dg->wDatagramLength == 0) {
+            break;
+          }
+          if (tuh_ncm_rx_cb && !tuh_ncm_rx_cb(idx, ntb + dg->wDatagramIndex, dg->wDatagramLength)) {
+            // keep cursor, same datagram is delivered on resume
+            p_ncm->rx_paused = true;
+            return;
+          }
+        }
+
+        p_ncm->rx_ndp = ndp->wNextNdpIndex;
+        p_ncm->rx_dg  = 0;
+      }
+    }
+
+    p_ncm->rx_head = (uint8_t) ((p_ncm->rx_head + 1) % RX_NTB_N);
+    p_ncm->rx_ready--;
+  }
+}
+
+static void rx_complete(ncmh_interface_t* p_ncm, uint8_t idx, xfer_result_t result, uint32_t xferred_bytes) {
+  TU_VERIFY(p_ncm->rx_armed,);
+
+  // completions are in submission order, first armed NTB is done
+  uint8_t const buf = (uint8_t) ((p_ncm->rx_head + p_ncm->rx_ready) % RX_NTB_N);
+  uint16_t len = (uint16_t) xferred_bytes;
+
+  if (result != XFER_RESULT_SUCCESS) {
+    TU_LOG_DRV("  NCMh RX failed %u\r\n", result);
+    len = 0;
+    if (result == XFER_RESULT_STALLED) {
+      p_ncm->rx_stalled = true;
+    }
+  } else if (!rx_ntb_validate(_ncmh_epbuf[idx].rx[buf].data, len)) {
+    TU_LOG_DRV("  NCMh RX invalid NTB, len = %u\r\n", len);
+    len = 0;
+  }
+
+  // failed or invalid NTB still takes its turn so that order is kept
+  p_ncm->rx_len[buf] = len;
+  p_ncm->rx_armed--;
+  p_ncm->rx_ready++;
+
+  rx_submit(p_ncm, idx);
+}
+
+#if NCMH_RX_MULTI_URB
+static void rx_complete_cb(tuh_xfer_t* xfer) {
+  uint8_t const idx = (uint8_t) xfer->user_data;
+  ncmh_interface_t* p_ncm = get_itf(idx);
+  TU_VERIFY(p_ncm && p_ncm->daddr == xfer->daddr && p_ncm->ep_in == xfer->ep_addr,);
+
+  rx_complete(p_ncm, idx, xfer->result, xfer->actual_len);
+}
+#endif
+
+// Deliver pending datagrams then submit free NTBs
+static void rx_submit(ncmh_interface_t* p_ncm, uint8_t idx) {
+  rx_process(p_ncm, idx);
+
+  while (!p_ncm->rx_stalled && p_ncm->rx_ready + p_ncm->rx_armed < RX_NTB_N) {
+    uint8_t const buf = (uint8_t) ((p_ncm->rx_head + p_ncm->rx_ready + p_ncm->rx_armed) % RX_NTB_N);
+    uint8_t* ntb = _ncmh_epbuf[idx].rx[buf].data;
+
+#if NCMH_RX_MULTI_URB
+    tuh_xfer_t xfer = {
+      .daddr       = p_ncm->daddr,
+      .ep_addr     = p_ncm->ep_in,
+      .buflen      = CFG_TUH_NCM_RX_NTB_SIZE,
+      .buffer      = ntb,
+      .complete_cb = rx_complete_cb,
+      .user_data   = idx
+    };
+    // stop if usbh queue is full, next completion submits the rest
+    if (!tuh_edpt_xfer(&xfer)) {
+      break;
+    }
+#else
+    if (p_ncm->rx_armed || !usbh_edpt_claim(p_ncm->daddr, p_ncm->ep_in)) {
+      break;
+    }
+    if (!usbh_edpt_xfer(p_ncm->daddr, p_ncm->ep_in, ntb, CFG_TUH_NCM_RX_NTB_SIZE)) {
+      usbh_edpt_release(p_ncm->daddr, p_ncm->ep_in);
+      break;
+    }
+#endif
+
+    p_ncm->rx_armed++;
+  }
+}
+
+//--------------------------------------------------------------------+
+// Transmission
+//--------------------------------------------------------------------+
+
+// Offset of datagram appended at pos, as per device wNdpOutDivisor and wNdpOutPayloadRemainder
+static uint32_t tx_datagram_offset(ncmh_interface_t const* p_ncm, uint32_t pos) {
+  uint32_t const divisor = p_ncm->tx_divisor;
+  return pos + (divisor + p_ncm->tx_remainder - pos % divisor) % divisor;
+}
+
+static uint32_t tx_ndp_offset(ncmh_interface_t const* p_ncm, uint32_t pos) {
+  uint32_t const align = p_ncm->tx_ndp_align;
+  return (pos + align - 1) / align * align;
+}
+
+// Check if a datagram fits into filling NTB, NDP is placed after the last datagram
+static bool tx_fits(ncmh_interface_t const* p_ncm, uint8_t count, uint32_t end, uint16_t len) {
+  TU_VERIFY(count < p_ncm->tx_max_datagrams);
+  uint32_t const ndp_index = tx_ndp_offset(p_ncm, tx_datagram_offset(p_ncm, end) + len);
+  return ndp_index + sizeof(ndp16_t) + (count + 2u) * sizeof(ndp16_datagram_t) <= p_ncm->tx_max_size;
+}
+
+TU_ATTR_ALWAYS_INLINE static inline uint8_t tx_fill_index(ncmh_interface_t const* p_ncm) {
+  return (uint8_t) ((p_ncm->tx_head + p_ncm->tx_queued) % TX_NTB_N);
+}
+
+TU_ATTR_ALWAYS_INLINE static inline uint32_t tx_fill_end(ncmh_interface_t const* p_ncm) {
+  return p_ncm->tx_dg_count ? p_ncm->tx_len[tx_fill_index(p_ncm)] : sizeof(nth16_t);
+}
+
+// Write NTH and NDP of filling NTB and queue it
+static void tx_close(ncmh_interface_t* p_ncm, uint8_t idx) {
+  uint8_t const buf = tx_fill_index(p_ncm);
+  uint8_t* ntb = _ncmh_epbuf[idx].tx[buf].data;
+  uint32_t const end = p_ncm->tx_len[buf];
+  uint32_t const ndp_index = tx_ndp_offset(p_ncm, end);
+  uint8_t const count = p_ncm->tx_dg_count;
+
+  tu_memclr(ntb + end, ndp_index - end);
+
+  ndp16_t* ndp = (ndp16_t*) (ntb + ndp_index);
+  ndp->dwSignature   = NDP16_SIGNATURE_NCM0;
+  ndp->wLength       = (uint16_t) (sizeof(ndp16_t) + (count + 1u) * sizeof(ndp16_datagram_t));
+  ndp->wNextNdpIndex = 0;
+
+  ndp16_datagram_t* datagram = (ndp16_datagram_t*) (ndp + 1);
+  memcpy(datagram, p_ncm->tx_dg, count * sizeof(ndp16_datagram_t));
+  datagram[count].wDatagramIndex  = 0;
+  datagram[count].wDatagramLength = 0;
+
+  uint32_t len = ndp_index + ndp->wLength;
+
+  // NTB shorter than dwNtbOutMaxSize must end with a short packet: pad instead of sending a ZLP
+  if ((len % p_ncm->ep_out_size) == 0 && len < p_ncm->tx_max_size) {
+    ntb[len++] = 0;
+  }
+
+  nth16_t* nth = (nth16_t*) ntb;
+  nth->dwSignature   = NTH16_SIGNATURE;
+  nth->wHeaderLength = sizeof(nth16_t);
+  nth->wSequence     = p_ncm->tx_seq++;
+  nth->wBlockLength  = (uint16_t) len;
+  nth->wNdpIndex     = (uint16_t) ndp_index;
+
+  p_ncm->tx_len[buf] = (uint16_t) len;
+  p_ncm->tx_dg_count = 0;
+  p_ncm->tx_queued++;
+}
+
+// Send oldest queued NTB, or the filling one if endpoint is idle
+static void tx_try_send(ncmh_interface_t* p_ncm, uint8_t idx) {
+  if (p_ncm->tx_busy) {
+    return;
+  }
+  if (p_ncm->tx_queued == 0) {
+    if (p_ncm->tx_dg_count == 0) {
+      return;
+    }
+    tx_close(p_ncm, idx);
+  }
+
+  TU_VERIFY(usbh_edpt_claim(p_ncm->daddr, p_ncm->ep_out),);
+  if (!usbh_edpt_xfer(p_ncm->daddr, p_ncm->ep_out, _ncmh_epbuf[idx].tx[p_ncm->tx_head].data,
+                      p_ncm->tx_len[p_ncm->tx_head])) {
+    usbh_edpt_release(p_ncm->daddr, p_ncm->ep_out);
+    return;
+  }
+  p_ncm->tx_busy = true;
+}
+
+static void tx_complete(ncmh_interface_t* p_ncm, uint8_t idx, xfer_result_t result) {
+  if (result != XFER_RESULT_SUCCESS) {
+    TU_LOG_DRV("  NCMh TX failed %u\r\n", result);
+  }
+
+  // NTB is dropped on failure as well, upper layer protocol takes care of retransmission
+  p_ncm->tx_busy = false;
+  if (p_ncm->tx_queued) {
+    p_ncm->tx_head = (uint8_t) ((p_ncm->tx_head + 1) % TX_NTB_N);
+    p_ncm->tx_queued--;
+  }
+
+  tx_try_send(p_ncm, idx);
+
+  if (tuh_ncm_tx_complete_cb) {
+    tuh_ncm_tx_complete_cb(idx);
+  }
+}
+
+static bool tx_can_xmit(ncmh_interface_t const* p_ncm, uint16_t len) {
+  TU_VERIFY(p_ncm->mounted && len);
+  TU_VERIFY(p_ncm->tx_queued < TX_NTB_N);
+
+  if (tx_fits(p_ncm, p_ncm->tx_dg_count, tx_fill_end(p_ncm), len)) {
+    return true;
+  }
+
+  // filling NTB is full, a new one can be started
+  return p_ncm->tx_dg_count && (p_ncm->tx_queued + 1 < TX_NTB_N) && tx_fits(p_ncm, 0, sizeof(nth16_t), len);
+}
+
+bool tuh_ncm_can_xmit(uint8_t idx, uint16_t len) {
+  ncmh_interface_t const* p_ncm = get_itf(idx);
+  TU_VERIFY(p_ncm);
+  return tx_can_xmit(p_ncm, len);
+}
+
+bool tuh_ncm_xmit(uint8_t idx, void const* frame, uint16_t len) {
+  ncmh_interface_t* p_ncm = get_itf(idx);
+  TU_VERIFY(p_ncm && tx_can_xmit(p_ncm, len));
+
+  if (!tx_fits(p_ncm, p_ncm->tx_dg_count, tx_fill_end(p_ncm), len)) {
+    tx_close(p_ncm, idx);
+  }
+
+  uint8_t const buf = tx_fill_index(p_ncm);
+  uint8_t* ntb = _ncmh_epbuf[idx].tx[buf].data;
+  uint32_t const end = tx_fill_end(p_ncm);
+  uint32_t const pos = tx_datagram_offset(p_ncm, end);
+
+  tu_memclr(ntb + end, pos - end);
+  memcpy(ntb + pos, frame, len);
+
+  ndp16_datagram_t* datagram = &p_ncm->tx_dg[p_ncm->tx_dg_count++];
+  datagram->wDatagramIndex  = (uint16_t) pos;
+  datagram->wDatagramLength = len;
+  p_ncm->tx_len[buf] = (uint16_t) (pos + len);
+
+  tx_try_send(p_ncm, idx);
+  return true;
+}
+
+//--------------------------------------------------------------------+
+// Notification
+//--------------------------------------------------------------------+
+
+static void notif_xfer(ncmh_interface_t* p_ncm, uint8_t idx) {
+  if (p_ncm->ep_notif && usbh_edpt_claim(p_ncm->daddr, p_ncm->ep_notif)) {
+    if (!usbh_edpt_xfer(p_ncm->daddr, p_ncm->ep_notif, (uint8_t*) &_ncmh_epbuf[idx].notif, sizeof(ncm_notify_t))) {
+      usbh_edpt_release(p_ncm->daddr, p_ncm->ep_notif);
+    }
+  }
+}
+
+static void notif_process(ncmh_interface_t* p_ncm, uint8_t idx, uint32_t xferred_bytes) {
+  ncm_notify_t const* notify = &_ncmh_epbuf[idx].notif;
+  TU_VERIFY(xferred_bytes >= sizeof(tusb_control_request_t),);
+
+  switch (notify->header.bRequest) {
+    case CDC_NOTIF_NETWORK_CONNECTION:
+      p_ncm->connected = (notify->header.wValue != 0);
+      TU_LOG_DRV("  NCMh link %s\r\n", p_ncm->connected ? "up" : "down");
+      if (tuh_ncm_link_cb) {
+        tuh_ncm_link_cb(idx, p_ncm->connected);
+      }
+      break;
+
+    case CDC_NOTIF_CONNECTION_SPEED_CHANGE:
+      if (xferred_bytes >= sizeof(ncm_notify_t)) {
+        TU_LOG_DRV("  NCMh speed down = %" PRIu32 " up = %" PRIu32 "\r\n", notify->downlink, notify->uplink);
+      }
+      break;
+
+    default:
+      break;
+  }
+}
+
+//--------------------------------------------------------------------+
+// Class Driver API
+//--------------------------------------------------------------------+
+
+bool ncmh_init(void) {
+  TU_LOG_DRV("sizeof(ncmh_interface_t) = %u\r\n", sizeof(ncmh_interface_t));
+  tu_memclr(_ncmh_itf, sizeof(_ncmh_itf));
+  return true;
+}
+
+bool ncmh_deinit(void) {
+  return true;
+}
+
+void ncmh_close(uint8_t daddr) {
+  for (uint8_t idx = 0; idx < CFG_TUH_NCM; idx++) {
+    ncmh_interface_t* p_ncm = &_ncmh_itf[idx];
+    if (p_ncm->daddr == daddr) {
+      TU_LOG_DRV("  NCMh close addr = %u index = %u\r\n", daddr, idx);
+
+      if (p_ncm->mounted && tuh_ncm_umount_cb) {
+        tuh_ncm_umount_cb(idx);
+      }
+
+      tu_memclr(p_ncm, sizeof(ncmh_interface_t));
+    }
+  }
+}
+
+bool ncmh_xfer_cb(uint8_t daddr, uint8_t ep_addr, xfer_result_t event, uint32_t xferred_bytes) {
+  uint8_t const idx = get_idx_by_ep_addr(daddr, ep_addr);
+  ncmh_interface_t* p_ncm = get_itf(idx);
+  TU_VERIFY(p_ncm);
+
+  if (ep_addr == p_ncm->ep_out) {
+    tx_complete(p_ncm, idx, event);
+  } else if (ep_addr == p_ncm->ep_in) {
+    rx_complete(p_ncm, idx, event, xferred_bytes);
+  } else if (ep_addr == p_ncm->ep_notif) {
+    // not re-armed on error to avoid looping on a stalled endpoint
+    if (event == XFER_RESULT_SUCCESS) {
+      notif_process(p_ncm, idx, xferred_bytes);
+      notif_xfer(p_ncm, idx);
+    }
+  }
+
+  return true;
+}
+
+//--------------------------------------------------------------------+
+// Enumeration
+//--------------------------------------------------------------------+
+
+enum {
+  CONFIG_NCM_GET_NTB_PARAMETERS = 0,
+  CONFIG_NCM_SET_NTB_INPUT_SIZE,
+  CONFIG_NCM_SET_INTERFACE,
+  CONFIG_NCM_GET_MAC_ADDRESS,
+  CONFIG_NCM_COMPLETE,
+};
+
+bool ncmh_open(uint8_t rhport, uint8_t daddr, tusb_desc_interface_t const* itf_desc, uint16_t max_len) {
+  (void) rhport;
+
+  TU_VERIFY(TUSB_CLASS_CDC                          == itf_desc->bInterfaceClass &&
+            CDC_COMM_SUBCLASS_NETWORK_CONTROL_MODEL == itf_desc->bInterfaceSubClass);
+
+  uint8_t const* p_desc_end = ((uint8_t const*) itf_desc) + max_len;
+  ncmh_interface_t* p_ncm = make_new_itf(daddr, itf_desc);
+  TU_VERIFY(p_ncm);
+
+  //------------- Communication Interface -------------//
+  uint8_t const* p_desc = tu_desc_next(itf_desc);
+
+  // Functional descriptors
+  while ((p_desc < p_desc_end) && (TUSB_DESC_CS_INTERFACE == tu_desc_type(p_desc))) {
+    if (CDC_FUNC_DESC_ETHERNET_NETWORKING == cdc_functional_desc_typeof(p_desc) && tu_desc_len(p_desc) > 3) {
+      p_ncm->mac_index = p_desc[3]; // iMACAddress
+    }
+    p_desc = tu_desc_next(p_desc);
+  }
+
+  // Notification endpoint
+  if (itf_desc->bNumEndpoints == 1) {
+    TU_ASSERT(TUSB_DESC_ENDPOINT == tu_desc_type(p_desc));
+    tusb_desc_endpoint_t const* desc_ep = (tusb_desc_endpoint_t const*) p_desc;
+
+    TU_ASSERT(tuh_edpt_open(daddr, desc_ep));
+    p_ncm->ep_notif = desc_ep->bEndpointAddress;
+
+    p_desc = tu_desc_next(p_desc);
+  }
+
+  //------------- Data Interface -------------//
+  // alternate 0 has no endpoint, alternate 1 has the bulk pair
+  while (p_desc < p_desc_end) {
+    tusb_desc_interface_t const* desc_itf = (tusb_desc_interface_t const*) p_desc;
+    p_desc = tu_desc_next(p_desc);
+
+    if (TUSB_DESC_INTERFACE == desc_itf->bDescriptorType && TUSB_CLASS_CDC_DATA == desc_itf->bInterfaceClass &&
+        2 == desc_itf->bNumEndpoints) {
+      p_ncm->itf_data = desc_itf->bInterfaceNumber;
+
+      for (uint8_t count = 0; count < 2 && p_desc < p_desc_end; p_desc = tu_desc_next(p_desc)) {
+        if (TUSB_DESC_ENDPOINT == tu_desc_type(p_desc)) {
+          tusb_desc_endpoint_t const* desc_ep = (tusb_desc_endpoint_t const*) p_desc;
+          TU_ASSERT(TUSB_XFER_BULK == desc_ep->bmAttributes.xfer);
+          TU_ASSERT(tuh_edpt_open(daddr, desc_ep));
+
+          if (tu_edpt_dir(desc_ep->bEndpointAddress) == TUSB_DIR_IN) {
+            p_ncm->ep_in = desc_ep->bEndpointAddress;
+          } else {
+            p_ncm->ep_out      = desc_ep->bEndpointAddress;
+            p_ncm->ep_out_size = tu_edpt_packet_size(desc_ep);
+          }
+          count++;
+        }
+      }
+      break;
+    }
+  }
+
+  TU_ASSERT(p_ncm->ep_in && p_ncm->ep_out && p_ncm->ep_out_size);
+  return true;
+}
+
+static bool ncm_control_xfer(ncmh_interface_t* p_ncm, tusb_dir_t dir, uint8_t request, uint16_t len,
+                             tuh_xfer_cb_t complete_cb, uintptr_t user_data) {
+  tusb_control_request_t const req = {
+    .bmRequestType_bit = {
+      .recipient = TUSB_REQ_RCPT_INTERFACE,
+      .type      = TUSB_REQ_TYPE_CLASS,
+      .direction = dir
+    },
+    .bRequest = request,
+    .wValue   = 0,
+    .wIndex   = tu_htole16((uint16_t) p_ncm->itf_num),
+    .wLength  = tu_htole16(len)
+  };
+
+  tuh_xfer_t xfer = {
+    .daddr       = p_ncm->daddr,
+    .ep_addr     = 0,
+    .setup       = &req,
+    .buffer      = usbh_get_enum_buf(),
+    .complete_cb = complete_cb,
+    .user_data   = user_data
+  };
+
+  return tuh_control_xfer(&xfer);
+}
+
+static uint8_t hex_to_nibble(uint8_t c) {
+  if (c >= '0' && c <= '9') return (uint8_t) (c - '0');
+  if (c >= 'A' && c <= 'F') return (uint8_t) (c - 'A' + 10);
+  if (c >= 'a' && c <= 'f') return (uint8_t) (c - 'a' + 10);
+  return 0xff;
+}
+
+// iMACAddress string is 12 hex digits in UTF-16LE
+static bool parse_mac_string(uint8_t mac[6], uint8_t const* desc, uint32_t len) {
+  TU_VERIFY(len >= 2 + 24 && desc[0] >= 2 + 24 && desc[1] == TUSB_DESC_STRING);
+
+  for (uint8_t i = 0; i < 12; i++) {
+    uint8_t const nibble = hex_to_nibble(desc[2 + 2 * i]);
+    TU_VERIFY(nibble < 16 && desc[3 + 2 * i] == 0);
+    mac[i / 2] = (uint8_t) ((mac[i / 2] << 4) | nibble);
+  }
+
+  return true;
+}
+
+static void ncm_process_config(tuh_xfer_t* xfer) {
+  uint8_t const idx   = (uint8_t) (xfer->user_data >> 8);
+  uint8_t const state = (uint8_t) (xfer->user_data & 0xff);
+  ncmh_interface_t* p_ncm = get_itf(idx);
+  TU_ASSERT(p_ncm,);
+
+  uint8_t* enum_buf = usbh_get_enum_buf();
+  uintptr_t const next = ((uintptr_t) idx << 8) | (state + 1u);
+
+  // only MAC address is optional
+  if (xfer->result != XFER_RESULT_SUCCESS && state != CONFIG_NCM_COMPLETE) {
+    TU_LOG_DRV("  NCMh config failed at state %u\r\n", state);
+    usbh_driver_set_config_complete(p_ncm->daddr, p_ncm->itf_data);
+    return;
+  }
+
+  switch (state) {
+    case CONFIG_NCM_GET_NTB_PARAMETERS:
+      TU_ASSERT(ncm_control_xfer(p_ncm, TUSB_DIR_IN, NCM_GET_NTB_PARAMETERS, sizeof(ntb_parameters_t),
+                                 ncm_process_config, next),);
+      break;
+
+    case CONFIG_NCM_SET_NTB_INPUT_SIZE: {
+      ntb_parameters_t params;
+      TU_ASSERT(xfer->actual_len >= sizeof(ntb_parameters_t),);
+      memcpy(&params, enum_buf, sizeof(ntb_parameters_t));
+      TU_ASSERT(params.bmNtbFormatsSupported & 0x01,); // NTB16
+
+      p_ncm->tx_max_size      = (uint16_t) tu_min32(CFG_TUH_NCM_TX_NTB_SIZE, params.dwNtbOutMaxSize);
+      p_ncm->tx_divisor       = params.wNdbOutDivisor ? params.wNdbOutDivisor : 4;
+      p_ncm->tx_remainder     = (uint16_t) (params.wNdbOutPayloadRemainder % p_ncm->tx_divisor);
+      p_ncm->tx_ndp_align     = tu_max16(params.wNdbOutAlignment, 4);
+      p_ncm->tx_max_datagrams = (uint8_t) ((params.wNtbOutMaxDatagrams && params.wNtbOutMaxDatagrams < CFG_TUH_NCM_TX_MAX_DATAGRAMS) ?
+                                           params.wNtbOutMaxDatagrams : CFG_TUH_NCM_TX_MAX_DATAGRAMS);
+      TU_LOG_DRV("  NCMh NTB in max = %" PRIu32 ", out max = %u\r\n", params.dwNtbInMaxSize, p_ncm->tx_max_size);
+
+      // limit device NTB to our buffer
+      if (params.dwNtbInMaxSize > CFG_TUH_NCM_RX_NTB_SIZE) {
+        tu_unaligned_write32(enum_buf, CFG_TUH_NCM_RX_NTB_SIZE);
+        TU_ASSERT(ncm_control_xfer(p_ncm, TUSB_DIR_OUT, NCM_SET_NTB_INPUT_SIZE, 4, ncm_process_config, next),);
+        break;
+      }
+      TU_ATTR_FALLTHROUGH;
+    }
+
+    case CONFIG_NCM_SET_INTERFACE:
+      TU_ASSERT(tuh_interface_set(p_ncm->daddr, p_ncm->itf_data, 1, ncm_process_config,
+                                  ((uintptr_t) idx << 8) | CONFIG_NCM_GET_MAC_ADDRESS),);
+      break;
+
+    case CONFIG_NCM_GET_MAC_ADDRESS:
+      if (p_ncm->mac_index) {
+        TU_ASSERT(tuh_descriptor_get_string(p_ncm->daddr, p_ncm->mac_index, 0x0409, enum_buf, 2 + 24,
+                                            ncm_process_config, next),);
+        break;
+      }
+      TU_ATTR_FALLTHROUGH;
+
+    case CONFIG_NCM_COMPLETE:
+      if (p_ncm->mac_index && xfer->result == XFER_RESULT_SUCCESS) {
+        p_ncm->mac_valid = parse_mac_string(p_ncm->mac, enum_buf, xfer->actual_len);
+      }
+
+      TU_LOG_DRV("NCMh Set Configure complete\r\n");
+      p_ncm->mounted = true;
+      if (tuh_ncm_mount_cb) {
+        tuh_ncm_mount_cb(idx);
+      }
+
+      notif_xfer(p_ncm, idx);
+      rx_submit(p_ncm, idx);
+
+      // data interface is bound to this driver as well
+      usbh_driver_set_config_complete(p_ncm->daddr, p_ncm->itf_data);
+      break;
+
+    default:
+      break;
+  }
+}
+
+bool ncmh_set_config(uint8_t daddr, uint8_t itf_num) {
+  uint8_t const idx = tuh_ncm_itf_get_index(daddr, itf_num);
+  TU_ASSERT(get_itf(idx));
+
+  // fake transfer to kick-off process
+  tuh_xfer_t xfer;
+  xfer.daddr     = daddr;
+  xfer.result    = XFER_RESULT_SUCCESS;
+  xfer.user_data = ((uintptr_t) idx << 8) | CONFIG_NCM_GET_NTB_PARAMETERS;
+
+  ncm_process_config(&xfer);
+  return true;
+}
+
+#endif
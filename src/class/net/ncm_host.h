@@ -0,0 +1,141 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#ifndef _TUSB_NCM_HOST_H_
+#define _TUSB_NCM_HOST_H_
+
+#include "class/cdc/cdc.h"
+#include "ncm.h"
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+// CDC Network Control Model host driver, counterpart of ncm_device.c. Only NTB16 is supported.
+// Received NTBs are queued: with CFG_TUH_EDPT_XFER_QUEUE (and CFG_TUH_API_EDPT_XFER) all free NTB buffers are
+// submitted to the IN endpoint at once so that the host controller never waits for datagrams to be consumed,
+// otherwise the next buffer is submitted when the previous one completes.
+// Transmitted datagrams are sent at once if OUT endpoint is idle, otherwise aggregated into the next NTB.
+
+//--------------------------------------------------------------------+
+// Class Driver Configuration
+//--------------------------------------------------------------------+
+
+// Number of NTB buffers for reception
+#ifndef CFG_TUH_NCM_RX_NTB_N
+  #define CFG_TUH_NCM_RX_NTB_N        2
+#endif
+
+// Size of a reception NTB buffer, requested to device by SET_NTB_INPUT_SIZE. Must be > MTU
+#ifndef CFG_TUH_NCM_RX_NTB_SIZE
+  #define CFG_TUH_NCM_RX_NTB_SIZE     3200
+#endif
+
+// Number of NTB buffers for transmission
+#ifndef CFG_TUH_NCM_TX_NTB_N
+  #define CFG_TUH_NCM_TX_NTB_N        2
+#endif
+
+// Size of a transmission NTB buffer, limited further by device dwNtbOutMaxSize. Must be > MTU
+#ifndef CFG_TUH_NCM_TX_NTB_SIZE
+  #define CFG_TUH_NCM_TX_NTB_SIZE     2048
+#endif
+
+// Maximum number of datagrams aggregated into a transmission NTB, limited further by device wNtbOutMaxDatagrams
+#ifndef CFG_TUH_NCM_TX_MAX_DATAGRAMS
+  #define CFG_TUH_NCM_TX_MAX_DATAGRAMS 8
+#endif
+
+TU_VERIFY_STATIC(CFG_TUH_NCM_RX_NTB_N > 0 && CFG_TUH_NCM_RX_NTB_N < UINT8_MAX, "Number is not correct");
+TU_VERIFY_STATIC(CFG_TUH_NCM_TX_NTB_N > 0 && CFG_TUH_NCM_TX_NTB_N < UINT8_MAX, "Number is not correct");
+TU_VERIFY_STATIC(CFG_TUH_NCM_RX_NTB_SIZE >= 2048 && CFG_TUH_NCM_RX_NTB_SIZE <= UINT16_MAX, "Size is not correct");
+TU_VERIFY_STATIC(CFG_TUH_NCM_TX_NTB_SIZE >= 2048 && CFG_TUH_NCM_TX_NTB_SIZE <= UINT16_MAX, "Size is not correct");
+TU_VERIFY_STATIC(CFG_TUH_NCM_TX_MAX_DATAGRAMS > 0 && CFG_TUH_NCM_TX_MAX_DATAGRAMS < UINT8_MAX, "Number is not correct");
+
+//--------------------------------------------------------------------+
+// Application API
+//--------------------------------------------------------------------+
+
+// Get Interface index from device address + interface number
+// return TUSB_INDEX_INVALID_8 (0xFF) if not found
+uint8_t tuh_ncm_itf_get_index(uint8_t daddr, uint8_t itf_num);
+
+// Get Interface information
+bool tuh_ncm_itf_get_info(uint8_t idx, tuh_itf_info_t* info);
+
+// Check if an interface is mounted
+bool tuh_ncm_mounted(uint8_t idx);
+
+// Check if device reported network connection
+bool tuh_ncm_connected(uint8_t idx);
+
+// Get MAC address of device (from iMACAddress string), return false if not available
+bool tuh_ncm_get_mac(uint8_t idx, uint8_t mac[6]);
+
+// Check if a datagram of len bytes can be transmitted now
+bool tuh_ncm_can_xmit(uint8_t idx, uint16_t len);
+
+// Copy an ethernet frame into the transmission NTB, sent at once if endpoint is idle
+bool tuh_ncm_xmit(uint8_t idx, void const* frame, uint16_t len);
+
+// Resume delivery of received datagrams paused by tuh_ncm_rx_cb() returning false
+void tuh_ncm_rx_resume(uint8_t idx);
+
+//--------------------------------------------------------------------+
+// Application Callbacks
+//--------------------------------------------------------------------+
+
+// Invoked when a device with NCM interface is mounted
+TU_ATTR_WEAK extern void tuh_ncm_mount_cb(uint8_t idx);
+
+// Invoked when a device with NCM interface is unmounted
+TU_ATTR_WEAK extern void tuh_ncm_umount_cb(uint8_t idx);
+
+// Invoked for each received ethernet frame, data is only valid during the callback.
+// Return false if frame can not be consumed now: it is delivered again after tuh_ncm_rx_resume()
+TU_ATTR_WEAK extern bool tuh_ncm_rx_cb(uint8_t idx, uint8_t const* frame, uint16_t len);
+
+// Invoked when an NTB is sent and therefore room becomes available for transmission
+TU_ATTR_WEAK extern void tuh_ncm_tx_complete_cb(uint8_t idx);
+
+// Invoked when device reports network connection change
+TU_ATTR_WEAK extern void tuh_ncm_link_cb(uint8_t idx, bool connected);
+
+//--------------------------------------------------------------------+
+// Internal Class Driver API
+//--------------------------------------------------------------------+
+bool ncmh_init       (void);
+bool ncmh_deinit     (void);
+bool ncmh_open       (uint8_t rhport, uint8_t dev_addr, tusb_desc_interface_t const *itf_desc, uint16_t max_len);
+bool ncmh_set_config (uint8_t dev_addr, uint8_t itf_num);
+bool ncmh_xfer_cb    (uint8_t dev_addr, uint8_t ep_addr, xfer_result_t event, uint32_t xferred_bytes);
+void ncmh_close      (uint8_t dev_addr);
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif /* _TUSB_NCM_HOST_H_ */
@@ -35,6 +35,10 @@
 #error "Cannot enable both ECM_RNDIS and NCM network drivers"
 #endif
 
+#if CFG_TUD_ECM_RNDIS > 1
+#error "ECM_RNDIS network driver supports only one instance"
+#endif
+
 /* declared here, NOT in usb_descriptors.c, so that the driver can intelligently ZLP as needed */
 #define CFG_TUD_NET_ENDPOINT_SIZE (TUD_OPT_HIGH_SPEED ? 512 : 64)
 
@@ -43,6 +47,50 @@
 #define CFG_TUD_NET_MTU           1514
 #endif
 
+// ECM/RNDIS: number of frame buffers for reception. With more than one, next frame is received while the glue logic
+// still holds the previous one (until tud_network_recv_renew())
+#ifndef CFG_TUD_ECM_RNDIS_OUT_FRAME_N
+#define CFG_TUD_ECM_RNDIS_OUT_FRAME_N  1
+#endif
+
+// ECM/RNDIS: number of frame buffers for transmission. With more than one, tud_network_can_xmit() accepts next frame
+// while previous one is still being sent
+#ifndef CFG_TUD_ECM_RNDIS_IN_FRAME_N
+#define CFG_TUD_ECM_RNDIS_IN_FRAME_N   1
+#endif
+
+// NCM: adaptive NTB aggregation. When datagrams queue up behind the NTB on the wire (heavy traffic), the next NTB
+// is held back until it is CFG_TUD_NCM_IN_COALESCE_PERCENT full or for at most CFG_TUD_NCM_IN_COALESCE_MS frames.
+// A datagram arriving on an idle endpoint is always sent at once. 0 disables holding back
+#ifndef CFG_TUD_NCM_IN_COALESCE_MS
+#define CFG_TUD_NCM_IN_COALESCE_MS       0
+#endif
+
+#ifndef CFG_TUD_NCM_IN_COALESCE_PERCENT
+#define CFG_TUD_NCM_IN_COALESCE_PERCENT  75
+#endif
+
+// NCM: compute IP/TCP/UDP/ICMP checksums of transmitted datagrams and verify them on received ones, see
+// tud_network_recv_csum(). The network stack's own checksum generation must be disabled then
+#ifndef CFG_TUD_NCM_CSUM_OFFLOAD
+#define CFG_TUD_NCM_CSUM_OFFLOAD       0
+#endif
+
+// Result of received datagram checksum verification
+enum {
+  TUD_NETWORK_CSUM_UNVERIFIED = 0, // not IP, fragment or protocol not supported: stack must verify
+  TUD_NETWORK_CSUM_VALID,          // IPv4 header and TCP/UDP/ICMP checksums are correct
+  TUD_NETWORK_CSUM_INVALID,        // a checksum is wrong, datagram should be dropped
+};
+
+// NCM: statistics of transmitted NTBs, for tuning aggregation
+typedef struct {
+  uint32_t ntb_count;      // NTBs sent
+  uint32_t datagram_count; // datagrams sent
+  uint32_t byte_count;     // NTB bytes sent including headers, average fill is byte_count / ntb_count
+  uint32_t timeout_count;  // NTBs sent by aggregation timeout before reaching fill threshold
+  uint32_t datagrams_hist[8]; // NTBs per number of datagrams: 1, 2, 3-4, 5-8, 9-16, 17-32, 33-64, more
+} tud_network_xmit_stats_t;
 
 // Table 4.3 Data Class Interface Protocol Codes
 typedef enum
@@ -56,27 +104,81 @@ typedef enum
 #endif
 
 //--------------------------------------------------------------------+
-// Application API
+// Application API (Multiple Instances)
+// NCM supports CFG_TUD_NCM instances, itf is the index of the function in configuration descriptor order.
+// ECM/RNDIS is single instance, itf must be 0
 //--------------------------------------------------------------------+
 
 // indicate to network driver that client has finished with the packet provided to network_recv_cb()
-void tud_network_recv_renew(void);
+void tud_network_n_recv_renew(uint8_t itf);
 
 // poll network driver for its ability to accept another packet to transmit
-bool tud_network_can_xmit(uint16_t size);
+bool tud_network_n_can_xmit(uint8_t itf, uint16_t size);
 
 // if network_can_xmit() returns true, network_xmit() can be called once
-void tud_network_xmit(void *ref, uint16_t arg);
+void tud_network_n_xmit(uint8_t itf, void *ref, uint16_t arg);
+
+//------------- NCM -------------//
+
+// Zero-copy reception: called within the receive callback to keep referencing src after returning, e.g. with a
+// PBUF_REF pbuf. Return handle for tud_network_recv_release() or NULL if refused: packet must be copied then
+void *tud_network_n_recv_hold(uint8_t itf);
+
+// drop reference taken by tud_network_n_recv_hold(), must be called from the same context as tud_task()
+void tud_network_recv_release(void *handle);
+
+// Statistics of transmitted NTBs since enumeration or last clear
+void tud_network_n_xmit_stats(uint8_t itf, tud_network_xmit_stats_t *stats, bool clear);
+
+// Checksum verification result (TUD_NETWORK_CSUM_*) of the datagram passed to the receive callback, only valid
+// within the callback. Always unverified without CFG_TUD_NCM_CSUM_OFFLOAD
+uint8_t tud_network_n_recv_csum(uint8_t itf);
+
+//--------------------------------------------------------------------+
+// Application API (Single Instance)
+//--------------------------------------------------------------------+
+
+TU_ATTR_ALWAYS_INLINE static inline void tud_network_recv_renew(void) {
+  tud_network_n_recv_renew(0);
+}
+
+TU_ATTR_ALWAYS_INLINE static inline bool tud_network_can_xmit(uint16_t size) {
+  return tud_network_n_can_xmit(0, size);
+}
+
+TU_ATTR_ALWAYS_INLINE static inline void tud_network_xmit(void *ref, uint16_t arg) {
+  tud_network_n_xmit(0, ref, arg);
+}
+
+TU_ATTR_ALWAYS_INLINE static inline void *tud_network_recv_hold(void) {
+  return tud_network_n_recv_hold(0);
+}
+
+TU_ATTR_ALWAYS_INLINE static inline void tud_network_xmit_stats(tud_network_xmit_stats_t *stats, bool clear) {
+  tud_network_n_xmit_stats(0, stats, clear);
+}
+
+TU_ATTR_ALWAYS_INLINE static inline uint8_t tud_network_recv_csum(void) {
+  return tud_network_n_recv_csum(0);
+}
 
 //--------------------------------------------------------------------+
 // Application Callbacks (WEAK is optional)
 //--------------------------------------------------------------------+
 
-// client must provide this: return false if the packet buffer was not accepted
-bool tud_network_recv_cb(const uint8_t *src, uint16_t size);
+// client must provide one of these: return false if the packet buffer was not accepted.
+// The itf variant is preferred, the other one is for single instance
+TU_ATTR_WEAK bool tud_network_n_recv_cb(uint8_t itf, const uint8_t *src, uint16_t size);
+TU_ATTR_WEAK bool tud_network_recv_cb(const uint8_t *src, uint16_t size);
+
+// client must provide one of these: copy from network stack packet pointer to dst.
+// The itf variant is preferred, the other one is for single instance
+TU_ATTR_WEAK uint16_t tud_network_n_xmit_cb(uint8_t itf, uint8_t *dst, void *ref, uint16_t arg);
+TU_ATTR_WEAK uint16_t tud_network_xmit_cb(uint8_t *dst, void *ref, uint16_t arg);
 
-// client must provide this: copy from network stack packet pointer to dst
-uint16_t tud_network_xmit_cb(uint8_t *dst, void *ref, uint16_t arg);
+// NCM with CFG_TUD_NCM_CSUM_OFFLOAD: port hook for MCUs with a checksum engine. Return sum plus 16-bit big-endian
+// one's complement sum (RFC 1071) of data, may be left unfolded. Software is used if not implemented
+TU_ATTR_WEAK uint32_t tud_network_csum_cb(uint32_t sum, const uint8_t *data, uint16_t len);
 
 //------------- ECM/RNDIS -------------//
 
@@ -97,6 +199,7 @@ uint16_t netd_open            (uint8_t rhport, tusb_desc_interface_t const * itf
 bool     netd_control_xfer_cb (uint8_t rhport, uint8_t stage, tusb_control_request_t const * request);
 bool     netd_xfer_cb         (uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes);
 void     netd_report          (uint8_t *buf, uint16_t len);
+void     netd_sof             (uint8_t rhport, uint32_t frame_count);
 
 #ifdef __cplusplus
  }
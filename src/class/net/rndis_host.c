@@ -0,0 +1,943 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#include "tusb_option.h"
+
+#if (CFG_TUH_ENABLED && CFG_TUH_RNDIS)
+
+#include "host/usbh.h"
+#include "host/usbh_pvt.h"
+
+#include "rndis_host.h"
+
+// Level where CFG_TUSB_DEBUG must be at least for this driver is logged
+#ifndef CFG_TUH_RNDIS_LOG_LEVEL
+  #define CFG_TUH_RNDIS_LOG_LEVEL   CFG_TUH_LOG_LEVEL
+#endif
+
+#define TU_LOG_DRV(...)   TU_LOG(CFG_TUH_RNDIS_LOG_LEVEL, __VA_ARGS__)
+
+// Submit all free reception buffers at once: usbh queue completes them in order
+#define RNDISH_RX_MULTI_URB   (CFG_TUH_EDPT_XFER_QUEUE && CFG_TUH_API_EDPT_XFER)
+
+#define RX_BUF_N              CFG_TUH_RNDIS_RX_BUF_N
+#define TX_BUF_N              CFG_TUH_RNDIS_TX_BUF_N
+
+// encapsulated command/response, large enough for INITIALIZE_CMPLT and status indication
+#define CTRL_BUFSIZE          128
+#define NOTIF_BUFSIZE         16
+
+// GET_ENCAPSULATED_RESPONSE is polled until device has the response ready
+#define RESPONSE_DELAY_MS     10
+#define RESPONSE_RETRY_MAX    50
+
+// offset of payload in a packet message, and value of its DataOffset field (relative to DataOffset itself)
+#define PACKET_HDR_SIZE       sizeof(rndis_msg_packet_t)
+#define PACKET_DATA_OFFSET    (PACKET_HDR_SIZE - offsetof(rndis_msg_packet_t, data_offset))
+
+//--------------------------------------------------------------------+
+// Host RNDIS Interface
+//--------------------------------------------------------------------+
+
+typedef struct {
+  uint8_t daddr;
+  uint8_t itf_num;     // communication interface
+  uint8_t itf_data;    // data interface
+  uint8_t itf_class;
+  uint8_t itf_subclass;
+  uint8_t itf_protocol;
+  uint8_t ep_notif;
+  uint8_t ep_in;
+  uint8_t ep_out;
+  uint16_t ep_out_size;
+
+  bool mac_valid;
+  uint8_t mac[6];
+
+  volatile bool mounted;
+  bool connected;
+
+  uint8_t ctrl_retry;  // GET_ENCAPSULATED_RESPONSE attempts
+  uint32_t request_id;
+
+  // reception: buffer ring in order of submission, from head: ready (completed) then armed (submitted) ones
+  uint8_t rx_head;
+  uint8_t rx_ready;
+  uint8_t rx_armed;
+  bool rx_paused;      // application could not consume frame
+  bool rx_stalled;
+  uint16_t rx_ofs;     // delivery cursor: offset of next packet message in head buffer
+  uint16_t rx_len[RX_BUF_N]; // 0 if transfer failed
+
+  // transmission: buffer ring from head: queued (closed) ones, first one in flight, then the one being filled
+  uint8_t tx_head;
+  uint8_t tx_queued;
+  bool tx_busy;
+  uint8_t tx_count;    // packet messages in filling buffer
+  uint16_t tx_last;    // offset of last packet message in filling buffer
+  uint16_t tx_len[TX_BUF_N]; // transfer length if closed, end of last message if filling
+
+  // device parameters for transmission (INITIALIZE_CMPLT)
+  uint16_t tx_max_size;
+  uint16_t tx_align;
+  uint8_t tx_max_packets;
+} rndish_interface_t;
+
+typedef struct {
+  TUH_EPBUF_DEF(data, CFG_TUH_RNDIS_RX_BUFSIZE);
+} rndish_rx_buf_t;
+
+typedef struct {
+  TUH_EPBUF_DEF(data, CFG_TUH_RNDIS_TX_BUFSIZE);
+} rndish_tx_buf_t;
+
+typedef struct {
+  rndish_rx_buf_t rx[RX_BUF_N];
+  rndish_tx_buf_t tx[TX_BUF_N];
+  TUH_EPBUF_DEF(ctrl, CTRL_BUFSIZE);
+  TUH_EPBUF_DEF(notif, NOTIF_BUFSIZE);
+} rndish_epbuf_t;
+
+static rndish_interface_t _rndish_itf[CFG_TUH_RNDIS];
+CFG_TUH_MEM_SECTION static rndish_epbuf_t _rndish_epbuf[CFG_TUH_RNDIS];
+
+static void rx_submit(rndish_interface_t* p_rndis, uint8_t idx);
+static void tx_try_send(rndish_interface_t* p_rndis, uint8_t idx);
+
+//--------------------------------------------------------------------+
+// Helper
+//--------------------------------------------------------------------+
+
+static inline rndish_interface_t* get_itf(uint8_t idx) {
+  TU_ASSERT(idx < CFG_TUH_RNDIS, NULL);
+  rndish_interface_t* p_rndis = &_rndish_itf[idx];
+
+  return (p_rndis->daddr != 0) ? p_rndis : NULL;
+}
+
+static inline uint8_t get_idx_by_ep_addr(uint8_t daddr, uint8_t ep_addr) {
+  for (uint8_t i = 0; i < CFG_TUH_RNDIS; i++) {
+    rndish_interface_t* p_rndis = &_rndish_itf[i];
+    if ((p_rndis->daddr == daddr) &&
+        (ep_addr == p_rndis->ep_notif || ep_addr == p_rndis->ep_in || ep_addr == p_rndis->ep_out)) {
+      return i;
+    }
+  }
+
+  return TUSB_INDEX_INVALID_8;
+}
+
+static rndish_interface_t* make_new_itf(uint8_t daddr, tusb_desc_interface_t const* itf_desc) {
+  for (uint8_t i = 0; i < CFG_TUH_RNDIS; i++) {
+    rndish_interface_t* p_rndis = &_rndish_itf[i];
+    if (p_rndis->daddr == 0) {
+      tu_memclr(p_rndis, sizeof(rndish_interface_t));
+      p_rndis->daddr        = daddr;
+      p_rndis->itf_num      = itf_desc->bInterfaceNumber;
+      p_rndis->itf_class    = itf_desc->bInterfaceClass;
+      p_rndis->itf_subclass = itf_desc->bInterfaceSubClass;
+      p_rndis->itf_protocol = itf_desc->bInterfaceProtocol;
+      return p_rndis;
+    }
+  }
+
+  return NULL;
+}
+
+// RNDIS messages are little endian and packed messages are not necessarily 4-byte aligned in a transfer
+TU_ATTR_ALWAYS_INLINE static inline uint32_t msg_read32(uint8_t const* msg, uint32_t offset) {
+  return tu_le32toh(tu_unaligned_read32(msg + offset));
+}
+
+TU_ATTR_ALWAYS_INLINE static inline void msg_write32(uint8_t* msg, uint32_t offset, uint32_t value) {
+  tu_unaligned_write32(msg + offset, tu_htole32(value));
+}
+
+//--------------------------------------------------------------------+
+// Application API
+//--------------------------------------------------------------------+
+
+uint8_t tuh_rndis_itf_get_index(uint8_t daddr, uint8_t itf_num) {
+  for (uint8_t i = 0; i < CFG_TUH_RNDIS; i++) {
+    rndish_interface_t const* p_rndis = &_rndish_itf[i];
+    if (p_rndis->daddr == daddr && p_rndis->itf_num == itf_num) return i;
+  }
+
+  return TUSB_INDEX_INVALID_8;
+}
+
+bool tuh_rndis_itf_get_info(uint8_t idx, tuh_itf_info_t* info) {
+  rndish_interface_t* p_rndis = get_itf(idx);
+  TU_VERIFY(p_rndis && info);
+
+  info->daddr = p_rndis->daddr;
+
+  // re-construct descriptor
+  tusb_desc_interface_t* desc = &info->desc;
+  desc->bLength            = sizeof(tusb_desc_interface_t);
+  desc->bDescriptorType    = TUSB_DESC_INTERFACE;
+
+  desc->bInterfaceNumber   = p_rndis->itf_num;
+  desc->bAlternateSetting  = 0;
+  desc->bNumEndpoints      = p_rndis->ep_notif ? 1u : 0u;
+  desc->bInterfaceClass    = p_rndis->itf_class;
+  desc->bInterfaceSubClass = p_rndis->itf_subclass;
+  desc->bInterfaceProtocol = p_rndis->itf_protocol;
+  desc->iInterface         = 0; // not used yet
+
+  return true;
+}
+
+bool tuh_rndis_mounted(uint8_t idx) {
+  rndish_interface_t* p_rndis = get_itf(idx);
+  TU_VERIFY(p_rndis);
+  return p_rndis->mounted;
+}
+
+bool tuh_rndis_connected(uint8_t idx) {
+  rndish_interface_t* p_rndis = get_itf(idx);
+  TU_VERIFY(p_rndis && p_rndis->mounted);
+  return p_rndis->connected;
+}
+
+bool tuh_rndis_get_mac(uint8_t idx, uint8_t mac[6]) {
+  rndish_interface_t* p_rndis = get_itf(idx);
+  TU_VERIFY(p_rndis && p_rndis->mac_valid);
+  memcpy(mac, p_rndis->mac, 6);
+  return true;
+}
+
+void tuh_rndis_rx_resume(uint8_t idx) {
+  rndish_interface_t* p_rndis = get_itf(idx);
+  TU_VERIFY(p_rndis && p_rndis->mounted,);
+  p_rndis->rx_paused = false;
+  rx_submit(p_rndis, idx);
+}
+
+//--------------------------------------------------------------------+
+// Reception
+//--------------------------------------------------------------------+
+
+// Deliver frames of ready buffers in order, free them and submit them again. A transfer holds one or more
+// concatenated packet messages, each one is checked against the transfer length before its frame is delivered
+static void rx_process(rndish_interface_t* p_rndis, uint8_t idx) {
+  while (p_rndis->rx_ready && !p_rndis->rx_paused) {
+    uint8_t const* buf = _rndish_epbuf[idx].rx[p_rndis->rx_head].data;
+    uint32_t const len = p_rndis->rx_len[p_rndis->rx_head];
+
+    while (p_rndis->rx_ofs + PACKET_HDR_SIZE <= len) {
+      uint8_t const* msg = buf + p_rndis->rx_ofs;
+      uint32_t const msg_len = msg_read32(msg, offsetof(rndis_msg_packet_t, length));
+
+      // anything else than a packet message ends the transfer e.g trailing zero padding
+      if (msg_read32(msg, offsetof(rndis_msg_packet_t, type)) != RNDIS_MSG_PACKET ||
+          msg_len < PACKET_HDR_SIZE || msg_len > len - p_rndis->rx_ofs) {
+        break;
+      }
+
+      uint32_t const data_ofs = msg_read32(msg, offsetof(rndis_msg_packet_t, data_offset)) +
+                                offsetof(rndis_msg_packet_t, data_offset);
+      uint32_t const data_len = msg_read32(msg, offsetof(rndis_msg_packet_t, data_length));
+
+      if (data_len && data_ofs <= msg_len && data_len <= msg_len - data_ofs) {
+        if (tuh_rndis_rx_cb && !tuh_rndis_rx_cb(idx, msg + data_ofs, (uint16_t) data_len)) {
+          // keep cursor, same frame is delivered on resume
+          p_rndis->rx_paused = true;
+          return;
+        }
+      }
+
+      p_rndis->rx_ofs = (uint16_t) (p_rndis->rx_ofs + msg_len);
+    }
+
+    p_rndis->rx_ofs  = 0;
+    p_rndis->rx_head = (uint8_t) ((p_rndis->rx_head + 1) % RX_BUF_N);
+    p_rndis->rx_ready--;
+  }
+}
+
+static void rx_complete(rndish_interface_t* p_rndis, uint8_t idx, xfer_result_t result, uint32_t xferred_bytes) {
+  TU_VERIFY(p_rndis->rx_armed,);
+
+  // completions are in submission order, first armed buffer is done
+  uint8_t const buf = (uint8_t) ((p_rndis->rx_head + p_rndis->rx_ready) % RX_BUF_N);
+  uint16_t len = (uint16_t) xferred_bytes;
+
+  if (result != XFER_RESULT_SUCCESS) {
+    TU_LOG_DRV("  RNDISh RX failed %u\r\n", result);
+    len = 0;
+    if (result == XFER_RESULT_STALLED) {
+      p_rndis->rx_stalled = true;
+    }
+  }
+
+  // failed transfer still takes its turn so that order is kept
+  p_rndis->rx_len[buf] = len;
+  p_rndis->rx_armed--;
+  p_rndis->rx_ready++;
+
+  rx_submit(p_rndis, idx);
+}
+
+#if RNDISH_RX_MULTI_URB
+static void rx_complete_cb(tuh_xfer_t* xfer) {
+  uint8_t const idx = (uint8_t) xfer->user_data;
+  rndish_interface_t* p_rndis = get_itf(idx);
+  TU_VERIFY(p_rndis && p_rndis->daddr == xfer->daddr && p_rndis->ep_in == xfer->ep_addr,);
+
+  rx_complete(p_rndis, idx, xfer->result, xfer->actual_len);
+}
+#endif
+
+// Deliver pending frames then submit free buffers
+static void rx_submit(rndish_interface_t* p_rndis, uint8_t idx) {
+  rx_process(p_rndis, idx);
+
+  while (!p_rndis->rx_stalled && p_rndis->rx_ready + p_rndis->rx_armed < RX_BUF_N) {
+    uint8_t const buf = (uint8_t) ((p_rndis->rx_head + p_rndis->rx_ready + p_rndis->rx_armed) % RX_BUF_N);
+    uint8_t* data = _rndish_epbuf[idx].rx[buf].data;
+
+#if RNDISH_RX_MULTI_URB
+    tuh_xfer_t xfer = {
+      .daddr       = p_rndis->daddr,
+      .ep_addr     = p_rndis->ep_in,
+      .buflen      = CFG_TUH_RNDIS_RX_BUFSIZE,
+      .buffer      = data,
+      .complete_cb = rx_complete_cb,
+      .user_data   = idx
+    };
+    // stop if usbh queue is full, next completion submits the rest
+    if (!tuh_edpt_xfer(&xfer)) {
+      break;
+    }
+#else
+    if (p_rndis->rx_armed || !usbh_edpt_claim(p_rndis->daddr, p_rndis->ep_in)) {
+      break;
+    }
+    if (!usbh_edpt_xfer(p_rndis->daddr, p_rndis->ep_in, data, CFG_TUH_RNDIS_RX_BUFSIZE)) {
+      usbh_edpt_release(p_rndis->daddr, p_rndis->ep_in);
+      break;
+    }
+#endif
+
+    p_rndis->rx_armed++;
+  }
+}
+
+//--------------------------------------------------------------------+
+// Transmission
+//--------------------------------------------------------------------+
+
+// Offset of a packet message appended after end, as per device PacketAlignmentFactor
+TU_ATTR_ALWAYS_INLINE static inline uint32_t tx_align(rndish_interface_t const* p_rndis, uint32_t end) {
+  uint32_t const align = p_rndis->tx_align;
+  return (end + align - 1) / align * align;
+}
+
+// Check if a frame fits into filling buffer
+static bool tx_fits(rndish_interface_t const* p_rndis, uint8_t count, uint32_t end, uint16_t len) {
+  TU_VERIFY(count < p_rndis->tx_max_packets);
+  uint32_t const pos = count ? tx_align(p_rndis, end) : 0;
+  return pos + PACKET_HDR_SIZE + len <= p_rndis->tx_max_size;
+}
+
+TU_ATTR_ALWAYS_INLINE static inline uint8_t tx_fill_index(rndish_interface_t const* p_rndis) {
+  return (uint8_t) ((p_rndis->tx_head + p_rndis->tx_queued) % TX_BUF_N);
+}
+
+TU_ATTR_ALWAYS_INLINE static inline uint32_t tx_fill_end(rndish_interface_t const* p_rndis) {
+  return p_rndis->tx_count ? p_rndis->tx_len[tx_fill_index(p_rndis)] : 0;
+}
+
+// Queue filling buffer
+static void tx_close(rndish_interface_t* p_rndis, uint8_t idx) {
+  uint8_t const buf = tx_fill_index(p_rndis);
+  uint8_t* data = _rndish_epbuf[idx].tx[buf].data;
+  uint32_t len = p_rndis->tx_len[buf];
+
+  // transfer shorter than device MaxTransferSize must end with a short packet: pad last message instead of sending
+  // a ZLP, its length covers the padding
+  if ((len % p_rndis->ep_out_size) == 0 && len < p_rndis->tx_max_size) {
+    data[len++] = 0;
+    msg_write32(data + p_rndis->tx_last, offsetof(rndis_msg_packet_t, length), len - p_rndis->tx_last);
+  }
+
+  p_rndis->tx_len[buf] = (uint16_t) len;
+  p_rndis->tx_count = 0;
+  p_rndis->tx_queued++;
+}
+
+// Send oldest queued buffer, or the filling one if endpoint is idle
+static void tx_try_send(rndish_interface_t* p_rndis, uint8_t idx) {
+  if (p_rndis->tx_busy) {
+    return;
+  }
+  if (p_rndis->tx_queued == 0) {
+    if (p_rndis->tx_count == 0) {
+      return;
+    }
+    tx_close(p_rndis, idx);
+  }
+
+  TU_VERIFY(usbh_edpt_claim(p_rndis->daddr, p_rndis->ep_out),);
+  if (!usbh_edpt_xfer(p_rndis->daddr, p_rndis->ep_out, _rndish_epbuf[idx].tx[p_rndis->tx_head].data,
+                      p_rndis->tx_len[p_rndis->tx_head])) {
+    usbh_edpt_release(p_rndis->daddr, p_rndis->ep_out);
+    return;
+  }
+  p_rndis->tx_busy = true;
+}
+
+static void tx_complete(rndish_interface_t* p_rndis, uint8_t idx, xfer_result_t result) {
+  if (result != XFER_RESULT_SUCCESS) {
+    TU_LOG_DRV("  RNDISh TX failed %u\r\n", result);
+  }
+
+  // transfer is dropped on failure as well, upper layer protocol takes care of retransmission
+  p_rndis->tx_busy = false;
+  if (p_rndis->tx_queued) {
+    p_rndis->tx_head = (uint8_t) ((p_rndis->tx_head + 1) % TX_BUF_N);
+    p_rndis->tx_queued--;
+  }
+
+  tx_try_send(p_rndis, idx);
+
+  if (tuh_rndis_tx_complete_cb) {
+    tuh_rndis_tx_complete_cb(idx);
+  }
+}
+
+static bool tx_can_xmit(rndish_interface_t const* p_rndis, uint16_t len) {
+  TU_VERIFY(p_rndis->mounted && len);
+  TU_VERIFY(p_rndis->tx_queued < TX_BUF_N);
+
+  if (tx_fits(p_rndis, p_rndis->tx_count, tx_fill_end(p_rndis), len)) {
+    return true;
+  }
+
+  // filling buffer is full, a new one can be started
+  return p_rndis->tx_count && (p_rndis->tx_queued + 1 < TX_BUF_N) && tx_fits(p_rndis, 0, 0, len);
+}
+
+bool tuh_rndis_can_xmit(uint8_t idx, uint16_t len) {
+  rndish_interface_t const* p_rndis = get_itf(idx);
+  TU_VERIFY(p_rndis);
+  return tx_can_xmit(p_rndis, len);
+}
+
+bool tuh_rndis_xmit(uint8_t idx, void const* frame, uint16_t len) {
+  rndish_interface_t* p_rndis = get_itf(idx);
+  TU_VERIFY(p_rndis && tx_can_xmit(p_rndis, len));
+
+  if (!tx_fits(p_rndis, p_rndis->tx_count, tx_fill_end(p_rndis), len)) {
+    tx_close(p_rndis, idx);
+  }
+
+  uint8_t const buf = tx_fill_index(p_rndis);
+  uint8_t* data = _rndish_epbuf[idx].tx[buf].data;
+  uint32_t pos = 0;
+
+  if (p_rndis->tx_count) {
+    // previous message is extended to the aligned start of this one
+    uint32_t const end = tx_fill_end(p_rndis);
+    pos = tx_align(p_rndis, end);
+    tu_memclr(data + end, pos - end);
+    msg_write32(data + p_rndis->tx_last, offsetof(rndis_msg_packet_t, length), pos - p_rndis->tx_last);
+  }
+
+  uint8_t* msg = data + pos;
+  tu_memclr(msg, PACKET_HDR_SIZE);
+  msg_write32(msg, offsetof(rndis_msg_packet_t, type), RNDIS_MSG_PACKET);
+  msg_write32(msg, offsetof(rndis_msg_packet_t, length), PACKET_HDR_SIZE + len);
+  msg_write32(msg, offsetof(rndis_msg_packet_t, data_offset), PACKET_DATA_OFFSET);
+  msg_write32(msg, offsetof(rndis_msg_packet_t, data_length), len);
+  memcpy(msg + PACKET_HDR_SIZE, frame, len);
+
+  p_rndis->tx_count++;
+  p_rndis->tx_last = (uint16_t) pos;
+  p_rndis->tx_len[buf] = (uint16_t) (pos + PACKET_HDR_SIZE + len);
+
+  tx_try_send(p_rndis, idx);
+  return true;
+}
+
+//--------------------------------------------------------------------+
+// Control messages
+//--------------------------------------------------------------------+
+
+static bool rndis_control_xfer(rndish_interface_t* p_rndis, uint8_t idx, tusb_dir_t dir, uint8_t request, uint16_t len,
+                               tuh_xfer_cb_t complete_cb, uintptr_t user_data) {
+  tusb_control_request_t const req = {
+    .bmRequestType_bit = {
+      .recipient = TUSB_REQ_RCPT_INTERFACE,
+      .type      = TUSB_REQ_TYPE_CLASS,
+      .direction = dir
+    },
+    .bRequest = request,
+    .wValue   = 0,
+    .wIndex   = tu_htole16((uint16_t) p_rndis->itf_num),
+    .wLength  = tu_htole16(len)
+  };
+
+  tuh_xfer_t xfer = {
+    .daddr       = p_rndis->daddr,
+    .ep_addr     = 0,
+    .setup       = &req,
+    .buffer      = _rndish_epbuf[idx].ctrl,
+    .complete_cb = complete_cb,
+    .user_data   = user_data
+  };
+
+  return tuh_control_xfer(&xfer);
+}
+
+// Write common header of a host request message, other fields are cleared
+static void msg_request_init(rndish_interface_t* p_rndis, uint8_t* msg, uint32_t type, uint32_t len) {
+  tu_memclr(msg, len);
+  msg_write32(msg, offsetof(rndis_msg_query_t, type), type);
+  msg_write32(msg, offsetof(rndis_msg_query_t, length), len);
+  msg_write32(msg, offsetof(rndis_msg_query_t, request_id), ++p_rndis->request_id);
+}
+
+//--------------------------------------------------------------------+
+// Notification
+//--------------------------------------------------------------------+
+
+static void notif_xfer(rndish_interface_t* p_rndis, uint8_t idx) {
+  if (p_rndis->ep_notif && usbh_edpt_claim(p_rndis->daddr, p_rndis->ep_notif)) {
+    if (!usbh_edpt_xfer(p_rndis->daddr, p_rndis->ep_notif, _rndish_epbuf[idx].notif, NOTIF_BUFSIZE)) {
+      usbh_edpt_release(p_rndis->daddr, p_rndis->ep_notif);
+    }
+  }
+}
+
+static void status_process(rndish_interface_t* p_rndis, uint8_t idx, uint8_t const* msg, uint32_t len) {
+  TU_VERIFY(len >= 12,);
+  uint32_t const status = msg_read32(msg, 8);
+
+  bool connected;
+  if (status == RNDIS_STATUS_MEDIA_CONNECT) {
+    connected = true;
+  } else if (status == RNDIS_STATUS_MEDIA_DISCONNECT) {
+    connected = false;
+  } else {
+    TU_LOG_DRV("  RNDISh status %08lX\r\n", (unsigned long) status);
+    return;
+  }
+
+  if (connected != p_rndis->connected) {
+    p_rndis->connected = connected;
+    TU_LOG_DRV("  RNDISh link %s\r\n", connected ? "up" : "down");
+    if (p_rndis->mounted && tuh_rndis_link_cb) {
+      tuh_rndis_link_cb(idx, connected);
+    }
+  }
+}
+
+static void status_fetch(rndish_interface_t* p_rndis, uint8_t idx);
+
+static void status_fetch_deferred(void* param) {
+  uint8_t const daddr = (uint8_t) ((uintptr_t) param >> 8);
+  uint8_t const idx   = (uint8_t) ((uintptr_t) param & 0xff);
+  rndish_interface_t* p_rndis = get_itf(idx);
+  TU_VERIFY(p_rndis && p_rndis->daddr == daddr && p_rndis->mounted,);
+  status_fetch(p_rndis, idx);
+}
+
+static void status_sent(tuh_xfer_t* xfer) {
+  uint8_t const idx = (uint8_t) (xfer->user_data & 0xff);
+  rndish_interface_t* p_rndis = get_itf(idx);
+  TU_VERIFY(p_rndis && p_rndis->daddr == xfer->daddr,);
+  notif_xfer(p_rndis, idx);
+}
+
+static void status_complete(tuh_xfer_t* xfer) {
+  uint8_t const idx = (uint8_t) (xfer->user_data & 0xff);
+  rndish_interface_t* p_rndis = get_itf(idx);
+  TU_VERIFY(p_rndis && p_rndis->daddr == xfer->daddr,);
+
+  uint8_t* msg = _rndish_epbuf[idx].ctrl;
+  p_rndis->ctrl_retry = 0;
+
+  if (xfer->result == XFER_RESULT_SUCCESS && xfer->actual_len >= 12) {
+    uint32_t const type = msg_read32(msg, 0);
+
+    if (type == RNDIS_MSG_INDICATE_STATUS) {
+      status_process(p_rndis, idx, msg, xfer->actual_len);
+    } else if (type == RNDIS_MSG_KEEP_ALIVE) {
+      // answer device keep-alive with the same request id
+      uint32_t const request_id = msg_read32(msg, offsetof(rndis_msg_keep_alive_t, request_id));
+      tu_memclr(msg, sizeof(rndis_msg_keep_alive_cmplt_t));
+      msg_write32(msg, offsetof(rndis_msg_keep_alive_cmplt_t, type), RNDIS_MSG_KEEP_ALIVE_CMPLT);
+      msg_write32(msg, offsetof(rndis_msg_keep_alive_cmplt_t, length), sizeof(rndis_msg_keep_alive_cmplt_t));
+      msg_write32(msg, offsetof(rndis_msg_keep_alive_cmplt_t, request_id), request_id);
+      msg_write32(msg, offsetof(rndis_msg_keep_alive_cmplt_t, status), RNDIS_STATUS_SUCCESS);
+      if (rndis_control_xfer(p_rndis, idx, TUSB_DIR_OUT, CDC_REQUEST_SEND_ENCAPSULATED_COMMAND,
+                             sizeof(rndis_msg_keep_alive_cmplt_t), status_sent, xfer->user_data)) {
+        return;
+      }
+    }
+  }
+
+  notif_xfer(p_rndis, idx);
+}
+
+// Get encapsulated response announced by RESPONSE_AVAILABLE, notification is re-armed once it is processed
+static void status_fetch(rndish_interface_t* p_rndis, uint8_t idx) {
+  uintptr_t const param = ((uintptr_t) p_rndis->daddr << 8) | idx;
+  if (rndis_control_xfer(p_rndis, idx, TUSB_DIR_IN, CDC_REQUEST_GET_ENCAPSULATED_RESPONSE, CTRL_BUFSIZE,
+                         status_complete, param)) {
+    return;
+  }
+
+  // control pipe is busy, try again later
+  if (++p_rndis->ctrl_retry > RESPONSE_RETRY_MAX ||
+      !usbh_defer_func_ms(status_fetch_deferred, (void*) param, RESPONSE_DELAY_MS)) {
+    p_rndis->ctrl_retry = 0;
+    notif_xfer(p_rndis, idx);
+  }
+}
+
+//--------------------------------------------------------------------+
+// Class Driver API
+//--------------------------------------------------------------------+
+
+bool rndish_init(void) {
+  TU_LOG_DRV("sizeof(rndish_interface_t) = %u\r\n", sizeof(rndish_interface_t));
+  tu_memclr(_rndish_itf, sizeof(_rndish_itf));
+  return true;
+}
+
+bool rndish_deinit(void) {
+  return true;
+}
+
+void rndish_close(uint8_t daddr) {
+  for (uint8_t idx = 0; idx < CFG_TUH_RNDIS; idx++) {
+    rndish_interface_t* p_rndis = &_rndish_itf[idx];
+    if (p_rndis->daddr == daddr) {
+      TU_LOG_DRV("  RNDISh close addr = %u index = %u\r\n", daddr, idx);
+
+      if (p_rndis->mounted && tuh_rndis_umount_cb) {
+        tuh_rndis_umount_cb(idx);
+      }
+
+      tu_memclr(p_rndis, sizeof(rndish_interface_t));
+    }
+  }
+}
+
+bool rndish_xfer_cb(uint8_t daddr, uint8_t ep_addr, xfer_result_t event, uint32_t xferred_bytes) {
+  uint8_t const idx = get_idx_by_ep_addr(daddr, ep_addr);
+  rndish_interface_t* p_rndis = get_itf(idx);
+  TU_VERIFY(p_rndis);
+
+  if (ep_addr == p_rndis->ep_out) {
+    tx_complete(p_rndis, idx, event);
+  } else if (ep_addr == p_rndis->ep_in) {
+    rx_complete(p_rndis, idx, event, xferred_bytes);
+  } else if (ep_addr == p_rndis->ep_notif) {
+    // RESPONSE_AVAILABLE is the only notification. Not re-armed on error to avoid looping on a stalled endpoint
+    if (event == XFER_RESULT_SUCCESS) {
+      status_fetch(p_rndis, idx);
+    }
+  }
+
+  return true;
+}
+
+//--------------------------------------------------------------------+
+// Enumeration
+//--------------------------------------------------------------------+
+
+// Each state sends a command message then gets its response, which is checked by the next state
+enum {
+  CONFIG_RNDIS_INITIALIZE = 0,
+  CONFIG_RNDIS_QUERY_MAC,
+  CONFIG_RNDIS_SET_FILTER,
+  CONFIG_RNDIS_COMPLETE,
+};
+
+bool rndish_open(uint8_t rhport, uint8_t daddr, tusb_desc_interface_t const* itf_desc, uint16_t max_len) {
+  (void) rhport;
+
+  TU_VERIFY(rndish_is_rndis_itf(itf_desc));
+
+  uint8_t const* p_desc_end = ((uint8_t const*) itf_desc) + max_len;
+  rndish_interface_t* p_rndis = make_new_itf(daddr, itf_desc);
+  TU_VERIFY(p_rndis);
+
+  // media is assumed connected until device indicates otherwise
+  p_rndis->connected = true;
+
+  //------------- Communication Interface -------------//
+  uint8_t const* p_desc = tu_desc_next(itf_desc);
+
+  // Functional descriptors
+  while ((p_desc < p_desc_end) && (TUSB_DESC_CS_INTERFACE == tu_desc_type(p_desc))) {
+    p_desc = tu_desc_next(p_desc);
+  }
+
+  // Notification endpoint
+  if (itf_desc->bNumEndpoints == 1) {
+    TU_ASSERT(TUSB_DESC_ENDPOINT == tu_desc_type(p_desc));
+    tusb_desc_endpoint_t const* desc_ep = (tusb_desc_endpoint_t const*) p_desc;
+
+    TU_ASSERT(tuh_edpt_open(daddr, desc_ep));
+    p_rndis->ep_notif = desc_ep->bEndpointAddress;
+
+    p_desc = tu_desc_next(p_desc);
+  }
+
+  //------------- Data Interface -------------//
+  while (p_desc < p_desc_end) {
+    tusb_desc_interface_t const* desc_itf = (tusb_desc_interface_t const*) p_desc;
+    p_desc = tu_desc_next(p_desc);
+
+    if (TUSB_DESC_INTERFACE == desc_itf->bDescriptorType && TUSB_CLASS_CDC_DATA == desc_itf->bInterfaceClass &&
+        2 == desc_itf->bNumEndpoints) {
+      p_rndis->itf_data = desc_itf->bInterfaceNumber;
+
+      for (uint8_t count = 0; count < 2 && p_desc < p_desc_end; p_desc = tu_desc_next(p_desc)) {
+        if (TUSB_DESC_ENDPOINT == tu_desc_type(p_desc)) {
+          tusb_desc_endpoint_t const* desc_ep = (tusb_desc_endpoint_t const*) p_desc;
+          TU_ASSERT(TUSB_XFER_BULK == desc_ep->bmAttributes.xfer);
+          TU_ASSERT(tuh_edpt_open(daddr, desc_ep));
+
+          if (tu_edpt_dir(desc_ep->bEndpointAddress) == TUSB_DIR_IN) {
+            p_rndis->ep_in = desc_ep->bEndpointAddress;
+          } else {
+            p_rndis->ep_out      = desc_ep->bEndpointAddress;
+            p_rndis->ep_out_size = tu_edpt_packet_size(desc_ep);
+          }
+          count++;
+        }
+      }
+      break;
+    }
+  }
+
+  TU_ASSERT(p_rndis->ep_in && p_rndis->ep_out && p_rndis->ep_out_size);
+  return true;
+}
+
+static void config_failed(rndish_interface_t* p_rndis) {
+  TU_LOG_DRV("  RNDISh config failed\r\n");
+  usbh_driver_set_config_complete(p_rndis->daddr, p_rndis->itf_data);
+}
+
+static void rndis_process_config(tuh_xfer_t* xfer);
+
+static void config_response_get(rndish_interface_t* p_rndis, uint8_t idx, uint8_t state) {
+  if (!rndis_control_xfer(p_rndis, idx, TUSB_DIR_IN, CDC_REQUEST_GET_ENCAPSULATED_RESPONSE, CTRL_BUFSIZE,
+                          rndis_process_config, ((uintptr_t) idx << 8) | state)) {
+    config_failed(p_rndis);
+  }
+}
+
+static void config_retry_deferred(void* param) {
+  uint8_t const daddr = (uint8_t) ((uintptr_t) param >> 16);
+  uint8_t const idx   = (uint8_t) (((uintptr_t) param >> 8) & 0xff);
+  rndish_interface_t* p_rndis = get_itf(idx);
+  TU_VERIFY(p_rndis && p_rndis->daddr == daddr && !p_rndis->mounted,);
+  config_response_get(p_rndis, idx, (uint8_t) ((uintptr_t) param & 0xff));
+}
+
+// Response is not ready yet, get it again later
+static void config_retry(rndish_interface_t* p_rndis, uint8_t idx, uint8_t state) {
+  uintptr_t const param = ((uintptr_t) p_rndis->daddr << 16) | ((uintptr_t) idx << 8) | state;
+  if (++p_rndis->ctrl_retry > RESPONSE_RETRY_MAX ||
+      !usbh_defer_func_ms(config_retry_deferred, (void*) param, RESPONSE_DELAY_MS)) {
+    config_failed(p_rndis);
+  }
+}
+
+static void config_command_sent(tuh_xfer_t* xfer) {
+  uint8_t const idx = (uint8_t) (xfer->user_data >> 8);
+  rndish_interface_t* p_rndis = get_itf(idx);
+  TU_ASSERT(p_rndis,);
+
+  if (xfer->result != XFER_RESULT_SUCCESS) {
+    config_failed(p_rndis);
+    return;
+  }
+
+  p_rndis->ctrl_retry = 0;
+  config_response_get(p_rndis, idx, (uint8_t) (xfer->user_data & 0xff));
+}
+
+// Send command message in control buffer, its response is checked by next state
+static void config_command(rndish_interface_t* p_rndis, uint8_t idx, uint16_t len, uint8_t next_state) {
+  if (!rndis_control_xfer(p_rndis, idx, TUSB_DIR_OUT, CDC_REQUEST_SEND_ENCAPSULATED_COMMAND, len,
+                          config_command_sent, ((uintptr_t) idx << 8) | next_state)) {
+    config_failed(p_rndis);
+  }
+}
+
+// Length of the response to last command if it is a completion of expected type, 0 if not received yet.
+// Status indication received meanwhile is processed
+static uint32_t config_response(rndish_interface_t* p_rndis, uint8_t idx, tuh_xfer_t const* xfer, uint32_t type) {
+  uint8_t const* msg = _rndish_epbuf[idx].ctrl;
+  uint32_t const len = xfer->actual_len;
+  TU_VERIFY(xfer->result == XFER_RESULT_SUCCESS && len >= sizeof(rndis_msg_set_cmplt_t), 0);
+
+  uint32_t const msg_type = msg_read32(msg, 0);
+  if (msg_type == RNDIS_MSG_INDICATE_STATUS) {
+    status_process(p_rndis, idx, msg, len);
+    return 0;
+  }
+
+  TU_VERIFY(msg_type == type && msg_read32(msg, offsetof(rndis_msg_set_cmplt_t, request_id)) == p_rndis->request_id, 0);
+  return len;
+}
+
+static void rndis_process_config(tuh_xfer_t* xfer) {
+  uint8_t const idx   = (uint8_t) (xfer->user_data >> 8);
+  uint8_t const state = (uint8_t) (xfer->user_data & 0xff);
+  rndish_interface_t* p_rndis = get_itf(idx);
+  TU_ASSERT(p_rndis,);
+
+  uint8_t* msg = _rndish_epbuf[idx].ctrl;
+
+  switch (state) {
+    case CONFIG_RNDIS_INITIALIZE:
+      // device may concatenate packet messages up to our reception buffer
+      msg_request_init(p_rndis, msg, RNDIS_MSG_INITIALIZE, sizeof(rndis_msg_initialize_t));
+      msg_write32(msg, offsetof(rndis_msg_initialize_t, major_version), 1);
+      msg_write32(msg, offsetof(rndis_msg_initialize_t, minor_version), 0);
+      msg_write32(msg, offsetof(rndis_msg_initialize_t, max_xfer_size), CFG_TUH_RNDIS_RX_BUFSIZE);
+      config_command(p_rndis, idx, sizeof(rndis_msg_initialize_t), CONFIG_RNDIS_QUERY_MAC);
+      break;
+
+    case CONFIG_RNDIS_QUERY_MAC: {
+      uint32_t const len = config_response(p_rndis, idx, xfer, RNDIS_MSG_INITIALIZE_CMPLT);
+      if (len == 0) {
+        config_retry(p_rndis, idx, state);
+        break;
+      }
+      if (len < sizeof(rndis_msg_initialize_cmplt_t) ||
+          msg_read32(msg, offsetof(rndis_msg_initialize_cmplt_t, status)) != RNDIS_STATUS_SUCCESS) {
+        config_failed(p_rndis);
+        break;
+      }
+
+      uint32_t const max_packets = msg_read32(msg, offsetof(rndis_msg_initialize_cmplt_t, max_packet_per_xfer));
+      uint32_t const max_size    = msg_read32(msg, offsetof(rndis_msg_initialize_cmplt_t, max_xfer_size));
+      uint32_t const align_factor = msg_read32(msg, offsetof(rndis_msg_initialize_cmplt_t, packet_alignment_factor));
+
+      p_rndis->tx_max_size    = (uint16_t) tu_min32(CFG_TUH_RNDIS_TX_BUFSIZE, max_size);
+      p_rndis->tx_max_packets = (uint8_t) tu_min32(CFG_TUH_RNDIS_TX_MAX_PACKETS, tu_max32(max_packets, 1));
+      // message offsets are kept 4-byte aligned, an alignment beyond 128 bytes wastes buffer: one message per transfer
+      p_rndis->tx_align = (uint16_t) (1u << tu_max32(tu_min32(align_factor, 7), 2));
+      if (align_factor > 7) {
+        p_rndis->tx_max_packets = 1;
+      }
+      TU_LOG_DRV("  RNDISh max transfer out = %u (%u packets), in = %u\r\n", p_rndis->tx_max_size,
+                 p_rndis->tx_max_packets, CFG_TUH_RNDIS_RX_BUFSIZE);
+
+      msg_request_init(p_rndis, msg, RNDIS_MSG_QUERY, sizeof(rndis_msg_query_t));
+      msg_write32(msg, offsetof(rndis_msg_query_t, oid), RNDIS_OID_802_3_PERMANENT_ADDRESS);
+      config_command(p_rndis, idx, sizeof(rndis_msg_query_t), CONFIG_RNDIS_SET_FILTER);
+      break;
+    }
+
+    case CONFIG_RNDIS_SET_FILTER: {
+      uint32_t const len = config_response(p_rndis, idx, xfer, RNDIS_MSG_QUERY_CMPLT);
+      if (len == 0) {
+        config_retry(p_rndis, idx, state);
+        break;
+      }
+
+      // MAC address is optional, buffer offset is relative to request id
+      if (len >= sizeof(rndis_msg_query_cmplt_t) &&
+          msg_read32(msg, offsetof(rndis_msg_query_cmplt_t, status)) == RNDIS_STATUS_SUCCESS) {
+        uint32_t const buf_len = msg_read32(msg, offsetof(rndis_msg_query_cmplt_t, buffer_length));
+        uint32_t const buf_ofs = msg_read32(msg, offsetof(rndis_msg_query_cmplt_t, buffer_offset)) +
+                                 offsetof(rndis_msg_query_cmplt_t, request_id);
+        if (buf_len >= 6 && buf_ofs <= len - 6) {
+          memcpy(p_rndis->mac, msg + buf_ofs, 6);
+          p_rndis->mac_valid = true;
+        }
+      }
+
+      // device does not send any packet until filter is set
+      uint32_t const filter = RNDIS_PACKET_TYPE_DIRECTED | RNDIS_PACKET_TYPE_MULTICAST |
+                              RNDIS_PACKET_TYPE_ALL_MULTICAST | RNDIS_PACKET_TYPE_BROADCAST;
+      msg_request_init(p_rndis, msg, RNDIS_MSG_SET, sizeof(rndis_msg_set_t) + 4);
+      msg_write32(msg, offsetof(rndis_msg_set_t, oid), RNDIS_OID_GEN_CURRENT_PACKET_FILTER);
+      msg_write32(msg, offsetof(rndis_msg_set_t, buffer_length), 4);
+      msg_write32(msg, offsetof(rndis_msg_set_t, buffer_offset),
+                  sizeof(rndis_msg_set_t) - offsetof(rndis_msg_set_t, request_id));
+      msg_write32(msg, sizeof(rndis_msg_set_t), filter);
+      config_command(p_rndis, idx, sizeof(rndis_msg_set_t) + 4, CONFIG_RNDIS_COMPLETE);
+      break;
+    }
+
+    case CONFIG_RNDIS_COMPLETE: {
+      uint32_t const len = config_response(p_rndis, idx, xfer, RNDIS_MSG_SET_CMPLT);
+      if (len == 0) {
+        config_retry(p_rndis, idx, state);
+        break;
+      }
+      if (msg_read32(msg, offsetof(rndis_msg_set_cmplt_t, status)) != RNDIS_STATUS_SUCCESS) {
+        config_failed(p_rndis);
+        break;
+      }
+
+      TU_LOG_DRV("RNDISh Set Configure complete\r\n");
+      p_rndis->mounted = true;
+      if (tuh_rndis_mount_cb) {
+        tuh_rndis_mount_cb(idx);
+      }
+
+      notif_xfer(p_rndis, idx);
+      rx_submit(p_rndis, idx);
+
+      // data interface is bound to this driver as well
+      usbh_driver_set_config_complete(p_rndis->daddr, p_rndis->itf_data);
+      break;
+    }
+
+    default:
+      break;
+  }
+}
+
+bool rndish_set_config(uint8_t daddr, uint8_t itf_num) {
+  uint8_t const idx = tuh_rndis_itf_get_index(daddr, itf_num);
+  TU_ASSERT(get_itf(idx));
+
+  // fake transfer to kick-off process
+  tuh_xfer_t xfer;
+  xfer.daddr     = daddr;
+  xfer.result    = XFER_RESULT_SUCCESS;
+  xfer.user_data = ((uintptr_t) idx << 8) | CONFIG_RNDIS_INITIALIZE;
+
+  rndis_process_config(&xfer);
+  return true;
+}
+
+#endif
@@ -0,0 +1,156 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#ifndef _TUSB_RNDIS_HOST_H_
+#define _TUSB_RNDIS_HOST_H_
+
+#include "class/cdc/cdc.h"
+#include "class/cdc/cdc_rndis.h"
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+// Remote NDIS host driver e.g for Android USB tethering. Control messages are exchanged with encapsulated
+// command/response requests, network data is carried by REMOTE_NDIS_PACKET_MSG on the bulk pipes.
+// Several packet messages can be concatenated in one bulk transfer in both directions: received transfers are parsed
+// message by message, transmitted frames are aggregated up to device MaxTransferSize and MaxPacketsPerTransfer.
+// With CFG_TUH_EDPT_XFER_QUEUE (and CFG_TUH_API_EDPT_XFER) all free reception buffers are submitted at once.
+
+//--------------------------------------------------------------------+
+// Class Driver Configuration
+//--------------------------------------------------------------------+
+
+// Number of buffers for reception
+#ifndef CFG_TUH_RNDIS_RX_BUF_N
+  #define CFG_TUH_RNDIS_RX_BUF_N        2
+#endif
+
+// Size of a reception buffer, announced to device as MaxTransferSize of INITIALIZE message. Device may concatenate
+// packet messages up to this size, larger buffer (e.g 8192) allows more aggregation. Must fit a full ethernet frame
+#ifndef CFG_TUH_RNDIS_RX_BUFSIZE
+  #define CFG_TUH_RNDIS_RX_BUFSIZE      2048
+#endif
+
+// Number of buffers for transmission
+#ifndef CFG_TUH_RNDIS_TX_BUF_N
+  #define CFG_TUH_RNDIS_TX_BUF_N        2
+#endif
+
+// Size of a transmission buffer, limited further by device MaxTransferSize. Must fit a full ethernet frame
+#ifndef CFG_TUH_RNDIS_TX_BUFSIZE
+  #define CFG_TUH_RNDIS_TX_BUFSIZE      2048
+#endif
+
+// Maximum number of packet messages aggregated into a transmission buffer, limited further by device
+// MaxPacketsPerTransfer
+#ifndef CFG_TUH_RNDIS_TX_MAX_PACKETS
+  #define CFG_TUH_RNDIS_TX_MAX_PACKETS  8
+#endif
+
+TU_VERIFY_STATIC(CFG_TUH_RNDIS_RX_BUF_N > 0 && CFG_TUH_RNDIS_RX_BUF_N < UINT8_MAX, "Number is not correct");
+TU_VERIFY_STATIC(CFG_TUH_RNDIS_TX_BUF_N > 0 && CFG_TUH_RNDIS_TX_BUF_N < UINT8_MAX, "Number is not correct");
+TU_VERIFY_STATIC(CFG_TUH_RNDIS_RX_BUFSIZE >= 1600 && CFG_TUH_RNDIS_RX_BUFSIZE <= UINT16_MAX, "Size is not correct");
+TU_VERIFY_STATIC(CFG_TUH_RNDIS_TX_BUFSIZE >= 1600 && CFG_TUH_RNDIS_TX_BUFSIZE <= UINT16_MAX, "Size is not correct");
+TU_VERIFY_STATIC(CFG_TUH_RNDIS_TX_MAX_PACKETS > 0 && CFG_TUH_RNDIS_TX_MAX_PACKETS < UINT8_MAX, "Number is not correct");
+
+//--------------------------------------------------------------------+
+// Application API
+//--------------------------------------------------------------------+
+
+// Get Interface index from device address + interface number
+// return TUSB_INDEX_INVALID_8 (0xFF) if not found
+uint8_t tuh_rndis_itf_get_index(uint8_t daddr, uint8_t itf_num);
+
+// Get Interface information
+bool tuh_rndis_itf_get_info(uint8_t idx, tuh_itf_info_t* info);
+
+// Check if an interface is mounted
+bool tuh_rndis_mounted(uint8_t idx);
+
+// Check if device reported media connection, assumed connected when mounted
+bool tuh_rndis_connected(uint8_t idx);
+
+// Get MAC address of device (OID_802_3_PERMANENT_ADDRESS)
+bool tuh_rndis_get_mac(uint8_t idx, uint8_t mac[6]);
+
+// Check if a frame of len bytes can be transmitted now
+bool tuh_rndis_can_xmit(uint8_t idx, uint16_t len);
+
+// Copy an ethernet frame into the transmission buffer, sent at once if endpoint is idle
+bool tuh_rndis_xmit(uint8_t idx, void const* frame, uint16_t len);
+
+// Resume delivery of received frames paused by tuh_rndis_rx_cb() returning false
+void tuh_rndis_rx_resume(uint8_t idx);
+
+//--------------------------------------------------------------------+
+// Application Callbacks
+//--------------------------------------------------------------------+
+
+// Invoked when a device with RNDIS interface is mounted
+TU_ATTR_WEAK extern void tuh_rndis_mount_cb(uint8_t idx);
+
+// Invoked when a device with RNDIS interface is unmounted
+TU_ATTR_WEAK extern void tuh_rndis_umount_cb(uint8_t idx);
+
+// Invoked for each received ethernet frame, data is only valid during the callback.
+// Return false if frame can not be consumed now: it is delivered again after tuh_rndis_rx_resume()
+TU_ATTR_WEAK extern bool tuh_rndis_rx_cb(uint8_t idx, uint8_t const* frame, uint16_t len);
+
+// Invoked when a transfer is sent and therefore room becomes available for transmission
+TU_ATTR_WEAK extern void tuh_rndis_tx_complete_cb(uint8_t idx);
+
+// Invoked when device indicates media connect/disconnect
+TU_ATTR_WEAK extern void tuh_rndis_link_cb(uint8_t idx, bool connected);
+
+//--------------------------------------------------------------------+
+// Internal Class Driver API
+//--------------------------------------------------------------------+
+
+// RNDIS communication interface: Wireless Controller/RNDIS, CDC ACM with vendor protocol (Windows compatible
+// devices) or Miscellaneous/RNDIS over Ethernet
+TU_ATTR_ALWAYS_INLINE static inline bool rndish_is_rndis_itf(tusb_desc_interface_t const* desc_itf) {
+  uint8_t const cls = desc_itf->bInterfaceClass;
+  uint8_t const sub = desc_itf->bInterfaceSubClass;
+  uint8_t const protocol = desc_itf->bInterfaceProtocol;
+
+  return (TUSB_CLASS_WIRELESS_CONTROLLER == cls && 0x01 == sub && 0x03 == protocol) ||
+         (TUSB_CLASS_CDC == cls && CDC_COMM_SUBCLASS_ABSTRACT_CONTROL_MODEL == sub && 0xFF == protocol) ||
+         (TUSB_CLASS_MISC == cls && 0x04 == sub && 0x01 == protocol);
+}
+
+bool rndish_init       (void);
+bool rndish_deinit     (void);
+bool rndish_open       (uint8_t rhport, uint8_t dev_addr, tusb_desc_interface_t const *itf_desc, uint16_t max_len);
+bool rndish_set_config (uint8_t dev_addr, uint8_t itf_num);
+bool rndish_xfer_cb    (uint8_t dev_addr, uint8_t ep_addr, xfer_result_t event, uint32_t xferred_bytes);
+void rndish_close      (uint8_t dev_addr);
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif /* _TUSB_RNDIS_HOST_H_ */
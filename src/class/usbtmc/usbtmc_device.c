@@ -91,6 +91,13 @@ tu_static char logMsg[150];
 #define CFG_TUD_USBTMC_INT_EP_SIZE 2
 #endif
 
+// Number of notifications queued for interrupt endpoint while it is busy
+#ifndef CFG_TUD_USBTMC_NOTIF_QUEUE_DEPTH
+#define CFG_TUD_USBTMC_NOTIF_QUEUE_DEPTH 4
+#endif
+
+TU_VERIFY_STATIC(CFG_TUD_USBTMC_NOTIF_QUEUE_DEPTH > 0, "USBTMC notification queue depth must be at least 1");
+
 /*
  * The state machine does not allow simultaneous reading and writing. This is
  * consistent with USBTMC.
@@ -139,6 +146,26 @@ typedef struct
 
   uint8_t const * devInBuffer; // pointer to application-layer used for transmissions
 
+  // Chunked transmission: data is pulled from tud_usbtmc_msgBulkIn_data_cb() into epin buffer
+  bool devInChunked;
+  uint16_t devInFill;          // bytes in epin buffer, including header
+  uint16_t devInHdrLen;        // header bytes in epin buffer (first transfer only)
+
+  // Bulk-OUT transfers into application buffers, in completion order. 2nd one is queued behind the 1st
+  struct {
+    uint8_t * buf;
+    uint16_t len;
+  } devOut[2];
+  uint8_t devOutCount;
+
+  // Interrupt-IN notifications waiting for endpoint, sent in order from usbtmcd_xfer_cb
+  struct {
+    uint8_t len;
+    uint8_t data[CFG_TUD_USBTMC_INT_EP_SIZE];
+  } notif[CFG_TUD_USBTMC_NOTIF_QUEUE_DEPTH];
+  uint8_t notifRd;
+  uint8_t notifCount;
+
   usbtmc_capabilities_specific_t const * capabilities;
 } usbtmc_interface_state_t;
 
@@ -163,7 +190,7 @@ CFG_TUD_MEM_SECTION static usbtmc_epbuf_t usbtmc_epbuf;
 TU_VERIFY_STATIC(USBTMCD_BUFFER_SIZE >= 32u,"USBTMC dev buffer size too small");
 
 static bool handle_devMsgOutStart(uint8_t rhport, void *data, size_t len);
-static bool handle_devMsgOut(uint8_t rhport, void *data, size_t len, size_t packetLen);
+static bool handle_devMsgOut(uint8_t rhport, void *data, size_t len, bool shortPacket);
 
 #ifndef NDEBUG
 tu_static uint8_t termChar;
@@ -224,6 +251,7 @@ bool tud_usbtmc_transmit_dev_msg_data(
 #endif
 
   TU_VERIFY(usbtmc_state.state == STATE_TX_REQUESTED);
+  usbtmc_state.devInChunked = false;
   usbtmc_msg_dev_dep_msg_in_header_t *hdr = (usbtmc_msg_dev_dep_msg_in_header_t*)usbtmc_epbuf.epin;
   tu_varclr(hdr);
   hdr->header.MsgID = USBTMC_MSGID_DEV_DEP_MSG_IN;
@@ -251,17 +279,179 @@ bool tud_usbtmc_transmit_dev_msg_data(
   return true;
 }
 
+// Pull data from application until epin buffer is full or message is complete, then send it. Application may
+// provide less than asked when data is not ready yet, transmission is then resumed by
+// tud_usbtmc_transmit_dev_msg_data_resume(). Non-last transfers are always full buffer (multiple of packet size).
+static bool chunked_fill_send(uint8_t rhport)
+{
+  TU_VERIFY(tud_usbtmc_msgBulkIn_data_cb != NULL);
+  TU_VERIFY(usbtmc_state.state == STATE_TX_INITIATED && usbtmc_state.devInChunked);
+
+  size_t fill = usbtmc_state.devInFill;
+  size_t need = tu_min32(USBTMCD_BUFFER_SIZE - fill, usbtmc_state.transfer_size_remaining);
+  while (need > 0u)
+  {
+    size_t const count = tud_usbtmc_msgBulkIn_data_cb(usbtmc_epbuf.epin + fill, need);
+    if (count == 0u)
+    {
+      break;
+    }
+    TU_ASSERT(count <= need);
+    fill += count;
+    need -= count;
+    usbtmc_state.transfer_size_remaining -= count;
+  }
+  usbtmc_state.devInFill = (uint16_t)fill;
+
+  if (need > 0u)
+  {
+    return true; // wait for resume
+  }
+
+  usbtmc_state.transfer_size_sent += fill - usbtmc_state.devInHdrLen;
+  usbtmc_state.devInHdrLen = 0u;
+  usbtmc_state.devInFill = 0u;
+
+  if ((usbtmc_state.transfer_size_remaining == 0u) &&
+      (((fill % usbtmc_state.ep_bulk_in_wMaxPacketSize) != 0u) || (fill == 0u)))
+  {
+    usbtmc_state.state = STATE_TX_SHORTED;
+  }
+  // else: last data ends on packet boundary, a ZLP is sent on completion
+
+  TU_VERIFY(usbd_edpt_xfer(rhport, usbtmc_state.ep_bulk_in, usbtmc_epbuf.epin, (uint16_t)fill));
+  return true;
+}
+
+static void chunked_resume_task(void* param)
+{
+  (void) param;
+  if (usbtmc_state.state == STATE_TX_INITIATED && usbtmc_state.devInChunked &&
+      !usbd_edpt_busy(usbtmc_state.rhport, usbtmc_state.ep_bulk_in))
+  {
+    (void) chunked_fill_send(usbtmc_state.rhport);
+  }
+}
+
+// called from app
+// Header is sent with total len, data is pulled with tud_usbtmc_msgBulkIn_data_cb() as endpoint drains.
+bool tud_usbtmc_transmit_dev_msg_data_chunked(size_t len, bool endOfMessage, bool usingTermChar)
+{
+#ifndef NDEBUG
+  TU_ASSERT(len > 0u);
+  TU_ASSERT(len <= usbtmc_state.transfer_size_remaining);
+  TU_ASSERT(usbtmc_state.transfer_size_sent == 0u);
+  if(usingTermChar)
+  {
+    TU_ASSERT(usbtmc_state.capabilities->bmDevCapabilities.canEndBulkInOnTermChar);
+    TU_ASSERT(termCharRequested);
+  }
+#endif
+
+  TU_VERIFY(usbtmc_state.state == STATE_TX_REQUESTED);
+  usbtmc_msg_dev_dep_msg_in_header_t *hdr = (usbtmc_msg_dev_dep_msg_in_header_t*)usbtmc_epbuf.epin;
+  tu_varclr(hdr);
+  hdr->header.MsgID = USBTMC_MSGID_DEV_DEP_MSG_IN;
+  hdr->header.bTag = usbtmc_state.lastBulkInTag;
+  hdr->header.bTagInverse = (uint8_t)~(usbtmc_state.lastBulkInTag);
+  hdr->TransferSize = len;
+  hdr->bmTransferAttributes.EOM = endOfMessage;
+  hdr->bmTransferAttributes.UsingTermChar = usingTermChar;
+
+  usbtmc_state.transfer_size_remaining = len;
+  usbtmc_state.transfer_size_sent = 0u;
+  usbtmc_state.devInBuffer = NULL;
+  usbtmc_state.devInChunked = true;
+  usbtmc_state.devInHdrLen = sizeof(*hdr);
+  usbtmc_state.devInFill = sizeof(*hdr);
+
+  TU_VERIFY(atomicChangeState(STATE_TX_REQUESTED, STATE_TX_INITIATED));
+  usbd_defer_func(chunked_resume_task, NULL, false);
+  return true;
+}
+
+// called from app, when more data is available for tud_usbtmc_msgBulkIn_data_cb()
+bool tud_usbtmc_transmit_dev_msg_data_resume(void)
+{
+  TU_VERIFY(usbtmc_state.state == STATE_TX_INITIATED && usbtmc_state.devInChunked);
+  usbd_defer_func(chunked_resume_task, NULL, false);
+  return true;
+}
+
+// Send oldest queued notification if interrupt endpoint is idle
+static void notif_send_next(uint8_t rhport)
+{
+  TU_VERIFY(usbd_edpt_claim(rhport, usbtmc_state.ep_int_in),);
+
+  uint8_t len = 0u;
+  criticalEnter();
+  if (usbtmc_state.notifCount > 0u)
+  {
+    len = usbtmc_state.notif[usbtmc_state.notifRd].len;
+    memcpy(usbtmc_epbuf.epnotif, usbtmc_state.notif[usbtmc_state.notifRd].data, len);
+    usbtmc_state.notifRd = (uint8_t)((usbtmc_state.notifRd + 1u) % CFG_TUD_USBTMC_NOTIF_QUEUE_DEPTH);
+    usbtmc_state.notifCount--;
+  }
+  criticalLeave();
+
+  if ((len == 0u) || !usbd_edpt_xfer(rhport, usbtmc_state.ep_int_in, usbtmc_epbuf.epnotif, len))
+  {
+    usbd_edpt_release(rhport, usbtmc_state.ep_int_in);
+  }
+}
+
+// Queue notification, SRQ with the same status byte as one still pending is coalesced.
+// Return false if queue is full.
+static bool notif_queue(uint8_t rhport, const void * data, size_t len)
+{
+  TU_VERIFY(len > 0u && len <= CFG_TUD_USBTMC_INT_EP_SIZE);
+  uint8_t const * data8 = (uint8_t const *) data;
+  bool ret = true;
+
+  criticalEnter();
+  bool coalesced = false;
+  if ((len == sizeof(usbtmc_srq_interrupt_488_t)) && (data8[0] == USB488_bNOTIFY1_SRQ))
+  {
+    for (uint8_t i = 0; i < usbtmc_state.notifCount; i++)
+    {
+      uint8_t const idx = (uint8_t)((usbtmc_state.notifRd + i) % CFG_TUD_USBTMC_NOTIF_QUEUE_DEPTH);
+      if ((usbtmc_state.notif[idx].len == len) && (memcmp(usbtmc_state.notif[idx].data, data8, len) == 0))
+      {
+        coalesced = true;
+        break;
+      }
+    }
+  }
+
+  if (!coalesced)
+  {
+    if (usbtmc_state.notifCount < CFG_TUD_USBTMC_NOTIF_QUEUE_DEPTH)
+    {
+      uint8_t const idx =
+          (uint8_t)((usbtmc_state.notifRd + usbtmc_state.notifCount) % CFG_TUD_USBTMC_NOTIF_QUEUE_DEPTH);
+      usbtmc_state.notif[idx].len = (uint8_t)len;
+      memcpy(usbtmc_state.notif[idx].data, data8, len);
+      usbtmc_state.notifCount++;
+    }
+    else
+    {
+      ret = false;
+    }
+  }
+  criticalLeave();
+
+  notif_send_next(rhport);
+  return ret;
+}
+
 bool tud_usbtmc_transmit_notification_data(const void * data, size_t len)
 {
 #ifndef NDEBUG
   TU_ASSERT(len > 0);
   TU_ASSERT(usbtmc_state.ep_int_in != 0);
 #endif
-  TU_VERIFY(usbd_edpt_busy(usbtmc_state.rhport, usbtmc_state.ep_int_in));
-
-  TU_VERIFY(tu_memcpy_s(usbtmc_epbuf.epnotif, CFG_TUD_USBTMC_INT_EP_SIZE, data, len) == 0);
-  TU_VERIFY(usbd_edpt_xfer(usbtmc_state.rhport, usbtmc_state.ep_int_in, usbtmc_epbuf.epnotif, (uint16_t)len));
-  return true;
+  TU_VERIFY(usbtmc_state.ep_int_in != 0);
+  return notif_queue(usbtmc_state.rhport, data, len);
 }
 
 void usbtmcd_init_cb(void)
@@ -396,6 +586,7 @@ bool tud_usbtmc_start_bus_read(void)
     break;
   // When receiving, let it remain receiving
   case STATE_RCV:
+    TU_VERIFY(usbtmc_state.devOutCount == 0u);
     break;
   default:
     return false;
@@ -404,6 +595,45 @@ bool tud_usbtmc_start_bus_read(void)
   return true;
 }
 
+// Receive the rest of current DEV_DEP_MSG_OUT directly into application buffer with a multi-packet transfer,
+// instead of one packet at a time. Only valid while receiving (from tud_usbtmc_msgBulkOut_start_cb or
+// tud_usbtmc_msg_data_cb). With CFG_TUD_EDPT_XFER_QUEUE a 2nd buffer can be queued so that host keeps
+// sending while the 1st one is parsed, provided the 1st one cannot complete the message.
+bool tud_usbtmc_start_bus_read_into(void *buf, size_t bufsize)
+{
+  TU_VERIFY(usbtmc_state.state == STATE_RCV);
+  TU_VERIFY(usbtmc_state.devOutCount < (CFG_TUD_EDPT_XFER_QUEUE ? 2u : 1u));
+
+  uint32_t const mps = usbtmc_state.ep_bulk_out_wMaxPacketSize;
+  uint32_t committed = 0u;
+  for (uint8_t i = 0; i < usbtmc_state.devOutCount; i++)
+  {
+    committed += usbtmc_state.devOut[i].len;
+  }
+  TU_VERIFY(usbtmc_state.transfer_size_remaining > committed);
+
+  // Rounding remaining data up to packet size also covers the alignment padding at end of message
+  uint32_t const left = tu_round_up(usbtmc_state.transfer_size_remaining - committed, mps);
+  uint32_t const len = tu_min32(tu_min32(bufsize, UINT16_MAX) - (tu_min32(bufsize, UINT16_MAX) % mps), left);
+  TU_VERIFY(len > 0u);
+
+  uint8_t const idx = usbtmc_state.devOutCount;
+  usbtmc_state.devOut[idx].buf = (uint8_t*) buf;
+  usbtmc_state.devOut[idx].len = (uint16_t) len;
+  usbtmc_state.devOutCount++;
+
+#if CFG_TUD_EDPT_XFER_QUEUE
+  bool const ret = usbd_edpt_xfer_queue(usbtmc_state.rhport, usbtmc_state.ep_bulk_out, (uint8_t*) buf, (uint16_t) len);
+#else
+  bool const ret = usbd_edpt_xfer(usbtmc_state.rhport, usbtmc_state.ep_bulk_out, (uint8_t*) buf, (uint16_t) len);
+#endif
+  if (!ret)
+  {
+    usbtmc_state.devOutCount--;
+  }
+  return ret;
+}
+
 void usbtmcd_reset_cb(uint8_t rhport)
 {
   (void)rhport;
@@ -428,24 +658,24 @@ static bool handle_devMsgOutStart(uint8_t rhport, void *data, size_t len)
   usbtmc_state.transfer_size_remaining = msg->TransferSize;
   TU_VERIFY(tud_usbtmc_msgBulkOut_start_cb(msg));
 
-  TU_VERIFY(handle_devMsgOut(rhport, (uint8_t*)data + sizeof(*msg), len - sizeof(*msg), len));
+  TU_VERIFY(handle_devMsgOut(rhport, (uint8_t*)data + sizeof(*msg), len - sizeof(*msg),
+                             len < usbtmc_state.ep_bulk_out_wMaxPacketSize));
   usbtmc_state.lastBulkOutTag = msg->header.bTag;
   return true;
 }
 
-static bool handle_devMsgOut(uint8_t rhport, void *data, size_t len, size_t packetLen)
+static bool handle_devMsgOut(uint8_t rhport, void *data, size_t len, bool shortPacket)
 {
   (void)rhport;
   // return true upon failure, as we can assume error is being handled elsewhere.
   TU_VERIFY(usbtmc_state.state == STATE_RCV,true);
 
-  bool shortPacket = (packetLen < usbtmc_state.ep_bulk_out_wMaxPacketSize);
-
   // Packet is to be considered complete when we get enough data or at a short packet.
   bool atEnd = false;
   if(len >= usbtmc_state.transfer_size_remaining || shortPacket)
   {
     atEnd = true;
+    usbtmc_state.devOutCount = 0u;
     TU_VERIFY(atomicChangeState(STATE_RCV, STATE_NAK));
   }
 
@@ -540,12 +770,24 @@ bool usbtmcd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint
         return true;
       }
     case STATE_RCV:
-      if(!handle_devMsgOut(rhport, usbtmc_epbuf.epout, xferred_bytes, xferred_bytes))
+    {
+      uint8_t * buf = usbtmc_epbuf.epout;
+      bool shortPacket = (xferred_bytes < usbtmc_state.ep_bulk_out_wMaxPacketSize);
+      if(usbtmc_state.devOutCount > 0u)
+      {
+        // transfer into application buffer: a short packet ends it early
+        buf = usbtmc_state.devOut[0].buf;
+        shortPacket = (xferred_bytes < usbtmc_state.devOut[0].len);
+        usbtmc_state.devOut[0] = usbtmc_state.devOut[1];
+        usbtmc_state.devOutCount--;
+      }
+      if(!handle_devMsgOut(rhport, buf, xferred_bytes, shortPacket))
       {
         usbd_edpt_stall(rhport, usbtmc_state.ep_bulk_out);
         return false;
       }
       return true;
+    }
 
     case STATE_ABORTING_BULK_OUT:
       // Should be stalled by now, shouldn't have received a packet.
@@ -564,12 +806,17 @@ bool usbtmcd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint
   {
     switch(usbtmc_state.state) {
     case STATE_TX_SHORTED:
+      usbtmc_state.devInChunked = false;
       TU_VERIFY(atomicChangeState(STATE_TX_SHORTED, STATE_NAK));
       TU_VERIFY(tud_usbtmc_msgBulkIn_complete_cb());
       break;
 
     case STATE_TX_INITIATED:
-      if(usbtmc_state.transfer_size_remaining >= USBTMCD_BUFFER_SIZE)
+      if(usbtmc_state.devInChunked)
+      {
+        return chunked_fill_send(rhport);
+      }
+      else if(usbtmc_state.transfer_size_remaining >= USBTMCD_BUFFER_SIZE)
       {
         // Copy buffer to ensure alignment correctness
         memcpy(usbtmc_epbuf.epin, usbtmc_state.devInBuffer, USBTMCD_BUFFER_SIZE);
@@ -582,7 +829,7 @@ bool usbtmcd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint
       {
         size_t packetLen = usbtmc_state.transfer_size_remaining;
         memcpy(usbtmc_epbuf.epin, usbtmc_state.devInBuffer, usbtmc_state.transfer_size_remaining);
-          usbtmc_state.transfer_size_sent += sizeof(usbtmc_state.transfer_size_remaining);
+        usbtmc_state.transfer_size_sent += packetLen;
         usbtmc_state.transfer_size_remaining = 0;
         usbtmc_state.devInBuffer = NULL;
         TU_VERIFY( usbd_edpt_xfer(rhport, usbtmc_state.ep_bulk_in, usbtmc_epbuf.epin, (uint16_t)packetLen) );
@@ -609,6 +856,7 @@ bool usbtmcd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint
     }
   }
   else if (ep_addr == usbtmc_state.ep_int_in) {
+    notif_send_next(rhport);
     if (tud_usbtmc_notification_complete_cb) {
       TU_VERIFY(tud_usbtmc_notification_complete_cb());
     }
@@ -646,6 +894,7 @@ bool usbtmcd_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request
       usbd_edpt_stall(rhport, (uint8_t)ep_addr);
       usbd_edpt_clear_stall(rhport, (uint8_t)ep_addr);
       usbtmc_state.state = STATE_NAK; // USBD core has placed EP in NAK state for us
+      usbtmc_state.devOutCount = 0u;
       criticalLeave();
       tud_usbtmc_bulkOut_clearFeature_cb();
     }
@@ -653,6 +902,7 @@ bool usbtmcd_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request
     {
       usbd_edpt_stall(rhport, (uint8_t)ep_addr);
       usbd_edpt_clear_stall(rhport, (uint8_t)ep_addr);
+      usbtmc_state.devInChunked = false;
       tud_usbtmc_bulkIn_clearFeature_cb();
     }
     else if ((usbtmc_state.ep_int_in != 0) && (ep_addr == usbtmc_state.ep_int_in))
@@ -703,6 +953,7 @@ bool usbtmcd_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request
       // Check if we've queued a short packet
       criticalEnter();
       usbtmc_state.state = STATE_ABORTING_BULK_OUT;
+      usbtmc_state.devOutCount = 0u;
       criticalLeave();
       TU_VERIFY(tud_usbtmc_initiate_abort_bulk_out_cb(&(rsp.USBTMC_status)));
       usbd_edpt_stall(rhport, usbtmc_state.ep_bulk_out);
@@ -744,9 +995,11 @@ bool usbtmcd_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request
       usbtmc_state.state = ((usbtmc_state.transfer_size_sent % usbtmc_state.ep_bulk_in_wMaxPacketSize) == 0) ?
               STATE_ABORTING_BULK_IN : STATE_ABORTING_BULK_IN_SHORTED;
       criticalLeave();
-      if(usbtmc_state.transfer_size_sent  == 0)
+      usbtmc_state.devInChunked = false;
+      usbtmc_state.devInFill = 0u;
+      if((usbtmc_state.transfer_size_sent == 0) || !usbd_edpt_busy(rhport, usbtmc_state.ep_bulk_in))
       {
-        // Send short packet, nothing is in the buffer yet
+        // Send short packet, nothing is in the buffer yet (or chunked transmission is waiting for data)
         TU_VERIFY( usbd_edpt_xfer(rhport, usbtmc_state.ep_bulk_in, usbtmc_epbuf.epin,(uint16_t)0u));
         usbtmc_state.state = STATE_ABORTING_BULK_IN_SHORTED;
       }
@@ -809,6 +1062,7 @@ bool usbtmcd_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request
       usbtmc_state.transfer_size_remaining = 0;
       criticalEnter();
       usbtmc_state.state = STATE_CLEARING;
+      usbtmc_state.devOutCount = 0u;
       criticalLeave();
       TU_VERIFY(tud_usbtmc_initiate_clear_cb(&tmcStatusCode));
       TU_VERIFY(tud_control_xfer(rhport, request, (void*)&tmcStatusCode,sizeof(tmcStatusCode)));
@@ -879,23 +1133,19 @@ bool usbtmcd_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request
       if(usbtmc_state.ep_int_in != 0)
       {
         rsp.statusByte = 0x00; // Use interrupt endpoint, instead. Must be 0x00 (USB488v1.0 4.3.1.2)
-        if(usbd_edpt_busy(rhport, usbtmc_state.ep_int_in))
+        rsp.USBTMC_status = USBTMC_STATUS_SUCCESS;
+        usbtmc_read_stb_interrupt_488_t intMsg =
         {
-          rsp.USBTMC_status = USB488_STATUS_INTERRUPT_IN_BUSY;
-        }
-        else
+          .bNotify1 = {
+              .one = 1,
+              .bTag = bTag & 0x7Fu,
+          },
+          .StatusByte = tud_usbtmc_get_stb_cb(&(rsp.USBTMC_status))
+        };
+        // Must be queued before control request response sent (USB488v1.0 4.3.1.2)
+        if(!notif_queue(rhport, &intMsg, sizeof(intMsg)))
         {
-          rsp.USBTMC_status = USBTMC_STATUS_SUCCESS;
-          usbtmc_read_stb_interrupt_488_t intMsg =
-          {
-            .bNotify1 = {
-                .one = 1,
-                .bTag = bTag & 0x7Fu,
-            },
-            .StatusByte = tud_usbtmc_get_stb_cb(&(rsp.USBTMC_status))
-          };
-          // Must be queued before control request response sent (USB488v1.0 4.3.1.2)
-          usbd_edpt_xfer(rhport, usbtmc_state.ep_int_in, (void*)&intMsg, sizeof(intMsg));
+          rsp.USBTMC_status = USB488_STATUS_INTERRUPT_IN_BUSY;
         }
       }
       else
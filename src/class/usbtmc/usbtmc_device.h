@@ -63,6 +63,9 @@ void tud_usbtmc_bulkOut_clearFeature_cb(void); // Notice to clear and abort the
 
 bool tud_usbtmc_msgBulkIn_request_cb(usbtmc_msg_request_dev_dep_in const * request);
 bool tud_usbtmc_msgBulkIn_complete_cb(void);
+// Chunked transmission: copy up to bufsize bytes of response data to buf, return number of bytes copied. Return
+// less (or 0) if data is not ready yet, then call tud_usbtmc_transmit_dev_msg_data_resume() when it is.
+TU_ATTR_WEAK size_t tud_usbtmc_msgBulkIn_data_cb(void *buf, size_t bufsize);
 void tud_usbtmc_bulkIn_clearFeature_cb(void); // Notice to clear and abort the pending BULK out transfer
 
 bool tud_usbtmc_initiate_abort_bulk_in_cb(uint8_t *tmcResult);
@@ -94,17 +97,34 @@ bool tud_usbtmc_transmit_dev_msg_data(
     const void * data, size_t len,
     bool endOfMessage, bool usingTermChar);
 
+// Called from app
+//
+// Send DEV_DEP_MSG_IN response of len bytes without staging it in a single buffer. Header with total
+// length is sent first, data is then pulled with tud_usbtmc_msgBulkIn_data_cb() as the endpoint drains.
+bool tud_usbtmc_transmit_dev_msg_data_chunked(size_t len, bool endOfMessage, bool usingTermChar);
+
+// Continue chunked transmission after tud_usbtmc_msgBulkIn_data_cb() ran out of data
+bool tud_usbtmc_transmit_dev_msg_data_resume(void);
+
 // Buffers a notification to be sent to the host. The data starts
 // with the bNotify1 field, see the USBTMC Specification, Table 13.
 //
-// If the previous notification data has not yet been sent, this
-// returns false.
+// Notifications are queued (CFG_TUD_USBTMC_NOTIF_QUEUE_DEPTH) while the
+// endpoint is busy, an SRQ identical to one still queued is coalesced.
+// If the queue is full, this returns false.
 //
 // Requires an interrupt endpoint in the interface.
 bool tud_usbtmc_transmit_notification_data(const void * data, size_t len);
 
 bool tud_usbtmc_start_bus_read(void);
 
+// Receive the rest of current DEV_DEP_MSG_OUT directly into buf (at least one packet, multiple of packet size is
+// used) with a single multi-packet transfer, instead of tud_usbtmc_start_bus_read(). Call during
+// tud_usbtmc_msgBulkOut_start_cb or tud_usbtmc_msg_data_cb, which then reports data in buf. With
+// CFG_TUD_EDPT_XFER_QUEUE a 2nd buffer can be queued (double buffering) if the 1st cannot hold the rest of message.
+// Buffer must stay valid until reported by tud_usbtmc_msg_data_cb.
+bool tud_usbtmc_start_bus_read_into(void *buf, size_t bufsize);
+
 
 /* "callbacks" from USB device core */
 
@@ -114,17 +114,42 @@ typedef struct TU_ATTR_PACKED {
   uint32_t max_payload_transfer_size;
   uint8_t  error_code;/* error code */
   uint8_t  state;    /* 0:probing 1:committed 2:streaming */
+  uint8_t  xfer_pending; /* number of transfers on the wire or queued */
+  uint8_t  xfer_idx;     /* staging buffer to be filled next (ping-pong) */
+  bool     inplace;      /* frame buffer has headroom for payload headers, sent without copy */
+  bool     in_frame;     /* a frame is sent in slices and its last slice is not yet submitted */
+  bool     eof;          /* current buffer is the last part of the frame */
+  tusb_video_payload_header_t hdr; /* payload header of current frame */
+#if CFG_TUD_VIDEO_STREAMING_PACING
+  bool     pace_hold;    /* a frame is submitted and waits for its interval */
+  volatile bool pace_due; /* frame interval has elapsed, next frame can be released */
+  bool     pace_sof_valid;
+  uint16_t pace_sof;     /* frame number of the last SOF */
+  uint32_t pace_elapsed; /* time since the interval started in 100ns units */
+#endif
+#if CFG_TUD_VIDEO_STREAMING_TIMESTAMP
+  bool     pts_set;      /* pts_next is given by application */
+  uint32_t pts_next;     /* presentation time of the next frame */
+  uint32_t pts;          /* presentation time of current frame */
+#endif
 
   video_probe_and_commit_control_t probe_commit_payload; /* Probe and Commit control */
 } videod_streaming_interface_t;
 
+TU_VERIFY_STATIC(CFG_TUD_VIDEO_STREAMING_XFER_BUFSIZE >= CFG_TUD_VIDEO_STREAMING_EP_BUFSIZE &&
+                 CFG_TUD_VIDEO_STREAMING_XFER_BUFSIZE <= UINT16_MAX, "Invalid CFG_TUD_VIDEO_STREAMING_XFER_BUFSIZE");
+
 typedef struct {
-  TUD_EPBUF_DEF(buf, CFG_TUD_VIDEO_STREAMING_EP_BUFSIZE);
+  TUD_EPBUF_DEF(buf, CFG_TUD_VIDEO_STREAMING_XFER_BUFSIZE);
+#if CFG_TUD_VIDEO_STREAMING_PINGPONG
+  TUD_EPBUF_DEF(buf_alt, CFG_TUD_VIDEO_STREAMING_XFER_BUFSIZE);
+#endif
 } videod_streaming_epbuf_t;
 
 /* video control interface */
 typedef struct TU_ATTR_PACKED {
   const uint8_t*beg;                     /* The head of the first video control interface descriptor */
+  uint8_t  rhport;                       /* root port the interface is opened on */
   uint16_t len;                          /* Byte length of the descriptors */
   uint16_t cur;                          /* offset for current video control interface */
   uint8_t  stm[CFG_TUD_VIDEO_STREAMING]; /* Indices of streaming interface */
@@ -140,6 +165,15 @@ static videod_interface_t _videod_itf[CFG_TUD_VIDEO];
 static videod_streaming_interface_t _videod_streaming_itf[CFG_TUD_VIDEO_STREAMING];
 CFG_TUD_MEM_SECTION static videod_streaming_epbuf_t _videod_streaming_epbuf[CFG_TUD_VIDEO_STREAMING];
 
+/* Streaming interface index + 1 of each IN endpoint number, 0 if not used by video */
+static uint8_t _videod_ep2stm[CFG_TUD_ENDPPOINT_MAX];
+
+#if CFG_TUD_VIDEO_STREAMING_TIMESTAMP
+/* source clock reference latched at the latest SOF */
+static volatile uint32_t _videod_scr_stc;
+static volatile uint16_t _videod_scr_sof;
+#endif
+
 static uint8_t const _cap_get     = 0x1u; /* support for GET */
 static uint8_t const _cap_get_set = 0x3u; /* support for GET and SET */
 
@@ -422,6 +456,55 @@ static inline void const *_find_desc_frame(void const *beg, void const *end, uin
   return end;
 }
 
+/** Largest packet size of isochronous endpoints among alternate settings, 0 if streaming via bulk endpoint
+ *
+ * @param[out] per_ms   Number of service intervals of the endpoint per millisecond */
+static uint_fast16_t _get_iso_max_packet_size(videod_streaming_interface_t const *stm, uint_fast8_t *per_ms)
+{
+  uint8_t const *desc = _videod_itf[stm->index_vc].beg;
+  void const *end = desc + stm->desc.end;
+  uint_fast16_t max_size = 0;
+  *per_ms = 1;
+  for (void const *cur = desc + stm->desc.beg; cur < end; cur = tu_desc_next(cur)) {
+    if (TUSB_DESC_ENDPOINT != tu_desc_type(cur)) continue;
+    tusb_desc_endpoint_t const *ep = (tusb_desc_endpoint_t const*)cur;
+    if (TUSB_XFER_ISOCHRONOUS != ep->bmAttributes.xfer || tu_edpt_packet_size(ep) <= max_size) continue;
+    max_size = tu_edpt_packet_size(ep);
+    /* high speed service interval is 2^(bInterval-1) microframes */
+    if ((TUSB_SPEED_HIGH == tud_speed_get()) && ep->bInterval && (ep->bInterval < 4)) {
+      *per_ms = (uint_fast8_t) (8u >> (ep->bInterval - 1));
+    } else {
+      *per_ms = 1;
+    }
+  }
+  return max_size;
+}
+
+/** Payload size to carry a frame within the frame interval
+ *
+ * A payload is sent every millisecond, or every service interval of isochronous endpoint at high speed s.t. the host
+ * can select the smallest sufficient alternate setting. Limited to the largest isochronous packet size. */
+static uint_fast32_t _calc_payload_size(videod_streaming_interface_t const *stm, uint_fast32_t frame_size,
+                                        uint_fast32_t interval_ms)
+{
+  uint_fast8_t per_ms;
+  uint_fast32_t const iso_max = _get_iso_max_packet_size(stm, &per_ms);
+  uint_fast32_t payload_size;
+  if (!interval_ms) {
+    payload_size = frame_size + TUD_VIDEO_PAYLOAD_HEADER_LEN;
+  } else {
+    uint_fast32_t const num = interval_ms * per_ms;
+    payload_size = (frame_size + num - 1) / num + TUD_VIDEO_PAYLOAD_HEADER_LEN;
+  }
+  if (CFG_TUD_VIDEO_STREAMING_EP_BUFSIZE < payload_size) {
+    payload_size = CFG_TUD_VIDEO_STREAMING_EP_BUFSIZE;
+  }
+  if (iso_max && iso_max < payload_size) {
+    payload_size = iso_max;
+  }
+  return payload_size;
+}
+
 /** Set uniquely determined values to variables that have not been set
  *
  * @param[in,out] param       Target */
@@ -511,11 +594,7 @@ static bool _update_streaming_parameters(videod_streaming_interface_t const *stm
   }
   uint_fast32_t interval_ms = interval / 10000;
   TU_ASSERT(interval_ms);
-  uint_fast32_t payload_size = (frame_size + interval_ms - 1) / interval_ms + 2;
-  if (CFG_TUD_VIDEO_STREAMING_EP_BUFSIZE < payload_size) {
-    payload_size = CFG_TUD_VIDEO_STREAMING_EP_BUFSIZE;
-  }
-  param->dwMaxPayloadTransferSize = payload_size;
+  param->dwMaxPayloadTransferSize = _calc_payload_size(stm, frame_size, interval_ms);
   return true;
 }
 
@@ -667,17 +746,7 @@ static bool _negotiate_streaming_parameters(videod_streaming_interface_t const *
     if (!interval) {
       param->dwMaxPayloadTransferSize = 0;
     } else {
-      uint_fast32_t frame_size = param->dwMaxVideoFrameSize;
-      uint_fast32_t payload_size;
-      if (!interval_ms) {
-        payload_size = frame_size + 2;
-      } else {
-        payload_size = (frame_size + interval_ms - 1) / interval_ms + 2;
-      }
-      if (CFG_TUD_VIDEO_STREAMING_EP_BUFSIZE < payload_size) {
-        payload_size = CFG_TUD_VIDEO_STREAMING_EP_BUFSIZE;
-      }
-      param->dwMaxPayloadTransferSize = payload_size;
+      param->dwMaxPayloadTransferSize = _calc_payload_size(stm, param->dwMaxVideoFrameSize, interval_ms);
     }
     return true;
   }
@@ -777,6 +846,7 @@ static bool _open_vs_itf(uint8_t rhport, videod_streaming_interface_t *stm, uint
     /* Only ISO endpoints needs to be closed */
     if(ep->bmAttributes.xfer == TUSB_XFER_ISOCHRONOUS) {
       stm->desc.ep[i] = 0;
+      _videod_ep2stm[tu_edpt_number(ep->bEndpointAddress)] = 0;
       usbd_edpt_close(rhport, ep->bEndpointAddress);
       TU_LOG_DRV("    close EP%02x\r\n", ep->bEndpointAddress);
     }
@@ -787,11 +857,20 @@ static bool _open_vs_itf(uint8_t rhport, videod_streaming_interface_t *stm, uint
   stm->buffer  = NULL;
   stm->bufsize = 0;
   stm->offset  = 0;
+  stm->xfer_pending = 0;
+  stm->xfer_idx = 0;
+  stm->in_frame = false;
+#if CFG_TUD_VIDEO_STREAMING_PACING
+  stm->pace_hold = false;
+#endif
 
   /* Find a alternate interface */
   uint8_t const *beg = desc + stm->desc.beg;
   uint8_t const *end = desc + stm->desc.end;
-  uint8_t const *cur = _find_desc_itf(beg, end, _desc_itfnum(beg), altnum);
+  uint8_t const *cur = (uint8_t const *) usbd_find_interface_desc(rhport, _desc_itfnum(beg), (uint8_t) altnum);
+  if (!cur || cur < beg || cur >= end) {
+    cur = _find_desc_itf(beg, end, _desc_itfnum(beg), altnum);
+  }
   TU_VERIFY(cur < end);
 
   uint_fast8_t numeps = ((tusb_desc_interface_t const *)cur)->bNumEndpoints;
@@ -819,6 +898,7 @@ static bool _open_vs_itf(uint8_t rhport, videod_streaming_interface_t *stm, uint
       TU_ASSERT(usbd_edpt_open(rhport, ep));
     }
     stm->desc.ep[i] = (uint16_t) (cur - desc);
+    _videod_ep2stm[tu_edpt_number(ep->bEndpointAddress)] = (uint8_t) (stm - _videod_streaming_itf + 1);
     TU_LOG_DRV("    open EP%02x\r\n", _desc_ep_addr(cur));
   }
   if (altnum) {
@@ -828,24 +908,110 @@ static bool _open_vs_itf(uint8_t rhport, videod_streaming_interface_t *stm, uint
   return true;
 }
 
-/** Prepare the next packet payload. */
-static uint_fast16_t _prepare_in_payload(videod_streaming_interface_t *stm, uint8_t* ep_buf) {
-  uint_fast16_t remaining = stm->bufsize - stm->offset;
-  uint_fast16_t hdr_len   = ep_buf[0];
-  uint_fast16_t pkt_len   = stm->max_payload_transfer_size;
-  if (hdr_len + remaining < pkt_len) {
-    pkt_len = hdr_len + remaining;
+/** Find the streaming endpoint of current settings. */
+static tusb_desc_endpoint_t const* _get_desc_stm_ep(videod_streaming_interface_t const *stm) {
+  uint_fast16_t ofs_ep = stm->desc.ep[0];
+  if (!ofs_ep) return NULL;
+  return (tusb_desc_endpoint_t const*)(_videod_itf[stm->index_vc].beg + ofs_ep);
+}
+
+/** Build payload header of the next transfer, EndOfFrame is set per payload. */
+static void _build_payload_header(videod_streaming_interface_t const *stm, uint8_t *hdr) {
+  memcpy(hdr, &stm->hdr, sizeof(tusb_video_payload_header_t));
+#if CFG_TUD_VIDEO_STREAMING_TIMESTAMP
+  usbd_int_set(false);
+  uint32_t const stc = _videod_scr_stc;
+  uint16_t const sof = _videod_scr_sof;
+  usbd_int_set(true);
+  tu_unaligned_write32(hdr + 2, tu_htole32(stm->pts));
+  tu_unaligned_write32(hdr + 6, tu_htole32(stc));
+  tu_unaligned_write16(hdr + 10, tu_htole16(sof));
+#endif
+}
+
+/** Prepare the next transfer into a staging buffer.
+ *
+ * Bulk: payloads are packed as long as they fit, a payload of dwMaxPayloadTransferSize bytes ends on packet
+ * boundary so that the host still sees each payload as a separate transfer. The last payload of a buffer is short.
+ * Isochronous: one payload per transfer i.e. (micro)frame.
+ * @return byte length of the transfer */
+static uint_fast16_t _prepare_in_xfer(videod_streaming_interface_t *stm, tusb_desc_endpoint_t const *ep, uint8_t *buf) {
+  uint_fast16_t const hdr_len = stm->hdr.bHeaderLength;
+  uint_fast32_t const pld_max = stm->max_payload_transfer_size;
+  bool const pack = (TUSB_XFER_BULK == ep->bmAttributes.xfer) && !(pld_max % tu_edpt_packet_size(ep));
+  TU_ASSERT(pld_max > hdr_len, 0);
+  uint8_t hdr_tmpl[TUD_VIDEO_PAYLOAD_HEADER_LEN];
+  _build_payload_header(stm, hdr_tmpl);
+
+  uint_fast16_t xfer_len = 0;
+  do {
+    uint_fast32_t const remaining = stm->bufsize - stm->offset;
+    uint_fast32_t const data_len = tu_min32(remaining, pld_max - hdr_len);
+    tusb_video_payload_header_t *hdr = (tusb_video_payload_header_t*) &buf[xfer_len];
+    memcpy(hdr, hdr_tmpl, hdr_len);
+    if (data_len == remaining && stm->eof) {
+      hdr->EndOfFrame = 1;
+    }
+    memcpy(&buf[xfer_len + hdr_len], stm->buffer + stm->offset, data_len);
+    stm->offset += data_len;
+    xfer_len += (uint_fast16_t) (hdr_len + data_len);
+  } while (pack && stm->offset < stm->bufsize && xfer_len + pld_max <= CFG_TUD_VIDEO_STREAMING_XFER_BUFSIZE);
+
+  return xfer_len;
+}
+
+/** Prepare the next transfer straight from a frame buffer laid out as payloads with header headroom.
+ *
+ * Headers are written into the headroom. Bulk: as many payloads as fit in a transfer if they end on packet boundary.
+ * Isochronous: one payload per transfer.
+ * @return byte length of the transfer */
+static uint_fast16_t _prepare_in_xfer_inplace(videod_streaming_interface_t *stm, tusb_desc_endpoint_t const *ep, uint8_t **buf) {
+  uint_fast16_t const hdr_len = stm->hdr.bHeaderLength;
+  uint_fast32_t const pld_max = stm->max_payload_transfer_size;
+  bool const pack = (TUSB_XFER_BULK == ep->bmAttributes.xfer) && !(pld_max % tu_edpt_packet_size(ep));
+  TU_ASSERT(pld_max > hdr_len, 0);
+  uint8_t hdr_tmpl[TUD_VIDEO_PAYLOAD_HEADER_LEN];
+  _build_payload_header(stm, hdr_tmpl);
+
+  uint_fast32_t const xfer_max = pack ? (UINT16_MAX / pld_max) * pld_max : pld_max;
+  uint_fast32_t const xfer_len = tu_min32(stm->bufsize - stm->offset, xfer_max);
+  *buf = stm->buffer + stm->offset;
+  for (uint_fast32_t ofs = 0; ofs < xfer_len; ofs += pld_max) {
+    tusb_video_payload_header_t *hdr = (tusb_video_payload_header_t*) (*buf + ofs);
+    memcpy(hdr, hdr_tmpl, hdr_len);
+    if (stm->offset + ofs + pld_max >= stm->bufsize && stm->eof) {
+      hdr->EndOfFrame = 1;
+    }
   }
-  TU_ASSERT(pkt_len >= hdr_len);
-  uint_fast16_t data_len = pkt_len - hdr_len;
-  memcpy(&ep_buf[hdr_len], stm->buffer + stm->offset, data_len);
-  stm->offset += data_len;
-  remaining -= data_len;
-  if (!remaining) {
-    tusb_video_payload_header_t *hdr = (tusb_video_payload_header_t*) ep_buf;
-    hdr->EndOfFrame = 1;
+  stm->offset += xfer_len;
+
+  return (uint_fast16_t) xfer_len;
+}
+
+/** Submit transfers of the current frame: one at a time, or with ping-pong one on the wire and one queued. */
+static bool _submit_in_xfer(uint8_t rhport, videod_streaming_interface_t *stm, videod_streaming_epbuf_t *stm_epbuf) {
+  tusb_desc_endpoint_t const *ep = _get_desc_stm_ep(stm);
+  TU_VERIFY(ep);
+  uint8_t const ep_addr = ep->bEndpointAddress;
+
+#if CFG_TUD_VIDEO_STREAMING_PINGPONG
+  while (stm->offset < stm->bufsize && usbd_edpt_xfer_queue_available(rhport, ep_addr)) {
+    uint8_t *buf = stm->xfer_idx ? stm_epbuf->buf_alt : stm_epbuf->buf;
+    uint_fast16_t xfer_len = stm->inplace ? _prepare_in_xfer_inplace(stm, ep, &buf) : _prepare_in_xfer(stm, ep, buf);
+    TU_ASSERT(xfer_len && usbd_edpt_xfer_queue(rhport, ep_addr, buf, (uint16_t) xfer_len));
+    stm->xfer_idx ^= 1;
+    stm->xfer_pending++;
   }
-  return hdr_len + data_len;
+  TU_VERIFY(stm->xfer_pending);
+#else
+  TU_VERIFY(usbd_edpt_claim(rhport, ep_addr));
+  uint8_t *buf = stm_epbuf->buf;
+  uint_fast16_t xfer_len = stm->inplace ? _prepare_in_xfer_inplace(stm, ep, &buf) : _prepare_in_xfer(stm, ep, buf);
+  TU_ASSERT(xfer_len && usbd_edpt_xfer(rhport, ep_addr, buf, (uint16_t) xfer_len));
+  stm->xfer_pending++;
+#endif
+
+  return true;
 }
 
 /** Handle a standard request to the video control interface. */
@@ -1014,7 +1180,6 @@ static int handle_video_stm_cs_req(uint8_t rhport, uint8_t stage,
                                    uint_fast8_t stm_idx) {
   (void)rhport;
   videod_streaming_interface_t *stm = &_videod_streaming_itf[stm_idx];
-  videod_streaming_epbuf_t *stm_epbuf = &_videod_streaming_epbuf[stm_idx];
 
   uint8_t const ctrl_sel = TU_U16_HIGH(request->wValue);
   TU_LOG_DRV("%s_Control(%s)\r\n", tu_str_video_vs_control_selector[ctrl_sel], tu_lookup_find(&tu_table_video_request, request->bRequest));
@@ -1113,10 +1278,23 @@ static int handle_video_stm_cs_req(uint8_t rhport, uint8_t stage,
               stm->buffer  = NULL;
               stm->bufsize = 0;
               stm->offset  = 0;
+              stm->in_frame = false;
               /* initialize payload header */
-              tusb_video_payload_header_t *hdr = (tusb_video_payload_header_t*)stm_epbuf->buf;
-              hdr->bHeaderLength = sizeof(*hdr);
-              hdr->bmHeaderInfo  = 0;
+              stm->hdr.bHeaderLength = TUD_VIDEO_PAYLOAD_HEADER_LEN;
+              stm->hdr.bmHeaderInfo  = 0;
+#if CFG_TUD_VIDEO_STREAMING_TIMESTAMP
+              stm->hdr.PresentationTime     = 1;
+              stm->hdr.SourceClockReference = 1;
+#endif
+#if CFG_TUD_VIDEO_STREAMING_PACING
+              stm->pace_hold      = false;
+              stm->pace_due       = true;
+              stm->pace_sof_valid = false;
+              stm->pace_elapsed   = 0;
+#endif
+#if CFG_TUD_VIDEO_STREAMING_TIMESTAMP || CFG_TUD_VIDEO_STREAMING_PACING
+              usbd_sof_enable(rhport, SOF_CONSUMER_VIDEO, true);
+#endif
             }
           }
           return VIDEO_ERROR_NONE;
@@ -1212,41 +1390,109 @@ bool tud_video_n_streaming(uint_fast8_t ctl_idx, uint_fast8_t stm_idx)
   return true;
 }
 
-bool tud_video_n_frame_xfer(uint_fast8_t ctl_idx, uint_fast8_t stm_idx, void *buffer, size_t bufsize) {
+#if CFG_TUD_VIDEO_STREAMING_PACING
+/** Submit the held frame if its interval has elapsed */
+static void _release_frame(videod_streaming_interface_t *stm) {
+  if (!stm->pace_hold || !stm->pace_due) return;
+  stm->pace_hold = false;
+  stm->pace_due  = false;
+  if (!_submit_in_xfer(_videod_itf[stm->index_vc].rhport, stm, &_videod_streaming_epbuf[stm - _videod_streaming_itf])) {
+    stm->buffer  = NULL;
+    stm->bufsize = 0;
+  }
+}
+
+/** Deferred from SOF ISR to usbd task */
+static void _release_frames(void *param) {
+  (void) param;
+  for (uint_fast8_t i = 0; i < CFG_TUD_VIDEO_STREAMING; ++i) {
+    _release_frame(&_videod_streaming_itf[i]);
+  }
+}
+#endif
+
+static bool _frame_xfer(uint_fast8_t ctl_idx, uint_fast8_t stm_idx, void *buffer, size_t bufsize, bool inplace, bool eof) {
   TU_ASSERT(ctl_idx < CFG_TUD_VIDEO);
   TU_ASSERT(stm_idx < CFG_TUD_VIDEO_STREAMING);
 
   if (!buffer || !bufsize) return false;
   videod_streaming_interface_t *stm = _get_instance_streaming(ctl_idx, stm_idx);
-  videod_streaming_epbuf_t *stm_epbuf = &_videod_streaming_epbuf[ctl_idx];
 
   if (!stm || !stm->desc.ep[0] || stm->buffer) return false;
   if (stm->state == VS_STATE_PROBING) return false;
+  videod_streaming_epbuf_t *stm_epbuf = &_videod_streaming_epbuf[stm - _videod_streaming_itf];
 
-  /* Find EP address */
-  uint8_t const *desc = _videod_itf[stm->index_vc].beg;
-  uint8_t ep_addr = 0;
-  for (uint_fast8_t i = 0; i < CFG_TUD_VIDEO_STREAMING; ++i) {
-    uint_fast16_t ofs_ep = stm->desc.ep[i];
-    if (!ofs_ep) continue;
-    ep_addr = _desc_ep_addr(desc + ofs_ep);
-    break;
+  if (inplace) {
+    /* Last payload must carry data after its header */
+    uint_fast32_t const last = bufsize % stm->max_payload_transfer_size;
+    TU_VERIFY(!last || last > stm->hdr.bHeaderLength);
   }
-  if (!ep_addr) return false;
 
-  TU_VERIFY( usbd_edpt_claim(0, ep_addr) );
-  /* update the packet header */
-  tusb_video_payload_header_t *hdr = (tusb_video_payload_header_t*)stm_epbuf->buf;
-  hdr->FrameID   ^= 1;
-  hdr->EndOfFrame = 0;
+  /* update the packet header, FrameID toggles at the first part of a frame */
+  if (!stm->in_frame) {
+    stm->hdr.FrameID ^= 1;
+#if CFG_TUD_VIDEO_STREAMING_TIMESTAMP
+    stm->pts     = stm->pts_set ? stm->pts_next : tud_video_stc_cb();
+    stm->pts_set = false;
+#endif
+  }
+  stm->hdr.EndOfFrame = 0;
   /* update the packet data */
   stm->buffer     = (uint8_t*)buffer;
   stm->bufsize    = bufsize;
-  uint_fast16_t pkt_len = _prepare_in_payload(stm, stm_epbuf->buf);
-  TU_ASSERT( usbd_edpt_xfer(0, ep_addr, stm_epbuf->buf, (uint16_t) pkt_len), 0);
+  stm->offset     = 0;
+  stm->inplace    = inplace;
+  stm->eof        = eof;
+#if CFG_TUD_VIDEO_STREAMING_PACING
+  if (!stm->in_frame) {
+    /* first part of a frame waits for the frame interval, following slices go out as they come */
+    stm->pace_hold = true;
+    stm->in_frame  = !eof;
+    _release_frame(stm);
+    return true;
+  }
+#endif
+  if (!_submit_in_xfer(_videod_itf[stm->index_vc].rhport, stm, stm_epbuf)) {
+    stm->buffer  = NULL;
+    stm->bufsize = 0;
+    return false;
+  }
+  stm->in_frame = !eof;
   return true;
 }
 
+bool tud_video_n_frame_xfer(uint_fast8_t ctl_idx, uint_fast8_t stm_idx, void *buffer, size_t bufsize) {
+  return _frame_xfer(ctl_idx, stm_idx, buffer, bufsize, false, true);
+}
+
+bool tud_video_n_frame_xfer_inplace(uint_fast8_t ctl_idx, uint_fast8_t stm_idx, void *buffer, size_t bufsize) {
+  return _frame_xfer(ctl_idx, stm_idx, buffer, bufsize, true, true);
+}
+
+bool tud_video_n_slice_xfer(uint_fast8_t ctl_idx, uint_fast8_t stm_idx, void *buffer, size_t bufsize, bool end_of_frame) {
+  return _frame_xfer(ctl_idx, stm_idx, buffer, bufsize, false, end_of_frame);
+}
+
+#if CFG_TUD_VIDEO_STREAMING_TIMESTAMP
+bool tud_video_n_frame_set_pts(uint_fast8_t ctl_idx, uint_fast8_t stm_idx, uint32_t pts) {
+  TU_ASSERT(ctl_idx < CFG_TUD_VIDEO);
+  TU_ASSERT(stm_idx < CFG_TUD_VIDEO_STREAMING);
+  videod_streaming_interface_t *stm = _get_instance_streaming(ctl_idx, stm_idx);
+  if (!stm) return false;
+  stm->pts_next = pts;
+  stm->pts_set  = true;
+  return true;
+}
+#endif
+
+uint32_t tud_video_n_payload_size(uint_fast8_t ctl_idx, uint_fast8_t stm_idx) {
+  TU_ASSERT(ctl_idx < CFG_TUD_VIDEO, 0);
+  TU_ASSERT(stm_idx < CFG_TUD_VIDEO_STREAMING, 0);
+  videod_streaming_interface_t *stm = _get_instance_streaming(ctl_idx, stm_idx);
+  if (!stm || stm->state == VS_STATE_PROBING) return 0;
+  return stm->max_payload_transfer_size;
+}
+
 //--------------------------------------------------------------------+
 // USBD Driver API
 //--------------------------------------------------------------------+
@@ -1266,15 +1512,25 @@ bool videod_deinit(void) {
 }
 
 void videod_reset(uint8_t rhport) {
-  (void) rhport;
-  for (uint_fast8_t i = 0; i < CFG_TUD_VIDEO; ++i) {
-    videod_interface_t* ctl = &_videod_itf[i];
-    tu_memclr(ctl, sizeof(*ctl));
+#if CFG_TUD_VIDEO_STREAMING_TIMESTAMP || CFG_TUD_VIDEO_STREAMING_PACING
+  usbd_sof_enable(rhport, SOF_CONSUMER_VIDEO, false);
+#endif
+  /* interfaces opened on other root port are kept */
+  for (uint_fast8_t i = 0; i < sizeof(_videod_ep2stm); ++i) {
+    if (_videod_ep2stm[i] && _videod_itf[_videod_streaming_itf[_videod_ep2stm[i] - 1u].index_vc].rhport == rhport) {
+      _videod_ep2stm[i] = 0;
+    }
   }
   for (uint_fast8_t i = 0; i < CFG_TUD_VIDEO_STREAMING; ++i) {
     videod_streaming_interface_t *stm = &_videod_streaming_itf[i];
+    if (stm->desc.beg && _videod_itf[stm->index_vc].rhport != rhport) continue;
     tu_memclr(stm, sizeof(videod_streaming_interface_t));
   }
+  for (uint_fast8_t i = 0; i < CFG_TUD_VIDEO; ++i) {
+    videod_interface_t* ctl = &_videod_itf[i];
+    if (ctl->beg && ctl->rhport != rhport) continue;
+    tu_memclr(ctl, sizeof(*ctl));
+  }
 }
 
 uint16_t videod_open(uint8_t rhport, tusb_desc_interface_t const * itf_desc, uint16_t max_len) {
@@ -1294,6 +1550,7 @@ uint16_t videod_open(uint8_t rhport, tusb_desc_interface_t const * itf_desc, uin
 
   uint8_t const *end = (uint8_t const*)itf_desc + max_len;
   self->beg = (uint8_t const*) itf_desc;
+  self->rhport = rhport;
   self->len = max_len;
 
   /*------------- Video Control Interface -------------*/
@@ -1362,7 +1619,7 @@ bool videod_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_
   uint_fast8_t itf;
   for (itf = 0; itf < CFG_TUD_VIDEO; ++itf) {
     void const *desc = _videod_itf[itf].beg;
-    if (!desc) continue;
+    if (!desc || _videod_itf[itf].rhport != rhport) continue;
     if (itfnum == _desc_itfnum(desc)) break;
   }
 
@@ -1377,7 +1634,7 @@ bool videod_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_
   /* Identify which streaming interface to use */
   for (itf = 0; itf < CFG_TUD_VIDEO_STREAMING; ++itf) {
     videod_streaming_interface_t *stm = &_videod_streaming_itf[itf];
-    if (!stm->desc.beg) continue;
+    if (!stm->desc.beg || _videod_itf[stm->index_vc].rhport != rhport) continue;
     uint8_t const *desc = _videod_itf[stm->index_vc].beg;
     if (itfnum == _desc_itfnum(desc + stm->desc.beg)) break;
   }
@@ -1396,34 +1653,75 @@ bool videod_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint3
   (void)result; (void)xferred_bytes;
 
   /* find streaming handle */
-  uint_fast8_t itf;
-  videod_interface_t *ctl;
-  videod_streaming_interface_t *stm;
-  for (itf = 0; itf < CFG_TUD_VIDEO_STREAMING; ++itf) {
-    stm = &_videod_streaming_itf[itf];
-    uint_fast16_t const ep_ofs = stm->desc.ep[0];
-    if (!ep_ofs) continue;
-    ctl = &_videod_itf[stm->index_vc];
-    uint8_t const *desc = ctl->beg;
-    if (ep_addr == _desc_ep_addr(desc + ep_ofs)) break;
-  }
-  TU_ASSERT(itf < CFG_TUD_VIDEO_STREAMING);
+#if CFG_TUD_VIDEO_STREAMING == 1
+  /* single streaming interface: only its endpoint is used for transfer */
+  (void) ep_addr;
+  uint_fast8_t const itf = 0;
+#else
+  uint_fast8_t const epnum = tu_edpt_number(ep_addr);
+  TU_ASSERT(epnum < CFG_TUD_ENDPPOINT_MAX && _videod_ep2stm[epnum]);
+  uint_fast8_t const itf = (uint_fast8_t) (_videod_ep2stm[epnum] - 1u);
+#endif
+  videod_streaming_interface_t *stm = &_videod_streaming_itf[itf];
   videod_streaming_epbuf_t *stm_epbuf = &_videod_streaming_epbuf[itf];
 
+  /* Transfer of a cancelled frame e.g. by set interface */
+  if (!stm->xfer_pending) return true;
+  stm->xfer_pending--;
+
   if (stm->offset < stm->bufsize) {
-    /* Claim the endpoint */
-    TU_VERIFY( usbd_edpt_claim(rhport, ep_addr), 0);
-    uint_fast16_t pkt_len = _prepare_in_payload(stm, stm_epbuf->buf);
-    TU_ASSERT( usbd_edpt_xfer(rhport, ep_addr, stm_epbuf->buf, (uint16_t) pkt_len), 0);
-  } else {
+    TU_ASSERT(_submit_in_xfer(rhport, stm, stm_epbuf));
+  } else if (!stm->xfer_pending) {
     stm->buffer  = NULL;
     stm->bufsize = 0;
     stm->offset  = 0;
-    if (tud_video_frame_xfer_complete_cb) {
+    if (!stm->eof) {
+      if (tud_video_slice_xfer_complete_cb) {
+        tud_video_slice_xfer_complete_cb(stm->index_vc, stm->index_vs);
+      }
+    } else if (tud_video_frame_xfer_complete_cb) {
       tud_video_frame_xfer_complete_cb(stm->index_vc, stm->index_vs);
     }
   }
   return true;
 }
 
+#if CFG_TUD_VIDEO_STREAMING_TIMESTAMP || CFG_TUD_VIDEO_STREAMING_PACING
+TU_ATTR_FAST_FUNC void videod_sof_isr(uint8_t rhport, uint32_t frame_count) {
+  (void) rhport;
+  uint16_t const sof = (uint16_t) (frame_count & 0x7FFu);
+#if CFG_TUD_VIDEO_STREAMING_TIMESTAMP
+  _videod_scr_stc = tud_video_stc_cb();
+  _videod_scr_sof = sof;
+#endif
+#if CFG_TUD_VIDEO_STREAMING_PACING
+  bool release = false;
+  for (uint_fast8_t i = 0; i < CFG_TUD_VIDEO_STREAMING; ++i) {
+    videod_streaming_interface_t *stm = &_videod_streaming_itf[i];
+    if (VS_STATE_PROBING == stm->state) continue;
+    if (stm->pace_sof_valid) {
+      if (stm->pace_due) {
+        /* application is late, next interval starts at release */
+        stm->pace_elapsed = 0;
+      } else {
+        /* frame number is 11 bit, stays the same across microframes */
+        stm->pace_elapsed += ((uint32_t) (sof - stm->pace_sof) & 0x7FFu) * 10000u;
+        uint32_t const interval = stm->probe_commit_payload.dwFrameInterval;
+        if (stm->pace_elapsed >= interval) {
+          stm->pace_elapsed -= interval;
+          stm->pace_due      = true;
+        }
+      }
+      release |= stm->pace_due && stm->pace_hold;
+    }
+    stm->pace_sof       = sof;
+    stm->pace_sof_valid = true;
+  }
+  if (release) {
+    usbd_defer_func(_release_frames, NULL, true);
+  }
+#endif
+}
+#endif
+
 #endif
@@ -35,6 +35,38 @@
 extern "C" {
 #endif
 
+//--------------------------------------------------------------------+
+// Class Driver Configuration
+//--------------------------------------------------------------------+
+
+// Staging buffer of a streaming interface. For bulk, several payloads (header + frame data) are packed in one transfer
+// if payload size is a multiple of endpoint packet size. An isochronous transfer carries one payload per (micro)frame
+#ifndef CFG_TUD_VIDEO_STREAMING_XFER_BUFSIZE
+#define CFG_TUD_VIDEO_STREAMING_XFER_BUFSIZE   CFG_TUD_VIDEO_STREAMING_EP_BUFSIZE
+#endif
+
+// Double-buffered streaming: next transfer is prepared and queued while the previous is on the wire, s.t. isochronous
+// payloads go out every (micro)frame without waiting for usbd task. Require CFG_TUD_EDPT_XFER_QUEUE, staging buffer is doubled
+#ifndef CFG_TUD_VIDEO_STREAMING_PINGPONG
+#define CFG_TUD_VIDEO_STREAMING_PINGPONG       0
+#endif
+
+#if CFG_TUD_VIDEO_STREAMING_PINGPONG && !CFG_TUD_EDPT_XFER_QUEUE
+  #error "CFG_TUD_VIDEO_STREAMING_PINGPONG requires CFG_TUD_EDPT_XFER_QUEUE"
+#endif
+
+// Payload headers carry presentation time (PTS) and source clock reference (SCR). Source time clock is sampled by
+// tud_video_stc_cb() at every SOF together with the SOF frame number. Payload header grows from 2 to 12 bytes
+#ifndef CFG_TUD_VIDEO_STREAMING_TIMESTAMP
+#define CFG_TUD_VIDEO_STREAMING_TIMESTAMP      0
+#endif
+
+// Frames are released at the committed dwFrameInterval measured by SOF: a frame submitted early is held by the driver
+// until its interval has elapsed, instead of being sent as fast as the bus allows
+#ifndef CFG_TUD_VIDEO_STREAMING_PACING
+#define CFG_TUD_VIDEO_STREAMING_PACING         0
+#endif
+
 //--------------------------------------------------------------------+
 // Application API (Multiple Ports)
 // CFG_TUD_VIDEO > 1
@@ -56,6 +88,58 @@ bool tud_video_n_streaming(uint_fast8_t ctl_idx, uint_fast8_t stm_idx);
  * @param[in] bufsize    Byte size of the frame buffer */
 bool tud_video_n_frame_xfer(uint_fast8_t ctl_idx, uint_fast8_t stm_idx, void *buffer, size_t bufsize);
 
+/** Transfer a part of a frame
+ *
+ * Slices are sent in order as they are produced, so that the application does not have to hold a whole frame. The
+ * driver toggles FrameID at the first slice of a frame and sets EndOfFrame on the last payload of the slice submitted
+ * with end_of_frame. Each slice ends with a short payload, a slice should be a multiple of
+ * (tud_video_n_payload_size() - TUD_VIDEO_PAYLOAD_HEADER_LEN) bytes to keep payloads full.
+ * Next slice can be submitted after tud_video_slice_xfer_complete_cb(), or tud_video_frame_xfer_complete_cb() for
+ * the last slice of a frame.
+ *
+ * @param[in] ctl_idx      Destination control interface index
+ * @param[in] stm_idx      Destination streaming interface index
+ * @param[in] buffer       Slice buffer. The caller must not use this buffer until the operation is completed.
+ * @param[in] bufsize      Byte size of the slice buffer
+ * @param[in] end_of_frame True if this is the last slice of the frame */
+bool tud_video_n_slice_xfer(uint_fast8_t ctl_idx, uint_fast8_t stm_idx, void *buffer, size_t bufsize, bool end_of_frame);
+
+/** Length of payload header written by the driver */
+#if CFG_TUD_VIDEO_STREAMING_TIMESTAMP
+#define TUD_VIDEO_PAYLOAD_HEADER_LEN  12
+#else
+#define TUD_VIDEO_PAYLOAD_HEADER_LEN  sizeof(tusb_video_payload_header_t)
+#endif
+
+/** Transfer a frame without copying it
+ *
+ * Frame buffer is laid out as consecutive payloads of tud_video_n_payload_size() bytes, each starting with
+ * TUD_VIDEO_PAYLOAD_HEADER_LEN bytes of headroom filled by the driver, the last payload may be shorter. Buffer is
+ * transferred by endpoint DMA directly, it must meet the requirements of endpoint buffers (e.g CFG_TUD_MEM_SECTION
+ * and CFG_TUD_MEM_ALIGN) and payload size should be a multiple of the alignment.
+ *
+ * @param[in] ctl_idx    Destination control interface index
+ * @param[in] stm_idx    Destination streaming interface index
+ * @param[in] buffer     Frame buffer with header headroom. The caller must not use this buffer until the operation is completed.
+ * @param[in] bufsize    Byte size of the frame buffer including headroom */
+bool tud_video_n_frame_xfer_inplace(uint_fast8_t ctl_idx, uint_fast8_t stm_idx, void *buffer, size_t bufsize);
+
+/** Return negotiated payload size (dwMaxPayloadTransferSize) including header, 0 if not committed
+ *
+ * @param[in] ctl_idx    Destination control interface index
+ * @param[in] stm_idx    Destination streaming interface index */
+uint32_t tud_video_n_payload_size(uint_fast8_t ctl_idx, uint_fast8_t stm_idx);
+
+#if CFG_TUD_VIDEO_STREAMING_TIMESTAMP
+/** Set presentation time of the next frame e.g. its capture time
+ *
+ * If not set, the source time clock at submission of the first part of the frame is used.
+ * @param[in] ctl_idx    Destination control interface index
+ * @param[in] stm_idx    Destination streaming interface index
+ * @param[in] pts        Presentation time in the units of tud_video_stc_cb() */
+bool tud_video_n_frame_set_pts(uint_fast8_t ctl_idx, uint_fast8_t stm_idx, uint32_t pts);
+#endif
+
 /*------------- Optional callbacks -------------*/
 /** Invoked when compeletion of a frame transfer
  *
@@ -63,6 +147,12 @@ bool tud_video_n_frame_xfer(uint_fast8_t ctl_idx, uint_fast8_t stm_idx, void *bu
  * @param[in] stm_idx    Destination streaming interface index */
 TU_ATTR_WEAK void tud_video_frame_xfer_complete_cb(uint_fast8_t ctl_idx, uint_fast8_t stm_idx);
 
+/** Invoked when compeletion of a slice transfer which does not end the frame
+ *
+ * @param[in] ctl_idx    Destination control interface index
+ * @param[in] stm_idx    Destination streaming interface index */
+TU_ATTR_WEAK void tud_video_slice_xfer_complete_cb(uint_fast8_t ctl_idx, uint_fast8_t stm_idx);
+
 //--------------------------------------------------------------------+
 // Application Callback API (weak is optional)
 //--------------------------------------------------------------------+
@@ -83,6 +173,13 @@ TU_ATTR_WEAK int tud_video_power_mode_cb(uint_fast8_t ctl_idx, uint8_t power_mod
 TU_ATTR_WEAK int tud_video_commit_cb(uint_fast8_t ctl_idx, uint_fast8_t stm_idx,
                                      video_probe_and_commit_control_t const *parameters);
 
+#if CFG_TUD_VIDEO_STREAMING_TIMESTAMP
+/** Invoked in SOF ISR to sample the source time clock, required if CFG_TUD_VIDEO_STREAMING_TIMESTAMP is enabled
+ *
+ * @return free running device clock counter in units of dwClockFrequency of the committed parameters */
+TU_ATTR_FAST_FUNC uint32_t tud_video_stc_cb(void);
+#endif
+
 //--------------------------------------------------------------------+
 // INTERNAL USBD-CLASS DRIVER API
 //--------------------------------------------------------------------+
@@ -92,6 +189,7 @@ void     videod_reset          (uint8_t rhport);
 uint16_t videod_open           (uint8_t rhport, tusb_desc_interface_t const * itf_desc, uint16_t max_len);
 bool     videod_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t const * request);
 bool     videod_xfer_cb        (uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes);
+void     videod_sof_isr        (uint8_t rhport, uint32_t frame_count);
 
 #ifdef __cplusplus
  }
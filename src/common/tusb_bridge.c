@@ -0,0 +1,267 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#include "tusb_option.h"
+
+#if CFG_TUSB_BRIDGE
+
+#include "tusb.h"
+#include "tusb_bridge.h"
+
+#if CFG_TUD_ENABLED
+  #include "device/usbd_pvt.h"
+#endif
+
+#if CFG_TUH_ENABLED
+  #include "host/usbh_pvt.h"
+#endif
+
+TU_VERIFY_STATIC((CFG_TUSB_BRIDGE_DEPTH & (CFG_TUSB_BRIDGE_DEPTH - 1)) == 0 && CFG_TUSB_BRIDGE_DEPTH <= 128,
+                 "Bridge depth must be power of 2");
+
+// Slot counters are free-running: wr is only advanced by rx completion, rd by tx completion. Each side owns the slot
+// it is transferring, so that both sides can run in different tasks (usbh and usbd) without lock. Endpoint claim
+// serializes starting a transfer on the same endpoint.
+static tusb_bridge_t* _bridges[CFG_TUSB_BRIDGE];
+
+//--------------------------------------------------------------------+
+// Endpoint helper
+//--------------------------------------------------------------------+
+#if CFG_TUH_ENABLED && CFG_TUH_API_EDPT_XFER
+static void bridge_host_xfer_cb(tuh_xfer_t* xfer);
+#endif
+
+static bool bridge_edpt_claim(tusb_bridge_edpt_t const* e) {
+  if (e->is_host) {
+    #if CFG_TUH_ENABLED
+    return usbh_edpt_claim(e->hwid, e->ep_addr);
+    #endif
+  } else {
+    #if CFG_TUD_ENABLED
+    return usbd_edpt_claim(e->hwid, e->ep_addr);
+    #endif
+  }
+  return false;
+}
+
+static void bridge_edpt_release(tusb_bridge_edpt_t const* e) {
+  if (e->is_host) {
+    #if CFG_TUH_ENABLED
+    (void) usbh_edpt_release(e->hwid, e->ep_addr);
+    #endif
+  } else {
+    #if CFG_TUD_ENABLED
+    (void) usbd_edpt_release(e->hwid, e->ep_addr);
+    #endif
+  }
+}
+
+static bool bridge_edpt_xfer(tusb_bridge_t* b, tusb_bridge_edpt_t const* e, uint8_t* buf, uint16_t len) {
+  if (e->is_host) {
+    #if CFG_TUH_ENABLED && CFG_TUH_API_EDPT_XFER
+    return usbh_edpt_xfer_with_callback(e->hwid, e->ep_addr, len ? buf : NULL, len, bridge_host_xfer_cb, (uintptr_t) b);
+    #endif
+  } else {
+    #if CFG_TUD_ENABLED
+    return usbd_edpt_xfer(e->hwid, e->ep_addr, len ? buf : NULL, len);
+    #endif
+  }
+  (void) b; (void) buf; (void) len;
+  return false;
+}
+
+//--------------------------------------------------------------------+
+// Pipeline
+//--------------------------------------------------------------------+
+TU_ATTR_ALWAYS_INLINE static inline uint8_t* slot_buf(tusb_bridge_t* b, uint8_t idx) {
+  return b->buf + (uint32_t) (idx & (CFG_TUSB_BRIDGE_DEPTH - 1)) * b->slot_size;
+}
+
+// Receive into next free slot if endpoint is idle
+static void bridge_rx_kick(tusb_bridge_t* b) {
+  // free space only grows while we hold the claim, no need to check again
+  if (b->running && (uint8_t) (b->wr - b->rd) < CFG_TUSB_BRIDGE_DEPTH && bridge_edpt_claim(&b->rx)) {
+    b->rx_busy = true;
+    if (!bridge_edpt_xfer(b, &b->rx, slot_buf(b, b->wr), b->slot_size)) {
+      b->rx_busy = false;
+      bridge_edpt_release(&b->rx);
+    }
+  }
+}
+
+// Send oldest received slot (or its owed ZLP) if endpoint is idle
+static void bridge_tx_kick(tusb_bridge_t* b) {
+  if (b->running && b->wr != b->rd && bridge_edpt_claim(&b->tx)) {
+    uint8_t const idx = b->rd & (CFG_TUSB_BRIDGE_DEPTH - 1);
+    b->tx_busy = true;
+    if (!bridge_edpt_xfer(b, &b->tx, slot_buf(b, idx), b->slot[idx].len)) {
+      b->tx_busy = false;
+      bridge_edpt_release(&b->tx);
+    }
+  }
+}
+
+static void bridge_stop(tusb_bridge_t* b, xfer_result_t result) {
+  tusb_bridge_close(b);
+  tusb_bridge_stopped_cb(b, result);
+}
+
+static void bridge_rx_complete(tusb_bridge_t* b, xfer_result_t result, uint32_t xferred_bytes) {
+  b->rx_busy = false;
+  TU_VERIFY(b->running, );
+  if (result != XFER_RESULT_SUCCESS) {
+    bridge_stop(b, result);
+    return;
+  }
+
+  uint8_t const idx = b->wr & (CFG_TUSB_BRIDGE_DEPTH - 1);
+  uint16_t const len = (uint16_t) xferred_bytes;
+  b->slot[idx].len = len;
+  // transfer ended early on packet boundary (by ZLP, or short packet of a larger rx packet size)
+  b->slot[idx].zlp = len && (len < b->slot_size) && (0 == (len % b->tx.mps));
+  b->rx_bytes += len;
+  b->wr++;
+
+  bridge_tx_kick(b);
+  bridge_rx_kick(b);
+}
+
+static void bridge_tx_complete(tusb_bridge_t* b, xfer_result_t result, uint32_t xferred_bytes) {
+  b->tx_busy = false;
+  TU_VERIFY(b->running, );
+  if (result != XFER_RESULT_SUCCESS) {
+    bridge_stop(b, result);
+    return;
+  }
+
+  uint8_t const idx = b->rd & (CFG_TUSB_BRIDGE_DEPTH - 1);
+  b->tx_bytes += xferred_bytes;
+  if (b->slot[idx].zlp) {
+    // data is sent, ZLP goes next from the same slot
+    b->slot[idx].zlp = false;
+    b->slot[idx].len = 0;
+  } else {
+    b->rd++;
+  }
+
+  bridge_tx_kick(b);
+  bridge_rx_kick(b);
+}
+
+#if CFG_TUH_ENABLED && CFG_TUH_API_EDPT_XFER
+static void bridge_host_xfer_cb(tuh_xfer_t* xfer) {
+  tusb_bridge_t* b = (tusb_bridge_t*) xfer->user_data;
+  if (b->rx.is_host && b->rx.hwid == xfer->daddr && b->rx.ep_addr == xfer->ep_addr && b->rx_busy) {
+    bridge_rx_complete(b, xfer->result, xfer->actual_len);
+  } else if (b->tx.is_host && b->tx.hwid == xfer->daddr && b->tx.ep_addr == xfer->ep_addr && b->tx_busy) {
+    bridge_tx_complete(b, xfer->result, xfer->actual_len);
+  }
+}
+#endif
+
+//--------------------------------------------------------------------+
+// Application API
+//--------------------------------------------------------------------+
+TU_ATTR_WEAK void tusb_bridge_stopped_cb(tusb_bridge_t* b, xfer_result_t result) {
+  (void) b; (void) result;
+}
+
+// rx endpoint receives from bus (host IN, device OUT), tx endpoint transmits to bus (host OUT, device IN)
+static bool bridge_edpt_valid(tusb_bridge_edpt_t const* e, bool is_rx) {
+  TU_VERIFY(tu_edpt_number(e->ep_addr) && e->mps);
+  #if !(CFG_TUH_ENABLED && CFG_TUH_API_EDPT_XFER)
+  TU_VERIFY(!e->is_host);
+  #endif
+  #if !CFG_TUD_ENABLED
+  TU_VERIFY(e->is_host);
+  #endif
+  tusb_dir_t const bus_dir = (e->is_host == is_rx) ? TUSB_DIR_IN : TUSB_DIR_OUT;
+  return tu_edpt_dir(e->ep_addr) == bus_dir;
+}
+
+bool tusb_bridge_open(tusb_bridge_t* b, tusb_bridge_edpt_t const* rx, tusb_bridge_edpt_t const* tx,
+                      uint8_t* buf, uint16_t slot_size) {
+  TU_ASSERT(b && buf && slot_size && !b->running);
+  TU_ASSERT(bridge_edpt_valid(rx, true) && bridge_edpt_valid(tx, false));
+  TU_ASSERT(0 == (slot_size % rx->mps));
+
+  uint8_t i;
+  for (i = 0; i < CFG_TUSB_BRIDGE; i++) {
+    if (_bridges[i] == NULL) break;
+  }
+  TU_ASSERT(i < CFG_TUSB_BRIDGE);
+
+  tu_memclr(b, sizeof(tusb_bridge_t));
+  b->rx = *rx;
+  b->tx = *tx;
+  b->buf = buf;
+  b->slot_size = slot_size;
+  b->running = true;
+  _bridges[i] = b;
+
+  bridge_rx_kick(b);
+  return true;
+}
+
+void tusb_bridge_close(tusb_bridge_t* b) {
+  b->running = false;
+  for (uint8_t i = 0; i < CFG_TUSB_BRIDGE; i++) {
+    if (_bridges[i] == b) {
+      _bridges[i] = NULL;
+    }
+  }
+}
+
+//--------------------------------------------------------------------+
+// Internal API
+//--------------------------------------------------------------------+
+bool tu_bridge_device_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes) {
+  for (uint8_t i = 0; i < CFG_TUSB_BRIDGE; i++) {
+    tusb_bridge_t* b = _bridges[i];
+    if (b == NULL) continue;
+
+    if (!b->rx.is_host && b->rx.hwid == rhport && b->rx.ep_addr == ep_addr && b->rx_busy) {
+      bridge_rx_complete(b, result, xferred_bytes);
+      return true;
+    }
+    if (!b->tx.is_host && b->tx.hwid == rhport && b->tx.ep_addr == ep_addr && b->tx_busy) {
+      bridge_tx_complete(b, result, xferred_bytes);
+      return true;
+    }
+  }
+  return false;
+}
+
+void tu_bridge_dev_close(bool is_host, uint8_t hwid) {
+  for (uint8_t i = 0; i < CFG_TUSB_BRIDGE; i++) {
+    tusb_bridge_t* b = _bridges[i];
+    if (b && ((b->rx.is_host == is_host && b->rx.hwid == hwid) || (b->tx.is_host == is_host && b->tx.hwid == hwid))) {
+      bridge_stop(b, XFER_RESULT_FAILED);
+    }
+  }
+}
+
+#endif
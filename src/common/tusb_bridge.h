@@ -0,0 +1,120 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#ifndef _TUSB_BRIDGE_H_
+#define _TUSB_BRIDGE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Endpoint bridge: data received on one endpoint (host IN or device OUT) is transmitted on another one (host OUT or
+// device IN) without copy. A ring of CFG_TUSB_BRIDGE_DEPTH slots is shared by both endpoints: a slot is received
+// into, then submitted as is to the other endpoint, and re-used for receiving once sent. Completion of one side
+// directly starts the other side in usbh/usbd task, application is not involved. A bridge is one direction, use two
+// bridges for both directions. Transfer boundaries are kept: a transfer ended by short packet is forwarded as is,
+// followed by ZLP if its length is a multiple of the transmit packet size.
+//
+// Endpoints must be opened (by a class driver or tuh_edpt_open()) and not used by anyone else while bridged.
+// Host endpoints require CFG_TUH_API_EDPT_XFER.
+
+#include "common/tusb_common.h"
+
+//--------------------------------------------------------------------+
+// Application API
+//--------------------------------------------------------------------+
+
+typedef struct {
+  bool     is_host;
+  uint8_t  hwid;    // device: rhport, host: device address
+  uint8_t  ep_addr;
+  uint16_t mps;     // endpoint packet size, used to keep transfer boundaries
+} tusb_bridge_edpt_t;
+
+typedef struct {
+  tusb_bridge_edpt_t rx;
+  tusb_bridge_edpt_t tx;
+
+  uint8_t* buf;       // CFG_TUSB_BRIDGE_DEPTH slots of slot_size
+  uint16_t slot_size;
+
+  struct {
+    uint16_t len;
+    bool     zlp;     // ZLP is owed once data of this slot is sent
+  } slot[CFG_TUSB_BRIDGE_DEPTH];
+
+  volatile uint8_t wr; // slots received, free-running
+  volatile uint8_t rd; // slots sent, free-running
+  volatile bool rx_busy;
+  volatile bool tx_busy;
+  volatile bool running;
+
+  uint32_t rx_bytes;
+  uint32_t tx_bytes;
+} tusb_bridge_t;
+
+#if CFG_TUSB_BRIDGE
+
+// Start bridging rx endpoint to tx endpoint. buf holds CFG_TUSB_BRIDGE_DEPTH slots of slot_size bytes, must be
+// DMA-capable (CFG_TUSB_MEM_SECTION, CFG_TUSB_MEM_ALIGN) and stay valid until bridge is closed. slot_size must be a
+// multiple of rx packet size and is the max transfer length submitted on either endpoint.
+bool tusb_bridge_open(tusb_bridge_t* b, tusb_bridge_edpt_t const* rx, tusb_bridge_edpt_t const* tx,
+                      uint8_t* buf, uint16_t slot_size);
+
+// Stop bridging. Transfers in progress are not aborted: host completion is ignored, device completion is passed to
+// the class driver owning the endpoint
+void tusb_bridge_close(tusb_bridge_t* b);
+
+// Check if bridge is running
+TU_ATTR_ALWAYS_INLINE static inline bool tusb_bridge_running(tusb_bridge_t const* b) {
+  return b->running;
+}
+
+// Invoked when bridge is stopped by a failed transfer, or by its device being reset or removed (XFER_RESULT_FAILED)
+void tusb_bridge_stopped_cb(tusb_bridge_t* b, xfer_result_t result);
+
+//--------------------------------------------------------------------+
+// Internal API used by usbd/usbh
+//--------------------------------------------------------------------+
+
+// Device transfer is complete, return true if it belongs to a bridge and is handled
+bool tu_bridge_device_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes);
+
+// Stop all bridges with an endpoint of a device e.g unplugged or configuration reset
+void tu_bridge_dev_close(bool is_host, uint8_t hwid);
+
+#else
+
+#define tu_bridge_device_xfer_cb(_rhport, _ep_addr, _result, _xferred_bytes) false
+#define tu_bridge_dev_close(_is_host, _hwid)
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _TUSB_BRIDGE_H_ */
@@ -0,0 +1,407 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#include "tusb_option.h"
+
+#if CFG_TUSB_CAPTURE
+
+#include "tusb_capture.h"
+
+TU_VERIFY_STATIC((CFG_TUSB_CAPTURE_DEPTH & (CFG_TUSB_CAPTURE_DEPTH - 1)) == 0, "Capture depth must be power of 2");
+TU_VERIFY_STATIC(CFG_TUSB_CAPTURE_SNAPLEN >= 8 && CFG_TUSB_CAPTURE_SNAPLEN <= UINT16_MAX,
+                 "Capture snap length must fit setup packet");
+
+// Entry is published by writing its sequence last (release), reader loads sequence before and after copying it
+// (acquire) to detect entry being written or overwritten meanwhile.
+#if defined(__GNUC__) || defined(__clang__)
+  #define _cap_acquire()   __atomic_thread_fence(__ATOMIC_ACQUIRE)
+  #define _cap_release()   __atomic_thread_fence(__ATOMIC_RELEASE)
+#else
+  #define _cap_acquire()
+  #define _cap_release()
+#endif
+
+//--------------------------------------------------------------------+
+// pcapng with Linux usbmon (memory-mapped) header
+//--------------------------------------------------------------------+
+enum {
+  PCAPNG_BLOCK_SHB = 0x0A0D0D0Aul,
+  PCAPNG_BLOCK_IDB = 0x00000001ul,
+  PCAPNG_BLOCK_EPB = 0x00000006ul,
+  PCAPNG_BYTE_ORDER_MAGIC = 0x1A2B3C4Dul,
+  LINKTYPE_USB_LINUX_MMAPPED = 220
+};
+
+enum {
+  USBMON_XFER_ISO = 0,
+  USBMON_XFER_INTR,
+  USBMON_XFER_CONTROL,
+  USBMON_XFER_BULK
+};
+
+// struct mon_bin_hdr of Linux usbmon, in host (capturing MCU) byte order
+typedef struct TU_ATTR_PACKED {
+  uint32_t id_lo;       // URB tag, 64-bit
+  uint32_t id_hi;
+  uint8_t  type;        // 'S' submit, 'C' complete
+  uint8_t  xfer_type;
+  uint8_t  epnum;       // with direction bit
+  uint8_t  devnum;
+  uint16_t busnum;
+  uint8_t  flag_setup;  // 0 if setup is present, '-' otherwise
+  uint8_t  flag_data;   // 0 if data is present, '<' or '>' otherwise
+  uint32_t ts_sec_lo;   // 64-bit
+  uint32_t ts_sec_hi;
+  int32_t  ts_usec;
+  int32_t  status;
+  uint32_t length;      // URB length
+  uint32_t len_cap;     // captured data length
+  uint8_t  setup[8];
+  int32_t  interval;
+  int32_t  start_frame;
+  uint32_t xfer_flags;
+  uint32_t ndesc;
+} usbmon_hdr_t;
+
+TU_VERIFY_STATIC(sizeof(usbmon_hdr_t) == 64, "size is not correct");
+
+//--------------------------------------------------------------------+
+// Capture ring
+//--------------------------------------------------------------------+
+typedef struct {
+  volatile uint32_t seq; // index + 1 once entry is completely written, 0 while writing
+  uint32_t timestamp_us;
+  uint32_t urb_len;
+  int32_t  status;
+  uint8_t  event;        // 'S' or 'C'
+  uint8_t  xfer_type;    // tusb_xfer_type_t
+  uint8_t  bus;          // rhport + 1
+  uint8_t  daddr;
+  uint8_t  ep_addr;
+  uint8_t  has_setup;    // setup packet is in data[0..7]
+  uint16_t cap_len;      // captured transfer data
+  uint8_t  data[CFG_TUSB_CAPTURE_SNAPLEN];
+} capture_entry_t;
+
+// Transfer type and buffer of in-progress transfer, used to capture received data on completion
+typedef struct {
+  uint8_t bus;           // 0 if unused, rhport + 1 with bit 7 set for host
+  uint8_t daddr;
+  uint8_t ep_addr;
+  uint8_t xfer_type;
+  uint8_t const* buffer;
+} capture_edpt_t;
+
+static capture_entry_t _capture_ring[CFG_TUSB_CAPTURE_DEPTH];
+static volatile uint32_t _capture_wr; // total entries reserved by writers, free-running
+static uint32_t _capture_rd;          // total entries consumed by export
+static uint32_t _capture_dropped;
+
+static capture_edpt_t _capture_edpt[CFG_TUSB_CAPTURE_EDPT_MAX];
+
+TU_ATTR_WEAK uint32_t tusb_capture_timestamp_us_cb(void) {
+  return 0;
+}
+
+TU_ATTR_ALWAYS_INLINE static inline uint8_t capture_bus(uint8_t rhport, bool is_host) {
+  return (uint8_t) ((rhport + 1) | (is_host ? 0x80 : 0));
+}
+
+static capture_edpt_t* capture_edpt_get(uint8_t bus, uint8_t daddr, uint8_t ep_addr, bool alloc) {
+  capture_edpt_t* free_edpt = NULL;
+  for (uint8_t i = 0; i < CFG_TUSB_CAPTURE_EDPT_MAX; i++) {
+    capture_edpt_t* edpt = &_capture_edpt[i];
+    if (edpt->bus == bus && edpt->daddr == daddr && edpt->ep_addr == ep_addr) {
+      return edpt;
+    }
+    if (edpt->bus == 0 && free_edpt == NULL) {
+      free_edpt = edpt;
+    }
+  }
+
+  if (alloc && free_edpt) {
+    free_edpt->bus = bus;
+    free_edpt->daddr = daddr;
+    free_edpt->ep_addr = ep_addr;
+    free_edpt->xfer_type = (uint8_t) (tu_edpt_number(ep_addr) ? TUSB_XFER_BULK : TUSB_XFER_CONTROL);
+    free_edpt->buffer = NULL;
+    return free_edpt;
+  }
+
+  return NULL;
+}
+
+// Entry is reserved with an atomic add so that event from ISR does not corrupt an entry being written by thread.
+// Without atomic support (e.g ARMv6-M) an entry could be lost when both write at the same time.
+static uint32_t capture_reserve(void) {
+#if defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4)
+  return __atomic_fetch_add(&_capture_wr, 1, __ATOMIC_RELAXED);
+#else
+  uint32_t const wr = _capture_wr;
+  _capture_wr = wr + 1;
+  return wr;
+#endif
+}
+
+static void capture_record(uint8_t event, uint8_t bus, uint8_t daddr, uint8_t ep_addr, uint8_t xfer_type,
+                           uint32_t urb_len, int32_t status, uint8_t const* data, uint32_t data_len, bool has_setup) {
+  uint32_t const idx = capture_reserve();
+  capture_entry_t* entry = &_capture_ring[idx & (CFG_TUSB_CAPTURE_DEPTH - 1)];
+
+  entry->seq = 0;
+  _cap_release();
+
+  entry->timestamp_us = tusb_capture_timestamp_us_cb();
+  entry->urb_len = urb_len;
+  entry->status = status;
+  entry->event = event;
+  entry->xfer_type = xfer_type;
+  entry->bus = (uint8_t) (bus & 0x7F);
+  entry->daddr = daddr;
+  entry->ep_addr = ep_addr;
+  entry->has_setup = has_setup ? 1 : 0;
+
+  uint32_t const cap_len = (data && !has_setup) ? tu_min32(data_len, CFG_TUSB_CAPTURE_SNAPLEN) : 0;
+  entry->cap_len = (uint16_t) cap_len;
+  if (has_setup) {
+    memcpy(entry->data, data, 8);
+  } else if (cap_len) {
+    memcpy(entry->data, data, cap_len);
+  }
+
+  _cap_release();
+  entry->seq = idx + 1;
+}
+
+// Data is in the buffer on submit if this side transmits: host OUT or device IN, otherwise it is on completion
+TU_ATTR_ALWAYS_INLINE static inline bool capture_is_tx(bool is_host, uint8_t ep_addr) {
+  return is_host == (tu_edpt_dir(ep_addr) == TUSB_DIR_OUT);
+}
+
+//--------------------------------------------------------------------+
+// Internal API
+//--------------------------------------------------------------------+
+void tu_capture_edpt_open(uint8_t rhport, bool is_host, uint8_t daddr, uint8_t ep_addr, uint8_t xfer_type) {
+  capture_edpt_t* edpt = capture_edpt_get(capture_bus(rhport, is_host), daddr, ep_addr, true);
+  if (edpt) {
+    edpt->xfer_type = xfer_type;
+    edpt->buffer = NULL;
+  }
+}
+
+void tu_capture_dev_close(uint8_t rhport, bool is_host, uint8_t daddr) {
+  uint8_t const bus = capture_bus(rhport, is_host);
+  for (uint8_t i = 0; i < CFG_TUSB_CAPTURE_EDPT_MAX; i++) {
+    if (_capture_edpt[i].bus == bus && _capture_edpt[i].daddr == daddr) {
+      tu_varclr(&_capture_edpt[i]);
+    }
+  }
+}
+
+void tu_capture_setup(uint8_t rhport, bool is_host, uint8_t daddr, uint8_t const setup[8]) {
+  uint8_t const bus = capture_bus(rhport, is_host);
+  uint16_t const wLength = tu_u16(setup[7], setup[6]);
+  capture_record('S', bus, daddr, 0, TUSB_XFER_CONTROL, wLength, 0, setup, 8, true);
+}
+
+void tu_capture_xfer_submit(uint8_t rhport, bool is_host, uint8_t daddr, uint8_t ep_addr,
+                            uint8_t const* buffer, uint32_t len) {
+  uint8_t const bus = capture_bus(rhport, is_host);
+  capture_edpt_t* edpt = capture_edpt_get(bus, daddr, ep_addr, true);
+  uint8_t xfer_type = (uint8_t) (tu_edpt_number(ep_addr) ? TUSB_XFER_BULK : TUSB_XFER_CONTROL);
+  if (edpt) {
+    edpt->buffer = buffer;
+    xfer_type = edpt->xfer_type;
+  }
+
+  bool const is_tx = capture_is_tx(is_host, ep_addr);
+  capture_record('S', bus, daddr, ep_addr, xfer_type, len, 0, is_tx ? buffer : NULL, len, false);
+}
+
+void tu_capture_xfer_complete(uint8_t rhport, bool is_host, uint8_t daddr, uint8_t ep_addr,
+                              xfer_result_t result, uint32_t len) {
+  uint8_t const bus = capture_bus(rhport, is_host);
+  capture_edpt_t* edpt = capture_edpt_get(bus, daddr, ep_addr, false);
+  uint8_t xfer_type = (uint8_t) (tu_edpt_number(ep_addr) ? TUSB_XFER_BULK : TUSB_XFER_CONTROL);
+  uint8_t const* buffer = NULL;
+  if (edpt) {
+    xfer_type = edpt->xfer_type;
+    buffer = edpt->buffer;
+    edpt->buffer = NULL;
+  }
+
+  // Linux errno as reported by usbmon
+  int32_t status;
+  switch (result) {
+    case XFER_RESULT_SUCCESS: status = 0; break;
+    case XFER_RESULT_STALLED: status = -32; break;  // EPIPE
+    case XFER_RESULT_TIMEOUT: status = -110; break; // ETIMEDOUT
+    default: status = -71; break;                   // EPROTO
+  }
+
+  bool const is_tx = capture_is_tx(is_host, ep_addr);
+  capture_record('C', bus, daddr, ep_addr, xfer_type, len, status, is_tx ? NULL : buffer, len, false);
+}
+
+//--------------------------------------------------------------------+
+// Application API
+//--------------------------------------------------------------------+
+static void export_header(tusb_capture_write_cb_t write_cb, void* arg) {
+  struct TU_ATTR_PACKED {
+    uint32_t type;
+    uint32_t len;
+    uint32_t byte_order_magic;
+    uint16_t major;
+    uint16_t minor;
+    uint32_t section_len_lo; // 64-bit, -1 is unknown
+    uint32_t section_len_hi;
+    uint32_t len2;
+  } const shb = {
+    .type = PCAPNG_BLOCK_SHB, .len = sizeof(shb), .byte_order_magic = PCAPNG_BYTE_ORDER_MAGIC,
+    .major = 1, .minor = 0, .section_len_lo = 0xFFFFFFFFul, .section_len_hi = 0xFFFFFFFFul, .len2 = sizeof(shb)
+  };
+  write_cb(&shb, sizeof(shb), arg);
+
+  struct TU_ATTR_PACKED {
+    uint32_t type;
+    uint32_t len;
+    uint16_t link_type;
+    uint16_t reserved;
+    uint32_t snap_len;
+    uint32_t len2;
+  } const idb = {
+    .type = PCAPNG_BLOCK_IDB, .len = sizeof(idb), .link_type = LINKTYPE_USB_LINUX_MMAPPED, .reserved = 0,
+    .snap_len = sizeof(usbmon_hdr_t) + CFG_TUSB_CAPTURE_SNAPLEN, .len2 = sizeof(idb)
+  };
+  write_cb(&idb, sizeof(idb), arg);
+}
+
+static void export_entry(tusb_capture_write_cb_t write_cb, void* arg, capture_entry_t const* entry) {
+  usbmon_hdr_t hdr;
+  tu_varclr(&hdr);
+
+  hdr.id_lo = ((uint32_t) entry->bus << 16) | ((uint32_t) entry->daddr << 8) | entry->ep_addr;
+  hdr.type = entry->event;
+  hdr.xfer_type = (uint8_t) (entry->xfer_type == TUSB_XFER_ISOCHRONOUS ? USBMON_XFER_ISO :
+                             entry->xfer_type == TUSB_XFER_INTERRUPT ? USBMON_XFER_INTR :
+                             entry->xfer_type == TUSB_XFER_BULK ? USBMON_XFER_BULK : USBMON_XFER_CONTROL);
+  hdr.epnum = entry->ep_addr;
+  hdr.devnum = entry->daddr;
+  hdr.busnum = entry->bus;
+  hdr.flag_setup = entry->has_setup ? 0 : '-';
+  hdr.flag_data = entry->cap_len ? 0 : (tu_edpt_dir(entry->ep_addr) == TUSB_DIR_IN ? '<' : '>');
+  hdr.ts_sec_lo = entry->timestamp_us / 1000000u;
+  hdr.ts_usec = (int32_t) (entry->timestamp_us % 1000000u);
+  hdr.status = entry->status;
+  hdr.length = entry->urb_len;
+  hdr.len_cap = entry->cap_len;
+  if (entry->has_setup) {
+    memcpy(hdr.setup, entry->data, 8);
+  }
+
+  uint32_t const pkt_len = sizeof(usbmon_hdr_t) + entry->cap_len;
+  uint32_t const pad_len = (4 - (pkt_len & 3)) & 3;
+  uint32_t const block_len = 32 + pkt_len + pad_len;
+  uint32_t const orig_len = sizeof(usbmon_hdr_t) + (entry->cap_len ? entry->urb_len : 0);
+
+  uint32_t const epb[7] = {
+    PCAPNG_BLOCK_EPB, block_len,
+    0,                // interface id
+    0,                // timestamp high, microsecond resolution
+    entry->timestamp_us,
+    pkt_len, tu_max32(orig_len, pkt_len)
+  };
+  uint32_t const padding = 0;
+
+  write_cb(epb, sizeof(epb), arg);
+  write_cb(&hdr, sizeof(hdr), arg);
+  if (entry->cap_len) {
+    write_cb(entry->data, entry->cap_len, arg);
+  }
+  if (pad_len) {
+    write_cb(&padding, pad_len, arg);
+  }
+  write_cb(&block_len, 4, arg);
+}
+
+uint32_t tusb_capture_export(tusb_capture_write_cb_t write_cb, void* arg, bool with_header) {
+  TU_VERIFY(write_cb, 0);
+
+  if (with_header) {
+    export_header(write_cb, arg);
+  }
+
+  uint32_t count = 0;
+  while (_capture_rd != _capture_wr) {
+    uint32_t const wr = _capture_wr;
+
+    // overrun: oldest entries are overwritten
+    if (wr - _capture_rd > CFG_TUSB_CAPTURE_DEPTH) {
+      _capture_dropped += wr - CFG_TUSB_CAPTURE_DEPTH - _capture_rd;
+      _capture_rd = wr - CFG_TUSB_CAPTURE_DEPTH;
+    }
+
+    capture_entry_t const* slot = &_capture_ring[_capture_rd & (CFG_TUSB_CAPTURE_DEPTH - 1)];
+    uint32_t const expected = _capture_rd + 1;
+    uint32_t const seq = slot->seq;
+    _cap_acquire();
+
+    if (seq != expected) {
+      if (seq == 0 || (int32_t) (seq - expected) < 0) {
+        break; // still being written, export it next time
+      }
+      _capture_dropped++; // overwritten by newer entry
+      _capture_rd++;
+      continue;
+    }
+
+    capture_entry_t entry;
+    memcpy(&entry, slot, sizeof(capture_entry_t));
+    _cap_acquire();
+    if (slot->seq != seq) {
+      _capture_dropped++; // overwritten while copying
+      _capture_rd++;
+      continue;
+    }
+
+    export_entry(write_cb, arg, &entry);
+    _capture_rd++;
+    count++;
+  }
+
+  return count;
+}
+
+void tusb_capture_clear(void) {
+  _capture_rd = _capture_wr;
+  _capture_dropped = 0;
+}
+
+uint32_t tusb_capture_dropped(void) {
+  return _capture_dropped;
+}
+
+#endif
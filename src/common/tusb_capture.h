@@ -0,0 +1,100 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#ifndef _TUSB_CAPTURE_H_
+#define _TUSB_CAPTURE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// In-stack packet capture. Setup packets, transfer submissions and completions seen by usbd/usbh are recorded with
+// timestamp into a ring of CFG_TUSB_CAPTURE_DEPTH entries, data is truncated to CFG_TUSB_CAPTURE_SNAPLEN bytes.
+// Entries are exported as pcapng with Linux usbmon link type (LINKTYPE_USB_LINUX_MMAPPED) which can be opened with
+// Wireshark. Events are always reported from host point of view: bus number is rhport + 1, device mode events use
+// device address 0 since device does not track its own address.
+
+#include "common/tusb_common.h"
+
+//--------------------------------------------------------------------+
+// Application API
+//--------------------------------------------------------------------+
+
+// Invoked to write exported pcapng data e.g to CDC or a RAM buffer read by debugger
+typedef void (*tusb_capture_write_cb_t)(void const* data, uint32_t len, void* arg);
+
+#if CFG_TUSB_CAPTURE
+
+// Export captured entries (oldest first) as pcapng blocks, exported entries are removed from the ring.
+// with_header should be true for the first export of a file to write Section Header + Interface Description blocks,
+// later exports appended to the same file should pass false. Return number of exported entries.
+uint32_t tusb_capture_export(tusb_capture_write_cb_t write_cb, void* arg, bool with_header);
+
+// Drop all captured entries
+void tusb_capture_clear(void);
+
+// Number of entries overwritten before being exported since last clear
+uint32_t tusb_capture_dropped(void);
+
+// Invoked to get timestamp in microseconds of captured event, may be called in ISR. Default is 0
+uint32_t tusb_capture_timestamp_us_cb(void);
+
+//--------------------------------------------------------------------+
+// Internal API used by usbd/usbh
+//--------------------------------------------------------------------+
+
+// Endpoint is opened with transfer type (tusb_xfer_type_t)
+void tu_capture_edpt_open(uint8_t rhport, bool is_host, uint8_t daddr, uint8_t ep_addr, uint8_t xfer_type);
+
+// Forget all endpoints of a device e.g unplugged or configuration reset
+void tu_capture_dev_close(uint8_t rhport, bool is_host, uint8_t daddr);
+
+// Setup packet is sent (host) or received (device)
+void tu_capture_setup(uint8_t rhport, bool is_host, uint8_t daddr, uint8_t const setup[8]);
+
+// Transfer is submitted, buffer can be NULL (e.g fifo transfer) then no data is captured
+void tu_capture_xfer_submit(uint8_t rhport, bool is_host, uint8_t daddr, uint8_t ep_addr,
+                            uint8_t const* buffer, uint32_t len);
+
+// Transfer is complete, called in ISR
+void tu_capture_xfer_complete(uint8_t rhport, bool is_host, uint8_t daddr, uint8_t ep_addr,
+                              xfer_result_t result, uint32_t len);
+
+#else
+
+#define tu_capture_edpt_open(_rhport, _is_host, _daddr, _ep_addr, _xfer_type)
+#define tu_capture_dev_close(_rhport, _is_host, _daddr)
+#define tu_capture_setup(_rhport, _is_host, _daddr, _setup)
+#define tu_capture_xfer_submit(_rhport, _is_host, _daddr, _ep_addr, _buffer, _len)
+#define tu_capture_xfer_complete(_rhport, _is_host, _daddr, _ep_addr, _result, _len)
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _TUSB_CAPTURE_H_ */
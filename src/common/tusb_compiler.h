@@ -273,6 +273,9 @@
 #endif
 
 
+// composed of 32-bit swaps, only needed by a few 64-bit protocol fields e.g SCSI LBA
+#define TU_BSWAP64(u64) ((((uint64_t) TU_BSWAP32((uint32_t) (u64))) << 32) | TU_BSWAP32((uint32_t) ((u64) >> 32)))
+
 #if (TU_BYTE_ORDER == TU_LITTLE_ENDIAN)
 
   #define tu_htons(u16)  (TU_BSWAP16(u16))
@@ -281,6 +284,9 @@
   #define tu_htonl(u32)  (TU_BSWAP32(u32))
   #define tu_ntohl(u32)  (TU_BSWAP32(u32))
 
+  #define tu_htonll(u64) (TU_BSWAP64(u64))
+  #define tu_ntohll(u64) (TU_BSWAP64(u64))
+
   #define tu_htole16(u16) (u16)
   #define tu_le16toh(u16) (u16)
 
@@ -295,6 +301,9 @@
   #define tu_htonl(u32)  (u32)
   #define tu_ntohl(u32)  (u32)
 
+  #define tu_htonll(u64) (u64)
+  #define tu_ntohll(u64) (u64)
+
   #define tu_htole16(u16) (TU_BSWAP16(u16))
   #define tu_le16toh(u16) (TU_BSWAP16(u16))
 
@@ -63,12 +63,56 @@ static inline void tu_print_buf(uint8_t const* buf, uint32_t bufsize) {
   tu_printf("\r\n");
 }
 
+#if CFG_TUSB_DEBUG_TRACE
+// Binary trace record, in little-endian 32-bit words:
+// - header   : magic TU_TRACE_MAGIC (bit 7:0), argument count (11:8), type (15:12), memory dump length (31:16)
+// - timestamp: from tusb_trace_timestamp_cb()
+// - log      : format string address followed by arguments (up to 15)
+// - memory   : dump data padded to word
+// Arguments are read as 32-bit (int, long, pointer of 32-bit MCU). Strings (format and %s arguments) must be in
+// read-only memory so that host decoder can find them in ELF.
+#define TU_TRACE_MAGIC     0xA5u
+#define TU_TRACE_ARGC_MAX  15u
+
+enum {
+  TU_TRACE_TYPE_LOG = 0,
+  TU_TRACE_TYPE_MEM = 1
+};
+
+void tu_trace_log(uint32_t argc, char const* format, ...);
+void tu_trace_mem(void const* buf, uint32_t count);
+
+// Copy recorded trace from ring buffer (oldest first), return number of bytes. Only available when
+// CFG_TUSB_DEBUG_TRACE_WRITE is not defined
+uint32_t tu_trace_read(void* buf, uint32_t bufsize);
+
+// Invoked to get timestamp of trace record (in any unit e.g ms or cpu cycle), may be called in ISR
+uint32_t tusb_trace_timestamp_cb(void);
+
+#ifdef CFG_TUSB_DEBUG_TRACE_WRITE
+  extern void CFG_TUSB_DEBUG_TRACE_WRITE(void const* buf, uint32_t len);
+#endif
+
+#define TU_TRACE_LOG(...)  tu_trace_log(TU_ARGS_NUM(__VA_ARGS__) - 1, __VA_ARGS__)
+#endif
+
 // Log with Level
 #define TU_LOG(n, ...)        TU_XSTRCAT(TU_LOG, n)(__VA_ARGS__)
 #define TU_LOG_MEM(n, ...)    TU_XSTRCAT3(TU_LOG, n, _MEM)(__VA_ARGS__)
 #define TU_LOG_BUF(n, ...)    TU_XSTRCAT3(TU_LOG, n, _BUF)(__VA_ARGS__)
 #define TU_LOG_INT(n, ...)    TU_XSTRCAT3(TU_LOG, n, _INT)(__VA_ARGS__)
 #define TU_LOG_HEX(n, ...)    TU_XSTRCAT3(TU_LOG, n, _HEX)(__VA_ARGS__)
+#if CFG_TUSB_DEBUG_TRACE
+#define TU_LOG_LOCATION()     TU_TRACE_LOG("%s: %d:\r\n", __PRETTY_FUNCTION__, __LINE__)
+#define TU_LOG_FAILED()       TU_TRACE_LOG("%s: %d: Failed\r\n", __PRETTY_FUNCTION__, __LINE__)
+
+// Log Level 1: Error
+#define TU_LOG1               TU_TRACE_LOG
+#define TU_LOG1_MEM(_x, _n, _indent) tu_trace_mem(_x, _n)
+#define TU_LOG1_BUF(_x, _n)   tu_trace_mem(_x, _n)
+#define TU_LOG1_INT(_x)       TU_TRACE_LOG(#_x " = %ld\r\n", (unsigned long) (_x) )
+#define TU_LOG1_HEX(_x)       TU_TRACE_LOG(#_x " = 0x%lX\r\n", (unsigned long) (_x) )
+#else
 #define TU_LOG_LOCATION()     tu_printf("%s: %d:\r\n", __PRETTY_FUNCTION__, __LINE__)
 #define TU_LOG_FAILED()       tu_printf("%s: %d: Failed\r\n", __PRETTY_FUNCTION__, __LINE__)
 
@@ -78,6 +122,7 @@ static inline void tu_print_buf(uint8_t const* buf, uint32_t bufsize) {
 #define TU_LOG1_BUF(_x, _n)   tu_print_buf((uint8_t const*)(_x), _n)
 #define TU_LOG1_INT(_x)       tu_printf(#_x " = %ld\r\n", (unsigned long) (_x) )
 #define TU_LOG1_HEX(_x)       tu_printf(#_x " = 0x%lX\r\n", (unsigned long) (_x) )
+#endif
 
 // Log Level 2: Warn
 #if CFG_TUSB_DEBUG >= 2
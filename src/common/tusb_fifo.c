@@ -55,6 +55,80 @@ TU_ATTR_ALWAYS_INLINE static inline void _ff_unlock(osal_mutex_t mutex)
 
 #endif
 
+// Without mutex, fifo is lock-free for single producer single consumer (SPSC). Data must be committed to the
+// buffer before the index is published to the other side (release), and the other side's index must be loaded
+// before accessing the buffer (acquire). These are also required for multi-core MCU or CPU with weak ordering.
+#if defined(__GNUC__) || defined(__clang__)
+  #define _ff_acquire()   __atomic_thread_fence(__ATOMIC_ACQUIRE)
+  #define _ff_release()   __atomic_thread_fence(__ATOMIC_RELEASE)
+#else
+  // volatile index access only
+  #define _ff_acquire()
+  #define _ff_release()
+#endif
+
+#if CFG_TUSB_FIFO_INDEX_32BIT
+  #define _ff_min   tu_min32
+#else
+  #define _ff_min   tu_min16
+#endif
+
+//--------------------------------------------------------------------+
+// Copy backend for TU_FIFO_COPY_INC
+//--------------------------------------------------------------------+
+
+#ifdef CFG_TUSB_FIFO_MEMCPY
+  // port/application provided copy e.g DMA-assisted memcpy
+  extern void* CFG_TUSB_FIFO_MEMCPY(void* dst, const void* src, size_t len);
+  #define _ff_memcpy    CFG_TUSB_FIFO_MEMCPY
+
+#elif CFG_TUSB_FIFO_COPY_WORDS
+
+// Word-wide copy. Libc memcpy() optimized for size (e.g newlib-nano) only copies byte by byte, which is
+// the main CPU cost of fifo on high speed ports. Use 32-bit (or 64-bit on 64-bit CPU) words when both
+// sides are aligned, falling back to byte copy for unaligned buffers and the remaining tail.
+static void* _ff_memcpy(void* dst, const void* src, size_t len)
+{
+  uint8_t* dst8 = (uint8_t*) dst;
+  uint8_t const* src8 = (uint8_t const*) src;
+
+  if ( (((uintptr_t) dst8 | (uintptr_t) src8) & (sizeof(uintptr_t)-1)) == 0 )
+  {
+    uintptr_t* dst_w = (uintptr_t*) (uintptr_t) dst8;
+    uintptr_t const* src_w = (uintptr_t const*) (uintptr_t) src8;
+
+    // unrolled by 4 words
+    while ( len >= 4*sizeof(uintptr_t) )
+    {
+      dst_w[0] = src_w[0];
+      dst_w[1] = src_w[1];
+      dst_w[2] = src_w[2];
+      dst_w[3] = src_w[3];
+
+      dst_w += 4;
+      src_w += 4;
+      len   -= 4*sizeof(uintptr_t);
+    }
+
+    while ( len >= sizeof(uintptr_t) )
+    {
+      *dst_w++ = *src_w++;
+      len -= sizeof(uintptr_t);
+    }
+
+    dst8 = (uint8_t*) dst_w;
+    src8 = (uint8_t const*) src_w;
+  }
+
+  while ( len-- ) *dst8++ = *src8++;
+
+  return dst;
+}
+
+#else
+  #define _ff_memcpy    memcpy
+#endif
+
 /** \enum tu_fifo_copy_mode_t
  * \brief Write modes intended to allow special read and write functions to be able to
  *        copy data to and from USB hardware FIFOs as needed for e.g. STM32s and others
@@ -67,12 +141,12 @@ typedef enum
 #endif
 } tu_fifo_copy_mode_t;
 
-bool tu_fifo_config(tu_fifo_t *f, void* buffer, uint16_t depth, uint16_t item_size, bool overwritable)
+bool tu_fifo_config(tu_fifo_t *f, void* buffer, tu_fifo_size_t depth, uint16_t item_size, bool overwritable)
 {
   // Limit index space to 2*depth - this allows for a fast "modulo" calculation
-  // but limits the maximum depth to 2^16/2 = 2^15 and buffer overflows are detectable
+  // but limits the maximum depth to 2^16/2 = 2^15 (2^31 with 32-bit index) and buffer overflows are detectable
   // only if overflow happens once (important for unsupervised DMA applications)
-  if (depth > 0x8000) return false;
+  if (depth > TU_FIFO_DEPTH_MAX) return false;
 
   _ff_lock(f->mutex_wr);
   _ff_lock(f->mutex_rd);
@@ -83,6 +157,14 @@ bool tu_fifo_config(tu_fifo_t *f, void* buffer, uint16_t depth, uint16_t item_si
   f->overwritable = overwritable;
   f->rd_idx       = 0;
   f->wr_idx       = 0;
+#if CFG_TUSB_FIFO_ISR_SAFE
+  f->wr_rsv_idx   = 0;
+  f->wr_pending   = 0;
+#endif
+#if CFG_TUSB_FIFO_STATS
+  tu_memclr(&f->stats, sizeof(tu_fifo_stats_t));
+  f->wm_above     = false;
+#endif
 
   _ff_unlock(f->mutex_wr);
   _ff_unlock(f->mutex_rd);
@@ -98,12 +180,12 @@ bool tu_fifo_config(tu_fifo_t *f, void* buffer, uint16_t depth, uint16_t item_si
 // Intended to be used to read from hardware USB FIFO in e.g. STM32 where all data is read from a constant address
 // Code adapted from dcd_synopsys.c
 // TODO generalize with configurable 1 byte or 4 byte each read
-static void _ff_push_const_addr(uint8_t * ff_buf, const void * app_buf, uint16_t len)
+static void _ff_push_const_addr(uint8_t * ff_buf, const void * app_buf, tu_fifo_size_t len)
 {
   volatile const uint32_t * reg_rx = (volatile const uint32_t *) app_buf;
 
   // Reading full available 32 bit words from const app address
-  uint16_t full_words = len >> 2;
+  tu_fifo_size_t full_words = len >> 2;
   while(full_words--)
   {
     tu_unaligned_write32(ff_buf, *reg_rx);
@@ -121,12 +203,12 @@ static void _ff_push_const_addr(uint8_t * ff_buf, const void * app_buf, uint16_t
 
 // Intended to be used to write to hardware USB FIFO in e.g. STM32
 // where all data is written to a constant address in full word copies
-static void _ff_pull_const_addr(void * app_buf, const uint8_t * ff_buf, uint16_t len)
+static void _ff_pull_const_addr(void * app_buf, const uint8_t * ff_buf, tu_fifo_size_t len)
 {
   volatile uint32_t * reg_tx = (volatile uint32_t *) app_buf;
 
   // Write full available 32 bit words to const address
-  uint16_t full_words = len >> 2;
+  tu_fifo_size_t full_words = len >> 2;
   while(full_words--)
   {
     *reg_tx = tu_unaligned_read32(ff_buf);
@@ -146,19 +228,19 @@ static void _ff_pull_const_addr(void * app_buf, const uint8_t * ff_buf, uint16_t
 #endif
 
 // send one item to fifo WITHOUT updating write pointer
-static inline void _ff_push(tu_fifo_t* f, void const * app_buf, uint16_t rel)
+static inline void _ff_push(tu_fifo_t* f, void const * app_buf, tu_fifo_size_t rel)
 {
   memcpy(f->buffer + (rel * f->item_size), app_buf, f->item_size);
 }
 
 // send n items to fifo WITHOUT updating write pointer
-static void _ff_push_n(tu_fifo_t* f, void const * app_buf, uint16_t n, uint16_t wr_ptr, tu_fifo_copy_mode_t copy_mode)
+static void _ff_push_n(tu_fifo_t* f, void const * app_buf, tu_fifo_size_t n, tu_fifo_size_t wr_ptr, tu_fifo_copy_mode_t copy_mode)
 {
-  uint16_t const lin_count = f->depth - wr_ptr;
-  uint16_t const wrap_count = n - lin_count;
+  tu_fifo_size_t const lin_count = f->depth - wr_ptr;
+  tu_fifo_size_t const wrap_count = n - lin_count;
 
-  uint16_t lin_bytes = lin_count * f->item_size;
-  uint16_t wrap_bytes = wrap_count * f->item_size;
+  tu_fifo_size_t lin_bytes = lin_count * f->item_size;
+  tu_fifo_size_t wrap_bytes = wrap_count * f->item_size;
 
   // current buffer of fifo
   uint8_t* ff_buf = f->buffer + (wr_ptr * f->item_size);
@@ -169,18 +251,18 @@ static void _ff_push_n(tu_fifo_t* f, void const * app_buf, uint16_t n, uint16_t
       if(n <= lin_count)
       {
         // Linear only
-        memcpy(ff_buf, app_buf, n*f->item_size);
+        _ff_memcpy(ff_buf, app_buf, n*f->item_size);
       }
       else
       {
         // Wrap around
 
         // Write data to linear part of buffer
-        memcpy(ff_buf, app_buf, lin_bytes);
+        _ff_memcpy(ff_buf, app_buf, lin_bytes);
 
         // Write data wrapped around
         // TU_ASSERT(nWrap_bytes <= f->depth, );
-        memcpy(f->buffer, ((uint8_t const*) app_buf) + lin_bytes, wrap_bytes);
+        _ff_memcpy(f->buffer, ((uint8_t const*) app_buf) + lin_bytes, wrap_bytes);
       }
       break;
 #ifdef TUP_MEM_CONST_ADDR
@@ -196,7 +278,7 @@ static void _ff_push_n(tu_fifo_t* f, void const * app_buf, uint16_t n, uint16_t
         // Wrap around case
 
         // Write full words to linear part of buffer
-        uint16_t nLin_4n_bytes = lin_bytes & 0xFFFC;
+        tu_fifo_size_t nLin_4n_bytes = lin_bytes & (TU_FIFO_SIZE_MAX - 3);
         _ff_push_const_addr(ff_buf, app_buf, nLin_4n_bytes);
         ff_buf += nLin_4n_bytes;
 
@@ -206,7 +288,7 @@ static void _ff_push_n(tu_fifo_t* f, void const * app_buf, uint16_t n, uint16_t
         {
           volatile const uint32_t * rx_fifo = (volatile const uint32_t *) app_buf;
 
-          uint8_t remrem = (uint8_t) tu_min16(wrap_bytes, 4-rem);
+          uint8_t remrem = (uint8_t) _ff_min(wrap_bytes, 4-rem);
           wrap_bytes -= remrem;
 
           uint32_t tmp32 = *rx_fifo;
@@ -234,19 +316,19 @@ static void _ff_push_n(tu_fifo_t* f, void const * app_buf, uint16_t n, uint16_t
 }
 
 // get one item from fifo WITHOUT updating read pointer
-static inline void _ff_pull(tu_fifo_t* f, void * app_buf, uint16_t rel)
+static inline void _ff_pull(tu_fifo_t* f, void * app_buf, tu_fifo_size_t rel)
 {
   memcpy(app_buf, f->buffer + (rel * f->item_size), f->item_size);
 }
 
 // get n items from fifo WITHOUT updating read pointer
-static void _ff_pull_n(tu_fifo_t* f, void* app_buf, uint16_t n, uint16_t rd_ptr, tu_fifo_copy_mode_t copy_mode)
+static void _ff_pull_n(tu_fifo_t* f, void* app_buf, tu_fifo_size_t n, tu_fifo_size_t rd_ptr, tu_fifo_copy_mode_t copy_mode)
 {
-  uint16_t const lin_count = f->depth - rd_ptr;
-  uint16_t const wrap_count = n - lin_count; // only used if wrapped
+  tu_fifo_size_t const lin_count = f->depth - rd_ptr;
+  tu_fifo_size_t const wrap_count = n - lin_count; // only used if wrapped
 
-  uint16_t lin_bytes = lin_count * f->item_size;
-  uint16_t wrap_bytes = wrap_count * f->item_size;
+  tu_fifo_size_t lin_bytes = lin_count * f->item_size;
+  tu_fifo_size_t wrap_bytes = wrap_count * f->item_size;
 
   // current buffer of fifo
   uint8_t* ff_buf = f->buffer + (rd_ptr * f->item_size);
@@ -257,17 +339,17 @@ static void _ff_pull_n(tu_fifo_t* f, void* app_buf, uint16_t n, uint16_t rd_ptr,
       if ( n <= lin_count )
       {
         // Linear only
-        memcpy(app_buf, ff_buf, n*f->item_size);
+        _ff_memcpy(app_buf, ff_buf, n*f->item_size);
       }
       else
       {
         // Wrap around
 
         // Read data from linear part of buffer
-        memcpy(app_buf, ff_buf, lin_bytes);
+        _ff_memcpy(app_buf, ff_buf, lin_bytes);
 
         // Read data wrapped part
-        memcpy((uint8_t*) app_buf + lin_bytes, f->buffer, wrap_bytes);
+        _ff_memcpy((uint8_t*) app_buf + lin_bytes, f->buffer, wrap_bytes);
       }
     break;
 #ifdef TUP_MEM_CONST_ADDR
@@ -282,7 +364,7 @@ static void _ff_pull_n(tu_fifo_t* f, void* app_buf, uint16_t n, uint16_t rd_ptr,
         // Wrap around case
 
         // Read full words from linear part of buffer
-        uint16_t lin_4n_bytes = lin_bytes & 0xFFFC;
+        tu_fifo_size_t lin_4n_bytes = lin_bytes & (TU_FIFO_SIZE_MAX - 3);
         _ff_pull_const_addr(app_buf, ff_buf, lin_4n_bytes);
         ff_buf += lin_4n_bytes;
 
@@ -292,7 +374,7 @@ static void _ff_pull_n(tu_fifo_t* f, void* app_buf, uint16_t n, uint16_t rd_ptr,
         {
           volatile uint32_t * reg_tx = (volatile uint32_t *) app_buf;
 
-          uint8_t remrem = (uint8_t) tu_min16(wrap_bytes, 4-rem);
+          uint8_t remrem = (uint8_t) _ff_min(wrap_bytes, 4-rem);
           wrap_bytes -= remrem;
 
           uint32_t tmp32=0;
@@ -325,25 +407,38 @@ static void _ff_pull_n(tu_fifo_t* f, void* app_buf, uint16_t n, uint16_t rd_ptr,
 // Helper
 //--------------------------------------------------------------------+
 
+// Power-of-two depth makes index space 2*depth also a power of two: wrapping is done with a mask instead of
+// compare and subtract. Checked on depth which is loaded anyway, no extra state in tu_fifo_t is needed.
+TU_ATTR_ALWAYS_INLINE static inline
+bool _ff_is_pow2(tu_fifo_size_t depth)
+{
+  return (depth & (depth - 1)) == 0;
+}
+
 // return only the index difference and as such can be used to determine an overflow i.e overflowable count
 TU_ATTR_ALWAYS_INLINE static inline
-uint16_t _ff_count(uint16_t depth, uint16_t wr_idx, uint16_t rd_idx)
+tu_fifo_size_t _ff_count(tu_fifo_size_t depth, tu_fifo_size_t wr_idx, tu_fifo_size_t rd_idx)
 {
+  if ( _ff_is_pow2(depth) )
+  {
+    return (tu_fifo_size_t) ((wr_idx - rd_idx) & (2*depth - 1));
+  }
+
   // In case we have non-power of two depth we need a further modification
   if (wr_idx >= rd_idx)
   {
-    return (uint16_t) (wr_idx - rd_idx);
+    return (tu_fifo_size_t) (wr_idx - rd_idx);
   } else
   {
-    return (uint16_t) (2*depth - (rd_idx - wr_idx));
+    return (tu_fifo_size_t) (2*depth - (rd_idx - wr_idx));
   }
 }
 
 // return remaining slot in fifo
 TU_ATTR_ALWAYS_INLINE static inline
-uint16_t _ff_remaining(uint16_t depth, uint16_t wr_idx, uint16_t rd_idx)
+tu_fifo_size_t _ff_remaining(tu_fifo_size_t depth, tu_fifo_size_t wr_idx, tu_fifo_size_t rd_idx)
 {
-  uint16_t const count = _ff_count(depth, wr_idx, rd_idx);
+  tu_fifo_size_t const count = _ff_count(depth, wr_idx, rd_idx);
   return (depth > count) ? (depth - count) : 0;
 }
 
@@ -353,16 +448,21 @@ uint16_t _ff_remaining(uint16_t depth, uint16_t wr_idx, uint16_t rd_idx)
 
 // Advance an absolute index
 // "absolute" index is only in the range of [0..2*depth)
-static uint16_t advance_index(uint16_t depth, uint16_t idx, uint16_t offset)
+static tu_fifo_size_t advance_index(tu_fifo_size_t depth, tu_fifo_size_t idx, tu_fifo_size_t offset)
 {
+  if ( _ff_is_pow2(depth) )
+  {
+    return (tu_fifo_size_t) ((idx + offset) & (2*depth - 1));
+  }
+
   // We limit the index space of p such that a correct wrap around happens
   // Check for a wrap around or if we are in unused index space - This has to be checked first!!
   // We are exploiting the wrap around to the correct index
-  uint16_t new_idx = (uint16_t) (idx + offset);
+  tu_fifo_size_t new_idx = (tu_fifo_size_t) (idx + offset);
   if ( (idx > new_idx) || (new_idx >= 2*depth) )
   {
-    uint16_t const non_used_index_space = (uint16_t) (UINT16_MAX - (2*depth-1));
-    new_idx = (uint16_t) (new_idx + non_used_index_space);
+    tu_fifo_size_t const non_used_index_space = (tu_fifo_size_t) (TU_FIFO_SIZE_MAX - (2*depth-1));
+    new_idx = (tu_fifo_size_t) (new_idx + non_used_index_space);
   }
 
   return new_idx;
@@ -370,16 +470,16 @@ static uint16_t advance_index(uint16_t depth, uint16_t idx, uint16_t offset)
 
 #if 0 // not used but
 // Backward an absolute index
-static uint16_t backward_index(uint16_t depth, uint16_t idx, uint16_t offset)
+static tu_fifo_size_t backward_index(tu_fifo_size_t depth, tu_fifo_size_t idx, tu_fifo_size_t offset)
 {
   // We limit the index space of p such that a correct wrap around happens
   // Check for a wrap around or if we are in unused index space - This has to be checked first!!
   // We are exploiting the wrap around to the correct index
-  uint16_t new_idx = (uint16_t) (idx - offset);
+  tu_fifo_size_t new_idx = (tu_fifo_size_t) (idx - offset);
   if ( (idx < new_idx) || (new_idx >= 2*depth) )
   {
-    uint16_t const non_used_index_space = (uint16_t) (UINT16_MAX - (2*depth-1));
-    new_idx = (uint16_t) (new_idx - non_used_index_space);
+    tu_fifo_size_t const non_used_index_space = (tu_fifo_size_t) (TU_FIFO_SIZE_MAX - (2*depth-1));
+    new_idx = (tu_fifo_size_t) (new_idx - non_used_index_space);
   }
 
   return new_idx;
@@ -388,8 +488,13 @@ static uint16_t backward_index(uint16_t depth, uint16_t idx, uint16_t offset)
 
 // index to pointer, simply an modulo with minus.
 TU_ATTR_ALWAYS_INLINE static inline
-uint16_t idx2ptr(uint16_t depth, uint16_t idx)
+tu_fifo_size_t idx2ptr(tu_fifo_size_t depth, tu_fifo_size_t idx)
 {
+  if ( _ff_is_pow2(depth) )
+  {
+    return (tu_fifo_size_t) (idx & (depth - 1));
+  }
+
   // Only run at most 3 times since index is limit in the range of [0..2*depth)
   while ( idx >= depth ) idx -= depth;
   return idx;
@@ -399,10 +504,14 @@ uint16_t idx2ptr(uint16_t depth, uint16_t idx)
 // When an overwritable fifo is overflowed, rd_idx will be re-index so that it forms
 // an full fifo i.e _ff_count() = depth
 TU_ATTR_ALWAYS_INLINE static inline
-uint16_t _ff_correct_read_index(tu_fifo_t* f, uint16_t wr_idx)
+tu_fifo_size_t _ff_correct_read_index(tu_fifo_t* f, tu_fifo_size_t wr_idx)
 {
-  uint16_t rd_idx;
-  if ( wr_idx >= f->depth )
+  tu_fifo_size_t rd_idx;
+  if ( _ff_is_pow2(f->depth) )
+  {
+    // wr_idx +/- depth in index space of 2*depth
+    rd_idx = wr_idx ^ f->depth;
+  }else if ( wr_idx >= f->depth )
   {
     rd_idx = wr_idx - f->depth;
   }else
@@ -415,15 +524,71 @@ uint16_t _ff_correct_read_index(tu_fifo_t* f, uint16_t wr_idx)
   return rd_idx;
 }
 
+//--------------------------------------------------------------------+
+// Statistics and Watermark
+//--------------------------------------------------------------------+
+#if CFG_TUSB_FIFO_STATS
+
+TU_ATTR_WEAK void tu_fifo_watermark_cb(tu_fifo_t* f, bool above_high) {
+  (void) f;
+  (void) above_high;
+}
+
+// fire callback on crossing: rising to high watermark or falling to low watermark (hysteresis)
+static void _ff_check_watermark(tu_fifo_t* f, tu_fifo_size_t cnt)
+{
+  if ( f->wm_high == 0 ) return;
+
+  if ( !f->wm_above && cnt >= f->wm_high )
+  {
+    f->wm_above = true;
+    tu_fifo_watermark_cb(f, true);
+  }
+  else if ( f->wm_above && cnt <= f->wm_low )
+  {
+    f->wm_above = false;
+    tu_fifo_watermark_cb(f, false);
+  }
+}
+
+static void _ff_stats_write(tu_fifo_t* f, tu_fifo_size_t n_req, tu_fifo_size_t n_written)
+{
+  tu_fifo_size_t const cnt = _ff_count(f->depth, f->wr_idx, f->rd_idx);
+
+  f->stats.total_written += n_written;
+
+  // dropped (not enough space) or overwritten (overflowable count exceeds depth)
+  if ( n_written < n_req || cnt > f->depth ) f->stats.overflow_count++;
+
+  tu_fifo_size_t const level = _ff_min(cnt, f->depth);
+  if ( level > f->stats.peak ) f->stats.peak = level;
+
+  _ff_check_watermark(f, level);
+}
+
+static void _ff_stats_read(tu_fifo_t* f)
+{
+  _ff_check_watermark(f, _ff_min(_ff_count(f->depth, f->wr_idx, f->rd_idx), f->depth));
+}
+
+#else
+
+#define _ff_stats_write(_f, _n_req, _n_written)   (void) (_n_req)
+#define _ff_stats_read(_f)
+
+#endif
+
 // Works on local copies of w and r
 // Must be protected by mutexes since in case of an overflow read pointer gets modified
-static bool _tu_fifo_peek(tu_fifo_t* f, void * p_buffer, uint16_t wr_idx, uint16_t rd_idx)
+static bool _tu_fifo_peek(tu_fifo_t* f, void * p_buffer, tu_fifo_size_t wr_idx, tu_fifo_size_t rd_idx)
 {
-  uint16_t cnt = _ff_count(f->depth, wr_idx, rd_idx);
+  tu_fifo_size_t cnt = _ff_count(f->depth, wr_idx, rd_idx);
 
   // nothing to peek
   if ( cnt == 0 ) return false;
 
+  _ff_acquire();
+
   // Check overflow and correct if required
   if ( cnt > f->depth )
   {
@@ -431,7 +596,7 @@ static bool _tu_fifo_peek(tu_fifo_t* f, void * p_buffer, uint16_t wr_idx, uint16
     cnt = f->depth;
   }
 
-  uint16_t rd_ptr = idx2ptr(f->depth, rd_idx);
+  tu_fifo_size_t rd_ptr = idx2ptr(f->depth, rd_idx);
 
   // Peek data
   _ff_pull(f, p_buffer, rd_ptr);
@@ -441,13 +606,15 @@ static bool _tu_fifo_peek(tu_fifo_t* f, void * p_buffer, uint16_t wr_idx, uint16
 
 // Works on local copies of w and r
 // Must be protected by mutexes since in case of an overflow read pointer gets modified
-static uint16_t _tu_fifo_peek_n(tu_fifo_t* f, void * p_buffer, uint16_t n, uint16_t wr_idx, uint16_t rd_idx, tu_fifo_copy_mode_t copy_mode)
+static tu_fifo_size_t _tu_fifo_peek_n(tu_fifo_t* f, void * p_buffer, tu_fifo_size_t n, tu_fifo_size_t wr_idx, tu_fifo_size_t rd_idx, tu_fifo_copy_mode_t copy_mode)
 {
-  uint16_t cnt = _ff_count(f->depth, wr_idx, rd_idx);
+  tu_fifo_size_t cnt = _ff_count(f->depth, wr_idx, rd_idx);
 
   // nothing to peek
   if ( cnt == 0 ) return 0;
 
+  _ff_acquire();
+
   // Check overflow and correct if required
   if ( cnt > f->depth )
   {
@@ -458,7 +625,7 @@ static uint16_t _tu_fifo_peek_n(tu_fifo_t* f, void * p_buffer, uint16_t n, uint1
   // Check if we can read something at and after offset - if too less is available we read what remains
   if ( cnt < n ) n = cnt;
 
-  uint16_t rd_ptr = idx2ptr(f->depth, rd_idx);
+  tu_fifo_size_t rd_ptr = idx2ptr(f->depth, rd_idx);
 
   // Peek data
   _ff_pull_n(f, p_buffer, n, rd_ptr, copy_mode);
@@ -466,14 +633,70 @@ static uint16_t _tu_fifo_peek_n(tu_fifo_t* f, void * p_buffer, uint16_t n, uint1
   return n;
 }
 
-static uint16_t _tu_fifo_write_n(tu_fifo_t* f, const void * data, uint16_t n, tu_fifo_copy_mode_t copy_mode)
+#if CFG_TUSB_FIFO_ISR_SAFE
+// Multiple producers: reserve index space in critical section, copy without it, then publish write index when
+// no other producer (which we may have preempted, or which preempted us) is still copying. Since ISRs nest,
+// the outermost producer is the last one to complete and publishes all reserved data.
+static tu_fifo_size_t _tu_fifo_write_n_isr_safe(tu_fifo_t* f, const void * data, tu_fifo_size_t n)
+{
+  if ( n == 0 ) return 0;
+
+  tu_fifo_size_t const n_req = n;
+
+  uint32_t state = tu_critical_enter();
+
+  // no pending producer: sync reservation with write index, which could be changed by other write API
+  tu_fifo_size_t const wr_idx = f->wr_pending ? f->wr_rsv_idx : f->wr_idx;
+  n = _ff_min(n, _ff_remaining(f->depth, wr_idx, f->rd_idx));
+
+  if ( n )
+  {
+    f->wr_rsv_idx = advance_index(f->depth, wr_idx, n);
+    f->wr_pending++;
+  }
+
+  tu_critical_exit(state);
+
+  if ( n == 0 )
+  {
+    _ff_stats_write(f, n_req, 0);
+    return 0;
+  }
+
+  _ff_acquire();
+  _ff_push_n(f, data, n, idx2ptr(f->depth, wr_idx), TU_FIFO_COPY_INC);
+
+  state = tu_critical_enter();
+
+  if ( 0 == --f->wr_pending )
+  {
+    _ff_release();
+    f->wr_idx = f->wr_rsv_idx;
+  }
+
+  tu_critical_exit(state);
+
+  _ff_stats_write(f, n_req, n);
+
+  return n;
+}
+#endif
+
+static tu_fifo_size_t _tu_fifo_write_n(tu_fifo_t* f, const void * data, tu_fifo_size_t n, tu_fifo_copy_mode_t copy_mode)
 {
   if ( n == 0 ) return 0;
 
+#if CFG_TUSB_FIFO_ISR_SAFE
+  if ( f->isr_safe && copy_mode == TU_FIFO_COPY_INC ) return _tu_fifo_write_n_isr_safe(f, data, n);
+#endif
+
+  tu_fifo_size_t const n_req = n;
+
   _ff_lock(f->mutex_wr);
 
-  uint16_t wr_idx = f->wr_idx;
-  uint16_t rd_idx = f->rd_idx;
+  tu_fifo_size_t wr_idx = f->wr_idx;
+  tu_fifo_size_t rd_idx = f->rd_idx;
+  _ff_acquire();
 
   uint8_t const* buf8 = (uint8_t const*) data;
 
@@ -483,8 +706,8 @@ static uint16_t _tu_fifo_write_n(tu_fifo_t* f, const void * data, uint16_t n, tu
   if ( !f->overwritable )
   {
     // limit up to full
-    uint16_t const remain = _ff_remaining(f->depth, wr_idx, rd_idx);
-    n = tu_min16(n, remain);
+    tu_fifo_size_t const remain = _ff_remaining(f->depth, wr_idx, rd_idx);
+    n = _ff_min(n, remain);
   }
   else
   {
@@ -511,7 +734,7 @@ static uint16_t _tu_fifo_write_n(tu_fifo_t* f, const void * data, uint16_t n, tu
     }
     else
     {
-      uint16_t const overflowable_count = _ff_count(f->depth, wr_idx, rd_idx);
+      tu_fifo_size_t const overflowable_count = _ff_count(f->depth, wr_idx, rd_idx);
       if (overflowable_count + n >= 2*f->depth)
       {
         // Double overflowed
@@ -535,7 +758,7 @@ static uint16_t _tu_fifo_write_n(tu_fifo_t* f, const void * data, uint16_t n, tu
 
   if (n)
   {
-    uint16_t wr_ptr = idx2ptr(f->depth, wr_idx);
+    tu_fifo_size_t wr_ptr = idx2ptr(f->depth, wr_idx);
 
     TU_LOG(TU_FIFO_DBG, "actual_n = %u, wr_ptr = %u", n, wr_ptr);
 
@@ -543,6 +766,7 @@ static uint16_t _tu_fifo_write_n(tu_fifo_t* f, const void * data, uint16_t n, tu
     _ff_push_n(f, buf8, n, wr_ptr, copy_mode);
 
     // Advance index
+    _ff_release();
     f->wr_idx = advance_index(f->depth, wr_idx, n);
 
     TU_LOG(TU_FIFO_DBG, "\tnew_wr = %u\r\n", f->wr_idx);
@@ -550,10 +774,12 @@ static uint16_t _tu_fifo_write_n(tu_fifo_t* f, const void * data, uint16_t n, tu
 
   _ff_unlock(f->mutex_wr);
 
+  _ff_stats_write(f, n_req, n);
+
   return n;
 }
 
-static uint16_t _tu_fifo_read_n(tu_fifo_t* f, void * buffer, uint16_t n, tu_fifo_copy_mode_t copy_mode)
+static tu_fifo_size_t _tu_fifo_read_n(tu_fifo_t* f, void * buffer, tu_fifo_size_t n, tu_fifo_copy_mode_t copy_mode)
 {
   _ff_lock(f->mutex_rd);
 
@@ -562,9 +788,13 @@ static uint16_t _tu_fifo_read_n(tu_fifo_t* f, void * buffer, uint16_t n, tu_fifo
   n = _tu_fifo_peek_n(f, buffer, n, f->wr_idx, f->rd_idx, copy_mode);
 
   // Advance read pointer
+  _ff_release();
   f->rd_idx = advance_index(f->depth, f->rd_idx, n);
 
   _ff_unlock(f->mutex_rd);
+
+  _ff_stats_read(f);
+
   return n;
 }
 
@@ -587,9 +817,9 @@ static uint16_t _tu_fifo_read_n(tu_fifo_t* f, void * buffer, uint16_t n, tu_fifo
     @returns Number of items in FIFO
  */
 /******************************************************************************/
-uint16_t tu_fifo_count(tu_fifo_t* f)
+tu_fifo_size_t tu_fifo_count(tu_fifo_t* f)
 {
-  return tu_min16(_ff_count(f->depth, f->wr_idx, f->rd_idx), f->depth);
+  return _ff_min(_ff_count(f->depth, f->wr_idx, f->rd_idx), f->depth);
 }
 
 /******************************************************************************/
@@ -641,7 +871,7 @@ bool tu_fifo_full(tu_fifo_t* f)
     @returns Number of items in FIFO
  */
 /******************************************************************************/
-uint16_t tu_fifo_remaining(tu_fifo_t* f)
+tu_fifo_size_t tu_fifo_remaining(tu_fifo_t* f)
 {
   return _ff_remaining(f->depth, f->wr_idx, f->rd_idx);
 }
@@ -705,9 +935,13 @@ bool tu_fifo_read(tu_fifo_t* f, void * buffer)
   bool ret = _tu_fifo_peek(f, buffer, f->wr_idx, f->rd_idx);
 
   // Advance pointer
+  _ff_release();
   f->rd_idx = advance_index(f->depth, f->rd_idx, ret);
 
   _ff_unlock(f->mutex_rd);
+
+  _ff_stats_read(f);
+
   return ret;
 }
 
@@ -727,7 +961,7 @@ bool tu_fifo_read(tu_fifo_t* f, void * buffer)
     @returns number of items read from the FIFO
  */
 /******************************************************************************/
-uint16_t tu_fifo_read_n(tu_fifo_t* f, void * buffer, uint16_t n)
+tu_fifo_size_t tu_fifo_read_n(tu_fifo_t* f, void * buffer, tu_fifo_size_t n)
 {
   return _tu_fifo_read_n(f, buffer, n, TU_FIFO_COPY_INC);
 }
@@ -750,12 +984,69 @@ uint16_t tu_fifo_read_n(tu_fifo_t* f, void * buffer, uint16_t n)
     @returns number of items read from the FIFO
  */
 /******************************************************************************/
-uint16_t tu_fifo_read_n_const_addr_full_words(tu_fifo_t* f, void * buffer, uint16_t n)
+tu_fifo_size_t tu_fifo_read_n_const_addr_full_words(tu_fifo_t* f, void * buffer, tu_fifo_size_t n)
 {
   return _tu_fifo_read_n(f, buffer, n, TU_FIFO_COPY_CST_FULL_WORDS);
 }
 #endif
 
+/******************************************************************************/
+/*!
+    @brief Scatter read: read into segments of iov in order under a single lock
+    and a single read index update. Reading stops when fifo is empty.
+
+    @param[in]  f
+                Pointer to the FIFO buffer to manipulate
+    @param[in]  iov
+                Array of segments, length is in number of elements
+    @param[in]  iovcnt
+                Number of segments
+    @return Number of read elements
+ */
+/******************************************************************************/
+tu_fifo_size_t tu_fifo_read_iov(tu_fifo_t* f, tu_iovec_t const* iov, uint8_t iovcnt)
+{
+  _ff_lock(f->mutex_rd);
+
+  tu_fifo_size_t const wr_idx = f->wr_idx;
+  tu_fifo_size_t rd_idx = f->rd_idx;
+  tu_fifo_size_t cnt = _ff_count(f->depth, wr_idx, rd_idx);
+  tu_fifo_size_t total = 0;
+
+  if ( cnt )
+  {
+    _ff_acquire();
+
+    // Check overflow and correct if required
+    if ( cnt > f->depth )
+    {
+      rd_idx = _ff_correct_read_index(f, wr_idx);
+      cnt = f->depth;
+    }
+
+    for(uint8_t i = 0; i < iovcnt && cnt; i++)
+    {
+      tu_fifo_size_t const n = _ff_min(iov[i].iov_len, cnt);
+      if ( n )
+      {
+        _ff_pull_n(f, iov[i].iov_base, n, idx2ptr(f->depth, rd_idx), TU_FIFO_COPY_INC);
+        rd_idx = advance_index(f->depth, rd_idx, n);
+        cnt   -= n;
+        total += n;
+      }
+    }
+
+    _ff_release();
+    f->rd_idx = rd_idx;
+  }
+
+  _ff_unlock(f->mutex_rd);
+
+  _ff_stats_read(f);
+
+  return total;
+}
+
 /******************************************************************************/
 /*!
     @brief Read one item without removing it from the FIFO.
@@ -792,10 +1083,10 @@ bool tu_fifo_peek(tu_fifo_t* f, void * p_buffer)
     @returns Number of bytes written to p_buffer
  */
 /******************************************************************************/
-uint16_t tu_fifo_peek_n(tu_fifo_t* f, void * p_buffer, uint16_t n)
+tu_fifo_size_t tu_fifo_peek_n(tu_fifo_t* f, void * p_buffer, tu_fifo_size_t n)
 {
   _ff_lock(f->mutex_rd);
-  uint16_t ret = _tu_fifo_peek_n(f, p_buffer, n, f->wr_idx, f->rd_idx, TU_FIFO_COPY_INC);
+  tu_fifo_size_t ret = _tu_fifo_peek_n(f, p_buffer, n, f->wr_idx, f->rd_idx, TU_FIFO_COPY_INC);
   _ff_unlock(f->mutex_rd);
   return ret;
 }
@@ -818,22 +1109,28 @@ uint16_t tu_fifo_peek_n(tu_fifo_t* f, void * p_buffer, uint16_t n)
 /******************************************************************************/
 bool tu_fifo_write(tu_fifo_t* f, const void * data)
 {
+#if CFG_TUSB_FIFO_ISR_SAFE
+  if ( f->isr_safe ) return 1 == _tu_fifo_write_n_isr_safe(f, data, 1);
+#endif
+
   _ff_lock(f->mutex_wr);
 
   bool ret;
-  uint16_t const wr_idx = f->wr_idx;
+  tu_fifo_size_t const wr_idx = f->wr_idx;
 
   if ( tu_fifo_full(f) && !f->overwritable )
   {
     ret = false;
   }else
   {
-    uint16_t wr_ptr = idx2ptr(f->depth, wr_idx);
+    tu_fifo_size_t wr_ptr = idx2ptr(f->depth, wr_idx);
+    _ff_acquire();
 
     // Write data
     _ff_push(f, data, wr_ptr);
 
     // Advance pointer
+    _ff_release();
     f->wr_idx = advance_index(f->depth, wr_idx, 1);
 
     ret = true;
@@ -841,6 +1138,8 @@ bool tu_fifo_write(tu_fifo_t* f, const void * data)
 
   _ff_unlock(f->mutex_wr);
 
+  _ff_stats_write(f, 1, ret ? 1 : 0);
+
   return ret;
 }
 
@@ -858,7 +1157,7 @@ bool tu_fifo_write(tu_fifo_t* f, const void * data)
     @return Number of written elements
  */
 /******************************************************************************/
-uint16_t tu_fifo_write_n(tu_fifo_t* f, const void * data, uint16_t n)
+tu_fifo_size_t tu_fifo_write_n(tu_fifo_t* f, const void * data, tu_fifo_size_t n)
 {
   return _tu_fifo_write_n(f, data, n, TU_FIFO_COPY_INC);
 }
@@ -879,12 +1178,202 @@ uint16_t tu_fifo_write_n(tu_fifo_t* f, const void * data, uint16_t n)
     @return Number of written elements
  */
 /******************************************************************************/
-uint16_t tu_fifo_write_n_const_addr_full_words(tu_fifo_t* f, const void * data, uint16_t n)
+tu_fifo_size_t tu_fifo_write_n_const_addr_full_words(tu_fifo_t* f, const void * data, tu_fifo_size_t n)
 {
   return _tu_fifo_write_n(f, data, n, TU_FIFO_COPY_CST_FULL_WORDS);
 }
 #endif
 
+/******************************************************************************/
+/*!
+    @brief Gather write: write all segments of iov as a whole under a single
+    lock and a single write index update, e.g header + payload of a frame.
+    Nothing is written if total length does not fit into remaining space (or
+    fifo depth in overwritable mode).
+
+    @param[in]  f
+                Pointer to the FIFO buffer to manipulate
+    @param[in]  iov
+                Array of segments, length is in number of elements
+    @param[in]  iovcnt
+                Number of segments
+    @return Number of written elements, either total length or 0
+ */
+/******************************************************************************/
+tu_fifo_size_t tu_fifo_write_iov(tu_fifo_t* f, tu_iovec_t const* iov, uint8_t iovcnt)
+{
+  uint32_t total = 0;
+  for(uint8_t i = 0; i < iovcnt; i++) total += iov[i].iov_len;
+
+  if ( total == 0 || total > f->depth ) return 0;
+
+  _ff_lock(f->mutex_wr);
+
+  tu_fifo_size_t wr_idx = f->wr_idx;
+  tu_fifo_size_t rd_idx = f->rd_idx;
+  _ff_acquire();
+
+  if ( !f->overwritable )
+  {
+    if ( total > _ff_remaining(f->depth, wr_idx, rd_idx) )
+    {
+      _ff_unlock(f->mutex_wr);
+      _ff_stats_write(f, (tu_fifo_size_t) total, 0);
+      return 0;
+    }
+  }
+  else if ( _ff_count(f->depth, wr_idx, rd_idx) + total >= 2*f->depth )
+  {
+    // Double overflowed: re-position write index to have a full fifo after pushed, same as tu_fifo_write_n()
+    wr_idx = advance_index(f->depth, rd_idx, (tu_fifo_size_t) (f->depth - total));
+  }
+
+  for(uint8_t i = 0; i < iovcnt; i++)
+  {
+    tu_fifo_size_t const n = iov[i].iov_len;
+    if ( n )
+    {
+      _ff_push_n(f, iov[i].iov_base, n, idx2ptr(f->depth, wr_idx), TU_FIFO_COPY_INC);
+      wr_idx = advance_index(f->depth, wr_idx, n);
+    }
+  }
+
+  // publish all segments at once
+  _ff_release();
+  f->wr_idx = wr_idx;
+
+  _ff_unlock(f->mutex_wr);
+
+  _ff_stats_write(f, (tu_fifo_size_t) total, (tu_fifo_size_t) total);
+
+  return (tu_fifo_size_t) total;
+}
+
+/******************************************************************************/
+/*!
+    @brief Reserve linear free space for zero-copy write. Application writes
+    data directly into the returned buffer then calls tu_fifo_commit(). Space
+    is limited to the linear part i.e up to the end of the buffer, call again
+    after commit to get the wrapped part. Overwritable mode is not applied,
+    only free space can be reserved.
+
+    Write mutex is locked until tu_fifo_commit() is called.
+
+    @param[in]  f
+                Pointer to the FIFO buffer to manipulate
+    @param[out] p_buf
+                Pointer to start of reserved space
+    @param[in]  n
+                Number of items wanted
+
+    @returns Number of items reserved
+ */
+/******************************************************************************/
+tu_fifo_size_t tu_fifo_reserve(tu_fifo_t* f, void** p_buf, tu_fifo_size_t n)
+{
+  _ff_lock(f->mutex_wr);
+
+  tu_fifo_size_t const wr_idx = f->wr_idx;
+  tu_fifo_size_t const rd_idx = f->rd_idx;
+  _ff_acquire();
+
+  tu_fifo_size_t const wr_ptr = idx2ptr(f->depth, wr_idx);
+
+  n = _ff_min(n, _ff_remaining(f->depth, wr_idx, rd_idx));
+  n = _ff_min(n, (tu_fifo_size_t) (f->depth - wr_ptr));
+
+  *p_buf = f->buffer + (wr_ptr * f->item_size);
+
+  return n;
+}
+
+/******************************************************************************/
+/*!
+    @brief Commit n items written to space previously reserved by
+    tu_fifo_reserve() and unlock write mutex.
+
+    @param[in]  f
+                Pointer to the FIFO buffer to manipulate
+    @param[in]  n
+                Number of items written, must not exceed reserved count
+ */
+/******************************************************************************/
+void tu_fifo_commit(tu_fifo_t* f, tu_fifo_size_t n)
+{
+  if (n)
+  {
+    _ff_release();
+    f->wr_idx = advance_index(f->depth, f->wr_idx, n);
+  }
+
+  _ff_unlock(f->mutex_wr);
+
+  _ff_stats_write(f, n, n);
+}
+
+/******************************************************************************/
+/*!
+    @brief Get linear span of readable data for zero-copy read. Application
+    consumes data directly from the returned buffer then calls tu_fifo_release().
+    Span is limited to the linear part, call again after release to get the
+    wrapped part. This function checks for an overflow and corrects read pointer
+    if required.
+
+    Read mutex is locked until tu_fifo_release() is called.
+
+    @param[in]  f
+                Pointer to the FIFO buffer to manipulate
+    @param[out] p_buf
+                Pointer to start of readable data
+
+    @returns Number of items available in the span
+ */
+/******************************************************************************/
+tu_fifo_size_t tu_fifo_peek_span(tu_fifo_t* f, void const** p_buf)
+{
+  _ff_lock(f->mutex_rd);
+
+  tu_fifo_size_t const wr_idx = f->wr_idx;
+  tu_fifo_size_t rd_idx = f->rd_idx;
+  tu_fifo_size_t cnt = _ff_count(f->depth, wr_idx, rd_idx);
+
+  if ( cnt > f->depth )
+  {
+    rd_idx = _ff_correct_read_index(f, wr_idx);
+    cnt = f->depth;
+  }
+  _ff_acquire();
+
+  tu_fifo_size_t const rd_ptr = idx2ptr(f->depth, rd_idx);
+  *p_buf = f->buffer + (rd_ptr * f->item_size);
+
+  return _ff_min(cnt, (tu_fifo_size_t) (f->depth - rd_ptr));
+}
+
+/******************************************************************************/
+/*!
+    @brief Release n items consumed from span returned by tu_fifo_peek_span()
+    and unlock read mutex.
+
+    @param[in]  f
+                Pointer to the FIFO buffer to manipulate
+    @param[in]  n
+                Number of items consumed, must not exceed span count
+ */
+/******************************************************************************/
+void tu_fifo_release(tu_fifo_t* f, tu_fifo_size_t n)
+{
+  if (n)
+  {
+    _ff_release();
+    f->rd_idx = advance_index(f->depth, f->rd_idx, n);
+  }
+
+  _ff_unlock(f->mutex_rd);
+
+  _ff_stats_read(f);
+}
+
 /******************************************************************************/
 /*!
     @brief Clear the fifo read and write pointers
@@ -900,6 +1389,9 @@ bool tu_fifo_clear(tu_fifo_t *f)
 
   f->rd_idx = 0;
   f->wr_idx = 0;
+#if CFG_TUSB_FIFO_STATS
+  f->wm_above = false;
+#endif
 
   _ff_unlock(f->mutex_wr);
   _ff_unlock(f->mutex_rd);
@@ -945,9 +1437,12 @@ bool tu_fifo_set_overwritable(tu_fifo_t *f, bool overwritable)
                 Number of items the write pointer moves forward
  */
 /******************************************************************************/
-void tu_fifo_advance_write_pointer(tu_fifo_t *f, uint16_t n)
+void tu_fifo_advance_write_pointer(tu_fifo_t *f, tu_fifo_size_t n)
 {
+  _ff_release();
   f->wr_idx = advance_index(f->depth, f->wr_idx, n);
+
+  _ff_stats_write(f, n, n);
 }
 
 /******************************************************************************/
@@ -966,9 +1461,12 @@ void tu_fifo_advance_write_pointer(tu_fifo_t *f, uint16_t n)
                 Number of items the read pointer moves forward
  */
 /******************************************************************************/
-void tu_fifo_advance_read_pointer(tu_fifo_t *f, uint16_t n)
+void tu_fifo_advance_read_pointer(tu_fifo_t *f, tu_fifo_size_t n)
 {
+  _ff_release();
   f->rd_idx = advance_index(f->depth, f->rd_idx, n);
+
+  _ff_stats_read(f);
 }
 
 /******************************************************************************/
@@ -989,10 +1487,11 @@ void tu_fifo_advance_read_pointer(tu_fifo_t *f, uint16_t n)
 void tu_fifo_get_read_info(tu_fifo_t *f, tu_fifo_buffer_info_t *info)
 {
   // Operate on temporary values in case they change in between
-  uint16_t wr_idx = f->wr_idx;
-  uint16_t rd_idx = f->rd_idx;
+  tu_fifo_size_t wr_idx = f->wr_idx;
+  tu_fifo_size_t rd_idx = f->rd_idx;
+  _ff_acquire();
 
-  uint16_t cnt = _ff_count(f->depth, wr_idx, rd_idx);
+  tu_fifo_size_t cnt = _ff_count(f->depth, wr_idx, rd_idx);
 
   // Check overflow and correct if required - may happen in case a DMA wrote too fast
   if (cnt > f->depth)
@@ -1015,8 +1514,8 @@ void tu_fifo_get_read_info(tu_fifo_t *f, tu_fifo_buffer_info_t *info)
   }
 
   // Get relative pointers
-  uint16_t wr_ptr = idx2ptr(f->depth, wr_idx);
-  uint16_t rd_ptr = idx2ptr(f->depth, rd_idx);
+  tu_fifo_size_t wr_ptr = idx2ptr(f->depth, wr_idx);
+  tu_fifo_size_t rd_ptr = idx2ptr(f->depth, rd_idx);
 
   // Copy pointer to buffer to start reading from
   info->ptr_lin = &f->buffer[rd_ptr];
@@ -1056,9 +1555,10 @@ void tu_fifo_get_read_info(tu_fifo_t *f, tu_fifo_buffer_info_t *info)
 /******************************************************************************/
 void tu_fifo_get_write_info(tu_fifo_t *f, tu_fifo_buffer_info_t *info)
 {
-  uint16_t wr_idx = f->wr_idx;
-  uint16_t rd_idx = f->rd_idx;
-  uint16_t remain = _ff_remaining(f->depth, wr_idx, rd_idx);
+  tu_fifo_size_t wr_idx = f->wr_idx;
+  tu_fifo_size_t rd_idx = f->rd_idx;
+  _ff_acquire();
+  tu_fifo_size_t remain = _ff_remaining(f->depth, wr_idx, rd_idx);
 
   if (remain == 0)
   {
@@ -1070,8 +1570,8 @@ void tu_fifo_get_write_info(tu_fifo_t *f, tu_fifo_buffer_info_t *info)
   }
 
   // Get relative pointers
-  uint16_t wr_ptr = idx2ptr(f->depth, wr_idx);
-  uint16_t rd_ptr = idx2ptr(f->depth, rd_idx);
+  tu_fifo_size_t wr_ptr = idx2ptr(f->depth, wr_idx);
+  tu_fifo_size_t rd_ptr = idx2ptr(f->depth, rd_idx);
 
   // Copy pointer to buffer to start writing to
   info->ptr_lin = &f->buffer[wr_ptr];
@@ -48,6 +48,24 @@ extern "C" {
 // for OS None, we don't get preempted
 #define CFG_FIFO_MUTEX      OSAL_MUTEX_REQUIRED
 
+// Mutex is only required when there are multiple writers (or readers) e.g several RTOS tasks. A fifo without
+// mutex on a side (NULL or not configured) is lock-free on that side: with exactly one producer and one consumer
+// (SPSC) e.g application task and USB task/ISR, indexes are published with acquire/release barriers and no lock
+// is taken.
+
+// Index and item count type: 16-bit by default limiting depth to 32K items, 32-bit with CFG_TUSB_FIFO_INDEX_32BIT
+// for large fifo in external RAM e.g high speed video or mass storage bridge.
+#if CFG_TUSB_FIFO_INDEX_32BIT
+typedef uint32_t tu_fifo_size_t;
+#define TU_FIFO_SIZE_MAX    UINT32_MAX
+#else
+typedef uint16_t tu_fifo_size_t;
+#define TU_FIFO_SIZE_MAX    UINT16_MAX
+#endif
+
+// Index space is 2*depth
+#define TU_FIFO_DEPTH_MAX   (TU_FIFO_SIZE_MAX/2 + 1)
+
 /* Write/Read index is always in the range of:
  *      0 .. 2*depth-1
  * The extra window allow us to determine the fifo state of empty or full with only 2 indices
@@ -103,32 +121,57 @@ extern "C" {
  *      -------------------------
  *      | R | 1 | 2 | W | 4 | 5 |
  */
+typedef struct {
+  tu_fifo_size_t peak      ; // highest fill level
+  uint32_t overflow_count  ; // number of writes that dropped (not enough space) or overwrote items
+  uint32_t total_written   ; // total written items
+} tu_fifo_stats_t;
+
 typedef struct {
   uint8_t* buffer          ; // buffer pointer
-  uint16_t depth           ; // max items
+  tu_fifo_size_t depth     ; // max items
 
   struct TU_ATTR_PACKED {
     uint16_t item_size : 15; // size of each item
     bool overwritable  : 1 ; // ovwerwritable when full
   };
 
-  volatile uint16_t wr_idx ; // write index
-  volatile uint16_t rd_idx ; // read index
+  volatile tu_fifo_size_t wr_idx; // write index
+  volatile tu_fifo_size_t rd_idx; // read index
 
 #if OSAL_MUTEX_REQUIRED
   osal_mutex_t mutex_wr;
   osal_mutex_t mutex_rd;
 #endif
 
+#if CFG_TUSB_FIFO_ISR_SAFE
+  volatile tu_fifo_size_t wr_rsv_idx; // reserved write index, ahead of wr_idx while producers are copying
+  volatile uint8_t wr_pending;        // number of producers copying data
+  bool isr_safe;                      // multiple producers (tasks and ISRs) write with critical section
+#endif
+
+#if CFG_TUSB_FIFO_STATS
+  tu_fifo_stats_t stats;
+  tu_fifo_size_t wm_high;             // high watermark, 0 is disabled
+  tu_fifo_size_t wm_low;              // low watermark
+  volatile bool wm_above;             // level has reached high watermark and not yet fallen to low watermark
+#endif
+
 } tu_fifo_t;
 
 typedef struct {
-  uint16_t len_lin  ; ///< linear length in item size
-  uint16_t len_wrap ; ///< wrapped length in item size
-  void * ptr_lin    ; ///< linear part start pointer
-  void * ptr_wrap   ; ///< wrapped part start pointer
+  tu_fifo_size_t len_lin  ; ///< linear length in item size
+  tu_fifo_size_t len_wrap ; ///< wrapped length in item size
+  void * ptr_lin          ; ///< linear part start pointer
+  void * ptr_wrap         ; ///< wrapped part start pointer
 } tu_fifo_buffer_info_t;
 
+// Segment for scatter/gather read/write, length is in number of items
+typedef struct {
+  void*          iov_base;
+  tu_fifo_size_t iov_len;
+} tu_iovec_t;
+
 #define TU_FIFO_INIT(_buffer, _depth, _type, _overwritable){\
   .buffer               = _buffer,                          \
   .depth                = _depth,                           \
@@ -140,9 +183,30 @@ typedef struct {
     uint8_t _name##_buf[_depth*sizeof(_type)];                                \
     tu_fifo_t _name = TU_FIFO_INIT(_name##_buf, _depth, _type, _overwritable)
 
-bool tu_fifo_set_overwritable(tu_fifo_t *f, bool overwritable);
-bool tu_fifo_clear(tu_fifo_t *f);
-bool tu_fifo_config(tu_fifo_t *f, void* buffer, uint16_t depth, uint16_t item_size, bool overwritable);
+// Same as TU_FIFO_DEF() but enforce power-of-two depth at compile time, which uses faster mask-based index wrapping
+#define TU_FIFO_DEF_POW2(_name, _depth, _type, _overwritable)                 \
+    TU_VERIFY_STATIC(((_depth) & ((_depth) - 1)) == 0, "fifo depth must be power of 2"); \
+    TU_FIFO_DEF(_name, _depth, _type, _overwritable)
+
+bool           tu_fifo_set_overwritable       (tu_fifo_t *f, bool overwritable);
+bool           tu_fifo_clear                  (tu_fifo_t *f);
+bool           tu_fifo_config                 (tu_fifo_t *f, void* buffer, tu_fifo_size_t depth, uint16_t item_size, bool overwritable);
+
+#if CFG_TUSB_FIFO_ISR_SAFE
+// Critical section provided by port/application e.g disable interrupts and return previous PRIMASK.
+// Must support nesting i.e exit restores the state returned by enter.
+uint32_t tu_critical_enter(void);
+void     tu_critical_exit(uint32_t state);
+
+// Enable ISR-safe multi-producer write: write index is reserved within a short critical section, data is copied
+// outside of it and published when the last (outermost) producer completes. Write mutex is not used. Item is
+// never overwritten in this mode even if fifo is overwritable.
+// Note: Only tu_fifo_write() and tu_fifo_write_n() are ISR-safe, other write APIs must not be used concurrently.
+TU_ATTR_ALWAYS_INLINE static inline
+void tu_fifo_set_isr_safe(tu_fifo_t *f, bool isr_safe) {
+  f->isr_safe = isr_safe;
+}
+#endif
 
 #if OSAL_MUTEX_REQUIRED
 TU_ATTR_ALWAYS_INLINE static inline
@@ -154,37 +218,84 @@ void tu_fifo_config_mutex(tu_fifo_t *f, osal_mutex_t wr_mutex, osal_mutex_t rd_m
 #define tu_fifo_config_mutex(_f, _wr_mutex, _rd_mutex)
 #endif
 
-bool     tu_fifo_write                  (tu_fifo_t* f, void const * data);
-uint16_t tu_fifo_write_n                (tu_fifo_t* f, void const * data, uint16_t n);
+bool           tu_fifo_write                  (tu_fifo_t* f, void const * data);
+tu_fifo_size_t tu_fifo_write_n                (tu_fifo_t* f, void const * data, tu_fifo_size_t n);
 #ifdef TUP_MEM_CONST_ADDR
-uint16_t tu_fifo_write_n_const_addr_full_words    (tu_fifo_t* f, const void * data, uint16_t n);
+tu_fifo_size_t tu_fifo_write_n_const_addr_full_words (tu_fifo_t* f, const void * data, tu_fifo_size_t n);
 #endif
 
-bool     tu_fifo_read                   (tu_fifo_t* f, void * buffer);
-uint16_t tu_fifo_read_n                 (tu_fifo_t* f, void * buffer, uint16_t n);
+bool           tu_fifo_read                   (tu_fifo_t* f, void * buffer);
+tu_fifo_size_t tu_fifo_read_n                 (tu_fifo_t* f, void * buffer, tu_fifo_size_t n);
 #ifdef TUP_MEM_CONST_ADDR
-uint16_t tu_fifo_read_n_const_addr_full_words     (tu_fifo_t* f, void * buffer, uint16_t n);
+tu_fifo_size_t tu_fifo_read_n_const_addr_full_words (tu_fifo_t* f, void * buffer, tu_fifo_size_t n);
 #endif
 
-bool     tu_fifo_peek                   (tu_fifo_t* f, void * p_buffer);
-uint16_t tu_fifo_peek_n                 (tu_fifo_t* f, void * p_buffer, uint16_t n);
+// Scatter/gather: all segments are written as a whole (or nothing) with a single lock and index update
+tu_fifo_size_t tu_fifo_write_iov              (tu_fifo_t* f, tu_iovec_t const* iov, uint8_t iovcnt);
+tu_fifo_size_t tu_fifo_read_iov               (tu_fifo_t* f, tu_iovec_t const* iov, uint8_t iovcnt);
+
+bool           tu_fifo_peek                   (tu_fifo_t* f, void * p_buffer);
+tu_fifo_size_t tu_fifo_peek_n                 (tu_fifo_t* f, void * p_buffer, tu_fifo_size_t n);
 
-uint16_t tu_fifo_count                  (tu_fifo_t* f);
-uint16_t tu_fifo_remaining              (tu_fifo_t* f);
-bool     tu_fifo_empty                  (tu_fifo_t* f);
-bool     tu_fifo_full                   (tu_fifo_t* f);
-bool     tu_fifo_overflowed             (tu_fifo_t* f);
-void     tu_fifo_correct_read_pointer   (tu_fifo_t* f);
+tu_fifo_size_t tu_fifo_count                  (tu_fifo_t* f);
+tu_fifo_size_t tu_fifo_remaining              (tu_fifo_t* f);
+bool           tu_fifo_empty                  (tu_fifo_t* f);
+bool           tu_fifo_full                   (tu_fifo_t* f);
+bool           tu_fifo_overflowed             (tu_fifo_t* f);
+void           tu_fifo_correct_read_pointer   (tu_fifo_t* f);
 
 TU_ATTR_ALWAYS_INLINE static inline
-uint16_t tu_fifo_depth(tu_fifo_t* f) {
+tu_fifo_size_t tu_fifo_depth(tu_fifo_t* f) {
   return f->depth;
 }
 
+#if CFG_TUSB_FIFO_STATS
+// Invoked when fill level rises to high watermark (above_high = true) or then falls to low watermark
+// (above_high = false). Invoked from context of the writer/reader i.e could be ISR.
+void tu_fifo_watermark_cb(tu_fifo_t* f, bool above_high);
+
+// Set watermarks for tu_fifo_watermark_cb(), high = 0 to disable
+TU_ATTR_ALWAYS_INLINE static inline
+void tu_fifo_set_watermark(tu_fifo_t* f, tu_fifo_size_t high, tu_fifo_size_t low) {
+  f->wm_high  = high;
+  f->wm_low   = low;
+  f->wm_above = false;
+}
+
+// Flag alternative to tu_fifo_watermark_cb(): true once level reached high watermark until it falls to low
+TU_ATTR_ALWAYS_INLINE static inline
+bool tu_fifo_above_watermark(tu_fifo_t* f) {
+  return f->wm_above;
+}
+
+// Statistics are updated without lock, values can be slightly off with concurrent writers
+TU_ATTR_ALWAYS_INLINE static inline
+tu_fifo_stats_t const* tu_fifo_get_stats(tu_fifo_t* f) {
+  return &f->stats;
+}
+
+TU_ATTR_ALWAYS_INLINE static inline
+void tu_fifo_clear_stats(tu_fifo_t* f) {
+  tu_memclr(&f->stats, sizeof(tu_fifo_stats_t));
+}
+#endif
+
+// Zero-copy write: reserve up to n items of linear free space at write pointer, return number of items
+// reserved and its start in *p_buf (can be less than n at wrap-around, call again after commit for the
+// wrapped part). Write mutex is held until tu_fifo_commit() which MUST be called, even with n = 0.
+tu_fifo_size_t tu_fifo_reserve   (tu_fifo_t* f, void** p_buf, tu_fifo_size_t n);
+void           tu_fifo_commit    (tu_fifo_t* f, tu_fifo_size_t n);
+
+// Zero-copy read: get linear span of readable items at read pointer, return number of items and its start
+// in *p_buf (call again after release for the wrapped part). Read mutex is held until tu_fifo_release()
+// which MUST be called, even with n = 0.
+tu_fifo_size_t tu_fifo_peek_span (tu_fifo_t* f, void const** p_buf);
+void           tu_fifo_release   (tu_fifo_t* f, tu_fifo_size_t n);
+
 // Pointer modifications intended to be used in combinations with DMAs.
 // USE WITH CARE - NO SAFETY CHECKS CONDUCTED HERE! NOT MUTEX PROTECTED!
-void tu_fifo_advance_write_pointer(tu_fifo_t *f, uint16_t n);
-void tu_fifo_advance_read_pointer (tu_fifo_t *f, uint16_t n);
+void tu_fifo_advance_write_pointer(tu_fifo_t *f, tu_fifo_size_t n);
+void tu_fifo_advance_read_pointer (tu_fifo_t *f, tu_fifo_size_t n);
 
 // If you want to read/write from/to the FIFO by use of a DMA, you may need to conduct two copies
 // to handle a possible wrapping part. These functions deliver a pointer to start
@@ -537,6 +537,13 @@
   #define TUP_RHPORT_HIGHSPEED    1
   #define TUD_ENDPOINT_ONE_DIRECTION_ONLY
 
+//--------------------------------------------------------------------+
+// Host-native simulation
+//--------------------------------------------------------------------+
+#elif TU_CHECK_MCU(OPT_MCU_SIM)
+  #define TUP_DCD_ENDPOINT_MAX    16
+  #define TUP_RHPORT_HIGHSPEED    1
+
 #endif
 
 //--------------------------------------------------------------------+
@@ -578,6 +585,12 @@
   #define TUP_DCD_EDPT_ISO_ALLOC
 #endif
 
+// USBIP that implements dcd_edpt_xfer_fifo() i.e transfer to/from ring buffer without intermediate linear buffer
+#if defined(TUP_USBIP_DWC2) || defined(TUP_USBIP_FSDEV) || defined(TUP_USBIP_RUSB2) || \
+    defined(TUP_USBIP_CHIPIDEA_HS) || defined(TUP_USBIP_MUSB)
+  #define TUP_DCD_EDPT_XFER_FIFO
+#endif
+
 #if defined(TUP_USBIP_DWC2) // && CFG_TUD_DWC2_DMA_ENABLE == 0
   #define TUP_MEM_CONST_ADDR
 #endif
@@ -46,15 +46,43 @@ typedef struct TU_ATTR_PACKED {
   volatile uint8_t claimed : 1;
 }tu_edpt_state_t;
 
+// Write coalescing: pending bytes are flushed once threshold is reached, or after timeout frames since the first
+// unflushed byte. Timeout is ticked by class driver SOF handler, which then defers the flush to usbd task.
+typedef struct {
+  uint16_t threshold;          // 0: endpoint packet size
+  uint16_t timeout;            // in frames (ms), 0: disabled
+  volatile uint16_t countdown; // frames left before flush, 0: not armed
+  uint16_t last_frame;
+}tu_edpt_coalesce_t;
+
+// Zero-length packet policy when a write transfer ends on packet boundary with no pending data
+typedef enum {
+  TU_EDPT_STREAM_ZLP_AUTO = 0, // send ZLP immediately
+  TU_EDPT_STREAM_ZLP_DEFER,    // hold off ZLP, dropped if more data is written before next flush or coalescing timeout
+  TU_EDPT_STREAM_ZLP_NEVER,    // protocol delimits its own transfers
+} tu_edpt_stream_zlp_t;
+
 typedef struct {
   struct TU_ATTR_PACKED  {
     uint8_t is_host   : 1; // 1: host, 0: device
-    uint8_t is_mps512 : 1; // 1: 512, 0: 64 since stream is used for Bulk only
+    uint8_t is_pingpong : 1; // tx: ep_buf is split into two halves of ep_bufsize
+    uint8_t pp_idx      : 1; // tx: half of ep_buf used by next transfer
+    uint8_t zlp_policy  : 2; // tx: tu_edpt_stream_zlp_t
+    uint8_t zlp_pending : 1; // tx: deferred ZLP is owed to the host
   };
   uint8_t ep_addr;
+  uint16_t mps;         // endpoint max packet size
   uint16_t ep_bufsize;
 
-  uint8_t* ep_buf; // TODO xfer_fifo can skip this buffer
+  uint8_t zc_align;     // tx: zero-copy transfer from FIFO if its linear part is aligned to this, 0 is disabled
+  uint16_t zc_inflight; // tx: bytes of FIFO currently on the wire with zero-copy
+
+  uint16_t rx_parked_ofs; // rx: received bytes not fitting FIFO are parked in ep_buf from this offset
+  uint16_t rx_parked_len;
+
+  tu_edpt_coalesce_t tx_coalesce;
+
+  uint8_t* ep_buf; // bounce buffer, can be NULL for tx with zero-copy of no alignment requirement
   tu_fifo_t ff;
 
   // mutex: read if rx, otherwise write
@@ -62,6 +90,39 @@ typedef struct {
 
 }tu_edpt_stream_t;
 
+// Stream role is fixed if only one of device or host stack is enabled, branches on it are then resolved at compile time
+TU_ATTR_ALWAYS_INLINE static inline bool tu_edpt_stream_is_host(tu_edpt_stream_t const* s) {
+#if CFG_TUD_ENABLED && CFG_TUH_ENABLED
+  return s->is_host;
+#else
+  (void) s;
+  return CFG_TUH_ENABLED;
+#endif
+}
+
+// Priority of deferred function call, higher priority pending calls are invoked first
+typedef enum {
+  TU_DEFER_PRIO_HIGH = 0,
+  TU_DEFER_PRIO_NORMAL,
+  TU_DEFER_PRIO_LOW,
+} tu_defer_prio_t;
+
+typedef struct {
+  osal_task_func_t func; // NULL if free
+  void* param;
+  uint16_t seq;          // submission order within the same priority
+  uint8_t prio;
+} tu_defer_entry_t;
+
+// Pool of pending deferred function calls. A single wake-up event is queued for the whole pool, so that deferred
+// work does not take up event queue slots needed by hardware events. Caller provides locking.
+typedef struct {
+  tu_defer_entry_t* entries;
+  uint8_t size;
+  bool kicked;           // wake-up event is queued and not yet handled
+  uint16_t seq;
+} tu_defer_pool_t;
+
 //--------------------------------------------------------------------+
 // Endpoint
 //--------------------------------------------------------------------+
@@ -81,13 +142,60 @@ bool tu_edpt_claim(tu_edpt_state_t* ep_state, osal_mutex_t mutex);
 // Release an endpoint with provided mutex
 bool tu_edpt_release(tu_edpt_state_t* ep_state, osal_mutex_t mutex);
 
+//--------------------------------------------------------------------+
+// Write Coalescing
+//--------------------------------------------------------------------+
+
+// Get number of pending bytes that should trigger a flush
+TU_ATTR_ALWAYS_INLINE static inline
+uint16_t tu_edpt_coalesce_threshold(tu_edpt_coalesce_t const* c, uint16_t mps) {
+  return c->threshold ? c->threshold : mps;
+}
+
+// Start timeout countdown if not armed yet, called when pending bytes are left in fifo
+TU_ATTR_ALWAYS_INLINE static inline
+void tu_edpt_coalesce_arm(tu_edpt_coalesce_t* c) {
+  if (c->timeout && !c->countdown) {
+    c->countdown = c->timeout;
+  }
+}
+
+TU_ATTR_ALWAYS_INLINE static inline
+void tu_edpt_coalesce_disarm(tu_edpt_coalesce_t* c) {
+  c->countdown = 0;
+}
+
+// Called on every SOF (in ISR), return true once the timeout expires. Highspeed micro-frames with the same frame
+// number only count once.
+TU_ATTR_ALWAYS_INLINE static inline
+bool tu_edpt_coalesce_tick(tu_edpt_coalesce_t* c, uint32_t frame_count) {
+  uint16_t const frame = (uint16_t) frame_count;
+  if (!c->countdown || frame == c->last_frame) {
+    return false;
+  }
+  c->last_frame = frame;
+  c->countdown--;
+  return 0 == c->countdown;
+}
+
+//--------------------------------------------------------------------+
+// Deferred Function Call Pool
+//--------------------------------------------------------------------+
+
+// Add a call, a pending call with the same func and param is coalesced (and raised to the higher priority).
+// Return false if pool is full. *kick is set if caller must queue a wake-up event for the pool.
+bool tu_defer_pool_add(tu_defer_pool_t* pool, osal_task_func_t func, void* param, uint8_t prio, bool* kick);
+
+// Remove the pending call to invoke next: highest priority, oldest first. Return false if there is none
+bool tu_defer_pool_take(tu_defer_pool_t* pool, osal_task_func_t* func, void** param);
+
 //--------------------------------------------------------------------+
 // Endpoint Stream
 //--------------------------------------------------------------------+
 
 // Init an endpoint stream
 bool tu_edpt_stream_init(tu_edpt_stream_t* s, bool is_host, bool is_tx, bool overwritable,
-                         void* ff_buf, uint16_t ff_bufsize, uint8_t* ep_buf, uint16_t ep_bufsize);
+                         void* ff_buf, uint32_t ff_bufsize, uint8_t* ep_buf, uint16_t ep_bufsize);
 
 // Deinit an endpoint stream
 bool tu_edpt_stream_deinit(tu_edpt_stream_t* s);
@@ -96,8 +204,20 @@ bool tu_edpt_stream_deinit(tu_edpt_stream_t* s);
 TU_ATTR_ALWAYS_INLINE static inline
 void tu_edpt_stream_open(tu_edpt_stream_t* s, tusb_desc_endpoint_t const *desc_ep) {
   tu_fifo_clear(&s->ff);
+  s->zc_inflight = 0;
+  s->rx_parked_len = 0;
+  tu_edpt_coalesce_disarm(&s->tx_coalesce);
+  s->zlp_pending = 0;
   s->ep_addr = desc_ep->bEndpointAddress;
-  s->is_mps512 = (tu_edpt_packet_size(desc_ep) == 512) ? 1 : 0;
+  s->mps = tu_edpt_packet_size(desc_ep);
+}
+
+// Override packet size from endpoint descriptor e.g 1024 for SuperSpeed bridge behind a highspeed endpoint
+TU_ATTR_ALWAYS_INLINE static inline
+bool tu_edpt_stream_set_mps(tu_edpt_stream_t* s, uint16_t mps) {
+  TU_VERIFY(mps);
+  s->mps = mps;
+  return true;
 }
 
 TU_ATTR_ALWAYS_INLINE static inline
@@ -105,9 +225,20 @@ void tu_edpt_stream_close(tu_edpt_stream_t* s) {
   s->ep_addr = 0;
 }
 
-// Clear fifo
+// Replace FIFO buffer e.g allocated from a pool when opened, FIFO is emptied. Mutex (if any) is kept
+TU_ATTR_ALWAYS_INLINE static inline
+bool tu_edpt_stream_set_fifo(tu_edpt_stream_t* s, void* ff_buf, uint32_t ff_bufsize) {
+  s->rx_parked_len = 0;
+  return tu_fifo_config(&s->ff, ff_buf, (tu_fifo_size_t) ff_bufsize, 1, s->ff.overwritable);
+}
+
+// Clear fifo. Bytes of a zero-copy transfer in flight are dropped as well: its completion must not advance the
+// (cleared) fifo read pointer
 TU_ATTR_ALWAYS_INLINE static inline
 bool tu_edpt_stream_clear(tu_edpt_stream_t* s) {
+  s->zc_inflight = 0;
+  s->rx_parked_ofs = 0;
+  s->rx_parked_len = 0;
   return tu_fifo_clear(&s->ff);
 }
 
@@ -121,6 +252,35 @@ uint32_t tu_edpt_stream_write(uint8_t hwid, tu_edpt_stream_t* s, void const *buf
 // Start an usb transfer if endpoint is not busy
 uint32_t tu_edpt_stream_write_xfer(uint8_t hwid, tu_edpt_stream_t* s);
 
+// Enable double-buffered (ping-pong) transmit: ep_buf is split into two halves, the next one is filled from FIFO
+// and queued while the other is on the wire. Device only, require CFG_TUD_EDPT_XFER_QUEUE and a FIFO.
+// Return false (stream is unchanged) if not supported
+bool tu_edpt_stream_write_set_pingpong(tu_edpt_stream_t* s, bool enabled);
+
+// Enable zero-copy transmit: FIFO linear part is submitted to endpoint directly instead of copying to ep_buf.
+// FIFO buffer must then meet DCD requirement (CFG_TUD_MEM_SECTION). ep_buf is only used as fallback when FIFO
+// read pointer is not aligned to align, and can be NULL if align is 1. align = 0 to disable.
+bool tu_edpt_stream_write_set_zerocopy(tu_edpt_stream_t* s, uint8_t align);
+
+// Configure write coalescing: transfer is started once threshold bytes (0: packet size) are queued, or timeout_ms
+// after the first unflushed byte (0: explicit flush only). Timeout requires tu_edpt_stream_write_tick() on every SOF.
+bool tu_edpt_stream_write_set_coalesce(tu_edpt_stream_t* s, uint16_t threshold, uint16_t timeout_ms);
+
+// Tick coalescing timeout, must be called on every SOF (in ISR). Return true if pending data should be flushed
+// with tu_edpt_stream_write_xfer() (in task context)
+TU_ATTR_ALWAYS_INLINE static inline
+bool tu_edpt_stream_write_tick(tu_edpt_stream_t* s, uint32_t frame_count) {
+  return tu_edpt_coalesce_tick(&s->tx_coalesce, frame_count);
+}
+
+// Set zero-length packet policy, default is TU_EDPT_STREAM_ZLP_AUTO. With TU_EDPT_STREAM_ZLP_DEFER the owed ZLP is sent
+// by the next tu_edpt_stream_write_xfer() that finds no data, e.g on coalescing timeout or explicit flush
+TU_ATTR_ALWAYS_INLINE static inline
+void tu_edpt_stream_write_set_zlp(tu_edpt_stream_t* s, tu_edpt_stream_zlp_t policy) {
+  s->zlp_policy = (uint8_t) (policy & 0x03u);
+  s->zlp_pending = 0;
+}
+
 // Start an zero-length packet if needed
 bool tu_edpt_stream_write_zlp_if_needed(uint8_t hwid, tu_edpt_stream_t* s, uint32_t last_xferred_bytes);
 
@@ -128,6 +288,13 @@ bool tu_edpt_stream_write_zlp_if_needed(uint8_t hwid, tu_edpt_stream_t* s, uint3
 // Note: if no fifo, return endpoint size if not busy, 0 otherwise
 uint32_t tu_edpt_stream_write_available(uint8_t hwid, tu_edpt_stream_t* s);
 
+// Zero-copy write: reserve linear space in FIFO, return reserved size. Must be followed by
+// tu_edpt_stream_write_commit() with number of bytes actually written. Return 0 if stream has no fifo.
+uint32_t tu_edpt_stream_write_reserve(tu_edpt_stream_t* s, void** p_buf, uint32_t bufsize);
+
+// Commit bytes written to reserved space, transfer is started if packet size is queued
+uint32_t tu_edpt_stream_write_commit(uint8_t hwid, tu_edpt_stream_t* s, uint32_t count);
+
 //--------------------------------------------------------------------+
 // Stream Read
 //--------------------------------------------------------------------+
@@ -138,26 +305,38 @@ uint32_t tu_edpt_stream_read(uint8_t hwid, tu_edpt_stream_t* s, void* buffer, ui
 // Start an usb transfer if endpoint is not busy
 uint32_t tu_edpt_stream_read_xfer(uint8_t hwid, tu_edpt_stream_t* s);
 
-// Must be called in the transfer complete callback
-TU_ATTR_ALWAYS_INLINE static inline
-void tu_edpt_stream_read_xfer_complete(tu_edpt_stream_t* s, uint32_t xferred_bytes) {
-  if (tu_fifo_depth(&s->ff)) {
-    tu_fifo_write_n(&s->ff, s->ep_buf, (uint16_t) xferred_bytes);
-  }
-}
+// Same as tu_edpt_stream_read_xfer(), in_isr must be true when called from device class driver's xfer_isr()
+uint32_t tu_edpt_stream_read_xfer_ex(uint8_t hwid, tu_edpt_stream_t* s, bool in_isr);
 
-// Same as tu_edpt_stream_read_xfer_complete but skip the first n bytes
+// Same as tu_edpt_stream_read_xfer_complete but skip the first n bytes.
+// Bytes not fitting into FIFO are parked in ep_buf, and moved to FIFO on later tu_edpt_stream_read()
 TU_ATTR_ALWAYS_INLINE static inline
 void tu_edpt_stream_read_xfer_complete_offset(tu_edpt_stream_t* s, uint32_t xferred_bytes, uint32_t skip_offset) {
   if (tu_fifo_depth(&s->ff) && (skip_offset < xferred_bytes)) {
-    tu_fifo_write_n(&s->ff, s->ep_buf + skip_offset, (uint16_t) (xferred_bytes - skip_offset));
+    uint16_t const len = (uint16_t) (xferred_bytes - skip_offset);
+    uint16_t const count = (uint16_t) tu_fifo_write_n(&s->ff, s->ep_buf + skip_offset, len);
+    if (count < len) {
+      s->rx_parked_ofs = (uint16_t) (skip_offset + count);
+      s->rx_parked_len = (uint16_t) (len - count);
+    }
   }
 }
 
+// Same as tu_edpt_stream_read_xfer_complete but for vendor framing where every packet starts with a hdr_len header
+// (e.g FTDI status bytes). Headers of all packets are stripped while writing payload to FIFO in one pass, only payload
+// not fitting into FIFO is compacted and parked. Return number of payload bytes
+uint32_t tu_edpt_stream_read_xfer_complete_framed(tu_edpt_stream_t* s, uint32_t xferred_bytes, uint8_t hdr_len);
+
+// Must be called in the transfer complete callback
+TU_ATTR_ALWAYS_INLINE static inline
+void tu_edpt_stream_read_xfer_complete(tu_edpt_stream_t* s, uint32_t xferred_bytes) {
+  tu_edpt_stream_read_xfer_complete_offset(s, xferred_bytes, 0);
+}
+
 // Get the number of bytes available for reading
 TU_ATTR_ALWAYS_INLINE static inline
 uint32_t tu_edpt_stream_read_available(tu_edpt_stream_t* s) {
-  return (uint32_t) tu_fifo_count(&s->ff);
+  return (uint32_t) tu_fifo_count(&s->ff) + s->rx_parked_len;
 }
 
 TU_ATTR_ALWAYS_INLINE static inline
@@ -68,7 +68,9 @@
 // TU_VERIFY Helper
 //--------------------------------------------------------------------+
 
-#if CFG_TUSB_DEBUG
+#if CFG_TUSB_DEBUG && CFG_TUSB_DEBUG_TRACE
+  #define TU_MESS_FAILED()    tu_trace_log(2, "%s %d: ASSERT FAILED\r\n", __func__, __LINE__)
+#elif CFG_TUSB_DEBUG
   #include <stdio.h>
   #define TU_MESS_FAILED()    tu_printf("%s %d: ASSERT FAILED\r\n", __func__, __LINE__)
 #else
@@ -44,11 +44,12 @@ typedef enum {
   DCD_EVENT_BUS_RESET,      // 1
   DCD_EVENT_UNPLUGGED,      // 2
   DCD_EVENT_SOF,            // 3
-  DCD_EVENT_SUSPEND,        // 4 TODO LPM Sleep L1 support
+  DCD_EVENT_SUSPEND,        // 4 L2 suspend
   DCD_EVENT_RESUME,         // 5
   DCD_EVENT_SETUP_RECEIVED, // 6
   DCD_EVENT_XFER_COMPLETE,  // 7
   USBD_EVENT_FUNC_CALL,     // 8 Not an DCD event, just a convenient way to defer ISR function
+  DCD_EVENT_LPM_SLEEP,      // 9 LPM L1 sleep, exit with DCD_EVENT_RESUME
   DCD_EVENT_COUNT
 } dcd_eventid_t;
 
@@ -74,9 +75,16 @@ typedef struct TU_ATTR_ALIGNED(4) {
     struct {
       uint8_t  ep_addr;
       uint8_t  result;
+      uint16_t frame; // (micro)frame number of last isochronous packet, UINT16_MAX if not reported by DCD
       uint32_t len;
     }xfer_complete;
 
+    // LPM_SLEEP
+    struct {
+      uint8_t besl;          // Best Effort Service Latency of accepted LPM token
+      uint8_t remote_wakeup; // bRemoteWake of accepted LPM token
+    } lpm_sleep;
+
     // FUNC_CALL
     struct {
       void (*func) (void*);
@@ -87,6 +95,22 @@ typedef struct TU_ATTR_ALIGNED(4) {
 
 //TU_VERIFY_STATIC(sizeof(dcd_event_t) <= 12, "size is not correct");
 
+// Capabilities of device controller driver, queried by class drivers with usbd_dcd_caps_get()
+typedef struct {
+  uint32_t max_xfer_size; // largest total_bytes of a single transfer
+  uint16_t mem_align;     // required alignment in bytes of transfer buffer, 1 if none
+  uint8_t  queue_depth;   // number of transfers accepted by an endpoint at once
+
+  struct TU_ATTR_PACKED {
+    uint8_t xfer_fifo          : 1; // dcd_edpt_xfer_fifo() is implemented
+    uint8_t double_buffer      : 1; // bulk packets are double buffered by hardware
+    uint8_t iso_alloc          : 1; // dcd_edpt_iso_alloc()/dcd_edpt_iso_activate() API is used
+    uint8_t iso_high_bandwidth : 1; // isochronous endpoint with up to 3 transactions per microframe
+    uint8_t iso_frame          : 1; // (micro)frame number of completed isochronous transfer is reported
+    uint8_t                    : 3;
+  };
+} dcd_caps_t;
+
 //--------------------------------------------------------------------+
 // Memory API
 //--------------------------------------------------------------------+
@@ -103,6 +127,12 @@ bool dcd_dcache_invalidate(const void* addr, uint32_t data_size);
 // Required before an DMA transfer where memory is both read/write by DMA
 bool dcd_dcache_clean_invalidate(const void* addr, uint32_t data_size);
 
+// Batch cache maintenance (optional): clean/invalidate issued between begin and end may defer their completion barrier,
+// end completes all of them with a single barrier. Buffers must not be accessed by CPU or DMA until batch end.
+// Batches can be nested, barrier is issued by the outermost end.
+void dcd_dcache_batch_begin(void);
+void dcd_dcache_batch_end(void);
+
 //--------------------------------------------------------------------+
 // Controller API
 //--------------------------------------------------------------------+
@@ -137,6 +167,17 @@ void dcd_disconnect(uint8_t rhport);
 // Enable/Disable Start-of-frame interrupt. Default is disabled
 void dcd_sof_enable(uint8_t rhport, bool en);
 
+// Adjust capabilities pre-filled by usbd with defaults derived from implemented API.
+// This API is optional, only needed when controller can do better than defaults (or worse e.g DMA alignment)
+void dcd_caps_get(uint8_t rhport, dcd_caps_t* caps) TU_ATTR_WEAK;
+
+#if CFG_TUD_LPM
+// Enable/Disable acknowledging LPM token from host. Host BESL values at least besl_deep allow controller to enter
+// deep L1 sleep (e.g PHY clock stopped), besl_deep > 15 only uses shallow sleep.
+// This API is optional, return false if LPM is not supported by controller
+bool dcd_lpm_config(uint8_t rhport, bool enable, uint8_t besl_deep) TU_ATTR_WEAK;
+#endif
+
 #if CFG_TUD_TEST_MODE
 // Put device into a test mode (needs power cycle to quit)
 void dcd_enter_test_mode(uint8_t rhport, tusb_feature_test_mode_t test_selector);
@@ -157,9 +198,18 @@ bool dcd_edpt_open            (uint8_t rhport, tusb_desc_endpoint_t const * desc
 // required for multiple configuration support.
 void dcd_edpt_close_all       (uint8_t rhport);
 
+// Invoked when a configuration is selected, before its endpoints are opened. DCD may plan its packet buffer/FIFO
+// for all endpoints of all alternate settings. This API is optional.
+void dcd_edpt_config_plan     (uint8_t rhport, tusb_desc_configuration_t const * desc_cfg) TU_ATTR_WEAK;
+
 // Submit a transfer, When complete dcd_event_xfer_complete() is invoked to notify the stack
 bool dcd_edpt_xfer            (uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, uint16_t total_bytes);
 
+// Submit a transfer with 32-bit length, When complete dcd_event_xfer_complete() is invoked to notify the stack
+// This API is optional (DCD implementing it defines TUP_DCD_EDPT_XFER_EX), weak default returns false and usbd then
+// splits large transfer into multiple dcd_edpt_xfer()
+bool dcd_edpt_xfer_ex         (uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, uint32_t total_bytes);
+
 // Submit an transfer using fifo, When complete dcd_event_xfer_complete() is invoked to notify the stack
 // This API is optional, may be useful for register-based for transferring data.
 bool dcd_edpt_xfer_fifo       (uint8_t rhport, uint8_t ep_addr, tu_fifo_t * ff, uint16_t total_bytes) TU_ATTR_WEAK;
@@ -209,6 +259,16 @@ TU_ATTR_ALWAYS_INLINE static inline  void dcd_event_bus_reset (uint8_t rhport, t
   dcd_event_handler(&event, in_isr);
 }
 
+// helper to send LPM L1 sleep event
+TU_ATTR_ALWAYS_INLINE static inline void dcd_event_lpm_sleep(uint8_t rhport, uint8_t besl, bool remote_wakeup, bool in_isr) {
+  dcd_event_t event;
+  event.rhport = rhport;
+  event.event_id = DCD_EVENT_LPM_SLEEP;
+  event.lpm_sleep.besl = besl;
+  event.lpm_sleep.remote_wakeup = remote_wakeup ? 1u : 0u;
+  dcd_event_handler(&event, in_isr);
+}
+
 // helper to send setup received
 TU_ATTR_ALWAYS_INLINE static inline void dcd_event_setup_received(uint8_t rhport, uint8_t const * setup, bool in_isr) {
   dcd_event_t event;
@@ -226,6 +286,19 @@ TU_ATTR_ALWAYS_INLINE static inline void dcd_event_xfer_complete (uint8_t rhport
   event.xfer_complete.ep_addr = ep_addr;
   event.xfer_complete.len     = xferred_bytes;
   event.xfer_complete.result  = result;
+  event.xfer_complete.frame   = UINT16_MAX;
+  dcd_event_handler(&event, in_isr);
+}
+
+// helper to send isochronous transfer complete event with the (micro)frame number its last packet is transferred in
+TU_ATTR_ALWAYS_INLINE static inline void dcd_event_iso_xfer_complete (uint8_t rhport, uint8_t ep_addr, uint32_t xferred_bytes, uint8_t result, uint16_t frame, bool in_isr) {
+  dcd_event_t event;
+  event.rhport = rhport;
+  event.event_id = DCD_EVENT_XFER_COMPLETE;
+  event.xfer_complete.ep_addr = ep_addr;
+  event.xfer_complete.len     = xferred_bytes;
+  event.xfer_complete.result  = result;
+  event.xfer_complete.frame   = frame;
   dcd_event_handler(&event, in_isr);
 }
 
@@ -42,6 +42,37 @@
   #define CFG_TUD_TASK_QUEUE_SZ   16
 #endif
 
+// Number of events drained from queue at once by tud_task_ext(), consecutive SOF events in a batch are coalesced
+#ifndef CFG_TUD_TASK_EVENT_BATCH
+  #define CFG_TUD_TASK_EVENT_BATCH  1
+#endif
+
+// Split event queue into priority lanes: bus/control events are always handled before data transfer events,
+// which are handled before SOF and deferred function call. CFG_TUD_TASK_QUEUE_SZ is then size of data lane.
+#ifndef CFG_TUD_TASK_QUEUE_PRIORITY
+  #define CFG_TUD_TASK_QUEUE_PRIORITY  0
+#endif
+
+#ifndef CFG_TUD_TASK_QUEUE_CTRL_SZ
+  #define CFG_TUD_TASK_QUEUE_CTRL_SZ   8
+#endif
+
+#ifndef CFG_TUD_TASK_QUEUE_LOW_SZ
+  #define CFG_TUD_TASK_QUEUE_LOW_SZ    4
+#endif
+
+// Number of pending deferred function calls (usbd_defer_func) kept in a pool outside of event queue, 0 to queue each
+// call as an event. Pending calls with the same func and param are coalesced, all of them take a single queue slot.
+#ifndef CFG_TUD_DEFER_POOL_SIZE
+  #define CFG_TUD_DEFER_POOL_SIZE      0
+#endif
+
+// Application class drivers via usbd_app_driver_get_cb(). Set to 0 if not used: driver lookup then indexes built-in
+// drivers directly, and the callback is not invoked even if implemented.
+#ifndef CFG_TUD_APP_DRIVER
+  #define CFG_TUD_APP_DRIVER           1
+#endif
+
 //--------------------------------------------------------------------+
 // Weak stubs: invoked if no strong implementation is available
 //--------------------------------------------------------------------+
@@ -53,6 +84,15 @@ TU_ATTR_WEAK void tud_sof_cb(uint32_t frame_count) {
   (void) frame_count;
 }
 
+TU_ATTR_WEAK bool tud_sof_isr_cb(uint32_t frame_count) {
+  (void) frame_count;
+  return true;
+}
+
+TU_ATTR_WEAK uint32_t tud_stats_timestamp_cb(void) {
+  return 0;
+}
+
 TU_ATTR_WEAK uint8_t const* tud_descriptor_bos_cb(void) {
   return NULL;
 }
@@ -76,6 +116,10 @@ TU_ATTR_WEAK void tud_suspend_cb(bool remote_wakeup_en) {
   (void) remote_wakeup_en;
 }
 
+TU_ATTR_WEAK void tud_lpm_sleep_cb(uint8_t besl, bool remote_wakeup_en) {
+  (void) besl; (void) remote_wakeup_en;
+}
+
 TU_ATTR_WEAK void tud_resume_cb(void) {
 }
 
@@ -112,6 +156,17 @@ TU_ATTR_WEAK bool dcd_dcache_clean_invalidate(const void* addr, uint32_t data_si
   return true;
 }
 
+TU_ATTR_WEAK void dcd_dcache_batch_begin(void) {
+}
+
+TU_ATTR_WEAK void dcd_dcache_batch_end(void) {
+}
+
+TU_ATTR_WEAK bool dcd_edpt_xfer_ex(uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint32_t total_bytes) {
+  (void) rhport; (void) ep_addr; (void) buffer; (void) total_bytes;
+  return false;
+}
+
 //--------------------------------------------------------------------+
 // Device Data
 //--------------------------------------------------------------------+
@@ -119,6 +174,30 @@ TU_ATTR_WEAK bool dcd_dcache_clean_invalidate(const void* addr, uint32_t data_si
 // Invalid driver ID in itf2drv[] ep2drv[][] mapping
 enum { DRVID_INVALID = 0xFFu };
 
+// Transfer queued behind the active one of an endpoint
+typedef struct {
+  uint8_t* buffer;
+  uint16_t total_bytes;
+  volatile uint8_t pending; // transfer waiting to be started
+  volatile uint8_t chained; // number of completions whose successor is already started in ISR
+} usbd_xfer_queue_t;
+
+// Large transfer split into chunks by usbd
+typedef struct {
+  uint8_t* buffer;    // start of next chunk
+  uint32_t remaining; // bytes not yet submitted to DCD
+  uint32_t xferred;   // bytes transferred by completed chunks
+  uint16_t chunk;     // size of the active chunk
+  volatile uint8_t active;
+} usbd_xfer_ex_t;
+
+// Interface descriptor location in active configuration descriptor
+typedef struct {
+  uint16_t offset;
+  uint8_t itf_num;
+  uint8_t alt;
+} usbd_itf_index_t;
+
 typedef struct {
   struct TU_ATTR_PACKED {
     volatile uint8_t connected    : 1;
@@ -128,6 +207,8 @@ typedef struct {
     uint8_t remote_wakeup_en      : 1; // enable/disable by host
     uint8_t remote_wakeup_support : 1; // configuration descriptor's attribute
     uint8_t self_powered          : 1; // configuration descriptor's attribute
+    volatile uint8_t lpm_sleeping : 1; // in LPM L1 sleep, suspended is also set
+    uint8_t lpm_remote_wakeup     : 1; // bRemoteWake of LPM token
   };
   volatile uint8_t cfg_num; // current active configuration (0x00 is not configured)
   uint8_t speed;
@@ -137,11 +218,127 @@ typedef struct {
   uint8_t ep2drv[CFG_TUD_ENDPPOINT_MAX][2]; // map endpoint to driver ( 0xff is invalid ), can use only 4-bit each
 
   tu_edpt_state_t ep_status[CFG_TUD_ENDPPOINT_MAX][2];
+  uint16_t ep_frame[CFG_TUD_ENDPPOINT_MAX][2]; // frame number of last reported transfer complete
+
+#if CFG_TUD_EDPT_CONTEXT
+  void* ep_ctx[CFG_TUD_ENDPPOINT_MAX][2]; // class instance owning the endpoint
+#endif
 
+#if CFG_TUD_ITF_CONTEXT
+  void* itf_ctx[CFG_TUD_INTERFACE_MAX]; // class instance owning the interface
+#endif
+
+#if CFG_TUD_EDPT_XFER_QUEUE
+  usbd_xfer_queue_t ep_xferq[CFG_TUD_ENDPPOINT_MAX][2];
+#endif
+
+#if CFG_TUD_EDPT_XFER_EX
+  usbd_xfer_ex_t ep_xfer_ex[CFG_TUD_ENDPPOINT_MAX][2];
+#endif
+
+#if CFG_TUD_ITF_INDEX_MAX
+  uint8_t const* desc_cfg;                         // active configuration descriptor
+  uint8_t itf_first[CFG_TUD_INTERFACE_MAX];        // index of first alternate of interface, 0 is invalid (1-based)
+  uint8_t itf_count;
+  usbd_itf_index_t itf_index[CFG_TUD_ITF_INDEX_MAX];
+#endif
+
+#if CFG_TUD_EPBUF_POOL_SIZE
+  uint32_t epbuf_used; // bytes allocated from endpoint buffer pool by opened drivers
+#endif
+
+#if CFG_TUD_FAST_BOOT
+  uint8_t const* desc_dev_cache;  // descriptors returned by callbacks since bus reset
+  uint8_t const* desc_cfg_cache;
+  uint8_t desc_cfg_cache_idx;
+#endif
 }usbd_device_t;
 
-tu_static usbd_device_t _usbd_dev;
-static volatile uint8_t _usbd_queued_setup;
+// Port state kept across bus reset
+typedef struct {
+  volatile uint8_t queued_setup;
+  uint16_t sof_divider; // SOF divider of user consumer
+  uint16_t sof_countdown;
+#if CFG_TUD_RHPORT_NUM > 1 && CFG_TUD_TASK_QUEUE_PRIORITY
+  volatile uint16_t xfer_queued; // transfer complete events of this port in data lane
+  uint16_t xfer_stale;           // leading ones of above queued before bus reset/unplug, to be discarded
+#endif
+} usbd_port_t;
+
+tu_static usbd_device_t _usbd_dev[CFG_TUD_RHPORT_NUM];
+tu_static usbd_port_t _usbd_port[CFG_TUD_RHPORT_NUM];
+
+#if CFG_TUD_RHPORT_NUM > 1
+  TU_VERIFY_STATIC(CFG_TUD_RHPORT_NUM <= 8, "initialized ports are tracked with 8-bit mask");
+  #define USBD_RHPORT(_rhport)   (_rhport)
+#else
+  // single port: drivers may use 0 for the actual controller number
+  #define USBD_RHPORT(_rhport)   _usbd_rhport
+#endif
+
+TU_ATTR_ALWAYS_INLINE static inline usbd_device_t* get_dev(uint8_t rhport) {
+  return &_usbd_dev[usbd_port_idx(rhport)];
+}
+
+TU_ATTR_ALWAYS_INLINE static inline usbd_port_t* get_port(uint8_t rhport) {
+  return &_usbd_port[usbd_port_idx(rhport)];
+}
+
+#if CFG_TUD_EPBUF_POOL_SIZE
+// Endpoint buffer pool shared by drivers of the active configuration of each port
+CFG_TUD_MEM_SECTION TU_ATTR_ALIGNED(CFG_TUD_EPBUF_POOL_ALIGN)
+static uint8_t _usbd_epbuf_pool[CFG_TUD_RHPORT_NUM][CFG_TUD_EPBUF_POOL_SIZE];
+TU_VERIFY_STATIC(CFG_TUD_RHPORT_NUM == 1 || (CFG_TUD_EPBUF_POOL_SIZE % CFG_TUD_EPBUF_POOL_ALIGN) == 0,
+                 "CFG_TUD_EPBUF_POOL_SIZE must be multiple of CFG_TUD_EPBUF_POOL_ALIGN");
+#endif
+
+//--------------------------------------------------------------------+
+// Descriptor template self-check: *_DESC_LEN must match template expansion
+//--------------------------------------------------------------------+
+#define USBD_VERIFY_TEMPLATE(_len, ...) \
+  TU_VERIFY_STATIC(TUD_DESC_TEMPLATE_LEN(__VA_ARGS__) == (_len), #_len " does not match its template")
+
+USBD_VERIFY_TEMPLATE(TUD_CONFIG_DESC_LEN, TUD_CONFIG_DESCRIPTOR(1, 1, 0, 100, 0, 100));
+
+// class templates use constants from class header, which is only included if class is enabled
+#if CFG_TUD_CDC
+USBD_VERIFY_TEMPLATE(TUD_CDC_DESC_LEN, TUD_CDC_DESCRIPTOR(0, 0, 0x81, 8, 0x02, 0x82, 64));
+#endif
+#if CFG_TUD_MSC
+USBD_VERIFY_TEMPLATE(TUD_MSC_DESC_LEN, TUD_MSC_DESCRIPTOR(0, 0, 0x01, 0x81, 64));
+#endif
+#if CFG_TUD_UAS
+USBD_VERIFY_TEMPLATE(TUD_UAS_DESC_LEN, TUD_UAS_DESCRIPTOR(0, 0, 0x01, 0x81, 0x82, 0x03, 512));
+#endif
+#if CFG_TUD_HID
+USBD_VERIFY_TEMPLATE(TUD_HID_DESC_LEN, TUD_HID_DESCRIPTOR(0, 0, 0, 64, 0x81, 16, 10));
+USBD_VERIFY_TEMPLATE(TUD_HID_INOUT_DESC_LEN, TUD_HID_INOUT_DESCRIPTOR(0, 0, 0, 64, 0x01, 0x81, 16, 10));
+#endif
+#if CFG_TUD_MIDI
+USBD_VERIFY_TEMPLATE(TUD_MIDI_DESC_LEN, TUD_MIDI_DESCRIPTOR(0, 0, 0x01, 0x81, 64));
+#endif
+#if CFG_TUD_VENDOR
+USBD_VERIFY_TEMPLATE(TUD_VENDOR_DESC_LEN, TUD_VENDOR_DESCRIPTOR(0, 0, 0x01, 0x81, 64));
+#endif
+#if CFG_TUD_DFU_RUNTIME
+USBD_VERIFY_TEMPLATE(TUD_DFU_RT_DESC_LEN, TUD_DFU_RT_DESCRIPTOR(0, 0, 0x0d, 1000, 4096));
+#endif
+#if CFG_TUD_DFU
+USBD_VERIFY_TEMPLATE(TUD_DFU_DESC_LEN(2), TUD_DFU_DESCRIPTOR(0, 2, 0, 0x0d, 1000, 4096));
+#endif
+#if CFG_TUD_ECM_RNDIS
+USBD_VERIFY_TEMPLATE(TUD_CDC_ECM_DESC_LEN, TUD_CDC_ECM_DESCRIPTOR(0, 0, 0, 0x81, 64, 0x02, 0x82, 64, 1514));
+USBD_VERIFY_TEMPLATE(TUD_RNDIS_DESC_LEN, TUD_RNDIS_DESCRIPTOR(0, 0, 0x81, 8, 0x02, 0x82, 64));
+#endif
+#if CFG_TUD_NCM
+USBD_VERIFY_TEMPLATE(TUD_CDC_NCM_DESC_LEN, TUD_CDC_NCM_DESCRIPTOR(0, 0, 0, 0x81, 64, 0x02, 0x82, 64, 1514));
+#endif
+#if CFG_TUD_AUDIO
+USBD_VERIFY_TEMPLATE(TUD_AUDIO_MIC_ONE_CH_DESC_LEN, TUD_AUDIO_MIC_ONE_CH_DESCRIPTOR(0, 0, 2, 16, 0x81, 64));
+USBD_VERIFY_TEMPLATE(TUD_AUDIO_MIC_FOUR_CH_DESC_LEN, TUD_AUDIO_MIC_FOUR_CH_DESCRIPTOR(0, 0, 2, 16, 0x81, 64));
+USBD_VERIFY_TEMPLATE(TUD_AUDIO_SPEAKER_MONO_FB_DESC_LEN,
+                     TUD_AUDIO_SPEAKER_MONO_FB_DESCRIPTOR(0, 0, 2, 16, 0x01, 64, 0x81, 4));
+#endif
 
 //--------------------------------------------------------------------+
 // Class Driver
@@ -163,7 +360,14 @@ tu_static usbd_class_driver_t const _usbd_driver[] = {
         .open             = cdcd_open,
         .control_xfer_cb  = cdcd_control_xfer_cb,
         .xfer_cb          = cdcd_xfer_cb,
-        .sof              = NULL
+        #if CFG_TUD_CDC_TX_COALESCE_MS
+        .sof              = cdcd_sof,
+        #else
+        .sof              = NULL,
+        #endif
+        #if CFG_TUD_CDC_XFER_ISR
+        .xfer_isr         = cdcd_xfer_isr, // fifo and re-arm only, callbacks are deferred to usbd task
+        #endif
     },
     #endif
 
@@ -176,7 +380,20 @@ tu_static usbd_class_driver_t const _usbd_driver[] = {
         .open             = mscd_open,
         .control_xfer_cb  = mscd_control_xfer_cb,
         .xfer_cb          = mscd_xfer_cb,
-        .sof              = NULL
+        .sof              = mscd_sof
+    },
+    #endif
+
+    #if CFG_TUD_UAS
+    {
+        .name             = DRIVER_NAME("UAS"),
+        .init             = uasd_init,
+        .deinit           = NULL,
+        .reset            = uasd_reset,
+        .open             = uasd_open,
+        .control_xfer_cb  = uasd_control_xfer_cb,
+        .xfer_cb          = uasd_xfer_cb,
+        .sof              = uasd_sof
     },
     #endif
 
@@ -189,7 +406,10 @@ tu_static usbd_class_driver_t const _usbd_driver[] = {
         .open             = hidd_open,
         .control_xfer_cb  = hidd_control_xfer_cb,
         .xfer_cb          = hidd_xfer_cb,
-        .sof              = NULL
+        .sof              = NULL,
+        #if CFG_TUD_HID_REPORT_FILL && CFG_TUD_XFER_ISR
+        .xfer_isr         = hidd_xfer_isr, // re-arm with filled report only, safe to run in ISR
+        #endif
     },
     #endif
 
@@ -202,7 +422,10 @@ tu_static usbd_class_driver_t const _usbd_driver[] = {
         .open             = audiod_open,
         .control_xfer_cb  = audiod_control_xfer_cb,
         .xfer_cb          = audiod_xfer_cb,
-        .sof              = audiod_sof_isr
+        .sof              = audiod_sof_isr,
+        #if CFG_TUD_AUDIO_XFER_ISR
+        .xfer_isr         = audiod_xfer_isr, // ISO OUT decode and re-arm only, safe to run in ISR
+        #endif
     },
     #endif
 
@@ -215,7 +438,11 @@ tu_static usbd_class_driver_t const _usbd_driver[] = {
         .open             = videod_open,
         .control_xfer_cb  = videod_control_xfer_cb,
         .xfer_cb          = videod_xfer_cb,
+      #if CFG_TUD_VIDEO_STREAMING_TIMESTAMP || CFG_TUD_VIDEO_STREAMING_PACING
+        .sof              = videod_sof_isr
+      #else
         .sof              = NULL
+      #endif
     },
     #endif
 
@@ -241,7 +468,14 @@ tu_static usbd_class_driver_t const _usbd_driver[] = {
         .open             = vendord_open,
         .control_xfer_cb  = tud_vendor_control_xfer_cb,
         .xfer_cb          = vendord_xfer_cb,
-        .sof              = NULL
+        #if CFG_TUD_VENDOR_TX_COALESCE_MS
+        .sof              = vendord_sof,
+        #else
+        .sof              = NULL,
+        #endif
+        #if CFG_TUD_VENDOR_XFER_ISR
+        .xfer_isr         = vendord_xfer_isr,
+        #endif
     },
     #endif
 
@@ -293,7 +527,11 @@ tu_static usbd_class_driver_t const _usbd_driver[] = {
         .open             = netd_open,
         .control_xfer_cb  = netd_control_xfer_cb,
         .xfer_cb          = netd_xfer_cb,
-        .sof                  = NULL,
+        #if CFG_TUD_NCM && CFG_TUD_NCM_IN_COALESCE_MS
+        .sof              = netd_sof,
+        #else
+        .sof              = NULL,
+        #endif
     },
     #endif
 
@@ -313,6 +551,7 @@ tu_static usbd_class_driver_t const _usbd_driver[] = {
 
 enum { BUILTIN_DRIVER_COUNT = TU_ARRAY_SIZE(_usbd_driver) };
 
+#if CFG_TUD_APP_DRIVER
 // Additional class drivers implemented by application
 tu_static usbd_class_driver_t const * _app_driver = NULL;
 tu_static uint8_t _app_driver_count = 0;
@@ -331,6 +570,14 @@ TU_ATTR_ALWAYS_INLINE static inline usbd_class_driver_t const * get_driver(uint8
   }
   return driver;
 }
+#else
+#define TOTAL_DRIVER_COUNT    BUILTIN_DRIVER_COUNT
+
+// built-in drivers only, drvid is always valid when coming from _usbd_dev itf2drv/ep2drv map
+TU_ATTR_ALWAYS_INLINE static inline usbd_class_driver_t const * get_driver(uint8_t drvid) {
+  return (BUILTIN_DRIVER_COUNT > 0 && drvid < BUILTIN_DRIVER_COUNT) ? &_usbd_driver[drvid] : NULL;
+}
+#endif
 
 
 //--------------------------------------------------------------------+
@@ -338,12 +585,53 @@ TU_ATTR_ALWAYS_INLINE static inline usbd_class_driver_t const * get_driver(uint8
 //--------------------------------------------------------------------+
 
 enum { RHPORT_INVALID = 0xFFu };
-tu_static uint8_t _usbd_rhport = RHPORT_INVALID;
+tu_static uint8_t _usbd_rhport = RHPORT_INVALID; // first initialized port, used by API without rhport argument
+tu_static uint8_t _usbd_event_rhport;           // port of event being processed by usbd task
+
+#if CFG_TUD_RHPORT_NUM > 1
+tu_static uint8_t _usbd_rhport_mask; // bitmap of initialized ports
+  #define USBD_RHPORT_VALID(_rhport) ((_rhport) < CFG_TUD_RHPORT_NUM)
+#else
+  #define USBD_RHPORT_VALID(_rhport) true
+#endif
 
 // Event queue
 // usbd_int_set() is used as mutex in OS NONE config
+// FreeRTOS notify queues share the task notification: waiting on one lane also wakes up on the others
+#define USBD_QUEUE_NOTIFY   (CFG_TUSB_OS == OPT_OS_FREERTOS && CFG_TUSB_OS_FREERTOS_QUEUE_NOTIFY)
 OSAL_QUEUE_DEF(usbd_int_set, _usbd_qdef, CFG_TUD_TASK_QUEUE_SZ, dcd_event_t);
-tu_static osal_queue_t _usbd_q;
+
+#if CFG_TUD_TASK_QUEUE_PRIORITY
+OSAL_QUEUE_DEF(usbd_int_set, _usbd_qdef_ctrl, CFG_TUD_TASK_QUEUE_CTRL_SZ, dcd_event_t);
+OSAL_QUEUE_DEF(usbd_int_set, _usbd_qdef_low, CFG_TUD_TASK_QUEUE_LOW_SZ, dcd_event_t);
+
+enum { USBD_QUEUE_COUNT = TUD_TASK_QUEUE_COUNT };
+#define USBD_QUEUE_IDX(_lane)   (_lane)
+
+#if defined(OSAL_QUEUE_WAIT_ANY) && OSAL_QUEUE_WAIT_ANY
+// RTOS can block on multiple queues e.g Zephyr k_poll(): task waits on all lanes then polls them without waiting
+  #define USBD_QUEUE_WAIT_ANY   1
+#elif CFG_TUSB_OS != OPT_OS_NONE && CFG_TUSB_OS != OPT_OS_PICO && !USBD_QUEUE_NOTIFY
+// RTOS cannot block on multiple queues: task waits on this doorbell then polls lanes without waiting
+  #define USBD_QUEUE_DOORBELL   1
+tu_static osal_semaphore_def_t _usbd_doorbell_def;
+tu_static osal_semaphore_t _usbd_doorbell;
+#endif
+#else
+enum { USBD_QUEUE_COUNT = 1 };
+#define USBD_QUEUE_IDX(_lane)   0
+#endif
+
+#ifndef USBD_QUEUE_DOORBELL
+  #define USBD_QUEUE_DOORBELL   0
+#endif
+#ifndef USBD_QUEUE_WAIT_ANY
+  #define USBD_QUEUE_WAIT_ANY   0
+#endif
+
+// lanes are in priority order
+tu_static osal_queue_t _usbd_q[USBD_QUEUE_COUNT];
+tu_static uint32_t _usbd_q_overflow[TUD_TASK_QUEUE_COUNT];
 
 // Mutex for claiming endpoint
 #if OSAL_MUTEX_REQUIRED
@@ -353,18 +641,198 @@ tu_static osal_queue_t _usbd_q;
   #define _usbd_mutex   NULL
 #endif
 
+#if CFG_TUD_DEFER_POOL_SIZE
+tu_static tu_defer_entry_t _usbd_defer_entries[CFG_TUD_DEFER_POOL_SIZE];
+tu_static tu_defer_pool_t _usbd_defer = { .entries = _usbd_defer_entries, .size = CFG_TUD_DEFER_POOL_SIZE };
+#endif
+
+TU_ATTR_ALWAYS_INLINE static inline tud_task_queue_t event_lane(dcd_event_t const * event) {
+  switch (event->event_id) {
+    case DCD_EVENT_XFER_COMPLETE:
+      // control endpoint must stay in order with SETUP
+      return tu_edpt_number(event->xfer_complete.ep_addr) ? TUD_TASK_QUEUE_DATA : TUD_TASK_QUEUE_CTRL;
+
+    case DCD_EVENT_SOF:
+    case USBD_EVENT_FUNC_CALL:
+      return TUD_TASK_QUEUE_LOW;
+
+    default:
+      return TUD_TASK_QUEUE_CTRL;
+  }
+}
+
+//--------------------------------------------------------------------+
+// Statistics
+//--------------------------------------------------------------------+
+#if CFG_TUD_STATS
+tu_static tud_stats_t _usbd_stats;
+tu_static uint32_t _usbd_stats_ts[CFG_TUD_ENDPPOINT_MAX][2]; // timestamp of last transfer complete event
+tu_static volatile uint16_t _usbd_stats_queued; // events pending in queue
+
+#define USBD_STATS_EP(_ep_addr) (&_usbd_stats.ep[tu_edpt_number(_ep_addr)][tu_edpt_dir(_ep_addr)])
+
+void tud_stats_get(tud_stats_t* stats) {
+  usbd_int_set(false);
+  *stats = _usbd_stats;
+  usbd_int_set(true);
+
+  for (uint8_t i = 0; i < CFG_TUD_STATS_DRIVER_MAX; i++) {
+    usbd_class_driver_t const* driver = get_driver(i);
+    stats->driver[i].name = driver ? driver->name : NULL;
+  }
+}
+
+void tud_stats_clear(void) {
+  usbd_int_set(false);
+  tu_varclr(&_usbd_stats);
+  usbd_int_set(true);
+}
+
+// event is added to usbd queue, called in ISR
+TU_ATTR_ALWAYS_INLINE static inline void usbd_stats_queued(dcd_event_t const* event) {
+  uint16_t const queued = ++_usbd_stats_queued;
+  if (queued > _usbd_stats.queue_peak) _usbd_stats.queue_peak = queued;
+  if (event->event_id == DCD_EVENT_XFER_COMPLETE) {
+    uint8_t const ep_addr = event->xfer_complete.ep_addr;
+    _usbd_stats_ts[tu_edpt_number(ep_addr)][tu_edpt_dir(ep_addr)] = tud_stats_timestamp_cb();
+  }
+}
+
+// n events are removed from usbd queue by usbd task
+TU_ATTR_ALWAYS_INLINE static inline void usbd_stats_dequeued(uint8_t n) {
+  usbd_int_set(false);
+  _usbd_stats_queued = (uint16_t) (_usbd_stats_queued - tu_min16(n, _usbd_stats_queued));
+  usbd_int_set(true);
+}
+
+// transfer complete is about to be handled by class driver, in_task is false if handled directly in ISR
+static void usbd_stats_xfer_complete(dcd_event_t const* event, bool in_task) {
+  uint8_t const ep_addr = event->xfer_complete.ep_addr;
+  tud_stats_edpt_t* ep_stats = USBD_STATS_EP(ep_addr);
+  ep_stats->xfer_completed++;
+  ep_stats->bytes += event->xfer_complete.len;
+  if (event->xfer_complete.result != XFER_RESULT_SUCCESS) {
+    ep_stats->xfer_failed++;
+  }
+
+  if (in_task) {
+    uint32_t const latency = tud_stats_timestamp_cb() - _usbd_stats_ts[tu_edpt_number(ep_addr)][tu_edpt_dir(ep_addr)];
+    ep_stats->latency_sum += latency;
+    if (latency > ep_stats->latency_max) ep_stats->latency_max = latency;
+  }
+}
+
+// class driver callback returned, start is timestamp taken before invoking it
+static void usbd_stats_driver(uint8_t drv_id, uint32_t start) {
+  if (drv_id < CFG_TUD_STATS_DRIVER_MAX) {
+    uint32_t const elapsed = tud_stats_timestamp_cb() - start;
+    tud_stats_driver_t* drv_stats = &_usbd_stats.driver[drv_id];
+    drv_stats->calls++;
+    drv_stats->time_sum += elapsed;
+    if (elapsed > drv_stats->time_max) drv_stats->time_max = elapsed;
+  }
+}
+
+// enumeration reached a stage, only the first occurrence since bus reset is recorded
+#define usbd_stats_enum(_stage) \
+  do { if (_usbd_stats.enumeration._stage == 0) _usbd_stats.enumeration._stage = tud_stats_timestamp_cb(); } while(0)
+
+static void usbd_stats_enum_reset(void) {
+  uint32_t const init = _usbd_stats.enumeration.init;
+  tu_varclr(&_usbd_stats.enumeration);
+  _usbd_stats.enumeration.init = init;
+  usbd_stats_enum(bus_reset);
+}
+
+#define usbd_stats_timestamp()      tud_stats_timestamp_cb()
+#define usbd_stats_submit(_ep_addr) (USBD_STATS_EP(_ep_addr)->xfer_submitted++)
+#define usbd_stats_stall(_ep_addr)  (USBD_STATS_EP(_ep_addr)->stalls++)
+#else
+#define usbd_stats_enum(_stage)
+#define usbd_stats_enum_reset()
+#define usbd_stats_queued(_event)
+#define usbd_stats_dequeued(_n)
+#define usbd_stats_xfer_complete(_event, _in_task)
+#define usbd_stats_driver(_drv_id, _start) (void) (_start)
+#define usbd_stats_timestamp()      0
+#define usbd_stats_submit(_ep_addr)
+#define usbd_stats_stall(_ep_addr)
+#endif
+
 TU_ATTR_ALWAYS_INLINE static inline bool queue_event(dcd_event_t const * event, bool in_isr) {
-  TU_ASSERT(osal_queue_send(_usbd_q, event, in_isr));
+  tud_task_queue_t const lane = event_lane(event);
+  bool const sent = osal_queue_send(_usbd_q[USBD_QUEUE_IDX(lane)], event, in_isr);
+  if (!sent) {
+    _usbd_q_overflow[lane]++;
+  }
+  TU_ASSERT(sent);
+#if CFG_TUD_TASK_QUEUE_PRIORITY && CFG_TUD_RHPORT_NUM > 1
+  if (lane == TUD_TASK_QUEUE_DATA) {
+    _usbd_port[event->rhport].xfer_queued++;
+  }
+#endif
+  usbd_stats_queued(event);
+
+#if USBD_QUEUE_DOORBELL
+  osal_semaphore_post(_usbd_doorbell, in_isr);
+#endif
+
   tud_event_hook_cb(event->rhport, event->event_id, in_isr);
   return true;
 }
 
+TU_ATTR_ALWAYS_INLINE static inline bool usbd_queue_empty(void) {
+  for (uint8_t i = 0; i < USBD_QUEUE_COUNT; i++) {
+    if (!osal_queue_empty(_usbd_q[i])) return false;
+  }
+  return true;
+}
+
+#if CFG_TUD_DEFER_POOL_SIZE
+// ISR is not preempted by task, task locks out both ISR and other tasks
+static void usbd_defer_lock(bool in_isr) {
+  if (!in_isr) {
+    (void) osal_mutex_lock(_usbd_mutex, OSAL_TIMEOUT_WAIT_FOREVER);
+    usbd_int_set(false);
+  }
+}
+
+static void usbd_defer_unlock(bool in_isr) {
+  if (!in_isr) {
+    usbd_int_set(true);
+    (void) osal_mutex_unlock(_usbd_mutex);
+  }
+}
+
+// Invoke pending deferred calls. Calls deferred meanwhile queue a new wake-up event, run is bounded by pool size so
+// that a call re-deferring itself does not starve other events.
+static void usbd_defer_run(void) {
+  usbd_defer_lock(false);
+  _usbd_defer.kicked = false;
+  usbd_defer_unlock(false);
+
+  for (uint8_t i = 0; i < CFG_TUD_DEFER_POOL_SIZE; i++) {
+    osal_task_func_t func;
+    void* param;
+    usbd_defer_lock(false);
+    bool const has_call = tu_defer_pool_take(&_usbd_defer, &func, &param);
+    usbd_defer_unlock(false);
+
+    if (!has_call) break;
+    func(param);
+  }
+}
+#else
+  #define usbd_defer_run()
+#endif
+
 //--------------------------------------------------------------------+
 // Prototypes
 //--------------------------------------------------------------------+
 static bool process_control_request(uint8_t rhport, tusb_control_request_t const * p_request);
 static bool process_set_config(uint8_t rhport, uint8_t cfg_num);
 static bool process_get_descriptor(uint8_t rhport, tusb_control_request_t const * p_request);
+static void configuration_reset(uint8_t rhport);
 
 #if CFG_TUD_TEST_MODE
 static bool process_test_mode_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t const * request) {
@@ -377,9 +845,9 @@ static bool process_test_mode_cb(uint8_t rhport, uint8_t stage, tusb_control_req
 #endif
 
 // from usbd_control.c
-void usbd_control_reset(void);
-void usbd_control_set_request(tusb_control_request_t const *request);
-void usbd_control_set_complete_callback( usbd_control_xfer_cb_t fp );
+void usbd_control_reset(uint8_t rhport);
+void usbd_control_set_request(uint8_t rhport, tusb_control_request_t const *request);
+void usbd_control_set_complete_callback(uint8_t rhport, usbd_control_xfer_cb_t fp);
 bool usbd_control_xfer_cb (uint8_t rhport, uint8_t ep_addr, xfer_result_t event, uint32_t xferred_bytes);
 
 
@@ -396,7 +864,8 @@ tu_static char const* const _usbd_event_str[DCD_EVENT_COUNT] = {
     "Resume",
     "Setup Received",
     "Xfer Complete",
-    "Func Call"
+    "Func Call",
+    "LPM Sleep"
 };
 
 // for usbd_control to print the name of control complete driver
@@ -415,27 +884,76 @@ void usbd_driver_print_control_complete_name(usbd_control_xfer_cb_t callback) {
 //--------------------------------------------------------------------+
 // Application API
 //--------------------------------------------------------------------+
+tusb_speed_t tud_rhport_speed_get(uint8_t rhport) {
+  TU_VERIFY(USBD_RHPORT_VALID(rhport), TUSB_SPEED_INVALID);
+  return (tusb_speed_t) get_dev(rhport)->speed;
+}
+
+bool tud_rhport_connected(uint8_t rhport) {
+  TU_VERIFY(USBD_RHPORT_VALID(rhport));
+  return get_dev(rhport)->connected;
+}
+
+bool tud_rhport_mounted(uint8_t rhport) {
+  TU_VERIFY(USBD_RHPORT_VALID(rhport));
+  return get_dev(rhport)->cfg_num ? true : false;
+}
+
+bool tud_rhport_suspended(uint8_t rhport) {
+  TU_VERIFY(USBD_RHPORT_VALID(rhport));
+  return get_dev(rhport)->suspended;
+}
+
+bool tud_rhport_remote_wakeup(uint8_t rhport) {
+  TU_VERIFY(USBD_RHPORT_VALID(rhport));
+  rhport = USBD_RHPORT(rhport);
+  usbd_device_t const* dev = get_dev(rhport);
+
+  // only wake up host if this feature is supported and enabled and we are suspended
+  // in L1 sleep, remote wakeup is enabled per LPM token rather than by SET_FEATURE
+  const bool enabled = dev->lpm_sleeping ? dev->lpm_remote_wakeup : dev->remote_wakeup_en;
+  TU_VERIFY (dev->suspended && dev->remote_wakeup_support && enabled);
+  dcd_remote_wakeup(rhport);
+  return true;
+}
+
+uint8_t tud_event_rhport(void) {
+  return _usbd_event_rhport;
+}
+
 tusb_speed_t tud_speed_get(void) {
-  return (tusb_speed_t) _usbd_dev.speed;
+  return tud_rhport_speed_get(_usbd_rhport);
 }
 
 bool tud_connected(void) {
-  return _usbd_dev.connected;
+  return tud_rhport_connected(_usbd_rhport);
 }
 
 bool tud_mounted(void) {
-  return _usbd_dev.cfg_num ? true : false;
+  return tud_rhport_mounted(_usbd_rhport);
 }
 
 bool tud_suspended(void) {
-  return _usbd_dev.suspended;
+  return tud_rhport_suspended(_usbd_rhport);
 }
 
 bool tud_remote_wakeup(void) {
-  // only wake up host if this feature is supported and enabled and we are suspended
-  TU_VERIFY (_usbd_dev.suspended && _usbd_dev.remote_wakeup_support && _usbd_dev.remote_wakeup_en);
-  dcd_remote_wakeup(_usbd_rhport);
-  return true;
+  return tud_rhport_remote_wakeup(_usbd_rhport);
+}
+
+bool tud_lpm_sleeping(void) {
+  TU_VERIFY(USBD_RHPORT_VALID(_usbd_rhport));
+  return get_dev(_usbd_rhport)->lpm_sleeping;
+}
+
+bool tud_lpm_config(bool enable, uint8_t besl_deep) {
+#if CFG_TUD_LPM
+  TU_VERIFY(dcd_lpm_config != NULL);
+  return dcd_lpm_config(_usbd_rhport, enable, besl_deep);
+#else
+  (void) enable; (void) besl_deep;
+  return false;
+#endif
 }
 
 bool tud_disconnect(void) {
@@ -452,6 +970,13 @@ void tud_sof_cb_enable(bool en) {
   usbd_sof_enable(_usbd_rhport, SOF_CONSUMER_USER, en);
 }
 
+void tud_sof_cb_set_divider(uint16_t divider) {
+  TU_VERIFY(USBD_RHPORT_VALID(_usbd_rhport),);
+  usbd_port_t* port = get_port(_usbd_rhport);
+  port->sof_divider = divider;
+  port->sof_countdown = 0;
+}
+
 //--------------------------------------------------------------------+
 // USBD Task
 //--------------------------------------------------------------------+
@@ -459,22 +984,41 @@ bool tud_inited(void) {
   return _usbd_rhport != RHPORT_INVALID;
 }
 
-bool tud_rhport_init(uint8_t rhport, const tusb_rhport_init_t* rh_init) {
-  if (tud_inited()) {
-    return true; // skip if already initialized
+bool tud_rhport_inited(uint8_t rhport) {
+#if CFG_TUD_RHPORT_NUM > 1
+  return USBD_RHPORT_VALID(rhport) && tu_bit_test(_usbd_rhport_mask, rhport);
+#else
+  return tud_inited() && rhport == _usbd_rhport;
+#endif
+}
+
+// Init resources shared by all ports: mutex, event queue and class drivers
+#if CFG_TUD_FAST_BOOT
+tu_static bool _usbd_driver_inited;
+  #define usbd_drivers_inited() _usbd_driver_inited
+#else
+  #define usbd_drivers_inited() true
+#endif
+
+static bool usbd_init_drivers(void) {
+  for (uint8_t i = 0; i < TOTAL_DRIVER_COUNT; i++) {
+    usbd_class_driver_t const* driver = get_driver(i);
+    TU_ASSERT(driver && driver->init);
+    TU_LOG_USBD("%s init\r\n", driver->name);
+    driver->init();
   }
-  TU_ASSERT(rh_init);
+#if CFG_TUD_FAST_BOOT
+  _usbd_driver_inited = true;
+#endif
+  return true;
+}
 
-  TU_LOG_USBD("USBD init on controller %u, speed = %s\r\n", rhport,
-    rh_init->speed == TUSB_SPEED_HIGH ? "High" : "Full");
+static bool usbd_init_shared(void) {
   TU_LOG_INT(CFG_TUD_LOG_LEVEL, sizeof(usbd_device_t));
   TU_LOG_INT(CFG_TUD_LOG_LEVEL, sizeof(dcd_event_t));
   TU_LOG_INT(CFG_TUD_LOG_LEVEL, sizeof(tu_fifo_t));
   TU_LOG_INT(CFG_TUD_LOG_LEVEL, sizeof(tu_edpt_stream_t));
 
-  tu_varclr(&_usbd_dev);
-  _usbd_queued_setup = 0;
-
 #if OSAL_MUTEX_REQUIRED
   // Init device mutex
   _usbd_mutex = osal_mutex_create(&_ubsd_mutexdef);
@@ -482,33 +1026,109 @@ bool tud_rhport_init(uint8_t rhport, const tusb_rhport_init_t* rh_init) {
 #endif
 
   // Init device queue & task
-  _usbd_q = osal_queue_create(&_usbd_qdef);
-  TU_ASSERT(_usbd_q);
+#if CFG_TUD_TASK_QUEUE_PRIORITY
+  _usbd_q[TUD_TASK_QUEUE_CTRL] = osal_queue_create(&_usbd_qdef_ctrl);
+  _usbd_q[TUD_TASK_QUEUE_DATA] = osal_queue_create(&_usbd_qdef);
+  _usbd_q[TUD_TASK_QUEUE_LOW] = osal_queue_create(&_usbd_qdef_low);
+  #if USBD_QUEUE_DOORBELL
+  _usbd_doorbell = osal_semaphore_create(&_usbd_doorbell_def);
+  TU_ASSERT(_usbd_doorbell);
+  #endif
+#else
+  _usbd_q[0] = osal_queue_create(&_usbd_qdef);
+#endif
+  for (uint8_t i = 0; i < USBD_QUEUE_COUNT; i++) {
+    TU_ASSERT(_usbd_q[i]);
+  }
+  tu_varclr(&_usbd_q_overflow);
 
+#if CFG_TUD_DEFER_POOL_SIZE
+  tu_memclr(_usbd_defer_entries, sizeof(_usbd_defer_entries));
+  _usbd_defer.kicked = false;
+#endif
+
+#if CFG_TUD_APP_DRIVER
   // Get application driver if available
   if (usbd_app_driver_get_cb) {
     _app_driver = usbd_app_driver_get_cb(&_app_driver_count);
   }
+#endif
 
-  // Init class drivers
-  for (uint8_t i = 0; i < TOTAL_DRIVER_COUNT; i++) {
+#if CFG_TUD_FAST_BOOT
+  _usbd_driver_inited = false; // postponed to first tud_task()
+  return true;
+#else
+  return usbd_init_drivers();
+#endif
+}
+
+static void usbd_deinit_shared(void) {
+  // Deinit class drivers
+  for (uint8_t i = 0; usbd_drivers_inited() && i < TOTAL_DRIVER_COUNT; i++) {
     usbd_class_driver_t const* driver = get_driver(i);
-    TU_ASSERT(driver && driver->init);
-    TU_LOG_USBD("%s init\r\n", driver->name);
-    driver->init();
+    if(driver && driver->deinit) {
+      TU_LOG_USBD("%s deinit\r\n", driver->name);
+      driver->deinit();
+    }
+  }
+
+  // Deinit device queue & task
+  for (uint8_t i = 0; i < USBD_QUEUE_COUNT; i++) {
+    osal_queue_delete(_usbd_q[i]);
+    _usbd_q[i] = NULL;
+  }
+#if USBD_QUEUE_DOORBELL
+  osal_semaphore_delete(_usbd_doorbell);
+  _usbd_doorbell = NULL;
+#endif
+
+#if OSAL_MUTEX_REQUIRED
+  // TODO make sure there is no task waiting on this mutex
+  osal_mutex_delete(_usbd_mutex);
+  _usbd_mutex = NULL;
+#endif
+}
+
+bool tud_rhport_init(uint8_t rhport, const tusb_rhport_init_t* rh_init) {
+  if (tud_rhport_inited(rhport)) {
+    return true; // skip if already initialized
+  }
+  TU_ASSERT(rh_init);
+#if CFG_TUD_RHPORT_NUM > 1
+  TU_ASSERT(USBD_RHPORT_VALID(rhport)); // increase CFG_TUD_RHPORT_NUM
+#else
+  TU_VERIFY(!tud_inited()); // other port is already running, increase CFG_TUD_RHPORT_NUM
+#endif
+
+  TU_LOG_USBD("USBD init on controller %u, speed = %s\r\n", rhport,
+    rh_init->speed == TUSB_SPEED_HIGH ? "High" : "Full");
+
+  if (!tud_inited()) {
+    TU_ASSERT(usbd_init_shared());
   }
 
-  _usbd_rhport = rhport;
+  tu_varclr(get_dev(rhport));
+  tu_varclr(get_port(rhport));
+
+  usbd_int_set(false); // port is added to usbd_int_set() mask
+#if CFG_TUD_RHPORT_NUM > 1
+  _usbd_rhport_mask |= TU_BIT(rhport);
+#endif
+  if (!tud_inited()) {
+    _usbd_rhport = rhport;
+  }
+  usbd_int_set(true);
 
   // Init device controller driver
   TU_ASSERT(dcd_init(rhport, rh_init));
   dcd_int_enable(rhport);
+  usbd_stats_enum(init);
 
   return true;
 }
 
 bool tud_deinit(uint8_t rhport) {
-  if (!tud_inited()) {
+  if (!tud_rhport_inited(rhport)) {
     return true; // skip if not initialized
   }
 
@@ -519,51 +1139,325 @@ bool tud_deinit(uint8_t rhport) {
   dcd_disconnect(rhport);
   dcd_deinit(rhport);
 
-  // Deinit class drivers
-  for (uint8_t i = 0; i < TOTAL_DRIVER_COUNT; i++) {
-    usbd_class_driver_t const* driver = get_driver(i);
-    if(driver && driver->deinit) {
-      TU_LOG_USBD("%s deinit\r\n", driver->name);
-      driver->deinit();
+#if CFG_TUD_RHPORT_NUM > 1
+  usbd_int_set(false);
+  _usbd_rhport_mask &= (uint8_t) ~TU_BIT(rhport);
+  if (rhport == _usbd_rhport) {
+    // API without rhport argument moves to the lowest remaining port
+    for (uint8_t i = 0; i < CFG_TUD_RHPORT_NUM; i++) {
+      if (tu_bit_test(_usbd_rhport_mask, i)) {
+        _usbd_rhport = i;
+        break;
+      }
     }
   }
+  usbd_int_set(true);
+
+  if (_usbd_rhport_mask) {
+    // other ports are still running: only close class drivers of this port
+    configuration_reset(rhport);
+    return true;
+  }
+#endif
+
+  usbd_deinit_shared();
+  _usbd_rhport = RHPORT_INVALID;
+
+  return true;
+}
+
+static void configuration_reset(uint8_t rhport) {
+  for (uint8_t i = 0; usbd_drivers_inited() && i < TOTAL_DRIVER_COUNT; i++) {
+    usbd_class_driver_t const* driver = get_driver(i);
+    TU_ASSERT(driver,);
+    driver->reset(rhport);
+  }
+
+  usbd_device_t* dev = get_dev(rhport);
+  tu_varclr(dev);
+  memset(dev->itf2drv, DRVID_INVALID, sizeof(dev->itf2drv)); // invalid mapping
+  memset(dev->ep2drv, DRVID_INVALID, sizeof(dev->ep2drv)); // invalid mapping
+
+  tu_capture_dev_close(rhport, false, 0);
+  tu_bridge_dev_close(false, rhport);
+}
+
+static void usbd_reset(uint8_t rhport) {
+  configuration_reset(rhport);
+  usbd_control_reset(rhport);
+}
+
+bool tud_task_event_ready(void) {
+  // Skip if stack is not initialized
+  if (!tud_inited()) return false;
+  return !usbd_queue_empty();
+}
+
+uint32_t tud_task_queue_overflow_count(tud_task_queue_t lane) {
+  TU_VERIFY(lane < TUD_TASK_QUEUE_COUNT, 0);
+  return _usbd_q_overflow[lane];
+}
+
+// With priority lanes, transfer events queued before bus reset/unplug are handled after it: discard them since
+// endpoints are already closed. Endpoints are only re-opened after SET_CONFIGURATION i.e later.
+// Deferred function calls of low lane are kept (same as without lanes), they may carry application work and must
+// revalidate their own state, see usbd_defer_func()
+static void usbd_queue_flush_data(uint8_t rhport) {
+#if CFG_TUD_TASK_QUEUE_PRIORITY && CFG_TUD_RHPORT_NUM > 1
+  // lane is shared with other ports: mark events of this port as stale, they are dropped when dequeued
+  usbd_port_t* port = get_port(rhport);
+  usbd_int_set(false);
+  port->xfer_stale = port->xfer_queued;
+  usbd_int_set(true);
+#elif CFG_TUD_TASK_QUEUE_PRIORITY
+  (void) rhport;
+  dcd_event_t event;
+  while (osal_queue_receive(_usbd_q[TUD_TASK_QUEUE_DATA], &event, OSAL_TIMEOUT_NOTIMEOUT)) {}
+#else
+  (void) rhport;
+#endif
+}
+
+#if CFG_TUD_TASK_QUEUE_PRIORITY && CFG_TUD_RHPORT_NUM > 1
+// Account for a dequeued transfer complete of data lane, return false if it is stale and must be dropped
+static bool usbd_xfer_dequeued(uint8_t rhport) {
+  usbd_port_t* port = get_port(rhport);
+  bool fresh = true;
+  usbd_int_set(false);
+  port->xfer_queued--;
+  if (port->xfer_stale) {
+    port->xfer_stale--;
+    fresh = false;
+  }
+  usbd_int_set(true);
+  return fresh;
+}
+#endif
+
+#if CFG_TUD_EDPT_XFER_QUEUE
+// Account for a transfer complete in usbd task. Return true if endpoint is still busy with a queued transfer
+static bool usbd_xfer_queue_complete(uint8_t rhport, uint8_t ep_addr) {
+  uint8_t const epnum = tu_edpt_number(ep_addr);
+  TU_VERIFY(epnum != 0);
+  usbd_xfer_queue_t* xferq = &get_dev(rhport)->ep_xferq[epnum][tu_edpt_dir(ep_addr)];
+  bool busy = false;
+
+  usbd_int_set(false);
+  if (xferq->chained) {
+    // successor was started in ISR
+    xferq->chained--;
+    busy = true;
+  } else if (xferq->pending) {
+    // queued after the transfer had completed (or DCD failed to start it in ISR)
+    xferq->pending = 0;
+    tu_capture_xfer_submit(rhport, false, 0, ep_addr, xferq->buffer, xferq->total_bytes);
+    busy = dcd_edpt_xfer(rhport, ep_addr, xferq->buffer, xferq->total_bytes);
+  }
+  usbd_int_set(true);
+
+  return busy;
+}
+#endif
+
+// Process an event from queue
+static void usbd_process_event(dcd_event_t const* event) {
+  uint8_t const rhport = event->rhport;
+  usbd_device_t* dev = get_dev(rhport);
+  usbd_port_t* port = get_port(rhport);
+  _usbd_event_rhport = rhport;
+
+#if CFG_TUSB_DEBUG >= CFG_TUD_LOG_LEVEL
+  if (event->event_id == DCD_EVENT_SETUP_RECEIVED) TU_LOG_USBD("\r\n"); // extra line for setup
+  TU_LOG_USBD("USBD %s ", event->event_id < DCD_EVENT_COUNT ? _usbd_event_str[event->event_id] : "CORRUPTED");
+#endif
+
+  switch (event->event_id) {
+    case DCD_EVENT_BUS_RESET:
+      TU_LOG_USBD(": %s Speed\r\n", tu_str_speed[event->bus_reset.speed]);
+      usbd_stats_enum_reset();
+      usbd_reset(rhport);
+      usbd_queue_flush_data(rhport);
+      dev->speed = event->bus_reset.speed;
+      break;
+
+    case DCD_EVENT_UNPLUGGED:
+      TU_LOG_USBD("\r\n");
+      usbd_reset(rhport);
+      usbd_queue_flush_data(rhport);
+      tud_umount_cb();
+      break;
+
+    case DCD_EVENT_SETUP_RECEIVED:
+      TU_ASSERT(port->queued_setup > 0,);
+      port->queued_setup--;
+      TU_LOG_BUF(CFG_TUD_LOG_LEVEL, &event->setup_received, 8);
+      if (port->queued_setup) {
+        TU_LOG_USBD("  Skipped since there is other SETUP in queue\r\n");
+        break;
+      }
+
+      // Mark as connected after receiving 1st setup packet.
+      // But it is easier to set it every time instead of wasting time to check then set
+      dev->connected = 1;
+
+      // mark both in & out control as free
+      dev->ep_status[0][TUSB_DIR_OUT].busy = 0;
+      dev->ep_status[0][TUSB_DIR_OUT].claimed = 0;
+      dev->ep_status[0][TUSB_DIR_IN].busy = 0;
+      dev->ep_status[0][TUSB_DIR_IN].claimed = 0;
+
+      // Process control request
+      if (!process_control_request(rhport, &event->setup_received)) {
+        TU_LOG_USBD("  Stall EP0\r\n");
+        // Failed -> stall both control endpoint IN and OUT
+        dcd_edpt_stall(rhport, 0);
+        dcd_edpt_stall(rhport, 0 | TUSB_DIR_IN_MASK);
+      }
+      break;
+
+    case DCD_EVENT_XFER_COMPLETE: {
+      // Invoke the class callback associated with the endpoint address
+      uint8_t const ep_addr = event->xfer_complete.ep_addr;
+      uint8_t const epnum = tu_edpt_number(ep_addr);
+      uint8_t const ep_dir = tu_edpt_dir(ep_addr);
+
+      TU_LOG_USBD("on EP %02X with %u bytes\r\n", ep_addr, (unsigned int) event->xfer_complete.len);
+
+#if CFG_TUD_TASK_QUEUE_PRIORITY && CFG_TUD_RHPORT_NUM > 1
+      if (epnum && !usbd_xfer_dequeued(rhport)) {
+        TU_LOG_USBD("  Skipped since queued before reset\r\n");
+        break;
+      }
+#endif
+
+#if CFG_TUD_EDPT_XFER_QUEUE
+      // endpoint is still busy if next transfer is already (or now) started
+      if (!usbd_xfer_queue_complete(rhport, ep_addr))
+#endif
+      {
+        dev->ep_status[epnum][ep_dir].busy = 0;
+        dev->ep_status[epnum][ep_dir].claimed = 0;
+      }
+
+      usbd_stats_xfer_complete(event, true);
+      dev->ep_frame[epnum][ep_dir] = event->xfer_complete.frame;
+
+      if (0 == epnum) {
+        usbd_control_xfer_cb(rhport, ep_addr, (xfer_result_t) event->xfer_complete.result,
+                             event->xfer_complete.len);
+      } else {
+        if (tu_bridge_device_xfer_cb(rhport, ep_addr, (xfer_result_t) event->xfer_complete.result,
+                                     event->xfer_complete.len)) {
+          TU_LOG_USBD("  bridge xfer callback\r\n");
+          break;
+        }
+
+        uint8_t const drv_id = dev->ep2drv[epnum][ep_dir];
+        usbd_class_driver_t const* driver = get_driver(drv_id);
+        TU_ASSERT(driver,);
+
+        TU_LOG_USBD("  %s xfer callback\r\n", driver->name);
+        uint32_t const ts = usbd_stats_timestamp();
+        driver->xfer_cb(rhport, ep_addr, (xfer_result_t) event->xfer_complete.result, event->xfer_complete.len);
+        usbd_stats_driver(drv_id, ts);
+      }
+      break;
+    }
+
+    case DCD_EVENT_SUSPEND:
+      // NOTE: When plugging/unplugging device, the D+/D- state are unstable and
+      // can accidentally meet the SUSPEND condition ( Bus Idle for 3ms ), which result in a series of event
+      // e.g suspend -> resume -> unplug/plug. Skip suspend/resume if not connected
+      if (dev->connected) {
+        TU_LOG_USBD(": Remote Wakeup = %u\r\n", dev->remote_wakeup_en);
+        tud_suspend_cb(dev->remote_wakeup_en);
+      } else {
+        TU_LOG_USBD(" Skipped\r\n");
+      }
+      break;
+
+    case DCD_EVENT_LPM_SLEEP:
+      if (dev->connected) {
+        TU_LOG_USBD(": BESL = %u, Remote Wakeup = %u\r\n", event->lpm_sleep.besl, event->lpm_sleep.remote_wakeup);
+        tud_lpm_sleep_cb(event->lpm_sleep.besl, event->lpm_sleep.remote_wakeup != 0);
+      } else {
+        TU_LOG_USBD(" Skipped\r\n");
+      }
+      break;
 
-  // Deinit device queue & task
-  osal_queue_delete(_usbd_q);
-  _usbd_q = NULL;
+    case DCD_EVENT_RESUME:
+      if (dev->connected) {
+        TU_LOG_USBD("\r\n");
+        tud_resume_cb();
+      } else {
+        TU_LOG_USBD(" Skipped\r\n");
+      }
+      break;
 
-#if OSAL_MUTEX_REQUIRED
-  // TODO make sure there is no task waiting on this mutex
-  osal_mutex_delete(_usbd_mutex);
-  _usbd_mutex = NULL;
-#endif
+    case USBD_EVENT_FUNC_CALL:
+      TU_LOG_USBD("\r\n");
+      if (event->func_call.func) {
+        event->func_call.func(event->func_call.param);
+      } else {
+        usbd_defer_run();
+      }
+      break;
 
-  _usbd_rhport = RHPORT_INVALID;
+    case DCD_EVENT_SOF:
+      if (tu_bit_test(dev->sof_consumer, SOF_CONSUMER_USER)) {
+        TU_LOG_USBD("\r\n");
+        tud_sof_cb(event->sof.frame_count);
+      }
+    break;
 
-  return true;
+    default:
+      TU_BREAKPOINT();
+      break;
+  }
 }
 
-static void configuration_reset(uint8_t rhport) {
-  for (uint8_t i = 0; i < TOTAL_DRIVER_COUNT; i++) {
-    usbd_class_driver_t const* driver = get_driver(i);
-    TU_ASSERT(driver,);
-    driver->reset(rhport);
+// Receive up to n events from a queue. Queue of OS None/Pico (and FreeRTOS notify) is tu_fifo, which is drained with
+// a single lock (usb interrupt disabled). For RTOS, block for the first event then get the rest without waiting.
+TU_ATTR_ALWAYS_INLINE static inline uint8_t queue_receive_n(osal_queue_t qhdl, dcd_event_t* events, uint8_t n,
+                                                            uint32_t timeout_ms) {
+#if CFG_TUD_TASK_EVENT_BATCH > 1
+  #if CFG_TUSB_OS == OPT_OS_NONE || CFG_TUSB_OS == OPT_OS_PICO || USBD_QUEUE_NOTIFY
+  return (uint8_t) osal_queue_receive_n(qhdl, events, n, timeout_ms);
+  #else
+  uint8_t count = 0;
+  while (count < n && osal_queue_receive(qhdl, &events[count], count ? OSAL_TIMEOUT_NOTIMEOUT : timeout_ms)) {
+    count++;
   }
-
-  tu_varclr(&_usbd_dev);
-  memset(_usbd_dev.itf2drv, DRVID_INVALID, sizeof(_usbd_dev.itf2drv)); // invalid mapping
-  memset(_usbd_dev.ep2drv, DRVID_INVALID, sizeof(_usbd_dev.ep2drv)); // invalid mapping
+  return count;
+  #endif
+#else
+  (void) n;
+  return osal_queue_receive(qhdl, events, timeout_ms) ? 1 : 0;
+#endif
 }
 
-static void usbd_reset(uint8_t rhport) {
-  configuration_reset(rhport);
-  usbd_control_reset();
-}
+// Receive up to n events from the highest priority non-empty lane
+static uint8_t usbd_queue_receive(dcd_event_t* events, uint8_t n, uint32_t timeout_ms) {
+#if USBD_QUEUE_DOORBELL
+  if (usbd_queue_empty()) {
+    TU_VERIFY(osal_semaphore_wait(_usbd_doorbell, timeout_ms), 0);
+  }
+  timeout_ms = OSAL_TIMEOUT_NOTIMEOUT;
+#elif USBD_QUEUE_WAIT_ANY
+  if (usbd_queue_empty()) {
+    TU_VERIFY(osal_queue_wait_any(_usbd_q, USBD_QUEUE_COUNT, timeout_ms), 0);
+  }
+  timeout_ms = OSAL_TIMEOUT_NOTIMEOUT;
+#endif
 
-bool tud_task_event_ready(void) {
-  // Skip if stack is not initialized
-  if (!tud_inited()) return false;
-  return !osal_queue_empty(_usbd_q);
+  for (uint8_t i = 0; i < USBD_QUEUE_COUNT; i++) {
+    // only wait on the last (or the only) lane
+    uint8_t const count = queue_receive_n(_usbd_q[i], events, n,
+                                          (i == USBD_QUEUE_COUNT - 1) ? timeout_ms : OSAL_TIMEOUT_NOTIMEOUT);
+    if (count) return count;
+  }
+
+  return 0;
 }
 
 /* USB Device Driver task
@@ -586,122 +1480,31 @@ void tud_task_ext(uint32_t timeout_ms, bool in_isr) {
   // Skip if stack is not initialized
   if (!tud_inited()) return;
 
-  // Loop until there is no more events in the queue
-  while (1) {
-    dcd_event_t event;
-    if (!osal_queue_receive(_usbd_q, &event, timeout_ms)) return;
-
-#if CFG_TUSB_DEBUG >= CFG_TUD_LOG_LEVEL
-    if (event.event_id == DCD_EVENT_SETUP_RECEIVED) TU_LOG_USBD("\r\n"); // extra line for setup
-    TU_LOG_USBD("USBD %s ", event.event_id < DCD_EVENT_COUNT ? _usbd_event_str[event.event_id] : "CORRUPTED");
+#if CFG_TUD_FAST_BOOT
+  if (!_usbd_driver_inited) {
+    TU_VERIFY(usbd_init_drivers(),);
+  }
 #endif
 
-    switch (event.event_id) {
-      case DCD_EVENT_BUS_RESET:
-        TU_LOG_USBD(": %s Speed\r\n", tu_str_speed[event.bus_reset.speed]);
-        usbd_reset(event.rhport);
-        _usbd_dev.speed = event.bus_reset.speed;
-        break;
-
-      case DCD_EVENT_UNPLUGGED:
-        TU_LOG_USBD("\r\n");
-        usbd_reset(event.rhport);
-        tud_umount_cb();
-        break;
-
-      case DCD_EVENT_SETUP_RECEIVED:
-        TU_ASSERT(_usbd_queued_setup > 0,);
-        _usbd_queued_setup--;
-        TU_LOG_BUF(CFG_TUD_LOG_LEVEL, &event.setup_received, 8);
-        if (_usbd_queued_setup) {
-          TU_LOG_USBD("  Skipped since there is other SETUP in queue\r\n");
-          break;
-        }
-
-        // Mark as connected after receiving 1st setup packet.
-        // But it is easier to set it every time instead of wasting time to check then set
-        _usbd_dev.connected = 1;
-
-        // mark both in & out control as free
-        _usbd_dev.ep_status[0][TUSB_DIR_OUT].busy = 0;
-        _usbd_dev.ep_status[0][TUSB_DIR_OUT].claimed = 0;
-        _usbd_dev.ep_status[0][TUSB_DIR_IN].busy = 0;
-        _usbd_dev.ep_status[0][TUSB_DIR_IN].claimed = 0;
-
-        // Process control request
-        if (!process_control_request(event.rhport, &event.setup_received)) {
-          TU_LOG_USBD("  Stall EP0\r\n");
-          // Failed -> stall both control endpoint IN and OUT
-          dcd_edpt_stall(event.rhport, 0);
-          dcd_edpt_stall(event.rhport, 0 | TUSB_DIR_IN_MASK);
-        }
-        break;
-
-      case DCD_EVENT_XFER_COMPLETE: {
-        // Invoke the class callback associated with the endpoint address
-        uint8_t const ep_addr = event.xfer_complete.ep_addr;
-        uint8_t const epnum = tu_edpt_number(ep_addr);
-        uint8_t const ep_dir = tu_edpt_dir(ep_addr);
-
-        TU_LOG_USBD("on EP %02X with %u bytes\r\n", ep_addr, (unsigned int) event.xfer_complete.len);
-
-        _usbd_dev.ep_status[epnum][ep_dir].busy = 0;
-        _usbd_dev.ep_status[epnum][ep_dir].claimed = 0;
-
-        if (0 == epnum) {
-          usbd_control_xfer_cb(event.rhport, ep_addr, (xfer_result_t) event.xfer_complete.result,
-                               event.xfer_complete.len);
-        } else {
-          usbd_class_driver_t const* driver = get_driver(_usbd_dev.ep2drv[epnum][ep_dir]);
-          TU_ASSERT(driver,);
-
-          TU_LOG_USBD("  %s xfer callback\r\n", driver->name);
-          driver->xfer_cb(event.rhport, ep_addr, (xfer_result_t) event.xfer_complete.result, event.xfer_complete.len);
-        }
-        break;
+  // Loop until there is no more events in the queue
+  while (1) {
+    dcd_event_t events[CFG_TUD_TASK_EVENT_BATCH];
+    uint8_t const count = usbd_queue_receive(events, CFG_TUD_TASK_EVENT_BATCH, timeout_ms);
+    if (0 == count) return;
+    usbd_stats_dequeued(count);
+
+    for (uint8_t i = 0; i < count; i++) {
+      // coalesce consecutive SOFs, only the latest one is reported
+      if (events[i].event_id == DCD_EVENT_SOF && (i + 1u) < count && events[i + 1].event_id == DCD_EVENT_SOF &&
+          events[i].rhport == events[i + 1].rhport) {
+        continue;
       }
-
-      case DCD_EVENT_SUSPEND:
-        // NOTE: When plugging/unplugging device, the D+/D- state are unstable and
-        // can accidentally meet the SUSPEND condition ( Bus Idle for 3ms ), which result in a series of event
-        // e.g suspend -> resume -> unplug/plug. Skip suspend/resume if not connected
-        if (_usbd_dev.connected) {
-          TU_LOG_USBD(": Remote Wakeup = %u\r\n", _usbd_dev.remote_wakeup_en);
-          tud_suspend_cb(_usbd_dev.remote_wakeup_en);
-        } else {
-          TU_LOG_USBD(" Skipped\r\n");
-        }
-        break;
-
-      case DCD_EVENT_RESUME:
-        if (_usbd_dev.connected) {
-          TU_LOG_USBD("\r\n");
-          tud_resume_cb();
-        } else {
-          TU_LOG_USBD(" Skipped\r\n");
-        }
-        break;
-
-      case USBD_EVENT_FUNC_CALL:
-        TU_LOG_USBD("\r\n");
-        if (event.func_call.func) event.func_call.func(event.func_call.param);
-        break;
-
-      case DCD_EVENT_SOF:
-        if (tu_bit_test(_usbd_dev.sof_consumer, SOF_CONSUMER_USER)) {
-          TU_LOG_USBD("\r\n");
-          tud_sof_cb(event.sof.frame_count);
-        }
-      break;
-
-      default:
-        TU_BREAKPOINT();
-        break;
+      usbd_process_event(&events[i]);
     }
 
 #if CFG_TUSB_OS != OPT_OS_NONE && CFG_TUSB_OS != OPT_OS_PICO
     // return if there is no more events, for application to run other background
-    if (osal_queue_empty(_usbd_q)) return;
+    if (usbd_queue_empty()) return;
 #endif
   }
 }
@@ -712,7 +1515,7 @@ void tud_task_ext(uint32_t timeout_ms, bool in_isr) {
 
 // Helper to invoke class driver control request handler
 static bool invoke_class_control(uint8_t rhport, usbd_class_driver_t const * driver, tusb_control_request_t const * request) {
-  usbd_control_set_complete_callback(driver->control_xfer_cb);
+  usbd_control_set_complete_callback(rhport, driver->control_xfer_cb);
   TU_LOG_USBD("  %s control request\r\n", driver->name);
   return driver->control_xfer_cb(rhport, CONTROL_STAGE_SETUP, request);
 }
@@ -720,12 +1523,13 @@ static bool invoke_class_control(uint8_t rhport, usbd_class_driver_t const * dri
 // This handles the actual request and its response.
 // Returns false if unable to complete the request, causing caller to stall control endpoints.
 static bool process_control_request(uint8_t rhport, tusb_control_request_t const * p_request) {
-  usbd_control_set_complete_callback(NULL);
+  usbd_device_t* dev = get_dev(rhport);
+  usbd_control_set_complete_callback(rhport, NULL);
   TU_ASSERT(p_request->bmRequestType_bit.type < TUSB_REQ_TYPE_INVALID);
 
   // Vendor request
   if ( p_request->bmRequestType_bit.type == TUSB_REQ_TYPE_VENDOR ) {
-    usbd_control_set_complete_callback(tud_vendor_control_xfer_cb);
+    usbd_control_set_complete_callback(rhport, tud_vendor_control_xfer_cb);
     return tud_vendor_control_xfer_cb(rhport, CONTROL_STAGE_SETUP, p_request);
   }
 
@@ -741,9 +1545,9 @@ static bool process_control_request(uint8_t rhport, tusb_control_request_t const
     case TUSB_REQ_RCPT_DEVICE:
       if ( TUSB_REQ_TYPE_CLASS == p_request->bmRequestType_bit.type ) {
         uint8_t const itf = tu_u16_low(p_request->wIndex);
-        TU_VERIFY(itf < TU_ARRAY_SIZE(_usbd_dev.itf2drv));
+        TU_VERIFY(itf < TU_ARRAY_SIZE(dev->itf2drv));
 
-        usbd_class_driver_t const * driver = get_driver(_usbd_dev.itf2drv[itf]);
+        usbd_class_driver_t const * driver = get_driver(dev->itf2drv[itf]);
         TU_VERIFY(driver);
 
         // forward to class driver: "non-STD request to Interface"
@@ -761,14 +1565,15 @@ static bool process_control_request(uint8_t rhport, tusb_control_request_t const
           // Depending on mcu, status phase could be sent either before or after changing device address,
           // or even require stack to not response with status at all
           // Therefore DCD must take full responsibility to response and include zlp status packet if needed.
-          usbd_control_set_request(p_request); // set request since DCD has no access to tud_control_status() API
+          usbd_control_set_request(rhport, p_request); // set request since DCD has no access to tud_control_status() API
           dcd_set_address(rhport, (uint8_t) p_request->wValue);
           // skip tud_control_status()
-          _usbd_dev.addressed = 1;
+          dev->addressed = 1;
+          usbd_stats_enum(addressed);
         break;
 
         case TUSB_REQ_GET_CONFIGURATION: {
-          uint8_t cfg_num = _usbd_dev.cfg_num;
+          uint8_t cfg_num = dev->cfg_num;
           tud_control_xfer(rhport, p_request, &cfg_num, 1);
         }
         break;
@@ -777,10 +1582,10 @@ static bool process_control_request(uint8_t rhport, tusb_control_request_t const
           uint8_t const cfg_num = (uint8_t) p_request->wValue;
 
           // Only process if new configure is different
-          if (_usbd_dev.cfg_num != cfg_num) {
-            if ( _usbd_dev.cfg_num ) {
+          if (dev->cfg_num != cfg_num) {
+            if ( dev->cfg_num ) {
               // already configured: need to clear all endpoints and driver first
-              TU_LOG_USBD("  Clear current Configuration (%u) before switching\r\n", _usbd_dev.cfg_num);
+              TU_LOG_USBD("  Clear current Configuration (%u) before switching\r\n", dev->cfg_num);
 
               // disable SOF
               dcd_sof_enable(rhport, false);
@@ -789,13 +1594,13 @@ static bool process_control_request(uint8_t rhport, tusb_control_request_t const
               dcd_edpt_close_all(rhport);
 
               // close all drivers and current configured state except bus speed
-              uint8_t const speed = _usbd_dev.speed;
+              uint8_t const speed = dev->speed;
               configuration_reset(rhport);
 
-              _usbd_dev.speed = speed; // restore speed
+              dev->speed = speed; // restore speed
             }
 
-            _usbd_dev.cfg_num = cfg_num;
+            dev->cfg_num = cfg_num;
 
             // Handle the new configuration and execute the corresponding callback
             if ( cfg_num ) {
@@ -803,9 +1608,10 @@ static bool process_control_request(uint8_t rhport, tusb_control_request_t const
               if (!process_set_config(rhport, cfg_num)) {
                 TU_MESS_FAILED();
                 TU_BREAKPOINT();
-                _usbd_dev.cfg_num = 0;
+                dev->cfg_num = 0;
                 return false;
               }
+              usbd_stats_enum(configured);
               tud_mount_cb();
             } else {
               tud_umount_cb();
@@ -825,7 +1631,7 @@ static bool process_control_request(uint8_t rhport, tusb_control_request_t const
             case TUSB_REQ_FEATURE_REMOTE_WAKEUP:
               TU_LOG_USBD("    Enable Remote Wakeup\r\n");
               // Host may enable remote wake up before suspending especially HID device
-              _usbd_dev.remote_wakeup_en = true;
+              dev->remote_wakeup_en = true;
               tud_control_status(rhport, p_request);
             break;
 
@@ -837,7 +1643,7 @@ static bool process_control_request(uint8_t rhport, tusb_control_request_t const
               uint8_t const selector = tu_u16_high(p_request->wIndex);
               TU_VERIFY(TUSB_FEATURE_TEST_J <= selector && selector <= TUSB_FEATURE_TEST_FORCE_ENABLE);
 
-              usbd_control_set_complete_callback(process_test_mode_cb);
+              usbd_control_set_complete_callback(rhport, process_test_mode_cb);
               tud_control_status(rhport, p_request);
               break;
             }
@@ -855,7 +1661,7 @@ static bool process_control_request(uint8_t rhport, tusb_control_request_t const
           TU_LOG_USBD("    Disable Remote Wakeup\r\n");
 
           // Host may disable remote wake up after resuming
-          _usbd_dev.remote_wakeup_en = false;
+          dev->remote_wakeup_en = false;
           tud_control_status(rhport, p_request);
         break;
 
@@ -863,7 +1669,7 @@ static bool process_control_request(uint8_t rhport, tusb_control_request_t const
           // Device status bit mask
           // - Bit 0: Self Powered
           // - Bit 1: Remote Wakeup enabled
-          uint16_t status = (uint16_t) ((_usbd_dev.self_powered ? 1u : 0u) | (_usbd_dev.remote_wakeup_en ? 2u : 0u));
+          uint16_t status = (uint16_t) ((dev->self_powered ? 1u : 0u) | (dev->remote_wakeup_en ? 2u : 0u));
           tud_control_xfer(rhport, p_request, &status, 2);
           break;
         }
@@ -876,9 +1682,9 @@ static bool process_control_request(uint8_t rhport, tusb_control_request_t const
     //------------- Class/Interface Specific Request -------------//
     case TUSB_REQ_RCPT_INTERFACE: {
       uint8_t const itf = tu_u16_low(p_request->wIndex);
-      TU_VERIFY(itf < TU_ARRAY_SIZE(_usbd_dev.itf2drv));
+      TU_VERIFY(itf < TU_ARRAY_SIZE(dev->itf2drv));
 
-      usbd_class_driver_t const * driver = get_driver(_usbd_dev.itf2drv[itf]);
+      usbd_class_driver_t const * driver = get_driver(dev->itf2drv[itf]);
       TU_VERIFY(driver);
 
       // all requests to Interface (STD or Class) is forwarded to class driver.
@@ -892,7 +1698,7 @@ static bool process_control_request(uint8_t rhport, tusb_control_request_t const
           case TUSB_REQ_GET_INTERFACE:
           case TUSB_REQ_SET_INTERFACE:
             // Clear complete callback if driver set since it can also stall the request.
-            usbd_control_set_complete_callback(NULL);
+            usbd_control_set_complete_callback(rhport, NULL);
 
             if (TUSB_REQ_GET_INTERFACE == p_request->bRequest) {
               uint8_t alternate = 0;
@@ -914,8 +1720,8 @@ static bool process_control_request(uint8_t rhport, tusb_control_request_t const
       uint8_t const ep_num  = tu_edpt_number(ep_addr);
       uint8_t const ep_dir  = tu_edpt_dir(ep_addr);
 
-      TU_ASSERT(ep_num < TU_ARRAY_SIZE(_usbd_dev.ep2drv) );
-      usbd_class_driver_t const * driver = get_driver(_usbd_dev.ep2drv[ep_num][ep_dir]);
+      TU_ASSERT(ep_num < TU_ARRAY_SIZE(dev->ep2drv) );
+      usbd_class_driver_t const * driver = get_driver(dev->ep2drv[ep_num][ep_dir]);
 
       if ( TUSB_REQ_TYPE_STANDARD != p_request->bmRequestType_bit.type ) {
         // Forward class request to its driver
@@ -947,10 +1753,10 @@ static bool process_control_request(uint8_t rhport, tusb_control_request_t const
               // STD request must always be ACKed regardless of driver returned value
               // Also clear complete callback if driver set since it can also stall the request.
               (void) invoke_class_control(rhport, driver, p_request);
-              usbd_control_set_complete_callback(NULL);
+              usbd_control_set_complete_callback(rhport, NULL);
 
               // skip ZLP status if driver already did that
-              if ( !_usbd_dev.ep_status[0][TUSB_DIR_IN].busy ) tud_control_status(rhport, p_request);
+              if ( !dev->ep_status[0][TUSB_DIR_IN].busy ) tud_control_status(rhport, p_request);
             }
           }
           break;
@@ -975,15 +1781,106 @@ static bool process_control_request(uint8_t rhport, tusb_control_request_t const
 
 // Process Set Configure Request
 // This function parse configuration descriptor & open drivers accordingly
+#if CFG_TUD_ITF_INDEX_MAX
+// Index all interface descriptors of configuration, those beyond CFG_TUD_ITF_INDEX_MAX are not indexed
+static void itf_index_build(uint8_t rhport, tusb_desc_configuration_t const* desc_cfg) {
+  usbd_device_t* dev = get_dev(rhport);
+  uint8_t const* p_desc = (uint8_t const*) desc_cfg;
+  uint8_t const* desc_end = p_desc + tu_le16toh(desc_cfg->wTotalLength);
+
+  dev->desc_cfg = p_desc;
+  dev->itf_count = 0;
+  tu_varclr(&dev->itf_first);
+
+  while (p_desc < desc_end && dev->itf_count < CFG_TUD_ITF_INDEX_MAX) {
+    if (TUSB_DESC_INTERFACE == tu_desc_type(p_desc)) {
+      tusb_desc_interface_t const* desc_itf = (tusb_desc_interface_t const*) p_desc;
+      uint8_t const itf_num = desc_itf->bInterfaceNumber;
+      usbd_itf_index_t* entry = &dev->itf_index[dev->itf_count++];
+
+      entry->offset = (uint16_t) (p_desc - dev->desc_cfg);
+      entry->itf_num = itf_num;
+      entry->alt = desc_itf->bAlternateSetting;
+
+      if (itf_num < CFG_TUD_INTERFACE_MAX && 0 == dev->itf_first[itf_num]) {
+        dev->itf_first[itf_num] = dev->itf_count;
+      }
+    }
+    p_desc = tu_desc_next(p_desc);
+  }
+}
+#endif
+
+tusb_desc_interface_t const* usbd_find_interface_desc(uint8_t rhport, uint8_t itf_num, uint8_t alt) {
+#if CFG_TUD_ITF_INDEX_MAX
+  usbd_device_t const* dev = get_dev(rhport);
+  TU_VERIFY(itf_num < CFG_TUD_INTERFACE_MAX && dev->itf_first[itf_num], NULL);
+
+  // alternate settings are usually listed in order right after each other
+  uint8_t idx = (uint8_t) (dev->itf_first[itf_num] - 1);
+  if (alt < dev->itf_count - idx && dev->itf_index[idx + alt].itf_num == itf_num &&
+      dev->itf_index[idx + alt].alt == alt) {
+    idx = (uint8_t) (idx + alt);
+  } else {
+    while (idx < dev->itf_count &&
+           (dev->itf_index[idx].itf_num != itf_num || dev->itf_index[idx].alt != alt)) {
+      idx++;
+    }
+    TU_VERIFY(idx < dev->itf_count, NULL);
+  }
+
+  return (tusb_desc_interface_t const*) (dev->desc_cfg + dev->itf_index[idx].offset);
+#else
+  (void) rhport; (void) itf_num; (void) alt;
+  return NULL;
+#endif
+}
+
+// Device and configuration descriptors from callbacks, cached until bus reset with CFG_TUD_FAST_BOOT
+static uint8_t const* usbd_desc_device(usbd_device_t* dev) {
+#if CFG_TUD_FAST_BOOT
+  if (dev->desc_dev_cache == NULL) {
+    dev->desc_dev_cache = tud_descriptor_device_cb();
+  }
+  return dev->desc_dev_cache;
+#else
+  (void) dev;
+  return tud_descriptor_device_cb();
+#endif
+}
+
+static uint8_t const* usbd_desc_configuration(usbd_device_t* dev, uint8_t index) {
+#if CFG_TUD_FAST_BOOT
+  if (dev->desc_cfg_cache == NULL || dev->desc_cfg_cache_idx != index) {
+    dev->desc_cfg_cache = tud_descriptor_configuration_cb(index);
+    dev->desc_cfg_cache_idx = index;
+  }
+  return dev->desc_cfg_cache;
+#else
+  (void) dev;
+  return tud_descriptor_configuration_cb(index);
+#endif
+}
+
 static bool process_set_config(uint8_t rhport, uint8_t cfg_num)
 {
+  usbd_device_t* dev = get_dev(rhport);
   // index is cfg_num-1
-  tusb_desc_configuration_t const * desc_cfg = (tusb_desc_configuration_t const *) tud_descriptor_configuration_cb(cfg_num-1);
+  tusb_desc_configuration_t const * desc_cfg = (tusb_desc_configuration_t const *) usbd_desc_configuration(dev, cfg_num-1);
   TU_ASSERT(desc_cfg != NULL && desc_cfg->bDescriptorType == TUSB_DESC_CONFIGURATION);
 
   // Parse configuration descriptor
-  _usbd_dev.remote_wakeup_support = (desc_cfg->bmAttributes & TUSB_DESC_CONFIG_ATT_REMOTE_WAKEUP) ? 1u : 0u;
-  _usbd_dev.self_powered          = (desc_cfg->bmAttributes & TUSB_DESC_CONFIG_ATT_SELF_POWERED ) ? 1u : 0u;
+  dev->remote_wakeup_support = (desc_cfg->bmAttributes & TUSB_DESC_CONFIG_ATT_REMOTE_WAKEUP) ? 1u : 0u;
+  dev->self_powered          = (desc_cfg->bmAttributes & TUSB_DESC_CONFIG_ATT_SELF_POWERED ) ? 1u : 0u;
+
+#if CFG_TUD_ITF_INDEX_MAX
+  itf_index_build(rhport, desc_cfg);
+#endif
+
+  // Let DCD plan endpoint buffers for the whole configuration
+  if (dcd_edpt_config_plan != NULL) {
+    dcd_edpt_config_plan(rhport, desc_cfg);
+  }
 
   // Parse interface descriptor
   uint8_t const * p_desc   = ((uint8_t const*) desc_cfg) + sizeof(tusb_desc_configuration_t);
@@ -1046,12 +1943,12 @@ static bool process_set_config(uint8_t rhport, uint8_t cfg_num)
           uint8_t const itf_num = desc_itf->bInterfaceNumber+i;
 
           // Interface number must not be used already
-          TU_ASSERT(DRVID_INVALID == _usbd_dev.itf2drv[itf_num]);
-          _usbd_dev.itf2drv[itf_num] = drv_id;
+          TU_ASSERT(DRVID_INVALID == dev->itf2drv[itf_num]);
+          dev->itf2drv[itf_num] = drv_id;
         }
 
         // bind all endpoints to found driver
-        tu_edpt_bind_driver(_usbd_dev.ep2drv, desc_itf, drv_len, drv_id);
+        tu_edpt_bind_driver(dev->ep2drv, desc_itf, drv_len, drv_id);
 
         // next Interface
         p_desc += drv_len;
@@ -1070,6 +1967,7 @@ static bool process_set_config(uint8_t rhport, uint8_t cfg_num)
 // return descriptor's buffer and update desc_len
 static bool process_get_descriptor(uint8_t rhport, tusb_control_request_t const * p_request)
 {
+  usbd_device_t* dev = get_dev(rhport);
   tusb_desc_type_t const desc_type = (tusb_desc_type_t) tu_u16_high(p_request->wValue);
   uint8_t const desc_index = tu_u16_low( p_request->wValue );
 
@@ -1078,12 +1976,13 @@ static bool process_get_descriptor(uint8_t rhport, tusb_control_request_t const
     case TUSB_DESC_DEVICE: {
       TU_LOG_USBD(" Device\r\n");
 
-      void* desc_device = (void*) (uintptr_t) tud_descriptor_device_cb();
+      void* desc_device = (void*) (uintptr_t) usbd_desc_device(dev);
       TU_ASSERT(desc_device);
+      usbd_stats_enum(desc_device);
 
       // Only response with exactly 1 Packet if: not addressed and host requested more data than device descriptor has.
       // This only happens with the very first get device descriptor and EP0 size = 8 or 16.
-      if ((CFG_TUD_ENDPOINT0_SIZE < sizeof(tusb_desc_device_t)) && !_usbd_dev.addressed &&
+      if ((CFG_TUD_ENDPOINT0_SIZE < sizeof(tusb_desc_device_t)) && !dev->addressed &&
           ((tusb_control_request_t const*) p_request)->wLength > sizeof(tusb_desc_device_t)) {
         // Hack here: we modify the request length to prevent usbd_control response with zlp
         // since we are responding with 1 packet & less data than wLength.
@@ -1117,8 +2016,9 @@ static bool process_get_descriptor(uint8_t rhport, tusb_control_request_t const
 
       if ( desc_type == TUSB_DESC_CONFIGURATION ) {
         TU_LOG_USBD(" Configuration[%u]\r\n", desc_index);
-        desc_config = (uintptr_t) tud_descriptor_configuration_cb(desc_index);
+        desc_config = (uintptr_t) usbd_desc_configuration(dev, desc_index);
         TU_ASSERT(desc_config);
+        usbd_stats_enum(desc_config);
       }else {
         // Host only request this after getting Device Qualifier descriptor
         TU_LOG_USBD(" Other Speed Configuration\r\n");
@@ -1161,14 +2061,107 @@ static bool process_get_descriptor(uint8_t rhport, tusb_control_request_t const
 //--------------------------------------------------------------------+
 // DCD Event Handler
 //--------------------------------------------------------------------+
+#if CFG_TUD_XFER_ISR
+#if OSAL_MUTEX_REQUIRED
+  #error "CFG_TUD_XFER_ISR is not supported with RTOS or multiple cores"
+#endif
+
+// Hand transfer complete event to class driver in ISR, return false if it should be deferred to usbd task
+TU_ATTR_FAST_FUNC static bool usbd_xfer_isr(dcd_event_t const* event) {
+  usbd_device_t* dev = get_dev(event->rhport);
+  uint8_t const ep_addr = event->xfer_complete.ep_addr;
+  uint8_t const epnum = tu_edpt_number(ep_addr);
+  uint8_t const ep_dir = tu_edpt_dir(ep_addr);
+
+  TU_VERIFY(epnum != 0);
+  uint8_t const drv_id = dev->ep2drv[epnum][ep_dir];
+  usbd_class_driver_t const* driver = get_driver(drv_id);
+  TU_VERIFY(driver && driver->xfer_isr);
+  #if CFG_TUD_EDPT_XFER_QUEUE
+  // endpoint is busy with a chained transfer, let usbd task account for it
+  TU_VERIFY(0 == dev->ep_xferq[epnum][ep_dir].chained);
+  #endif
+
+  // free endpoint so that driver can re-arm it, restore if driver defers the event
+  dev->ep_status[epnum][ep_dir].busy = 0;
+  dev->ep_status[epnum][ep_dir].claimed = 0;
+  dev->ep_frame[epnum][ep_dir] = event->xfer_complete.frame;
+
+  uint32_t const ts = usbd_stats_timestamp();
+  bool const handled = driver->xfer_isr(event->rhport, ep_addr, (xfer_result_t) event->xfer_complete.result,
+                                        event->xfer_complete.len);
+  usbd_stats_driver(drv_id, ts);
+  if (handled) {
+    usbd_stats_xfer_complete(event, false);
+    return true;
+  }
+
+  dev->ep_status[epnum][ep_dir].busy = 1;
+  return false;
+}
+#endif
+
+#if CFG_TUD_EDPT_XFER_EX
+// Continue a large transfer with its next chunk. Return NULL if next chunk is started (event is consumed),
+// otherwise the event to report: either the original one or a copy with the total length of large transfer.
+TU_ATTR_FAST_FUNC static dcd_event_t const* usbd_xfer_ex_isr(dcd_event_t const* event, dcd_event_t* event_ex) {
+  uint8_t const ep_addr = event->xfer_complete.ep_addr;
+  uint8_t const epnum = tu_edpt_number(ep_addr);
+  if (epnum >= CFG_TUD_ENDPPOINT_MAX) return event;
+
+  usbd_xfer_ex_t* xfer = &get_dev(event->rhport)->ep_xfer_ex[epnum][tu_edpt_dir(ep_addr)];
+  if (!xfer->active) return event;
+
+  xfer->xferred += event->xfer_complete.len;
+
+  // short packet or error ends the transfer
+  if (event->xfer_complete.result == XFER_RESULT_SUCCESS && event->xfer_complete.len == xfer->chunk &&
+      xfer->remaining > 0) {
+    uint16_t const chunk = (uint16_t) tu_min32(xfer->remaining, CFG_TUD_EDPT_XFER_EX_CHUNK);
+    if (dcd_edpt_xfer(event->rhport, ep_addr, xfer->buffer, chunk)) {
+      xfer->buffer += chunk;
+      xfer->remaining -= chunk;
+      xfer->chunk = chunk;
+      return NULL;
+    }
+  }
+
+  xfer->active = 0;
+  *event_ex = *event;
+  event_ex->xfer_complete.len = xfer->xferred;
+  return event_ex;
+}
+#endif
+
+#if CFG_TUD_EDPT_XFER_QUEUE
+// Start the queued transfer of an endpoint right after the active one completes
+TU_ATTR_FAST_FUNC static void usbd_xfer_queue_isr(dcd_event_t const* event) {
+  uint8_t const ep_addr = event->xfer_complete.ep_addr;
+  uint8_t const epnum = tu_edpt_number(ep_addr);
+  if (epnum == 0 || epnum >= CFG_TUD_ENDPPOINT_MAX) return;
+
+  usbd_xfer_queue_t* xferq = &get_dev(event->rhport)->ep_xferq[epnum][tu_edpt_dir(ep_addr)];
+  if (xferq->pending) {
+    tu_capture_xfer_submit(event->rhport, false, 0, ep_addr, xferq->buffer, xferq->total_bytes);
+    if (dcd_edpt_xfer(event->rhport, ep_addr, xferq->buffer, xferq->total_bytes)) {
+      xferq->pending = 0;
+      xferq->chained++;
+    }
+  }
+}
+#endif
+
 TU_ATTR_FAST_FUNC void dcd_event_handler(dcd_event_t const* event, bool in_isr) {
+  usbd_device_t* dev = get_dev(event->rhport);
+  usbd_port_t* port = get_port(event->rhport);
   bool send = false;
   switch (event->event_id) {
     case DCD_EVENT_UNPLUGGED:
-      _usbd_dev.connected = 0;
-      _usbd_dev.addressed = 0;
-      _usbd_dev.cfg_num = 0;
-      _usbd_dev.suspended = 0;
+      dev->connected = 0;
+      dev->addressed = 0;
+      dev->cfg_num = 0;
+      dev->suspended = 0;
+      dev->lpm_sleeping = 0;
       send = true;
       break;
 
@@ -1177,16 +2170,26 @@ TU_ATTR_FAST_FUNC void dcd_event_handler(dcd_event_t const* event, bool in_isr)
       // can accidentally meet the SUSPEND condition ( Bus Idle for 3ms ).
       // In addition, some MCUs such as SAMD or boards that haven no VBUS detection cannot distinguish
       // suspended vs disconnected. We will skip handling SUSPEND/RESUME event if not currently connected
-      if (_usbd_dev.connected) {
-        _usbd_dev.suspended = 1;
+      if (dev->connected) {
+        dev->suspended = 1;
+        send = true;
+      }
+      break;
+
+    case DCD_EVENT_LPM_SLEEP:
+      if (dev->connected) {
+        dev->suspended = 1;
+        dev->lpm_sleeping = 1;
+        dev->lpm_remote_wakeup = event->lpm_sleep.remote_wakeup ? 1u : 0u;
         send = true;
       }
       break;
 
     case DCD_EVENT_RESUME:
       // skip event if not connected (especially required for SAMD)
-      if (_usbd_dev.connected) {
-        _usbd_dev.suspended = 0;
+      if (dev->connected) {
+        dev->suspended = 0;
+        dev->lpm_sleeping = 0;
         send = true;
       }
       break;
@@ -1202,23 +2205,54 @@ TU_ATTR_FAST_FUNC void dcd_event_handler(dcd_event_t const* event, bool in_isr)
 
       // Some MCUs after running dcd_remote_wakeup() does not have way to detect the end of remote wakeup
       // which last 1-15 ms. DCD can use SOF as a clear indicator that bus is back to operational
-      if (_usbd_dev.suspended) {
-        _usbd_dev.suspended = 0;
+      if (dev->suspended) {
+        dev->suspended = 0;
+        dev->lpm_sleeping = 0;
 
         dcd_event_t const event_resume = {.rhport = event->rhport, .event_id = DCD_EVENT_RESUME};
         queue_event(&event_resume, in_isr);
       }
 
-      if (tu_bit_test(_usbd_dev.sof_consumer, SOF_CONSUMER_USER)) {
-        dcd_event_t const event_sof = {.rhport = event->rhport, .event_id = DCD_EVENT_SOF, .sof.frame_count = event->sof.frame_count};
-        queue_event(&event_sof, in_isr);
+      if (tu_bit_test(dev->sof_consumer, SOF_CONSUMER_USER)) {
+        // only every divider-th SOF is reported, and only deferred to usbd task if ISR callback requests it
+        if (port->sof_countdown) {
+          port->sof_countdown--;
+        } else {
+          port->sof_countdown = port->sof_divider ? (uint16_t) (port->sof_divider - 1) : 0;
+          if (tud_sof_isr_cb(event->sof.frame_count)) {
+            dcd_event_t const event_sof = {.rhport = event->rhport, .event_id = DCD_EVENT_SOF, .sof.frame_count = event->sof.frame_count};
+            queue_event(&event_sof, in_isr);
+          }
+        }
       }
       break;
 
     case DCD_EVENT_SETUP_RECEIVED:
-      _usbd_queued_setup++;
+      port->queued_setup++;
+      tu_capture_setup(event->rhport, false, 0, (uint8_t const*) &event->setup_received);
+      send = true;
+      break;
+
+    #if CFG_TUD_XFER_ISR || CFG_TUD_EDPT_XFER_QUEUE || CFG_TUD_EDPT_XFER_EX || CFG_TUSB_CAPTURE
+    case DCD_EVENT_XFER_COMPLETE: {
+      #if CFG_TUD_EDPT_XFER_EX
+      dcd_event_t event_ex;
+      event = usbd_xfer_ex_isr(event, &event_ex);
+      if (event == NULL) break; // next chunk is started
+      #endif
+      tu_capture_xfer_complete(event->rhport, false, 0, event->xfer_complete.ep_addr,
+                               (xfer_result_t) event->xfer_complete.result, event->xfer_complete.len);
+      #if CFG_TUD_EDPT_XFER_QUEUE
+      usbd_xfer_queue_isr(event);
+      #endif
+      #if CFG_TUD_XFER_ISR
+      send = !(in_isr && usbd_xfer_isr(event));
+      #else
       send = true;
+      #endif
       break;
+    }
+    #endif
 
     default:
       send = true;
@@ -1236,6 +2270,18 @@ TU_ATTR_FAST_FUNC void dcd_event_handler(dcd_event_t const* event, bool in_isr)
 
 void usbd_int_set(bool enabled)
 {
+#if CFG_TUD_RHPORT_NUM > 1
+  // event queue is shared by all ports
+  for (uint8_t rhport = 0; rhport < CFG_TUD_RHPORT_NUM; rhport++) {
+    if (tu_bit_test(_usbd_rhport_mask, rhport)) {
+      if (enabled) {
+        dcd_int_enable(rhport);
+      } else {
+        dcd_int_disable(rhport);
+      }
+    }
+  }
+#else
   if (enabled)
   {
     dcd_int_enable(_usbd_rhport);
@@ -1243,6 +2289,7 @@ void usbd_int_set(bool enabled)
   {
     dcd_int_disable(_usbd_rhport);
   }
+#endif
 }
 
 // Parse consecutive endpoint descriptors (IN & OUT)
@@ -1271,13 +2318,38 @@ bool usbd_open_edpt_pair(uint8_t rhport, uint8_t const* p_desc, uint8_t ep_count
 
 // Helper to defer an isr function
 void usbd_defer_func(osal_task_func_t func, void* param, bool in_isr) {
+  usbd_defer_func_prio(func, param, TU_DEFER_PRIO_NORMAL, in_isr);
+}
+
+void usbd_defer_func_prio(osal_task_func_t func, void* param, uint8_t prio, bool in_isr) {
   dcd_event_t event = {
       .rhport   = 0,
       .event_id = USBD_EVENT_FUNC_CALL,
   };
+
+#if CFG_TUD_DEFER_POOL_SIZE
+  bool kick = false;
+  usbd_defer_lock(in_isr);
+  bool const pooled = tu_defer_pool_add(&_usbd_defer, func, param, prio, &kick);
+  usbd_defer_unlock(in_isr);
+
+  if (pooled) {
+    // a single event (func = NULL) runs all pending calls
+    if (kick && !queue_event(&event, in_isr)) {
+      usbd_defer_lock(in_isr);
+      _usbd_defer.kicked = false;
+      usbd_defer_unlock(in_isr);
+    }
+    return;
+  }
+  TU_LOG_USBD("Defer pool is full\r\n");
+#else
+  (void) prio;
+#endif
+
+  // pool is full or not used: queue the call itself
   event.func_call.func  = func;
   event.func_call.param = param;
-
   queue_event(&event, in_isr);
 }
 
@@ -1286,39 +2358,59 @@ void usbd_defer_func(osal_task_func_t func, void* param, bool in_isr) {
 //--------------------------------------------------------------------+
 
 bool usbd_edpt_open(uint8_t rhport, tusb_desc_endpoint_t const* desc_ep) {
-  rhport = _usbd_rhport;
+  rhport = USBD_RHPORT(rhport);
+  usbd_device_t* dev = get_dev(rhport);
 
   TU_ASSERT(tu_edpt_number(desc_ep->bEndpointAddress) < CFG_TUD_ENDPPOINT_MAX);
-  TU_ASSERT(tu_edpt_validate(desc_ep, (tusb_speed_t) _usbd_dev.speed));
+  TU_ASSERT(tu_edpt_validate(desc_ep, (tusb_speed_t) dev->speed));
 
+  tu_capture_edpt_open(rhport, false, 0, desc_ep->bEndpointAddress, desc_ep->bmAttributes.xfer);
   return dcd_edpt_open(rhport, desc_ep);
 }
 
 bool usbd_edpt_claim(uint8_t rhport, uint8_t ep_addr) {
-  (void) rhport;
+  return usbd_edpt_claim_ex(rhport, ep_addr, false);
+}
+
+bool usbd_edpt_claim_ex(uint8_t rhport, uint8_t ep_addr, bool in_isr) {
+  usbd_device_t* dev = get_dev(rhport);
 
   // TODO add this check later, also make sure we don't starve an out endpoint while suspending
   // TU_VERIFY(tud_ready());
 
   uint8_t const epnum = tu_edpt_number(ep_addr);
   uint8_t const dir = tu_edpt_dir(ep_addr);
-  tu_edpt_state_t* ep_state = &_usbd_dev.ep_status[epnum][dir];
+  tu_edpt_state_t* ep_state = &dev->ep_status[epnum][dir];
+
+#if CFG_TUD_XFER_ISR
+  // endpoint can also be claimed by class driver's xfer_isr(): disable usb interrupt while claiming from task.
+  // Within usb ISR it is already masked and must not be re-enabled before the handler returns
+  if (!in_isr) {
+    usbd_int_set(false);
+    bool const ret = tu_edpt_claim(ep_state, _usbd_mutex);
+    usbd_int_set(true);
+    return ret;
+  }
+#else
+  (void) in_isr;
+#endif
 
   return tu_edpt_claim(ep_state, _usbd_mutex);
 }
 
 bool usbd_edpt_release(uint8_t rhport, uint8_t ep_addr) {
-  (void) rhport;
+  usbd_device_t* dev = get_dev(rhport);
 
   uint8_t const epnum = tu_edpt_number(ep_addr);
   uint8_t const dir = tu_edpt_dir(ep_addr);
-  tu_edpt_state_t* ep_state = &_usbd_dev.ep_status[epnum][dir];
+  tu_edpt_state_t* ep_state = &dev->ep_status[epnum][dir];
 
   return tu_edpt_release(ep_state, _usbd_mutex);
 }
 
 bool usbd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint16_t total_bytes) {
-  rhport = _usbd_rhport;
+  rhport = USBD_RHPORT(rhport);
+  usbd_device_t* dev = get_dev(rhport);
 
   uint8_t const epnum = tu_edpt_number(ep_addr);
   uint8_t const dir = tu_edpt_dir(ep_addr);
@@ -1334,30 +2426,148 @@ bool usbd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint16_t t
 #endif
 
   // Attempt to transfer on a busy endpoint, sound like an race condition !
-  TU_ASSERT(_usbd_dev.ep_status[epnum][dir].busy == 0);
+  TU_ASSERT(dev->ep_status[epnum][dir].busy == 0);
 
   // Set busy first since the actual transfer can be complete before dcd_edpt_xfer()
   // could return and USBD task can preempt and clear the busy
-  _usbd_dev.ep_status[epnum][dir].busy = 1;
+  dev->ep_status[epnum][dir].busy = 1;
+  tu_capture_xfer_submit(rhport, false, 0, ep_addr, buffer, total_bytes);
 
   if (dcd_edpt_xfer(rhport, ep_addr, buffer, total_bytes)) {
+    usbd_stats_submit(ep_addr);
     return true;
   } else {
     // DCD error, mark endpoint as ready to allow next transfer
-    _usbd_dev.ep_status[epnum][dir].busy = 0;
-    _usbd_dev.ep_status[epnum][dir].claimed = 0;
+    dev->ep_status[epnum][dir].busy = 0;
+    dev->ep_status[epnum][dir].claimed = 0;
     TU_LOG_USBD("FAILED\r\n");
     TU_BREAKPOINT();
     return false;
   }
 }
 
+#if CFG_TUD_EDPT_XFER_EX
+TU_VERIFY_STATIC(CFG_TUD_EDPT_XFER_EX_CHUNK <= UINT16_MAX && (CFG_TUD_EDPT_XFER_EX_CHUNK % 1024) == 0,
+                 "CFG_TUD_EDPT_XFER_EX_CHUNK must be multiple of 1024 and fit 16-bit");
+
+bool usbd_edpt_xfer_ex(uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint32_t total_bytes) {
+  rhport = USBD_RHPORT(rhport);
+  usbd_device_t* dev = get_dev(rhport);
+
+  uint8_t const epnum = tu_edpt_number(ep_addr);
+  uint8_t const dir = tu_edpt_dir(ep_addr);
+  TU_ASSERT(epnum < CFG_TUD_ENDPPOINT_MAX);
+
+  if (total_bytes <= CFG_TUD_EDPT_XFER_EX_CHUNK) {
+    return usbd_edpt_xfer(rhport, ep_addr, buffer, (uint16_t) total_bytes);
+  }
+
+  TU_LOG_USBD("  Queue EP %02X with %lu bytes ...\r\n", ep_addr, (unsigned long) total_bytes);
+
+  // Attempt to transfer on a busy endpoint, sound like an race condition !
+  TU_ASSERT(dev->ep_status[epnum][dir].busy == 0);
+  dev->ep_status[epnum][dir].busy = 1;
+  tu_capture_xfer_submit(rhport, false, 0, ep_addr, buffer, total_bytes);
+
+  // DCD without 32-bit transfer support returns false (weak default)
+  bool ret = dcd_edpt_xfer_ex(rhport, ep_addr, buffer, total_bytes);
+  if (!ret) {
+    // first chunk is submitted here, the rest are chained in ISR on completion
+    usbd_xfer_ex_t* xfer = &dev->ep_xfer_ex[epnum][dir];
+    xfer->buffer = buffer + CFG_TUD_EDPT_XFER_EX_CHUNK;
+    xfer->remaining = total_bytes - CFG_TUD_EDPT_XFER_EX_CHUNK;
+    xfer->xferred = 0;
+    xfer->chunk = CFG_TUD_EDPT_XFER_EX_CHUNK;
+    xfer->active = 1;
+
+    ret = dcd_edpt_xfer(rhport, ep_addr, buffer, CFG_TUD_EDPT_XFER_EX_CHUNK);
+    if (!ret) {
+      xfer->active = 0;
+    }
+  }
+
+  if (ret) {
+    usbd_stats_submit(ep_addr);
+  } else {
+    // DCD error, mark endpoint as ready to allow next transfer
+    dev->ep_status[epnum][dir].busy = 0;
+    dev->ep_status[epnum][dir].claimed = 0;
+    TU_LOG_USBD("FAILED\r\n");
+    TU_BREAKPOINT();
+  }
+
+  return ret;
+}
+#endif
+
+#if CFG_TUD_EDPT_XFER_QUEUE
+bool usbd_edpt_xfer_queue(uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint16_t total_bytes) {
+  rhport = USBD_RHPORT(rhport);
+  usbd_device_t* dev = get_dev(rhport);
+
+  uint8_t const epnum = tu_edpt_number(ep_addr);
+  uint8_t const dir = tu_edpt_dir(ep_addr);
+  TU_ASSERT(epnum != 0 && epnum < CFG_TUD_ENDPPOINT_MAX);
+
+  tu_edpt_state_t* ep_state = &dev->ep_status[epnum][dir];
+  usbd_xfer_queue_t* xferq = &dev->ep_xferq[epnum][dir];
+  bool ret = false;
+
+  TU_LOG_USBD("  Queue EP %02X with %u bytes (chained)\r\n", ep_addr, total_bytes);
+
+  (void) osal_mutex_lock(_usbd_mutex, OSAL_TIMEOUT_WAIT_FOREVER);
+  usbd_int_set(false);
+
+  if (!ep_state->busy && !ep_state->claimed) {
+    // endpoint is idle: start right away
+    ep_state->claimed = 1;
+    ep_state->busy = 1;
+    tu_capture_xfer_submit(rhport, false, 0, ep_addr, buffer, total_bytes);
+    ret = dcd_edpt_xfer(rhport, ep_addr, buffer, total_bytes);
+    if (!ret) {
+      ep_state->busy = 0;
+      ep_state->claimed = 0;
+    }
+  } else if (ep_state->busy && !xferq->pending) {
+    // started by ISR on completion of the active transfer (or by usbd task if it is already complete)
+    xferq->buffer = buffer;
+    xferq->total_bytes = total_bytes;
+    xferq->pending = 1;
+    ret = true;
+  }
+
+  usbd_int_set(true);
+  (void) osal_mutex_unlock(_usbd_mutex);
+
+  if (ret) {
+    usbd_stats_submit(ep_addr);
+  }
+  return ret;
+}
+
+bool usbd_edpt_xfer_queue_available(uint8_t rhport, uint8_t ep_addr) {
+  usbd_device_t* dev = get_dev(rhport);
+
+  uint8_t const epnum = tu_edpt_number(ep_addr);
+  uint8_t const dir = tu_edpt_dir(ep_addr);
+  TU_VERIFY(epnum != 0 && epnum < CFG_TUD_ENDPPOINT_MAX);
+
+  tu_edpt_state_t const* ep_state = &dev->ep_status[epnum][dir];
+  if (ep_state->busy) {
+    return !dev->ep_xferq[epnum][dir].pending;
+  } else {
+    return !ep_state->claimed;
+  }
+}
+#endif
+
 // The number of bytes has to be given explicitly to allow more flexible control of how many
 // bytes should be written and second to keep the return value free to give back a boolean
 // success message. If total_bytes is too big, the FIFO will copy only what is available
 // into the USB buffer!
 bool usbd_edpt_xfer_fifo(uint8_t rhport, uint8_t ep_addr, tu_fifo_t* ff, uint16_t total_bytes) {
-  rhport = _usbd_rhport;
+  rhport = USBD_RHPORT(rhport);
+  usbd_device_t* dev = get_dev(rhport);
 
   uint8_t const epnum = tu_edpt_number(ep_addr);
   uint8_t const dir = tu_edpt_dir(ep_addr);
@@ -1365,36 +2575,64 @@ bool usbd_edpt_xfer_fifo(uint8_t rhport, uint8_t ep_addr, tu_fifo_t* ff, uint16_
   TU_LOG_USBD("  Queue ISO EP %02X with %u bytes ... ", ep_addr, total_bytes);
 
   // Attempt to transfer on a busy endpoint, sound like an race condition !
-  TU_ASSERT(_usbd_dev.ep_status[epnum][dir].busy == 0);
+  TU_ASSERT(dev->ep_status[epnum][dir].busy == 0);
 
   // Set busy first since the actual transfer can be complete before dcd_edpt_xfer() could return
   // and usbd task can preempt and clear the busy
-  _usbd_dev.ep_status[epnum][dir].busy = 1;
+  dev->ep_status[epnum][dir].busy = 1;
+  tu_capture_xfer_submit(rhport, false, 0, ep_addr, NULL, total_bytes);
 
   if (dcd_edpt_xfer_fifo(rhport, ep_addr, ff, total_bytes)) {
+    usbd_stats_submit(ep_addr);
     TU_LOG_USBD("OK\r\n");
     return true;
   } else {
     // DCD error, mark endpoint as ready to allow next transfer
-    _usbd_dev.ep_status[epnum][dir].busy = 0;
-    _usbd_dev.ep_status[epnum][dir].claimed = 0;
+    dev->ep_status[epnum][dir].busy = 0;
+    dev->ep_status[epnum][dir].claimed = 0;
     TU_LOG_USBD("failed\r\n");
     TU_BREAKPOINT();
     return false;
   }
 }
 
+void usbd_dcd_caps_get(uint8_t rhport, dcd_caps_t* caps) {
+  rhport = USBD_RHPORT(rhport);
+  tu_memclr(caps, sizeof(dcd_caps_t));
+
+#ifdef TUP_DCD_EDPT_XFER_EX
+  caps->max_xfer_size = UINT32_MAX;
+#else
+  caps->max_xfer_size = UINT16_MAX;
+#endif
+#if CFG_TUD_MEM_DCACHE_ENABLE
+  caps->mem_align = CFG_TUD_MEM_DCACHE_LINE_SIZE;
+#else
+  caps->mem_align = 1;
+#endif
+  caps->queue_depth = 1;
+  caps->xfer_fifo = (dcd_edpt_xfer_fifo != NULL) ? 1 : 0;
+#ifdef TUP_DCD_EDPT_ISO_ALLOC
+  caps->iso_alloc = 1;
+#endif
+
+  if (dcd_caps_get != NULL) {
+    dcd_caps_get(rhport, caps);
+  }
+}
+
 bool usbd_edpt_busy(uint8_t rhport, uint8_t ep_addr) {
-  (void) rhport;
+  usbd_device_t* dev = get_dev(rhport);
 
   uint8_t const epnum = tu_edpt_number(ep_addr);
   uint8_t const dir = tu_edpt_dir(ep_addr);
 
-  return _usbd_dev.ep_status[epnum][dir].busy;
+  return dev->ep_status[epnum][dir].busy;
 }
 
 void usbd_edpt_stall(uint8_t rhport, uint8_t ep_addr) {
-  rhport = _usbd_rhport;
+  rhport = USBD_RHPORT(rhport);
+  usbd_device_t* dev = get_dev(rhport);
 
   uint8_t const epnum = tu_edpt_number(ep_addr);
   uint8_t const dir = tu_edpt_dir(ep_addr);
@@ -1402,12 +2640,14 @@ void usbd_edpt_stall(uint8_t rhport, uint8_t ep_addr) {
   // only stalled if currently cleared
   TU_LOG_USBD("    Stall EP %02X\r\n", ep_addr);
   dcd_edpt_stall(rhport, ep_addr);
-  _usbd_dev.ep_status[epnum][dir].stalled = 1;
-  _usbd_dev.ep_status[epnum][dir].busy = 1;
+  dev->ep_status[epnum][dir].stalled = 1;
+  dev->ep_status[epnum][dir].busy = 1;
+  usbd_stats_stall(ep_addr);
 }
 
 void usbd_edpt_clear_stall(uint8_t rhport, uint8_t ep_addr) {
-  rhport = _usbd_rhport;
+  rhport = USBD_RHPORT(rhport);
+  usbd_device_t* dev = get_dev(rhport);
 
   uint8_t const epnum = tu_edpt_number(ep_addr);
   uint8_t const dir = tu_edpt_dir(ep_addr);
@@ -1415,17 +2655,25 @@ void usbd_edpt_clear_stall(uint8_t rhport, uint8_t ep_addr) {
   // only clear if currently stalled
   TU_LOG_USBD("    Clear Stall EP %02X\r\n", ep_addr);
   dcd_edpt_clear_stall(rhport, ep_addr);
-  _usbd_dev.ep_status[epnum][dir].stalled = 0;
-  _usbd_dev.ep_status[epnum][dir].busy = 0;
+  dev->ep_status[epnum][dir].stalled = 0;
+  dev->ep_status[epnum][dir].busy = 0;
 }
 
 bool usbd_edpt_stalled(uint8_t rhport, uint8_t ep_addr) {
-  (void) rhport;
+  usbd_device_t* dev = get_dev(rhport);
 
   uint8_t const epnum = tu_edpt_number(ep_addr);
   uint8_t const dir = tu_edpt_dir(ep_addr);
 
-  return _usbd_dev.ep_status[epnum][dir].stalled;
+  return dev->ep_status[epnum][dir].stalled;
+}
+
+uint16_t usbd_edpt_iso_frame(uint8_t rhport, uint8_t ep_addr) {
+  usbd_device_t* dev = get_dev(rhport);
+
+  uint8_t const epnum = tu_edpt_number(ep_addr);
+  TU_VERIFY(epnum < CFG_TUD_ENDPPOINT_MAX, UINT16_MAX);
+  return dev->ep_frame[epnum][tu_edpt_dir(ep_addr)];
 }
 
 /**
@@ -1437,7 +2685,8 @@ void usbd_edpt_close(uint8_t rhport, uint8_t ep_addr) {
   (void) rhport; (void) ep_addr;
   // ISO alloc/activate Should be used instead
 #else
-  rhport = _usbd_rhport;
+  rhport = USBD_RHPORT(rhport);
+  usbd_device_t* dev = get_dev(rhport);
 
   TU_LOG_USBD("  CLOSING Endpoint: 0x%02X\r\n", ep_addr);
 
@@ -1445,34 +2694,100 @@ void usbd_edpt_close(uint8_t rhport, uint8_t ep_addr) {
   uint8_t const dir = tu_edpt_dir(ep_addr);
 
   dcd_edpt_close(rhport, ep_addr);
-  _usbd_dev.ep_status[epnum][dir].stalled = 0;
-  _usbd_dev.ep_status[epnum][dir].busy = 0;
-  _usbd_dev.ep_status[epnum][dir].claimed = 0;
+  dev->ep_status[epnum][dir].stalled = 0;
+  dev->ep_status[epnum][dir].busy = 0;
+  dev->ep_status[epnum][dir].claimed = 0;
+  #if CFG_TUD_EDPT_CONTEXT
+  dev->ep_ctx[epnum][dir] = NULL;
+  #endif
+  #if CFG_TUD_EDPT_XFER_QUEUE
+  tu_varclr(&dev->ep_xferq[epnum][dir]);
+  #endif
+  #if CFG_TUD_EDPT_XFER_EX
+  tu_varclr(&dev->ep_xfer_ex[epnum][dir]);
+  #endif
 #endif
 
   return;
 }
 
+void usbd_edpt_set_context(uint8_t rhport, uint8_t ep_addr, void* ctx) {
+#if CFG_TUD_EDPT_CONTEXT
+  usbd_device_t* dev = get_dev(rhport);
+  uint8_t const epnum = tu_edpt_number(ep_addr);
+  TU_ASSERT(epnum < CFG_TUD_ENDPPOINT_MAX,);
+  dev->ep_ctx[epnum][tu_edpt_dir(ep_addr)] = ctx;
+#else
+  (void) rhport; (void) ep_addr; (void) ctx;
+#endif
+}
+
+TU_ATTR_FAST_FUNC void* usbd_edpt_get_context(uint8_t rhport, uint8_t ep_addr) {
+#if CFG_TUD_EDPT_CONTEXT
+  usbd_device_t const* dev = get_dev(rhport);
+  uint8_t const epnum = tu_edpt_number(ep_addr);
+  return (epnum < CFG_TUD_ENDPPOINT_MAX) ? dev->ep_ctx[epnum][tu_edpt_dir(ep_addr)] : NULL;
+#else
+  (void) rhport; (void) ep_addr;
+  return NULL;
+#endif
+}
+
+void usbd_itf_set_context(uint8_t rhport, uint8_t itf_num, void* ctx) {
+#if CFG_TUD_ITF_CONTEXT
+  TU_ASSERT(itf_num < CFG_TUD_INTERFACE_MAX,);
+  get_dev(rhport)->itf_ctx[itf_num] = ctx;
+#else
+  (void) rhport; (void) itf_num; (void) ctx;
+#endif
+}
+
+void* usbd_itf_get_context(uint8_t rhport, uint8_t itf_num) {
+#if CFG_TUD_ITF_CONTEXT
+  usbd_device_t const* dev = get_dev(rhport);
+  return (itf_num < CFG_TUD_INTERFACE_MAX) ? dev->itf_ctx[itf_num] : NULL;
+#else
+  (void) rhport; (void) itf_num;
+  return NULL;
+#endif
+}
+
 void usbd_sof_enable(uint8_t rhport, sof_consumer_t consumer, bool en) {
-  rhport = _usbd_rhport;
+  rhport = USBD_RHPORT(rhport);
+  usbd_device_t* dev = get_dev(rhport);
 
-  uint8_t consumer_old = _usbd_dev.sof_consumer;
+  uint8_t consumer_old = dev->sof_consumer;
   // Keep track how many class instances need the SOF interrupt
   if (en) {
-    _usbd_dev.sof_consumer |= (uint8_t)(1 << consumer);
+    dev->sof_consumer |= (uint8_t)(1 << consumer);
   } else {
-    _usbd_dev.sof_consumer &= (uint8_t)(~(1 << consumer));
+    dev->sof_consumer &= (uint8_t)(~(1 << consumer));
   }
 
   // Test logically unequal
-  if(!_usbd_dev.sof_consumer != !consumer_old) {
-    dcd_sof_enable(rhport, _usbd_dev.sof_consumer);
+  if(!dev->sof_consumer != !consumer_old) {
+    dcd_sof_enable(rhport, dev->sof_consumer);
   }
 }
 
+#if CFG_TUD_EPBUF_POOL_SIZE
+void* usbd_epbuf_alloc(uint8_t rhport, uint32_t size) {
+  TU_VERIFY(size > 0, NULL);
+  usbd_device_t* dev = get_dev(rhport);
+  // padded to cache line so that maintenance of a buffer does not touch its neighbors
+  const uint32_t alloc_size = tu_round_up(TUD_EPBUF_DCACHE_SIZE(size), CFG_TUD_EPBUF_POOL_ALIGN);
+  TU_ASSERT(alloc_size <= CFG_TUD_EPBUF_POOL_SIZE - dev->epbuf_used, NULL); // increase CFG_TUD_EPBUF_POOL_SIZE
+
+  uint8_t* buf = _usbd_epbuf_pool[usbd_port_idx(rhport)] + dev->epbuf_used;
+  dev->epbuf_used += alloc_size;
+  return buf;
+}
+#endif
+
 bool usbd_edpt_iso_alloc(uint8_t rhport, uint8_t ep_addr, uint16_t largest_packet_size) {
 #ifdef TUP_DCD_EDPT_ISO_ALLOC
-  rhport = _usbd_rhport;
+  rhport = USBD_RHPORT(rhport);
+  usbd_device_t* dev = get_dev(rhport);
 
   TU_ASSERT(tu_edpt_number(ep_addr) < CFG_TUD_ENDPPOINT_MAX);
   return dcd_edpt_iso_alloc(rhport, ep_addr, largest_packet_size);
@@ -1484,17 +2799,19 @@ bool usbd_edpt_iso_alloc(uint8_t rhport, uint8_t ep_addr, uint16_t largest_packe
 
 bool usbd_edpt_iso_activate(uint8_t rhport, tusb_desc_endpoint_t const* desc_ep) {
 #ifdef TUP_DCD_EDPT_ISO_ALLOC
-  rhport = _usbd_rhport;
+  rhport = USBD_RHPORT(rhport);
+  usbd_device_t* dev = get_dev(rhport);
 
   uint8_t const epnum = tu_edpt_number(desc_ep->bEndpointAddress);
   uint8_t const dir = tu_edpt_dir(desc_ep->bEndpointAddress);
 
   TU_ASSERT(epnum < CFG_TUD_ENDPPOINT_MAX);
-  TU_ASSERT(tu_edpt_validate(desc_ep, (tusb_speed_t) _usbd_dev.speed));
+  TU_ASSERT(tu_edpt_validate(desc_ep, (tusb_speed_t) dev->speed));
 
-  _usbd_dev.ep_status[epnum][dir].stalled = 0;
-  _usbd_dev.ep_status[epnum][dir].busy = 0;
-  _usbd_dev.ep_status[epnum][dir].claimed = 0;
+  dev->ep_status[epnum][dir].stalled = 0;
+  dev->ep_status[epnum][dir].busy = 0;
+  dev->ep_status[epnum][dir].claimed = 0;
+  tu_capture_edpt_open(rhport, false, 0, desc_ep->bEndpointAddress, desc_ep->bmAttributes.xfer);
   return dcd_edpt_iso_activate(rhport, desc_ep);
 #else
   (void) rhport; (void) desc_ep;
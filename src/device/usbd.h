@@ -55,9 +55,12 @@ TU_ATTR_ALWAYS_INLINE static inline bool tud_init (uint8_t rhport) {
 // Deinit device stack on roothub port
 bool tud_deinit(uint8_t rhport);
 
-// Check if device stack is already initialized
+// Check if device stack is already initialized (on any port)
 bool tud_inited(void);
 
+// Check if device stack is initialized on roothub port
+bool tud_rhport_inited(uint8_t rhport);
+
 // Task function should be called in main/rtos loop, extended version of tud_task()
 // - timeout_ms: millisecond to wait, zero = no wait, 0xFFFFFFFF = wait forever
 // - in_isr: if function is called in ISR
@@ -72,6 +75,59 @@ void tud_task (void) {
 // Check if there is pending events need processing by tud_task()
 bool tud_task_event_ready(void);
 
+// Event queue lane, in priority order when CFG_TUD_TASK_QUEUE_PRIORITY is enabled
+typedef enum {
+  TUD_TASK_QUEUE_CTRL = 0, // bus events, SETUP and control endpoint transfer
+  TUD_TASK_QUEUE_DATA,     // transfer complete of non-control endpoints
+  TUD_TASK_QUEUE_LOW,      // SOF and deferred function call
+  TUD_TASK_QUEUE_COUNT
+} tud_task_queue_t;
+
+// Number of events dropped since queue (lane) was full
+uint32_t tud_task_queue_overflow_count(tud_task_queue_t lane);
+
+#if CFG_TUD_STATS
+typedef struct {
+  uint32_t xfer_submitted;
+  uint32_t xfer_completed;
+  uint32_t xfer_failed;  // completed with error (or stalled) result
+  uint32_t bytes;
+  uint32_t stalls;
+  uint32_t latency_max;  // timestamp ticks from transfer complete (dcd event) to class xfer callback
+  uint32_t latency_sum;  // average is latency_sum / xfer_completed
+} tud_stats_edpt_t;
+
+typedef struct {
+  char const* name;      // driver name, NULL if not built with CFG_TUSB_DEBUG
+  uint32_t calls;        // xfer_cb/xfer_isr invocations
+  uint32_t time_max;     // timestamp ticks spent in a single callback
+  uint32_t time_sum;
+} tud_stats_driver_t;
+
+// Timestamps of enumeration stages, 0 if not reached yet. Stages after bus_reset are cleared by each bus reset
+typedef struct {
+  uint32_t init;         // device controller is initialized and connected by tud_init()
+  uint32_t bus_reset;    // bus reset is processed by usbd task
+  uint32_t desc_device;  // first GET_DESCRIPTOR(Device)
+  uint32_t addressed;    // SET_ADDRESS
+  uint32_t desc_config;  // first GET_DESCRIPTOR(Configuration)
+  uint32_t configured;   // SET_CONFIGURATION with all class drivers opened
+} tud_stats_enum_t;
+
+typedef struct {
+  uint16_t queue_peak;   // high water mark of pending events in usbd queue
+  tud_stats_enum_t enumeration;
+  tud_stats_edpt_t ep[CFG_TUD_ENDPPOINT_MAX][2];
+  tud_stats_driver_t driver[CFG_TUD_STATS_DRIVER_MAX]; // indexed by driver id
+} tud_stats_t;
+
+// Get a copy of statistics
+void tud_stats_get(tud_stats_t* stats);
+
+// Clear all statistics
+void tud_stats_clear(void);
+#endif
+
 #ifndef TUSB_DCD_H_
 extern void dcd_int_handler(uint8_t rhport);
 #endif
@@ -79,6 +135,22 @@ extern void dcd_int_handler(uint8_t rhport);
 // Interrupt handler, name alias to DCD
 #define tud_int_handler   dcd_int_handler
 
+// Per-port status, for multiple device ports (CFG_TUD_RHPORT_NUM > 1). API without rhport argument below
+// applies to the first initialized port.
+tusb_speed_t tud_rhport_speed_get(uint8_t rhport);
+bool tud_rhport_connected(uint8_t rhport);
+bool tud_rhport_mounted(uint8_t rhport);
+bool tud_rhport_suspended(uint8_t rhport);
+bool tud_rhport_remote_wakeup(uint8_t rhport);
+
+TU_ATTR_ALWAYS_INLINE static inline
+bool tud_rhport_ready(uint8_t rhport) {
+  return tud_rhport_mounted(rhport) && !tud_rhport_suspended(rhport);
+}
+
+// Port of the event being processed by tud_task(), to tell ports apart in callbacks such as tud_mount_cb()
+uint8_t tud_event_rhport(void);
+
 // Get current bus speed
 tusb_speed_t tud_speed_get(void);
 
@@ -98,9 +170,17 @@ bool tud_ready(void) {
   return tud_mounted() && !tud_suspended();
 }
 
-// Remote wake up host, only if suspended and enabled by host
+// Remote wake up host, only if suspended and enabled by host.
+// In LPM L1 sleep, remote wakeup is enabled by bRemoteWake of host's LPM token instead of SET_FEATURE
 bool tud_remote_wakeup(void);
 
+// Check if device is in LPM L1 sleep, also reported as suspended by tud_suspended()
+bool tud_lpm_sleeping(void);
+
+// Enable/Disable LPM (requires CFG_TUD_LPM). Host BESL (0-15) at least besl_deep allows controller to enter deep
+// L1 sleep, besl_deep > 15 only uses shallow sleep. Return false if not supported by controller
+bool tud_lpm_config(bool enable, uint8_t besl_deep);
+
 // Enable pull-up resistor on D+ D-
 // Return false on unsupported MCUs
 bool tud_disconnect(void);
@@ -112,11 +192,30 @@ bool tud_connect(void);
 // Enable or disable the Start Of Frame callback support
 void tud_sof_cb_enable(bool en);
 
+// Only report every n-th SOF to tud_sof_isr_cb()/tud_sof_cb(), 0 or 1 means every (micro) frame
+void tud_sof_cb_set_divider(uint16_t divider);
+
 // Carry out Data and Status stage of control transfer
 // - If len = 0, it is equivalent to sending status only
 // - If len > wLength : it will be truncated
 bool tud_control_xfer(uint8_t rhport, tusb_control_request_t const * request, void* buffer, uint16_t len);
 
+// Same as tud_control_xfer() but buffer is used by DCD directly without copying through the control endpoint
+// buffer. Buffer must meet DCD's requirement (CFG_TUD_MEM_SECTION, CFG_TUD_MEM_ALIGN) and stay valid until
+// the data stage completes. With CFG_TUD_CONTROL_MULTI_PACKET, the data stage is carried out as one transfer.
+bool tud_control_xfer_direct(uint8_t rhport, tusb_control_request_t const * request, void* buffer, uint16_t len);
+
+// Control data stage callback of tud_control_xfer_stream(), carried out per control endpoint packet.
+// - IN : fill buffer with up to len bytes starting at offset, return number of bytes (less than len ends data stage)
+// - OUT: consume len received bytes at offset, return len to accept or less to stall the request
+typedef uint16_t (*tud_control_stream_cb_t)(uint8_t rhport, tusb_control_request_t const * request, uint16_t offset,
+                                            uint8_t* buffer, uint16_t len);
+
+// Carry out data stage of control transfer of len bytes (truncated to wLength) by pulling/pushing data chunk by
+// chunk with stream_cb, allow serving payload larger than RAM e.g from external flash
+bool tud_control_xfer_stream(uint8_t rhport, tusb_control_request_t const * request, uint16_t len,
+                             tud_control_stream_cb_t stream_cb);
+
 // Send STATUS (zero length) packet
 bool tud_control_status(uint8_t rhport, tusb_control_request_t const * request);
 
@@ -161,6 +260,10 @@ void tud_umount_cb(void);
 // Within 7ms, device must draw an average of current less than 2.5 mA from bus
 void tud_suspend_cb(bool remote_wakeup_en);
 
+// Invoked when host put device into LPM L1 sleep. Device must be able to resume within BESL (besl is 4-bit index,
+// 0 = 125 us ... 15 = 10 ms) but has no current limit as in L2 suspend. tud_resume_cb() is invoked on L1 exit
+void tud_lpm_sleep_cb(uint8_t besl, bool remote_wakeup_en);
+
 // Invoked when usb bus is resumed
 void tud_resume_cb(void);
 
@@ -170,6 +273,13 @@ void tud_event_hook_cb(uint8_t rhport, uint32_t eventid, bool in_isr);
 // Invoked when a new (micro) frame started
 void tud_sof_cb(uint32_t frame_count);
 
+// Invoked in ISR when a new (micro) frame started (subject to divider). Return true to also defer to tud_sof_cb()
+// in usbd task, false if it is fully handled here (no task wake-up)
+bool tud_sof_isr_cb(uint32_t frame_count);
+
+// Invoked to get timestamp (in any unit e.g cpu cycle) for CFG_TUD_STATS latency, may be called in ISR
+uint32_t tud_stats_timestamp_cb(void);
+
 // Invoked when received control request with VENDOR TYPE
 bool tud_vendor_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t const * request);
 
@@ -187,6 +297,17 @@ bool tud_vendor_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_requ
 #define TUD_BOS_PLATFORM_DESCRIPTOR(...) \
   4+TU_ARGS_NUM(__VA_ARGS__), TUSB_DESC_DEVICE_CAPABILITY, DEVICE_CAPABILITY_PLATFORM, 0x00, __VA_ARGS__
 
+//------------- USB 2.0 Extension -------------//
+
+// Total Length of USB 2.0 Extension Capability
+#define TUD_BOS_USB20_EXT_DESC_LEN      7
+
+// USB 2.0 Extension Capability with LPM and BESL support. Baseline/deep BESL (0-15) are the minimum host BESL device
+// prefers for shallow and deep L1 sleep, should match besl_deep of tud_lpm_config()
+#define TUD_BOS_USB20_EXT_LPM_DESCRIPTOR(_baseline_besl, _deep_besl) \
+  TUD_BOS_USB20_EXT_DESC_LEN, TUSB_DESC_DEVICE_CAPABILITY, DEVICE_CAPABILITY_USB20_EXTENSION, \
+  U32_TO_U8S_LE(0x1Eu | (((_baseline_besl) & 0x0Fu) << 8) | (((_deep_besl) & 0x0Fu) << 12))
+
 //------------- WebUSB BOS Platform -------------//
 
 // Descriptor Length
@@ -217,6 +338,14 @@ bool tud_vendor_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_requ
 
 #define TUD_CONFIG_DESC_LEN   (9)
 
+// Size in bytes of a descriptor template expansion, usable in constant expression
+#define TUD_DESC_TEMPLATE_LEN(...)   sizeof((uint8_t const[]) { __VA_ARGS__ })
+
+// Compile-time check that a descriptor array matches its declared (total) length,
+// e.g TUD_DESC_VERIFY_LEN(desc_fs_configuration, CONFIG_TOTAL_LEN) right after the array definition
+#define TUD_DESC_VERIFY_LEN(_desc, _len) \
+  TU_VERIFY_STATIC(sizeof(_desc) == (_len), "descriptor size does not match its declared length")
+
 // Config number, interface count, string index, total length, attribute, power in mA
 #define TUD_CONFIG_DESCRIPTOR(config_num, _itfcount, _stridx, _total_len, _attribute, _power_ma) \
   9, TUSB_DESC_CONFIGURATION, U16_TO_U8S_LE(_total_len), _itfcount, config_num, _stridx, TU_BIT(7) | _attribute, (_power_ma)/2
@@ -252,6 +381,31 @@ bool tud_vendor_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_requ
   /* Endpoint In */\
   7, TUSB_DESC_ENDPOINT, _epin, TUSB_XFER_BULK, U16_TO_U8S_LE(_epsize), 0
 
+//--------------------------------------------------------------------+
+// UAS Descriptor Templates
+//--------------------------------------------------------------------+
+
+// Length of template descriptor: 53 bytes
+#define TUD_UAS_DESC_LEN    (9 + 4*(7+4))
+
+// Interface number, string index, EP Command Out, EP Status In, EP Data In, EP Data Out & EP size
+// Each endpoint is followed by its Pipe Usage descriptor
+#define TUD_UAS_DESCRIPTOR(_itfnum, _stridx, _epcmd, _epstatus, _epdin, _epdout, _epsize) \
+  /* Interface */\
+  9, TUSB_DESC_INTERFACE, _itfnum, 0, 4, TUSB_CLASS_MSC, MSC_SUBCLASS_SCSI, MSC_PROTOCOL_UAS, _stridx,\
+  /* Endpoint Command Out */\
+  7, TUSB_DESC_ENDPOINT, _epcmd, TUSB_XFER_BULK, U16_TO_U8S_LE(_epsize), 0,\
+  4, UAS_DESC_PIPE_USAGE, UAS_PIPE_COMMAND, 0,\
+  /* Endpoint Status In */\
+  7, TUSB_DESC_ENDPOINT, _epstatus, TUSB_XFER_BULK, U16_TO_U8S_LE(_epsize), 0,\
+  4, UAS_DESC_PIPE_USAGE, UAS_PIPE_STATUS, 0,\
+  /* Endpoint Data In */\
+  7, TUSB_DESC_ENDPOINT, _epdin, TUSB_XFER_BULK, U16_TO_U8S_LE(_epsize), 0,\
+  4, UAS_DESC_PIPE_USAGE, UAS_PIPE_DATA_IN, 0,\
+  /* Endpoint Data Out */\
+  7, TUSB_DESC_ENDPOINT, _epdout, TUSB_XFER_BULK, U16_TO_U8S_LE(_epsize), 0,\
+  4, UAS_DESC_PIPE_USAGE, UAS_PIPE_DATA_OUT, 0
+
 //--------------------------------------------------------------------+
 // MSC Descriptor Templates
 //--------------------------------------------------------------------+
@@ -363,6 +517,42 @@ bool tud_vendor_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_requ
   TUD_MIDI_DESC_EP(_epin, _epsize, 1),\
   TUD_MIDI_JACKID_OUT_EMB(1)
 
+//------------- MIDI 2.0 -------------//
+
+// MIDI 2.0 alternate setting (1) of MIDI Streaming interface, endpoints are associated with Group Terminal Block 1
+#define TUD_MIDI2_DESC_ALT_LEN (9 + 7 + 2 * (7 + 5))
+#define TUD_MIDI2_DESC_ALT(_itfnum, _epout, _epin, _epsize) \
+  /* MIDI Streaming (MS) Interface Alt 1 */\
+  9, TUSB_DESC_INTERFACE, (uint8_t)((_itfnum) + 1), 1, 2, TUSB_CLASS_AUDIO, AUDIO_SUBCLASS_MIDI_STREAMING, AUDIO_FUNC_PROTOCOL_CODE_UNDEF, 0,\
+  /* MS Header v2.0 */\
+  7, TUSB_DESC_CS_INTERFACE, MIDI_CS_INTERFACE_HEADER, U16_TO_U8S_LE(0x0200), U16_TO_U8S_LE(7),\
+  /* Endpoint Out */\
+  7, TUSB_DESC_ENDPOINT, _epout, TUSB_XFER_BULK, U16_TO_U8S_LE(_epsize), 0,\
+  /* MS Endpoint v2.0 */\
+  5, TUSB_DESC_CS_ENDPOINT, MIDI_CS_ENDPOINT_GENERAL_2_0, 1, 1,\
+  /* Endpoint In */\
+  7, TUSB_DESC_ENDPOINT, _epin, TUSB_XFER_BULK, U16_TO_U8S_LE(_epsize), 0,\
+  /* MS Endpoint v2.0 */\
+  5, TUSB_DESC_CS_ENDPOINT, MIDI_CS_ENDPOINT_GENERAL_2_0, 1, 1
+
+// Length of template descriptor (132 bytes)
+#define TUD_MIDI2_DESC_LEN (TUD_MIDI_DESC_LEN + TUD_MIDI2_DESC_ALT_LEN)
+
+// MIDI 2.0 descriptor: MIDI 1.0 simple descriptor as alternate setting 0 and UMP as alternate setting 1.
+// Group Terminal Block descriptors are returned by tud_midi_descriptor_gtb_cb()
+#define TUD_MIDI2_DESCRIPTOR(_itfnum, _stridx, _epout, _epin, _epsize) \
+  TUD_MIDI_DESCRIPTOR(_itfnum, _stridx, _epout, _epin, _epsize),\
+  TUD_MIDI2_DESC_ALT(_itfnum, _epout, _epin, _epsize)
+
+// Group Terminal Block descriptors, header followed by _numblocks blocks
+#define TUD_MIDI2_GTB_HEADER_LEN 5
+#define TUD_MIDI2_GTB_LEN 13
+#define TUD_MIDI2_GTB_HEADER(_numblocks) \
+  TUD_MIDI2_GTB_HEADER_LEN, MIDI_CS_GR_TRM_BLOCK, MIDI_GR_TRM_BLOCK_HEADER, U16_TO_U8S_LE(TUD_MIDI2_GTB_HEADER_LEN + (_numblocks) * TUD_MIDI2_GTB_LEN)
+
+#define TUD_MIDI2_GTB(_id, _type, _group_first, _group_count, _stridx, _protocol) \
+  TUD_MIDI2_GTB_LEN, MIDI_CS_GR_TRM_BLOCK, MIDI_GR_TRM_BLOCK, _id, _type, _group_first, _group_count, _stridx, _protocol, U16_TO_U8S_LE(0), U16_TO_U8S_LE(0)
+
 //--------------------------------------------------------------------+
 // Audio v2.0 Descriptor Templates
 //--------------------------------------------------------------------+
@@ -682,6 +872,17 @@ bool tud_vendor_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_requ
   /* Function */ \
   9, DFU_DESC_FUNCTIONAL, _attr, U16_TO_U8S_LE(_timeout), U16_TO_U8S_LE(_xfer_size), U16_TO_U8S_LE(0x0101)
 
+// Length of an alternate setting with its own functional descriptor
+#define TUD_DFU_ALT_FUNC_DESC_LEN    (9 + 9)
+
+// Interface number, alternate setting, string index, attributes, detach timeout, transfer size
+// Alternate setting followed by its own functional descriptor, allowing a transfer size per alternate (e.g matching
+// flash sector size of each partition). Use one per alternate setting, in increasing order
+#define TUD_DFU_ALT_FUNC_DESCRIPTOR(_itfnum, _alt, _stridx, _attr, _timeout, _xfer_size) \
+  _TUD_DFU_ALT(_itfnum, _alt, _stridx), \
+  /* Function */ \
+  9, DFU_DESC_FUNCTIONAL, _attr, U16_TO_U8S_LE(_timeout), U16_TO_U8S_LE(_xfer_size), U16_TO_U8S_LE(0x0101)
+
 #define _TUD_DFU_ALT(_itfnum, _alt, _stridx) \
   /* Interface */ \
   9, TUSB_DESC_INTERFACE, _itfnum, _alt, 0, TUD_DFU_APP_CLASS, TUD_DFU_APP_SUBCLASS, DFU_PROTOCOL_DFU, _stridx
@@ -54,14 +54,17 @@ typedef struct {
   uint8_t* buffer;
   uint16_t data_len;
   uint16_t total_xferred;
+  uint16_t xact_len;      // length of current data stage transaction
+  bool direct;            // buffer is used by DCD directly, no copy to control endpoint buffer
+  tud_control_stream_cb_t stream_cb; // data is pulled/pushed per transaction, buffer is not used
   usbd_control_xfer_cb_t complete_cb;
 } usbd_control_xfer_t;
 
-static usbd_control_xfer_t _ctrl_xfer;
+static usbd_control_xfer_t _ctrl_xfer[CFG_TUD_RHPORT_NUM];
 
 CFG_TUD_MEM_SECTION static struct {
   TUD_EPBUF_DEF(buf, CFG_TUD_ENDPOINT0_SIZE);
-} _ctrl_epbuf;
+} _ctrl_epbuf[CFG_TUD_RHPORT_NUM];
 
 //--------------------------------------------------------------------+
 // Application API
@@ -76,10 +79,13 @@ static inline bool status_stage_xact(uint8_t rhport, const tusb_control_request_
 
 // Status phase
 bool tud_control_status(uint8_t rhport, const tusb_control_request_t* request) {
-  _ctrl_xfer.request = (*request);
-  _ctrl_xfer.buffer = NULL;
-  _ctrl_xfer.total_xferred = 0;
-  _ctrl_xfer.data_len = 0;
+  usbd_control_xfer_t* ctrl = &_ctrl_xfer[usbd_port_idx(rhport)];
+  ctrl->request = (*request);
+  ctrl->buffer = NULL;
+  ctrl->total_xferred = 0;
+  ctrl->data_len = 0;
+  ctrl->direct = false;
+  ctrl->stream_cb = NULL;
 
   return status_stage_xact(rhport, request);
 }
@@ -88,30 +94,46 @@ bool tud_control_status(uint8_t rhport, const tusb_control_request_t* request) {
 // Each transaction has up to Endpoint0's max packet size.
 // This function can also transfer an zero-length packet
 static bool data_stage_xact(uint8_t rhport) {
-  const uint16_t xact_len = tu_min16(_ctrl_xfer.data_len - _ctrl_xfer.total_xferred, CFG_TUD_ENDPOINT0_SIZE);
-  uint8_t ep_addr = EDPT_CTRL_OUT;
-
-  if (_ctrl_xfer.request.bmRequestType_bit.direction == TUSB_DIR_IN) {
-    ep_addr = EDPT_CTRL_IN;
-    if (xact_len) {
-      TU_VERIFY(0 == tu_memcpy_s(_ctrl_epbuf.buf, CFG_TUD_ENDPOINT0_SIZE, _ctrl_xfer.buffer, xact_len));
+  usbd_control_xfer_t* ctrl = &_ctrl_xfer[usbd_port_idx(rhport)];
+  uint8_t* epbuf = _ctrl_epbuf[usbd_port_idx(rhport)].buf;
+  const uint16_t remaining = (uint16_t) (ctrl->data_len - ctrl->total_xferred);
+  uint16_t xact_len = tu_min16(remaining, CFG_TUD_ENDPOINT0_SIZE);
+  const uint8_t ep_addr = (ctrl->request.bmRequestType_bit.direction == TUSB_DIR_IN) ? EDPT_CTRL_IN : EDPT_CTRL_OUT;
+  uint8_t* xact_buf = epbuf;
+
+  if (ctrl->direct) {
+    // transfer straight from/to application buffer
+    xact_buf = ctrl->buffer;
+    #if CFG_TUD_CONTROL_MULTI_PACKET
+    xact_len = remaining;
+    #endif
+  } else if (ep_addr == EDPT_CTRL_IN && xact_len) {
+    if (ctrl->stream_cb) {
+      // pull next chunk from application, a short chunk ends the data stage
+      xact_len = tu_min16(xact_len, ctrl->stream_cb(rhport, &ctrl->request, ctrl->total_xferred,
+                                                         epbuf, xact_len));
+    } else {
+      TU_VERIFY(0 == tu_memcpy_s(epbuf, CFG_TUD_ENDPOINT0_SIZE, ctrl->buffer, xact_len));
     }
   }
 
-  return usbd_edpt_xfer(rhport, ep_addr, xact_len ? _ctrl_epbuf.buf : NULL, xact_len);
+  ctrl->xact_len = xact_len;
+  return usbd_edpt_xfer(rhport, ep_addr, xact_len ? xact_buf : NULL, xact_len);
 }
 
-// Transmit data to/from the control endpoint.
-// If the request's wLength is zero, a status packet is sent instead.
-bool tud_control_xfer(uint8_t rhport, const tusb_control_request_t* request, void* buffer, uint16_t len) {
-  _ctrl_xfer.request = (*request);
-  _ctrl_xfer.buffer = (uint8_t*) buffer;
-  _ctrl_xfer.total_xferred = 0U;
-  _ctrl_xfer.data_len = tu_min16(len, request->wLength);
+static bool control_xfer(uint8_t rhport, const tusb_control_request_t* request, void* buffer, uint16_t len,
+                         bool direct, tud_control_stream_cb_t stream_cb) {
+  usbd_control_xfer_t* ctrl = &_ctrl_xfer[usbd_port_idx(rhport)];
+  ctrl->request = (*request);
+  ctrl->buffer = (uint8_t*) buffer;
+  ctrl->total_xferred = 0U;
+  ctrl->data_len = tu_min16(len, request->wLength);
+  ctrl->direct = direct;
+  ctrl->stream_cb = stream_cb;
 
   if (request->wLength > 0U) {
-    if (_ctrl_xfer.data_len > 0U) {
-      TU_ASSERT(buffer);
+    if (ctrl->data_len > 0U) {
+      TU_ASSERT(buffer || stream_cb);
     }
     TU_ASSERT(data_stage_xact(rhport));
   } else {
@@ -121,80 +143,117 @@ bool tud_control_xfer(uint8_t rhport, const tusb_control_request_t* request, voi
   return true;
 }
 
+// Transmit data to/from the control endpoint.
+// If the request's wLength is zero, a status packet is sent instead.
+bool tud_control_xfer(uint8_t rhport, const tusb_control_request_t* request, void* buffer, uint16_t len) {
+  return control_xfer(rhport, request, buffer, len, false, NULL);
+}
+
+bool tud_control_xfer_direct(uint8_t rhport, const tusb_control_request_t* request, void* buffer, uint16_t len) {
+  return control_xfer(rhport, request, buffer, len, true, NULL);
+}
+
+bool tud_control_xfer_stream(uint8_t rhport, const tusb_control_request_t* request, uint16_t len,
+                             tud_control_stream_cb_t stream_cb) {
+  TU_ASSERT(stream_cb);
+  return control_xfer(rhport, request, NULL, len, false, stream_cb);
+}
+
 //--------------------------------------------------------------------+
 // USBD API
 //--------------------------------------------------------------------+
-void usbd_control_reset(void);
-void usbd_control_set_request(const tusb_control_request_t* request);
-void usbd_control_set_complete_callback(usbd_control_xfer_cb_t fp);
+void usbd_control_reset(uint8_t rhport);
+void usbd_control_set_request(uint8_t rhport, const tusb_control_request_t* request);
+void usbd_control_set_complete_callback(uint8_t rhport, usbd_control_xfer_cb_t fp);
 bool usbd_control_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes);
 
-void usbd_control_reset(void) {
-  tu_varclr(&_ctrl_xfer);
+void usbd_control_reset(uint8_t rhport) {
+  tu_varclr(&_ctrl_xfer[usbd_port_idx(rhport)]);
 }
 
 // Set complete callback
-void usbd_control_set_complete_callback(usbd_control_xfer_cb_t fp) {
-  _ctrl_xfer.complete_cb = fp;
+void usbd_control_set_complete_callback(uint8_t rhport, usbd_control_xfer_cb_t fp) {
+  _ctrl_xfer[usbd_port_idx(rhport)].complete_cb = fp;
 }
 
 // for dcd_set_address where DCD is responsible for status response
-void usbd_control_set_request(const tusb_control_request_t* request) {
-  _ctrl_xfer.request = (*request);
-  _ctrl_xfer.buffer = NULL;
-  _ctrl_xfer.total_xferred = 0;
-  _ctrl_xfer.data_len = 0;
+void usbd_control_set_request(uint8_t rhport, const tusb_control_request_t* request) {
+  usbd_control_xfer_t* ctrl = &_ctrl_xfer[usbd_port_idx(rhport)];
+  ctrl->request = (*request);
+  ctrl->buffer = NULL;
+  ctrl->total_xferred = 0;
+  ctrl->data_len = 0;
+  ctrl->direct = false;
+  ctrl->stream_cb = NULL;
 }
 
 // callback when a transaction complete on
 // - DATA stage of control endpoint or
 // - Status stage
 bool usbd_control_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes) {
+  usbd_control_xfer_t* ctrl = &_ctrl_xfer[usbd_port_idx(rhport)];
+  uint8_t* epbuf = _ctrl_epbuf[usbd_port_idx(rhport)].buf;
   (void) result;
 
   // Endpoint Address is opposite to direction bit, this is Status Stage complete event
-  if (tu_edpt_dir(ep_addr) != _ctrl_xfer.request.bmRequestType_bit.direction) {
+  if (tu_edpt_dir(ep_addr) != ctrl->request.bmRequestType_bit.direction) {
     TU_ASSERT(0 == xferred_bytes);
 
     // invoke optional dcd hook if available
-    dcd_edpt0_status_complete(rhport, &_ctrl_xfer.request);
+    dcd_edpt0_status_complete(rhport, &ctrl->request);
 
-    if (_ctrl_xfer.complete_cb) {
+    if (ctrl->complete_cb) {
       // TODO refactor with usbd_driver_print_control_complete_name
-      _ctrl_xfer.complete_cb(rhport, CONTROL_STAGE_ACK, &_ctrl_xfer.request);
+      ctrl->complete_cb(rhport, CONTROL_STAGE_ACK, &ctrl->request);
     }
 
     return true;
   }
 
-  if (_ctrl_xfer.request.bmRequestType_bit.direction == TUSB_DIR_OUT) {
-    TU_VERIFY(_ctrl_xfer.buffer);
-    memcpy(_ctrl_xfer.buffer, _ctrl_epbuf.buf, xferred_bytes);
-    TU_LOG_MEM(CFG_TUD_LOG_LEVEL, _ctrl_xfer.buffer, xferred_bytes, 2);
+  bool is_ok = true;
+
+  if (ctrl->request.bmRequestType_bit.direction == TUSB_DIR_OUT) {
+    if (ctrl->stream_cb) {
+      // push received chunk to application, it can reject (stall) by not consuming all
+      uint16_t const len = (uint16_t) xferred_bytes;
+      TU_LOG_MEM(CFG_TUD_LOG_LEVEL, epbuf, len, 2);
+      is_ok = (len == ctrl->stream_cb(rhport, &ctrl->request, ctrl->total_xferred, epbuf, len));
+    } else {
+      TU_VERIFY(ctrl->buffer);
+      if (!ctrl->direct) {
+        memcpy(ctrl->buffer, epbuf, xferred_bytes);
+      }
+      TU_LOG_MEM(CFG_TUD_LOG_LEVEL, ctrl->buffer, xferred_bytes, 2);
+    }
   }
 
-  _ctrl_xfer.total_xferred += (uint16_t) xferred_bytes;
-  _ctrl_xfer.buffer += xferred_bytes;
+  ctrl->total_xferred += (uint16_t) xferred_bytes;
+  if (ctrl->buffer) {
+    ctrl->buffer += xferred_bytes;
+  }
 
   // Data Stage is complete when all request's length are transferred or
-  // a short packet is sent including zero-length packet.
-  if ((_ctrl_xfer.request.wLength == _ctrl_xfer.total_xferred) ||
-      (xferred_bytes < CFG_TUD_ENDPOINT0_SIZE)) {
+  // a short packet is sent including zero-length packet. A multi-packet transaction can also end early.
+  if (!is_ok) {
+    // Stall both IN and OUT control endpoint
+    dcd_edpt_stall(rhport, EDPT_CTRL_OUT);
+    dcd_edpt_stall(rhport, EDPT_CTRL_IN);
+  } else if ((ctrl->request.wLength == ctrl->total_xferred) || (xferred_bytes == 0) ||
+             (xferred_bytes % CFG_TUD_ENDPOINT0_SIZE) || (xferred_bytes < ctrl->xact_len)) {
     // DATA stage is complete
-    bool is_ok = true;
 
     // invoke complete callback if set
     // callback can still stall control in status phase e.g out data does not make sense
-    if (_ctrl_xfer.complete_cb) {
+    if (ctrl->complete_cb) {
       #if CFG_TUSB_DEBUG >= CFG_TUD_LOG_LEVEL
-      usbd_driver_print_control_complete_name(_ctrl_xfer.complete_cb);
+      usbd_driver_print_control_complete_name(ctrl->complete_cb);
       #endif
 
-      is_ok = _ctrl_xfer.complete_cb(rhport, CONTROL_STAGE_DATA, &_ctrl_xfer.request);
+      is_ok = ctrl->complete_cb(rhport, CONTROL_STAGE_DATA, &ctrl->request);
     }
 
     if (is_ok) {
-      TU_ASSERT(status_stage_xact(rhport, &_ctrl_xfer.request));
+      TU_ASSERT(status_stage_xact(rhport, &ctrl->request));
     } else {
       // Stall both IN and OUT control endpoint
       dcd_edpt_stall(rhport, EDPT_CTRL_OUT);
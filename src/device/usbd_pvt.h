@@ -29,6 +29,7 @@
 #include "osal/osal.h"
 #include "common/tusb_fifo.h"
 #include "common/tusb_private.h"
+#include "device/dcd.h"
 
 #ifdef __cplusplus
  extern "C" {
@@ -43,6 +44,12 @@
 typedef enum {
   SOF_CONSUMER_USER = 0,
   SOF_CONSUMER_AUDIO,
+  SOF_CONSUMER_CDC,
+  SOF_CONSUMER_VENDOR,
+  SOF_CONSUMER_MSC,
+  SOF_CONSUMER_UAS,
+  SOF_CONSUMER_NCM,
+  SOF_CONSUMER_VIDEO,
 } sof_consumer_t;
 
 //--------------------------------------------------------------------+
@@ -58,6 +65,8 @@ typedef struct {
   bool     (* control_xfer_cb  ) (uint8_t rhport, uint8_t stage, tusb_control_request_t const * request);
   bool     (* xfer_cb          ) (uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes);
   void     (* sof              ) (uint8_t rhport, uint32_t frame_count); // optional
+  // optional, invoked in ISR with CFG_TUD_XFER_ISR, return false to defer event to usbd task i.e xfer_cb()
+  bool     (* xfer_isr         ) (uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes);
 } usbd_class_driver_t;
 
 // Invoked when initializing device stack to get additional class drivers.
@@ -67,11 +76,17 @@ usbd_class_driver_t const* usbd_app_driver_get_cb(uint8_t* driver_count) TU_ATTR
 
 typedef bool (*usbd_control_xfer_cb_t)(uint8_t rhport, uint8_t stage, tusb_control_request_t const * request);
 
+// Enable/disable interrupt of all initialized device ports
 void usbd_int_set(bool enabled);
 
+// Index of per-port state, always 0 with a single port since drivers may use 0 for the actual controller number
+TU_ATTR_ALWAYS_INLINE static inline uint8_t usbd_port_idx(uint8_t rhport) {
+  return (CFG_TUD_RHPORT_NUM > 1) ? rhport : 0;
+}
+
 //--------------------------------------------------------------------+
 // USBD Endpoint API
-// Note: rhport should be 0 since device stack only support 1 rhport for now
+// Note: with a single port (CFG_TUD_RHPORT_NUM = 1), rhport is ignored
 //--------------------------------------------------------------------+
 
 // Open an endpoint
@@ -80,16 +95,87 @@ bool usbd_edpt_open(uint8_t rhport, tusb_desc_endpoint_t const * desc_ep);
 // Close an endpoint
 void usbd_edpt_close(uint8_t rhport, uint8_t ep_addr);
 
+// Attach class instance context to an endpoint, cleared when endpoint is closed or bus reset.
+// No-op if CFG_TUD_EDPT_CONTEXT is disabled
+void usbd_edpt_set_context(uint8_t rhport, uint8_t ep_addr, void* ctx);
+
+// Get context attached to endpoint, NULL if none or CFG_TUD_EDPT_CONTEXT is disabled
+void* usbd_edpt_get_context(uint8_t rhport, uint8_t ep_addr);
+
+// Return true if class driver instance idx owns the endpoint
+typedef bool (*usbd_edpt_match_t)(uint8_t idx, uint8_t rhport, uint8_t ep_addr);
+
+// Find class driver instance owning an endpoint: endpoint context first, then match() each instance. Return count if
+// not found. Single instance resolves to 0 at compile time since usbd only dispatches endpoints opened by the driver
+TU_ATTR_ALWAYS_INLINE static inline uint8_t usbd_edpt_find_instance_impl(uint8_t rhport, uint8_t ep_addr,
+    void const* instances, size_t instance_size, uint8_t count, usbd_edpt_match_t match) {
+  if (count == 1) {
+    return 0;
+  }
+
+  void const* ctx = usbd_edpt_get_context(rhport, ep_addr);
+  if (ctx != NULL) {
+    return (uint8_t) (((uintptr_t) ctx - (uintptr_t) instances) / instance_size);
+  }
+
+  uint8_t idx;
+  for (idx = 0; idx < count; idx++) {
+    if (match(idx, rhport, ep_addr)) {
+      break;
+    }
+  }
+  return idx;
+}
+
+// instances is the driver's instance array
+#define usbd_edpt_find_instance(_rhport, _ep_addr, _instances, _match) \
+  usbd_edpt_find_instance_impl(_rhport, _ep_addr, _instances, sizeof((_instances)[0]), \
+                               (uint8_t) TU_ARRAY_SIZE(_instances), _match)
+
+// Attach class instance context to an interface, cleared when configuration is reset.
+// No-op if CFG_TUD_ITF_CONTEXT is disabled
+void usbd_itf_set_context(uint8_t rhport, uint8_t itf_num, void* ctx);
+
+// Get context attached to interface, NULL if none or CFG_TUD_ITF_CONTEXT is disabled
+void* usbd_itf_get_context(uint8_t rhport, uint8_t itf_num);
+
+// Find interface descriptor of an alternate setting in the active configuration using the index built on
+// SET_CONFIGURATION. Return NULL if CFG_TUD_ITF_INDEX_MAX is disabled or not found: caller should parse the descriptor
+tusb_desc_interface_t const* usbd_find_interface_desc(uint8_t rhport, uint8_t itf_num, uint8_t alt);
+
 // Submit a usb transfer
 bool usbd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, uint16_t total_bytes);
 
+#if CFG_TUD_EDPT_XFER_EX
+// Submit a usb transfer of up to 4GB, endpoint must be claimed. Completion is reported with a single xfer_cb()
+// carrying the total number of transferred bytes. A short packet (OUT) or error ends the transfer early.
+bool usbd_edpt_xfer_ex(uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint32_t total_bytes);
+#endif
+
+#if CFG_TUD_EDPT_XFER_QUEUE
+// Submit a usb transfer without claiming, which can be queued behind the active transfer of endpoint (ping-pong).
+// The queued transfer is started in ISR as soon as the active one completes, xfer_cb() is still invoked once
+// per transfer in order. Return false if endpoint is claimed by other or already has a queued transfer.
+bool usbd_edpt_xfer_queue(uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint16_t total_bytes);
+
+// Check if usbd_edpt_xfer_queue() can accept a transfer i.e there is at most one transfer on the wire
+bool usbd_edpt_xfer_queue_available(uint8_t rhport, uint8_t ep_addr);
+#endif
+
 // Submit a usb ISO transfer by use of a FIFO (ring buffer) - all bytes in FIFO get transmitted
 bool usbd_edpt_xfer_fifo(uint8_t rhport, uint8_t ep_addr, tu_fifo_t * ff, uint16_t total_bytes);
 
+// Get capabilities of device controller driver, so that class driver can pick its transfer strategy at runtime.
+// Compile-time equivalents are TUP_DCD_ macros in tusb_mcu.h
+void usbd_dcd_caps_get(uint8_t rhport, dcd_caps_t* caps);
+
 // Claim an endpoint before submitting a transfer.
 // If caller does not make any transfer, it must release endpoint for others.
 bool usbd_edpt_claim(uint8_t rhport, uint8_t ep_addr);
 
+// Same as usbd_edpt_claim(), in_isr must be true when called from class driver's xfer_isr() (CFG_TUD_XFER_ISR)
+bool usbd_edpt_claim_ex(uint8_t rhport, uint8_t ep_addr, bool in_isr);
+
 // Release claimed endpoint without submitting a transfer
 bool usbd_edpt_release(uint8_t rhport, uint8_t ep_addr);
 
@@ -111,6 +197,10 @@ bool usbd_edpt_iso_alloc(uint8_t rhport, uint8_t ep_addr, uint16_t largest_packe
 // Configure and enable an ISO endpoint according to descriptor
 bool usbd_edpt_iso_activate(uint8_t rhport,  tusb_desc_endpoint_t const * p_endpoint_desc);
 
+// Get (micro)frame number in which the last packet of the completed isochronous transfer is transferred, valid within
+// xfer_cb(). Return UINT16_MAX if DCD does not report it
+uint16_t usbd_edpt_iso_frame(uint8_t rhport, uint8_t ep_addr);
+
 // Check if endpoint is ready (not busy and not stalled)
 TU_ATTR_ALWAYS_INLINE static inline
 bool usbd_edpt_ready(uint8_t rhport, uint8_t ep_addr) {
@@ -120,13 +210,27 @@ bool usbd_edpt_ready(uint8_t rhport, uint8_t ep_addr) {
 // Enable SOF interrupt
 void usbd_sof_enable(uint8_t rhport, sof_consumer_t consumer, bool en);
 
+#if CFG_TUD_EPBUF_POOL_SIZE
+// Allocate an endpoint buffer of size bytes from the pool (CFG_TUD_EPBUF_POOL_SIZE), aligned to
+// CFG_TUD_EPBUF_POOL_ALIGN and padded to cache line. Buffers are released all at once when configuration is reset,
+// class driver should allocate in its open(). Each port has its own pool. Return NULL if pool is exhausted
+void* usbd_epbuf_alloc(uint8_t rhport, uint32_t size);
+#endif
+
 /*------------------------------------------------------------------*/
 /* Helper
  *------------------------------------------------------------------*/
 
 bool usbd_open_edpt_pair(uint8_t rhport, uint8_t const* p_desc, uint8_t ep_count, uint8_t xfer_type, uint8_t* ep_out, uint8_t* ep_in);
+
+// Defer func to be invoked in usbd task. Deferred calls are not discarded on bus reset or unplug, and can run after
+// it (with priority lanes also after the control requests that follow): func must revalidate the state it acts on.
 void usbd_defer_func(osal_task_func_t func, void *param, bool in_isr);
 
+// Defer with priority (tu_defer_prio_t). With CFG_TUD_DEFER_POOL_SIZE, a pending call with the same func and param
+// is not queued again, higher priority pending calls are invoked first. ISR callers must be the USB interrupt.
+void usbd_defer_func_prio(osal_task_func_t func, void *param, uint8_t prio, bool in_isr);
+
 
 #if CFG_TUSB_DEBUG >= CFG_TUD_LOG_LEVEL
 void usbd_driver_print_control_complete_name(usbd_control_xfer_cb_t callback);
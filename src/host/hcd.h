@@ -50,6 +50,12 @@
 //  #endif
 #endif
 
+// Max number of isochronous endpoints opened at the same time, sizes HCD isochronous descriptors/buffers.
+// 0 disables isochronous support in HCDs that implement it
+#ifndef CFG_TUH_ISO_EDPT_MAX
+  #define CFG_TUH_ISO_EDPT_MAX   (3*CFG_TUH_AUDIO)
+#endif
+
 //--------------------------------------------------------------------+
 // MACRO CONSTANT TYPEDEF
 //--------------------------------------------------------------------+
@@ -97,6 +103,13 @@ typedef struct {
   uint8_t speed;
 } hcd_devtree_info_t;
 
+// Isochronous packet, one per service interval. Packets are laid out back to back in transfer buffer with len stride
+typedef struct {
+  uint16_t len;        // requested length
+  uint16_t actual_len; // set by HCD on completion
+  uint8_t  result;     // xfer_result_t, set by HCD on completion
+} hcd_iso_packet_t;
+
 //--------------------------------------------------------------------+
 // Memory API
 //--------------------------------------------------------------------+
@@ -113,6 +126,12 @@ bool hcd_dcache_invalidate(void const* addr, uint32_t data_size);
 // Required before an DMA transfer where memory is both read/write by DMA
 bool hcd_dcache_clean_invalidate(void const* addr, uint32_t data_size);
 
+// Batch cache maintenance (optional): clean/invalidate issued between begin and end may defer their completion barrier,
+// end completes all of them with a single barrier. Buffers must not be accessed by CPU or DMA until batch end.
+// Batches can be nested, barrier is issued by the outermost end.
+void hcd_dcache_batch_begin(void);
+void hcd_dcache_batch_end(void);
+
 //--------------------------------------------------------------------+
 // Controller API
 //--------------------------------------------------------------------+
@@ -168,6 +187,13 @@ bool hcd_edpt_open(uint8_t rhport, uint8_t daddr, tusb_desc_endpoint_t const * e
 // Submit a transfer, when complete hcd_event_xfer_complete() must be invoked
 bool hcd_edpt_xfer(uint8_t rhport, uint8_t daddr, uint8_t ep_addr, uint8_t * buffer, uint16_t buflen);
 
+// Submit an isochronous transfer of n_packets, one packet per service interval. A transfer submitted while another
+// is in progress is scheduled right after it (continuous streaming), HCD must accept at least 2 transfers per endpoint.
+// On completion packets' actual_len/result are updated and hcd_event_xfer_complete() is invoked with total bytes,
+// result is XFER_RESULT_FAILED if any packet failed. Late packets are skipped and marked failed.
+bool hcd_edpt_iso_xfer(uint8_t rhport, uint8_t daddr, uint8_t ep_addr, uint8_t* buffer, hcd_iso_packet_t* packets,
+                       uint16_t n_packets);
+
 // Abort a queued transfer. Note: it can only abort transfer that has not been started
 // Return true if a queued transfer is aborted, false if there is no transfer to abort
 bool hcd_edpt_abort_xfer(uint8_t rhport, uint8_t dev_addr, uint8_t ep_addr);
@@ -187,6 +213,26 @@ bool hcd_edpt_clear_stall(uint8_t rhport, uint8_t dev_addr, uint8_t ep_addr);
 // needed topology info to carry out its work
 extern void hcd_devtree_get_info(uint8_t dev_addr, hcd_devtree_info_t* devtree_info);
 
+//------------- Periodic Bandwidth -------------//
+
+// Reserve periodic bus time for an interrupt/isochronous endpoint, typically in hcd_edpt_open(). A slot is a
+// microframe of high speed bus (uframe = true) or a frame of full speed bus. Endpoint is serviced every period slots
+// (power of 2), its first slot can be any of [phase_first, phase_first + phase_count) as allowed by HCD schedule.
+// Return first slot with least load that keeps every slot within periodic limit (80% of microframe, 90% of frame),
+// or -1 if bus is over-subscribed. Reservation is released by hcd_bw_release() or when device is removed.
+extern int16_t hcd_bw_reserve(uint8_t dev_addr, tusb_desc_endpoint_t const* ep_desc, bool uframe, uint16_t period,
+                              uint16_t phase_first, uint16_t phase_count);
+
+// Reserve bus time for a full/low speed periodic endpoint behind a high speed hub with split transactions. Budget is
+// checked on both the high speed bus and the hub's transaction translator. period and phase are in frames, smask and
+// cmask return microframes of start-split and complete-split within the frame (EHCI 4.12 placement).
+// Return first frame or -1 if either bus is over-subscribed.
+extern int16_t hcd_bw_reserve_split(uint8_t dev_addr, tusb_desc_endpoint_t const* ep_desc, uint16_t period,
+                                    uint16_t phase_first, uint16_t phase_count, uint8_t* smask, uint8_t* cmask);
+
+// Release reservation of an endpoint, ep_addr = 0 for all endpoints of device
+extern void hcd_bw_release(uint8_t dev_addr, uint8_t ep_addr);
+
 //------------- Event API -------------//
 
 // Called by HCD to notify stack
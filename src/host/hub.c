@@ -46,7 +46,21 @@ typedef struct
   uint8_t ep_in;
   uint8_t port_count;
 
-  CFG_TUH_MEM_ALIGN uint8_t status_change;
+  // status change bitmap is processed in one pass: bit 0 for hub, bit n for port n
+  uint16_t change_pending; // hub/ports not processed yet
+  uint16_t port_attach;    // ports to report attach/remove when pass is complete
+  uint16_t port_remove;
+
+  // ports are powered in groups within CFG_TUH_HUB_POWER_BUDGET_MA, bPwrOn2PwrGood apart
+  uint8_t power_next;     // first port of next group, 0 if all ports are powered
+  uint8_t power_last;     // last port of group being powered
+  uint8_t power_group;    // number of ports per group
+  uint16_t power_good_ms;
+  bool power_due;         // next group is due while hub is busy: power it instead of re-arming status endpoint
+  bool configured;
+  bool status_armed;      // status endpoint is waiting for change, hub control pipe is idle
+
+  CFG_TUH_MEM_ALIGN uint8_t status_change[2]; // up to 15 ports
   CFG_TUH_MEM_ALIGN hub_port_status_response_t port_status;
   CFG_TUH_MEM_ALIGN hub_status_response_t hub_status;
 } hub_interface_t;
@@ -232,10 +246,22 @@ void hub_close(uint8_t dev_addr)
   }
 }
 
+static void hub_power_group(uint8_t daddr);
+
 bool hub_edpt_status_xfer(uint8_t dev_addr)
 {
   hub_interface_t* hub_itf = get_itf(dev_addr);
-  return usbh_edpt_xfer(dev_addr, hub_itf->ep_in, &hub_itf->status_change, 1);
+
+  if (hub_itf->power_due) {
+    // status endpoint is re-armed once next group is powered
+    hub_itf->power_due = false;
+    hub_power_group(dev_addr);
+    return true;
+  }
+
+  uint16_t const len = (hub_itf->port_count < 8) ? 1 : 2;
+  hub_itf->status_armed = usbh_edpt_xfer(dev_addr, hub_itf->ep_in, hub_itf->status_change, len);
+  return hub_itf->status_armed;
 }
 
 
@@ -290,13 +316,51 @@ static void config_set_port_power (tuh_xfer_t* xfer)
 
   // only use number of ports in hub descriptor
   descriptor_hub_desc_t const* desc_hub = (descriptor_hub_desc_t const*) _hub_buffer;
-  p_hub->port_count = desc_hub->bNbrPorts;
+  p_hub->port_count = tu_min8(desc_hub->bNbrPorts, 15); // status change bitmap is 2 bytes
+  p_hub->power_good_ms = (uint16_t) (desc_hub->bPwrOn2PwrGood * 2);
 
   // May need to GET_STATUS
 
+  // Port power can only be staggered with per-port power switching (wHubCharacteristics[1:0] = 01)
+  uint8_t group = p_hub->port_count;
+  if (CFG_TUH_HUB_POWER_BUDGET_MA && (tu_le16toh(desc_hub->wHubCharacteristics) & 0x03u) == 0x01u) {
+    group = (uint8_t) tu_max32(CFG_TUH_HUB_POWER_BUDGET_MA / CFG_TUH_HUB_PORT_CURRENT_MA, 1);
+  }
+  p_hub->power_group = tu_min8(group, p_hub->port_count);
+
   // Set Port Power to be able to detect connection, starting with port 1
-  uint8_t const hub_port = 1;
-  hub_port_set_feature(daddr, hub_port, HUB_FEATURE_PORT_POWER, config_port_power_complete, 0);
+  p_hub->power_next = 1;
+  hub_power_group(daddr);
+}
+
+// next group is due: take over hub control pipe if it is idle, otherwise power it when hub is done with changes
+static void hub_power_timeout(void* param)
+{
+  uint8_t const daddr = (uint8_t) (uintptr_t) param;
+  hub_interface_t* p_hub = get_itf(daddr);
+  TU_VERIFY(p_hub->ep_in && p_hub->power_next, );
+
+  if (p_hub->status_armed) {
+    // hub keeps its change status, it is reported again once re-armed
+    (void) tuh_edpt_abort_xfer(daddr, p_hub->ep_in);
+    p_hub->status_armed = false;
+    hub_power_group(daddr);
+  } else {
+    p_hub->power_due = true;
+  }
+}
+
+static void hub_power_group(uint8_t daddr)
+{
+  hub_interface_t* p_hub = get_itf(daddr);
+  uint8_t const hub_port = p_hub->power_next;
+  p_hub->power_last = tu_min8((uint8_t) (hub_port + p_hub->power_group - 1), p_hub->port_count);
+
+  if (!hub_port_set_feature(daddr, hub_port, HUB_FEATURE_PORT_POWER, config_port_power_complete, 0)) {
+    // control pipe is busy, try again later
+    p_hub->status_armed = false;
+    (void) usbh_defer_func_ms(hub_power_timeout, (void*) (uintptr_t) daddr, 1);
+  }
 }
 
 static void config_port_power_complete (tuh_xfer_t* xfer)
@@ -305,200 +369,204 @@ static void config_port_power_complete (tuh_xfer_t* xfer)
 
   uint8_t const daddr = xfer->daddr;
   hub_interface_t* p_hub = get_itf(daddr);
+  uint8_t const hub_port = (uint8_t) tu_le16toh(xfer->setup->wIndex);
 
-  if (xfer->setup->wIndex == p_hub->port_count)
+  if (hub_port < p_hub->power_last)
   {
-    // All ports are power -> queue notification status endpoint and
-    // complete the SET CONFIGURATION
-    TU_ASSERT( usbh_edpt_xfer(daddr, p_hub->ep_in, &p_hub->status_change, 1), );
+    // power next port of group
+    hub_port_set_feature(daddr, (uint8_t) (hub_port + 1), HUB_FEATURE_PORT_POWER, config_port_power_complete, 0);
+    return;
+  }
 
-    usbh_driver_set_config_complete(daddr, p_hub->itf_num);
-  }else
+  // Group is powered: its ports report connection once power is good, devices on them can be enumerated while
+  // next group waits for its turn
+  p_hub->power_next = (hub_port < p_hub->port_count) ? (uint8_t) (hub_port + 1) : 0;
+  if (p_hub->power_next) {
+    TU_LOG_DRV("  HUB addr = %u: power next ports in %u ms\r\n", daddr, p_hub->power_good_ms);
+    (void) usbh_defer_func_ms(hub_power_timeout, (void*) (uintptr_t) daddr, p_hub->power_good_ms);
+  }
+
+  TU_ASSERT( hub_edpt_status_xfer(daddr), );
+
+  if (!p_hub->configured)
   {
-    // power next port
-    uint8_t const hub_port = (uint8_t) (xfer->setup->wIndex + 1);
-    hub_port_set_feature(daddr, hub_port, HUB_FEATURE_PORT_POWER, config_port_power_complete, 0);
+    // first group is powered -> complete the SET CONFIGURATION
+    p_hub->configured = true;
+    usbh_driver_set_config_complete(daddr, p_hub->itf_num);
   }
 }
 
 //--------------------------------------------------------------------+
 // Connection Changes
+// All hub/port bits of status change are processed in one pass, all change bits of a port are cleared back to back.
+// Attach/remove are reported to usbh at the end of the pass. Port reset is done by usbh enumeration, since only one
+// device can be at address 0. Status endpoint is re-armed when pass is complete, or by usbh once the attached ports
+// have been enumerated.
 //--------------------------------------------------------------------+
 
-static void hub_port_get_status_complete (tuh_xfer_t* xfer);
+static void hub_status_process(uint8_t daddr);
 static void hub_get_status_complete (tuh_xfer_t* xfer);
-static void connection_clear_conn_change_complete (tuh_xfer_t* xfer);
-static void connection_port_reset_complete (tuh_xfer_t* xfer);
+static void hub_port_get_status_complete (tuh_xfer_t* xfer);
+static void hub_clear_change_complete (tuh_xfer_t* xfer);
 
 // callback as response of interrupt endpoint polling
 bool hub_xfer_cb(uint8_t dev_addr, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes) {
-  (void) xferred_bytes; // TODO can be more than 1 for hub with lots of ports
   (void) ep_addr;
+  hub_interface_t* p_hub = get_itf(dev_addr);
+  p_hub->status_armed = false;
   TU_VERIFY(result == XFER_RESULT_SUCCESS);
 
-  hub_interface_t* p_hub = get_itf(dev_addr);
+  uint16_t status_change = p_hub->status_change[0];
+  if (xferred_bytes > 1) {
+    status_change |= (uint16_t) (p_hub->status_change[1] << 8);
+  }
+  status_change &= (uint16_t) ((2u << p_hub->port_count) - 1);
+  TU_LOG2("  Hub Status Change = 0x%04X\r\n", status_change);
 
-  uint8_t const status_change = p_hub->status_change;
-  TU_LOG2("  Hub Status Change = 0x%02X\r\n", status_change);
+  // Note: status change 0 is neither for the hub, nor for any of its ports. This shouldn't happen, but it does with
+  // some devices, pass will complete right away and re-arm the status endpoint.
+  p_hub->change_pending = status_change;
+  p_hub->port_attach = 0;
+  p_hub->port_remove = 0;
+  hub_status_process(dev_addr);
 
-  if ( status_change == 0 ) {
-    // The status change event was neither for the hub, nor for any of its ports.
-    // This shouldn't happen, but it does with some devices.
-    // Initiate the next interrupt poll here.
-    return hub_edpt_status_xfer(dev_addr);
-  }
+  return true;
+}
 
-  if (tu_bit_test(status_change, 0)) {
-    // Hub bit 0 is for the hub device events
-    if (hub_port_get_status(dev_addr, 0, &p_hub->hub_status, hub_get_status_complete, 0) == false) {
-      //Hub status control transfer failed, retry
-      hub_edpt_status_xfer(dev_addr);
+// report attach/remove of this pass to usbh, re-arm status endpoint if there is no port to enumerate
+static void hub_status_complete(uint8_t daddr) {
+  hub_interface_t* p_hub = get_itf(daddr);
+  p_hub->change_pending = 0;
+
+  for (uint8_t port = 1; port <= p_hub->port_count; port++) {
+    bool const is_attach = tu_bit_test(p_hub->port_attach, port);
+    if (is_attach || tu_bit_test(p_hub->port_remove, port)) {
+      hcd_event_t event =
+      {
+        .rhport     = usbh_get_rhport(daddr),
+        .event_id   = is_attach ? HCD_EVENT_DEVICE_ATTACH : HCD_EVENT_DEVICE_REMOVE,
+        .connection =
+        {
+          .hub_addr = daddr,
+          .hub_port = port
+        }
+      };
+
+      hcd_event_handler(&event, false);
     }
   }
-  else {
-    // Hub bits 1 to n are hub port events
-    for (uint8_t port=1; port <= p_hub->port_count; port++) {
-      if ( tu_bit_test(status_change, port) ) {
-        if (hub_port_get_status(dev_addr, port, &p_hub->port_status, hub_port_get_status_complete, 0) == false) {
-          //Hub status control transfer failed, retry
-          hub_edpt_status_xfer(dev_addr);
-        }
-        break;
+
+  if (p_hub->port_attach == 0) {
+    hub_edpt_status_xfer(daddr);
+  }
+}
+
+// get status of next hub/port with change, complete the pass if there is none
+static void hub_status_process(uint8_t daddr) {
+  hub_interface_t* p_hub = get_itf(daddr);
+
+  if (p_hub->change_pending == 0) {
+    hub_status_complete(daddr);
+    return;
+  }
+
+  uint8_t port = 0;
+  while (!tu_bit_test(p_hub->change_pending, port)) {
+    port++;
+  }
+
+  bool ret;
+  if (port == 0) {
+    ret = hub_port_get_status(daddr, 0, &p_hub->hub_status, hub_get_status_complete, 0);
+  } else {
+    ret = hub_port_get_status(daddr, port, &p_hub->port_status, hub_port_get_status_complete, 0);
+  }
+
+  if (!ret) {
+    // control pipe is busy: hub keeps change status of remaining ports, they will be reported again
+    hub_status_complete(daddr);
+  }
+}
+
+// clear next change bit of hub (port 0) or port, continue with next hub/port when all are cleared
+static void hub_clear_next_change(uint8_t daddr, uint8_t port) {
+  hub_interface_t* p_hub = get_itf(daddr);
+  uint16_t* change = (port == 0) ? &p_hub->hub_status.change.value : &p_hub->port_status.change.value;
+
+  // hub: local power (0), over current (1). port: connection (0), enable, suspend, over current, reset (4)
+  uint8_t const count = (port == 0) ? 2 : 5;
+  for (uint8_t i = 0; i < count; i++) {
+    if (tu_bit_test(*change, i)) {
+      *change = (uint16_t) tu_bit_clear(*change, i);
+      uint8_t const feature = (uint8_t) ((port == 0) ? i : (HUB_FEATURE_PORT_CONNECTION_CHANGE + i));
+      if (!hub_port_clear_feature(daddr, port, feature, hub_clear_change_complete, 0)) {
+        hub_status_complete(daddr); // control pipe is busy, change will be reported again
       }
+      return;
     }
   }
 
-  // NOTE: next status transfer is queued by usbh.c after handling this request
-  return true;
+  // Other changes are: L1 state, not handled
+  p_hub->change_pending = (uint16_t) tu_bit_clear(p_hub->change_pending, port);
+  hub_status_process(daddr);
 }
 
-static void hub_clear_feature_complete_stub(tuh_xfer_t* xfer)
-{
-  TU_ASSERT(xfer->result == XFER_RESULT_SUCCESS, );
-  hub_edpt_status_xfer(xfer->daddr);
+static void hub_clear_change_complete(tuh_xfer_t* xfer) {
+  uint8_t const daddr = xfer->daddr;
+  if (xfer->result != XFER_RESULT_SUCCESS) {
+    hub_status_complete(daddr);
+    return;
+  }
+  hub_clear_next_change(daddr, (uint8_t) tu_le16toh(xfer->setup->wIndex));
 }
 
 static void hub_get_status_complete (tuh_xfer_t* xfer)
 {
-  TU_ASSERT(xfer->result == XFER_RESULT_SUCCESS, );
-
   uint8_t const daddr = xfer->daddr;
-  hub_interface_t* p_hub = get_itf(daddr);
-  uint8_t const port_num = (uint8_t) tu_le16toh(xfer->setup->wIndex);
-  TU_ASSERT(port_num == 0 , );
+  if (xfer->result != XFER_RESULT_SUCCESS) {
+    hub_status_complete(daddr);
+    return;
+  }
 
+  hub_interface_t* p_hub = get_itf(daddr);
   TU_LOG2("HUB Got hub status, addr = %u, status = %04x\r\n", daddr, p_hub->hub_status.change.value);
 
-  if (p_hub->hub_status.change.local_power_source)
-  {
+  if (p_hub->hub_status.change.local_power_source) {
     TU_LOG2("HUB Local Power Change, addr = %u\r\n", daddr);
-    hub_port_clear_feature(daddr, port_num, HUB_FEATURE_HUB_LOCAL_POWER_CHANGE, hub_clear_feature_complete_stub, 0);
   }
-  else if (p_hub->hub_status.change.over_current)
-  {
+  if (p_hub->hub_status.change.over_current) {
     TU_LOG1("HUB Over Current, addr = %u\r\n", daddr);
-    hub_port_clear_feature(daddr, port_num, HUB_FEATURE_HUB_OVER_CURRENT_CHANGE, hub_clear_feature_complete_stub, 0);
   }
+
+  hub_clear_next_change(daddr, 0);
 }
 
 static void hub_port_get_status_complete (tuh_xfer_t* xfer)
 {
-  TU_ASSERT(xfer->result == XFER_RESULT_SUCCESS, );
-
   uint8_t const daddr = xfer->daddr;
-  hub_interface_t* p_hub = get_itf(daddr);
-  uint8_t const port_num = (uint8_t) tu_le16toh(xfer->setup->wIndex);
-
-  // Connection change
-  if (p_hub->port_status.change.connection)
-  {
-    // Port is powered and enabled
-    //TU_VERIFY(port_status.status_current.port_power && port_status.status_current.port_enable, );
-
-    // Acknowledge Port Connection Change
-    hub_port_clear_feature(daddr, port_num, HUB_FEATURE_PORT_CONNECTION_CHANGE, connection_clear_conn_change_complete, 0);
-  }else
-  {
-    // Clear other port status change interrupts. TODO Not currently handled - just cleared.
-    if (p_hub->port_status.change.port_enable)
-    {
-      hub_port_clear_feature(daddr, port_num, HUB_FEATURE_PORT_ENABLE_CHANGE, hub_clear_feature_complete_stub, 0);
-    }
-    else if (p_hub->port_status.change.suspend)
-    {
-      hub_port_clear_feature(daddr, port_num, HUB_FEATURE_PORT_SUSPEND_CHANGE, hub_clear_feature_complete_stub, 0);
-    }
-    else if (p_hub->port_status.change.over_current)
-    {
-      hub_port_clear_feature(daddr, port_num, HUB_FEATURE_PORT_OVER_CURRENT_CHANGE, hub_clear_feature_complete_stub, 0);
-    }
-    else if (p_hub->port_status.change.reset)
-    {
-      hub_port_clear_feature(daddr, port_num, HUB_FEATURE_PORT_RESET_CHANGE, hub_clear_feature_complete_stub, 0);
-    }
-    // Other changes are: L1 state
-    // TODO clear change
-
-    else
-    {
-      // prepare for next hub status
-      // TODO continue with status_change, or maybe we can do it again with status
-      hub_edpt_status_xfer(daddr);
-    }
+  if (xfer->result != XFER_RESULT_SUCCESS) {
+    hub_status_complete(daddr);
+    return;
   }
-}
 
-static void connection_clear_conn_change_complete (tuh_xfer_t* xfer)
-{
-  TU_ASSERT(xfer->result == XFER_RESULT_SUCCESS, );
-
-  uint8_t const daddr = xfer->daddr;
   hub_interface_t* p_hub = get_itf(daddr);
   uint8_t const port_num = (uint8_t) tu_le16toh(xfer->setup->wIndex);
 
-  if ( p_hub->port_status.status.connection )
-  {
-    // Reset port if attach event
-    hub_port_reset(daddr, port_num, connection_port_reset_complete, 0);
-  }else
-  {
-    // submit detach event
-    hcd_event_t event =
-    {
-      .rhport     = usbh_get_rhport(daddr),
-      .event_id   = HCD_EVENT_DEVICE_REMOVE,
-      .connection =
-       {
-         .hub_addr = daddr,
-         .hub_port = port_num
-       }
-    };
-
-    hcd_event_handler(&event, false);
+  if (p_hub->port_status.change.connection) {
+    // a quick unplug/plug is reported as attach, usbh handles it as duplicated attach
+    if (p_hub->port_status.status.connection) {
+      p_hub->port_attach = (uint16_t) tu_bit_set(p_hub->port_attach, port_num);
+    } else {
+      p_hub->port_remove = (uint16_t) tu_bit_set(p_hub->port_remove, port_num);
+    }
   }
-}
-
-static void connection_port_reset_complete (tuh_xfer_t* xfer)
-{
-  TU_ASSERT(xfer->result == XFER_RESULT_SUCCESS, );
-
-  uint8_t const daddr = xfer->daddr;
-  // hub_interface_t* p_hub = get_itf(daddr);
-  uint8_t const port_num = (uint8_t) tu_le16toh(xfer->setup->wIndex);
 
-  // submit attach event
-  hcd_event_t event =
-  {
-    .rhport     = usbh_get_rhport(daddr),
-    .event_id   = HCD_EVENT_DEVICE_ATTACH,
-    .connection =
-    {
-      .hub_addr = daddr,
-      .hub_port = port_num
-    }
-  };
+  if (p_hub->port_status.change.over_current) {
+    TU_LOG1("HUB Port Over Current, addr = %u port = %u\r\n", daddr, port_num);
+  }
 
-  hcd_event_handler(&event, false);
+  // Clear port status change interrupts. TODO enable, suspend and over current are not handled - just cleared.
+  hub_clear_next_change(daddr, port_num);
 }
 
 #endif
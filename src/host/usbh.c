@@ -44,6 +44,18 @@
   #define CFG_TUH_INTERFACE_MAX   8
 #endif
 
+// Number of pending deferred function calls (usbh_defer_func) kept in a pool outside of event queue, 0 to queue each
+// call as an event. Pending calls with the same func and param are coalesced, all of them take a single queue slot.
+#ifndef CFG_TUH_DEFER_POOL_SIZE
+  #define CFG_TUH_DEFER_POOL_SIZE   0
+#endif
+
+// Number of non-control endpoints shared by all devices, allocated when opened. 0 means each device has its own
+// CFG_TUH_ENDPOINT_MAX x 2 endpoint table. Pool saves RAM with many devices that use few endpoints (e.g hubs).
+#ifndef CFG_TUH_ENDPOINT_POOL
+  #define CFG_TUH_ENDPOINT_POOL   0
+#endif
+
 //--------------------------------------------------------------------+
 // Weak stubs: invoked if no strong implementation is available
 //--------------------------------------------------------------------+
@@ -59,12 +71,47 @@ TU_ATTR_WEAK bool hcd_configure(uint8_t rhport, uint32_t cfg_id, const void* cfg
   return false;
 }
 
+TU_ATTR_WEAK bool hcd_edpt_iso_xfer(uint8_t rhport, uint8_t daddr, uint8_t ep_addr, uint8_t* buffer,
+                                    hcd_iso_packet_t* packets, uint16_t n_packets) {
+  (void) rhport;
+  (void) daddr;
+  (void) ep_addr;
+  (void) buffer;
+  (void) packets;
+  (void) n_packets;
+  return false;
+}
+
+#if CFG_TUH_DESC_CACHE
+TU_ATTR_WEAK uint16_t tuh_descriptor_cache_load_cb(tusb_desc_device_t const* desc_device, uint8_t* buffer, uint16_t bufsize) {
+  (void) desc_device;
+  (void) buffer;
+  (void) bufsize;
+  return 0;
+}
+
+TU_ATTR_WEAK void tuh_descriptor_cache_store_cb(tusb_desc_device_t const* desc_device, uint8_t const* desc_config, uint16_t len) {
+  (void) desc_device;
+  (void) desc_config;
+  (void) len;
+}
+#endif
+
 TU_ATTR_WEAK void tuh_event_hook_cb(uint8_t rhport, uint32_t eventid, bool in_isr) {
   (void) rhport;
   (void) eventid;
   (void) in_isr;
 }
 
+TU_ATTR_WEAK uint32_t tuh_stats_timestamp_cb(void) {
+  return 0;
+}
+
+TU_ATTR_WEAK uint8_t tuh_edpt_interval_cb(uint8_t daddr, tusb_desc_endpoint_t const* desc_ep) {
+  (void) daddr;
+  return desc_ep->bInterval;
+}
+
 TU_ATTR_WEAK bool hcd_dcache_clean(const void* addr, uint32_t data_size) {
   (void) addr; (void) data_size;
   return false;
@@ -80,6 +127,12 @@ TU_ATTR_WEAK bool hcd_dcache_clean_invalidate(const void* addr, uint32_t data_si
   return false;
 }
 
+TU_ATTR_WEAK void hcd_dcache_batch_begin(void) {
+}
+
+TU_ATTR_WEAK void hcd_dcache_batch_end(void) {
+}
+
 //--------------------------------------------------------------------+
 // USBH-HCD common data structure
 //--------------------------------------------------------------------+
@@ -96,6 +149,21 @@ typedef struct {
   };
 } usbh_dev0_t;
 
+// Endpoint state
+typedef struct {
+#if CFG_TUH_ENDPOINT_POOL
+  uint8_t daddr;   // owner device, 0 if free
+  uint8_t ep_addr;
+#endif
+  uint8_t drv_id;  // driver of this endpoint (0xff is invalid)
+  tu_edpt_state_t state;
+
+#if CFG_TUH_API_EDPT_XFER
+  tuh_xfer_cb_t complete_cb;
+  uintptr_t user_data;
+#endif
+} usbh_edpt_t;
+
 typedef struct {
   // port, must be same layout as usbh_dev0_t
   uint8_t rhport;
@@ -109,6 +177,7 @@ typedef struct {
     volatile uint8_t addressed  : 1; // After SET_ADDR
     volatile uint8_t configured : 1; // After SET_CONFIG and all drivers are configured
     volatile uint8_t suspended  : 1; // Bus suspended
+    volatile uint8_t enum_pending : 1; // Addressed, waiting for enumeration buffer to continue enumerating
 
     // volatile uint8_t removing : 1; // Physically disconnected, waiting to be processed by usbh
   };
@@ -123,23 +192,17 @@ typedef struct {
   uint8_t  i_product;
   uint8_t  i_serial;
 
+  uint16_t quirks;  // TUH_QUIRK_ flags from device ID table
+
   // Configuration Descriptor
   // uint8_t interface_count; // bNumInterfaces alias
 
   // Endpoint & Interface
   uint8_t itf2drv[CFG_TUH_INTERFACE_MAX];  // map interface number to driver (0xff is invalid)
-  uint8_t ep2drv[CFG_TUH_ENDPOINT_MAX][2]; // map endpoint to driver ( 0xff is invalid ), can use only 4-bit each
 
-  tu_edpt_state_t ep_status[CFG_TUH_ENDPOINT_MAX][2];
-
-#if CFG_TUH_API_EDPT_XFER
-  // TODO array can be CFG_TUH_ENDPOINT_MAX-1
-  struct {
-    tuh_xfer_cb_t complete_cb;
-    uintptr_t user_data;
-  }ep_callback[CFG_TUH_ENDPOINT_MAX][2];
+#if !CFG_TUH_ENDPOINT_POOL
+  usbh_edpt_t ep[CFG_TUH_ENDPOINT_MAX][2];
 #endif
-
 } usbh_device_t;
 
 //--------------------------------------------------------------------+
@@ -152,6 +215,19 @@ typedef struct {
 #endif
 
 static usbh_class_driver_t const usbh_class_drivers[] = {
+  // before CDC which would claim the ACM interface of RNDIS device
+  #if CFG_TUH_RNDIS
+  {
+      .name       = DRIVER_NAME("RNDIS"),
+      .init       = rndish_init,
+      .deinit     = rndish_deinit,
+      .open       = rndish_open,
+      .set_config = rndish_set_config,
+      .xfer_cb    = rndish_xfer_cb,
+      .close      = rndish_close
+  },
+  #endif
+
   #if CFG_TUH_CDC
   {
       .name       = DRIVER_NAME("CDC"),
@@ -164,6 +240,30 @@ static usbh_class_driver_t const usbh_class_drivers[] = {
   },
   #endif
 
+  #if CFG_TUH_NCM
+  {
+      .name       = DRIVER_NAME("NCM"),
+      .init       = ncmh_init,
+      .deinit     = ncmh_deinit,
+      .open       = ncmh_open,
+      .set_config = ncmh_set_config,
+      .xfer_cb    = ncmh_xfer_cb,
+      .close      = ncmh_close
+  },
+  #endif
+
+  #if CFG_TUH_UAS
+  {
+      .name       = DRIVER_NAME("UAS"),
+      .init       = uash_init,
+      .deinit     = uash_deinit,
+      .open       = uash_open,
+      .set_config = uash_set_config,
+      .xfer_cb    = uash_xfer_cb,
+      .close      = uash_close
+  },
+  #endif
+
   #if CFG_TUH_MSC
   {
       .name       = DRIVER_NAME("MSC"),
@@ -176,6 +276,42 @@ static usbh_class_driver_t const usbh_class_drivers[] = {
   },
   #endif
 
+  #if CFG_TUH_AUDIO
+  {
+      .name       = DRIVER_NAME("AUDIO"),
+      .init       = audioh_init,
+      .deinit     = audioh_deinit,
+      .open       = audioh_open,
+      .set_config = audioh_set_config,
+      .xfer_cb    = audioh_xfer_cb,
+      .close      = audioh_close
+  },
+  #endif
+
+  #if CFG_TUH_MIDI
+  {
+      .name       = DRIVER_NAME("MIDI"),
+      .init       = midih_init,
+      .deinit     = midih_deinit,
+      .open       = midih_open,
+      .set_config = midih_set_config,
+      .xfer_cb    = midih_xfer_cb,
+      .close      = midih_close
+  },
+  #endif
+
+  #if CFG_TUH_BTH
+  {
+      .name       = DRIVER_NAME("BTH"),
+      .init       = bthh_init,
+      .deinit     = bthh_deinit,
+      .open       = bthh_open,
+      .set_config = bthh_set_config,
+      .xfer_cb    = bthh_xfer_cb,
+      .close      = bthh_close
+  },
+  #endif
+
   #if CFG_TUH_HID
   {
       .name       = DRIVER_NAME("HID"),
@@ -202,13 +338,13 @@ static usbh_class_driver_t const usbh_class_drivers[] = {
 
   #if CFG_TUH_VENDOR
   {
-    .name       = DRIVER_NAME("VENDOR"),
-    .init       = cush_init,
-    .deinit     = cush_deinit,
-    .open       = cush_open,
-    .set_config = cush_set_config,
-    .xfer_cb    = cush_isr,
-    .close      = cush_close
+      .name       = DRIVER_NAME("VENDOR"),
+      .init       = vendorh_init,
+      .deinit     = vendorh_deinit,
+      .open       = vendorh_open,
+      .set_config = vendorh_set_config,
+      .xfer_cb    = vendorh_xfer_cb,
+      .close      = vendorh_close
   }
   #endif
 };
@@ -216,6 +352,86 @@ static usbh_class_driver_t const usbh_class_drivers[] = {
 enum { BUILTIN_DRIVER_COUNT = TU_ARRAY_SIZE(usbh_class_drivers) };
 enum { CONFIG_NUM = 1 }; // default to use configuration 1
 
+//--------------------------------------------------------------------+
+// Device ID table
+//--------------------------------------------------------------------+
+
+// Known devices: interfaces of class itf_class (0 for any) are bound to driver whose open() is given (NULL to keep
+// the normal driver search), quirks apply to the whole device.
+typedef struct {
+  uint16_t vid;
+  uint16_t pid;
+  uint8_t  itf_class;
+  uint16_t quirks;
+  bool (* open)(uint8_t rhport, uint8_t daddr, tusb_desc_interface_t const * desc_itf, uint16_t max_len);
+} usbh_device_id_t;
+
+// Must be sorted by VID then PID for binary search
+static usbh_device_id_t const usbh_device_ids[] = {
+  #if CFG_TUH_CDC && CFG_TUH_CDC_FTDI
+  { 0x0403, 0x6001, TUSB_CLASS_VENDOR_SPECIFIC, TUH_QUIRK_SERIAL_FTDI, cdch_open },
+  { 0x0403, 0x6006, TUSB_CLASS_VENDOR_SPECIFIC, TUH_QUIRK_SERIAL_FTDI, cdch_open },
+  { 0x0403, 0x6010, TUSB_CLASS_VENDOR_SPECIFIC, TUH_QUIRK_SERIAL_FTDI, cdch_open },
+  { 0x0403, 0x6011, TUSB_CLASS_VENDOR_SPECIFIC, TUH_QUIRK_SERIAL_FTDI, cdch_open },
+  { 0x0403, 0x6014, TUSB_CLASS_VENDOR_SPECIFIC, TUH_QUIRK_SERIAL_FTDI, cdch_open },
+  { 0x0403, 0x6015, TUSB_CLASS_VENDOR_SPECIFIC, TUH_QUIRK_SERIAL_FTDI, cdch_open },
+  { 0x0403, 0x8372, TUSB_CLASS_VENDOR_SPECIFIC, TUH_QUIRK_SERIAL_FTDI, cdch_open },
+  { 0x0403, 0xCD18, TUSB_CLASS_VENDOR_SPECIFIC, TUH_QUIRK_SERIAL_FTDI, cdch_open },
+  { 0x0403, 0xFBFA, TUSB_CLASS_VENDOR_SPECIFIC, TUH_QUIRK_SERIAL_FTDI, cdch_open },
+  #endif
+
+  #if CFG_TUH_CDC && CFG_TUH_CDC_CP210X
+  { 0x10C4, 0xEA60, TUSB_CLASS_VENDOR_SPECIFIC, TUH_QUIRK_SERIAL_CP210X, cdch_open },
+  { 0x10C4, 0xEA70, TUSB_CLASS_VENDOR_SPECIFIC, TUH_QUIRK_SERIAL_CP210X, cdch_open },
+  #endif
+
+  #if CFG_TUH_CDC && CFG_TUH_CDC_CH34X
+  { 0x1A86, 0x5523, TUSB_CLASS_VENDOR_SPECIFIC, TUH_QUIRK_SERIAL_CH34X, cdch_open }, // ch341
+  { 0x1A86, 0x7522, TUSB_CLASS_VENDOR_SPECIFIC, TUH_QUIRK_SERIAL_CH34X, cdch_open }, // ch340k
+  { 0x1A86, 0x7523, TUSB_CLASS_VENDOR_SPECIFIC, TUH_QUIRK_SERIAL_CH34X, cdch_open }, // ch340
+  { 0x1A86, 0xE523, TUSB_CLASS_VENDOR_SPECIFIC, TUH_QUIRK_SERIAL_CH34X, cdch_open }, // ch330
+  { 0x2184, 0x0057, TUSB_CLASS_VENDOR_SPECIFIC, TUH_QUIRK_SERIAL_CH34X, cdch_open }, // from Linux ch341.c
+  { 0x4348, 0x5523, TUSB_CLASS_VENDOR_SPECIFIC, TUH_QUIRK_SERIAL_CH34X, cdch_open }, // ch340 custom
+  { 0x9986, 0x7523, TUSB_CLASS_VENDOR_SPECIFIC, TUH_QUIRK_SERIAL_CH34X, cdch_open }, // from Linux ch341.c
+  #endif
+
+  // keep table non-empty
+  { 0xFFFF, 0xFFFF, 0, 0, NULL }
+};
+
+enum { DEVICE_ID_COUNT = TU_ARRAY_SIZE(usbh_device_ids) };
+
+// Index of first entry of vid/pid, DEVICE_ID_COUNT if not found
+static uint16_t device_id_find(uint16_t vid, uint16_t pid) {
+  uint32_t const key = ((uint32_t) vid << 16) | pid;
+  uint16_t lo = 0;
+  uint16_t hi = DEVICE_ID_COUNT;
+
+  while (lo < hi) {
+    uint16_t const mid = (uint16_t) ((lo + hi) / 2);
+    uint32_t const mid_key = ((uint32_t) usbh_device_ids[mid].vid << 16) | usbh_device_ids[mid].pid;
+    if (mid_key < key) {
+      lo = (uint16_t) (mid + 1);
+    } else {
+      hi = mid;
+    }
+  }
+
+  if (lo < DEVICE_ID_COUNT && usbh_device_ids[lo].vid == vid && usbh_device_ids[lo].pid == pid) {
+    return lo;
+  }
+  return DEVICE_ID_COUNT;
+}
+
+static uint16_t device_id_quirks(uint16_t vid, uint16_t pid) {
+  uint16_t quirks = 0;
+  for (uint16_t i = device_id_find(vid, pid);
+       i < DEVICE_ID_COUNT && usbh_device_ids[i].vid == vid && usbh_device_ids[i].pid == pid; i++) {
+    quirks |= usbh_device_ids[i].quirks;
+  }
+  return quirks;
+}
+
 // Additional class drivers implemented by application
 tu_static usbh_class_driver_t const * _app_driver = NULL;
 tu_static uint8_t _app_driver_count = 0;
@@ -234,6 +450,59 @@ static inline usbh_class_driver_t const *get_driver(uint8_t drv_id) {
   return driver;
 }
 
+//--------------------------------------------------------------------+
+// Statistics
+//--------------------------------------------------------------------+
+#if CFG_TUH_STATS
+// only updated by usbh task
+tu_static tuh_stats_t _usbh_stats;
+
+void tuh_stats_get(tuh_stats_t* stats) {
+  *stats = _usbh_stats;
+  for (uint8_t i = 0; i < CFG_TUH_STATS_DRIVER_MAX; i++) {
+    usbh_class_driver_t const* driver = get_driver(i);
+    stats->driver[i].name = driver ? driver->name : NULL;
+  }
+}
+
+void tuh_stats_clear(void) {
+  tu_varclr(&_usbh_stats);
+}
+
+// class driver callback returned, start is timestamp taken before invoking it
+static void usbh_stats_driver(uint8_t drv_id, uint32_t start) {
+  if (drv_id < CFG_TUH_STATS_DRIVER_MAX) {
+    uint32_t const elapsed = tuh_stats_timestamp_cb() - start;
+    tuh_stats_driver_t* drv_stats = &_usbh_stats.driver[drv_id];
+    drv_stats->calls++;
+    drv_stats->time_sum += elapsed;
+    if (elapsed > drv_stats->time_max) drv_stats->time_max = elapsed;
+  }
+}
+
+#define usbh_stats_timestamp()  tuh_stats_timestamp_cb()
+#else
+#define usbh_stats_driver(_drv_id, _start) (void) (_start)
+#define usbh_stats_timestamp()  0
+#endif
+
+// Built-in driver bound to an interface by device ID table, TUSB_INDEX_INVALID_8 if none
+static uint8_t device_id_get_driver(uint16_t vid, uint16_t pid, uint8_t itf_class) {
+  for (uint16_t i = device_id_find(vid, pid);
+       i < DEVICE_ID_COUNT && usbh_device_ids[i].vid == vid && usbh_device_ids[i].pid == pid; i++) {
+    usbh_device_id_t const* id = &usbh_device_ids[i];
+    if (id->open && (id->itf_class == 0 || id->itf_class == itf_class)) {
+      for (uint8_t drv_id = _app_driver_count; drv_id < TOTAL_DRIVER_COUNT; drv_id++) {
+        if (get_driver(drv_id)->open == id->open) {
+          return drv_id;
+        }
+      }
+    }
+  }
+
+  return TUSB_INDEX_INVALID_8;
+}
+
 //--------------------------------------------------------------------+
 // INTERNAL OBJECT & FUNCTION DECLARATION
 //--------------------------------------------------------------------+
@@ -251,6 +520,25 @@ static usbh_dev0_t _dev0;
 // TODO: hub can has its own simpler struct to save memory
 static usbh_device_t _usbh_devices[TOTAL_DEVICES];
 
+// tuh_task() is processing an event, blocking transfer must keep running tuh_task() instead of sleeping
+static volatile bool _usbh_in_task;
+
+// Delayed function call, run by tuh_task(). Used by hub driver and HID adaptive polling
+#if CFG_TUH_HID && CFG_TUH_HID_POLL_ADAPTIVE
+  #define USBH_TIMER_HID  CFG_TUH_HID
+#else
+  #define USBH_TIMER_HID  0
+#endif
+enum { USBH_TIMER_MAX = (CFG_TUH_HUB ? CFG_TUH_HUB : 1) + USBH_TIMER_HID };
+typedef struct {
+  osal_task_func_t func; // NULL if free
+  void* param;
+  uint32_t start_ms;
+  uint32_t delay_ms;
+} usbh_timer_t;
+
+static usbh_timer_t _usbh_timer[USBH_TIMER_MAX];
+
 // Mutex for claiming endpoint
 #if OSAL_MUTEX_REQUIRED
   static osal_mutex_def_t _usbh_mutexdef;
@@ -264,10 +552,15 @@ static usbh_device_t _usbh_devices[TOTAL_DEVICES];
 OSAL_QUEUE_DEF(usbh_int_set, _usbh_qdef, CFG_TUH_TASK_QUEUE_SZ, hcd_event_t);
 static osal_queue_t _usbh_q;
 
-// Control transfers: since most controllers do not support multiple control transfers
-// on multiple devices concurrently and control transfers are not used much except for
-// enumeration, we will only execute control transfers one at a time.
-static struct {
+#if CFG_TUH_DEFER_POOL_SIZE
+static tu_defer_entry_t _usbh_defer_entries[CFG_TUH_DEFER_POOL_SIZE];
+static tu_defer_pool_t _usbh_defer = { .entries = _usbh_defer_entries, .size = CFG_TUH_DEFER_POOL_SIZE };
+#endif
+
+// Control transfers: if HCD supports it (CFG_TUH_CONTROL_CONCURRENT), each device including dev0 has its own
+// control transfer state. Otherwise, since control transfers are not used much except for enumeration, we will
+// only execute control transfers one at a time.
+typedef struct {
   uint8_t* buffer;
   tuh_xfer_cb_t complete_cb;
   uintptr_t user_data;
@@ -275,10 +568,23 @@ static struct {
   uint8_t daddr;
   volatile uint8_t stage;
   volatile uint16_t actual_len;
-} _ctrl_xfer;
+} usbh_ctrl_xfer_t;
+
+#if CFG_TUH_CONTROL_CONCURRENT
+  #define CTRL_XFER_COUNT   (TOTAL_DEVICES + 1)
+#else
+  #define CTRL_XFER_COUNT   1
+#endif
+
+static usbh_ctrl_xfer_t _ctrl_xfer[CTRL_XFER_COUNT];
 
 typedef struct {
   TUH_EPBUF_TYPE_DEF(tusb_control_request_t, request);
+} usbh_ctrl_epbuf_t;
+
+typedef struct {
+  usbh_ctrl_epbuf_t ctrl_setup[CTRL_XFER_COUNT];
+  TUH_EPBUF_DEF(dev0, 8); // reset and set address stage: hub port status, 8 bytes of device descriptor
   TUH_EPBUF_DEF(ctrl, CFG_TUH_ENUMERATION_BUFSIZE);
 } usbh_epbuf_t;
 
@@ -291,10 +597,32 @@ TU_ATTR_ALWAYS_INLINE static inline usbh_device_t* get_device(uint8_t dev_addr)
   return &_usbh_devices[dev_addr-1];
 }
 
-static bool enum_new_device(hcd_event_t* event);
+TU_ATTR_ALWAYS_INLINE static inline uint8_t ctrl_xfer_idx(uint8_t daddr) {
+#if CFG_TUH_CONTROL_CONCURRENT
+  return daddr;
+#else
+  (void) daddr;
+  return 0;
+#endif
+}
+
+TU_ATTR_ALWAYS_INLINE static inline usbh_ctrl_xfer_t* get_ctrl_xfer(uint8_t daddr) {
+  return &_ctrl_xfer[ctrl_xfer_idx(daddr)];
+}
+
+TU_ATTR_ALWAYS_INLINE static inline tusb_control_request_t* get_ctrl_request(uint8_t daddr) {
+  return &_usbh_epbuf.ctrl_setup[ctrl_xfer_idx(daddr)].request;
+}
+
+static bool enum_new_device(hcd_event_t const* event, uint32_t attach_ms);
+static uint32_t enum_process(uint32_t timeout_ms);
+static void enum_attach_event(hcd_event_t const* event, uint32_t attach_ms);
+static void enum_remove_event(hcd_event_t const* event);
+static void enum_device_removed(uint8_t daddr);
 static void process_removing_device(uint8_t rhport, uint8_t hub_addr, uint8_t hub_port);
 static bool usbh_edpt_control_open(uint8_t dev_addr, uint8_t max_packet_size);
 static bool usbh_control_xfer_cb (uint8_t daddr, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes);
+static uint32_t usbh_timer_process(uint32_t timeout_ms);
 
 TU_ATTR_ALWAYS_INLINE static inline bool queue_event(hcd_event_t const * event, bool in_isr) {
   TU_ASSERT(osal_queue_send(_usbh_q, event, in_isr));
@@ -302,6 +630,43 @@ TU_ATTR_ALWAYS_INLINE static inline bool queue_event(hcd_event_t const * event,
   return true;
 }
 
+#if CFG_TUH_DEFER_POOL_SIZE
+// ISR is not preempted by task, task locks out both ISR and other tasks
+static void usbh_defer_lock(bool in_isr) {
+  if (!in_isr) {
+    (void) osal_mutex_lock(_usbh_mutex, OSAL_TIMEOUT_WAIT_FOREVER);
+    usbh_int_set(false);
+  }
+}
+
+static void usbh_defer_unlock(bool in_isr) {
+  if (!in_isr) {
+    usbh_int_set(true);
+    (void) osal_mutex_unlock(_usbh_mutex);
+  }
+}
+
+// Invoke pending deferred calls, bounded by pool size so that a call re-deferring itself does not starve other events
+static void usbh_defer_run(void) {
+  usbh_defer_lock(false);
+  _usbh_defer.kicked = false;
+  usbh_defer_unlock(false);
+
+  for (uint8_t i = 0; i < CFG_TUH_DEFER_POOL_SIZE; i++) {
+    osal_task_func_t func;
+    void* param;
+    usbh_defer_lock(false);
+    bool const has_call = tu_defer_pool_take(&_usbh_defer, &func, &param);
+    usbh_defer_unlock(false);
+
+    if (!has_call) break;
+    func(param);
+  }
+}
+#else
+  #define usbh_defer_run()
+#endif
+
 //--------------------------------------------------------------------+
 // Device API
 //--------------------------------------------------------------------+
@@ -312,6 +677,11 @@ bool tuh_mounted(uint8_t dev_addr) {
   return dev->configured;
 }
 
+uint16_t tuh_quirks_get(uint8_t dev_addr) {
+  usbh_device_t const *dev = get_device(dev_addr);
+  return dev ? dev->quirks : 0;
+}
+
 bool tuh_vid_pid_get(uint8_t dev_addr, uint16_t *vid, uint16_t *pid) {
   *vid = *pid = 0;
 
@@ -351,10 +721,530 @@ bool tuh_configure(uint8_t rhport, uint32_t cfg_id, const void *cfg_param) {
   return hcd_configure(rhport, cfg_id, cfg_param);
 }
 
+//--------------------------------------------------------------------+
+// Periodic Bandwidth
+// Bus time of periodic endpoints is tracked over a window of 8 frames (64 microframes) for high speed bus and
+// 32 frames for full speed bus (size of OHCI interrupt table). Longer period is accounted as window size.
+//
+// Full/Low speed endpoints behind a high speed hub are also budgeted on the hub's transaction translator (TT): its
+// full speed bus is modeled as 188 bytes per microframe (USB 2.0 11.18.1) over the same 8 frames window. A multi-TT
+// hub is accounted as single TT, which is conservative.
+//--------------------------------------------------------------------+
+enum {
+  BW_SLOT_COUNT        = 64,
+  BW_FRAME_SLOT_COUNT  = 32,
+  BW_UFRAME_LIMIT_NS   = 100000, // 80% of 125 us
+  BW_FRAME_LIMIT_NS    = 900000, // 90% of 1 ms
+  BW_RESERVATION_MAX   = 2*TOTAL_DEVICES,
+  BW_TT_UFRAME_BYTES   = 188,
+  BW_TT_BYTE_NS        = 667,    // full speed byte time
+  BW_TT_FRAME_COUNT    = BW_SLOT_COUNT / 8,
+  BW_TT_COUNT          = CFG_TUH_HUB ? CFG_TUH_HUB : 1
+};
+
+typedef struct {
+  uint8_t daddr; // 0 if free
+  uint8_t ep_addr;
+  uint8_t phase;
+  uint8_t period;
+  uint32_t cost_ns; // per transaction, start-split for split transaction
+
+  // split transaction: phase and period are in frames
+  uint8_t tt;       // TT index + 1, 0 if not split
+  uint8_t smask;    // start-split microframes
+  uint8_t cmask;    // complete-split microframes
+  uint16_t tt_bytes; // full speed bytes on TT
+  uint16_t cs_ns;   // per complete-split
+} usbh_bw_reservation_t;
+
+typedef struct {
+  uint8_t hub_addr; // 0 if free
+  uint8_t load[BW_TT_FRAME_COUNT][8]; // full speed bytes
+} usbh_bw_tt_t;
+
+static struct {
+  bool uframe;
+  uint32_t load_ns[BW_SLOT_COUNT];
+  usbh_bw_reservation_t resv[BW_RESERVATION_MAX];
+  usbh_bw_tt_t tt[BW_TT_COUNT];
+} _usbh_bw;
+
+// high speed transaction bus time of a packet, USB 2.0 spec 5.11.3 including bit stuffing
+TU_ATTR_ALWAYS_INLINE static inline uint32_t bw_hs_packet_ns(bool is_iso, uint32_t len) {
+  return (is_iso ? 633 : 917) + (len * 1944) / 100;
+}
+
+// Transaction bus time estimated with USB 2.0 spec 5.11.3 including bit stuffing, host delay is ignored
+static uint32_t bw_transaction_ns(tusb_desc_endpoint_t const* ep_desc, tusb_speed_t speed) {
+  uint32_t const len = tu_edpt_packet_size(ep_desc);
+  bool const is_iso = (ep_desc->bmAttributes.xfer == TUSB_XFER_ISOCHRONOUS);
+
+  switch (speed) {
+    case TUSB_SPEED_HIGH: {
+      // high bandwidth endpoint has up to 2 additional transactions per microframe
+      uint32_t const count = 1 + ((tu_le16toh(ep_desc->wMaxPacketSize) >> 11) & 0x03);
+      return count * bw_hs_packet_ns(is_iso, len);
+    }
+
+    case TUSB_SPEED_FULL:
+      return (is_iso ? 7268 : 9107) + (len * 7797) / 10;
+
+    default: // low speed
+      return 64060 + len * 6315;
+  }
+}
+
+TU_ATTR_ALWAYS_INLINE static inline void bw_load_update(uint32_t* load, uint32_t cost, bool add) {
+  *load = add ? (*load + cost) : (*load - tu_min32(cost, *load));
+}
+
+// full speed bytes of a split transaction, spread from the microframe after first start-split
+static void bw_tt_update(usbh_bw_reservation_t const* resv, uint8_t frame, bool add) {
+  uint8_t* load = _usbh_bw.tt[resv->tt - 1].load[frame];
+  uint8_t uf = 0;
+  while (!tu_bit_test(resv->smask, uf)) {
+    uf++;
+  }
+  uf++;
+  for (uint16_t remain = resv->tt_bytes; remain > 0 && uf < 8; uf++) {
+    uint8_t const chunk = (uint8_t) tu_min16(remain, BW_TT_UFRAME_BYTES);
+    load[uf] = add ? (uint8_t) (load[uf] + chunk) : (uint8_t) (load[uf] - tu_min8(chunk, load[uf]));
+    remain -= chunk;
+  }
+}
+
+static void bw_update(usbh_bw_reservation_t const* resv, bool add) {
+  if (resv->tt == 0) {
+    uint16_t const window = _usbh_bw.uframe ? BW_SLOT_COUNT : BW_FRAME_SLOT_COUNT;
+    for (uint16_t slot = resv->phase; slot < window; slot += resv->period) {
+      bw_load_update(&_usbh_bw.load_ns[slot], resv->cost_ns, add);
+    }
+  } else {
+    for (uint8_t frame = resv->phase; frame < BW_TT_FRAME_COUNT; frame += resv->period) {
+      for (uint8_t uf = 0; uf < 8; uf++) {
+        if (tu_bit_test(resv->smask, uf)) {
+          bw_load_update(&_usbh_bw.load_ns[frame * 8 + uf], resv->cost_ns, add);
+        }
+        if (tu_bit_test(resv->cmask, uf)) {
+          bw_load_update(&_usbh_bw.load_ns[frame * 8 + uf], resv->cs_ns, add);
+        }
+      }
+      bw_tt_update(resv, frame, add);
+    }
+  }
+}
+
+void hcd_bw_release(uint8_t dev_addr, uint8_t ep_addr) {
+  for (uint8_t i = 0; i < BW_RESERVATION_MAX; i++) {
+    usbh_bw_reservation_t* resv = &_usbh_bw.resv[i];
+    if (resv->daddr != 0 && resv->daddr == dev_addr && (ep_addr == 0 || resv->ep_addr == ep_addr)) {
+      bw_update(resv, false);
+      tu_memclr(resv, sizeof(usbh_bw_reservation_t));
+    }
+  }
+
+  // free TT which has no more reservation
+  for (uint8_t t = 0; t < BW_TT_COUNT; t++) {
+    bool used = false;
+    for (uint8_t i = 0; i < BW_RESERVATION_MAX; i++) {
+      used = used || (_usbh_bw.resv[i].tt == t + 1);
+    }
+    if (!used) {
+      _usbh_bw.tt[t].hub_addr = 0;
+    }
+  }
+}
+
+// release previous reservation of endpoint and get a free one
+static usbh_bw_reservation_t* bw_resv_alloc(uint8_t dev_addr, uint8_t ep_addr) {
+  hcd_bw_release(dev_addr, ep_addr);
+  for (uint8_t i = 0; i < BW_RESERVATION_MAX; i++) {
+    if (_usbh_bw.resv[i].daddr == 0) {
+      return &_usbh_bw.resv[i];
+    }
+  }
+  return NULL;
+}
+
+int16_t hcd_bw_reserve(uint8_t dev_addr, tusb_desc_endpoint_t const* ep_desc, bool uframe, uint16_t period,
+                       uint16_t phase_first, uint16_t phase_count) {
+  uint16_t const window = uframe ? BW_SLOT_COUNT : BW_FRAME_SLOT_COUNT;
+  uint32_t const limit = uframe ? BW_UFRAME_LIMIT_NS : BW_FRAME_LIMIT_NS;
+  TU_ASSERT(period && phase_count, -1);
+
+  usbh_bw_reservation_t* resv = bw_resv_alloc(dev_addr, ep_desc->bEndpointAddress);
+  TU_ASSERT(resv, -1);
+  _usbh_bw.uframe = uframe;
+
+  hcd_devtree_info_t devtree;
+  hcd_devtree_get_info(dev_addr, &devtree);
+  uint32_t const cost_ns = bw_transaction_ns(ep_desc, (tusb_speed_t) devtree.speed);
+
+  period = tu_min16(period, window);
+  phase_count = tu_min16(phase_count, period);
+  phase_first %= period;
+
+  // find phase whose busiest slot is least loaded
+  int16_t best_phase = -1;
+  uint32_t best_load = UINT32_MAX;
+  for (uint16_t i = 0; i < phase_count; i++) {
+    uint16_t const phase = (uint16_t) ((phase_first + i) % period);
+    uint32_t max_load = 0;
+    for (uint16_t slot = phase; slot < window; slot += period) {
+      max_load = tu_max32(max_load, _usbh_bw.load_ns[slot]);
+    }
+
+    if (max_load + cost_ns <= limit && max_load < best_load) {
+      best_load = max_load;
+      best_phase = (int16_t) phase;
+    }
+  }
+
+  if (best_phase < 0) {
+    TU_LOG1("[%u] EP %02X: periodic bandwidth is over-subscribed\r\n", dev_addr, ep_desc->bEndpointAddress);
+    return -1;
+  }
+
+  resv->daddr = dev_addr;
+  resv->ep_addr = ep_desc->bEndpointAddress;
+  resv->phase = (uint8_t) best_phase;
+  resv->period = (uint8_t) period;
+  resv->cost_ns = cost_ns;
+  bw_update(resv, true);
+
+  return best_phase;
+}
+
+// TT of nearest high speed hub upstream of a full/low speed device
+static uint8_t bw_tt_get(uint8_t dev_addr) {
+  hcd_devtree_info_t devtree;
+  hcd_devtree_get_info(dev_addr, &devtree);
+
+  uint8_t hub_addr = devtree.hub_addr;
+  while (hub_addr != 0) {
+    hcd_devtree_get_info(hub_addr, &devtree);
+    if (devtree.speed == TUSB_SPEED_HIGH) {
+      break;
+    }
+    hub_addr = devtree.hub_addr;
+  }
+  TU_VERIFY(hub_addr != 0, 0);
+
+  uint8_t free_tt = 0;
+  for (uint8_t t = 0; t < BW_TT_COUNT; t++) {
+    if (_usbh_bw.tt[t].hub_addr == hub_addr) {
+      return t + 1;
+    }
+    if (free_tt == 0 && _usbh_bw.tt[t].hub_addr == 0) {
+      free_tt = t + 1;
+    }
+  }
+  TU_VERIFY(free_tt != 0, 0);
+
+  tu_memclr(&_usbh_bw.tt[free_tt - 1], sizeof(usbh_bw_tt_t));
+  _usbh_bw.tt[free_tt - 1].hub_addr = hub_addr;
+  return free_tt;
+}
+
+int16_t hcd_bw_reserve_split(uint8_t dev_addr, tusb_desc_endpoint_t const* ep_desc, uint16_t period,
+                             uint16_t phase_first, uint16_t phase_count, uint8_t* smask, uint8_t* cmask) {
+  TU_ASSERT(period && phase_count, -1);
+
+  usbh_bw_reservation_t* resv = bw_resv_alloc(dev_addr, ep_desc->bEndpointAddress);
+  TU_ASSERT(resv, -1);
+  _usbh_bw.uframe = true; // split is only for high speed bus
+
+  uint8_t const tt = bw_tt_get(dev_addr);
+  TU_ASSERT(tt, -1);
+  usbh_bw_tt_t const* p_tt = &_usbh_bw.tt[tt - 1];
+
+  hcd_devtree_info_t devtree;
+  hcd_devtree_get_info(dev_addr, &devtree);
+
+  bool const is_iso = (ep_desc->bmAttributes.xfer == TUSB_XFER_ISOCHRONOUS);
+  bool const is_in = (tu_edpt_dir(ep_desc->bEndpointAddress) == TUSB_DIR_IN);
+  uint16_t const mps = tu_edpt_packet_size(ep_desc);
+  uint32_t const fs_bytes = tu_div_ceil(bw_transaction_ns(ep_desc, (tusb_speed_t) devtree.speed), BW_TT_BYTE_NS);
+  uint8_t const fs_uframes = (uint8_t) tu_div_ceil(fs_bytes, BW_TT_UFRAME_BYTES);
+
+  // EHCI 4.12.3: start-split in microframe Y, full speed transaction starts in Y+1
+  // - interrupt: complete-splits in Y+2 .. Y+n+3 to catch transaction wherever it finishes
+  // - isochronous OUT: one start-split per 188 bytes and no complete-split
+  // - isochronous IN: complete-splits in Y+2 .. Y+n+1
+  uint8_t ss_count, cs_first, cs_count;
+  uint32_t ss_ns, cs_ns;
+  if (!is_iso) {
+    ss_count = 1;
+    cs_first = 2;
+    cs_count = (uint8_t) (fs_uframes + 2);
+    ss_ns = bw_hs_packet_ns(false, is_in ? 0 : mps);
+    cs_ns = bw_hs_packet_ns(false, is_in ? mps : 0);
+  } else if (!is_in) {
+    ss_count = fs_uframes;
+    cs_first = cs_count = 0;
+    ss_ns = bw_hs_packet_ns(true, tu_min16(mps, BW_TT_UFRAME_BYTES));
+    cs_ns = 0;
+  } else {
+    ss_count = 1;
+    cs_first = 2;
+    cs_count = fs_uframes;
+    ss_ns = bw_hs_packet_ns(true, 0);
+    cs_ns = bw_hs_packet_ns(true, tu_min16(mps, BW_TT_UFRAME_BYTES));
+  }
+
+  // microframes used within frame: start-splits, complete-splits and full speed transaction
+  uint8_t const span = (uint8_t) tu_max32(tu_max32(ss_count, cs_count ? (cs_first + cs_count) : 0), fs_uframes + 1);
+  TU_VERIFY(fs_bytes <= 7 * BW_TT_UFRAME_BYTES && span <= 8, -1);
+
+  period = tu_min16(period, BW_TT_FRAME_COUNT);
+  phase_count = tu_min16(phase_count, period);
+  phase_first %= period;
+
+  // find frame and start microframe whose busiest TT microframe is least loaded
+  int16_t best_phase = -1;
+  uint8_t best_uf = 0;
+  uint16_t best_load = UINT16_MAX;
+  for (uint16_t i = 0; i < phase_count; i++) {
+    uint8_t const phase = (uint8_t) ((phase_first + i) % period);
+    for (uint8_t y = 0; y + span <= 8; y++) {
+      uint16_t max_load = 0;
+      bool fit = true;
+      for (uint16_t frame = phase; fit && frame < BW_TT_FRAME_COUNT; frame += period) {
+        uint32_t remain = fs_bytes;
+        for (uint8_t uf = y + 1; remain > 0; uf++) {
+          uint16_t const chunk = (uint16_t) tu_min32(remain, BW_TT_UFRAME_BYTES);
+          uint16_t const load = p_tt->load[frame][uf] + chunk;
+          fit = fit && (load <= BW_TT_UFRAME_BYTES);
+          max_load = tu_max16(max_load, load);
+          remain -= chunk;
+        }
+
+        for (uint8_t uf = 0; uf < 8; uf++) {
+          uint32_t cost = 0;
+          if (uf >= y && uf < y + ss_count) {
+            cost += ss_ns;
+          }
+          if (cs_count && uf >= y + cs_first && uf < y + cs_first + cs_count) {
+            cost += cs_ns;
+          }
+          fit = fit && (_usbh_bw.load_ns[frame * 8 + uf] + cost <= BW_UFRAME_LIMIT_NS);
+        }
+      }
+
+      if (fit && max_load < best_load) {
+        best_load = max_load;
+        best_phase = (int16_t) phase;
+        best_uf = y;
+      }
+    }
+  }
+
+  if (best_phase < 0) {
+    TU_LOG1("[%u] EP %02X: TT bandwidth is over-subscribed\r\n", dev_addr, ep_desc->bEndpointAddress);
+    return -1;
+  }
+
+  resv->daddr = dev_addr;
+  resv->ep_addr = ep_desc->bEndpointAddress;
+  resv->phase = (uint8_t) best_phase;
+  resv->period = (uint8_t) period;
+  resv->cost_ns = ss_ns;
+  resv->tt = tt;
+  resv->smask = (uint8_t) (((1u << ss_count) - 1) << best_uf);
+  resv->cmask = (uint8_t) (((1u << cs_count) - 1) << (best_uf + cs_first));
+  resv->tt_bytes = (uint16_t) fs_bytes;
+  resv->cs_ns = (uint16_t) cs_ns;
+  bw_update(resv, true);
+
+  if (smask) {
+    *smask = resv->smask;
+  }
+  if (cmask) {
+    *cmask = resv->cmask;
+  }
+
+  return best_phase;
+}
+
+//--------------------------------------------------------------------+
+// Endpoint table
+//--------------------------------------------------------------------+
+#if CFG_TUH_ENDPOINT_POOL
+static usbh_edpt_t _usbh_edpt_pool[CFG_TUH_ENDPOINT_POOL];
+#endif
+
+// get state of opened endpoint, NULL if not available. Control endpoint is not in pool
+static usbh_edpt_t* get_edpt(uint8_t daddr, uint8_t ep_addr) {
+#if CFG_TUH_ENDPOINT_POOL
+  for (uint8_t i = 0; i < CFG_TUH_ENDPOINT_POOL; i++) {
+    usbh_edpt_t* ep = &_usbh_edpt_pool[i];
+    if (ep->daddr == daddr && ep->ep_addr == ep_addr) {
+      return ep;
+    }
+  }
+  return NULL;
+#else
+  usbh_device_t* dev = get_device(daddr);
+  uint8_t const epnum = tu_edpt_number(ep_addr);
+  TU_VERIFY(dev && epnum < CFG_TUH_ENDPOINT_MAX, NULL);
+  return &dev->ep[epnum][tu_edpt_dir(ep_addr)];
+#endif
+}
+
+// get endpoint state, allocate it from pool if not opened yet
+static usbh_edpt_t* edpt_alloc(uint8_t daddr, uint8_t ep_addr) {
+  usbh_edpt_t* ep = get_edpt(daddr, ep_addr);
+#if CFG_TUH_ENDPOINT_POOL
+  if (ep == NULL && daddr != 0 && tu_edpt_number(ep_addr) != 0) {
+    ep = get_edpt(0, 0); // free entry
+    if (ep) {
+      tu_memclr(ep, sizeof(usbh_edpt_t));
+      ep->daddr = daddr;
+      ep->ep_addr = ep_addr;
+      ep->drv_id = TUSB_INDEX_INVALID_8;
+    }
+  }
+#endif
+  return ep;
+}
+
+//--------------------------------------------------------------------+
+// Endpoint transfer queue
+//--------------------------------------------------------------------+
+#if CFG_TUH_EDPT_XFER_QUEUE
+typedef struct {
+  uint8_t daddr;
+  uint8_t ep_addr;
+  uint16_t buflen;
+  uint8_t* buffer;
+  tuh_xfer_cb_t complete_cb;
+  uintptr_t user_data;
+} usbh_urb_t;
+
+// queued transfers in submission order, protected by usbh mutex
+static struct {
+  uint8_t count;
+  usbh_urb_t urb[CFG_TUH_EDPT_XFER_QUEUE];
+} _usbh_urbq;
+
+// remove matching transfers: ep_addr = 0 for all endpoints of device. Return true if any removed
+static bool urbq_remove(uint8_t daddr, uint8_t ep_addr, usbh_urb_t* first) {
+  uint8_t count = 0;
+  bool found = false;
+  for (uint8_t i = 0; i < _usbh_urbq.count; i++) {
+    usbh_urb_t const* urb = &_usbh_urbq.urb[i];
+    bool const match = (urb->daddr == daddr) && (ep_addr == 0 || urb->ep_addr == ep_addr);
+    if (match && !(found && first)) {
+      if (first) {
+        (*first) = (*urb);
+      }
+      found = true;
+    } else {
+      _usbh_urbq.urb[count++] = (*urb);
+    }
+  }
+  _usbh_urbq.count = count;
+  return found;
+}
+
+// queue transfer if endpoint is busy, return false if endpoint is available (or queue is full)
+static bool edpt_xfer_enqueue(tuh_xfer_t const* xfer) {
+  usbh_edpt_t* ep = get_edpt(xfer->daddr, xfer->ep_addr);
+  TU_VERIFY(ep);
+
+  (void) osal_mutex_lock(_usbh_mutex, OSAL_TIMEOUT_WAIT_FOREVER);
+  bool const queued = (ep->state.busy || ep->state.claimed) && (_usbh_urbq.count < CFG_TUH_EDPT_XFER_QUEUE);
+  if (queued) {
+    usbh_urb_t* urb = &_usbh_urbq.urb[_usbh_urbq.count++];
+    urb->daddr = xfer->daddr;
+    urb->ep_addr = xfer->ep_addr;
+    urb->buflen = (uint16_t) xfer->buflen;
+    urb->buffer = xfer->buffer;
+    urb->complete_cb = xfer->complete_cb;
+    urb->user_data = xfer->user_data;
+  }
+  (void) osal_mutex_unlock(_usbh_mutex);
+
+  return queued;
+}
+
+// on transfer complete: submit next queued transfer of endpoint, or mark it as available
+static void edpt_xfer_next(uint8_t daddr, uint8_t ep_addr, usbh_edpt_t* ep) {
+  while (1) {
+    usbh_urb_t urb;
+
+    (void) osal_mutex_lock(_usbh_mutex, OSAL_TIMEOUT_WAIT_FOREVER);
+    bool const has_next = urbq_remove(daddr, ep_addr, &urb);
+    ep->state.busy = 0;
+    ep->state.claimed = has_next ? 1 : 0; // keep claimed so that new transfer is queued after this one
+    (void) osal_mutex_unlock(_usbh_mutex);
+
+    if (!has_next || usbh_edpt_xfer_with_callback(daddr, ep_addr, urb.buffer, urb.buflen, urb.complete_cb, urb.user_data)) {
+      return;
+    }
+
+    // failed to submit, complete it and try next one
+    tuh_xfer_t xfer = {
+        .daddr       = daddr,
+        .ep_addr     = ep_addr,
+        .result      = XFER_RESULT_FAILED,
+        .actual_len  = 0,
+        .buflen      = urb.buflen,
+        .buffer      = urb.buffer,
+        .complete_cb = urb.complete_cb,
+        .user_data   = urb.user_data
+    };
+    urb.complete_cb(&xfer);
+  }
+}
+#endif
+
 static void clear_device(usbh_device_t* dev) {
+  tu_capture_dev_close(dev->rhport, true, (uint8_t) (dev - _usbh_devices + 1));
+  tu_bridge_dev_close(true, (uint8_t) (dev - _usbh_devices + 1));
   tu_memclr(dev, sizeof(usbh_device_t));
   memset(dev->itf2drv, TUSB_INDEX_INVALID_8, sizeof(dev->itf2drv)); // invalid mapping
-  memset(dev->ep2drv , TUSB_INDEX_INVALID_8, sizeof(dev->ep2drv )); // invalid mapping
+
+#if CFG_TUH_ENDPOINT_POOL || CFG_TUH_EDPT_XFER_QUEUE
+  uint8_t const daddr = (uint8_t) (dev - _usbh_devices + 1);
+#endif
+
+#if CFG_TUH_EDPT_XFER_QUEUE
+  (void) osal_mutex_lock(_usbh_mutex, OSAL_TIMEOUT_WAIT_FOREVER);
+  (void) urbq_remove(daddr, 0, NULL);
+  (void) osal_mutex_unlock(_usbh_mutex);
+#endif
+
+#if CFG_TUH_ENDPOINT_POOL
+  for (uint8_t i = 0; i < CFG_TUH_ENDPOINT_POOL; i++) {
+    if (_usbh_edpt_pool[i].daddr == daddr) {
+      tu_memclr(&_usbh_edpt_pool[i], sizeof(usbh_edpt_t));
+    }
+  }
+#else
+  for (uint8_t epnum = 0; epnum < CFG_TUH_ENDPOINT_MAX; epnum++) {
+    dev->ep[epnum][0].drv_id = TUSB_INDEX_INVALID_8; // invalid mapping
+    dev->ep[epnum][1].drv_id = TUSB_INDEX_INVALID_8;
+  }
+#endif
+}
+
+// bind all endpoints of interface(s) to driver
+static bool edpt_bind_driver(uint8_t daddr, tusb_desc_interface_t const* desc_itf, uint16_t desc_len, uint8_t drv_id) {
+  uint8_t const* p_desc = (uint8_t const*) desc_itf;
+  uint8_t const* desc_end = p_desc + desc_len;
+
+  while (p_desc < desc_end) {
+    if (TUSB_DESC_ENDPOINT == tu_desc_type(p_desc)) {
+      uint8_t const ep_addr = ((tusb_desc_endpoint_t const*) p_desc)->bEndpointAddress;
+      usbh_edpt_t* ep = edpt_alloc(daddr, ep_addr);
+      TU_ASSERT(ep);
+      ep->drv_id = drv_id;
+    }
+    p_desc = tu_desc_next(p_desc);
+  }
+
+  return true;
 }
 
 bool tuh_inited(void) {
@@ -393,10 +1283,24 @@ bool tuh_rhport_init(uint8_t rhport, const tusb_rhport_init_t* rh_init) {
       _app_driver = usbh_app_driver_get_cb(&_app_driver_count);
     }
 
+#if CFG_TUSB_DEBUG
+    // binary search requires sorted device ID table
+    for (uint16_t i = 1; i < DEVICE_ID_COUNT; i++) {
+      TU_ASSERT(usbh_device_ids[i-1].vid < usbh_device_ids[i].vid ||
+                (usbh_device_ids[i-1].vid == usbh_device_ids[i].vid && usbh_device_ids[i-1].pid <= usbh_device_ids[i].pid));
+    }
+#endif
+
     // Device
     tu_memclr(&_dev0, sizeof(_dev0));
     tu_memclr(_usbh_devices, sizeof(_usbh_devices));
-    tu_memclr(&_ctrl_xfer, sizeof(_ctrl_xfer));
+    tu_memclr(_ctrl_xfer, sizeof(_ctrl_xfer));
+    tu_memclr(&_usbh_bw, sizeof(_usbh_bw));
+    tu_memclr(_usbh_timer, sizeof(_usbh_timer));
+#if CFG_TUH_DEFER_POOL_SIZE
+    tu_memclr(_usbh_defer_entries, sizeof(_usbh_defer_entries));
+    _usbh_defer.kicked = false;
+#endif
 
     for (uint8_t i = 0; i < TOTAL_DEVICES; i++) {
       clear_device(&_usbh_devices[i]);
@@ -488,57 +1392,29 @@ void tuh_task_ext(uint32_t timeout_ms, bool in_isr) {
 
   // Loop until there is no more events in the queue
   while (1) {
+    // run expired timers, resume enumeration whose delay has expired or start pending ones, do not wait for events
+    // longer than the remaining delay
+    uint32_t const wait_ms = enum_process(usbh_timer_process(timeout_ms));
+
     hcd_event_t event;
-    if (!osal_queue_receive(_usbh_q, &event, timeout_ms)) return;
+    _usbh_in_task = false;
+    if (!osal_queue_receive(_usbh_q, &event, wait_ms)) return;
+    _usbh_in_task = true;
 
     switch (event.event_id) {
       case HCD_EVENT_DEVICE_ATTACH:
-        // due to the shared control buffer, we must complete enumerating one device before enumerating another one.
-        // TODO better to have an separated queue for newly attached devices
-        if (_dev0.enumerating) {
-          // Some device can cause multiple duplicated attach events
-          // drop current enumerating and start over for a proper port reset
-          if (event.rhport == _dev0.rhport && event.connection.hub_addr == _dev0.hub_addr &&
-              event.connection.hub_port == _dev0.hub_port) {
-            // abort/cancel current enumeration and start new one
-            TU_LOG1("[%u:] USBH Device Attach (duplicated)\r\n", event.rhport);
-            tuh_edpt_abort_xfer(0, 0);
-            enum_new_device(&event);
-          } else {
-            TU_LOG_USBH("[%u:] USBH Defer Attach until current enumeration complete\r\n", event.rhport);
-
-            bool is_empty = osal_queue_empty(_usbh_q);
-            queue_event(&event, in_isr);
-
-            if (is_empty) {
-              // Exit if this is the only event in the queue, otherwise we may loop forever
-              return;
-            }
-          }
-        } else {
-          TU_LOG1("[%u:] USBH Device Attach\r\n", event.rhport);
-          _dev0.enumerating = 1;
-          enum_new_device(&event);
-        }
+        enum_attach_event(&event, tusb_time_millis_api());
         break;
 
       case HCD_EVENT_DEVICE_REMOVE:
         TU_LOG_USBH("[%u:%u:%u] USBH DEVICE REMOVED\r\n", event.rhport, event.connection.hub_addr, event.connection.hub_port);
+        enum_remove_event(&event);
         process_removing_device(event.rhport, event.connection.hub_addr, event.connection.hub_port);
-
-        #if CFG_TUH_HUB
-        // TODO remove
-        if (event.connection.hub_addr != 0 && event.connection.hub_port != 0) {
-          // done with hub, waiting for next data on status pipe
-          (void) hub_edpt_status_xfer(event.connection.hub_addr);
-        }
-        #endif
         break;
 
       case HCD_EVENT_XFER_COMPLETE: {
         uint8_t const ep_addr = event.xfer_complete.ep_addr;
         uint8_t const epnum = tu_edpt_number(ep_addr);
-        uint8_t const ep_dir = (uint8_t) tu_edpt_dir(ep_addr);
 
         TU_LOG_USBH("on EP %02X with %u bytes: %s\r\n", ep_addr, (unsigned int) event.xfer_complete.len, tu_str_xfer_result[event.xfer_complete.result]);
 
@@ -550,16 +1426,28 @@ void tuh_task_ext(uint32_t timeout_ms, bool in_isr) {
           usbh_device_t* dev = get_device(event.dev_addr);
           TU_VERIFY(dev && dev->connected,);
 
-          dev->ep_status[epnum][ep_dir].busy = 0;
-          dev->ep_status[epnum][ep_dir].claimed = 0;
-
           if (0 == epnum) {
             usbh_control_xfer_cb(event.dev_addr, ep_addr, (xfer_result_t) event.xfer_complete.result, event.xfer_complete.len);
           } else {
+            usbh_edpt_t* ep = get_edpt(event.dev_addr, ep_addr);
+            TU_VERIFY(ep,);
+
+            #if CFG_TUH_API_EDPT_XFER
+            tuh_xfer_cb_t const complete_cb = ep->complete_cb;
+            uintptr_t const user_data = ep->user_data;
+            #endif
+
+            #if CFG_TUH_EDPT_XFER_QUEUE
+            // submit next queued transfer first to keep endpoint busy while callback is processed
+            edpt_xfer_next(event.dev_addr, ep_addr, ep);
+            #else
+            ep->state.busy = 0;
+            ep->state.claimed = 0;
+            #endif
+
             // Prefer application callback over built-in one if available. This occurs when tuh_edpt_xfer() is used
             // with enabled driver e.g HID endpoint
             #if CFG_TUH_API_EDPT_XFER
-            tuh_xfer_cb_t const complete_cb = dev->ep_callback[epnum][ep_dir].complete_cb;
             if ( complete_cb ) {
               // re-construct xfer info
               tuh_xfer_t xfer = {
@@ -570,18 +1458,19 @@ void tuh_task_ext(uint32_t timeout_ms, bool in_isr) {
                   .buflen      = 0,    // not available
                   .buffer      = NULL, // not available
                   .complete_cb = complete_cb,
-                  .user_data   = dev->ep_callback[epnum][ep_dir].user_data
+                  .user_data   = user_data
               };
               complete_cb(&xfer);
             }else
             #endif
             {
-              uint8_t drv_id = dev->ep2drv[epnum][ep_dir];
-              usbh_class_driver_t const* driver = get_driver(drv_id);
+              usbh_class_driver_t const* driver = get_driver(ep->drv_id);
               if (driver) {
                 TU_LOG_USBH("%s xfer callback\r\n", driver->name);
+                uint32_t const ts = usbh_stats_timestamp();
                 driver->xfer_cb(event.dev_addr, ep_addr, (xfer_result_t) event.xfer_complete.result,
                                 event.xfer_complete.len);
+                usbh_stats_driver(ep->drv_id, ts);
               } else {
                 // no driver/callback responsible for this transfer
                 TU_ASSERT(false,);
@@ -593,7 +1482,11 @@ void tuh_task_ext(uint32_t timeout_ms, bool in_isr) {
       }
 
       case USBH_EVENT_FUNC_CALL:
-        if (event.func_call.func) event.func_call.func(event.func_call.param);
+        if (event.func_call.func) {
+          event.func_call.func(event.func_call.param);
+        } else {
+          usbh_defer_run();
+        }
         break;
 
       default:
@@ -611,12 +1504,92 @@ void tuh_task_ext(uint32_t timeout_ms, bool in_isr) {
 // Control transfer
 //--------------------------------------------------------------------+
 
-static void _control_blocking_complete_cb(tuh_xfer_t* xfer) {
-  // update result
-  *((xfer_result_t*) xfer->user_data) = xfer->result;
+//--------------------------------------------------------------------+
+// Completion Token
+//--------------------------------------------------------------------+
+void tuh_xfer_token_init(tuh_xfer_token_t* token, tuh_xfer_token_notify_t notify, void* notify_arg) {
+  token->result = XFER_RESULT_INVALID;
+  token->actual_len = 0;
+  token->notify = notify;
+  token->notify_arg = notify_arg;
+  token->sem = NULL;
+#if CFG_TUSB_OS != OPT_OS_NONE
+  // usbh task must keep running tuh_task() to complete transfer, other threads can sleep
+  if (notify == NULL && !_usbh_in_task) {
+    token->sem = osal_semaphore_create(&token->semdef);
+  }
+#endif
+}
+
+static void token_sem_delete(tuh_xfer_token_t* token) {
+#if CFG_TUSB_OS != OPT_OS_NONE
+  if (token->sem) {
+    (void) osal_semaphore_delete(token->sem);
+    token->sem = NULL;
+  }
+#else
+  (void) token;
+#endif
+}
+
+void tuh_xfer_token_complete(tuh_xfer_token_t* token, xfer_result_t result, uint32_t actual_len) {
+  token->actual_len = actual_len;
+  token->result = result;
+  if (token->notify) {
+    token->notify(token);
+  } else if (token->sem) {
+    (void) osal_semaphore_post(token->sem, false);
+  }
+}
+
+void tuh_xfer_token_cb(tuh_xfer_t* xfer) {
+  tuh_xfer_token_complete((tuh_xfer_token_t*) xfer->user_data, xfer->result, xfer->actual_len);
+}
+
+bool tuh_xfer_token_wait(tuh_xfer_token_t* token, uint32_t timeout_ms) {
+  uint32_t const start_ms = timeout_ms ? tusb_time_millis_api() : 0;
+
+  while (token->result == XFER_RESULT_INVALID) {
+    uint32_t wait_ms = OSAL_TIMEOUT_WAIT_FOREVER;
+    if (timeout_ms) {
+      uint32_t const elapsed = tusb_time_millis_api() - start_ms;
+      if (elapsed >= timeout_ms) {
+        return false;
+      }
+      wait_ms = timeout_ms - elapsed;
+    }
+
+    if (token->sem) {
+      (void) osal_semaphore_wait(token->sem, wait_ms);
+    } else if (tuh_task_event_ready()) {
+      // Note: this can be called within an callback ie. part of tuh_task()
+      // therefore event with RTOS tuh_task() still need to be invoked
+      tuh_task();
+    }
+  }
+
+  token_sem_delete(token);
+  return true;
+}
+
+//--------------------------------------------------------------------+
+// Blocking transfer
+//--------------------------------------------------------------------+
+#if CFG_TUH_API_EDPT_XFER
+static void _blocking_aborted_cb(tuh_xfer_t* xfer) {
+  (void) xfer;
+}
+#endif
+
+// update transfer result as blocking transfer complete, user_data is expected to point to xfer_result_t
+static void _blocking_complete(tuh_xfer_t* xfer, tuh_xfer_token_t const* ctx) {
+  if (xfer->user_data != 0) {
+    *((xfer_result_t*) xfer->user_data) = ctx->result;
+  }
+  xfer->result     = ctx->result;
+  xfer->actual_len = ctx->actual_len;
 }
 
-// TODO timeout_ms is not supported yet
 bool tuh_control_xfer (tuh_xfer_t* xfer) {
   // EP0 with setup packet
   TU_VERIFY(xfer->ep_addr == 0 && xfer->setup);
@@ -630,20 +1603,23 @@ bool tuh_control_xfer (tuh_xfer_t* xfer) {
     TU_VERIFY(dev && dev->connected);
   }
 
+  usbh_ctrl_xfer_t* ctrl = get_ctrl_xfer(daddr);
+  tusb_control_request_t* request = get_ctrl_request(daddr);
+
   // pre-check to help reducing mutex lock
-  TU_VERIFY(_ctrl_xfer.stage == CONTROL_STAGE_IDLE);
+  TU_VERIFY(ctrl->stage == CONTROL_STAGE_IDLE);
   (void) osal_mutex_lock(_usbh_mutex, OSAL_TIMEOUT_WAIT_FOREVER);
 
-  bool const is_idle = (_ctrl_xfer.stage == CONTROL_STAGE_IDLE);
+  bool const is_idle = (ctrl->stage == CONTROL_STAGE_IDLE);
   if (is_idle) {
-    _ctrl_xfer.stage       = CONTROL_STAGE_SETUP;
-    _ctrl_xfer.daddr       = daddr;
-    _ctrl_xfer.actual_len  = 0;
-
-    _ctrl_xfer.buffer      = xfer->buffer;
-    _ctrl_xfer.complete_cb = xfer->complete_cb;
-    _ctrl_xfer.user_data   = xfer->user_data;
-    _usbh_epbuf.request    = (*xfer->setup);
+    ctrl->stage       = CONTROL_STAGE_SETUP;
+    ctrl->daddr       = daddr;
+    ctrl->actual_len  = 0;
+
+    ctrl->buffer      = xfer->buffer;
+    ctrl->complete_cb = xfer->complete_cb;
+    ctrl->user_data   = xfer->user_data;
+    (*request)        = (*xfer->setup);
   }
 
   (void) osal_mutex_unlock(_usbh_mutex);
@@ -655,63 +1631,60 @@ bool tuh_control_xfer (tuh_xfer_t* xfer) {
               (xfer->setup->bmRequestType_bit.type == TUSB_REQ_TYPE_STANDARD && xfer->setup->bRequest <= TUSB_REQ_SYNCH_FRAME) ?
                   tu_str_std_request[xfer->setup->bRequest] : "Class Request");
   TU_LOG_BUF_USBH(xfer->setup, 8);
+  tu_capture_setup(rhport, true, daddr, (uint8_t const*) request);
 
   if (xfer->complete_cb) {
-    TU_ASSERT( hcd_setup_send(rhport, daddr, (uint8_t const*) &_usbh_epbuf.request) );
+    TU_ASSERT( hcd_setup_send(rhport, daddr, (uint8_t const*) request) );
   }else {
     // blocking if complete callback is not provided
-    // change callback to internal blocking, and result as user argument
-    volatile xfer_result_t result = XFER_RESULT_INVALID;
-
-    // use user_data to point to xfer_result_t
-    _ctrl_xfer.user_data   = (uintptr_t) &result;
-    _ctrl_xfer.complete_cb = _control_blocking_complete_cb;
-
-    TU_ASSERT( hcd_setup_send(rhport, daddr, (uint8_t*) &_usbh_epbuf.request) );
-
-    while (result == XFER_RESULT_INVALID) {
-      // Note: this can be called within an callback ie. part of tuh_task()
-      // therefore event with RTOS tuh_task() still need to be invoked
-      if (tuh_task_event_ready()) {
-        tuh_task();
-      }
-      // TODO probably some timeout to prevent hanged
+    // change callback to internal blocking, and blocking context as user argument
+    tuh_xfer_token_t ctx;
+    tuh_xfer_token_init(&ctx, NULL, NULL);
+
+    ctrl->user_data   = (uintptr_t) &ctx;
+    ctrl->complete_cb = tuh_xfer_token_cb;
+
+    TU_ASSERT( hcd_setup_send(rhport, daddr, (uint8_t const*) request) );
+
+    if (!tuh_xfer_token_wait(&ctx, xfer->timeout_ms)) {
+      // cancel transfer, late completion must not reach the context on stack
+      TU_LOG1("[%u:%u] Control transfer timed out\r\n", rhport, daddr);
+      (void) tuh_edpt_abort_xfer(daddr, 0);
+      ctrl->complete_cb = NULL;
+      token_sem_delete(&ctx);
+      ctx.result = XFER_RESULT_TIMEOUT;
     }
 
-    // update transfer result, user_data is expected to point to xfer_result_t
-    if (xfer->user_data != 0) {
-      *((xfer_result_t*) xfer->user_data) = result;
-    }
-    xfer->result     = result;
-    xfer->actual_len = _ctrl_xfer.actual_len;
+    _blocking_complete(xfer, &ctx);
   }
 
   return true;
 }
 
-TU_ATTR_ALWAYS_INLINE static inline void _set_control_xfer_stage(uint8_t stage) {
+TU_ATTR_ALWAYS_INLINE static inline void _set_control_xfer_stage(usbh_ctrl_xfer_t* ctrl, uint8_t stage) {
   (void) osal_mutex_lock(_usbh_mutex, OSAL_TIMEOUT_WAIT_FOREVER);
-  _ctrl_xfer.stage = stage;
+  ctrl->stage = stage;
   (void) osal_mutex_unlock(_usbh_mutex);
 }
 
 static void _control_xfer_complete(uint8_t daddr, xfer_result_t result) {
   TU_LOG_USBH("\r\n");
+  usbh_ctrl_xfer_t* ctrl = get_ctrl_xfer(daddr);
 
   // duplicate xfer since user can execute control transfer within callback
-  tusb_control_request_t const request = _usbh_epbuf.request;
+  tusb_control_request_t const request = *get_ctrl_request(daddr);
   tuh_xfer_t xfer_temp = {
     .daddr       = daddr,
     .ep_addr     = 0,
     .result      = result,
     .setup       = &request,
-    .actual_len  = (uint32_t) _ctrl_xfer.actual_len,
-    .buffer      = _ctrl_xfer.buffer,
-    .complete_cb = _ctrl_xfer.complete_cb,
-    .user_data   = _ctrl_xfer.user_data
+    .actual_len  = (uint32_t) ctrl->actual_len,
+    .buffer      = ctrl->buffer,
+    .complete_cb = ctrl->complete_cb,
+    .user_data   = ctrl->user_data
   };
 
-  _set_control_xfer_stage(CONTROL_STAGE_IDLE);
+  _set_control_xfer_stage(ctrl, CONTROL_STAGE_IDLE);
 
   if (xfer_temp.complete_cb) {
     xfer_temp.complete_cb(&xfer_temp);
@@ -722,7 +1695,8 @@ static bool usbh_control_xfer_cb (uint8_t daddr, uint8_t ep_addr, xfer_result_t
   (void) ep_addr;
 
   const uint8_t rhport = usbh_get_rhport(daddr);
-  tusb_control_request_t const * request = &_usbh_epbuf.request;
+  usbh_ctrl_xfer_t* ctrl = get_ctrl_xfer(daddr);
+  tusb_control_request_t const * request = get_ctrl_request(daddr);
 
   if (XFER_RESULT_SUCCESS != result) {
     TU_LOG_USBH("[%u:%u] Control %s, xferred_bytes = %" PRIu32 "\r\n", rhport, daddr, result == XFER_RESULT_STALLED ? "STALLED" : "FAILED", xferred_bytes);
@@ -731,12 +1705,14 @@ static bool usbh_control_xfer_cb (uint8_t daddr, uint8_t ep_addr, xfer_result_t
     // terminate transfer if any stage failed
     _control_xfer_complete(daddr, result);
   }else {
-    switch(_ctrl_xfer.stage) {
+    switch(ctrl->stage) {
       case CONTROL_STAGE_SETUP:
         if (request->wLength) {
           // DATA stage: initial data toggle is always 1
-          _set_control_xfer_stage(CONTROL_STAGE_DATA);
-          TU_ASSERT( hcd_edpt_xfer(rhport, daddr, tu_edpt_addr(0, request->bmRequestType_bit.direction), _ctrl_xfer.buffer, request->wLength) );
+          _set_control_xfer_stage(ctrl, CONTROL_STAGE_DATA);
+          tu_capture_xfer_submit(rhport, true, daddr, tu_edpt_addr(0, request->bmRequestType_bit.direction),
+                                 ctrl->buffer, request->wLength);
+          TU_ASSERT( hcd_edpt_xfer(rhport, daddr, tu_edpt_addr(0, request->bmRequestType_bit.direction), ctrl->buffer, request->wLength) );
           return true;
         }
         TU_ATTR_FALLTHROUGH;
@@ -744,13 +1720,14 @@ static bool usbh_control_xfer_cb (uint8_t daddr, uint8_t ep_addr, xfer_result_t
       case CONTROL_STAGE_DATA:
         if (request->wLength) {
           TU_LOG_USBH("[%u:%u] Control data:\r\n", rhport, daddr);
-          TU_LOG_MEM_USBH(_ctrl_xfer.buffer, xferred_bytes, 2);
+          TU_LOG_MEM_USBH(ctrl->buffer, xferred_bytes, 2);
         }
 
-        _ctrl_xfer.actual_len = (uint16_t) xferred_bytes;
+        ctrl->actual_len = (uint16_t) xferred_bytes;
 
         // ACK stage: toggle is always 1
-        _set_control_xfer_stage(CONTROL_STAGE_ACK);
+        _set_control_xfer_stage(ctrl, CONTROL_STAGE_ACK);
+        tu_capture_xfer_submit(rhport, true, daddr, tu_edpt_addr(0, 1 - request->bmRequestType_bit.direction), NULL, 0);
         TU_ASSERT( hcd_edpt_xfer(rhport, daddr, tu_edpt_addr(0, 1 - request->bmRequestType_bit.direction), NULL, 0) );
         break;
 
@@ -785,8 +1762,44 @@ bool tuh_edpt_xfer(tuh_xfer_t* xfer) {
   uint8_t const ep_addr = xfer->ep_addr;
 
   TU_VERIFY(daddr && ep_addr);
+
+#if CFG_TUH_EDPT_XFER_QUEUE
+  if (xfer->complete_cb && edpt_xfer_enqueue(xfer)) {
+    return true;
+  }
+#endif
+
   TU_VERIFY(usbh_edpt_claim(daddr, ep_addr));
 
+#if CFG_TUH_API_EDPT_XFER
+  if (xfer->complete_cb == NULL) {
+    // blocking
+    tuh_xfer_token_t ctx;
+    tuh_xfer_token_init(&ctx, NULL, NULL);
+
+    if (!usbh_edpt_xfer_with_callback(daddr, ep_addr, xfer->buffer, (uint16_t) xfer->buflen,
+                                      tuh_xfer_token_cb, (uintptr_t) &ctx)) {
+      usbh_edpt_release(daddr, ep_addr);
+      token_sem_delete(&ctx);
+      return false;
+    }
+
+    if (!tuh_xfer_token_wait(&ctx, xfer->timeout_ms)) {
+      TU_LOG1("[%u] Transfer on EP %02X timed out\r\n", daddr, ep_addr);
+      (void) tuh_edpt_abort_xfer(daddr, ep_addr);
+      usbh_edpt_t* ep = get_edpt(daddr, ep_addr);
+      if (ep) {
+        ep->complete_cb = _blocking_aborted_cb; // late completion must not reach the context on stack
+      }
+      token_sem_delete(&ctx);
+      ctx.result = XFER_RESULT_TIMEOUT;
+    }
+
+    _blocking_complete(xfer, &ctx);
+    return true;
+  }
+#endif
+
   if (!usbh_edpt_xfer_with_callback(daddr, ep_addr, xfer->buffer, (uint16_t) xfer->buflen,
                                     xfer->complete_cb, xfer->user_data)) {
     usbh_edpt_release(daddr, ep_addr);
@@ -800,26 +1813,34 @@ bool tuh_edpt_abort_xfer(uint8_t daddr, uint8_t ep_addr) {
   TU_LOG_USBH("[%u] Aborted transfer on EP %02X\r\n", daddr, ep_addr);
 
   const uint8_t epnum = tu_edpt_number(ep_addr);
-  const uint8_t dir   = tu_edpt_dir(ep_addr);
 
   if (epnum == 0) {
     // Also include dev0 for aborting enumerating
     const uint8_t rhport = usbh_get_rhport(daddr);
 
-    // control transfer: only 1 control at a time, check if we are aborting the current one
-    TU_VERIFY(daddr == _ctrl_xfer.daddr && _ctrl_xfer.stage != CONTROL_STAGE_IDLE);
+    // control transfer: check if we are aborting the current one (only 1 control at a time if not concurrent)
+    usbh_ctrl_xfer_t* ctrl = get_ctrl_xfer(daddr);
+    TU_VERIFY(daddr == ctrl->daddr && ctrl->stage != CONTROL_STAGE_IDLE);
     hcd_edpt_abort_xfer(rhport, daddr, ep_addr);
-    _set_control_xfer_stage(CONTROL_STAGE_IDLE); // reset control transfer state to idle
+    _set_control_xfer_stage(ctrl, CONTROL_STAGE_IDLE); // reset control transfer state to idle
   } else {
     usbh_device_t* dev = get_device(daddr);
-    TU_VERIFY(dev);
+    usbh_edpt_t* ep = get_edpt(daddr, ep_addr);
+    TU_VERIFY(dev && ep);
+
+    #if CFG_TUH_EDPT_XFER_QUEUE
+    // drop queued transfers as well
+    (void) osal_mutex_lock(_usbh_mutex, OSAL_TIMEOUT_WAIT_FOREVER);
+    (void) urbq_remove(daddr, ep_addr, NULL);
+    (void) osal_mutex_unlock(_usbh_mutex);
+    #endif
 
-    TU_VERIFY(dev->ep_status[epnum][dir].busy); // non-control skip if not busy
+    TU_VERIFY(ep->state.busy); // non-control skip if not busy
     hcd_edpt_abort_xfer(dev->rhport, daddr, ep_addr);
 
     // mark as ready and release endpoint if transfer is aborted
-    dev->ep_status[epnum][dir].busy = false;
-    tu_edpt_release(&dev->ep_status[epnum][dir], _usbh_mutex);
+    ep->state.busy = false;
+    tu_edpt_release(&ep->state, _usbh_mutex);
   }
 
   return true;
@@ -838,6 +1859,10 @@ uint8_t *usbh_get_enum_buf(void) {
   return _usbh_epbuf.ctrl;
 }
 
+bool usbh_in_task(void) {
+  return _usbh_in_task;
+}
+
 void usbh_int_set(bool enabled) {
   // TODO all host controller if multiple are used since they shared the same event queue
   if (enabled) {
@@ -848,14 +1873,78 @@ void usbh_int_set(bool enabled) {
 }
 
 void usbh_defer_func(osal_task_func_t func, void *param, bool in_isr) {
+  usbh_defer_func_prio(func, param, TU_DEFER_PRIO_NORMAL, in_isr);
+}
+
+void usbh_defer_func_prio(osal_task_func_t func, void *param, uint8_t prio, bool in_isr) {
   hcd_event_t event = { 0 };
   event.event_id = USBH_EVENT_FUNC_CALL;
+
+#if CFG_TUH_DEFER_POOL_SIZE
+  bool kick = false;
+  usbh_defer_lock(in_isr);
+  bool const pooled = tu_defer_pool_add(&_usbh_defer, func, param, prio, &kick);
+  usbh_defer_unlock(in_isr);
+
+  if (pooled) {
+    // a single event (func = NULL) runs all pending calls
+    if (kick && !queue_event(&event, in_isr)) {
+      usbh_defer_lock(in_isr);
+      _usbh_defer.kicked = false;
+      usbh_defer_unlock(in_isr);
+    }
+    return;
+  }
+  TU_LOG_USBH("Defer pool is full\r\n");
+#else
+  (void) prio;
+#endif
+
+  // pool is full or not used: queue the call itself
   event.func_call.func = func;
   event.func_call.param = param;
-
   queue_event(&event, in_isr);
 }
 
+bool usbh_defer_func_ms(osal_task_func_t func, void *param, uint32_t delay_ms) {
+  usbh_timer_t* timer = NULL;
+  for (uint8_t i = 0; i < USBH_TIMER_MAX; i++) {
+    usbh_timer_t* t = &_usbh_timer[i];
+    if (t->func == func && t->param == param) {
+      timer = t;
+      break;
+    }
+    if (timer == NULL && t->func == NULL) {
+      timer = t;
+    }
+  }
+  TU_ASSERT(timer);
+
+  timer->func = func;
+  timer->param = param;
+  timer->start_ms = tusb_time_millis_api();
+  timer->delay_ms = delay_ms;
+  return true;
+}
+
+// invoke expired timers, return remaining time of the nearest one (bounded by timeout_ms)
+static uint32_t usbh_timer_process(uint32_t timeout_ms) {
+  for (uint8_t i = 0; i < USBH_TIMER_MAX; i++) {
+    usbh_timer_t* t = &_usbh_timer[i];
+    if (t->func != NULL) {
+      uint32_t const elapsed = tusb_time_millis_api() - t->start_ms;
+      if (elapsed >= t->delay_ms) {
+        osal_task_func_t const func = t->func;
+        t->func = NULL; // func may schedule itself again
+        func(t->param);
+      } else {
+        timeout_ms = tu_min32(timeout_ms, t->delay_ms - elapsed);
+      }
+    }
+  }
+  return timeout_ms;
+}
+
 //--------------------------------------------------------------------+
 // Endpoint API
 //--------------------------------------------------------------------+
@@ -865,11 +1954,10 @@ bool usbh_edpt_claim(uint8_t dev_addr, uint8_t ep_addr) {
   // Note: addr0 only use tuh_control_xfer
   usbh_device_t* dev = get_device(dev_addr);
   TU_ASSERT(dev && dev->connected);
+  usbh_edpt_t* ep = get_edpt(dev_addr, ep_addr);
+  TU_ASSERT(ep);
 
-  uint8_t const epnum = tu_edpt_number(ep_addr);
-  uint8_t const dir = tu_edpt_dir(ep_addr);
-
-  TU_VERIFY(tu_edpt_claim(&dev->ep_status[epnum][dir], _usbh_mutex));
+  TU_VERIFY(tu_edpt_claim(&ep->state, _usbh_mutex));
   TU_LOG_USBH("[%u] Claimed EP 0x%02x\r\n", dev_addr, ep_addr);
 
   return true;
@@ -880,11 +1968,10 @@ bool usbh_edpt_release(uint8_t dev_addr, uint8_t ep_addr) {
   // Note: addr0 only use tuh_control_xfer
   usbh_device_t* dev = get_device(dev_addr);
   TU_VERIFY(dev && dev->connected);
+  usbh_edpt_t* ep = get_edpt(dev_addr, ep_addr);
+  TU_VERIFY(ep);
 
-  uint8_t const epnum = tu_edpt_number(ep_addr);
-  uint8_t const dir = tu_edpt_dir(ep_addr);
-
-  TU_VERIFY(tu_edpt_release(&dev->ep_status[epnum][dir], _usbh_mutex));
+  TU_VERIFY(tu_edpt_release(&ep->state, _usbh_mutex));
   TU_LOG_USBH("[%u] Released EP 0x%02x\r\n", dev_addr, ep_addr);
 
   return true;
@@ -898,11 +1985,9 @@ bool usbh_edpt_xfer_with_callback(uint8_t dev_addr, uint8_t ep_addr, uint8_t* bu
   (void) user_data;
 
   usbh_device_t* dev = get_device(dev_addr);
-  TU_VERIFY(dev);
-
-  uint8_t const epnum = tu_edpt_number(ep_addr);
-  uint8_t const dir = tu_edpt_dir(ep_addr);
-  tu_edpt_state_t* ep_state = &dev->ep_status[epnum][dir];
+  usbh_edpt_t* ep = get_edpt(dev_addr, ep_addr);
+  TU_VERIFY(dev && ep);
+  tu_edpt_state_t* ep_state = &ep->state;
 
   TU_LOG_USBH("  Queue EP %02X with %u bytes ... \r\n", ep_addr, total_bytes);
 
@@ -914,10 +1999,11 @@ bool usbh_edpt_xfer_with_callback(uint8_t dev_addr, uint8_t ep_addr, uint8_t* bu
   ep_state->busy = 1;
 
 #if CFG_TUH_API_EDPT_XFER
-  dev->ep_callback[epnum][dir].complete_cb = complete_cb;
-  dev->ep_callback[epnum][dir].user_data   = user_data;
+  ep->complete_cb = complete_cb;
+  ep->user_data   = user_data;
 #endif
 
+  tu_capture_xfer_submit(dev->rhport, true, dev_addr, ep_addr, buffer, total_bytes);
   if (hcd_edpt_xfer(dev->rhport, dev_addr, ep_addr, buffer, total_bytes)) {
     TU_LOG_USBH("OK\r\n");
     return true;
@@ -931,6 +2017,21 @@ bool usbh_edpt_xfer_with_callback(uint8_t dev_addr, uint8_t ep_addr, uint8_t* bu
   }
 }
 
+// Isochronous transfer does not use busy flag: HCD queues transfers and completes them in order
+bool usbh_edpt_iso_xfer(uint8_t dev_addr, uint8_t ep_addr, uint8_t* buffer, hcd_iso_packet_t* packets,
+                        uint16_t n_packets) {
+  usbh_device_t* dev = get_device(dev_addr);
+  usbh_edpt_t* ep = get_edpt(dev_addr, ep_addr);
+  TU_VERIFY(dev && ep && n_packets);
+
+#if CFG_TUH_API_EDPT_XFER
+  ep->complete_cb = NULL;
+  ep->user_data   = 0;
+#endif
+
+  return hcd_edpt_iso_xfer(dev->rhport, dev_addr, ep_addr, buffer, packets, n_packets);
+}
+
 static bool usbh_edpt_control_open(uint8_t dev_addr, uint8_t max_packet_size) {
   TU_LOG_USBH("[%u:%u] Open EP0 with Size = %u\r\n", usbh_get_rhport(dev_addr), dev_addr, max_packet_size);
   tusb_desc_endpoint_t ep0_desc = {
@@ -947,17 +2048,31 @@ static bool usbh_edpt_control_open(uint8_t dev_addr, uint8_t max_packet_size) {
 
 bool tuh_edpt_open(uint8_t dev_addr, tusb_desc_endpoint_t const* desc_ep) {
   TU_ASSERT(tu_edpt_validate(desc_ep, tuh_speed_get(dev_addr)));
+  TU_ASSERT(edpt_alloc(dev_addr, desc_ep->bEndpointAddress));
+  tu_capture_edpt_open(usbh_get_rhport(dev_addr), true, dev_addr, desc_ep->bEndpointAddress, desc_ep->bmAttributes.xfer);
+
+  if (desc_ep->bmAttributes.xfer == TUSB_XFER_INTERRUPT) {
+    // polling interval override: HCD schedules with a copy of descriptor
+    uint8_t interval = tu_max8(tuh_edpt_interval_cb(dev_addr, desc_ep), 1);
+    if (tuh_speed_get(dev_addr) == TUSB_SPEED_HIGH) {
+      interval = tu_min8(interval, 16); // 2^(bInterval-1) microframes
+    }
+    if (interval != desc_ep->bInterval) {
+      TU_LOG_USBH("[%u] EP %02X interval %u -> %u\r\n", dev_addr, desc_ep->bEndpointAddress, desc_ep->bInterval, interval);
+      tusb_desc_endpoint_t ep_desc = *desc_ep;
+      ep_desc.bInterval = interval;
+      return hcd_edpt_open(usbh_get_rhport(dev_addr), dev_addr, &ep_desc);
+    }
+  }
+
   return hcd_edpt_open(usbh_get_rhport(dev_addr), dev_addr, desc_ep);
 }
 
 bool usbh_edpt_busy(uint8_t dev_addr, uint8_t ep_addr) {
-  usbh_device_t* dev = get_device(dev_addr);
-  TU_VERIFY(dev);
+  usbh_edpt_t* ep = get_edpt(dev_addr, ep_addr);
+  TU_VERIFY(ep);
 
-  uint8_t const epnum = tu_edpt_number(ep_addr);
-  uint8_t const dir = tu_edpt_dir(ep_addr);
-
-  return dev->ep_status[epnum][dir].busy;
+  return ep->state.busy;
 }
 
 //--------------------------------------------------------------------+
@@ -992,6 +2107,11 @@ TU_ATTR_FAST_FUNC void hcd_event_handler(hcd_event_t const* event, bool in_isr)
       }
       break;
 
+    case HCD_EVENT_XFER_COMPLETE:
+      tu_capture_xfer_complete(event->rhport, true, event->dev_addr, event->xfer_complete.ep_addr,
+                               (xfer_result_t) event->xfer_complete.result, event->xfer_complete.len);
+      break;
+
     default: break;
   }
 
@@ -1157,6 +2277,35 @@ bool tuh_interface_set(uint8_t daddr, uint8_t itf_num, uint8_t itf_alt,
   return tuh_control_xfer(&xfer);
 }
 
+bool tuh_edpt_clear_halt(uint8_t daddr, uint8_t ep_addr, tuh_xfer_cb_t complete_cb, uintptr_t user_data) {
+  TU_LOG_USBH("Clear Halt EP %02X\r\n", ep_addr);
+  tusb_control_request_t const request = {
+      .bmRequestType_bit = {
+          .recipient = TUSB_REQ_RCPT_ENDPOINT,
+          .type      = TUSB_REQ_TYPE_STANDARD,
+          .direction = TUSB_DIR_OUT
+      },
+      .bRequest = TUSB_REQ_CLEAR_FEATURE,
+      .wValue   = tu_htole16(TUSB_REQ_FEATURE_EDPT_HALT),
+      .wIndex   = tu_htole16(ep_addr),
+      .wLength  = 0
+  };
+  tuh_xfer_t xfer = {
+      .daddr       = daddr,
+      .ep_addr     = 0,
+      .setup       = &request,
+      .buffer      = NULL,
+      .complete_cb = complete_cb,
+      .user_data   = user_data
+  };
+
+  TU_VERIFY(tuh_control_xfer(&xfer));
+
+  // endpoint is idle while its halt is being cleared: device resets data toggle to DATA0 on this request
+  (void) hcd_edpt_clear_stall(usbh_get_rhport(daddr), daddr, ep_addr);
+  return true;
+}
+
 //--------------------------------------------------------------------+
 // Descriptor Sync
 //--------------------------------------------------------------------+
@@ -1264,10 +2413,13 @@ static void process_removing_device(uint8_t rhport, uint8_t hub_addr, uint8_t hu
         }
 
         hcd_device_close(rhport, daddr);
+        hcd_bw_release(daddr, 0);
         clear_device(dev);
+        enum_device_removed(daddr);
 
         // abort on-going control xfer on this device if any
-        if (_ctrl_xfer.daddr == daddr) _set_control_xfer_stage(CONTROL_STAGE_IDLE);
+        usbh_ctrl_xfer_t* ctrl = get_ctrl_xfer(daddr);
+        if (ctrl->daddr == daddr) _set_control_xfer_stage(ctrl, CONTROL_STAGE_IDLE);
       }
     }
 
@@ -1296,9 +2448,13 @@ static void process_removing_device(uint8_t rhport, uint8_t hub_addr, uint8_t hu
 //--------------------------------------------------------------------+
 // Enumeration Process
 // is a lengthy process with a series of control transfer to configure
-// newly attached device.
-// NOTE: due to the shared control buffer, we must complete enumerating
-// one device before enumerating another one.
+// newly attached device. It has 2 stages:
+// - dev0: port reset and set address, only one device can be at address 0 at a time. Attach events of other
+//   devices wait in a pending queue.
+// - config: get descriptors, set configuration and class drivers set_config, which use the shared enumeration
+//   buffer. Addressed devices wait for their turn.
+// With CFG_TUH_ENUM_OVERLAP, dev0 stage of next device runs while previous one is in config stage. Otherwise
+// a device must complete enumerating before enumerating another one.
 //--------------------------------------------------------------------+
 
 enum {
@@ -1310,13 +2466,19 @@ enum {
 enum {
   ENUM_IDLE,
   ENUM_RESET_1,         // 1st reset when attached
-  //ENUM_HUB_GET_STATUS_1,
+  ENUM_RESET_1_END,     // roothub: end of 1st reset
+  ENUM_DEBOUNCED,       // roothub: connection is stable
+  ENUM_HUB_RESET_1,     // hub: connection is stable
+  ENUM_HUB_RESET_1_END, // hub: port reset is started
+  ENUM_HUB_GET_STATUS_1,
   ENUM_HUB_CLEAR_RESET_1,
   ENUM_ADDR0_DEVICE_DESC,
   ENUM_RESET_2,         // 2nd reset before set address (not used)
+  ENUM_HUB_RESET_2,
   ENUM_HUB_GET_STATUS_2,
   ENUM_HUB_CLEAR_RESET_2,
   ENUM_SET_ADDR,
+  ENUM_ADDR_RECOVERY,
 
   ENUM_GET_DEVICE_DESC,
   ENUM_GET_9BYTE_CONFIG_DESC,
@@ -1327,7 +2489,403 @@ enum {
 
 static bool enum_request_set_addr(void);
 static bool _parse_configuration_descriptor (uint8_t dev_addr, tusb_desc_configuration_t const* desc_cfg);
-static void enum_full_complete(void);
+static void enum_full_complete(uint8_t daddr);
+static void process_enumeration(tuh_xfer_t* xfer);
+
+enum {
+  ENUM_STAGE_DEV0 = 0,
+  ENUM_STAGE_CONFIG,
+  ENUM_STAGE_COUNT
+};
+
+// Enumeration delays (reset, debouncing, retry etc.) do not block: enumeration resumes from tuh_task() once the
+// delay expires, meanwhile other devices keep running. Each stage has its own delay.
+typedef struct {
+  uint32_t start_ms;
+  uint16_t delay_ms;
+  uint8_t daddr;
+  uint8_t state;        // enumeration state to resume with
+  bool pending;
+  bool retry;           // retry failed control transfer instead of resuming state
+
+  tusb_control_request_t request; // copy of failed transfer for retry
+  tuh_xfer_t xfer;
+} enum_delay_t;
+
+static enum_delay_t _enum_delay[ENUM_STAGE_COUNT];
+
+// device address in config stage, 0 if none
+static uint8_t _enum_config_addr;
+
+// attach events waiting for dev0. Hub reports all of its changed ports at once, room for as many as can be enumerated
+enum { ENUM_ATTACH_PENDING_MAX = CFG_TUH_DEVICE_MAX + CFG_TUH_HUB + 1 };
+static struct {
+  uint8_t count;
+  hcd_event_t event[ENUM_ATTACH_PENDING_MAX];
+  uint32_t attach_ms[ENUM_ATTACH_PENDING_MAX]; // debouncing elapses while waiting
+} _enum_attach;
+
+// Note: dev0 stage transfers to hub have hub address, stage is determined by (next) state
+TU_ATTR_ALWAYS_INLINE static inline uint8_t enum_stage(uintptr_t state) {
+  return (state <= ENUM_ADDR_RECOVERY) ? ENUM_STAGE_DEV0 : ENUM_STAGE_CONFIG;
+}
+
+//--------------------------------------------------------------------+
+// Enumeration statistics
+//--------------------------------------------------------------------+
+#if CFG_TUH_ENUM_STATS
+// indexed by device address, 0 is dev0
+static tuh_enum_stats_t _enum_stats[TOTAL_DEVICES + 1];
+
+// class driver whose set_config is running for device in config stage
+static struct {
+  uint32_t start_ms;
+  uint8_t drv_id;
+} _enum_stats_driver;
+
+bool tuh_enum_stats_get(uint8_t daddr, tuh_enum_stats_t* stats) {
+  TU_VERIFY(daddr <= TOTAL_DEVICES && stats);
+  *stats = _enum_stats[daddr];
+  return true;
+}
+
+// dev0 stage transfers to hub have hub address, they are recorded to dev0
+static tuh_enum_stats_t* enum_stats(uint8_t stage, uint8_t daddr) {
+  return &_enum_stats[(stage == ENUM_STAGE_DEV0) ? 0 : daddr];
+}
+
+static void enum_stats_start(void) {
+  tu_varclr(&_enum_stats[0]);
+  _enum_stats[0].attach_ms = tusb_time_millis_api();
+}
+
+static void enum_stats_stage(uint8_t daddr, uint8_t stats_stage) {
+  tuh_enum_stats_t* stats = &_enum_stats[daddr];
+  stats->stage_ms[stats_stage] = tusb_time_millis_api() - stats->attach_ms;
+  stats->stage_count = stats_stage + 1;
+}
+
+// address is set, device continues with its own record
+static void enum_stats_addressed(uint8_t new_addr) {
+  _enum_stats[new_addr] = _enum_stats[0];
+}
+
+// previous class driver set_config is complete (if any), next_drv_id is driver to invoke or TUSB_INDEX_INVALID_8
+static void enum_stats_driver(uint8_t daddr, bool complete, uint8_t next_drv_id) {
+  tuh_enum_stats_t* stats = &_enum_stats[daddr];
+  uint32_t const now = tusb_time_millis_api();
+  if (complete) {
+    uint32_t const elapsed = now - _enum_stats_driver.start_ms;
+    stats->driver_ms += elapsed;
+    if (elapsed >= stats->driver_max_ms) {
+      stats->driver_max_ms = elapsed;
+      stats->driver_max_id = _enum_stats_driver.drv_id;
+    }
+  }
+  _enum_stats_driver.start_ms = now;
+  _enum_stats_driver.drv_id = next_drv_id;
+}
+
+// stage is complete (dev0 with address 0) successfully or not
+static void enum_stats_complete(uint8_t daddr) {
+  tuh_enum_stats_t* stats = &_enum_stats[daddr];
+  uint8_t const last_stage = (daddr == 0) ? TUH_ENUM_STATS_SET_ADDR : TUH_ENUM_STATS_MOUNTED;
+  if (stats->stage_count <= last_stage) {
+    stats->failed = true;
+    TU_LOG_USBH("[:%u] Enumeration failed at stage %u after %" PRIu32 " ms\r\n", daddr, stats->stage_count,
+                tusb_time_millis_api() - stats->attach_ms);
+  }
+}
+
+#define enum_stats_retry(_stage, _daddr)      enum_stats(_stage, _daddr)->retries++
+#define enum_stats_delay(_stage, _daddr, _ms) enum_stats(_stage, _daddr)->delay_ms += (_ms)
+#else
+#define enum_stats_start()
+#define enum_stats_stage(_daddr, _stats_stage)
+#define enum_stats_addressed(_new_addr)
+#define enum_stats_driver(_daddr, _complete, _next_drv_id) (void) (_complete)
+#define enum_stats_complete(_daddr)
+#define enum_stats_retry(_stage, _daddr)
+#define enum_stats_delay(_stage, _daddr, _ms)
+#endif
+
+// stage is still running: dev0 is enumerating or device is the one in config stage
+static bool enum_stage_active(uint8_t stage, uint8_t daddr) {
+  if (stage == ENUM_STAGE_DEV0) {
+    return _dev0.enumerating;
+  }
+  const usbh_device_t* dev = get_device(daddr);
+  return (daddr == _enum_config_addr) && dev && dev->connected;
+}
+
+static void enum_delay(uint8_t daddr, uint8_t state, uint16_t delay_ms) {
+  enum_stats_delay(enum_stage(state), daddr, delay_ms);
+  enum_delay_t* delay = &_enum_delay[enum_stage(state)];
+  delay->start_ms = tusb_time_millis_api();
+  delay->delay_ms = delay_ms;
+  delay->daddr = daddr;
+  delay->state = state;
+  delay->retry = false;
+  delay->pending = true;
+}
+
+static void enum_delay_retry(tuh_xfer_t const* xfer, uint16_t delay_ms) {
+  uint8_t const state = (uint8_t) xfer->user_data;
+  enum_delay(xfer->daddr, state, delay_ms);
+  enum_delay_t* delay = &_enum_delay[enum_stage(state)];
+  delay->request = (*xfer->setup);
+  delay->xfer = (*xfer);
+  delay->xfer.setup = &delay->request;
+  delay->retry = true;
+}
+
+// resume stage if its delay expired, return remaining time otherwise
+static uint32_t enum_delay_process(uint8_t stage, uint32_t timeout_ms) {
+  enum_delay_t* delay = &_enum_delay[stage];
+  if (!delay->pending) {
+    return timeout_ms;
+  }
+
+  uint32_t const elapsed = tusb_time_millis_api() - delay->start_ms;
+  if (elapsed < delay->delay_ms) {
+    return tu_min32(timeout_ms, delay->delay_ms - elapsed);
+  }
+
+  delay->pending = false;
+  if (!enum_stage_active(stage, delay->daddr)) {
+    return timeout_ms; // device is removed while waiting
+  }
+
+  if (delay->retry) {
+    if (!tuh_control_xfer(&delay->xfer)) {
+      enum_full_complete((stage == ENUM_STAGE_DEV0) ? 0 : delay->daddr);
+    }
+  } else {
+    tuh_xfer_t xfer;
+    xfer.daddr = delay->daddr;
+    xfer.result = XFER_RESULT_SUCCESS;
+    xfer.user_data = delay->state;
+    process_enumeration(&xfer);
+  }
+
+  // resumed state may start another delay
+  return enum_delay_process(stage, timeout_ms);
+}
+
+static bool enum_attach_same_port(hcd_event_t const* a, hcd_event_t const* b) {
+  return a->rhport == b->rhport && a->connection.hub_addr == b->connection.hub_addr &&
+         a->connection.hub_port == b->connection.hub_port;
+}
+
+#if CFG_TUH_HUB
+// re-arm hub status endpoint once none of its attached ports is waiting for or in dev0 stage
+static void enum_hub_status_rearm(uint8_t hub_addr) {
+  if (hub_addr == 0 || (_dev0.enumerating && _dev0.hub_addr == hub_addr)) {
+    return;
+  }
+  for (uint8_t i = 0; i < _enum_attach.count; i++) {
+    if (_enum_attach.event[i].connection.hub_addr == hub_addr) {
+      return;
+    }
+  }
+
+  const usbh_device_t* hub = get_device(hub_addr);
+  if (hub && hub->connected) {
+    (void) hub_edpt_status_xfer(hub_addr);
+  }
+}
+#endif
+
+static void enum_attach_event(hcd_event_t const* event, uint32_t attach_ms) {
+  if (_dev0.enumerating) {
+    // Some device can cause multiple duplicated attach events
+    // drop current enumerating and start over for a proper port reset
+    if (event->rhport == _dev0.rhport && event->connection.hub_addr == _dev0.hub_addr &&
+        event->connection.hub_port == _dev0.hub_port) {
+      // abort/cancel current enumeration and start new one
+      TU_LOG1("[%u:] USBH Device Attach (duplicated)\r\n", event->rhport);
+      tuh_edpt_abort_xfer(0, 0);
+      enum_new_device(event, attach_ms);
+      return;
+    }
+
+    for (uint8_t i = 0; i < _enum_attach.count; i++) {
+      if (enum_attach_same_port(&_enum_attach.event[i], event)) {
+        return; // already pending
+      }
+    }
+
+    TU_LOG_USBH("[%u:] USBH Defer Attach until current enumeration complete\r\n", event->rhport);
+    if (_enum_attach.count < ENUM_ATTACH_PENDING_MAX) {
+      _enum_attach.attach_ms[_enum_attach.count] = attach_ms;
+      _enum_attach.event[_enum_attach.count++] = (*event);
+    } else {
+      TU_LOG1("[%u:] USBH Attach dropped, pending queue is full\r\n", event->rhport);
+      #if CFG_TUH_HUB
+      enum_hub_status_rearm(event->connection.hub_addr);
+      #endif
+    }
+  } else {
+    TU_LOG1("[%u:] USBH Device Attach\r\n", event->rhport);
+    _dev0.enumerating = 1;
+    enum_new_device(event, attach_ms);
+  }
+}
+
+// drop pending attach of removed port. Roothub removal drops all of its pending ports
+static void enum_remove_event(hcd_event_t const* event) {
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < _enum_attach.count; i++) {
+    hcd_event_t const* pending = &_enum_attach.event[i];
+    bool const removed = (pending->rhport == event->rhport) &&
+                         (event->connection.hub_addr == 0 || enum_attach_same_port(pending, event));
+    if (!removed) {
+      _enum_attach.attach_ms[count] = _enum_attach.attach_ms[i];
+      _enum_attach.event[count++] = (*pending);
+    }
+  }
+  _enum_attach.count = count;
+}
+
+static void enum_device_removed(uint8_t daddr) {
+  if (daddr == _enum_config_addr) {
+    _enum_config_addr = 0;
+    _enum_delay[ENUM_STAGE_CONFIG].pending = false;
+  }
+}
+
+// start config stage of daddr with the enumeration buffer, or queue it if buffer is being used
+static void enum_config_start(uint8_t daddr, uint16_t delay_ms) {
+  if (_enum_config_addr == 0) {
+    _enum_config_addr = daddr;
+    enum_delay(daddr, ENUM_GET_DEVICE_DESC, delay_ms);
+  } else {
+    usbh_device_t* dev = get_device(daddr);
+    TU_VERIFY(dev,);
+    dev->enum_pending = 1;
+  }
+}
+
+static uint32_t enum_process(uint32_t timeout_ms) {
+  // start next device waiting for dev0
+  while (!_dev0.enumerating && _enum_attach.count > 0) {
+    hcd_event_t const event = _enum_attach.event[0];
+    uint32_t const attach_ms = _enum_attach.attach_ms[0];
+    _enum_attach.count--;
+    memmove(&_enum_attach.event[0], &_enum_attach.event[1], _enum_attach.count * sizeof(hcd_event_t));
+    memmove(&_enum_attach.attach_ms[0], &_enum_attach.attach_ms[1], _enum_attach.count * sizeof(uint32_t));
+
+    // skip if hub is removed meanwhile
+    const usbh_device_t* hub = get_device(event.connection.hub_addr);
+    if (event.connection.hub_addr == 0 || (hub && hub->connected)) {
+      enum_attach_event(&event, attach_ms);
+    }
+  }
+
+  // start next addressed device waiting for config stage
+  if (_enum_config_addr == 0) {
+    for (uint8_t dev_id = 0; dev_id < TOTAL_DEVICES; dev_id++) {
+      usbh_device_t* dev = &_usbh_devices[dev_id];
+      if (dev->enum_pending) {
+        dev->enum_pending = 0;
+        if (dev->connected) {
+          enum_config_start(dev_id + 1, 0);
+          break;
+        }
+      }
+    }
+  }
+
+  for (uint8_t i = 0; i < ENUM_STAGE_COUNT; i++) {
+    timeout_ms = enum_delay_process(i, timeout_ms);
+  }
+
+  return timeout_ms;
+}
+
+//--------------------------------------------------------------------+
+// Descriptor Cache
+//--------------------------------------------------------------------+
+#if CFG_TUH_DESC_CACHE
+
+// device descriptor of device in config stage, key for caching its configuration descriptor
+static tusb_desc_device_t _enum_desc_device;
+
+#if CFG_TUH_DESC_CACHE_ENTRIES
+typedef struct {
+  tusb_desc_device_t desc_device;
+  uint16_t len; // 0 if entry is free
+  uint32_t last_use;
+  uint8_t desc_config[CFG_TUH_DESC_CACHE_BUFSIZE];
+} desc_cache_entry_t;
+
+static desc_cache_entry_t _desc_cache[CFG_TUH_DESC_CACHE_ENTRIES];
+static uint32_t _desc_cache_tick;
+
+// insert into RAM cache, replacing least recently used entry
+static void desc_cache_insert(tusb_desc_device_t const* desc_device, uint8_t const* desc_config, uint16_t len) {
+  if (len > CFG_TUH_DESC_CACHE_BUFSIZE) {
+    return;
+  }
+
+  desc_cache_entry_t* entry = &_desc_cache[0];
+  for (uint8_t i = 0; i < CFG_TUH_DESC_CACHE_ENTRIES; i++) {
+    desc_cache_entry_t* e = &_desc_cache[i];
+    if (e->len == 0 || 0 == memcmp(&e->desc_device, desc_device, sizeof(tusb_desc_device_t))) {
+      entry = e;
+      break;
+    }
+    if (e->last_use < entry->last_use) {
+      entry = e;
+    }
+  }
+
+  entry->desc_device = (*desc_device);
+  entry->len = len;
+  entry->last_use = ++_desc_cache_tick;
+  memcpy(entry->desc_config, desc_config, len);
+}
+#endif
+
+// cached descriptor must be a complete configuration descriptor
+static bool desc_cache_valid(uint8_t const* desc_config, uint16_t len) {
+  TU_VERIFY(len >= sizeof(tusb_desc_configuration_t) && len <= CFG_TUH_ENUMERATION_BUFSIZE);
+  TU_VERIFY(desc_config[1] == TUSB_DESC_CONFIGURATION);
+  return len == tu_le16toh(tu_unaligned_read16(desc_config + offsetof(tusb_desc_configuration_t, wTotalLength)));
+}
+
+// copy cached configuration descriptor of device into buffer (enumeration buffer size), return its length or 0
+static uint16_t desc_cache_load(tusb_desc_device_t const* desc_device, uint8_t* buffer) {
+  #if CFG_TUH_DESC_CACHE_ENTRIES
+  for (uint8_t i = 0; i < CFG_TUH_DESC_CACHE_ENTRIES; i++) {
+    desc_cache_entry_t* entry = &_desc_cache[i];
+    if (entry->len && 0 == memcmp(&entry->desc_device, desc_device, sizeof(tusb_desc_device_t))) {
+      entry->last_use = ++_desc_cache_tick;
+      memcpy(buffer, entry->desc_config, entry->len);
+      return entry->len;
+    }
+  }
+  #endif
+
+  uint16_t const len = tuh_descriptor_cache_load_cb(desc_device, buffer, CFG_TUH_ENUMERATION_BUFSIZE);
+  TU_VERIFY(len && desc_cache_valid(buffer, len), 0);
+
+  #if CFG_TUH_DESC_CACHE_ENTRIES
+  desc_cache_insert(desc_device, buffer, len);
+  #endif
+
+  return len;
+}
+
+static void desc_cache_store(tusb_desc_device_t const* desc_device, uint8_t const* desc_config, uint16_t len) {
+  TU_VERIFY(desc_cache_valid(desc_config, len),);
+  #if CFG_TUH_DESC_CACHE_ENTRIES
+  desc_cache_insert(desc_device, desc_config, len);
+  #endif
+  tuh_descriptor_cache_store_cb(desc_device, desc_config, len);
+}
+
+#endif
 
 // process device enumeration
 static void process_enumeration(tuh_xfer_t* xfer) {
@@ -1336,40 +2894,82 @@ static void process_enumeration(tuh_xfer_t* xfer) {
     ATTEMPT_COUNT_MAX = 3,
     ATTEMPT_DELAY_MS = 100
   };
-  static uint8_t failed_count = 0;
+  static uint8_t failed_count[ENUM_STAGE_COUNT];
+
+  uint8_t const daddr = xfer->daddr;
+  uintptr_t const state = xfer->user_data;
+  uint8_t const stage = enum_stage(state);
 
   if (XFER_RESULT_SUCCESS != xfer->result) {
     // retry if not reaching max attempt
-    bool retry = _dev0.enumerating && (failed_count < ATTEMPT_COUNT_MAX);
+    bool const retry = enum_stage_active(stage, daddr) && (failed_count[stage] < ATTEMPT_COUNT_MAX);
     if ( retry ) {
-      failed_count++;
-      tusb_time_delay_ms_api(ATTEMPT_DELAY_MS); // delay a bit
-      TU_LOG1("Enumeration attempt %u\r\n", failed_count);
-      retry = tuh_control_xfer(xfer);
-    }
-
-    if (!retry) {
-      enum_full_complete();
+      failed_count[stage]++;
+      enum_stats_retry(stage, daddr);
+      TU_LOG1("Enumeration attempt %u\r\n", failed_count[stage]);
+      enum_delay_retry(xfer, ATTEMPT_DELAY_MS); // delay a bit
+    } else {
+      enum_full_complete((stage == ENUM_STAGE_DEV0) ? 0 : daddr);
     }
 
     return;
   }
-  failed_count = 0;
-
-  uint8_t const daddr = xfer->daddr;
-  uintptr_t const state = xfer->user_data;
+  failed_count[stage] = 0;
 
   switch (state) {
+    case ENUM_RESET_1_END:
+      hcd_port_reset_end(_dev0.rhport);
+
+      // wait until device connection is stable
+      enum_delay(0, ENUM_DEBOUNCED, ENUM_DEBOUNCING_DELAY_MS);
+      break;
+
+    case ENUM_DEBOUNCED:
+      // device unplugged while delaying
+      if (!hcd_port_connect_status(_dev0.rhport)) {
+        enum_full_complete(0);
+        return;
+      }
+
+      _dev0.speed = hcd_port_speed_get(_dev0.rhport);
+      TU_LOG_USBH("%s Speed\r\n", tu_str_speed[_dev0.speed]);
+      TU_ATTR_FALLTHROUGH;
+
+    case ENUM_ADDR0_DEVICE_DESC: {
+      enum_stats_stage(0, TUH_ENUM_STATS_RESET);
+
+      // TODO probably doesn't need to open/close each enumeration
+      uint8_t const addr0 = 0;
+      TU_ASSERT(usbh_edpt_control_open(addr0, 8),);
+
+      // Get first 8 bytes of device descriptor for Control Endpoint size
+      TU_LOG_USBH("Get 8 byte of Device Descriptor\r\n");
+      TU_ASSERT(tuh_descriptor_get_device(addr0, _usbh_epbuf.dev0, 8,
+                                          process_enumeration, ENUM_SET_ADDR),);
+      break;
+    }
+
     #if CFG_TUH_HUB
-    //case ENUM_HUB_GET_STATUS_1: break;
+    case ENUM_HUB_RESET_1:
+      TU_ASSERT(hub_port_reset(_dev0.hub_addr, _dev0.hub_port, process_enumeration, ENUM_HUB_RESET_1_END),);
+      break;
+
+    case ENUM_HUB_RESET_1_END:
+      enum_delay(0, ENUM_HUB_GET_STATUS_1, ENUM_RESET_DELAY_MS);
+      break;
+
+    case ENUM_HUB_GET_STATUS_1:
+      TU_ASSERT(hub_port_get_status(_dev0.hub_addr, _dev0.hub_port, _usbh_epbuf.dev0,
+                                    process_enumeration, ENUM_HUB_CLEAR_RESET_1),);
+      break;
 
     case ENUM_HUB_CLEAR_RESET_1: {
       hub_port_status_response_t port_status;
-      memcpy(&port_status, _usbh_epbuf.ctrl, sizeof(hub_port_status_response_t));
+      memcpy(&port_status, _usbh_epbuf.dev0, sizeof(hub_port_status_response_t));
 
       if (!port_status.status.connection) {
         // device unplugged while delaying, nothing else to do
-        enum_full_complete();
+        enum_full_complete(0);
         return;
       }
 
@@ -1380,19 +2980,24 @@ static void process_enumeration(tuh_xfer_t* xfer) {
       if (port_status.change.reset) {
         hub_port_clear_reset_change(_dev0.hub_addr, _dev0.hub_port,
                                     process_enumeration, ENUM_ADDR0_DEVICE_DESC);
+      } else {
+        enum_delay(0, ENUM_ADDR0_DEVICE_DESC, 0); // already cleared by hub driver
       }
       break;
     }
 
+    case ENUM_HUB_RESET_2:
+      enum_delay(0, ENUM_HUB_GET_STATUS_2, ENUM_RESET_DELAY_MS);
+      break;
+
     case ENUM_HUB_GET_STATUS_2:
-      tusb_time_delay_ms_api(ENUM_RESET_DELAY_MS);
-      TU_ASSERT(hub_port_get_status(_dev0.hub_addr, _dev0.hub_port, _usbh_epbuf.ctrl,
+      TU_ASSERT(hub_port_get_status(_dev0.hub_addr, _dev0.hub_port, _usbh_epbuf.dev0,
                                     process_enumeration, ENUM_HUB_CLEAR_RESET_2),);
       break;
 
     case ENUM_HUB_CLEAR_RESET_2: {
       hub_port_status_response_t port_status;
-      memcpy(&port_status, _usbh_epbuf.ctrl, sizeof(hub_port_status_response_t));
+      memcpy(&port_status, _usbh_epbuf.dev0, sizeof(hub_port_status_response_t));
 
       // Acknowledge Port Reset Change if Reset Successful
       if (port_status.change.reset) {
@@ -1403,18 +3008,6 @@ static void process_enumeration(tuh_xfer_t* xfer) {
     }
     #endif
 
-    case ENUM_ADDR0_DEVICE_DESC: {
-      // TODO probably doesn't need to open/close each enumeration
-      uint8_t const addr0 = 0;
-      TU_ASSERT(usbh_edpt_control_open(addr0, 8),);
-
-      // Get first 8 bytes of device descriptor for Control Endpoint size
-      TU_LOG_USBH("Get 8 byte of Device Descriptor\r\n");
-      TU_ASSERT(tuh_descriptor_get_device(addr0, _usbh_epbuf.ctrl, 8,
-                                          process_enumeration, ENUM_SET_ADDR),);
-      break;
-    }
-
 #if 0
       case ENUM_RESET_2:
         // TODO not used by now, but may be needed for some devices !?
@@ -1432,7 +3025,7 @@ static void process_enumeration(tuh_xfer_t* xfer) {
         else {
           // after RESET_DELAY the hub_port_reset() already complete
           TU_ASSERT( hub_port_reset(_dev0.hub_addr, _dev0.hub_port,
-                                    process_enumeration, ENUM_HUB_GET_STATUS_2), );
+                                    process_enumeration, ENUM_HUB_RESET_2), );
           break;
         }
 #endif
@@ -1440,28 +3033,43 @@ static void process_enumeration(tuh_xfer_t* xfer) {
 #endif
 
     case ENUM_SET_ADDR:
+      enum_stats_stage(0, TUH_ENUM_STATS_DEVICE_DESC_8);
       enum_request_set_addr();
       break;
 
-    case ENUM_GET_DEVICE_DESC: {
-      // Allow 2ms for address recovery time, Ref USB Spec 9.2.6.3
-      tusb_time_delay_ms_api(2);
-
+    case ENUM_ADDR_RECOVERY: {
       const uint8_t new_addr = (uint8_t) tu_le16toh(xfer->setup->wValue);
 
       usbh_device_t* new_dev = get_device(new_addr);
       TU_ASSERT(new_dev,);
       new_dev->addressed = 1;
 
+      enum_stats_stage(0, TUH_ENUM_STATS_SET_ADDR);
+      enum_stats_addressed(new_addr);
+
       // Close device 0
       hcd_device_close(_dev0.rhport, 0);
 
+      #if CFG_TUH_ENUM_OVERLAP
+      // dev0 is free for next device while this one continues with config stage
+      enum_full_complete(0);
+      #endif
+
+      // Allow 2ms for address recovery time, Ref USB Spec 9.2.6.3
+      enum_config_start(new_addr, 2);
+      break;
+    }
+
+    case ENUM_GET_DEVICE_DESC: {
+      usbh_device_t* new_dev = get_device(daddr);
+      TU_ASSERT(new_dev,);
+
       // open control pipe for new address
-      TU_ASSERT(usbh_edpt_control_open(new_addr, new_dev->ep0_size),);
+      TU_ASSERT(usbh_edpt_control_open(daddr, new_dev->ep0_size),);
 
       // Get full device descriptor
       TU_LOG_USBH("Get Device Descriptor\r\n");
-      TU_ASSERT(tuh_descriptor_get_device(new_addr, _usbh_epbuf.ctrl, sizeof(tusb_desc_device_t),
+      TU_ASSERT(tuh_descriptor_get_device(daddr, _usbh_epbuf.ctrl, sizeof(tusb_desc_device_t),
                                           process_enumeration, ENUM_GET_9BYTE_CONFIG_DESC),);
       break;
     }
@@ -1470,6 +3078,7 @@ static void process_enumeration(tuh_xfer_t* xfer) {
       tusb_desc_device_t const* desc_device = (tusb_desc_device_t const*) _usbh_epbuf.ctrl;
       usbh_device_t* dev = get_device(daddr);
       TU_ASSERT(dev,);
+      enum_stats_stage(daddr, TUH_ENUM_STATS_DEVICE_DESC);
 
       dev->vid = desc_device->idVendor;
       dev->pid = desc_device->idProduct;
@@ -1477,6 +3086,17 @@ static void process_enumeration(tuh_xfer_t* xfer) {
       dev->i_product = desc_device->iProduct;
       dev->i_serial = desc_device->iSerialNumber;
 
+      #if CFG_TUH_DESC_CACHE
+      // Skip reading configuration descriptor if device is known
+      _enum_desc_device = (*desc_device);
+      if (desc_cache_load(&_enum_desc_device, _usbh_epbuf.ctrl)) {
+        TU_LOG_USBH("Configuration[0] Descriptor from cache\r\n");
+        enum_stats_stage(daddr, TUH_ENUM_STATS_CONFIG_DESC);
+        TU_ASSERT(tuh_configuration_set(daddr, CONFIG_NUM, process_enumeration, ENUM_CONFIG_DRIVER),);
+        break;
+      }
+      #endif
+
       // Get 9-byte for total length
       uint8_t const config_idx = CONFIG_NUM - 1;
       TU_LOG_USBH("Get Configuration[0] Descriptor (9 bytes)\r\n");
@@ -1492,18 +3112,27 @@ static void process_enumeration(tuh_xfer_t* xfer) {
       uint16_t const total_len = tu_le16toh(
           tu_unaligned_read16(desc_config + offsetof(tusb_desc_configuration_t, wTotalLength)));
 
-      // TODO not enough buffer to hold configuration descriptor
-      TU_ASSERT(total_len <= CFG_TUH_ENUMERATION_BUFSIZE,);
+      // Configuration descriptor larger than enumeration buffer is read up to buffer size: GET_DESCRIPTOR has no
+      // offset to fetch the rest. Functions (interface + association) that are fully read are still opened.
+      uint16_t const xfer_len = tu_min16(total_len, CFG_TUH_ENUMERATION_BUFSIZE);
+      if (xfer_len < total_len) {
+        TU_LOG1("Configuration descriptor (%u bytes) exceeds CFG_TUH_ENUMERATION_BUFSIZE, truncated\r\n", total_len);
+      }
 
       // Get full configuration descriptor
       uint8_t const config_idx = CONFIG_NUM - 1;
       TU_LOG_USBH("Get Configuration[0] Descriptor\r\n");
-      TU_ASSERT(tuh_descriptor_get_configuration(daddr, config_idx, _usbh_epbuf.ctrl, total_len,
+      TU_ASSERT(tuh_descriptor_get_configuration(daddr, config_idx, _usbh_epbuf.ctrl, xfer_len,
                                                  process_enumeration, ENUM_SET_CONFIG),);
       break;
     }
 
     case ENUM_SET_CONFIG:
+      enum_stats_stage(daddr, TUH_ENUM_STATS_CONFIG_DESC);
+      #if CFG_TUH_DESC_CACHE
+      desc_cache_store(&_enum_desc_device, _usbh_epbuf.ctrl, (uint16_t) xfer->actual_len);
+      #endif
+
       TU_ASSERT(tuh_configuration_set(daddr, CONFIG_NUM, process_enumeration, ENUM_CONFIG_DRIVER),);
       break;
 
@@ -1513,6 +3142,7 @@ static void process_enumeration(tuh_xfer_t* xfer) {
       TU_ASSERT(dev,);
 
       dev->configured = 1;
+      enum_stats_stage(daddr, TUH_ENUM_STATS_SET_CONFIG);
 
       // Parse configuration & set up drivers
       // driver_open() must not make any usb transfer
@@ -1528,17 +3158,19 @@ static void process_enumeration(tuh_xfer_t* xfer) {
 
     default:
       // stop enumeration if unknown state
-      enum_full_complete();
+      enum_full_complete((stage == ENUM_STAGE_DEV0) ? 0 : daddr);
       break;
   }
 }
 
 
 
-static bool enum_new_device(hcd_event_t* event) {
+static bool enum_new_device(hcd_event_t const* event, uint32_t attach_ms) {
+  (void) attach_ms;
   _dev0.rhport = event->rhport;
   _dev0.hub_addr = event->connection.hub_addr;
   _dev0.hub_port = event->connection.hub_port;
+  enum_stats_start();
 
   if (_dev0.hub_addr == 0) {
     // connected directly to roothub
@@ -1546,39 +3178,14 @@ static bool enum_new_device(hcd_event_t* event) {
 
     // Since we are in middle of rhport reset, frame number is not available yet.
     // need to depend on tusb_time_millis_api()
-    tusb_time_delay_ms_api(ENUM_RESET_DELAY_MS);
-
-    hcd_port_reset_end(_dev0.rhport);
-
-    // wait until device connection is stable TODO non blocking
-    tusb_time_delay_ms_api(ENUM_DEBOUNCING_DELAY_MS);
-
-    // device unplugged while delaying
-    if (!hcd_port_connect_status(_dev0.rhport)) {
-      enum_full_complete();
-      return true;
-    }
-
-    _dev0.speed = hcd_port_speed_get(_dev0.rhport);
-    TU_LOG_USBH("%s Speed\r\n", tu_str_speed[_dev0.speed]);
-
-    // fake transfer to kick-off the enumeration process
-    tuh_xfer_t xfer;
-    xfer.daddr = 0;
-    xfer.result = XFER_RESULT_SUCCESS;
-    xfer.user_data = ENUM_ADDR0_DEVICE_DESC;
-
-    process_enumeration(&xfer);
+    enum_delay(0, ENUM_RESET_1_END, ENUM_RESET_DELAY_MS);
   }
 #if CFG_TUH_HUB
   else {
     // connected via external hub
-    // wait until device connection is stable TODO non blocking
-    tusb_time_delay_ms_api(ENUM_DEBOUNCING_DELAY_MS);
-
-    // ENUM_HUB_GET_STATUS
-    TU_ASSERT(hub_port_get_status(_dev0.hub_addr, _dev0.hub_port, _usbh_epbuf.ctrl,
-                                  process_enumeration, ENUM_HUB_CLEAR_RESET_1));
+    // wait until device connection is stable, time waiting in attach queue counts toward debouncing
+    uint32_t const elapsed = tusb_time_millis_api() - attach_ms;
+    enum_delay(0, ENUM_HUB_RESET_1, (uint16_t) (ENUM_DEBOUNCING_DELAY_MS - tu_min32(elapsed, ENUM_DEBOUNCING_DELAY_MS)));
   }
 #endif // hub
 
@@ -1605,7 +3212,7 @@ static uint8_t get_new_address(bool is_hub) {
 }
 
 static bool enum_request_set_addr(void) {
-  tusb_desc_device_t const* desc_device = (tusb_desc_device_t const*) _usbh_epbuf.ctrl;
+  tusb_desc_device_t const* desc_device = (tusb_desc_device_t const*) _usbh_epbuf.dev0;
 
   // Get new address
   uint8_t const new_addr = get_new_address(desc_device->bDeviceClass == TUSB_CLASS_HUB);
@@ -1637,7 +3244,7 @@ static bool enum_request_set_addr(void) {
       .setup       = &request,
       .buffer      = NULL,
       .complete_cb = process_enumeration,
-      .user_data   = ENUM_GET_DEVICE_DESC
+      .user_data   = ENUM_ADDR_RECOVERY
   };
 
   TU_ASSERT(tuh_control_xfer(&xfer));
@@ -1647,11 +3254,16 @@ static bool enum_request_set_addr(void) {
 static bool _parse_configuration_descriptor(uint8_t dev_addr, tusb_desc_configuration_t const* desc_cfg) {
   usbh_device_t* dev = get_device(dev_addr);
   uint16_t const total_len = tu_le16toh(desc_cfg->wTotalLength);
-  uint8_t const* desc_end = ((uint8_t const*) desc_cfg) + total_len;
+  // descriptor is truncated to enumeration buffer if too large
+  uint16_t const len = tu_min16(total_len, CFG_TUH_ENUMERATION_BUFSIZE);
+  bool const truncated = (len < total_len);
+  uint8_t const* desc_end = ((uint8_t const*) desc_cfg) + len;
   uint8_t const* p_desc   = tu_desc_next(desc_cfg);
 
   TU_LOG_USBH("Parsing Configuration descriptor (wTotalLength = %u)\r\n", total_len);
 
+  dev->quirks = device_id_quirks(dev->vid, dev->pid);
+
   // parse each interfaces
   while( p_desc < desc_end ) {
     if ( 0 == tu_desc_len(p_desc) ) {
@@ -1669,6 +3281,9 @@ static bool _parse_configuration_descriptor(uint8_t dev_addr, tusb_desc_configur
       assoc_itf_count = desc_iad->bInterfaceCount;
 
       p_desc = tu_desc_next(p_desc); // next to Interface
+      if (p_desc >= desc_end) {
+        break; // truncated
+      }
 
       // IAD's first interface number and class should match with opened interface
       //TU_ASSERT(desc_iad->bFirstInterface == desc_itf->bInterfaceNumber &&
@@ -1699,11 +3314,57 @@ static bool _parse_configuration_descriptor(uint8_t dev_addr, tusb_desc_configur
     }
 #endif
 
+#if CFG_TUH_NCM
+    // same for NCM device without IAD: communication + data interface
+    if (1                                       == assoc_itf_count              &&
+        TUSB_CLASS_CDC                          == desc_itf->bInterfaceClass    &&
+        CDC_COMM_SUBCLASS_NETWORK_CONTROL_MODEL == desc_itf->bInterfaceSubClass) {
+      assoc_itf_count = 2;
+    }
+#endif
+
+#if CFG_TUH_RNDIS
+    // RNDIS device (e.g Android tethering) may also lack IAD: communication + data interface
+    if (1 == assoc_itf_count && rndish_is_rndis_itf(desc_itf)) {
+      assoc_itf_count = 2;
+    }
+#endif
+
+#if CFG_TUH_BTH
+    // Bluetooth controller has HCI interface followed by SCO (isochronous) interface without IAD,
+    // combine them if the next interface is also a Bluetooth (RF controller) one
+    if (1 == assoc_itf_count && TUSB_CLASS_WIRELESS_CONTROLLER == desc_itf->bInterfaceClass &&
+        0x01 == desc_itf->bInterfaceSubClass && 0x01 == desc_itf->bInterfaceProtocol) {
+      uint16_t const itf_len = tu_desc_get_interface_total_len(desc_itf, 1, (uint16_t) (desc_end-p_desc));
+      tusb_desc_interface_t const* next_itf = (tusb_desc_interface_t const*) (p_desc + itf_len);
+      if ((uint8_t const*) next_itf + sizeof(tusb_desc_interface_t) <= desc_end &&
+          TUSB_DESC_INTERFACE            == next_itf->bDescriptorType   &&
+          desc_itf->bInterfaceNumber + 1 == next_itf->bInterfaceNumber  &&
+          desc_itf->bInterfaceClass      == next_itf->bInterfaceClass   &&
+          desc_itf->bInterfaceSubClass   == next_itf->bInterfaceSubClass) {
+        assoc_itf_count = 2;
+      }
+    }
+#endif
+
     uint16_t const drv_len = tu_desc_get_interface_total_len(desc_itf, assoc_itf_count, (uint16_t) (desc_end-p_desc));
     TU_ASSERT(drv_len >= sizeof(tusb_desc_interface_t));
 
-    // Find driver for this interface
-    for (uint8_t drv_id = 0; drv_id < TOTAL_DRIVER_COUNT; drv_id++) {
+    // last function of a truncated descriptor may be incomplete, skip it
+    if (truncated && (p_desc + drv_len >= desc_end)) {
+      TU_LOG1("[%u:%u] Interface %u and later: not enough enumeration buffer\r\n", dev->rhport, dev_addr, desc_itf->bInterfaceNumber);
+      break;
+    }
+
+    // Find driver for this interface: the one of device ID table first, then try all drivers in order
+    uint8_t const id_drv = device_id_get_driver(dev->vid, dev->pid, desc_itf->bInterfaceClass);
+    bool opened = false;
+    for (uint8_t n = 0; n <= TOTAL_DRIVER_COUNT; n++) {
+      uint8_t const drv_id = (n == 0) ? id_drv : (uint8_t) (n - 1);
+      if (n != 0 && drv_id == id_drv) {
+        continue; // already tried
+      }
+
       usbh_class_driver_t const * driver = get_driver(drv_id);
       if (driver && driver->open(dev->rhport, dev_addr, desc_itf, drv_len) ) {
         // open successfully
@@ -1719,15 +3380,16 @@ static bool _parse_configuration_descriptor(uint8_t dev_addr, tusb_desc_configur
         }
 
         // bind all endpoints to found driver
-        tu_edpt_bind_driver(dev->ep2drv, desc_itf, drv_len, drv_id);
+        TU_ASSERT(edpt_bind_driver(dev_addr, desc_itf, drv_len, drv_id));
 
+        opened = true;
         break; // exit driver find loop
       }
+    }
 
-      if ( drv_id == TOTAL_DRIVER_COUNT - 1 ) {
-        TU_LOG_USBH("[%u:%u] Interface %u: class = %u subclass = %u protocol = %u is not supported\r\n",
-               dev->rhport, dev_addr, desc_itf->bInterfaceNumber, desc_itf->bInterfaceClass, desc_itf->bInterfaceSubClass, desc_itf->bInterfaceProtocol);
-      }
+    if (!opened) {
+      TU_LOG_USBH("[%u:%u] Interface %u: class = %u subclass = %u protocol = %u is not supported\r\n",
+             dev->rhport, dev_addr, desc_itf->bInterfaceNumber, desc_itf->bInterfaceClass, desc_itf->bInterfaceSubClass, desc_itf->bInterfaceProtocol);
     }
 
     // next Interface or IAD descriptor
@@ -1739,6 +3401,7 @@ static bool _parse_configuration_descriptor(uint8_t dev_addr, tusb_desc_configur
 
 void usbh_driver_set_config_complete(uint8_t dev_addr, uint8_t itf_num) {
   usbh_device_t* dev = get_device(dev_addr);
+  bool const driver_complete = (itf_num != TUSB_INDEX_INVALID_8);
 
   for(itf_num++; itf_num < CFG_TUH_INTERFACE_MAX; itf_num++) {
     // continue with next valid interface
@@ -1748,6 +3411,7 @@ void usbh_driver_set_config_complete(uint8_t dev_addr, uint8_t itf_num) {
     usbh_class_driver_t const * driver = get_driver(drv_id);
     if (driver) {
       TU_LOG_USBH("%s set config: itf = %u\r\n", driver->name, itf_num);
+      enum_stats_driver(dev_addr, driver_complete, drv_id);
       driver->set_config(dev_addr, itf_num);
       break;
     }
@@ -1755,7 +3419,9 @@ void usbh_driver_set_config_complete(uint8_t dev_addr, uint8_t itf_num) {
 
   // all interface are configured
   if (itf_num == CFG_TUH_INTERFACE_MAX) {
-    enum_full_complete();
+    enum_stats_driver(dev_addr, driver_complete, TUSB_INDEX_INVALID_8);
+    enum_stats_stage(dev_addr, TUH_ENUM_STATS_MOUNTED);
+    enum_full_complete(dev_addr);
 
     if (is_hub_addr(dev_addr)) {
       TU_LOG_USBH("HUB address = %u is mounted\r\n", dev_addr);
@@ -1766,15 +3432,31 @@ void usbh_driver_set_config_complete(uint8_t dev_addr, uint8_t itf_num) {
   }
 }
 
-static void enum_full_complete(void) {
-  // mark enumeration as complete
+// complete config stage of daddr, or dev0 stage if daddr is 0. Without CFG_TUH_ENUM_OVERLAP, dev0 stage lasts until
+// config stage is complete.
+static void enum_full_complete(uint8_t daddr) {
+  if (daddr != 0) {
+    if (daddr != _enum_config_addr) {
+      return;
+    }
+    _enum_config_addr = 0;
+    _enum_delay[ENUM_STAGE_CONFIG].pending = false;
+    enum_stats_complete(daddr);
+
+    #if CFG_TUH_ENUM_OVERLAP
+    return;
+    #endif
+  }
+
+  // mark dev0 enumeration as complete
+  enum_stats_complete(0);
   _dev0.enumerating = 0;
+  _enum_delay[ENUM_STAGE_DEV0].pending = false;
 
 #if CFG_TUH_HUB
-  // get next hub status
-  if (_dev0.hub_addr) hub_edpt_status_xfer(_dev0.hub_addr);
+  // get next hub status when its other attached ports are enumerated
+  enum_hub_status_rearm(_dev0.hub_addr);
 #endif
-
 }
 
 #endif
@@ -32,6 +32,7 @@
 #endif
 
 #include "common/tusb_common.h"
+#include "osal/osal.h"
 
 //--------------------------------------------------------------------+
 // MACRO CONSTANT TYPEDEF
@@ -64,7 +65,24 @@ struct tuh_xfer_s {
   tuh_xfer_cb_t complete_cb;
   uintptr_t user_data;
 
-  // uint32_t timeout_ms;    // place holder, not supported yet
+  uint32_t timeout_ms;       // blocking transfer only: abort with XFER_RESULT_TIMEOUT after this, 0 = wait forever
+};
+
+// Completion token, see tuh_xfer_token_init()
+struct tuh_xfer_token_s;
+typedef struct tuh_xfer_token_s tuh_xfer_token_t;
+
+typedef void (*tuh_xfer_token_notify_t)(tuh_xfer_token_t* token);
+
+struct tuh_xfer_token_s {
+  volatile xfer_result_t result; // XFER_RESULT_INVALID while in flight
+  uint32_t actual_len;
+
+  tuh_xfer_token_notify_t notify; // invoked in usbh task once complete e.g to resume a coroutine
+  void* notify_arg;
+
+  osal_semaphore_t sem;           // posted once complete if waited from other thread than usbh task
+  osal_semaphore_def_t semdef;
 };
 
 // Subject to change
@@ -73,6 +91,13 @@ typedef struct {
   tusb_desc_interface_t desc;
 } tuh_itf_info_t;
 
+// Device quirks from usbh device ID table, see tuh_quirks_get()
+enum {
+  TUH_QUIRK_SERIAL_FTDI   = 0x0001, // FTDI USB-UART, served by CDC driver
+  TUH_QUIRK_SERIAL_CP210X = 0x0002, // Silicon Labs CP210x USB-UART, served by CDC driver
+  TUH_QUIRK_SERIAL_CH34X  = 0x0004, // WCH CH34x USB-UART, served by CDC driver
+};
+
 // ConfigID for tuh_configure()
 enum {
   TUH_CFGID_INVALID = 0,
@@ -86,6 +111,59 @@ typedef struct {
   uint8_t pinctl; // R17: Pin Control Register. FDUPSPI bit is ignored
 } tuh_configure_max3421_t;
 
+// MAX3421 SPI write transaction passed to tuh_max3421_spi_xfer_list_api(): CS is asserted, command byte then len
+// data bytes are sent, CS is de-asserted
+typedef struct {
+  uint8_t cmd;          // command byte: register address with write bit
+  uint8_t len;          // number of data bytes
+  uint8_t const* data;  // data bytes, valid until the next SPI transfer with MAX3421
+} tuh_max3421_spi_xact_t;
+
+// Pico-PIO-USB frame cost, see tuh_rpi_pio_usb_frame()
+typedef struct {
+  uint32_t frame_count; // frames run since last reset
+  uint32_t busy_count;  // frames with at least one transfer pending on a root port
+  uint32_t total_us;    // accumulated frame cost, average is total_us / frame_count
+  uint16_t last_us;     // cost of the latest frame
+  uint16_t max_us;      // worst frame cost
+} tuh_rpi_pio_usb_frame_stats_t;
+
+// Class driver callback time, see CFG_TUH_STATS
+typedef struct {
+  char const* name;   // driver name, NULL if not built with CFG_TUSB_DEBUG
+  uint32_t calls;     // xfer_cb invocations
+  uint32_t time_max;  // timestamp ticks spent in a single callback
+  uint32_t time_sum;
+} tuh_stats_driver_t;
+
+typedef struct {
+  tuh_stats_driver_t driver[CFG_TUH_STATS_DRIVER_MAX]; // indexed by driver id
+} tuh_stats_t;
+
+// Enumeration stages recorded by CFG_TUH_ENUM_STATS, in order
+enum {
+  TUH_ENUM_STATS_RESET = 0,      // port reset and debouncing complete
+  TUH_ENUM_STATS_DEVICE_DESC_8,  // first 8 bytes of device descriptor at address 0
+  TUH_ENUM_STATS_SET_ADDR,
+  TUH_ENUM_STATS_DEVICE_DESC,
+  TUH_ENUM_STATS_CONFIG_DESC,    // read from device or from descriptor cache
+  TUH_ENUM_STATS_SET_CONFIG,
+  TUH_ENUM_STATS_MOUNTED,        // all class drivers set_config complete
+  TUH_ENUM_STATS_STAGE_COUNT
+};
+
+typedef struct {
+  uint32_t attach_ms;       // enumeration start (after attach event)
+  uint32_t stage_ms[TUH_ENUM_STATS_STAGE_COUNT]; // time since attach_ms when stage is complete
+  uint32_t delay_ms;        // time of enumeration delays: reset, debouncing, retry and address recovery
+  uint32_t driver_ms;       // time spent by class drivers set_config
+  uint32_t driver_max_ms;   // slowest class driver set_config
+  uint8_t  driver_max_id;   // driver id of the slowest one, see tuh_stats_t
+  uint8_t  stage_count;     // stages completed, failed stage is stage_count if failed is set
+  uint8_t  retries;         // control transfers retried
+  bool     failed;
+} tuh_enum_stats_t;
+
 typedef union {
   // For TUH_CFGID_RPI_PIO_USB_CONFIGURATION use pio_usb_configuration_t
 
@@ -108,6 +186,23 @@ TU_ATTR_WEAK void tuh_umount_cb(uint8_t daddr);
 // Invoked when there is a new usb event, which need to be processed by tuh_task()/tuh_task_ext()
 void tuh_event_hook_cb(uint8_t rhport, uint32_t eventid, bool in_isr);
 
+// Invoked to get timestamp (in any unit e.g cpu cycle) for CFG_TUH_STATS
+uint32_t tuh_stats_timestamp_cb(void);
+
+// Invoked when an interrupt endpoint is opened (by class driver or tuh_edpt_open()). Return bInterval to schedule it
+// with instead of the one in descriptor e.g faster polling for gaming input or slower for battery-friendly sensors.
+// Endpoint address identifies the interface. Result is clamped to valid range for device speed
+uint8_t tuh_edpt_interval_cb(uint8_t daddr, tusb_desc_endpoint_t const* desc_ep);
+
+#if CFG_TUH_DESC_CACHE
+// Invoked when configuration descriptor of a device is not in RAM cache. Application can copy a previously stored
+// descriptor (e.g from flash) into buffer. Return its length, or 0 if not available
+uint16_t tuh_descriptor_cache_load_cb(tusb_desc_device_t const* desc_device, uint8_t* buffer, uint16_t bufsize);
+
+// Invoked when configuration descriptor of a device is read from device, application can store it for later use
+void tuh_descriptor_cache_store_cb(tusb_desc_device_t const* desc_device, uint8_t const* desc_config, uint16_t len);
+#endif
+
 //--------------------------------------------------------------------+
 // APPLICATION API
 //--------------------------------------------------------------------+
@@ -170,6 +265,29 @@ bool tuh_rhport_is_active(uint8_t rhport);
 // Assert/de-assert Bus Reset signal to roothub port. USB specs: it should last 10-50ms
 bool tuh_rhport_reset_bus(uint8_t rhport, bool active);
 
+#if CFG_TUH_RPI_PIO_USB
+// Run one USB frame on all PIO root ports. Must be called every 1ms (e.g from a core dedicated to USB host) when
+// pio_usb_configuration_t.skip_alarm_pool is set, instead of the SDK alarm pool. CPU cost of each frame is recorded
+void tuh_rpi_pio_usb_frame(void);
+
+// Get frame cost statistics recorded by tuh_rpi_pio_usb_frame(), optionally reset them afterward
+void tuh_rpi_pio_usb_frame_stats(tuh_rpi_pio_usb_frame_stats_t* stats, bool reset);
+#endif
+
+#if CFG_TUH_STATS
+// Get a copy of class driver statistics
+void tuh_stats_get(tuh_stats_t* stats);
+
+// Clear all statistics
+void tuh_stats_clear(void);
+#endif
+
+#if CFG_TUH_ENUM_STATS
+// Get enumeration timeline of device, address 0 for the latest device in dev0 stage. Record is kept after device is
+// removed until its address is re-used. Return false if address is invalid
+bool tuh_enum_stats_get(uint8_t daddr, tuh_enum_stats_t* stats);
+#endif
+
 //--------------------------------------------------------------------+
 // Device API
 //--------------------------------------------------------------------+
@@ -177,6 +295,9 @@ bool tuh_rhport_reset_bus(uint8_t rhport, bool active);
 // Get VID/PID of device
 bool tuh_vid_pid_get(uint8_t daddr, uint16_t* vid, uint16_t* pid);
 
+// Get TUH_QUIRK_ flags of device, valid once configuration descriptor is parsed (when class drivers are opened)
+uint16_t tuh_quirks_get(uint8_t daddr);
+
 // Get speed of device
 tusb_speed_t tuh_speed_get(uint8_t daddr);
 
@@ -203,12 +324,14 @@ bool tuh_ready(uint8_t daddr) {
 
 // Submit a control transfer
 //  - async: complete callback invoked when finished.
-//  - sync : blocking if complete callback is NULL.
+//  - sync : blocking if complete callback is NULL, up to timeout_ms. Called from other thread than tuh_task(), it sleeps
+//           on a semaphore; called within tuh_task() e.g from a callback, it runs tuh_task() while waiting.
 bool tuh_control_xfer(tuh_xfer_t* xfer);
 
 // Submit a bulk/interrupt transfer
 //  - async: complete callback invoked when finished.
-//  - sync : blocking if complete callback is NULL.
+//  - sync : blocking if complete callback is NULL (require CFG_TUH_API_EDPT_XFER), same as tuh_control_xfer().
+// With CFG_TUH_EDPT_XFER_QUEUE, async transfer on a busy endpoint is queued and submitted after the on-going ones
 bool tuh_edpt_xfer(tuh_xfer_t* xfer);
 
 // Open a non-control endpoint
@@ -231,6 +354,11 @@ bool tuh_configuration_set(uint8_t daddr, uint8_t config_num,
 bool tuh_interface_set(uint8_t daddr, uint8_t itf_num, uint8_t itf_alt,
                        tuh_xfer_cb_t complete_cb, uintptr_t user_data);
 
+// Clear endpoint halt (control transfer), host side data toggle is reset as well
+// true on success, false if there is on-going control transfer or incorrect parameters
+// if complete_cb == NULL i.e blocking, user_data should be pointed to xfer_reuslt_t*
+bool tuh_edpt_clear_halt(uint8_t daddr, uint8_t ep_addr, tuh_xfer_cb_t complete_cb, uintptr_t user_data);
+
 //--------------------------------------------------------------------+
 // Descriptors Asynchronous (non-blocking)
 //--------------------------------------------------------------------+
@@ -312,6 +440,32 @@ uint8_t tuh_descriptor_get_product_string_sync(uint8_t daddr, uint16_t language_
 // return transfer result
 uint8_t tuh_descriptor_get_serial_string_sync(uint8_t daddr, uint16_t language_id, void* buffer, uint16_t len);
 
+//--------------------------------------------------------------------+
+// Completion Token
+// A token tracks one asynchronous operation: pass tuh_xfer_token_cb() as complete callback and the token as user data
+// (or tuh_msc_token_cb() for MSC commands). Many operations can be in flight, each with its own token, which is
+// then polled, waited or notified on completion. Token must stay valid until operation completes.
+//--------------------------------------------------------------------+
+
+// Init token before submitting operation. Without notify, token can be waited by tuh_xfer_token_wait(): a semaphore
+// is created if called from other thread than usbh task (RTOS), otherwise waiting runs tuh_task().
+void tuh_xfer_token_init(tuh_xfer_token_t* token, tuh_xfer_token_notify_t notify, void* notify_arg);
+
+// Complete callback to be used with tuh_xfer_t and descriptor API, user_data is the token
+void tuh_xfer_token_cb(tuh_xfer_t* xfer);
+
+// Mark token as complete, used by class completion adapter
+void tuh_xfer_token_complete(tuh_xfer_token_t* token, xfer_result_t result, uint32_t actual_len);
+
+// Check if operation is complete
+TU_ATTR_ALWAYS_INLINE static inline bool tuh_xfer_token_done(tuh_xfer_token_t const* token) {
+  return token->result != XFER_RESULT_INVALID;
+}
+
+// Wait for operation to complete, timeout_ms = 0 to wait forever. Return false if timed out: operation is still in
+// flight and must be aborted (or waited again) before token goes out of scope.
+bool tuh_xfer_token_wait(tuh_xfer_token_t* token, uint32_t timeout_ms);
+
 #ifdef __cplusplus
  }
 #endif
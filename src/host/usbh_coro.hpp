@@ -0,0 +1,180 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#ifndef TUSB_USBH_CORO_HPP_
+#define TUSB_USBH_CORO_HPP_
+
+// Optional header-only C++20 coroutine adapter on top of completion token (tuh_xfer_token_t). Host operations are
+// awaited without spinning, coroutine is resumed by tuh_task() when operation completes, e.g
+//
+//   tusb::host_task enumerate(uint8_t daddr) {
+//     auto r = co_await tusb::descriptor_get_device(daddr, &desc, sizeof(desc));
+//     if (r) { ... }
+//   }
+//
+// Not included by tusb.h, application includes it explicitly. No heap allocation except coroutine frame itself.
+
+#include <coroutine>
+#include "tusb.h"
+
+#if CFG_TUH_ENABLED
+
+namespace tusb {
+
+// Result of an awaited operation
+struct xfer_status {
+  xfer_result_t result;
+  uint32_t actual_len;
+
+  explicit operator bool() const { return result == XFER_RESULT_SUCCESS; }
+};
+
+// Awaitable operation, submit is invoked with the token when coroutine is suspended and returns false on failure
+template <typename Submit>
+class xfer_awaiter {
+public:
+  explicit xfer_awaiter(Submit submit) : _submit(submit) {}
+
+  bool await_ready() const noexcept { return false; }
+
+  bool await_suspend(std::coroutine_handle<> h) noexcept {
+    tuh_xfer_token_init(&_token, resume, h.address());
+    if (!_submit(&_token)) {
+      _token.result = XFER_RESULT_FAILED;
+      return false; // resume immediately
+    }
+    // token may already be completed and coroutine resumed by now, do not touch *this
+    return true;
+  }
+
+  xfer_status await_resume() const noexcept { return xfer_status{_token.result, _token.actual_len}; }
+
+private:
+  static void resume(tuh_xfer_token_t* token) {
+    std::coroutine_handle<>::from_address(token->notify_arg).resume();
+  }
+
+  Submit _submit;
+  tuh_xfer_token_t _token;
+};
+
+template <typename Submit>
+xfer_awaiter<Submit> make_awaiter(Submit submit) {
+  return xfer_awaiter<Submit>(submit);
+}
+
+// Fire-and-forget coroutine type, frame is freed once coroutine returns
+struct host_task {
+  struct promise_type {
+    host_task get_return_object() noexcept { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() noexcept {}
+    void unhandled_exception() noexcept {}
+  };
+};
+
+//--------------------------------------------------------------------+
+// Transfer
+//--------------------------------------------------------------------+
+
+// Control transfer, complete_cb and user_data of xfer are ignored
+inline auto control_xfer(tuh_xfer_t xfer) {
+  return make_awaiter([xfer](tuh_xfer_token_t* token) mutable {
+    xfer.complete_cb = tuh_xfer_token_cb;
+    xfer.user_data   = reinterpret_cast<uintptr_t>(token);
+    return tuh_control_xfer(&xfer);
+  });
+}
+
+#if CFG_TUH_API_EDPT_XFER
+// Non-control transfer, complete_cb and user_data of xfer are ignored
+inline auto edpt_xfer(tuh_xfer_t xfer) {
+  return make_awaiter([xfer](tuh_xfer_token_t* token) mutable {
+    xfer.complete_cb = tuh_xfer_token_cb;
+    xfer.user_data   = reinterpret_cast<uintptr_t>(token);
+    return tuh_edpt_xfer(&xfer);
+  });
+}
+#endif
+
+//--------------------------------------------------------------------+
+// Descriptors
+//--------------------------------------------------------------------+
+inline auto descriptor_get(uint8_t daddr, uint8_t type, uint8_t index, void* buffer, uint16_t len) {
+  return make_awaiter([=](tuh_xfer_token_t* token) {
+    return tuh_descriptor_get(daddr, type, index, buffer, len, tuh_xfer_token_cb, reinterpret_cast<uintptr_t>(token));
+  });
+}
+
+inline auto descriptor_get_device(uint8_t daddr, void* buffer, uint16_t len) {
+  return make_awaiter([=](tuh_xfer_token_t* token) {
+    return tuh_descriptor_get_device(daddr, buffer, len, tuh_xfer_token_cb, reinterpret_cast<uintptr_t>(token));
+  });
+}
+
+inline auto descriptor_get_configuration(uint8_t daddr, uint8_t index, void* buffer, uint16_t len) {
+  return make_awaiter([=](tuh_xfer_token_t* token) {
+    return tuh_descriptor_get_configuration(daddr, index, buffer, len, tuh_xfer_token_cb,
+                                            reinterpret_cast<uintptr_t>(token));
+  });
+}
+
+inline auto descriptor_get_string(uint8_t daddr, uint8_t index, uint16_t language_id, void* buffer, uint16_t len) {
+  return make_awaiter([=](tuh_xfer_token_t* token) {
+    return tuh_descriptor_get_string(daddr, index, language_id, buffer, len, tuh_xfer_token_cb,
+                                     reinterpret_cast<uintptr_t>(token));
+  });
+}
+
+//--------------------------------------------------------------------+
+// MSC
+//--------------------------------------------------------------------+
+#if CFG_TUH_MSC
+inline auto msc_scsi_command(uint8_t daddr, msc_cbw_t const* cbw, void* data) {
+  return make_awaiter([=](tuh_xfer_token_t* token) {
+    return tuh_msc_scsi_command(daddr, cbw, data, tuh_msc_token_cb, reinterpret_cast<uintptr_t>(token));
+  });
+}
+
+inline auto msc_read10(uint8_t daddr, uint8_t lun, void* buffer, uint32_t lba, uint16_t block_count) {
+  return make_awaiter([=](tuh_xfer_token_t* token) {
+    return tuh_msc_read10(daddr, lun, buffer, lba, block_count, tuh_msc_token_cb, reinterpret_cast<uintptr_t>(token));
+  });
+}
+
+inline auto msc_write10(uint8_t daddr, uint8_t lun, void const* buffer, uint32_t lba, uint16_t block_count) {
+  return make_awaiter([=](tuh_xfer_token_t* token) {
+    return tuh_msc_write10(daddr, lun, buffer, lba, block_count, tuh_msc_token_cb, reinterpret_cast<uintptr_t>(token));
+  });
+}
+#endif
+
+} // namespace tusb
+
+#endif
+
+#endif
@@ -30,6 +30,7 @@
 #include "osal/osal.h"
 #include "common/tusb_fifo.h"
 #include "common/tusb_private.h"
+#include "host/hcd.h"
 
 #ifdef __cplusplus
  extern "C" {
@@ -71,10 +72,20 @@ uint8_t usbh_get_rhport(uint8_t dev_addr);
 
 uint8_t* usbh_get_enum_buf(void);
 
+// Check if caller is processing an event of tuh_task() i.e. is a callback of usbh
+bool usbh_in_task(void);
+
 void usbh_int_set(bool enabled);
 
 void usbh_defer_func(osal_task_func_t func, void *param, bool in_isr);
 
+// Defer with priority (tu_defer_prio_t). With CFG_TUH_DEFER_POOL_SIZE, a pending call with the same func and param
+// is not queued again, higher priority pending calls are invoked first. ISR callers must be the USB interrupt.
+void usbh_defer_func_prio(osal_task_func_t func, void *param, uint8_t prio, bool in_isr);
+
+// Call func(param) in usbh task after delay_ms, a pending call with the same func and param is re-scheduled
+bool usbh_defer_func_ms(osal_task_func_t func, void *param, uint32_t delay_ms);
+
 //--------------------------------------------------------------------+
 // USBH Endpoint API
 //--------------------------------------------------------------------+
@@ -88,6 +99,10 @@ static inline bool usbh_edpt_xfer(uint8_t dev_addr, uint8_t ep_addr, uint8_t * b
   return usbh_edpt_xfer_with_callback(dev_addr, ep_addr, buffer, total_bytes, NULL, 0);
 }
 
+// Submit an isochronous transfer, can be called again while previous one is in progress. See hcd_edpt_iso_xfer()
+bool usbh_edpt_iso_xfer(uint8_t dev_addr, uint8_t ep_addr, uint8_t* buffer, hcd_iso_packet_t* packets,
+                        uint16_t n_packets);
+
 // Claim an endpoint before submitting a transfer.
 // If caller does not make any transfer, it must release endpoint for others.
 bool usbh_edpt_claim(uint8_t dev_addr, uint8_t ep_addr);
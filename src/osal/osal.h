@@ -71,6 +71,10 @@ typedef void (*osal_task_func_t)( void * );
   #error OS is not supported yet
 #endif
 
+#if CFG_TUSB_CORE_AFFINITY >= 0 && !(CFG_TUSB_OS == OPT_OS_PICO || (CFG_TUSB_OS == OPT_OS_FREERTOS && defined(ESP_PLATFORM)))
+  #error "CFG_TUSB_CORE_AFFINITY is only supported with pico-sdk and ESP-IDF"
+#endif
+
 //--------------------------------------------------------------------+
 // OSAL Porting API
 // Should be implemented as static inline function in osal_port.h header
@@ -89,8 +93,11 @@ typedef void (*osal_task_func_t)( void * );
    osal_queue_t osal_queue_create(osal_queue_def_t* qdef);
    bool osal_queue_delete(osal_queue_t qhdl);
    bool osal_queue_receive(osal_queue_t qhdl, void* data, uint32_t msec);
+   uint16_t osal_queue_receive_n(osal_queue_t qhdl, void* data, uint16_t n, uint32_t msec); // OS None, Pico & FreeRTOS notify only
    bool osal_queue_send(osal_queue_t qhdl, void const * data, bool in_isr);
    bool osal_queue_empty(osal_queue_t qhdl);
+
+   uint8_t osal_core_id(void); // multi-core only, required by CFG_TUSB_CORE_AFFINITY
 */
 //--------------------------------------------------------------------+
 
@@ -41,17 +41,57 @@ extern "C" {
 // MACRO CONSTANT TYPEDEF PROTYPES
 //--------------------------------------------------------------------+
 
+#if CFG_TUSB_OS_FREERTOS_STATIC_ONLY && !configSUPPORT_STATIC_ALLOCATION
+  #error "CFG_TUSB_OS_FREERTOS_STATIC_ONLY requires configSUPPORT_STATIC_ALLOCATION"
+#endif
+
+#if CFG_TUSB_OS_FREERTOS_STATIC_ONLY && defined(CFG_TUH_MAX3421) && CFG_TUH_MAX3421
+  #error "MAX3421 blocks while holding its SPI mutex, which is not supported with CFG_TUSB_OS_FREERTOS_STATIC_ONLY"
+#endif
+
 #if configSUPPORT_STATIC_ALLOCATION
   typedef StaticSemaphore_t osal_semaphore_def_t;
-  typedef StaticSemaphore_t osal_mutex_def_t;
 #else
   // not used therefore defined to smallest possible type to save space
   typedef uint8_t osal_semaphore_def_t;
-  typedef uint8_t osal_mutex_def_t;
 #endif
 
 typedef SemaphoreHandle_t osal_semaphore_t;
-typedef SemaphoreHandle_t osal_mutex_t;
+
+#if CFG_TUSB_OS_FREERTOS_STATIC_ONLY
+  // no mutex object: mutex is scheduler suspension
+  typedef uint8_t osal_mutex_def_t;
+  typedef osal_mutex_def_t* osal_mutex_t;
+#elif configSUPPORT_STATIC_ALLOCATION
+  typedef StaticSemaphore_t osal_mutex_def_t;
+  typedef SemaphoreHandle_t osal_mutex_t;
+#else
+  typedef uint8_t osal_mutex_def_t;
+  typedef SemaphoreHandle_t osal_mutex_t;
+#endif
+
+#if CFG_TUSB_OS_FREERTOS_QUEUE_NOTIFY
+#include "common/tusb_fifo.h"
+
+// Single consumer (usbd/usbh task) lock-free fifo. Producers are serialized by a short critical section, or by
+// tu_fifo itself with CFG_TUSB_FIFO_ISR_SAFE. Consumer task is woken up by direct-to-task notification.
+typedef struct {
+  tu_fifo_t ff;
+  TaskHandle_t volatile waiter; // consumer task, registered on receive
+#ifdef ESP_PLATFORM
+  portMUX_TYPE mux;
+#endif
+} osal_queue_def_t;
+
+typedef osal_queue_def_t* osal_queue_t;
+
+// _int_set is not used with an RTOS
+#define OSAL_QUEUE_DEF(_int_set, _name, _depth, _type) \
+  static uint8_t _name##_##buf[_depth*sizeof(_type)];\
+  osal_queue_def_t _name = { .ff = TU_FIFO_INIT(_name##_##buf, _depth, _type, false) }
+
+#else
+
 typedef QueueHandle_t osal_queue_t;
 
 typedef struct
@@ -80,6 +120,8 @@ typedef struct
   static _type _name##_##buf[_depth];\
   osal_queue_def_t _name = { .depth = _depth, .item_sz = sizeof(_type), .buf = _name##_##buf, _OSAL_Q_NAME(_name) }
 
+#endif
+
 //--------------------------------------------------------------------+
 // TASK API
 //--------------------------------------------------------------------+
@@ -101,6 +143,12 @@ TU_ATTR_ALWAYS_INLINE static inline void osal_task_delay(uint32_t msec) {
   vTaskDelay(pdMS_TO_TICKS(msec));
 }
 
+#ifdef ESP_PLATFORM
+TU_ATTR_ALWAYS_INLINE static inline uint8_t osal_core_id(void) {
+  return (uint8_t) xPortGetCoreID();
+}
+#endif
+
 //--------------------------------------------------------------------+
 // Semaphore API
 //--------------------------------------------------------------------+
@@ -149,6 +197,32 @@ TU_ATTR_ALWAYS_INLINE static inline void osal_semaphore_reset(osal_semaphore_t c
 // MUTEX API (priority inheritance)
 //--------------------------------------------------------------------+
 
+#if CFG_TUSB_OS_FREERTOS_STATIC_ONLY
+
+TU_ATTR_ALWAYS_INLINE static inline osal_mutex_t osal_mutex_create(osal_mutex_def_t *mdef) {
+  return mdef;
+}
+
+TU_ATTR_ALWAYS_INLINE static inline bool osal_mutex_delete(osal_mutex_t mutex_hdl) {
+  (void) mutex_hdl;
+  return true;
+}
+
+TU_ATTR_ALWAYS_INLINE static inline bool osal_mutex_lock(osal_mutex_t mutex_hdl, uint32_t msec) {
+  (void) mutex_hdl;
+  (void) msec;
+  vTaskSuspendAll();
+  return true;
+}
+
+TU_ATTR_ALWAYS_INLINE static inline bool osal_mutex_unlock(osal_mutex_t mutex_hdl) {
+  (void) mutex_hdl;
+  (void) xTaskResumeAll();
+  return true;
+}
+
+#else
+
 TU_ATTR_ALWAYS_INLINE static inline osal_mutex_t osal_mutex_create(osal_mutex_def_t *mdef) {
 #if configSUPPORT_STATIC_ALLOCATION
   return xSemaphoreCreateMutexStatic(mdef);
@@ -171,10 +245,135 @@ TU_ATTR_ALWAYS_INLINE static inline bool osal_mutex_unlock(osal_mutex_t mutex_hd
   return xSemaphoreGive(mutex_hdl);
 }
 
+#endif
+
 //--------------------------------------------------------------------+
 // QUEUE API
 //--------------------------------------------------------------------+
 
+#if CFG_TUSB_OS_FREERTOS_QUEUE_NOTIFY
+
+TU_ATTR_ALWAYS_INLINE static inline UBaseType_t _osal_q_lock(osal_queue_t qhdl, bool in_isr) {
+#ifdef ESP_PLATFORM
+  if (in_isr) {
+    taskENTER_CRITICAL_ISR(&qhdl->mux);
+  } else {
+    taskENTER_CRITICAL(&qhdl->mux);
+  }
+  return 0;
+#else
+  (void) qhdl;
+  if (in_isr) {
+    return taskENTER_CRITICAL_FROM_ISR();
+  }
+  taskENTER_CRITICAL();
+  return 0;
+#endif
+}
+
+TU_ATTR_ALWAYS_INLINE static inline void _osal_q_unlock(osal_queue_t qhdl, bool in_isr, UBaseType_t state) {
+#ifdef ESP_PLATFORM
+  (void) state;
+  if (in_isr) {
+    taskEXIT_CRITICAL_ISR(&qhdl->mux);
+  } else {
+    taskEXIT_CRITICAL(&qhdl->mux);
+  }
+#else
+  (void) qhdl;
+  if (in_isr) {
+    taskEXIT_CRITICAL_FROM_ISR(state);
+  } else {
+    taskEXIT_CRITICAL();
+  }
+#endif
+}
+
+// Register calling task as consumer to be notified. Queues received by the same task share its notification:
+// waiting on a queue also wakes up (and returns empty) on events of the others.
+TU_ATTR_ALWAYS_INLINE static inline void _osal_q_set_waiter(osal_queue_t qhdl) {
+  TaskHandle_t const task = xTaskGetCurrentTaskHandle();
+  if (qhdl->waiter != task) {
+    qhdl->waiter = task;
+  }
+}
+
+TU_ATTR_ALWAYS_INLINE static inline osal_queue_t osal_queue_create(osal_queue_def_t* qdef) {
+  tu_fifo_clear(&qdef->ff);
+  qdef->waiter = NULL;
+#ifdef ESP_PLATFORM
+  portMUX_INITIALIZE(&qdef->mux);
+#endif
+#if CFG_TUSB_FIFO_ISR_SAFE
+  tu_fifo_set_isr_safe(&qdef->ff, true);
+#endif
+  return (osal_queue_t) qdef;
+}
+
+TU_ATTR_ALWAYS_INLINE static inline bool osal_queue_delete(osal_queue_t qhdl) {
+  qhdl->waiter = NULL;
+  return true;
+}
+
+TU_ATTR_ALWAYS_INLINE static inline bool osal_queue_receive(osal_queue_t qhdl, void* data, uint32_t msec) {
+  _osal_q_set_waiter(qhdl);
+  if (tu_fifo_read(&qhdl->ff, data)) {
+    return true;
+  }
+  if (msec == 0) {
+    return false;
+  }
+
+  // pending notification (event sent after above read) returns immediately
+  (void) ulTaskNotifyTake(pdTRUE, _osal_ms2tick(msec));
+  return tu_fifo_read(&qhdl->ff, data);
+}
+
+TU_ATTR_ALWAYS_INLINE static inline uint16_t osal_queue_receive_n(osal_queue_t qhdl, void* data, uint16_t n, uint32_t msec) {
+  _osal_q_set_waiter(qhdl);
+  uint16_t count = (uint16_t) tu_fifo_read_n(&qhdl->ff, data, n);
+  if (count == 0 && msec != 0) {
+    (void) ulTaskNotifyTake(pdTRUE, _osal_ms2tick(msec));
+    count = (uint16_t) tu_fifo_read_n(&qhdl->ff, data, n);
+  }
+  return count;
+}
+
+// Sender does not block when queue is full, same as OS None
+TU_ATTR_ALWAYS_INLINE static inline bool osal_queue_send(osal_queue_t qhdl, void const *data, bool in_isr) {
+#if CFG_TUSB_FIFO_ISR_SAFE
+  bool const success = tu_fifo_write(&qhdl->ff, data);
+#else
+  UBaseType_t const state = _osal_q_lock(qhdl, in_isr);
+  bool const success = tu_fifo_write(&qhdl->ff, data);
+  _osal_q_unlock(qhdl, in_isr, state);
+#endif
+
+  TaskHandle_t const waiter = qhdl->waiter;
+  if (success && waiter != NULL) {
+    if (!in_isr) {
+      (void) xTaskNotifyGive(waiter);
+    } else {
+      BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+      vTaskNotifyGiveFromISR(waiter, &xHigherPriorityTaskWoken);
+
+#if CFG_TUSB_MCU == OPT_MCU_ESP32S2 || CFG_TUSB_MCU == OPT_MCU_ESP32S3
+      if ( xHigherPriorityTaskWoken ) portYIELD_FROM_ISR();
+#else
+      portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+#endif
+    }
+  }
+
+  return success;
+}
+
+TU_ATTR_ALWAYS_INLINE static inline bool osal_queue_empty(osal_queue_t qhdl) {
+  return tu_fifo_empty(&qhdl->ff);
+}
+
+#else
+
 TU_ATTR_ALWAYS_INLINE static inline osal_queue_t osal_queue_create(osal_queue_def_t* qdef) {
   osal_queue_t q;
 
@@ -222,6 +421,8 @@ TU_ATTR_ALWAYS_INLINE static inline bool osal_queue_empty(osal_queue_t qhdl) {
   return uxQueueMessagesWaiting(qhdl) == 0;
 }
 
+#endif
+
 #ifdef __cplusplus
 }
 #endif
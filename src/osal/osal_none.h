@@ -149,8 +149,29 @@ TU_ATTR_ALWAYS_INLINE static inline void _osal_q_unlock(osal_queue_t qhdl) {
   qhdl->interrupt_set(true);
 }
 
+// Lock-free consumer side: fifo is lock-free for single producer (ISR) and single consumer (task)
+#if CFG_TUSB_OS_NONE_QUEUE_LOCKFREE
+  #define _osal_q_rd_lock(_qhdl)
+  #define _osal_q_rd_unlock(_qhdl)
+#else
+  #define _osal_q_rd_lock(_qhdl)    _osal_q_lock(_qhdl)
+  #define _osal_q_rd_unlock(_qhdl)  _osal_q_unlock(_qhdl)
+#endif
+
+// Task producer can skip lock if fifo supports multiple producers (with short critical section)
+#if CFG_TUSB_OS_NONE_QUEUE_LOCKFREE && CFG_TUSB_FIFO_ISR_SAFE
+  #define _osal_q_wr_lock(_qhdl)
+  #define _osal_q_wr_unlock(_qhdl)
+#else
+  #define _osal_q_wr_lock(_qhdl)    _osal_q_lock(_qhdl)
+  #define _osal_q_wr_unlock(_qhdl)  _osal_q_unlock(_qhdl)
+#endif
+
 TU_ATTR_ALWAYS_INLINE static inline osal_queue_t osal_queue_create(osal_queue_def_t* qdef) {
   tu_fifo_clear(&qdef->ff);
+  #if CFG_TUSB_OS_NONE_QUEUE_LOCKFREE && CFG_TUSB_FIFO_ISR_SAFE
+  tu_fifo_set_isr_safe(&qdef->ff, true);
+  #endif
   return (osal_queue_t) qdef;
 }
 
@@ -162,22 +183,33 @@ TU_ATTR_ALWAYS_INLINE static inline bool osal_queue_delete(osal_queue_t qhdl) {
 TU_ATTR_ALWAYS_INLINE static inline bool osal_queue_receive(osal_queue_t qhdl, void* data, uint32_t msec) {
   (void) msec; // not used, always behave as msec = 0
 
-  _osal_q_lock(qhdl);
+  _osal_q_rd_lock(qhdl);
   bool success = tu_fifo_read(&qhdl->ff, data);
-  _osal_q_unlock(qhdl);
+  _osal_q_rd_unlock(qhdl);
 
   return success;
 }
 
+// Receive up to n items with a single lock, return number of received items
+TU_ATTR_ALWAYS_INLINE static inline uint16_t osal_queue_receive_n(osal_queue_t qhdl, void* data, uint16_t n, uint32_t msec) {
+  (void) msec; // not used, always behave as msec = 0
+
+  _osal_q_rd_lock(qhdl);
+  uint16_t count = (uint16_t) tu_fifo_read_n(&qhdl->ff, data, n);
+  _osal_q_rd_unlock(qhdl);
+
+  return count;
+}
+
 TU_ATTR_ALWAYS_INLINE static inline bool osal_queue_send(osal_queue_t qhdl, void const* data, bool in_isr) {
   if (!in_isr) {
-    _osal_q_lock(qhdl);
+    _osal_q_wr_lock(qhdl);
   }
 
   bool success = tu_fifo_write(&qhdl->ff, data);
 
   if (!in_isr) {
-    _osal_q_unlock(qhdl);
+    _osal_q_wr_unlock(qhdl);
   }
 
   return success;
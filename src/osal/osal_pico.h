@@ -31,6 +31,7 @@
 #include "pico/sem.h"
 #include "pico/mutex.h"
 #include "pico/critical_section.h"
+#include "hardware/sync.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -43,6 +44,10 @@ TU_ATTR_ALWAYS_INLINE static inline void osal_task_delay(uint32_t msec) {
   sleep_ms(msec);
 }
 
+TU_ATTR_ALWAYS_INLINE static inline uint8_t osal_core_id(void) {
+  return (uint8_t) get_core_num();
+}
+
 //--------------------------------------------------------------------+
 // Binary Semaphore API
 //--------------------------------------------------------------------+
@@ -116,8 +121,23 @@ typedef osal_queue_def_t* osal_queue_t;
     .ff = TU_FIFO_INIT(_name##_buf, _depth, _type, false) \
   }
 
+// With CFG_TUSB_CORE_AFFINITY, queue is only received by usbd/usbh task on the pinned core (single consumer) which
+// does not need to lock. Senders (USB IRQ and other cores) are serialized by a dedicated spinlock, instead of
+// one from the striped pool shared with other pico-sdk users.
+#if CFG_TUSB_CORE_AFFINITY >= 0
+  #define _osal_q_rd_lock(_qhdl)
+  #define _osal_q_rd_unlock(_qhdl)
+#else
+  #define _osal_q_rd_lock(_qhdl)    critical_section_enter_blocking(&(_qhdl)->critsec)
+  #define _osal_q_rd_unlock(_qhdl)  critical_section_exit(&(_qhdl)->critsec)
+#endif
+
 TU_ATTR_ALWAYS_INLINE static inline osal_queue_t osal_queue_create(osal_queue_def_t* qdef) {
+#if CFG_TUSB_CORE_AFFINITY >= 0
+  critical_section_init_with_lock_num(&qdef->critsec, (uint) spin_lock_claim_unused(true));
+#else
   critical_section_init(&qdef->critsec);
+#endif
   tu_fifo_clear(&qdef->ff);
   return (osal_queue_t) qdef;
 }
@@ -131,13 +151,24 @@ TU_ATTR_ALWAYS_INLINE static inline bool osal_queue_delete(osal_queue_t qhdl) {
 TU_ATTR_ALWAYS_INLINE static inline bool osal_queue_receive(osal_queue_t qhdl, void* data, uint32_t msec) {
   (void) msec; // not used, always behave as msec = 0
 
-  critical_section_enter_blocking(&qhdl->critsec);
+  _osal_q_rd_lock(qhdl);
   bool success = tu_fifo_read(&qhdl->ff, data);
-  critical_section_exit(&qhdl->critsec);
+  _osal_q_rd_unlock(qhdl);
 
   return success;
 }
 
+// Receive up to n items with a single lock, return number of received items
+TU_ATTR_ALWAYS_INLINE static inline uint16_t osal_queue_receive_n(osal_queue_t qhdl, void* data, uint16_t n, uint32_t msec) {
+  (void) msec; // not used, always behave as msec = 0
+
+  _osal_q_rd_lock(qhdl);
+  uint16_t count = (uint16_t) tu_fifo_read_n(&qhdl->ff, data, n);
+  _osal_q_rd_unlock(qhdl);
+
+  return count;
+}
+
 TU_ATTR_ALWAYS_INLINE static inline bool osal_queue_send(osal_queue_t qhdl, void const* data, bool in_isr) {
   (void) in_isr;
 
@@ -120,4 +120,20 @@ TU_ATTR_ALWAYS_INLINE static inline bool osal_queue_empty(osal_queue_t qhdl) {
   return 0 == k_msgq_num_used_get(qhdl);
 }
 
+#if defined(CONFIG_POLL) && CONFIG_POLL
+// Block until any of queues has data (or timeout) with a single k_poll(), used by usbd to wait on its priority lanes
+// without a doorbell semaphore. Data is then read with osal_queue_receive() without waiting
+#define OSAL_QUEUE_WAIT_ANY_MAX  4
+#define OSAL_QUEUE_WAIT_ANY      1
+
+TU_ATTR_ALWAYS_INLINE static inline bool osal_queue_wait_any(osal_queue_t const* qhdls, uint8_t count, uint32_t msec) {
+  struct k_poll_event events[OSAL_QUEUE_WAIT_ANY_MAX];
+  count = (uint8_t) (count < OSAL_QUEUE_WAIT_ANY_MAX ? count : OSAL_QUEUE_WAIT_ANY_MAX);
+  for (uint8_t i = 0; i < count; i++) {
+    k_poll_event_init(&events[i], K_POLL_TYPE_MSGQ_DATA_AVAILABLE, K_POLL_MODE_NOTIFY_ONLY, qhdls[i]);
+  }
+  return 0 == k_poll(events, count, (msec == OSAL_TIMEOUT_WAIT_FOREVER) ? K_FOREVER : K_MSEC(msec));
+}
+#endif
+
 #endif
@@ -171,6 +171,10 @@ enum {
   MAX_NAK_DEFAULT = 1 // Number of NAK per endpoint per usb frame to save CPU/SPI bus usage
 };
 
+enum {
+  SPI_BATCH_MAX = 6 // PERADDR, HCTL, SNDFIFO, SNDBC, HXFR of an OUT transaction + spare
+};
+
 enum {
   EP_STATE_IDLE        = 0,
   EP_STATE_COMPLETE    = 1,
@@ -235,6 +239,14 @@ typedef struct {
 
   atomic_flag busy; // busy transferring
 
+  // register writes queued by spi_batch_begin(), sent together by spi_batch_end()
+  struct {
+    bool active;
+    uint8_t count;
+    uint8_t reg_data[SPI_BATCH_MAX];
+    tuh_max3421_spi_xact_t xact[SPI_BATCH_MAX];
+  } batch;
+
 #if OSAL_MUTEX_REQUIRED
   OSAL_MUTEX_DEF(spi_mutexdef);
   osal_mutex_t spi_mutex;
@@ -268,6 +280,11 @@ extern bool tuh_max3421_spi_xfer_api(uint8_t rhport, uint8_t const* tx_buf, uint
 // API to enable/disable MAX3421 INTR pin interrupt
 extern void tuh_max3421_int_api(uint8_t rhport, bool enabled);
 
+// API to send a list of write transactions, each is framed by its own CS assertion. Optional, default implementation
+// uses spi_cs_api() and spi_xfer_api(). Application can implement it with chained DMA and return before completion:
+// in that case next call to spi_cs_api() or spi_xfer_list_api() must wait for the list to complete.
+TU_ATTR_WEAK bool tuh_max3421_spi_xfer_list_api(uint8_t rhport, tuh_max3421_spi_xact_t const* xacts, uint8_t count);
+
 // API to read MAX3421's register. Implemented by TinyUSB
 uint8_t tuh_max3421_reg_read(uint8_t rhport, uint8_t reg, bool in_isr);
 
@@ -281,12 +298,31 @@ bool tuh_max3421_reg_write(uint8_t rhport, uint8_t reg, uint8_t data, bool in_is
 #define reg_read  tuh_max3421_reg_read
 #define reg_write tuh_max3421_reg_write
 
-static void max3421_spi_lock(uint8_t rhport, bool in_isr) {
+static void spi_batch_send(uint8_t rhport);
+
+static void max3421_spi_acquire(uint8_t rhport, bool in_isr) {
   // disable interrupt and mutex lock (for pre-emptive RTOS) if not in_isr
   if (!in_isr) {
     (void) osal_mutex_lock(_hcd_data.spi_mutex, OSAL_TIMEOUT_WAIT_FOREVER);
     tuh_max3421_int_api(rhport, false);
   }
+}
+
+static void max3421_spi_release(uint8_t rhport, bool in_isr) {
+  // mutex unlock and re-enable interrupt
+  if (!in_isr) {
+    tuh_max3421_int_api(rhport, true);
+    (void) osal_mutex_unlock(_hcd_data.spi_mutex);
+  }
+}
+
+static void max3421_spi_lock(uint8_t rhport, bool in_isr) {
+  if (_hcd_data.batch.active) {
+    // already acquired by spi_batch_begin(), queued writes must reach MAX3421 before this transfer
+    spi_batch_send(rhport);
+  } else {
+    max3421_spi_acquire(rhport, in_isr);
+  }
 
   // assert CS
   tuh_max3421_spi_cs_api(rhport, true);
@@ -296,13 +332,64 @@ static void max3421_spi_unlock(uint8_t rhport, bool in_isr) {
   // de-assert CS
   tuh_max3421_spi_cs_api(rhport, false);
 
-  // mutex unlock and re-enable interrupt
-  if (!in_isr) {
-    tuh_max3421_int_api(rhport, true);
-    (void) osal_mutex_unlock(_hcd_data.spi_mutex);
+  if (!_hcd_data.batch.active) {
+    max3421_spi_release(rhport, in_isr);
   }
 }
 
+TU_ATTR_WEAK bool tuh_max3421_spi_xfer_list_api(uint8_t rhport, tuh_max3421_spi_xact_t const* xacts, uint8_t count) {
+  bool ret = true;
+  for (uint8_t i = 0; i < count; i++) {
+    tuh_max3421_spi_cs_api(rhport, true);
+    ret = tuh_max3421_spi_xfer_api(rhport, &xacts[i].cmd, NULL, 1) && ret;
+    if (xacts[i].len) {
+      ret = tuh_max3421_spi_xfer_api(rhport, xacts[i].data, NULL, xacts[i].len) && ret;
+    }
+    tuh_max3421_spi_cs_api(rhport, false);
+  }
+  return ret;
+}
+
+// Queue register/FIFO writes until spi_batch_end(), so that a whole transaction setup is sent with one SPI lock and
+// one list transfer. SPI is held for the whole batch, reads in between send queued writes first.
+static void spi_batch_begin(uint8_t rhport, bool in_isr) {
+  max3421_spi_acquire(rhport, in_isr);
+  _hcd_data.batch.active = true;
+}
+
+static void spi_batch_send(uint8_t rhport) {
+  if (_hcd_data.batch.count == 0) return;
+  (void) tuh_max3421_spi_xfer_list_api(rhport, _hcd_data.batch.xact, _hcd_data.batch.count);
+  _hcd_data.batch.count = 0;
+}
+
+static void spi_batch_end(uint8_t rhport, bool in_isr) {
+  spi_batch_send(rhport);
+  _hcd_data.batch.active = false;
+  max3421_spi_release(rhport, in_isr);
+}
+
+// Append a write transaction to the batch, return false if batching is not active
+static bool spi_batch_write(uint8_t rhport, uint8_t reg, const uint8_t* data, uint8_t len) {
+  if (!_hcd_data.batch.active) return false;
+
+  if (_hcd_data.batch.count == SPI_BATCH_MAX) {
+    spi_batch_send(rhport);
+  }
+
+  const uint8_t idx = _hcd_data.batch.count++;
+  tuh_max3421_spi_xact_t* xact = &_hcd_data.batch.xact[idx];
+  xact->cmd = reg | CMDBYTE_WRITE;
+  xact->len = len;
+  if (data) {
+    xact->data = data;
+  } else {
+    // single register value is kept in batch storage
+    xact->data = &_hcd_data.batch.reg_data[idx];
+  }
+  return true;
+}
+
 uint8_t tuh_max3421_reg_read(uint8_t rhport, uint8_t reg, bool in_isr) {
   uint8_t tx_buf[2] = {reg, 0};
   uint8_t rx_buf[2] = {0, 0};
@@ -316,6 +403,11 @@ uint8_t tuh_max3421_reg_read(uint8_t rhport, uint8_t reg, bool in_isr) {
 }
 
 bool tuh_max3421_reg_write(uint8_t rhport, uint8_t reg, uint8_t data, bool in_isr) {
+  if (spi_batch_write(rhport, reg, NULL, 1)) {
+    _hcd_data.batch.reg_data[_hcd_data.batch.count - 1] = data;
+    return true;
+  }
+
   uint8_t tx_buf[2] = {reg | CMDBYTE_WRITE, data};
   uint8_t rx_buf[2] = {0, 0};
 
@@ -369,6 +461,8 @@ TU_ATTR_ALWAYS_INLINE static inline void sndbc_write(uint8_t rhport, uint8_t dat
 // FIFO access (receive, send, setup)
 //--------------------------------------------------------------------
 static void hwfifo_write(uint8_t rhport, uint8_t reg, const uint8_t* buffer, uint8_t len, bool in_isr) {
+  if (spi_batch_write(rhport, reg, buffer, len)) return;
+
   uint8_t hirq;
   reg |= CMDBYTE_WRITE;
 
@@ -705,7 +799,7 @@ static void xact_setup(uint8_t rhport, max3421_ep_t *ep, bool in_isr) {
   hxfr_write(rhport, HXFR_SETUP, in_isr);
 }
 
-static void xact_generic(uint8_t rhport, max3421_ep_t *ep, bool switch_ep, bool in_isr) {
+static void xact_generic_unbatched(uint8_t rhport, max3421_ep_t *ep, bool switch_ep, bool in_isr) {
   if (ep->hxfr_bm.ep_num == 0 ) {
     // setup
     if (ep->hxfr_bm.is_setup) {
@@ -729,6 +823,13 @@ static void xact_generic(uint8_t rhport, max3421_ep_t *ep, bool switch_ep, bool
   }
 }
 
+// Start transaction of endpoint, all register and FIFO writes are sent as one batch
+static void xact_generic(uint8_t rhport, max3421_ep_t *ep, bool switch_ep, bool in_isr) {
+  spi_batch_begin(rhport, in_isr);
+  xact_generic_unbatched(rhport, ep, switch_ep, in_isr);
+  spi_batch_end(rhport, in_isr);
+}
+
 // Submit a transfer, when complete hcd_event_xfer_complete() must be invoked
 bool hcd_edpt_xfer(uint8_t rhport, uint8_t daddr, uint8_t ep_addr, uint8_t * buffer, uint16_t buflen) {
   uint8_t const ep_num = tu_edpt_number(ep_addr);
@@ -787,7 +888,7 @@ bool hcd_setup_send(uint8_t rhport, uint8_t daddr, uint8_t const setup_packet[8]
 
   // carry out transfer if not busy
   if (!atomic_flag_test_and_set(&_hcd_data.busy)) {
-    xact_setup(rhport, ep, false);
+    xact_generic(rhport, ep, true, false);
   }
 
   return true;
@@ -974,7 +1075,7 @@ static void handle_xfer_done(uint8_t rhport, bool in_isr) {
     if (xact_len < ep->packet_size || ep->xferred_len >= ep->total_len) {
       xfer_complete_isr(rhport, ep, xfer_result, hrsl, in_isr);
     } else {
-      xact_out(rhport, ep, false, in_isr); // more to transfer
+      xact_generic(rhport, ep, false, in_isr); // more to transfer
     }
   }
 }
@@ -77,17 +77,63 @@ TU_ATTR_ALWAYS_INLINE static inline bool imxrt_is_cache_mem(uintptr_t addr) {
   return !(0x20000000 <= addr && addr < 0x20100000);
 }
 
-TU_ATTR_ALWAYS_INLINE static inline bool imxrt_dcache_clean(void const* addr, uint32_t data_size) {
+// Batched maintenance: operations by line are issued without barrier while batch is open in the same execution
+// context (thread or exception number), outermost end completes them with a single barrier. Other contexts
+// (e.g ISR preempting the batch) still use the complete operation.
+typedef struct {
+  uint8_t depth;
+  uint32_t ipsr;
+} imxrt_dcache_batch_t;
+
+TU_ATTR_ALWAYS_INLINE static inline bool imxrt_dcache_batching(const imxrt_dcache_batch_t* batch) {
+  return batch->depth > 0 && batch->ipsr == __get_IPSR();
+}
+
+TU_ATTR_ALWAYS_INLINE static inline void imxrt_dcache_batch_begin(imxrt_dcache_batch_t* batch) {
+  if (batch->depth == 0) {
+    batch->ipsr = __get_IPSR();
+  }
+  if (batch->ipsr == __get_IPSR()) {
+    batch->depth++;
+  }
+}
+
+TU_ATTR_ALWAYS_INLINE static inline void imxrt_dcache_batch_end(imxrt_dcache_batch_t* batch) {
+  if (imxrt_dcache_batching(batch)) {
+    batch->depth--;
+    if (batch->depth == 0) {
+      __DSB();
+      __ISB();
+    }
+  }
+}
+
+// Maintenance operation by line (op_reg is SCB->DCCMVAC, DCIMVAC or DCCIMVAC), barrier is up to caller
+TU_ATTR_ALWAYS_INLINE static inline void imxrt_dcache_op_by_line(volatile uint32_t* op_reg, uintptr_t addr,
+                                                                 uint32_t size) {
+  const uintptr_t end = addr + round_up_to_cache_line_size(size);
+  for (; addr < end; addr += CFG_TUD_MEM_DCACHE_LINE_SIZE) {
+    *op_reg = (uint32_t) addr;
+  }
+}
+
+TU_ATTR_ALWAYS_INLINE static inline bool imxrt_dcache_clean(void const* addr, uint32_t data_size,
+                                                            const imxrt_dcache_batch_t* batch) {
   const uintptr_t addr32 = (uintptr_t) addr;
   if (imxrt_is_cache_mem(addr32)) {
     TU_ASSERT(tu_is_aligned32(addr32));
     data_size = round_up_to_cache_line_size(data_size);
-    SCB_CleanDCache_by_Addr((uint32_t *) addr32, (int32_t) data_size);
+    if (imxrt_dcache_batching(batch)) {
+      imxrt_dcache_op_by_line(&SCB->DCCMVAC, addr32, data_size);
+    } else {
+      SCB_CleanDCache_by_Addr((uint32_t *) addr32, (int32_t) data_size);
+    }
   }
   return true;
 }
 
-TU_ATTR_ALWAYS_INLINE static inline bool imxrt_dcache_invalidate(void const* addr, uint32_t data_size) {
+TU_ATTR_ALWAYS_INLINE static inline bool imxrt_dcache_invalidate(void const* addr, uint32_t data_size,
+                                                                 const imxrt_dcache_batch_t* batch) {
   const uintptr_t addr32 = (uintptr_t) addr;
   if (imxrt_is_cache_mem(addr32)) {
     // Invalidating does not push cached changes back to RAM so we need to be
@@ -95,17 +141,26 @@ TU_ATTR_ALWAYS_INLINE static inline bool imxrt_dcache_invalidate(void const* add
     // values back to their RAM state.
     TU_ASSERT(tu_is_aligned32(addr32));
     data_size = round_up_to_cache_line_size(data_size);
-    SCB_InvalidateDCache_by_Addr((void*) addr32, (int32_t) data_size);
+    if (imxrt_dcache_batching(batch)) {
+      imxrt_dcache_op_by_line(&SCB->DCIMVAC, addr32, data_size);
+    } else {
+      SCB_InvalidateDCache_by_Addr((void*) addr32, (int32_t) data_size);
+    }
   }
   return true;
 }
 
-TU_ATTR_ALWAYS_INLINE static inline bool imxrt_dcache_clean_invalidate(void const* addr, uint32_t data_size) {
+TU_ATTR_ALWAYS_INLINE static inline bool imxrt_dcache_clean_invalidate(void const* addr, uint32_t data_size,
+                                                                       const imxrt_dcache_batch_t* batch) {
   const uintptr_t addr32 = (uintptr_t) addr;
   if (imxrt_is_cache_mem(addr32)) {
     TU_ASSERT(tu_is_aligned32(addr32));
     data_size = round_up_to_cache_line_size(data_size);
-    SCB_CleanInvalidateDCache_by_Addr((uint32_t *) addr32, (int32_t) data_size);
+    if (imxrt_dcache_batching(batch)) {
+      imxrt_dcache_op_by_line(&SCB->DCCIMVAC, addr32, data_size);
+    } else {
+      SCB_CleanInvalidateDCache_by_Addr((uint32_t *) addr32, (int32_t) data_size);
+    }
   }
   return true;
 }
@@ -35,16 +35,26 @@
   #include "ci_hs_imxrt.h"
 
 #if CFG_TUD_MEM_DCACHE_ENABLE
+static imxrt_dcache_batch_t _dcache_batch;
+
 bool dcd_dcache_clean(void const* addr, uint32_t data_size) {
-  return imxrt_dcache_clean(addr, data_size);
+  return imxrt_dcache_clean(addr, data_size, &_dcache_batch);
 }
 
 bool dcd_dcache_invalidate(void const* addr, uint32_t data_size) {
-  return imxrt_dcache_invalidate(addr, data_size);
+  return imxrt_dcache_invalidate(addr, data_size, &_dcache_batch);
 }
 
 bool dcd_dcache_clean_invalidate(void const* addr, uint32_t data_size) {
-  return imxrt_dcache_clean_invalidate(addr, data_size);
+  return imxrt_dcache_clean_invalidate(addr, data_size, &_dcache_batch);
+}
+
+void dcd_dcache_batch_begin(void) {
+  imxrt_dcache_batch_begin(&_dcache_batch);
+}
+
+void dcd_dcache_batch_end(void) {
+  imxrt_dcache_batch_end(&_dcache_batch);
 }
 #endif
 
@@ -63,6 +73,17 @@ bool dcd_dcache_clean_invalidate(void const* addr, uint32_t data_size) {
 // MACRO CONSTANT TYPEDEF
 //--------------------------------------------------------------------+
 
+// Number of dTDs per endpoint direction. A dTD covers 5 pages (16KB to 20KB), larger transfer and FIFO transfer with
+// linear + wrapped parts are chained with multiple dTDs. Default covers any transfer up to 64KB.
+// For isochronous endpoint, each dTD is a (micro)frame: this is also the max number of frames queued per transfer.
+#ifndef CFG_TUD_CI_HS_QTD_PER_EP
+  #define CFG_TUD_CI_HS_QTD_PER_EP  5
+#endif
+
+#define QTD_PER_EP  CFG_TUD_CI_HS_QTD_PER_EP
+
+TU_VERIFY_STATIC(QTD_PER_EP >= 1 && QTD_PER_EP <= 255, "invalid CFG_TUD_CI_HS_QTD_PER_EP");
+
 // ENDPTCTRL
 enum {
   ENDPTCTRL_STALL          = TU_BIT(0),
@@ -107,7 +128,7 @@ typedef struct
   uint32_t                      : 1  ;
 
   // Word 2-6: Buffer Page Pointer List, Each element in the list is a 4K page aligned, physical memory address. The lower 12 bits in each pointer are reserved (except for the first one) as each memory pointer must reference the start of a 4K page
-  uint32_t buffer[5]; ///< buffer1 has frame_n for TODO Isochronous
+  uint32_t buffer[5]; ///< bit 10:0 of buffer[1] is FRAME_N written by controller when isochronous dTD is complete
 
   //--------------------------------------------------------------------+
   // TD is 32 bytes aligned but occupies only 28 bytes
@@ -144,7 +165,8 @@ typedef struct
   // Therefore there are 16 bytes padding that we can use.
   //--------------------------------------------------------------------+
   tu_fifo_t * ff;
-  uint8_t reserved[12];
+  uint8_t qtd_count; // number of chained dTDs of current transfer
+  uint8_t reserved[11];
 } dcd_qhd_t;
 
 TU_VERIFY_STATIC( sizeof(dcd_qhd_t) == 64, "size is not correct");
@@ -158,9 +180,9 @@ TU_VERIFY_STATIC( sizeof(dcd_qhd_t) == 64, "size is not correct");
 typedef struct {
   // Must be at 2K alignment
   // Each endpoint with direction (IN/OUT) occupies a queue head
-  // for portability, TinyUSB only queue 1 TD for each Qhd
+  // for portability, TinyUSB only queue 1 transfer for each Qhd, which may be a chain of dTDs
   dcd_qhd_t qhd[TUP_DCD_ENDPOINT_MAX][2] TU_ATTR_ALIGNED(64);
-  dcd_qtd_t qtd[TUP_DCD_ENDPOINT_MAX][2] TU_ATTR_ALIGNED(32);
+  dcd_qtd_t qtd[TUP_DCD_ENDPOINT_MAX][2][QTD_PER_EP] TU_ATTR_ALIGNED(32);
 }dcd_data_t;
 
 CFG_TUD_MEM_SECTION TU_ATTR_ALIGNED(2048)
@@ -307,6 +329,13 @@ void dcd_sof_enable(uint8_t rhport, bool en)
   }
 }
 
+void dcd_caps_get(uint8_t rhport, dcd_caps_t* caps) {
+  (void) rhport;
+  // dQH handles high bandwidth MULT, each isochronous dTD records its completion frame
+  caps->iso_high_bandwidth = TUD_OPT_HIGH_SPEED ? 1 : 0;
+  caps->iso_frame = 1;
+}
+
 //--------------------------------------------------------------------+
 // HELPER
 //--------------------------------------------------------------------+
@@ -339,6 +368,41 @@ static void qtd_init(dcd_qtd_t* p_qtd, void * data_ptr, uint16_t total_bytes)
   }
 }
 
+// Bytes of a (micro)frame for isochronous endpoint (up to 3 transactions), max packet size otherwise
+TU_ATTR_ALWAYS_INLINE static inline uint16_t qhd_xact_size(dcd_qhd_t const* p_qhd)
+{
+  return (uint16_t) (p_qhd->max_packet_size * (p_qhd->iso_mult ? p_qhd->iso_mult : 1));
+}
+
+// Append dTDs covering a buffer span to chain of endpoint. A dTD other than the last one must end on packet boundary
+// since packet can not span 2 dTDs, isochronous dTD is executed in a (micro)frame therefore carries a full frame.
+// Return false if there is not enough dTD.
+static bool qtd_chain_append(uint8_t epnum, uint8_t dir, uint8_t* buffer, uint32_t total_bytes)
+{
+  dcd_qhd_t* p_qhd = &_dcd_data.qhd[epnum][dir];
+  uint16_t const xact_size = qhd_xact_size(p_qhd);
+
+  do {
+    TU_VERIFY(p_qhd->qtd_count < QTD_PER_EP);
+
+    uint32_t chunk = p_qhd->iso_mult ? xact_size : (5*4096 - tu_offset4k((uint32_t) buffer));
+    if ( total_bytes <= chunk )
+    {
+      chunk = total_bytes;
+    }else
+    {
+      chunk -= chunk % xact_size;
+    }
+
+    qtd_init(&_dcd_data.qtd[epnum][dir][p_qhd->qtd_count++], buffer, (uint16_t) chunk);
+
+    if (buffer != NULL) buffer += chunk;
+    total_bytes -= chunk;
+  } while (total_bytes);
+
+  return true;
+}
+
 //--------------------------------------------------------------------+
 // DCD Endpoint Port
 //--------------------------------------------------------------------+
@@ -383,7 +447,10 @@ bool dcd_edpt_open(uint8_t rhport, tusb_desc_endpoint_t const * p_endpoint_desc)
   p_qhd->max_packet_size         = tu_edpt_packet_size(p_endpoint_desc);
   if (p_endpoint_desc->bmAttributes.xfer == TUSB_XFER_ISOCHRONOUS)
   {
-    p_qhd->iso_mult = 1;
+    // high bandwidth endpoint: bit 12..11 of wMaxPacketSize is number of additional transactions per microframe
+    uint8_t const mult = (uint8_t) (1 + ((tu_le16toh(p_endpoint_desc->wMaxPacketSize) >> 11) & 0x03));
+    TU_ASSERT(mult <= 3);
+    p_qhd->iso_mult = mult & 0x03u;
   }
 
   p_qhd->qtd_overlay.next        = QTD_NEXT_INVALID;
@@ -442,7 +509,25 @@ static void qhd_start_xfer(uint8_t rhport, uint8_t epnum, uint8_t dir)
 {
   ci_hs_regs_t* dcd_reg = CI_HS_REG(rhport);
   dcd_qhd_t* p_qhd = &_dcd_data.qhd[epnum][dir];
-  dcd_qtd_t* p_qtd = &_dcd_data.qtd[epnum][dir];
+  dcd_qtd_t* p_qtd = _dcd_data.qtd[epnum][dir];
+
+  // link chained dTDs. IN transfer only interrupts on the last one, OUT transfer interrupts on each dTD to detect
+  // short packet which ends the transfer early
+  for (uint8_t i = 0; i+1 < p_qhd->qtd_count; i++)
+  {
+    p_qtd[i].next            = (uint32_t) &p_qtd[i+1];
+    p_qtd[i].int_on_complete = (dir == TUSB_DIR_OUT) ? 1 : 0;
+  }
+
+  // high bandwidth isochronous IN: number of transactions of each frame overrides MULT of dQH
+  if ( p_qhd->iso_mult && dir == TUSB_DIR_IN )
+  {
+    for (uint8_t i = 0; i < p_qhd->qtd_count; i++)
+    {
+      uint32_t const xact = tu_div_ceil(p_qtd[i].expected_bytes, p_qhd->max_packet_size);
+      p_qtd[i].iso_mult_override = (xact ? xact : 1) & 0x03u;
+    }
+  }
 
   p_qhd->qtd_overlay.halted = false;            // clear any previous error
   p_qhd->qtd_overlay.next   = (uint32_t) p_qtd; // link qtd to qhd
@@ -467,10 +552,13 @@ bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, uint16_t t
   uint8_t const dir   = tu_edpt_dir(ep_addr);
 
   dcd_qhd_t* p_qhd = &_dcd_data.qhd[epnum][dir];
-  dcd_qtd_t* p_qtd = &_dcd_data.qtd[epnum][dir];
 
-  // Prepare qtd
-  qtd_init(p_qtd, buffer, total_bytes);
+  // Prepare qtd chain, buffer maintenance of all dTDs is completed with one barrier
+  p_qhd->qtd_count = 0;
+  dcd_dcache_batch_begin();
+  bool const appended = qtd_chain_append(epnum, dir, buffer, total_bytes);
+  dcd_dcache_batch_end();
+  TU_ASSERT(appended); // try to increase CFG_TUD_CI_HS_QTD_PER_EP
 
   // Start qhd transfer
   p_qhd->ff = NULL;
@@ -488,7 +576,7 @@ bool dcd_edpt_xfer_fifo (uint8_t rhport, uint8_t ep_addr, tu_fifo_t * ff, uint16
   uint8_t const dir   = tu_edpt_dir(ep_addr);
 
   dcd_qhd_t * p_qhd = &_dcd_data.qhd[epnum][dir];
-  dcd_qtd_t * p_qtd = &_dcd_data.qtd[epnum][dir];
+  dcd_qtd_t * p_qtd = _dcd_data.qtd[epnum][dir];
 
   tu_fifo_buffer_info_t fifo_info;
 
@@ -500,39 +588,46 @@ bool dcd_edpt_xfer_fifo (uint8_t rhport, uint8_t ep_addr, tu_fifo_t * ff, uint16
     tu_fifo_get_write_info(ff, &fifo_info);
   }
 
+  p_qhd->qtd_count = 0;
+
   if ( fifo_info.len_lin >= total_bytes )
   {
     // Linear length is enough for this transfer
-    qtd_init(p_qtd, fifo_info.ptr_lin, total_bytes);
+    TU_ASSERT(qtd_chain_append(epnum, dir, fifo_info.ptr_lin, total_bytes));
   }
-  else
+  else if ( (fifo_info.len_lin % qhd_xact_size(p_qhd)) == 0 )
   {
-    // linear part is not enough
-
-    // prepare TD up to linear length
+    // linear part ends on packet (frame for isochronous) boundary: chain dTDs of linear and wrapped parts
+    TU_ASSERT(qtd_chain_append(epnum, dir, fifo_info.ptr_lin, fifo_info.len_lin));
+    TU_ASSERT(qtd_chain_append(epnum, dir, fifo_info.ptr_wrap, (uint32_t) (total_bytes - fifo_info.len_lin)));
+  }
+  else if ( !tu_offset4k((uint32_t) fifo_info.ptr_wrap) && !tu_offset4k(tu_fifo_depth(ff)) &&
+            fifo_info.len_lin <= 4*4096 )
+  {
+    // a packet spans linear and wrapped parts. If buffer is aligned to 4K & buffer size is multiple of 4K
+    // We can make use of buffer page array to also combine the linear + wrapped length
     qtd_init(p_qtd, fifo_info.ptr_lin, fifo_info.len_lin);
+    p_qhd->qtd_count = 1;
 
-    if ( !tu_offset4k((uint32_t) fifo_info.ptr_wrap) && !tu_offset4k(tu_fifo_depth(ff)) )
+    uint16_t page = 0;
+    for(uint8_t i = 1; i < 5; i++)
     {
-      // If buffer is aligned to 4K & buffer size is multiple of 4K
-      // We can make use of buffer page array to also combine the linear + wrapped length
-      p_qtd->total_bytes = p_qtd->expected_bytes = total_bytes;
-
-      for(uint8_t i = 1, page = 0; i < 5; i++)
+      // pick up buffer array where linear ends
+      if (p_qtd->buffer[i] == 0)
       {
-        // pick up buffer array where linear ends
-        if (p_qtd->buffer[i] == 0)
-        {
-          p_qtd->buffer[i] = (uint32_t) fifo_info.ptr_wrap + 4096 * page;
-          page++;
-        }
+        p_qtd->buffer[i] = (uint32_t) fifo_info.ptr_wrap + 4096 * page;
+        page++;
       }
     }
-    else
-    {
-      // TODO we may need to carry the wrapped length after the linear part complete
-      // for now only transfer up to linear part
-    }
+
+    // transfer is limited to 5 pages, or a frame for isochronous
+    uint32_t const capacity = p_qhd->iso_mult ? qhd_xact_size(p_qhd) : (5*4096 - tu_offset4k((uint32_t) fifo_info.ptr_lin));
+    p_qtd->total_bytes = p_qtd->expected_bytes = (uint16_t) tu_min32(total_bytes, capacity);
+  }
+  else
+  {
+    // a packet would span linear and wrapped parts: only transfer up to linear part
+    TU_ASSERT(qtd_chain_append(epnum, dir, fifo_info.ptr_lin, fifo_info.len_lin));
   }
 
   // Start qhd transfer
@@ -550,33 +645,66 @@ bool dcd_edpt_xfer_fifo (uint8_t rhport, uint8_t ep_addr, tu_fifo_t * ff, uint16
 static void process_edpt_complete_isr(uint8_t rhport, uint8_t epnum, uint8_t dir)
 {
   dcd_qhd_t * p_qhd = &_dcd_data.qhd[epnum][dir];
-  dcd_qtd_t * p_qtd = &_dcd_data.qtd[epnum][dir];
+  dcd_qtd_t * p_qtd = _dcd_data.qtd[epnum][dir];
+
+  // already reported, e.g both dTDs of an OUT transfer completed before this interrupt is serviced
+  if ( p_qhd->qtd_count == 0 ) return;
 
-  uint8_t result = p_qtd->halted ? XFER_RESULT_STALLED :
-      ( p_qtd->xact_err || p_qtd->buffer_err ) ? XFER_RESULT_FAILED : XFER_RESULT_SUCCESS;
+  uint8_t result = XFER_RESULT_SUCCESS;
+  uint32_t xferred_bytes = 0;
+  uint8_t last = 0;
 
-  if ( result != XFER_RESULT_SUCCESS )
+  for (uint8_t i = 0; i < p_qhd->qtd_count; i++)
   {
-    ci_hs_regs_t* dcd_reg = CI_HS_REG(rhport);
-    // flush to abort error buffer
-    dcd_reg->ENDPTFLUSH = TU_BIT(epnum + (dir ? 16 : 0));
+    // intermediate dTD of OUT transfer is complete, wait for the rest of chain
+    if ( p_qtd[i].active ) return;
+
+    last = i;
+    xferred_bytes += p_qtd[i].expected_bytes - p_qtd[i].total_bytes;
+
+    uint8_t const qtd_result = p_qtd[i].halted ? XFER_RESULT_STALLED :
+        ( p_qtd[i].xact_err || p_qtd[i].buffer_err ) ? XFER_RESULT_FAILED : XFER_RESULT_SUCCESS;
+
+    // isochronous frame error (e.g missed or corrupted frame) does not stop the following frames
+    if ( qtd_result != XFER_RESULT_SUCCESS && p_qhd->iso_mult && !p_qtd[i].halted )
+    {
+      result = XFER_RESULT_FAILED;
+      continue;
+    }
+
+    if ( qtd_result != XFER_RESULT_SUCCESS ) result = qtd_result;
+
+    // error or short packet ends the transfer
+    if ( (qtd_result != XFER_RESULT_SUCCESS) || (p_qtd[i].total_bytes && (i+1 < p_qhd->qtd_count)) )
+    {
+      ci_hs_regs_t* dcd_reg = CI_HS_REG(rhport);
+      // flush to abort error buffer and remaining dTDs
+      dcd_reg->ENDPTFLUSH = TU_BIT(epnum + (dir ? 16 : 0));
+      break;
+    }
   }
 
-  uint16_t const xferred_bytes = p_qtd->expected_bytes - p_qtd->total_bytes;
+  p_qhd->qtd_count = 0;
 
   if (p_qhd->ff)
   {
     if (dir == TUSB_DIR_IN)
     {
-      tu_fifo_advance_read_pointer(p_qhd->ff, xferred_bytes);
+      tu_fifo_advance_read_pointer(p_qhd->ff, (uint16_t) xferred_bytes);
     } else
     {
-      tu_fifo_advance_write_pointer(p_qhd->ff, xferred_bytes);
+      tu_fifo_advance_write_pointer(p_qhd->ff, (uint16_t) xferred_bytes);
     }
   }
 
-  // only number of bytes in the IOC qtd
-  dcd_event_xfer_complete(rhport, tu_edpt_addr(epnum, dir), xferred_bytes, result, true);
+  if ( p_qhd->iso_mult )
+  {
+    uint16_t const frame = (uint16_t) (p_qtd[last].buffer[1] & 0x7FFu);
+    dcd_event_iso_xfer_complete(rhport, tu_edpt_addr(epnum, dir), xferred_bytes, result, frame, true);
+  }else
+  {
+    dcd_event_xfer_complete(rhport, tu_edpt_addr(epnum, dir), xferred_bytes, result, true);
+  }
 }
 
 void dcd_int_handler(uint8_t rhport)
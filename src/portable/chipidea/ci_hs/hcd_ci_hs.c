@@ -43,16 +43,26 @@
 #include "ci_hs_imxrt.h"
 
 #if CFG_TUH_MEM_DCACHE_ENABLE
+static imxrt_dcache_batch_t _dcache_batch;
+
 bool hcd_dcache_clean(void const* addr, uint32_t data_size) {
-  return imxrt_dcache_clean(addr, data_size);
+  return imxrt_dcache_clean(addr, data_size, &_dcache_batch);
 }
 
 bool hcd_dcache_invalidate(void const* addr, uint32_t data_size) {
-  return imxrt_dcache_invalidate(addr, data_size);
+  return imxrt_dcache_invalidate(addr, data_size, &_dcache_batch);
 }
 
 bool hcd_dcache_clean_invalidate(void const* addr, uint32_t data_size) {
-  return imxrt_dcache_clean_invalidate(addr, data_size);
+  return imxrt_dcache_clean_invalidate(addr, data_size, &_dcache_batch);
+}
+
+void hcd_dcache_batch_begin(void) {
+  imxrt_dcache_batch_begin(&_dcache_batch);
+}
+
+void hcd_dcache_batch_end(void) {
+  imxrt_dcache_batch_end(&_dcache_batch);
 }
 #endif
 
@@ -44,33 +44,143 @@
 // Debug level of EHCI
 #define EHCI_DBG     2
 
-// Framelist size as small as possible to save SRAM
-#ifdef TUP_USBIP_CHIPIDEA_HS
-  // NXP Transdimension: 8 elements
+// Frame list size (power of 2). Interrupt endpoints with longer interval are polled every FRAMELIST_SIZE frames.
+// Standard EHCI supports 256, 512 or 1024 elements, ChipIdea also supports 8 to 128 elements to save SRAM
+#ifndef CFG_TUH_EHCI_FRAMELIST_SIZE
+  #ifdef TUP_USBIP_CHIPIDEA_HS
+    #define CFG_TUH_EHCI_FRAMELIST_SIZE  8
+  #else
+    #define CFG_TUH_EHCI_FRAMELIST_SIZE  256
+  #endif
+#endif
+
+#if   CFG_TUH_EHCI_FRAMELIST_SIZE == 1024
+  #define FRAMELIST_SIZE_BIT_VALUE      0u
+#elif CFG_TUH_EHCI_FRAMELIST_SIZE == 512
+  #define FRAMELIST_SIZE_BIT_VALUE      1u
+#elif CFG_TUH_EHCI_FRAMELIST_SIZE == 256
+  #define FRAMELIST_SIZE_BIT_VALUE      2u
+#elif CFG_TUH_EHCI_FRAMELIST_SIZE == 128
+  #define FRAMELIST_SIZE_BIT_VALUE      3u
+#elif CFG_TUH_EHCI_FRAMELIST_SIZE == 64
+  #define FRAMELIST_SIZE_BIT_VALUE      4u
+#elif CFG_TUH_EHCI_FRAMELIST_SIZE == 32
+  #define FRAMELIST_SIZE_BIT_VALUE      5u
+#elif CFG_TUH_EHCI_FRAMELIST_SIZE == 16
+  #define FRAMELIST_SIZE_BIT_VALUE      6u
+#elif CFG_TUH_EHCI_FRAMELIST_SIZE == 8
   #define FRAMELIST_SIZE_BIT_VALUE      7u
+#else
+  #error "CFG_TUH_EHCI_FRAMELIST_SIZE must be power of 2 from 8 to 1024"
+#endif
+
+#ifdef TUP_USBIP_CHIPIDEA_HS
+  // NXP Transdimension: 3-bit size field
   #define FRAMELIST_SIZE_USBCMD_VALUE   (((FRAMELIST_SIZE_BIT_VALUE &  3) << EHCI_USBCMD_FRAMELIST_SIZE_SHIFT) | \
                                          ((FRAMELIST_SIZE_BIT_VALUE >> 2) << EHCI_USBCMD_CHIPIDEA_FRAMELIST_SIZE_MSB_SHIFT))
 #else
-  // STD EHCI: 256 elements
-  #define FRAMELIST_SIZE_BIT_VALUE      2u
-  #define FRAMELIST_SIZE_USBCMD_VALUE   ((FRAMELIST_SIZE_BIT_VALUE &  3) << EHCI_USBCMD_POS_FRAMELIST_SIZE)
+  #if FRAMELIST_SIZE_BIT_VALUE > 2
+    #error "Standard EHCI frame list size must be 256, 512 or 1024"
+  #endif
+  #define FRAMELIST_SIZE_USBCMD_VALUE   ((FRAMELIST_SIZE_BIT_VALUE &  3) << EHCI_USBCMD_FRAMELIST_SIZE_SHIFT)
 #endif
 
 #define FRAMELIST_SIZE                  (1024 >> FRAMELIST_SIZE_BIT_VALUE)
+#define FRAMELIST_SIZE_LOG2             (10 - FRAMELIST_SIZE_BIT_VALUE)
 
-// Total queue head pool. TODO should be user configurable and more optimize memory usage in the future
-#define QHD_MAX      (CFG_TUH_DEVICE_MAX*CFG_TUH_ENDPOINT_MAX + CFG_TUH_HUB)
-#define QTD_MAX      QHD_MAX
+// Frames tracked by periodic bandwidth planner (hcd_bw_reserve), longer periods are balanced by interval tree branch
+#define PERIOD_BW_WINDOW                8u
+
+// Total queue head pool for non-control endpoints
+#ifndef CFG_TUH_EHCI_QHD_MAX
+  #define CFG_TUH_EHCI_QHD_MAX  (CFG_TUH_DEVICE_MAX*CFG_TUH_ENDPOINT_MAX + CFG_TUH_HUB)
+#endif
+
+// Total queue TD pool shared by non-control endpoints, TDs are allocated per transfer. A TD spans 5 pages (16KB to
+// 20KB depending on buffer alignment), larger transfer is chained with more TDs. Default allows one 64KB transfer in
+// addition to one TD per endpoint.
+#ifndef CFG_TUH_EHCI_QTD_MAX
+  #define CFG_TUH_EHCI_QTD_MAX  (CFG_TUH_EHCI_QHD_MAX + 4)
+#endif
+
+#define QHD_MAX      CFG_TUH_EHCI_QHD_MAX
+#define QTD_MAX      CFG_TUH_EHCI_QTD_MAX
+
+// Isochronous TDs per endpoint, each TD covers one frame: iTD (up to 8 microframe packets) for high speed or siTD
+// (split transaction) for full speed. TDs are linked directly to frame list ahead of interrupt queue heads.
+// More TDs allow scheduling further ahead of the controller (more latency, more tolerance to late servicing)
+#ifndef CFG_TUH_EHCI_ISO_TD_MAX
+  #define CFG_TUH_EHCI_ISO_TD_MAX    8
+#endif
+
+// Isochronous transfers (buffers) that can be queued per endpoint, next ones are scheduled right after previous
+// without gap in the frame sequence
+#ifndef CFG_TUH_EHCI_ISO_XFER_MAX
+  #define CFG_TUH_EHCI_ISO_XFER_MAX  2
+#endif
+
+#define ISO_TD_MAX   CFG_TUH_EHCI_ISO_TD_MAX
+#define ISO_XFER_MAX CFG_TUH_EHCI_ISO_XFER_MAX
+
+TU_VERIFY_STATIC(ISO_TD_MAX >= 2 && ISO_TD_MAX <= 255 && ISO_XFER_MAX >= 1 && ISO_XFER_MAX <= 255,
+                 "invalid EHCI isochronous configuration");
+
+#if CFG_TUH_ISO_EDPT_MAX
+typedef union {
+  ehci_itd_t itd;
+  ehci_sitd_t sitd;
+} ehci_iso_td_t;
+
+typedef struct {
+  uint8_t* buffer;
+  hcd_iso_packet_t* packets;
+  uint16_t n_packets;
+  uint16_t sched_count;   // packets scheduled to TD (or skipped)
+  uint16_t done_count;    // packets completed
+  uint32_t sched_offset;  // buffer offset of next packet to schedule
+  uint32_t xferred_bytes;
+  bool failed;
+} ehci_iso_xfer_t;
+
+typedef struct {
+  uint8_t dev_addr;  // 0 if free
+  uint8_t ep_addr;
+  uint8_t is_hs;     // iTD if high speed, siTD otherwise
+  uint8_t started;   // stream is running, frames which are missed count as late packets
+
+  uint8_t hub_addr;
+  uint8_t hub_port;
+  uint8_t smask;     // siTD start-split microframes
+  uint8_t cmask;     // siTD complete-split microframes
+
+  uint8_t uf_phase;  // iTD: first microframe within frame
+  uint8_t uf_period; // iTD: microframes between packets within frame (1, 2, 4 or 8)
+  uint8_t mult;      // iTD: transactions per microframe
+  uint8_t frame_phase;
+  uint16_t frame_period; // frames between TDs
+  uint16_t mps;
+
+  uint32_t next_frame; // frame of next TD to schedule
+
+  uint8_t td_head;   // oldest scheduled TD
+  uint8_t td_count;
+  struct {
+    uint32_t frame;
+    uint16_t pkt_first;
+    uint8_t pkt_count;
+    uint8_t xfer_id;
+  } td_info[ISO_TD_MAX];
+
+  uint8_t xfer_head;
+  uint8_t xfer_count;
+  ehci_iso_xfer_t xfer[ISO_XFER_MAX];
+} ehci_iso_ep_t;
+#endif
 
 typedef struct
 {
   ehci_link_t period_framelist[FRAMELIST_SIZE];
 
-  // TODO only implement 1 ms & 2 ms & 4 ms, 8 ms (framelist)
-  // [0] : 1ms, [1] : 2ms, [2] : 4ms, [3] : 8 ms
-  // TODO better implementation without dummy head to save SRAM
-  ehci_qhd_t period_head_arr[4];
-
   // Note control qhd of dev0 is used as head of async list
   struct {
     ehci_qhd_t qhd;
@@ -80,6 +190,18 @@ typedef struct
   ehci_qhd_t qhd_pool[QHD_MAX];
   ehci_qtd_t qtd_pool[QTD_MAX] TU_ATTR_ALIGNED(32);
 
+  // Inactive TD as alternate next of chained IN TDs: short packet stops the queue there instead of continuing with
+  // next TD of the same transfer. Its address has bit 5 set so that 'used' sharing the alternate word stays 1.
+  struct {
+    ehci_qtd_t padding;
+    ehci_qtd_t qtd;
+  } short_stop TU_ATTR_ALIGNED(64);
+
+#if CFG_TUH_ISO_EDPT_MAX
+  ehci_iso_td_t iso_td[CFG_TUH_ISO_EDPT_MAX][ISO_TD_MAX];
+  ehci_iso_ep_t iso_ep[CFG_TUH_ISO_EDPT_MAX];
+#endif
+
   ehci_registers_t* regs;         // operational register
   ehci_cap_registers_t* cap_regs; // capability register
 
@@ -131,24 +253,37 @@ static inline void print_intr(uint32_t intr) {
 TU_ATTR_WEAK bool hcd_dcache_clean(void const* addr, uint32_t data_size) { (void) addr; (void) data_size; return true; }
 TU_ATTR_WEAK bool hcd_dcache_invalidate(void const* addr, uint32_t data_size) { (void) addr; (void) data_size; return true; }
 TU_ATTR_WEAK bool hcd_dcache_clean_invalidate(void const* addr, uint32_t data_size) { (void) addr; (void) data_size; return true; }
+TU_ATTR_WEAK void hcd_dcache_batch_begin(void) { }
+TU_ATTR_WEAK void hcd_dcache_batch_end(void) { }
 
 TU_ATTR_ALWAYS_INLINE static inline ehci_qhd_t* qhd_control(uint8_t dev_addr);
 TU_ATTR_ALWAYS_INLINE static inline ehci_qhd_t* qhd_next (ehci_qhd_t const * p_qhd);
 TU_ATTR_ALWAYS_INLINE static inline ehci_qhd_t* qhd_find_free (void);
 static ehci_qhd_t* qhd_get_from_addr (uint8_t dev_addr, uint8_t ep_addr);
-static void qhd_init(ehci_qhd_t *p_qhd, uint8_t dev_addr, tusb_desc_endpoint_t const * ep_desc);
+static bool qhd_init(ehci_qhd_t *p_qhd, uint8_t dev_addr, tusb_desc_endpoint_t const * ep_desc);
 static void qhd_attach_qtd(ehci_qhd_t *qhd, ehci_qtd_t *qtd);
 static void qhd_remove_qtd(ehci_qhd_t *qhd);
 
 TU_ATTR_ALWAYS_INLINE static inline ehci_qtd_t* qtd_control(uint8_t dev_addr);
 TU_ATTR_ALWAYS_INLINE static inline ehci_qtd_t* qtd_find_free (void);
+TU_ATTR_ALWAYS_INLINE static inline ehci_qtd_t* qtd_next (ehci_qtd_t const * qtd);
 static void qtd_init (ehci_qtd_t* qtd, void const* buffer, uint16_t total_bytes);
+static void qtd_chain_free(ehci_qtd_t* qtd);
+static bool qhd_qtd_chain_done(ehci_qhd_t const* qhd, uint32_t* xferred_bytes);
 
-TU_ATTR_ALWAYS_INLINE static inline ehci_link_t* list_get_period_head(uint8_t rhport, uint32_t interval_ms);
 TU_ATTR_ALWAYS_INLINE static inline ehci_qhd_t* list_get_async_head(uint8_t rhport);
 TU_ATTR_ALWAYS_INLINE static inline void list_insert (ehci_link_t *current, ehci_link_t *new, uint8_t new_type);
 TU_ATTR_ALWAYS_INLINE static inline ehci_link_t* list_next (ehci_link_t const *p_link);
 static void list_remove_qhd_by_daddr(ehci_link_t* list_head, uint8_t dev_addr);
+static void period_list_link(ehci_qhd_t* qhd);
+static void period_list_unlink(ehci_qhd_t const* qhd);
+
+#if CFG_TUH_ISO_EDPT_MAX
+static ehci_iso_ep_t* iso_ep_find(uint8_t dev_addr, uint8_t ep_addr);
+static bool iso_edpt_open(uint8_t dev_addr, tusb_desc_endpoint_t const* ep_desc);
+static void iso_edpt_stop(ehci_iso_ep_t* iso);
+static void iso_service(ehci_iso_ep_t* iso, bool in_isr);
+#endif
 
 static void ehci_disable_schedule(ehci_registers_t* regs, bool is_period) {
   // maybe have a timeout for status
@@ -244,10 +379,26 @@ void hcd_device_close(uint8_t rhport, uint8_t daddr)
   // Remove from async list
   list_remove_qhd_by_daddr((ehci_link_t *) list_get_async_head(rhport), daddr);
 
-  // Remove from all interval period list
-  for(uint8_t i = 0; i < TU_ARRAY_SIZE(ehci_data.period_head_arr); i++) {
-    list_remove_qhd_by_daddr((ehci_link_t *) &ehci_data.period_head_arr[i], daddr);
+  // Remove from periodic frame list
+  for (uint32_t i = 0; i < QHD_MAX; i++) {
+    ehci_qhd_t* qhd = &ehci_data.qhd_pool[i];
+    if (qhd->used && qhd->periodic && qhd->dev_addr == daddr) {
+      period_list_unlink(qhd);
+      // period list queue element is guarantee to be free in the next frame (1 ms)
+      qhd->used = 0;
+    }
+  }
+
+#if CFG_TUH_ISO_EDPT_MAX
+  // Unlink isochronous TDs from frame list
+  for (uint8_t i = 0; i < CFG_TUH_ISO_EDPT_MAX; i++) {
+    ehci_iso_ep_t* iso = &ehci_data.iso_ep[i];
+    if (iso->dev_addr == daddr) {
+      iso_edpt_stop(iso);
+      tu_memclr(iso, sizeof(ehci_iso_ep_t));
+    }
   }
+#endif
 
   // Async doorbell (EHCI 4.8.2 for operational details)
   ehci_data.regs->command_bm.async_adv_doorbell = 1;
@@ -256,40 +407,12 @@ void hcd_device_close(uint8_t rhport, uint8_t daddr)
 static void init_periodic_list(uint8_t rhport) {
   (void) rhport;
 
-  // Build the polling interval tree with 1 ms, 2 ms, 4 ms and 8 ms (framesize) only
-  for ( uint32_t i = 0; i < TU_ARRAY_SIZE(ehci_data.period_head_arr); i++ ) {
-    ehci_data.period_head_arr[i].int_smask          = 1; // queue head in period list must have smask non-zero
-    ehci_data.period_head_arr[i].qtd_overlay.halted = 1; // dummy node, always inactive
-  }
-
-  // TODO EHCI_FRAMELIST_SIZE with other size than 8
-  // all links --> period_head_arr[0] (1ms)
-  // 0, 2, 4, 6 etc --> period_head_arr[1] (2ms)
-  // 1, 5 --> period_head_arr[2] (4ms)
-  // 3 --> period_head_arr[3] (8ms)
-
-  ehci_link_t * const framelist  = ehci_data.period_framelist;
-  ehci_link_t * const head_1ms = (ehci_link_t *) &ehci_data.period_head_arr[0];
-  ehci_link_t * const head_2ms = (ehci_link_t *) &ehci_data.period_head_arr[1];
-  ehci_link_t * const head_4ms = (ehci_link_t *) &ehci_data.period_head_arr[2];
-  ehci_link_t * const head_8ms = (ehci_link_t *) &ehci_data.period_head_arr[3];
-
+  // Frame list is the root of the polling interval tree, there is no dummy queue head: every frame is empty until
+  // an interrupt queue head or isochronous TD is linked, see period_list_link()
   for (uint32_t i = 0; i < FRAMELIST_SIZE; i++) {
-    framelist[i].address = (uint32_t) head_1ms;
-    framelist[i].type = EHCI_QTYPE_QHD;
-  }
-
-  for (uint32_t i = 0; i < FRAMELIST_SIZE; i += 2) {
-    list_insert(framelist + i, head_2ms, EHCI_QTYPE_QHD);
-  }
-
-  for (uint32_t i = 1; i < FRAMELIST_SIZE; i += 4) {
-    list_insert(framelist + i, head_4ms, EHCI_QTYPE_QHD);
+    ehci_data.period_framelist[i].address = 0;
+    ehci_data.period_framelist[i].terminate = 1;
   }
-
-  list_insert(framelist + 3, head_8ms, EHCI_QTYPE_QHD);
-
-  head_1ms->terminate = 1;
 }
 
 bool ehci_init(uint8_t rhport, uint32_t capability_reg, uint32_t operatial_reg)
@@ -329,6 +452,10 @@ bool ehci_init(uint8_t rhport, uint32_t capability_reg, uint32_t operatial_reg)
 
   regs->async_list_addr = (uint32_t) async_head;
 
+  ehci_qtd_t* short_stop = &ehci_data.short_stop.qtd;
+  short_stop->next.terminate      = 1;
+  short_stop->alternate.terminate = 1;
+
   //------------- Periodic List -------------//
   init_periodic_list(rhport);
   regs->periodic_list_base = (uint32_t) ehci_data.period_framelist;
@@ -379,14 +506,19 @@ bool hcd_edpt_open(uint8_t rhport, uint8_t dev_addr, tusb_desc_endpoint_t const
 {
   (void) rhport;
 
-  // TODO not support ISO yet
-  TU_ASSERT (ep_desc->bmAttributes.xfer != TUSB_XFER_ISOCHRONOUS);
+  if (ep_desc->bmAttributes.xfer == TUSB_XFER_ISOCHRONOUS) {
+    #if CFG_TUH_ISO_EDPT_MAX
+    return iso_edpt_open(dev_addr, ep_desc);
+    #else
+    return false; // CFG_TUH_ISO_EDPT_MAX is 0
+    #endif
+  }
 
   //------------- Prepare Queue Head -------------//
   ehci_qhd_t *p_qhd = (ep_desc->bEndpointAddress == 0) ? qhd_control(dev_addr) : qhd_find_free();
   TU_ASSERT(p_qhd);
 
-  qhd_init(p_qhd, dev_addr, ep_desc);
+  TU_ASSERT(qhd_init(p_qhd, dev_addr, ep_desc));
 
   // control of dev0 is always present as async head
   if ( dev_addr == 0 ) return true;
@@ -402,12 +534,9 @@ bool hcd_edpt_open(uint8_t rhport, uint8_t dev_addr, tusb_desc_endpoint_t const
     break;
 
     case TUSB_XFER_INTERRUPT:
-      list_head = list_get_period_head(rhport, p_qhd->interval_ms);
-    break;
-
-    case TUSB_XFER_ISOCHRONOUS:
-      // TODO iso is not supported
-    break;
+      hcd_dcache_clean(p_qhd, sizeof(ehci_qhd_t));
+      period_list_link(p_qhd);
+      return true;
 
     default: break;
   }
@@ -470,11 +599,44 @@ bool hcd_edpt_xfer(uint8_t rhport, uint8_t dev_addr, uint8_t ep_addr, uint8_t *
     // skip if endpoint is halted
     TU_VERIFY(!qhd->qtd_overlay.halted);
 
-    qtd = qtd_find_free();
-    TU_ASSERT(qtd);
+    // Chain TDs of up to 5 pages, each TD except the last one must be multiple of max packet size
+    uint16_t const mps = qhd->max_packet_size;
+    ehci_qtd_t* prev = NULL;
+    uint32_t offset = 0;
+    qtd = NULL;
+
+    do {
+      ehci_qtd_t* td = qtd_find_free();
+      if (td == NULL) {
+        qtd_chain_free(qtd);
+        TU_ASSERT(false);
+      }
 
-    qtd_init(qtd, buffer, buflen);
-    qtd->pid = qhd->pid;
+      uint32_t const max_len = 5*4096u - (((uint32_t) buffer + offset) & 0xFFFu);
+      uint32_t len = buflen - offset;
+      if (len > max_len) {
+        len = max_len - (max_len % mps);
+      }
+
+      qtd_init(td, buffer + offset, (uint16_t) len);
+      td->pid = qhd->pid;
+      offset += len;
+
+      if (offset < buflen) {
+        // interrupt on last TD only, short packet of IN transfer stops the chain
+        td->int_on_complete = 0;
+        if (dir) {
+          td->alternate.address = (uint32_t) &ehci_data.short_stop.qtd;
+        }
+      }
+
+      if (prev) {
+        prev->next.address = (uint32_t) td;
+      } else {
+        qtd = td;
+      }
+      prev = td;
+    } while (offset < buflen);
   }
 
   // IN transfer: invalidate buffer, OUT transfer: clean buffer
@@ -490,24 +652,73 @@ bool hcd_edpt_xfer(uint8_t rhport, uint8_t dev_addr, uint8_t ep_addr, uint8_t *
   return true;
 }
 
+bool hcd_edpt_iso_xfer(uint8_t rhport, uint8_t daddr, uint8_t ep_addr, uint8_t* buffer, hcd_iso_packet_t* packets,
+                       uint16_t n_packets) {
+#if CFG_TUH_ISO_EDPT_MAX
+  ehci_iso_ep_t* iso = iso_ep_find(daddr, ep_addr);
+  TU_VERIFY(iso && n_packets && iso->xfer_count < ISO_XFER_MAX);
+
+  uint32_t total_bytes = 0;
+  for (uint16_t i = 0; i < n_packets; i++) {
+    TU_ASSERT(packets[i].len <= iso->mps * iso->mult);
+    packets[i].actual_len = 0;
+    packets[i].result = XFER_RESULT_INVALID;
+    total_bytes += packets[i].len;
+  }
+
+  // IN transfer: invalidate buffer, OUT transfer: clean buffer
+  if (tu_edpt_dir(ep_addr)) {
+    hcd_dcache_invalidate(buffer, total_bytes);
+  } else {
+    hcd_dcache_clean(buffer, total_bytes);
+  }
+
+  hcd_int_disable(rhport);
+
+  ehci_iso_xfer_t* xfer = &iso->xfer[(iso->xfer_head + iso->xfer_count) % ISO_XFER_MAX];
+  tu_memclr(xfer, sizeof(ehci_iso_xfer_t));
+  xfer->buffer = buffer;
+  xfer->packets = packets;
+  xfer->n_packets = n_packets;
+  iso->xfer_count++;
+
+  iso_service(iso, false);
+
+  hcd_int_enable(rhport);
+
+  return true;
+#else
+  (void) rhport; (void) daddr; (void) ep_addr; (void) buffer; (void) packets; (void) n_packets;
+  return false;
+#endif
+}
+
 bool hcd_edpt_abort_xfer(uint8_t rhport, uint8_t dev_addr, uint8_t ep_addr) {
   (void) rhport;
 
-  // TODO ISO not supported yet
+#if CFG_TUH_ISO_EDPT_MAX
+  ehci_iso_ep_t* iso = iso_ep_find(dev_addr, ep_addr);
+  if (iso) {
+    // drop all queued isochronous transfers, endpoint remains opened
+    bool const has_xfer = (iso->xfer_count > 0);
+    iso_edpt_stop(iso);
+    return has_xfer;
+  }
+#endif
+
   ehci_qhd_t* qhd = qhd_get_from_addr(dev_addr, ep_addr);
-  ehci_qtd_t * volatile qtd = qhd->attached_qtd;
-  TU_VERIFY(qtd != NULL); // no queued transfer
+  TU_VERIFY(qhd->attached_qtd != NULL); // no queued transfer
 
-  hcd_dcache_invalidate(qtd, sizeof(ehci_qtd_t));
-  TU_VERIFY(qtd->active); // transfer is already complete
+  uint32_t xferred_bytes;
+  TU_VERIFY(!qhd_qtd_chain_done(qhd, &xferred_bytes)); // transfer is already complete
 
   // HC is still processing, disable HC list schedule before making changes
-  bool const is_period = (qhd->interval_ms > 0);
+  bool const is_period = qhd->periodic;
 
   ehci_disable_schedule(ehci_data.regs, is_period);
 
-  // check active bit again just in case HC has just processed the TD
-  bool const still_active = qtd->active;
+  // check again just in case HC has just processed the TD
+  bool const still_active = !qhd_qtd_chain_done(qhd, &xferred_bytes);
   if (still_active) {
     // remove TD from QH overlay
     qhd->qtd_overlay.next.terminate = 1;
@@ -549,6 +760,10 @@ void async_advance_isr(uint8_t rhport)
     if (qhd_pool[i].removing) {
       qhd_pool[i].removing = 0;
       qhd_pool[i].used = 0;
+
+      // free TDs of transfer in progress when device was closed
+      qtd_chain_free(qhd_pool[i].attached_qtd);
+      qhd_pool[i].attached_qtd = NULL;
     }
   }
 }
@@ -573,6 +788,12 @@ void qhd_xfer_complete_isr(ehci_qhd_t * qhd) {
 
   // process non-active (completed) QHD with attached (scheduled) TD
   if ( !qtd_overlay->active && qhd->attached_qtd != NULL ) {
+    // overlay is also inactive while HC moves to next chained TD
+    uint32_t xferred_bytes;
+    if (!qhd_qtd_chain_done(qhd, &xferred_bytes)) {
+      return;
+    }
+
     xfer_result_t xfer_result;
 
     if ( qtd_overlay->halted ) {
@@ -591,11 +812,7 @@ void qhd_xfer_complete_isr(ehci_qhd_t * qhd) {
       xfer_result = XFER_RESULT_SUCCESS;
     }
 
-    ehci_qtd_t * volatile qtd = qhd->attached_qtd;
-    hcd_dcache_invalidate(qtd, sizeof(ehci_qtd_t)); // HC may have written back TD
-
-    uint8_t const dir = (qtd->pid == EHCI_PID_IN) ? 1 : 0;
-    uint32_t const xferred_bytes = qtd->expected_bytes - qtd->total_bytes;
+    uint8_t const dir = (qhd->attached_qtd->pid == EHCI_PID_IN) ? 1 : 0;
 
     // invalidate dcache if IN transfer with data
     if (dir == 1 && qhd->attached_buffer != 0 && xferred_bytes > 0) {
@@ -622,38 +839,30 @@ void proccess_async_xfer_isr(ehci_qhd_t * const list_head)
   } while ( qhd != list_head ); // async list traversal, stop if loop around
 }
 
+// Interrupt queue heads are shared by several frames of the interval tree, walk the pool instead of the frame list
 TU_ATTR_ALWAYS_INLINE static inline
-void process_period_xfer_isr(uint8_t rhport, uint32_t interval_ms)
-{
-  uint32_t const period_1ms_addr = (uint32_t) list_get_period_head(rhport, 1u);
-  ehci_link_t next_link = *list_get_period_head(rhport, interval_ms);
-
-  while (!next_link.terminate) {
-    if (interval_ms > 1 && period_1ms_addr == tu_align32(next_link.address)) {
-      // 1ms period list is end of list for all larger interval
-      break;
+void process_period_xfer_isr(uint8_t rhport) {
+  (void) rhport;
+  for (uint32_t i = 0; i < QHD_MAX; i++) {
+    ehci_qhd_t* qhd = &ehci_data.qhd_pool[i];
+    if (qhd->used && qhd->periodic) {
+      qhd_xfer_complete_isr(qhd);
     }
+  }
+}
 
-    uintptr_t const entry_addr = tu_align32(next_link.address);
-
-    switch (next_link.type) {
-      case EHCI_QTYPE_QHD: {
-        ehci_qhd_t *qhd = (ehci_qhd_t *) entry_addr;
-        qhd_xfer_complete_isr(qhd);
-      }
-        break;
-
-      // TODO support hs/fs ISO
-      case EHCI_QTYPE_ITD:
-      case EHCI_QTYPE_SITD:
-      case EHCI_QTYPE_FSTN:
-      default:
-        break;
+#if CFG_TUH_ISO_EDPT_MAX
+TU_ATTR_ALWAYS_INLINE static inline
+void process_iso_xfer_isr(uint8_t rhport) {
+  (void) rhport;
+  for (uint8_t i = 0; i < CFG_TUH_ISO_EDPT_MAX; i++) {
+    ehci_iso_ep_t* iso = &ehci_data.iso_ep[i];
+    if (iso->dev_addr != 0 && (iso->td_count || iso->xfer_count)) {
+      iso_service(iso, true);
     }
-
-    next_link = *list_next(&next_link);
   }
 }
+#endif
 
 //------------- Host Controller Driver's Interrupt Handler -------------//
 void hcd_int_handler(uint8_t rhport, bool in_isr) {
@@ -691,13 +900,18 @@ void hcd_int_handler(uint8_t rhport, bool in_isr) {
   if (usb_int) {
     proccess_async_xfer_isr(list_get_async_head(rhport));
 
-    for ( uint32_t i = 1; i <= FRAMELIST_SIZE; i *= 2 ) {
-      process_period_xfer_isr(rhport, i);
-    }
+    process_period_xfer_isr(rhport);
 
     regs->status = usb_int; // Acknowledge
   }
 
+#if CFG_TUH_ISO_EDPT_MAX
+  // missed isochronous TD does not raise interrupt, also check it on frame list rollover
+  if (usb_int || (int_status & EHCI_INT_MASK_FRAMELIST_ROLLOVER)) {
+    process_iso_xfer_isr(rhport);
+  }
+#endif
+
   //------------- There is some removed async previously -------------//
   // need to place after EHCI_INT_MASK_NXP_ASYNC
   if (int_status & EHCI_INT_MASK_ASYNC_ADVANCE) {
@@ -710,12 +924,6 @@ void hcd_int_handler(uint8_t rhport, bool in_isr) {
 // List Managing Helper
 //--------------------------------------------------------------------+
 
-// Get head of periodic list
-TU_ATTR_ALWAYS_INLINE static inline ehci_link_t* list_get_period_head(uint8_t rhport, uint32_t interval_ms) {
-  (void) rhport;
-  return (ehci_link_t*) &ehci_data.period_head_arr[ tu_log2( tu_min32(FRAMELIST_SIZE, interval_ms) ) ];
-}
-
 // Get head of async list
 TU_ATTR_ALWAYS_INLINE static inline ehci_qhd_t* list_get_async_head(uint8_t rhport) {
   (void) rhport;
@@ -751,16 +959,9 @@ static void list_remove_qhd_by_daddr(ehci_link_t* list_head, uint8_t dev_addr) {
       // EHCI 4.8.2 link the removed qhd's next to async head (which always reachable by Host Controller)
       qhd->next.address = ((uint32_t) list_head) | (EHCI_QTYPE_QHD << 1);
 
-      if ( qhd->int_smask )
-      {
-        // period list queue element is guarantee to be free in the next frame (1 ms)
-        qhd->used = 0;
-      }else
-      {
-        // async list use async advance handshake
-        // mark as removing, will completely re-usable when async advance isr occurs
-        qhd->removing = 1;
-      }
+      // async list use async advance handshake
+      // mark as removing, will completely re-usable when async advance isr occurs
+      qhd->removing = 1;
 
       hcd_dcache_clean(qhd, sizeof(ehci_qhd_t));
       hcd_dcache_clean(prev, sizeof(ehci_qhd_t));
@@ -771,6 +972,83 @@ static void list_remove_qhd_by_daddr(ehci_link_t* list_head, uint8_t dev_addr) {
 }
 
 
+// Periodic schedule is a binary interval tree rooted at the frame list (EHCI 4.6). A queue head of period P frames
+// (power of 2) is linked to frames phase, phase + P, phase + 2P ... Each frame chain is sorted by decreasing period,
+// so that frames sharing the same lower bits merge into a common tail of shorter periods and a queue head is linked
+// only once per branch. Isochronous TDs are always at head of chain, before interrupt queue heads.
+static void period_list_link(ehci_qhd_t* qhd) {
+  for (uint32_t frame = qhd->period_phase; frame < FRAMELIST_SIZE; frame += (1u << qhd->period_log2)) {
+    ehci_link_t* prev = &ehci_data.period_framelist[frame];
+
+    // skip isochronous TDs and queue heads of longer or same period
+    while (!prev->terminate) {
+      ehci_link_t* next = list_next(prev);
+      if (next == (ehci_link_t*) qhd) {
+        break; // already linked by branch shared with previous frame
+      }
+      if (prev->type == EHCI_QTYPE_QHD && ((ehci_qhd_t*) next)->period_log2 < qhd->period_log2) {
+        break;
+      }
+      prev = next;
+    }
+
+    if (prev->terminate || list_next(prev) != (ehci_link_t*) qhd) {
+      list_insert(prev, (ehci_link_t*) qhd, EHCI_QTYPE_QHD);
+      hcd_dcache_clean(qhd, sizeof(ehci_qhd_t));
+      hcd_dcache_clean(prev, sizeof(ehci_link_t));
+    }
+  }
+}
+
+// Unlink queue head from all its branches, removed queue head keeps its next link so that controller currently
+// processing it can continue.
+static void period_list_unlink(ehci_qhd_t const* qhd) {
+  for (uint32_t frame = qhd->period_phase; frame < FRAMELIST_SIZE; frame += (1u << qhd->period_log2)) {
+    ehci_link_t* prev = &ehci_data.period_framelist[frame];
+
+    while (!prev->terminate) {
+      ehci_link_t* next = list_next(prev);
+      if (next == (ehci_link_t const*) qhd) {
+        prev->address = qhd->next.address;
+        hcd_dcache_clean(prev, sizeof(ehci_link_t));
+        break;
+      }
+      if (prev->type == EHCI_QTYPE_QHD && ((ehci_qhd_t*) next)->period_log2 < qhd->period_log2) {
+        break; // already unlinked from branch shared with previous frame
+      }
+      prev = next;
+    }
+  }
+}
+
+// Bandwidth planner places endpoint within first frames of its period. Among frames of the tree equivalent for the
+// planner (same frame modulo planner window), choose the branch shared with least queue heads.
+static uint16_t period_branch_balance(ehci_qhd_t const* qhd, uint16_t frame, uint16_t window) {
+  uint32_t const period = 1u << qhd->period_log2;
+  uint16_t best_frame = frame;
+  uint32_t best_count = UINT32_MAX;
+
+  for (uint32_t f = frame; f < period; f += window) {
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < QHD_MAX; i++) {
+      ehci_qhd_t const* other = &ehci_data.qhd_pool[i];
+      if (other != qhd && other->used && other->periodic) {
+        // two queue heads share a frame if phases are equal modulo the shorter period
+        uint32_t const mask = (1u << tu_min8(other->period_log2, qhd->period_log2)) - 1;
+        count += ((f & mask) == (other->period_phase & mask)) ? 1 : 0;
+      }
+    }
+
+    if (count < best_count) {
+      best_count = count;
+      best_frame = (uint16_t) f;
+    }
+  }
+
+  return best_frame;
+}
+
+
 //--------------------------------------------------------------------+
 // Queue Header helper
 //--------------------------------------------------------------------+
@@ -812,7 +1090,7 @@ static ehci_qhd_t *qhd_get_from_addr(uint8_t dev_addr, uint8_t ep_addr) {
 }
 
 // Init queue head with endpoint descriptor
-static void qhd_init(ehci_qhd_t *p_qhd, uint8_t dev_addr, tusb_desc_endpoint_t const * ep_desc)
+static bool qhd_init(ehci_qhd_t *p_qhd, uint8_t dev_addr, tusb_desc_endpoint_t const * ep_desc)
 {
   // address 0 is used as async head, which always on the list --> cannot be cleared (ehci halted otherwise)
   if (dev_addr != 0) {
@@ -836,30 +1114,57 @@ static void qhd_init(ehci_qhd_t *p_qhd, uint8_t dev_addr, tusb_desc_endpoint_t c
   p_qhd->nak_reload         = 0;
 
   // Bulk/Control -> smask = cmask = 0
-  // TODO Isochronous
+  // Isochronous endpoints use iTD/siTD instead of queue head, see iso_edpt_open()
   if (TUSB_XFER_INTERRUPT == xfer_type)
   {
+    p_qhd->periodic = 1;
+    uint16_t frame;
+
     if (TUSB_SPEED_HIGH == p_qhd->ep_speed)
     {
-      TU_ASSERT( interval <= 16, );
+      TU_ASSERT( interval <= 16 && interval != 0 );
       if ( interval < 4) // sub millisecond interval
       {
-        p_qhd->interval_ms = 0;
-        p_qhd->int_smask   = (interval == 1) ? TU_BIN8(11111111) :
-                             (interval == 2) ? TU_BIN8(10101010) : TU_BIN8(01000100);
+        // period 1, 2, 4 microframes: linked to every frame, place in least loaded microframe(s) via S-mask
+        uint8_t const period = (uint8_t) (1u << (interval - 1));
+        int16_t const phase = hcd_bw_reserve(dev_addr, ep_desc, true, period, 0, period);
+        TU_VERIFY(phase >= 0);
+
+        p_qhd->period_log2 = 0;
+        p_qhd->int_smask   = 0;
+        for (uint8_t uf = (uint8_t) phase; uf < 8; uf += period) {
+          p_qhd->int_smask |= TU_BIT(uf);
+        }
+        frame = 0;
       }else
       {
-        p_qhd->interval_ms = (uint8_t) tu_min16( 1 << (interval-4), 255 );
-        p_qhd->int_smask = TU_BIT(interval % 8);
+        // 2^(interval-4) frames, longer period than frame list is polled every frame list round
+        p_qhd->period_log2 = (uint8_t) tu_min8(interval - 4, FRAMELIST_SIZE_LOG2);
+        uint16_t const period_uf = (uint16_t) (8u << p_qhd->period_log2);
+        int16_t const phase = hcd_bw_reserve(dev_addr, ep_desc, true, period_uf, 0, period_uf);
+        TU_VERIFY(phase >= 0);
+
+        p_qhd->int_smask = TU_BIT(phase % 8);
+        frame = (uint16_t) (phase / 8);
       }
     }else
     {
-      TU_ASSERT( 0 != interval, );
-      // Full/Low: 4.12.2.1 (EHCI) case 1 schedule start split at 1 us & complete split at 2,3,4 uframes
-      p_qhd->int_smask    = 0x01;
-      p_qhd->fl_int_cmask = TU_BIN8(11100);
-      p_qhd->interval_ms  = interval;
+      TU_ASSERT( 0 != interval );
+      p_qhd->period_log2 = (uint8_t) tu_log2(tu_min32(interval, FRAMELIST_SIZE));
+
+      // Full/Low: 4.12.2.1 (EHCI) start split in microframe Y, complete split at Y+2, Y+3, Y+4. Planner chooses frame
+      // and Y within TT budget of the hub
+      uint16_t const period = (uint16_t) (1u << p_qhd->period_log2);
+      uint8_t smask, cmask;
+      int16_t const phase = hcd_bw_reserve_split(dev_addr, ep_desc, period, 0, period, &smask, &cmask);
+      TU_VERIFY(phase >= 0);
+
+      p_qhd->int_smask    = smask;
+      p_qhd->fl_int_cmask = cmask;
+      frame = (uint16_t) phase;
     }
+
+    p_qhd->period_phase = period_branch_balance(p_qhd, frame, PERIOD_BW_WINDOW);
   }else
   {
     p_qhd->int_smask = p_qhd->fl_int_cmask = 0;
@@ -884,15 +1189,21 @@ static void qhd_init(ehci_qhd_t *p_qhd, uint8_t dev_addr, tusb_desc_endpoint_t c
   {
     p_qhd->qtd_overlay.ping_err = 1; // do PING for Highspeed Bulk OUT, EHCI section 4.11
   }
+
+  return true;
 }
 
-// Attach a TD to queue head
+// Attach a TD (chain) to queue head
 static void qhd_attach_qtd(ehci_qhd_t *qhd, ehci_qtd_t *qtd) {
   qhd->attached_qtd = qtd;
   qhd->attached_buffer = qtd->buffer[0];
+  qhd->attached_len = 0;
 
   // clean and invalidate cache before physically write
-  hcd_dcache_clean_invalidate(qtd, sizeof(ehci_qtd_t));
+  for (ehci_qtd_t* td = qtd; td != NULL; td = qtd_next(td)) {
+    qhd->attached_len += td->total_bytes;
+    hcd_dcache_clean_invalidate(td, sizeof(ehci_qtd_t));
+  }
 
   qhd->qtd_overlay.next.address = (uint32_t) qtd;
   hcd_dcache_clean_invalidate(qhd, sizeof(ehci_qhd_t));
@@ -906,8 +1217,29 @@ static void qhd_remove_qtd(ehci_qhd_t *qhd) {
   qhd->attached_buffer = 0;
   hcd_dcache_clean(qhd, sizeof(ehci_qhd_t));
 
-  qtd->used = 0; // free QTD
-  hcd_dcache_clean(qtd, sizeof(ehci_qtd_t));
+  qtd_chain_free(qtd);
+}
+
+// Check if TD chain attached to queue head is done: last TD is retired, or an earlier TD is halted or ended with
+// short packet. xferred_bytes is number of bytes transferred by the chain
+static bool qhd_qtd_chain_done(ehci_qhd_t const* qhd, uint32_t* xferred_bytes) {
+  uint32_t remaining = 0;
+  bool done = false;
+
+  for (ehci_qtd_t* qtd = qhd->attached_qtd; qtd != NULL; qtd = qtd_next(qtd)) {
+    hcd_dcache_invalidate(qtd, sizeof(ehci_qtd_t)); // HC may have written back TD
+    remaining += qtd->total_bytes;
+
+    if (!done) {
+      if (qtd->active) {
+        return false;
+      }
+      done = qtd->halted || (qtd->total_bytes != 0) || (qtd_next(qtd) == NULL);
+    }
+  }
+
+  *xferred_bytes = qhd->attached_len - remaining;
+  return done;
 }
 
 //--------------------------------------------------------------------+
@@ -926,6 +1258,22 @@ TU_ATTR_ALWAYS_INLINE static inline ehci_qtd_t *qtd_find_free(void) {
   return NULL;
 }
 
+TU_ATTR_ALWAYS_INLINE static inline ehci_qtd_t* qtd_next(ehci_qtd_t const* qtd) {
+  return qtd->next.terminate ? NULL : (ehci_qtd_t*) tu_align32(qtd->next.address);
+}
+
+// Free TD and its chained TDs
+static void qtd_chain_free(ehci_qtd_t* qtd) {
+  hcd_dcache_batch_begin();
+  while (qtd != NULL) {
+    ehci_qtd_t* next = qtd_next(qtd);
+    qtd->used = 0;
+    hcd_dcache_clean(qtd, sizeof(ehci_qtd_t));
+    qtd = next;
+  }
+  hcd_dcache_batch_end();
+}
+
 static void qtd_init(ehci_qtd_t* qtd, void const* buffer, uint16_t total_bytes) {
   tu_memclr(qtd, sizeof(ehci_qtd_t));
   qtd->used                = 1;
@@ -945,4 +1293,351 @@ static void qtd_init(ehci_qtd_t* qtd, void const* buffer, uint16_t total_bytes)
   }
 }
 
+//--------------------------------------------------------------------+
+// Isochronous helper
+//--------------------------------------------------------------------+
+#if CFG_TUH_ISO_EDPT_MAX
+
+static ehci_iso_ep_t* iso_ep_find(uint8_t dev_addr, uint8_t ep_addr) {
+  for (uint8_t i = 0; i < CFG_TUH_ISO_EDPT_MAX; i++) {
+    ehci_iso_ep_t* iso = &ehci_data.iso_ep[i];
+    if (iso->dev_addr == dev_addr && iso->ep_addr == ep_addr) {
+      return iso;
+    }
+  }
+  return NULL;
+}
+
+TU_ATTR_ALWAYS_INLINE static inline ehci_iso_td_t* iso_td_get(ehci_iso_ep_t const* iso, uint8_t td_idx) {
+  return &ehci_data.iso_td[iso - ehci_data.iso_ep][td_idx];
+}
+
+// packets carried by one TD
+TU_ATTR_ALWAYS_INLINE static inline uint8_t iso_pkt_per_td(ehci_iso_ep_t const* iso) {
+  return iso->is_hs ? (uint8_t) (8 / iso->uf_period) : 1;
+}
+
+static bool iso_edpt_open(uint8_t dev_addr, tusb_desc_endpoint_t const* ep_desc) {
+  uint8_t const interval = ep_desc->bInterval;
+  TU_ASSERT(interval >= 1 && interval <= 16);
+
+  // endpoint can be re-opened with different alternate setting
+  ehci_iso_ep_t* iso = iso_ep_find(dev_addr, ep_desc->bEndpointAddress);
+  if (iso != NULL) {
+    iso_edpt_stop(iso);
+  } else {
+    iso = iso_ep_find(0, 0);
+  }
+  TU_ASSERT(iso); // not enough iso endpoint, try to increase CFG_TUH_ISO_EDPT_MAX
+
+  hcd_devtree_info_t devtree_info;
+  hcd_devtree_get_info(dev_addr, &devtree_info);
+
+  tu_memclr(iso, sizeof(ehci_iso_ep_t));
+  iso->ep_addr  = ep_desc->bEndpointAddress;
+  iso->mps      = tu_edpt_packet_size(ep_desc);
+  iso->hub_addr = devtree_info.hub_addr;
+  iso->hub_port = devtree_info.hub_port;
+
+  // interval is 2^(bInterval-1) microframes for high speed, frames for full speed
+  uint16_t const period = (uint16_t) (1u << (interval - 1));
+
+  if (devtree_info.speed == TUSB_SPEED_HIGH) {
+    int16_t const phase = hcd_bw_reserve(dev_addr, ep_desc, true, period, 0, period);
+    TU_VERIFY(phase >= 0);
+
+    iso->is_hs        = 1;
+    iso->mult         = (uint8_t) (1 + ((tu_le16toh(ep_desc->wMaxPacketSize) >> 11) & 0x3u));
+    iso->uf_period    = (uint8_t) tu_min16(period, 8);
+    iso->uf_phase     = (uint8_t) (phase % 8);
+    iso->frame_period = (uint16_t) tu_max16(period >> 3, 1);
+    iso->frame_phase  = (uint8_t) (phase / 8);
+  } else {
+    uint8_t smask, cmask;
+    int16_t const phase = hcd_bw_reserve_split(dev_addr, ep_desc, period, 0, period, &smask, &cmask);
+    TU_VERIFY(phase >= 0);
+
+    iso->is_hs        = 0;
+    iso->mult         = 1;
+    iso->smask        = smask;
+    iso->cmask        = cmask;
+    iso->frame_period = period;
+    iso->frame_phase  = (uint8_t) phase;
+  }
+
+  iso->dev_addr = dev_addr;
+
+  return true;
+}
+
+// Remove TD from its frame list slot. Isochronous TDs are always inserted at head, before interrupt queue heads
+static void iso_td_unlink(uint32_t frame, ehci_link_t const* td) {
+  ehci_link_t* prev = &ehci_data.period_framelist[frame % FRAMELIST_SIZE];
+
+  while (!prev->terminate && (prev->type == EHCI_QTYPE_ITD || prev->type == EHCI_QTYPE_SITD)) {
+    ehci_link_t* next = list_next(prev);
+    if (next == td) {
+      prev->address = td->address;
+      hcd_dcache_clean(prev, sizeof(ehci_link_t));
+      break;
+    }
+    prev = next;
+  }
+}
+
+// Unlink all scheduled TDs and drop queued transfers
+static void iso_edpt_stop(ehci_iso_ep_t* iso) {
+  while (iso->td_count) {
+    iso_td_unlink(iso->td_info[iso->td_head].frame, (ehci_link_t const*) iso_td_get(iso, iso->td_head));
+    iso->td_head = (uint8_t) ((iso->td_head + 1) % ISO_TD_MAX);
+    iso->td_count--;
+  }
+
+  iso->td_head = 0;
+  iso->xfer_head = 0;
+  iso->xfer_count = 0;
+  iso->started = 0;
+}
+
+static void itd_init(ehci_iso_ep_t const* iso, ehci_itd_t* itd, ehci_iso_xfer_t const* xfer, uint8_t pkt_count) {
+  tu_memclr(itd, sizeof(ehci_itd_t));
+
+  uint32_t const start = (uint32_t) (uintptr_t) xfer->buffer + xfer->sched_offset;
+  uint32_t const page0 = tu_align4k(start);
+  uint32_t offset = start - page0;
+
+  uint8_t uf = iso->uf_phase;
+  for (uint8_t i = 0; i < pkt_count; i++) {
+    uint16_t const len = xfer->packets[xfer->sched_count + i].len;
+    itd->xact[uf].offset          = offset & 0xFFFu;
+    itd->xact[uf].page_select     = (offset >> 12) & 0x7u;
+    itd->xact[uf].length          = len;
+    itd->xact[uf].int_on_complete = (i == pkt_count - 1) ? 1 : 0;
+    itd->xact[uf].active          = 1;
+
+    offset += len;
+    uf += iso->uf_period;
+  }
+
+  for (uint8_t p = 0; p < 7; p++) {
+    itd->BufferPointer[p] = page0 + 4096u * p;
+  }
+
+  // endpoint info is stored in reserved low bits of first 3 page pointers (EHCI 3.3.3)
+  itd->BufferPointer[0] |= iso->dev_addr | ((uint32_t) tu_edpt_number(iso->ep_addr) << 8);
+  itd->BufferPointer[1] |= iso->mps | ((uint32_t) tu_edpt_dir(iso->ep_addr) << 11);
+  itd->BufferPointer[2] |= iso->mult;
+}
+
+static void sitd_init(ehci_iso_ep_t const* iso, ehci_sitd_t* sitd, ehci_iso_xfer_t const* xfer) {
+  tu_memclr(sitd, sizeof(ehci_sitd_t));
+
+  uint32_t const start = (uint32_t) (uintptr_t) xfer->buffer + xfer->sched_offset;
+  uint16_t const len = xfer->packets[xfer->sched_count].len;
+  uint8_t const dir = tu_edpt_dir(iso->ep_addr);
+
+  sitd->dev_addr        = iso->dev_addr;
+  sitd->ep_number       = tu_edpt_number(iso->ep_addr);
+  sitd->hub_addr        = iso->hub_addr;
+  sitd->port_number     = iso->hub_port;
+  sitd->direction       = dir;
+  sitd->int_smask       = iso->smask;
+  sitd->fl_int_cmask    = iso->cmask;
+  sitd->total_bytes     = len;
+  sitd->int_on_complete = 1;
+  sitd->active          = 1;
+
+  sitd->buffer[0] = start;
+  sitd->buffer[1] = tu_align4k(start) + 4096;
+  if (dir == TUSB_DIR_OUT) {
+    // OUT payload is sent with one start-split per 188 bytes, TP = ALL if single else BEGIN (EHCI 3.4.5)
+    uint32_t const t_count = tu_max32(tu_div_ceil(len, 188), 1);
+    uint32_t const tp = (t_count == 1) ? 0 : 1;
+    sitd->buffer[1] |= (tp << 3) | t_count;
+  }
+
+  sitd->back.terminate = 1;
+}
+
+// Mark packets which missed their frame as failed
+static void iso_skip_packets(ehci_iso_xfer_t* xfer, uint16_t count) {
+  count = tu_min16(count, (uint16_t) (xfer->n_packets - xfer->sched_count));
+  for (uint16_t i = 0; i < count; i++) {
+    hcd_iso_packet_t* pkt = &xfer->packets[xfer->sched_count];
+    pkt->actual_len = 0;
+    pkt->result = XFER_RESULT_FAILED;
+    xfer->sched_offset += pkt->len;
+    xfer->sched_count++;
+    xfer->done_count++;
+  }
+  xfer->failed = xfer->failed || (count > 0);
+}
+
+// transfer of next packets to schedule, NULL if all packets are scheduled
+static ehci_iso_xfer_t* iso_xfer_to_schedule(ehci_iso_ep_t* iso) {
+  for (uint8_t i = 0; i < iso->xfer_count; i++) {
+    ehci_iso_xfer_t* xfer = &iso->xfer[(iso->xfer_head + i) % ISO_XFER_MAX];
+    if (xfer->sched_count < xfer->n_packets) {
+      return xfer;
+    }
+  }
+  return NULL;
+}
+
+// Fill free TDs with packets of queued transfers. A TD only carries packets of one transfer, high speed transfer
+// should have multiple of (8 / microframe interval) packets for gapless streaming.
+static void iso_schedule(ehci_iso_ep_t* iso) {
+  // host controller may cache up to isochronous scheduling threshold ahead, keep 2 frames margin
+  uint32_t const earliest = hcd_frame_number(0) + 2;
+  uint8_t const pkt_per_td = iso_pkt_per_td(iso);
+
+  while (iso->td_count < ISO_TD_MAX) {
+    ehci_iso_xfer_t* xfer = iso_xfer_to_schedule(iso);
+    if (xfer == NULL) {
+      break;
+    }
+
+    if (!iso->started || (int32_t) (iso->next_frame - earliest) < 0) {
+      // (re)start on next frame of endpoint phase, TDs of skipped frames are late
+      uint32_t const frame = earliest +
+                             (iso->frame_phase + iso->frame_period - earliest % iso->frame_period) % iso->frame_period;
+
+      if (iso->started) {
+        uint32_t const skipped = (frame - iso->next_frame) / iso->frame_period;
+        iso_skip_packets(xfer, (uint16_t) tu_min32(skipped * pkt_per_td, UINT16_MAX));
+        if (xfer->sched_count == xfer->n_packets) {
+          iso->next_frame = frame;
+          continue; // whole transfer is late
+        }
+      }
+
+      iso->next_frame = frame;
+      iso->started = 1;
+    }
+
+    // frame list slot can only be reused once previous TD in it is retired
+    if (iso->td_count && (iso->next_frame - iso->td_info[iso->td_head].frame) >= FRAMELIST_SIZE) {
+      break;
+    }
+
+    uint8_t const td_idx = (uint8_t) ((iso->td_head + iso->td_count) % ISO_TD_MAX);
+    ehci_iso_td_t* td = iso_td_get(iso, td_idx);
+    uint8_t const pkt_count = (uint8_t) tu_min16(pkt_per_td, (uint16_t) (xfer->n_packets - xfer->sched_count));
+
+    if (iso->is_hs) {
+      itd_init(iso, &td->itd, xfer, pkt_count);
+    } else {
+      sitd_init(iso, &td->sitd, xfer);
+    }
+
+    iso->td_info[td_idx].frame     = iso->next_frame;
+    iso->td_info[td_idx].pkt_first = xfer->sched_count;
+    iso->td_info[td_idx].pkt_count = pkt_count;
+    iso->td_info[td_idx].xfer_id   = (uint8_t) (xfer - iso->xfer);
+
+    for (uint8_t i = 0; i < pkt_count; i++) {
+      xfer->sched_offset += xfer->packets[xfer->sched_count].len;
+      xfer->sched_count++;
+    }
+
+    // link to frame list
+    ehci_link_t* fl = &ehci_data.period_framelist[iso->next_frame % FRAMELIST_SIZE];
+    list_insert(fl, (ehci_link_t*) td, iso->is_hs ? EHCI_QTYPE_ITD : EHCI_QTYPE_SITD);
+    hcd_dcache_clean(td, sizeof(ehci_iso_td_t));
+    hcd_dcache_clean(fl, sizeof(ehci_link_t));
+
+    iso->td_count++;
+    iso->next_frame += iso->frame_period;
+  }
+}
+
+// Retire TDs whose frame has passed: update packet status and unlink from frame list
+static void iso_retire(ehci_iso_ep_t* iso) {
+  uint32_t const now = hcd_frame_number(0);
+  bool const is_in = (tu_edpt_dir(iso->ep_addr) == TUSB_DIR_IN);
+
+  while (iso->td_count) {
+    uint8_t const td_idx = iso->td_head;
+    if ((int32_t) (now - iso->td_info[td_idx].frame) <= 0) {
+      break; // HC is still processing this frame
+    }
+
+    ehci_iso_td_t* td = iso_td_get(iso, td_idx);
+    hcd_dcache_invalidate(td, sizeof(ehci_iso_td_t)); // HC may have written back TD
+    iso_td_unlink(iso->td_info[td_idx].frame, (ehci_link_t const*) td);
+
+    ehci_iso_xfer_t* xfer = &iso->xfer[iso->td_info[td_idx].xfer_id];
+    uint8_t uf = iso->uf_phase;
+
+    for (uint8_t i = 0; i < iso->td_info[td_idx].pkt_count; i++) {
+      hcd_iso_packet_t* pkt = &xfer->packets[iso->td_info[td_idx].pkt_first + i];
+      bool failed;
+      uint16_t actual_len;
+
+      if (iso->is_hs) {
+        // still active means HC could not process it in time
+        failed = td->itd.xact[uf].active || td->itd.xact[uf].error || td->itd.xact[uf].babble_err ||
+                 td->itd.xact[uf].buffer_err;
+        actual_len = is_in ? (uint16_t) td->itd.xact[uf].length : pkt->len;
+        uf += iso->uf_period;
+      } else {
+        ehci_sitd_t const* sitd = &td->sitd;
+        failed = sitd->active || sitd->xact_err || sitd->babble_err || sitd->buffer_err || sitd->error ||
+                 sitd->missed_uframe;
+        actual_len = is_in ? (uint16_t) (pkt->len - sitd->total_bytes) : pkt->len;
+      }
+
+      if (failed) {
+        actual_len = 0;
+      }
+
+      pkt->actual_len = actual_len;
+      pkt->result = failed ? XFER_RESULT_FAILED : XFER_RESULT_SUCCESS;
+      xfer->xferred_bytes += actual_len;
+      xfer->failed = xfer->failed || failed;
+      xfer->done_count++;
+    }
+
+    iso->td_head = (uint8_t) ((iso->td_head + 1) % ISO_TD_MAX);
+    iso->td_count--;
+  }
+}
+
+// Notify usbh of transfers whose packets are all completed, in submitted order
+static void iso_complete(ehci_iso_ep_t* iso, bool in_isr) {
+  bool const is_in = (tu_edpt_dir(iso->ep_addr) == TUSB_DIR_IN);
+
+  while (iso->xfer_count) {
+    ehci_iso_xfer_t* xfer = &iso->xfer[iso->xfer_head];
+    if (xfer->done_count < xfer->n_packets) {
+      break;
+    }
+
+    // invalidate dcache of received data
+    if (is_in && xfer->sched_offset) {
+      hcd_dcache_invalidate(xfer->buffer, xfer->sched_offset);
+    }
+
+    iso->xfer_head = (uint8_t) ((iso->xfer_head + 1) % ISO_XFER_MAX);
+    iso->xfer_count--;
+
+    hcd_event_xfer_complete(iso->dev_addr, iso->ep_addr, xfer->xferred_bytes,
+                            xfer->failed ? XFER_RESULT_FAILED : XFER_RESULT_SUCCESS, in_isr);
+  }
+
+  // stream stopped: transfer is not submitted in time, next one starts over without counting late frames
+  if (iso->xfer_count == 0 && iso->td_count == 0) {
+    iso->started = 0;
+  }
+}
+
+static void iso_service(ehci_iso_ep_t* iso, bool in_isr) {
+  iso_retire(iso);
+  iso_complete(iso, in_isr);
+  iso_schedule(iso);
+  iso_complete(iso, in_isr); // late packets may complete a transfer
+}
+
+#endif
+
 #endif
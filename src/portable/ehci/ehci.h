@@ -159,14 +159,16 @@ typedef struct TU_ATTR_ALIGNED(32)
   /// Due to the fact QHD is 32 bytes aligned but occupies only 48 bytes
 	/// thus there are 16 bytes padding free that we can make use of.
   //--------------------------------------------------------------------+
-	uint8_t used;
-	uint8_t removing; // removed from asyn list, waiting for async advance
+	uint8_t used        : 1;
+	uint8_t removing    : 1; // removed from asyn list, waiting for async advance
+	uint8_t periodic    : 1; // linked to periodic frame list (interrupt endpoint)
+	uint8_t period_log2 : 4; // polled every 2^period_log2 frames, microframes within frame are in int_smask
 	uint8_t pid;
-	uint8_t interval_ms; // polling interval in frames (or millisecond)
+	uint16_t period_phase;   // first frame linking this queue head in frame list
 
-	uint8_t TU_RESERVED[4];
+	uint32_t attached_len; // total bytes of attached TD chain
 
-  // Attached TD management, note usbh will only queue 1 TD per QHD.
+  // Attached TD management, note usbh will only queue 1 transfer per QHD, which may be a chain of TDs.
   // buffer for dcache invalidate since td's buffer is modified by HC and finding initial buffer address is not trivial
   uint32_t attached_buffer;
 	ehci_qtd_t * volatile attached_qtd;
@@ -65,7 +65,7 @@
 
 typedef struct {
     uint8_t *buffer;
-    // tu_fifo_t * ff; // TODO support dcd_edpt_xfer_fifo API
+    tu_fifo_t * ff;
     uint16_t total_len;
     uint16_t queued_len;
     uint16_t max_size;
@@ -85,6 +85,15 @@ static xfer_ctl_t xfer_status[EP_MAX][2];
 // Keep count of how many FIFOs are in use
 static uint8_t _allocated_fifos = 1; //FIFO0 is always in use
 
+// Number of 32-bit words allocated to IN FIFOs from the top of FIFO RAM, 16 for EP0 IN
+static uint16_t _allocated_in_words = 16;
+
+// Size of shared OUT FIFO in 32-bit words for largest OUT packet size, see bus_reset()
+static inline uint16_t rx_fifo_words(uint16_t max_size)
+{
+  return (uint16_t) (11 + 2 * ((max_size + 3) / 4 + 2));
+}
+
 // Will either return an unused FIFO number, or 0 if all are used.
 static uint8_t get_free_fifo(void)
 {
@@ -110,15 +119,13 @@ static void bus_reset(void)
   // Peripheral FIFO architecture
   //
   // --------------- 320 or 1024 ( 1280 or 4096 bytes )
-  // | IN FIFO MAX |
+  // | IN FIFO 0   |
+  // --------------- EP_FIFO_SIZE/4 - 16
+  // | IN FIFO 1   |
   // ---------------
   // |    ...      |
-  // --------------- y + x + 16 + GRXFSIZ
-  // | IN FIFO 2   |
-  // --------------- x + 16 + GRXFSIZ
-  // | IN FIFO 1   |
-  // --------------- 16 + GRXFSIZ
-  // | IN FIFO 0   |
+  // --------------- EP_FIFO_SIZE/4 - _allocated_in_words
+  // |   (free)    |
   // --------------- GRXFSIZ
   // | OUT FIFO    |
   // | ( Shared )  |
@@ -130,7 +137,7 @@ static void bus_reset(void)
   // - All EP OUT shared a unique OUT FIFO which uses
   //   * 10 locations in hardware for setup packets + setup control words (up to 3 setup packets).
   //   * 2 locations for OUT endpoint control words.
-  //   * 16 for largest packet size of 64 bytes. ( TODO Highspeed is 512 bytes)
+  //   * 16 for largest packet size of 64 bytes, grown by dcd_edpt_open() for larger OUT endpoints
   //   * 1 location for global NAK (not required/used here).
   //   * It is recommended to allocate 2 times the largest packet size, therefore
   //   Recommended value = 10 + 1 + 2 x (16+2) = 47 --> Let's make it 52
@@ -138,8 +145,9 @@ static void bus_reset(void)
   USB0.grstctl |= USB_TXFFLSH_M;        // Flush fifo
   USB0.grxfsiz = 52;
 
-  // Control IN uses FIFO 0 with 64 bytes ( 16 32-bit word )
-  USB0.gnptxfsiz = (16 << USB_NPTXFDEP_S) | (USB0.grxfsiz & 0x0000ffffUL);
+  // Control IN uses FIFO 0 with 64 bytes ( 16 32-bit word ) at the top of FIFO RAM
+  _allocated_in_words = 16;
+  USB0.gnptxfsiz = (16 << USB_NPTXFDEP_S) | (EP_FIFO_SIZE/4 - 16);
 
   // Ready to receive SETUP packet
   USB0.out_ep_reg[0].doeptsiz |= USB_SUPCNT0_M;
@@ -284,6 +292,13 @@ bool dcd_edpt_open(uint8_t rhport, tusb_desc_endpoint_t const *desc_edpt)
   xfer->interval = desc_edpt->bInterval;
 
   if (dir == TUSB_DIR_OUT) {
+    // Grow shared OUT FIFO for packet size larger than 64 bytes e.g isochronous
+    uint16_t const rx_words = rx_fifo_words(xfer->max_size);
+    if (rx_words > (USB0.grxfsiz & 0x0000ffff)) {
+      TU_ASSERT(rx_words <= EP_FIFO_SIZE/4 - _allocated_in_words);
+      USB0.grxfsiz = rx_words;
+    }
+
     out_ep[epnum].doepctl |= USB_USBACTEP1_M |
                              desc_edpt->bmAttributes.xfer << USB_EPTYPE1_S |
                              (desc_edpt->bmAttributes.xfer != TUSB_XFER_ISOCHRONOUS ? USB_DO_SETD0PID1_M : 0) |
@@ -294,23 +309,22 @@ bool dcd_edpt_open(uint8_t rhport, tusb_desc_endpoint_t const *desc_edpt)
     // Peripheral FIFO architecture
     //
     // --------------- 320 or 1024 ( 1280 or 4096 bytes )
-    // | IN FIFO MAX |
+    // | IN FIFO 0   |
+    // --------------- EP_FIFO_SIZE/4 - 16
+    // | IN FIFO 1   |
     // ---------------
     // |    ...      |
-    // --------------- y + x + 16 + GRXFSIZ
-    // | IN FIFO 2   |
-    // --------------- x + 16 + GRXFSIZ
-    // | IN FIFO 1   |
-    // --------------- 16 + GRXFSIZ
-    // | IN FIFO 0   |
+    // --------------- EP_FIFO_SIZE/4 - _allocated_in_words
+    // |   (free)    |
     // --------------- GRXFSIZ
     // | OUT FIFO    |
     // | ( Shared )  |
     // --------------- 0
     //
-    // Since OUT FIFO = GRXFSIZ, FIFO 0 = 16, for simplicity, we equally allocated for the rest of endpoints
-    // - Size  : (FIFO_SIZE/4 - GRXFSIZ - 16) / (EP_MAX-1)
-    // - Offset: GRXFSIZ + 16 + Size*(epnum-1)
+    // IN FIFOs are allocated downward from the top of FIFO RAM according to max packet size, so that OUT FIFO can
+    // still grow for larger OUT endpoints opened later.
+    // - Size  : 2 packets for bulk/interrupt to keep the FIFO busy while next packet is written, 1 for isochronous
+    //   since only one packet is sent per frame
     // - IN EP 1 gets FIFO 1, IN EP "n" gets FIFO "n".
 
     uint8_t fifo_num = get_free_fifo();
@@ -326,10 +340,12 @@ bool dcd_edpt_open(uint8_t rhport, tusb_desc_endpoint_t const *desc_edpt)
     USB0.daintmsk |= (1 << (0 + epnum));
 
     // Both TXFD and TXSA are in unit of 32-bit words.
-    // IN FIFO 0 was configured during enumeration, hence the "+ 16".
-    uint16_t const allocated_size = (USB0.grxfsiz & 0x0000ffff) + 16;
-    uint16_t const fifo_size = (EP_FIFO_SIZE/4 - allocated_size) / (EP_FIFO_NUM-1);
-    uint32_t const fifo_offset = allocated_size + fifo_size*(fifo_num-1);
+    uint16_t const packet_words = (uint16_t) ((xfer->max_size + 3) / 4);
+    uint16_t const fifo_size = tu_max16(16, desc_edpt->bmAttributes.xfer == TUSB_XFER_ISOCHRONOUS ?
+                                                packet_words : (uint16_t) (2 * packet_words));
+    TU_ASSERT(_allocated_in_words + fifo_size <= EP_FIFO_SIZE/4 - (USB0.grxfsiz & 0x0000ffff));
+    _allocated_in_words += fifo_size;
+    uint32_t const fifo_offset = EP_FIFO_SIZE/4 - _allocated_in_words;
 
     // DIEPTXF starts at FIFO #1.
     USB0.dieptxf[epnum - 1] = (fifo_size << USB_NPTXFDEP_S) | fifo_offset;
@@ -359,18 +375,18 @@ void dcd_edpt_close_all(uint8_t rhport)
   }
 
   _allocated_fifos = 1;
+  _allocated_in_words = 16;
+  USB0.grxfsiz = 52;
 }
 
-bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t *buffer, uint16_t total_bytes)
+static bool edpt_xfer(uint8_t ep_addr, uint8_t *buffer, tu_fifo_t * ff, uint16_t total_bytes)
 {
-  (void)rhport;
-
   uint8_t const epnum = tu_edpt_number(ep_addr);
   uint8_t const dir   = tu_edpt_dir(ep_addr);
 
   xfer_ctl_t * xfer = XFER_CTL_BASE(epnum, dir);
   xfer->buffer       = buffer;
-  // xfer->ff           = NULL; // TODO support dcd_edpt_xfer_fifo API
+  xfer->ff           = ff;
   xfer->total_len    = total_bytes;
   xfer->queued_len   = 0;
   xfer->short_packet = false;
@@ -420,12 +436,23 @@ bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t *buffer, uint16_t to
   return true;
 }
 
-#if 0 // TODO support dcd_edpt_xfer_fifo API
-bool dcd_edpt_xfer_fifo (uint8_t rhport, uint8_t ep_addr, tu_fifo_t * ff, uint16_t total_bytes)
+bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t *buffer, uint16_t total_bytes)
 {
   (void)rhport;
+  return edpt_xfer(ep_addr, buffer, NULL, total_bytes);
+}
+
+// The number of bytes has to be given explicitly to allow more flexible control of how many
+// bytes should be written and second to keep the return value free to give back a boolean
+// success message. If total_bytes is too big, the FIFO will copy only what is available
+// into the USB buffer!
+bool dcd_edpt_xfer_fifo(uint8_t rhport, uint8_t ep_addr, tu_fifo_t * ff, uint16_t total_bytes)
+{
+  (void)rhport;
+  // USB buffers always work in bytes so to avoid unnecessary divisions we demand item_size = 1
+  TU_ASSERT(ff->item_size == 1);
+  return edpt_xfer(ep_addr, NULL, ff, total_bytes);
 }
-#endif
 
 void dcd_edpt_stall(uint8_t rhport, uint8_t ep_addr)
 {
@@ -536,14 +563,12 @@ static void receive_packet(xfer_ctl_t *xfer, /* usb_out_endpoint_t * out_ep, */
   }
 
   // Common buffer read
-#if 0 // TODO support dcd_edpt_xfer_fifo API
   if (xfer->ff)
   {
     // Ring buffer
-    tu_fifo_write_n_const_addr_full_words(xfer->ff, (const void *) rx_fifo, to_recv_size);
+    tu_fifo_write_n_const_addr_full_words(xfer->ff, (const void *) (uintptr_t) rx_fifo, to_recv_size);
   }
   else
-#endif
   {
     uint8_t to_recv_rem = to_recv_size % 4;
     uint16_t to_recv_size_aligned = to_recv_size - to_recv_rem;
@@ -595,13 +620,11 @@ static void transmit_packet(xfer_ctl_t *xfer, volatile usb_in_endpoint_t *in_ep,
 
   uint16_t to_xfer_size = (remaining > xfer->max_size) ? xfer->max_size : remaining;
 
-#if 0 // TODO support dcd_edpt_xfer_fifo API
   if (xfer->ff)
   {
-    tu_fifo_read_n_const_addr_full_words(xfer->ff, (void *) tx_fifo, to_xfer_size);
+    tu_fifo_read_n_const_addr_full_words(xfer->ff, (void *) (uintptr_t) tx_fifo, to_xfer_size);
   }
   else
-#endif
   {
     uint8_t to_xfer_rem = to_xfer_size % 4;
     uint16_t to_xfer_size_aligned = to_xfer_size - to_xfer_rem;
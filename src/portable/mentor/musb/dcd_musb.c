@@ -79,6 +79,12 @@ typedef struct
   pipe_state_t pipe0;
   pipe_state_t pipe[2][TUP_DCD_ENDPOINT_MAX-1];   /* pipe[direction][endpoint number - 1] */
   uint16_t     pipe_buf_is_fifo[2]; /* Bitmap. Each bit means whether 1:TU_FIFO or 0:POD. */
+#if CFG_TUD_MUSB_DMA
+  uint16_t     pipe_dma_busy[2]; /* Bitmap. Each bit means whether DMA transfer is in progress. */
+  uint8_t      dma_ch[2][TUP_DCD_ENDPOINT_MAX-1]; /* DMA channel + 1 assigned to bulk endpoint, 0 if none */
+  uint8_t      dma_ep[8];   /* endpoint address of each allocated DMA channel */
+  uint8_t      dma_count;   /* number of allocated DMA channels */
+#endif
 } dcd_data_t;
 
 static dcd_data_t _dcd;
@@ -262,14 +268,18 @@ static bool handle_xfer_in(uint8_t rhport, uint_fast8_t ep_addr)
   unsigned epnum_minus1 = epnum - 1;
   pipe_state_t  *pipe = &_dcd.pipe[tu_edpt_dir(ep_addr)][epnum_minus1];
   const unsigned rem  = pipe->remaining;
+  musb_regs_t* musb_regs = MUSB_REGS(rhport);
+  musb_ep_csr_t* ep_csr = get_ep_csr(musb_regs, epnum);
 
   if (!rem) {
+#if CFG_TUD_MUSB_DMA
+    /* Last packet written by DMA is not sent yet, this is an interrupt of previous packets */
+    if (ep_csr->tx_csrl & MUSB_TXCSRL1_TXRDY) return false;
+#endif
     pipe->buf = NULL;
     return true;
   }
 
-  musb_regs_t* musb_regs = MUSB_REGS(rhport);
-  musb_ep_csr_t* ep_csr = get_ep_csr(musb_regs, epnum);
   const unsigned mps = ep_csr->tx_maxp;
   const unsigned len = TU_MIN(mps, rem);
   void          *buf = pipe->buf;
@@ -323,6 +333,73 @@ static bool handle_xfer_out(uint8_t rhport, uint_fast8_t ep_addr)
   return false;
 }
 
+#if CFG_TUD_MUSB_DMA
+/* Start DMA mode 1 transfer of multiple packets. Return false if CPU should transfer instead:
+ * no channel, FIFO buffer, unaligned buffer or less than 2 packets. */
+static bool edpt_dma_xfer(uint8_t rhport, uint_fast8_t ep_addr)
+{
+  unsigned epnum = tu_edpt_number(ep_addr);
+  unsigned epnum_minus1 = epnum - 1;
+  unsigned dir_in = tu_edpt_dir(ep_addr);
+  unsigned ch = _dcd.dma_ch[dir_in][epnum_minus1];
+  pipe_state_t *pipe = &_dcd.pipe[dir_in][epnum_minus1];
+
+  if (!ch || (_dcd.pipe_buf_is_fifo[dir_in] & TU_BIT(epnum_minus1)) || ((uintptr_t)pipe->buf & 3)) return false;
+
+  musb_regs_t* musb_regs = MUSB_REGS(rhport);
+  musb_ep_csr_t* ep_csr = get_ep_csr(musb_regs, epnum);
+  unsigned count;
+  if (dir_in) {
+    /* Full packets are committed by AUTOSET, last short packet is committed when DMA completes */
+    const unsigned mps = ep_csr->tx_maxp;
+    count = pipe->remaining;
+    if (count <= mps) return false;
+    ep_csr->tx_csrh |= MUSB_TXCSRH1_AUTOSET | MUSB_TXCSRH1_DMAEN | MUSB_TXCSRH1_DMAMOD;
+  } else {
+    /* Full packets except the last one, which is read by CPU as usual to end the transfer */
+    const unsigned mps = ep_csr->rx_maxp;
+    if (pipe->remaining <= mps) return false;
+    count = ((pipe->remaining - 1u) / mps) * mps;
+    if (ep_csr->rx_csrl & MUSB_RXCSRL1_RXRDY) ep_csr->rx_csrl = 0;
+    ep_csr->rx_csrh |= MUSB_RXCSRH1_AUTOCL | MUSB_RXCSRH1_DMAEN | MUSB_RXCSRH1_DMAMOD;
+  }
+
+  _dcd.pipe_dma_busy[dir_in] |= TU_BIT(epnum_minus1);
+  musb_dma_start(musb_regs, ch - 1, epnum, dir_in, pipe->buf, count);
+  return true;
+}
+
+/* Stop DMA transfer of endpoint and account transferred bytes. Index register is already set by caller */
+static void edpt_dma_stop(musb_regs_t* musb_regs, uint_fast8_t ep_addr)
+{
+  unsigned epnum_minus1 = tu_edpt_number(ep_addr) - 1;
+  unsigned dir_in = tu_edpt_dir(ep_addr);
+  pipe_state_t *pipe = &_dcd.pipe[dir_in][epnum_minus1];
+
+  const uint32_t xferred = musb_dma_stop(musb_regs, _dcd.dma_ch[dir_in][epnum_minus1] - 1u, pipe->buf);
+  pipe->buf        = (uint8_t*)pipe->buf + xferred;
+  pipe->remaining  = (uint16_t)(pipe->remaining - xferred);
+
+  if (dir_in) {
+    musb_regs->indexed_csr.tx_csrh &= ~(MUSB_TXCSRH1_AUTOSET | MUSB_TXCSRH1_DMAEN | MUSB_TXCSRH1_DMAMOD);
+  } else {
+    musb_regs->indexed_csr.rx_csrh &= ~(MUSB_RXCSRH1_AUTOCL | MUSB_RXCSRH1_DMAEN | MUSB_RXCSRH1_DMAMOD);
+  }
+  _dcd.pipe_dma_busy[dir_in] &= ~TU_BIT(epnum_minus1);
+}
+
+/* Stop all channels and release them from endpoints */
+static void dma_reset(musb_regs_t* musb_regs)
+{
+  for (unsigned ch = 0; ch < _dcd.dma_count; ch++) {
+    musb_regs->dma[ch].cntl = 0;
+  }
+  _dcd.dma_count = 0;
+  _dcd.pipe_dma_busy[0] = _dcd.pipe_dma_busy[1] = 0;
+  tu_memclr(_dcd.dma_ch, sizeof(_dcd.dma_ch));
+}
+#endif
+
 static bool edpt_n_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t *buffer, uint16_t total_bytes)
 {
   unsigned epnum = tu_edpt_number(ep_addr);
@@ -334,6 +411,10 @@ static bool edpt_n_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t *buffer, uint16
   pipe->length       = total_bytes;
   pipe->remaining    = total_bytes;
 
+#if CFG_TUD_MUSB_DMA
+  if (edpt_dma_xfer(rhport, ep_addr)) return true;
+#endif
+
   if (dir_in) {
     handle_xfer_in(rhport, ep_addr);
   } else {
@@ -512,6 +593,10 @@ static void process_edpt_n(uint8_t rhport, uint_fast8_t ep_addr)
       ep_csr->tx_csrl &= ~(MUSB_TXCSRL1_STALLED | MUSB_TXCSRL1_UNDRN);
       return;
     }
+#if CFG_TUD_MUSB_DMA
+    /* Packets are written by DMA, transfer continues on DMA completion */
+    if (_dcd.pipe_dma_busy[TUSB_DIR_IN] & TU_BIT(epn_minus1)) return;
+#endif
     completed = handle_xfer_in(rhport, ep_addr);
   } else {
     // TU_LOG1(" RX CSRL%d = %x\r\n", epn, ep_csr->rx_csrl);
@@ -519,6 +604,12 @@ static void process_edpt_n(uint8_t rhport, uint_fast8_t ep_addr)
       ep_csr->rx_csrl &= ~(MUSB_RXCSRL1_STALLED | MUSB_RXCSRL1_OVER);
       return;
     }
+#if CFG_TUD_MUSB_DMA
+    /* Short packet ends DMA transfer early, it is read by CPU */
+    if (_dcd.pipe_dma_busy[TUSB_DIR_OUT] & TU_BIT(epn_minus1)) {
+      edpt_dma_stop(musb_regs, ep_addr);
+    }
+#endif
     completed = handle_xfer_out(rhport, ep_addr);
   }
 
@@ -530,6 +621,39 @@ static void process_edpt_n(uint8_t rhport, uint_fast8_t ep_addr)
   }
 }
 
+#if CFG_TUD_MUSB_DMA
+static void process_dma(uint8_t rhport, unsigned ch)
+{
+  musb_regs_t* musb_regs = MUSB_REGS(rhport);
+  const uint_fast8_t ep_addr = _dcd.dma_ep[ch];
+  const unsigned epn = tu_edpt_number(ep_addr);
+  const unsigned dir_in = tu_edpt_dir(ep_addr);
+  if (!(_dcd.pipe_dma_busy[dir_in] & TU_BIT(epn - 1))) return;
+
+  const bool bus_error = musb_regs->dma[ch].cntl & MUSB_DMACTL0_ERR;
+  musb_ep_csr_t* ep_csr = get_ep_csr(musb_regs, epn);
+  edpt_dma_stop(musb_regs, ep_addr);
+
+  pipe_state_t *pipe = &_dcd.pipe[dir_in][epn - 1];
+  if (bus_error) {
+    hwfifo_flush(musb_regs, epn, 1 - dir_in, false);
+    pipe->buf = NULL;
+    dcd_event_xfer_complete(rhport, ep_addr, pipe->length - pipe->remaining, XFER_RESULT_FAILED, true);
+    return;
+  }
+
+  if (dir_in) {
+    /* Commit last short packet, completion is reported by TX interrupt when it is sent */
+    if (pipe->length % ep_csr->tx_maxp) {
+      ep_csr->tx_csrl = MUSB_TXCSRL1_TXRDY;
+    }
+  } else if (ep_csr->rx_csrl & MUSB_RXCSRL1_RXRDY) {
+    /* Last packet is already received */
+    process_edpt_n(rhport, ep_addr);
+  }
+}
+#endif
+
 // Upon BUS RESET is detected, hardware havs already done:
 // faddr = 0, index = 0, flushes all ep fifos, clears all ep csr, enabled all ep interrupts
 static void process_bus_reset(uint8_t rhport) {
@@ -548,6 +672,10 @@ static void process_bus_reset(uint8_t rhport) {
   musb->intr_txen = 1; /* Enable only EP0 */
   musb->intr_rxen = 0;
 
+#if CFG_TUD_MUSB_DMA
+  dma_reset(musb);
+#endif
+
   /* Clear FIFO settings */
   for (unsigned i = 1; i < TUP_DCD_ENDPOINT_MAX; ++i) {
     musb->index = i;
@@ -647,10 +775,12 @@ void dcd_disconnect(uint8_t rhport)
 
 void dcd_sof_enable(uint8_t rhport, bool en)
 {
-  (void) rhport;
-  (void) en;
-
-  // TODO implement later
+  musb_regs_t* musb_regs = MUSB_REGS(rhport);
+  if (en) {
+    musb_regs->intr_usben |= MUSB_IE_SOF;
+  } else {
+    musb_regs->intr_usben &= ~MUSB_IE_SOF;
+  }
 }
 
 //--------------------------------------------------------------------+
@@ -691,6 +821,17 @@ bool dcd_edpt_open(uint8_t rhport, tusb_desc_endpoint_t const * ep_desc) {
   TU_ASSERT(hwfifo_config(musb, epn, is_rx, mps, false));
   musb->intren_ep[is_rx] |= TU_BIT(epn);
 
+#if CFG_TUD_MUSB_DMA
+  /* Assign a DMA channel to bulk endpoint if there is any left */
+  uint8_t *dma_ch = &_dcd.dma_ch[dir_in][epn - 1];
+  if (ep_desc->bmAttributes.xfer != TUSB_XFER_BULK) {
+    *dma_ch = 0;
+  } else if (!*dma_ch && _dcd.dma_count < musb_dma_channel_count(musb)) {
+    _dcd.dma_ep[_dcd.dma_count] = (uint8_t)ep_addr;
+    *dma_ch = ++_dcd.dma_count;
+  }
+#endif
+
   return true;
 }
 
@@ -768,6 +909,10 @@ void dcd_edpt_close_all(uint8_t rhport)
   alloced_fifo_bytes = CFG_TUD_ENDPOINT0_SIZE;
 #endif
 
+#if CFG_TUD_MUSB_DMA
+  dma_reset(musb);
+#endif
+
   if (ie) musb_dcd_int_enable(rhport);
 }
 
@@ -862,13 +1007,16 @@ void dcd_int_handler(uint8_t rhport) {
   uint_fast8_t intr_usb = musb_regs->intr_usb; // a read will clear this interrupt status
   uint_fast8_t intr_tx = musb_regs->intr_tx; // a read will clear this interrupt status
   uint_fast8_t intr_rx = musb_regs->intr_rx; // a read will clear this interrupt status
+#if CFG_TUD_MUSB_DMA
+  uint_fast8_t intr_dma = musb_regs->dma_intr; // a read will clear this interrupt status
+#endif
   // TU_LOG1("D%2x T%2x R%2x\r\n", is, txis, rxis);
 
   intr_usb &= musb_regs->intr_usben; /* Clear disabled interrupts */
   if (intr_usb & MUSB_IS_DISCON) {
   }
   if (intr_usb & MUSB_IS_SOF) {
-    dcd_event_bus_signal(rhport, DCD_EVENT_SOF, true);
+    dcd_event_sof(rhport, musb_regs->frame, true);
   }
   if (intr_usb & MUSB_IS_RESET) {
     process_bus_reset(rhport);
@@ -880,6 +1028,15 @@ void dcd_int_handler(uint8_t rhport) {
     dcd_event_bus_signal(rhport, DCD_EVENT_SUSPEND, true);
   }
 
+#if CFG_TUD_MUSB_DMA
+  /* DMA completion is handled first: endpoint interrupts of the same transfer follow it */
+  while (intr_dma) {
+    unsigned const ch = __builtin_ctz(intr_dma);
+    if (ch < _dcd.dma_count) process_dma(rhport, ch);
+    intr_dma &= ~TU_BIT(ch);
+  }
+#endif
+
   intr_tx &= musb_regs->intr_txen; /* Clear disabled interrupts */
   if (intr_tx & TU_BIT(0)) {
     process_ep0(rhport);
@@ -749,6 +749,31 @@ TU_ATTR_ALWAYS_INLINE static inline musb_ep_csr_t* get_ep_csr(musb_regs_t* musb_
 #define MUSB_HSBT_HSBT_M         0x000F  // High Speed Timeout Adder
 #define MUSB_HSBT_HSBT_S         0
 
+//--------------------------------------------------------------------+
+// DMA Helper
+//--------------------------------------------------------------------+
+// Number of channels of the multichannel DMA controller, 0 if not included
+TU_ATTR_ALWAYS_INLINE static inline unsigned musb_dma_channel_count(musb_regs_t* musb_regs) {
+  unsigned const count = musb_regs->raminfo_bit.dma_channel;
+  return count < 8u ? count : 8u;
+}
+
+// Start a DMA mode 1 transfer between memory and endpoint FIFO, interrupt when count is reached.
+// addr must be word-aligned
+TU_ATTR_ALWAYS_INLINE static inline void musb_dma_start(musb_regs_t* musb_regs, unsigned ch, unsigned epnum, unsigned is_tx,
+                                                        void const* addr, uint32_t count) {
+  musb_regs->dma[ch].addr  = (uint32_t) (uintptr_t) addr;
+  musb_regs->dma[ch].count = count;
+  musb_regs->dma[ch].cntl  = (uint16_t) (MUSB_DMACTL0_ENABLE | (is_tx ? MUSB_DMACTL0_DIR : 0) | MUSB_DMACTL0_MODE |
+                                         MUSB_DMACTL0_IE | (epnum << MUSB_DMACTL0_EP_S) | MUSB_DMACTL0_BRSTM_INC16);
+}
+
+// Stop DMA channel, return number of bytes transferred since started at addr
+TU_ATTR_ALWAYS_INLINE static inline uint32_t musb_dma_stop(musb_regs_t* musb_regs, unsigned ch, void const* addr) {
+  musb_regs->dma[ch].cntl = 0;
+  return musb_regs->dma[ch].addr - (uint32_t) (uintptr_t) addr;
+}
+
 #ifdef __cplusplus
  }
 #endif
@@ -50,7 +50,6 @@
 
 // TODO remove later
 #include "device/usbd.h"
-#include "device/usbd_pvt.h" // to use defer function helper
 
 #if CFG_TUSB_OS == OPT_OS_MYNEWT
 #include "mcu/mcu.h"
@@ -83,10 +82,15 @@
 enum {
   // Max allowed by USB specs
   MAX_PACKET_SIZE = 64,
+};
 
-  // Mask of all END event (IN & OUT) for all endpoints. ENDEPIN0-7, ENDEPOUT0-7, ENDISOIN, ENDISOOUT
-  EDPT_END_ALL_MASK = (0xff << USBD_INTEN_ENDEPIN0_Pos) | (0xff << USBD_INTEN_ENDEPOUT0_Pos) |
-                      USBD_INTENCLR_ENDISOIN_Msk | USBD_INTEN_ENDISOOUT_Msk
+// DMA request bit position: IN/OUT endpoint 0-7 and ISO (8), control tasks that also require EasyDMA
+enum {
+  DMA_REQ_IN_POS    = 0,
+  DMA_REQ_OUT_POS   = 16,
+  DMA_REQ_EP0STATUS = 30,
+  DMA_REQ_EP0RCVOUT = 31,
+  DMA_REQ_CONTROL_MASK = TU_BIT(DMA_REQ_IN_POS) | TU_BIT(DMA_REQ_OUT_POS) | TU_BIT(DMA_REQ_EP0STATUS) | TU_BIT(DMA_REQ_EP0RCVOUT)
 };
 
 enum {
@@ -121,6 +125,11 @@ static struct {
   // nRF can only carry one DMA at a time, this is used to guard the access to EasyDMA
   atomic_flag dma_running;
 
+  // Requests (bit DMA_REQ_*) waiting for EasyDMA, issued round-robin from ENDED event
+  volatile uint32_t dma_pending;
+  uint8_t dma_last_req;
+  uint32_t dma_end_mask; // END event of running DMA
+
   // Track whether sof has been manually enabled
   bool sof_enabled;
 } _dcd;
@@ -148,60 +157,65 @@ static void start_dma(volatile uint32_t* reg_startep) {
   }
 }
 
-static void edpt_dma_start(volatile uint32_t* reg_startep) {
-  if (atomic_flag_test_and_set(&_dcd.dma_running)) {
-    usbd_defer_func((osal_task_func_t)(uintptr_t ) edpt_dma_start, (void*) (uintptr_t) reg_startep, is_in_isr());
-  } else {
-    start_dma(reg_startep);
-  }
-}
+static void dma_issue_pending(void);
 
-// DMA is complete
+// DMA is complete, queued requests are issued at the end of dcd_int_handler() after transfers are updated
 static void edpt_dma_end(void) {
+  _dcd.dma_end_mask = 0;
   atomic_flag_clear(&_dcd.dma_running);
 }
 
+// Queue a DMA request. From task it is started right away if EasyDMA is free, from ISR it is issued at the end of
+// dcd_int_handler()
+static void dma_request(uint8_t req) {
+  if (is_in_isr()) {
+    _dcd.dma_pending |= TU_BIT(req);
+  } else {
+    bool const int_enabled = NVIC_GetEnableIRQ(USBD_IRQn) != 0;
+    NVIC_DisableIRQ(USBD_IRQn);
+
+    _dcd.dma_pending |= TU_BIT(req);
+    dma_issue_pending();
+
+    if (int_enabled) {
+      NVIC_EnableIRQ(USBD_IRQn);
+    }
+  }
+}
+
 // helper getting td
 static inline xfer_td_t* get_td(uint8_t epnum, uint8_t dir) {
   return &_dcd.xfer[epnum][dir];
 }
 
-static void xact_out_dma(uint8_t epnum);
-
-// Function wraps xact_out_dma which wants uint8_t while usbd_defer_func wants void (*)(void *)
-static void xact_out_dma_wrapper(void* epnum) {
-  xact_out_dma((uint8_t) ((uintptr_t) epnum));
-}
-
-// Start DMA to move data from Endpoint -> RAM
-static void xact_out_dma(uint8_t epnum) {
+// Start DMA to move data from Endpoint -> RAM. EasyDMA must be acquired since it can't be active during read of
+// SIZE.EPOUT or SIZE.ISOOUT. Return false if no DMA is started (EasyDMA is released)
+static bool xact_out_dma(uint8_t epnum) {
   xfer_td_t* xfer = get_td(epnum, TUSB_DIR_OUT);
   uint32_t xact_len;
 
-  // DMA can't be active during read of SIZE.EPOUT or SIZE.ISOOUT, so try to lock,
-  // If already running defer call regardless if it was called from ISR or task,
-  if (atomic_flag_test_and_set(&_dcd.dma_running)) {
-    usbd_defer_func((osal_task_func_t) xact_out_dma_wrapper, (void*) (uint32_t) epnum, is_in_isr());
-    return;
-  }
   if (epnum == EP_ISO_NUM) {
     xact_len = NRF_USBD->SIZE.ISOOUT;
     // If ZERO bit is set, ignore ISOOUT length
-    if (xact_len & USBD_SIZE_ISOOUT_ZERO_Msk) {
-      xact_len = 0;
+    if ((xact_len & USBD_SIZE_ISOOUT_ZERO_Msk) || !xfer->started) {
       atomic_flag_clear(&_dcd.dma_running);
-    } else {
-      if (xfer->started) {
-        // Trigger DMA move data from Endpoint -> SRAM
-        NRF_USBD->ISOOUT.PTR = (uint32_t) xfer->buffer;
-        NRF_USBD->ISOOUT.MAXCNT = xact_len;
-
-        start_dma(&NRF_USBD->TASKS_STARTISOOUT);
-      } else {
-        atomic_flag_clear(&_dcd.dma_running);
-      }
+      return false;
     }
+
+    // Trigger DMA move data from Endpoint -> SRAM
+    NRF_USBD->ISOOUT.PTR = (uint32_t) xfer->buffer;
+    NRF_USBD->ISOOUT.MAXCNT = xact_len;
+
+    _dcd.dma_end_mask = USBD_INTEN_ENDISOOUT_Msk;
+    start_dma(&NRF_USBD->TASKS_STARTISOOUT);
   } else {
+    if (!xfer->started || xfer->actual_len >= xfer->total_len) {
+      // transfer is complete while request was queued, packet is kept for next transfer
+      xfer->data_received = true;
+      atomic_flag_clear(&_dcd.dma_running);
+      return false;
+    }
+
     // limit xact len to remaining length
     xact_len = tu_min16((uint16_t) NRF_USBD->SIZE.EPOUT[epnum], xfer->total_len - xfer->actual_len);
 
@@ -209,12 +223,14 @@ static void xact_out_dma(uint8_t epnum) {
     NRF_USBD->EPOUT[epnum].PTR = (uint32_t) xfer->buffer;
     NRF_USBD->EPOUT[epnum].MAXCNT = xact_len;
 
+    _dcd.dma_end_mask = TU_BIT(USBD_INTEN_ENDEPOUT0_Pos + epnum);
     start_dma(&NRF_USBD->TASKS_STARTEPOUT[epnum]);
   }
+
+  return true;
 }
 
-// Prepare for a CBI transaction IN, call at the start
-// it start DMA to transfer data from RAM -> Endpoint
+// Start DMA of a CBI transaction IN to transfer data from RAM -> Endpoint. EasyDMA must be acquired
 static void xact_in_dma(uint8_t epnum) {
   xfer_td_t* xfer = get_td(epnum, TUSB_DIR_IN);
 
@@ -224,7 +240,40 @@ static void xact_in_dma(uint8_t epnum) {
   NRF_USBD->EPIN[epnum].PTR = (uint32_t) xfer->buffer;
   NRF_USBD->EPIN[epnum].MAXCNT = xact_len;
 
-  edpt_dma_start(&NRF_USBD->TASKS_STARTEPIN[epnum]);
+  // EPIN[8] and STARTEPIN[8] are ISOIN registers
+  _dcd.dma_end_mask = (epnum == EP_ISO_NUM) ? USBD_INTEN_ENDISOIN_Msk : TU_BIT(USBD_INTEN_ENDEPIN0_Pos + epnum);
+  start_dma(&NRF_USBD->TASKS_STARTEPIN[epnum]);
+}
+
+// Issue queued requests round-robin until one of them occupies EasyDMA. Control tasks release EasyDMA right away,
+// so next request is started back-to-back
+static void dma_issue_pending(void) {
+  while (_dcd.dma_pending) {
+    if (atomic_flag_test_and_set(&_dcd.dma_running)) {
+      return; // issued when current DMA is ended
+    }
+
+    uint8_t req = _dcd.dma_last_req;
+    do {
+      req = (uint8_t) ((req + 1) & 31);
+    } while (!tu_bit_test(_dcd.dma_pending, req));
+
+    _dcd.dma_pending &= ~TU_BIT(req);
+    _dcd.dma_last_req = req;
+
+    if (req == DMA_REQ_EP0STATUS) {
+      start_dma(&NRF_USBD->TASKS_EP0STATUS);
+    } else if (req == DMA_REQ_EP0RCVOUT) {
+      start_dma(&NRF_USBD->TASKS_EP0RCVOUT);
+    } else if (req >= DMA_REQ_OUT_POS) {
+      if (xact_out_dma((uint8_t) (req - DMA_REQ_OUT_POS))) {
+        return;
+      }
+    } else {
+      xact_in_dma(req);
+      return;
+    }
+  }
 }
 
 //--------------------------------------------------------------------+
@@ -382,6 +431,9 @@ void dcd_edpt_close_all(uint8_t rhport) {
 
   tu_memclr(_dcd.xfer[EP_ISO_NUM], 2 * sizeof(xfer_td_t));
 
+  // drop DMA requests of closed endpoints
+  _dcd.dma_pending &= DMA_REQ_CONTROL_MASK;
+
   // de-activate all non-control
   NRF_USBD->EPOUTEN = 1UL;
   NRF_USBD->EPINEN = 1UL;
@@ -447,12 +499,12 @@ bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint16_t to
     dcd_event_xfer_complete(0, ep_addr, 0, XFER_RESULT_SUCCESS, is_in_isr());
 
     // Status Phase also requires EasyDMA has to be available as well !!!!
-    edpt_dma_start(&NRF_USBD->TASKS_EP0STATUS);
+    dma_request(DMA_REQ_EP0STATUS);
   } else if (dir == TUSB_DIR_OUT) {
     xfer->started = true;
     if (epnum == 0) {
       // Accept next Control Out packet. TASKS_EP0RCVOUT also require EasyDMA
-      edpt_dma_start(&NRF_USBD->TASKS_EP0RCVOUT);
+      dma_request(DMA_REQ_EP0RCVOUT);
     } else {
       // started just set, it could start DMA transfer if interrupt was trigger after this line
       // code only needs to start transfer (from Endpoint to RAM) when data_received was set
@@ -465,7 +517,7 @@ bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint16_t to
         // Data is already received previously
         // start DMA to copy to SRAM
         xfer->data_received = false;
-        xact_out_dma(epnum);
+        dma_request(DMA_REQ_OUT_POS + epnum);
       } else {
         // nRF auto accept next Bulk/Interrupt OUT packet
         // nothing to do
@@ -473,7 +525,7 @@ bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint16_t to
     }
   } else {
     // Start DMA to copy data from RAM -> Endpoint
-    xact_in_dma(epnum);
+    dma_request(DMA_REQ_IN_POS + epnum);
   }
 
   return true;
@@ -601,7 +653,7 @@ void dcd_int_handler(uint8_t rhport) {
       // Transfer from endpoint to RAM only if data is not corrupted
       if ((int_status & USBD_INTEN_USBEVENT_Msk) == 0 ||
           (NRF_USBD->EVENTCAUSE & USBD_EVENTCAUSE_ISOOUTCRC_Msk) == 0) {
-        xact_out_dma(EP_ISO_NUM);
+        dma_request(DMA_REQ_OUT_POS + EP_ISO_NUM);
       }
     }
 
@@ -680,8 +732,9 @@ void dcd_int_handler(uint8_t rhport) {
     }
   }
 
-  if (int_status & EDPT_END_ALL_MASK) {
-    // DMA complete move data from SRAM <-> Endpoint
+  if (int_status & _dcd.dma_end_mask) {
+    // DMA complete move data from SRAM <-> Endpoint. END event of control tasks (EP0STATUS, EP0RCVOUT) is ignored
+    // since EasyDMA is released when they are started.
     // Must before endpoint transfer handling
     edpt_dma_end();
   }
@@ -734,7 +787,7 @@ void dcd_int_handler(uint8_t rhport) {
       if ((epnum != EP_ISO_NUM) && (xact_len == xfer->mps) && (xfer->actual_len < xfer->total_len)) {
         if (epnum == 0) {
           // Accept next Control Out packet. TASKS_EP0RCVOUT also require EasyDMA
-          edpt_dma_start(&NRF_USBD->TASKS_EP0RCVOUT);
+          dma_request(DMA_REQ_EP0RCVOUT);
         } else {
           // nRF auto accept next Bulk/Interrupt OUT packet
           // nothing to do
@@ -776,7 +829,7 @@ void dcd_int_handler(uint8_t rhport) {
 
         if (xfer->actual_len < xfer->total_len) {
           // Start DMA to copy next data packet
-          xact_in_dma(epnum);
+          dma_request(DMA_REQ_IN_POS + epnum);
         } else {
           // CBI IN complete
           dcd_event_xfer_complete(0, epnum | TUSB_DIR_IN_MASK, xfer->actual_len, XFER_RESULT_SUCCESS, true);
@@ -790,7 +843,7 @@ void dcd_int_handler(uint8_t rhport) {
         xfer_td_t* xfer = get_td(epnum, TUSB_DIR_OUT);
 
         if (xfer->started && xfer->actual_len < xfer->total_len) {
-          xact_out_dma(epnum);
+          dma_request(DMA_REQ_OUT_POS + epnum);
         } else {
           // Data overflow !!! Nah, nRF will auto accept next Bulk/Interrupt OUT packet
           // Mark this endpoint with data received
@@ -799,6 +852,9 @@ void dcd_int_handler(uint8_t rhport) {
       }
     }
   }
+
+  // Issue DMA requests back-to-back
+  dma_issue_pending();
 }
 
 //--------------------------------------------------------------------+
@@ -108,6 +108,7 @@ typedef struct
   };
   uint8_t setup_packet[8];
   uint8_t addr;
+  bool    sof_en;
 }dcd_data_t;
 
 //--------------------------------------------------------------------+
@@ -190,6 +191,13 @@ static void process_tokdne(uint8_t rhport)
     }
     return;
   }
+  /* Transfer ended (short packet) while the other buffer is still primed for the packet after: take it back, next
+   * transfer starts on it with the data toggle it already holds */
+  buffer_descriptor_t *other = &_dcd.bdt[epnum][dir][odd ^ 1];
+  if (other->own) {
+    other->own = 0;
+  }
+
   const unsigned length = ep->length;
   dcd_event_xfer_complete(rhport,
                           tu_edpt_addr(epnum, dir),
@@ -213,7 +221,8 @@ static void process_bus_reset(uint8_t rhport)
   KHCI->CTL     |= USB_CTL_ODDRST_MASK;
   KHCI->ADDR     = 0;
   KHCI->INTEN    = USB_INTEN_USBRSTEN_MASK | USB_INTEN_TOKDNEEN_MASK | USB_INTEN_SLEEPEN_MASK |
-                   USB_INTEN_ERROREN_MASK  | USB_INTEN_STALLEN_MASK;
+                   USB_INTEN_ERROREN_MASK  | USB_INTEN_STALLEN_MASK |
+                   (_dcd.sof_en ? USB_INTEN_SOFTOKEN_MASK : 0);
 
   KHCI->ENDPOINT[0].ENDPT = USB_ENDPT_EPHSHK_MASK | USB_ENDPT_EPRXEN_MASK | USB_ENDPT_EPTXEN_MASK;
   for (unsigned i = 1; i < 16; ++i) {
@@ -347,9 +356,14 @@ void dcd_disconnect(uint8_t rhport)
 void dcd_sof_enable(uint8_t rhport, bool en)
 {
   (void) rhport;
-  (void) en;
 
-  // TODO implement later
+  _dcd.sof_en = en;
+  if (en) {
+    KHCI->ISTAT  = USB_ISTAT_SOFTOK_MASK;
+    KHCI->INTEN |= USB_INTEN_SOFTOKEN_MASK;
+  } else {
+    KHCI->INTEN &= ~USB_INTEN_SOFTOKEN_MASK;
+  }
 }
 
 //--------------------------------------------------------------------+
@@ -573,8 +587,11 @@ void dcd_int_handler(uint8_t rhport)
     process_stall(rhport);
   }
 
+  // drain completed tokens in one go: STAT FIFO holds up to 4 of them when buffers are ping-ponged back-to-back
   if (is & USB_ISTAT_TOKDNE_MASK) {
-    process_tokdne(rhport);
+    do {
+      process_tokdne(rhport);
+    } while (KHCI->ISTAT & USB_ISTAT_TOKDNE_MASK);
   }
 }
 
@@ -86,10 +86,17 @@ typedef struct {
 enum {
   NBYTES_ISO_FS_MAX = 1023, // FS ISO
   NBYTES_ISO_HS_MAX = 1024, // HS ISO
-  NBYTES_CBI_FS_MAX = 64,   // FS control/bulk/interrupt. TODO some FS can do burst with higher size e.g 1024. Need to test
+  NBYTES_CBI_FS_MAX = 64,   // FS control/bulk/interrupt
+  NBYTES_BULK_FS_BURST = 960, // FS bulk with CFG_TUD_IP3511_FS_BURST: 15 packets, fit in 10-bit nbytes
   NBYTES_CBI_HS_MAX = 32767 // can be up to all 15-bit, but only tested with 4096
 };
 
+// Buffer offset is in unit of 64 bytes: double buffered chunks must be multiple of 64
+enum {
+  NBYTES_DBUF_FS_MAX = (CFG_TUD_IP3511_FS_BURST ? NBYTES_BULK_FS_BURST : NBYTES_CBI_FS_MAX),
+  NBYTES_DBUF_HS_MAX = NBYTES_CBI_HS_MAX & ~0x3F
+};
+
 enum {
   INT_SOF_MASK           = TU_BIT(30),
   INT_DEVICE_STATUS_MASK = TU_BIT(31)
@@ -168,8 +175,12 @@ typedef struct
 
   uint16_t nbytes;
 
-  // prevent unaligned access on Highspeed port on USB_SRAM
-  uint16_t TU_RESERVED;
+  // double buffer
+  uint16_t buf_offset;     // buffer offset of transfer start
+  uint16_t queued_bytes;   // bytes programmed to buffers so far
+  uint16_t dbuf_nbytes[2]; // nbytes programmed to each buffer
+  uint8_t  dbuf_armed;     // bitmap of buffers programmed and not yet completed
+  uint8_t  dbuf_next;      // buffer to complete next, hardware alternates between them
 }xfer_dma_t;
 
 // Absolute max of endpoints pairs for all port
@@ -181,7 +192,7 @@ typedef struct
 // current_td is used to keep track of number of remaining & xferred bytes of the current request.
 typedef struct
 {
-  // 256 byte aligned, 2 for double buffer (not used)
+  // 256 byte aligned, 2 for double buffer (bulk IN with CFG_TUD_IP3511_DBUF)
   // Each cmd_sts can only transfer up to DMA_NBYTES_MAX bytes each
   ep_cmd_sts_t ep[2*MAX_EP_PAIRS][2];
   xfer_dma_t dma[2*MAX_EP_PAIRS];
@@ -199,6 +210,11 @@ CFG_TUD_MEM_SECTION TU_ATTR_ALIGNED(256) static dcd_data_t _dcd;
 // TODO find way to save memory
 CFG_TUD_MEM_SECTION TU_ATTR_ALIGNED(64) static uint8_t dummy[8];
 
+#if CFG_TUD_IP3511_FS_BURST
+// FS bulk endpoints with 64-byte max packet size, nbytes can span multiple packets
+static uint32_t _fs_burst_mask;
+#endif
+
 //--------------------------------------------------------------------+
 // Multiple Controllers
 //--------------------------------------------------------------------+
@@ -262,6 +278,10 @@ TU_ATTR_ALWAYS_INLINE static inline bool rhport_is_highspeed(uint8_t rhport) {
   return _dcd_controller[rhport].is_highspeed;
 }
 
+TU_ATTR_ALWAYS_INLINE static inline bool ep_is_dbuf(uint8_t rhport, uint8_t ep_id) {
+  return CFG_TUD_IP3511_DBUF && tu_bit_test(_dcd_controller[rhport].regs->EPBUFCFG, ep_id);
+}
+
 //--------------------------------------------------------------------+
 // CONTROLLER API
 //--------------------------------------------------------------------+
@@ -358,19 +378,24 @@ void dcd_sof_enable(uint8_t rhport, bool en)
 //--------------------------------------------------------------------+
 void dcd_edpt_stall(uint8_t rhport, uint8_t ep_addr)
 {
-  (void) rhport;
-
   // TODO cannot able to STALL Control OUT endpoint !!!!! FIXME try some walk-around
   uint8_t const ep_id = ep_addr2id(ep_addr);
   _dcd.ep[ep_id][0].cmd_sts.stall = 1;
+  if (ep_is_dbuf(rhport, ep_id)) {
+    _dcd.ep[ep_id][1].cmd_sts.stall = 1;
+  }
 }
 
 void dcd_edpt_clear_stall(uint8_t rhport, uint8_t ep_addr)
 {
-  (void) rhport;
-
   uint8_t const ep_id = ep_addr2id(ep_addr);
 
+  if (ep_is_dbuf(rhport, ep_id)) {
+    // restart from buffer 0, which carries the toggle reset
+    _dcd.ep[ep_id][1].cmd_sts.stall = 0;
+    _dcd_controller[rhport].regs->EPINUSE &= ~TU_BIT(ep_id);
+  }
+
   _dcd.ep[ep_id][0].cmd_sts.stall        = 0;
   _dcd.ep[ep_id][0].cmd_sts.toggle_reset = 1;
   _dcd.ep[ep_id][0].cmd_sts.rf_tv        = 0;
@@ -407,8 +432,26 @@ bool dcd_edpt_open(uint8_t rhport, tusb_desc_endpoint_t const * p_endpoint_desc)
     default: break;
   }
 
-  // Enable EP interrupt
   dcd_registers_t* dcd_reg = _dcd_controller[rhport].regs;
+  bool const is_bulk = (p_endpoint_desc->bmAttributes.xfer == TUSB_XFER_BULK);
+
+#if CFG_TUD_IP3511_FS_BURST
+  if (is_bulk && tu_edpt_packet_size(p_endpoint_desc) == 64) {
+    _fs_burst_mask |= TU_BIT(ep_id);
+  } else {
+    _fs_burst_mask &= ~TU_BIT(ep_id);
+  }
+#endif
+
+  // Double buffer only for bulk IN: OUT transfer can end early with short packet while the second buffer is armed
+  if (CFG_TUD_IP3511_DBUF && is_bulk && (ep_id & 0x01)) {
+    dcd_reg->EPINUSE  &= ~TU_BIT(ep_id);
+    dcd_reg->EPBUFCFG |= TU_BIT(ep_id);
+  } else {
+    dcd_reg->EPBUFCFG &= ~TU_BIT(ep_id);
+  }
+
+  // Enable EP interrupt
   dcd_reg->INTEN |= TU_BIT(ep_id);
 
   return true;
@@ -455,7 +498,13 @@ static void prepare_ep_xfer(uint8_t rhport, uint8_t ep_id, uint16_t buf_offset,
     ep_cs[0].buffer_hs.offset = buf_offset;
     ep_cs[0].buffer_hs.nbytes = nbytes;
   }else {
-    nbytes = tu_min16(total_bytes, is_iso ? NBYTES_ISO_FS_MAX : NBYTES_CBI_FS_MAX);
+    uint16_t nbytes_max = is_iso ? NBYTES_ISO_FS_MAX : NBYTES_CBI_FS_MAX;
+    #if CFG_TUD_IP3511_FS_BURST
+    if (tu_bit_test(_fs_burst_mask, ep_id)) {
+      nbytes_max = NBYTES_BULK_FS_BURST;
+    }
+    #endif
+    nbytes = tu_min16(total_bytes, nbytes_max);
     ep_cs[0].buffer_fs.offset = buf_offset;
     ep_cs[0].buffer_fs.nbytes = nbytes;
   }
@@ -464,6 +513,62 @@ static void prepare_ep_xfer(uint8_t rhport, uint8_t ep_id, uint16_t buf_offset,
   ep_cs[0].cmd_sts.active = 1;
 }
 
+#if CFG_TUD_IP3511_DBUF
+// Program next chunk of transfer to a buffer of double-buffered endpoint
+static void dbuf_prepare(uint8_t rhport, uint8_t ep_id, uint8_t buf_idx) {
+  xfer_dma_t* xfer_dma = &_dcd.dma[ep_id];
+  ep_cmd_sts_t* ep_cs = &_dcd.ep[ep_id][buf_idx];
+
+  uint16_t const chunk_max = rhport_is_highspeed(rhport) ? NBYTES_DBUF_HS_MAX : NBYTES_DBUF_FS_MAX;
+  uint16_t const nbytes = tu_min16(xfer_dma->total_bytes - xfer_dma->queued_bytes, chunk_max);
+  uint16_t const buf_offset = xfer_dma->buf_offset + (xfer_dma->queued_bytes >> 6);
+
+  if (rhport_is_highspeed(rhport)) {
+    ep_cs->buffer_hs.offset = buf_offset;
+    ep_cs->buffer_hs.nbytes = nbytes;
+  } else {
+    ep_cs->buffer_fs.offset = buf_offset;
+    ep_cs->buffer_fs.nbytes = nbytes;
+  }
+
+  xfer_dma->queued_bytes += nbytes;
+  xfer_dma->dbuf_nbytes[buf_idx] = nbytes;
+  xfer_dma->dbuf_armed |= TU_BIT(buf_idx);
+  ep_cs->cmd_sts.active = 1;
+}
+
+static void dbuf_xfer(uint8_t rhport, uint8_t ep_id) {
+  xfer_dma_t* xfer_dma = &_dcd.dma[ep_id];
+  uint8_t const buf_idx = tu_bit_test(_dcd_controller[rhport].regs->EPINUSE, ep_id) ? 1 : 0;
+
+  xfer_dma->dbuf_next = buf_idx;
+  dbuf_prepare(rhport, ep_id, buf_idx);
+  if (xfer_dma->queued_bytes < xfer_dma->total_bytes) {
+    dbuf_prepare(rhport, ep_id, buf_idx ^ 1);
+  }
+}
+
+// Account completed buffers in order and refill them. Return true if transfer is complete
+static bool dbuf_process(uint8_t rhport, uint8_t ep_id) {
+  xfer_dma_t* xfer_dma = &_dcd.dma[ep_id];
+
+  while (tu_bit_test(xfer_dma->dbuf_armed, xfer_dma->dbuf_next) && !_dcd.ep[ep_id][xfer_dma->dbuf_next].cmd_sts.active) {
+    uint8_t const buf_idx = xfer_dma->dbuf_next;
+
+    // IN buffer is only deactivated when all of its bytes are sent (nbytes is not reliable after IN on some parts)
+    xfer_dma->xferred_bytes += xfer_dma->dbuf_nbytes[buf_idx];
+    xfer_dma->dbuf_armed &= (uint8_t) ~TU_BIT(buf_idx);
+    xfer_dma->dbuf_next = buf_idx ^ 1;
+
+    if (xfer_dma->queued_bytes < xfer_dma->total_bytes) {
+      dbuf_prepare(rhport, ep_id, buf_idx);
+    }
+  }
+
+  return xfer_dma->dbuf_armed == 0;
+}
+#endif
+
 bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint16_t total_bytes) {
   uint8_t const ep_id = ep_addr2id(ep_addr);
 
@@ -476,6 +581,14 @@ bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint16_t to
   tu_memclr(&_dcd.dma[ep_id], sizeof(xfer_dma_t));
   _dcd.dma[ep_id].total_bytes = total_bytes;
 
+#if CFG_TUD_IP3511_DBUF
+  if (ep_is_dbuf(rhport, ep_id)) {
+    _dcd.dma[ep_id].buf_offset = get_buf_offset(buffer);
+    dbuf_xfer(rhport, ep_id);
+    return true;
+  }
+#endif
+
   prepare_ep_xfer(rhport, ep_id, get_buf_offset(buffer), total_bytes);
 
   return true;
@@ -519,6 +632,16 @@ static void process_xfer_isr(uint8_t rhport, uint32_t int_status) {
         ep_cs->cmd_sts.active = 0;
       }
 
+      #if CFG_TUD_IP3511_DBUF
+      if (ep_is_dbuf(rhport, ep_id)) {
+        if (dbuf_process(rhport, ep_id)) {
+          dcd_event_xfer_complete(rhport, tu_edpt_addr(ep_id / 2, TUSB_DIR_IN), xfer_dma->xferred_bytes,
+                                  XFER_RESULT_SUCCESS, true);
+        }
+        continue;
+      }
+      #endif
+
       uint16_t buf_offset;
       uint16_t buf_nbytes;
 
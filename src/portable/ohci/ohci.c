@@ -152,13 +152,23 @@ static ohci_ed_t * const p_ed_head[] =
     [TUSB_XFER_CONTROL]     = &ohci_data.control[0].ed,
     [TUSB_XFER_BULK   ]     = &ohci_data.bulk_head_ed,
     [TUSB_XFER_INTERRUPT]   = &ohci_data.period_head_ed,
-    [TUSB_XFER_ISOCHRONOUS] = NULL // TODO Isochronous
+    [TUSB_XFER_ISOCHRONOUS] = &ohci_data.period_head_ed // isochronous EDs are at tail of periodic list
 };
 
 static void ed_list_insert(ohci_ed_t * p_pre, ohci_ed_t * p_ed);
 static void ed_list_remove_by_addr(ohci_ed_t * p_head, uint8_t dev_addr);
 static gtd_extra_data_t *gtd_get_extra_data(ohci_gtd_t const * const gtd);
 
+#if CFG_TUH_ISO_EDPT_MAX
+static ohci_iso_ep_t* iso_ep_find(uint8_t dev_addr, uint8_t ep_addr);
+static bool iso_edpt_open(ohci_ed_t* ed, uint8_t dev_addr, tusb_desc_endpoint_t const* ep_desc);
+static void iso_edpt_stop(ohci_iso_ep_t* iso);
+static void iso_schedule(ohci_iso_ep_t* iso);
+static void iso_complete(ohci_iso_ep_t* iso, bool in_isr);
+static bool itd_is_iso(ohci_td_item_t const* td);
+static void itd_retire(ohci_itd_t const* itd);
+#endif
+
 //--------------------------------------------------------------------+
 // USBH-HCD API
 //--------------------------------------------------------------------+
@@ -231,7 +241,8 @@ bool hcd_init(uint8_t rhport, const tusb_rhport_init_t* rh_init) {
       OHCI_INT_MASTER_ENABLE_MASK;
 
   OHCI_REG->control = OHCI_CONTROL_CONTROL_BULK_RATIO | OHCI_CONTROL_LIST_CONTROL_ENABLE_MASK |
-       OHCI_CONTROL_LIST_BULK_ENABLE_MASK | OHCI_CONTROL_LIST_PERIODIC_ENABLE_MASK; // TODO Isochronous
+       OHCI_CONTROL_LIST_BULK_ENABLE_MASK | OHCI_CONTROL_LIST_PERIODIC_ENABLE_MASK |
+       (CFG_TUH_ISO_EDPT_MAX ? OHCI_CONTROL_LIST_ISOCHRONOUS_ENABLE_MASK : 0);
 
   OHCI_REG->frame_interval = (OHCI_FMINTERVAL_FSMPS << 16) | OHCI_FMINTERVAL_FI;
   OHCI_REG->frame_interval ^= (1 << 31); //Must toggle when frame_interval is updated.
@@ -297,10 +308,18 @@ void hcd_device_close(uint8_t rhport, uint8_t dev_addr)
     // remove bulk
     ed_list_remove_by_addr(p_ed_head[TUSB_XFER_BULK], dev_addr);
 
-    // remove interrupt
-    ed_list_remove_by_addr(p_ed_head[TUSB_XFER_INTERRUPT], dev_addr);
+#if CFG_TUH_ISO_EDPT_MAX
+    for (uint8_t i = 0; i < CFG_TUH_ISO_EDPT_MAX; i++) {
+      ohci_iso_ep_t* iso = &ohci_data.iso_ep[i];
+      if (iso->dev_addr == dev_addr) {
+        iso_edpt_stop(iso);
+        tu_memclr(iso, sizeof(ohci_iso_ep_t));
+      }
+    }
+#endif
 
-    // TODO remove ISO
+    // remove interrupt and isochronous
+    ed_list_remove_by_addr(p_ed_head[TUSB_XFER_INTERRUPT], dev_addr);
   }
 }
 
@@ -370,7 +389,7 @@ static ohci_ed_t * ed_from_addr(uint8_t dev_addr, uint8_t ep_addr)
 
   for(uint32_t i=0; i<ED_MAX; i++)
   {
-    if ( (ed_pool[i].dev_addr == dev_addr) &&
+    if ( ed_pool[i].used && (ed_pool[i].dev_addr == dev_addr) &&
           ep_addr == tu_edpt_addr(ed_pool[i].ep_number, ed_pool[i].pid == PID_IN) )
     {
       return &ed_pool[i];
@@ -398,6 +417,33 @@ static void ed_list_insert(ohci_ed_t * p_pre, ohci_ed_t * p_ed)
   p_pre->next = (uint32_t) _phys_addr(p_ed);
 }
 
+// Append ED to tail of list
+static void ed_list_append(ohci_ed_t * p_head, ohci_ed_t * p_ed)
+{
+  ohci_ed_t* p_prev = p_head;
+  while ( p_prev->next )
+  {
+    p_prev = (ohci_ed_t*) _virt_addr((void *)p_prev->next);
+  }
+  ed_list_insert(p_prev, p_ed);
+}
+
+// Free all general TDs queued to ED including its dummy tail TD
+static void ed_gtd_free_all(ohci_ed_t * p_ed)
+{
+  if ( p_ed->is_iso || tu_align16(p_ed->td_tail) == 0 ) return; // isochronous TDs or control TD are not pooled
+
+  ohci_gtd_t* const tail = (ohci_gtd_t*) _virt_addr((void*) tu_align16(p_ed->td_tail));
+  ohci_gtd_t* gtd = (ohci_gtd_t*) _virt_addr((void*) tu_align16(p_ed->td_head.address));
+
+  while ( gtd != tail )
+  {
+    gtd->used = 0;
+    gtd = (ohci_gtd_t*) _virt_addr((void*) gtd->next);
+  }
+  tail->used = 0;
+}
+
 static void ed_list_remove_by_addr(ohci_ed_t * p_head, uint8_t dev_addr)
 {
   ohci_ed_t* p_prev = p_head;
@@ -416,6 +462,7 @@ static void ed_list_remove_by_addr(ohci_ed_t * p_head, uint8_t dev_addr)
 
       // point the removed ED's next pointer to list head to make sure HC can always safely move away from this ED
       ed->next = (uint32_t) _phys_addr(p_head);
+      ed_gtd_free_all(ed);
       ed->used = 0;
       ed->skip = 0;
     }else
@@ -425,27 +472,39 @@ static void ed_list_remove_by_addr(ohci_ed_t * p_head, uint8_t dev_addr)
   }
 }
 
+// Allocate a TD from pool, TD is marked as used
 static ohci_gtd_t * gtd_find_free(void)
 {
-  for(uint8_t i=0; i < GTD_MAX; i++)
+  for(uint16_t i=0; i < GTD_MAX; i++)
   {
-    if ( !ohci_data.gtd_pool[i].used ) return &ohci_data.gtd_pool[i];
+    if ( !ohci_data.gtd_pool[i].used )
+    {
+      ohci_data.gtd_pool[i].used = 1;
+      return &ohci_data.gtd_pool[i];
+    }
   }
 
   return NULL;
 }
 
-static void td_insert_to_ed(ohci_ed_t* p_ed, ohci_gtd_t * p_gtd)
+static uint16_t gtd_free_count(void)
 {
-  // tail is always NULL
-  if ( tu_align16(p_ed->td_head.address) == 0 )
-  { // TD queue is empty --> head = TD
-    p_ed->td_head.address |= (uint32_t) _phys_addr(p_gtd);
-  }
-  else
-  { // TODO currently only support queue up to 2 TD each endpoint at a time
-    ((ohci_gtd_t*) tu_align16((uint32_t)_virt_addr((void *)p_ed->td_head.address)))->next = (uint32_t) _phys_addr(p_gtd);
+  uint16_t count = 0;
+  for(uint16_t i=0; i < GTD_MAX; i++)
+  {
+    if ( !ohci_data.gtd_pool[i].used ) count++;
   }
+
+  return count;
+}
+
+// Bytes of next TD of a transfer: TD buffer spans at most 2 pages, TD other than the last must be multiple of
+// max packet size so that short packet can only happen at its end
+static uint16_t gtd_chunk_size(uint8_t const * buffer, uint32_t remaining, uint16_t mps)
+{
+  uint32_t const span = 8192 - tu_offset4k((uint32_t) _phys_addr((void*) (uintptr_t) buffer));
+  if ( remaining <= span ) return (uint16_t) remaining;
+  return (uint16_t) (span - span % mps);
 }
 
 //--------------------------------------------------------------------+
@@ -456,8 +515,13 @@ bool hcd_edpt_open(uint8_t rhport, uint8_t dev_addr, tusb_desc_endpoint_t const
 {
   (void) rhport;
 
-  // TODO iso support
-  TU_ASSERT(ep_desc->bmAttributes.xfer != TUSB_XFER_ISOCHRONOUS);
+  uint8_t const xfer_type = ep_desc->bmAttributes.xfer;
+
+  // interrupt and isochronous EDs are all linked to 1ms period list, admission control only
+  if ( xfer_type == TUSB_XFER_INTERRUPT || xfer_type == TUSB_XFER_ISOCHRONOUS )
+  {
+    TU_VERIFY(hcd_bw_reserve(dev_addr, ep_desc, false, 1, 0, 1) >= 0);
+  }
 
   //------------- Prepare Queue Head -------------//
   ohci_ed_t * p_ed;
@@ -465,14 +529,27 @@ bool hcd_edpt_open(uint8_t rhport, uint8_t dev_addr, tusb_desc_endpoint_t const
   if ( ep_desc->bEndpointAddress == 0 )
   {
     p_ed = &ohci_data.control[dev_addr].ed;
+  }else if ( xfer_type == TUSB_XFER_ISOCHRONOUS )
+  {
+#if CFG_TUH_ISO_EDPT_MAX
+    // endpoint can be re-opened with different alternate setting, keep its ED in periodic list
+    p_ed = ed_from_addr(dev_addr, ep_desc->bEndpointAddress);
+    if ( p_ed )
+    {
+      p_ed->max_packet_size = tu_edpt_packet_size(ep_desc);
+      return iso_edpt_open(p_ed, dev_addr, ep_desc);
+    }
+    p_ed = ed_find_free();
+#else
+    return false; // CFG_TUH_ISO_EDPT_MAX is 0
+#endif
   }else
   {
     p_ed = ed_find_free();
   }
   TU_ASSERT(p_ed);
 
-  ed_init( p_ed, dev_addr, tu_edpt_packet_size(ep_desc), ep_desc->bEndpointAddress,
-            ep_desc->bmAttributes.xfer, ep_desc->bInterval );
+  ed_init( p_ed, dev_addr, tu_edpt_packet_size(ep_desc), ep_desc->bEndpointAddress, xfer_type, ep_desc->bInterval );
 
   // control of dev0 is used as static async head
   if ( dev_addr == 0 )
@@ -481,7 +558,35 @@ bool hcd_edpt_open(uint8_t rhport, uint8_t dev_addr, tusb_desc_endpoint_t const
     return true;
   }
 
-  ed_list_insert( p_ed_head[ep_desc->bmAttributes.xfer], p_ed );
+  if ( xfer_type == TUSB_XFER_ISOCHRONOUS )
+  {
+#if CFG_TUH_ISO_EDPT_MAX
+    if ( !iso_edpt_open(p_ed, dev_addr, ep_desc) )
+    {
+      p_ed->used = 0;
+      return false;
+    }
+
+    // OHCI 5.2.7.3 isochronous EDs are placed after all interrupt EDs
+    ed_list_append(p_ed_head[TUSB_XFER_ISOCHRONOUS], p_ed);
+#endif
+    return true;
+  }
+
+  if ( xfer_type != TUSB_XFER_CONTROL )
+  {
+    // empty TD queue: head = tail = dummy TD (OHCI 5.2.8.2)
+    ohci_gtd_t* dummy = gtd_find_free();
+    if ( !dummy )
+    {
+      p_ed->used = 0;
+      TU_ASSERT(false);
+    }
+    p_ed->td_head.address = p_ed->td_tail = (uint32_t) _phys_addr(dummy);
+    ohci_data.ed_xferred_bytes[p_ed - ohci_data.ed_pool] = 0;
+  }
+
+  ed_list_insert( p_ed_head[xfer_type], p_ed );
 
   return true;
 }
@@ -532,23 +637,92 @@ bool hcd_edpt_xfer(uint8_t rhport, uint8_t dev_addr, uint8_t ep_addr, uint8_t *
   }else
   {
     ohci_ed_t * ed = ed_from_addr(dev_addr, ep_addr);
-    ohci_gtd_t* gtd = gtd_find_free();
+    TU_ASSERT(ed && !ed->is_iso);
+
+    // count TDs of this transfer, current dummy tail TD is used as first one
+    uint16_t td_count = 0;
+    uint32_t remaining = buflen;
+    do {
+      remaining -= gtd_chunk_size(buffer + (buflen - remaining), remaining, ed->max_packet_size);
+      td_count++;
+    } while ( remaining );
+
+    // remaining TDs and the new dummy tail, TDs are only allocated in task context
+    TU_ASSERT(gtd_free_count() >= td_count); // not enough TD, try to increase CFG_TUH_OHCI_GTD_MAX
+
+    // fill TDs from current tail, HC does not process tail TD until TailP is advanced
+    ohci_gtd_t* gtd = (ohci_gtd_t*) _virt_addr((void*) tu_align16(ed->td_tail));
+    remaining = buflen;
+    for ( uint16_t i = 0; i < td_count; i++ )
+    {
+      uint16_t const len = gtd_chunk_size(buffer + (buflen - remaining), remaining, ed->max_packet_size);
+      bool const is_last = (i == td_count - 1);
 
-    TU_ASSERT(gtd);
+      gtd_init(gtd, buffer + (buflen - remaining), len);
+      gtd->index = (uint8_t) (ed - ohci_data.ed_pool);
+      gtd->last  = is_last ? 1 : 0;
+      if ( is_last )
+      {
+        gtd->delay_interrupt = OHCI_INT_ON_COMPLETE_YES;
+      }else
+      {
+        // short packet in middle TD stops the transfer: halt ED with data underrun, see done_queue_isr()
+        gtd->buffer_rounding = 0;
+      }
 
-    gtd_init(gtd, buffer, buflen);
-    gtd->index = ed-ohci_data.ed_pool;
-    gtd->delay_interrupt = OHCI_INT_ON_COMPLETE_YES;
+      ohci_gtd_t* next = gtd_find_free();
+      gtd->next = (uint32_t) _phys_addr(next);
+
+      remaining -= len;
+      gtd = next;
+    }
+
+    tu_memclr(gtd, sizeof(ohci_gtd_t));
+    gtd->used = 1;
 
-    td_insert_to_ed(ed, gtd);
+    ed->td_tail = (ed->td_tail & 0x0Ful) | (uint32_t) _phys_addr(gtd);
 
-    tusb_xfer_type_t xfer_type = ed_get_xfer_type( ed_from_addr(dev_addr, ep_addr) );
-    if (TUSB_XFER_BULK == xfer_type) OHCI_REG->command_status_bit.bulk_list_filled = 1;
+    if (TUSB_XFER_BULK == ed_get_xfer_type(ed)) OHCI_REG->command_status_bit.bulk_list_filled = 1;
   }
 
   return true;
 }
 
+bool hcd_edpt_iso_xfer(uint8_t rhport, uint8_t daddr, uint8_t ep_addr, uint8_t* buffer, hcd_iso_packet_t* packets,
+                       uint16_t n_packets) {
+#if CFG_TUH_ISO_EDPT_MAX
+  ohci_iso_ep_t* iso = iso_ep_find(daddr, ep_addr);
+  TU_VERIFY(iso && n_packets && iso->xfer_count < ISO_XFER_MAX);
+
+  // packet size is derived from offset of next packet (or BufferEnd for last one): zero-length is not supported
+  uint16_t const mps = ohci_data.ed_pool[iso->ed_index].max_packet_size;
+  for (uint16_t i = 0; i < n_packets; i++) {
+    TU_ASSERT(packets[i].len > 0 && packets[i].len <= mps);
+    packets[i].actual_len = 0;
+    packets[i].result = XFER_RESULT_INVALID;
+  }
+
+  hcd_int_disable(rhport);
+
+  ohci_iso_xfer_t* xfer = &iso->xfer[(iso->xfer_head + iso->xfer_count) % ISO_XFER_MAX];
+  tu_memclr(xfer, sizeof(ohci_iso_xfer_t));
+  xfer->buffer = buffer;
+  xfer->packets = packets;
+  xfer->n_packets = n_packets;
+  iso->xfer_count++;
+
+  iso_schedule(iso);
+  iso_complete(iso, false); // late packets may complete a transfer
+
+  hcd_int_enable(rhport);
+
+  return true;
+#else
+  (void) rhport; (void) daddr; (void) ep_addr; (void) buffer; (void) packets; (void) n_packets;
+  return false;
+#endif
+}
+
 bool hcd_edpt_abort_xfer(uint8_t rhport, uint8_t dev_addr, uint8_t ep_addr) {
   (void) rhport;
   (void) dev_addr;
@@ -562,7 +736,6 @@ bool hcd_edpt_clear_stall(uint8_t rhport, uint8_t dev_addr, uint8_t ep_addr) {
   ohci_ed_t * const p_ed = ed_from_addr(dev_addr, ep_addr);
 
   p_ed->is_stalled = 0;
-  p_ed->td_tail    &= 0x0Ful; // set tail pointer back to NULL
 
   p_ed->td_head.toggle = 0; // reset data toggle
   p_ed->td_head.halted = 0;
@@ -631,6 +804,24 @@ static inline uint32_t gtd_xfer_byte_left(uint32_t buffer_end, uint32_t current_
       tu_offset4k(buffer_end) - tu_offset4k(current_buffer) + 1;
 }
 
+// Drop remaining TDs of transfer whose TD is retired early (error or short packet). ED is halted by HC so that these
+// TDs are not processed
+static void gtd_drop_transfer(ohci_ed_t* ed)
+{
+  ohci_gtd_t const* const tail = (ohci_gtd_t*) _virt_addr((void*) tu_align16(ed->td_tail));
+  ohci_gtd_t* gtd = (ohci_gtd_t*) _virt_addr((void*) tu_align16(ed->td_head.address));
+
+  while ( gtd != tail )
+  {
+    bool const is_last = gtd->last;
+    gtd->used = 0;
+    gtd = (ohci_gtd_t*) _virt_addr((void*) gtd->next);
+    if ( is_last ) break;
+  }
+
+  ed->td_head.address = (ed->td_head.address & 0x0Ful) | (uint32_t) _phys_addr(gtd);
+}
+
 static void done_queue_isr(uint8_t hostid)
 {
   (void) hostid;
@@ -641,38 +832,59 @@ static void done_queue_isr(uint8_t hostid)
 
   while( td_head != NULL )
   {
-    // TODO check if td_head is iso td
+    // retired TD can be re-used right away (isochronous), get next item first
+    ohci_td_item_t* const td_next = (ohci_td_item_t*) _virt_addr((void *)td_head->next);
+
+#if CFG_TUH_ISO_EDPT_MAX
+    if ( itd_is_iso(td_head) )
+    {
+      itd_retire((ohci_itd_t const*) td_head);
+      td_head = td_next;
+      continue;
+    }
+#endif
+
     //------------- Non ISO transfer -------------//
     ohci_gtd_t * const qtd = (ohci_gtd_t *) td_head;
-    xfer_result_t const event = (qtd->condition_code == OHCI_CCODE_NO_ERROR) ? XFER_RESULT_SUCCESS :
-                                (qtd->condition_code == OHCI_CCODE_STALL) ? XFER_RESULT_STALLED : XFER_RESULT_FAILED;
+    xfer_result_t event = (qtd->condition_code == OHCI_CCODE_NO_ERROR) ? XFER_RESULT_SUCCESS :
+                          (qtd->condition_code == OHCI_CCODE_STALL) ? XFER_RESULT_STALLED : XFER_RESULT_FAILED;
+
+    ohci_ed_t * const ed  = gtd_get_ed(qtd);
+    uint32_t xferred_bytes = gtd_get_extra_data(qtd)->expected_bytes - gtd_xfer_byte_left((uint32_t) qtd->buffer_end, (uint32_t) qtd->current_buffer_pointer);
+    bool complete = (qtd->delay_interrupt == OHCI_INT_ON_COMPLETE_YES) || (event != XFER_RESULT_SUCCESS);
 
     qtd->used = 0; // free TD
-    if ( (qtd->delay_interrupt == OHCI_INT_ON_COMPLETE_YES) || (event != XFER_RESULT_SUCCESS) )
+
+    if ( !gtd_is_control(qtd) )
     {
-      ohci_ed_t * const ed  = gtd_get_ed(qtd);
-      uint32_t const xferred_bytes = gtd_get_extra_data(qtd)->expected_bytes - gtd_xfer_byte_left((uint32_t) qtd->buffer_end, (uint32_t) qtd->current_buffer_pointer);
-
-      // NOTE Assuming the current list is BULK and there is no other EDs in the list has queued TDs.
-      // When there is a error resulting this ED is halted, and this EP still has other queued TD
-      // --> the Bulk list only has this halted EP queueing TDs (remaining)
-      // --> Bulk list will be considered as not empty by HC !!! while there is no attempt transaction on this list
-      // --> HC will not process Control list (due to service ratio when Bulk list not empty)
-      // To walk-around this, the halted ED will have TailP = HeadP (empty list condition), when clearing halt
-      // the TailP must be set back to NULL for processing remaining TDs
-      if (event != XFER_RESULT_SUCCESS)
+      // transfer is chained with multiple TDs, sum up their bytes
+      uint16_t* const ed_xferred = &ohci_data.ed_xferred_bytes[ed - ohci_data.ed_pool];
+      xferred_bytes += *ed_xferred;
+      *ed_xferred = complete ? 0 : (uint16_t) xferred_bytes;
+
+      if ( complete && !qtd->last )
       {
-        ed->td_tail &= 0x0Ful;
-        ed->td_tail |= tu_align16(ed->td_head.address); // mark halted EP as empty queue
-        if ( event == XFER_RESULT_STALLED ) ed->is_stalled = 1;
+        gtd_drop_transfer(ed);
+
+        // short packet ends transfer before its last TD: not an error, resume ED
+        if ( qtd->condition_code == OHCI_CCODE_DATA_UNDERRUN )
+        {
+          event = XFER_RESULT_SUCCESS;
+          ed->td_head.halted = 0;
+        }
       }
+    }
+
+    if ( complete )
+    {
+      if ( event == XFER_RESULT_STALLED ) ed->is_stalled = 1;
 
       uint8_t dir = (ed->ep_number == 0) ? (qtd->pid == PID_IN) : (ed->pid == PID_IN);
 
       hcd_event_xfer_complete(ed->dev_addr, tu_edpt_addr(ed->ep_number, dir), xferred_bytes, event, true);
     }
 
-    td_head = (ohci_td_item_t*) _virt_addr((void *)td_head->next);
+    td_head = td_next;
   }
 }
 
@@ -732,6 +944,252 @@ void hcd_int_handler(uint8_t hostid, bool in_isr) {
 
   OHCI_REG->interrupt_enable = OHCI_INT_MASTER_ENABLE_MASK; // Enable MIE
 }
+
+//--------------------------------------------------------------------+
+// Isochronous helper
+//--------------------------------------------------------------------+
+#if CFG_TUH_ISO_EDPT_MAX
+
+// TDs per endpoint ring, including dummy tail
+#define ISO_TD_RING  (ISO_TD_MAX + 1)
+
+enum {
+  // offset word (OHCI 4.3.2.1): [12:0] offset (bit 12 selects page of BufferEnd), [15:13] NOT_ACCESSED until processed.
+  // After processing, it becomes packet status word: [10:0] size, [15:12] condition code
+  ITD_OFFSET_NOT_ACCESSED = 0x7u << 13,
+  ITD_PSW_SIZE_MASK       = 0x7FFu,
+};
+
+static ohci_iso_ep_t* iso_ep_find(uint8_t dev_addr, uint8_t ep_addr) {
+  for (uint8_t i = 0; i < CFG_TUH_ISO_EDPT_MAX; i++) {
+    ohci_iso_ep_t* iso = &ohci_data.iso_ep[i];
+    if (iso->dev_addr == dev_addr && iso->ep_addr == ep_addr) {
+      return iso;
+    }
+  }
+  return NULL;
+}
+
+TU_ATTR_ALWAYS_INLINE static inline ohci_itd_t* iso_td_get(ohci_iso_ep_t const* iso, uint8_t td_idx) {
+  return &ohci_data.iso_td[iso - ohci_data.iso_ep][td_idx];
+}
+
+static bool itd_is_iso(ohci_td_item_t const* td) {
+  uintptr_t const addr = (uintptr_t) td;
+  return (addr >= (uintptr_t) ohci_data.iso_td) && (addr < (uintptr_t) (ohci_data.iso_td + CFG_TUH_ISO_EDPT_MAX));
+}
+
+static bool iso_edpt_open(ohci_ed_t* ed, uint8_t dev_addr, tusb_desc_endpoint_t const* ep_desc) {
+  // OHCI only supports full speed isochronous endpoint, serviced every frame
+  TU_VERIFY(ep_desc->bInterval == 1);
+
+  // endpoint can be re-opened with different alternate setting
+  ohci_iso_ep_t* iso = iso_ep_find(dev_addr, ep_desc->bEndpointAddress);
+  if (iso != NULL) {
+    iso_edpt_stop(iso);
+  } else {
+    iso = iso_ep_find(0, 0);
+  }
+  TU_ASSERT(iso); // not enough iso endpoint, try to increase CFG_TUH_ISO_EDPT_MAX
+
+  tu_memclr(iso, sizeof(ohci_iso_ep_t));
+  iso->ep_addr  = ep_desc->bEndpointAddress;
+  iso->ed_index = (uint8_t) (ed - ohci_data.ed_pool);
+  iso->dev_addr = dev_addr;
+
+  iso_edpt_stop(iso);
+
+  return true;
+}
+
+// Drop scheduled TDs and queued transfers: TD queue is emptied to first TD of ring. Like other ED removals, HC is
+// assumed not to be processing this ED. TDs already retired to done queue are ignored by itd_retire()
+static void iso_edpt_stop(ohci_iso_ep_t* iso) {
+  ohci_ed_t* ed = &ohci_data.ed_pool[iso->ed_index];
+  uint32_t const first_td = (uint32_t) _phys_addr(iso_td_get(iso, 0));
+
+  ed->td_tail         = first_td;
+  ed->td_head.address = first_td;
+
+  iso->td_head = 0;
+  iso->td_count = 0;
+  iso->xfer_head = 0;
+  iso->xfer_count = 0;
+  iso->started = 0;
+}
+
+// Packets of next TD: up to 8 frames whose data are within 2 pages
+static uint8_t iso_td_packets(ohci_iso_xfer_t const* xfer) {
+  uint32_t offset = tu_offset4k((uint32_t) _phys_addr(xfer->buffer + xfer->sched_offset));
+  uint8_t count = 0;
+
+  while (count < 8 && xfer->sched_count + count < xfer->n_packets) {
+    uint16_t const len = xfer->packets[xfer->sched_count + count].len;
+    if (offset + len > 8192) {
+      break;
+    }
+    offset += len;
+    count++;
+  }
+
+  return count;
+}
+
+static void itd_init(ohci_itd_t* itd, ohci_iso_xfer_t const* xfer, uint16_t frame, uint8_t pkt_count) {
+  tu_memclr(itd, sizeof(ohci_itd_t));
+
+  uint32_t const start = (uint32_t) _phys_addr(xfer->buffer + xfer->sched_offset);
+  uint32_t offset = tu_offset4k(start);
+
+  itd->starting_frame  = frame;
+  itd->delay_interrupt = OHCI_INT_ON_COMPLETE_YES;
+  itd->frame_count     = (uint8_t) (pkt_count - 1) & 0x7u;
+  itd->condition_code  = OHCI_CCODE_NOT_ACCESSED;
+  itd->buffer_page0    = tu_align4k(start);
+
+  for (uint8_t i = 0; i < pkt_count; i++) {
+    itd->offset_packetstatus[i] = (uint16_t) (ITD_OFFSET_NOT_ACCESSED | offset);
+    offset += xfer->packets[xfer->sched_count + i].len;
+  }
+
+  itd->buffer_end = tu_align4k(start) + offset - 1;
+}
+
+// Mark packets which missed their frame as failed
+static void iso_skip_packets(ohci_iso_xfer_t* xfer, uint16_t count) {
+  count = tu_min16(count, (uint16_t) (xfer->n_packets - xfer->sched_count));
+  for (uint16_t i = 0; i < count; i++) {
+    hcd_iso_packet_t* pkt = &xfer->packets[xfer->sched_count];
+    pkt->actual_len = 0;
+    pkt->result = XFER_RESULT_FAILED;
+    xfer->sched_offset += pkt->len;
+    xfer->sched_count++;
+    xfer->done_count++;
+  }
+  xfer->failed = xfer->failed || (count > 0);
+}
+
+// transfer of next packets to schedule, NULL if all packets are scheduled
+static ohci_iso_xfer_t* iso_xfer_to_schedule(ohci_iso_ep_t* iso) {
+  for (uint8_t i = 0; i < iso->xfer_count; i++) {
+    ohci_iso_xfer_t* xfer = &iso->xfer[(iso->xfer_head + i) % ISO_XFER_MAX];
+    if (xfer->sched_count < xfer->n_packets) {
+      return xfer;
+    }
+  }
+  return NULL;
+}
+
+// Fill free TDs of ring with packets of queued transfers. A TD only carries packets of one transfer
+static void iso_schedule(ohci_iso_ep_t* iso) {
+  // HC may have fetched ED of current frame, keep 2 frames margin
+  uint32_t const earliest = hcd_frame_number(0) + 2;
+  ohci_ed_t* ed = &ohci_data.ed_pool[iso->ed_index];
+
+  while (iso->td_count < ISO_TD_MAX) {
+    ohci_iso_xfer_t* xfer = iso_xfer_to_schedule(iso);
+    if (xfer == NULL) {
+      break;
+    }
+
+    if (!iso->started || (int32_t) (iso->next_frame - earliest) < 0) {
+      // (re)start on earliest frame, packets of skipped frames are late
+      if (iso->started) {
+        iso_skip_packets(xfer, (uint16_t) tu_min32(earliest - iso->next_frame, UINT16_MAX));
+        if (xfer->sched_count == xfer->n_packets) {
+          iso->next_frame = earliest;
+          continue; // whole transfer is late
+        }
+      }
+
+      iso->next_frame = earliest;
+      iso->started = 1;
+    }
+
+    uint8_t const td_idx = (uint8_t) ((iso->td_head + iso->td_count) % ISO_TD_RING);
+    ohci_itd_t* itd = iso_td_get(iso, td_idx);
+    ohci_itd_t* next = iso_td_get(iso, (uint8_t) ((td_idx + 1) % ISO_TD_RING));
+    uint8_t const pkt_count = iso_td_packets(xfer);
+
+    itd_init(itd, xfer, (uint16_t) iso->next_frame, pkt_count);
+    itd->next = (uint32_t) _phys_addr(next);
+
+    iso->td_info[td_idx].pkt_first = xfer->sched_count;
+    iso->td_info[td_idx].pkt_count = pkt_count;
+    iso->td_info[td_idx].xfer_id   = (uint8_t) (xfer - iso->xfer);
+
+    for (uint8_t i = 0; i < pkt_count; i++) {
+      xfer->sched_offset += xfer->packets[xfer->sched_count].len;
+      xfer->sched_count++;
+    }
+
+    // TD is processed by HC once tail is advanced to next (dummy) TD
+    ed->td_tail = (uint32_t) _phys_addr(next);
+
+    iso->td_count++;
+    iso->next_frame += pkt_count;
+  }
+}
+
+// Notify usbh of transfers whose packets are all completed, in submitted order
+static void iso_complete(ohci_iso_ep_t* iso, bool in_isr) {
+  while (iso->xfer_count) {
+    ohci_iso_xfer_t* xfer = &iso->xfer[iso->xfer_head];
+    if (xfer->done_count < xfer->n_packets) {
+      break;
+    }
+
+    iso->xfer_head = (uint8_t) ((iso->xfer_head + 1) % ISO_XFER_MAX);
+    iso->xfer_count--;
+
+    hcd_event_xfer_complete(iso->dev_addr, iso->ep_addr, xfer->xferred_bytes,
+                            xfer->failed ? XFER_RESULT_FAILED : XFER_RESULT_SUCCESS, in_isr);
+  }
+
+  // stream stopped: transfer is not submitted in time, next one starts over without counting late frames
+  if (iso->xfer_count == 0 && iso->td_count == 0) {
+    iso->started = 0;
+  }
+}
+
+// Update packets of TD retired to done queue, TDs of an endpoint are retired in order
+static void itd_retire(ohci_itd_t const* itd) {
+  uint32_t const ep_idx = (uint32_t) (((uintptr_t) itd - (uintptr_t) ohci_data.iso_td) / sizeof(ohci_data.iso_td[0]));
+  ohci_iso_ep_t* iso = &ohci_data.iso_ep[ep_idx];
+  if (iso->dev_addr == 0 || iso->td_count == 0 || itd != iso_td_get(iso, iso->td_head)) {
+    return; // endpoint is stopped
+  }
+
+  bool const is_in = (tu_edpt_dir(iso->ep_addr) == TUSB_DIR_IN);
+  ohci_iso_xfer_t* xfer = &iso->xfer[iso->td_info[iso->td_head].xfer_id];
+  uint16_t const pkt_first = iso->td_info[iso->td_head].pkt_first;
+
+  for (uint8_t i = 0; i < iso->td_info[iso->td_head].pkt_count; i++) {
+    hcd_iso_packet_t* pkt = &xfer->packets[pkt_first + i];
+    uint16_t const psw = itd->offset_packetstatus[i];
+    uint8_t const cc = (uint8_t) (psw >> 12);
+
+    // frame which is not processed in time is left NOT_ACCESSED, short IN packet is reported as data underrun
+    bool const failed = !(cc == OHCI_CCODE_NO_ERROR || (is_in && cc == OHCI_CCODE_DATA_UNDERRUN));
+    uint16_t const actual_len = failed ? 0 : (is_in ? (uint16_t) (psw & ITD_PSW_SIZE_MASK) : pkt->len);
+
+    pkt->actual_len = actual_len;
+    pkt->result = failed ? XFER_RESULT_FAILED : XFER_RESULT_SUCCESS;
+    xfer->xferred_bytes += actual_len;
+    xfer->failed = xfer->failed || failed;
+    xfer->done_count++;
+  }
+
+  iso->td_head = (uint8_t) ((iso->td_head + 1) % ISO_TD_RING);
+  iso->td_count--;
+
+  iso_complete(iso, true);
+  iso_schedule(iso);
+  iso_complete(iso, true); // late packets may complete a transfer
+}
+
+#endif
+
 //--------------------------------------------------------------------+
 // HELPER
 //--------------------------------------------------------------------+
@@ -37,16 +37,33 @@
 #define HOST_HCD_XFER_INTERRUPT // TODO interrupt is used widely, should always be enabled
 #define OHCI_PERIODIC_LIST (defined HOST_HCD_XFER_INTERRUPT || defined HOST_HCD_XFER_ISOCHRONOUS)
 
-// TODO merge OHCI with EHCI
-enum {
-  OHCI_MAX_ITD = 4
-};
-
 #define ED_MAX       (CFG_TUH_DEVICE_MAX*CFG_TUH_ENDPOINT_MAX)
-#define GTD_MAX      ED_MAX
+
+// General TD pool shared by non-control endpoints. Each endpoint keeps one dummy TD at tail of its queue (OHCI 5.2.8),
+// a transfer is split into TDs of up to 8KB (2 pages), so that a 64KB transfer needs 9 TDs.
+#ifndef CFG_TUH_OHCI_GTD_MAX
+  #define CFG_TUH_OHCI_GTD_MAX    (2*ED_MAX + 8)
+#endif
+
+// Isochronous TDs per endpoint, each TD carries up to 8 frames (one packet per frame) within 2 pages of buffer
+#ifndef CFG_TUH_OHCI_ISO_TD_MAX
+  #define CFG_TUH_OHCI_ISO_TD_MAX    4
+#endif
+
+// Isochronous transfers (buffers) that can be queued per endpoint, next ones are scheduled right after previous
+#ifndef CFG_TUH_OHCI_ISO_XFER_MAX
+  #define CFG_TUH_OHCI_ISO_XFER_MAX  2
+#endif
+
+#define GTD_MAX      CFG_TUH_OHCI_GTD_MAX
+#define ISO_TD_MAX   CFG_TUH_OHCI_ISO_TD_MAX
+#define ISO_XFER_MAX CFG_TUH_OHCI_ISO_XFER_MAX
 
 // tinyUSB's OHCI implementation caps number of EDs to 8 bits
 TU_VERIFY_STATIC (ED_MAX <= 256, "Reduce CFG_TUH_DEVICE_MAX or CFG_TUH_ENDPOINT_MAX");
+TU_VERIFY_STATIC (GTD_MAX > ED_MAX && GTD_MAX <= 1024, "invalid CFG_TUH_OHCI_GTD_MAX");
+TU_VERIFY_STATIC (ISO_TD_MAX >= 2 && ISO_TD_MAX < 255 && ISO_XFER_MAX >= 1 && ISO_XFER_MAX <= 255,
+                  "invalid OHCI isochronous configuration");
 
 //--------------------------------------------------------------------+
 // OHCI Data Structure
@@ -74,7 +91,8 @@ typedef struct TU_ATTR_ALIGNED(16)
 	// Word 0
 	uint32_t used                    : 1;
   uint32_t index                   : 8; // endpoint index the gtd belongs to, or device address in case of control xfer
-  uint32_t                         : 9; // can be used
+  uint32_t last                    : 1; // last TD of transfer
+  uint32_t                         : 8; // can be used
   uint32_t buffer_rounding         : 1;
   uint32_t pid                     : 2;
   uint32_t delay_interrupt         : 3;
@@ -150,18 +168,57 @@ typedef struct TU_ATTR_ALIGNED(32)
 
 	/*---------- Word 5-8 ----------*/
 	volatile uint16_t offset_packetstatus[8];
-} ochi_itd_t;
+} ohci_itd_t;
 
-TU_VERIFY_STATIC( sizeof(ochi_itd_t) == 32, "size is not correct" );
+TU_VERIFY_STATIC( sizeof(ohci_itd_t) == 32, "size is not correct" );
 
 typedef struct {
   uint16_t expected_bytes; // up to 8192 bytes so max is 13 bits
 } gtd_extra_data_t;
 
+#if CFG_TUH_ISO_EDPT_MAX
+typedef struct {
+  uint8_t* buffer;
+  hcd_iso_packet_t* packets;
+  uint16_t n_packets;
+  uint16_t sched_count;   // packets scheduled to TD (or skipped)
+  uint16_t done_count;    // packets completed
+  uint32_t sched_offset;  // buffer offset of next packet to schedule
+  uint32_t xferred_bytes;
+  bool failed;
+} ohci_iso_xfer_t;
+
+typedef struct {
+  uint8_t dev_addr;  // 0 if free
+  uint8_t ep_addr;
+  uint8_t ed_index;  // ED in ed_pool
+  uint8_t started;   // stream is running, frames which are missed count as late packets
+
+  // TDs linked to ED in ring of ISO_TD_MAX+1 entries, the one after last linked TD is dummy tail
+  uint8_t td_head;
+  uint8_t td_count;
+  uint32_t next_frame; // frame of next TD to schedule
+
+  struct {
+    uint16_t pkt_first;
+    uint8_t pkt_count;
+    uint8_t xfer_id;
+  } td_info[ISO_TD_MAX + 1];
+
+  uint8_t xfer_head;
+  uint8_t xfer_count;
+  ohci_iso_xfer_t xfer[ISO_XFER_MAX];
+} ohci_iso_ep_t;
+#endif
+
 // structure with member alignment required from large to small
 typedef struct TU_ATTR_ALIGNED(256) {
   ohci_hcca_t hcca;
 
+#if CFG_TUH_ISO_EDPT_MAX
+  ohci_itd_t iso_td[CFG_TUH_ISO_EDPT_MAX][ISO_TD_MAX + 1]; // itd requires alignment of 32
+#endif
+
   ohci_ed_t bulk_head_ed; // static bulk head (dummy)
   ohci_ed_t period_head_ed; // static periodic list head (dummy)
 
@@ -171,7 +228,6 @@ typedef struct TU_ATTR_ALIGNED(256) {
     ohci_gtd_t gtd;
   } control[CFG_TUH_DEVICE_MAX + CFG_TUH_HUB + 1];
 
-  //  ochi_itd_t itd[OHCI_MAX_ITD]; // itd requires alignment of 32
   ohci_ed_t ed_pool[ED_MAX];
   ohci_gtd_t gtd_pool[GTD_MAX];
 
@@ -179,6 +235,12 @@ typedef struct TU_ATTR_ALIGNED(256) {
   gtd_extra_data_t gtd_extra_control[CFG_TUH_DEVICE_MAX + CFG_TUH_HUB + 1];
   gtd_extra_data_t gtd_extra[GTD_MAX];
 
+  uint16_t ed_xferred_bytes[ED_MAX]; // bytes of completed TDs of current transfer
+
+#if CFG_TUH_ISO_EDPT_MAX
+  ohci_iso_ep_t iso_ep[CFG_TUH_ISO_EDPT_MAX];
+#endif
+
   volatile uint16_t frame_number_hi;
 } ohci_data_t;
 
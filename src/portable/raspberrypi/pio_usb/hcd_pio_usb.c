@@ -29,6 +29,7 @@
 #if CFG_TUH_ENABLED && (CFG_TUSB_MCU == OPT_MCU_RP2040) && CFG_TUH_RPI_PIO_USB
 
 #include "pico.h"
+#include "hardware/timer.h"
 #include "pio_usb.h"
 #include "pio_usb_ll.h"
 
@@ -44,6 +45,48 @@
 #define RHPORT_PIO(_x)    ((_x)-RHPORT_OFFSET)
 
 static pio_usb_configuration_t pio_host_cfg = PIO_USB_DEFAULT_CONFIG;
+static tuh_rpi_pio_usb_frame_stats_t _frame_stats;
+
+//--------------------------------------------------------------------+
+// Frame
+//--------------------------------------------------------------------+
+
+// Check if any opened endpoint of any root port has a transfer pending
+static bool __no_inline_not_in_flash_func(has_pending_transfer)(void) {
+  for (uint8_t ep_idx = 0; ep_idx < PIO_USB_EP_POOL_CNT; ep_idx++) {
+    if (PIO_USB_ENDPOINT(ep_idx)->has_transfer) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void __no_inline_not_in_flash_func(tuh_rpi_pio_usb_frame)(void) {
+  bool const busy = has_pending_transfer();
+  uint32_t const start_us = time_us_32();
+
+  // SOF and transactions of all root ports, endpoints without pending transfer are skipped by Pico-PIO-USB
+  pio_usb_host_frame();
+
+  uint16_t const cost_us = (uint16_t) tu_min32(time_us_32() - start_us, UINT16_MAX);
+
+  _frame_stats.frame_count++;
+  if (busy) {
+    _frame_stats.busy_count++;
+  }
+  _frame_stats.total_us += cost_us;
+  _frame_stats.last_us = cost_us;
+  _frame_stats.max_us = tu_max16(_frame_stats.max_us, cost_us);
+}
+
+void tuh_rpi_pio_usb_frame_stats(tuh_rpi_pio_usb_frame_stats_t* stats, bool reset) {
+  if (stats) {
+    *stats = _frame_stats;
+  }
+  if (reset) {
+    tu_memclr(&_frame_stats, sizeof(_frame_stats));
+  }
+}
 
 //--------------------------------------------------------------------+
 // HCD API
@@ -59,7 +102,9 @@ bool hcd_init(uint8_t rhport, const tusb_rhport_init_t* rh_init) {
   (void) rhport;
   (void) rh_init;
 
-  // To run USB SOF interrupt in core1, call this init in core1
+  // To run USB SOF interrupt in core1, call this init in core1. With skip_alarm_pool, application runs frames with
+  // tuh_rpi_pio_usb_frame() instead. Additional root ports are added with pio_usb_host_add_port() as rhport 2, 3 ...
+  tu_memclr(&_frame_stats, sizeof(_frame_stats));
   pio_usb_host_init(&pio_host_cfg);
 
   return true;
@@ -85,7 +130,8 @@ bool hcd_port_connect_status(uint8_t rhport) {
 }
 
 tusb_speed_t hcd_port_speed_get(uint8_t rhport) {
-  // TODO determine link speed
+  // Speed is latched by Pico-PIO-USB on connection from idle line state (pull-up on D+ or D-). Line state can't be
+  // used afterward since bus carries SOF or keep-alive
   uint8_t const pio_rhport = RHPORT_PIO(rhport);
   return PIO_USB_ROOT_PORT(pio_rhport)->is_fullspeed ? TUSB_SPEED_FULL : TUSB_SPEED_LOW;
 }
@@ -164,13 +210,14 @@ static void __no_inline_not_in_flash_func(handle_endpoint_irq)(root_port_t *rpor
   (void) rport;
   const uint32_t ep_all = *ep_reg;
 
-  for ( uint8_t ep_idx = 0; ep_idx < PIO_USB_EP_POOL_CNT; ep_idx++ ) {
-    uint32_t const mask = (1u << ep_idx);
+  // only visit endpoints with pending event
+  uint32_t pending = ep_all;
+  while (pending) {
+    uint8_t const ep_idx = (uint8_t) __builtin_ctz(pending);
+    pending &= ~(1u << ep_idx);
 
-    if ( ep_all & mask ) {
-      endpoint_t * ep = PIO_USB_ENDPOINT(ep_idx);
-      hcd_event_xfer_complete(ep->dev_addr, ep->ep_num, ep->actual_len, result, true);
-    }
+    endpoint_t * ep = PIO_USB_ENDPOINT(ep_idx);
+    hcd_event_xfer_complete(ep->dev_addr, ep->ep_num, ep->actual_len, result, true);
   }
 
   // clear all
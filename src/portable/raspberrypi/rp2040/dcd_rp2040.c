@@ -46,12 +46,15 @@
 /*------------------------------------------------------------------*/
 /* Low level controller
  *------------------------------------------------------------------*/
-// Init these in dcd_init
-static uint8_t* next_buffer_ptr;
-
 // USB_MAX_ENDPOINTS Endpoints, direction TUSB_DIR_OUT for out and TUSB_DIR_IN for in.
 static struct hw_endpoint hw_endpoints[USB_MAX_ENDPOINTS][2];
 
+// Size of DPRAM buffer allocated to each endpoint (0 if none), offset is given by its hw_data_buf
+static uint16_t _dpram_size[USB_MAX_ENDPOINTS][2];
+
+// Buffer size planned for each endpoint of current configuration (0 if not planned)
+static uint16_t _dpram_plan[USB_MAX_ENDPOINTS][2];
+
 // SOF may be used by remote wakeup as RESUME, this indicate whether SOF is actually used by usbd
 static bool _sof_enable = false;
 
@@ -65,28 +68,127 @@ TU_ATTR_ALWAYS_INLINE static inline struct hw_endpoint* hw_endpoint_get_by_addr(
   return hw_endpoint_get_by_num(num, dir);
 }
 
-// Allocate from the USB buffer space (max 3840 bytes)
-static void hw_endpoint_alloc(struct hw_endpoint* ep, size_t size) {
-  // round up size to multiple of 64
-  size = tu_round_up(ep->wMaxPacketSize, 64);
+// Enable endpoint
+TU_ATTR_ALWAYS_INLINE static inline void hw_endpoint_enable(struct hw_endpoint* ep) {
+  uint32_t const reg = EP_CTRL_ENABLE_BITS | ((uint) ep->transfer_type << EP_CTRL_BUFFER_TYPE_LSB) | hw_data_offset(ep->hw_data_buf);
+  *ep->endpoint_control = reg;
+}
 
-  // double buffered Bulk endpoint
-  if (ep->transfer_type == TUSB_XFER_BULK) {
-    size *= 2u;
+//--------------------------------------------------------------------+
+// DPRAM allocator
+// Endpoint buffers are allocated first-fit from USB buffer space (max 3840 bytes) and released when the endpoint is
+// re-opened (e.g. alternate setting change). Idle endpoints are moved down to make room when space is fragmented.
+//--------------------------------------------------------------------+
+typedef struct {
+  struct hw_endpoint* ep;
+  uint16_t offset;
+  uint16_t size;
+} dpram_region_t;
+
+// Collect allocated buffers sorted by offset, return number of regions
+static uint8_t dpram_regions(dpram_region_t regions[2 * (USB_MAX_ENDPOINTS - 1)]) {
+  uint8_t count = 0;
+  for (uint8_t num = 1; num < USB_MAX_ENDPOINTS; num++) {
+    for (uint8_t dir = 0; dir < 2; dir++) {
+      if (_dpram_size[num][dir] == 0) {
+        continue;
+      }
+      struct hw_endpoint* ep = hw_endpoint_get_by_num(num, (tusb_dir_t) dir);
+      dpram_region_t region = {
+        .ep = ep,
+        .offset = (uint16_t) (ep->hw_data_buf - usb_dpram->epx_data),
+        .size = _dpram_size[num][dir]
+      };
+
+      // insertion sort
+      uint8_t i = count++;
+      while (i > 0 && regions[i - 1].offset > region.offset) {
+        regions[i] = regions[i - 1];
+        i--;
+      }
+      regions[i] = region;
+    }
   }
+  return count;
+}
 
-  // assign buffer
-  ep->hw_data_buf = next_buffer_ptr;
-  next_buffer_ptr += size;
+// Find first free gap that fits size, return offset or -1 if none
+static int32_t dpram_find_gap(uint16_t size) {
+  dpram_region_t regions[2 * (USB_MAX_ENDPOINTS - 1)];
+  uint8_t const count = dpram_regions(regions);
 
-  hard_assert(next_buffer_ptr < usb_dpram->epx_data + sizeof(usb_dpram->epx_data));
-  pico_info("  Allocated %d bytes (0x%p)\r\n", size,  ep->hw_data_buf);
+  uint32_t cursor = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    if (regions[i].offset >= cursor + size) {
+      return (int32_t) cursor;
+    }
+    cursor = tu_max32(cursor, (uint32_t) regions[i].offset + regions[i].size);
+  }
+
+  return (cursor + size <= sizeof(usb_dpram->epx_data)) ? (int32_t) cursor : -1;
 }
 
-// Enable endpoint
-TU_ATTR_ALWAYS_INLINE static inline void hw_endpoint_enable(struct hw_endpoint* ep) {
-  uint32_t const reg = EP_CTRL_ENABLE_BITS | ((uint) ep->transfer_type << EP_CTRL_BUFFER_TYPE_LSB) | hw_data_offset(ep->hw_data_buf);
-  *ep->endpoint_control = reg;
+// Move buffers of idle endpoints down to merge free space. Endpoint with transfer in progress or holding a packet for
+// its next transfer stays in place.
+static void dpram_compact(void) {
+  dpram_region_t regions[2 * (USB_MAX_ENDPOINTS - 1)];
+  uint8_t const count = dpram_regions(regions);
+
+  uint32_t cursor = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    struct hw_endpoint* ep = regions[i].ep;
+    if (!ep->active && !ep->out_carry && regions[i].offset > cursor) {
+      ep->hw_data_buf = &usb_dpram->epx_data[cursor];
+      if (*ep->endpoint_control & EP_CTRL_ENABLE_BITS) {
+        hw_endpoint_enable(ep);
+      }
+      pico_info("  Moved ep %02X buffer to 0x%p\r\n", ep->ep_addr, ep->hw_data_buf);
+      cursor += regions[i].size;
+    } else {
+      cursor = tu_max32(cursor, (uint32_t) regions[i].offset + regions[i].size);
+    }
+  }
+}
+
+static bool dpram_alloc(struct hw_endpoint* ep, uint16_t size) {
+  int32_t offset = dpram_find_gap(size);
+  if (offset < 0) {
+    dpram_compact();
+    offset = dpram_find_gap(size);
+  }
+  TU_VERIFY(offset >= 0);
+
+  ep->hw_data_buf = &usb_dpram->epx_data[offset];
+  _dpram_size[tu_edpt_number(ep->ep_addr)][tu_edpt_dir(ep->ep_addr)] = size;
+  pico_info("  Allocated %d bytes (0x%p)\r\n", size, ep->hw_data_buf);
+  return true;
+}
+
+// Allocate endpoint buffer, previous buffer of this endpoint (if any) is released first
+static void hw_endpoint_alloc(struct hw_endpoint* ep, size_t size) {
+  uint8_t const num = tu_edpt_number(ep->ep_addr);
+  uint8_t const dir = tu_edpt_dir(ep->ep_addr);
+  _dpram_size[num][dir] = 0;
+
+  // round up size to multiple of 64
+  uint16_t const buf_size = (uint16_t) tu_round_up(size, 64);
+
+  // planned size covers all alternate settings of the configuration
+  uint16_t alloc_size = tu_max16(buf_size, _dpram_plan[num][dir]);
+  if (ep->transfer_type == TUSB_XFER_BULK && _dpram_plan[num][dir] == 0) {
+    // double buffered Bulk endpoint if not planned
+    alloc_size = (uint16_t) (2 * buf_size);
+  }
+
+  if (!dpram_alloc(ep, alloc_size)) {
+    // fall back to single buffer
+    alloc_size = buf_size;
+    bool const allocated = dpram_alloc(ep, alloc_size);
+    hard_assert(allocated);
+    (void) allocated;
+  }
+
+  ep->single_buffered = (alloc_size < 2 * buf_size);
 }
 
 // main processing for dcd_edpt_iso_activate
@@ -104,6 +206,7 @@ static void hw_endpoint_init(uint8_t ep_addr, uint16_t wMaxPacketSize, uint8_t t
   ep->next_pid = 0u;
   ep->wMaxPacketSize = wMaxPacketSize;
   ep->transfer_type = transfer_type;
+  ep->out_carry = false;
 
   // Every endpoint has a buffer control register in dpram
   if (dir == TUSB_DIR_IN) {
@@ -145,7 +248,11 @@ static void hw_endpoint_open(uint8_t ep_addr, uint16_t wMaxPacketSize, uint8_t t
 
 static void hw_endpoint_xfer(uint8_t ep_addr, uint8_t* buffer, uint16_t total_bytes) {
   struct hw_endpoint* ep = hw_endpoint_get_by_addr(ep_addr);
-  hw_endpoint_xfer_start(ep, buffer, total_bytes);
+  if (hw_endpoint_xfer_start(ep, buffer, total_bytes)) {
+    // complete with packet received at the end of previous transfer
+    dcd_event_xfer_complete(0, ep->ep_addr, ep->xferred_len, XFER_RESULT_SUCCESS, false);
+    hw_endpoint_reset_transfer(ep);
+  }
 }
 
 static void __tusb_irq_path_func(hw_handle_buff_status)(void) {
@@ -160,8 +267,8 @@ static void __tusb_irq_path_func(hw_handle_buff_status)(void) {
       // IN transfer for even i, OUT transfer for odd i
       struct hw_endpoint* ep = hw_endpoint_get_by_num(i >> 1u, (i & 1u) ? TUSB_DIR_OUT : TUSB_DIR_IN);
 
-      // Continue xfer
-      bool done = hw_endpoint_xfer_continue(ep);
+      // Continue xfer. Double-buffered OUT may have already synced this buffer with previous status
+      bool done = (ep->active || !ep->rx) && hw_endpoint_xfer_continue(ep);
       if (done) {
         // Notify
         dcd_event_xfer_complete(0, ep->ep_addr, ep->xferred_len, XFER_RESULT_SUCCESS, true);
@@ -211,7 +318,8 @@ static void __tusb_irq_path_func(reset_non_control_endpoints)(void) {
   tu_memclr(hw_endpoints[1], sizeof(hw_endpoints) - 2 * sizeof(hw_endpoint_t));
 
   // reclaim buffer space
-  next_buffer_ptr = &usb_dpram->epx_data[0];
+  tu_memclr(_dpram_size, sizeof(_dpram_size));
+  tu_memclr(_dpram_plan, sizeof(_dpram_plan));
 }
 
 static void __tusb_irq_path_func(dcd_rp2040_irq)(void) {
@@ -505,6 +613,51 @@ bool dcd_edpt_iso_activate(uint8_t rhport, tusb_desc_endpoint_t const * ep_desc)
   return true;
 }
 
+// Plan DPRAM for the configuration: every endpoint gets the largest packet size among alternate settings, then bulk
+// endpoints are double buffered (2x64 bytes or more) as long as all endpoints still fit
+void dcd_edpt_config_plan(uint8_t rhport, tusb_desc_configuration_t const* desc_cfg) {
+  (void) rhport;
+  uint16_t plan[USB_MAX_ENDPOINTS][2] = { 0 };
+  uint16_t bulk_mask[2] = { 0 };
+
+  uint8_t const* p_desc = (uint8_t const*) desc_cfg;
+  uint8_t const* desc_end = p_desc + tu_le16toh(desc_cfg->wTotalLength);
+  p_desc = tu_desc_next(p_desc);
+
+  while (p_desc < desc_end) {
+    if (tu_desc_type(p_desc) == TUSB_DESC_ENDPOINT) {
+      tusb_desc_endpoint_t const* desc_ep = (tusb_desc_endpoint_t const*) p_desc;
+      uint8_t const num = tu_edpt_number(desc_ep->bEndpointAddress);
+      uint8_t const dir = tu_edpt_dir(desc_ep->bEndpointAddress);
+      TU_VERIFY(num > 0 && num < USB_MAX_ENDPOINTS,);
+
+      plan[num][dir] = tu_max16(plan[num][dir], (uint16_t) tu_round_up(tu_edpt_packet_size(desc_ep), 64));
+      if (desc_ep->bmAttributes.xfer == TUSB_XFER_BULK) {
+        bulk_mask[dir] |= (uint16_t) TU_BIT(num);
+      }
+    }
+    p_desc = tu_desc_next(p_desc);
+  }
+
+  uint32_t total = 0;
+  for (uint8_t num = 1; num < USB_MAX_ENDPOINTS; num++) {
+    total += plan[num][0] + plan[num][1];
+  }
+  TU_VERIFY(total <= sizeof(usb_dpram->epx_data),); // allocate on open without plan
+
+  uint32_t spare = sizeof(usb_dpram->epx_data) - total;
+  for (uint8_t num = 1; num < USB_MAX_ENDPOINTS; num++) {
+    for (uint8_t dir = 0; dir < 2; dir++) {
+      if ((bulk_mask[dir] & TU_BIT(num)) && plan[num][dir] <= spare) {
+        spare -= plan[num][dir];
+        plan[num][dir] = (uint16_t) (2 * plan[num][dir]);
+      }
+    }
+  }
+
+  memcpy(_dpram_plan, plan, sizeof(plan));
+}
+
 void dcd_edpt_close_all(uint8_t rhport) {
   (void) rhport;
 
@@ -529,9 +682,11 @@ void dcd_edpt_stall(uint8_t rhport, uint8_t ep_addr) {
 
   struct hw_endpoint* ep = hw_endpoint_get_by_addr(ep_addr);
 
-  // stall and clear current pending buffer
+  // stall and clear current pending buffer, also drop packet carried for next transfer
   // may need to use EP_ABORT
   _hw_endpoint_buffer_control_set_value32(ep, USB_BUF_CTRL_STALL);
+  ep->out_armed = 0;
+  ep->out_carry = false;
 }
 
 void dcd_edpt_clear_stall(uint8_t rhport, uint8_t ep_addr) {
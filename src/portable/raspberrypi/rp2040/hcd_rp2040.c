@@ -52,10 +52,75 @@
 #endif
 static_assert(PICO_USB_HOST_INTERRUPT_ENDPOINTS <= USB_MAX_ENDPOINTS, "");
 
+// Number of hardware interrupt endpoints that bulk endpoints leave free for interrupt/isochronous endpoints
+#ifndef CFG_TUH_RPI_INTEP_PERIODIC_RESERVED
+#define CFG_TUH_RPI_INTEP_PERIODIC_RESERVED 4
+#endif
+
+// Number of bulk endpoints served by EPX when they do not get a hardware interrupt endpoint
+#ifndef CFG_TUH_RPI_EPX_BULK_MAX
+#define CFG_TUH_RPI_EPX_BULK_MAX 8
+#endif
+
+// Bulk transfer on EPX is carried out in slices of this size, so that pending transfers of other endpoints
+// get EPX in between
+#ifndef CFG_TUH_RPI_EPX_SLICE_SIZE
+#define CFG_TUH_RPI_EPX_SLICE_SIZE 512
+#endif
+
 // Host mode uses one shared endpoint register for non-interrupt endpoint
 static struct hw_endpoint ep_pool[1 + PICO_USB_HOST_INTERRUPT_ENDPOINTS];
 #define epx (ep_pool[0])
 
+// Bulk endpoint sharing EPX with control endpoint, hardware registers are programmed when it gets EPX
+typedef struct {
+  struct hw_endpoint hw;  // must be first, transfer info is of the current slice
+  uint8_t* buffer;        // whole transfer
+  uint16_t total_len;
+  uint16_t xferred_len;
+  uint16_t slice_len;     // length of slice on EPX
+  bool queued;            // waiting for EPX
+} epx_bulk_t;
+
+static epx_bulk_t epx_bulk[CFG_TUH_RPI_EPX_BULK_MAX];
+
+// Control transfer waiting for EPX
+static struct {
+  bool queued;
+  bool setup;
+  uint8_t* buffer;
+  uint16_t len;
+} epx_ctrl_xfer;
+
+static struct hw_endpoint* epx_owner; // endpoint whose transfer is on EPX, NULL if idle
+static uint8_t epx_bulk_rr;           // next bulk endpoint to serve on EPX
+
+#if CFG_TUH_ISO_EDPT_MAX
+// Isochronous transfer is carried out one packet per service interval, hardware polls endpoint at its interval
+typedef struct {
+  uint8_t* buffer;
+  hcd_iso_packet_t* packets;
+  uint16_t n_packets;
+  uint16_t pkt_idx;       // packet in progress
+  uint32_t offset;        // buffer offset of packet in progress
+  uint32_t xferred_bytes;
+  bool failed;
+} iso_xfer_t;
+
+// Up to 2 transfers are queued for continuous streaming
+typedef struct {
+  struct hw_endpoint* ep; // NULL if not used
+  uint8_t xfer_head;
+  uint8_t xfer_count;
+  iso_xfer_t xfer[2];
+} iso_edpt_t;
+
+static iso_edpt_t iso_pool[CFG_TUH_ISO_EDPT_MAX];
+
+// Isochronous packets are larger than 64 bytes, their data buffers are allocated downward from top of dpram
+static uint16_t iso_dpram_top;
+#endif
+
 // Flags we set by default in sie_ctrl (we add other bits on top)
 enum {
   SIE_CTRL_BASE = USB_SIE_CTRL_SOF_EN_BITS      | USB_SIE_CTRL_KEEP_ALIVE_EN_BITS |
@@ -73,9 +138,21 @@ static struct hw_endpoint *get_dev_ep(uint8_t dev_addr, uint8_t ep_addr)
     if ( ep->configured && (ep->dev_addr == dev_addr) && (ep->ep_addr == ep_addr) ) return ep;
   }
 
+  for ( uint32_t i = 0; i < CFG_TUH_RPI_EPX_BULK_MAX; i++ )
+  {
+    struct hw_endpoint *ep = &epx_bulk[i].hw;
+    if ( ep->configured && (ep->dev_addr == dev_addr) && (ep->ep_addr == ep_addr) ) return ep;
+  }
+
   return NULL;
 }
 
+// Check if endpoint transfers through EPX (control or bulk without hardware interrupt endpoint)
+TU_ATTR_ALWAYS_INLINE static inline bool is_epx_user(struct hw_endpoint const *ep)
+{
+  return ep->endpoint_control == &usbh_dpram->epx_ctrl;
+}
+
 TU_ATTR_ALWAYS_INLINE static inline uint8_t dev_speed(void)
 {
   return (usb_hw->sie_status & USB_SIE_STATUS_SPEED_BITS) >> USB_SIE_STATUS_SPEED_LSB;
@@ -88,6 +165,8 @@ TU_ATTR_ALWAYS_INLINE static inline bool need_pre(uint8_t dev_addr)
   return hcd_port_speed_get(0) != tuh_speed_get(dev_addr);
 }
 
+static void epx_schedule(void);
+
 static void __tusb_irq_path_func(hw_xfer_complete)(struct hw_endpoint *ep, xfer_result_t xfer_result)
 {
   // Mark transfer as done before we tell the tinyusb stack
@@ -95,12 +174,92 @@ static void __tusb_irq_path_func(hw_xfer_complete)(struct hw_endpoint *ep, xfer_
   uint8_t ep_addr = ep->ep_addr;
   uint xferred_len = ep->xferred_len;
   hw_endpoint_reset_transfer(ep);
+
+  if ( !is_epx_user(ep) )
+  {
+    hcd_event_xfer_complete(dev_addr, ep_addr, xferred_len, xfer_result, true);
+    return;
+  }
+
+  epx_owner = NULL;
+
+  if ( ep != &epx )
+  {
+    // bulk slice is done: queue next slice behind other pending transfers unless this is the end of transfer
+    epx_bulk_t *bulk = (epx_bulk_t *) ep;
+    bool const full_slice = (xferred_len == bulk->slice_len);
+    bulk->xferred_len = (uint16_t) (bulk->xferred_len + xferred_len);
+    xferred_len = bulk->xferred_len;
+
+    if ( xfer_result == XFER_RESULT_SUCCESS && full_slice && bulk->xferred_len < bulk->total_len )
+    {
+      bulk->queued = true;
+      epx_schedule();
+      return;
+    }
+  }
+
+  epx_schedule();
   hcd_event_xfer_complete(dev_addr, ep_addr, xferred_len, xfer_result, true);
 }
 
+#if CFG_TUH_ISO_EDPT_MAX
+static iso_edpt_t* iso_edpt_find(struct hw_endpoint const *ep)
+{
+  for ( uint i = 0; i < CFG_TUH_ISO_EDPT_MAX; i++ )
+  {
+    if ( iso_pool[i].ep == ep ) return &iso_pool[i];
+  }
+  return NULL;
+}
+
+// Arm current packet of head transfer, it is sent/received in endpoint's next service interval
+static void __tusb_irq_path_func(iso_packet_start)(iso_edpt_t *iso)
+{
+  iso_xfer_t const * ixfer = &iso->xfer[iso->xfer_head];
+  iso->ep->next_pid = 0; // isochronous is always DATA0
+  hw_endpoint_xfer_start(iso->ep, ixfer->buffer + ixfer->offset, ixfer->packets[ixfer->pkt_idx].len);
+}
+
+static void __tusb_irq_path_func(iso_packet_done)(struct hw_endpoint *ep)
+{
+  uint16_t const actual_len = ep->xferred_len;
+  hw_endpoint_reset_transfer(ep);
+
+  iso_edpt_t *iso = iso_edpt_find(ep);
+  if ( !iso || !iso->xfer_count ) return; // aborted
+
+  iso_xfer_t *ixfer = &iso->xfer[iso->xfer_head];
+  hcd_iso_packet_t *pkt = &ixfer->packets[ixfer->pkt_idx];
+  pkt->actual_len = actual_len;
+  pkt->result = XFER_RESULT_SUCCESS;
+  ixfer->xferred_bytes += actual_len;
+  ixfer->offset += pkt->len;
+  ixfer->pkt_idx++;
+
+  if ( ixfer->pkt_idx == ixfer->n_packets )
+  {
+    iso->xfer_head ^= 1u;
+    iso->xfer_count--;
+    hcd_event_xfer_complete(ep->dev_addr, ep->ep_addr, ixfer->xferred_bytes,
+                            ixfer->failed ? XFER_RESULT_FAILED : XFER_RESULT_SUCCESS, true);
+  }
+
+  if ( iso->xfer_count ) iso_packet_start(iso);
+}
+#endif
+
 static void __tusb_irq_path_func(_handle_buff_status_bit)(uint bit, struct hw_endpoint *ep)
 {
   usb_hw_clear->buf_status = bit;
+#if CFG_TUH_ISO_EDPT_MAX
+  if ( ep->transfer_type == TUSB_XFER_ISOCHRONOUS )
+  {
+    // transfer may have been aborted while packet is in flight
+    if ( ep->active && hw_endpoint_xfer_continue(ep) ) iso_packet_done(ep);
+    return;
+  }
+#endif
   // EP may have been stalled?
   assert(ep->active);
   bool done = hw_endpoint_xfer_continue(ep);
@@ -120,7 +279,7 @@ static void __tusb_irq_path_func(hw_handle_buff_status)(void)
   if ( remaining_buffers & bit )
   {
     remaining_buffers &= ~bit;
-    struct hw_endpoint * ep = &epx;
+    struct hw_endpoint * ep = epx_owner ? epx_owner : &epx;
 
     uint32_t ep_ctrl = *ep->endpoint_control;
     if ( ep_ctrl & EP_CTRL_DOUBLE_BUFFERED_BITS )
@@ -170,7 +329,7 @@ static void __tusb_irq_path_func(hw_trans_complete)(void)
   {
     pico_trace("Sent setup packet\n");
     struct hw_endpoint *ep = &epx;
-    assert(ep->active);
+    assert(ep->active && epx_owner == ep);
     // Set transferred length to 8 for a setup packet
     ep->xferred_len = 8;
     hw_xfer_complete(ep, XFER_RESULT_SUCCESS);
@@ -213,7 +372,7 @@ static void __tusb_irq_path_func(hcd_rp2040_irq)(void)
     pico_trace("Stall REC\n");
     handled |= USB_INTS_STALL_BITS;
     usb_hw_clear->sie_status = USB_SIE_STATUS_STALL_REC_BITS;
-    hw_xfer_complete(&epx, XFER_RESULT_STALLED);
+    hw_xfer_complete(epx_owner ? epx_owner : &epx, XFER_RESULT_STALLED);
   }
 
   if ( status & USB_INTS_BUFF_STATUS_BITS )
@@ -260,10 +419,9 @@ void __tusb_irq_path_func(hcd_int_handler)(uint8_t rhport, bool in_isr) {
 
 static struct hw_endpoint *_next_free_interrupt_ep(void)
 {
-  struct hw_endpoint * ep = NULL;
   for ( uint i = 1; i < TU_ARRAY_SIZE(ep_pool); i++ )
   {
-    ep = &ep_pool[i];
+    struct hw_endpoint * ep = &ep_pool[i];
     if ( !ep->configured )
     {
       // Will be configured by _hw_endpoint_init / _hw_endpoint_allocate
@@ -271,7 +429,30 @@ static struct hw_endpoint *_next_free_interrupt_ep(void)
       return ep;
     }
   }
-  return ep;
+  return NULL;
+}
+
+static uint _free_interrupt_ep_count(void)
+{
+  uint count = 0;
+  for ( uint i = 1; i < TU_ARRAY_SIZE(ep_pool); i++ )
+  {
+    if ( !ep_pool[i].configured ) count++;
+  }
+  return count;
+}
+
+static struct hw_endpoint *_next_free_epx_bulk(void)
+{
+  for ( uint i = 0; i < CFG_TUH_RPI_EPX_BULK_MAX; i++ )
+  {
+    if ( !epx_bulk[i].hw.configured )
+    {
+      memset(&epx_bulk[i], 0, sizeof(epx_bulk_t));
+      return &epx_bulk[i].hw;
+    }
+  }
+  return NULL;
 }
 
 static struct hw_endpoint *_hw_endpoint_allocate(uint8_t transfer_type)
@@ -280,31 +461,70 @@ static struct hw_endpoint *_hw_endpoint_allocate(uint8_t transfer_type)
 
   if ( transfer_type != TUSB_XFER_CONTROL )
   {
-    // Note: even though datasheet name these "Interrupt" endpoints. These are actually
-    // "Asynchronous" endpoints and can be used for other type such as: Bulk  (ISO need confirmation)
-    ep = _next_free_interrupt_ep();
-    pico_info("Allocate %s ep %d\n", tu_edpt_type_str(transfer_type), ep->interrupt_num);
-    assert(ep);
-    ep->buffer_control = &usbh_dpram->int_ep_buffer_ctrl[ep->interrupt_num].ctrl;
-    ep->endpoint_control = &usbh_dpram->int_ep_ctrl[ep->interrupt_num].ctrl;
-    // 0 for epx (double buffered): TODO increase to 1024 for ISO
-    // 2x64 for intep0
-    // 3x64 for intep1
-    // etc
-    ep->hw_data_buf = &usbh_dpram->epx_data[64 * (ep->interrupt_num + 2)];
+    // Hardware interrupt endpoints are polled by controller and go to interrupt/isochronous endpoints first: bulk
+    // endpoint leaves CFG_TUH_RPI_INTEP_PERIODIC_RESERVED of them free and otherwise shares EPX with control endpoint
+    bool const is_bulk = (transfer_type == TUSB_XFER_BULK);
+    if ( is_bulk && _free_interrupt_ep_count() <= CFG_TUH_RPI_INTEP_PERIODIC_RESERVED )
+    {
+      ep = _next_free_epx_bulk();
+    }
+
+    if ( ep == NULL )
+    {
+      // Note: even though datasheet name these "Interrupt" endpoints. These are actually
+      // "Asynchronous" endpoints and can be used for other type such as: Bulk, Isochronous
+      ep = _next_free_interrupt_ep();
+      if ( ep )
+      {
+        pico_info("Allocate %s ep %d\n", tu_edpt_type_str(transfer_type), ep->interrupt_num);
+        ep->buffer_control = &usbh_dpram->int_ep_buffer_ctrl[ep->interrupt_num].ctrl;
+        ep->endpoint_control = &usbh_dpram->int_ep_ctrl[ep->interrupt_num].ctrl;
+        // 0 for epx (double buffered)
+        // 2x64 for intep0
+        // 3x64 for intep1
+        // etc
+        // isochronous endpoint has its larger buffer allocated from top of dpram in hcd_edpt_open()
+        ep->hw_data_buf = &usbh_dpram->epx_data[64 * (ep->interrupt_num + 2)];
+        return ep;
+      }
+
+      if ( is_bulk ) ep = _next_free_epx_bulk();
+      if ( ep == NULL ) return NULL;
+    }
+
+    pico_info("Allocate %s ep on EPX\n", tu_edpt_type_str(transfer_type));
   }
   else
   {
     ep = &epx;
-    ep->buffer_control = &usbh_dpram->epx_buf_ctrl;
-    ep->endpoint_control = &usbh_dpram->epx_ctrl;
-    ep->hw_data_buf = &usbh_dpram->epx_data[0];
   }
 
+  ep->buffer_control = &usbh_dpram->epx_buf_ctrl;
+  ep->endpoint_control = &usbh_dpram->epx_ctrl;
+  ep->hw_data_buf = &usbh_dpram->epx_data[0];
+
   return ep;
 }
 
-static void _hw_endpoint_init(struct hw_endpoint *ep, uint8_t dev_addr, uint8_t ep_addr, uint16_t wMaxPacketSize, uint8_t transfer_type, uint8_t bmInterval)
+// Endpoint control register value with buffer offset
+static uint32_t __tusb_irq_path_func(_hw_endpoint_ctrl_value)(struct hw_endpoint const *ep, uint16_t bmInterval)
+{
+  uint dpram_offset = hw_data_offset(ep->hw_data_buf);
+  // Bits 0-5 should be 0
+  assert(!(dpram_offset & 0b111111));
+
+  uint32_t ep_reg = EP_CTRL_ENABLE_BITS
+                    | EP_CTRL_INTERRUPT_PER_BUFFER
+                    | (ep->transfer_type << EP_CTRL_BUFFER_TYPE_LSB)
+                    | dpram_offset;
+  if ( bmInterval )
+  {
+    ep_reg |= (uint32_t) ((bmInterval - 1) << EP_CTRL_HOST_INTERRUPT_INTERVAL_LSB);
+  }
+  return ep_reg;
+}
+
+static void _hw_endpoint_init(struct hw_endpoint *ep, uint8_t dev_addr, uint8_t ep_addr, uint16_t wMaxPacketSize, uint8_t transfer_type, uint16_t bmInterval)
 {
   // Already has data buffer, endpoint control, and buffer control allocated at this point
   assert(ep->endpoint_control);
@@ -327,25 +547,16 @@ static void _hw_endpoint_init(struct hw_endpoint *ep, uint8_t dev_addr, uint8_t
 
   pico_trace("hw_endpoint_init dev %d ep %02X xfer %d\n", ep->dev_addr, ep->ep_addr, ep->transfer_type);
   pico_trace("dev %d ep %02X setup buffer @ 0x%p\n", ep->dev_addr, ep->ep_addr, ep->hw_data_buf);
-  uint dpram_offset = hw_data_offset(ep->hw_data_buf);
-  // Bits 0-5 should be 0
-  assert(!(dpram_offset & 0b111111));
-
-  // Fill in endpoint control register with buffer offset
-  uint32_t ep_reg = EP_CTRL_ENABLE_BITS
-                    | EP_CTRL_INTERRUPT_PER_BUFFER
-                    | (ep->transfer_type << EP_CTRL_BUFFER_TYPE_LSB)
-                    | dpram_offset;
-  if ( bmInterval )
-  {
-    ep_reg |= (uint32_t) ((bmInterval - 1) << EP_CTRL_HOST_INTERRUPT_INTERVAL_LSB);
-  }
-  *ep->endpoint_control = ep_reg;
-  pico_trace("endpoint control (0x%p) <- 0x%lx\n", ep->endpoint_control, ep_reg);
   ep->configured = true;
 
-  if ( ep != &epx )
+  // EPX is shared: its endpoint control is programmed when a transfer gets it, see epx_xfer_start()
+  if ( !is_epx_user(ep) )
   {
+    // Fill in endpoint control register with buffer offset
+    uint32_t ep_reg = _hw_endpoint_ctrl_value(ep, bmInterval);
+    *ep->endpoint_control = ep_reg;
+    pico_trace("endpoint control (0x%p) <- 0x%lx\n", ep->endpoint_control, ep_reg);
+
     // Endpoint has its own addr_endp and interrupt bits to be setup!
     // This is an interrupt/async endpoint. so need to set up ADDR_ENDP register with:
     // - device address
@@ -372,6 +583,84 @@ static void _hw_endpoint_init(struct hw_endpoint *ep, uint8_t dev_addr, uint8_t
   }
 }
 
+//--------------------------------------------------------------------+
+// EPX Scheduler
+//--------------------------------------------------------------------+
+
+// START_TRANS bit on SIE_CTRL seems to exhibit the same behavior as the AVAILABLE bit
+// described in RP2040 Datasheet, release 2.1, section "4.1.2.5.1. Concurrent access".
+// We write everything except the START_TRANS bit first, then wait some cycles.
+static void __tusb_irq_path_func(epx_sie_start)(uint32_t flags)
+{
+  flags |= SIE_CTRL_BASE | USB_SIE_CTRL_START_TRANS_BITS |
+           (need_pre(epx_owner->dev_addr) ? USB_SIE_CTRL_PREAMBLE_EN_BITS : 0);
+  usb_hw->sie_ctrl = flags & ~USB_SIE_CTRL_START_TRANS_BITS;
+  busy_wait_at_least_cycles(12);
+  usb_hw->sie_ctrl = flags;
+}
+
+// Give EPX to endpoint and start its transfer
+static void __tusb_irq_path_func(epx_xfer_start)(struct hw_endpoint *ep, uint8_t *buffer, uint16_t buflen)
+{
+  epx_owner = ep;
+  usbh_dpram->epx_ctrl = _hw_endpoint_ctrl_value(ep, 0);
+  hw_endpoint_xfer_start(ep, buffer, buflen);
+
+  // That has set up buffer control, endpoint control etc
+  // for host we have to initiate the transfer
+  usb_hw->dev_addr_ctrl = (uint32_t) (ep->dev_addr | (tu_edpt_number(ep->ep_addr) << USB_ADDR_ENDP_ENDPOINT_LSB));
+  epx_sie_start(ep->rx ? USB_SIE_CTRL_RECEIVE_DATA_BITS : USB_SIE_CTRL_SEND_DATA_BITS);
+}
+
+static void __tusb_irq_path_func(epx_setup_start)(void)
+{
+  struct hw_endpoint *ep = &epx;
+  epx_owner = ep;
+  usbh_dpram->epx_ctrl = _hw_endpoint_ctrl_value(ep, 0);
+
+  ep->remaining_len = 8;
+  ep->active = true;
+
+  // Set device address
+  usb_hw->dev_addr_ctrl = ep->dev_addr;
+  epx_sie_start(USB_SIE_CTRL_SEND_SETUP_BITS);
+}
+
+// Start next pending transfer if EPX is idle: control transfer first, then bulk endpoints round-robin one slice
+// at a time. Must be called with interrupt disabled or in interrupt.
+static void __tusb_irq_path_func(epx_schedule)(void)
+{
+  if ( epx_owner ) return;
+
+  if ( epx_ctrl_xfer.queued )
+  {
+    epx_ctrl_xfer.queued = false;
+    if ( epx_ctrl_xfer.setup )
+    {
+      epx_setup_start();
+    }
+    else
+    {
+      epx_xfer_start(&epx, epx_ctrl_xfer.buffer, epx_ctrl_xfer.len);
+    }
+    return;
+  }
+
+  for ( uint i = 0; i < CFG_TUH_RPI_EPX_BULK_MAX; i++ )
+  {
+    uint8_t const idx = (uint8_t) ((epx_bulk_rr + i) % CFG_TUH_RPI_EPX_BULK_MAX);
+    epx_bulk_t *bulk = &epx_bulk[idx];
+    if ( bulk->queued )
+    {
+      bulk->queued = false;
+      bulk->slice_len = tu_min16((uint16_t) (bulk->total_len - bulk->xferred_len), CFG_TUH_RPI_EPX_SLICE_SIZE);
+      epx_bulk_rr = (uint8_t) ((idx + 1) % CFG_TUH_RPI_EPX_BULK_MAX);
+      epx_xfer_start(&bulk->hw, bulk->buffer + bulk->xferred_len, bulk->slice_len);
+      return;
+    }
+  }
+}
+
 //--------------------------------------------------------------------+
 // HCD API
 //--------------------------------------------------------------------+
@@ -394,6 +683,15 @@ bool hcd_init(uint8_t rhport, const tusb_rhport_init_t* rh_init) {
 
   // clear epx and interrupt eps
   memset(&ep_pool, 0, sizeof(ep_pool));
+  memset(&epx_bulk, 0, sizeof(epx_bulk));
+  memset(&epx_ctrl_xfer, 0, sizeof(epx_ctrl_xfer));
+  epx_owner = NULL;
+  epx_bulk_rr = 0;
+
+#if CFG_TUH_ISO_EDPT_MAX
+  memset(&iso_pool, 0, sizeof(iso_pool));
+  iso_dpram_top = sizeof(usbh_dpram->epx_data);
+#endif
 
   // Enable in host mode with SOF / Keep alive on
   usb_hw->main_ctrl = USB_MAIN_CTRL_CONTROLLER_EN_BITS | USB_MAIN_CTRL_HOST_NDEVICE_BITS;
@@ -481,8 +779,44 @@ void hcd_device_close(uint8_t rhport, uint8_t dev_addr)
       *ep->endpoint_control = 0;
       *ep->buffer_control = 0;
       hw_endpoint_reset_transfer(ep);
+
+#if CFG_TUH_ISO_EDPT_MAX
+      iso_edpt_t *iso = iso_edpt_find(ep);
+      if ( iso ) memset(iso, 0, sizeof(iso_edpt_t));
+#endif
     }
   }
+
+  // bulk endpoints on EPX: drop queued transfer, stop the one in progress and give EPX to others
+  hcd_int_disable(rhport);
+  for (size_t i = 0; i < CFG_TUH_RPI_EPX_BULK_MAX; i++)
+  {
+    epx_bulk_t* bulk = &epx_bulk[i];
+    if (bulk->hw.dev_addr == dev_addr && bulk->hw.configured)
+    {
+      bulk->hw.configured = false;
+      bulk->queued = false;
+      if (epx_owner == &bulk->hw)
+      {
+        usb_hw->sie_ctrl = SIE_CTRL_BASE | USB_SIE_CTRL_STOP_TRANS_BITS;
+        usbh_dpram->epx_buf_ctrl = 0;
+        hw_endpoint_reset_transfer(&bulk->hw);
+        epx_owner = NULL;
+      }
+    }
+  }
+  epx_schedule();
+  hcd_int_enable(rhport);
+
+#if CFG_TUH_ISO_EDPT_MAX
+  // reclaim isochronous buffers once all isochronous endpoints are closed
+  bool iso_in_use = false;
+  for ( uint i = 0; i < CFG_TUH_ISO_EDPT_MAX; i++ )
+  {
+    if ( iso_pool[i].ep ) iso_in_use = true;
+  }
+  if ( !iso_in_use ) iso_dpram_top = sizeof(usbh_dpram->epx_data);
+#endif
 }
 
 uint32_t hcd_frame_number(uint8_t rhport)
@@ -516,16 +850,45 @@ bool hcd_edpt_open(uint8_t rhport, uint8_t dev_addr, tusb_desc_endpoint_t const
 
   pico_trace("hcd_edpt_open dev_addr %d, ep_addr %d\n", dev_addr, ep_desc->bEndpointAddress);
 
+  uint16_t interval = ep_desc->bInterval;
+#if CFG_TUH_ISO_EDPT_MAX
+  iso_edpt_t *iso = NULL;
+  if ( ep_desc->bmAttributes.xfer == TUSB_XFER_ISOCHRONOUS )
+  {
+    iso = iso_edpt_find(NULL);
+    TU_ASSERT(iso);
+
+    // data buffer must be 64-byte aligned and stay clear of interrupt endpoints' buffers
+    uint16_t const buf_size = (uint16_t) tu_round_up(tu_edpt_packet_size(ep_desc), 64);
+    TU_ASSERT(iso_dpram_top >= buf_size + 64 * (PICO_USB_HOST_INTERRUPT_ENDPOINTS + 2));
+
+    // interval is 2^(bInterval-1) frames, register field is 10-bit
+    interval = (uint16_t) (1u << (tu_min8(tu_max8(ep_desc->bInterval, 1), 11) - 1));
+  }
+#else
+  TU_VERIFY(ep_desc->bmAttributes.xfer != TUSB_XFER_ISOCHRONOUS);
+#endif
+
   // Allocated differently based on if it's an interrupt endpoint or not
   struct hw_endpoint *ep = _hw_endpoint_allocate(ep_desc->bmAttributes.xfer);
   TU_ASSERT(ep);
 
+#if CFG_TUH_ISO_EDPT_MAX
+  if ( iso )
+  {
+    iso_dpram_top = (uint16_t) (iso_dpram_top - tu_round_up(tu_edpt_packet_size(ep_desc), 64));
+    ep->hw_data_buf = &usbh_dpram->epx_data[iso_dpram_top];
+    memset(iso, 0, sizeof(iso_edpt_t));
+    iso->ep = ep;
+  }
+#endif
+
   _hw_endpoint_init(ep,
                     dev_addr,
                     ep_desc->bEndpointAddress,
                     tu_edpt_packet_size(ep_desc),
                     ep_desc->bmAttributes.xfer,
-                    ep_desc->bInterval);
+                    interval);
 
   return true;
 }
@@ -536,46 +899,46 @@ bool hcd_edpt_xfer(uint8_t rhport, uint8_t dev_addr, uint8_t ep_addr, uint8_t *
 
   pico_trace("hcd_edpt_xfer dev_addr %d, ep_addr 0x%x, len %d\n", dev_addr, ep_addr, buflen);
 
-  uint8_t const ep_num = tu_edpt_number(ep_addr);
-  tusb_dir_t const ep_dir = tu_edpt_dir(ep_addr);
-
   // Get appropriate ep. Either EPX or interrupt endpoint
   struct hw_endpoint *ep = get_dev_ep(dev_addr, ep_addr);
 
   TU_ASSERT(ep);
 
   // EP should be inactive
-  assert(!ep->active);
+  assert(!ep->active && epx_owner != ep);
 
   // Control endpoint can change direction 0x00 <-> 0x80
   if ( ep_addr != ep->ep_addr )
   {
-    assert(ep_num == 0);
+    assert(tu_edpt_number(ep_addr) == 0);
 
     // Direction has flipped on endpoint control so re init it but with same properties
     _hw_endpoint_init(ep, dev_addr, ep_addr, ep->wMaxPacketSize, ep->transfer_type, 0);
   }
 
-  // If a normal transfer (non-interrupt) then initiate using
-  // sie ctrl registers. Otherwise interrupt ep registers should
+  // If a normal transfer (non-interrupt) then queue it for EPX, it is initiated using
+  // sie ctrl registers once EPX is free. Otherwise interrupt ep registers should
   // already be configured
-  if ( ep == &epx )
+  if ( is_epx_user(ep) )
   {
-    hw_endpoint_xfer_start(ep, buffer, buflen);
-
-    // That has set up buffer control, endpoint control etc
-    // for host we have to initiate the transfer
-    usb_hw->dev_addr_ctrl = (uint32_t) (dev_addr | (ep_num << USB_ADDR_ENDP_ENDPOINT_LSB));
-
-    uint32_t flags = USB_SIE_CTRL_START_TRANS_BITS | SIE_CTRL_BASE |
-                     (ep_dir ? USB_SIE_CTRL_RECEIVE_DATA_BITS : USB_SIE_CTRL_SEND_DATA_BITS) |
-                     (need_pre(dev_addr) ? USB_SIE_CTRL_PREAMBLE_EN_BITS : 0);
-    // START_TRANS bit on SIE_CTRL seems to exhibit the same behavior as the AVAILABLE bit
-    // described in RP2040 Datasheet, release 2.1, section "4.1.2.5.1. Concurrent access".
-    // We write everything except the START_TRANS bit first, then wait some cycles.
-    usb_hw->sie_ctrl = flags & ~USB_SIE_CTRL_START_TRANS_BITS;
-    busy_wait_at_least_cycles(12);
-    usb_hw->sie_ctrl = flags;
+    hcd_int_disable(rhport);
+    if ( ep == &epx )
+    {
+      epx_ctrl_xfer.queued = true;
+      epx_ctrl_xfer.setup = false;
+      epx_ctrl_xfer.buffer = buffer;
+      epx_ctrl_xfer.len = buflen;
+    }
+    else
+    {
+      epx_bulk_t *bulk = (epx_bulk_t *) ep;
+      bulk->buffer = buffer;
+      bulk->total_len = buflen;
+      bulk->xferred_len = 0;
+      bulk->queued = true;
+    }
+    epx_schedule();
+    hcd_int_enable(rhport);
   }else
   {
     hw_endpoint_xfer_start(ep, buffer, buflen);
@@ -584,10 +947,77 @@ bool hcd_edpt_xfer(uint8_t rhport, uint8_t dev_addr, uint8_t ep_addr, uint8_t *
   return true;
 }
 
+#if CFG_TUH_ISO_EDPT_MAX
+bool hcd_edpt_iso_xfer(uint8_t rhport, uint8_t dev_addr, uint8_t ep_addr, uint8_t* buffer, hcd_iso_packet_t* packets,
+                       uint16_t n_packets)
+{
+  struct hw_endpoint *ep = get_dev_ep(dev_addr, ep_addr);
+  TU_ASSERT(ep && n_packets);
+  iso_edpt_t *iso = iso_edpt_find(ep);
+  TU_ASSERT(iso);
+
+  for ( uint16_t i = 0; i < n_packets; i++ )
+  {
+    TU_ASSERT(packets[i].len <= ep->wMaxPacketSize);
+    packets[i].actual_len = 0;
+    packets[i].result = XFER_RESULT_INVALID;
+  }
+
+  bool ret = false;
+  hcd_int_disable(rhport);
+  if ( iso->xfer_count < 2 )
+  {
+    iso_xfer_t *ixfer = &iso->xfer[(iso->xfer_head + iso->xfer_count) & 1u];
+    memset(ixfer, 0, sizeof(iso_xfer_t));
+    ixfer->buffer = buffer;
+    ixfer->packets = packets;
+    ixfer->n_packets = n_packets;
+    iso->xfer_count++;
+
+    // queued transfer continues right after the current one
+    if ( iso->xfer_count == 1 ) iso_packet_start(iso);
+    ret = true;
+  }
+  hcd_int_enable(rhport);
+
+  return ret;
+}
+#endif
+
 bool hcd_edpt_abort_xfer(uint8_t rhport, uint8_t dev_addr, uint8_t ep_addr) {
   (void) rhport;
-  (void) dev_addr;
-  (void) ep_addr;
+#if CFG_TUH_ISO_EDPT_MAX
+  struct hw_endpoint *ep = get_dev_ep(dev_addr, ep_addr);
+  iso_edpt_t *iso = ep ? iso_edpt_find(ep) : NULL;
+  if ( iso )
+  {
+    // drop queued transfers and release the armed packet
+    hcd_int_disable(rhport);
+    iso->xfer_count = 0;
+    *ep->buffer_control = 0;
+    hw_endpoint_reset_transfer(ep);
+    hcd_int_enable(rhport);
+    return true;
+  }
+#else
+  struct hw_endpoint *ep = get_dev_ep(dev_addr, ep_addr);
+#endif
+
+  // bulk transfer waiting for EPX can be dropped
+  if ( ep && is_epx_user(ep) && ep != &epx )
+  {
+    epx_bulk_t *bulk = (epx_bulk_t *) ep;
+    bool ret = false;
+    hcd_int_disable(rhport);
+    if ( bulk->queued )
+    {
+      bulk->queued = false;
+      ret = true;
+    }
+    hcd_int_enable(rhport);
+    return ret;
+  }
+
   // TODO not implemented yet
   return false;
 }
@@ -613,22 +1043,12 @@ bool hcd_setup_send(uint8_t rhport, uint8_t dev_addr, uint8_t const setup_packet
   _hw_endpoint_init(ep, dev_addr, 0x00, ep->wMaxPacketSize, 0, 0);
   assert(ep->configured);
 
-  ep->remaining_len = 8;
-  ep->active = true;
-
-  // Set device address
-  usb_hw->dev_addr_ctrl = dev_addr;
-
-  // Set pre if we are a low speed device on full speed hub
-  uint32_t const flags = SIE_CTRL_BASE | USB_SIE_CTRL_SEND_SETUP_BITS | USB_SIE_CTRL_START_TRANS_BITS |
-                         (need_pre(dev_addr) ? USB_SIE_CTRL_PREAMBLE_EN_BITS : 0);
-
-  // START_TRANS bit on SIE_CTRL seems to exhibit the same behavior as the AVAILABLE bit
-  // described in RP2040 Datasheet, release 2.1, section "4.1.2.5.1. Concurrent access".
-  // We write everything except the START_TRANS bit first, then wait some cycles.
-  usb_hw->sie_ctrl = flags & ~USB_SIE_CTRL_START_TRANS_BITS;
-  busy_wait_at_least_cycles(12);
-  usb_hw->sie_ctrl = flags;
+  // Setup is sent once EPX is free, pre is set if we are a low speed device on full speed hub
+  hcd_int_disable(rhport);
+  epx_ctrl_xfer.queued = true;
+  epx_ctrl_xfer.setup = true;
+  epx_schedule();
+  hcd_int_enable(rhport);
 
   return true;
 }
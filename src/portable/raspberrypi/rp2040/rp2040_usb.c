@@ -45,11 +45,21 @@ static void _hw_endpoint_xfer_sync(struct hw_endpoint* ep);
   #define e15_is_critical_frame_period(x) (false)
 #endif
 
+// EP_ABORT is only usable from B2 (Errata RP2040-E2), required to cancel the second buffer of device OUT
+static bool _ep_abort_supported = false;
+
 // if usb hardware is in host mode
 TU_ATTR_ALWAYS_INLINE static inline bool is_host_mode(void) {
   return (usb_hw->main_ctrl & USB_MAIN_CTRL_HOST_NDEVICE_BITS) ? true : false;
 }
 
+// Device bulk OUT is double buffered with an interrupt per buffer: buffers are synced and re-armed in order so that
+// a short packet is seen right away. A packet of the next transfer already landed in the other buffer is kept in
+// DPRAM and carried into the next transfer.
+TU_ATTR_ALWAYS_INLINE static inline bool is_out_double_buffered(struct hw_endpoint* ep) {
+  return ep->rx && !is_host_mode() && ep->transfer_type == TUSB_XFER_BULK && _ep_abort_supported;
+}
+
 //--------------------------------------------------------------------+
 // Implementation
 //--------------------------------------------------------------------+
@@ -83,6 +93,8 @@ void rp2040_usb_init(void) {
   // Mux the controller to the onboard usb phy
   usb_hw->muxing = USB_USB_MUXING_TO_PHY_BITS | USB_USB_MUXING_SOFTCON_BITS;
 
+  _ep_abort_supported = (rp2040_chip_version() >= 2);
+
   TU_LOG2_INT(sizeof(hw_endpoint_t));
 }
 
@@ -91,6 +103,7 @@ void __tusb_irq_path_func(hw_endpoint_reset_transfer)(struct hw_endpoint* ep) {
   ep->remaining_len = 0;
   ep->xferred_len = 0;
   ep->user_buf = 0;
+  ep->out_armed = 0;
 }
 
 void __tusb_irq_path_func(_hw_endpoint_buffer_control_update32)(struct hw_endpoint* ep, uint32_t and_mask,
@@ -158,14 +171,20 @@ void __tusb_irq_path_func(hw_endpoint_start_next_buffer)(struct hw_endpoint* ep)
   // always compute and start with buffer 0
   uint32_t buf_ctrl = prepare_ep_buffer(ep, 0) | USB_BUF_CTRL_SEL;
 
-  // For now: skip double buffered for OUT endpoint in Device mode, since
-  // host could send < 64 bytes and cause short packet on buffer0
+  // Device OUT is only double buffered for bulk with per-buffer interrupt, since host could send < 64 bytes and
+  // cause short packet on buffer0 while buffer1 is already armed (see is_out_double_buffered())
   // NOTE: this could happen to Host mode IN endpoint
   // Also, Host mode "interrupt" endpoint hardware is only single buffered,
   // NOTE2: Currently Host bulk is implemented using "interrupt" endpoint
   bool const is_host = is_host_mode();
-  bool const force_single = (!is_host && !tu_edpt_dir(ep->ep_addr)) ||
-                            (is_host && tu_edpt_number(ep->ep_addr) != 0);
+  bool const out_double = is_out_double_buffered(ep);
+  bool const force_single = (!is_host && !tu_edpt_dir(ep->ep_addr) && !out_double) ||
+                            (is_host && tu_edpt_number(ep->ep_addr) != 0) || ep->single_buffered;
+
+  if (out_double) {
+    ep->out_buf_sel = 0;
+    ep->out_armed = 1;
+  }
 
   if (ep->remaining_len && !force_single) {
     // Use buffer 1 (double buffered) if there is still data
@@ -174,8 +193,14 @@ void __tusb_irq_path_func(hw_endpoint_start_next_buffer)(struct hw_endpoint* ep)
     buf_ctrl |= prepare_ep_buffer(ep, 1);
 
     // Set endpoint control double buffered bit if needed
-    ep_ctrl &= ~EP_CTRL_INTERRUPT_PER_BUFFER;
-    ep_ctrl |= EP_CTRL_DOUBLE_BUFFERED_BITS | EP_CTRL_INTERRUPT_PER_DOUBLE_BUFFER;
+    ep_ctrl &= ~(EP_CTRL_INTERRUPT_PER_BUFFER | EP_CTRL_INTERRUPT_PER_DOUBLE_BUFFER);
+    ep_ctrl |= EP_CTRL_DOUBLE_BUFFERED_BITS;
+    if (out_double) {
+      ep_ctrl |= EP_CTRL_INTERRUPT_PER_BUFFER;
+      ep->out_armed = 2;
+    } else {
+      ep_ctrl |= EP_CTRL_INTERRUPT_PER_DOUBLE_BUFFER;
+    }
   } else {
     // Single buffered since 1 is enough
     ep_ctrl &= ~(EP_CTRL_DOUBLE_BUFFERED_BITS | EP_CTRL_INTERRUPT_PER_DOUBLE_BUFFER);
@@ -191,7 +216,66 @@ void __tusb_irq_path_func(hw_endpoint_start_next_buffer)(struct hw_endpoint* ep)
   _hw_endpoint_buffer_control_set_value32(ep, buf_ctrl);
 }
 
-void hw_endpoint_xfer_start(struct hw_endpoint* ep, uint8_t* buffer, uint16_t total_len) {
+// Arm a single buffer of double-buffered device OUT while the other one may be in use by controller
+static void __tusb_irq_path_func(out_buffer_arm)(struct hw_endpoint* ep, uint8_t buf_id) {
+  io_rw_16* buf_ctrl16 = (io_rw_16*) ep->buffer_control;
+  uint32_t buf_ctrl = prepare_ep_buffer(ep, buf_id);
+  if (buf_id) buf_ctrl = buf_ctrl >> 16;
+
+  // 16-bit access to leave the other buffer untouched, AVAIL is set 12 cycles later as for 32-bit update
+  buf_ctrl16[buf_id] = (uint16_t) (buf_ctrl & ~USB_BUF_CTRL_AVAIL);
+  busy_wait_at_least_cycles(12);
+  buf_ctrl16[buf_id] = (uint16_t) buf_ctrl;
+
+  ep->out_armed++;
+}
+
+// Transfer ended with short packet while the other buffer is still armed: abort it. If the host has already sent
+// a packet into it, this packet belongs to the next transfer and is kept in DPRAM until then.
+static void __tusb_irq_path_func(out_buffer_cancel)(struct hw_endpoint* ep) {
+  io_rw_16* buf_ctrl16 = (io_rw_16*) ep->buffer_control;
+  uint32_t const abort_mask = TU_BIT(2 * tu_edpt_number(ep->ep_addr) + 1);
+
+  usb_hw_set->abort = abort_mask;
+  while ((usb_hw->abort_done & abort_mask) != abort_mask) {}
+
+  if (buf_ctrl16[ep->out_buf_sel] & USB_BUF_CTRL_FULL) {
+    ep->out_carry = true;
+  } else {
+    buf_ctrl16[ep->out_buf_sel] = 0;
+    ep->next_pid ^= 1u; // PID of cancelled buffer is not used
+  }
+  ep->out_armed = 0;
+
+  // buffer status of the carried packet is handled when next transfer starts
+  usb_hw_clear->buf_status = abort_mask;
+  usb_hw_clear->abort_done = abort_mask;
+  usb_hw_clear->abort = abort_mask;
+}
+
+// Copy packet carried from previous transfer, return true if transfer is complete
+static bool out_carry_consume(struct hw_endpoint* ep) {
+  io_rw_16* buf_ctrl16 = (io_rw_16*) ep->buffer_control;
+  uint8_t const buf_id = ep->out_buf_sel;
+  uint16_t const len = (uint16_t) (buf_ctrl16[buf_id] & USB_BUF_CTRL_LEN_MASK);
+  uint16_t const copy_len = tu_min16(len, ep->remaining_len);
+
+  if (copy_len < len) {
+    TU_LOG(1, "WARN: ep %02X buffer too small for carried packet, %u bytes dropped\r\n", ep->ep_addr, len - copy_len);
+  }
+
+  unaligned_memcpy(ep->user_buf, ep->hw_data_buf + buf_id * 64, copy_len);
+  ep->user_buf += copy_len;
+  ep->xferred_len = copy_len;
+  ep->remaining_len = (uint16_t) (ep->remaining_len - copy_len);
+
+  buf_ctrl16[buf_id] = 0;
+  ep->out_carry = false;
+
+  return (len < ep->wMaxPacketSize) || (ep->remaining_len == 0);
+}
+
+bool hw_endpoint_xfer_start(struct hw_endpoint* ep, uint8_t* buffer, uint16_t total_len) {
   hw_endpoint_lock_update(ep, 1);
 
   if (ep->active) {
@@ -206,6 +290,11 @@ void hw_endpoint_xfer_start(struct hw_endpoint* ep, uint8_t* buffer, uint16_t to
   ep->active = true;
   ep->user_buf = buffer;
 
+  if (ep->out_carry && out_carry_consume(ep)) {
+    hw_endpoint_lock_update(ep, -1);
+    return true;
+  }
+
   if (e15_is_bulkin_ep(ep)) {
     usb_hw_set->inte = USB_INTS_DEV_SOF_BITS;
   }
@@ -217,6 +306,7 @@ void hw_endpoint_xfer_start(struct hw_endpoint* ep, uint8_t* buffer, uint16_t to
   }
 
   hw_endpoint_lock_update(ep, -1);
+  return false;
 }
 
 // sync endpoint buffer and return transferred bytes
@@ -252,10 +342,40 @@ static uint16_t __tusb_irq_path_func(sync_ep_buffer)(struct hw_endpoint* ep, uin
   return xferred_bytes;
 }
 
+// Sync completed buffers of double-buffered device OUT in order, re-arm them while there is still data to receive
+static void __tusb_irq_path_func(out_double_buffered_sync)(struct hw_endpoint* ep) {
+  io_rw_16 const* buf_ctrl16 = (io_rw_16 const*) ep->buffer_control;
+
+  while (ep->out_armed && (buf_ctrl16[ep->out_buf_sel] & USB_BUF_CTRL_FULL)) {
+    uint8_t const buf_id = ep->out_buf_sel;
+    uint16_t const xferred_bytes = sync_ep_buffer(ep, buf_id);
+
+    ((io_rw_16*) ep->buffer_control)[buf_id] = 0;
+    ep->out_buf_sel ^= 1u;
+    ep->out_armed--;
+
+    if (xferred_bytes < ep->wMaxPacketSize) {
+      if (ep->out_armed) {
+        out_buffer_cancel(ep);
+      }
+      break;
+    }
+
+    if (ep->remaining_len) {
+      out_buffer_arm(ep, buf_id);
+    }
+  }
+}
+
 static void __tusb_irq_path_func(_hw_endpoint_xfer_sync)(struct hw_endpoint* ep) {
   // Update hw endpoint struct with info from hardware
   // after a buff status interrupt
 
+  if (ep->out_armed) {
+    out_double_buffered_sync(ep);
+    return;
+  }
+
   uint32_t __unused buf_ctrl = _hw_endpoint_buffer_control_get_value32(ep);
   TU_LOG(3, "  Sync BufCtrl: [0] = 0x%04x  [1] = 0x%04x\r\n", tu_u32_low16(buf_ctrl), tu_u32_high16(buf_ctrl));
 
@@ -269,9 +389,8 @@ static void __tusb_irq_path_func(_hw_endpoint_xfer_sync)(struct hw_endpoint* ep)
       sync_ep_buffer(ep, 1);
     } else {
       // short packet on buffer 0
-      // TODO couldn't figure out how to handle this case which happen with net_lwip_webserver example
       // At this time (currently trigger per 2 buffer), the buffer1 is probably filled with data from
-      // the next transfer (not current one). For now we disable double buffered for device OUT
+      // the next transfer (not current one). Device OUT is handled by out_double_buffered_sync() instead
       // NOTE this could happen to Host IN
 #if 0
       uint8_t const ep_num = tu_edpt_number(ep->ep_addr);
@@ -312,11 +431,13 @@ bool __tusb_irq_path_func(hw_endpoint_xfer_continue)(struct hw_endpoint* ep) {
 
   // Now we have synced our state with the hardware. Is there more data to transfer?
   // If we are done then notify tinyusb
-  if (ep->remaining_len == 0) {
+  if (ep->remaining_len == 0 && ep->out_armed == 0) {
     pico_trace("Completed transfer of %d bytes on ep %02X\r\n", ep->xferred_len, ep->ep_addr);
     // Notify caller we are done so it can notify the tinyusb stack
     hw_endpoint_lock_update(ep, -1);
     return true;
+  } else if (ep->out_armed) {
+    // double-buffered device OUT is re-armed per buffer while syncing
   } else {
     if (e15_is_critical_frame_period(ep)) {
       ep->pending = 1;
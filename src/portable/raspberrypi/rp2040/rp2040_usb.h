@@ -83,6 +83,15 @@ typedef struct hw_endpoint
     // Transfer scheduled but not active
     uint8_t pending;
 
+    // Buffer memory only fits one packet, double buffering is not used
+    bool single_buffered;
+
+    // Device double-buffered OUT: buffer to complete next, number of armed buffers and whether buffer out_buf_sel
+    // holds a packet received for the next transfer
+    uint8_t out_buf_sel;
+    uint8_t out_armed;
+    bool out_carry;
+
 #if CFG_TUH_ENABLED
     // Only needed for host
     uint8_t dev_addr;
@@ -99,7 +108,8 @@ extern volatile uint32_t e15_last_sof;
 
 void rp2040_usb_init(void);
 
-void hw_endpoint_xfer_start(struct hw_endpoint *ep, uint8_t *buffer, uint16_t total_len);
+// Return true if transfer is already complete with packet carried from previous transfer (device OUT only)
+bool hw_endpoint_xfer_start(struct hw_endpoint *ep, uint8_t *buffer, uint16_t total_len);
 bool hw_endpoint_xfer_continue(struct hw_endpoint *ep);
 void hw_endpoint_reset_transfer(struct hw_endpoint *ep);
 void hw_endpoint_start_next_buffer(struct hw_endpoint *ep);
@@ -164,17 +164,34 @@ static inline void pipe_wait_for_ready(rusb2_reg_t * rusb, unsigned num) {
 // Pipe FIFO
 //--------------------------------------------------------------------+
 
+// Access width of pipe 1-9 FIFO port: 32-bit for highspeed, 16-bit for fullspeed
+static inline uint16_t pipe_fifo_mbw(rusb2_reg_t * rusb) {
+  return rusb2_is_highspeed_reg(rusb) ? RUSB2_FIFOSEL_MBW_32BIT : RUSB2_FIFOSEL_MBW_16BIT;
+}
+
 // Write data buffer --> hw fifo
-static void pipe_write_packet(rusb2_reg_t * rusb, void *buf, volatile void *fifo, unsigned len)
+// Access width is selected by MBW of fifosel, for 32-bit the remaining bytes are written with 16-bit width.
+static void pipe_write_packet(rusb2_reg_t * rusb, void *buf, volatile void *fifo, volatile uint16_t *fifosel,
+                              unsigned len)
 {
-  (void) rusb;
+  uint8_t const* buf8 = (uint8_t const*) buf;
+
+  if ((*fifosel & RUSB2_CFIFOSEL_MBW_Msk) == RUSB2_FIFOSEL_MBW_32BIT) {
+    volatile uint32_t *ff32 = (volatile uint32_t*) fifo;
+    while (len >= 4) {
+      *ff32 = tu_unaligned_read32(buf8);
+      buf8 += 4;
+      len  -= 4;
+    }
+    if (!len) return;
+    *fifosel = (uint16_t) ((*fifosel & ~RUSB2_CFIFOSEL_MBW_Msk) | RUSB2_FIFOSEL_MBW_16BIT);
+  }
 
   volatile uint16_t *ff16;
   volatile uint8_t *ff8;
 
-  // Highspeed FIFO is 32-bit
+  // Highspeed FIFO is 32-bit, narrower access is at the upper bytes
   if ( rusb2_is_highspeed_reg(rusb) ) {
-    // TODO 32-bit access for better performance
     ff16 = (volatile uint16_t*) ((uintptr_t) fifo+2);
     ff8  = (volatile uint8_t *) ((uintptr_t) fifo+3);
   }else {
@@ -182,8 +199,6 @@ static void pipe_write_packet(rusb2_reg_t * rusb, void *buf, volatile void *fifo
     ff8  = ((volatile uint8_t*) fifo);
   }
 
-  uint8_t const* buf8 = (uint8_t const*) buf;
-
   while (len >= 2) {
     *ff16 = tu_unaligned_read16(buf8);
     buf8 += 2;
@@ -197,29 +212,24 @@ static void pipe_write_packet(rusb2_reg_t * rusb, void *buf, volatile void *fifo
 }
 
 // Read data buffer <-- hw fifo
-static void pipe_read_packet(rusb2_reg_t * rusb, void *buf, volatile void *fifo, unsigned len)
+static void pipe_read_packet(void *buf, volatile void *fifo, volatile uint16_t *fifosel, unsigned len)
 {
-  (void) rusb;
-
-  // TODO 16/32-bit access for better performance
-
-  uint8_t *p = (uint8_t*)buf;
-  volatile uint8_t *reg = (volatile uint8_t*)fifo;  /* byte access is always at base register address */
-  while (len--) *p++ = *reg;
+  rusb2_fifo_read(buf, fifo, *fifosel & RUSB2_CFIFOSEL_MBW_Msk, len);
 }
 
 // Write data sw fifo --> hw fifo
-static void pipe_write_packet_ff(rusb2_reg_t * rusb, tu_fifo_t *f, volatile void *fifo, uint16_t total_len) {
+static void pipe_write_packet_ff(rusb2_reg_t * rusb, tu_fifo_t *f, volatile void *fifo, volatile uint16_t *fifosel,
+                                 uint16_t total_len) {
   tu_fifo_buffer_info_t info;
   tu_fifo_get_read_info(f, &info);
 
   uint16_t count = tu_min16(total_len, info.len_lin);
-  pipe_write_packet(rusb, info.ptr_lin, fifo, count);
+  pipe_write_packet(rusb, info.ptr_lin, fifo, fifosel, count);
 
   uint16_t rem = total_len - count;
   if (rem) {
     rem = tu_min16(rem, info.len_wrap);
-    pipe_write_packet(rusb, info.ptr_wrap, fifo, rem);
+    pipe_write_packet(rusb, info.ptr_wrap, fifo, fifosel, rem);
     count += rem;
   }
 
@@ -227,17 +237,18 @@ static void pipe_write_packet_ff(rusb2_reg_t * rusb, tu_fifo_t *f, volatile void
 }
 
 // Read data sw fifo <-- hw fifo
-static void pipe_read_packet_ff(rusb2_reg_t * rusb, tu_fifo_t *f, volatile void *fifo, uint16_t total_len) {
+// Caller selects 8-bit access since the linear part may end in the middle of a FIFO word
+static void pipe_read_packet_ff(tu_fifo_t *f, volatile void *fifo, volatile uint16_t *fifosel, uint16_t total_len) {
   tu_fifo_buffer_info_t info;
   tu_fifo_get_write_info(f, &info);
 
   uint16_t count = tu_min16(total_len, info.len_lin);
-  pipe_read_packet(rusb, info.ptr_lin, fifo, count);
+  pipe_read_packet(info.ptr_lin, fifo, fifosel, count);
 
   uint16_t rem = total_len - count;
   if (rem) {
     rem = tu_min16(rem, info.len_wrap);
-    pipe_read_packet(rusb, info.ptr_wrap, fifo, rem);
+    pipe_read_packet(info.ptr_wrap, fifo, fifosel, rem);
     count += rem;
   }
 
@@ -264,9 +275,9 @@ static bool pipe0_xfer_in(rusb2_reg_t* rusb)
 
   if (len) {
     if (pipe->ff) {
-      pipe_write_packet_ff(rusb, (tu_fifo_t*)buf, (volatile void*)&rusb->CFIFO, len);
+      pipe_write_packet_ff(rusb, (tu_fifo_t*)buf, (volatile void*)&rusb->CFIFO, &rusb->CFIFOSEL, len);
     } else {
-      pipe_write_packet(rusb, buf, (volatile void*)&rusb->CFIFO, len);
+      pipe_write_packet(rusb, buf, (volatile void*)&rusb->CFIFO, &rusb->CFIFOSEL, len);
       pipe->buf = (uint8_t*)buf + len;
     }
   }
@@ -291,9 +302,9 @@ static bool pipe0_xfer_out(rusb2_reg_t* rusb)
 
   if (len) {
     if (pipe->ff) {
-      pipe_read_packet_ff(rusb, (tu_fifo_t*)buf, (volatile void*)&rusb->CFIFO, len);
+      pipe_read_packet_ff((tu_fifo_t*)buf, (volatile void*)&rusb->CFIFO, &rusb->CFIFOSEL, len);
     } else {
-      pipe_read_packet(rusb, buf, (volatile void*)&rusb->CFIFO, len);
+      pipe_read_packet(buf, (volatile void*)&rusb->CFIFO, &rusb->CFIFOSEL, len);
       pipe->buf = (uint8_t*)buf + len;
     }
   }
@@ -321,7 +332,7 @@ static bool pipe_xfer_in(rusb2_reg_t* rusb, unsigned num)
     return true;
   }
 
-  rusb->D0FIFOSEL = num | RUSB2_FIFOSEL_MBW_16BIT | (TU_BYTE_ORDER == TU_BIG_ENDIAN ? RUSB2_FIFOSEL_BIGEND : 0);
+  rusb->D0FIFOSEL = num | pipe_fifo_mbw(rusb) | (TU_BYTE_ORDER == TU_BIG_ENDIAN ? RUSB2_FIFOSEL_BIGEND : 0);
   const uint16_t mps  = edpt_max_packet_size(rusb, num);
   pipe_wait_for_ready(rusb, num);
   const uint16_t len  = tu_min16(rem, mps);
@@ -329,9 +340,9 @@ static bool pipe_xfer_in(rusb2_reg_t* rusb, unsigned num)
 
   if (len) {
     if (pipe->ff) {
-      pipe_write_packet_ff(rusb, (tu_fifo_t*)buf, (volatile void*)&rusb->D0FIFO, len);
+      pipe_write_packet_ff(rusb, (tu_fifo_t*)buf, (volatile void*)&rusb->D0FIFO, &rusb->D0FIFOSEL, len);
     } else {
-      pipe_write_packet(rusb, buf, (volatile void*)&rusb->D0FIFO, len);
+      pipe_write_packet(rusb, buf, (volatile void*)&rusb->D0FIFO, &rusb->D0FIFOSEL, len);
       pipe->buf = (uint8_t*)buf + len;
     }
   }
@@ -353,7 +364,8 @@ static bool pipe_xfer_out(rusb2_reg_t* rusb, unsigned num)
   pipe_state_t  *pipe = &_dcd.pipe[num];
   const uint16_t rem  = pipe->remaining;
 
-  rusb->D0FIFOSEL = num | RUSB2_FIFOSEL_MBW_8BIT;
+  rusb->D0FIFOSEL = num | (pipe->ff ? RUSB2_FIFOSEL_MBW_8BIT : pipe_fifo_mbw(rusb)) |
+                    (TU_BYTE_ORDER == TU_BIG_ENDIAN ? RUSB2_FIFOSEL_BIGEND : 0);
   const uint16_t mps = edpt_max_packet_size(rusb, num);
   pipe_wait_for_ready(rusb, num);
 
@@ -363,9 +375,9 @@ static bool pipe_xfer_out(rusb2_reg_t* rusb, unsigned num)
 
   if (len) {
     if (pipe->ff) {
-      pipe_read_packet_ff(rusb, (tu_fifo_t*)buf, (volatile void*)&rusb->D0FIFO, len);
+      pipe_read_packet_ff((tu_fifo_t*)buf, (volatile void*)&rusb->D0FIFO, &rusb->D0FIFOSEL, len);
     } else {
-      pipe_read_packet(rusb, buf, (volatile void*)&rusb->D0FIFO, len);
+      pipe_read_packet(buf, (volatile void*)&rusb->D0FIFO, &rusb->D0FIFOSEL, len);
       pipe->buf = (uint8_t*)buf + len;
     }
   }
@@ -796,12 +808,6 @@ bool dcd_edpt_open(uint8_t rhport, tusb_desc_endpoint_t const * ep_desc)
   /* setup pipe */
   dcd_int_disable(rhport);
 
-  if ( rusb2_is_highspeed_rhport(rhport) ) {
-    // FIXME shouldn't be after pipe selection and config, also the BUFNMB should be changed
-    //       depending on the allocation scheme
-    rusb->PIPEBUF = 0x7C08;
-  }
-
   rusb->PIPESEL = num;
   rusb->PIPEMAXP = mps;
   volatile uint16_t *ctr = get_pipectr(rusb, num);
@@ -817,6 +823,11 @@ bool dcd_edpt_open(uint8_t rhport, tusb_desc_endpoint_t const * ep_desc)
     cfg |= (RUSB2_PIPECFG_TYPE_ISO | RUSB2_PIPECFG_DBLB_Msk);
   }
 
+  // Highspeed controller has configurable buffer for pipe 1-5, give each pipe its own double buffer
+  if ( rusb2_is_highspeed_rhport(rhport) && num <= 5 ) {
+    rusb->PIPEBUF = rusb2_pipebuf_value(num, mps, cfg & RUSB2_PIPECFG_DBLB_Msk);
+  }
+
   rusb->PIPECFG = cfg;
   rusb->BRDYSTS = 0x3FFu ^ TU_BIT(num);
   rusb->BRDYENB |= TU_BIT(num);
@@ -165,11 +165,29 @@ static inline void pipe_wait_for_ready(rusb2_reg_t* rusb, unsigned num)
   while (!rusb->D0FIFOCTR_b.FRDY) {}
 }
 
-static void pipe_write_packet(void *buf, volatile void *fifo, unsigned len)
+// Access width of pipe 1-9 FIFO port: 32-bit for highspeed, 16-bit for fullspeed
+static inline uint16_t pipe_fifo_mbw(rusb2_reg_t* rusb)
 {
+  return rusb2_is_highspeed_reg(rusb) ? RUSB2_FIFOSEL_MBW_32BIT : RUSB2_FIFOSEL_MBW_16BIT;
+}
+
+// Access width is selected by MBW of fifosel, for 32-bit the remaining bytes are written with 16-bit width.
+static void pipe_write_packet(void *buf, volatile void *fifo, volatile uint16_t *fifosel, unsigned len)
+{
+  uintptr_t addr = (uintptr_t)buf;
+  if ((*fifosel & RUSB2_CFIFOSEL_MBW_Msk) == RUSB2_FIFOSEL_MBW_32BIT) {
+    volatile uint32_t *ff32 = (volatile uint32_t*)fifo;
+    while (len >= 4) {
+      *ff32 = tu_unaligned_read32((const void*)addr);
+      addr += 4;
+      len  -= 4;
+    }
+    if (!len) return;
+    *fifosel = (uint16_t)((*fifosel & ~RUSB2_CFIFOSEL_MBW_Msk) | RUSB2_FIFOSEL_MBW_16BIT);
+  }
+
   // NOTE: unlike DCD, Highspeed 32-bit FIFO does not need to adjust the fifo address
   volatile hw_fifo_t *reg = (volatile hw_fifo_t*)fifo;
-  uintptr_t addr = (uintptr_t)buf;
   while (len >= 2) {
     reg->u16 = *(const uint16_t *)addr;
     addr += 2;
@@ -181,11 +199,9 @@ static void pipe_write_packet(void *buf, volatile void *fifo, unsigned len)
   }
 }
 
-static void pipe_read_packet(void *buf, volatile void *fifo, unsigned len)
+static void pipe_read_packet(void *buf, volatile void *fifo, volatile uint16_t *fifosel, unsigned len)
 {
-  uint8_t *p   = (uint8_t*)buf;
-  volatile uint8_t *reg = (volatile uint8_t*)fifo;  /* byte access is always at base register address */
-  while (len--) *p++ = *reg;
+  rusb2_fifo_read(buf, fifo, *fifosel & RUSB2_CFIFOSEL_MBW_Msk, len);
 }
 
 static bool pipe0_xfer_in(rusb2_reg_t* rusb)
@@ -199,7 +215,7 @@ static bool pipe0_xfer_in(rusb2_reg_t* rusb)
   void          *buf = pipe->buf;
   if (len) {
     rusb->DCPCTR = RUSB2_PIPE_CTR_PID_NAK;
-    pipe_read_packet(buf, (volatile void*)&rusb->CFIFO, len);
+    pipe_read_packet(buf, (volatile void*)&rusb->CFIFO, &rusb->CFIFOSEL, len);
     pipe->buf = (uint8_t*)buf + len;
   }
   if (len < mps) {
@@ -226,7 +242,7 @@ static bool pipe0_xfer_out(rusb2_reg_t* rusb)
   const unsigned len = TU_MIN(mps, rem);
   void          *buf = pipe->buf;
   if (len) {
-    pipe_write_packet(buf, (volatile void*)&rusb->CFIFO, len);
+    pipe_write_packet(buf, (volatile void*)&rusb->CFIFO, &rusb->CFIFOSEL, len);
     pipe->buf = (uint8_t*)buf + len;
   }
   if (len < mps) {
@@ -241,14 +257,14 @@ static bool pipe_xfer_in(rusb2_reg_t* rusb, unsigned num)
   pipe_state_t  *pipe = &_hcd.pipe[num];
   const unsigned rem  = pipe->remaining;
 
-  rusb->D0FIFOSEL = num | RUSB2_FIFOSEL_MBW_8BIT;
+  rusb->D0FIFOSEL = num | pipe_fifo_mbw(rusb) | (TU_BYTE_ORDER == TU_BIG_ENDIAN ? RUSB2_FIFOSEL_BIGEND : 0);
   const unsigned mps  = edpt_max_packet_size(rusb, num);
   pipe_wait_for_ready(rusb, num);
   const unsigned vld  = rusb->D0FIFOCTR_b.DTLN;
   const unsigned len  = TU_MIN(TU_MIN(rem, mps), vld);
   void          *buf  = pipe->buf;
   if (len) {
-    pipe_read_packet(buf, (volatile void*)&rusb->D0FIFO, len);
+    pipe_read_packet(buf, (volatile void*)&rusb->D0FIFO, &rusb->D0FIFOSEL, len);
     pipe->buf = (uint8_t*)buf + len;
   }
   if (len < mps) {
@@ -274,13 +290,13 @@ static bool pipe_xfer_out(rusb2_reg_t* rusb, unsigned num)
     return true;
   }
 
-  rusb->D0FIFOSEL = num | RUSB2_FIFOSEL_MBW_16BIT | (TU_BYTE_ORDER == TU_BIG_ENDIAN ? RUSB2_FIFOSEL_BIGEND : 0);
+  rusb->D0FIFOSEL = num | pipe_fifo_mbw(rusb) | (TU_BYTE_ORDER == TU_BIG_ENDIAN ? RUSB2_FIFOSEL_BIGEND : 0);
   const unsigned mps  = edpt_max_packet_size(rusb, num);
   pipe_wait_for_ready(rusb, num);
   const unsigned len  = TU_MIN(rem, mps);
   void          *buf  = pipe->buf;
   if (len) {
-    pipe_write_packet(buf, (volatile void*)&rusb->D0FIFO, len);
+    pipe_write_packet(buf, (volatile void*)&rusb->D0FIFO, &rusb->D0FIFOSEL, len);
     pipe->buf = (uint8_t*)buf + len;
   }
   if (len < mps) {
@@ -704,6 +720,11 @@ bool hcd_edpt_open(uint8_t rhport, uint8_t dev_addr, tusb_desc_endpoint_t const
     cfg |= RUSB2_PIPECFG_TYPE_ISO | RUSB2_PIPECFG_DBLB_Msk;
   }
 
+  // Highspeed controller has configurable buffer for pipe 1-5, give each pipe its own double buffer
+  if (rusb2_is_highspeed_rhport(rhport) && num <= 5) {
+    rusb->PIPEBUF = rusb2_pipebuf_value(num, mps, cfg & RUSB2_PIPECFG_DBLB_Msk);
+  }
+
   rusb->PIPECFG = cfg;
   rusb->BRDYSTS = 0x3FFu ^ TU_BIT(num);
   rusb->NRDYENB |= TU_BIT(num);
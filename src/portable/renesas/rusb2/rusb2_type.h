@@ -29,6 +29,7 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <string.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -1701,6 +1702,46 @@ TU_ATTR_BIT_FIELD_ORDER_END
 #define RUSB2_PIPECFG_TYPE_INT          (2U << RUSB2_PIPECFG_TYPE_Pos)
 #define RUSB2_PIPECFG_TYPE_ISO          (3U << RUSB2_PIPECFG_TYPE_Pos)
 
+//--------------------------------------------------------------------+
+// Helper
+//--------------------------------------------------------------------+
+
+// PIPEBUF value of pipe 1-5 for high-speed controller. Buffer 0-3 is used by DCP and 4-7 by pipe 6-9, then each pipe
+// has its own region big enough for double buffered 1024 bytes (pipe 1-2) or 512 bytes (pipe 3-5) packets.
+static inline uint16_t rusb2_pipebuf_value(unsigned num, unsigned mps, unsigned dblb) {
+  static const uint8_t bufnmb[5] = { 8, 40, 72, 88, 104 };
+  const unsigned blocks = ((mps + 63) / 64) << (dblb ? 1 : 0);
+  return (uint16_t) (((blocks - 1) << RUSB2_PIPEBUF_BUFSIZE_Pos) | bufnmb[num - 1]);
+}
+
+// Read len bytes from FIFO port whose FIFOSEL.MBW is mbw. For 16/32-bit access, the last partial word is read as a
+// whole and its extra bytes are discarded, BIGEND must be set on big endian MCU.
+static inline void rusb2_fifo_read(void *buf, volatile void *fifo, unsigned mbw, unsigned len) {
+  uint8_t *p = (uint8_t*) buf;
+  if (mbw == RUSB2_FIFOSEL_MBW_32BIT) {
+    volatile uint32_t *ff32 = (volatile uint32_t*) fifo;
+    while (len) {
+      const uint32_t tmp = *ff32;
+      const unsigned n = (len < 4) ? len : 4;
+      memcpy(p, &tmp, n);
+      p   += n;
+      len -= n;
+    }
+  } else if (mbw == RUSB2_FIFOSEL_MBW_16BIT) {
+    volatile uint16_t *ff16 = (volatile uint16_t*) fifo;
+    while (len) {
+      const uint16_t tmp = *ff16;
+      const unsigned n = (len < 2) ? len : 2;
+      memcpy(p, &tmp, n);
+      p   += n;
+      len -= n;
+    }
+  } else {
+    volatile uint8_t *ff8 = (volatile uint8_t*) fifo;  /* byte access is always at base register address */
+    while (len--) *p++ = *ff8;
+  }
+}
+
 //--------------------------------------------------------------------+
 // Static Assert
 //--------------------------------------------------------------------+
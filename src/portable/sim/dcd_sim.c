@@ -0,0 +1,568 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#include "tusb_option.h"
+
+#if CFG_TUD_ENABLED && CFG_TUSB_MCU == OPT_MCU_SIM
+
+#include "device/dcd.h"
+#include "dcd_sim.h"
+
+//--------------------------------------------------------------------+
+// MACRO TYPEDEF CONSTANT ENUM DECLARATION
+//--------------------------------------------------------------------+
+
+// bit time in picoseconds
+#define SIM_BIT_PS_FS       83333u
+#define SIM_BIT_PS_HS       2083u
+
+#define SIM_FRAME_PS_FS     1000000000ull
+#define SIM_FRAME_PS_HS     125000000ull
+
+// protocol overhead per transaction in bytes (token, data packet framing, handshake, inter-packet delay)
+// USB 2.0 section 5.8.4 bulk transaction: 13 bytes for fullspeed, 55 bytes for highspeed
+#define SIM_XACT_OVERHEAD_FS  13u
+#define SIM_XACT_OVERHEAD_HS  55u
+
+typedef struct {
+  uint8_t* buffer;
+  uint16_t total_len;
+  uint16_t actual_len;
+  uint16_t mps;
+  uint8_t xfer_type;
+  bool opened;
+  bool active;
+  bool stalled;
+} sim_edpt_t;
+
+// host-side data of an endpoint: OUT data queued by host, or IN data received by host
+typedef struct {
+  uint8_t data[CFG_DCD_SIM_HOST_BUFSIZE];
+  uint32_t count;
+} sim_pipe_t;
+
+typedef enum {
+  CTRL_IDLE = 0,
+  CTRL_SETUP,
+  CTRL_DATA_IN,
+  CTRL_DATA_OUT,
+  CTRL_STATUS_IN,
+  CTRL_STATUS_OUT,
+  CTRL_DONE,
+  CTRL_STALLED,
+} sim_ctrl_state_t;
+
+typedef enum {
+  XACT_NONE = 0, // nothing to do
+  XACT_NAK,
+  XACT_DATA,
+} sim_xact_t;
+
+typedef struct {
+  tusb_speed_t speed;
+  bool connected;
+  bool sof_en;
+  bool int_en;
+  uint8_t dev_addr;
+
+  uint16_t frame_num;
+  uint8_t microframe;
+  uint64_t budget_ps; // remaining time in current (micro)frame
+
+  void (*task_hook)(void);
+  dcd_sim_stats_t stats;
+
+  struct {
+    TU_ATTR_ALIGNED(4) tusb_control_request_t request;
+    uint8_t* buffer;
+    uint16_t xferred;
+    sim_ctrl_state_t state;
+  } ctrl;
+
+  sim_edpt_t edpt[TUP_DCD_ENDPOINT_MAX][2];
+} sim_dcd_t;
+
+static sim_dcd_t _sim;
+static sim_pipe_t _sim_pipe[TUP_DCD_ENDPOINT_MAX][2];
+
+//--------------------------------------------------------------------+
+// Bus model
+//--------------------------------------------------------------------+
+
+TU_ATTR_ALWAYS_INLINE static inline bool is_highspeed(void) {
+  return _sim.speed == TUSB_SPEED_HIGH;
+}
+
+// consume bus time of a transaction with len bytes payload, false if it does not fit into current frame
+static bool bus_consume(uint16_t len) {
+  uint32_t const overhead = is_highspeed() ? SIM_XACT_OVERHEAD_HS : SIM_XACT_OVERHEAD_FS;
+  uint32_t const bit_ps = is_highspeed() ? SIM_BIT_PS_HS : SIM_BIT_PS_FS;
+  uint64_t const cost = (uint64_t) (overhead + len) * 8u * bit_ps;
+  if (cost > _sim.budget_ps) {
+    return false;
+  }
+  _sim.budget_ps -= cost;
+  return true;
+}
+
+static void signal_event(void) {
+  if (_sim.task_hook) {
+    _sim.task_hook();
+  }
+}
+
+static void xfer_complete(uint8_t ep_addr) {
+  sim_edpt_t* ep = &_sim.edpt[tu_edpt_number(ep_addr)][tu_edpt_dir(ep_addr)];
+  ep->active = false;
+  dcd_event_xfer_complete(0, ep_addr, ep->actual_len, XFER_RESULT_SUCCESS, true);
+  signal_event();
+}
+
+// Device side of a data packet: copy between endpoint buffer and data, return true if transfer is complete
+static bool edpt_packet(uint8_t ep_addr, uint8_t* data, uint16_t len) {
+  sim_edpt_t* ep = &_sim.edpt[tu_edpt_number(ep_addr)][tu_edpt_dir(ep_addr)];
+  if (ep->buffer && data && len) {
+    if (tu_edpt_dir(ep_addr) == TUSB_DIR_IN) {
+      memcpy(data, ep->buffer + ep->actual_len, len);
+    } else {
+      memcpy(ep->buffer + ep->actual_len, data, len);
+    }
+  }
+  ep->actual_len = (uint16_t) (ep->actual_len + len);
+  _sim.stats.transactions++;
+  if (tu_edpt_dir(ep_addr) == TUSB_DIR_IN) {
+    _sim.stats.bytes_in += len;
+  } else {
+    _sim.stats.bytes_out += len;
+  }
+  return (len < ep->mps) || (ep->actual_len == ep->total_len);
+}
+
+// NAK or STALL handshake, return true if it fits into current frame
+static bool edpt_handshake(sim_edpt_t const* ep) {
+  if (!bus_consume(0)) {
+    return false;
+  }
+  if (ep->stalled) {
+    _sim.stats.stalls++;
+  } else {
+    _sim.stats.naks++;
+  }
+  return true;
+}
+
+static sim_xact_t ctrl_xact(void) {
+  sim_edpt_t* ep_out = &_sim.edpt[0][TUSB_DIR_OUT];
+  sim_edpt_t* ep_in = &_sim.edpt[0][TUSB_DIR_IN];
+  uint16_t const wLength = _sim.ctrl.request.wLength;
+
+  switch (_sim.ctrl.state) {
+    case CTRL_SETUP:
+      if (!bus_consume(8)) return XACT_NONE;
+      _sim.stats.transactions++;
+      // setup packet always clears control endpoint stall and aborts previous transfer
+      ep_out->stalled = ep_in->stalled = false;
+      ep_out->active = ep_in->active = false;
+      _sim.ctrl.xferred = 0;
+      if (wLength) {
+        _sim.ctrl.state = (_sim.ctrl.request.bmRequestType_bit.direction == TUSB_DIR_IN) ? CTRL_DATA_IN : CTRL_DATA_OUT;
+      } else {
+        _sim.ctrl.state = CTRL_STATUS_IN;
+      }
+      dcd_event_setup_received(0, (uint8_t const*) &_sim.ctrl.request, true);
+      signal_event();
+      return XACT_DATA;
+
+    case CTRL_DATA_IN:
+    case CTRL_STATUS_IN: {
+      if (ep_in->stalled) {
+        (void) edpt_handshake(ep_in);
+        _sim.ctrl.state = CTRL_STALLED;
+        return XACT_DATA;
+      }
+      if (!ep_in->active) {
+        return edpt_handshake(ep_in) ? XACT_NAK : XACT_NONE;
+      }
+      uint16_t len = tu_min16(ep_in->mps, (uint16_t) (ep_in->total_len - ep_in->actual_len));
+      if (!bus_consume(len)) return XACT_NONE;
+
+      uint8_t scratch[CFG_TUD_ENDPOINT0_SIZE];
+      uint16_t const room = (uint16_t) (wLength - _sim.ctrl.xferred);
+      bool const complete = edpt_packet(0x80, scratch, len);
+      if (_sim.ctrl.state == CTRL_DATA_IN) {
+        if (_sim.ctrl.buffer) {
+          memcpy(_sim.ctrl.buffer + _sim.ctrl.xferred, scratch, tu_min16(len, room));
+        }
+        _sim.ctrl.xferred = (uint16_t) (_sim.ctrl.xferred + tu_min16(len, room));
+        if (len < ep_in->mps || _sim.ctrl.xferred >= wLength) {
+          _sim.ctrl.state = CTRL_STATUS_OUT;
+        }
+      } else {
+        _sim.ctrl.state = CTRL_DONE;
+      }
+      if (complete) {
+        xfer_complete(0x80);
+      }
+      return XACT_DATA;
+    }
+
+    case CTRL_DATA_OUT:
+    case CTRL_STATUS_OUT: {
+      if (ep_out->stalled) {
+        (void) edpt_handshake(ep_out);
+        _sim.ctrl.state = CTRL_STALLED;
+        return XACT_DATA;
+      }
+      if (!ep_out->active) {
+        return edpt_handshake(ep_out) ? XACT_NAK : XACT_NONE;
+      }
+      uint16_t len = 0;
+      if (_sim.ctrl.state == CTRL_DATA_OUT) {
+        len = tu_min16(tu_min16(ep_out->mps, (uint16_t) (wLength - _sim.ctrl.xferred)),
+                       (uint16_t) (ep_out->total_len - ep_out->actual_len));
+      }
+      if (!bus_consume(len)) return XACT_NONE;
+
+      bool const complete = edpt_packet(0x00, _sim.ctrl.buffer ? _sim.ctrl.buffer + _sim.ctrl.xferred : NULL, len);
+      if (_sim.ctrl.state == CTRL_DATA_OUT) {
+        _sim.ctrl.xferred = (uint16_t) (_sim.ctrl.xferred + len);
+        if (_sim.ctrl.xferred >= wLength) {
+          _sim.ctrl.state = CTRL_STATUS_IN;
+        }
+      } else {
+        _sim.ctrl.state = CTRL_DONE;
+      }
+      if (complete) {
+        xfer_complete(0x00);
+      }
+      return XACT_DATA;
+    }
+
+    default:
+      return XACT_NONE;
+  }
+}
+
+static sim_xact_t edpt_xact(uint8_t ep_addr) {
+  uint8_t const epnum = tu_edpt_number(ep_addr);
+  uint8_t const dir = tu_edpt_dir(ep_addr);
+  sim_edpt_t* ep = &_sim.edpt[epnum][dir];
+  sim_pipe_t* pipe = &_sim_pipe[epnum][dir];
+
+  if (!ep->opened) {
+    return XACT_NONE;
+  }
+
+  // host only issues OUT token with data to send, and IN token when it has room for a packet
+  if (dir == TUSB_DIR_OUT ? (pipe->count == 0) : (CFG_DCD_SIM_HOST_BUFSIZE - pipe->count < ep->mps)) {
+    return XACT_NONE;
+  }
+
+  if (ep->stalled || !ep->active) {
+    // host stops polling a stalled endpoint until it is cleared
+    if (ep->stalled) return XACT_NONE;
+    return edpt_handshake(ep) ? XACT_NAK : XACT_NONE;
+  }
+
+  uint16_t len = (uint16_t) (ep->total_len - ep->actual_len);
+  len = tu_min16(len, ep->mps);
+  if (dir == TUSB_DIR_OUT) {
+    len = (uint16_t) tu_min32(len, pipe->count);
+  }
+  if (!bus_consume(len)) {
+    return XACT_NONE;
+  }
+
+  bool complete;
+  if (dir == TUSB_DIR_OUT) {
+    complete = edpt_packet(ep_addr, pipe->data, len);
+    pipe->count -= len;
+    memmove(pipe->data, pipe->data + len, pipe->count);
+  } else {
+    complete = edpt_packet(ep_addr, pipe->data + pipe->count, len);
+    pipe->count += len;
+  }
+
+  if (complete) {
+    xfer_complete(ep_addr);
+  }
+  return XACT_DATA;
+}
+
+static void run_frame(void) {
+  uint64_t const frame_ps = is_highspeed() ? SIM_FRAME_PS_HS : SIM_FRAME_PS_FS;
+
+  if (!is_highspeed() || (_sim.microframe++ & 7u) == 0) {
+    _sim.frame_num = (uint16_t) ((_sim.frame_num + 1u) & 0x7FFu);
+  }
+  _sim.budget_ps = frame_ps;
+  _sim.stats.frames++;
+
+  if (_sim.connected) {
+    (void) bus_consume(3); // SOF token
+    if (_sim.sof_en) {
+      dcd_event_sof(0, _sim.frame_num, true);
+      signal_event();
+    }
+
+    // periodic endpoints are serviced once per frame
+    for (uint8_t epnum = 1; epnum < TUP_DCD_ENDPOINT_MAX; epnum++) {
+      for (uint8_t dir = 0; dir < 2; dir++) {
+        if (_sim.edpt[epnum][dir].xfer_type == TUSB_XFER_ISOCHRONOUS ||
+            _sim.edpt[epnum][dir].xfer_type == TUSB_XFER_INTERRUPT) {
+          (void) edpt_xact(tu_edpt_addr(epnum, dir));
+        }
+      }
+    }
+
+    // control and bulk share the rest of frame, serviced round-robin until nothing can move
+    bool progress = true;
+    while (progress) {
+      progress = (ctrl_xact() == XACT_DATA);
+      for (uint8_t epnum = 1; epnum < TUP_DCD_ENDPOINT_MAX; epnum++) {
+        for (uint8_t dir = 0; dir < 2; dir++) {
+          if (_sim.edpt[epnum][dir].xfer_type == TUSB_XFER_BULK && edpt_xact(tu_edpt_addr(epnum, dir)) == XACT_DATA) {
+            progress = true;
+          }
+        }
+      }
+    }
+  }
+
+  _sim.stats.time_ns += frame_ps / 1000u;
+}
+
+//--------------------------------------------------------------------+
+// Host API
+//--------------------------------------------------------------------+
+
+void dcd_sim_set_task_hook(void (*hook)(void)) {
+  _sim.task_hook = hook;
+}
+
+bool dcd_sim_host_bus_reset(void) {
+  TU_VERIFY(_sim.connected);
+
+  for (uint8_t epnum = 1; epnum < TUP_DCD_ENDPOINT_MAX; epnum++) {
+    tu_memclr(_sim.edpt[epnum], sizeof(_sim.edpt[epnum]));
+  }
+  tu_memclr(_sim_pipe, sizeof(_sim_pipe));
+  _sim.edpt[0][0].active = _sim.edpt[0][1].active = false;
+  _sim.ctrl.state = CTRL_IDLE;
+  _sim.dev_addr = 0;
+
+  dcd_event_bus_reset(0, _sim.speed, true);
+  signal_event();
+  return true;
+}
+
+void dcd_sim_run_frames(uint32_t count) {
+  while (count--) {
+    run_frame();
+  }
+}
+
+void dcd_sim_run(uint32_t duration_us) {
+  uint32_t const frame_us = is_highspeed() ? 125u : 1000u;
+  dcd_sim_run_frames((duration_us + frame_us - 1) / frame_us);
+}
+
+bool dcd_sim_host_control(tusb_control_request_t const* request, void* buffer) {
+  TU_VERIFY(_sim.connected && _sim.ctrl.state != CTRL_SETUP);
+  _sim.ctrl.request = *request;
+  _sim.ctrl.buffer = (uint8_t*) buffer;
+  _sim.ctrl.xferred = 0;
+  _sim.ctrl.state = CTRL_SETUP;
+  return true;
+}
+
+dcd_sim_control_status_t dcd_sim_host_control_status(uint16_t* xferred) {
+  if (xferred) {
+    *xferred = _sim.ctrl.xferred;
+  }
+  switch (_sim.ctrl.state) {
+    case CTRL_IDLE:    return DCD_SIM_CONTROL_IDLE;
+    case CTRL_DONE:    return DCD_SIM_CONTROL_DONE;
+    case CTRL_STALLED: return DCD_SIM_CONTROL_STALLED;
+    default:           return DCD_SIM_CONTROL_BUSY;
+  }
+}
+
+uint32_t dcd_sim_host_write(uint8_t ep_addr, void const* buffer, uint32_t bufsize) {
+  uint8_t const epnum = tu_edpt_number(ep_addr);
+  TU_VERIFY(epnum && epnum < TUP_DCD_ENDPOINT_MAX && tu_edpt_dir(ep_addr) == TUSB_DIR_OUT, 0);
+  sim_pipe_t* pipe = &_sim_pipe[epnum][TUSB_DIR_OUT];
+  uint32_t const count = tu_min32(bufsize, CFG_DCD_SIM_HOST_BUFSIZE - pipe->count);
+  memcpy(pipe->data + pipe->count, buffer, count);
+  pipe->count += count;
+  return count;
+}
+
+uint32_t dcd_sim_host_read(uint8_t ep_addr, void* buffer, uint32_t bufsize) {
+  uint8_t const epnum = tu_edpt_number(ep_addr);
+  TU_VERIFY(epnum && epnum < TUP_DCD_ENDPOINT_MAX && tu_edpt_dir(ep_addr) == TUSB_DIR_IN, 0);
+  sim_pipe_t* pipe = &_sim_pipe[epnum][TUSB_DIR_IN];
+  uint32_t const count = tu_min32(bufsize, pipe->count);
+  memcpy(buffer, pipe->data, count);
+  pipe->count -= count;
+  memmove(pipe->data, pipe->data + count, pipe->count);
+  return count;
+}
+
+uint32_t dcd_sim_host_read_available(uint8_t ep_addr) {
+  uint8_t const epnum = tu_edpt_number(ep_addr);
+  TU_VERIFY(epnum && epnum < TUP_DCD_ENDPOINT_MAX && tu_edpt_dir(ep_addr) == TUSB_DIR_IN, 0);
+  return _sim_pipe[epnum][TUSB_DIR_IN].count;
+}
+
+void dcd_sim_get_stats(dcd_sim_stats_t* stats) {
+  *stats = _sim.stats;
+}
+
+void dcd_sim_clear_stats(void) {
+  tu_memclr(&_sim.stats, sizeof(_sim.stats));
+}
+
+/*------------------------------------------------------------------*/
+/* Device API
+ *------------------------------------------------------------------*/
+
+bool dcd_init(uint8_t rhport, const tusb_rhport_init_t* rh_init) {
+  (void) rhport;
+  void (*hook)(void) = _sim.task_hook; // can be set before stack init
+  tu_memclr(&_sim, sizeof(_sim));
+  tu_memclr(_sim_pipe, sizeof(_sim_pipe));
+  _sim.task_hook = hook;
+  _sim.speed = (rh_init && rh_init->speed == TUSB_SPEED_FULL) ? TUSB_SPEED_FULL : TUSB_SPEED_HIGH;
+  _sim.edpt[0][0].mps = _sim.edpt[0][1].mps = CFG_TUD_ENDPOINT0_SIZE;
+  _sim.edpt[0][0].opened = _sim.edpt[0][1].opened = true;
+  _sim.connected = true;
+  return true;
+}
+
+bool dcd_deinit(uint8_t rhport) {
+  (void) rhport;
+  _sim.connected = false;
+  return true;
+}
+
+// Events are signaled synchronously from dcd_sim_run(), there is no interrupt to handle
+void dcd_int_handler(uint8_t rhport) {
+  (void) rhport;
+}
+
+void dcd_int_enable(uint8_t rhport) {
+  (void) rhport;
+  _sim.int_en = true;
+}
+
+void dcd_int_disable(uint8_t rhport) {
+  (void) rhport;
+  _sim.int_en = false;
+}
+
+void dcd_set_address(uint8_t rhport, uint8_t dev_addr) {
+  _sim.dev_addr = dev_addr;
+  // respond with status
+  dcd_edpt_xfer(rhport, 0x80, NULL, 0);
+}
+
+void dcd_remote_wakeup(uint8_t rhport) {
+  (void) rhport;
+}
+
+void dcd_connect(uint8_t rhport) {
+  (void) rhport;
+  _sim.connected = true;
+}
+
+void dcd_disconnect(uint8_t rhport) {
+  (void) rhport;
+  _sim.connected = false;
+}
+
+void dcd_sof_enable(uint8_t rhport, bool en) {
+  (void) rhport;
+  _sim.sof_en = en;
+}
+
+//--------------------------------------------------------------------+
+// Endpoint API
+//--------------------------------------------------------------------+
+
+bool dcd_edpt_open(uint8_t rhport, tusb_desc_endpoint_t const* desc_ep) {
+  (void) rhport;
+  uint8_t const epnum = tu_edpt_number(desc_ep->bEndpointAddress);
+  uint8_t const dir = tu_edpt_dir(desc_ep->bEndpointAddress);
+  TU_ASSERT(epnum < TUP_DCD_ENDPOINT_MAX);
+
+  sim_edpt_t* ep = &_sim.edpt[epnum][dir];
+  tu_memclr(ep, sizeof(sim_edpt_t));
+  ep->mps = tu_edpt_packet_size(desc_ep);
+  ep->xfer_type = desc_ep->bmAttributes.xfer;
+  ep->opened = true;
+  return true;
+}
+
+void dcd_edpt_close_all(uint8_t rhport) {
+  (void) rhport;
+  for (uint8_t epnum = 1; epnum < TUP_DCD_ENDPOINT_MAX; epnum++) {
+    tu_memclr(_sim.edpt[epnum], sizeof(_sim.edpt[epnum]));
+  }
+}
+
+void dcd_edpt_close(uint8_t rhport, uint8_t ep_addr) {
+  (void) rhport;
+  tu_memclr(&_sim.edpt[tu_edpt_number(ep_addr)][tu_edpt_dir(ep_addr)], sizeof(sim_edpt_t));
+}
+
+bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint16_t total_bytes) {
+  (void) rhport;
+  uint8_t const epnum = tu_edpt_number(ep_addr);
+  TU_ASSERT(epnum < TUP_DCD_ENDPOINT_MAX);
+  sim_edpt_t* ep = &_sim.edpt[epnum][tu_edpt_dir(ep_addr)];
+  TU_ASSERT(ep->opened);
+
+  ep->buffer = buffer;
+  ep->total_len = total_bytes;
+  ep->actual_len = 0;
+  ep->active = true;
+  return true;
+}
+
+void dcd_edpt_stall(uint8_t rhport, uint8_t ep_addr) {
+  (void) rhport;
+  sim_edpt_t* ep = &_sim.edpt[tu_edpt_number(ep_addr)][tu_edpt_dir(ep_addr)];
+  ep->stalled = true;
+  ep->active = false;
+}
+
+void dcd_edpt_clear_stall(uint8_t rhport, uint8_t ep_addr) {
+  (void) rhport;
+  _sim.edpt[tu_edpt_number(ep_addr)][tu_edpt_dir(ep_addr)].stalled = false;
+}
+
+#endif
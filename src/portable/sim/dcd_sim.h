@@ -0,0 +1,104 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#ifndef TUSB_DCD_SIM_H_
+#define TUSB_DCD_SIM_H_
+
+#include "common/tusb_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Simulated device controller (CFG_TUSB_MCU = OPT_MCU_SIM) to run the device stack natively on a workstation e.g
+// for profiling with perf/valgrind. The API below plays the host role: it drives a deterministic bus model where
+// each (micro)frame has a fixed time budget and every transaction costs its packet duration at the bus speed.
+// There is no real time involved, application advances the bus with dcd_sim_run().
+//
+// Typical use: dcd_sim_set_task_hook(tud_task) then tusb_init(), dcd_sim_host_bus_reset() and enumerate with
+// dcd_sim_host_control() while calling dcd_sim_run_frames(). Application also provides tusb_time_millis_api(), which
+// can return simulated time from dcd_sim_get_stats().
+//
+// Model simplification: bulk, interrupt and isochronous share the frame time budget, interrupt and isochronous
+// endpoints get one transaction per (micro)frame regardless of bInterval. Bit stuffing is not accounted for.
+
+// Size of host-side buffer for each non-control endpoint
+#ifndef CFG_DCD_SIM_HOST_BUFSIZE
+#define CFG_DCD_SIM_HOST_BUFSIZE    4096
+#endif
+
+typedef enum {
+  DCD_SIM_CONTROL_IDLE = 0,
+  DCD_SIM_CONTROL_BUSY,
+  DCD_SIM_CONTROL_DONE,
+  DCD_SIM_CONTROL_STALLED,
+} dcd_sim_control_status_t;
+
+typedef struct {
+  uint64_t time_ns;      // simulated bus time
+  uint32_t frames;       // (micro)frames run
+  uint32_t transactions; // data transactions including control
+  uint32_t naks;
+  uint32_t stalls;
+  uint64_t bytes_out;    // host to device payload
+  uint64_t bytes_in;     // device to host payload
+} dcd_sim_stats_t;
+
+// Invoked after every event signaled to the stack, typically set to tud_task() to model a device which services
+// its interrupts immediately. Without hook, application must call tud_task() between dcd_sim_run()
+void dcd_sim_set_task_hook(void (*hook)(void));
+
+// Reset the bus, device must be connected (tud_connect()). Speed is high unless initialized with full speed
+bool dcd_sim_host_bus_reset(void);
+
+// Advance the bus by a number of (micro)frames or microseconds
+void dcd_sim_run_frames(uint32_t count);
+void dcd_sim_run(uint32_t duration_us);
+
+// Start a control transfer on endpoint 0. buffer holds data to send (Host to Device) or receives data from device,
+// and must stay valid until dcd_sim_host_control_status() is no longer BUSY
+bool dcd_sim_host_control(tusb_control_request_t const* request, void* buffer);
+
+// Get status of control transfer, number of data stage bytes transferred are returned in xferred (can be NULL)
+dcd_sim_control_status_t dcd_sim_host_control_status(uint16_t* xferred);
+
+// Queue data to a device OUT endpoint, return number of bytes accepted
+uint32_t dcd_sim_host_write(uint8_t ep_addr, void const* buffer, uint32_t bufsize);
+
+// Read data received from a device IN endpoint, return number of bytes read
+uint32_t dcd_sim_host_read(uint8_t ep_addr, void* buffer, uint32_t bufsize);
+
+// Number of bytes received from a device IN endpoint and not read yet
+uint32_t dcd_sim_host_read_available(uint8_t ep_addr);
+
+void dcd_sim_get_stats(dcd_sim_stats_t* stats);
+void dcd_sim_clear_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
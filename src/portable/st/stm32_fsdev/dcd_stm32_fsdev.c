@@ -76,7 +76,7 @@
  * - Packet buffer memory is copied in the interrupt.
  *   - This is better for performance, but means interrupts are disabled for longer
  *   - DMA may be the best choice, but it could also be pushed to the USBD task.
- * - No double-buffering
+ * - Double-buffering only for isochronous (2048 byte PMA) and bulk endpoints (when configuration leaves enough PMA)
  * - No DMA
  * - Minimal error handling
  *   - Perhaps error interrupts should be reported to the stack, or cause a device reset?
@@ -136,6 +136,8 @@ typedef struct {
   uint16_t max_packet_size;
   uint8_t ep_idx;   // index for USB_EPnR register
   bool iso_in_sending; // Workaround for ISO IN EP doesn't have interrupt mask
+  bool dbuf;           // double-buffered bulk endpoint
+  bool dbuf_prefilled; // IN: next packet is written to application buffer but not released yet
 } xfer_ctl_t;
 
 // EP allocator
@@ -143,10 +145,12 @@ typedef struct {
   uint8_t ep_num;
   uint8_t ep_type;
   bool allocated[2];
+  bool exclusive; // ISO or double-buffered bulk use both buffers of the register
 } ep_alloc_t;
 
 static xfer_ctl_t xfer_status[CFG_TUD_ENDPPOINT_MAX][2];
 static ep_alloc_t ep_alloc_status[FSDEV_EP_COUNT];
+static uint16_t ep_dbuf_mask[2]; // bulk endpoints to double buffer, planned by dcd_edpt_config_plan()
 static uint8_t remoteWakeCountdown; // When wake is requested
 
 //--------------------------------------------------------------------+
@@ -156,12 +160,13 @@ static uint8_t remoteWakeCountdown; // When wake is requested
 // into the stack.
 static void handle_bus_reset(uint8_t rhport);
 static void dcd_transmit_packet(xfer_ctl_t *xfer, uint16_t ep_ix);
+static void dcd_dbuf_write_packet(xfer_ctl_t *xfer, uint16_t ep_ix);
 static bool edpt_xfer(uint8_t rhport, uint8_t ep_num, tusb_dir_t dir);
 
 // PMA allocation/access
 static uint16_t ep_buf_ptr; ///< Points to first free memory location
 static uint32_t dcd_pma_alloc(uint16_t len, bool dbuf);
-static uint8_t dcd_ep_alloc(uint8_t ep_addr, uint8_t ep_type);
+static uint8_t dcd_ep_alloc(uint8_t ep_addr, uint8_t ep_type, bool exclusive);
 static bool dcd_write_packet_memory(uint16_t dst, const void *__restrict src, uint16_t nbytes);
 static bool dcd_read_packet_memory(void *__restrict dst, uint16_t src, uint16_t nbytes);
 
@@ -182,6 +187,16 @@ TU_ATTR_ALWAYS_INLINE static inline xfer_ctl_t *xfer_ctl_ptr(uint8_t epnum, uint
   return &xfer_status[epnum][dir];
 }
 
+// Double-buffered bulk endpoint: DTOG of its direction selects the buffer used by USB, DTOG of the other direction
+// (SW_BUF) selects the buffer owned by application. USB NAKs when both select the same buffer.
+// Toggle SW_BUF to hand application buffer over to USB and take the other one.
+TU_ATTR_ALWAYS_INLINE static inline void ep_dbuf_release(uint32_t ep_idx, tusb_dir_t dir) {
+  uint32_t ep_reg = ep_read(ep_idx) | USB_EP_CTR_TX | USB_EP_CTR_RX; // reserve CTR
+  ep_reg &= USB_EPREG_MASK;
+  ep_change_dtog(&ep_reg, (tusb_dir_t) (1 - dir), 1);
+  ep_write(ep_idx, ep_reg, true);
+}
+
 //--------------------------------------------------------------------+
 // Controller API
 //--------------------------------------------------------------------+
@@ -266,10 +281,12 @@ static void handle_bus_reset(uint8_t rhport) {
     ep_alloc_status[i].ep_type = 0xFF;
     ep_alloc_status[i].allocated[0] = false;
     ep_alloc_status[i].allocated[1] = false;
+    ep_alloc_status[i].exclusive = false;
   }
 
   // Reset PMA allocation
   ep_buf_ptr = FSDEV_BTABLE_BASE + 8 * FSDEV_EP_COUNT;
+  ep_dbuf_mask[0] = ep_dbuf_mask[1] = 0;
 
   edpt0_open(rhport); // open control endpoint (both IN & OUT)
 
@@ -293,6 +310,19 @@ static void handle_ctr_tx(uint32_t ep_id) {
     xfer->iso_in_sending = false;
     uint8_t buf_id = (ep_reg & USB_EP_DTOG_TX) ? 0 : 1;
     btable_set_count(ep_id, buf_id, 0);
+  } else if (xfer->dbuf) {
+    // USB is done with one buffer: hand over the pre-filled one and write next packet into the freed buffer
+    if (xfer->dbuf_prefilled) {
+      ep_dbuf_release(ep_id, TUSB_DIR_IN);
+      xfer->dbuf_prefilled = false;
+      if (xfer->total_len != xfer->queued_len) {
+        dcd_dbuf_write_packet(xfer, ep_id);
+        xfer->dbuf_prefilled = true;
+      }
+    } else {
+      dcd_event_xfer_complete(0, ep_num | TUSB_DIR_IN_MASK, xfer->queued_len, XFER_RESULT_SUCCESS, true);
+    }
+    return;
   }
 
   if (xfer->total_len != xfer->queued_len) {
@@ -331,7 +361,7 @@ static void handle_ctr_rx(uint32_t ep_id) {
   xfer_ctl_t* xfer = xfer_ctl_ptr(ep_num, TUSB_DIR_OUT);
 
   uint8_t buf_id;
-  if (is_iso) {
+  if (is_iso || xfer->dbuf) {
     buf_id = (ep_reg & USB_EP_DTOG_RX) ? 0 : 1; // ISO are double buffered
   } else {
     buf_id = BTABLE_BUF_RX;
@@ -339,6 +369,14 @@ static void handle_ctr_rx(uint32_t ep_id) {
   uint16_t const rx_count = btable_get_count(ep_id, buf_id);
   uint16_t pma_addr = (uint16_t) btable_get_addr(ep_id, buf_id);
 
+  if (xfer->dbuf && rx_count == xfer->max_packet_size && xfer->queued_len + rx_count < xfer->total_len) {
+    // More data expected: take the filled buffer and release the other one before copying, so that USB can receive
+    // next packet meanwhile. Last packet keeps the other buffer to application (NAK) until next transfer.
+    uint16_t const remaining = (uint16_t) (xfer->total_len - xfer->queued_len - rx_count);
+    btable_set_rx_bufsize(ep_id, buf_id ^ 1, tu_min16(remaining, xfer->max_packet_size));
+    ep_dbuf_release(ep_id, TUSB_DIR_OUT);
+  }
+
   if (xfer->ff) {
     dcd_read_packet_memory_ff(xfer->ff, pma_addr, rx_count);
   } else {
@@ -357,8 +395,9 @@ static void handle_ctr_rx(uint32_t ep_id) {
     // ch32 seems to unconditionally accept ZLP on EP0 OUT, which can incorrectly use queued_len of previous
     // transfer. So reset total_len and queued_len to 0.
     xfer->total_len = xfer->queued_len = 0;
-  } else {
-    // Set endpoint active again for receiving more data. Note that isochronous endpoints stay active always
+  } else if (!xfer->dbuf) {
+    // Set endpoint active again for receiving more data. Note that isochronous and double-buffered endpoints stay
+    // active always
     if (!is_iso) {
       uint16_t const cnt = tu_min16(xfer->total_len - xfer->queued_len, xfer->max_packet_size);
       btable_set_rx_bufsize(ep_id, BTABLE_BUF_RX, cnt);
@@ -514,23 +553,25 @@ static uint32_t dcd_pma_alloc(uint16_t len, bool dbuf)
 /***
  * Allocate hardware endpoint
  */
-static uint8_t dcd_ep_alloc(uint8_t ep_addr, uint8_t ep_type)
+static uint8_t dcd_ep_alloc(uint8_t ep_addr, uint8_t ep_type, bool exclusive)
 {
   uint8_t const epnum = tu_edpt_number(ep_addr);
   uint8_t const dir = tu_edpt_dir(ep_addr);
+  exclusive = exclusive || (ep_type == TUSB_XFER_ISOCHRONOUS);
 
   for (uint8_t i = 0; i < FSDEV_EP_COUNT; i++) {
     // Check if already allocated
     if (ep_alloc_status[i].allocated[dir] &&
         ep_alloc_status[i].ep_type == ep_type &&
-        ep_alloc_status[i].ep_num == epnum) {
+        ep_alloc_status[i].ep_num == epnum &&
+        ep_alloc_status[i].exclusive == exclusive) {
       return i;
     }
 
     // If EP of current direction is not allocated
-    // Except for ISO endpoint, both direction should be free
-    if (!ep_alloc_status[i].allocated[dir] &&
-        (ep_type != TUSB_XFER_ISOCHRONOUS || !ep_alloc_status[i].allocated[dir ^ 1])) {
+    // Except for ISO and double-buffered endpoint, both direction should be free
+    if (!ep_alloc_status[i].allocated[dir] && !ep_alloc_status[i].exclusive &&
+        (!exclusive || !ep_alloc_status[i].allocated[dir ^ 1])) {
       // Check if EP number is the same
       if (ep_alloc_status[i].ep_num == 0xFF || ep_alloc_status[i].ep_num == epnum) {
         // One EP pair has to be the same type
@@ -538,6 +579,7 @@ static uint8_t dcd_ep_alloc(uint8_t ep_addr, uint8_t ep_type)
           ep_alloc_status[i].ep_num = epnum;
           ep_alloc_status[i].ep_type = ep_type;
           ep_alloc_status[i].allocated[dir] = true;
+          ep_alloc_status[i].exclusive = exclusive;
 
           return i;
         }
@@ -545,15 +587,15 @@ static uint8_t dcd_ep_alloc(uint8_t ep_addr, uint8_t ep_type)
     }
   }
 
-  // Allocation failed
-  TU_ASSERT(0);
+  // Allocation failed, caller asserts
+  return 0xFF;
 }
 
 void edpt0_open(uint8_t rhport) {
   (void) rhport;
 
-  dcd_ep_alloc(0x0, TUSB_XFER_CONTROL);
-  dcd_ep_alloc(0x80, TUSB_XFER_CONTROL);
+  dcd_ep_alloc(0x0, TUSB_XFER_CONTROL, false);
+  dcd_ep_alloc(0x80, TUSB_XFER_CONTROL, false);
 
   xfer_status[0][0].max_packet_size = CFG_TUD_ENDPOINT0_SIZE;
   xfer_status[0][0].ep_idx = 0;
@@ -583,7 +625,23 @@ bool dcd_edpt_open(uint8_t rhport, tusb_desc_endpoint_t const *desc_ep) {
   uint8_t const ep_num = tu_edpt_number(ep_addr);
   tusb_dir_t const dir = tu_edpt_dir(ep_addr);
   const uint16_t packet_size = tu_edpt_packet_size(desc_ep);
-  uint8_t const ep_idx = dcd_ep_alloc(ep_addr, desc_ep->bmAttributes.xfer);
+
+  // Double buffer bulk endpoint as planned if it still fits PMA and a whole register is available
+  bool dbuf = false;
+  uint8_t ep_idx = 0xFF;
+  if (desc_ep->bmAttributes.xfer == TUSB_XFER_BULK && tu_bit_test(ep_dbuf_mask[dir], ep_num)) {
+    uint8_t blsize, num_block;
+    uint16_t const aligned_len = pma_align_buffer_size(packet_size, &blsize, &num_block);
+    (void) blsize;
+    (void) num_block;
+    if (ep_buf_ptr + 2u * aligned_len <= FSDEV_PMA_SIZE) {
+      ep_idx = dcd_ep_alloc(ep_addr, TUSB_XFER_BULK, true);
+      dbuf = (ep_idx < FSDEV_EP_COUNT);
+    }
+  }
+  if (!dbuf) {
+    ep_idx = dcd_ep_alloc(ep_addr, desc_ep->bmAttributes.xfer, false);
+  }
   TU_ASSERT(ep_idx < FSDEV_EP_COUNT);
 
   uint32_t ep_reg = ep_read(ep_idx) & ~USB_EPREG_MASK;
@@ -603,22 +661,38 @@ bool dcd_edpt_open(uint8_t rhport, tusb_desc_endpoint_t const *desc_ep) {
       TU_ASSERT(false);
   }
 
-  /* Create a packet memory buffer area. */
-  uint16_t pma_addr = dcd_pma_alloc(packet_size, false);
-  btable_set_addr(ep_idx, dir == TUSB_DIR_IN ? BTABLE_BUF_TX : BTABLE_BUF_RX, pma_addr);
-
   xfer_ctl_t *xfer = xfer_ctl_ptr(ep_num, dir);
   xfer->max_packet_size = packet_size;
   xfer->ep_idx = ep_idx;
+  xfer->dbuf = dbuf;
 
   ep_change_status(&ep_reg, dir, EP_STAT_NAK);
   ep_change_dtog(&ep_reg, dir, 0);
 
-  // reserve other direction toggle bits
-  if (dir == TUSB_DIR_IN) {
-    ep_reg &= ~(USB_EPRX_STAT | USB_EP_DTOG_RX);
+  if (dbuf) {
+    // Both buffers of register are used by this direction, other direction is disabled
+    uint32_t pma_addr = dcd_pma_alloc(packet_size, true);
+    btable_set_addr(ep_idx, 0, (uint16_t) pma_addr);
+    btable_set_addr(ep_idx, 1, (uint16_t) (pma_addr >> 16));
+    if (dir == TUSB_DIR_OUT) {
+      btable_set_rx_bufsize(ep_idx, 0, packet_size);
+      btable_set_rx_bufsize(ep_idx, 1, packet_size);
+    }
+
+    ep_reg |= USB_EP_KIND; // DBL_BUF
+    ep_change_status(&ep_reg, (tusb_dir_t) (1 - dir), EP_STAT_DISABLED);
+    ep_change_dtog(&ep_reg, (tusb_dir_t) (1 - dir), 0); // SW_BUF = DTOG: NAK until transfer is queued
   } else {
-    ep_reg &= ~(USB_EPTX_STAT | USB_EP_DTOG_TX);
+    /* Create a packet memory buffer area. */
+    uint16_t pma_addr = dcd_pma_alloc(packet_size, false);
+    btable_set_addr(ep_idx, dir == TUSB_DIR_IN ? BTABLE_BUF_TX : BTABLE_BUF_RX, pma_addr);
+
+    // reserve other direction toggle bits
+    if (dir == TUSB_DIR_IN) {
+      ep_reg &= ~(USB_EPRX_STAT | USB_EP_DTOG_RX);
+    } else {
+      ep_reg &= ~(USB_EPTX_STAT | USB_EP_DTOG_TX);
+    }
   }
 
   ep_write(ep_idx, ep_reg, true);
@@ -637,12 +711,64 @@ void dcd_edpt_close_all(uint8_t rhport) {
     ep_alloc_status[i].ep_type = 0xFF;
     ep_alloc_status[i].allocated[0] = false;
     ep_alloc_status[i].allocated[1] = false;
+    ep_alloc_status[i].exclusive = false;
   }
 
   dcd_int_enable(rhport);
 
   // Reset PMA allocation
   ep_buf_ptr = FSDEV_BTABLE_BASE + 8 * CFG_TUD_ENDPPOINT_MAX + 2 * CFG_TUD_ENDPOINT0_SIZE;
+  ep_dbuf_mask[0] = ep_dbuf_mask[1] = 0;
+}
+
+// Double buffer bulk endpoints with PMA left after all endpoints of configuration (largest packet size among
+// alternate settings) are allocated single-buffered, isochronous are counted as they are allocated.
+void dcd_edpt_config_plan(uint8_t rhport, tusb_desc_configuration_t const* desc_cfg) {
+  (void) rhport;
+  uint16_t plan[CFG_TUD_ENDPPOINT_MAX][2] = { 0 };
+  uint16_t bulk_mask[2] = { 0 };
+  uint8_t blsize, num_block;
+
+  uint8_t const* p_desc = (uint8_t const*) desc_cfg;
+  uint8_t const* desc_end = p_desc + tu_le16toh(desc_cfg->wTotalLength);
+  p_desc = tu_desc_next(p_desc);
+
+  while (p_desc < desc_end) {
+    if (tu_desc_type(p_desc) == TUSB_DESC_ENDPOINT) {
+      tusb_desc_endpoint_t const* desc_ep = (tusb_desc_endpoint_t const*) p_desc;
+      uint8_t const num = tu_edpt_number(desc_ep->bEndpointAddress);
+      uint8_t const dir = tu_edpt_dir(desc_ep->bEndpointAddress);
+      TU_VERIFY(num > 0 && num < CFG_TUD_ENDPPOINT_MAX,);
+
+      uint16_t len = pma_align_buffer_size(tu_edpt_packet_size(desc_ep), &blsize, &num_block);
+#if FSDEV_PMA_SIZE > 1024u
+      if (desc_ep->bmAttributes.xfer == TUSB_XFER_ISOCHRONOUS) {
+        len = (uint16_t) (2 * len);
+      }
+#endif
+      plan[num][dir] = tu_max16(plan[num][dir], len);
+      if (desc_ep->bmAttributes.xfer == TUSB_XFER_BULK) {
+        bulk_mask[dir] |= (uint16_t) TU_BIT(num);
+      }
+    }
+    p_desc = tu_desc_next(p_desc);
+  }
+
+  uint32_t total = ep_buf_ptr;
+  for (uint8_t num = 1; num < CFG_TUD_ENDPPOINT_MAX; num++) {
+    total += plan[num][0] + plan[num][1];
+  }
+  TU_VERIFY(total <= FSDEV_PMA_SIZE,);
+
+  uint32_t spare = FSDEV_PMA_SIZE - total;
+  for (uint8_t num = 1; num < CFG_TUD_ENDPPOINT_MAX; num++) {
+    for (uint8_t dir = 0; dir < 2; dir++) {
+      if ((bulk_mask[dir] & TU_BIT(num)) && plan[num][dir] <= spare) {
+        spare -= plan[num][dir];
+        ep_dbuf_mask[dir] |= (uint16_t) TU_BIT(num);
+      }
+    }
+  }
 }
 
 bool dcd_edpt_iso_alloc(uint8_t rhport, uint8_t ep_addr, uint16_t largest_packet_size) {
@@ -650,7 +776,8 @@ bool dcd_edpt_iso_alloc(uint8_t rhport, uint8_t ep_addr, uint16_t largest_packet
 
   uint8_t const ep_num = tu_edpt_number(ep_addr);
   uint8_t const dir = tu_edpt_dir(ep_addr);
-  uint8_t const ep_idx = dcd_ep_alloc(ep_addr, TUSB_XFER_ISOCHRONOUS);
+  uint8_t const ep_idx = dcd_ep_alloc(ep_addr, TUSB_XFER_ISOCHRONOUS, true);
+  TU_ASSERT(ep_idx < FSDEV_EP_COUNT);
 
   /* Create a packet memory buffer area. Enable double buffering for devices with 2048 bytes PMA,
      for smaller devices double buffering occupy too much space. */
@@ -667,6 +794,7 @@ bool dcd_edpt_iso_alloc(uint8_t rhport, uint8_t ep_addr, uint16_t largest_packet
 
   xfer_ctl_t* xfer = xfer_ctl_ptr(ep_num, dir);
   xfer->ep_idx = ep_idx;
+  xfer->dbuf = false;
 
   return true;
 }
@@ -694,6 +822,16 @@ bool dcd_edpt_iso_activate(uint8_t rhport, tusb_desc_endpoint_t const *desc_ep)
   return true;
 }
 
+// Write next packet of transfer to PMA
+static void xfer_write_packet(xfer_ctl_t *xfer, uint16_t addr_ptr, uint16_t len) {
+  if (xfer->ff) {
+    dcd_write_packet_memory_ff(xfer->ff, addr_ptr, len);
+  } else {
+    dcd_write_packet_memory(addr_ptr, &(xfer->buffer[xfer->queued_len]), len);
+  }
+  xfer->queued_len += len;
+}
+
 // Currently, single-buffered, and only 64 bytes at a time (max)
 static void dcd_transmit_packet(xfer_ctl_t *xfer, uint16_t ep_ix) {
   uint16_t len = tu_min16(xfer->total_len - xfer->queued_len, xfer->max_packet_size);
@@ -708,13 +846,7 @@ static void dcd_transmit_packet(xfer_ctl_t *xfer, uint16_t ep_ix) {
     buf_id = BTABLE_BUF_TX;
   }
   uint16_t addr_ptr = (uint16_t) btable_get_addr(ep_ix, buf_id);
-
-  if (xfer->ff) {
-    dcd_write_packet_memory_ff(xfer->ff, addr_ptr, len);
-  } else {
-    dcd_write_packet_memory(addr_ptr, &(xfer->buffer[xfer->queued_len]), len);
-  }
-  xfer->queued_len += len;
+  xfer_write_packet(xfer, addr_ptr, len);
 
   btable_set_count(ep_ix, buf_id, len);
   ep_change_status(&ep_reg, TUSB_DIR_IN, EP_STAT_VALID);
@@ -726,21 +858,55 @@ static void dcd_transmit_packet(xfer_ctl_t *xfer, uint16_t ep_ix) {
   ep_write(ep_ix, ep_reg, true);
 }
 
+// Double-buffered IN: write packet into application buffer (selected by SW_BUF)
+static void dcd_dbuf_write_packet(xfer_ctl_t *xfer, uint16_t ep_ix) {
+  uint16_t const len = tu_min16(xfer->total_len - xfer->queued_len, xfer->max_packet_size);
+  uint8_t const buf_id = (ep_read(ep_ix) & USB_EP_DTOG_RX) ? 1 : 0;
+  xfer_write_packet(xfer, (uint16_t) btable_get_addr(ep_ix, buf_id), len);
+  btable_set_count(ep_ix, buf_id, len);
+}
+
 static bool edpt_xfer(uint8_t rhport, uint8_t ep_num, tusb_dir_t dir) {
   (void) rhport;
 
   xfer_ctl_t *xfer = xfer_ctl_ptr(ep_num, dir);
   uint8_t const ep_idx = xfer->ep_idx;
 
-  if (dir == TUSB_DIR_IN) {
+  if (dir == TUSB_DIR_IN && xfer->dbuf) {
+    // Take both buffers (SW_BUF = DTOG_TX, USB NAKs), then release first packet and pre-fill the second one
+    uint32_t ep_reg = ep_read(ep_idx) | USB_EP_CTR_TX | USB_EP_CTR_RX; // reserve CTR
+    bool const swbuf_differ = ((ep_reg & USB_EP_DTOG_TX) != 0) != ((ep_reg & USB_EP_DTOG_RX) != 0);
+    ep_reg &= USB_EPREG_MASK | EP_STAT_MASK(dir);
+    ep_change_status(&ep_reg, dir, EP_STAT_VALID);
+    if (swbuf_differ) {
+      ep_change_dtog(&ep_reg, TUSB_DIR_OUT, 1);
+    }
+    ep_write(ep_idx, ep_reg, true);
+
+    dcd_dbuf_write_packet(xfer, ep_idx);
+    ep_dbuf_release(ep_idx, dir);
+    xfer->dbuf_prefilled = false;
+    if (xfer->total_len != xfer->queued_len) {
+      dcd_dbuf_write_packet(xfer, ep_idx);
+      xfer->dbuf_prefilled = true;
+    }
+  } else if (dir == TUSB_DIR_IN) {
     dcd_transmit_packet(xfer, ep_idx);
   } else {
     uint32_t ep_reg = ep_read(ep_idx) | USB_EP_CTR_TX | USB_EP_CTR_RX; // reserve CTR
+    bool const dtog_rx = (ep_reg & USB_EP_DTOG_RX) != 0;
+    bool const swbuf = (ep_reg & USB_EP_DTOG_TX) != 0;
     ep_reg &= USB_EPREG_MASK | EP_STAT_MASK(dir);
 
     uint16_t cnt = tu_min16(xfer->total_len, xfer->max_packet_size);
 
-    if (ep_is_iso(ep_reg)) {
+    if (xfer->dbuf) {
+      // USB receives into buffer selected by DTOG_RX, release it if application (SW_BUF) still owns it
+      btable_set_rx_bufsize(ep_idx, dtog_rx ? 1 : 0, cnt);
+      if (dtog_rx == swbuf) {
+        ep_change_dtog(&ep_reg, TUSB_DIR_IN, 1);
+      }
+    } else if (ep_is_iso(ep_reg)) {
       btable_set_rx_bufsize(ep_idx, 0, cnt);
       btable_set_rx_bufsize(ep_idx, 1, cnt);
     } else {
@@ -816,9 +982,14 @@ void dcd_edpt_clear_stall(uint8_t rhport, uint8_t ep_addr) {
 // PMA read/write
 //--------------------------------------------------------------------+
 
+TU_ATTR_ALWAYS_INLINE static inline bool fsdevbus_is_aligned(const void* ptr) {
+  return (((uintptr_t) ptr) & (FSDEV_BUS_SIZE - 1)) == 0;
+}
+
 // Write to packet memory area (PMA) from user memory
 // - Packet memory must be either strictly 16-bit or 32-bit depending on FSDEV_BUS_32BIT
-// - Uses unaligned for RAM (since M0 cannot access unaligned address)
+// - Aligned RAM is copied with bus-width access, 4 words per loop. Otherwise uses unaligned access for RAM
+//   (since M0 cannot access unaligned address)
 static bool dcd_write_packet_memory(uint16_t dst, const void *__restrict src, uint16_t nbytes) {
   if (nbytes == 0) return true;
   uint32_t n_write = nbytes / FSDEV_BUS_SIZE;
@@ -826,10 +997,27 @@ static bool dcd_write_packet_memory(uint16_t dst, const void *__restrict src, ui
   fsdev_pma_buf_t* pma_buf = PMA_BUF_AT(dst);
   const uint8_t *src8 = src;
 
-  while (n_write--) {
-    pma_buf->value = fsdevbus_unaligned_read(src8);
-    src8 += FSDEV_BUS_SIZE;
-    pma_buf++;
+  if (fsdevbus_is_aligned(src8)) {
+    const fsdev_bus_t* src_bus = (const fsdev_bus_t*) (uintptr_t) src8;
+    for (; n_write >= 4; n_write -= 4) {
+      pma_buf[0].value = src_bus[0];
+      pma_buf[1].value = src_bus[1];
+      pma_buf[2].value = src_bus[2];
+      pma_buf[3].value = src_bus[3];
+      src_bus += 4;
+      pma_buf += 4;
+    }
+    while (n_write--) {
+      pma_buf->value = *src_bus++;
+      pma_buf++;
+    }
+    src8 = (const uint8_t*) src_bus;
+  } else {
+    while (n_write--) {
+      pma_buf->value = fsdevbus_unaligned_read(src8);
+      src8 += FSDEV_BUS_SIZE;
+      pma_buf++;
+    }
   }
 
   // odd bytes e.g 1 for 16-bit or 1-3 for 32-bit
@@ -847,7 +1035,8 @@ static bool dcd_write_packet_memory(uint16_t dst, const void *__restrict src, ui
 
 // Read from packet memory area (PMA) to user memory.
 // - Packet memory must be either strictly 16-bit or 32-bit depending on FSDEV_BUS_32BIT
-// - Uses unaligned for RAM (since M0 cannot access unaligned address)
+// - Aligned RAM is copied with bus-width access, 4 words per loop. Otherwise uses unaligned access for RAM
+//   (since M0 cannot access unaligned address)
 static bool dcd_read_packet_memory(void *__restrict dst, uint16_t src, uint16_t nbytes) {
   if (nbytes == 0) return true;
   uint32_t n_read = nbytes / FSDEV_BUS_SIZE;
@@ -855,10 +1044,27 @@ static bool dcd_read_packet_memory(void *__restrict dst, uint16_t src, uint16_t
   fsdev_pma_buf_t* pma_buf = PMA_BUF_AT(src);
   uint8_t *dst8 = (uint8_t *)dst;
 
-  while (n_read--) {
-    fsdevbus_unaligned_write(dst8, (fsdev_bus_t ) pma_buf->value);
-    dst8 += FSDEV_BUS_SIZE;
-    pma_buf++;
+  if (fsdevbus_is_aligned(dst8)) {
+    fsdev_bus_t* dst_bus = (fsdev_bus_t*) (uintptr_t) dst8;
+    for (; n_read >= 4; n_read -= 4) {
+      dst_bus[0] = pma_buf[0].value;
+      dst_bus[1] = pma_buf[1].value;
+      dst_bus[2] = pma_buf[2].value;
+      dst_bus[3] = pma_buf[3].value;
+      dst_bus += 4;
+      pma_buf += 4;
+    }
+    while (n_read--) {
+      *dst_bus++ = pma_buf->value;
+      pma_buf++;
+    }
+    dst8 = (uint8_t*) dst_bus;
+  } else {
+    while (n_read--) {
+      fsdevbus_unaligned_write(dst8, (fsdev_bus_t ) pma_buf->value);
+      dst8 += FSDEV_BUS_SIZE;
+      pma_buf++;
+    }
   }
 
   // odd bytes e.g 1 for 16-bit or 1-3 for 32-bit
@@ -235,6 +235,16 @@ bool tcd_msg_send(uint8_t rhport, uint8_t const* buffer, uint16_t total_bytes) {
   return true;
 }
 
+bool tcd_hard_reset_send(uint8_t rhport) {
+  // abort any ongoing transfer, hardware sends Hard Reset as soon as line is idle
+  dma_tx_stop(rhport);
+  _tx_pending_buf = NULL;
+  _tx_pending_bytes = 0;
+
+  UCPD1->CR |= UCPD_CR_TXHRST;
+  return true;
+}
+
 void tcd_int_handler(uint8_t rhport) {
   (void) rhport;
 
@@ -301,22 +311,23 @@ void tcd_int_handler(uint8_t rhport) {
   if (sr & UCPD_SR_RXMSGEND) {
     TU_LOG3("RX MSG END\r\n");
 
-    // stop TX
+    // stop RX, buffer is owned by stack until next tcd_msg_receive()
     dma_stop(rhport, true);
+    pd_header_t const* rx_header = (pd_header_t const*) _rx_buf;
+    _rx_buf = NULL;
 
     uint8_t result;
 
-    if (!(sr & UCPD_SR_RXERR)) {
-      // response with good crc
-      // TODO move this to usbc stack
-      if (_rx_buf) {
-        _good_crc.msg_id = ((pd_header_t const *) _rx_buf)->msg_id;
+    if (!(sr & UCPD_SR_RXERR) && rx_header) {
+      // response with good crc right away to meet tTransmit, GoodCRC itself is not acknowledged
+      if (!(rx_header->n_data_obj == 0 && rx_header->msg_type == PD_CTRL_GOOD_CRC)) {
+        _good_crc.msg_id = rx_header->msg_id;
         dma_tx_start(rhport, &_good_crc, 2);
       }
 
       result = XFER_RESULT_SUCCESS;
     }else {
-      // CRC failed
+      // CRC failed or no buffer: no GoodCRC so that partner retries
       result = XFER_RESULT_FAILED;
     }
 
@@ -327,6 +338,13 @@ void tcd_int_handler(uint8_t rhport) {
     UCPD1->ICR = UCPD_ICR_RXMSGENDCF;
   }
 
+  if (sr & UCPD_SR_RXHRSTDET) {
+    TU_LOG3("RX Hard Reset\r\n");
+    tcd_event_hard_reset(rhport, true);
+    // ack
+    UCPD1->ICR = UCPD_ICR_RXHRSTDETCF;
+  }
+
   if (sr & UCPD_SR_RXOVR) {
     TU_LOG3("RXOVR\r\n");
     // ack
@@ -334,6 +352,11 @@ void tcd_int_handler(uint8_t rhport) {
   }
 
   //------------- TX -------------//
+  if (sr & (UCPD_SR_HRSTSENT | UCPD_SR_HRSTDISC)) {
+    // Hard Reset is sent (or discarded by incoming one), nothing else to do since stack already reset its state
+    UCPD1->ICR = UCPD_ICR_HRSTSENTCF | UCPD_ICR_HRSTDISCCF;
+  }
+
   // All tx events: complete and error
   if (sr & (UCPD_SR_TXMSGSENT | (UCPD_SR_TXMSGDISC | UCPD_SR_TXMSGABT | UCPD_SR_TXUND))) {
     // force TX stop
@@ -889,7 +889,6 @@ bool dcd_init(uint8_t rhport, const tusb_rhport_init_t* rh_init) {
   USBC_Writeb((1 << USBC_BP_INTUSBE_EN_SUSPEND)
     | (1 << USBC_BP_INTUSBE_EN_RESUME)
     | (1 << USBC_BP_INTUSBE_EN_RESET)
-    | (1 << USBC_BP_INTUSBE_EN_SOF)
     | (1 << USBC_BP_INTUSBE_EN_DISCONNECT)
     , USBC_REG_INTUSBE(USBC0_BASE));
   f1c100s_intc_clear_pend(F1C100S_IRQ_USBOTG);
@@ -917,9 +916,11 @@ void dcd_disconnect(uint8_t rhport)
 void dcd_sof_enable(uint8_t rhport, bool en)
 {
   (void) rhport;
-  (void) en;
-
-  // TODO implement later
+  if (en) {
+    USBC_REG_set_bit_b(USBC_BP_INTUSBE_EN_SOF, USBC_REG_INTUSBE(USBC0_BASE));
+  } else {
+    USBC_REG_clear_bit_b(USBC_BP_INTUSBE_EN_SOF, USBC_REG_INTUSBE(USBC0_BASE));
+  }
 }
 
 void dcd_int_enable(uint8_t rhport)
@@ -1185,7 +1186,7 @@ void dcd_int_handler(uint8_t rhport)
 	dcd_event_bus_signal(rhport, DCD_EVENT_UNPLUGGED, true);
   }
   if (is & USBC_INTUSB_SOF) {
-    dcd_event_bus_signal(rhport, DCD_EVENT_SOF, true);
+    dcd_event_sof(rhport, USBC_Readw(USBC_REG_FRNUM(USBC0_BASE)), true);
   }
   if (is & USBC_INTUSB_RESET) {
     /* ep0 FADDR must be 0 when (re)entering peripheral mode */
@@ -35,6 +35,10 @@
 #error DWC2 require either CFG_TUD_DWC2_SLAVE_ENABLE or CFG_TUD_DWC2_DMA_ENABLE to be enabled
 #endif
 
+#if CFG_TUD_DWC2_DMA_SG_ENABLE && !CFG_TUD_DWC2_DMA_ENABLE
+#error CFG_TUD_DWC2_DMA_SG_ENABLE require CFG_TUD_DWC2_DMA_ENABLE
+#endif
+
 // Debug level for DWC2
 #define DWC2_DEBUG    2
 
@@ -56,6 +60,11 @@ typedef struct {
   uint16_t total_len;
   uint16_t max_size;
   uint8_t interval;
+#if CFG_TUD_DWC2_DMA_SG_ENABLE
+  uint8_t desc_count;                                   // descriptors used by current transfer
+  uint16_t desc_xfer_bytes;                             // requested bytes of current transfer
+  uint16_t desc_nbytes[CFG_TUD_DWC2_DMA_SG_DESC_COUNT]; // programmed bytes of each descriptor
+#endif
 } xfer_ctl_t;
 
 static xfer_ctl_t xfer_status[DWC2_EP_MAX][2];
@@ -69,6 +78,9 @@ typedef struct {
   // Number of IN endpoints active
   uint8_t allocated_epin_count;
 
+  // TX FIFO size in words planned for each IN endpoint of current configuration, 0 if not planned
+  uint16_t txf_plan[DWC2_EP_MAX];
+
   // SOF enabling flag - required for SOF to not get disabled in ISR when SOF was enabled by
   bool sof_en;
 } dcd_data_t;
@@ -77,8 +89,20 @@ static dcd_data_t _dcd_data;
 
 CFG_TUD_MEM_SECTION static struct {
   TUD_EPBUF_DEF(setup_packet, 8);
+#if CFG_TUD_DWC2_DMA_SG_ENABLE
+  TUD_EPBUF_TYPE_DEF(dwc2_dma_desc_t, setup_desc);
+#endif
 } _dcd_usbbuf;
 
+#if CFG_TUD_DWC2_DMA_SG_ENABLE
+TU_VERIFY_STATIC(CFG_TUD_DWC2_DMA_SG_DESC_COUNT >= 4, "Non-isochronous transfer may need up to 4 descriptors");
+
+typedef dwc2_dma_desc_t dma_desc_list_t[CFG_TUD_DWC2_DMA_SG_DESC_COUNT];
+
+// Descriptor list per endpoint direction, padded to cache line so that each list can be cleaned/invalidated on its own
+CFG_TUD_MEM_SECTION static TUD_EPBUF_TYPE_DEF(dma_desc_list_t, list) _dcd_dma_desc[DWC2_EP_MAX][2];
+#endif
+
 //--------------------------------------------------------------------
 // DMA
 //--------------------------------------------------------------------
@@ -105,6 +129,11 @@ TU_ATTR_ALWAYS_INLINE static inline bool dma_device_enabled(const dwc2_regs_t* d
   return CFG_TUD_DWC2_DMA_ENABLE && dwc2->ghwcfg2_bm.arch == GHWCFG2_ARCH_INTERNAL_DMA;
 }
 
+TU_ATTR_ALWAYS_INLINE static inline bool dma_sg_enabled(const dwc2_regs_t* dwc2) {
+  (void) dwc2;
+  return CFG_TUD_DWC2_DMA_SG_ENABLE && dma_device_enabled(dwc2) && dwc2->ghwcfg4_bm.dma_desc_enabled;
+}
+
 static void dma_setup_prepare(uint8_t rhport) {
   dwc2_regs_t* dwc2 = DWC2_REG(rhport);
 
@@ -114,12 +143,217 @@ static void dma_setup_prepare(uint8_t rhport) {
     }
   }
 
+#if CFG_TUD_DWC2_DMA_SG_ENABLE
+  if (dma_sg_enabled(dwc2)) {
+    // Single descriptor for 1 setup packet, completion is signaled by setup phase done interrupt
+    union {
+      uint32_t value;
+      dwc2_dma_desc_status_t bm;
+    } status;
+    status.value = 0;
+    status.bm.nbytes = 8;
+    status.bm.last = 1;
+    status.bm.buf_status = DMA_DESC_BS_HOST_READY;
+
+    dwc2_dma_desc_t* desc = &_dcd_usbbuf.setup_desc;
+    desc->buffer = (uint32_t) (uintptr_t) _dcd_usbbuf.setup_packet;
+    desc->status = status.value;
+    dcd_dcache_clean(desc, sizeof(dwc2_dma_desc_t));
+
+    dwc2->epout[0].doepdma = (uint32_t) (uintptr_t) desc;
+    dwc2->epout[0].doepctl |= DOEPCTL_EPENA | DOEPCTL_USBAEP;
+    return;
+  }
+#endif
+
   // Receive only 1 packet
   dwc2->epout[0].doeptsiz = (1 << DOEPTSIZ_STUPCNT_Pos) | (1 << DOEPTSIZ_PKTCNT_Pos) | (8 << DOEPTSIZ_XFRSIZ_Pos);
   dwc2->epout[0].doepdma = (uintptr_t) _dcd_usbbuf.setup_packet;
   dwc2->epout[0].doepctl |= DOEPCTL_EPENA | DOEPCTL_USBAEP;
 }
 
+#if CFG_TUD_DWC2_DMA_SG_ENABLE
+// Append descriptors for a linear buffer. Non-isochronous descriptor is limited to 64KB rounded down to packet size,
+// isochronous descriptor carries a single packet. OUT descriptor size is rounded up to packet size.
+static bool dma_desc_append(xfer_ctl_t* xfer, dwc2_dma_desc_t* list, bool is_iso, uint8_t dir,
+                            uint8_t* buf, uint16_t len) {
+  const uint16_t mps = xfer->max_size;
+  const uint16_t desc_max = is_iso ? mps : (uint16_t) (UINT16_MAX - (UINT16_MAX % mps));
+
+  do {
+    TU_ASSERT(xfer->desc_count < CFG_TUD_DWC2_DMA_SG_DESC_COUNT);
+    const uint16_t xact_bytes = tu_min16(len, desc_max);
+    uint16_t nbytes = xact_bytes;
+    if (dir == TUSB_DIR_OUT) {
+      nbytes = (uint16_t) (tu_div_ceil(nbytes, mps) * mps);
+    }
+
+    // Flags of last descriptor are set when the list is complete
+    dwc2_dma_desc_t* desc = &list[xfer->desc_count];
+    desc->buffer = (uint32_t) (uintptr_t) buf;
+    desc->status = nbytes; // also nbytes of isochronous layout, buffer status is host ready
+    xfer->desc_nbytes[xfer->desc_count] = nbytes;
+    xfer->desc_count++;
+
+    buf += xact_bytes;
+    len -= xact_bytes;
+  } while (len > 0);
+
+  return true;
+}
+
+// Bytes of an OUT segment that fit into room without letting a max size packet overflow it
+static uint16_t dma_out_fit(uint16_t want, uint16_t room, uint16_t mps) {
+  if (tu_div_ceil(want, mps) * mps <= room) {
+    return want;
+  }
+  want = tu_min16(want, room);
+  return (uint16_t) (want - (want % mps));
+}
+
+// Build descriptor list of current transfer and enable endpoint. FIFO transfer uses linear and wrapped part of the
+// FIFO directly, OUT data only continues into the wrapped part if the linear part is multiple of packet size.
+static bool edpt_schedule_desc(uint8_t rhport, uint8_t epnum, uint8_t dir, uint16_t total_bytes) {
+  dwc2_regs_t* dwc2 = DWC2_REG(rhport);
+  xfer_ctl_t* const xfer = XFER_CTL_BASE(epnum, dir);
+  dwc2_dep_t* dep = &dwc2->ep[dir == TUSB_DIR_IN ? 0 : 1][epnum];
+  dwc2_dma_desc_t* list = _dcd_dma_desc[epnum][dir].list;
+  const bool is_iso = (dep->ctl_bm.type == DEPCTL_EPTYPE_ISOCHRONOUS);
+  const uint16_t mps = xfer->max_size;
+
+  xfer->desc_count = 0;
+
+  if (xfer->ff != NULL) {
+    tu_fifo_buffer_info_t info;
+    uint16_t lin_bytes;
+    uint16_t wrap_bytes = 0;
+
+    if (dir == TUSB_DIR_IN) {
+      tu_fifo_get_read_info(xfer->ff, &info);
+      lin_bytes = tu_min16(total_bytes, (uint16_t) info.len_lin);
+      wrap_bytes = tu_min16((uint16_t) (total_bytes - lin_bytes), (uint16_t) info.len_wrap);
+    } else {
+      tu_fifo_get_write_info(xfer->ff, &info);
+      lin_bytes = dma_out_fit(total_bytes, (uint16_t) info.len_lin, mps);
+      if (lin_bytes == info.len_lin && lin_bytes < total_bytes) {
+        wrap_bytes = dma_out_fit((uint16_t) (total_bytes - lin_bytes), (uint16_t) info.len_wrap, mps);
+      }
+      TU_ASSERT(total_bytes == 0 || lin_bytes > 0);
+    }
+
+    TU_ASSERT(dma_desc_append(xfer, list, is_iso, dir, (uint8_t*) info.ptr_lin, lin_bytes));
+    if (wrap_bytes > 0) {
+      TU_ASSERT(dma_desc_append(xfer, list, is_iso, dir, (uint8_t*) info.ptr_wrap, wrap_bytes));
+    }
+
+    total_bytes = (uint16_t) (lin_bytes + wrap_bytes);
+    xfer->total_len = total_bytes;
+
+    if (dir == TUSB_DIR_IN) {
+      dcd_dcache_clean(info.ptr_lin, lin_bytes);
+      dcd_dcache_clean(info.ptr_wrap, wrap_bytes);
+    }
+  } else {
+    uint8_t* buf = xfer->buffer;
+    if (epnum == 0) {
+      // EP0 is scheduled one packet at a time
+      buf += xfer->total_len - _dcd_data.ep0_pending[dir] - total_bytes;
+    }
+    TU_ASSERT(dma_desc_append(xfer, list, is_iso, dir, buf, total_bytes));
+
+    if (dir == TUSB_DIR_IN) {
+      dcd_dcache_clean(buf, total_bytes);
+    }
+  }
+
+  xfer->desc_xfer_bytes = total_bytes;
+  const uint8_t last = (uint8_t) (xfer->desc_count - 1);
+
+  if (is_iso) {
+    // One (micro)frame per descriptor, IN descriptor is sent in its target frame
+    uint32_t frame = dwc2->dsts_bm.frame_number;
+    const uint32_t interval = 1u << (tu_max8(xfer->interval, 1) - 1);
+
+    for (uint8_t i = 0; i < xfer->desc_count; i++) {
+      union {
+        uint32_t value;
+        dwc2_dma_desc_iso_status_t bm;
+      } status;
+      status.value = list[i].status;
+
+      if (dir == TUSB_DIR_IN) {
+        frame += interval;
+        status.bm.frame_number = frame & 0x7FFu;
+        status.bm.pid = (status.bm.nbytes > 0) ? 1 : 0;
+      }
+      if (i == last) {
+        status.bm.last = 1;
+        status.bm.ioc = 1;
+      }
+      list[i].status = status.value;
+    }
+  } else {
+    union {
+      uint32_t value;
+      dwc2_dma_desc_status_t bm;
+    } status;
+    status.value = list[last].status;
+    status.bm.last = 1;
+    status.bm.ioc = 1;
+    if (dir == TUSB_DIR_IN && (total_bytes % mps) != 0) {
+      status.bm.short_packet = 1;
+    }
+    list[last].status = status.value;
+  }
+
+  dcd_dcache_clean(list, sizeof(dma_desc_list_t));
+
+  dep->diepdma = (uint32_t) (uintptr_t) list;
+  dep->diepctl |= EPCTL_CNAK | EPCTL_EPENA; // enable endpoint
+  return true;
+}
+
+// Collect result of closed descriptors: received bytes for OUT, return false if any descriptor has an error
+static bool dma_desc_xfer_result(xfer_ctl_t* xfer, dwc2_dma_desc_t const* list, bool is_iso, uint8_t dir,
+                                 uint16_t* xferred_bytes) {
+  bool success = true;
+  uint16_t count = 0;
+
+  dcd_dcache_invalidate(list, sizeof(dma_desc_list_t));
+
+  for (uint8_t i = 0; i < xfer->desc_count; i++) {
+    union {
+      uint32_t value;
+      dwc2_dma_desc_status_t bm;
+      dwc2_dma_desc_iso_status_t iso_bm;
+    } status;
+    status.value = list[i].status;
+
+    if (status.bm.buf_status != DMA_DESC_BS_DMA_DONE) {
+      break;
+    }
+    if (status.bm.xfer_status != DMA_DESC_STS_SUCCESS) {
+      success = false;
+    }
+
+    const uint16_t remain = (uint16_t) (is_iso ? status.iso_bm.nbytes : status.bm.nbytes);
+    if (dir == TUSB_DIR_OUT) {
+      const uint16_t received = (uint16_t) (xfer->desc_nbytes[i] - remain);
+      dcd_dcache_invalidate((void*) (uintptr_t) list[i].buffer, received);
+      count += received;
+
+      // short packet ends non-isochronous transfer
+      if (!is_iso && remain > 0) {
+        break;
+      }
+    }
+  }
+
+  *xferred_bytes = (dir == TUSB_DIR_OUT) ? tu_min16(count, xfer->desc_xfer_bytes) : xfer->desc_xfer_bytes;
+  return success;
+}
+#endif
+
 //--------------------------------------------------------------------+
 // Data FIFO
 //--------------------------------------------------------------------+
@@ -181,6 +415,15 @@ static bool dfifo_alloc(uint8_t rhport, uint8_t ep_addr, uint16_t packet_size) {
   TU_ASSERT(epnum < ep_count);
 
   uint16_t fifo_size = tu_div_ceil(packet_size, 4);
+  if (dir == TUSB_DIR_IN && _dcd_data.txf_plan[epnum] > 0) {
+    // FIFO is already planned for largest packet of all alternate settings
+    if ((dwc2->gahbcfg & GAHBCFG_TX_FIFO_EPMTY_LVL) == 0) {
+      fifo_size *= 2;
+    }
+    TU_ASSERT(fifo_size <= _dcd_data.txf_plan[epnum]);
+    return true;
+  }
+
   if (dir == TUSB_DIR_OUT) {
     // Calculate required size of RX FIFO
     const uint16_t new_sz = calc_device_grxfsiz(4 * fifo_size, ep_count);
@@ -224,18 +467,100 @@ static void dfifo_device_init(uint8_t rhport) {
   dwc2_regs_t* dwc2 = DWC2_REG(rhport);
   dwc2->grxfsiz = calc_device_grxfsiz(CFG_TUD_ENDPOINT0_SIZE, dwc2_controller->ep_count);
 
-  // Scatter/Gather DMA mode is not yet supported. Buffer DMA only need 1 words per endpoint direction
+  // Buffer DMA need 1 word, Scatter/Gather DMA need 4 words per endpoint direction
   const bool is_dma = dma_device_enabled(dwc2);
   _dcd_data.dfifo_top = dwc2_controller->ep_fifo_size/4;
   if (is_dma) {
-    _dcd_data.dfifo_top -= 2 * dwc2_controller->ep_count;
+    _dcd_data.dfifo_top -= (dma_sg_enabled(dwc2) ? 8 : 2) * dwc2_controller->ep_count;
   }
   dwc2->gdfifocfg = (_dcd_data.dfifo_top << GDFIFOCFG_EPINFOBASE_SHIFT) | _dcd_data.dfifo_top;
+  tu_memclr(_dcd_data.txf_plan, sizeof(_dcd_data.txf_plan));
 
   // Allocate FIFO for EP0 IN
   dfifo_alloc(rhport, 0x80, CFG_TUD_ENDPOINT0_SIZE);
 }
 
+// Plan FIFO for the whole configuration before its endpoints are opened. Each IN endpoint gets a TX FIFO for its largest
+// packet among all alternate settings, so that re-opening endpoints on SET_INTERFACE does not consume FIFO RAM again.
+// Remaining space is used to double buffer isochronous then bulk endpoints. If the plan does not fit, FIFO is
+// allocated when endpoint is opened as before.
+void dcd_edpt_config_plan(uint8_t rhport, const tusb_desc_configuration_t* desc_cfg) {
+  dwc2_regs_t* dwc2 = DWC2_REG(rhport);
+  const dwc2_controller_t* dwc2_controller = &_dwc2_controller[rhport];
+  const uint8_t ep_count = dwc2_controller->ep_count;
+
+  uint16_t txf_size[DWC2_EP_MAX] = { 0 }; // in words
+  uint32_t iso_mask = 0;
+  uint32_t bulk_mask = 0;
+  uint16_t out_largest = CFG_TUD_ENDPOINT0_SIZE;
+
+  const uint8_t* p_desc = (const uint8_t*) desc_cfg;
+  const uint8_t* desc_end = p_desc + tu_le16toh(desc_cfg->wTotalLength);
+  p_desc = tu_desc_next(p_desc);
+
+  while (p_desc < desc_end) {
+    if (tu_desc_type(p_desc) == TUSB_DESC_ENDPOINT) {
+      const tusb_desc_endpoint_t* desc_ep = (const tusb_desc_endpoint_t*) p_desc;
+      const uint8_t epnum = tu_edpt_number(desc_ep->bEndpointAddress);
+      const uint16_t packet_size = tu_edpt_packet_size(desc_ep);
+      TU_VERIFY(epnum > 0 && epnum < ep_count,);
+
+      if (tu_edpt_dir(desc_ep->bEndpointAddress) == TUSB_DIR_IN) {
+        txf_size[epnum] = tu_max16(txf_size[epnum], (uint16_t) tu_div_ceil(packet_size, 4));
+        if (desc_ep->bmAttributes.xfer == TUSB_XFER_ISOCHRONOUS) {
+          iso_mask |= TU_BIT(epnum);
+        } else if (desc_ep->bmAttributes.xfer == TUSB_XFER_BULK) {
+          bulk_mask |= TU_BIT(epnum);
+        }
+      } else {
+        out_largest = tu_max16(out_largest, packet_size);
+      }
+    }
+    p_desc = tu_desc_next(p_desc);
+  }
+
+  // If The TXFELVL is configured as half empty, the fifo must be twice the max_size.
+  const uint16_t txf_mul = (dwc2->gahbcfg & GAHBCFG_TX_FIFO_EPMTY_LVL) ? 1 : 2;
+
+  const uint16_t grxfsiz = tu_max16((uint16_t) dwc2->grxfsiz, calc_device_grxfsiz(out_largest, ep_count));
+  uint32_t txf_total = 0;
+  uint8_t epin_count = _dcd_data.allocated_epin_count;
+  for (uint8_t n = 1; n < ep_count; n++) {
+    txf_size[n] = (uint16_t) (txf_size[n] * txf_mul);
+    txf_total += txf_size[n];
+    if (txf_size[n] > 0) {
+      epin_count++;
+    }
+  }
+
+  TU_VERIFY(dwc2_controller->ep_in_count == 0 || epin_count <= dwc2_controller->ep_in_count,);
+  TU_VERIFY(grxfsiz + txf_total <= _dcd_data.dfifo_top,);
+  uint32_t spare = _dcd_data.dfifo_top - grxfsiz - txf_total;
+
+  // Double buffer isochronous endpoints first since they cannot retry, then bulk endpoints for throughput
+  const uint32_t dbuf_mask[2] = { iso_mask, bulk_mask };
+  for (uint8_t i = 0; i < 2; i++) {
+    for (uint8_t n = 1; n < ep_count; n++) {
+      if ((dbuf_mask[i] & TU_BIT(n)) && txf_size[n] <= spare) {
+        spare -= txf_size[n];
+        txf_size[n] = (uint16_t) (2 * txf_size[n]);
+      }
+    }
+  }
+
+  dwc2->grxfsiz = grxfsiz;
+  _dcd_data.allocated_epin_count = epin_count;
+
+  // Both TXFD and TXSA are in unit of 32-bit words, allocated from top to bottom
+  for (uint8_t n = 1; n < ep_count; n++) {
+    if (txf_size[n] > 0) {
+      _dcd_data.dfifo_top -= txf_size[n];
+      _dcd_data.txf_plan[n] = txf_size[n];
+      dwc2->dieptxf[n - 1] = ((uint32_t) txf_size[n] << DIEPTXF_INEPTXFD_Pos) | _dcd_data.dfifo_top;
+    }
+  }
+}
+
 
 //--------------------------------------------------------------------
 // Endpoint
@@ -321,7 +646,7 @@ static void edpt_disable(uint8_t rhport, uint8_t ep_addr, bool stall) {
   }
 }
 
-static void edpt_schedule_packets(uint8_t rhport, const uint8_t epnum, const uint8_t dir) {
+static bool edpt_schedule_packets(uint8_t rhport, const uint8_t epnum, const uint8_t dir) {
   dwc2_regs_t* dwc2 = DWC2_REG(rhport);
   xfer_ctl_t* const xfer = XFER_CTL_BASE(epnum, dir);
   dwc2_dep_t* dep = &dwc2->ep[dir == TUSB_DIR_IN ? 0 : 1][epnum];
@@ -342,6 +667,13 @@ static void edpt_schedule_packets(uint8_t rhport, const uint8_t epnum, const uin
     }
   }
 
+#if CFG_TUD_DWC2_DMA_SG_ENABLE
+  if (dma_sg_enabled(dwc2)) {
+    // transfer size and (micro)frame are described by descriptors
+    return edpt_schedule_desc(rhport, epnum, dir, total_bytes);
+  }
+#endif
+
   // transfer size: A full OUT transfer (multiple packets, possibly) triggers XFRC.
   union {
     uint32_t value;
@@ -386,6 +718,8 @@ static void edpt_schedule_packets(uint8_t rhport, const uint8_t epnum, const uin
       dwc2->diepempmsk |= (1 << epnum);
     }
   }
+
+  return true;
 }
 
 //--------------------------------------------------------------------
@@ -418,6 +752,9 @@ bool dcd_init(uint8_t rhport, const tusb_rhport_init_t* rh_init) {
   }
 
   dcfg |= DCFG_NZLSOHSK; // send STALL back and discard if host send non-zlp during control status
+  if (dma_sg_enabled(dwc2)) {
+    dcfg |= DCFG_DESCDMA;
+  }
   dwc2->dcfg = dcfg;
 
   dcd_disconnect(rhport);
@@ -462,6 +799,17 @@ void dcd_remote_wakeup(uint8_t rhport) {
 
   dwc2_regs_t* dwc2 = DWC2_REG(rhport);
 
+#if CFG_TUD_LPM
+  if (dwc2->glpmcfg & GLPMCFG_SLPSTS) {
+    // L1 remote wakeup: core clears RWUSIG by itself after 50us (TL1DevDrvResume)
+    TU_VERIFY(dwc2->glpmcfg & GLPMCFG_L1RSMOK,);
+    dwc2->gintsts = GINTSTS_SOF;
+    dwc2->gintmsk |= GINTMSK_SOFM;
+    dwc2->dctl |= DCTL_RWUSIG;
+    return;
+  }
+#endif
+
   // set remote wakeup
   dwc2->dctl |= DCTL_RWUSIG;
 
@@ -509,7 +857,40 @@ void dcd_disconnect(uint8_t rhport) {
   dwc2->dctl |= DCTL_SDIS;
 }
 
+#if CFG_TUD_LPM
+bool dcd_lpm_config(uint8_t rhport, bool enable, uint8_t besl_deep) {
+  dwc2_regs_t* dwc2 = DWC2_REG(rhport);
+  TU_VERIFY(dwc2->ghwcfg3_bm.lpm_mode);
+
+  uint32_t glpmcfg = dwc2->glpmcfg & ~(GLPMCFG_LPMEN | GLPMCFG_LPMACK | GLPMCFG_ENBESL | GLPMCFG_L1SSEN |
+                                       GLPMCFG_L1DSEN | GLPMCFG_BESLTHRS);
+  if (enable) {
+    // ACK all LPM token, gate PHY clock in L1. Also stop PHY (deep sleep) if host BESL is long enough
+    glpmcfg |= GLPMCFG_LPMEN | GLPMCFG_LPMACK | GLPMCFG_ENBESL | GLPMCFG_L1SSEN;
+    if (besl_deep <= 15) {
+      glpmcfg |= GLPMCFG_L1DSEN | ((uint32_t) besl_deep << GLPMCFG_BESLTHRS_Pos);
+    }
+    dwc2->glpmcfg = glpmcfg;
+    dwc2->gintsts = GINTSTS_LPMINT;
+    dwc2->gintmsk |= GINTMSK_LPMINTM;
+  } else {
+    dwc2->gintmsk &= ~GINTMSK_LPMINTM;
+    dwc2->glpmcfg = glpmcfg;
+  }
+
+  return true;
+}
+#endif
+
 // Be advised: audio, video and possibly other iso-ep classes use dcd_sof_enable() to enable/disable its corresponding ISR on purpose!
+void dcd_caps_get(uint8_t rhport, dcd_caps_t* caps) {
+  const dwc2_regs_t* dwc2 = DWC2_REG(rhport);
+  // internal DMA requires word-aligned buffer
+  if (dma_device_enabled(dwc2)) {
+    caps->mem_align = tu_max16(caps->mem_align, 4);
+  }
+}
+
 void dcd_sof_enable(uint8_t rhport, bool en) {
   (void) rhport;
   dwc2_regs_t* dwc2 = DWC2_REG(rhport);
@@ -587,9 +968,7 @@ bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint16_t to
   }
 
   // Schedule packets to be sent within interrupt
-  edpt_schedule_packets(rhport, epnum, dir);
-
-  return true;
+  return edpt_schedule_packets(rhport, epnum, dir);
 }
 
 // The number of bytes has to be given explicitly to allow more flexible control of how many
@@ -608,11 +987,9 @@ bool dcd_edpt_xfer_fifo(uint8_t rhport, uint8_t ep_addr, tu_fifo_t* ff, uint16_t
   xfer->ff = ff;
   xfer->total_len = total_bytes;
 
-  // Schedule packets to be sent within interrupt
-  // TODO xfer fifo may only available for slave mode
-  edpt_schedule_packets(rhport, epnum, dir);
-
-  return true;
+  // Schedule packets to be sent within interrupt. With Scatter/Gather DMA, FIFO is accessed directly by descriptors
+  // TODO xfer fifo is not available for Buffer DMA mode
+  return edpt_schedule_packets(rhport, epnum, dir);
 }
 
 void dcd_edpt_stall(uint8_t rhport, uint8_t ep_addr) {
@@ -892,10 +1269,26 @@ static void handle_epout_dma(uint8_t rhport, uint8_t epnum, dwc2_doepint_t doepi
       } else {
         dwc2_dep_t* epout = &dwc2->epout[epnum];
         xfer_ctl_t* xfer = XFER_CTL_BASE(epnum, TUSB_DIR_OUT);
+        xfer_result_t result = XFER_RESULT_SUCCESS;
 
         // determine actual received bytes
-        const uint16_t remain = epout->tsiz_bm.xfer_size;
-        xfer->total_len -= remain;
+#if CFG_TUD_DWC2_DMA_SG_ENABLE
+        if (dma_sg_enabled(dwc2)) {
+          const bool is_iso = (epout->ctl_bm.type == DEPCTL_EPTYPE_ISOCHRONOUS);
+          uint16_t received;
+          if (!dma_desc_xfer_result(xfer, _dcd_dma_desc[epnum][TUSB_DIR_OUT].list, is_iso, TUSB_DIR_OUT, &received)) {
+            result = XFER_RESULT_FAILED;
+          }
+          xfer->total_len -= (uint16_t) (xfer->desc_xfer_bytes - received);
+          if (xfer->ff != NULL) {
+            tu_fifo_advance_write_pointer(xfer->ff, received);
+          }
+        } else
+#endif
+        {
+          const uint16_t remain = epout->tsiz_bm.xfer_size;
+          xfer->total_len -= remain;
+        }
 
         // this is ZLP, so prepare EP0 for next setup
         // TODO use status phase rx
@@ -904,7 +1297,7 @@ static void handle_epout_dma(uint8_t rhport, uint8_t epnum, dwc2_doepint_t doepi
         }
 
         dcd_dcache_invalidate(xfer->buffer, xfer->total_len);
-        dcd_event_xfer_complete(rhport, epnum, xfer->total_len, XFER_RESULT_SUCCESS, true);
+        dcd_event_xfer_complete(rhport, epnum, xfer->total_len, result, true);
       }
     }
   }
@@ -921,7 +1314,23 @@ static void handle_epin_dma(uint8_t rhport, uint8_t epnum, dwc2_diepint_t diepin
       if(epnum == 0) {
         dma_setup_prepare(rhport);
       }
-      dcd_event_xfer_complete(rhport, epnum | TUSB_DIR_IN_MASK, xfer->total_len, XFER_RESULT_SUCCESS, true);
+
+      xfer_result_t result = XFER_RESULT_SUCCESS;
+#if CFG_TUD_DWC2_DMA_SG_ENABLE
+      dwc2_regs_t* dwc2 = DWC2_REG(rhport);
+      if (dma_sg_enabled(dwc2)) {
+        // isochronous descriptor missing its (micro)frame is reported with error status
+        const bool is_iso = (dwc2->epin[epnum].ctl_bm.type == DEPCTL_EPTYPE_ISOCHRONOUS);
+        uint16_t xferred_bytes;
+        if (!dma_desc_xfer_result(xfer, _dcd_dma_desc[epnum][TUSB_DIR_IN].list, is_iso, TUSB_DIR_IN, &xferred_bytes)) {
+          result = XFER_RESULT_FAILED;
+        }
+        if (xfer->ff != NULL) {
+          tu_fifo_advance_read_pointer(xfer->ff, xferred_bytes);
+        }
+      }
+#endif
+      dcd_event_xfer_complete(rhport, epnum | TUSB_DIR_IN_MASK, xfer->total_len, result, true);
     }
   }
 }
@@ -1005,10 +1414,21 @@ void dcd_int_handler(uint8_t rhport) {
   }
 
   if (gintsts & GINTSTS_WKUINT) {
+    // also asserted on L1 exit
     dwc2->gintsts = GINTSTS_WKUINT;
     dcd_event_bus_signal(rhport, DCD_EVENT_RESUME, true);
   }
 
+#if CFG_TUD_LPM
+  if (gintsts & GINTSTS_LPMINT) {
+    // LPM token is ACKed, link enters L1
+    dwc2->gintsts = GINTSTS_LPMINT;
+    const uint32_t glpmcfg = dwc2->glpmcfg;
+    dcd_event_lpm_sleep(rhport, (uint8_t) ((glpmcfg & GLPMCFG_BESL) >> GLPMCFG_BESL_Pos),
+                        (glpmcfg & GLPMCFG_REMWAKE) != 0, true);
+  }
+#endif
+
   // TODO check GINTSTS_DISCINT for disconnect detection
   // if(int_status & GINTSTS_DISCINT)
 
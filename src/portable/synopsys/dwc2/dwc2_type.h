@@ -632,6 +632,57 @@ typedef struct {
 
 TU_VERIFY_STATIC(sizeof(dwc2_dep_t) == 0x20, "incorrect size");
 
+// Device Scatter/Gather DMA descriptor: buffer status
+enum {
+  DMA_DESC_BS_HOST_READY = 0,
+  DMA_DESC_BS_DMA_BUSY   = 1,
+  DMA_DESC_BS_DMA_DONE   = 2,
+  DMA_DESC_BS_HOST_BUSY  = 3,
+};
+
+// Device Scatter/Gather DMA descriptor: Rx/Tx status
+enum {
+  DMA_DESC_STS_SUCCESS   = 0,
+  DMA_DESC_STS_BUFF_ERR  = 3,
+};
+
+// Device Scatter/Gather DMA descriptor quadlet for control, bulk and interrupt endpoint
+typedef struct TU_ATTR_PACKED {
+  uint32_t nbytes       : 16; // 0..15 Number of bytes, OUT: remaining bytes after transfer
+  uint32_t rsv16_22     :  7; // 16..22 Reserved
+  uint32_t mtrf         :  1; // 23 OUT: Multiple transfer
+  uint32_t setup_rx     :  1; // 24 OUT: Setup packet received
+  uint32_t ioc          :  1; // 25 Interrupt on complete
+  uint32_t short_packet :  1; // 26 Short packet
+  uint32_t last         :  1; // 27 Last descriptor of list
+  uint32_t xfer_status  :  2; // 28..29 Rx/Tx status
+  uint32_t buf_status   :  2; // 30..31 Buffer status
+} dwc2_dma_desc_status_t;
+TU_VERIFY_STATIC(sizeof(dwc2_dma_desc_status_t) == 4, "incorrect size");
+
+// Device Scatter/Gather DMA descriptor quadlet for isochronous endpoint
+typedef struct TU_ATTR_PACKED {
+  uint32_t nbytes       : 12; // 0..11 Number of bytes, OUT only use 0..10
+  uint32_t frame_number : 11; // 12..22 (Micro)frame number
+  uint32_t pid          :  2; // 23..24 IN: number of packets per (micro)frame, OUT: received PID
+  uint32_t ioc          :  1; // 25 Interrupt on complete
+  uint32_t short_packet :  1; // 26 Short packet
+  uint32_t last         :  1; // 27 Last descriptor of list
+  uint32_t xfer_status  :  2; // 28..29 Rx/Tx status
+  uint32_t buf_status   :  2; // 30..31 Buffer status
+} dwc2_dma_desc_iso_status_t;
+TU_VERIFY_STATIC(sizeof(dwc2_dma_desc_iso_status_t) == 4, "incorrect size");
+
+typedef struct {
+  union {
+    volatile uint32_t status;
+    volatile dwc2_dma_desc_status_t status_bm;
+    volatile dwc2_dma_desc_iso_status_t iso_status_bm;
+  };
+  volatile uint32_t buffer;
+} dwc2_dma_desc_t;
+TU_VERIFY_STATIC(sizeof(dwc2_dma_desc_t) == 8, "incorrect size");
+
 //--------------------------------------------------------------------
 // CSR Register Map
 //--------------------------------------------------------------------
@@ -936,6 +987,10 @@ TU_VERIFY_STATIC(offsetof(dwc2_regs_t, fifo   ) == 0x1000, "incorrect size");
 #define DCFG_XCVRDLY_Msk                 (0x1UL << DCFG_XCVRDLY_Pos)             // 0x00004000
 #define DCFG_XCVRDLY                     DCFG_XCVRDLY_Msk                        // Enables delay between xcvr_sel and txvalid during device chirp
 
+#define DCFG_DESCDMA_Pos                 (23U)
+#define DCFG_DESCDMA_Msk                 (0x1UL << DCFG_DESCDMA_Pos)              // 0x00800000
+#define DCFG_DESCDMA                     DCFG_DESCDMA_Msk                         // Enable scatter/gather DMA descriptor
+
 #define DCFG_PERSCHIVL_Pos               (24U)
 #define DCFG_PERSCHIVL_Msk               (0x3UL << DCFG_PERSCHIVL_Pos)            // 0x03000000
 #define DCFG_PERSCHIVL                   DCFG_PERSCHIVL_Msk                       // Periodic scheduling interval
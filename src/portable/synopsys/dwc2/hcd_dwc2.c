@@ -60,6 +60,26 @@ enum {
   HCD_XFER_PERIOD_SPLIT_NYET_MAX = 3
 };
 
+// Bulk IN is retried on the channel for a few NAKs, then endpoint is parked with exponential backoff (in frames)
+// to free the channel for other endpoints
+enum {
+  HCD_XFER_NAK_MAX = 4,
+  HCD_XFER_NAK_BACKOFF_SHIFT_MAX = 3 // up to 8 frames
+};
+
+// Split isochronous: transaction translator forwards up to 188 bytes of full speed data per microframe. Larger OUT
+// packet is sent as several start-splits whose position is marked with HCSPLT.XACTPOS
+enum {
+  HCD_SPLIT_ISO_UFRAME_BYTES = 188
+};
+
+enum {
+  HCSPLT_XACTPOS_MID   = 0,
+  HCSPLT_XACTPOS_END   = 1,
+  HCSPLT_XACTPOS_BEGIN = 2,
+  HCSPLT_XACTPOS_ALL   = 3
+};
+
 //--------------------------------------------------------------------
 //
 //--------------------------------------------------------------------
@@ -80,13 +100,18 @@ typedef struct {
     uint32_t speed    : 2;
     uint32_t next_pid : 2;
     uint32_t do_ping  : 1;
-    // uint32_t : 9;
+    uint32_t period_phase    : 6; // periodic slot assigned by bandwidth planner (microframe if highspeed, else frame)
+    uint32_t period_phase_en : 1;
+    // uint32_t : 2;
   };
 
   uint32_t uframe_countdown; // micro-frame count down to transfer for periodic, only need 18-bit
 
   uint8_t* buffer;
   uint16_t buflen;
+
+  uint8_t sched_pending; // non-periodic transfer is waiting for channel (or backoff) in scheduler
+  uint8_t nak_backoff;   // backoff shift applied when transfer is parked on NAK
 } hcd_endpoint_t;
 
 // Additional info for each channel when it is active
@@ -100,15 +125,43 @@ typedef struct {
     uint8_t halted_sof_schedule : 1;
   };
   uint8_t result;
+  uint8_t nak_count;
 
   uint16_t xferred_bytes;  // bytes that accumulate transferred though USB bus for the whole hcd_edpt_xfer(), which can
                            // be composed of multiple channel_xfer_start() (retry with NAK/NYET)
   uint16_t fifo_bytes;     // bytes written/read from/to FIFO (may not be transferred on USB bus).
 } hcd_xfer_t;
 
+#if CFG_TUH_ISO_EDPT_MAX
+// Isochronous transfer is carried out one packet per service interval, each packet is a channel transfer
+typedef struct {
+  uint8_t* buffer;
+  hcd_iso_packet_t* packets;
+  uint16_t n_packets;
+  uint16_t pkt_idx;       // packet in progress
+  uint32_t offset;        // buffer offset of packet in progress
+  uint32_t xferred_bytes;
+  bool failed;
+} hcd_iso_xfer_t;
+
+// Additional info for opened isochronous endpoint, up to 2 transfers are queued for continuous streaming
+typedef struct {
+  bool allocated;
+  uint8_t ep_id;
+  uint8_t xfer_head;
+  uint8_t xfer_count;
+  uint16_t split_offset; // bytes of current packet done by previous split transactions
+  hcd_iso_xfer_t xfer[2];
+} hcd_iso_edpt_t;
+#endif
+
 typedef struct {
   hcd_xfer_t xfer[DWC2_CHANNEL_COUNT_MAX];
   hcd_endpoint_t edpt[CFG_TUH_DWC2_ENDPOINT_MAX];
+#if CFG_TUH_ISO_EDPT_MAX
+  hcd_iso_edpt_t iso[CFG_TUH_ISO_EDPT_MAX];
+#endif
+  uint8_t sched_rr; // next endpoint to serve in round-robin of non-periodic scheduler
 } hcd_data_t;
 
 hcd_data_t _hcd_data;
@@ -186,6 +239,29 @@ TU_ATTR_ALWAYS_INLINE static inline void channel_dealloc(dwc2_regs_t* dwc2, uint
   dwc2->haintmsk &= ~TU_BIT(ch_id);
 }
 
+// Non-periodic transfer does not take the last free channel while a periodic endpoint is waiting for its slot
+static bool channel_available_non_periodic(dwc2_regs_t* dwc2) {
+  const uint8_t max_channel = DWC2_CHANNEL_COUNT(dwc2);
+  uint8_t free_count = 0;
+  for (uint8_t ch_id = 0; ch_id < max_channel; ch_id++) {
+    if (!_hcd_data.xfer[ch_id].allocated) {
+      free_count++;
+    }
+  }
+
+  if (free_count != 1) {
+    return free_count > 1;
+  }
+
+  for (uint8_t ep_id = 0; ep_id < CFG_TUH_DWC2_ENDPOINT_MAX; ep_id++) {
+    const hcd_endpoint_t* edpt = &_hcd_data.edpt[ep_id];
+    if (edpt->hcchar_bm.enable && edpt_is_periodic(edpt->hcchar_bm.ep_type) && edpt->uframe_countdown > 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
 TU_ATTR_ALWAYS_INLINE static inline bool channel_disable(const dwc2_regs_t* dwc2, dwc2_channel_t* channel) {
   // disable also require request queue
   TU_ASSERT(req_queue_avail(dwc2, edpt_is_periodic(channel->hcchar_bm.ep_type)));
@@ -242,6 +318,19 @@ TU_ATTR_ALWAYS_INLINE static inline uint8_t edpt_find_opened(uint8_t dev_addr, u
   return TUSB_INDEX_INVALID_8;
 }
 
+#if CFG_TUH_ISO_EDPT_MAX
+// Find isochronous info of an opened endpoint
+TU_ATTR_ALWAYS_INLINE static inline hcd_iso_edpt_t* iso_edpt_find(uint8_t ep_id) {
+  for (uint8_t i = 0; i < CFG_TUH_ISO_EDPT_MAX; i++) {
+    hcd_iso_edpt_t* iso = &_hcd_data.iso[i];
+    if (iso->allocated && iso->ep_id == ep_id) {
+      return iso;
+    }
+  }
+  return NULL;
+}
+#endif
+
 TU_ATTR_ALWAYS_INLINE static inline uint16_t cal_packet_count(uint16_t len, uint16_t ep_size) {
   if (len == 0) {
     return 1;
@@ -447,6 +536,12 @@ void hcd_device_close(uint8_t rhport, uint8_t dev_addr) {
   for (uint8_t i = 0; i < (uint8_t) CFG_TUH_DWC2_ENDPOINT_MAX; i++) {
     hcd_endpoint_t* edpt = &_hcd_data.edpt[i];
     if (edpt->hcchar_bm.enable && edpt->hcchar_bm.dev_addr == dev_addr) {
+      #if CFG_TUH_ISO_EDPT_MAX
+      hcd_iso_edpt_t* iso = iso_edpt_find(i);
+      if (iso) {
+        tu_memclr(iso, sizeof(hcd_iso_edpt_t));
+      }
+      #endif
       tu_memclr(edpt, sizeof(hcd_endpoint_t));
     }
   }
@@ -464,6 +559,22 @@ bool hcd_edpt_open(uint8_t rhport, uint8_t dev_addr, const tusb_desc_endpoint_t*
   hcd_devtree_info_t devtree_info;
   hcd_devtree_get_info(dev_addr, &devtree_info);
 
+#if CFG_TUH_ISO_EDPT_MAX
+  hcd_iso_edpt_t* iso = NULL;
+  if (desc_ep->bmAttributes.xfer == TUSB_XFER_ISOCHRONOUS) {
+    // split isochronous is chained from channel halted interrupt, which is only available with DMA
+    TU_VERIFY(rh_speed != TUSB_SPEED_HIGH || devtree_info.speed == TUSB_SPEED_HIGH || dma_host_enabled(dwc2));
+    for (uint8_t i = 0; i < CFG_TUH_ISO_EDPT_MAX && iso == NULL; i++) {
+      if (!_hcd_data.iso[i].allocated) {
+        iso = &_hcd_data.iso[i];
+      }
+    }
+    TU_ASSERT(iso != NULL);
+  }
+#else
+  TU_VERIFY(desc_ep->bmAttributes.xfer != TUSB_XFER_ISOCHRONOUS);
+#endif
+
   // find a free endpoint
   const uint8_t ep_id = edpt_alloc();
   TU_ASSERT(ep_id < CFG_TUH_DWC2_ENDPOINT_MAX);
@@ -503,9 +614,75 @@ bool hcd_edpt_open(uint8_t rhport, uint8_t dev_addr, const tusb_desc_endpoint_t*
     }
   }
 
+  // Reserve periodic bandwidth and spread endpoints over (micro)frames. Split transaction is also budgeted on the hub's
+  // TT, its start-split is issued in the assigned microframe.
+  edpt->period_phase_en = 0;
+  if (edpt_is_periodic(hcchar_bm->ep_type)) {
+    const bool is_hs = (rh_speed == TUSB_SPEED_HIGH);
+    if (hcsplt_bm->split_en || !is_hs) {
+      // full speed interval can be any ms, round down to power of 2 for a fixed frame pattern
+      edpt->uframe_interval = ((1u << tu_log2(tu_max32(edpt->uframe_interval >> 3, 1))) << 3) & 0x3FFFFu;
+    }
+
+    const uint16_t period = (uint16_t) (is_hs ? edpt->uframe_interval : (edpt->uframe_interval >> 3));
+    int16_t phase;
+    if (hcsplt_bm->split_en) {
+      uint8_t smask;
+      phase = hcd_bw_reserve_split(dev_addr, desc_ep, period >> 3, 0, period >> 3, &smask, NULL);
+      if (phase >= 0) {
+        // convert to microframe of first start-split
+        uint8_t uf = 0;
+        while (!tu_bit_test(smask, uf)) {
+          uf++;
+        }
+        phase = (int16_t) (phase * 8 + uf);
+      }
+    } else {
+      phase = hcd_bw_reserve(dev_addr, desc_ep, is_hs, period, 0, period);
+    }
+
+    if (phase < 0) {
+      edpt->hcchar_bm.enable = 0; // free endpoint
+      return false;
+    }
+
+    edpt->period_phase = (uint8_t) phase & 0x3Fu;
+    edpt->period_phase_en = 1;
+  }
+
+#if CFG_TUH_ISO_EDPT_MAX
+  if (iso != NULL) {
+    // high bandwidth: additional transactions per microframe
+    const uint8_t mult = (uint8_t) ((tu_le16toh(desc_ep->wMaxPacketSize) >> 11) & 0x3u) + 1;
+    hcchar_bm->err_multi_count = (devtree_info.speed == TUSB_SPEED_HIGH) ? mult : 1;
+    tu_memclr(iso, sizeof(hcd_iso_edpt_t));
+    iso->allocated = true;
+    iso->ep_id = ep_id;
+  }
+#endif
+
   return true;
 }
 
+// micro-frames until next slot of a periodic endpoint assigned by bandwidth planner
+static uint32_t edpt_period_countdown(dwc2_regs_t* dwc2, const hcd_endpoint_t* edpt) {
+  if (!edpt->period_phase_en) {
+    return edpt->uframe_interval;
+  }
+
+  // frame number counts microframes in highspeed, wrap-around is multiple of any period
+  const bool is_hs = (hprt_speed_get(dwc2) == TUSB_SPEED_HIGH);
+  const uint32_t period = is_hs ? edpt->uframe_interval : (edpt->uframe_interval >> 3);
+  const uint32_t now = (dwc2->hfnum & HFNUM_FRNUM_Msk) % period;
+
+  uint32_t wait = (edpt->period_phase + period - now) % period;
+  if (wait == 0) {
+    wait = period;
+  }
+
+  return is_hs ? wait : (wait << 3);
+}
+
 // clean up channel after part of transfer is done but the whole urb is not complete
 static void channel_xfer_out_wrapup(dwc2_regs_t* dwc2, uint8_t ch_id) {
   hcd_xfer_t* xfer = &_hcd_data.xfer[ch_id];
@@ -581,7 +758,10 @@ static bool channel_xfer_start(dwc2_regs_t* dwc2, uint8_t ch_id) {
     }
   } else {
     uint32_t hcintmsk = HCINT_NAK | HCINT_XACT_ERR | HCINT_STALL | HCINT_XFER_COMPLETE | HCINT_DATATOGGLE_ERR;
-    if (hcchar_bm->ep_dir == TUSB_DIR_IN) {
+    if (hcchar_bm->ep_type == HCCHAR_EPTYPE_ISOCHRONOUS) {
+      // no handshake, packet is either received/sent or lost
+      hcintmsk = HCINT_XACT_ERR | HCINT_XFER_COMPLETE | HCINT_DATATOGGLE_ERR | HCINT_BABBLE_ERR | HCINT_FARME_OVERRUN;
+    } else if (hcchar_bm->ep_dir == TUSB_DIR_IN) {
       hcintmsk |= HCINT_BABBLE_ERR | HCINT_DATATOGGLE_ERR | HCINT_ACK;
     } else {
       hcintmsk |= HCINT_NYET;
@@ -612,17 +792,146 @@ static bool channel_xfer_start(dwc2_regs_t* dwc2, uint8_t ch_id) {
   return true;
 }
 
-// kick-off transfer with an endpoint
+// kick-off transfer with an endpoint, return false if there is no channel available
 static bool edpt_xfer_kickoff(dwc2_regs_t* dwc2, uint8_t ep_id) {
+  hcd_endpoint_t* edpt = &_hcd_data.edpt[ep_id];
+  if (!edpt_is_periodic(edpt->hcchar_bm.ep_type)) {
+    TU_VERIFY(channel_available_non_periodic(dwc2));
+  }
+
   uint8_t ch_id = channel_alloc(dwc2);
-  TU_ASSERT(ch_id < 16); // all channel are in used
+  TU_VERIFY(ch_id < 16); // all channel are in used
   hcd_xfer_t* xfer = &_hcd_data.xfer[ch_id];
   xfer->ep_id = ep_id;
   xfer->result = XFER_RESULT_INVALID;
+  edpt->sched_pending = 0;
 
   return channel_xfer_start(dwc2, ch_id);
 }
 
+// Park endpoint's transfer in scheduler: started in SOF interrupt after countdown or when a channel is freed
+static void edpt_xfer_park(dwc2_regs_t* dwc2, uint8_t ep_id, uint32_t uframes) {
+  hcd_endpoint_t* edpt = &_hcd_data.edpt[ep_id];
+  if (edpt_is_periodic(edpt->hcchar_bm.ep_type)) {
+    edpt->uframe_countdown = tu_max32(uframes, 1);
+  } else {
+    edpt->uframe_countdown = uframes;
+    edpt->sched_pending = 1;
+  }
+  dwc2->gintmsk |= GINTSTS_SOF;
+}
+
+// Start parked non-periodic transfers whose backoff is over, round-robin while there is free channel.
+// Return true if there is still parked transfer
+static bool sched_start_pending(dwc2_regs_t* dwc2, uint32_t elapsed_uframes) {
+  bool has_channel = true;
+  bool more_pending = false;
+  const uint8_t rr_start = _hcd_data.sched_rr;
+
+  for (uint8_t i = 0; i < CFG_TUH_DWC2_ENDPOINT_MAX; i++) {
+    const uint8_t ep_id = (uint8_t) ((rr_start + i) % CFG_TUH_DWC2_ENDPOINT_MAX);
+    hcd_endpoint_t* edpt = &_hcd_data.edpt[ep_id];
+    if (!(edpt->hcchar_bm.enable && edpt->sched_pending)) {
+      continue;
+    }
+
+    edpt->uframe_countdown -= tu_min32(elapsed_uframes, edpt->uframe_countdown);
+    if (edpt->uframe_countdown == 0 && has_channel) {
+      if (edpt_xfer_kickoff(dwc2, ep_id)) {
+        _hcd_data.sched_rr = (uint8_t) ((ep_id + 1) % CFG_TUH_DWC2_ENDPOINT_MAX);
+        continue;
+      }
+      has_channel = false;
+    }
+    more_pending = true;
+  }
+
+  return more_pending;
+}
+
+#if CFG_TUH_ISO_EDPT_MAX
+// Prepare endpoint for current packet of head transfer
+static void iso_packet_load(hcd_endpoint_t* edpt, const hcd_iso_edpt_t* iso) {
+  const hcd_iso_xfer_t* ixfer = &iso->xfer[iso->xfer_head];
+  const uint16_t pkt_len = ixfer->packets[ixfer->pkt_idx].len;
+  edpt->buffer = ixfer->buffer + ixfer->offset;
+  edpt->buflen = pkt_len;
+
+  if (edpt->hcsplt_bm.split_en) {
+    // full speed isochronous is always DATA0. IN packet is fetched by complete-splits as a whole, OUT packet larger
+    // than a microframe budget is sent in pieces by consecutive start-splits
+    edpt->next_pid = HCTSIZ_PID_DATA0;
+    edpt->hcsplt_bm.split_compl = 0;
+    edpt->hcsplt_bm.xact_pos = HCSPLT_XACTPOS_ALL;
+    if (edpt->hcchar_bm.ep_dir == TUSB_DIR_OUT && pkt_len > HCD_SPLIT_ISO_UFRAME_BYTES) {
+      const uint16_t remain = pkt_len - iso->split_offset;
+      edpt->buffer += iso->split_offset;
+      edpt->buflen = tu_min16(remain, HCD_SPLIT_ISO_UFRAME_BYTES);
+      if (iso->split_offset == 0) {
+        edpt->hcsplt_bm.xact_pos = HCSPLT_XACTPOS_BEGIN;
+      } else if (remain <= HCD_SPLIT_ISO_UFRAME_BYTES) {
+        edpt->hcsplt_bm.xact_pos = HCSPLT_XACTPOS_END;
+      } else {
+        edpt->hcsplt_bm.xact_pos = HCSPLT_XACTPOS_MID;
+      }
+    }
+    return;
+  }
+
+  // high bandwidth start with PID of number of transactions: DATA0 (1), DATA1 (2), DATA2 (3)
+  switch (cal_packet_count(edpt->buflen, edpt->hcchar_bm.ep_size)) {
+    case 2:  edpt->next_pid = HCTSIZ_PID_DATA1; break;
+    case 3:  edpt->next_pid = HCTSIZ_PID_DATA2; break;
+    default: edpt->next_pid = HCTSIZ_PID_DATA0; break;
+  }
+}
+
+// Schedule current packet in the endpoint's next service interval
+static void iso_packet_arm(dwc2_regs_t* dwc2, uint8_t ep_id) {
+  hcd_endpoint_t* edpt = &_hcd_data.edpt[ep_id];
+  iso_packet_load(edpt, iso_edpt_find(ep_id));
+  edpt->uframe_countdown = edpt_period_countdown(dwc2, edpt);
+  dwc2->gintmsk |= GINTSTS_SOF;
+}
+
+bool hcd_edpt_iso_xfer(uint8_t rhport, uint8_t dev_addr, uint8_t ep_addr, uint8_t* buffer, hcd_iso_packet_t* packets,
+                       uint16_t n_packets) {
+  dwc2_regs_t* dwc2 = DWC2_REG(rhport);
+  const uint8_t ep_id = edpt_find_opened(dev_addr, tu_edpt_number(ep_addr), tu_edpt_dir(ep_addr));
+  TU_ASSERT(ep_id < CFG_TUH_DWC2_ENDPOINT_MAX);
+  hcd_endpoint_t* edpt = &_hcd_data.edpt[ep_id];
+  hcd_iso_edpt_t* iso = iso_edpt_find(ep_id);
+  TU_ASSERT(iso != NULL && n_packets > 0);
+
+  const uint16_t max_len = (uint16_t) (edpt->hcchar_bm.ep_size * tu_max8(edpt->hcchar_bm.err_multi_count, 1));
+  for (uint16_t i = 0; i < n_packets; i++) {
+    TU_ASSERT(packets[i].len <= max_len);
+    packets[i].actual_len = 0;
+    packets[i].result = XFER_RESULT_INVALID;
+  }
+
+  bool ret = false;
+  hcd_int_disable(rhport);
+  if (iso->xfer_count < 2) {
+    hcd_iso_xfer_t* ixfer = &iso->xfer[(iso->xfer_head + iso->xfer_count) & 1u];
+    tu_memclr(ixfer, sizeof(hcd_iso_xfer_t));
+    ixfer->buffer = buffer;
+    ixfer->packets = packets;
+    ixfer->n_packets = n_packets;
+    iso->xfer_count++;
+
+    // queued transfer continues right after the current one
+    if (iso->xfer_count == 1) {
+      iso_packet_arm(dwc2, ep_id);
+    }
+    ret = true;
+  }
+  hcd_int_enable(rhport);
+
+  return ret;
+}
+#endif
+
 // Submit a transfer, when complete hcd_event_xfer_complete() must be invoked
 bool hcd_edpt_xfer(uint8_t rhport, uint8_t dev_addr, uint8_t ep_addr, uint8_t * buffer, uint16_t buflen) {
   dwc2_regs_t* dwc2 = DWC2_REG(rhport);
@@ -641,7 +950,13 @@ bool hcd_edpt_xfer(uint8_t rhport, uint8_t dev_addr, uint8_t ep_addr, uint8_t *
     edpt->hcchar_bm.ep_dir = ep_dir;
   }
 
-  return edpt_xfer_kickoff(dwc2, ep_id);
+  edpt->nak_backoff = 0;
+  if (!edpt_xfer_kickoff(dwc2, ep_id)) {
+    // all channels are busy, scheduler starts the transfer once a channel is free
+    edpt_xfer_park(dwc2, ep_id, 0);
+  }
+
+  return true;
 }
 
 // Abort a queued transfer. Note: it can only abort transfer that has not been started
@@ -653,6 +968,28 @@ bool hcd_edpt_abort_xfer(uint8_t rhport, uint8_t dev_addr, uint8_t ep_addr) {
   const uint8_t ep_id = edpt_find_opened(dev_addr, ep_num, ep_dir);
   TU_VERIFY(ep_id < CFG_TUH_DWC2_ENDPOINT_MAX);
 
+#if CFG_TUH_ISO_EDPT_MAX
+  // drop all queued isochronous transfers, in-flight packet is discarded when its channel halts
+  hcd_iso_edpt_t* iso = iso_edpt_find(ep_id);
+  if (iso != NULL) {
+    hcd_int_disable(rhport);
+    iso->xfer_count = 0;
+    iso->split_offset = 0;
+    _hcd_data.edpt[ep_id].uframe_countdown = 0;
+    hcd_int_enable(rhport);
+  }
+#endif
+
+  // transfer parked in scheduler has no channel yet
+  hcd_endpoint_t* edpt = &_hcd_data.edpt[ep_id];
+  if (edpt->sched_pending) {
+    hcd_int_disable(rhport);
+    edpt->sched_pending = 0;
+    edpt->uframe_countdown = 0;
+    hcd_int_enable(rhport);
+    return true;
+  }
+
   // hcd_int_disable(rhport);
 
   // Find enabled channeled and disable it, channel will be de-allocated in the interrupt handler
@@ -716,7 +1053,7 @@ static void channel_xfer_in_retry(dwc2_regs_t* dwc2, uint8_t ch_id, uint32_t hci
 
     // for periodic, de-allocate channel, enable SOF set frame counter for later transfer
     edpt->next_pid = channel->hctsiz_bm.pid; // save PID
-    edpt->uframe_countdown = edpt->uframe_interval;
+    edpt->uframe_countdown = edpt_period_countdown(dwc2, edpt);
     dwc2->gintmsk |= GINTSTS_SOF;
 
     if (hcint & HCINT_HALTED) {
@@ -727,6 +1064,21 @@ static void channel_xfer_in_retry(dwc2_regs_t* dwc2, uint8_t ch_id, uint32_t hci
       xfer->halted_sof_schedule = 1;
       channel_disable(dwc2, channel);
     }
+  } else if (channel->hcchar_bm.ep_type == HCCHAR_EPTYPE_BULK && xfer->xferred_bytes == 0 && xfer->fifo_bytes == 0 &&
+             ++xfer->nak_count >= HCD_XFER_NAK_MAX) {
+    // bulk keeps NAKing without data: park endpoint with backoff instead of spinning on the channel
+    edpt->next_pid = channel->hctsiz_bm.pid; // save PID
+    edpt_xfer_park(dwc2, xfer->ep_id, 8u << edpt->nak_backoff);
+    if (edpt->nak_backoff < HCD_XFER_NAK_BACKOFF_SHIFT_MAX) {
+      edpt->nak_backoff++;
+    }
+
+    if (hcint & HCINT_HALTED) {
+      channel_dealloc(dwc2, ch_id);
+    } else {
+      xfer->halted_sof_schedule = 1;
+      channel_disable(dwc2, channel);
+    }
   } else {
     // for control/bulk: retry immediately
     channel_send_in_token(dwc2, channel);
@@ -781,12 +1133,11 @@ static void handle_rxflvl_irq(uint8_t rhport) {
       break;
 
     case GRXSTS_PKTSTS_HOST_DATATOGGLE_ERR:
-      TU_ASSERT(0, ); // maybe try to change DToggle
+      // data is discarded by core and channel raises HCINT_DATATOGGLE_ERR, which is retried by channel handler
       break;
 
     case GRXSTS_PKTSTS_HOST_CHANNEL_HALTED:
-      // triggered when channel.hcchar_bm.disable is set
-      // TODO handle later
+      // triggered when channel.hcchar_bm.disable is set, channel is released by HCINT_HALTED in handle_channel_irq()
       break;
 
     default: break; // ignore other status
@@ -1043,8 +1394,7 @@ static bool handle_channel_in_dma(dwc2_regs_t* dwc2, uint8_t ch_id, uint32_t hci
       xfer->err_count = 0;
       channel->hcintmsk &= ~HCINT_ACK;
       if (channel->hcsplt_bm.split_en) {
-        // start split is ACK --> do complete split
-        // TODO: for ISO must use xact_pos to plan complete split based on microframe (up to 187.5 bytes/uframe)
+        // start split is ACK --> do complete split (isochronous split is handled by iso_split_continue())
         channel->hcsplt_bm.split_compl = 1;
         if (edpt_is_periodic(channel->hcchar_bm.ep_type)) {
           channel->hcchar_bm.odd_frame = 1 - (dwc2->hfnum & 1); // transfer on next frame
@@ -1126,6 +1476,156 @@ static bool handle_channel_out_dma(dwc2_regs_t* dwc2, uint8_t ch_id, uint32_t hc
 }
 #endif
 
+#if CFG_TUH_ISO_EDPT_MAX
+// Complete current isochronous packet, transfer is complete when all its packets are done
+static void iso_packet_done(dwc2_regs_t* dwc2, uint8_t ep_id, uint16_t actual_len, xfer_result_t result, bool in_isr) {
+  hcd_iso_edpt_t* iso = iso_edpt_find(ep_id);
+  if (iso == NULL || iso->xfer_count == 0) {
+    return; // aborted
+  }
+  const hcd_endpoint_t* edpt = &_hcd_data.edpt[ep_id];
+  hcd_iso_xfer_t* ixfer = &iso->xfer[iso->xfer_head];
+  hcd_iso_packet_t* pkt = &ixfer->packets[ixfer->pkt_idx];
+
+  iso->split_offset = 0;
+  pkt->actual_len = actual_len;
+  pkt->result = (uint8_t) result;
+  ixfer->xferred_bytes += actual_len;
+  ixfer->offset += pkt->len;
+  if (result != XFER_RESULT_SUCCESS) {
+    ixfer->failed = true;
+  }
+
+  ixfer->pkt_idx++;
+  if (ixfer->pkt_idx == ixfer->n_packets) {
+    const uint8_t ep_addr = tu_edpt_addr(edpt->hcchar_bm.ep_num, edpt->hcchar_bm.ep_dir);
+    if (edpt->hcchar_bm.ep_dir == TUSB_DIR_IN && dma_host_enabled(dwc2)) {
+      hcd_dcache_invalidate(ixfer->buffer, ixfer->offset);
+    }
+
+    iso->xfer_head ^= 1u;
+    iso->xfer_count--;
+    hcd_event_xfer_complete(edpt->hcchar_bm.dev_addr, ep_addr, ixfer->xferred_bytes,
+                            ixfer->failed ? XFER_RESULT_FAILED : XFER_RESULT_SUCCESS, in_isr);
+  }
+
+  if (iso->xfer_count > 0) {
+    iso_packet_arm(dwc2, ep_id);
+  }
+}
+
+#if CFG_TUH_DWC2_DMA_ENABLE
+// Chain next split transaction of current isochronous packet on the same channel (DMA only, channel is halted):
+// - IN : start-split is ACKed by TT, then complete-split every microframe. NYET means TT has no data yet, MDATA means
+//        the full speed packet continues in next microframe
+// - OUT: no handshake, next up-to-188-byte piece is sent with start-split in next microframe
+// Return false if packet is done (or failed) and should be completed by caller
+static bool iso_split_continue(dwc2_regs_t* dwc2, uint8_t ch_id, uint32_t hcint) {
+  hcd_xfer_t* xfer = &_hcd_data.xfer[ch_id];
+  dwc2_channel_t* channel = &dwc2->channel[ch_id];
+  hcd_endpoint_t* edpt = &_hcd_data.edpt[xfer->ep_id];
+  hcd_iso_edpt_t* iso = iso_edpt_find(xfer->ep_id);
+
+  if (iso == NULL || iso->xfer_count == 0 ||
+      (hcint & (HCINT_XACT_ERR | HCINT_BABBLE_ERR | HCINT_FARME_OVERRUN | HCINT_DATATOGGLE_ERR | HCINT_STALL |
+                HCINT_AHB_ERR))) {
+    return false;
+  }
+
+  if (channel->hcchar_bm.ep_dir == TUSB_DIR_IN) {
+    if (!channel->hcsplt_bm.split_compl) {
+      if (!(hcint & HCINT_ACK)) {
+        return false;
+      }
+      edpt->hcsplt_bm.split_compl = 1;
+      xfer->period_split_nyet_count = 0;
+    } else if (hcint & HCINT_XFER_COMPLETE) {
+      const uint16_t actual_len = (uint16_t) (edpt->buflen - channel->hctsiz_bm.xfer_size);
+      iso->split_offset += actual_len;
+      if (channel->hctsiz_bm.pid != HCTSIZ_PID_MDATA || actual_len == 0 || actual_len == edpt->buflen) {
+        return false; // DATA0 is the last part of packet
+      }
+      edpt->buffer += actual_len;
+      edpt->buflen -= actual_len;
+      xfer->period_split_nyet_count = 0;
+    } else if (hcint & HCINT_NYET) {
+      xfer->period_split_nyet_count++;
+      if (xfer->period_split_nyet_count >= HCD_XFER_PERIOD_SPLIT_NYET_MAX) {
+        return false;
+      }
+    } else {
+      return false;
+    }
+  } else {
+    if (!(hcint & HCINT_XFER_COMPLETE)) {
+      return false;
+    }
+    iso->split_offset += edpt->buflen;
+    const hcd_iso_xfer_t* ixfer = &iso->xfer[iso->xfer_head];
+    if (iso->split_offset >= ixfer->packets[ixfer->pkt_idx].len) {
+      return false;
+    }
+    iso_packet_load(edpt, iso);
+  }
+
+  // channel_xfer_start() schedules the transaction in next microframe
+  channel_xfer_start(dwc2, ch_id);
+  return true;
+}
+#endif
+
+// Isochronous is never retried: packet is done when transferred or on any error
+static void handle_channel_iso(dwc2_regs_t* dwc2, uint8_t ch_id, uint32_t hcint, bool is_dma, bool in_isr) {
+  hcd_xfer_t* xfer = &_hcd_data.xfer[ch_id];
+  dwc2_channel_t* channel = &dwc2->channel[ch_id];
+  const hcd_endpoint_t* edpt = &_hcd_data.edpt[xfer->ep_id];
+  const bool is_in = (channel->hcchar_bm.ep_dir == TUSB_DIR_IN);
+  const bool is_split = (edpt->hcsplt_bm.split_en != 0);
+
+  #if CFG_TUH_DWC2_DMA_ENABLE
+  if (is_dma && is_split && xfer->result == XFER_RESULT_INVALID && iso_split_continue(dwc2, ch_id, hcint)) {
+    return;
+  }
+  #endif
+
+  if (xfer->result == XFER_RESULT_INVALID) {
+    if (hcint & HCINT_XFER_COMPLETE) {
+      xfer->result = XFER_RESULT_SUCCESS;
+    } else if (hcint & (HCINT_XACT_ERR | HCINT_BABBLE_ERR | HCINT_FARME_OVERRUN | HCINT_DATATOGGLE_ERR |
+                        HCINT_STALL | HCINT_AHB_ERR)) {
+      xfer->result = XFER_RESULT_FAILED;
+    } else if (!(hcint & HCINT_HALTED)) {
+      return;
+    } else {
+      xfer->result = XFER_RESULT_FAILED; // halted by abort
+    }
+  }
+
+  // slave: IN and failed OUT must wait for channel halted before it can be released
+  if (!is_dma && !(hcint & HCINT_HALTED) && (is_in || xfer->result != XFER_RESULT_SUCCESS)) {
+    channel_disable(dwc2, channel);
+    return;
+  }
+
+  uint16_t actual_len = 0;
+  if (xfer->result == XFER_RESULT_SUCCESS) {
+    if (is_split) {
+      actual_len = iso_edpt_find(xfer->ep_id)->split_offset; // accumulated by iso_split_continue()
+    } else if (!is_in) {
+      actual_len = edpt->buflen;
+    } else if (is_dma) {
+      actual_len = (uint16_t) (edpt->buflen - channel->hctsiz_bm.xfer_size);
+    } else {
+      actual_len = xfer->xferred_bytes; // accumulated by rx fifo handler
+    }
+  }
+
+  const uint8_t ep_id = xfer->ep_id;
+  channel_dealloc(dwc2, ch_id);
+  iso_packet_done(dwc2, ep_id, actual_len, (xfer_result_t) xfer->result, in_isr);
+}
+#endif
+
 static void handle_channel_irq(uint8_t rhport, bool in_isr) {
   dwc2_regs_t* dwc2 = DWC2_REG(rhport);
   const bool is_dma = dma_host_enabled(dwc2);
@@ -1141,6 +1641,13 @@ static void handle_channel_irq(uint8_t rhport, bool in_isr) {
       const uint32_t hcint = channel->hcint;
       channel->hcint = hcint; // clear interrupt
 
+      #if CFG_TUH_ISO_EDPT_MAX
+      if (hcchar_bm.ep_type == HCCHAR_EPTYPE_ISOCHRONOUS) {
+        handle_channel_iso(dwc2, ch_id, hcint, is_dma, in_isr);
+        continue;
+      }
+      #endif
+
       bool is_done = false;
       if (is_dma) {
         #if CFG_TUH_DWC2_DMA_ENABLE
@@ -1171,6 +1678,9 @@ static void handle_channel_irq(uint8_t rhport, bool in_isr) {
       }
     }
   }
+
+  // give freed channels to parked transfers
+  sched_start_pending(dwc2, 0);
 }
 
 // SOF is enabled for scheduled periodic transfer
@@ -1189,6 +1699,14 @@ static bool handle_sof_irq(uint8_t rhport, bool in_isr) {
       edpt->uframe_countdown -= tu_min32(ucount, edpt->uframe_countdown);
       if (edpt->uframe_countdown == 0) {
         if (!edpt_xfer_kickoff(dwc2, ep_id)) {
+          #if CFG_TUH_ISO_EDPT_MAX
+          if (edpt->hcchar_bm.ep_type == HCCHAR_EPTYPE_ISOCHRONOUS) {
+            // service interval is missed, skip packet
+            iso_packet_done(dwc2, ep_id, 0, XFER_RESULT_FAILED, in_isr);
+            more_isr = true;
+            continue;
+          }
+          #endif
           edpt->uframe_countdown = ucount; // failed to start, try again next frame
         }
       }
@@ -1197,6 +1715,11 @@ static bool handle_sof_irq(uint8_t rhport, bool in_isr) {
     }
   }
 
+  // non-periodic transfers are served after periodic ones
+  if (sched_start_pending(dwc2, ucount)) {
+    more_isr = true;
+  }
+
   return more_isr;
 }
 
@@ -81,6 +81,12 @@ void dcd_sof_enable(uint8_t rhport, bool en) {
   (void) en;
 }
 
+// Optional: adjust capabilities pre-filled by usbd
+void dcd_caps_get(uint8_t rhport, dcd_caps_t* caps) {
+  (void) rhport;
+  (void) caps;
+}
+
 //--------------------------------------------------------------------+
 // Endpoint API
 //--------------------------------------------------------------------+
@@ -279,13 +279,30 @@ bool dcd_edpt_open(uint8_t rhport, tusb_desc_endpoint_t const* desc_ep) {
 
 void dcd_edpt_close_all(uint8_t rhport) {
   (void) rhport;
-  // TODO optional
+  for (uint8_t ep = 1; ep < EP_MAX; ep++) {
+    data.xfer[ep][TUSB_DIR_OUT].valid = false;
+    data.xfer[ep][TUSB_DIR_IN].valid = false;
+    EP_TX_LEN(ep) = 0;
+    EP_TX_CTRL(ep) = USBFS_EP_T_AUTO_TOG | USBFS_EP_T_RES_NAK;
+    EP_RX_CTRL(ep) = USBFS_EP_R_AUTO_TOG | USBFS_EP_R_RES_NAK;
+  }
 }
 
 void dcd_edpt_close(uint8_t rhport, uint8_t ep_addr) {
   (void) rhport;
-  (void) ep_addr;
-  // TODO optional
+  uint8_t ep = tu_edpt_number(ep_addr);
+  uint8_t dir = tu_edpt_dir(ep_addr);
+  if (ep == 0) {
+    return;
+  }
+
+  data.xfer[ep][dir].valid = false;
+  if (dir == TUSB_DIR_OUT) {
+    EP_RX_CTRL(ep) = USBFS_EP_R_AUTO_TOG | USBFS_EP_R_RES_NAK;
+  } else {
+    EP_TX_LEN(ep) = 0;
+    EP_TX_CTRL(ep) = USBFS_EP_T_AUTO_TOG | USBFS_EP_T_RES_NAK;
+  }
 }
 
 bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint16_t total_bytes) {
@@ -39,9 +39,11 @@ typedef struct {
   uint8_t* buffer;
   uint16_t total_len;
   uint16_t queued_len;
+  uint16_t armed_len; // double buffer: end of data armed to packet buffers
   uint16_t max_size;
   bool is_last_packet;
   bool is_iso;
+  bool is_dbuf;
 } xfer_ctl_t;
 
 typedef enum {
@@ -131,6 +133,96 @@ static void xfer_data_packet(uint8_t ep_num, tusb_dir_t ep_dir, xfer_ctl_t* xfer
   ep_set_response_and_toggle(ep_num, ep_dir, USBHS_EP_R_RES_ACK);
 }
 
+//--------------------------------------------------------------------+
+// Double Buffer
+// With BUF_MOD, an endpoint used in one direction only takes both of its DMA addresses as packet buffers selected by
+// the data toggle: own direction address for DATA0, the other for DATA1. Next packet is armed while the current one
+// is on the bus, interrupt handler only updates length.
+//--------------------------------------------------------------------+
+#if CFG_TUD_WCH_USBHS_DBUF
+
+static inline uint8_t ep_data_toggle(uint8_t ep_num, tusb_dir_t dir) {
+  if (dir == TUSB_DIR_IN) {
+    return (EP_TX_CTRL(ep_num) & USBHS_EP_T_TOG_1) ? 1 : 0;
+  } else {
+    return (EP_RX_CTRL(ep_num) & USBHS_EP_R_TOG_1) ? 1 : 0;
+  }
+}
+
+// Arm next packet of transfer to buffer of data toggle
+static void dbuf_arm_packet(uint8_t ep_num, tusb_dir_t dir, xfer_ctl_t* xfer, uint8_t toggle) {
+  uint32_t const addr = (uint32_t) &xfer->buffer[xfer->armed_len];
+  if ((dir == TUSB_DIR_IN) ^ (toggle == 1)) {
+    EP_TX_DMA_ADDR(ep_num) = addr;
+  } else {
+    EP_RX_DMA_ADDR(ep_num) = addr;
+  }
+  xfer->armed_len += tu_min16(xfer->total_len - xfer->armed_len, xfer->max_size);
+}
+
+// Start transfer by arming both buffers
+static void dbuf_xfer_start(uint8_t ep_num, tusb_dir_t dir, xfer_ctl_t* xfer) {
+  uint8_t const toggle = ep_data_toggle(ep_num, dir);
+  uint16_t const first_len = tu_min16(xfer->total_len, xfer->max_size);
+
+  xfer->armed_len = 0;
+  dbuf_arm_packet(ep_num, dir, xfer, toggle);
+  if (xfer->armed_len < xfer->total_len) {
+    dbuf_arm_packet(ep_num, dir, xfer, toggle ^ 1);
+  }
+
+  if (dir == TUSB_DIR_IN) {
+    EP_TX_LEN(ep_num) = first_len;
+  } else {
+    EP_RX_MAX_LEN(ep_num) = first_len;
+  }
+  ep_set_response_and_toggle(ep_num, dir, EP_RESPONSE_ACK);
+}
+
+// A packet is transferred, toggle is already flipped to the pre-armed buffer. Return true if transfer is complete
+static bool dbuf_xfer_continue(uint8_t ep_num, tusb_dir_t dir, xfer_ctl_t* xfer) {
+  uint16_t const xact_len = (dir == TUSB_DIR_IN) ? EP_TX_LEN(ep_num) : USBHSD->RX_LEN;
+  xfer->queued_len += xact_len;
+
+  if (xfer->queued_len >= xfer->total_len || (dir == TUSB_DIR_OUT && xact_len < xfer->max_size)) {
+    return true;
+  }
+
+  // controller NAKs until interrupt flag is cleared, length of next packet can be updated safely
+  uint16_t const next_len = tu_min16(xfer->total_len - xfer->queued_len, xfer->max_size);
+  if (dir == TUSB_DIR_IN) {
+    EP_TX_LEN(ep_num) = next_len;
+  } else {
+    EP_RX_MAX_LEN(ep_num) = next_len;
+  }
+
+  // refill the buffer just released
+  if (xfer->armed_len < xfer->total_len) {
+    dbuf_arm_packet(ep_num, dir, xfer, ep_data_toggle(ep_num, dir) ^ 1);
+  }
+
+  return false;
+}
+
+// Double buffer is used when opening bulk endpoint whose number is not used by the other direction, and dropped when
+// the other direction is opened later
+static void dbuf_config(uint8_t ep_num, tusb_dir_t dir, bool is_bulk) {
+  xfer_ctl_t* other = XFER_CTL_BASE(ep_num, 1 - dir);
+  uint32_t const other_en = (dir == TUSB_DIR_IN) ? (USBHS_EP0_R_EN << ep_num) : (USBHS_EP0_T_EN << ep_num);
+  bool const other_opened = (USBHSD->ENDP_CONFIG & other_en) || other->is_iso;
+
+  xfer_status[ep_num][dir].is_dbuf = is_bulk && !other_opened;
+  other->is_dbuf = false;
+
+  if (xfer_status[ep_num][dir].is_dbuf) {
+    USBHSD->BUF_MODE |= (USBHS_EP0_BUF_MOD << ep_num);
+  } else {
+    USBHSD->BUF_MODE &= ~(USBHS_EP0_BUF_MOD << ep_num);
+  }
+}
+
+#endif
+
 bool dcd_init(uint8_t rhport, const tusb_rhport_init_t* rh_init) {
   (void) rhport;
   (void) rh_init;
@@ -194,9 +286,13 @@ void dcd_edpt_close_all(uint8_t rhport) {
     EP_RX_CTRL(ep) = USBHS_EP_R_AUTOTOG | USBHS_EP_R_RES_NAK;
 
     EP_RX_MAX_LEN(ep) = 0;
+
+    xfer_status[ep][TUSB_DIR_OUT].is_dbuf = false;
+    xfer_status[ep][TUSB_DIR_IN].is_dbuf = false;
   }
 
   USBHSD->ENDP_CONFIG = USBHS_EP0_T_EN | USBHS_EP0_R_EN;
+  USBHSD->BUF_MODE = 0;
 }
 
 void dcd_set_address(uint8_t rhport, uint8_t dev_addr) {
@@ -210,6 +306,11 @@ void dcd_remote_wakeup(uint8_t rhport) {
   (void) rhport;
 }
 
+void dcd_caps_get(uint8_t rhport, dcd_caps_t* caps) {
+  (void) rhport;
+  caps->double_buffer = CFG_TUD_WCH_USBHS_DBUF ? 1 : 0;
+}
+
 void dcd_sof_enable(uint8_t rhport, bool en) {
   (void) rhport;
   if (en) {
@@ -248,6 +349,10 @@ bool dcd_edpt_open(uint8_t rhport, tusb_desc_endpoint_t const* desc_edpt) {
   xfer->max_size = tu_edpt_packet_size(desc_edpt);
 
   xfer->is_iso = (desc_edpt->bmAttributes.xfer == TUSB_XFER_ISOCHRONOUS);
+#if CFG_TUD_WCH_USBHS_DBUF
+  dbuf_config(ep_num, dir, desc_edpt->bmAttributes.xfer == TUSB_XFER_BULK);
+#endif
+
   if (dir == TUSB_DIR_OUT) {
     USBHSD->ENDP_CONFIG |= (USBHS_EP0_R_EN << ep_num);
     EP_RX_CTRL(ep_num) = USBHS_EP_R_AUTOTOG | USBHS_EP_R_RES_NAK;
@@ -275,6 +380,11 @@ void dcd_edpt_close(uint8_t rhport, uint8_t ep_addr) {
   uint8_t const ep_num = tu_edpt_number(ep_addr);
   tusb_dir_t const dir = tu_edpt_dir(ep_addr);
 
+  if (xfer_status[ep_num][dir].is_dbuf) {
+    xfer_status[ep_num][dir].is_dbuf = false;
+    USBHSD->BUF_MODE &= ~(USBHS_EP0_BUF_MOD << ep_num);
+  }
+
   if (dir == TUSB_DIR_OUT) {
     EP_RX_CTRL(ep_num) = USBHS_EP_R_AUTOTOG | USBHS_EP_R_RES_NAK;
     EP_RX_MAX_LEN(ep_num) = 0;
@@ -326,6 +436,13 @@ bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint16_t to
   xfer->queued_len = 0;
   xfer->is_last_packet = false;
 
+#if CFG_TUD_WCH_USBHS_DBUF
+  if (xfer->is_dbuf) {
+    dbuf_xfer_start(ep_num, dir, xfer);
+    return true;
+  }
+#endif
+
   xfer_data_packet(ep_num, dir, xfer);
 
   return true;
@@ -349,6 +466,11 @@ void dcd_int_handler(uint8_t rhport) {
       uint8_t const ep_addr = tu_edpt_addr(ep_num, ep_dir);
       xfer_ctl_t* xfer = XFER_CTL_BASE(ep_num, ep_dir);
 
+#if CFG_TUD_WCH_USBHS_DBUF
+      if (xfer->is_dbuf) {
+        xfer->is_last_packet = dbuf_xfer_continue(ep_num, ep_dir, xfer);
+      } else
+#endif
       if (token == USBHS_TOKEN_PID_OUT) {
         uint16_t rx_len = USBHSD->RX_LEN;
 
@@ -372,6 +494,8 @@ void dcd_int_handler(uint8_t rhport) {
       if (xfer->is_last_packet == true) {
         ep_set_response_and_toggle(ep_num, ep_dir, EP_RESPONSE_NAK);
         dcd_event_xfer_complete(0, ep_addr, xfer->queued_len, XFER_RESULT_SUCCESS, true);
+      } else if (xfer->is_dbuf) {
+        // next packet is already armed
       } else {
         /* prepare next part of packet to xref */
         xfer_data_packet(ep_num, ep_dir, xfer);
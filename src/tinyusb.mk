@@ -2,9 +2,12 @@
 TINYUSB_SRC_C += \
 	src/tusb.c \
 	src/common/tusb_fifo.c \
+	src/common/tusb_capture.c \
+	src/common/tusb_bridge.c \
 	src/device/usbd.c \
 	src/device/usbd_control.c \
 	src/typec/usbc.c \
+	src/typec/pd_policy.c \
 	src/class/audio/audio_device.c \
 	src/class/cdc/cdc_device.c \
 	src/class/dfu/dfu_device.c \
@@ -12,6 +15,8 @@ TINYUSB_SRC_C += \
 	src/class/hid/hid_device.c \
 	src/class/midi/midi_device.c \
 	src/class/msc/msc_device.c \
+	src/class/msc/msc_cache.c \
+	src/class/msc/uas_device.c \
 	src/class/net/ecm_rndis_device.c \
 	src/class/net/ncm_device.c \
 	src/class/usbtmc/usbtmc_device.c \
@@ -19,8 +24,15 @@ TINYUSB_SRC_C += \
 	src/class/vendor/vendor_device.c \
   src/host/usbh.c \
   src/host/hub.c \
+  src/class/audio/audio_host.c \
+  src/class/bth/bth_host.c \
   src/class/cdc/cdc_host.c \
   src/class/hid/hid_host.c \
+  src/class/midi/midi_host.c \
   src/class/msc/msc_host.c \
+  src/class/msc/msc_passthrough.c \
+  src/class/msc/uas_host.c \
+  src/class/net/ncm_host.c \
+  src/class/net/rndis_host.c \
   src/class/vendor/vendor_host.c \
   src/typec/usbc.c \
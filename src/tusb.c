@@ -55,10 +55,25 @@ TU_ATTR_WEAK void tusb_time_delay_ms_api(uint32_t ms) {
 #endif
 }
 
+#if CFG_TUSB_OS == OPT_OS_FREERTOS
+TU_ATTR_WEAK uint32_t tusb_time_millis_api(void) {
+  return (uint32_t) (xTaskGetTickCount() * portTICK_PERIOD_MS);
+}
+#elif CFG_TUSB_OS == OPT_OS_PICO
+TU_ATTR_WEAK uint32_t tusb_time_millis_api(void) {
+  return to_ms_since_boot(get_absolute_time());
+}
+#endif
+
 //--------------------------------------------------------------------+
 // Public API
 //--------------------------------------------------------------------+
 bool tusb_rhport_init(uint8_t rhport, const tusb_rhport_init_t* rh_init) {
+  #if CFG_TUSB_CORE_AFFINITY >= 0
+  // USB IRQ is enabled on the calling core
+  TU_ASSERT(osal_core_id() == CFG_TUSB_CORE_AFFINITY);
+  #endif
+
   //  backward compatible called with tusb_init(void)
   #if defined(TUD_OPT_RHPORT) || defined(TUH_OPT_RHPORT)
   if (rh_init == NULL) {
@@ -279,16 +294,66 @@ uint16_t tu_desc_get_interface_total_len(tusb_desc_interface_t const* desc_itf,
   return len;
 }
 
+//--------------------------------------------------------------------+
+// Deferred Function Call Pool for both Host and Device stack
+//--------------------------------------------------------------------+
+
+bool tu_defer_pool_add(tu_defer_pool_t* pool, osal_task_func_t func, void* param, uint8_t prio, bool* kick) {
+  tu_defer_entry_t* free_entry = NULL;
+  *kick = false;
+
+  for (uint8_t i = 0; i < pool->size; i++) {
+    tu_defer_entry_t* entry = &pool->entries[i];
+    if (entry->func == func && entry->param == param) {
+      entry->prio = tu_min8(entry->prio, prio);
+      return true;
+    }
+    if (free_entry == NULL && entry->func == NULL) {
+      free_entry = entry;
+    }
+  }
+  TU_VERIFY(free_entry);
+
+  free_entry->func = func;
+  free_entry->param = param;
+  free_entry->prio = prio;
+  free_entry->seq = pool->seq++;
+
+  if (!pool->kicked) {
+    pool->kicked = true;
+    *kick = true;
+  }
+  return true;
+}
+
+bool tu_defer_pool_take(tu_defer_pool_t* pool, osal_task_func_t* func, void** param) {
+  tu_defer_entry_t* next = NULL;
+
+  for (uint8_t i = 0; i < pool->size; i++) {
+    tu_defer_entry_t* entry = &pool->entries[i];
+    if (entry->func && (next == NULL || entry->prio < next->prio ||
+                        (entry->prio == next->prio && (int16_t) (entry->seq - next->seq) < 0))) {
+      next = entry;
+    }
+  }
+  TU_VERIFY(next);
+
+  *func = next->func;
+  *param = next->param;
+  next->func = NULL;
+  return true;
+}
+
 //--------------------------------------------------------------------+
 // Endpoint Stream Helper for both Host and Device stack
 //--------------------------------------------------------------------+
 
 bool tu_edpt_stream_init(tu_edpt_stream_t* s, bool is_host, bool is_tx, bool overwritable,
-                         void* ff_buf, uint16_t ff_bufsize, uint8_t* ep_buf, uint16_t ep_bufsize) {
+                         void* ff_buf, uint32_t ff_bufsize, uint8_t* ep_buf, uint16_t ep_bufsize) {
   (void) is_tx;
 
   s->is_host = is_host;
-  tu_fifo_config(&s->ff, ff_buf, ff_bufsize, 1, overwritable);
+  tu_fifo_config(&s->ff, ff_buf, (tu_fifo_size_t) ff_bufsize, 1, overwritable);
 
   #if OSAL_MUTEX_REQUIRED
   if (ff_buf && ff_bufsize) {
@@ -299,6 +364,7 @@ bool tu_edpt_stream_init(tu_edpt_stream_t* s, bool is_host, bool is_tx, bool ove
 
   s->ep_buf = ep_buf;
   s->ep_bufsize = ep_bufsize;
+  s->mps = TUSB_EPSIZE_BULK_FS; // updated by tu_edpt_stream_open()
 
   return true;
 }
@@ -312,34 +378,46 @@ bool tu_edpt_stream_deinit(tu_edpt_stream_t* s) {
   return true;
 }
 
-TU_ATTR_ALWAYS_INLINE static inline bool stream_claim(uint8_t hwid, tu_edpt_stream_t* s) {
-  if (s->is_host) {
+// in_isr: called from device class driver's xfer_isr()
+TU_ATTR_ALWAYS_INLINE static inline bool stream_claim_ex(uint8_t hwid, tu_edpt_stream_t* s, bool in_isr) {
+  (void) in_isr;
+  if (tu_edpt_stream_is_host(s)) {
     #if CFG_TUH_ENABLED
     return usbh_edpt_claim(hwid, s->ep_addr);
     #endif
   } else {
     #if CFG_TUD_ENABLED
-    return usbd_edpt_claim(hwid, s->ep_addr);
+    return usbd_edpt_claim_ex(hwid, s->ep_addr, in_isr);
     #endif
   }
   return false;
 }
 
-TU_ATTR_ALWAYS_INLINE static inline bool stream_xfer(uint8_t hwid, tu_edpt_stream_t* s, uint16_t count) {
-  if (s->is_host) {
+TU_ATTR_ALWAYS_INLINE static inline bool stream_claim(uint8_t hwid, tu_edpt_stream_t* s) {
+  return stream_claim_ex(hwid, s, false);
+}
+
+TU_ATTR_ALWAYS_INLINE static inline bool stream_xfer_buf(uint8_t hwid, tu_edpt_stream_t* s, uint8_t* buf,
+                                                          uint16_t count) {
+  if (tu_edpt_stream_is_host(s)) {
     #if CFG_TUH_ENABLED
-    return usbh_edpt_xfer(hwid, s->ep_addr, count ? s->ep_buf : NULL, count);
+    return usbh_edpt_xfer(hwid, s->ep_addr, count ? buf : NULL, count);
     #endif
   } else {
     #if CFG_TUD_ENABLED
-    return usbd_edpt_xfer(hwid, s->ep_addr, count ? s->ep_buf : NULL, count);
+    return usbd_edpt_xfer(hwid, s->ep_addr, count ? buf : NULL, count);
     #endif
   }
+  (void) buf;
   return false;
 }
 
+TU_ATTR_ALWAYS_INLINE static inline bool stream_xfer(uint8_t hwid, tu_edpt_stream_t* s, uint16_t count) {
+  return stream_xfer_buf(hwid, s, s->ep_buf, count);
+}
+
 TU_ATTR_ALWAYS_INLINE static inline bool stream_release(uint8_t hwid, tu_edpt_stream_t* s) {
-  if (s->is_host) {
+  if (tu_edpt_stream_is_host(s)) {
     #if CFG_TUH_ENABLED
     return usbh_edpt_release(hwid, s->ep_addr);
     #endif
@@ -356,21 +434,133 @@ TU_ATTR_ALWAYS_INLINE static inline bool stream_release(uint8_t hwid, tu_edpt_st
 //--------------------------------------------------------------------+
 bool tu_edpt_stream_write_zlp_if_needed(uint8_t hwid, tu_edpt_stream_t* s, uint32_t last_xferred_bytes) {
   // ZLP condition: no pending data, last transferred bytes is multiple of packet size
-  const uint16_t mps = s->is_mps512 ? TUSB_EPSIZE_BULK_HS : TUSB_EPSIZE_BULK_FS;
-  TU_VERIFY(!tu_fifo_count(&s->ff) && last_xferred_bytes && (0 == (last_xferred_bytes & (mps - 1))));
+  TU_VERIFY(s->zlp_policy != TU_EDPT_STREAM_ZLP_NEVER);
+  TU_VERIFY(!tu_fifo_count(&s->ff) && last_xferred_bytes && (0 == (last_xferred_bytes % s->mps)));
+
+  if (s->zlp_policy == TU_EDPT_STREAM_ZLP_DEFER) {
+    // more data written soon continues the same host transfer, saving a (micro)frame for the ZLP
+    s->zlp_pending = 1;
+    tu_edpt_coalesce_arm(&s->tx_coalesce);
+    return false;
+  }
+
   TU_VERIFY(stream_claim(hwid, s));
   TU_ASSERT(stream_xfer(hwid, s, 0));
   return true;
 }
 
+// Send deferred ZLP if still owed, called when there is no data to write
+static void stream_write_zlp_pending(uint8_t hwid, tu_edpt_stream_t* s) {
+  if (s->zlp_pending && stream_claim(hwid, s)) {
+    s->zlp_pending = 0;
+    if (!stream_xfer(hwid, s, 0)) {
+      stream_release(hwid, s);
+    }
+  }
+}
+
+bool tu_edpt_stream_write_set_pingpong(tu_edpt_stream_t* s, bool enabled) {
+#if CFG_TUD_ENABLED && CFG_TUD_EDPT_XFER_QUEUE
+  TU_VERIFY(!tu_edpt_stream_is_host(s) && tu_fifo_depth(&s->ff));
+  if (enabled != s->is_pingpong) {
+    TU_VERIFY(!enabled || (s->ep_bufsize / 2) >= TUSB_EPSIZE_BULK_FS);
+    s->ep_bufsize = enabled ? (uint16_t) (s->ep_bufsize / 2) : (uint16_t) (s->ep_bufsize * 2);
+    s->is_pingpong = enabled ? 1 : 0;
+    s->pp_idx = 0;
+  }
+  return true;
+#else
+  (void) s;
+  return !enabled;
+#endif
+}
+
+#if CFG_TUD_ENABLED && CFG_TUD_EDPT_XFER_QUEUE
+// Fill the free half of ep_buf and queue it behind the transfer on the wire (if any)
+static uint32_t stream_write_xfer_pingpong(uint8_t hwid, tu_edpt_stream_t* s) {
+  uint16_t count = 0;
+
+  #if OSAL_MUTEX_REQUIRED
+  // serialize with other callers picking the same half (writer mutex is not held when calling this)
+  (void) osal_mutex_lock(s->ff.mutex_wr, OSAL_TIMEOUT_WAIT_FOREVER);
+  #endif
+
+  // the free half is only known to be unused if there is at most one transfer on the wire
+  if (usbd_edpt_xfer_queue_available(hwid, s->ep_addr)) {
+    uint8_t* buf = s->ep_buf + (s->pp_idx ? s->ep_bufsize : 0);
+    count = (uint16_t) tu_fifo_peek_n(&s->ff, buf, s->ep_bufsize);
+    if (count && usbd_edpt_xfer_queue(hwid, s->ep_addr, buf, count)) {
+      tu_fifo_advance_read_pointer(&s->ff, count);
+      s->pp_idx ^= 1;
+      s->zlp_pending = 0;
+    } else {
+      count = 0;
+    }
+  }
+
+  #if OSAL_MUTEX_REQUIRED
+  (void) osal_mutex_unlock(s->ff.mutex_wr);
+  #endif
+
+  return count;
+}
+#endif
+
+bool tu_edpt_stream_write_set_zerocopy(tu_edpt_stream_t* s, uint8_t align) {
+  TU_VERIFY(tu_fifo_depth(&s->ff) && !s->is_pingpong && s->ep_bufsize);
+  TU_VERIFY(tu_is_power_of_two(align) || align == 0);
+  TU_VERIFY(s->ep_buf || align == 1); // no bounce buffer for unaligned data
+  s->zc_align = align;
+  s->zc_inflight = 0;
+  return true;
+}
+
+bool tu_edpt_stream_write_set_coalesce(tu_edpt_stream_t* s, uint16_t threshold, uint16_t timeout_ms) {
+  TU_VERIFY(tu_fifo_depth(&s->ff));
+  s->tx_coalesce.threshold = threshold;
+  s->tx_coalesce.timeout = timeout_ms;
+  tu_edpt_coalesce_disarm(&s->tx_coalesce);
+  return true;
+}
+
 uint32_t tu_edpt_stream_write_xfer(uint8_t hwid, tu_edpt_stream_t* s) {
-  // skip if no data
-  TU_VERIFY(tu_fifo_count(&s->ff), 0);
+  // skip if no data, but complete transfer with deferred ZLP if any
+  if (0 == tu_fifo_count(&s->ff)) {
+    stream_write_zlp_pending(hwid, s);
+    return 0;
+  }
+
+  // pending data is being flushed, later completion will continue with what is left
+  tu_edpt_coalesce_disarm(&s->tx_coalesce);
+
+#if CFG_TUD_ENABLED && CFG_TUD_EDPT_XFER_QUEUE
+  if (s->is_pingpong) {
+    return stream_write_xfer_pingpong(hwid, s);
+  }
+#endif
 
   TU_VERIFY(stream_claim(hwid, s), 0);
+  s->zlp_pending = 0; // new data continues the host transfer
+
+  if (s->zc_align) {
+    // endpoint is claimed: previous zero-copy transfer is complete, its data can be removed from FIFO
+    if (s->zc_inflight) {
+      tu_fifo_advance_read_pointer(&s->ff, s->zc_inflight);
+      s->zc_inflight = 0;
+    }
+
+    tu_fifo_buffer_info_t info;
+    tu_fifo_get_read_info(&s->ff, &info);
+    if (info.len_lin && 0 == ((uintptr_t) info.ptr_lin & (s->zc_align - 1u))) {
+      uint16_t const zc_count = (uint16_t) tu_min32(info.len_lin, s->ep_bufsize);
+      TU_ASSERT(stream_xfer_buf(hwid, s, (uint8_t*) info.ptr_lin, zc_count), 0);
+      s->zc_inflight = zc_count;
+      return zc_count;
+    }
+  }
 
   // Pull data from FIFO -> EP buf
-  uint16_t const count = tu_fifo_read_n(&s->ff, s->ep_buf, s->ep_bufsize);
+  uint16_t const count = s->ep_buf ? (uint16_t) tu_fifo_read_n(&s->ff, s->ep_buf, s->ep_bufsize) : 0;
 
   if (count) {
     TU_ASSERT(stream_xfer(hwid, s, count), 0);
@@ -383,6 +573,18 @@ uint32_t tu_edpt_stream_write_xfer(uint8_t hwid, tu_edpt_stream_t* s) {
   }
 }
 
+// flush if fifo has more than coalescing threshold (packet size by default) or
+// in rare case: fifo depth is configured too small (which never reach threshold).
+// Otherwise arm coalescing timeout for the pending bytes
+TU_ATTR_ALWAYS_INLINE static inline void stream_write_flush_if_needed(uint8_t hwid, tu_edpt_stream_t* s) {
+  const uint16_t threshold = tu_edpt_coalesce_threshold(&s->tx_coalesce, s->mps);
+  if ((tu_fifo_count(&s->ff) >= threshold) || (tu_fifo_depth(&s->ff) < threshold)) {
+    tu_edpt_stream_write_xfer(hwid, s);
+  } else if (tu_fifo_count(&s->ff)) {
+    tu_edpt_coalesce_arm(&s->tx_coalesce);
+  }
+}
+
 uint32_t tu_edpt_stream_write(uint8_t hwid, tu_edpt_stream_t* s, void const* buffer, uint32_t bufsize) {
   TU_VERIFY(bufsize); // TODO support ZLP
 
@@ -394,24 +596,30 @@ uint32_t tu_edpt_stream_write(uint8_t hwid, tu_edpt_stream_t* s, void const* buf
     TU_ASSERT(stream_xfer(hwid, s, (uint16_t) xact_len), 0);
     return xact_len;
   } else {
-    const uint16_t ret = tu_fifo_write_n(&s->ff, buffer, (uint16_t) bufsize);
-
-    // flush if fifo has more than packet size or
-    // in rare case: fifo depth is configured too small (which never reach packet size)
-    const uint16_t mps = s->is_mps512 ? TUSB_EPSIZE_BULK_HS : TUSB_EPSIZE_BULK_FS;
-    if ((tu_fifo_count(&s->ff) >= mps) || (tu_fifo_depth(&s->ff) < mps)) {
-      tu_edpt_stream_write_xfer(hwid, s);
-    }
+    const uint32_t ret = tu_fifo_write_n(&s->ff, buffer, (tu_fifo_size_t) tu_min32(bufsize, TU_FIFO_SIZE_MAX));
+    stream_write_flush_if_needed(hwid, s);
     return ret;
   }
 }
 
+uint32_t tu_edpt_stream_write_reserve(tu_edpt_stream_t* s, void** p_buf, uint32_t bufsize) {
+  TU_VERIFY(tu_fifo_depth(&s->ff), 0);
+  return tu_fifo_reserve(&s->ff, p_buf, (tu_fifo_size_t) tu_min32(bufsize, TU_FIFO_SIZE_MAX));
+}
+
+uint32_t tu_edpt_stream_write_commit(uint8_t hwid, tu_edpt_stream_t* s, uint32_t count) {
+  TU_VERIFY(tu_fifo_depth(&s->ff), 0);
+  tu_fifo_commit(&s->ff, (tu_fifo_size_t) count);
+  stream_write_flush_if_needed(hwid, s);
+  return count;
+}
+
 uint32_t tu_edpt_stream_write_available(uint8_t hwid, tu_edpt_stream_t* s) {
   if (tu_fifo_depth(&s->ff)) {
     return (uint32_t) tu_fifo_remaining(&s->ff);
   } else {
     bool is_busy = true;
-    if (s->is_host) {
+    if (tu_edpt_stream_is_host(s)) {
       #if CFG_TUH_ENABLED
       is_busy = usbh_edpt_busy(hwid, s->ep_addr);
       #endif
@@ -427,43 +635,86 @@ uint32_t tu_edpt_stream_write_available(uint8_t hwid, tu_edpt_stream_t* s) {
 //--------------------------------------------------------------------+
 // Stream Read
 //--------------------------------------------------------------------+
+// Move parked bytes (received while FIFO was full) to FIFO, return true if all are moved
+static bool stream_rx_unpark(tu_edpt_stream_t* s) {
+  if (s->rx_parked_len) {
+    uint16_t const count = (uint16_t) tu_fifo_write_n(&s->ff, s->ep_buf + s->rx_parked_ofs, s->rx_parked_len);
+    s->rx_parked_ofs = (uint16_t) (s->rx_parked_ofs + count);
+    s->rx_parked_len = (uint16_t) (s->rx_parked_len - count);
+  }
+  return 0 == s->rx_parked_len;
+}
+
 uint32_t tu_edpt_stream_read_xfer(uint8_t hwid, tu_edpt_stream_t* s) {
+  return tu_edpt_stream_read_xfer_ex(hwid, s, false);
+}
+
+uint32_t tu_edpt_stream_read_xfer_ex(uint8_t hwid, tu_edpt_stream_t* s, bool in_isr) {
   if (0 == tu_fifo_depth(&s->ff)) {
     // no fifo for buffered
-    TU_VERIFY(stream_claim(hwid, s), 0);
+    TU_VERIFY(stream_claim_ex(hwid, s, in_isr), 0);
     TU_ASSERT(stream_xfer(hwid, s, s->ep_bufsize), 0);
     return s->ep_bufsize;
   } else {
-    const uint16_t mps = s->is_mps512 ? TUSB_EPSIZE_BULK_HS : TUSB_EPSIZE_BULK_FS;
-    uint16_t available = tu_fifo_remaining(&s->ff);
+    // ep_buf still holds data of previous transfer
+    TU_VERIFY(stream_rx_unpark(s), 0);
 
-    // Prepare for incoming data but only allow what we can store in the ring buffer.
-    // TODO Actually we can still carry out the transfer, keeping count of received bytes
-    // and slowly move it to the FIFO when read().
-    // This pre-check reduces endpoint claiming
-    TU_VERIFY(available >= mps);
+    const uint16_t mps = s->mps;
+    TU_VERIFY(stream_claim_ex(hwid, s, in_isr), 0);
 
-    TU_VERIFY(stream_claim(hwid, s), 0);
+    // Prepare for incoming data: multiple of packet size that fits FIFO, limited by ep bufsize.
+    // If FIFO has less than a packet of space, still overcommit one packet into ep_buf: bytes not fitting
+    // are parked there and moved to FIFO later on read(), keeping endpoint flowing with slow consumer.
+    uint32_t const available = tu_fifo_remaining(&s->ff);
+    uint16_t const count = (uint16_t) tu_min32(tu_max32(available - (available % mps), mps), s->ep_bufsize);
+    TU_ASSERT(stream_xfer(hwid, s, count), 0);
+    return count;
+  }
+}
 
-    // get available again since fifo can be changed before endpoint is claimed
-    available = tu_fifo_remaining(&s->ff);
+uint32_t tu_edpt_stream_read_xfer_complete_framed(tu_edpt_stream_t* s, uint32_t xferred_bytes, uint8_t hdr_len) {
+  TU_VERIFY(tu_fifo_depth(&s->ff), 0);
+  uint8_t* const buf = s->ep_buf;
+  uint16_t const mps = s->mps;
+  uint32_t total = 0;
+
+  // next transfer is only started once parked bytes are moved to FIFO, rx_parked_len is 0 here
+  for (uint32_t ofs = 0; ofs < xferred_bytes; ofs += mps) {
+    uint32_t const pkt_len = tu_min32(mps, xferred_bytes - ofs);
+    if (pkt_len <= hdr_len) {
+      continue; // header only
+    }
+
+    uint16_t const payload_ofs = (uint16_t) (ofs + hdr_len);
+    uint16_t const len = (uint16_t) (pkt_len - hdr_len);
+    total += len;
 
-    if (available >= mps) {
-      // multiple of packet size limit by ep bufsize
-      uint16_t count = (uint16_t) (available & ~(mps - 1));
-      count = tu_min16(count, s->ep_bufsize);
-      TU_ASSERT(stream_xfer(hwid, s, count), 0);
-      return count;
+    if (0 == s->rx_parked_len) {
+      uint16_t const count = (uint16_t) tu_fifo_write_n(&s->ff, buf + payload_ofs, len);
+      if (count < len) {
+        s->rx_parked_ofs = (uint16_t) (payload_ofs + count);
+        s->rx_parked_len = (uint16_t) (len - count);
+      }
     } else {
-      // Release endpoint since we don't make any transfer
-      stream_release(hwid, s);
-      return 0;
+      // FIFO is full: append to parked bytes, which always lie before this packet
+      memmove(buf + s->rx_parked_ofs + s->rx_parked_len, buf + payload_ofs, len);
+      s->rx_parked_len = (uint16_t) (s->rx_parked_len + len);
     }
   }
+
+  return total;
 }
 
 uint32_t tu_edpt_stream_read(uint8_t hwid, tu_edpt_stream_t* s, void* buffer, uint32_t bufsize) {
-  uint32_t num_read = tu_fifo_read_n(&s->ff, buffer, (uint16_t) bufsize);
+  uint32_t num_read = tu_fifo_read_n(&s->ff, buffer, (tu_fifo_size_t) tu_min32(bufsize, TU_FIFO_SIZE_MAX));
+
+  // FIFO has room now: pull in parked bytes, also pass them to caller if there is space
+  if (num_read < bufsize && s->rx_parked_len) {
+    (void) stream_rx_unpark(s);
+    num_read += tu_fifo_read_n(&s->ff, (uint8_t*) buffer + num_read,
+                               (tu_fifo_size_t) tu_min32(bufsize - num_read, TU_FIFO_SIZE_MAX));
+  }
+
   tu_edpt_stream_read_xfer(hwid, s);
   return num_read;
 }
@@ -556,6 +807,113 @@ void tu_print_mem(void const* buf, uint32_t count, uint8_t indent) {
   dump_str_line(buf8 - nback, nback);
 }
 
+#if CFG_TUSB_DEBUG_TRACE
+#include <stdarg.h>
+
+TU_VERIFY_STATIC((CFG_TUSB_DEBUG_TRACE_BUFSIZE & (CFG_TUSB_DEBUG_TRACE_BUFSIZE - 1)) == 0,
+                 "Trace buffer size must be power of 2");
+TU_VERIFY_STATIC(CFG_TUSB_DEBUG_TRACE_MEM_MAX <= 0xFFFFu, "Trace memory dump is limited to 64KB");
+
+TU_ATTR_WEAK uint32_t tusb_trace_timestamp_cb(void) {
+  return 0;
+}
+
+#ifdef CFG_TUSB_DEBUG_TRACE_WRITE
+
+static void trace_commit(uint32_t* record, uint32_t nwords) {
+  CFG_TUSB_DEBUG_TRACE_WRITE(record, 4 * nwords);
+}
+
+#else
+
+static uint32_t _trace_buf[CFG_TUSB_DEBUG_TRACE_BUFSIZE];
+static volatile uint32_t _trace_wr; // total words reserved by writers, free-running
+static uint32_t _trace_rd;          // total words read by tu_trace_read()
+
+// Record is reserved with an atomic add so that logging from ISR does not corrupt a record being written by
+// thread. Without atomic support (e.g ARMv6-M) records from ISR and thread may interleave, decoder would then
+// resync on next header.
+static uint32_t trace_reserve(uint32_t nwords) {
+#if defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4)
+  return __atomic_fetch_add(&_trace_wr, nwords, __ATOMIC_RELAXED);
+#else
+  uint32_t const wr = _trace_wr;
+  _trace_wr = wr + nwords;
+  return wr;
+#endif
+}
+
+// Header is written last so that reader never sees a valid header followed by a partial record
+static void trace_commit(uint32_t* record, uint32_t nwords) {
+  uint32_t const mask = CFG_TUSB_DEBUG_TRACE_BUFSIZE - 1;
+  uint32_t const wr = trace_reserve(nwords);
+  for (uint32_t i = 1; i < nwords; i++) {
+    _trace_buf[(wr + i) & mask] = record[i];
+  }
+  _trace_buf[wr & mask] = record[0];
+}
+
+uint32_t tu_trace_read(void* buf, uint32_t bufsize) {
+  uint32_t const wr = _trace_wr;
+  uint32_t count = wr - _trace_rd;
+
+  // overrun: skip the overwritten part, decoder resyncs on next header
+  if (count > CFG_TUSB_DEBUG_TRACE_BUFSIZE) {
+    _trace_rd = wr - CFG_TUSB_DEBUG_TRACE_BUFSIZE;
+    count = CFG_TUSB_DEBUG_TRACE_BUFSIZE;
+  }
+  count = tu_min32(count, bufsize / 4);
+
+  uint32_t* buf32 = (uint32_t*) buf;
+  for (uint32_t i = 0; i < count; i++) {
+    tu_unaligned_write32(buf32 + i, _trace_buf[(_trace_rd + i) & (CFG_TUSB_DEBUG_TRACE_BUFSIZE - 1)]);
+  }
+  _trace_rd += count;
+
+  return 4 * count;
+}
+
+#endif
+
+void tu_trace_log(uint32_t argc, char const* format, ...) {
+  uint32_t record[2 + 1 + TU_TRACE_ARGC_MAX];
+  argc = tu_min32(argc, TU_TRACE_ARGC_MAX);
+
+  record[0] = TU_TRACE_MAGIC | (argc << 8) | ((uint32_t) TU_TRACE_TYPE_LOG << 12);
+  record[1] = tusb_trace_timestamp_cb();
+  record[2] = (uint32_t) (uintptr_t) format;
+
+  va_list ap;
+  va_start(ap, format);
+  for (uint32_t i = 0; i < argc; i++) {
+    record[3 + i] = va_arg(ap, uint32_t);
+  }
+  va_end(ap);
+
+  trace_commit(record, 3 + argc);
+}
+
+void tu_trace_mem(void const* buf, uint32_t count) {
+  uint32_t record[2 + (CFG_TUSB_DEBUG_TRACE_MEM_MAX + 3) / 4];
+  if (buf == NULL) {
+    count = 0;
+  }
+  count = tu_min32(count, CFG_TUSB_DEBUG_TRACE_MEM_MAX);
+
+  record[0] = TU_TRACE_MAGIC | ((uint32_t) TU_TRACE_TYPE_MEM << 12) | (count << 16);
+  record[1] = tusb_trace_timestamp_cb();
+  if (count & 3) {
+    record[2 + count / 4] = 0; // clear padding of last word
+  }
+  if (count) {
+    memcpy(&record[2], buf, count);
+  }
+
+  trace_commit(record, 2 + (count + 3) / 4);
+}
+
+#endif
+
 #endif
 
 #endif // host or device enabled
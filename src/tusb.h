@@ -37,6 +37,8 @@
 #include "common/tusb_common.h"
 #include "osal/osal.h"
 #include "common/tusb_fifo.h"
+#include "common/tusb_capture.h"
+#include "common/tusb_bridge.h"
 
 //------------- TypeC -------------//
 #if CFG_TUC_ENABLED
@@ -47,18 +49,43 @@
 #if CFG_TUH_ENABLED
   #include "host/usbh.h"
 
+  #if CFG_TUH_AUDIO
+    #include "class/audio/audio_host.h"
+  #endif
+
+  #if CFG_TUH_BTH
+    #include "class/bth/bth_host.h"
+  #endif
+
   #if CFG_TUH_HID
     #include "class/hid/hid_host.h"
   #endif
 
+  #if CFG_TUH_MIDI
+    #include "class/midi/midi_host.h"
+  #endif
+
   #if CFG_TUH_MSC
     #include "class/msc/msc_host.h"
+    #include "class/msc/msc_passthrough.h"
+  #endif
+
+  #if CFG_TUH_UAS
+    #include "class/msc/uas_host.h"
   #endif
 
   #if CFG_TUH_CDC
     #include "class/cdc/cdc_host.h"
   #endif
 
+  #if CFG_TUH_NCM
+    #include "class/net/ncm_host.h"
+  #endif
+
+  #if CFG_TUH_RNDIS
+    #include "class/net/rndis_host.h"
+  #endif
+
   #if CFG_TUH_VENDOR
     #include "class/vendor/vendor_host.h"
   #endif
@@ -84,6 +111,10 @@
     #include "class/msc/msc_device.h"
   #endif
 
+  #if CFG_TUD_UAS
+    #include "class/msc/uas_device.h"
+  #endif
+
   #if CFG_TUD_AUDIO
     #include "class/audio/audio_device.h"
   #endif
@@ -169,7 +200,8 @@ void tusb_int_handler(uint8_t rhport, bool in_isr);
 // API Implemented by user
 //--------------------------------------------------------------------+
 
-// Get current milliseconds, required by some port/configuration without RTOS
+// Get current milliseconds, required by host enumeration and some port/configuration without RTOS.
+// Default implementation is provided for FreeRTOS and pico-sdk
 uint32_t tusb_time_millis_api(void);
 
 // Delay in milliseconds, use tusb_time_millis_api() by default. required by some port/configuration with no RTOS
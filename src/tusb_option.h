@@ -199,6 +199,9 @@
 #define OPT_MCU_MAX32650         2402  ///< ADI MAX32650/1/2
 #define OPT_MCU_MAX78002         2403  ///< ADI MAX78002
 
+// Host-native
+#define OPT_MCU_SIM              2500  ///< Simulated controller for workstation profiling, see portable/sim
+
 // Check if configured MCU is one of listed
 // Apply _TU_CHECK_MCU with || as separator to list of input
 #define _TU_CHECK_MCU(_m)    (CFG_TUSB_MCU == _m)
@@ -267,6 +270,18 @@
   #define CFG_TUD_DWC2_DMA_ENABLE CFG_TUD_DWC2_DMA_ENABLE_DEFAULT
 #endif
 
+// Use Scatter/Gather (descriptor) DMA instead of Buffer DMA for device if supported by the core (ghwcfg4.dma_desc_enabled),
+// require CFG_TUD_DWC2_DMA_ENABLE
+#ifndef CFG_TUD_DWC2_DMA_SG_ENABLE
+  #define CFG_TUD_DWC2_DMA_SG_ENABLE 0
+#endif
+
+// Number of Scatter/Gather DMA descriptors per endpoint direction. Non-isochronous transfer uses up to 2 descriptors
+// per buffer segment (FIFO transfer has up to 2 segments), isochronous transfer uses 1 descriptor per packet
+#ifndef CFG_TUD_DWC2_DMA_SG_DESC_COUNT
+  #define CFG_TUD_DWC2_DMA_SG_DESC_COUNT 4
+#endif
+
 // Enable DWC2 Slave mode for host
 #ifndef CFG_TUH_DWC2_SLAVE_ENABLE
   #ifndef CFG_TUH_DWC2_SLAVE_ENABLE_DEFAULT
@@ -285,6 +300,30 @@
   #define CFG_TUH_DWC2_DMA_ENABLE   CFG_TUH_DWC2_DMA_ENABLE_DEFAULT
 #endif
 
+// Use MUSB (Inventra) multichannel DMA controller in mode 1 (multi-packet) for bulk endpoints. Channels are assigned
+// to endpoints when opened, endpoint without channel or unaligned buffer falls back to CPU FIFO access.
+#ifndef CFG_TUD_MUSB_DMA
+  #define CFG_TUD_MUSB_DMA 0
+#endif
+
+// Double buffer (BUF_MOD ping-pong) bulk endpoints of WCH USBHS device whose endpoint number is used in one direction
+// only. Both packet buffers are armed ahead so that only length needs updating between packets.
+#ifndef CFG_TUD_WCH_USBHS_DBUF
+  #define CFG_TUD_WCH_USBHS_DBUF 0
+#endif
+
+// LPC IP3511 device: double buffer bulk IN endpoints, next chunk is programmed to the second buffer of endpoint
+// command list while the first one is on the bus
+#ifndef CFG_TUD_IP3511_DBUF
+  #define CFG_TUD_IP3511_DBUF 0
+#endif
+
+// LPC IP3511 device: let bulk endpoints of full speed port transfer multiple 64-byte packets per buffer (up to 960
+// bytes) instead of one packet per buffer
+#ifndef CFG_TUD_IP3511_FS_BURST
+  #define CFG_TUD_IP3511_FS_BURST 0
+#endif
+
 // Enable PIO-USB software host controller
 #ifndef CFG_TUH_RPI_PIO_USB
   #define CFG_TUH_RPI_PIO_USB 0
@@ -395,6 +434,62 @@
   #define CFG_TUD_LOG_LEVEL   2
 #endif
 
+// Binary trace backend for TU_LOG: format string address and arguments are recorded instead of being formatted by
+// printf on target, then decoded on host by tools/trace_decode.py with the firmware ELF. Records are passed to
+// CFG_TUSB_DEBUG_TRACE_WRITE(buf, len) if defined (e.g a SEGGER RTT channel), otherwise kept in a ring buffer
+// read out with tu_trace_read()
+#ifndef CFG_TUSB_DEBUG_TRACE
+  #define CFG_TUSB_DEBUG_TRACE 0
+#endif
+
+// Size of trace ring buffer in 32-bit words, must be power of 2
+#ifndef CFG_TUSB_DEBUG_TRACE_BUFSIZE
+  #define CFG_TUSB_DEBUG_TRACE_BUFSIZE 1024
+#endif
+
+// Max bytes of memory dump (TU_LOG_MEM, TU_LOG_BUF) kept in a trace record, the rest is truncated
+#ifndef CFG_TUSB_DEBUG_TRACE_MEM_MAX
+  #define CFG_TUSB_DEBUG_TRACE_MEM_MAX 64
+#endif
+
+// In-stack packet capture: setup packets, transfer submissions and completions of usbd/usbh are recorded into a ring
+// of fixed-size entries and exported as pcapng (Linux usbmon link type) with tusb_capture_export()
+#ifndef CFG_TUSB_CAPTURE
+  #define CFG_TUSB_CAPTURE 0
+#endif
+
+// Number of capture entries, must be power of 2. Oldest entries are overwritten when full
+#ifndef CFG_TUSB_CAPTURE_DEPTH
+  #define CFG_TUSB_CAPTURE_DEPTH 64
+#endif
+
+// Max data bytes kept per entry (snap length), at least 8 for setup packet
+#ifndef CFG_TUSB_CAPTURE_SNAPLEN
+  #define CFG_TUSB_CAPTURE_SNAPLEN 32
+#endif
+
+// Number of endpoints whose transfer type and buffer are tracked for capture
+#ifndef CFG_TUSB_CAPTURE_EDPT_MAX
+  #define CFG_TUSB_CAPTURE_EDPT_MAX 16
+#endif
+
+// Max number of running endpoint bridges (tusb_bridge_open()) forwarding data between host and/or device endpoints
+// without copy, 0 to disable
+#ifndef CFG_TUSB_BRIDGE
+  #define CFG_TUSB_BRIDGE 0
+#endif
+
+// Number of buffer slots of a bridge, must be power of 2
+#ifndef CFG_TUSB_BRIDGE_DEPTH
+  #define CFG_TUSB_BRIDGE_DEPTH 4
+#endif
+
+// Number of device MSC LUNs which can be mapped to a LUN of a host mounted MSC device (tusb_msc_passthrough_attach()),
+// 0 to disable. Requires both CFG_TUD_MSC and CFG_TUH_MSC
+#ifndef CFG_TUSB_MSC_PASSTHROUGH
+  #define CFG_TUSB_MSC_PASSTHROUGH 0
+#endif
+
 // Memory section for placing buffer used for usb transferring. If MEM_SECTION is different for
 // host and device use: CFG_TUD_MEM_SECTION, CFG_TUH_MEM_SECTION instead
 #ifndef CFG_TUSB_MEM_SECTION
@@ -415,6 +510,29 @@
   #define CFG_TUSB_MEM_DCACHE_LINE_SIZE CFG_TUSB_MEM_DCACHE_LINE_SIZE_DEFAULT
 #endif
 
+// Copy data between tu_fifo and linear buffer with aligned word loop instead of memcpy(). Useful when
+// libc memcpy() is optimized for size e.g newlib-nano. Alternatively CFG_TUSB_FIFO_MEMCPY can be defined
+// to a port/application function with memcpy() signature e.g DMA-assisted copy.
+#ifndef CFG_TUSB_FIFO_COPY_WORDS
+  #define CFG_TUSB_FIFO_COPY_WORDS 0
+#endif
+
+// Use 32-bit index for tu_fifo to support depth larger than 32K items, at the cost of larger tu_fifo_t
+#ifndef CFG_TUSB_FIFO_INDEX_32BIT
+  #define CFG_TUSB_FIFO_INDEX_32BIT 0
+#endif
+
+// Support ISR-safe multiple producers for tu_fifo on selected fifo (tu_fifo_set_isr_safe()).
+// Port/application must provide tu_critical_enter() and tu_critical_exit().
+#ifndef CFG_TUSB_FIFO_ISR_SAFE
+  #define CFG_TUSB_FIFO_ISR_SAFE 0
+#endif
+
+// Keep fill level statistics (peak, overflow count, total written) and high/low watermark for tu_fifo
+#ifndef CFG_TUSB_FIFO_STATS
+  #define CFG_TUSB_FIFO_STATS 0
+#endif
+
 // OS selection
 #ifndef CFG_TUSB_OS
   #define CFG_TUSB_OS             OPT_OS_NONE
@@ -428,6 +546,36 @@
   #define CFG_TUSB_OS_INC_PATH  CFG_TUSB_OS_INC_PATH_DEFAULT
 #endif
 
+// Multi-core: core which runs USB IRQ and usbd/usbh task, tusb_init() must be called on this core. Other cores only
+// exchange data with the stack through lock-free fifos, endpoint transfers requested by them are deferred to usbd
+// task. Event queue uses its own hardware spinlock on pico. -1 if not pinned
+#ifndef CFG_TUSB_CORE_AFFINITY
+  #define CFG_TUSB_CORE_AFFINITY -1
+#endif
+
+// OS None: usbd/usbh task receives events without disabling USB interrupt, since it is the only consumer and ISR
+// is the producer (single producer single consumer). Sending from task context still disables USB interrupt,
+// unless CFG_TUSB_FIFO_ISR_SAFE is also enabled to let task and ISR produce concurrently.
+#ifndef CFG_TUSB_OS_NONE_QUEUE_LOCKFREE
+  #define CFG_TUSB_OS_NONE_QUEUE_LOCKFREE 0
+#endif
+
+// FreeRTOS: static allocation only without any mutex objects, mutex is replaced by scheduler suspension (code must
+// not block while holding it). Implies CFG_TUSB_OS_FREERTOS_QUEUE_NOTIFY
+#ifndef CFG_TUSB_OS_FREERTOS_STATIC_ONLY
+  #define CFG_TUSB_OS_FREERTOS_STATIC_ONLY 0
+#endif
+
+// FreeRTOS: event queue is a lock-free tu_fifo with direct-to-task notification to wake up the consumer task,
+// instead of a FreeRTOS queue. Notification value (index 0) of usbd/usbh task is used by the stack.
+#ifndef CFG_TUSB_OS_FREERTOS_QUEUE_NOTIFY
+  #define CFG_TUSB_OS_FREERTOS_QUEUE_NOTIFY CFG_TUSB_OS_FREERTOS_STATIC_ONLY
+#endif
+
+#if CFG_TUSB_OS_FREERTOS_STATIC_ONLY && !CFG_TUSB_OS_FREERTOS_QUEUE_NOTIFY
+  #error "CFG_TUSB_OS_FREERTOS_STATIC_ONLY requires CFG_TUSB_OS_FREERTOS_QUEUE_NOTIFY"
+#endif
+
 //--------------------------------------------------------------------
 // Device Options (Default)
 //--------------------------------------------------------------------
@@ -442,12 +590,25 @@
   #define CFG_TUD_MEM_ALIGN       CFG_TUSB_MEM_ALIGN
 #endif
 
+// CFG_TUD_MEM_SECTION is a non-cacheable region (e.g configured by MPU): endpoint buffers (TUD_EPBUF_DEF) are
+// declared within it, cache line padding and maintenance are skipped. Application buffers given to zero-copy API
+// must be placed there too
+#ifndef CFG_TUD_MEM_NONCACHEABLE
+  #define CFG_TUD_MEM_NONCACHEABLE  0
+#endif
+
 #ifndef CFG_TUD_MEM_DCACHE_ENABLE
   #ifndef CFG_TUD_MEM_DCACHE_ENABLE_DEFAULT
   #define CFG_TUD_MEM_DCACHE_ENABLE_DEFAULT  0
   #endif
 
-  #define CFG_TUD_MEM_DCACHE_ENABLE   CFG_TUD_MEM_DCACHE_ENABLE_DEFAULT
+  #if CFG_TUD_MEM_NONCACHEABLE
+    #define CFG_TUD_MEM_DCACHE_ENABLE   0
+  #else
+    #define CFG_TUD_MEM_DCACHE_ENABLE   CFG_TUD_MEM_DCACHE_ENABLE_DEFAULT
+  #endif
+#elif CFG_TUD_MEM_DCACHE_ENABLE && CFG_TUD_MEM_NONCACHEABLE
+  #error "CFG_TUD_MEM_DCACHE_ENABLE must be 0 with CFG_TUD_MEM_NONCACHEABLE"
 #endif
 
 #ifndef CFG_TUD_MEM_DCACHE_LINE_SIZE
@@ -458,6 +619,19 @@
   #define CFG_TUD_ENDPOINT0_SIZE  64
 #endif
 
+// tud_control_xfer_direct() submits the whole data stage as a single transfer instead of one per packet.
+// Only enable if DCD supports multi-packet transfer on control endpoint
+#ifndef CFG_TUD_CONTROL_MULTI_PACKET
+  #define CFG_TUD_CONTROL_MULTI_PACKET 0
+#endif
+
+// Number of device root ports that can run at the same time, each with its own enumeration state.
+// When more than 1, rhport numbers must be less than this value and class driver instances are bound to
+// the port that opened them.
+#ifndef CFG_TUD_RHPORT_NUM
+  #define CFG_TUD_RHPORT_NUM      1
+#endif
+
 #ifndef CFG_TUD_INTERFACE_MAX
   #define CFG_TUD_INTERFACE_MAX   16
 #endif
@@ -471,6 +645,88 @@
   #error "CFG_TUD_ENDPPOINT_MAX must be less than or equal to TUP_DCD_ENDPOINT_MAX"
 #endif
 
+// Allow class driver to handle transfer complete event directly in ISR (xfer_isr) instead of deferring to
+// usbd task. Callbacks of classes enabled with CFG_TUD_<CLASS>_XFER_ISR are then invoked in ISR context.
+// Only supported without RTOS (mutex cannot be taken in ISR).
+#ifndef CFG_TUD_XFER_ISR
+  #define CFG_TUD_XFER_ISR        0
+#endif
+
+// Store a class instance pointer per endpoint (usbd_edpt_set_context) so that class drivers can resolve the
+// interface owning an endpoint in O(1) on transfer complete rather than scanning their interface array.
+// Cost a pointer per endpoint direction.
+#ifndef CFG_TUD_EDPT_CONTEXT
+  #define CFG_TUD_EDPT_CONTEXT    0
+#endif
+
+// Same as above for interfaces (usbd_itf_set_context): together with interface to driver map built at
+// SET_CONFIGURATION, class control requests are dispatched to their instance in O(1). Cost a pointer per interface.
+#ifndef CFG_TUD_ITF_CONTEXT
+  #define CFG_TUD_ITF_CONTEXT     0
+#endif
+
+// Allow queuing a transfer behind the active one on an endpoint (usbd_edpt_xfer_queue). The queued transfer
+// is started in ISR right on completion of the active one, removing the round trip to usbd task between them.
+// Require dcd_edpt_xfer() to be callable in ISR context.
+#ifndef CFG_TUD_EDPT_XFER_QUEUE
+  #define CFG_TUD_EDPT_XFER_QUEUE 0
+#endif
+
+// Support transfer larger than 64KB with usbd_edpt_xfer_ex(). If DCD does not implement dcd_edpt_xfer_ex(),
+// usbd splits it into chunks of CFG_TUD_EDPT_XFER_EX_CHUNK bytes which are chained in ISR.
+#ifndef CFG_TUD_EDPT_XFER_EX
+  #define CFG_TUD_EDPT_XFER_EX    0
+#endif
+
+// Chunk size must be multiple of max packet size, and fit a single DCD transfer (e.g 5 pages of chipidea dTD)
+#ifndef CFG_TUD_EDPT_XFER_EX_CHUNK
+  #define CFG_TUD_EDPT_XFER_EX_CHUNK 16384
+#endif
+
+// Size of endpoint buffer pool in CFG_TUD_MEM_SECTION, class drivers supporting it allocate their endpoint buffers
+// from the pool when opened instead of static ones. Pool is reset with configuration (bus reset, SET_CONFIGURATION),
+// so that drivers of different configurations share the same RAM. 0 to disable
+#ifndef CFG_TUD_EPBUF_POOL_SIZE
+  #define CFG_TUD_EPBUF_POOL_SIZE 0
+#endif
+
+// Alignment of buffers allocated from the pool, must satisfy DCD DMA requirement
+#ifndef CFG_TUD_EPBUF_POOL_ALIGN
+  #define CFG_TUD_EPBUF_POOL_ALIGN (CFG_TUD_MEM_DCACHE_ENABLE ? CFG_TUD_MEM_DCACHE_LINE_SIZE : 4)
+#endif
+
+// Max number of interface descriptors (including alternate settings) indexed per configuration, allowing class
+// drivers to look up an alternate setting with usbd_find_interface_desc() without walking the descriptor.
+// 0 to disable
+#ifndef CFG_TUD_ITF_INDEX_MAX
+  #define CFG_TUD_ITF_INDEX_MAX   0
+#endif
+
+// Collect per-endpoint transfer statistics and event latency, read with tud_stats_get().
+// Latency uses timestamp from tud_stats_timestamp_cb() e.g a cycle counter
+#ifndef CFG_TUD_STATS
+  #define CFG_TUD_STATS           0
+#endif
+
+// Number of class drivers (application drivers first, then built-in ones) whose callback time is accounted by
+// CFG_TUD_STATS, in tud_stats_timestamp_cb() ticks
+#ifndef CFG_TUD_STATS_DRIVER_MAX
+  #define CFG_TUD_STATS_DRIVER_MAX  8
+#endif
+
+// Shorten time from tud_init() to configured: class drivers are initialized by the first tud_task() instead of
+// tud_init() so that device is connected sooner, and device/configuration descriptors are requested from callbacks
+// once per bus reset rather than for each use. Class API must not be used before the first tud_task()
+#ifndef CFG_TUD_FAST_BOOT
+  #define CFG_TUD_FAST_BOOT       0
+#endif
+
+// USB 2.0 Link Power Management: L1 sleep with tens of microseconds resume, configured with tud_lpm_config().
+// Device descriptor must be bcdUSB 0x0201 with USB 2.0 Extension capability in BOS e.g TUD_BOS_USB20_EXT_LPM_DESCRIPTOR()
+#ifndef CFG_TUD_LPM
+  #define CFG_TUD_LPM             0
+#endif
+
 // USB 2.0 7.1.20: compliance test mode support
 #ifndef CFG_TUD_TEST_MODE
   #define CFG_TUD_TEST_MODE       0
@@ -493,6 +749,10 @@
   #define CFG_TUD_MSC             0
 #endif
 
+#ifndef CFG_TUD_UAS
+  #define CFG_TUD_UAS             0
+#endif
+
 #ifndef CFG_TUD_HID
   #define CFG_TUD_HID             0
 #endif
@@ -549,6 +809,53 @@
   #ifndef CFG_TUH_ENUMERATION_BUFSIZE
     #define CFG_TUH_ENUMERATION_BUFSIZE 256
   #endif
+
+  // Cache configuration descriptor of enumerated devices keyed by their device descriptor (VID/PID/bcdDevice/
+  // iSerialNumber ...) to skip reading it again when the same device is re-attached. Application can also persist
+  // cached descriptors with tuh_descriptor_cache_load_cb()/tuh_descriptor_cache_store_cb()
+  #ifndef CFG_TUH_DESC_CACHE
+    #define CFG_TUH_DESC_CACHE 0
+  #endif
+
+  // Number of RAM cache entries, can be 0 to only use application callbacks
+  #ifndef CFG_TUH_DESC_CACHE_ENTRIES
+    #define CFG_TUH_DESC_CACHE_ENTRIES 4
+  #endif
+
+  // Max length of cached configuration descriptor, longer one is not cached in RAM
+  #ifndef CFG_TUH_DESC_CACHE_BUFSIZE
+    #define CFG_TUH_DESC_CACHE_BUFSIZE CFG_TUH_ENUMERATION_BUFSIZE
+  #endif
+
+  // HCD can carry out control transfers of different devices concurrently (per-device control endpoint)
+  #ifndef TUP_HCD_CONTROL_CONCURRENT
+    #if (defined(TUP_USBIP_EHCI) || defined(TUP_USBIP_OHCI) || defined(TUP_USBIP_DWC2) || CFG_TUH_MAX3421) && !CFG_TUH_RPI_PIO_USB
+      #define TUP_HCD_CONTROL_CONCURRENT 1
+    #else
+      #define TUP_HCD_CONTROL_CONCURRENT 0
+    #endif
+  #endif
+
+  // Each device has its own control transfer state, allowing control transfers of different devices in parallel.
+  // Otherwise only one control transfer is executed at a time across all devices (default). Opt-in since it changes
+  // enumeration and control scheduling, require HCD support (TUP_HCD_CONTROL_CONCURRENT)
+  #ifndef CFG_TUH_CONTROL_CONCURRENT
+    #define CFG_TUH_CONTROL_CONCURRENT 0
+  #endif
+
+  #if CFG_TUH_CONTROL_CONCURRENT && !TUP_HCD_CONTROL_CONCURRENT
+    #error "CFG_TUH_CONTROL_CONCURRENT is not supported by this HCD"
+  #endif
+
+  // Overlap enumeration stages: reset/set address of next attached device while previous one is still reading its
+  // descriptors. Requires concurrent control transfers
+  #ifndef CFG_TUH_ENUM_OVERLAP
+    #define CFG_TUH_ENUM_OVERLAP CFG_TUH_CONTROL_CONCURRENT
+  #endif
+
+  #if CFG_TUH_ENUM_OVERLAP && !CFG_TUH_CONTROL_CONCURRENT
+    #error "CFG_TUH_ENUM_OVERLAP requires CFG_TUH_CONTROL_CONCURRENT"
+  #endif
 #endif // CFG_TUH_ENABLED
 
 // Attribute to place data in accessible RAM for host controller (default: CFG_TUSB_MEM_SECTION)
@@ -561,12 +868,25 @@
   #define CFG_TUH_MEM_ALIGN     CFG_TUSB_MEM_ALIGN
 #endif
 
+// CFG_TUH_MEM_SECTION is a non-cacheable region (e.g configured by MPU): endpoint buffers (TUH_EPBUF_DEF) are
+// declared within it, cache line padding and maintenance are skipped. Application buffers given to zero-copy API
+// must be placed there too
+#ifndef CFG_TUH_MEM_NONCACHEABLE
+  #define CFG_TUH_MEM_NONCACHEABLE  0
+#endif
+
 #ifndef CFG_TUH_MEM_DCACHE_ENABLE
   #ifndef CFG_TUH_MEM_DCACHE_ENABLE_DEFAULT
   #define CFG_TUH_MEM_DCACHE_ENABLE_DEFAULT  0
   #endif
 
-  #define CFG_TUH_MEM_DCACHE_ENABLE   CFG_TUH_MEM_DCACHE_ENABLE_DEFAULT
+  #if CFG_TUH_MEM_NONCACHEABLE
+    #define CFG_TUH_MEM_DCACHE_ENABLE   0
+  #else
+    #define CFG_TUH_MEM_DCACHE_ENABLE   CFG_TUH_MEM_DCACHE_ENABLE_DEFAULT
+  #endif
+#elif CFG_TUH_MEM_DCACHE_ENABLE && CFG_TUH_MEM_NONCACHEABLE
+  #error "CFG_TUH_MEM_DCACHE_ENABLE must be 0 with CFG_TUH_MEM_NONCACHEABLE"
 #endif
 
 #ifndef CFG_TUH_MEM_DCACHE_LINE_SIZE
@@ -579,6 +899,17 @@
   #define CFG_TUH_HUB    0
 #endif
 
+// Inrush current budget (mA) for powering hub ports. Ports are powered in groups that fit the budget, each group
+// counts CFG_TUH_HUB_PORT_CURRENT_MA per port and the next group waits for bPwrOn2PwrGood. 0 means power all at once
+#ifndef CFG_TUH_HUB_POWER_BUDGET_MA
+  #define CFG_TUH_HUB_POWER_BUDGET_MA    0
+#endif
+
+// Current of a port before its device is configured, default is one unit load
+#ifndef CFG_TUH_HUB_PORT_CURRENT_MA
+  #define CFG_TUH_HUB_PORT_CURRENT_MA    100
+#endif
+
 #ifndef CFG_TUH_CDC
   #define CFG_TUH_CDC    0
 #endif
@@ -588,40 +919,32 @@
   #define CFG_TUH_CDC_FTDI 0
 #endif
 
-// List of product IDs that can use the FTDI CDC driver. 0x0403 is FTDI's VID
-#ifndef CFG_TUH_CDC_FTDI_VID_PID_LIST
-  #define CFG_TUH_CDC_FTDI_VID_PID_LIST \
-    {0x0403, 0x6001}, {0x0403, 0x6006}, {0x0403, 0x6010}, {0x0403, 0x6011}, \
-    {0x0403, 0x6014}, {0x0403, 0x6015}, {0x0403, 0x8372}, {0x0403, 0xFBFA}, \
-    {0x0403, 0xCD18}
-#endif
+// FTDI devices are listed in usbh device ID table (usbh.c). Additional VID/PID pairs that use the FTDI CDC driver
+// can be given as e.g {0x1234, 0x5678}, {0x1234, 0x5679}
+// #define CFG_TUH_CDC_FTDI_VID_PID_LIST
 
 // CP210X is not part of CDC class, only to re-use CDC driver API
 #ifndef CFG_TUH_CDC_CP210X
   #define CFG_TUH_CDC_CP210X 0
 #endif
 
-// List of product IDs that can use the CP210X CDC driver. 0x10C4 is Silicon Labs' VID
-#ifndef CFG_TUH_CDC_CP210X_VID_PID_LIST
-  #define CFG_TUH_CDC_CP210X_VID_PID_LIST \
-    {0x10C4, 0xEA60}, {0x10C4, 0xEA70}
-#endif
+// Additional VID/PID pairs that use the CP210X CDC driver, see CFG_TUH_CDC_FTDI_VID_PID_LIST
+// #define CFG_TUH_CDC_CP210X_VID_PID_LIST
 
 #ifndef CFG_TUH_CDC_CH34X
   // CH34X is not part of CDC class, only to re-use CDC driver API
   #define CFG_TUH_CDC_CH34X 0
 #endif
 
-// List of product IDs that can use the CH34X CDC driver
-#ifndef CFG_TUH_CDC_CH34X_VID_PID_LIST
-  #define CFG_TUH_CDC_CH34X_VID_PID_LIST \
-    { 0x1a86, 0x5523 }, /* ch341 chip */ \
-    { 0x1a86, 0x7522 }, /* ch340k chip */ \
-    { 0x1a86, 0x7523 }, /* ch340 chip */ \
-    { 0x1a86, 0xe523 }, /* ch330 chip */ \
-    { 0x4348, 0x5523 }, /* ch340 custom chip */ \
-    { 0x2184, 0x0057 }, /* overtaken from Linux Kernel driver /drivers/usb/serial/ch341.c */ \
-    { 0x9986, 0x7523 }  /* overtaken from Linux Kernel driver /drivers/usb/serial/ch341.c */
+// Additional VID/PID pairs that use the CH34X CDC driver, see CFG_TUH_CDC_FTDI_VID_PID_LIST
+// #define CFG_TUH_CDC_CH34X_VID_PID_LIST
+
+#ifndef CFG_TUH_AUDIO
+  #define CFG_TUH_AUDIO  0
+#endif
+
+#ifndef CFG_TUH_BTH
+  #define CFG_TUH_BTH    0
 #endif
 
 #ifndef CFG_TUH_HID
@@ -636,6 +959,20 @@
   #define CFG_TUH_MSC    0
 #endif
 
+// USB Attached SCSI, takes mass storage interfaces having UAS alternate setting before MSC (Bulk-Only) driver
+#ifndef CFG_TUH_UAS
+  #define CFG_TUH_UAS    0
+#endif
+
+#ifndef CFG_TUH_NCM
+  #define CFG_TUH_NCM    0
+#endif
+
+// Remote NDIS, takes RNDIS interfaces (including CDC ACM with vendor protocol) before CDC driver
+#ifndef CFG_TUH_RNDIS
+  #define CFG_TUH_RNDIS  0
+#endif
+
 #ifndef CFG_TUH_VENDOR
   #define CFG_TUH_VENDOR 0
 #endif
@@ -644,6 +981,33 @@
   #define CFG_TUH_API_EDPT_XFER 0
 #endif
 
+// Account time spent in class driver xfer_cb per driver (application drivers first, then built-in ones), read with
+// tuh_stats_get(). Time uses timestamp from tuh_stats_timestamp_cb() e.g a cycle counter
+#ifndef CFG_TUH_STATS
+  #define CFG_TUH_STATS 0
+#endif
+
+#ifndef CFG_TUH_STATS_DRIVER_MAX
+  #define CFG_TUH_STATS_DRIVER_MAX 8
+#endif
+
+// Record enumeration timeline of each device: time of each stage, retries, delays and class drivers set_config, read
+// with tuh_enum_stats_get(). Address 0 holds the latest device in dev0 stage i.e before its address is set
+#ifndef CFG_TUH_ENUM_STATS
+  #define CFG_TUH_ENUM_STATS 0
+#endif
+
+// Number of transfers that can be queued by tuh_edpt_xfer() on busy endpoints, shared by all endpoints. Queued
+// transfer is submitted as soon as previous one completes, before its callback is invoked. Requires
+// CFG_TUH_API_EDPT_XFER
+#ifndef CFG_TUH_EDPT_XFER_QUEUE
+  #define CFG_TUH_EDPT_XFER_QUEUE 0
+#endif
+
+#if CFG_TUH_EDPT_XFER_QUEUE && !CFG_TUH_API_EDPT_XFER
+  #error "CFG_TUH_EDPT_XFER_QUEUE requires CFG_TUH_API_EDPT_XFER"
+#endif
+
 //--------------------------------------------------------------------+
 // TypeC Options (Default)
 //--------------------------------------------------------------------+
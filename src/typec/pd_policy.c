@@ -0,0 +1,514 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#include "tusb_option.h"
+#include "pd_policy.h" // for CFG_TUC_PD_POLICY default
+
+#if CFG_TUC_ENABLED && CFG_TUC_PD_POLICY
+
+#include "tusb.h" // for tusb_time_millis_api()
+#include "tcd.h"
+
+#define PE_DEBUG   2
+#define TU_LOG_PE(...)   TU_LOG(PE_DEBUG, __VA_ARGS__)
+
+//--------------------------------------------------------------------+
+// MACRO CONSTANT TYPEDEF
+//--------------------------------------------------------------------+
+
+// Spec timers (USBPD table 6-68), in milliseconds
+enum {
+  PE_TIME_SINK_WAIT_CAP     = 500, // tTypeCSinkWaitCap 310-620
+  PE_TIME_SENDER_RESPONSE   = 30,  // tSenderResponse 24-30
+  PE_TIME_PS_TRANSITION     = 500, // tPSTransition 450-550
+  PE_TIME_HARD_RESET_RECOVER = 1000, // tSafe0V + tSrcRecover + tSrcTurnOn, before source sends capabilities again
+};
+
+enum {
+  PE_HARD_RESET_COUNT = 2, // nHardResetCount
+  PE_SRC_PDO_MAX      = 7,
+};
+
+typedef enum {
+  PE_SNK_DISABLED = 0,      // detached or gave up after nHardResetCount
+  PE_SNK_WAIT_FOR_CAPS,
+  PE_SNK_SELECT_CAPABILITY, // Request sent, waiting Accept
+  PE_SNK_TRANSITION_SINK,   // Accepted, waiting PS_RDY
+  PE_SNK_READY,
+} pe_state_t;
+
+// Preference entry converted to PDO units
+typedef struct {
+  uint8_t  type;
+  uint16_t voltage; // Fixed: 50mV unit, PPS: 20mV unit
+  uint16_t current; // Fixed: 10mA unit, PPS: 50mA unit
+} pe_pref_t;
+
+typedef struct {
+  uint8_t state;
+  uint8_t specs_rev;        // min of ours and partner's
+  uint8_t hard_reset_count;
+  uint8_t pref_count;
+  uint8_t src_count;
+
+  pe_pref_t pref[CFG_TUC_PD_SINK_PDO_MAX];
+  uint32_t src_pdo[PE_SRC_PDO_MAX]; // last Source_Capabilities
+
+  tuc_pd_contract_t contract; // current explicit contract
+  tuc_pd_contract_t request;  // contract being requested
+
+  uint32_t timer_start;
+  uint32_t timer_ms;          // 0 if stopped
+  uint32_t keepalive_start;   // last PPS Request
+} pe_port_t;
+
+static pe_port_t _pe[TUP_TYPEC_RHPORTS_NUM];
+
+//--------------------------------------------------------------------+
+// Helper
+//--------------------------------------------------------------------+
+
+TU_ATTR_ALWAYS_INLINE static inline void timer_start(pe_port_t* pe, uint32_t ms) {
+  pe->timer_start = tusb_time_millis_api();
+  pe->timer_ms = ms;
+}
+
+TU_ATTR_ALWAYS_INLINE static inline void timer_stop(pe_port_t* pe) {
+  pe->timer_ms = 0;
+}
+
+static bool send_ctrl(uint8_t rhport, uint8_t msg_type) {
+  pd_header_t const header = {
+      .msg_type   = msg_type,
+      .data_role  = PD_DATA_ROLE_UFP,
+      .specs_rev  = _pe[rhport].specs_rev,
+      .power_role = PD_POWER_ROLE_SINK,
+      .msg_id     = 0, // managed by usbc
+      .n_data_obj = 0,
+      .extended   = 0,
+  };
+  return usbc_msg_send(rhport, &header, NULL);
+}
+
+static bool send_data(uint8_t rhport, uint8_t msg_type, uint32_t const* dobj, uint8_t count) {
+  pd_header_t const header = {
+      .msg_type   = msg_type,
+      .data_role  = PD_DATA_ROLE_UFP,
+      .specs_rev  = _pe[rhport].specs_rev,
+      .power_role = PD_POWER_ROLE_SINK,
+      .msg_id     = 0, // managed by usbc
+      .n_data_obj = count,
+      .extended   = 0,
+  };
+  return usbc_msg_send(rhport, &header, dobj);
+}
+
+static void contract_lost(uint8_t rhport) {
+  pe_port_t* pe = &_pe[rhport];
+  bool const had_contract = pe->contract.object_position != 0;
+  tu_memclr(&pe->contract, sizeof(tuc_pd_contract_t));
+  if (had_contract && tuc_pd_contract_cb) {
+    tuc_pd_contract_cb(rhport, NULL);
+  }
+}
+
+static void hard_reset_send(uint8_t rhport) {
+  pe_port_t* pe = &_pe[rhport];
+  contract_lost(rhport);
+  usbc_msg_id_reset(rhport);
+
+  if (pe->hard_reset_count >= PE_HARD_RESET_COUNT || tcd_hard_reset_send == NULL) {
+    // partner is not PD capable or does not respond: stay at vSafe5V default contract
+    TU_LOG_PE("PE: give up\r\n");
+    pe->state = PE_SNK_DISABLED;
+    timer_stop(pe);
+    return;
+  }
+
+  TU_LOG_PE("PE: Hard Reset\r\n");
+  pe->hard_reset_count++;
+  tcd_hard_reset_send(rhport);
+  pe->state = PE_SNK_WAIT_FOR_CAPS;
+  timer_start(pe, PE_TIME_HARD_RESET_RECOVER + PE_TIME_SINK_WAIT_CAP);
+}
+
+static bool request_send(uint8_t rhport) {
+  pe_port_t* pe = &_pe[rhport];
+  tuc_pd_contract_t const* req = &pe->request;
+  uint32_t rdo;
+
+  if (req->type == PD_PDO_TYPE_APDO) {
+    pd_rdo_pps_t const pps = {
+        .current_operate_50ma = (uint32_t) (req->current_ma / 50) & 0x7Fu,
+        .voltage_20mv         = (uint32_t) (req->voltage_mv / 20) & 0xFFFu,
+        .usb_comm_capable     = 1,
+        .no_usb_suspend       = 1,
+        .capability_mismatch  = req->mismatch ? 1u : 0u,
+        .object_position      = req->object_position & 0x0Fu,
+    };
+    memcpy(&rdo, &pps, 4);
+    pe->keepalive_start = tusb_time_millis_api();
+  } else {
+    uint32_t const current_10ma = (uint32_t) (req->current_ma / 10) & 0x3FFu;
+    pd_rdo_fixed_variable_t const fixed = {
+        .current_extremum_10ma = current_10ma,
+        .current_operate_10ma  = current_10ma,
+        .usb_comm_capable      = 1,
+        .no_usb_suspend        = 1,
+        .capability_mismatch   = req->mismatch ? 1u : 0u,
+        .object_position       = req->object_position & 0x0Fu,
+    };
+    memcpy(&rdo, &fixed, 4);
+  }
+
+  rdo = tu_htole32(rdo);
+  TU_LOG_PE("PE: Request PDO %u %u mV %u mA\r\n", req->object_position, req->voltage_mv, req->current_ma);
+  pe->state = PE_SNK_SELECT_CAPABILITY;
+  timer_start(pe, PE_TIME_SENDER_RESPONSE);
+  return send_data(rhport, PD_DATA_REQUEST, &rdo, 1);
+}
+
+// Select source PDO with precomputed preference table: first preferred entry offered by source wins
+static void capability_evaluate(uint8_t rhport) {
+  pe_port_t* pe = &_pe[rhport];
+  tuc_pd_contract_t* req = &pe->request;
+
+  for (uint8_t p = 0; p < pe->pref_count; p++) {
+    pe_pref_t const* pref = &pe->pref[p];
+
+    for (uint8_t i = 0; i < pe->src_count; i++) {
+      uint32_t const pdo = pe->src_pdo[i];
+      uint8_t const pdo_type = (uint8_t) (pdo >> 30);
+
+      if (pref->type == PD_PDO_TYPE_FIXED && pdo_type == PD_PDO_TYPE_FIXED) {
+        pd_pdo_fixed_t const* fixed = (pd_pdo_fixed_t const*) &pdo;
+        if (fixed->voltage_50mv == pref->voltage && fixed->current_max_10ma >= pref->current) {
+          *req = (tuc_pd_contract_t) {
+            .object_position = (uint8_t) (i + 1), .type = PD_PDO_TYPE_FIXED,
+            .voltage_mv = (uint16_t) (pref->voltage * 50), .current_ma = (uint16_t) (pref->current * 10),
+          };
+          return;
+        }
+      } else if (pref->type == PD_PDO_TYPE_APDO && pdo_type == PD_PDO_TYPE_APDO) {
+        pd_pdo_apdo_t const* apdo = (pd_pdo_apdo_t const*) &pdo;
+        // SPR PPS only, 100mV range vs 20mV request
+        if (apdo->spr_programmable == 0 &&
+            apdo->voltage_min_100mv * 5u <= pref->voltage && pref->voltage <= apdo->voltage_max_100mv * 5u &&
+            apdo->current_max_50ma >= pref->current) {
+          *req = (tuc_pd_contract_t) {
+            .object_position = (uint8_t) (i + 1), .type = PD_PDO_TYPE_APDO,
+            .voltage_mv = (uint16_t) (pref->voltage * 20), .current_ma = (uint16_t) (pref->current * 50),
+          };
+          return;
+        }
+      }
+    }
+  }
+
+  // fallback to vSafe5V which is always the first PDO
+  pd_pdo_fixed_t const* safe5v = (pd_pdo_fixed_t const*) &pe->src_pdo[0];
+  *req = (tuc_pd_contract_t) {
+    .object_position = 1, .type = PD_PDO_TYPE_FIXED, .voltage_mv = 5000,
+    .current_ma = (uint16_t) (safe5v->current_max_10ma * 10), .mismatch = pe->pref_count > 0,
+  };
+}
+
+static void sink_cap_send(uint8_t rhport) {
+  pe_port_t* pe = &_pe[rhport];
+  uint32_t pdo[1 + CFG_TUC_PD_SINK_PDO_MAX];
+  uint8_t count = 0;
+
+  // vSafe5V first, using largest fixed current of table
+  uint16_t current_10ma = 50;
+  for (uint8_t p = 0; p < pe->pref_count; p++) {
+    if (pe->pref[p].type == PD_PDO_TYPE_FIXED) {
+      current_10ma = tu_max16(current_10ma, pe->pref[p].current);
+    }
+  }
+  pd_pdo_fixed_t const safe5v = {
+    .current_max_10ma = current_10ma & 0x3FFu, .voltage_50mv = 100, .usb_comm_capable = 1,
+    .type = PD_PDO_TYPE_FIXED
+  };
+  memcpy(&pdo[count++], &safe5v, 4);
+
+  for (uint8_t p = 0; p < pe->pref_count; p++) {
+    pe_pref_t const* pref = &pe->pref[p];
+    if (pref->type == PD_PDO_TYPE_FIXED && pref->voltage != 100) {
+      pd_pdo_fixed_t const fixed = {
+        .current_max_10ma = pref->current & 0x3FFu, .voltage_50mv = pref->voltage & 0x3FFu, .type = PD_PDO_TYPE_FIXED
+      };
+      memcpy(&pdo[count++], &fixed, 4);
+    } else if (pref->type == PD_PDO_TYPE_APDO) {
+      uint8_t const v_100mv = (uint8_t) (pref->voltage / 5);
+      pd_pdo_apdo_t const apdo = {
+        .current_max_50ma = pref->current & 0x7Fu, .voltage_min_100mv = v_100mv, .voltage_max_100mv = v_100mv,
+        .type = PD_PDO_TYPE_APDO
+      };
+      memcpy(&pdo[count++], &apdo, 4);
+    }
+  }
+
+  for (uint8_t i = 0; i < count; i++) {
+    pdo[i] = tu_htole32(pdo[i]);
+  }
+  send_data(rhport, PD_DATA_SINK_CAP, pdo, count);
+}
+
+//--------------------------------------------------------------------+
+// Application API
+//--------------------------------------------------------------------+
+
+bool tuc_pd_sink_config(uint8_t rhport, tuc_pd_sink_pdo_t const* table, uint8_t count) {
+  TU_VERIFY(rhport < TUP_TYPEC_RHPORTS_NUM && count <= CFG_TUC_PD_SINK_PDO_MAX);
+  pe_port_t* pe = &_pe[rhport];
+
+  for (uint8_t p = 0; p < count; p++) {
+    tuc_pd_sink_pdo_t const* entry = &table[p];
+    pe_pref_t* pref = &pe->pref[p];
+
+    pref->type = entry->type;
+    if (entry->type == PD_PDO_TYPE_APDO) {
+      pref->voltage = entry->voltage_mv / 20;
+      pref->current = (uint16_t) ((entry->current_ma + 49) / 50);
+    } else {
+      TU_VERIFY(entry->type == PD_PDO_TYPE_FIXED);
+      pref->voltage = entry->voltage_mv / 50;
+      pref->current = (uint16_t) ((entry->current_ma + 9) / 10);
+    }
+  }
+  pe->pref_count = count;
+
+  // ask source to send capabilities again to re-evaluate
+  if (pe->state == PE_SNK_READY) {
+    return send_ctrl(rhport, PD_CTRL_GET_SOURCE_CAP);
+  }
+
+  return true;
+}
+
+tuc_pd_contract_t const* tuc_pd_contract_get(uint8_t rhport) {
+  TU_VERIFY(rhport < TUP_TYPEC_RHPORTS_NUM, NULL);
+  return &_pe[rhport].contract;
+}
+
+bool tuc_pd_pps_set(uint8_t rhport, uint16_t voltage_mv, uint16_t current_ma) {
+  TU_VERIFY(rhport < TUP_TYPEC_RHPORTS_NUM);
+  pe_port_t* pe = &_pe[rhport];
+  TU_VERIFY(pe->state == PE_SNK_READY && pe->contract.type == PD_PDO_TYPE_APDO);
+
+  // check against APDO of current contract, no need to re-evaluate capabilities
+  uint32_t const pdo = pe->src_pdo[pe->contract.object_position - 1];
+  pd_pdo_apdo_t const* apdo = (pd_pdo_apdo_t const*) &pdo;
+  TU_VERIFY(apdo->voltage_min_100mv * 100u <= voltage_mv && voltage_mv <= apdo->voltage_max_100mv * 100u);
+  TU_VERIFY(current_ma <= apdo->current_max_50ma * 50u);
+
+  pe->request = pe->contract;
+  pe->request.voltage_mv = voltage_mv;
+  pe->request.current_ma = current_ma;
+  return request_send(rhport);
+}
+
+bool tuc_pd_hard_reset(uint8_t rhport) {
+  TU_VERIFY(rhport < TUP_TYPEC_RHPORTS_NUM && tcd_hard_reset_send != NULL);
+  _pe[rhport].hard_reset_count = 0;
+  hard_reset_send(rhport);
+  return true;
+}
+
+//--------------------------------------------------------------------+
+// Internal API
+//--------------------------------------------------------------------+
+
+void usbc_pe_init(uint8_t rhport) {
+  pe_port_t* pe = &_pe[rhport];
+  uint8_t const pref_count = pe->pref_count;
+  pe_pref_t pref[CFG_TUC_PD_SINK_PDO_MAX];
+  memcpy(pref, pe->pref, sizeof(pref));
+
+  // preference table may be configured before tuc_init()
+  tu_memclr(pe, sizeof(pe_port_t));
+  memcpy(pe->pref, pref, sizeof(pref));
+  pe->pref_count = pref_count;
+  pe->specs_rev = PD_REV_30;
+}
+
+void usbc_pe_cc_changed(uint8_t rhport, bool attached) {
+  pe_port_t* pe = &_pe[rhport];
+
+  contract_lost(rhport);
+  pe->hard_reset_count = 0;
+  pe->specs_rev = PD_REV_30;
+
+  if (attached) {
+    pe->state = PE_SNK_WAIT_FOR_CAPS;
+    timer_start(pe, PE_TIME_SINK_WAIT_CAP);
+  } else {
+    pe->state = PE_SNK_DISABLED;
+    timer_stop(pe);
+  }
+}
+
+void usbc_pe_hard_reset_received(uint8_t rhport) {
+  pe_port_t* pe = &_pe[rhport];
+  TU_LOG_PE("PE: Hard Reset received\r\n");
+
+  contract_lost(rhport);
+  pe->state = PE_SNK_WAIT_FOR_CAPS;
+  timer_start(pe, PE_TIME_HARD_RESET_RECOVER + PE_TIME_SINK_WAIT_CAP);
+}
+
+void usbc_pe_msg_received(uint8_t rhport, pd_header_t const* header, uint8_t const* dobj, uint8_t const* p_end) {
+  pe_port_t* pe = &_pe[rhport];
+
+  if (header->n_data_obj == 0) {
+    switch (header->msg_type) {
+      case PD_CTRL_ACCEPT:
+        if (pe->state == PE_SNK_SELECT_CAPABILITY) {
+          pe->state = PE_SNK_TRANSITION_SINK;
+          timer_start(pe, PE_TIME_PS_TRANSITION);
+        }
+        break;
+
+      case PD_CTRL_REJECT:
+      case PD_CTRL_WAIT:
+        if (pe->state == PE_SNK_SELECT_CAPABILITY) {
+          // keep previous contract if any, otherwise wait for source to send capabilities again
+          if (pe->contract.object_position) {
+            pe->state = PE_SNK_READY;
+            timer_stop(pe);
+          } else {
+            pe->state = PE_SNK_WAIT_FOR_CAPS;
+            timer_start(pe, PE_TIME_SINK_WAIT_CAP);
+          }
+        }
+        break;
+
+      case PD_CTRL_PS_READY:
+        if (pe->state == PE_SNK_TRANSITION_SINK) {
+          // PPS keep-alive Request re-establishes the same contract, no need to notify
+          bool const changed = pe->contract.object_position != pe->request.object_position ||
+                               pe->contract.voltage_mv != pe->request.voltage_mv ||
+                               pe->contract.current_ma != pe->request.current_ma;
+          pe->state = PE_SNK_READY;
+          pe->hard_reset_count = 0;
+          pe->contract = pe->request;
+          timer_stop(pe);
+          if (changed) {
+            TU_LOG_PE("PE: Contract %u mV %u mA\r\n", pe->contract.voltage_mv, pe->contract.current_ma);
+            if (tuc_pd_contract_cb) {
+              tuc_pd_contract_cb(rhport, &pe->contract);
+            }
+          }
+        }
+        break;
+
+      case PD_CTRL_SOFT_RESET:
+        // MessageID counters are reset by usbc when receiving
+        contract_lost(rhport);
+        send_ctrl(rhport, PD_CTRL_ACCEPT);
+        pe->state = PE_SNK_WAIT_FOR_CAPS;
+        timer_start(pe, PE_TIME_SINK_WAIT_CAP);
+        break;
+
+      case PD_CTRL_GET_SINK_CAP:
+        sink_cap_send(rhport);
+        break;
+
+      case PD_CTRL_DR_SWAP:
+      case PD_CTRL_PR_SWAP:
+      case PD_CTRL_VCONN_SWAP:
+        send_ctrl(rhport, PD_CTRL_REJECT);
+        break;
+
+      default: break;
+    }
+  } else {
+    switch (header->msg_type) {
+      case PD_DATA_SOURCE_CAP: {
+        // Source_Capabilities in any state start a new negotiation
+        pe->specs_rev = tu_min8(header->specs_rev, PD_REV_30);
+        pe->src_count = 0;
+        for (uint8_t i = 0; i < header->n_data_obj && dobj + 4 <= p_end; i++) {
+          pe->src_pdo[pe->src_count++] = tu_le32toh(tu_unaligned_read32(dobj));
+          dobj += 4;
+        }
+
+        if (pe->src_count > 0) {
+          capability_evaluate(rhport);
+          request_send(rhport);
+        }
+        break;
+      }
+
+      default: break;
+    }
+  }
+}
+
+uint32_t usbc_pe_task(uint32_t timeout_ms) {
+  uint32_t const now = tusb_time_millis_api();
+
+  for (uint8_t rhport = 0; rhport < TUP_TYPEC_RHPORTS_NUM; rhport++) {
+    pe_port_t* pe = &_pe[rhport];
+
+    // PPS contract expires if source does not receive Request within tPPSRequest
+    if (pe->state == PE_SNK_READY && pe->contract.type == PD_PDO_TYPE_APDO) {
+      uint32_t const elapsed = now - pe->keepalive_start;
+      if (elapsed >= CFG_TUC_PD_PPS_KEEPALIVE_MS) {
+        pe->request = pe->contract;
+        request_send(rhport);
+      } else {
+        timeout_ms = tu_min32(timeout_ms, CFG_TUC_PD_PPS_KEEPALIVE_MS - elapsed);
+      }
+    }
+
+    if (pe->timer_ms == 0) {
+      continue;
+    }
+
+    uint32_t const elapsed = now - pe->timer_start;
+    if (elapsed < pe->timer_ms) {
+      timeout_ms = tu_min32(timeout_ms, pe->timer_ms - elapsed);
+      continue;
+    }
+
+    // timer expired
+    timer_stop(pe);
+    // SinkWaitCapTimer, SenderResponseTimer and PSTransitionTimer all lead to Hard Reset
+    if (pe->state == PE_SNK_WAIT_FOR_CAPS || pe->state == PE_SNK_SELECT_CAPABILITY ||
+        pe->state == PE_SNK_TRANSITION_SINK) {
+      hard_reset_send(rhport);
+    }
+
+    if (pe->timer_ms) {
+      timeout_ms = tu_min32(timeout_ms, pe->timer_ms);
+    }
+  }
+
+  return timeout_ms;
+}
+
+#endif
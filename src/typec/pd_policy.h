@@ -0,0 +1,119 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#ifndef _TUSB_PD_POLICY_H_
+#define _TUSB_PD_POLICY_H_
+
+#include "common/tusb_common.h"
+#include "pd_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Sink Policy Engine (USBPD 8.3.3.3). Source_Capabilities are answered with a Request selected from application's
+// preference table, Accept/PS_RDY are tracked with spec timers, Soft/Hard Reset and PPS keep-alive are handled.
+// Tables are converted to PDO units once by tuc_pd_sink_config() so that selection is a few integer compares.
+// When enabled, application must not send Request from tuc_pd_data_received_cb().
+
+//--------------------------------------------------------------------+
+// Configuration
+//--------------------------------------------------------------------+
+
+// Enable sink policy engine
+#ifndef CFG_TUC_PD_POLICY
+#define CFG_TUC_PD_POLICY         0
+#endif
+
+// Max entries of sink preference table
+#ifndef CFG_TUC_PD_SINK_PDO_MAX
+#define CFG_TUC_PD_SINK_PDO_MAX   4
+#endif
+
+// PPS Request is repeated within tPPSRequest (10s), in milliseconds
+#ifndef CFG_TUC_PD_PPS_KEEPALIVE_MS
+#define CFG_TUC_PD_PPS_KEEPALIVE_MS  5000
+#endif
+
+//--------------------------------------------------------------------+
+// Types
+//--------------------------------------------------------------------+
+
+// Entry of sink preference table, most preferred first
+typedef struct {
+  uint8_t  type;        // PD_PDO_TYPE_FIXED or PD_PDO_TYPE_APDO (PPS)
+  uint16_t voltage_mv;  // Fixed: supply voltage, PPS: requested output voltage
+  uint16_t current_ma;  // Operating current
+} tuc_pd_sink_pdo_t;
+
+typedef struct {
+  uint8_t  object_position; // position of source PDO (1-7), 0 if there is no explicit contract
+  uint8_t  type;            // PD_PDO_TYPE_FIXED or PD_PDO_TYPE_APDO
+  uint16_t voltage_mv;
+  uint16_t current_ma;
+  bool     mismatch;        // no preferred entry is offered, contract is vSafe5V with capability mismatch
+} tuc_pd_contract_t;
+
+//--------------------------------------------------------------------+
+// Application API
+//--------------------------------------------------------------------+
+
+// Set sink preference table. If an explicit contract exists, Get_Source_Cap is sent to re-evaluate with new table.
+// vSafe5V fixed is always used as fallback and does not need to be in the table
+bool tuc_pd_sink_config(uint8_t rhport, tuc_pd_sink_pdo_t const* table, uint8_t count);
+
+// Get current contract
+tuc_pd_contract_t const* tuc_pd_contract_get(uint8_t rhport);
+
+// Adjust output voltage/current of current PPS contract with a single Request (no capability exchange)
+bool tuc_pd_pps_set(uint8_t rhport, uint16_t voltage_mv, uint16_t current_ma);
+
+// Send Hard Reset, contract returns to vSafe5V
+bool tuc_pd_hard_reset(uint8_t rhport);
+
+//--------------------------------------------------------------------+
+// Callbacks (Weak is optional)
+//--------------------------------------------------------------------+
+
+// Invoked when a contract is established (PS_RDY received), or lost (contract is NULL) by reset or detach
+TU_ATTR_WEAK void tuc_pd_contract_cb(uint8_t rhport, tuc_pd_contract_t const* contract);
+
+//--------------------------------------------------------------------+
+// Internal API
+//--------------------------------------------------------------------+
+void usbc_pe_init(uint8_t rhport);
+void usbc_pe_cc_changed(uint8_t rhport, bool attached);
+void usbc_pe_hard_reset_received(uint8_t rhport);
+void usbc_pe_msg_received(uint8_t rhport, pd_header_t const* header, uint8_t const* dobj, uint8_t const* p_end);
+
+// Check timers of all ports, return milliseconds until next timer expires (capped by timeout_ms)
+uint32_t usbc_pe_task(uint32_t timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -225,6 +225,22 @@ typedef struct TU_ATTR_PACKED {
 } pd_rdo_battery_t;
 TU_VERIFY_STATIC(sizeof(pd_rdo_battery_t) == 4, "Invalid size");
 
+// Programmable Request Data Object table 6-26
+typedef struct TU_ATTR_PACKED {
+  uint32_t current_operate_50ma      :  7; // [6..0] Operating current in 50mA unit
+  uint32_t reserved1                 :  2; // [8..7] Reserved
+  uint32_t voltage_20mv              : 12; // [20..9] Output voltage in 20mV unit
+  uint32_t reserved2                 :  1; // [21] Reserved
+  uint32_t epr_mode_capable          :  1; // [22] EPR mode capable
+  uint32_t unchunked_ext_msg_support :  1; // [23] UnChunked Extended Message Supported
+  uint32_t no_usb_suspend            :  1; // [24] No USB Suspend
+  uint32_t usb_comm_capable          :  1; // [25] USB Communications Capable
+  uint32_t capability_mismatch       :  1; // [26] Capability Mismatch
+  uint32_t reserved3                 :  1; // [27] Reserved
+  uint32_t object_position           :  4; // [31..28] Object Position
+} pd_rdo_pps_t;
+TU_VERIFY_STATIC(sizeof(pd_rdo_pps_t) == 4, "Invalid size");
+
 
 TU_ATTR_PACKED_END  // End of all packed definitions
 TU_ATTR_BIT_FIELD_ORDER_END
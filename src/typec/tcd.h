@@ -46,6 +46,7 @@ enum {
   TCD_EVENT_CC_CHANGED,
   TCD_EVENT_RX_COMPLETE,
   TCD_EVENT_TX_COMPLETE,
+  TCD_EVENT_HARD_RESET, // Hard Reset received from port partner
 };
 
 typedef struct TU_ATTR_PACKED {
@@ -88,6 +89,9 @@ void tcd_int_handler(uint8_t rhport);
 bool tcd_msg_receive(uint8_t rhport, uint8_t* buffer, uint16_t total_bytes);
 bool tcd_msg_send(uint8_t rhport, uint8_t const* buffer, uint16_t total_bytes);
 
+// Send Hard Reset ordered set, abort any message in progress. This API is optional
+bool tcd_hard_reset_send(uint8_t rhport) TU_ATTR_WEAK;
+
 //--------------------------------------------------------------------+
 // Event API (implemented by stack)
 // Called by TCD to notify stack
@@ -136,6 +140,16 @@ void tcd_event_tx_complete(uint8_t rhport, uint16_t xferred_bytes, uint8_t resul
   tcd_event_handler(&event, in_isr);
 }
 
+TU_ATTR_ALWAYS_INLINE static inline
+void tcd_event_hard_reset(uint8_t rhport, bool in_isr) {
+  tcd_event_t event = {
+      .rhport   = rhport,
+      .event_id = TCD_EVENT_HARD_RESET,
+  };
+
+  tcd_event_handler(&event, in_isr);
+}
+
 #ifdef __cplusplus
 }
 #endif
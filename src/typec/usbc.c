@@ -52,10 +52,23 @@ static bool _usbc_inited = false;
 static bool _port_inited[TUP_TYPEC_RHPORTS_NUM];
 
 // Max possible PD size is 262 bytes
-static uint8_t _rx_buf[64] TU_ATTR_ALIGNED(4);
-static uint8_t _tx_buf[64] TU_ATTR_ALIGNED(4);
-
-bool usbc_msg_send(uint8_t rhport, pd_header_t const* header, void const* data);
+#define USBC_MSG_BUFSIZE  64
+
+// Received messages ring: ISR completes slot (wr % CFG_TUC_RX_SLOTS) and re-arms the next one if free,
+// task processes slot (rd % CFG_TUC_RX_SLOTS) in order. wr/rd are free-running counters
+typedef struct {
+  uint8_t buf[CFG_TUC_RX_SLOTS][USBC_MSG_BUFSIZE] TU_ATTR_ALIGNED(4);
+  volatile uint8_t wr;
+  volatile uint8_t rd;
+  volatile bool armed;
+  uint8_t last_msg_id; // MessageID of last accepted message, 0xff if none
+  uint8_t tx_msg_id;   // MessageID of next transmitted message
+} usbc_rx_ring_t;
+
+static usbc_rx_ring_t _rx_ring[TUP_TYPEC_RHPORTS_NUM];
+static uint8_t _tx_buf[USBC_MSG_BUFSIZE] TU_ATTR_ALIGNED(4);
+
+static void rx_arm(uint8_t rhport);
 bool parse_msg_data(uint8_t rhport, pd_header_t const* header, uint8_t const* dobj, uint8_t const* p_end);
 bool parse_msg_control(uint8_t rhport, pd_header_t const* header);
 
@@ -85,6 +98,13 @@ bool tuc_init(uint8_t rhport, uint32_t port_type) {
   TU_LOG_USBC("USBC init on port %u\r\n", rhport);
   TU_LOG_INT(USBC_DEBUG, sizeof(tcd_event_t));
 
+  tu_memclr(&_rx_ring[rhport], sizeof(usbc_rx_ring_t));
+  _rx_ring[rhport].last_msg_id = 0xff;
+
+#if CFG_TUC_PD_POLICY
+  usbc_pe_init(rhport);
+#endif
+
   TU_ASSERT(tcd_init(rhport, port_type));
   tcd_int_enable(rhport);
 
@@ -101,31 +121,58 @@ void tuc_task_ext(uint32_t timeout_ms, bool in_isr) {
   // Loop until there is no more events in the queue
   while (1) {
     tcd_event_t event;
+#if CFG_TUC_PD_POLICY
+    // wait no longer than the next policy engine timer
+    if (!osal_queue_receive(_usbc_q, &event, usbc_pe_task(timeout_ms))) {
+      (void) usbc_pe_task(0);
+      return;
+    }
+#else
     if (!osal_queue_receive(_usbc_q, &event, timeout_ms)) return;
+#endif
 
     switch (event.event_id) {
       case TCD_EVENT_CC_CHANGED:
+#if CFG_TUC_PD_POLICY
+        usbc_pe_cc_changed(event.rhport, event.cc_changed.cc_state[0] || event.cc_changed.cc_state[1]);
+#endif
         break;
 
-      case TCD_EVENT_RX_COMPLETE:
-        // TODO process message here in ISR, move to thread later
-        if (event.xfer_complete.result == XFER_RESULT_SUCCESS) {
-          pd_header_t const* header = (pd_header_t const*) _rx_buf;
+      case TCD_EVENT_HARD_RESET:
+#if CFG_TUC_PD_POLICY
+        usbc_pe_hard_reset_received(event.rhport);
+#endif
+        break;
 
-          if (header->n_data_obj == 0) {
-            parse_msg_control(event.rhport, header);
+      case TCD_EVENT_RX_COMPLETE: {
+        // only successful messages that need policy processing are queued by ISR, in order of the ring
+        usbc_rx_ring_t* ring = &_rx_ring[event.rhport];
+        uint8_t const* rx_buf = ring->buf[ring->rd % CFG_TUC_RX_SLOTS];
+        pd_header_t const* header = (pd_header_t const*) rx_buf;
 
-          }else {
-            uint8_t const* p_end = _rx_buf + event.xfer_complete.xferred_bytes;
-            uint8_t const * dobj = _rx_buf + sizeof(pd_header_t);
+#if CFG_TUC_PD_POLICY
+        usbc_pe_msg_received(event.rhport, header, rx_buf + sizeof(pd_header_t),
+                             rx_buf + event.xfer_complete.xferred_bytes);
+#endif
 
-            parse_msg_data(event.rhport, header, dobj, p_end);
-          }
+        if (header->n_data_obj == 0) {
+          parse_msg_control(event.rhport, header);
+        } else {
+          uint8_t const* p_end = rx_buf + event.xfer_complete.xferred_bytes;
+          uint8_t const* dobj = rx_buf + sizeof(pd_header_t);
+
+          parse_msg_data(event.rhport, header, dobj, p_end);
         }
 
-        // prepare for next message
-        tcd_msg_receive(event.rhport, _rx_buf, sizeof(_rx_buf));
+        // release slot, re-arm if ISR ran out of free slot
+        usbc_int_set(false);
+        ring->rd++;
+        if (!ring->armed) {
+          rx_arm(event.rhport);
+        }
+        usbc_int_set(true);
         break;
+      }
 
       case TCD_EVENT_TX_COMPLETE:
         break;
@@ -156,8 +203,9 @@ bool parse_msg_control(uint8_t rhport, pd_header_t const* header) {
 //--------------------------------------------------------------------+
 
 bool usbc_msg_send(uint8_t rhport, pd_header_t const* header, void const* data) {
-  // copy header
+  // copy header, MessageID is managed by stack
   memcpy(_tx_buf, header, sizeof(pd_header_t));
+  ((pd_header_t*) _tx_buf)->msg_id = _rx_ring[rhport].tx_msg_id;
 
   // copy data objcet if available
   uint16_t const n_data_obj = header->n_data_obj;
@@ -168,6 +216,13 @@ bool usbc_msg_send(uint8_t rhport, pd_header_t const* header, void const* data)
   return tcd_msg_send(rhport, _tx_buf, sizeof(pd_header_t) + n_data_obj * 4);
 }
 
+void usbc_msg_id_reset(uint8_t rhport) {
+  usbc_int_set(false);
+  _rx_ring[rhport].last_msg_id = 0xff;
+  _rx_ring[rhport].tx_msg_id = 0;
+  usbc_int_set(true);
+}
+
 bool tuc_msg_request(uint8_t rhport, void const* rdo) {
   pd_header_t const header = {
       .msg_type = PD_DATA_REQUEST,
@@ -182,18 +237,91 @@ bool tuc_msg_request(uint8_t rhport, void const* rdo) {
   return usbc_msg_send(rhport, &header, rdo);
 }
 
+// Arm receiving on next free slot, must be called with interrupt disabled or in ISR
+static void rx_arm(uint8_t rhport) {
+  usbc_rx_ring_t* ring = &_rx_ring[rhport];
+  if ((uint8_t) (ring->wr - ring->rd) < CFG_TUC_RX_SLOTS) {
+    ring->armed = tcd_msg_receive(rhport, ring->buf[ring->wr % CFG_TUC_RX_SLOTS], USBC_MSG_BUFSIZE);
+  } else {
+    ring->armed = false;
+  }
+}
+
+// Time-critical part of received message handling in ISR. Return true if message should be deferred to task
+static bool rx_complete_isr(uint8_t rhport, tcd_event_t const* event) {
+  usbc_rx_ring_t* ring = &_rx_ring[rhport];
+  pd_header_t const* header = (pd_header_t const*) ring->buf[ring->wr % CFG_TUC_RX_SLOTS];
+  bool defer = false;
+
+  if (!ring->armed) {
+    // no free slot, message is not received
+    return false;
+  }
+  ring->armed = false;
+
+  if (event->xfer_complete.result != XFER_RESULT_SUCCESS) {
+    // CRC error: no GoodCRC was sent, partner will retry. Reuse the same slot
+  } else if (header->n_data_obj == 0 && header->msg_type == PD_CTRL_GOOD_CRC) {
+    // acknowledge of our transmitted message
+    if (header->msg_id == ring->tx_msg_id) {
+      ring->tx_msg_id = (ring->tx_msg_id + 1) & 0x07u;
+    }
+  } else if (header->n_data_obj == 0 && header->msg_type == PD_CTRL_SOFT_RESET) {
+    // Soft_Reset resets MessageID counters
+    ring->last_msg_id = header->msg_id;
+    ring->tx_msg_id = 0;
+    defer = true;
+  } else if (header->msg_id == ring->last_msg_id) {
+    // retransmission of a message we already accepted (our GoodCRC was lost): drop
+  } else {
+    ring->last_msg_id = header->msg_id;
+    defer = true;
+  }
+
+  if (defer && header->n_data_obj == 0 && tuc_pd_control_received_isr_cb) {
+    defer = tuc_pd_control_received_isr_cb(rhport, header);
+  }
+
+  if (defer) {
+    ring->wr++;
+  }
+
+  // re-arm as soon as possible for back-to-back message
+  rx_arm(rhport);
+
+  return defer;
+}
+
 void tcd_event_handler(tcd_event_t const * event, bool in_isr) {
-  (void) in_isr;
+  uint8_t const rhport = event->rhport;
+
   switch(event->event_id) {
     case TCD_EVENT_CC_CHANGED:
       if (event->cc_changed.cc_state[0] || event->cc_changed.cc_state[1]) {
-        // Attach, start receiving
-        tcd_msg_receive(event->rhport, _rx_buf, sizeof(_rx_buf));
+        // Attach, reset message state and start receiving
+        usbc_rx_ring_t* ring = &_rx_ring[rhport];
+        ring->last_msg_id = 0xff;
+        ring->tx_msg_id = 0;
+        if (!ring->armed) {
+          rx_arm(rhport);
+        }
       }else {
         // Detach
       }
       break;
 
+    case TCD_EVENT_RX_COMPLETE:
+      if (!rx_complete_isr(rhport, event)) {
+        return;
+      }
+      break;
+
+    case TCD_EVENT_HARD_RESET:
+      // MessageID counters are reset by Hard Reset
+      _rx_ring[rhport].last_msg_id = 0xff;
+      _rx_ring[rhport].tx_msg_id = 0;
+      break;
+
     default: break;
   }
 
@@ -29,6 +29,7 @@
 
 #include "common/tusb_common.h"
 #include "pd_types.h"
+#include "pd_policy.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -42,6 +43,14 @@ extern "C" {
 #define CFG_TUC_TASK_QUEUE_SZ   8
 #endif
 
+// Number of received message buffers per port. Receiving is re-armed in ISR as long as a buffer is free, so that
+// back-to-back messages are not lost while tuc_task() is busy
+#ifndef CFG_TUC_RX_SLOTS
+#define CFG_TUC_RX_SLOTS        4
+#endif
+
+TU_VERIFY_STATIC(CFG_TUC_RX_SLOTS >= 2 && CFG_TUC_RX_SLOTS <= CFG_TUC_TASK_QUEUE_SZ, "RX slots is not correct");
+
 //--------------------------------------------------------------------+
 // Application API
 //--------------------------------------------------------------------+
@@ -77,12 +86,26 @@ extern void tcd_int_handler(uint8_t rhport);
 TU_ATTR_WEAK bool tuc_pd_data_received_cb(uint8_t rhport, pd_header_t const* header, uint8_t const* dobj, uint8_t const* p_end);
 TU_ATTR_WEAK bool tuc_pd_control_received_cb(uint8_t rhport, pd_header_t const* header);
 
+// Invoked in ISR when a control message (except GoodCRC) is received, for time-critical response e.g to
+// PS_RDY or Soft_Reset. Return true to also defer to tuc_pd_control_received_cb()
+TU_ATTR_WEAK bool tuc_pd_control_received_isr_cb(uint8_t rhport, pd_header_t const* header);
+
 //--------------------------------------------------------------------+
 //
 //--------------------------------------------------------------------+
 
 bool tuc_msg_request(uint8_t rhport, void const* rdo);
 
+//--------------------------------------------------------------------+
+// Internal API
+//--------------------------------------------------------------------+
+
+// Send message, MessageID of header is filled by stack
+bool usbc_msg_send(uint8_t rhport, pd_header_t const* header, void const* data);
+
+// Reset MessageID counters e.g when sending Hard Reset
+void usbc_msg_id_reset(uint8_t rhport);
+
 
 #ifdef __cplusplus
 }
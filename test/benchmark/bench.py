@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+TOTALS = re.compile(r'^(?:totals|summary):\s+(\d+)', re.MULTILINE)
+WALLTIME = re.compile(r'^(\S+)\s+\d+ bytes\s+(\d+) ns', re.MULTILINE)
+
+
+def list_benchmarks(binary):
+    out = subprocess.run([binary, '-l'], check=True, capture_output=True, text=True).stdout
+    return out.split()
+
+
+def run_callgrind(binary, name):
+    """Return number of instructions executed by the measured region of a benchmark"""
+    with tempfile.TemporaryDirectory() as tmp:
+        out_file = os.path.join(tmp, 'callgrind.out')
+        subprocess.run(['valgrind', '--tool=callgrind', '--toggle-collect=bench_measure',
+                        '--callgrind-out-file={}'.format(out_file), binary, name],
+                       check=True, capture_output=True, text=True)
+        with open(out_file) as fp:
+            m = TOTALS.search(fp.read())
+    if not m:
+        sys.exit('No instruction count found for {}'.format(name))
+    return int(m.group(1))
+
+
+def run_walltime(binary, name, repeat):
+    """Return fastest run time in ns, only meaningful on a quiet machine"""
+    out = subprocess.run([binary, '-n', str(repeat), name], check=True, capture_output=True, text=True).stdout
+    m = WALLTIME.search(out)
+    if not m:
+        sys.exit('No run time found for {}'.format(name))
+    return int(m.group(2))
+
+
+def cmd_run(args):
+    names = args.benchmark or list_benchmarks(args.binary)
+    results = {}
+    for name in names:
+        if args.tool == 'callgrind':
+            results[name] = run_callgrind(args.binary, name)
+        else:
+            results[name] = run_walltime(args.binary, name, args.repeat)
+        print('{:<20} {:>14}'.format(name, results[name]))
+
+    if args.output:
+        with open(args.output, 'w') as fp:
+            json.dump({'tool': args.tool, 'results': results}, fp, indent=2)
+
+
+def cmd_compare(args):
+    with open(args.base) as fp:
+        base = json.load(fp)
+    with open(args.head) as fp:
+        head = json.load(fp)
+    if base['tool'] != head['tool']:
+        sys.exit('Cannot compare {} with {} results'.format(base['tool'], head['tool']))
+
+    regressions = []
+    print('{:<20} {:>14} {:>14} {:>8}'.format('benchmark', 'base', 'head', 'change'))
+    for name, value in head['results'].items():
+        ref = base['results'].get(name)
+        if not ref:
+            print('{:<20} {:>14} {:>14} {:>8}'.format(name, '-', value, 'new'))
+            continue
+        change = (value - ref) * 100.0 / ref
+        mark = ''
+        if change > args.threshold:
+            regressions.append(name)
+            mark = ' <-- regression'
+        print('{:<20} {:>14} {:>14} {:>+7.2f}%{}'.format(name, ref, value, change, mark))
+
+    if regressions:
+        print('\n{} benchmark(s) regressed by more than {}%: {}'.format(len(regressions), args.threshold,
+                                                                      ', '.join(regressions)))
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(
+        prog='bench.py',
+        description='''Runs TinyUSB benchmarks and compares results of two builds e.g base and head of a pull
+                    request. Instruction counts from valgrind/callgrind are deterministic and used to
+                    gate regressions, wall-clock time is available for local profiling.''')
+    sub = parser.add_subparsers(dest='command', required=True)
+
+    run_parser = sub.add_parser('run', help='Run benchmarks')
+    run_parser.add_argument('binary', help='Benchmark executable e.g _build/benchmark')
+    run_parser.add_argument('benchmark', nargs='*', help='Benchmarks to run (default all)')
+    run_parser.add_argument('-o', '--output', help='Save results to json file')
+    run_parser.add_argument('-t', '--tool', choices=['callgrind', 'time'], default='callgrind',
+                            help='Measurement: instruction count (default) or wall-clock time')
+    run_parser.add_argument('-n', '--repeat', type=int, default=10, help='Repeat count for time tool (default 10)')
+    run_parser.set_defaults(func=cmd_run)
+
+    compare_parser = sub.add_parser('compare', help='Compare results, fail on regression')
+    compare_parser.add_argument('base', help='Reference results json')
+    compare_parser.add_argument('head', help='New results json')
+    compare_parser.add_argument('--threshold', type=float, default=2.0,
+                                help='Allowed increase in percent (default 2)')
+    compare_parser.set_defaults(func=cmd_compare)
+
+    args = parser.parse_args()
+    args.func(args)
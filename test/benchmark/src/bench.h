@@ -0,0 +1,81 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#ifndef BENCH_H_
+#define BENCH_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tusb.h"
+#include "portable/sim/dcd_sim.h"
+
+// A benchmark moves a fixed, deterministic workload through the stack. Only run() is measured, setup() and
+// teardown() bring the device in and out of the required state. Workload must not depend on wall-clock time so
+// that instruction counts are reproducible between runs.
+typedef struct {
+  char const* name;
+  void (*setup)(void);
+  void (*run)(void);
+  void (*teardown)(void);
+  uint32_t bytes; // payload moved by run(), used to report throughput
+} bench_t;
+
+// Abort the benchmark: a broken workload must not be mistaken for a fast one
+#define BENCH_ASSERT(_cond) \
+  do { \
+    if (!(_cond)) { \
+      fprintf(stderr, "%s:%d: benchmark assertion failed: %s\n", __FILE__, __LINE__, #_cond); \
+      exit(1); \
+    } \
+  } while (0)
+
+//--------------------------------------------------------------------+
+// Host side helpers
+//--------------------------------------------------------------------+
+
+// Run a control transfer to completion, return false if it is stalled
+bool bench_control(uint8_t bmRequestType, uint8_t bRequest, uint16_t wValue, uint16_t wIndex, uint16_t wLength,
+                   void* buffer);
+
+// SET_INTERFACE
+void bench_set_interface(uint8_t itf, uint8_t alt);
+
+// Run bus until condition is true, fail if it takes more than max_frames
+#define BENCH_RUN_UNTIL(_cond, _max_frames) \
+  do { \
+    uint32_t _frames = 0; \
+    while (!(_cond)) { \
+      BENCH_ASSERT(_frames++ < (_max_frames)); \
+      dcd_sim_run_frames(1); \
+    } \
+  } while (0)
+
+// Fill buffer with a pattern derived from seed
+void bench_fill(void* buffer, uint32_t len, uint32_t seed);
+
+#endif
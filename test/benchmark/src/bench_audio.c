@@ -0,0 +1,141 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#include "bench.h"
+
+// Type I PCM encoding (microphone, support FIFOs interleaved into IN packets) and decoding (speaker, OUT packets
+// de-interleaved into support FIFOs) of a 4-channel 16-bit stream. Application services the FIFOs every microframe.
+
+#define AUDIO_MS              1000
+#define AUDIO_FF_FRAME_BYTES  (BENCH_AUDIO_CHANNEL_PER_FIFO * BENCH_AUDIO_N_BYTES_PER_SAMPLE)
+#define AUDIO_FF_UFRAME_BYTES (BENCH_AUDIO_SAMPLE_RATE / 8000 * AUDIO_FF_FRAME_BYTES)
+#define AUDIO_UFRAMES         (AUDIO_MS * 8)
+#define AUDIO_FF_BYTES        (AUDIO_UFRAMES * AUDIO_FF_UFRAME_BYTES)
+#define AUDIO_TOTAL           (AUDIO_FF_BYTES * BENCH_AUDIO_N_FIFO)
+
+static uint8_t _ff_data[BENCH_AUDIO_N_FIFO][AUDIO_FF_BYTES];
+static uint8_t _stream[AUDIO_TOTAL];
+static uint8_t _buf[AUDIO_TOTAL];
+
+// build content of each support FIFO and the interleaved stream as seen on the bus
+static void audio_setup(void) {
+  for (uint8_t ff = 0; ff < BENCH_AUDIO_N_FIFO; ff++) {
+    bench_fill(_ff_data[ff], AUDIO_FF_BYTES, (uint32_t) (ff * 101u));
+  }
+  for (uint32_t i = 0; i < AUDIO_FF_BYTES / AUDIO_FF_FRAME_BYTES; i++) {
+    for (uint8_t ff = 0; ff < BENCH_AUDIO_N_FIFO; ff++) {
+      memcpy(&_stream[(i * BENCH_AUDIO_N_FIFO + ff) * AUDIO_FF_FRAME_BYTES], &_ff_data[ff][i * AUDIO_FF_FRAME_BYTES],
+             AUDIO_FF_FRAME_BYTES);
+    }
+  }
+  memset(_buf, 0, sizeof(_buf));
+}
+
+//------------- encode -------------//
+static void audio_encode_setup(void) {
+  audio_setup();
+  bench_set_interface(ITF_NUM_AUDIO_STREAMING_MIC, 1);
+}
+
+static void audio_encode_teardown(void) {
+  bench_set_interface(ITF_NUM_AUDIO_STREAMING_MIC, 0);
+  dcd_sim_host_read(EPNUM_AUDIO_IN, _buf, sizeof(_buf)); // flush remaining packets
+}
+
+static void audio_encode_run(void) {
+  uint32_t written = 0;
+  uint32_t received = 0;
+  uint32_t frames = 0;
+
+  while (received < AUDIO_TOTAL) {
+    BENCH_ASSERT(frames++ < 2 * AUDIO_UFRAMES);
+
+    // device application
+    if (written < AUDIO_FF_BYTES) {
+      for (uint8_t ff = 0; ff < BENCH_AUDIO_N_FIFO; ff++) {
+        BENCH_ASSERT(tud_audio_write_support_ff(ff, &_ff_data[ff][written], AUDIO_FF_UFRAME_BYTES) ==
+                     AUDIO_FF_UFRAME_BYTES);
+      }
+      written += AUDIO_FF_UFRAME_BYTES;
+    }
+
+    dcd_sim_run_frames(1);
+    received += dcd_sim_host_read(EPNUM_AUDIO_IN, _buf + received, AUDIO_TOTAL - received);
+  }
+
+  BENCH_ASSERT(0 == memcmp(_buf, _stream, AUDIO_TOTAL));
+}
+
+bench_t const bench_audio_encode = {
+  .name = "audio_encode",
+  .setup = audio_encode_setup,
+  .run = audio_encode_run,
+  .teardown = audio_encode_teardown,
+  .bytes = AUDIO_TOTAL
+};
+
+//------------- decode -------------//
+static void audio_decode_setup(void) {
+  audio_setup();
+  bench_set_interface(ITF_NUM_AUDIO_STREAMING_SPK, 1);
+}
+
+static void audio_decode_teardown(void) {
+  bench_set_interface(ITF_NUM_AUDIO_STREAMING_SPK, 0);
+}
+
+static void audio_decode_run(void) {
+  uint32_t sent = 0;
+  uint32_t received[BENCH_AUDIO_N_FIFO] = { 0 };
+  uint32_t frames = 0;
+
+  while (received[BENCH_AUDIO_N_FIFO - 1] < AUDIO_FF_BYTES) {
+    BENCH_ASSERT(frames++ < 2 * AUDIO_UFRAMES);
+
+    if (sent < AUDIO_TOTAL) {
+      sent += dcd_sim_host_write(EPNUM_AUDIO_OUT, _stream + sent, AUDIO_TOTAL - sent);
+    }
+    dcd_sim_run_frames(1);
+
+    // device application
+    for (uint8_t ff = 0; ff < BENCH_AUDIO_N_FIFO; ff++) {
+      uint8_t* dst = &_buf[ff * AUDIO_FF_BYTES + received[ff]];
+      received[ff] += tud_audio_read_support_ff(ff, dst, (uint16_t) tu_min32(AUDIO_FF_BYTES - received[ff], 0xffff));
+    }
+  }
+
+  for (uint8_t ff = 0; ff < BENCH_AUDIO_N_FIFO; ff++) {
+    BENCH_ASSERT(0 == memcmp(&_buf[ff * AUDIO_FF_BYTES], _ff_data[ff], AUDIO_FF_BYTES));
+  }
+}
+
+bench_t const bench_audio_decode = {
+  .name = "audio_decode",
+  .setup = audio_decode_setup,
+  .run = audio_decode_run,
+  .teardown = audio_decode_teardown,
+  .bytes = AUDIO_TOTAL
+};
@@ -0,0 +1,136 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#include "bench.h"
+
+// Pass data through fifo with several access patterns. Depth is not a power of 2 and chunk sizes are odd so that
+// index wrap-around is exercised on most accesses.
+
+#define FIFO_DEPTH    1000
+#define FIFO_TOTAL    (256 * 1024)
+
+static uint8_t _ff_buf[FIFO_DEPTH * 4];
+static tu_fifo_t _ff;
+
+static uint8_t _src[FIFO_TOTAL];
+static uint8_t _dst[FIFO_TOTAL];
+
+static void fifo_setup_item(uint16_t item_size) {
+  tu_fifo_config(&_ff, _ff_buf, FIFO_DEPTH, item_size, false);
+  bench_fill(_src, sizeof(_src), 0x5a);
+  memset(_dst, 0, sizeof(_dst));
+}
+
+static void fifo_setup_byte(void) {
+  fifo_setup_item(1);
+}
+
+static void fifo_setup_word(void) {
+  fifo_setup_item(4);
+}
+
+static void fifo_teardown(void) {
+  BENCH_ASSERT(tu_fifo_empty(&_ff));
+  BENCH_ASSERT(0 == memcmp(_src, _dst, sizeof(_src)));
+}
+
+//------------- single item -------------//
+static void fifo_write_read_run(void) {
+  uint32_t const count = FIFO_TOTAL / 4;
+  uint32_t const* src = (uint32_t const*) (uintptr_t) _src;
+  uint32_t* dst = (uint32_t*) (uintptr_t) _dst;
+  uint32_t wr = 0, rd = 0;
+
+  // producer runs ahead by up to 7 items, then consumer catches up
+  while (rd < count) {
+    for (uint32_t i = 0; i < 7 && wr < count; i++) {
+      BENCH_ASSERT(tu_fifo_write(&_ff, &src[wr++]));
+    }
+    while (rd < wr) {
+      BENCH_ASSERT(tu_fifo_read(&_ff, &dst[rd++]));
+    }
+  }
+}
+
+bench_t const bench_fifo_write_read = {
+  .name = "fifo_write_read",
+  .setup = fifo_setup_word,
+  .run = fifo_write_read_run,
+  .teardown = fifo_teardown,
+  .bytes = FIFO_TOTAL
+};
+
+//------------- n items -------------//
+static void fifo_write_read_n_run(void) {
+  static uint16_t const chunk[] = { 1, 63, 64, 65, 511, 512, 777 };
+  uint32_t wr = 0, rd = 0;
+  uint32_t i = 0;
+
+  while (rd < FIFO_TOTAL) {
+    uint32_t n = tu_min32(chunk[i++ % TU_ARRAY_SIZE(chunk)], FIFO_TOTAL - wr);
+    n = tu_min32(n, tu_fifo_remaining(&_ff));
+    wr += tu_fifo_write_n(&_ff, _src + wr, (tu_fifo_size_t) n);
+
+    n = tu_min32(chunk[i % TU_ARRAY_SIZE(chunk)], tu_fifo_count(&_ff));
+    rd += tu_fifo_read_n(&_ff, _dst + rd, (tu_fifo_size_t) n);
+  }
+}
+
+bench_t const bench_fifo_write_read_n = {
+  .name = "fifo_write_read_n",
+  .setup = fifo_setup_byte,
+  .run = fifo_write_read_n_run,
+  .teardown = fifo_teardown,
+  .bytes = FIFO_TOTAL
+};
+
+//------------- zero-copy -------------//
+static void fifo_linear_run(void) {
+  uint32_t wr = 0, rd = 0;
+
+  while (rd < FIFO_TOTAL) {
+    void* wbuf;
+    tu_fifo_size_t n = tu_fifo_reserve(&_ff, &wbuf, (tu_fifo_size_t) tu_min32(700, FIFO_TOTAL - wr));
+    memcpy(wbuf, _src + wr, n);
+    tu_fifo_commit(&_ff, n);
+    wr += n;
+
+    void const* rbuf;
+    n = tu_fifo_peek_span(&_ff, &rbuf);
+    n = (tu_fifo_size_t) tu_min32(n, 600);
+    memcpy(_dst + rd, rbuf, n);
+    tu_fifo_release(&_ff, n);
+    rd += n;
+  }
+}
+
+bench_t const bench_fifo_linear = {
+  .name = "fifo_linear",
+  .setup = fifo_setup_byte,
+  .run = fifo_linear_run,
+  .teardown = fifo_teardown,
+  .bytes = FIFO_TOTAL
+};
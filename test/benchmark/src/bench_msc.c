@@ -0,0 +1,179 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#include "bench.h"
+
+// Bulk-Only Transport READ10/WRITE10 of a RAM disk: CBW, data and CSW stages through the MSC state machine
+
+#define DISK_BLOCK_SIZE   512
+#define DISK_BLOCK_NUM    128
+#define XFER_BLOCKS       32
+#define XFER_COUNT        32
+#define XFER_TOTAL        (XFER_COUNT * XFER_BLOCKS * DISK_BLOCK_SIZE)
+#define XFER_MAX_FRAME    2000
+
+static uint8_t _disk[DISK_BLOCK_NUM * DISK_BLOCK_SIZE];
+static uint8_t _buf[XFER_BLOCKS * DISK_BLOCK_SIZE + sizeof(msc_csw_t)];
+static uint32_t _tag;
+
+//--------------------------------------------------------------------+
+// Device application: RAM disk
+//--------------------------------------------------------------------+
+
+void tud_msc_inquiry_cb(uint8_t lun, uint8_t vendor_id[8], uint8_t product_id[16], uint8_t product_rev[4]) {
+  (void) lun;
+  memcpy(vendor_id, "TinyUSB ", 8);
+  memcpy(product_id, "Benchmark       ", 16);
+  memcpy(product_rev, "1.0 ", 4);
+}
+
+bool tud_msc_test_unit_ready_cb(uint8_t lun) {
+  (void) lun;
+  return true;
+}
+
+void tud_msc_capacity_cb(uint8_t lun, uint32_t* block_count, uint16_t* block_size) {
+  (void) lun;
+  *block_count = DISK_BLOCK_NUM;
+  *block_size = DISK_BLOCK_SIZE;
+}
+
+int32_t tud_msc_read10_cb(uint8_t lun, uint32_t lba, uint32_t offset, void* buffer, uint32_t bufsize) {
+  (void) lun;
+  uint32_t const addr = lba * DISK_BLOCK_SIZE + offset;
+  TU_VERIFY(addr + bufsize <= sizeof(_disk), -1);
+  memcpy(buffer, _disk + addr, bufsize);
+  return (int32_t) bufsize;
+}
+
+int32_t tud_msc_write10_cb(uint8_t lun, uint32_t lba, uint32_t offset, uint8_t* buffer, uint32_t bufsize) {
+  (void) lun;
+  uint32_t const addr = lba * DISK_BLOCK_SIZE + offset;
+  TU_VERIFY(addr + bufsize <= sizeof(_disk), -1);
+  memcpy(_disk + addr, buffer, bufsize);
+  return (int32_t) bufsize;
+}
+
+int32_t tud_msc_scsi_cb(uint8_t lun, uint8_t const scsi_cmd[16], void* buffer, uint16_t bufsize) {
+  (void) scsi_cmd;
+  (void) buffer;
+  (void) bufsize;
+  tud_msc_set_sense(lun, SCSI_SENSE_ILLEGAL_REQUEST, 0x20, 0x00);
+  return -1;
+}
+
+//--------------------------------------------------------------------+
+// Host side
+//--------------------------------------------------------------------+
+
+static void send_cbw(uint8_t cmd_code, uint8_t dir, uint32_t lba, uint16_t block_count) {
+  msc_cbw_t cbw = {
+    .signature = MSC_CBW_SIGNATURE,
+    .tag = ++_tag,
+    .total_bytes = (uint32_t) block_count * DISK_BLOCK_SIZE,
+    .dir = dir,
+    .lun = 0,
+    .cmd_len = sizeof(scsi_read10_t)
+  };
+  scsi_read10_t const cmd = {
+    .cmd_code = cmd_code,
+    .lba = tu_htonl(lba),
+    .block_count = tu_htons(block_count)
+  };
+  memcpy(cbw.command, &cmd, sizeof(cmd));
+  BENCH_ASSERT(dcd_sim_host_write(EPNUM_MSC_OUT, &cbw, sizeof(cbw)) == sizeof(cbw));
+}
+
+static void check_csw(msc_csw_t const* csw) {
+  BENCH_ASSERT(csw->signature == MSC_CSW_SIGNATURE);
+  BENCH_ASSERT(csw->tag == _tag);
+  BENCH_ASSERT(csw->status == MSC_CSW_STATUS_PASSED && csw->data_residue == 0);
+}
+
+static void msc_setup(void) {
+  bench_fill(_disk, sizeof(_disk), 0x77);
+}
+
+static void msc_read10_run(void) {
+  uint32_t const len = XFER_BLOCKS * DISK_BLOCK_SIZE;
+
+  for (uint32_t i = 0; i < XFER_COUNT; i++) {
+    uint32_t const lba = (i * XFER_BLOCKS) % DISK_BLOCK_NUM;
+    send_cbw(SCSI_CMD_READ_10, TUSB_DIR_IN_MASK, lba, XFER_BLOCKS);
+
+    // data and CSW
+    uint32_t received = 0;
+    uint32_t frames = 0;
+    while (received < len + sizeof(msc_csw_t)) {
+      BENCH_ASSERT(frames++ < XFER_MAX_FRAME);
+      dcd_sim_run_frames(1);
+      received += dcd_sim_host_read(EPNUM_MSC_IN, _buf + received, sizeof(_buf) - received);
+    }
+
+    BENCH_ASSERT(0 == memcmp(_buf, _disk + lba * DISK_BLOCK_SIZE, len));
+    msc_csw_t csw;
+    memcpy(&csw, _buf + len, sizeof(csw));
+    check_csw(&csw);
+  }
+}
+
+bench_t const bench_msc_read10 = {
+  .name = "msc_read10",
+  .setup = msc_setup,
+  .run = msc_read10_run,
+  .bytes = XFER_TOTAL
+};
+
+static void msc_write10_run(void) {
+  uint32_t const len = XFER_BLOCKS * DISK_BLOCK_SIZE;
+
+  for (uint32_t i = 0; i < XFER_COUNT; i++) {
+    uint32_t const lba = (i * XFER_BLOCKS) % DISK_BLOCK_NUM;
+    bench_fill(_buf, len, i);
+    send_cbw(SCSI_CMD_WRITE_10, 0, lba, XFER_BLOCKS);
+
+    uint32_t sent = 0;
+    uint32_t received = 0;
+    uint32_t frames = 0;
+    msc_csw_t csw;
+    while (received < sizeof(csw)) {
+      BENCH_ASSERT(frames++ < XFER_MAX_FRAME);
+      sent += dcd_sim_host_write(EPNUM_MSC_OUT, _buf + sent, len - sent);
+      dcd_sim_run_frames(1);
+      received += dcd_sim_host_read(EPNUM_MSC_IN, ((uint8_t*) &csw) + received, sizeof(csw) - received);
+    }
+
+    check_csw(&csw);
+    BENCH_ASSERT(0 == memcmp(_buf, _disk + lba * DISK_BLOCK_SIZE, len));
+  }
+}
+
+bench_t const bench_msc_write10 = {
+  .name = "msc_write10",
+  .setup = msc_setup,
+  .run = msc_write10_run,
+  .bytes = XFER_TOTAL
+};
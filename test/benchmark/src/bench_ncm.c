@@ -0,0 +1,214 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#include "bench.h"
+#include "class/net/ncm.h"
+
+// NCM datagram aggregation: device packs datagrams of mixed sizes into NTBs (xmit) and unpacks NTBs built by the
+// host (recv)
+
+#define NCM_ROUNDS          300
+#define NCM_ROUND_BYTES     (60 + 590 + 1514 + 128 + 1024 + 64 + 300)
+#define NCM_DATAGRAM_COUNT  (NCM_ROUNDS * TU_ARRAY_SIZE(_datagram_size))
+#define NCM_TOTAL_BYTES     (NCM_ROUNDS * NCM_ROUND_BYTES)
+#define NCM_MAX_FRAME       20000
+
+static uint16_t const _datagram_size[] = { 60, 590, 1514, 128, 1024, 64, 300 };
+
+static uint8_t _datagram[CFG_TUD_NET_MTU];
+
+static uint32_t _recv_count;
+static uint32_t _recv_bytes;
+
+static uint16_t datagram_size(uint32_t index) {
+  return _datagram_size[index % TU_ARRAY_SIZE(_datagram_size)];
+}
+
+//--------------------------------------------------------------------+
+// Device application: network glue
+//--------------------------------------------------------------------+
+uint8_t tud_network_mac_address[6] = { 0x02, 0x02, 0x11, 0x22, 0x33, 0x44 };
+
+void tud_network_init_cb(void) {
+}
+
+bool tud_network_recv_cb(uint8_t const* src, uint16_t size) {
+  BENCH_ASSERT(0 == memcmp(src, _datagram, size));
+  _recv_count++;
+  _recv_bytes += size;
+  // datagram is consumed right away, driver continues with the next one after this callback returns
+  tud_network_recv_renew();
+  return true;
+}
+
+uint16_t tud_network_xmit_cb(uint8_t* dst, void* ref, uint16_t arg) {
+  (void) ref;
+  memcpy(dst, _datagram, arg);
+  return arg;
+}
+
+static void ncm_setup(void) {
+  bench_fill(_datagram, sizeof(_datagram), 0x11);
+  _recv_count = _recv_bytes = 0;
+}
+
+//--------------------------------------------------------------------+
+// Device to host
+//--------------------------------------------------------------------+
+
+// Host side: parse NTBs received on IN endpoint, return number of bytes consumed
+static uint32_t host_parse_ntb(uint8_t const* buf, uint32_t len) {
+  nth16_t nth;
+  if (len < sizeof(nth)) {
+    return 0;
+  }
+  memcpy(&nth, buf, sizeof(nth));
+  BENCH_ASSERT(nth.dwSignature == NTH16_SIGNATURE);
+  if (len < nth.wBlockLength) {
+    return 0;
+  }
+
+  ndp16_t ndp;
+  memcpy(&ndp, buf + nth.wNdpIndex, sizeof(ndp));
+  BENCH_ASSERT(ndp.dwSignature == NDP16_SIGNATURE_NCM0);
+
+  ndp16_datagram_t const* entry = (ndp16_datagram_t const*) (uintptr_t) (buf + nth.wNdpIndex + sizeof(ndp));
+  for (; entry->wDatagramIndex && entry->wDatagramLength; entry++) {
+    BENCH_ASSERT(entry->wDatagramIndex + entry->wDatagramLength <= nth.wBlockLength);
+    BENCH_ASSERT(0 == memcmp(buf + entry->wDatagramIndex, _datagram, entry->wDatagramLength));
+    _recv_count++;
+    _recv_bytes += entry->wDatagramLength;
+  }
+
+  return nth.wBlockLength;
+}
+
+static void ncm_xmit_run(void) {
+  static uint8_t buf[2 * CFG_TUD_NCM_IN_NTB_MAX_SIZE];
+  uint32_t buflen = 0;
+  uint32_t sent = 0;
+  uint32_t frames = 0;
+
+  while (_recv_count < NCM_DATAGRAM_COUNT) {
+    BENCH_ASSERT(frames++ < NCM_MAX_FRAME);
+
+    // device application
+    while (sent < NCM_DATAGRAM_COUNT && tud_network_can_xmit(datagram_size(sent))) {
+      tud_network_xmit(NULL, datagram_size(sent));
+      sent++;
+    }
+
+    dcd_sim_run_frames(1);
+
+    buflen += dcd_sim_host_read(EPNUM_NCM_IN, buf + buflen, sizeof(buf) - buflen);
+    uint32_t consumed;
+    while ((consumed = host_parse_ntb(buf, buflen)) > 0) {
+      buflen -= consumed;
+      memmove(buf, buf + consumed, buflen);
+    }
+  }
+
+  BENCH_ASSERT(_recv_bytes == NCM_TOTAL_BYTES);
+}
+
+bench_t const bench_ncm_xmit = {
+  .name = "ncm_xmit",
+  .setup = ncm_setup,
+  .run = ncm_xmit_run,
+  .bytes = NCM_TOTAL_BYTES
+};
+
+//--------------------------------------------------------------------+
+// Host to device
+//--------------------------------------------------------------------+
+
+// Host side: build NTB with as many datagrams as fit, starting at index. Return NTB length
+static uint16_t host_build_ntb(uint8_t* ntb, uint32_t* index, uint16_t sequence) {
+  enum { MAX_DATAGRAMS = 8 };
+  uint16_t const ndp_len = (uint16_t) (sizeof(ndp16_t) + (MAX_DATAGRAMS + 1) * sizeof(ndp16_datagram_t));
+  ndp16_datagram_t entry[MAX_DATAGRAMS + 1];
+  uint16_t len = (uint16_t) (sizeof(nth16_t) + ndp_len);
+  uint8_t count = 0;
+
+  memset(entry, 0, sizeof(entry));
+  while (*index < NCM_DATAGRAM_COUNT && count < MAX_DATAGRAMS) {
+    uint16_t const size = datagram_size(*index);
+    uint16_t const offset = (uint16_t) ((len + 3u) & ~3u);
+    if (offset + size > CFG_TUD_NCM_OUT_NTB_MAX_SIZE) {
+      break;
+    }
+    memcpy(ntb + offset, _datagram, size);
+    entry[count].wDatagramIndex = offset;
+    entry[count].wDatagramLength = size;
+    count++;
+    len = (uint16_t) (offset + size);
+    (*index)++;
+  }
+
+  // transfer ends with short packet, avoid a multiple of packet size which requires a ZLP
+  if ((len % 512) == 0) {
+    ntb[len++] = 0;
+  }
+
+  nth16_t const nth = {
+    .dwSignature = NTH16_SIGNATURE,
+    .wHeaderLength = sizeof(nth16_t),
+    .wSequence = sequence,
+    .wBlockLength = len,
+    .wNdpIndex = sizeof(nth16_t)
+  };
+  ndp16_t const ndp = {
+    .dwSignature = NDP16_SIGNATURE_NCM0,
+    .wLength = ndp_len,
+    .wNextNdpIndex = 0
+  };
+  memcpy(ntb, &nth, sizeof(nth));
+  memcpy(ntb + sizeof(nth), &ndp, sizeof(ndp));
+  memcpy(ntb + sizeof(nth) + sizeof(ndp), entry, sizeof(entry));
+  return len;
+}
+
+static void ncm_recv_run(void) {
+  static uint8_t ntb[CFG_TUD_NCM_OUT_NTB_MAX_SIZE];
+  uint32_t index = 0;
+  uint16_t sequence = 0;
+
+  while (_recv_count < NCM_DATAGRAM_COUNT) {
+    // one NTB at a time: a packet must not span two NTBs
+    uint16_t const len = host_build_ntb(ntb, &index, sequence++);
+    BENCH_ASSERT(dcd_sim_host_write(EPNUM_NCM_OUT, ntb, len) == len);
+    BENCH_RUN_UNTIL(_recv_count == index, 100);
+  }
+
+  BENCH_ASSERT(_recv_bytes == NCM_TOTAL_BYTES);
+}
+
+bench_t const bench_ncm_recv = {
+  .name = "ncm_recv",
+  .setup = ncm_setup,
+  .run = ncm_recv_run,
+  .bytes = NCM_TOTAL_BYTES
+};
@@ -0,0 +1,172 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#include "bench.h"
+
+// Host sends data to bulk OUT endpoint and device application echoes it back: exercises the class rx/tx fifos
+// (CDC) and the tu_edpt_stream pipeline (vendor) end to end, including endpoint scheduling in usbd.
+
+#define ECHO_TOTAL     (256 * 1024)
+#define ECHO_MAX_FRAME 20000
+
+typedef struct {
+  uint8_t ep_out;
+  uint8_t ep_in;
+  uint32_t (*available)(void);
+  uint32_t (*read)(void* buffer, uint32_t bufsize);
+  uint32_t (*write_available)(void);
+  uint32_t (*write)(void const* buffer, uint32_t bufsize);
+  uint32_t (*write_flush)(void);
+} echo_port_t;
+
+static uint8_t _src[ECHO_TOTAL];
+static uint8_t _dst[ECHO_TOTAL];
+
+static void echo_setup(void) {
+  bench_fill(_src, sizeof(_src), 0x33);
+  memset(_dst, 0, sizeof(_dst));
+}
+
+static void echo_teardown(void) {
+  BENCH_ASSERT(0 == memcmp(_src, _dst, sizeof(_src)));
+}
+
+static void echo_run(echo_port_t const* port) {
+  uint32_t sent = 0, received = 0;
+  uint32_t frames = 0;
+
+  while (received < ECHO_TOTAL) {
+    BENCH_ASSERT(frames++ < ECHO_MAX_FRAME);
+
+    if (sent < ECHO_TOTAL) {
+      sent += dcd_sim_host_write(port->ep_out, _src + sent, ECHO_TOTAL - sent);
+    }
+    dcd_sim_run_frames(1);
+
+    // device application
+    uint8_t buf[512];
+    uint32_t count;
+    while ((count = tu_min32(tu_min32(port->available(), port->write_available()), sizeof(buf))) > 0) {
+      count = port->read(buf, count);
+      BENCH_ASSERT(port->write(buf, count) == count);
+    }
+    port->write_flush();
+
+    received += dcd_sim_host_read(port->ep_in, _dst + received, ECHO_TOTAL - received);
+  }
+}
+
+//------------- CDC -------------//
+static uint32_t cdc_available(void) {
+  return tud_cdc_available();
+}
+
+static uint32_t cdc_read(void* buffer, uint32_t bufsize) {
+  return tud_cdc_read(buffer, bufsize);
+}
+
+static uint32_t cdc_write_available(void) {
+  return tud_cdc_write_available();
+}
+
+static uint32_t cdc_write(void const* buffer, uint32_t bufsize) {
+  return tud_cdc_write(buffer, bufsize);
+}
+
+static uint32_t cdc_write_flush(void) {
+  return tud_cdc_write_flush();
+}
+
+static echo_port_t const _cdc_port = {
+  .ep_out = EPNUM_CDC_OUT,
+  .ep_in = EPNUM_CDC_IN,
+  .available = cdc_available,
+  .read = cdc_read,
+  .write_available = cdc_write_available,
+  .write = cdc_write,
+  .write_flush = cdc_write_flush
+};
+
+static void cdc_echo_setup(void) {
+  echo_setup();
+  // DTR set, data written while terminal is not connected is dropped
+  BENCH_ASSERT(bench_control(0x21, CDC_REQUEST_SET_CONTROL_LINE_STATE, 0x0003, ITF_NUM_CDC, 0, NULL));
+}
+
+static void cdc_echo_run(void) {
+  echo_run(&_cdc_port);
+}
+
+bench_t const bench_cdc_echo = {
+  .name = "cdc_echo",
+  .setup = cdc_echo_setup,
+  .run = cdc_echo_run,
+  .teardown = echo_teardown,
+  .bytes = 2 * ECHO_TOTAL
+};
+
+//------------- Vendor -------------//
+static uint32_t vendor_available(void) {
+  return tud_vendor_available();
+}
+
+static uint32_t vendor_read(void* buffer, uint32_t bufsize) {
+  return tud_vendor_read(buffer, bufsize);
+}
+
+static uint32_t vendor_write_available(void) {
+  return tud_vendor_write_available();
+}
+
+static uint32_t vendor_write(void const* buffer, uint32_t bufsize) {
+  return tud_vendor_write(buffer, bufsize);
+}
+
+static uint32_t vendor_write_flush(void) {
+  return tud_vendor_write_flush();
+}
+
+static echo_port_t const _vendor_port = {
+  .ep_out = EPNUM_VENDOR_OUT,
+  .ep_in = EPNUM_VENDOR_IN,
+  .available = vendor_available,
+  .read = vendor_read,
+  .write_available = vendor_write_available,
+  .write = vendor_write,
+  .write_flush = vendor_write_flush
+};
+
+static void vendor_echo_run(void) {
+  echo_run(&_vendor_port);
+}
+
+bench_t const bench_vendor_echo = {
+  .name = "vendor_echo",
+  .setup = echo_setup,
+  .run = vendor_echo_run,
+  .teardown = echo_teardown,
+  .bytes = 2 * ECHO_TOTAL
+};
@@ -0,0 +1,191 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#include <time.h>
+
+#include "bench.h"
+
+extern bench_t const bench_fifo_write_read;
+extern bench_t const bench_fifo_write_read_n;
+extern bench_t const bench_fifo_linear;
+extern bench_t const bench_cdc_echo;
+extern bench_t const bench_vendor_echo;
+extern bench_t const bench_msc_read10;
+extern bench_t const bench_msc_write10;
+extern bench_t const bench_ncm_xmit;
+extern bench_t const bench_ncm_recv;
+extern bench_t const bench_audio_encode;
+extern bench_t const bench_audio_decode;
+
+static bench_t const* const bench_list[] = {
+  &bench_fifo_write_read,
+  &bench_fifo_write_read_n,
+  &bench_fifo_linear,
+  &bench_cdc_echo,
+  &bench_vendor_echo,
+  &bench_msc_read10,
+  &bench_msc_write10,
+  &bench_ncm_xmit,
+  &bench_ncm_recv,
+  &bench_audio_encode,
+  &bench_audio_decode,
+};
+
+//--------------------------------------------------------------------+
+// Host side helpers
+//--------------------------------------------------------------------+
+
+uint32_t tusb_time_millis_api(void) {
+  dcd_sim_stats_t stats;
+  dcd_sim_get_stats(&stats);
+  return (uint32_t) (stats.time_ns / 1000000u);
+}
+
+bool bench_control(uint8_t bmRequestType, uint8_t bRequest, uint16_t wValue, uint16_t wIndex, uint16_t wLength,
+                   void* buffer) {
+  tusb_control_request_t const request = {
+    .bmRequestType = bmRequestType,
+    .bRequest = bRequest,
+    .wValue = wValue,
+    .wIndex = wIndex,
+    .wLength = wLength
+  };
+  BENCH_ASSERT(dcd_sim_host_control(&request, buffer));
+  BENCH_RUN_UNTIL(dcd_sim_host_control_status(NULL) != DCD_SIM_CONTROL_BUSY, 1000);
+  return dcd_sim_host_control_status(NULL) == DCD_SIM_CONTROL_DONE;
+}
+
+void bench_set_interface(uint8_t itf, uint8_t alt) {
+  BENCH_ASSERT(bench_control(0x01, TUSB_REQ_SET_INTERFACE, alt, itf, 0, NULL));
+}
+
+void bench_fill(void* buffer, uint32_t len, uint32_t seed) {
+  uint8_t* p = (uint8_t*) buffer;
+  for (uint32_t i = 0; i < len; i++) {
+    p[i] = (uint8_t) (seed + i * 7u + (i >> 8));
+  }
+}
+
+static void enumerate(void) {
+  dcd_sim_set_task_hook(tud_task);
+  tusb_rhport_init_t const dev_init = {
+    .role = TUSB_ROLE_DEVICE,
+    .speed = TUSB_SPEED_HIGH
+  };
+  BENCH_ASSERT(tusb_init(0, &dev_init));
+  BENCH_ASSERT(dcd_sim_host_bus_reset());
+  dcd_sim_run_frames(8);
+
+  BENCH_ASSERT(bench_control(0x00, TUSB_REQ_SET_ADDRESS, 1, 0, 0, NULL));
+  BENCH_ASSERT(bench_control(0x00, TUSB_REQ_SET_CONFIGURATION, 1, 0, 0, NULL));
+  BENCH_ASSERT(tud_mounted());
+
+  // NCM data interface is only active with alternate 1
+  bench_set_interface(ITF_NUM_NCM_DATA, 1);
+}
+
+// Measured region, also used as toggle point for callgrind: valgrind --tool=callgrind --toggle-collect=bench_measure
+__attribute__((noinline)) void bench_measure(bench_t const* bench);
+__attribute__((noinline)) void bench_measure(bench_t const* bench) {
+  bench->run();
+}
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+static void run_bench(bench_t const* bench, uint32_t repeat) {
+  uint64_t best = UINT64_MAX;
+  for (uint32_t i = 0; i < repeat; i++) {
+    if (bench->setup) {
+      bench->setup();
+    }
+    uint64_t const start = now_ns();
+    bench_measure(bench);
+    uint64_t const elapsed = now_ns() - start;
+    if (bench->teardown) {
+      bench->teardown();
+    }
+    best = TU_MIN(best, elapsed);
+  }
+
+  double const mbps = best ? (double) bench->bytes * 1000.0 / (double) best : 0.0;
+  printf("%-20s %10lu bytes %12llu ns %10.1f MB/s\n", bench->name, (unsigned long) bench->bytes,
+         (unsigned long long) best, mbps);
+}
+
+static void usage(char const* prog) {
+  printf("Usage: %s [-l] [-n repeat] [benchmark ...]\n"
+         "  -l         list benchmarks\n"
+         "  -n repeat  run each benchmark repeat times and report the fastest (default 1)\n"
+         "Run all benchmarks if none is specified\n", prog);
+}
+
+int main(int argc, char* argv[]) {
+  uint32_t repeat = 1;
+  int argi = 1;
+
+  for (; argi < argc && argv[argi][0] == '-'; argi++) {
+    if (0 == strcmp(argv[argi], "-l")) {
+      for (size_t i = 0; i < TU_ARRAY_SIZE(bench_list); i++) {
+        printf("%s\n", bench_list[i]->name);
+      }
+      return 0;
+    } else if (0 == strcmp(argv[argi], "-n") && argi + 1 < argc) {
+      repeat = (uint32_t) strtoul(argv[++argi], NULL, 0);
+    } else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  enumerate();
+
+  if (argi == argc) {
+    for (size_t i = 0; i < TU_ARRAY_SIZE(bench_list); i++) {
+      run_bench(bench_list[i], repeat);
+    }
+    return 0;
+  }
+
+  for (; argi < argc; argi++) {
+    bench_t const* bench = NULL;
+    for (size_t i = 0; i < TU_ARRAY_SIZE(bench_list); i++) {
+      if (0 == strcmp(argv[argi], bench_list[i]->name)) {
+        bench = bench_list[i];
+      }
+    }
+    if (!bench) {
+      fprintf(stderr, "Unknown benchmark %s\n", argv[argi]);
+      return 1;
+    }
+    run_bench(bench, repeat);
+  }
+
+  return 0;
+}
@@ -0,0 +1,119 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#ifndef _TUSB_CONFIG_H_
+#define _TUSB_CONFIG_H_
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+#include "usb_descriptors.h"
+
+//--------------------------------------------------------------------
+// Common Configuration
+//--------------------------------------------------------------------
+
+// Benchmarks run the device stack on the simulated controller (portable/sim)
+#define CFG_TUSB_MCU          OPT_MCU_SIM
+#define CFG_TUSB_OS           OPT_OS_NONE
+
+#ifndef CFG_TUSB_DEBUG
+#define CFG_TUSB_DEBUG        0
+#endif
+
+#define CFG_TUD_ENABLED       1
+#define CFG_TUD_MAX_SPEED     OPT_MODE_HIGH_SPEED
+
+#define CFG_TUSB_MEM_SECTION
+#define CFG_TUSB_MEM_ALIGN    __attribute__ ((aligned(4)))
+
+//--------------------------------------------------------------------
+// DEVICE CONFIGURATION
+//--------------------------------------------------------------------
+
+#define CFG_TUD_ENDPOINT0_SIZE    64
+
+//------------- CLASS -------------//
+#define CFG_TUD_CDC              1
+#define CFG_TUD_MSC              1
+#define CFG_TUD_NCM              1
+#define CFG_TUD_VENDOR           1
+#define CFG_TUD_AUDIO            1
+
+// CDC FIFO size of TX and RX
+#define CFG_TUD_CDC_RX_BUFSIZE   2048
+#define CFG_TUD_CDC_TX_BUFSIZE   2048
+#define CFG_TUD_CDC_EP_BUFSIZE   512
+
+// Vendor uses tu_edpt_stream
+#define CFG_TUD_VENDOR_RX_BUFSIZE 2048
+#define CFG_TUD_VENDOR_TX_BUFSIZE 2048
+#define CFG_TUD_VENDOR_EPSIZE     512
+
+// MSC Buffer size of Device Mass storage
+#define CFG_TUD_MSC_EP_BUFSIZE   4096
+
+// NCM
+#define CFG_TUD_NCM_IN_NTB_MAX_SIZE   3200
+#define CFG_TUD_NCM_OUT_NTB_MAX_SIZE  3200
+
+//------------- AUDIO -------------//
+// 4-channel 16-bit 48kHz speaker (decoding) and microphone (encoding), each support FIFO holds a channel pair
+#define BENCH_AUDIO_SAMPLE_RATE                   48000
+#define BENCH_AUDIO_N_CHANNELS                    4
+#define BENCH_AUDIO_N_BYTES_PER_SAMPLE            2
+#define BENCH_AUDIO_CHANNEL_PER_FIFO              2
+#define BENCH_AUDIO_N_FIFO                        (BENCH_AUDIO_N_CHANNELS / BENCH_AUDIO_CHANNEL_PER_FIFO)
+#define BENCH_AUDIO_EP_SZ                         TUD_AUDIO_EP_SIZE(BENCH_AUDIO_SAMPLE_RATE, BENCH_AUDIO_N_BYTES_PER_SAMPLE, BENCH_AUDIO_N_CHANNELS)
+
+#define CFG_TUD_AUDIO_FUNC_1_DESC_LEN             BENCH_AUDIO_DESC_LEN
+#define CFG_TUD_AUDIO_FUNC_1_N_AS_INT             2
+#define CFG_TUD_AUDIO_FUNC_1_CTRL_BUF_SZ          64
+
+#define CFG_TUD_AUDIO_ENABLE_EP_IN                1
+#define CFG_TUD_AUDIO_ENABLE_ENCODING             1
+#define CFG_TUD_AUDIO_ENABLE_TYPE_I_ENCODING      1
+#define CFG_TUD_AUDIO_FUNC_1_EP_IN_SZ_MAX         BENCH_AUDIO_EP_SZ
+#define CFG_TUD_AUDIO_FUNC_1_EP_IN_SW_BUF_SZ      BENCH_AUDIO_EP_SZ
+#define CFG_TUD_AUDIO_FUNC_1_CHANNEL_PER_FIFO_TX  BENCH_AUDIO_CHANNEL_PER_FIFO
+#define CFG_TUD_AUDIO_FUNC_1_N_TX_SUPP_SW_FIFO    BENCH_AUDIO_N_FIFO
+#define CFG_TUD_AUDIO_FUNC_1_TX_SUPP_SW_FIFO_SZ   (8 * BENCH_AUDIO_EP_SZ)
+
+#define CFG_TUD_AUDIO_ENABLE_EP_OUT               1
+#define CFG_TUD_AUDIO_ENABLE_DECODING             1
+#define CFG_TUD_AUDIO_ENABLE_TYPE_I_DECODING      1
+#define CFG_TUD_AUDIO_FUNC_1_EP_OUT_SZ_MAX        BENCH_AUDIO_EP_SZ
+#define CFG_TUD_AUDIO_FUNC_1_EP_OUT_SW_BUF_SZ     BENCH_AUDIO_EP_SZ
+#define CFG_TUD_AUDIO_FUNC_1_CHANNEL_PER_FIFO_RX  BENCH_AUDIO_CHANNEL_PER_FIFO
+#define CFG_TUD_AUDIO_FUNC_1_N_RX_SUPP_SW_FIFO    BENCH_AUDIO_N_FIFO
+#define CFG_TUD_AUDIO_FUNC_1_RX_SUPP_SW_FIFO_SZ   (8 * BENCH_AUDIO_EP_SZ)
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif /* _TUSB_CONFIG_H_ */
@@ -0,0 +1,342 @@
+#!/usr/bin/env python3
+#
+# The MIT License (MIT)
+#
+# Copyright (c) 2025 Ha Thach (tinyusb.org)
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+# THE SOFTWARE.
+
+# Throughput and latency benchmark for boards in the HIL matrix. Same config file, firmware layout and udev rules as
+# hil_test.py. Existing examples are used as benchmark firmware:
+# - device/cdc_msc         : CDC echo throughput + round-trip latency, MSC read throughput
+# - device/webusb_serial   : vendor (bulk) echo throughput + round-trip latency, require pyusb
+# - device/net_lwip_webserver: NCM/ECM ping latency and iperf (v2) TCP throughput to 192.168.7.1
+#
+# Boards are benchmarked if they run device tests, this can be tuned per board with optional "bench" key:
+#   "bench": { "only": ["device/cdc_msc"], "skip": ["device/net_lwip_webserver"] }
+#
+# Results are printed and written as JSON (-o) with one entry per metric:
+#   { "board": ..., "flags": ..., "bench": ..., "metric": ..., "value": ..., "unit": ... }
+
+import argparse
+import json
+import mmap
+import os
+import re
+import statistics
+import sys
+import time
+from multiprocessing import Pool
+
+import hil_test
+from hil_test import ENUM_TIMEOUT, STATUS_FAILED, TINYUSB_ROOT, get_disk_dev, get_serial_dev, open_serial_dev, run_cmd
+
+NET_DEVICE_IP = '192.168.7.1'
+
+# benchmark parameters, can be changed by command line
+bench_size = 256 * 1024
+bench_iterations = 100
+
+
+def percentile(samples, p):
+    samples = sorted(samples)
+    idx = min(len(samples) - 1, int(round(p / 100.0 * (len(samples) - 1))))
+    return samples[idx]
+
+
+def latency_metrics(prefix, samples_s):
+    us = [s * 1e6 for s in samples_s]
+    return [
+        (f'{prefix}_latency_median', statistics.median(us), 'us'),
+        (f'{prefix}_latency_p99', percentile(us, 99), 'us'),
+    ]
+
+
+def echo_throughput(write, read, total, chunk):
+    # keep at most a few chunks in flight so that device echo buffer never overflows
+    pattern = bytes((i & 0xff) for i in range(chunk))
+    sent = 0
+    received = b''
+    start = time.perf_counter()
+    while sent < total:
+        write(pattern)
+        sent += chunk
+        while len(received) < sent - 2 * chunk:
+            data = read(sent - len(received))
+            assert data, f'Echo timeout after {len(received)} bytes'
+            received += data
+    while len(received) < sent:
+        data = read(sent - len(received))
+        assert data, f'Echo timeout after {len(received)} bytes'
+        received += data
+    duration = time.perf_counter() - start
+    assert received == pattern * (total // chunk), 'Echo wrong data'
+    # each byte crossed the bus twice
+    return (2 * total) / duration
+
+
+def echo_latency(write, read, count):
+    samples = []
+    for i in range(count):
+        b = bytes([0x30 + (i % 10)])
+        start = time.perf_counter()
+        write(b)
+        rd = read(1)
+        samples.append(time.perf_counter() - start)
+        assert rd == b, f'Echo wrong data: expected {b} was {rd}'
+    return samples
+
+
+# -------------------------------------------------------------
+# Benchmarks
+# -------------------------------------------------------------
+def bench_device_cdc_msc(board):
+    uid = board['uid']
+    results = []
+
+    # CDC echo
+    ser = open_serial_dev(get_serial_dev(uid, 'TinyUSB', "TinyUSB_Device", 0))
+    def cdc_write(data):
+        ser.write(data)
+        ser.flush()
+    def cdc_read(n):
+        return ser.read(n)
+    # cdc_msc echoes at most 64 bytes per read
+    chunk = 64
+    try:
+        results += latency_metrics('cdc', echo_latency(cdc_write, cdc_read, bench_iterations))
+        results.append(('cdc_echo_throughput', echo_throughput(cdc_write, cdc_read, bench_size, chunk) / 1024, 'KiB/s'))
+    finally:
+        ser.close()
+
+    # MSC raw read bypassing page cache
+    dev = get_disk_dev(uid, 'TinyUSB', 0)
+    timeout = ENUM_TIMEOUT
+    while not os.path.exists(dev) and timeout:
+        time.sleep(1)
+        timeout -= 1
+    assert timeout, f'Storage {dev} not existed'
+
+    fd = os.open(dev, os.O_RDONLY | getattr(os, 'O_DIRECT', 0))
+    try:
+        disk_size = os.lseek(fd, 0, os.SEEK_END)
+        blk = min(disk_size, 64 * 1024)
+        buf = mmap.mmap(-1, blk)  # page aligned for O_DIRECT
+        total = 0
+        start = time.perf_counter()
+        while total < bench_size:
+            offset = 0
+            while offset < disk_size and total < bench_size:
+                n = os.preadv(fd, [memoryview(buf)[:min(blk, disk_size - offset)]], offset)
+                assert n > 0, 'MSC read failed'
+                offset += n
+                total += n
+        duration = time.perf_counter() - start
+        results.append(('msc_read_throughput', total / duration / 1024, 'KiB/s'))
+    finally:
+        os.close(fd)
+
+    return results
+
+
+def bench_device_webusb_serial(board):
+    import usb.core
+    import usb.util
+
+    uid = board['uid']
+    timeout = ENUM_TIMEOUT
+    dev = None
+    while timeout:
+        dev = usb.core.find(custom_match=lambda d: d.serial_number == uid)
+        if dev:
+            break
+        time.sleep(1)
+        timeout -= 1
+    assert dev, 'Device not available'
+
+    # locate vendor interface and its bulk endpoints
+    cfg = dev.get_active_configuration()
+    itf = usb.util.find_descriptor(cfg, bInterfaceClass=0xff)
+    assert itf, 'Vendor interface not found'
+    ep_out = usb.util.find_descriptor(itf, custom_match=lambda e:
+                                      usb.util.endpoint_direction(e.bEndpointAddress) == usb.util.ENDPOINT_OUT)
+    ep_in = usb.util.find_descriptor(itf, custom_match=lambda e:
+                                     usb.util.endpoint_direction(e.bEndpointAddress) == usb.util.ENDPOINT_IN)
+    if dev.is_kernel_driver_active(itf.bInterfaceNumber):
+        dev.detach_kernel_driver(itf.bInterfaceNumber)
+    usb.util.claim_interface(dev, itf.bInterfaceNumber)
+
+    # webserial connect (simulated SET_CONTROL_LINE_STATE), then drain greeting
+    dev.ctrl_transfer(0x21, 0x22, 1, itf.bInterfaceNumber, None)
+    try:
+        while ep_in.read(ep_in.wMaxPacketSize, 100):
+            pass
+    except usb.core.USBTimeoutError:
+        pass
+
+    def vendor_write(data):
+        ep_out.write(data, 5000)
+    def vendor_read(n):
+        try:
+            return bytes(ep_in.read(max(n, ep_in.wMaxPacketSize), 5000))
+        except usb.core.USBTimeoutError:
+            return b''
+
+    results = []
+    try:
+        results += latency_metrics('vendor', echo_latency(vendor_write, vendor_read, bench_iterations))
+        results.append(('vendor_echo_throughput',
+                        echo_throughput(vendor_write, vendor_read, bench_size, ep_out.wMaxPacketSize) / 1024, 'KiB/s'))
+    finally:
+        dev.ctrl_transfer(0x21, 0x22, 0, itf.bInterfaceNumber, None)
+        usb.util.release_interface(dev, itf.bInterfaceNumber)
+        usb.util.dispose_resources(dev)
+
+    return results
+
+
+def bench_device_net_lwip_webserver(board):
+    # wait for host to get address from device's dhcp server
+    timeout = ENUM_TIMEOUT
+    while timeout:
+        if run_cmd(f'ping -c 1 -W 1 {NET_DEVICE_IP}').returncode == 0:
+            break
+        timeout -= 1
+    assert timeout, f'{NET_DEVICE_IP} not reachable'
+
+    results = []
+    ret = run_cmd(f'ping -c {bench_iterations} -i 0.01 -q {NET_DEVICE_IP}')
+    assert ret.returncode == 0, 'ping failed'
+    m = re.search(r'= ([\d.]+)/([\d.]+)/([\d.]+)/([\d.]+) ms', ret.stdout.decode())
+    assert m, 'Cannot parse ping output'
+    results.append(('net_ping_rtt_avg', float(m.group(2)) * 1000, 'us'))
+    results.append(('net_ping_rtt_max', float(m.group(3)) * 1000, 'us'))
+
+    # iperf v2 csv output: last field is bits per second
+    ret = run_cmd(f'iperf -c {NET_DEVICE_IP} -t 5 -y C')
+    assert ret.returncode == 0, 'iperf failed'
+    lines = ret.stdout.decode().strip().splitlines()
+    results.append(('net_tcp_throughput', int(lines[-1].split(',')[-1]) / 8 / 1024, 'KiB/s'))
+
+    return results
+
+
+# -------------------------------------------------------------
+# Main
+# -------------------------------------------------------------
+bench_list = [
+    'device/cdc_msc',
+    'device/webusb_serial',
+    'device/net_lwip_webserver',
+]
+
+
+def bench_board(board):
+    name = board['name']
+    flasher = board['flasher']
+    results = []
+
+    board_tests = board.get('tests', {})
+    board_bench = board.get('bench', {})
+    if 'only' in board_bench:
+        test_list = list(board_bench['only'])
+    elif board_tests.get('device', False):
+        test_list = list(bench_list)
+    else:
+        return results
+    for skip in board_bench.get('skip', []) + board_tests.get('skip', []):
+        if skip in test_list:
+            test_list.remove(skip)
+
+    flags_on_list = board.get('build', {}).get('flags_on', [""])
+
+    for f1 in flags_on_list:
+        f1_str = '-f1_' + f1.replace(' ', '_') if f1 != "" else ""
+        for test in test_list:
+            fw_dir = f'{TINYUSB_ROOT}/cmake-build/cmake-build-{name}{f1_str}/{test}'
+            if not os.path.exists(fw_dir):
+                fw_dir = f'{TINYUSB_ROOT}/examples/cmake-build-{name}{f1_str}/{test}'
+            fw_name = f'{fw_dir}/{os.path.basename(test)}'
+            label = f'{name + f1_str:40} {test:30}'
+
+            if not os.path.exists(fw_dir) or not (os.path.exists(f'{fw_name}.elf') or os.path.exists(f'{fw_name}.bin')):
+                print(f'{label} ... Skip (no binary)')
+                continue
+
+            ret = getattr(hil_test, f'flash_{flasher["name"].lower()}')(board, fw_name)
+            if ret.returncode != 0:
+                print(f'{label} ... Flash {STATUS_FAILED}')
+                continue
+
+            try:
+                metrics = globals()[f'bench_{test.replace("/", "_")}'](board)
+            except Exception as e:
+                print(f'{label} ... {STATUS_FAILED}')
+                print(f'  {e}')
+                continue
+
+            for metric, value, unit in metrics:
+                print(f'{label} {metric:28} {value:12.1f} {unit}')
+                results.append({'board': name, 'flags': f1, 'bench': test,
+                                'metric': metric, 'value': round(value, 2), 'unit': unit})
+
+    return results
+
+
+def main():
+    """
+    Throughput and latency benchmark on specified boards
+    """
+    global bench_size, bench_iterations
+
+    parser = argparse.ArgumentParser()
+    parser.add_argument('config_file', help='Configuration JSON file')
+    parser.add_argument('-b', '--board', action='append', default=[], help='Boards to benchmark, all if not specified')
+    parser.add_argument('-o', '--output', default='hil_bench.json', help='Result JSON file')
+    parser.add_argument('-s', '--size', type=int, default=bench_size, help='Bytes transferred per throughput metric')
+    parser.add_argument('-n', '--iterations', type=int, default=bench_iterations, help='Samples per latency metric')
+    parser.add_argument('-v', '--verbose', action='store_true', help='Verbose output')
+    args = parser.parse_args()
+
+    bench_size = args.size
+    bench_iterations = args.iterations
+    hil_test.verbose = args.verbose
+
+    config_file = args.config_file
+    if not os.path.exists(config_file):
+        config_file = os.path.join(os.path.dirname(__file__), config_file)
+    with open(config_file) as f:
+        config = json.load(f)
+
+    if len(args.board) == 0:
+        config_boards = config['boards']
+    else:
+        config_boards = [e for e in config['boards'] if e['name'] in args.board]
+
+    with Pool(processes=os.cpu_count()) as pool:
+        results = [r for board_results in pool.map(bench_board, config_boards) for r in board_results]
+
+    with open(args.output, 'w') as f:
+        json.dump({'timestamp': int(time.time()), 'results': results}, f, indent=2)
+    print(f'{len(results)} results written to {args.output}')
+    sys.exit(0 if results else 1)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,131 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2026 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#include "unity.h"
+
+// Files to test
+#include "osal/osal.h"
+#include "tusb_fifo.h"
+#include "tusb.h"
+#include "usbd.h"
+TEST_SOURCE_FILE("usbd_control.c")
+
+// CDC driver is included directly to inspect interface fifos
+#include "cdc_device.c"
+
+// Mock File
+#include "mock_dcd.h"
+#include "mock_msc_device.h"
+
+#if !OSAL_MUTEX_REQUIRED
+  #error "test_cdc_device requires fifo mutex (TUP_MCU_MULTIPLE_CORE=1)"
+#endif
+
+//--------------------------------------------------------------------+
+// MACRO TYPEDEF CONSTANT ENUM DECLARATION
+//--------------------------------------------------------------------+
+
+uint32_t tusb_time_millis_api(void) {
+  return 0;
+}
+
+uint8_t const * tud_descriptor_device_cb(void) {
+  return NULL;
+}
+
+uint8_t const * tud_descriptor_configuration_cb(uint8_t index) {
+  (void) index;
+  return NULL;
+}
+
+uint16_t const* tud_descriptor_string_cb(uint8_t index, uint16_t langid) {
+  (void) index;
+  (void) langid;
+  return NULL;
+}
+
+static void device_init(void) {
+  if ( !tud_inited() ) {
+    tusb_rhport_init_t dev_init = {
+      .role = TUSB_ROLE_DEVICE,
+      .speed = TUSB_SPEED_AUTO
+    };
+
+    mscd_init_Expect();
+    dcd_init_ExpectAndReturn(0, &dev_init, true);
+    tusb_init(0, &dev_init);
+  }
+}
+
+void setUp(void) {
+  dcd_int_disable_Ignore();
+  dcd_int_enable_Ignore();
+}
+
+void tearDown(void) {
+}
+
+//--------------------------------------------------------------------+
+// FIFO configuration
+//--------------------------------------------------------------------+
+
+// must run first: configure before stack is initialized
+void test_configure_fifo_lockfree_before_init(void) {
+  TEST_ASSERT_FALSE(tud_inited());
+
+  tud_cdc_configure_fifo_t cfg = {
+    .rx_lockfree = 1,
+    .tx_lockfree = 1
+  };
+  TEST_ASSERT_TRUE(tud_cdc_configure_fifo(&cfg));
+
+  device_init();
+
+  cdcd_interface_t* p_cdc = &_cdcd_itf[0];
+  TEST_ASSERT_NOT_NULL(p_cdc->rx_mutex);
+  TEST_ASSERT_NOT_NULL(p_cdc->tx_mutex);
+  TEST_ASSERT_NULL(p_cdc->rx_ff.mutex_rd);
+  TEST_ASSERT_NULL(p_cdc->tx_ff.mutex_wr);
+}
+
+void test_configure_fifo_lockfree_after_init(void) {
+  device_init();
+  cdcd_interface_t* p_cdc = &_cdcd_itf[0];
+
+  tud_cdc_configure_fifo_t cfg = {
+    .rx_lockfree = 0,
+    .tx_lockfree = 1
+  };
+  TEST_ASSERT_TRUE(tud_cdc_configure_fifo(&cfg));
+  TEST_ASSERT_EQUAL_PTR(p_cdc->rx_mutex, p_cdc->rx_ff.mutex_rd);
+  TEST_ASSERT_NULL(p_cdc->tx_ff.mutex_wr);
+
+  cfg.rx_lockfree = 1;
+  cfg.tx_lockfree = 0;
+  TEST_ASSERT_TRUE(tud_cdc_configure_fifo(&cfg));
+  TEST_ASSERT_NULL(p_cdc->rx_ff.mutex_rd);
+  TEST_ASSERT_EQUAL_PTR(p_cdc->tx_mutex, p_cdc->tx_ff.mutex_wr);
+}
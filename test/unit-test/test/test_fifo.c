@@ -376,3 +376,131 @@ void test_rd_idx_wrap()
   TEST_ASSERT_EQUAL(n, 2);
   TEST_ASSERT_EQUAL(ff10.rd_idx, 6);
 }
+
+void test_rd_idx_wrap_pow2()
+{
+  tu_fifo_t ff8;
+  uint8_t buf[8];
+  uint8_t dst[8];
+
+  tu_fifo_config(&ff8, buf, 8, 1, 1);
+
+  uint16_t n;
+
+  ff8.wr_idx = 3;
+  ff8.rd_idx = 13;
+  TEST_ASSERT_EQUAL(6, tu_fifo_count(&ff8));
+  TEST_ASSERT_EQUAL(2, tu_fifo_remaining(&ff8));
+
+  n = tu_fifo_read_n(&ff8, dst, 3);
+  TEST_ASSERT_EQUAL(n, 3);
+  TEST_ASSERT_EQUAL(ff8.rd_idx, 0);
+  n = tu_fifo_read_n(&ff8, dst, 8);
+  TEST_ASSERT_EQUAL(n, 3);
+  TEST_ASSERT_EQUAL(ff8.rd_idx, 3);
+
+  // overflowed: read index is corrected to form a full fifo
+  ff8.wr_idx = 12;
+  ff8.rd_idx = 1;
+  TEST_ASSERT_TRUE(tu_fifo_overflowed(&ff8));
+  tu_fifo_correct_read_pointer(&ff8);
+  TEST_ASSERT_EQUAL(ff8.rd_idx, 4);
+  TEST_ASSERT_TRUE(tu_fifo_full(&ff8));
+}
+
+void test_write_read_n_unaligned(void)
+{
+  uint8_t rd_buf_big[FIFO_SIZE + 8];
+
+  // misaligned source/destination and fifo pointer, covering both linear and wrapped copy
+  for(uint8_t offset=0; offset < 8; offset++)
+  {
+    tu_fifo_clear(ff);
+
+    // move fifo pointer to a misaligned position
+    TEST_ASSERT_EQUAL(offset+3, tu_fifo_write_n(ff, test_data, offset+3));
+    TEST_ASSERT_EQUAL(offset+3, tu_fifo_read_n(ff, rd_buf_big, offset+3));
+
+    TEST_ASSERT_EQUAL(FIFO_SIZE-1, tu_fifo_write_n(ff, test_data+offset, FIFO_SIZE-1));
+
+    memset(rd_buf_big, 0, sizeof(rd_buf_big));
+    TEST_ASSERT_EQUAL(FIFO_SIZE-1, tu_fifo_read_n(ff, rd_buf_big+offset, FIFO_SIZE-1));
+    TEST_ASSERT_EQUAL_MEMORY(test_data+offset, rd_buf_big+offset, FIFO_SIZE-1);
+  }
+}
+
+void test_reserve_commit(void)
+{
+  void* wr_ptr;
+  void const* rd_ptr;
+
+  // move pointers near the end so that reserve is limited by the linear part
+  tu_fifo_write_n(ff, test_data, FIFO_SIZE-10);
+  tu_fifo_read_n(ff, rd_buf, FIFO_SIZE-10);
+
+  TEST_ASSERT_EQUAL(10, tu_fifo_reserve(ff, &wr_ptr, 20));
+  TEST_ASSERT_EQUAL_PTR(tu_ff_buf + FIFO_SIZE-10, wr_ptr);
+  memcpy(wr_ptr, test_data, 10);
+  tu_fifo_commit(ff, 10);
+
+  // wrapped part
+  TEST_ASSERT_EQUAL(10, tu_fifo_reserve(ff, &wr_ptr, 10));
+  TEST_ASSERT_EQUAL_PTR(tu_ff_buf, wr_ptr);
+  memcpy(wr_ptr, test_data+10, 10);
+  tu_fifo_commit(ff, 10);
+
+  TEST_ASSERT_EQUAL(20, tu_fifo_count(ff));
+
+  // peek span also stops at the end of buffer
+  TEST_ASSERT_EQUAL(10, tu_fifo_peek_span(ff, &rd_ptr));
+  TEST_ASSERT_EQUAL_MEMORY(test_data, rd_ptr, 10);
+  tu_fifo_release(ff, 10);
+
+  TEST_ASSERT_EQUAL(10, tu_fifo_peek_span(ff, &rd_ptr));
+  TEST_ASSERT_EQUAL_MEMORY(test_data+10, rd_ptr, 10);
+  tu_fifo_release(ff, 10);
+
+  TEST_ASSERT_TRUE(tu_fifo_empty(ff));
+  TEST_ASSERT_EQUAL(0, tu_fifo_peek_span(ff, &rd_ptr));
+  tu_fifo_release(ff, 0);
+
+  // reserve is limited by remaining space
+  tu_fifo_write_n(ff, test_data, FIFO_SIZE-5);
+  TEST_ASSERT_EQUAL(5, tu_fifo_reserve(ff, &wr_ptr, FIFO_SIZE));
+  tu_fifo_commit(ff, 0);
+  TEST_ASSERT_EQUAL(FIFO_SIZE-5, tu_fifo_count(ff));
+}
+
+void test_write_read_iov(void)
+{
+  uint8_t hdr[2] = { 0xAA, 0xBB };
+  uint8_t rd_hdr[2] = { 0 };
+
+  // move pointers near the end so that segments wrap around
+  tu_fifo_write_n(ff, test_data, FIFO_SIZE-5);
+  tu_fifo_read_n(ff, rd_buf, FIFO_SIZE-5);
+
+  tu_iovec_t const wr_iov[3] = {
+    { .iov_base = hdr, .iov_len = 2 },
+    { .iov_base = NULL, .iov_len = 0 },
+    { .iov_base = test_data, .iov_len = 10 }
+  };
+  TEST_ASSERT_EQUAL(12, tu_fifo_write_iov(ff, wr_iov, 3));
+  TEST_ASSERT_EQUAL(12, tu_fifo_count(ff));
+
+  tu_iovec_t const rd_iov[2] = {
+    { .iov_base = rd_hdr, .iov_len = 2 },
+    { .iov_base = rd_buf, .iov_len = FIFO_SIZE }
+  };
+  memset(rd_buf, 0, sizeof(rd_buf));
+  TEST_ASSERT_EQUAL(12, tu_fifo_read_iov(ff, rd_iov, 2));
+  TEST_ASSERT_EQUAL_MEMORY(hdr, rd_hdr, 2);
+  TEST_ASSERT_EQUAL_MEMORY(test_data, rd_buf, 10);
+  TEST_ASSERT_TRUE(tu_fifo_empty(ff));
+
+  // frame that does not fit is not written at all
+  tu_fifo_set_overwritable(ff, false);
+  tu_fifo_write_n(ff, test_data, FIFO_SIZE-11);
+  TEST_ASSERT_EQUAL(0, tu_fifo_write_iov(ff, wr_iov, 3));
+  TEST_ASSERT_EQUAL(FIFO_SIZE-11, tu_fifo_count(ff));
+}
@@ -0,0 +1,243 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+// tu_fifo tests for optional features, built with options enabled by project.yml (see :defines: :test_fifo_options:)
+
+#include <string.h>
+#include "unity.h"
+
+#include "osal/osal.h"
+#include "tusb_fifo.h"
+
+#if !CFG_TUSB_FIFO_COPY_WORDS || !CFG_TUSB_FIFO_INDEX_32BIT || !CFG_TUSB_FIFO_ISR_SAFE || \
+    !CFG_TUSB_FIFO_STATS
+  #error "project.yml must enable fifo options for this test"
+#endif
+
+#define FIFO_SIZE   64
+TU_ATTR_ALIGNED(8) uint8_t tu_ff_buf[FIFO_SIZE * sizeof(uint8_t)];
+tu_fifo_t tu_ff = TU_FIFO_INIT(tu_ff_buf, FIFO_SIZE, uint8_t, false);
+
+tu_fifo_t* ff = &tu_ff;
+
+TU_ATTR_ALIGNED(8) uint8_t test_data[4096];
+TU_ATTR_ALIGNED(8) uint8_t rd_buf[FIFO_SIZE];
+
+void setUp(void)
+{
+  tu_fifo_clear(ff);
+
+  for(int i=0; i<sizeof(test_data); i++) test_data[i] = i;
+  memset(rd_buf, 0, sizeof(rd_buf));
+}
+
+void tearDown(void)
+{
+}
+
+//--------------------------------------------------------------------+
+// CFG_TUSB_FIFO_COPY_WORDS
+//--------------------------------------------------------------------+
+void test_copy_words_aligned(void)
+{
+  // word loop with byte tail
+  TEST_ASSERT_EQUAL(27, tu_fifo_write_n(ff, test_data, 27));
+  TEST_ASSERT_EQUAL(27, tu_fifo_read_n(ff, rd_buf, 27));
+  TEST_ASSERT_EQUAL_MEMORY(test_data, rd_buf, 27);
+
+  // aligned on both linear and wrapped part
+  tu_fifo_clear(ff);
+  tu_fifo_advance_write_pointer(ff, FIFO_SIZE-8);
+  tu_fifo_advance_read_pointer(ff, FIFO_SIZE-8);
+
+  TEST_ASSERT_EQUAL(27, tu_fifo_write_n(ff, test_data+8, 27));
+  memset(rd_buf, 0, sizeof(rd_buf));
+  TEST_ASSERT_EQUAL(27, tu_fifo_read_n(ff, rd_buf+8, 27));
+  TEST_ASSERT_EQUAL_MEMORY(test_data+8, rd_buf+8, 27);
+  TEST_ASSERT_EQUAL(0, rd_buf[8+27]);
+}
+
+void test_copy_words_unaligned(void)
+{
+  uint8_t rd_buf_big[FIFO_SIZE + 8];
+
+  // every alignment of source, destination and fifo pointer, covering both linear and wrapped copy
+  for(uint8_t offset=0; offset < 8; offset++)
+  {
+    tu_fifo_clear(ff);
+
+    TEST_ASSERT_EQUAL(offset+3, tu_fifo_write_n(ff, test_data, offset+3));
+    TEST_ASSERT_EQUAL(offset+3, tu_fifo_read_n(ff, rd_buf_big, offset+3));
+
+    TEST_ASSERT_EQUAL(FIFO_SIZE-1, tu_fifo_write_n(ff, test_data+offset, FIFO_SIZE-1));
+
+    memset(rd_buf_big, 0, sizeof(rd_buf_big));
+    TEST_ASSERT_EQUAL(FIFO_SIZE-1, tu_fifo_read_n(ff, rd_buf_big+offset, FIFO_SIZE-1));
+    TEST_ASSERT_EQUAL_MEMORY(test_data+offset, rd_buf_big+offset, FIFO_SIZE-1);
+
+    // bytes around destination are untouched
+    TEST_ASSERT_EQUAL(0, rd_buf_big[offset+FIFO_SIZE-1]);
+  }
+}
+
+void test_copy_words_peek(void)
+{
+  // wrapped peek with odd length
+  tu_fifo_write_n(ff, test_data, FIFO_SIZE-5);
+  tu_fifo_read_n(ff, rd_buf, FIFO_SIZE-5);
+
+  TEST_ASSERT_EQUAL(13, tu_fifo_write_n(ff, test_data+1, 13));
+  TEST_ASSERT_EQUAL(13, tu_fifo_peek_n(ff, rd_buf+1, 13));
+  TEST_ASSERT_EQUAL_MEMORY(test_data+1, rd_buf+1, 13);
+  TEST_ASSERT_EQUAL(13, tu_fifo_count(ff));
+}
+
+//--------------------------------------------------------------------+
+// CFG_TUSB_FIFO_INDEX_32BIT
+//--------------------------------------------------------------------+
+void test_index_32bit_large_fifo(void)
+{
+  enum { LARGE_DEPTH = 100000 };
+  static uint8_t large_buf[LARGE_DEPTH];
+  tu_fifo_t large_ff;
+
+  TEST_ASSERT_TRUE(tu_fifo_config(&large_ff, large_buf, LARGE_DEPTH, 1, false));
+  TEST_ASSERT_EQUAL(LARGE_DEPTH, tu_fifo_depth(&large_ff));
+
+  // fill past 64K items then wrap around
+  for(uint32_t i=0; i < LARGE_DEPTH; i += sizeof(test_data))
+  {
+    tu_fifo_write_n(&large_ff, test_data, sizeof(test_data));
+  }
+  TEST_ASSERT_TRUE(tu_fifo_full(&large_ff));
+
+  tu_fifo_advance_read_pointer(&large_ff, LARGE_DEPTH - 10);
+  TEST_ASSERT_EQUAL(10, tu_fifo_count(&large_ff));
+
+  TEST_ASSERT_EQUAL(20, tu_fifo_write_n(&large_ff, test_data, 20));
+  TEST_ASSERT_EQUAL(30, tu_fifo_count(&large_ff));
+  TEST_ASSERT_EQUAL(30, tu_fifo_read_n(&large_ff, rd_buf, 30));
+  TEST_ASSERT_EQUAL_MEMORY(test_data, rd_buf + 10, 20);
+}
+
+//--------------------------------------------------------------------+
+// CFG_TUSB_FIFO_ISR_SAFE
+//--------------------------------------------------------------------+
+static uint32_t critical_nest;
+
+uint32_t tu_critical_enter(void)
+{
+  return critical_nest++;
+}
+
+void tu_critical_exit(uint32_t state)
+{
+  critical_nest = state;
+}
+
+void test_write_isr_safe(void)
+{
+  tu_fifo_set_overwritable(ff, false);
+  tu_fifo_set_isr_safe(ff, true);
+
+  TEST_ASSERT_EQUAL(10, tu_fifo_write_n(ff, test_data, 10));
+  TEST_ASSERT_TRUE(tu_fifo_write(ff, test_data+10));
+  TEST_ASSERT_EQUAL(11, tu_fifo_count(ff));
+  TEST_ASSERT_EQUAL(0, critical_nest);
+
+  // simulate a preempted producer which reserved 5 items but has not finished copying
+  ff->wr_rsv_idx = (tu_fifo_size_t) (ff->wr_idx + 5);
+  ff->wr_pending = 1;
+
+  // preempting producer (ISR) completes first: data is not published yet
+  TEST_ASSERT_EQUAL(4, tu_fifo_write_n(ff, test_data+16, 4));
+  TEST_ASSERT_EQUAL(11, tu_fifo_count(ff));
+  TEST_ASSERT_EQUAL(1, ff->wr_pending);
+
+  // preempted producer completes: all data published
+  memcpy(tu_ff_buf+11, test_data+11, 5);
+  ff->wr_pending = 0;
+  ff->wr_idx = ff->wr_rsv_idx;
+  TEST_ASSERT_EQUAL(20, tu_fifo_count(ff));
+
+  // never overwrite, even in overwritable mode
+  tu_fifo_set_overwritable(ff, true);
+  TEST_ASSERT_EQUAL(FIFO_SIZE-20, tu_fifo_write_n(ff, test_data+20, FIFO_SIZE));
+  TEST_ASSERT_FALSE(tu_fifo_write(ff, test_data));
+
+  TEST_ASSERT_EQUAL(FIFO_SIZE, tu_fifo_read_n(ff, rd_buf, FIFO_SIZE));
+  TEST_ASSERT_EQUAL_MEMORY(test_data, rd_buf, FIFO_SIZE);
+
+  tu_fifo_set_isr_safe(ff, false);
+}
+
+//--------------------------------------------------------------------+
+// CFG_TUSB_FIFO_STATS
+//--------------------------------------------------------------------+
+static uint8_t wm_cb_count;
+static bool wm_cb_above;
+
+void tu_fifo_watermark_cb(tu_fifo_t* f, bool above_high)
+{
+  (void) f;
+  wm_cb_count++;
+  wm_cb_above = above_high;
+}
+
+void test_stats_watermark(void)
+{
+  tu_fifo_set_overwritable(ff, false);
+  tu_fifo_clear_stats(ff);
+  tu_fifo_set_watermark(ff, 48, 16);
+  wm_cb_count = 0;
+
+  tu_fifo_write_n(ff, test_data, 40);
+  TEST_ASSERT_EQUAL(0, wm_cb_count);
+
+  // rising to high watermark
+  tu_fifo_write_n(ff, test_data, 10);
+  TEST_ASSERT_EQUAL(1, wm_cb_count);
+  TEST_ASSERT_TRUE(wm_cb_above);
+  TEST_ASSERT_TRUE(tu_fifo_above_watermark(ff));
+
+  // hysteresis: no callback until falling to low watermark
+  tu_fifo_read_n(ff, rd_buf, 20);
+  TEST_ASSERT_EQUAL(1, wm_cb_count);
+  tu_fifo_read_n(ff, rd_buf, 20);
+  TEST_ASSERT_EQUAL(2, wm_cb_count);
+  TEST_ASSERT_FALSE(wm_cb_above);
+  TEST_ASSERT_FALSE(tu_fifo_above_watermark(ff));
+
+  // dropped write counted as overflow
+  tu_fifo_write_n(ff, test_data, FIFO_SIZE);
+
+  tu_fifo_stats_t const* stats = tu_fifo_get_stats(ff);
+  TEST_ASSERT_EQUAL(FIFO_SIZE, stats->peak);
+  TEST_ASSERT_EQUAL(1, stats->overflow_count);
+  TEST_ASSERT_EQUAL(50 + FIFO_SIZE - 10, stats->total_written);
+
+  tu_fifo_set_watermark(ff, 0, 0);
+}
@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+import argparse
+import re
+import sys
+
+# input section line of GNU ld map: ' .bss._usbd_dev  0x20000100  0x40 path/to/usbd.c.obj', name may be on its own line
+SECTION_LINE = re.compile(r'^ (\S+)?\s+(0x[0-9a-fA-F]+)\s+(0x[0-9a-fA-F]+)\s+(\S.*)$')
+SECTION_NAME = re.compile(r'^ (\.\S+|COMMON)\s*$')
+
+# TinyUSB object file, relative to src directory
+TUSB_OBJECT = re.compile(r'(?:^|[/\\])src[/\\]((?:common|device|host|class|portable|typec)[/\\].+|tusb)\.(?:c\.obj|o)$')
+
+CATEGORIES = ('text', 'rodata', 'data', 'bss')
+
+
+def section_category(name):
+    """Map input section name to text/rodata/data/bss, None if it does not take memory"""
+    if name.startswith('.text') or name.startswith('.ramfunc') or name.startswith('.itcm'):
+        return 'text'
+    if name.startswith('.rodata'):
+        return 'rodata'
+    if name.startswith('.data') or name.startswith('.sdata'):
+        return 'data'
+    if name.startswith('.bss') or name.startswith('.sbss') or name == 'COMMON':
+        return 'bss'
+    # custom sections e.g CFG_TUSB_MEM_SECTION
+    if name.startswith('.'):
+        return 'bss' if 'noinit' in name or 'bss' in name else None
+    return None
+
+
+def parse_map(map_file):
+    """Return {module: {category: size}} and {module: [(size, symbol)]} of TinyUSB objects"""
+    modules = {}
+    symbols = {}
+    pending_name = None
+    in_map = False
+
+    with open(map_file, 'r', errors='replace') as fp:
+        for line in fp:
+            line = line.rstrip('\n')
+            if not in_map:
+                in_map = line.startswith('Linker script and memory map')
+                continue
+
+            m = SECTION_NAME.match(line)
+            if m:
+                pending_name = m.group(1)
+                continue
+
+            m = SECTION_LINE.match(line)
+            if not m:
+                pending_name = None
+                continue
+
+            name = m.group(1) or pending_name
+            pending_name = None
+            size = int(m.group(3), 16)
+            obj = TUSB_OBJECT.search(m.group(4).strip())
+            if not name or not obj or size == 0:
+                continue
+
+            category = section_category(name)
+            if category is None:
+                continue
+
+            module = obj.group(1).replace('\\', '/')
+            modules.setdefault(module, dict.fromkeys(CATEGORIES, 0))[category] += size
+            if category in ('data', 'bss'):
+                symbol = name.split('.', 2)[2] if name.count('.') >= 2 else name
+                symbols.setdefault(module, []).append((size, symbol))
+
+    return modules, symbols
+
+
+def print_report(modules, symbols, top):
+    print('{:<40} {:>8} {:>8} {:>8} {:>8} {:>8}'.format('module', 'text', 'rodata', 'data', 'bss', 'ram'))
+    total = dict.fromkeys(CATEGORIES, 0)
+    for module in sorted(modules, key=lambda k: modules[k]['data'] + modules[k]['bss'], reverse=True):
+        sizes = modules[module]
+        for c in CATEGORIES:
+            total[c] += sizes[c]
+        print('{:<40} {:>8} {:>8} {:>8} {:>8} {:>8}'.format(module, sizes['text'], sizes['rodata'], sizes['data'],
+                                                           sizes['bss'], sizes['data'] + sizes['bss']))
+    print('{:<40} {:>8} {:>8} {:>8} {:>8} {:>8}'.format('total', total['text'], total['rodata'], total['data'],
+                                                       total['bss'], total['data'] + total['bss']))
+
+    if top:
+        print('\nlargest RAM symbols (build with -fdata-sections for per-symbol details)')
+        all_symbols = [(size, sym, module) for module, syms in symbols.items() for size, sym in syms]
+        for size, sym, module in sorted(all_symbols, reverse=True)[:top]:
+            print('  {:>8}  {:<40} {}'.format(size, sym, module))
+
+
+def main(map_file, top):
+    modules, symbols = parse_map(map_file)
+    if not modules:
+        print('No TinyUSB object found in {}'.format(map_file), file=sys.stderr)
+        sys.exit(1)
+    print_report(modules, symbols, top)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(
+        prog="memory_report.py",
+        description="""Summarizes code and static RAM usage of each TinyUSB module (class driver,
+                    usbd/usbh, port driver) from a GNU ld map file, to help sizing
+                    configuration for constrained parts.""")
+    parser.add_argument("map_file",
+                        help="Linker map file e.g _build/board/cdc_msc.elf.map")
+    parser.add_argument("-t", "--top", type=int, default=10,
+                        help="Number of largest RAM symbols listed, 0 to disable (default 10)")
+    args = parser.parse_args()
+    main(args.map_file, args.top)
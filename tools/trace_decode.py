@@ -0,0 +1,142 @@
+#!/usr/bin/env python3
+import argparse
+import re
+import struct
+import sys
+from elftools.elf.elffile import ELFFile
+
+TRACE_MAGIC = 0xA5
+TRACE_TYPE_LOG = 0
+TRACE_TYPE_MEM = 1
+
+# printf conversion: flags, width, precision, length modifier, conversion
+FORMAT_SPEC = re.compile(r'%([-+ #0]*)(\*|\d+)?(\.\d+)?(hh|h|ll|l|z|j|t)?([diouxXcsp%])')
+
+
+class ElfImage:
+    """Read-only view of allocated sections of firmware ELF, used to resolve string addresses"""
+
+    def __init__(self, elf_file):
+        self.sections = []
+        with open(elf_file, 'rb') as fp:
+            elf = ELFFile(fp)
+            for sec in elf.iter_sections():
+                # SHF_ALLOC, skip NOBITS (.bss) since it has no content
+                if sec['sh_flags'] & 0x2 and sec['sh_type'] != 'SHT_NOBITS' and sec['sh_size'] > 0:
+                    self.sections.append((sec['sh_addr'], sec.data()))
+
+    def read_string(self, addr):
+        """Return null-terminated string at address, or None if it is not in ELF"""
+        for base, data in self.sections:
+            if base <= addr < base + len(data):
+                end = data.find(b'\0', addr - base)
+                if end < 0:
+                    end = len(data)
+                return data[addr - base:end].decode('utf-8', errors='replace')
+        return None
+
+
+def format_log(image, fmt, args):
+    """Format C printf string with 32-bit arguments recorded on target"""
+    args = list(args)
+
+    def convert(m):
+        flags, width, precision, _, conv = m.groups()
+        if conv == '%':
+            return '%'
+        if width == '*':
+            width = str(args.pop(0) if args else 0)
+        value = args.pop(0) if args else 0
+        spec = '%' + flags + (width or '') + (precision or '')
+        if conv in 'di':
+            if value & 0x80000000:
+                value -= 1 << 32
+            return (spec + 'd') % value
+        if conv == 'u':
+            return (spec + 'd') % value
+        if conv == 'c':
+            return (spec + 'c') % chr(value & 0xFF)
+        if conv == 's':
+            s = image.read_string(value)
+            return (spec + 's') % (s if s is not None else '<0x{:08X}>'.format(value))
+        if conv == 'p':
+            return '0x{:08X}'.format(value)
+        return (spec + conv) % value
+
+    return FORMAT_SPEC.sub(convert, fmt)
+
+
+def format_mem(data):
+    """Hex dump of memory record, 16 bytes per line"""
+    lines = []
+    for ofs in range(0, len(data), 16):
+        chunk = data[ofs:ofs + 16]
+        hexstr = ' '.join('{:02X}'.format(b) for b in chunk)
+        ascii = ''.join(chr(b) if 0x20 <= b < 0x7F else '.' for b in chunk)
+        lines.append('  {:04X}: {:<47}  |{}|\n'.format(ofs, hexstr, ascii))
+    return ''.join(lines)
+
+
+def decode(image, raw, out):
+    """Decode trace records from raw bytes, resync on magic if stream is corrupted. Return number of records"""
+    nwords = len(raw) // 4
+    words = struct.unpack('<{}I'.format(nwords), raw[:4 * nwords])
+    count = 0
+    i = 0
+    while i + 1 < nwords:
+        header = words[i]
+        if header & 0xFF != TRACE_MAGIC:
+            i += 1
+            continue
+
+        argc = (header >> 8) & 0x0F
+        rtype = (header >> 12) & 0x0F
+        memlen = header >> 16
+        timestamp = words[i + 1]
+
+        if rtype == TRACE_TYPE_LOG:
+            if i + 3 + argc > nwords:
+                break
+            fmt = image.read_string(words[i + 2])
+            if fmt is None:
+                # not a format string: false header, keep looking
+                i += 1
+                continue
+            text = format_log(image, fmt, words[i + 3:i + 3 + argc])
+            i += 3 + argc
+        elif rtype == TRACE_TYPE_MEM:
+            n = (memlen + 3) // 4
+            if i + 2 + n > nwords:
+                break
+            data = struct.pack('<{}I'.format(n), *words[i + 2:i + 2 + n])[:memlen]
+            text = format_mem(data)
+            i += 2 + n
+        else:
+            i += 1
+            continue
+
+        out.write('[{:10d}] {}'.format(timestamp, text))
+        count += 1
+
+    return count
+
+
+def main(elf_file, trace_file):
+    image = ElfImage(elf_file)
+    with open(trace_file, 'rb') as fp:
+        raw = fp.read()
+    decode(image, raw, sys.stdout)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(
+        prog="trace_decode.py",
+        description="""Decodes binary trace of TinyUSB (CFG_TUSB_DEBUG_TRACE) captured
+                    from RTT channel or read out with tu_trace_read(). Format strings
+                    and string arguments are looked up in firmware ELF file.""")
+    parser.add_argument("elf_file",
+                        help="Firmware ELF file that produced the trace")
+    parser.add_argument("trace_file",
+                        help="Raw binary trace")
+    args = parser.parse_args()
+    main(args.elf_file, args.trace_file)